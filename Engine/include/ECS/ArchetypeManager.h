@@ -5,16 +5,21 @@
   Purpose:
     - Maintain a registry of archetypes keyed by component signature (ComponentMask).
     - Assign and look up an archetype ID for each unique signature.
+    - Lookup hashes the mask words directly into an open-addressing table (no string keys).
 
   Usage:
     - uint32_t id = manager.getOrCreate(signature);
     - const Archetype* info = manager.get(id);
+    - uint32_t next = manager.withComponent(id, componentId);    // signature + component
+    - uint32_t prev = manager.withoutComponent(id, componentId); // signature - component
+
+  Notes:
+    - withComponent()/withoutComponent() cache transition edges per archetype, so repeated
+      add/remove of the same component skips the signature key lookup entirely.
 */
 
-#include <unordered_map>
 #include <vector>
 #include <cstdint>
-#include <string>
 #include "ECS/Components.h"
 
 namespace Engine::ECS
@@ -31,17 +36,38 @@ namespace Engine::ECS
         // Returns existing ID for signature or creates a new archetype and returns its ID.
         uint32_t getOrCreate(const ComponentMask &signature)
         {
-            const std::string key = signature.toKey();
-            auto it = m_keyToId.find(key);
-            if (it != m_keyToId.end())
-                return it->second;
+            const uint64_t h = signature.hash();
+            if (const uint32_t found = find(signature, h); found != UINT32_MAX)
+                return found;
 
             const uint32_t id = static_cast<uint32_t>(m_archetypes.size());
-            m_keyToId.emplace(key, id);
             m_archetypes.push_back(Archetype{id, signature});
+            m_hashes.push_back(h);
+            m_edges.emplace_back();
+
+            // Keep load factor <= 1/2 so probe chains stay short.
+            if ((m_archetypes.size() * 2) > m_slots.size())
+                rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+            else
+                insertSlot(id);
             return id;
         }
 
+        // Existing ID for a signature, or UINT32_MAX.
+        uint32_t find(const ComponentMask &signature) const { return find(signature, signature.hash()); }
+
+        // Archetype reached by adding 'componentId' (returns 'archetypeId' if already present).
+        uint32_t withComponent(uint32_t archetypeId, uint32_t componentId)
+        {
+            return transition(archetypeId, componentId, true);
+        }
+
+        // Archetype reached by removing 'componentId' (returns 'archetypeId' if not present).
+        uint32_t withoutComponent(uint32_t archetypeId, uint32_t componentId)
+        {
+            return transition(archetypeId, componentId, false);
+        }
+
         // Retrieve archetype info by ID.
         const Archetype *get(uint32_t id) const
         {
@@ -49,8 +75,90 @@ namespace Engine::ECS
         }
 
     private:
-        std::unordered_map<std::string, uint32_t> m_keyToId;
+        static constexpr uint32_t EmptySlot = UINT32_MAX;
+
+        // Open addressing, linear probing; slots hold archetype IDs, hashes are cached per archetype.
+        uint32_t find(const ComponentMask &signature, uint64_t h) const
+        {
+            if (m_slots.empty())
+                return UINT32_MAX;
+            const size_t mask = m_slots.size() - 1;
+            for (size_t i = static_cast<size_t>(h) & mask;; i = (i + 1) & mask)
+            {
+                const uint32_t id = m_slots[i];
+                if (id == EmptySlot)
+                    return UINT32_MAX;
+                if (m_hashes[id] == h && m_archetypes[id].signature == signature)
+                    return id;
+            }
+        }
+
+        void insertSlot(uint32_t id)
+        {
+            const size_t mask = m_slots.size() - 1;
+            size_t i = static_cast<size_t>(m_hashes[id]) & mask;
+            while (m_slots[i] != EmptySlot)
+                i = (i + 1) & mask;
+            m_slots[i] = id;
+        }
+
+        void rehash(size_t slotCount)
+        {
+            m_slots.assign(slotCount, EmptySlot);
+            for (uint32_t id = 0; id < static_cast<uint32_t>(m_archetypes.size()); ++id)
+                insertSlot(id);
+        }
+
+        struct Edge
+        {
+            uint32_t componentId = UINT32_MAX;
+            uint32_t add = UINT32_MAX;    // archetype with componentId set
+            uint32_t remove = UINT32_MAX; // archetype with componentId cleared
+        };
+
+        Edge &edgeFor(uint32_t archetypeId, uint32_t componentId)
+        {
+            auto &edges = m_edges[archetypeId];
+            for (Edge &e : edges)
+            {
+                if (e.componentId == componentId)
+                    return e;
+            }
+            edges.push_back(Edge{componentId});
+            return edges.back();
+        }
+
+        uint32_t transition(uint32_t archetypeId, uint32_t componentId, bool add)
+        {
+            if (archetypeId >= m_archetypes.size() || componentId >= ComponentMask::MaxComponents)
+                return archetypeId;
+            if (m_archetypes[archetypeId].signature.has(componentId) == add)
+                return archetypeId;
+
+            {
+                const Edge &cached = edgeFor(archetypeId, componentId);
+                const uint32_t target = add ? cached.add : cached.remove;
+                if (target != UINT32_MAX)
+                    return target;
+            }
+
+            ComponentMask signature = m_archetypes[archetypeId].signature;
+            if (add)
+                signature.set(componentId);
+            else
+                signature.clear(componentId);
+            const uint32_t target = getOrCreate(signature); // may grow m_edges
+
+            // Cache both directions: target is one component away from archetypeId.
+            (add ? edgeFor(archetypeId, componentId).add : edgeFor(archetypeId, componentId).remove) = target;
+            (add ? edgeFor(target, componentId).remove : edgeFor(target, componentId).add) = archetypeId;
+            return target;
+        }
+
+        std::vector<uint32_t> m_slots;  // power-of-two hash table of archetype IDs
+        std::vector<uint64_t> m_hashes; // signature hash per archetype
         std::vector<Archetype> m_archetypes;
+        std::vector<std::vector<Edge>> m_edges; // per archetype, small (one entry per component ever toggled)
     };
 
 } // namespace Engine::ECS
\ No newline at end of file
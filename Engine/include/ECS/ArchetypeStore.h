@@ -4,264 +4,1113 @@
   ----------------
   Purpose:
     - Provide a generic Struct-of-Arrays store for a single archetype (signature).
-    - Conditionally hold arrays for components present in the signature (Position, Velocity, Health).
+    - Hold one type-erased column per signature component that has storage info in the
+      ComponentRegistry (tags have none). All columns share a single allocation.
     - Support creation of rows with defaults, destruction via swap-remove, and per-row masks.
 
   Usage:
     - Construct with a signature.
-    - resolveKnownComponents(registry) to enable arrays for known components.
-    - createRow(entity) then applyDefaults(row, defaults, registry).
-    - destroyRow(row) with dense packing.
+    - resolveKnownComponents(registry) to create columns for the signature's components.
+    - createRow(entity) then applyDefaults(row, prefab.defaults, registry).
+    - createRows(entities, n) + fillRowsFrom(row, begin, end) for batch spawns.
+    - createRowsFromTemplate(entities, n, rowTemplate) spawns rows straight from a packed
+      RowTemplate (a prefab's resolved defaults): one memcpy fill per column, no per-row visits.
+    - destroyRow(row) with dense packing; moveRowTo(row, dst) for archetype changes.
+    - Typed access: column<T>() / healths() etc. return a ColumnView over the rows; positions() and
+      velocities() return a Vec3ColumnView, which reads the same in either column layout.
+    - Columns of components marked with ComponentRegistry::setSplitLayout hold one array per 4-byte
+      field (x[], y[], z[]) instead of an array of structs; column<T>() is empty for those.
+    - ArchetypeStoreManager caches which stores match a (required, excluded) query;
+      the cache is only updated when a new store is created, so systems never rescan
+      every store signature per frame.
+    - Change versions: every column keeps the version of its last write per ChangeChunkRows rows,
+      stamped from the manager's change clock. Mutable typed access (column<T>(), positions(), ...)
+      marks the whole column; Query marks only the chunks it hands out for non-const columns; row
+      creation, swap-remove and the raw setters mark the rows they touch. Const access never marks.
+      Consumers keep the version they last processed and ask for rows written after it:
+        const uint32_t since = m_seen;
+        m_seen = stores.advanceChangeVersion();
+        store.forEachChangedRange(positionMask, since, [&](uint32_t begin, uint32_t end) { ... });
+      structureVersion() tells when rows were added, removed or reordered.
 */
 
 #include <vector>
 #include <unordered_map>
 #include <memory>
-#include <variant>
+#include <mutex>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
 #include "ECS/Components.h"
 #include "ECS/Entity.h"
+#include "Engine/FrameArena.h"
 
 namespace Engine::ECS
 {
+    // Non-owning view over one component column (indexed by store row).
+    template <typename T>
+    class ColumnView
+    {
+    public:
+        ColumnView() = default;
+        ColumnView(T *data, uint32_t size) : m_data(data), m_size(size) {}
+
+        T &operator[](uint32_t row) const { return m_data[row]; }
+        T *data() const { return m_data; }
+        uint32_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        T *begin() const { return m_data; }
+        T *end() const { return m_data + m_size; }
+
+    private:
+        T *m_data = nullptr;
+        uint32_t m_size = 0;
+    };
+
+    // View over a column of {x, y, z} floats (Position, Velocity) in either layout. Indexing returns a
+    // reference proxy, so row code reads like the struct (v[row].x += ...). Hot loops use the field
+    // pointers: x()[row * stride()], where stride() is 1 for split columns and 3 for structs.
+    template <typename T>
+    class Vec3ColumnView
+    {
+        using Value = std::remove_const_t<T>;
+        using Float = std::conditional_t<std::is_const_v<T>, const float, float>;
+
+    public:
+        struct Ref
+        {
+            Float &x;
+            Float &y;
+            Float &z;
+
+            operator Value() const
+            {
+                Value v;
+                v.x = x;
+                v.y = y;
+                v.z = z;
+                return v;
+            }
+            const Ref &operator=(const Value &v) const
+            {
+                x = v.x;
+                y = v.y;
+                z = v.z;
+                return *this;
+            }
+            const Ref &operator=(const Ref &other) const { return *this = static_cast<Value>(other); }
+        };
+
+        Vec3ColumnView() = default;
+        Vec3ColumnView(Float *x, Float *y, Float *z, uint32_t stride, uint32_t size)
+            : m_x(x), m_y(y), m_z(z), m_stride(stride), m_size(size) {}
+
+        Ref operator[](uint32_t row) const
+        {
+            const size_t i = static_cast<size_t>(row) * m_stride;
+            return Ref{m_x[i], m_y[i], m_z[i]};
+        }
+
+        Float *x() const { return m_x; }
+        Float *y() const { return m_y; }
+        Float *z() const { return m_z; }
+        uint32_t stride() const { return m_stride; }
+        bool split() const { return m_stride == 1; }
+        uint32_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+    private:
+        Float *m_x = nullptr;
+        Float *m_y = nullptr;
+        Float *m_z = nullptr;
+        uint32_t m_stride = 0;
+        uint32_t m_size = 0;
+    };
+
+    // Components accessed through Vec3ColumnView (plain {x, y, z} floats).
+    template <typename T>
+    struct IsVec3Component : std::false_type
+    {
+    };
+    template <>
+    struct IsVec3Component<Position> : std::true_type
+    {
+    };
+    template <>
+    struct IsVec3Component<Velocity> : std::true_type
+    {
+    };
+
+    // One packed row of trivially copyable column values, keyed by component ID in ascending order
+    // (the store's column order). Used for a prefab's defaults (any registered component type, set
+    // with set<T>() or from cooked bytes) and for the full row those resolve to (resolveRowTemplate
+    // in Prefab.h).
+    struct RowTemplate
+    {
+        struct Value
+        {
+            uint32_t componentId = 0;
+            uint32_t offset = 0; // into 'bytes'
+            uint32_t size = 0;
+        };
+
+        std::vector<Value> values;
+        std::vector<uint8_t> bytes;
+
+        bool empty() const { return values.empty(); }
+
+        const Value *find(uint32_t componentId) const
+        {
+            auto it = std::lower_bound(values.begin(), values.end(), componentId,
+                                       [](const Value &v, uint32_t id)
+                                       { return v.componentId < id; });
+            return (it != values.end() && it->componentId == componentId) ? &*it : nullptr;
+        }
+
+        const uint8_t *data(const Value &value) const { return bytes.data() + value.offset; }
+
+        // Set (or replace) the value of 'componentId' to 'size' bytes copied from 'src'. A replaced
+        // value of another size leaves its old bytes unused until the template is rebuilt.
+        void set(uint32_t componentId, const void *src, uint32_t size)
+        {
+            auto it = std::lower_bound(values.begin(), values.end(), componentId,
+                                       [](const Value &v, uint32_t id)
+                                       { return v.componentId < id; });
+            if (it == values.end() || it->componentId != componentId)
+                it = values.insert(it, Value{componentId, 0, 0});
+            if (it->size != size)
+            {
+                it->offset = static_cast<uint32_t>(bytes.size());
+                it->size = size;
+                bytes.resize(bytes.size() + size);
+            }
+            if (size)
+                std::memcpy(bytes.data() + it->offset, src, size);
+        }
+
+        template <typename T>
+        void set(uint32_t componentId, const T &value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "RowTemplate values are copied as raw bytes");
+            set(componentId, &value, static_cast<uint32_t>(sizeof(T)));
+        }
+
+        // Copy the value of 'componentId' into 'out'; false if there is none or its size differs.
+        template <typename T>
+        bool get(uint32_t componentId, T &out) const
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "RowTemplate values are copied as raw bytes");
+            const Value *value = find(componentId);
+            if (!value || value->size != sizeof(T))
+                return false;
+            std::memcpy(&out, data(*value), sizeof(T));
+            return true;
+        }
+
+        // Drop the values of components outside 'mask' (repacking the bytes).
+        void retain(const ComponentMask &mask)
+        {
+            RowTemplate kept;
+            for (const Value &v : values)
+            {
+                if (mask.has(v.componentId))
+                    kept.set(v.componentId, data(v), v.size);
+            }
+            *this = std::move(kept);
+        }
+    };
+
     class ArchetypeStore
     {
     public:
         explicit ArchetypeStore(const ComponentMask &signature)
             : m_signature(signature) {}
 
+        ~ArchetypeStore()
+        {
+            destroyRange(0, size());
+            freeBlock(m_block);
+        }
+
+        ArchetypeStore(const ArchetypeStore &) = delete;
+        ArchetypeStore &operator=(const ArchetypeStore &) = delete;
+
         // Create a new row for the given entity; returns row index.
         uint32_t createRow(Entity e)
         {
             const uint32_t row = static_cast<uint32_t>(m_entities.size());
+            if (row + 1 > m_capacity)
+                grow(std::max<uint32_t>(16u, m_capacity * 2u));
+
             m_entities.emplace_back(e);
             // Initialize row mask: start with the store signature (you can add tags per row later)
             m_rowMasks.emplace_back(m_signature);
 
-            // Conditionally create per-component entries based on signature bits.
-            if (hasPosition())
-                m_positions.emplace_back(Position{});
-            if (hasVelocity())
-                m_velocities.emplace_back(Velocity{});
-            if (hasHealth())
-                m_healths.emplace_back(Health{100.f});
-            if (hasMoveTarget())
-                m_moveTargets.emplace_back(MoveTarget{});
-            if (hasMoveSpeed())
-                m_moveSpeeds.emplace_back(MoveSpeed{});
-            if (hasRadius())
-                m_radii.emplace_back(Radius{});
-            if (hasSeparation())
-                m_separations.emplace_back(Separation{});
-            if (hasAvoidanceParams())
-                m_avoidanceParams.emplace_back(AvoidanceParams{});
-            if (hasRenderModel())
-                m_renderModels.emplace_back(RenderModel{});
-            if (hasRenderAnimation())
-                m_renderAnimations.emplace_back(RenderAnimation{});
+            // Default-construct one element per column.
+            for (const Column &c : m_columns)
+                constructRows(c, row, 1);
 
+            markStructure(row, row + 1);
             return row;
         }
 
-        // Swap-remove a row; maintains dense arrays and updates ownership.
-        void destroyRow(uint32_t row)
+        // Append 'count' default-constructed rows owned by 'entities'; returns the first new row.
+        uint32_t createRows(const Entity *entities, uint32_t count)
         {
-            const uint32_t last = static_cast<uint32_t>(m_entities.size() - 1);
-            if (row > last)
-                return;
+            const uint32_t first = size();
+            if (count == 0)
+                return first;
+            reserve(first + count);
 
-            auto swapErase = [&](auto &vec)
-            {
-                if (row != last)
-                    vec[row] = std::move(vec[last]);
-                vec.pop_back();
-            };
+            m_entities.insert(m_entities.end(), entities, entities + count);
+            m_rowMasks.resize(static_cast<size_t>(first) + count, m_signature);
 
-            swapErase(m_entities);
-            swapErase(m_rowMasks);
-            if (hasPosition())
-                swapErase(m_positions);
-            if (hasVelocity())
-                swapErase(m_velocities);
-            if (hasHealth())
-                swapErase(m_healths);
-            if (hasMoveTarget())
-                swapErase(m_moveTargets);
-            if (hasMoveSpeed())
-                swapErase(m_moveSpeeds);
-            if (hasRadius())
-                swapErase(m_radii);
-            if (hasSeparation())
-                swapErase(m_separations);
-            if (hasAvoidanceParams())
-                swapErase(m_avoidanceParams);
-            if (hasRenderModel())
-                swapErase(m_renderModels);
-            if (hasRenderAnimation())
-                swapErase(m_renderAnimations);
-        }
-
-        // Apply typed defaults for a newly created row.
-        void applyDefaults(uint32_t row, const std::unordered_map<uint32_t, DefaultValue> &defaults,
-                           const ComponentRegistry & /*registry*/)
-        {
-            for (const auto &kv : defaults)
-            {
-                const uint32_t cid = kv.first;
-                if (!m_signature.has(cid))
-                    continue;
+            for (const Column &c : m_columns)
+                constructRows(c, first, count);
+            markStructure(first, first + count);
+            return first;
+        }
 
-                if (std::holds_alternative<Position>(kv.second) && hasPosition())
-                {
-                    m_positions[row] = std::get<Position>(kv.second);
-                }
-                else if (std::holds_alternative<Velocity>(kv.second) && hasVelocity())
+        // Append 'count' rows owned by 'entities' and initialized from 'tmpl'; returns the first new row.
+        // Trivial columns with a template value are filled by memcpy (doubling copies, no construct);
+        // the remaining columns are default-constructed as in createRows().
+        uint32_t createRowsFromTemplate(const Entity *entities, uint32_t count, const RowTemplate &tmpl)
+        {
+            const uint32_t first = size();
+            if (count == 0)
+                return first;
+            reserve(first + count);
+
+            m_entities.insert(m_entities.end(), entities, entities + count);
+            m_rowMasks.resize(static_cast<size_t>(first) + count, m_signature);
+
+            size_t v = 0;
+            for (const Column &c : m_columns)
+            {
+                while (v < tmpl.values.size() && tmpl.values[v].componentId < c.componentId)
+                    ++v;
+                const RowTemplate::Value *value =
+                    (v < tmpl.values.size() && tmpl.values[v].componentId == c.componentId) ? &tmpl.values[v] : nullptr;
+
+                if (!value || !c.type->trivial || value->size != c.type->size)
                 {
-                    m_velocities[row] = std::get<Velocity>(kv.second);
+                    constructRows(c, first, count);
+                    continue;
                 }
-                else if (std::holds_alternative<Health>(kv.second) && hasHealth())
+                if (c.lanes)
                 {
-                    m_healths[row] = std::get<Health>(kv.second);
+                    fillLanes(c, first, count, tmpl.bytes.data() + value->offset);
+                    continue;
                 }
-                else if (std::holds_alternative<MoveTarget>(kv.second) && hasMoveTarget())
+
+                std::byte *dst = static_cast<std::byte *>(elementPtr(c, first));
+                const size_t elem = c.type->size;
+                std::memcpy(dst, tmpl.bytes.data() + value->offset, elem);
+                for (size_t filled = 1; filled < count;)
                 {
-                    m_moveTargets[row] = std::get<MoveTarget>(kv.second);
+                    const size_t n = std::min<size_t>(filled, count - filled);
+                    std::memcpy(dst + filled * elem, dst, n * elem);
+                    filled += n;
                 }
-                else if (std::holds_alternative<MoveSpeed>(kv.second) && hasMoveSpeed())
+            }
+            markStructure(first, first + count);
+            return first;
+        }
+
+        // Copy every column of 'srcRow' into rows [begin, end) (e.g. a row with defaults applied).
+        void fillRowsFrom(uint32_t srcRow, uint32_t begin, uint32_t end)
+        {
+            if (srcRow >= size() || end > size())
+                return;
+
+            for (const Column &c : m_columns)
+            {
+                markRows(c, begin, end);
+                if (c.lanes)
                 {
-                    m_moveSpeeds[row] = std::get<MoveSpeed>(kv.second);
+                    alignas(16) std::byte value[kMaxSplitComponentBytes];
+                    loadElement(c, srcRow, value);
+                    if (begin < end)
+                        fillLanes(c, begin, end - begin, value);
+                    continue;
                 }
-                else if (std::holds_alternative<Radius>(kv.second) && hasRadius())
+
+                const void *src = elementPtr(c, srcRow);
+                for (uint32_t r = begin; r < end; ++r)
                 {
-                    m_radii[row] = std::get<Radius>(kv.second);
+                    if (r == srcRow)
+                        continue;
+                    if (c.type->trivial)
+                        std::memcpy(elementPtr(c, r), src, c.type->size);
+                    else
+                        c.type->copyAssign(elementPtr(c, r), src);
                 }
-                else if (std::holds_alternative<Separation>(kv.second) && hasSeparation())
+            }
+        }
+
+        // Remove every row; columns and capacity are kept.
+        void clear()
+        {
+            destroyRange(0, size());
+            m_entities.clear();
+            m_rowMasks.clear();
+            m_structureVersion = changeVersion();
+        }
+
+        // Make room for at least 'rows' rows without further reallocation.
+        void reserve(uint32_t rows)
+        {
+            m_entities.reserve(rows);
+            m_rowMasks.reserve(rows);
+            if (rows > m_capacity)
+                grow(rows);
+        }
+
+        // Swap-remove a row; maintains dense arrays and updates ownership.
+        // Returns the entity that now occupies 'row' (invalid if the last row was removed),
+        // so the caller can re-attach its EntityRecord.
+        Entity destroyRow(uint32_t row)
+        {
+            if (m_entities.empty())
+                return Entity{};
+            const uint32_t last = static_cast<uint32_t>(m_entities.size() - 1);
+            if (row > last)
+                return Entity{};
+
+            for (const Column &c : m_columns)
+            {
+                if (c.lanes)
                 {
-                    m_separations[row] = std::get<Separation>(kv.second);
+                    for (uint32_t k = 0; row != last && k < c.lanes; ++k)
+                        std::memcpy(laneData(c, k) + static_cast<size_t>(row) * 4, laneData(c, k) + static_cast<size_t>(last) * 4, 4);
+                    continue;
                 }
-                else if (std::holds_alternative<AvoidanceParams>(kv.second) && hasAvoidanceParams())
+
+                void *dst = elementPtr(c, row);
+                void *src = elementPtr(c, last);
+                if (row != last)
                 {
-                    m_avoidanceParams[row] = std::get<AvoidanceParams>(kv.second);
+                    if (c.type->trivial)
+                        std::memcpy(dst, src, c.type->size);
+                    else
+                        c.type->moveAssign(dst, src);
                 }
-                else if (std::holds_alternative<RenderModel>(kv.second) && hasRenderModel())
+                if (!c.type->trivial)
+                    c.type->destroy(src);
+            }
+
+            auto swapErase = [&](auto &vec)
+            {
+                if (row != last)
+                    vec[row] = std::move(vec[last]);
+                vec.pop_back();
+            };
+            swapErase(m_entities);
+            swapErase(m_rowMasks);
+            markStructure(row, (row != last) ? row + 1 : row);
+            return (row != last) ? m_entities[row] : Entity{};
+        }
+
+        // Move a row into 'dst' (another archetype): shared columns are copied, columns only 'dst'
+        // has are default-constructed, and per-row tags outside both signatures are kept.
+        // Returns the new row in 'dst'; 'movedIntoRow' receives the entity swapped into 'row' here.
+        uint32_t moveRowTo(uint32_t row, ArchetypeStore &dst, Entity &movedIntoRow)
+        {
+            movedIntoRow = Entity{};
+            if (row >= size() || &dst == this)
+                return UINT32_MAX;
+
+            const uint32_t dstRow = dst.createRow(m_entities[row]);
+            for (const Column &dc : dst.m_columns)
+            {
+                const Column *sc = findColumn(dc.componentId);
+                if (!sc)
+                    continue;
+                if (dc.lanes || sc->lanes)
                 {
-                    m_renderModels[row] = std::get<RenderModel>(kv.second);
+                    alignas(16) std::byte value[kMaxSplitComponentBytes];
+                    loadElement(*sc, row, value);
+                    dst.storeElement(dc, dstRow, value);
                 }
-                else if (std::holds_alternative<RenderAnimation>(kv.second) && hasRenderAnimation())
+                else if (dc.type->trivial)
+                    std::memcpy(dst.elementPtr(dc, dstRow), elementPtr(*sc, row), dc.type->size);
+                else
+                    dc.type->moveAssign(dst.elementPtr(dc, dstRow), elementPtr(*sc, row));
+            }
+
+            const ComponentMask &srcMask = m_rowMasks[row];
+            ComponentMask &dstMask = dst.m_rowMasks[dstRow];
+            for (uint32_t id = 0; id < ComponentMask::MaxComponents; ++id)
+            {
+                if (srcMask.has(id) && !m_signature.has(id) && !dst.m_signature.has(id))
                 {
-                    m_renderAnimations[row] = std::get<RenderAnimation>(kv.second);
+                    dstMask.set(id);
+                    dst.m_rowTags.set(id);
                 }
             }
+
+            movedIntoRow = destroyRow(row);
+            return dstRow;
+        }
+
+        // Apply prefab defaults to a newly created row. Values whose size does not match the column's
+        // registered type, or whose type is not trivially copyable, are skipped.
+        void applyDefaults(uint32_t row, const RowTemplate &defaults, const ComponentRegistry & /*registry*/)
+        {
+            for (const RowTemplate::Value &value : defaults.values)
+            {
+                const Column *c = findColumn(value.componentId);
+                if (!c || !c->type->trivial || value.size != c->type->size)
+                    continue;
+                if (c->lanes)
+                    storeElement(*c, row, defaults.data(value));
+                else
+                    c->type->copyAssign(elementPtr(*c, row), defaults.data(value));
+                markRows(*c, row, row + 1);
+            }
+        }
+
+        // Copy a raw component value (of the column's registered type) into a row.
+        bool setComponentRaw(uint32_t row, uint32_t componentId, const void *value)
+        {
+            const Column *c = findColumn(componentId);
+            if (!c || row >= size() || !value)
+                return false;
+            if (c->lanes)
+                storeElement(*c, row, value);
+            else
+                c->type->copyAssign(elementPtr(*c, row), value);
+            markRows(*c, row, row + 1);
+            return true;
+        }
+
+        // Copy 'count' packed values (array of structs, any column layout) into rows [first, first + count).
+        bool setColumnRows(uint32_t componentId, uint32_t first, uint32_t count, const void *values)
+        {
+            const Column *c = findColumn(componentId);
+            if (!c || first + count > size() || !values || !c->type->trivial)
+                return false;
+            const std::byte *src = static_cast<const std::byte *>(values);
+            markRows(*c, first, first + count);
+            if (!c->lanes)
+            {
+                std::memcpy(elementPtr(*c, first), src, static_cast<size_t>(c->type->size) * count);
+                return true;
+            }
+            for (uint32_t i = 0; i < count; ++i)
+                storeElement(*c, first + i, src + static_cast<size_t>(i) * c->type->size);
+            return true;
+        }
+
+        // Overwrite the masks of rows [first, first + count); tags outside the signature join rowTags().
+        void setRowMasks(uint32_t first, const ComponentMask *masks, uint32_t count)
+        {
+            if (first + count > size())
+                return;
+            ComponentMask all;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                m_rowMasks[first + i] = masks[i];
+                all.merge(masks[i]);
+            }
+            for (uint32_t id = 0; id < ComponentMask::MaxComponents; ++id)
+            {
+                if (all.has(id) && !m_signature.has(id))
+                    m_rowTags.set(id);
+            }
+        }
+
+        // Raw pointer to a row's component; nullptr if the store has no such column or it is split.
+        // The mutable overload marks the row changed.
+        void *componentRaw(uint32_t row, uint32_t componentId)
+        {
+            const Column *c = findColumn(componentId);
+            if (!c || c->lanes || row >= size())
+                return nullptr;
+            markRows(*c, row, row + 1);
+            return elementPtr(*c, row);
+        }
+        const void *componentRaw(uint32_t row, uint32_t componentId) const
+        {
+            const Column *c = findColumn(componentId);
+            return (c && !c->lanes && row < size()) ? elementPtr(*c, row) : nullptr;
         }
 
         // Accessors
         const ComponentMask &signature() const { return m_signature; }
         uint32_t size() const { return static_cast<uint32_t>(m_entities.size()); }
+        uint32_t capacity() const { return m_capacity; }
+
+        // Heap bytes held by the store: the column block, the per-row entity and mask arrays and the
+        // change versions.
+        size_t memoryBytes() const
+        {
+            return m_blockBytes + m_entities.capacity() * sizeof(Entity) + m_rowMasks.capacity() * sizeof(ComponentMask) +
+                   (m_versions ? m_columns.size() * versionSlots() * sizeof(uint32_t) : 0);
+        }
+
+        size_t columnBlockBytes() const { return m_blockBytes; }
+
+        // fn(componentId, bytes) for each column, sized for capacity() rows (alignment padding excluded).
+        template <typename Fn>
+        void forEachColumnBytes(Fn &&fn) const
+        {
+            for (const Column &c : m_columns)
+                fn(c.componentId, c.lanes ? static_cast<size_t>(c.lanes) * laneRows() * 4 : static_cast<size_t>(c.type->size) * m_capacity);
+        }
 
-        // Row-level masks (e.g., exclude tags applied per row).
-        std::vector<ComponentMask> &rowMasks() { return m_rowMasks; }
+        // fn(componentId, type, rows) for each column; 'rows' points at size() packed structs. Split
+        // columns are packed into FrameArena scratch first, valid only during the call.
+        template <typename Fn>
+        void forEachColumnData(Fn &&fn) const
+        {
+            for (const Column &c : m_columns)
+            {
+                if (!c.lanes)
+                {
+                    fn(c.componentId, *c.type, static_cast<const void *>(columnBase(c)));
+                    continue;
+                }
+                FrameArena::Scope scratch;
+                std::byte *packed = scratch.arena().allocateArray<std::byte>(static_cast<size_t>(c.type->size) * size() + 1);
+                for (uint32_t r = 0; r < size(); ++r)
+                    loadElement(c, r, packed + static_cast<size_t>(r) * c.type->size);
+                fn(c.componentId, *c.type, static_cast<const void *>(packed));
+            }
+        }
+
+        // Entity handle per row.
+        const std::vector<Entity> &entities() const { return m_entities; }
+
+        // Row-level masks: the store signature plus per-row tags (e.g. "Selected").
         const std::vector<ComponentMask> &rowMasks() const { return m_rowMasks; }
 
-        // Component arrays (conditionally enabled).
-        std::vector<Position> &positions() { return m_positions; }
-        const std::vector<Position> &positions() const { return m_positions; }
+        // Per-row tags that do not change the archetype. Frequently toggled flags belong here;
+        // filter tags such as "Dead"/"Disabled" should be real components so whole stores drop out of queries.
+        void setRowTag(uint32_t row, uint32_t tagId)
+        {
+            if (row >= size())
+                return;
+            m_rowMasks[row].set(tagId);
+            if (!m_signature.has(tagId))
+                m_rowTags.set(tagId);
+        }
 
-        std::vector<Velocity> &velocities() { return m_velocities; }
-        const std::vector<Velocity> &velocities() const { return m_velocities; }
+        void clearRowTag(uint32_t row, uint32_t tagId)
+        {
+            if (row < size() && !m_signature.has(tagId))
+                m_rowMasks[row].clear(tagId);
+        }
 
-        std::vector<Health> &healths() { return m_healths; }
-        const std::vector<Health> &healths() const { return m_healths; }
+        void clearRowTagAll(uint32_t tagId)
+        {
+            if (m_signature.has(tagId) || !m_rowTags.has(tagId))
+                return;
+            for (ComponentMask &m : m_rowMasks)
+                m.clear(tagId);
+        }
 
-        std::vector<MoveTarget> &moveTargets() { return m_moveTargets; }
-        const std::vector<MoveTarget> &moveTargets() const { return m_moveTargets; }
+        // Every row tag that was ever set in this store (conservative; never shrinks).
+        // Rows need individual filtering only if this intersects a query's required/excluded tags.
+        const ComponentMask &rowTags() const { return m_rowTags; }
 
-        std::vector<MoveSpeed> &moveSpeeds() { return m_moveSpeeds; }
-        const std::vector<MoveSpeed> &moveSpeeds() const { return m_moveSpeeds; }
+        // Generic typed column access (any type registered via ComponentRegistry::registerType).
+        template <typename T>
+        bool hasColumn() const { return findColumnByType(componentTypeIndex<T>()) != nullptr; }
 
-        std::vector<Radius> &radii() { return m_radii; }
-        const std::vector<Radius> &radii() const { return m_radii; }
+        // Empty for split columns (see vec3Column()). Mutable access marks the whole column changed.
+        template <typename T>
+        ColumnView<T> column()
+        {
+            const Column *c = findColumnByType(componentTypeIndex<T>());
+            if (c)
+                markColumn(*c);
+            return (c && !c->lanes) ? ColumnView<T>(static_cast<T *>(columnBase(*c)), size()) : ColumnView<T>{};
+        }
 
-        std::vector<Separation> &separations() { return m_separations; }
-        const std::vector<Separation> &separations() const { return m_separations; }
+        template <typename T>
+        ColumnView<const T> column() const
+        {
+            const Column *c = findColumnByType(componentTypeIndex<T>());
+            return (c && !c->lanes) ? ColumnView<const T>(static_cast<const T *>(columnBase(*c)), size()) : ColumnView<const T>{};
+        }
 
-        std::vector<AvoidanceParams> &avoidanceParams() { return m_avoidanceParams; }
-        const std::vector<AvoidanceParams> &avoidanceParams() const { return m_avoidanceParams; }
+        // {x, y, z} float components in whichever layout the column has.
+        template <typename T>
+        Vec3ColumnView<T> vec3Column()
+        {
+            const Column *c = findColumnByType(componentTypeIndex<T>());
+            if (c)
+                markColumn(*c);
+            return makeVec3View<T>(c);
+        }
 
-        std::vector<RenderModel> &renderModels() { return m_renderModels; }
-        const std::vector<RenderModel> &renderModels() const { return m_renderModels; }
+        template <typename T>
+        Vec3ColumnView<const T> vec3Column() const
+        {
+            return makeVec3View<const T>(findColumnByType(componentTypeIndex<T>()));
+        }
+
+        // Mutable access that marks nothing: the caller reports the rows it writes with markChanged()
+        // (Query does this per chunk).
+        template <typename T>
+        ColumnView<T> columnUnmarked()
+        {
+            const Column *c = findColumnByType(componentTypeIndex<T>());
+            return (c && !c->lanes) ? ColumnView<T>(static_cast<T *>(columnBase(*c)), size()) : ColumnView<T>{};
+        }
+
+        template <typename T>
+        Vec3ColumnView<T> vec3ColumnUnmarked()
+        {
+            return makeVec3View<T>(findColumnByType(componentTypeIndex<T>()));
+        }
+
+        // Built-in component columns (empty views if not present).
+        Vec3ColumnView<Position> positions() { return vec3Column<Position>(); }
+        Vec3ColumnView<const Position> positions() const { return vec3Column<Position>(); }
+
+        Vec3ColumnView<Velocity> velocities() { return vec3Column<Velocity>(); }
+        Vec3ColumnView<const Velocity> velocities() const { return vec3Column<Velocity>(); }
+
+        ColumnView<Health> healths() { return column<Health>(); }
+        ColumnView<const Health> healths() const { return column<Health>(); }
+
+        ColumnView<MoveTarget> moveTargets() { return column<MoveTarget>(); }
+        ColumnView<const MoveTarget> moveTargets() const { return column<MoveTarget>(); }
+
+        ColumnView<MoveSpeed> moveSpeeds() { return column<MoveSpeed>(); }
+        ColumnView<const MoveSpeed> moveSpeeds() const { return column<MoveSpeed>(); }
 
-        std::vector<RenderAnimation> &renderAnimations() { return m_renderAnimations; }
-        const std::vector<RenderAnimation> &renderAnimations() const { return m_renderAnimations; }
+        ColumnView<Radius> radii() { return column<Radius>(); }
+        ColumnView<const Radius> radii() const { return column<Radius>(); }
+
+        ColumnView<Separation> separations() { return column<Separation>(); }
+        ColumnView<const Separation> separations() const { return column<Separation>(); }
+
+        ColumnView<AvoidanceParams> avoidanceParams() { return column<AvoidanceParams>(); }
+        ColumnView<const AvoidanceParams> avoidanceParams() const { return column<AvoidanceParams>(); }
+
+        ColumnView<RenderModel> renderModels() { return column<RenderModel>(); }
+        ColumnView<const RenderModel> renderModels() const { return column<RenderModel>(); }
+
+        ColumnView<RenderAnimation> renderAnimations() { return column<RenderAnimation>(); }
+        ColumnView<const RenderAnimation> renderAnimations() const { return column<RenderAnimation>(); }
 
         // Helpers
-        bool hasPosition() const { return m_hasPosition; }
-        bool hasVelocity() const { return m_hasVelocity; }
-        bool hasHealth() const { return m_hasHealth; }
-        bool hasMoveTarget() const { return m_hasMoveTarget; }
-        bool hasMoveSpeed() const { return m_hasMoveSpeed; }
-        bool hasRadius() const { return m_hasRadius; }
-        bool hasSeparation() const { return m_hasSeparation; }
-        bool hasAvoidanceParams() const { return m_hasAvoidanceParams; }
-        bool hasRenderModel() const { return m_hasRenderModel; }
-        bool hasRenderAnimation() const { return m_hasRenderAnimation; }
-
-        // Resolve which known components are present in signature; enables arrays accordingly.
+        bool hasPosition() const { return hasColumn<Position>(); }
+        bool hasVelocity() const { return hasColumn<Velocity>(); }
+        bool hasHealth() const { return hasColumn<Health>(); }
+        bool hasMoveTarget() const { return hasColumn<MoveTarget>(); }
+        bool hasMoveSpeed() const { return hasColumn<MoveSpeed>(); }
+        bool hasRadius() const { return hasColumn<Radius>(); }
+        bool hasSeparation() const { return hasColumn<Separation>(); }
+        bool hasAvoidanceParams() const { return hasColumn<AvoidanceParams>(); }
+        bool hasRenderModel() const { return hasColumn<RenderModel>(); }
+        bool hasRenderAnimation() const { return hasColumn<RenderAnimation>(); }
+
+        // ---- Change versions (see the header notes) ----
+
+        // Rows per change-version slot.
+        static constexpr uint32_t ChangeChunkRows = 64;
+
+        // Clock writes are stamped from (ArchetypeStoreManager sets it); a store without one stamps 1.
+        void setChangeClock(const std::atomic<uint32_t> *clock) { m_changeClock = clock; }
+        uint32_t changeVersion() const { return m_changeClock ? m_changeClock->load(std::memory_order_relaxed) : 1u; }
+
+        // Version of the last row creation, removal or swap (row -> entity mapping changed).
+        uint32_t structureVersion() const { return m_structureVersion; }
+
+        // Version of the last write to any row of the column (0: never written or no such column).
+        uint32_t columnVersion(uint32_t componentId) const
+        {
+            const Column *c = findColumn(componentId);
+            return (c && m_versions) ? columnVersions(*c)[LatestSlot].load(std::memory_order_relaxed) : 0u;
+        }
+
+        // True if any column in 'componentIds' was written after 'version'.
+        bool changedSince(const ComponentMask &componentIds, uint32_t version) const
+        {
+            for (const Column &c : m_columns)
+            {
+                if (componentIds.has(c.componentId) && columnVersion(c.componentId) > version)
+                    return true;
+            }
+            return false;
+        }
+
+        // fn(begin, end) for each maximal row range in which a column of 'componentIds' was written
+        // after 'version', in row order. Ranges are ChangeChunkRows-aligned (the last one ends at size()).
+        template <typename Fn>
+        void forEachChangedRange(const ComponentMask &componentIds, uint32_t version, Fn &&fn) const
+        {
+            const uint32_t rows = size();
+            if (!m_versions || rows == 0)
+                return;
+
+            std::array<const std::atomic<uint32_t> *, ComponentMask::MaxComponents> changed;
+            uint32_t changedCount = 0;
+            for (const Column &c : m_columns)
+            {
+                if (!componentIds.has(c.componentId))
+                    continue;
+                const std::atomic<uint32_t> *slots = columnVersions(c);
+                if (slots[LatestSlot].load(std::memory_order_relaxed) <= version)
+                    continue;
+                if (slots[WholeSlot].load(std::memory_order_relaxed) > version)
+                {
+                    fn(0u, rows);
+                    return;
+                }
+                changed[changedCount++] = slots + FirstChunkSlot;
+            }
+            if (changedCount == 0)
+                return;
+
+            const uint32_t chunks = (rows + ChangeChunkRows - 1) / ChangeChunkRows;
+            uint32_t runBegin = UINT32_MAX;
+            for (uint32_t k = 0; k < chunks; ++k)
+            {
+                bool dirty = false;
+                for (uint32_t i = 0; i < changedCount && !dirty; ++i)
+                    dirty = changed[i][k].load(std::memory_order_relaxed) > version;
+                if (dirty && runBegin == UINT32_MAX)
+                    runBegin = k * ChangeChunkRows;
+                else if (!dirty && runBegin != UINT32_MAX)
+                {
+                    fn(runBegin, k * ChangeChunkRows);
+                    runBegin = UINT32_MAX;
+                }
+            }
+            if (runBegin != UINT32_MAX)
+                fn(runBegin, rows);
+        }
+
+        // Report writes made through unmarked access (rows [begin, end) of one column).
+        void markChanged(uint32_t componentId, uint32_t begin, uint32_t end)
+        {
+            if (const Column *c = findColumn(componentId))
+                markRows(*c, begin, std::min(end, size()));
+        }
+
+        template <typename T>
+        void markChanged(uint32_t begin, uint32_t end)
+        {
+            if (const Column *c = findColumnByType(componentTypeIndex<T>()))
+                markRows(*c, begin, std::min(end, size()));
+        }
+
+        // Create one column per signature component with storage info; tags get no column.
+        // Must be called before the first row is created.
         void resolveKnownComponents(ComponentRegistry &registry)
         {
-            const uint32_t posId = registry.ensureId("Position");
-            const uint32_t velId = registry.ensureId("Velocity");
-            const uint32_t heaId = registry.ensureId("Health");
-            const uint32_t tgtId = registry.ensureId("MoveTarget");
-            const uint32_t spdId = registry.ensureId("MoveSpeed");
-            const uint32_t radId = registry.ensureId("Radius");
-            const uint32_t sepId = registry.ensureId("Separation");
-            const uint32_t apId = registry.ensureId("AvoidanceParams");
-            const uint32_t rmId = registry.ensureId("RenderModel");
-            const uint32_t raId = registry.ensureId("RenderAnimation");
-            m_hasPosition = m_signature.has(posId);
-            m_hasVelocity = m_signature.has(velId);
-            m_hasHealth = m_signature.has(heaId);
-            m_hasMoveTarget = m_signature.has(tgtId);
-            m_hasMoveSpeed = m_signature.has(spdId);
-            m_hasRadius = m_signature.has(radId);
-            m_hasSeparation = m_signature.has(sepId);
-            m_hasAvoidanceParams = m_signature.has(apId);
-            m_hasRenderModel = m_signature.has(rmId);
-            m_hasRenderAnimation = m_signature.has(raId);
+            m_columns.clear();
+            m_columnIndex.fill(NoColumn);
+            m_typeColumn.fill(NoColumn);
+            for (uint32_t id = 0; id < ComponentMask::MaxComponents; ++id)
+            {
+                if (!m_signature.has(id))
+                    continue;
+                const ComponentTypeInfo *type = registry.typeInfo(id);
+                if (!type)
+                    continue;
+                m_columnIndex[id] = static_cast<uint16_t>(m_columns.size());
+                m_typeColumn[type->typeIndex] = static_cast<uint16_t>(m_columns.size());
+                m_columns.push_back(Column{id, type, 0, type->lanes});
+            }
         }
 
     private:
+        static constexpr uint16_t NoColumn = UINT16_MAX;
+
+        struct Column
+        {
+            uint32_t componentId = 0;
+            const ComponentTypeInfo *type = nullptr; // owned by ComponentRegistry
+            size_t offset = 0;                       // byte offset of element 0 inside m_block
+            uint32_t lanes = 0;                      // split layout: lane k of row r at offset + (k * laneRows() + r) * 4
+        };
+
+        const Column *findColumn(uint32_t componentId) const
+        {
+            if (componentId >= ComponentMask::MaxComponents || m_columnIndex[componentId] == NoColumn)
+                return nullptr;
+            return &m_columns[m_columnIndex[componentId]];
+        }
+
+        const Column *findColumnByType(uint32_t typeIndex) const
+        {
+            if (typeIndex >= ComponentMask::MaxComponents || m_typeColumn[typeIndex] == NoColumn)
+                return nullptr;
+            return &m_columns[m_typeColumn[typeIndex]];
+        }
+
+        void *columnBase(const Column &c) const { return m_block + c.offset; }
+        // Array-of-structs columns only.
+        void *elementPtr(const Column &c, uint32_t row) const
+        {
+            return m_block + c.offset + static_cast<size_t>(row) * c.type->size;
+        }
+
+        static size_t alignUp(size_t v, size_t a) { return (v + a - 1) & ~(a - 1); }
+
+        // Rows per lane of a split column: capacity rounded up so every lane starts on a cache line.
+        static uint32_t laneRowsFor(uint32_t capacity) { return static_cast<uint32_t>(alignUp(capacity, BlockAlign / 4)); }
+        uint32_t laneRows() const { return laneRowsFor(m_capacity); }
+
+        // Lanes hold 4-byte fields; they are copied as bytes here and read with the field type by users.
+        std::byte *laneData(const Column &c, uint32_t lane) const
+        {
+            return m_block + c.offset + static_cast<size_t>(lane) * laneRows() * 4;
+        }
+
+        // Copy row 'row' of any column to / from one packed struct.
+        void loadElement(const Column &c, uint32_t row, void *out) const
+        {
+            if (!c.lanes)
+            {
+                std::memcpy(out, elementPtr(c, row), c.type->size);
+                return;
+            }
+            std::byte *fields = static_cast<std::byte *>(out);
+            for (uint32_t k = 0; k < c.lanes; ++k)
+                std::memcpy(fields + k * 4, laneData(c, k) + static_cast<size_t>(row) * 4, 4);
+        }
+
+        void storeElement(const Column &c, uint32_t row, const void *in)
+        {
+            if (!c.lanes)
+            {
+                c.type->copyAssign(elementPtr(c, row), in);
+                return;
+            }
+            const std::byte *fields = static_cast<const std::byte *>(in);
+            for (uint32_t k = 0; k < c.lanes; ++k)
+                std::memcpy(laneData(c, k) + static_cast<size_t>(row) * 4, fields + k * 4, 4);
+        }
+
+        // Split columns: set rows [first, first + count) to one packed value.
+        void fillLanes(const Column &c, uint32_t first, uint32_t count, const void *value)
+        {
+            const std::byte *fields = static_cast<const std::byte *>(value);
+            for (uint32_t k = 0; k < c.lanes; ++k)
+            {
+                std::byte *lane = laneData(c, k);
+                for (uint32_t r = first; r < first + count; ++r)
+                    std::memcpy(lane + static_cast<size_t>(r) * 4, fields + k * 4, 4);
+            }
+        }
+
+        void constructRows(const Column &c, uint32_t first, uint32_t count)
+        {
+            if (c.lanes)
+            {
+                alignas(16) std::byte value[kMaxSplitComponentBytes];
+                c.type->construct(value);
+                fillLanes(c, first, count, value);
+                return;
+            }
+            for (uint32_t r = first; r < first + count; ++r)
+                c.type->construct(elementPtr(c, r));
+        }
+
+        // Change-version slots per column: whole-column writes, latest write, then one per chunk.
+        static constexpr size_t WholeSlot = 0;
+        static constexpr size_t LatestSlot = 1;
+        static constexpr size_t FirstChunkSlot = 2;
+
+        static uint32_t versionChunksFor(uint32_t capacity) { return (capacity + ChangeChunkRows - 1) / ChangeChunkRows; }
+        size_t versionSlots() const { return FirstChunkSlot + m_versionChunks; }
+
+        std::atomic<uint32_t> *columnVersions(const Column &c) const
+        {
+            return m_versions.get() + static_cast<size_t>(&c - m_columns.data()) * versionSlots();
+        }
+
+        // Versions only grow; concurrent writers (query chunks on a pool) may race on a shared slot.
+        static void raiseVersion(std::atomic<uint32_t> &slot, uint32_t version)
+        {
+            uint32_t current = slot.load(std::memory_order_relaxed);
+            while (current < version && !slot.compare_exchange_weak(current, version, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        void markRows(const Column &c, uint32_t begin, uint32_t end) const
+        {
+            if (!m_versions || begin >= end)
+                return;
+            const uint32_t version = changeVersion();
+            std::atomic<uint32_t> *slots = columnVersions(c);
+            raiseVersion(slots[LatestSlot], version);
+            for (uint32_t k = begin / ChangeChunkRows; k <= (end - 1) / ChangeChunkRows; ++k)
+                raiseVersion(slots[FirstChunkSlot + k], version);
+        }
+
+        void markColumn(const Column &c) const
+        {
+            if (!m_versions)
+                return;
+            const uint32_t version = changeVersion();
+            std::atomic<uint32_t> *slots = columnVersions(c);
+            raiseVersion(slots[WholeSlot], version);
+            raiseVersion(slots[LatestSlot], version);
+        }
+
+        // Rows [begin, end) were created or refilled by a swap: every column changed there.
+        void markStructure(uint32_t begin, uint32_t end)
+        {
+            for (const Column &c : m_columns)
+                markRows(c, begin, end);
+            m_structureVersion = changeVersion();
+        }
+
+        template <typename V>
+        Vec3ColumnView<V> makeVec3View(const Column *c) const
+        {
+            using Value = std::remove_const_t<V>;
+            static_assert(IsVec3Component<Value>::value, "vec3Column<T>() needs a plain {x, y, z} float component");
+            static_assert(sizeof(Value) == 3 * sizeof(float) && std::is_standard_layout_v<Value>, "{x, y, z} floats expected");
+            static_assert(offsetof(Value, x) == 0 && offsetof(Value, y) == 4 && offsetof(Value, z) == 8, "{x, y, z} floats expected");
+            using Float = std::conditional_t<std::is_const_v<V>, const float, float>;
+            if (!c || !m_block)
+                return {};
+            if (c->lanes)
+            {
+                Float *x = reinterpret_cast<Float *>(laneData(*c, 0));
+                const size_t lane = laneRows();
+                return Vec3ColumnView<V>(x, x + lane, x + 2 * lane, 1u, size());
+            }
+            Value *rows = static_cast<Value *>(columnBase(*c));
+            return Vec3ColumnView<V>(&rows->x, &rows->y, &rows->z, 3u, size());
+        }
+
+        // Reallocate all columns into one block sized for 'newCapacity' rows.
+        void grow(uint32_t newCapacity)
+        {
+            if (newCapacity <= m_capacity)
+                return;
+
+            const uint32_t newLaneRows = laneRowsFor(newCapacity);
+            size_t bytes = 0;
+            std::vector<size_t> offsets(m_columns.size());
+            for (size_t i = 0; i < m_columns.size(); ++i)
+            {
+                const Column &c = m_columns[i];
+                if (c.lanes)
+                {
+                    offsets[i] = alignUp(bytes, BlockAlign);
+                    bytes = offsets[i] + static_cast<size_t>(c.lanes) * newLaneRows * 4;
+                    continue;
+                }
+                offsets[i] = alignUp(bytes, c.type->align);
+                bytes = offsets[i] + static_cast<size_t>(c.type->size) * newCapacity;
+            }
+
+            std::byte *block = bytes ? static_cast<std::byte *>(::operator new(bytes, std::align_val_t(BlockAlign))) : nullptr;
+            const uint32_t n = size();
+            for (size_t i = 0; i < m_columns.size(); ++i)
+            {
+                Column &c = m_columns[i];
+                std::byte *dst = block + offsets[i];
+                std::byte *src = m_block ? m_block + c.offset : nullptr;
+                if (src && n > 0 && c.lanes)
+                {
+                    for (uint32_t k = 0; k < c.lanes; ++k)
+                        std::memcpy(dst + static_cast<size_t>(k) * newLaneRows * 4, laneData(c, k), static_cast<size_t>(n) * 4);
+                }
+                else if (src && n > 0)
+                {
+                    if (c.type->trivial)
+                    {
+                        std::memcpy(dst, src, static_cast<size_t>(c.type->size) * n);
+                    }
+                    else
+                    {
+                        for (uint32_t r = 0; r < n; ++r)
+                        {
+                            c.type->moveConstruct(dst + static_cast<size_t>(r) * c.type->size, src + static_cast<size_t>(r) * c.type->size);
+                            c.type->destroy(src + static_cast<size_t>(r) * c.type->size);
+                        }
+                    }
+                }
+                c.offset = offsets[i];
+            }
+
+            freeBlock(m_block);
+            m_block = block;
+            m_blockBytes = bytes;
+            m_capacity = newCapacity;
+
+            // Change versions: same slots per column, more chunks (new chunks start at 0).
+            const uint32_t chunks = versionChunksFor(newCapacity);
+            std::unique_ptr<std::atomic<uint32_t>[]> versions(new std::atomic<uint32_t>[m_columns.size() * (FirstChunkSlot + chunks)]());
+            for (size_t i = 0; m_versions && i < m_columns.size(); ++i)
+            {
+                for (size_t s = 0; s < versionSlots(); ++s)
+                    versions[i * (FirstChunkSlot + chunks) + s].store(m_versions[i * versionSlots() + s].load(std::memory_order_relaxed),
+                                                                   std::memory_order_relaxed);
+            }
+            m_versions = std::move(versions);
+            m_versionChunks = chunks;
+        }
+
+        void destroyRange(uint32_t begin, uint32_t end)
+        {
+            for (const Column &c : m_columns)
+            {
+                if (c.type->trivial || c.lanes)
+                    continue;
+                for (uint32_t r = begin; r < end; ++r)
+                    c.type->destroy(elementPtr(c, r));
+            }
+        }
+
+        static void freeBlock(std::byte *block)
+        {
+            if (block)
+                ::operator delete(block, std::align_val_t(BlockAlign));
+        }
+
+        // Columns start on cache-line boundaries at most; larger alignments are not supported.
+        static constexpr size_t BlockAlign = 64;
+
         ComponentMask m_signature;
         std::vector<Entity> m_entities;
         std::vector<ComponentMask> m_rowMasks;
+        ComponentMask m_rowTags; // union of per-row tags outside the signature
 
-        // Component arrays (only used if signature includes them).
-        std::vector<Position> m_positions;
-        std::vector<Velocity> m_velocities;
-        std::vector<Health> m_healths;
-        std::vector<MoveTarget> m_moveTargets;
-        std::vector<MoveSpeed> m_moveSpeeds;
-        std::vector<Radius> m_radii;
-        std::vector<Separation> m_separations;
-        std::vector<AvoidanceParams> m_avoidanceParams;
-        std::vector<RenderModel> m_renderModels;
-        std::vector<RenderAnimation> m_renderAnimations;
-
-        // Flags indicating which arrays are active.
-        bool m_hasPosition = false;
-        bool m_hasVelocity = false;
-        bool m_hasHealth = false;
-        bool m_hasMoveTarget = false;
-        bool m_hasMoveSpeed = false;
-        bool m_hasRadius = false;
-        bool m_hasSeparation = false;
-        bool m_hasAvoidanceParams = false;
-        bool m_hasRenderModel = false;
-        bool m_hasRenderAnimation = false;
+        // Column storage: one allocation holding every column back to back.
+        std::vector<Column> m_columns;
+        std::array<uint16_t, ComponentMask::MaxComponents> m_columnIndex = makeEmptyIndex(); // component ID -> column
+        std::array<uint16_t, ComponentMask::MaxComponents> m_typeColumn = makeEmptyIndex();  // type index -> column
+        std::byte *m_block = nullptr;
+        size_t m_blockBytes = 0;
+        uint32_t m_capacity = 0;
+
+        // Change versions: versionSlots() per column (column order), sized with the block by grow().
+        std::unique_ptr<std::atomic<uint32_t>[]> m_versions;
+        uint32_t m_versionChunks = 0;
+        uint32_t m_structureVersion = 0;
+        const std::atomic<uint32_t> *m_changeClock = nullptr; // owned by ArchetypeStoreManager
+
+        static std::array<uint16_t, ComponentMask::MaxComponents> makeEmptyIndex()
+        {
+            std::array<uint16_t, ComponentMask::MaxComponents> a{};
+            a.fill(NoColumn);
+            return a;
+        }
     };
 
     class ArchetypeStoreManager
     {
     public:
+        using QueryId = uint32_t;
+
         ArchetypeStore *getOrCreate(uint32_t archetypeId, const ComponentMask &signature, ComponentRegistry &registry)
         {
             if (archetypeId >= m_stores.size())
@@ -271,6 +1120,15 @@ namespace Engine::ECS
             {
                 m_stores[archetypeId] = std::make_unique<ArchetypeStore>(signature);
                 m_stores[archetypeId]->resolveKnownComponents(registry);
+                m_stores[archetypeId]->setChangeClock(m_changeClock.get());
+
+                // New store: append it to every cached query it satisfies.
+                std::lock_guard<std::mutex> lock(*m_queryMutex);
+                for (auto &q : m_queries)
+                {
+                    if (signature.matches(q->required, q->excluded))
+                        insertSorted(q->storeIds, archetypeId);
+                }
             }
             return m_stores[archetypeId].get();
         }
@@ -280,10 +1138,101 @@ namespace Engine::ECS
             return (archetypeId < m_stores.size()) ? m_stores[archetypeId].get() : nullptr;
         }
 
+        const ArchetypeStore *get(uint32_t archetypeId) const
+        {
+            return (archetypeId < m_stores.size()) ? m_stores[archetypeId].get() : nullptr;
+        }
+
         const std::vector<std::unique_ptr<ArchetypeStore>> &stores() const { return m_stores; }
 
+        // Version that writes are stamped with now (starts at 1).
+        uint32_t changeVersion() const { return m_changeClock->load(std::memory_order_relaxed); }
+
+        // Start a new change version and return the one that ended: every write so far is stamped with
+        // it or less, every later one with more. Each consumer advances once per pass and keeps the result
+        // as the 'since' of its next pass (start from 0 to see everything once). Read-only consumers may
+        // advance it too: the clock is not store data.
+        uint32_t advanceChangeVersion() const { return m_changeClock->fetch_add(1, std::memory_order_relaxed); }
+
+        // Move an attached entity's row into the store of 'dstArchetypeId' and fix up both records.
+        // Returns the new row (UINT32_MAX if the entity is not attached).
+        uint32_t moveEntity(EntitiesRecord &entities, Entity e, uint32_t dstArchetypeId,
+                            const ComponentMask &dstSignature, ComponentRegistry &registry)
+        {
+            const EntityRecord *rec = entities.find(e);
+            if (!rec)
+                return UINT32_MAX;
+            if (rec->archetypeId == dstArchetypeId)
+                return rec->row;
+
+            const uint32_t srcArchetypeId = rec->archetypeId;
+            const uint32_t srcRow = rec->row;
+            ArchetypeStore *src = get(srcArchetypeId);
+            if (!src)
+                return UINT32_MAX;
+            ArchetypeStore *dst = getOrCreate(dstArchetypeId, dstSignature, registry);
+
+            Entity moved;
+            const uint32_t row = src->moveRowTo(srcRow, *dst, moved);
+            if (moved.valid())
+                entities.attach(moved, srcArchetypeId, srcRow);
+            entities.attach(e, dstArchetypeId, row);
+            return row;
+        }
+
+        // Register (or reuse) a cached store filter. Safe to call from concurrently running systems.
+        QueryId registerQuery(const ComponentMask &required, const ComponentMask &excluded)
+        {
+            std::lock_guard<std::mutex> lock(*m_queryMutex);
+            for (size_t i = 0; i < m_queries.size(); ++i)
+            {
+                if (m_queries[i]->required == required && m_queries[i]->excluded == excluded)
+                    return static_cast<QueryId>(i);
+            }
+
+            auto q = std::make_unique<CachedQuery>();
+            q->required = required;
+            q->excluded = excluded;
+            for (uint32_t sid = 0; sid < static_cast<uint32_t>(m_stores.size()); ++sid)
+            {
+                if (m_stores[sid] && m_stores[sid]->signature().matches(required, excluded))
+                    q->storeIds.push_back(sid);
+            }
+            m_queries.push_back(std::move(q));
+            return static_cast<QueryId>(m_queries.size() - 1);
+        }
+
+        // Store IDs (ascending) matching a registered query.
+        // The reference stays valid for the manager's lifetime; contents change only when stores are created.
+        const std::vector<uint32_t> &matchingStores(QueryId id) const
+        {
+            std::lock_guard<std::mutex> lock(*m_queryMutex);
+            return m_queries[id]->storeIds;
+        }
+
     private:
+        struct CachedQuery
+        {
+            ComponentMask required;
+            ComponentMask excluded;
+            std::vector<uint32_t> storeIds;
+        };
+
+        static void insertSorted(std::vector<uint32_t> &ids, uint32_t id)
+        {
+            auto it = std::lower_bound(ids.begin(), ids.end(), id);
+            if (it == ids.end() || *it != id)
+                ids.insert(it, id);
+        }
+
         std::vector<std::unique_ptr<ArchetypeStore>> m_stores;
+
+        // Heap-allocated so the stores' pointers survive moving the manager (ECSContext::Reset).
+        std::unique_ptr<std::atomic<uint32_t>> m_changeClock = std::make_unique<std::atomic<uint32_t>>(1u);
+
+        // Entries are heap-allocated so references returned by matchingStores() survive new registrations.
+        std::vector<std::unique_ptr<CachedQuery>> m_queries;
+        std::unique_ptr<std::mutex> m_queryMutex = std::make_unique<std::mutex>();
     };
 
-} // namespace Engine::ECS
\ No newline at end of file
+} // namespace Engine::ECS
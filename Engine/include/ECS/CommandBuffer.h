@@ -0,0 +1,422 @@
+#pragma once
+/*
+  CommandBuffer.h
+  ---------------
+  Purpose:
+    - Record structural ECS changes (spawn, destroy, add/remove component, row tags) while
+      systems iterate, and apply them later at a sync point.
+    - Playback groups work by archetype: all moves between the same pair of stores run
+      back to back (one reserve per destination), spawns of one prefab become one batch.
+    - Destination archetypes are resolved through ArchetypeManager's cached transition edges.
+
+  Usage:
+    - During update:   commands.destroy(e);
+                       commands.addComponent(e, healthId, Health{50.0f});
+                       commands.addTag(e, selectedId);
+                       commands.spawn(prefab, Position{x, 0.0f, z});
+    - At a sync point: commands.playback(ecs.components, ecs.archetypes, ecs.stores, ecs.entities);
+
+  Notes:
+    - Recording is thread-safe (one short lock per command), so parallel chunks can share a buffer.
+    - Commands for the same entity apply in recording order; commands recorded from different
+      threads for the same entity have no defined order.
+    - Entity commands run before spawns; commands for dead entities are dropped.
+    - Spawns apply in (prefab name, position) order whatever the recording threads, so entity ids
+      come out the same on every lockstep peer.
+    - addComponent()/removeComponent() change the archetype; addTag()/removeTag() only flip the
+      row mask (cheap, like the "Selected" tag).
+    - Component values are copied as bytes, so they must be trivially copyable.
+*/
+
+#include "ECS/Components.h"
+#include "ECS/ArchetypeManager.h"
+#include "ECS/ArchetypeStore.h"
+#include "ECS/Entity.h"
+#include "ECS/Prefab.h"
+#include "ECS/PrefabSpawner.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace Engine::ECS
+{
+    class CommandBuffer
+    {
+    public:
+        // Queue a new entity from a prefab, optionally overriding its Position.
+        void spawn(const Prefab *prefab)
+        {
+            if (!prefab)
+                return;
+            std::lock_guard<std::mutex> lock(*m_mutex);
+            m_spawns.push_back(SpawnCommand{prefab, Position{}, false});
+        }
+
+        void spawn(const Prefab *prefab, const Position &position)
+        {
+            if (!prefab)
+                return;
+            std::lock_guard<std::mutex> lock(*m_mutex);
+            m_spawns.push_back(SpawnCommand{prefab, position, true});
+        }
+
+        void destroy(Entity e)
+        {
+            push(Command{Kind::Destroy, e, 0, 0, 0});
+        }
+
+        // Add a component (or archetype-level tag) without a value: the new column is default-constructed.
+        void addComponent(Entity e, uint32_t componentId)
+        {
+            push(Command{Kind::Add, e, componentId, 0, 0});
+        }
+
+        // Add a component and set its value (also overwrites the value if the entity already has it).
+        template <typename T>
+        void addComponent(Entity e, uint32_t componentId, const T &value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "CommandBuffer payloads are copied as bytes");
+            static_assert(alignof(T) <= PayloadAlign, "CommandBuffer payload alignment too large");
+
+            std::lock_guard<std::mutex> lock(*m_mutex);
+            const size_t offset = (m_payload.size() + PayloadAlign - 1) & ~(PayloadAlign - 1);
+            m_payload.resize(offset + sizeof(T));
+            std::memcpy(m_payload.data() + offset, &value, sizeof(T));
+            m_commands.push_back(Command{Kind::Add, e, componentId,
+                                         static_cast<uint32_t>(offset), static_cast<uint32_t>(sizeof(T))});
+        }
+
+        void removeComponent(Entity e, uint32_t componentId)
+        {
+            push(Command{Kind::Remove, e, componentId, 0, 0});
+        }
+
+        // Row-mask tags: no archetype change.
+        void addTag(Entity e, uint32_t tagId)
+        {
+            push(Command{Kind::AddTag, e, tagId, 0, 0});
+        }
+
+        void removeTag(Entity e, uint32_t tagId)
+        {
+            push(Command{Kind::RemoveTag, e, tagId, 0, 0});
+        }
+
+        bool empty() const
+        {
+            std::lock_guard<std::mutex> lock(*m_mutex);
+            return m_commands.empty() && m_spawns.empty();
+        }
+
+        // Reserved bytes of the recorded commands, spawns and payload (kept across playbacks).
+        size_t memoryBytes() const
+        {
+            std::lock_guard<std::mutex> lock(*m_mutex);
+            return m_commands.capacity() * sizeof(Command) + m_spawns.capacity() * sizeof(SpawnCommand) +
+                   m_payload.capacity();
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(*m_mutex);
+            m_commands.clear();
+            m_spawns.clear();
+            m_payload.clear();
+        }
+
+        // Apply every recorded command and clear the buffer. Must not run concurrently with systems.
+        // Returns the number of commands applied (batched spawns count once per entity).
+        uint32_t playback(ComponentRegistry &registry,
+                          ArchetypeManager &archetypes,
+                          ArchetypeStoreManager &stores,
+                          EntitiesRecord &entities)
+        {
+            std::lock_guard<std::mutex> lock(*m_mutex);
+
+            uint32_t applied = applyEntityCommands(registry, archetypes, stores, entities);
+            applied += applySpawns(registry, archetypes, stores, entities);
+
+            m_commands.clear();
+            m_spawns.clear();
+            m_payload.clear();
+            return applied;
+        }
+
+    private:
+        static constexpr size_t PayloadAlign = alignof(std::max_align_t);
+
+        enum class Kind : uint8_t
+        {
+            Destroy,
+            Add,
+            Remove,
+            AddTag,
+            RemoveTag
+        };
+
+        struct Command
+        {
+            Kind kind = Kind::Destroy;
+            Entity entity{};
+            uint32_t componentId = 0;
+            uint32_t payloadOffset = 0;
+            uint32_t payloadSize = 0; // 0 = no value
+        };
+
+        struct SpawnCommand
+        {
+            const Prefab *prefab = nullptr;
+            Position position{};
+            bool hasPosition = false;
+        };
+
+        // Net effect of all commands recorded for one entity.
+        struct Pending
+        {
+            Entity entity{};
+            uint32_t srcArchetype = UINT32_MAX;
+            uint32_t dstArchetype = UINT32_MAX;
+            ComponentMask dstSignature;
+            ComponentMask tagsSet;
+            ComponentMask tagsCleared;
+            bool destroyed = false;
+            uint32_t firstCommand = 0; // range into m_commands (sorted by entity)
+            uint32_t commandCount = 0;
+        };
+
+        void push(const Command &c)
+        {
+            std::lock_guard<std::mutex> lock(*m_mutex);
+            m_commands.push_back(c);
+        }
+
+        // Move 'moved' (swapped into 'row' of 'archetypeId' by a swap-remove) back to its record.
+        static void reattach(EntitiesRecord &entities, Entity moved, uint32_t archetypeId, uint32_t row)
+        {
+            if (moved.valid())
+                entities.attach(moved, archetypeId, row);
+        }
+
+        uint32_t applyEntityCommands(ComponentRegistry &registry,
+                                     ArchetypeManager &archetypes,
+                                     ArchetypeStoreManager &stores,
+                                     EntitiesRecord &entities)
+        {
+            if (m_commands.empty())
+                return 0;
+
+            // Group by entity handle; stable so each entity keeps its recording order.
+            std::stable_sort(m_commands.begin(), m_commands.end(), [](const Command &a, const Command &b)
+                             {
+                                 if (a.entity.index != b.entity.index)
+                                     return a.entity.index < b.entity.index;
+                                 return a.entity.generation < b.entity.generation; });
+
+            std::vector<Pending> pending;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_commands.size());)
+            {
+                uint32_t end = i + 1;
+                while (end < m_commands.size() && m_commands[end].entity.index == m_commands[i].entity.index &&
+                       m_commands[end].entity.generation == m_commands[i].entity.generation)
+                    ++end;
+
+                foldEntity(i, end, archetypes, entities, pending);
+                i = end;
+            }
+
+            // Batch by (source store, destination store); destroys of a store come first.
+            std::sort(pending.begin(), pending.end(), [](const Pending &a, const Pending &b)
+                      {
+                          if (a.srcArchetype != b.srcArchetype)
+                              return a.srcArchetype < b.srcArchetype;
+                          if (a.destroyed != b.destroyed)
+                              return a.destroyed;
+                          return a.dstArchetype < b.dstArchetype; });
+
+            uint32_t applied = 0;
+            for (size_t i = 0; i < pending.size(); ++i)
+            {
+                Pending &p = pending[i];
+                if (p.destroyed)
+                {
+                    applied += destroyEntity(p.entity, stores, entities) ? p.commandCount : 0;
+                    continue;
+                }
+
+                ArchetypeStore *dst = stores.getOrCreate(p.dstArchetype, p.dstSignature, registry);
+                if (p.dstArchetype != p.srcArchetype && (i == 0 || pending[i - 1].srcArchetype != p.srcArchetype ||
+                                                         pending[i - 1].dstArchetype != p.dstArchetype))
+                {
+                    // First move of this (src, dst) run: size the destination once.
+                    size_t run = 1;
+                    while (i + run < pending.size() && pending[i + run].srcArchetype == p.srcArchetype &&
+                           pending[i + run].dstArchetype == p.dstArchetype && !pending[i + run].destroyed)
+                        ++run;
+                    dst->reserve(dst->size() + static_cast<uint32_t>(run));
+                }
+
+                const uint32_t row = stores.moveEntity(entities, p.entity, p.dstArchetype, p.dstSignature, registry);
+                if (row == UINT32_MAX)
+                    continue;
+
+                // Values, in recording order (later writes win).
+                for (uint32_t c = p.firstCommand; c < p.firstCommand + p.commandCount; ++c)
+                {
+                    const Command &cmd = m_commands[c];
+                    if (cmd.kind == Kind::Add && cmd.payloadSize > 0 && p.dstSignature.has(cmd.componentId))
+                        dst->setComponentRaw(row, cmd.componentId, m_payload.data() + cmd.payloadOffset);
+                }
+
+                for (uint32_t id = 0; !(p.tagsSet.empty() && p.tagsCleared.empty()) && id < ComponentMask::MaxComponents; ++id)
+                {
+                    if (p.tagsSet.has(id))
+                        dst->setRowTag(row, id);
+                    if (p.tagsCleared.has(id))
+                        dst->clearRowTag(row, id);
+                }
+                applied += p.commandCount;
+            }
+            return applied;
+        }
+
+        // Reduce the commands [begin, end) of one entity to a single Pending entry.
+        void foldEntity(uint32_t begin, uint32_t end,
+                        ArchetypeManager &archetypes,
+                        EntitiesRecord &entities,
+                        std::vector<Pending> &out)
+        {
+            const Entity e = m_commands[begin].entity;
+            const EntityRecord *rec = entities.find(e);
+            const Archetype *arch = rec ? archetypes.get(rec->archetypeId) : nullptr;
+            if (!arch)
+                return; // dead, stale handle or never attached
+
+            Pending p;
+            p.entity = e;
+            p.srcArchetype = rec->archetypeId;
+            p.dstArchetype = rec->archetypeId;
+            p.firstCommand = begin;
+            p.commandCount = end - begin;
+
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                const Command &c = m_commands[i];
+                switch (c.kind)
+                {
+                case Kind::Destroy:
+                    p.destroyed = true;
+                    break;
+                case Kind::Add:
+                    p.dstArchetype = archetypes.withComponent(p.dstArchetype, c.componentId);
+                    break;
+                case Kind::Remove:
+                    p.dstArchetype = archetypes.withoutComponent(p.dstArchetype, c.componentId);
+                    break;
+                case Kind::AddTag:
+                    p.tagsSet.set(c.componentId);
+                    p.tagsCleared.clear(c.componentId);
+                    break;
+                case Kind::RemoveTag:
+                    p.tagsCleared.set(c.componentId);
+                    p.tagsSet.clear(c.componentId);
+                    break;
+                }
+            }
+
+            p.dstSignature = archetypes.get(p.dstArchetype)->signature;
+            out.push_back(p);
+        }
+
+        static bool destroyEntity(Entity e, ArchetypeStoreManager &stores, EntitiesRecord &entities)
+        {
+            const EntityRecord *rec = entities.find(e);
+            if (!rec)
+                return false;
+
+            const uint32_t archetypeId = rec->archetypeId;
+            const uint32_t row = rec->row;
+            if (ArchetypeStore *store = stores.get(archetypeId))
+                reattach(entities, store->destroyRow(row), archetypeId, row);
+            entities.destroy(e);
+            return true;
+        }
+
+        static std::array<uint32_t, 4> spawnKey(const SpawnCommand &s)
+        {
+            std::array<uint32_t, 4> key{s.hasPosition ? 1u : 0u, 0, 0, 0};
+            if (s.hasPosition)
+            {
+                std::memcpy(&key[1], &s.position.x, sizeof(float));
+                std::memcpy(&key[2], &s.position.z, sizeof(float));
+                std::memcpy(&key[3], &s.position.y, sizeof(float));
+            }
+            return key;
+        }
+
+        uint32_t applySpawns(ComponentRegistry &registry,
+                             ArchetypeManager &archetypes,
+                             ArchetypeStoreManager &stores,
+                             EntitiesRecord &entities)
+        {
+            if (m_spawns.empty())
+                return 0;
+
+            // Content order, not recording order: spawns recorded from parallel chunks arrive in thread
+            // order, which would hand out entity ids differently on each lockstep peer. Spawns with the
+            // same prefab and position are interchangeable, so their relative order does not matter.
+            std::sort(m_spawns.begin(), m_spawns.end(), [](const SpawnCommand &a, const SpawnCommand &b)
+                      {
+                          if (a.prefab != b.prefab)
+                          {
+                              const int byName = a.prefab->name.compare(b.prefab->name);
+                              return byName != 0 ? byName < 0 : a.prefab < b.prefab; // same name: not from one PrefabManager
+                          }
+                          return spawnKey(a) < spawnKey(b); });
+
+            uint32_t applied = 0;
+            std::vector<Position> positions;
+            for (size_t i = 0; i < m_spawns.size();)
+            {
+                size_t end = i + 1;
+                while (end < m_spawns.size() && m_spawns[end].prefab == m_spawns[i].prefab)
+                    ++end;
+
+                const Prefab &prefab = *m_spawns[i].prefab;
+                const uint32_t count = static_cast<uint32_t>(end - i);
+                const SpawnBatchResult res = spawnBatchFromPrefab(prefab, count, nullptr,
+                                                                  registry, archetypes, stores, entities);
+
+                // Keep prefab Position defaults for spawns recorded without a position.
+                ArchetypeStore *store = stores.get(res.archetypeId);
+                if (store && store->hasPosition())
+                {
+                    auto pos = store->vec3ColumnUnmarked<Position>(); // rows created above, already marked
+                    for (uint32_t k = 0; k < count; ++k)
+                    {
+                        if (m_spawns[i + k].hasPosition)
+                            pos[res.firstRow + k] = m_spawns[i + k].position;
+                    }
+                }
+
+                applied += res.count;
+                i = end;
+            }
+            return applied;
+        }
+
+        std::vector<Command> m_commands;
+        std::vector<SpawnCommand> m_spawns;
+        std::vector<std::byte> m_payload; // component values referenced by Command::payloadOffset
+
+        // Held by pointer so ECSContext (which owns a CommandBuffer) stays movable.
+        std::unique_ptr<std::mutex> m_mutex = std::make_unique<std::mutex>();
+    };
+
+} // namespace Engine::ECS
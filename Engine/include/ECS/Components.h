@@ -4,24 +4,35 @@
   ------------
   Purpose:
     - Define component data structures (Position, Velocity, Health).
-    - Provide ComponentRegistry for name <-> ID mapping (data-driven).
-    - Provide ComponentMask: dynamic bitset keyed by component IDs.
+    - Provide ComponentRegistry for name <-> ID mapping (data-driven) and per-ID storage info.
+    - Provide ComponentMask: fixed-width inline bitset keyed by component IDs.
 
   Usage:
     - ComponentRegistry gives stable numeric IDs for component names defined in JSON.
     - ComponentMask builds signatures using those IDs to represent an entity/archetype's component set.
 */
 
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 #include <string>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
 #include <unordered_map>
-#include <variant>
 #include <assets/Handles.h>
 
+// Maximum number of distinct component IDs (bits per ComponentMask). Must be a multiple of 64.
+#ifndef ENGINE_ECS_MAX_COMPONENTS
+#define ENGINE_ECS_MAX_COMPONENTS 128
+#endif
+static_assert(ENGINE_ECS_MAX_COMPONENTS > 0 && ENGINE_ECS_MAX_COMPONENTS % 64 == 0,
+              "ENGINE_ECS_MAX_COMPONENTS must be a positive multiple of 64");
+
 namespace Engine::ECS
 {
     // -----------------------
@@ -100,25 +111,180 @@ namespace Engine::ECS
     // Per-entity animation state (node TRS only; no skinning yet)
     struct RenderAnimation
     {
+        static constexpr uint32_t kUnresolved = 0xFFFFFFFFu;
+
         uint32_t clipIndex = 0;
         float timeSec = 0.0f;
         float speed = 1.0f;
         bool loop = false;
         bool playing = false;
+
+        // Length of clip 'durationClip', cached by CharacterAnimationSystem whenever clipIndex no longer
+        // matches it (set durationClip = kUnresolved after swapping the entity's model).
+        float durationSec = 0.0f;
+        float invDurationSec = 0.0f; // 0 when the clip has no length
+        uint32_t durationClip = kUnresolved;
     };
 
-    // Typed defaults per component ID (used by Prefabs/Stores).
-    using DefaultValue = std::variant<Position, Velocity, Health, MoveTarget, MoveSpeed, Radius, Separation, AvoidanceParams, RenderModel, RenderAnimation>;
+    // Registry name of each built-in component type (registered by ComponentRegistry's constructor).
+    template <typename T>
+    struct ComponentName;
+
+    template <> struct ComponentName<Position> { static constexpr const char *value = "Position"; };
+    template <> struct ComponentName<Velocity> { static constexpr const char *value = "Velocity"; };
+    template <> struct ComponentName<Health> { static constexpr const char *value = "Health"; };
+    template <> struct ComponentName<MoveTarget> { static constexpr const char *value = "MoveTarget"; };
+    template <> struct ComponentName<MoveSpeed> { static constexpr const char *value = "MoveSpeed"; };
+    template <> struct ComponentName<Radius> { static constexpr const char *value = "Radius"; };
+    template <> struct ComponentName<Separation> { static constexpr const char *value = "Separation"; };
+    template <> struct ComponentName<AvoidanceParams> { static constexpr const char *value = "AvoidanceParams"; };
+    template <> struct ComponentName<RenderModel> { static constexpr const char *value = "RenderModel"; };
+    template <> struct ComponentName<RenderAnimation> { static constexpr const char *value = "RenderAnimation"; };
+
+    // -----------------------
+    // Component type info (type-erased storage ops)
+    // -----------------------
+    // Dense index per C++ component type (assigned on first use, no RTTI).
+    // Used by stores for O(1) typed column lookup.
+    inline uint32_t nextComponentTypeIndex()
+    {
+        static std::atomic<uint32_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template <typename T>
+    inline uint32_t componentTypeIndex()
+    {
+        static const uint32_t index = nextComponentTypeIndex();
+        return index;
+    }
+
+    // Everything an ArchetypeStore needs to hold a column of some component type.
+    struct ComponentTypeInfo
+    {
+        uint32_t typeIndex = UINT32_MAX; // componentTypeIndex<T>(); UINT32_MAX = no storage (tag)
+        uint32_t size = 0;
+        uint32_t align = 0;
+        bool trivial = false; // trivially copyable: columns may memcpy
+        uint32_t lanes = 0;   // > 0: split layout, one array per 4-byte field (ComponentRegistry::setSplitLayout)
+
+        void (*construct)(void *dst) = nullptr;                  // default-construct in place
+        void (*copyAssign)(void *dst, const void *src) = nullptr; // dst already constructed
+        void (*moveConstruct)(void *dst, void *src) = nullptr;    // dst uninitialized
+        void (*moveAssign)(void *dst, void *src) = nullptr;       // dst already constructed
+        void (*destroy)(void *p) = nullptr;
+
+        bool valid() const { return typeIndex != UINT32_MAX; }
+    };
+
+    // Largest component that may use the split layout (bytes).
+    static constexpr uint32_t kMaxSplitComponentBytes = 64;
+
+    template <typename T>
+    inline ComponentTypeInfo makeComponentTypeInfo()
+    {
+        static_assert(alignof(T) <= 64, "ECS components must not require more than 64-byte alignment");
+        ComponentTypeInfo t;
+        t.typeIndex = componentTypeIndex<T>();
+        t.size = static_cast<uint32_t>(sizeof(T));
+        t.align = static_cast<uint32_t>(alignof(T));
+        t.trivial = std::is_trivially_copyable_v<T>;
+        t.construct = [](void *dst)
+        { new (dst) T(); };
+        t.copyAssign = [](void *dst, const void *src)
+        { *static_cast<T *>(dst) = *static_cast<const T *>(src); };
+        t.moveConstruct = [](void *dst, void *src)
+        { new (dst) T(std::move(*static_cast<T *>(src))); };
+        t.moveAssign = [](void *dst, void *src)
+        { *static_cast<T *>(dst) = std::move(*static_cast<T *>(src)); };
+        t.destroy = [](void *p)
+        { static_cast<T *>(p)->~T(); };
+        return t;
+    }
+
     // -----------------------
     // Component Registry
     // -----------------------
     // Maps component names (e.g., "Position") to stable numeric IDs, and vice versa.
     // This enables data-driven JSON to refer to components by name while the engine uses compact IDs.
+    //
+    // Components with data also register a ComponentTypeInfo (registerType<T>), which lets
+    // ArchetypeStore allocate a column for them. Names without type info are tags (row/signature bits only).
+    // Built-in components are registered on construction; games add their own with registerType<T>("Name").
     class ComponentRegistry
     {
     public:
         static constexpr uint32_t InvalidID = UINT32_MAX;
 
+        ComponentRegistry()
+        {
+            registerType<Position>();
+            registerType<Velocity>();
+            registerType<Health>();
+            registerType<MoveTarget>();
+            registerType<MoveSpeed>();
+            registerType<Radius>();
+            registerType<Separation>();
+            registerType<AvoidanceParams>();
+            registerType<RenderModel>();
+            registerType<RenderAnimation>();
+        }
+
+        // Register a component type with storage under 'name'; returns its ID.
+        template <typename T>
+        uint32_t registerType(const std::string &name)
+        {
+            const uint32_t id = ensureId(name);
+            if (componentTypeIndex<T>() >= ENGINE_ECS_MAX_COMPONENTS)
+                throw std::length_error("ComponentRegistry: too many component types (raise ENGINE_ECS_MAX_COMPONENTS): " + name);
+            if (m_types.size() <= id)
+                m_types.resize(id + 1);
+            m_types[id] = makeComponentTypeInfo<T>();
+            m_typeIndexToId[componentTypeIndex<T>()] = id;
+            return id;
+        }
+
+        // Built-in types: name comes from ComponentName<T>.
+        template <typename T>
+        uint32_t registerType() { return registerType<T>(ComponentName<T>::value); }
+
+        // ID registered for C++ type T; InvalidID if T was never registered.
+        template <typename T>
+        uint32_t typeId() const
+        {
+            auto it = m_typeIndexToId.find(componentTypeIndex<T>());
+            return (it != m_typeIndexToId.end()) ? it->second : InvalidID;
+        }
+
+        // Lay the columns of component 'id' out as one array per 4-byte field (x[], y[], z[] for
+        // Position) instead of an array of structs, so loops over a few fields load only those.
+        // Only for trivially copyable types built from 4-byte fields (at most kMaxSplitComponentBytes);
+        // returns false otherwise. Stores created earlier keep the layout they were created with.
+        bool setSplitLayout(uint32_t id, bool split = true)
+        {
+            if (id >= m_types.size() || !m_types[id].valid())
+                return false;
+            ComponentTypeInfo &t = m_types[id];
+            if (!split)
+            {
+                t.lanes = 0;
+                return true;
+            }
+            if (!t.trivial || t.size == 0 || t.size % 4 != 0 || t.align != 4 || t.size > kMaxSplitComponentBytes)
+                return false;
+            t.lanes = t.size / 4;
+            return true;
+        }
+
+        template <typename T>
+        bool setSplitLayout(bool split = true) { return setSplitLayout(typeId<T>(), split); }
+
+        // Storage info for a component ID; nullptr for tags / unknown IDs.
+        const ComponentTypeInfo *typeInfo(uint32_t id) const
+        {
+            return (id < m_types.size() && m_types[id].valid()) ? &m_types[id] : nullptr;
+        }
+
         // Register a component name and return its stable ID.
         // If already registered, returns the existing ID.
         uint32_t registerComponent(const std::string &name)
@@ -128,6 +294,8 @@ namespace Engine::ECS
                 return it->second;
 
             const uint32_t id = static_cast<uint32_t>(m_idToName.size());
+            if (id >= ENGINE_ECS_MAX_COMPONENTS)
+                throw std::length_error("ComponentRegistry: too many components (raise ENGINE_ECS_MAX_COMPONENTS): " + name);
             m_nameToId.emplace(name, id);
             m_idToName.emplace_back(name);
             return id;
@@ -162,85 +330,126 @@ namespace Engine::ECS
     private:
         std::unordered_map<std::string, uint32_t> m_nameToId;
         std::vector<std::string> m_idToName;
+        std::vector<ComponentTypeInfo> m_types;                  // id -> storage info (invalid for tags)
+        std::unordered_map<uint32_t, uint32_t> m_typeIndexToId;  // componentTypeIndex<T>() -> id
     };
 
     // -----------------------
-    // Component Mask (dynamic)
+    // Component Mask (fixed width)
     // -----------------------
-    // Represents a set of components by their IDs. Backed by 64-bit words.
+    // Represents a set of components by their IDs. Backed by an inline array of 64-bit words,
+    // so masks never allocate and arrays of masks (e.g. ArchetypeStore row masks) are contiguous.
+    // Capacity is ENGINE_ECS_MAX_COMPONENTS bits (multiple of 64); the registry refuses IDs beyond it.
     class ComponentMask
     {
     public:
+        static constexpr uint32_t MaxComponents = ENGINE_ECS_MAX_COMPONENTS;
+        static constexpr size_t WordCount = MaxComponents / 64;
+
         ComponentMask() = default;
 
-        // Set a bit for component ID.
+        // Set a bit for component ID (IDs beyond capacity are ignored).
         void set(uint32_t compId)
         {
-            ensureBit(compId);
-            const auto [wordIdx, bit] = bitPos(compId);
-            m_words[wordIdx] |= (uint64_t(1) << bit);
+            if (compId >= MaxComponents)
+                return;
+            m_words[compId / 64] |= (uint64_t(1) << (compId % 64));
         }
 
         // Clear a bit for component ID.
         void clear(uint32_t compId)
         {
-            if (!has(compId))
+            if (compId >= MaxComponents)
                 return;
-            const auto [wordIdx, bit] = bitPos(compId);
-            m_words[wordIdx] &= ~(uint64_t(1) << bit);
+            m_words[compId / 64] &= ~(uint64_t(1) << (compId % 64));
         }
 
         // Check if a bit for component ID is set.
         bool has(uint32_t compId) const
         {
-            const auto [wordIdx, bit] = bitPos(compId);
-            if (wordIdx >= m_words.size())
+            if (compId >= MaxComponents)
                 return false;
-            return (m_words[wordIdx] & (uint64_t(1) << bit)) != 0;
+            return (m_words[compId / 64] & (uint64_t(1) << (compId % 64))) != 0;
+        }
+
+        // The set operations below are branch-free fixed-length loops; the compiler unrolls
+        // and vectorizes them (WordCount is a compile-time constant).
+
+        // Set every bit of 'rhs' too (union).
+        void merge(const ComponentMask &rhs)
+        {
+            for (size_t i = 0; i < WordCount; ++i)
+                m_words[i] |= rhs.m_words[i];
         }
 
         // Return true if this mask contains all bits in 'rhs'.
         bool containsAll(const ComponentMask &rhs) const
         {
-            const size_t n = std::max(m_words.size(), rhs.m_words.size());
-            for (size_t i = 0; i < n; ++i)
-            {
-                const uint64_t a = i < m_words.size() ? m_words[i] : 0;
-                const uint64_t b = i < rhs.m_words.size() ? rhs.m_words[i] : 0;
-                if ((a & b) != b)
-                    return false;
-            }
-            return true;
+            uint64_t missing = 0;
+            for (size_t i = 0; i < WordCount; ++i)
+                missing |= rhs.m_words[i] & ~m_words[i];
+            return missing == 0;
         }
 
         // Return true if this mask contains none of the bits in 'rhs'.
         bool containsNone(const ComponentMask &rhs) const
         {
-            const size_t n = std::max(m_words.size(), rhs.m_words.size());
-            for (size_t i = 0; i < n; ++i)
-            {
-                const uint64_t a = i < m_words.size() ? m_words[i] : 0;
-                const uint64_t b = i < rhs.m_words.size() ? rhs.m_words[i] : 0;
-                if ((a & b) != 0)
-                    return false;
-            }
-            return true;
+            uint64_t common = 0;
+            for (size_t i = 0; i < WordCount; ++i)
+                common |= rhs.m_words[i] & m_words[i];
+            return common == 0;
         }
 
-        // Convenience: required/excluded match.
+        // Convenience: required/excluded match (single pass over the words).
         bool matches(const ComponentMask &required, const ComponentMask &excluded) const
         {
-            return containsAll(required) && containsNone(excluded);
+            uint64_t bad = 0;
+            for (size_t i = 0; i < WordCount; ++i)
+                bad |= (required.m_words[i] & ~m_words[i]) | (excluded.m_words[i] & m_words[i]);
+            return bad == 0;
+        }
+
+        // True if no bit is set.
+        bool empty() const
+        {
+            uint64_t any = 0;
+            for (size_t i = 0; i < WordCount; ++i)
+                any |= m_words[i];
+            return any == 0;
+        }
+
+        bool operator==(const ComponentMask &rhs) const
+        {
+            uint64_t diff = 0;
+            for (size_t i = 0; i < WordCount; ++i)
+                diff |= m_words[i] ^ rhs.m_words[i];
+            return diff == 0;
+        }
+        bool operator!=(const ComponentMask &rhs) const { return !(*this == rhs); }
+
+        // 64-bit hash over the mask words (no allocation); equal masks hash equally.
+        uint64_t hash() const
+        {
+            uint64_t h = 0x9E3779B97F4A7C15ull;
+            for (size_t i = 0; i < WordCount; ++i)
+            {
+                // splitmix64 finalizer per word, folded into the running hash
+                uint64_t w = m_words[i] + 0x9E3779B97F4A7C15ull * (i + 1);
+                w = (w ^ (w >> 30)) * 0xBF58476D1CE4E5B9ull;
+                w = (w ^ (w >> 27)) * 0x94D049BB133111EBull;
+                w ^= w >> 31;
+                h = (h ^ w) * 0x100000001B3ull;
+            }
+            return h ^ (h >> 32);
         }
 
         // Stable string key for dictionary indexing (hex of words, high word first).
+        // Debug/serialization only; lookups use hash().
         std::string toKey() const
         {
-            if (m_words.empty())
-                return "0";
             std::ostringstream oss;
             oss << std::hex << std::setfill('0');
-            for (size_t i = m_words.size(); i-- > 0;)
+            for (size_t i = WordCount; i-- > 0;)
             {
                 oss << std::setw(16) << m_words[i];
             }
@@ -256,24 +465,10 @@ namespace Engine::ECS
             return m;
         }
 
-        const std::vector<uint64_t> &words() const { return m_words; }
+        const std::array<uint64_t, WordCount> &words() const { return m_words; }
 
     private:
-        std::vector<uint64_t> m_words; // 64 bits per word
-
-        static std::pair<size_t, uint32_t> bitPos(uint32_t compId)
-        {
-            const size_t wordIdx = compId / 64;
-            const uint32_t bit = compId % 64;
-            return {wordIdx, bit};
-        }
-
-        void ensureBit(uint32_t compId)
-        {
-            const size_t need = compId / 64 + 1;
-            if (m_words.size() < need)
-                m_words.resize(need, 0);
-        }
+        std::array<uint64_t, WordCount> m_words{}; // 64 bits per word
     };
 
 } // namespace Engine::ECS
\ No newline at end of file
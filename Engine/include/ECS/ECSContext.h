@@ -12,6 +12,8 @@
 //   - ArchetypeStoreManager: lazily created SoA stores per archetype.
 //   - EntitiesRecord: control-plane mapping of entity handle -> (archetypeId, row).
 //   - PrefabManager: dictionary of prefabs keyed by name (SampleApp loads JSON and fills it).
+//   - CommandBuffer: structural changes recorded during system updates, applied by playbackCommands().
+//   - SelectionSet: selected entities (mirrored into a row tag by SelectionSet::syncRowTags).
 //
 // Notes:
 //   - Engine/Application owns lifetime of ECSContext.
@@ -23,6 +25,16 @@
 #include "ECS/ArchetypeStore.h"   // ArchetypeStoreManager
 #include "ECS/Entity.h"           // EntitiesRecord
 #include "ECS/Prefab.h"           // PrefabManager
+#include "ECS/Query.h"            // Query<Ts...>
+#include "ECS/CommandBuffer.h"    // CommandBuffer
+#include "ECS/Selection.h"        // SelectionSet
+
+#include <algorithm>
+#include <initializer_list>
+#include <string>
+#include <type_traits>
+#include <vector>
+
 namespace Engine::ECS
 {
     struct ECSContext
@@ -33,6 +45,165 @@ namespace Engine::ECS
         ArchetypeStoreManager stores;
         EntitiesRecord entities;
         PrefabManager prefabs;
+        CommandBuffer commands;
+        SelectionSet selection;
+
+        // Typed query over all stores holding every Ts and none of 'excludedNames' (const Ts: read-only).
+        template <typename... Ts>
+        Query<Ts...> query(std::initializer_list<const char *> excludedNames = {})
+        {
+            ComponentMask required;
+            (required.set(components.typeId<std::remove_const_t<Ts>>()), ...);
+            ComponentMask excluded;
+            for (const char *n : excludedNames)
+                excluded.set(components.ensureId(n));
+            return Query<Ts...>(stores, std::move(required), std::move(excluded));
+        }
+
+        // Immediate structural changes. Do not call while systems iterate; use 'commands' there.
+        // Adding a component without a column (a tag such as "Dead" or "Disabled") moves the entity
+        // to an archetype that excluded-tag queries skip as a whole store.
+        bool addComponent(Entity e, uint32_t componentId)
+        {
+            const EntityRecord *rec = entities.find(e);
+            if (!rec || componentId == ComponentRegistry::InvalidID)
+                return false;
+            const uint32_t dstId = archetypes.withComponent(rec->archetypeId, componentId);
+            const ComponentMask dstSignature = archetypes.get(dstId)->signature;
+            return stores.moveEntity(entities, e, dstId, dstSignature, components) != UINT32_MAX;
+        }
+
+        bool addComponent(Entity e, const char *name)
+        {
+            return addComponent(e, components.ensureId(name));
+        }
+
+        // Add (or overwrite) a typed component registered via ComponentRegistry::registerType.
+        template <typename T>
+        bool addComponent(Entity e, const T &value)
+        {
+            const uint32_t componentId = components.typeId<T>();
+            if (!addComponent(e, componentId))
+                return false;
+            const EntityRecord *rec = entities.find(e);
+            return stores.get(rec->archetypeId)->setComponentRaw(rec->row, componentId, &value);
+        }
+
+        bool removeComponent(Entity e, uint32_t componentId)
+        {
+            const EntityRecord *rec = entities.find(e);
+            if (!rec || componentId == ComponentRegistry::InvalidID)
+                return false;
+            const uint32_t dstId = archetypes.withoutComponent(rec->archetypeId, componentId);
+            const ComponentMask dstSignature = archetypes.get(dstId)->signature;
+            return stores.moveEntity(entities, e, dstId, dstSignature, components) != UINT32_MAX;
+        }
+
+        bool removeComponent(Entity e, const char *name)
+        {
+            return removeComponent(e, components.ensureId(name));
+        }
+
+        bool hasComponent(Entity e, uint32_t componentId) const
+        {
+            const EntityRecord *rec = entities.find(e);
+            const Archetype *arch = rec ? archetypes.get(rec->archetypeId) : nullptr;
+            return arch && arch->signature.has(componentId);
+        }
+
+        // Remove the entity's row (swap-remove) and free its handle.
+        bool destroyEntity(Entity e)
+        {
+            const EntityRecord *rec = entities.find(e);
+            if (!rec)
+                return false;
+            const uint32_t archetypeId = rec->archetypeId;
+            const uint32_t row = rec->row;
+            if (ArchetypeStore *store = stores.get(archetypeId))
+            {
+                const Entity moved = store->destroyRow(row);
+                if (moved.valid())
+                    entities.attach(moved, archetypeId, row);
+            }
+            entities.destroy(e);
+            return true;
+        }
+
+        // Apply deferred spawn/destroy/add/remove commands (call between system updates).
+        uint32_t playbackCommands()
+        {
+            return commands.playback(components, archetypes, stores, entities);
+        }
+
+        // Heap bytes of the ECS containers (capacity, not size).
+        struct MemoryUsage
+        {
+            size_t columnBytes = 0;       // component column blocks
+            size_t rowBytes = 0;          // per-row entity handles and masks
+            size_t entityRecordBytes = 0; // generations, freelist, records
+            size_t commandBytes = 0;      // deferred command buffer
+            uint32_t storeCount = 0;
+        };
+
+        MemoryUsage memoryUsage() const
+        {
+            MemoryUsage usage;
+            for (const auto &store : stores.stores())
+            {
+                if (!store)
+                    continue;
+                usage.storeCount++;
+                usage.columnBytes += store->columnBlockBytes();
+                usage.rowBytes += store->memoryBytes() - store->columnBlockBytes();
+            }
+            usage.entityRecordBytes = entities.memoryBytes();
+            usage.commandBytes = commands.memoryBytes();
+            return usage;
+        }
+
+        // Entities per non-empty archetype store, largest first, named by their components
+        // ("Health+Position+Velocity"). Stores past 'maxArchetypes' are summed into one "other" entry.
+        struct ArchetypeCount
+        {
+            std::string components;
+            uint32_t entities = 0;
+        };
+
+        std::vector<ArchetypeCount> archetypeCounts(uint32_t maxArchetypes) const
+        {
+            std::vector<const ArchetypeStore *> populated;
+            for (const auto &store : stores.stores())
+            {
+                if (store && store->size() > 0)
+                    populated.push_back(store.get());
+            }
+            std::sort(populated.begin(), populated.end(), [](const ArchetypeStore *a, const ArchetypeStore *b)
+                      { return a->size() > b->size(); });
+
+            std::vector<ArchetypeCount> out;
+            for (const ArchetypeStore *store : populated)
+            {
+                if (out.size() >= maxArchetypes)
+                {
+                    if (out.size() == maxArchetypes)
+                        out.push_back({"other", 0});
+                    out.back().entities += store->size();
+                    continue;
+                }
+                ArchetypeCount c;
+                for (uint32_t id = 0; id < components.count(); ++id)
+                {
+                    if (!store->signature().has(id))
+                        continue;
+                    if (!c.components.empty())
+                        c.components += '+';
+                    c.components += components.getName(id);
+                }
+                c.entities = store->size();
+                out.push_back(std::move(c));
+            }
+            return out;
+        }
 
         // Optional helper to reset state (typically not needed except in tests/tools).
         void Reset()
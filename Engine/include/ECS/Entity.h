@@ -11,11 +11,16 @@
     - Use EntitiesRecord.create() to get a fresh Entity.
     - After creating a row in an archetype store, call EntitiesRecord.attach(entity, archetypeId, row).
     - Use EntitiesRecord.find(entity) to get quick O(1) location info for per-entity operations.
+
+  Notes:
+    - Records live in a dense vector indexed by Entity::index (next to the generations),
+      so lookups are a bounds/generation check plus one array access, no hashing.
 */
 
+#include <cstddef>
 #include <cstdint>
+#include <utility>
 #include <vector>
-#include <unordered_map>
 
 namespace Engine::ECS
 {
@@ -33,6 +38,8 @@ namespace Engine::ECS
     {
         uint32_t archetypeId = UINT32_MAX; // ID of the archetype (component signature)
         uint32_t row = UINT32_MAX;         // Row index inside the archetype store's SoA
+
+        bool attached() const noexcept { return archetypeId != UINT32_MAX; }
     };
 
     // Central registry for creating/destroying entities and tracking their store membership.
@@ -53,6 +60,7 @@ namespace Engine::ECS
             {
                 idx = static_cast<uint32_t>(m_generations.size());
                 m_generations.emplace_back(0);
+                m_records.emplace_back();
             }
             ++m_generations[idx]; // new generation marks the handle as alive
             return Entity{idx, m_generations[idx]};
@@ -63,7 +71,7 @@ namespace Engine::ECS
         {
             if (!isAlive(e))
                 return;
-            m_records.erase(e.index);
+            m_records[e.index] = EntityRecord{};
             ++m_generations[e.index];
             m_free.push_back(e.index);
         }
@@ -87,30 +95,66 @@ namespace Engine::ECS
         {
             if (!isAlive(e))
                 return;
-            m_records.erase(e.index);
+            m_records[e.index] = EntityRecord{};
         }
 
         // Find record; returns nullptr if missing or dead.
         const EntityRecord *find(Entity e) const
         {
-            if (!isAlive(e))
+            if (!isAlive(e) || !m_records[e.index].attached())
                 return nullptr;
-            auto it = m_records.find(e.index);
-            return (it != m_records.end()) ? &it->second : nullptr;
+            return &m_records[e.index];
         }
 
         EntityRecord *find(Entity e)
         {
-            if (!isAlive(e))
+            if (!isAlive(e) || !m_records[e.index].attached())
+                return nullptr;
+            return &m_records[e.index];
+        }
+
+        // Entity and record at a raw index, in index order walks (nullptr when free or detached).
+        const EntityRecord *recordAt(uint32_t index, Entity &outEntity) const
+        {
+            if (index >= m_records.size() || !m_records[index].attached())
                 return nullptr;
-            auto it = m_records.find(e.index);
-            return (it != m_records.end()) ? &it->second : nullptr;
+            outEntity = Entity{index, m_generations[index]};
+            return &m_records[index];
+        }
+
+        // Raw state for snapshots (ECS/Snapshot.h): arrays indexed by Entity::index, plus the freelist.
+        const std::vector<uint32_t> &generations() const { return m_generations; }
+        const std::vector<uint32_t> &freeList() const { return m_free; }
+        const std::vector<EntityRecord> &records() const { return m_records; }
+
+        // Replace every handle and record; 'generations' and 'records' must have the same length.
+        void restore(std::vector<uint32_t> generations, std::vector<uint32_t> freeList, std::vector<EntityRecord> records)
+        {
+            m_generations = std::move(generations);
+            m_free = std::move(freeList);
+            m_records = std::move(records);
+        }
+
+        // Reserve index space for 'count' more entities (batch spawns).
+        void reserve(size_t count)
+        {
+            m_generations.reserve(m_generations.size() + count);
+            m_records.reserve(m_records.size() + count);
+        }
+
+        // Number of indices ever handed out (alive or free).
+        uint32_t capacity() const { return static_cast<uint32_t>(m_generations.size()); }
+
+        size_t memoryBytes() const
+        {
+            return m_generations.capacity() * sizeof(uint32_t) + m_free.capacity() * sizeof(uint32_t) +
+                   m_records.capacity() * sizeof(EntityRecord);
         }
 
     private:
-        std::vector<uint32_t> m_generations;                  // generation per index
-        std::vector<uint32_t> m_free;                         // freelist of indices
-        std::unordered_map<uint32_t, EntityRecord> m_records; // index -> record
+        std::vector<uint32_t> m_generations; // generation per index
+        std::vector<uint32_t> m_free;        // freelist of indices
+        std::vector<EntityRecord> m_records; // index -> record (dense, parallel to m_generations)
     };
 
 } // namespace Engine::ECS
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+/*
+  Interpolation.h
+  ---------------
+  Purpose:
+    - Keep the Position column of every store as it was before the latest fixed simulation tick,
+      so rendering can blend between ticks (TimeStep::Alpha) instead of snapping at tick rate.
+
+  Usage:
+    - Before each fixed tick:   history.capture(ecs.stores);
+    - While rendering a row:    Position p = history.interpolate(storeId, row, entities[row], positions[row], alpha);
+
+  Notes:
+    - Rows are matched by (storeId, row) and checked against the captured entity, so a row that
+      was swap-removed or migrated since the capture renders at its current position until the next capture.
+*/
+
+#include "ECS/ArchetypeStore.h"
+#include "ECS/Components.h"
+#include "ECS/Entity.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine::ECS
+{
+    class PositionHistory
+    {
+    public:
+        // Copy every store's Position column and row owners.
+        void capture(const ArchetypeStoreManager &stores)
+        {
+            const auto &all = stores.stores();
+            m_previous.resize(all.size());
+            for (size_t sid = 0; sid < all.size(); ++sid)
+            {
+                auto &prev = m_previous[sid];
+                if (!all[sid] || !all[sid]->hasPosition())
+                {
+                    prev.positions.clear();
+                    prev.entities.clear();
+                    continue;
+                }
+                const ArchetypeStore &store = *all[sid];
+                const auto positions = store.positions();
+                prev.positions.resize(positions.size());
+                for (uint32_t row = 0; row < positions.size(); ++row)
+                    prev.positions[row] = positions[row];
+                prev.entities.assign(store.entities().begin(), store.entities().end());
+            }
+            m_valid = true;
+        }
+
+        void clear()
+        {
+            m_previous.clear();
+            m_valid = false;
+        }
+
+        bool valid() const { return m_valid; }
+
+        // Blend from the captured position to 'current'. alpha = 1 returns 'current'.
+        Position interpolate(uint32_t storeId, uint32_t row, Entity entity, const Position &current, float alpha) const
+        {
+            if (storeId >= m_previous.size() || row >= m_previous[storeId].positions.size())
+                return current;
+            const Column &prev = m_previous[storeId];
+            if (prev.entities[row].index != entity.index || prev.entities[row].generation != entity.generation)
+                return current;
+            const Position &p = prev.positions[row];
+            return Position{p.x + (current.x - p.x) * alpha,
+                            p.y + (current.y - p.y) * alpha,
+                            p.z + (current.z - p.z) * alpha};
+        }
+
+    private:
+        struct Column
+        {
+            std::vector<Position> positions;
+            std::vector<Entity> entities; // owner of each captured row
+        };
+
+        std::vector<Column> m_previous; // per store ID
+        bool m_valid = false;
+    };
+
+} // namespace Engine::ECS
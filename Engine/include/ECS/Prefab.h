@@ -3,30 +3,46 @@
   Prefab.h
   --------
   Purpose:
-    - Define Prefab (name, signature, archetypeId, typed defaults).
+    - Define Prefab (name, signature, archetypeId, raw default values per component).
     - Define PrefabManager (dictionary keyed by name).
     - Provide JSON loader for Prefabs; constructs signature masks from ComponentRegistry,
       validates defaults, and resolves archetype via ArchetypeManager.
+    - Cooked binary prefabs (.sprefab): component names, model path and raw default values,
+      loaded with a handful of memcpys instead of parsing JSON.
 
   Usage:
-    - std::string text = readFileText("Sample/Entity.json");
-    - Prefab p = loadPrefabFromJson(text, registry, archetypes, assets);
-    - PrefabManager.add(p);
+    - Prefab p = loadPrefabFile("entities/Unit.json", registry, archetypes, assets);
+      (uses entities/Unit.sprefab when it is newer than the JSON, otherwise parses and re-cooks)
+    - Or: Prefab p = loadPrefabFromJson(readFileText(path), registry, archetypes, assets);
+    - p.defaults.set(registry.typeId<MyComponent>(), MyComponent{...}); // game types (JSON fills built-ins)
+    - PrefabManager.add(p, registry); // also resolves p.rowTemplate for the spawners
+
+  Notes:
+    - A .sprefab stores names, not component ids, so it stays valid when registration order changes.
+      Each cooked default keeps its byte size; a mismatch with the registered type rejects the file.
+    - RenderModel / RenderAnimation defaults are not cooked; they are recreated from the model path.
+    - Defaults must be trivially copyable; they are stored and cooked as bytes.
+    - rowTemplate is the spawn-time form of 'defaults': every trivial column of the archetype,
+      packed in column order, so spawning copies one block per column instead of per-entity values.
 */
 
 #include <string>
 #include <unordered_map>
-#include <variant>
 #include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
 #include <fstream>
 #include <sstream>
-#include <regex>
 #include <vector>
 #include <iostream>
 
 #include "ECS/Components.h"
 #include "ECS/ArchetypeManager.h"
-#include "assets/AssetManager.h"
+#include "ECS/ArchetypeStore.h"
+#include "assets/ModelSource.h"
+#include "utils/MappedFile.h"
 
 namespace Engine::ECS
 {
@@ -36,27 +52,70 @@ namespace Engine::ECS
         std::string name;
         ComponentMask signature; // built from component IDs
         uint32_t archetypeId = UINT32_MAX;
-        std::unordered_map<uint32_t, DefaultValue> defaults; // compId -> typed default
+        RowTemplate defaults;      // compId -> raw default value (defaults.set<T>(id, value) for game types)
+        std::string modelPath;     // "visual.model" as written (empty: none)
+        RowTemplate rowTemplate;   // resolved defaults (resolveRowTemplate)
 
         // Validate that defaults only include components present in the signature.
         bool validateDefaults() const
         {
-            for (const auto &kv : defaults)
+            for (const RowTemplate::Value &v : defaults.values)
             {
-                const uint32_t cid = kv.first;
-                if (!signature.has(cid))
+                if (!signature.has(v.componentId))
                     return false; // default provided for a component not in signature
             }
             return true;
         }
     };
 
+    // Pack one row for the prefab's archetype: each trivially copyable column of the signature holds
+    // the prefab default when one of the column's size exists, else a default-constructed value.
+    inline void resolveRowTemplate(Prefab &p, const ComponentRegistry &registry)
+    {
+        p.rowTemplate = RowTemplate{};
+        for (uint32_t id = 0; id < ComponentMask::MaxComponents; ++id)
+        {
+            if (!p.signature.has(id))
+                continue;
+            const ComponentTypeInfo *type = registry.typeInfo(id);
+            if (!type || !type->trivial)
+                continue;
+
+            RowTemplate::Value value{id, static_cast<uint32_t>(p.rowTemplate.bytes.size()), type->size};
+            p.rowTemplate.bytes.resize(value.offset + value.size);
+            uint8_t *dst = p.rowTemplate.bytes.data() + value.offset;
+
+            const RowTemplate::Value *def = p.defaults.find(id);
+            if (def && def->size == type->size)
+            {
+                std::memcpy(dst, p.defaults.data(*def), type->size);
+            }
+            else
+            {
+                void *tmp = ::operator new(type->size, std::align_val_t(type->align));
+                type->construct(tmp);
+                std::memcpy(dst, tmp, type->size);
+                type->destroy(tmp);
+                ::operator delete(tmp, std::align_val_t(type->align));
+            }
+            p.rowTemplate.values.push_back(value);
+        }
+    }
+
     // PrefabManager: dictionary keyed by prefab name.
     class PrefabManager
     {
     public:
+        // Stores 'p' as is: spawners fall back to applying its defaults per row.
         void add(const Prefab &p) { m_prefabs[p.name] = p; }
 
+        // Stores 'p' with its row template resolved against 'registry' (spawns become column copies).
+        void add(Prefab p, const ComponentRegistry &registry)
+        {
+            resolveRowTemplate(p, registry);
+            m_prefabs[p.name] = std::move(p);
+        }
+
         const Prefab *get(const std::string &name) const
         {
             auto it = m_prefabs.find(name);
@@ -72,13 +131,14 @@ namespace Engine::ECS
         std::unordered_map<std::string, Prefab> m_prefabs;
     };
 
-    // Utility: read a whole file into a string.
+    // Utility: read a whole file into a string (from a mounted AssetArchive when it has 'path').
     inline std::string readFileText(const std::string &path)
     {
-        std::ifstream in(path);
-        std::stringstream ss;
-        ss << in.rdbuf();
-        return ss.str();
+        MappedFile file;
+        std::string error;
+        if (!file.open(path, error))
+            return std::string{};
+        return std::string(reinterpret_cast<const char *>(file.data()), static_cast<size_t>(file.size()));
     }
 
     // Helper: build a signature mask from component names via ComponentRegistry.
@@ -95,202 +155,39 @@ namespace Engine::ECS
         return sig;
     }
 
+    // Parse one prefab JSON document (single pass, nlohmann::json). Returns a prefab with an empty
+    // name on malformed input. 'assets' is an AssetManager, or a HeadlessAssetManager on servers; it
+    // may be null (tools): "visual" is then ignored and the prefab gets no RenderModel / RenderAnimation.
+    Prefab loadPrefabFromJson(const std::string &jsonText,
+                              ComponentRegistry &registry,
+                              ArchetypeManager &archetypes,
+                              Engine::ModelSource *assets);
+
     inline Prefab loadPrefabFromJson(const std::string &jsonText,
                                      ComponentRegistry &registry,
                                      ArchetypeManager &archetypes,
-                                     Engine::AssetManager &assets)
+                                     Engine::ModelSource &assets)
     {
-        Prefab p;
-
-        // Extract name
-        {
-            std::regex re_name(R"re("name"\s*:\s*"([^"]+)")re");
-            std::smatch m;
-            if (std::regex_search(jsonText, m, re_name))
-                p.name = m[1].str();
-        }
-
-        // Extract components array
-        {
-            std::regex re_components(R"re("components"\s*:\s*\[([^\]]+)\])re");
-            std::smatch m;
-            if (std::regex_search(jsonText, m, re_components))
-            {
-                std::string inner = m[1].str();
-                std::regex re_item(R"re("([^"]+)")re");
-                auto it = std::sregex_iterator(inner.begin(), inner.end(), re_item);
-                auto end = std::sregex_iterator();
-                std::vector<std::string> names;
-                for (; it != end; ++it)
-                    names.push_back((*it)[1].str());
-                p.signature = buildSignatureFromNames(names, registry);
-            }
-        }
-
-        // Optional visuals: if a model is present, load it and apply a RenderModel default.
-        // JSON schema: "visual": { "model": "path" , ... }
-        {
-            std::regex re_model(R"re("visual"\s*:\s*\{[\s\S]*?"model"\s*:\s*"([^"]+)")re");
-            std::smatch m;
-            if (std::regex_search(jsonText, m, re_model))
-            {
-                const std::string modelPath = m[1].str();
-                if (!modelPath.empty())
-                {
-                    Engine::ModelHandle h = assets.loadModel(modelPath);
-                    if (h.isValid())
-                    {
-                        const uint32_t rmId = registry.ensureId("RenderModel");
-                        p.signature.set(rmId);
-
-                        RenderModel rm{};
-                        rm.handle = h;
-                        p.defaults[rmId] = rm;
-
-                        // Also add per-entity animation state (defaults: clip 0, time 0, looping, playing)
-                        const uint32_t raId = registry.ensureId("RenderAnimation");
-                        p.signature.set(raId);
-
-                        RenderAnimation ra{};
-                        p.defaults[raId] = ra;
-                    }
-                    else
-                    {
-                        std::cerr << "[Prefab] Warning: Failed to load model mesh: " << modelPath << " for prefab " << p.name << "\n";
-                    }
-                }
-            }
-        }
-
-        // Resolve archetype (after any signature adjustments like RenderMesh)
-        p.archetypeId = archetypes.getOrCreate(p.signature);
-
-        // Parse defaults: Position
-        {
-            std::regex re_pos(R"("Position"\s*:\s*\{\s*"x"\s*:\s*([-+]?\d*\.?\d+),\s*"y"\s*:\s*([-+]?\d*\.?\d+),\s*"z"\s*:\s*([-+]?\d*\.?\d+)\s*\})");
-            std::smatch m;
-            if (std::regex_search(jsonText, m, re_pos))
-            {
-                Position pos{};
-                pos.x = std::stof(m[1].str());
-                pos.y = std::stof(m[2].str());
-                pos.z = std::stof(m[3].str());
-                uint32_t cid = registry.ensureId("Position");
-                p.defaults.emplace(cid, pos);
-            }
-        }
-
-        // Parse defaults: Velocity
-        {
-            std::regex re_vel(R"("Velocity"\s*:\s*\{\s*"x"\s*:\s*([-+]?\d*\.?\d+),\s*"y"\s*:\s*([-+]?\d*\.?\d+),\s*"z"\s*:\s*([-+]?\d*\.?\d+)\s*\})");
-            std::smatch m;
-            if (std::regex_search(jsonText, m, re_vel))
-            {
-                Velocity vel{};
-                vel.x = std::stof(m[1].str());
-                vel.y = std::stof(m[2].str());
-                vel.z = std::stof(m[3].str());
-                uint32_t cid = registry.ensureId("Velocity");
-                p.defaults.emplace(cid, vel);
-            }
-        }
-
-        // Parse defaults: Health
-        {
-            std::regex re_health(R"("Health"\s*:\s*\{\s*"value"\s*:\s*([-+]?\d*\.?\d+)\s*\})");
-            std::smatch m;
-            if (std::regex_search(jsonText, m, re_health))
-            {
-                Health h{};
-                h.value = std::stof(m[1].str());
-                uint32_t cid = registry.ensureId("Health");
-                p.defaults.emplace(cid, h);
-            }
-        }
-
-        // Parse defaults: MoveTarget
-        {
-            std::regex re_target(R"("MoveTarget"\s*:\s*\{\s*"x"\s*:\s*([-+]?\d*\.?\d+),\s*"y"\s*:\s*([-+]?\d*\.?\d+),\s*"z"\s*:\s*([-+]?\d*\.?\d+),\s*"active"\s*:\s*(\d+)\s*\})");
-            std::smatch m;
-            if (std::regex_search(jsonText, m, re_target))
-            {
-                MoveTarget t{};
-                t.x = std::stof(m[1].str());
-                t.y = std::stof(m[2].str());
-                t.z = std::stof(m[3].str());
-                t.active = static_cast<uint8_t>(std::stoi(m[4].str()));
-                uint32_t cid = registry.ensureId("MoveTarget");
-                p.defaults.emplace(cid, t);
-            }
-        }
-
-        // Parse defaults: MoveSpeed
-        {
-            std::regex re_speed(R"("MoveSpeed"\s*:\s*\{\s*"value"\s*:\s*([-+]?\d*\.?\d+)\s*\})");
-            std::smatch m;
-            if (std::regex_search(jsonText, m, re_speed))
-            {
-                MoveSpeed s{};
-                s.value = std::stof(m[1].str());
-                uint32_t cid = registry.ensureId("MoveSpeed");
-                p.defaults.emplace(cid, s);
-            }
-        }
+        return loadPrefabFromJson(jsonText, registry, archetypes, &assets);
+    }
 
-        // Parse defaults: Radius
-        {
-            std::regex re_radius(R"("Radius"\s*:\s*\{\s*"r"\s*:\s*([-+]?\d*\.?\d+)\s*\})");
-            std::smatch m;
-            if (std::regex_search(jsonText, m, re_radius))
-            {
-                Radius r{};
-                r.r = std::stof(m[1].str());
-                uint32_t cid = registry.ensureId("Radius");
-                p.defaults.emplace(cid, r);
-            }
-        }
+    constexpr uint32_t PrefabBinaryVersion = 2;
 
-        // Parse defaults: Separation
-        {
-            std::regex re_sep(R"("Separation"\s*:\s*\{\s*"value"\s*:\s*([-+]?\d*\.?\d+)\s*\})");
-            std::smatch m;
-            if (std::regex_search(jsonText, m, re_sep))
-            {
-                Separation s{};
-                s.value = std::stof(m[1].str());
-                uint32_t cid = registry.ensureId("Separation");
-                p.defaults.emplace(cid, s);
-            }
-        }
+    // Cook a prefab into the .sprefab layout.
+    bool writePrefabBinary(const Prefab &prefab, const ComponentRegistry &registry, std::vector<uint8_t> &out);
 
-        // Parse defaults: AvoidanceParams
-        {
-            std::regex re_ap(R"("AvoidanceParams"\s*:\s*\{\s*"strength"\s*:\s*([-+]?\d*\.?\d+),\s*"maxAccel"\s*:\s*([-+]?\d*\.?\d+),\s*"blend"\s*:\s*([-+]?\d*\.?\d+)\s*\})");
-            std::smatch m;
-            if (std::regex_search(jsonText, m, re_ap))
-            {
-                AvoidanceParams ap{};
-                ap.strength = std::stof(m[1].str());
-                ap.maxAccel = std::stof(m[2].str());
-                ap.blend = std::stof(m[3].str());
-                uint32_t cid = registry.ensureId("AvoidanceParams");
-                p.defaults.emplace(cid, ap);
-            }
-        }
+    // Load a cooked prefab; returns a prefab with an empty name if 'data' is not a valid .sprefab
+    // of this version (callers fall back to the JSON).
+    Prefab loadPrefabFromBinary(const uint8_t *data, size_t size,
+                                ComponentRegistry &registry,
+                                ArchetypeManager &archetypes,
+                                Engine::ModelSource *assets);
 
-        // Validate defaults align with signature; drop mismatches to keep consistency.
-        if (!p.validateDefaults())
-        {
-            for (auto it = p.defaults.begin(); it != p.defaults.end();)
-            {
-                if (!p.signature.has(it->first))
-                    it = p.defaults.erase(it);
-                else
-                    ++it;
-            }
-        }
-
-        return p;
-    }
+    // Load 'jsonPath' through its cooked cache: the sibling .sprefab is used when it is at least as
+    // new as the JSON (or the JSON is missing); otherwise the JSON is parsed and the cache rewritten.
+    Prefab loadPrefabFile(const std::string &jsonPath,
+                          ComponentRegistry &registry,
+                          ArchetypeManager &archetypes,
+                          Engine::ModelSource *assets);
 
 } // namespace Engine::ECS
\ No newline at end of file
@@ -11,6 +11,14 @@
 
   Usage:
     - SpawnResult res = spawnFromPrefab(prefab, registry, archetypes, storeMgr, entities);
+    - SpawnBatchResult b = spawnBatchFromPrefab(prefab, count, positions, registry, archetypes, storeMgr, entities);
+      New rows are [b.firstRow, b.firstRow + b.count) in stores.get(b.archetypeId).
+
+  Notes:
+    - Prefabs with a resolved rowTemplate (PrefabManager::add(p, registry)) spawn by filling each
+      column straight from the template. Without one, the batch path resolves the prefab defaults
+      into the first new row, then copies that row into the rest (memcpy for trivial columns).
+    - The batch path reserves store/record capacity once either way.
 */
 
 #include "ECS/Prefab.h"
@@ -19,6 +27,8 @@
 #include "ECS/Entity.h"
 #include "ECS/Components.h"
 
+#include <vector>
+
 namespace Engine::ECS
 {
     // Result of spawning: includes entity handle, row index, and archetypeId.
@@ -29,6 +39,14 @@ namespace Engine::ECS
         uint32_t archetypeId = UINT32_MAX;
     };
 
+    // Result of a batch spawn: a contiguous row range in one store.
+    struct SpawnBatchResult
+    {
+        uint32_t archetypeId = UINT32_MAX;
+        uint32_t firstRow = UINT32_MAX;
+        uint32_t count = 0;
+    };
+
     inline SpawnResult spawnFromPrefab(const Prefab &prefab,
                                        ComponentRegistry &registry,
                                        ArchetypeManager &archetypes,
@@ -45,8 +63,15 @@ namespace Engine::ECS
         ArchetypeStore *store = stores.getOrCreate(prefab.archetypeId, prefab.signature, registry);
 
         // Create row and apply defaults
-        res.row = store->createRow(res.entity);
-        store->applyDefaults(res.row, prefab.defaults, registry);
+        if (!prefab.rowTemplate.empty())
+        {
+            res.row = store->createRowsFromTemplate(&res.entity, 1, prefab.rowTemplate);
+        }
+        else
+        {
+            res.row = store->createRow(res.entity);
+            store->applyDefaults(res.row, prefab.defaults, registry);
+        }
 
         // Attach entity to record for quick per-entity operations
         entities.attach(res.entity, res.archetypeId, res.row);
@@ -54,4 +79,52 @@ namespace Engine::ECS
         return res;
     }
 
-} // namespace Engine::ECS
\ No newline at end of file
+    // Spawn 'count' entities of one prefab. 'positions' (optional, 'count' entries) overrides
+    // the Position default per unit when the archetype has a Position column.
+    inline SpawnBatchResult spawnBatchFromPrefab(const Prefab &prefab,
+                                                 uint32_t count,
+                                                 const Position *positions,
+                                                 ComponentRegistry &registry,
+                                                 ArchetypeManager &archetypes,
+                                                 ArchetypeStoreManager &stores,
+                                                 EntitiesRecord &entities)
+    {
+        SpawnBatchResult res{};
+        res.archetypeId = prefab.archetypeId;
+        if (count == 0)
+            return res;
+
+        ArchetypeStore *store = stores.getOrCreate(prefab.archetypeId, prefab.signature, registry);
+
+        std::vector<Entity> created(count);
+        entities.reserve(count);
+        for (uint32_t i = 0; i < count; ++i)
+            created[i] = entities.create();
+
+        // One reservation, then straight column copies (from the template, or from a resolved first row).
+        res.count = count;
+        if (!prefab.rowTemplate.empty())
+        {
+            res.firstRow = store->createRowsFromTemplate(created.data(), count, prefab.rowTemplate);
+        }
+        else
+        {
+            res.firstRow = store->createRows(created.data(), count);
+            store->applyDefaults(res.firstRow, prefab.defaults, registry);
+            store->fillRowsFrom(res.firstRow, res.firstRow, res.firstRow + count);
+        }
+
+        if (positions && store->hasPosition())
+        {
+            auto pos = store->vec3ColumnUnmarked<Position>(); // rows created above, already marked
+            for (uint32_t i = 0; i < count; ++i)
+                pos[res.firstRow + i] = positions[i];
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+            entities.attach(created[i], res.archetypeId, res.firstRow + i);
+
+        return res;
+    }
+
+} // namespace Engine::ECS
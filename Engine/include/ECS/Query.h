@@ -0,0 +1,223 @@
+#pragma once
+/*
+  Query.h
+  -------
+  Purpose:
+    - Typed iteration over every archetype store that matches a (required, excluded) mask.
+    - Matching stores come from ArchetypeStoreManager's query cache (no per-frame signature scan).
+    - Splits each matching store into fixed-size row chunks; chunks can run serially or on a WorkerPool.
+
+  Usage:
+    - auto q = ecs.query<Position, Velocity, MoveSpeed>({"Disabled", "Dead"});
+    - q.parallelForChunks(&pool, [&](const QueryChunk &c, Vec3ColumnView<Position> pos,
+                                     Vec3ColumnView<Velocity> vel, MoveSpeed *speed) {
+          for (uint32_t row = c.begin; row < c.end; ++row)
+          {
+              if (!c.rowMatches(row))
+                  continue;
+              pos[row].x += vel[row].x * dt;
+          }
+      });
+
+  Notes:
+    - Columns arrive as QueryColumn<T>: T* for most components, Vec3ColumnView<T> for Position and
+      Velocity (either column layout). Both are indexed by store row (not by chunk-local index).
+    - Ask for columns the callback only reads as const T (query<Position, const Velocity>): those
+      arrive read-only and are not marked changed. Non-const columns are marked changed for the rows
+      of every chunk handed out (ArchetypeStore change versions).
+    - changedSince(version) visits only rows whose required columns (or a given mask) were written
+      after 'version', e.g. to re-upload or replicate just what moved.
+    - Chunks never span stores, so two chunks never alias the same row.
+    - Structural changes (spawn/destroy) must not happen while a query runs.
+    - Stores are matched by signature; per-row checks only run when a store has row tags
+      (ArchetypeStore::rowTags()) that intersect the excluded mask.
+*/
+
+#include "ECS/Components.h"
+#include "ECS/ArchetypeStore.h"
+#include "ECS/WorkerPool.h"
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace Engine::ECS
+{
+    // One contiguous row range of a single store.
+    struct QueryChunk
+    {
+        ArchetypeStore *store = nullptr;
+        uint32_t storeId = 0; // index into ArchetypeStoreManager::stores()
+        uint32_t begin = 0;   // first row (inclusive)
+        uint32_t end = 0;     // last row (exclusive)
+
+        const ComponentMask *required = nullptr;
+        const ComponentMask *excluded = nullptr;
+        bool filterRows = true; // false when no row tag in this store can affect the query
+
+        // Row-level filter (row masks may carry tags beyond the store signature).
+        bool rowMatches(uint32_t row) const
+        {
+            return !filterRows || store->rowMasks()[row].matches(*required, *excluded);
+        }
+    };
+
+    // What a query hands its callback for component T (const T: read-only).
+    template <typename T>
+    using QueryColumn = std::conditional_t<IsVec3Component<std::remove_const_t<T>>::value, Vec3ColumnView<T>, T *>;
+
+    // Mutable columns come unmarked: Query marks the rows of each chunk it hands out instead.
+    template <typename T>
+    QueryColumn<T> queryColumn(ArchetypeStore &store)
+    {
+        using Value = std::remove_const_t<T>;
+        const ArchetypeStore &readOnly = store;
+        if constexpr (IsVec3Component<Value>::value && std::is_const_v<T>)
+            return readOnly.template vec3Column<Value>();
+        else if constexpr (IsVec3Component<Value>::value)
+            return store.template vec3ColumnUnmarked<Value>();
+        else if constexpr (std::is_const_v<T>)
+            return readOnly.template column<Value>().data();
+        else
+            return store.template columnUnmarked<Value>().data();
+    }
+
+    template <typename... Ts>
+    class Query
+    {
+    public:
+        static constexpr uint32_t DefaultChunkRows = 1024;
+
+        Query(ArchetypeStoreManager &stores, ComponentMask required, ComponentMask excluded)
+            : m_stores(stores), m_required(std::move(required)), m_excluded(std::move(excluded))
+        {
+            m_queryId = m_stores.registerQuery(m_required, m_excluded);
+        }
+
+        // Reuse an already registered store filter (see ArchetypeStoreManager::registerQuery).
+        Query(ArchetypeStoreManager &stores, ComponentMask required, ComponentMask excluded,
+              ArchetypeStoreManager::QueryId cachedId)
+            : m_stores(stores), m_required(std::move(required)), m_excluded(std::move(excluded)), m_queryId(cachedId) {}
+
+        Query &chunkRows(uint32_t rows)
+        {
+            m_chunkRows = (rows > 0) ? rows : 1u;
+            return *this;
+        }
+
+        // Only visit rows where a column in 'componentIds' was written after 'version'
+        // (ArchetypeStoreManager::advanceChangeVersion); ArchetypeStore::ChangeChunkRows granularity.
+        Query &changedSince(const ComponentMask &componentIds, uint32_t version)
+        {
+            m_changedOnly = true;
+            m_changedIds = componentIds;
+            m_changedVersion = version;
+            return *this;
+        }
+
+        // As above, over the required components.
+        Query &changedSince(uint32_t version) { return changedSince(m_required, version); }
+
+        // fn(const QueryChunk&, QueryColumn<Ts>...) on the calling thread.
+        template <typename Fn>
+        void forChunks(Fn &&fn)
+        {
+            collect();
+            for (const auto &c : m_chunks)
+                std::apply([&](QueryColumn<Ts>... cols)
+                           { fn(c.chunk, cols...); },
+                           c.columns);
+        }
+
+        // fn(const QueryChunk&, QueryColumn<Ts>...) spread over the pool; serial if pool is null.
+        // fn must be safe to call concurrently for different chunks.
+        template <typename Fn>
+        void parallelForChunks(WorkerPool *pool, Fn &&fn)
+        {
+            if (!pool)
+            {
+                forChunks(fn);
+                return;
+            }
+
+            collect();
+            pool->parallelFor(static_cast<uint32_t>(m_chunks.size()), 1u, [&](uint32_t begin, uint32_t end)
+                              {
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    const auto &c = m_chunks[i];
+                    std::apply([&](QueryColumn<Ts>... cols)
+                               { fn(c.chunk, cols...); },
+                               c.columns);
+                } });
+        }
+
+        const ComponentMask &required() const { return m_required; }
+        const ComponentMask &excluded() const { return m_excluded; }
+
+    private:
+        struct Entry
+        {
+            QueryChunk chunk;
+            std::tuple<QueryColumn<Ts>...> columns;
+        };
+
+        void collect()
+        {
+            m_chunks.clear();
+
+            for (uint32_t sid : m_stores.matchingStores(m_queryId))
+            {
+                ArchetypeStore *store = m_stores.get(sid);
+                if (!store || store->size() == 0)
+                    continue;
+                if (!(store->template hasColumn<std::remove_const_t<Ts>>() && ...))
+                    continue;
+
+                const std::tuple<QueryColumn<Ts>...> cols{queryColumn<Ts>(*store)...};
+                const bool filterRows = !store->rowTags().containsNone(m_excluded);
+                auto addRows = [&](uint32_t first, uint32_t last)
+                {
+                    for (uint32_t begin = first; begin < last; begin += m_chunkRows)
+                    {
+                        Entry e;
+                        e.chunk.store = store;
+                        e.chunk.storeId = sid;
+                        e.chunk.begin = begin;
+                        e.chunk.end = (last - begin > m_chunkRows) ? (begin + m_chunkRows) : last;
+                        e.chunk.required = &m_required;
+                        e.chunk.excluded = &m_excluded;
+                        e.chunk.filterRows = filterRows;
+                        e.columns = cols;
+                        m_chunks.push_back(e);
+                    }
+                    (markWritten<Ts>(*store, first, last), ...);
+                };
+
+                if (m_changedOnly)
+                    store->forEachChangedRange(m_changedIds, m_changedVersion, addRows);
+                else
+                    addRows(0, store->size());
+            }
+        }
+
+        template <typename T>
+        static void markWritten(ArchetypeStore &store, uint32_t begin, uint32_t end)
+        {
+            if constexpr (!std::is_const_v<T>)
+                store.template markChanged<T>(begin, end);
+        }
+
+        ArchetypeStoreManager &m_stores;
+        ComponentMask m_required;
+        ComponentMask m_excluded;
+        ArchetypeStoreManager::QueryId m_queryId = 0;
+        uint32_t m_chunkRows = DefaultChunkRows;
+        bool m_changedOnly = false;
+        ComponentMask m_changedIds;
+        uint32_t m_changedVersion = 0;
+        std::vector<Entry> m_chunks;
+    };
+
+} // namespace Engine::ECS
@@ -0,0 +1,131 @@
+#pragma once
+/*
+  RegionPartition.h
+  -----------------
+  Purpose:
+    - Split one large world across several simulation processes. The ground plane (X/Z) is cut into
+      a grid of regions (RegionLayout); each process owns the entities inside its region
+      (RegionShard over its own ECSContext).
+    - Entities crossing into another region migrate: the owner removes them and sends them as an
+      entity-subset snapshot (ECS/Snapshot.h), the new owner appends them.
+    - Owned entities near a border are mirrored every tick into the neighbouring regions as
+      read-only ghosts, so neighbor queries (SpatialIndexSystem, LocalAvoidanceSystem) see across
+      the seam.
+
+  Usage:
+    - RegionLayout layout{-2048, -2048, 2048, 2048, 4, 4};
+      RegionShard shard(layout, myRegion, 8.0f); // halo: at least the largest neighbor query radius
+      shard.initialize(ecs.components);
+    - Per tick, after the simulation:  shard.exportTick(ecs, messages, err);   // send each to m.toRegion
+      before the next tick, for every message received: shard.importMessage(ecs, bytes, size, err);
+
+  Notes:
+    - Ghosts carry the "RegionGhost" tag in their signature (separate stores). Systems that move or
+      write units must exclude it; systems that only read neighbors keep seeing ghosts.
+    - Every halo neighbor gets a message each tick (possibly with an empty halo) that replaces all
+      ghosts previously received from the sender; a halo older than the last one applied is ignored.
+    - Messages are in native byte order (peers run the same build); the transport is up to the caller.
+      Apply them in a fixed order (e.g. by sender region) to keep peers deterministic.
+    - Migrants get fresh handles: arrivals() maps the sender's handles to the new ones, so game
+      state outside the ECS (paths, formations) can follow. Exports and imports happen between
+      ticks, never while systems iterate.
+*/
+
+#include "ECS/ECSContext.h"
+#include "ECS/Snapshot.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Engine::ECS
+{
+    // The world rectangle cut into regionsX x regionsZ equal regions (row-major, z outer).
+    struct RegionLayout
+    {
+        float minX = 0.0f, minZ = 0.0f, maxX = 0.0f, maxZ = 0.0f;
+        uint32_t regionsX = 1, regionsZ = 1;
+
+        bool valid() const { return maxX > minX && maxZ > minZ && regionsX > 0 && regionsZ > 0; }
+        uint32_t regionCount() const { return regionsX * regionsZ; }
+
+        // Owner of a ground-plane point; points outside the world go to the nearest edge region.
+        uint32_t regionAt(float x, float z) const;
+
+        void bounds(uint32_t region, float &outMinX, float &outMinZ, float &outMaxX, float &outMaxZ) const;
+
+        // Ground distance from (x, z) to a region's rectangle (0 inside). Edge regions extend
+        // without limit outward, like regionAt().
+        float distanceTo(uint32_t region, float x, float z) const;
+    };
+
+    struct RegionMessage
+    {
+        uint32_t toRegion = 0;
+        std::vector<uint8_t> bytes;
+    };
+
+    class RegionShard
+    {
+    public:
+        static constexpr const char *GhostTagName = "RegionGhost";
+
+        RegionShard(const RegionLayout &layout, uint32_t region, float haloWidth);
+
+        // Register the ghost tag; call once after the components are registered.
+        void initialize(ComponentRegistry &registry);
+
+        const RegionLayout &layout() const { return m_layout; }
+        uint32_t region() const { return m_region; }
+        float haloWidth() const { return m_haloWidth; }
+        uint32_t ghostTagId() const { return m_ghostId; }
+
+        // Regions that receive this one's halo (rectangles within haloWidth of ours).
+        const std::vector<uint32_t> &haloNeighbors() const { return m_neighbors; }
+
+        // Pack this tick's migrants (owned entities outside the region, removed from 'ecs') and halos
+        // into one message per receiving region.
+        bool exportTick(ECSContext &ecs, std::vector<RegionMessage> &out, std::string &outError);
+
+        // Apply a message from another region: migrants become owned here, the halo replaces the
+        // sender's ghosts.
+        bool importMessage(ECSContext &ecs, const uint8_t *data, size_t size, std::string &outError);
+
+        // Migrants appended by the last importMessage() (sender's handle -> handle here).
+        const std::vector<SnapshotSpawn> &arrivals() const { return m_arrivals; }
+
+        // Ghosts currently mirrored from 'region' (owner's handle -> ghost handle here).
+        const std::vector<SnapshotSpawn> &ghosts(uint32_t region) const;
+
+        struct Stats
+        {
+            uint32_t migratedOut = 0; // last exportTick()
+            uint32_t haloSent = 0;    // last exportTick(), summed over neighbors
+            uint32_t migratedIn = 0;  // since the last exportTick()
+            uint32_t ghosts = 0;      // mirrored now
+        };
+        const Stats &stats() const { return m_stats; }
+
+    private:
+        void dropGhosts(ECSContext &ecs, uint32_t fromRegion);
+
+        RegionLayout m_layout;
+        uint32_t m_region = 0;
+        float m_haloWidth = 0.0f;
+        uint32_t m_ghostId = ComponentRegistry::InvalidID;
+        std::vector<uint32_t> m_neighbors;
+
+        uint32_t m_tick = 0;
+        std::vector<std::vector<SnapshotSpawn>> m_ghosts; // by sender region
+        std::vector<uint32_t> m_lastHaloTick;             // by sender region (0 = none yet)
+        std::vector<SnapshotSpawn> m_arrivals;
+        Stats m_stats;
+
+        // Scratch
+        std::vector<std::vector<Entity>> m_outgoing; // by region: migrants
+        std::vector<std::vector<Entity>> m_halo;     // by region: border entities
+        std::vector<uint8_t> m_migrateBytes;
+        std::vector<uint8_t> m_haloBytes;
+    };
+}
@@ -0,0 +1,231 @@
+#pragma once
+/*
+  Replication.h
+  -------------
+  Purpose:
+    - Stream simulation state from a server world to spectator clients at tick rate.
+    - ColumnChangeTracker diffs chosen store columns against the previous tick and reports
+      per-column dirty row ranges, so only rows that actually changed are re-read. Only chunks written
+      since the previous update (ArchetypeStore change versions) are compared.
+    - ReplicationServer quantizes Position / Velocity, delta-encodes every client's packet against
+      the last state that client acknowledged and spends a per-packet byte budget on the entities
+      nearest to the client's camera first (interest management).
+    - ReplicationClient decodes packets into its own copy of the replicated state.
+
+  Usage:
+    - Server:  ReplicationServer server; server.initialize(ecs.components);
+               const uint32_t c = server.addClient();
+               per tick, after the simulation: server.captureTick(ecs);
+                                               server.setClientView(c, camX, camZ, radius);
+                                               server.writePacket(c, bytes); // send 'bytes'
+               on receiving an ack:            server.acknowledge(c, ackedTick);
+    - Client:  ReplicationClient client; client.readPacket(bytes.data(), bytes.size(), err);
+               send client.ackTick() back; client.forEach([](Entity e, const Position &p, const Velocity &v) {...});
+
+  Notes:
+    - Packets are plain byte vectors (varint encoded, independent of byte order); the transport is up to the caller.
+      Unacknowledged packets may be lost or reordered: a client only applies a packet whose baseline
+      it still holds, and the server falls back to a full state once the acked baseline left its history.
+    - Entities whose update did not fit the budget keep waiting with a growing priority, so far units
+      are refreshed less often but never starve.
+    - Entities without Position are not replicated; a missing Velocity replicates as zero.
+    - Server and client must use the same ReplicationConfig quantization steps.
+    - Entity handles are the server's; mapping them to client-side entities (visuals) is up to the caller.
+*/
+
+#include "ECS/ECSContext.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace Engine::ECS
+{
+    struct ReplicationConfig
+    {
+        float positionStep = 1.0f / 64.0f;  // meters per quantum (int32 per axis)
+        float velocityStep = 1.0f / 128.0f; // m/s per quantum (int16 per axis, +-255 m/s)
+        uint32_t maxPacketBytes = 8 * 1024; // entity payload budget per client per tick
+        uint32_t historyTicks = 32;         // unacknowledged ticks kept per client / held by a client
+    };
+
+    // Quantized replicated state of one entity.
+    struct NetEntityState
+    {
+        uint32_t index = 0;
+        uint32_t generation = 0;
+        int32_t position[3] = {0, 0, 0};
+        int16_t velocity[3] = {0, 0, 0};
+    };
+
+    // Per-column dirty row ranges since the previous update().
+    class ColumnChangeTracker
+    {
+    public:
+        struct DirtyRange
+        {
+            uint32_t storeId = 0;
+            uint32_t componentId = 0;
+            uint32_t begin = 0; // rows [begin, end)
+            uint32_t end = 0;
+        };
+
+        // Diff columns of this component from the next update() on.
+        void track(uint32_t componentId);
+
+        // Compare every tracked column with its copy from the previous update and refresh the copies.
+        // Rows whose entity changed (spawn, swap-remove, archetype move) are dirty in every tracked column.
+        // Stores and chunks not written since the previous update are skipped (advances the change clock).
+        void update(const ArchetypeStoreManager &stores);
+
+        // Ranges found by the last update(), ordered by store, component and row.
+        const std::vector<DirtyRange> &dirtyRanges() const { return m_dirty; }
+
+        // Entities that no longer occupy the row they held at the previous update (despawned or moved).
+        const std::vector<Entity> &departed() const { return m_departed; }
+
+        // Forget every copy: the next update() reports all rows dirty.
+        void reset();
+
+    private:
+        struct ColumnCopy
+        {
+            uint32_t componentId = 0;
+            std::vector<uint8_t> bytes;
+        };
+
+        struct StoreCopy
+        {
+            bool valid = false; // copied by an update() since the last reset()
+            std::vector<Entity> entities;
+            std::vector<ColumnCopy> columns;
+        };
+
+        ComponentMask m_tracked;
+        uint32_t m_seenVersion = 0; // change version of the last update()
+        std::vector<StoreCopy> m_stores; // by store id
+        std::vector<DirtyRange> m_dirty;
+        std::vector<Entity> m_departed;
+        std::vector<uint8_t> m_rowChanged; // scratch: 1 where the row's entity changed
+    };
+
+    class ReplicationServer
+    {
+    public:
+        explicit ReplicationServer(const ReplicationConfig &config = {}) : m_config(config) {}
+
+        // Resolve Position / Velocity ids; call once after the components are registered.
+        void initialize(const ComponentRegistry &registry);
+
+        uint32_t addClient();
+        void removeClient(uint32_t clientId);
+
+        // Camera on the ground plane (X/Z). Entities farther than 'interestRadius' are not sent
+        // (and removed on the client); <= 0 replicates everything.
+        void setClientView(uint32_t clientId, float x, float z, float interestRadius);
+
+        // The client applied the packet of 'tick'; later packets are encoded against it.
+        void acknowledge(uint32_t clientId, uint32_t tick);
+
+        // Advance the tick and pick up what changed in 'ecs' since the previous capture.
+        void captureTick(const ECSContext &ecs);
+
+        // Encode the current tick for one client; returns false for an unknown client.
+        bool writePacket(uint32_t clientId, std::vector<uint8_t> &out);
+
+        uint32_t tick() const { return m_tick; }
+        const ColumnChangeTracker &changes() const { return m_changes; }
+
+    private:
+        struct WorldEntry
+        {
+            NetEntityState state;
+            bool alive = false;
+        };
+
+        struct View
+        {
+            uint32_t tick = 0;
+            std::vector<NetEntityState> entities; // sorted by index
+        };
+
+        struct Client
+        {
+            bool active = false;
+            float viewX = 0.0f;
+            float viewZ = 0.0f;
+            float interestRadius = 0.0f;
+            uint32_t ackedTick = 0;
+            bool hasAck = false;
+            std::deque<View> history;   // sent views newer than (and including) the acked one
+            std::vector<uint16_t> wait; // ticks a pending update has been deferred, by entity index
+        };
+
+        struct Candidate
+        {
+            float priority = 0.0f; // lower is sent first
+            uint32_t index = 0;
+            uint8_t kind = 0;      // PacketFlag bits
+            const NetEntityState *base = nullptr;
+            uint32_t bytes = 0;    // upper bound of the encoded entry
+        };
+
+        void refreshRow(const ArchetypeStore &store, uint32_t row);
+        const View *findView(const Client &c, uint32_t tick) const;
+
+        ReplicationConfig m_config;
+        uint32_t m_positionId = ComponentRegistry::InvalidID;
+        uint32_t m_velocityId = ComponentRegistry::InvalidID;
+
+        uint32_t m_tick = 0;
+        ColumnChangeTracker m_changes;
+        std::vector<WorldEntry> m_world; // by entity index
+        std::vector<Client> m_clients;
+
+        std::vector<Candidate> m_candidates; // scratch
+    };
+
+    class ReplicationClient
+    {
+    public:
+        explicit ReplicationClient(const ReplicationConfig &config = {}) : m_config(config) {}
+
+        // Apply one server packet. Packets older than the newest applied one are ignored (true);
+        // a packet whose baseline is no longer held or malformed data returns false.
+        bool readPacket(const uint8_t *data, size_t size, std::string &outError);
+
+        // Tick to acknowledge to the server (newest applied packet).
+        uint32_t ackTick() const { return m_history.empty() ? 0 : m_history.back().tick; }
+        bool hasState() const { return !m_history.empty(); }
+
+        size_t entityCount() const { return m_history.empty() ? 0 : m_history.back().entities.size(); }
+
+        // fn(Entity, const Position &, const Velocity &) for every replicated entity, in index order.
+        template <typename Fn>
+        void forEach(Fn &&fn) const
+        {
+            if (m_history.empty())
+                return;
+            for (const NetEntityState &s : m_history.back().entities)
+            {
+                const Position p{s.position[0] * m_config.positionStep, s.position[1] * m_config.positionStep,
+                                 s.position[2] * m_config.positionStep};
+                const Velocity v{s.velocity[0] * m_config.velocityStep, s.velocity[1] * m_config.velocityStep,
+                                 s.velocity[2] * m_config.velocityStep};
+                fn(Entity{s.index, s.generation}, p, v);
+            }
+        }
+
+    private:
+        struct View
+        {
+            uint32_t tick = 0;
+            std::vector<NetEntityState> entities; // sorted by index
+        };
+
+        ReplicationConfig m_config;
+        std::deque<View> m_history; // applied views, oldest first
+    };
+}
@@ -0,0 +1,132 @@
+#pragma once
+/*
+  Selection.h
+  -----------
+  Purpose:
+    - Set of selected entities with O(1) add / remove / contains and O(selected) iteration,
+      so selecting or clearing never walks every row of every store.
+
+  Usage:
+    - selection.clear(); selection.add(e);          // from input handling (between ticks)
+    - for (Entity e : selection.entities()) ...     // resolve rows with EntitiesRecord::find
+    - selection.syncRowTags(ecs.entities, ecs.stores, selectedTagId); // once before systems run
+
+  Notes:
+    - The set is the source of truth. syncRowTags() mirrors it into a per-row tag (e.g. "Selected")
+      for systems that filter rows by mask; it only touches rows added or removed since the last sync.
+    - Destroyed entities are not removed automatically: EntitiesRecord::find returns nullptr for them,
+      and prune() drops them when a caller wants the count to be exact.
+*/
+
+#include "ECS/ArchetypeStore.h"
+#include "ECS/Entity.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine::ECS
+{
+    class SelectionSet
+    {
+    public:
+        bool contains(Entity e) const
+        {
+            return e.index < m_slot.size() && m_slot[e.index] != 0 &&
+                   m_entities[m_slot[e.index] - 1].generation == e.generation;
+        }
+
+        bool add(Entity e)
+        {
+            if (!e.valid() || contains(e))
+                return false;
+            if (e.index >= m_slot.size())
+                m_slot.resize(static_cast<size_t>(e.index) + 1, 0u);
+            else if (m_slot[e.index] != 0)
+                removeAt(m_slot[e.index] - 1); // older generation of the same index
+            m_entities.push_back(e);
+            m_slot[e.index] = static_cast<uint32_t>(m_entities.size());
+            m_added.push_back(e);
+            return true;
+        }
+
+        bool remove(Entity e)
+        {
+            if (!contains(e))
+                return false;
+            removeAt(m_slot[e.index] - 1);
+            return true;
+        }
+
+        void clear()
+        {
+            for (Entity e : m_entities)
+            {
+                m_slot[e.index] = 0;
+                m_removed.push_back(e);
+            }
+            m_entities.clear();
+        }
+
+        // Drop entities that are no longer alive.
+        void prune(const EntitiesRecord &records)
+        {
+            for (size_t i = m_entities.size(); i-- > 0;)
+            {
+                if (!records.isAlive(m_entities[i]))
+                    removeAt(static_cast<uint32_t>(i));
+            }
+        }
+
+        const std::vector<Entity> &entities() const { return m_entities; }
+        size_t size() const { return m_entities.size(); }
+        bool empty() const { return m_entities.empty(); }
+
+        // True when syncRowTags() has changes to apply.
+        bool dirty() const { return !m_added.empty() || !m_removed.empty(); }
+
+        // Mirror membership changes into 'tagId' on the entities' rows. Call outside system updates.
+        void syncRowTags(const EntitiesRecord &records, ArchetypeStoreManager &stores, uint32_t tagId)
+        {
+            // Removals first: an entity removed and re-added since the last sync ends up tagged.
+            for (Entity e : m_removed)
+            {
+                if (const EntityRecord *rec = records.find(e))
+                {
+                    if (ArchetypeStore *store = stores.get(rec->archetypeId))
+                        store->clearRowTag(rec->row, tagId);
+                }
+            }
+            for (Entity e : m_added)
+            {
+                if (!contains(e))
+                    continue;
+                if (const EntityRecord *rec = records.find(e))
+                {
+                    if (ArchetypeStore *store = stores.get(rec->archetypeId))
+                        store->setRowTag(rec->row, tagId);
+                }
+            }
+            m_added.clear();
+            m_removed.clear();
+        }
+
+    private:
+        void removeAt(uint32_t i)
+        {
+            const Entity e = m_entities[i];
+            m_slot[e.index] = 0;
+            if (i + 1 != m_entities.size())
+            {
+                m_entities[i] = m_entities.back();
+                m_slot[m_entities[i].index] = i + 1;
+            }
+            m_entities.pop_back();
+            m_removed.push_back(e);
+        }
+
+        std::vector<Entity> m_entities; // selection order until the first removal
+        std::vector<uint32_t> m_slot;   // entity index -> position in m_entities + 1 (0: not selected)
+        std::vector<Entity> m_added;    // pending row-tag changes
+        std::vector<Entity> m_removed;
+    };
+}
@@ -0,0 +1,62 @@
+#pragma once
+/*
+  Snapshot.h
+  ----------
+  Purpose:
+    - Binary save / load of a whole ECSContext world: component registry (names and layouts),
+      archetype signatures, entity handles and every store column as one raw contiguous block.
+    - Loading maps the file and restores each column with a single memcpy, so large saves come
+      back in milliseconds (save games, replays, server-restart recovery).
+
+  Usage:
+    - std::string err; Engine::ECS::saveSnapshot(ecs, "world.ecs", err);
+    - Engine::ECS::loadSnapshot(ecs, "world.ecs", err); // between ticks
+    - In memory: writeSnapshot(ecs, bytes, err); readSnapshot(ecs, bytes.data(), bytes.size(), err);
+    - Entity subsets (region migration and halo mirroring, ECS/RegionPartition.h):
+        writeSnapshotEntities(ecs, list.data(), list.size(), bytes, err);   // same format, listed entities only
+        appendSnapshotEntities(other, bytes.data(), bytes.size(), {}, &spawned, err);
+
+  Notes:
+    - Versioned (SnapshotVersion); another version, byte order or ECS mask width is rejected.
+    - Components are matched by name, so a save still loads after registration order changed;
+      a component whose size changed since the save is an error.
+    - Only trivially copyable columns are saved. Asset handles (RenderModel) are stored as-is and
+      stay valid only when the same assets were loaded in the same order.
+    - Loading replaces every entity but keeps the stores (systems' cached queries stay valid).
+      Pending commands are dropped and the selection is rebuilt from the "Selected" row tag.
+    - Prefabs and game state outside the ECS (formations, paths, navigation) are not included.
+    - A subset has no entity table: appending gives its entities fresh handles in the target world
+      (reported as saved -> created pairs) next to the existing ones; selection and commands are untouched.
+*/
+
+#include "ECS/ECSContext.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Engine::ECS
+{
+    constexpr uint32_t SnapshotVersion = 1;
+
+    bool writeSnapshot(const ECSContext &ecs, std::vector<uint8_t> &out, std::string &outError);
+    bool readSnapshot(ECSContext &ecs, const uint8_t *data, size_t size, std::string &outError);
+
+    // Handle an appended entity had in the world that wrote it, and its handle now.
+    struct SnapshotSpawn
+    {
+        Entity saved;
+        Entity created;
+    };
+
+    // Fails if one of the entities is not alive.
+    bool writeSnapshotEntities(const ECSContext &ecs, const Entity *entities, size_t count,
+                               std::vector<uint8_t> &out, std::string &outError);
+    // Add the entities of a subset to 'ecs'; 'extraTags' join every appended entity's signature.
+    bool appendSnapshotEntities(ECSContext &ecs, const uint8_t *data, size_t size, const ComponentMask &extraTags,
+                                std::vector<SnapshotSpawn> *outSpawned, std::string &outError);
+
+    bool saveSnapshot(const ECSContext &ecs, const std::string &path, std::string &outError);
+    bool loadSnapshot(ECSContext &ecs, const std::string &path, std::string &outError);
+}
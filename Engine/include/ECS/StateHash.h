@@ -0,0 +1,79 @@
+#pragma once
+/*
+  StateHash.h
+  -----------
+  Purpose:
+    - One 64-bit digest of the simulation state (alive entities with their Position and Velocity
+      bit patterns) for lockstep desync detection: peers exchange it per tick and compare.
+
+  Usage:
+    - const uint64_t h = Engine::ECS::hashSimulationState(ecs.entities, ecs.stores);
+
+  Notes:
+    - Walks entities in index order, so the digest does not depend on which store or row holds an
+      entity, only on the handles and the component values.
+    - Bit patterns are hashed as-is: any rounding difference desyncs, which is the point.
+*/
+
+#include "ECS/ArchetypeStore.h"
+#include "ECS/Components.h"
+#include "ECS/Entity.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace Engine::ECS
+{
+    namespace detail
+    {
+        // FNV-1a over 32-bit words.
+        inline void hashWord(uint64_t &h, uint32_t w)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                h ^= (w >> (8 * i)) & 0xffu;
+                h *= 1099511628211ull;
+            }
+        }
+
+        inline void hashFloat(uint64_t &h, float f)
+        {
+            uint32_t w;
+            std::memcpy(&w, &f, sizeof(w));
+            hashWord(h, w);
+        }
+    }
+
+    inline uint64_t hashSimulationState(const EntitiesRecord &records, const ArchetypeStoreManager &stores)
+    {
+        uint64_t h = 1469598103934665603ull;
+        for (uint32_t index = 0; index < records.capacity(); ++index)
+        {
+            Entity e;
+            const EntityRecord *rec = records.recordAt(index, e);
+            if (!rec)
+                continue;
+            const ArchetypeStore *store = stores.get(rec->archetypeId);
+            if (!store)
+                continue;
+
+            detail::hashWord(h, e.index);
+            detail::hashWord(h, e.generation);
+            if (store->hasPosition())
+            {
+                const Position &p = store->positions()[rec->row];
+                detail::hashFloat(h, p.x);
+                detail::hashFloat(h, p.y);
+                detail::hashFloat(h, p.z);
+            }
+            if (store->hasVelocity())
+            {
+                const Velocity &v = store->velocities()[rec->row];
+                detail::hashFloat(h, v.x);
+                detail::hashFloat(h, v.y);
+                detail::hashFloat(h, v.z);
+            }
+        }
+        return h;
+    }
+}
@@ -12,14 +12,53 @@
     - Application should expose these managers to SampleApp (e.g., via getters or an ECSContext).
     - SampleApp constructs systems that follow this format and calls update() each frame.
 
-  You can evolve this into a scheduler later.
+  Scheduling:
+    - Systems may declare which components they read and write (setReadNames/setWriteNames).
+    - SystemScheduler orders systems by registration, adds an edge whenever two systems touch
+      the same component and at least one of them writes it, and runs independent systems
+      as High priority jobs on the engine JobSystem.
+    - Access names do not have to be components: shared non-ECS state (e.g. "SpatialGrid")
+      can be declared the same way; it gets a registry ID but never appears in a signature.
+    - A system that declares nothing is treated as touching everything and runs alone.
+    - Every update() is timed as a PerfScope named IGameplaySystem::name(), nested under the
+      scope that called run() whichever thread executes it.
 */
 
 #include "ECS/Components.h"     // ComponentRegistry, ComponentMask
 #include "ECS/ArchetypeStore.h" // ArchetypeStoreManager
+#include "ECS/Query.h"          // Query<Ts...>, WorkerPool
+#include "Engine/JobSystem.h"   // JobSystem, JobCounter
+#include "Engine/Profiler.h"    // PerfScope
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace Engine::ECS
 {
+    class CommandBuffer; // ECS/CommandBuffer.h
+
+    // Declared component access of a system (used by SystemScheduler).
+    struct SystemAccess
+    {
+        ComponentMask reads;
+        ComponentMask writes;
+        bool declared = false; // false => conflicts with every other system
+
+        // True if running 'a' and 'b' concurrently could race.
+        static bool conflicts(const SystemAccess &a, const SystemAccess &b)
+        {
+            if (!a.declared || !b.declared)
+                return true;
+            if (!a.writes.containsNone(b.writes) || !a.writes.containsNone(b.reads))
+                return true;
+            return !b.writes.containsNone(a.reads);
+        }
+    };
+
     // A generic, minimal interface for gameplay systems.
     // Game programmers implement:
     //  - buildMasks(ComponentRegistry&) to set required/excluded based on component names
@@ -36,6 +75,13 @@ namespace Engine::ECS
 
         // Optional: name for logging.
         virtual const char *name() const { return "UnnamedSystem"; }
+
+        // Optional: declared read/write sets. Default is undeclared (runs exclusively).
+        virtual const SystemAccess &access() const
+        {
+            static const SystemAccess undeclared{};
+            return undeclared;
+        }
     };
 
     // A tiny helper that many systems will follow:
@@ -47,6 +93,10 @@ namespace Engine::ECS
         void setRequiredNames(const std::vector<std::string> &names) { m_requiredNames = names; }
         void setExcludedNames(const std::vector<std::string> &names) { m_excludedNames = names; }
 
+        // Components (or shared resources) this system reads / writes during update().
+        void setReadNames(const std::vector<std::string> &names) { m_readNames = names; }
+        void setWriteNames(const std::vector<std::string> &names) { m_writeNames = names; }
+
         void buildMasks(ComponentRegistry &registry) override
         {
             // Build required mask from names
@@ -63,18 +113,201 @@ namespace Engine::ECS
                 uint32_t id = registry.ensureId(n);
                 m_excluded.set(id);
             }
+            // Build access sets for the scheduler (optional)
+            m_access = SystemAccess{};
+            for (const auto &n : m_readNames)
+                m_access.reads.set(registry.ensureId(n));
+            for (const auto &n : m_writeNames)
+                m_access.writes.set(registry.ensureId(n));
+            m_access.declared = !m_readNames.empty() || !m_writeNames.empty();
+
+            // Masks changed: drop the cached store query.
+            m_queryOwner = nullptr;
         }
 
+        const SystemAccess &access() const override { return m_access; }
+
+        // Optional pool for chunked queries; null runs chunks on the calling thread.
+        void setWorkerPool(WorkerPool *pool) { m_pool = pool; }
+        WorkerPool *workerPool() const { return m_pool; }
+
+        // Optional deferred structural changes, played back by the owner after the frame's systems ran.
+        void setCommandBuffer(CommandBuffer *commands) { m_commands = commands; }
+        CommandBuffer *commandBuffer() const { return m_commands; }
+
     protected:
         // Accessors for derived systems
         const ComponentMask &required() const { return m_required; }
         const ComponentMask &excluded() const { return m_excluded; }
 
+        // IDs of stores whose signature matches required/excluded (cached by the store manager).
+        const std::vector<uint32_t> &matchingStores(ArchetypeStoreManager &stores)
+        {
+            return stores.matchingStores(cachedQueryId(stores));
+        }
+
+        // Typed query using this system's required/excluded masks.
+        template <typename... Ts>
+        Query<Ts...> query(ArchetypeStoreManager &stores)
+        {
+            return Query<Ts...>(stores, m_required, m_excluded, cachedQueryId(stores));
+        }
+
     private:
+        ArchetypeStoreManager::QueryId cachedQueryId(ArchetypeStoreManager &stores)
+        {
+            if (m_queryOwner != &stores)
+            {
+                m_queryId = stores.registerQuery(m_required, m_excluded);
+                m_queryOwner = &stores;
+            }
+            return m_queryId;
+        }
+
         std::vector<std::string> m_requiredNames;
         std::vector<std::string> m_excludedNames;
+        std::vector<std::string> m_readNames;
+        std::vector<std::string> m_writeNames;
         ComponentMask m_required;
         ComponentMask m_excluded;
+        SystemAccess m_access;
+        WorkerPool *m_pool = nullptr;        // not owned
+        CommandBuffer *m_commands = nullptr; // not owned
+
+        const ArchetypeStoreManager *m_queryOwner = nullptr;
+        ArchetypeStoreManager::QueryId m_queryId = 0;
+    };
+
+    // Runs a list of systems as a dependency graph.
+    // - Registration order is the logical order: a later system that conflicts with an earlier one
+    //   (see SystemAccess::conflicts) always runs after it.
+    // - Non-conflicting systems run concurrently on worker threads; the calling thread helps.
+    // - Call build() after all systems had buildMasks() called (access sets must be resolved).
+    class SystemScheduler
+    {
+    public:
+        explicit SystemScheduler(JobSystem &jobs = JobSystem::get()) : m_jobs(&jobs) {}
+
+        SystemScheduler(const SystemScheduler &) = delete;
+        SystemScheduler &operator=(const SystemScheduler &) = delete;
+
+        void add(IGameplaySystem *system)
+        {
+            if (!system)
+                return;
+            m_nodes.push_back(Node{system, {}, 0});
+            m_built = false;
+        }
+
+        // Build the dependency graph from the declared access sets.
+        void build()
+        {
+            for (auto &n : m_nodes)
+            {
+                n.dependents.clear();
+                n.dependencyCount = 0;
+            }
+
+            const size_t count = m_nodes.size();
+            for (size_t i = 0; i < count; ++i)
+            {
+                for (size_t j = 0; j < i; ++j)
+                {
+                    if (!SystemAccess::conflicts(m_nodes[j].system->access(), m_nodes[i].system->access()))
+                        continue;
+                    m_nodes[j].dependents.push_back(static_cast<uint32_t>(i));
+                    ++m_nodes[i].dependencyCount;
+                }
+            }
+            m_built = true;
+        }
+
+        // Execute one frame of all systems; returns after every system finished.
+        // The first exception thrown by a system is rethrown here.
+        void run(ArchetypeStoreManager &stores, float dt)
+        {
+            if (!m_built)
+                build();
+            if (m_nodes.empty())
+                return;
+
+            m_stores = &stores;
+            m_dt = dt;
+            m_scopeParent = CpuProfiler::currentScope();
+            m_error = nullptr;
+            m_pending.resize(m_nodes.size());
+            for (size_t i = 0; i < m_nodes.size(); ++i)
+                m_pending[i] = m_nodes[i].dependencyCount;
+
+            // Systems are frame-critical jobs; the calling thread runs them too while it waits.
+            JobCounter frame;
+            for (size_t i = 0; i < m_nodes.size(); ++i)
+            {
+                if (m_nodes[i].dependencyCount == 0)
+                    launch(static_cast<uint32_t>(i), frame);
+            }
+            m_jobs->wait(frame);
+            m_stores = nullptr;
+
+            if (m_error)
+                std::rethrow_exception(m_error);
+        }
+
+        size_t systemCount() const { return m_nodes.size(); }
+        size_t workerCount() const { return m_jobs->workerCount(); }
+
+    private:
+        struct Node
+        {
+            IGameplaySystem *system = nullptr;
+            std::vector<uint32_t> dependents;
+            uint32_t dependencyCount = 0;
+        };
+
+        void launch(uint32_t index, JobCounter &frame)
+        {
+            m_jobs->submit([this, index, &frame]
+                           { execute(index, frame); },
+                           JobPriority::High, &frame);
+        }
+
+        // Runs one system, then launches the dependents it was the last blocker of. They join 'frame'
+        // before this job leaves it, so the frame cannot finish early.
+        void execute(uint32_t index, JobCounter &frame)
+        {
+            std::exception_ptr error = nullptr;
+            try
+            {
+                PerfScope scope(m_nodes[index].system->name(), m_scopeParent);
+                m_nodes[index].system->update(*m_stores, m_dt);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (error && !m_error)
+                m_error = error;
+            for (uint32_t dep : m_nodes[index].dependents)
+            {
+                if (--m_pending[dep] == 0)
+                    launch(dep, frame);
+            }
+        }
+
+        std::vector<Node> m_nodes;
+        bool m_built = false;
+        JobSystem *m_jobs;
+
+        // Per-run state; set before the first job is submitted, read-only while the graph runs
+        ArchetypeStoreManager *m_stores = nullptr;
+        float m_dt = 0.0f;
+        uint32_t m_scopeParent = CpuProfiler::kRootNode; // caller's profiler scope
+
+        std::mutex m_mutex; // guards m_pending and m_error while the graph runs
+        std::vector<uint32_t> m_pending;
+        std::exception_ptr m_error = nullptr;
     };
 
 } // namespace Engine::ECS
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+/*
+  WorkerPool.h
+  ------------
+  Purpose:
+    - parallel-for front end used by ECS queries (and by asset decode / command recording) to split
+      row ranges across cores. The work runs on the engine's JobSystem as High priority jobs, so
+      these ranges, scheduled systems and background streaming share one set of threads.
+
+  Usage:
+    - WorkerPool pool;                       // JobSystem::get()
+    - pool.parallelFor(count, grain, [&](uint32_t begin, uint32_t end) { ... });
+
+  Notes:
+    - parallelFor() blocks until every range has run; the calling thread executes work too,
+      so nested parallelFor() calls (e.g. from a scheduled system) cannot deadlock.
+    - The first exception thrown by a range is rethrown on the calling thread.
+    - Every task runs inside a FrameArena::Scope of the thread that runs it.
+*/
+
+#include <cstdint>
+#include <utility>
+
+#include "Engine/JobSystem.h"
+
+namespace Engine::ECS
+{
+    class WorkerPool
+    {
+    public:
+        explicit WorkerPool(JobSystem &jobs = JobSystem::get()) : m_jobs(&jobs) {}
+
+        WorkerPool(const WorkerPool &) = delete;
+        WorkerPool &operator=(const WorkerPool &) = delete;
+
+        uint32_t threadCount() const { return m_jobs->workerCount(); }
+        JobSystem &jobs() const { return *m_jobs; }
+
+        // Run fn(begin, end) over [0, count) split into ranges of at most 'grain' items.
+        template <typename Fn>
+        void parallelFor(uint32_t count, uint32_t grain, Fn &&fn)
+        {
+            m_jobs->parallelFor(count, grain, std::forward<Fn>(fn), JobPriority::High);
+        }
+
+    private:
+        JobSystem *m_jobs;
+    };
+
+} // namespace Engine::ECS
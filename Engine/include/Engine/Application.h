@@ -1,19 +1,21 @@
 #pragma once
+#include <cstdint>
 #include <memory>
 #include <functional>
 #include <string>
 
+#include "Engine/TimeStep.h"
+
 namespace Engine
 {
     class Window;
     class VulkanContext;
     class Renderer;
     class ImGuiLayer;
-
-    struct TimeStep
-    {
-        float DeltaSeconds = 0.0f;
-    };
+    class FrameCapture;
+    class Preloader;
+    struct FramePacing;
+    struct PreloadProgress;
 
     namespace ECS
     {
@@ -24,6 +26,10 @@ namespace Engine
     {
     public:
         Application();
+
+        // Start reading the files of a preload manifest (see assets/Preloader.h) on worker threads
+        // before the window and device are created. Mount asset archives before constructing.
+        explicit Application(const std::string &preloadManifestPath);
         virtual ~Application();
 
         // Start main loop (blocks)
@@ -32,6 +38,28 @@ namespace Engine
         // Called by engine each frame; override in your Sample game class
         virtual void OnUpdate(TimeStep) {}
 
+        // Called 0..maxCatchUpSteps times per frame with a constant DeltaSeconds when fixed stepping
+        // is enabled; runs before OnUpdate. Put simulation here and interpolate with TimeStep::Alpha.
+        virtual void OnFixedUpdate(TimeStep) {}
+
+        // Called instead of OnFixedUpdate/OnUpdate while the preload manifest is loading
+        // (GetPreloader().loading()); OnRender still runs, so a loading screen can draw there.
+        virtual void OnLoading(TimeStep, const PreloadProgress &) {}
+
+        // Enable fixed-step simulation at 'hz' ticks per second (<= 0 disables it).
+        // Frames that would need more than 'maxCatchUpSteps' ticks drop the backlog instead.
+        void SetFixedTimestep(float hz, uint32_t maxCatchUpSteps = 5);
+
+        // Record and submit frame N on a render thread while the main thread runs OnFixedUpdate/OnUpdate
+        // for frame N+1. OnRender (ImGui) and Renderer::snapshotFrame() run between the two, with the
+        // render thread idle; OnUpdate must therefore not touch the graphics queue (uploads belong in
+        // OnRender). Call before Run().
+        void SetPipelinedRendering(bool enabled);
+
+        // Present mode, frames in flight, present wait and frame cap (FramePacing::lowLatency() for
+        // responsive input, FramePacing::powerSaving() for battery/thermals). Any time; takes effect next frame.
+        void SetFramePacing(const FramePacing &pacing);
+
         // Optional: called after render submission, for UI, etc.
         virtual void OnRender() {}
 
@@ -56,6 +84,13 @@ namespace Engine
         // Access to ImGuiLayer for texture registration with ImGui (optional)
         ImGuiLayer* GetImGuiLayer();
 
+        // Chrome trace capture of CPU scopes and GPU passes: F2 captures the next frames, and
+        // FrameCapture::configure() can arm a hitch trigger.
+        FrameCapture &GetFrameCapture();
+
+        // Startup preloading; attach() it to the game's AssetManager once that exists.
+        Preloader &GetPreloader();
+
     private:
         struct Impl;
         std::unique_ptr<Impl> m_Impl;
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace Engine
+{
+    // ============================================================
+    // FrameArena
+    // ============================================================
+    // Bump allocator for CPU scratch that dies within a frame (sort buffers, per-update maps,
+    // readback staging). Allocating is a pointer bump; nothing is freed individually.
+    //
+    // Every thread has its own arena (local()), so allocation takes no locks. Memory is released by
+    // the thread that owns it, in one of two ways:
+    //  - reset(): the main loop and the render thread rewind their arena at their frame boundary.
+    //  - Scope: rewinds to where it was opened. JobSystem runs every job inside one, so scratch
+    //    taken on a worker (or by a job the main thread helps with) is gone when the job returns.
+    // Code that may run on any thread should open its own Scope.
+    //
+    // Blocks are kept across frames; when a frame spilled into extra blocks, reset() merges them
+    // into one block of the combined size, so steady-state frames make no heap allocations.
+    class FrameArena
+    {
+    public:
+        static constexpr size_t kDefaultBlockSize = 256 * 1024;
+
+        explicit FrameArena(size_t blockSize = kDefaultBlockSize);
+        FrameArena(const FrameArena &) = delete;
+        FrameArena &operator=(const FrameArena &) = delete;
+
+        // This thread's arena.
+        static FrameArena &local();
+
+        // 'alignment' must be a power of two. Throws std::bad_alloc only if the heap does.
+        void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        template <typename T>
+        T *allocateArray(size_t count)
+        {
+            if (count > SIZE_MAX / sizeof(T))
+                throw std::bad_alloc();
+            return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+        }
+
+        // Owning thread only; everything allocated since the last reset becomes invalid.
+        void reset();
+
+        struct Marker
+        {
+            size_t block = 0;
+            size_t offset = 0;
+        };
+        Marker mark() const { return {m_block, m_offset}; }
+        void rewind(const Marker &m);
+
+        // Rewinds the arena to where it stood at construction.
+        class Scope
+        {
+        public:
+            explicit Scope(FrameArena &arena = FrameArena::local()) : m_arena(arena), m_marker(arena.mark()) {}
+            ~Scope() { m_arena.rewind(m_marker); }
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+            FrameArena &arena() const { return m_arena; }
+
+        private:
+            FrameArena &m_arena;
+            Marker m_marker;
+        };
+
+        // Bytes up to the current position (including skipped block tails), and reserved block bytes.
+        size_t used() const;
+        size_t capacity() const;
+
+    private:
+        struct Block
+        {
+            std::unique_ptr<uint8_t[]> data;
+            size_t size = 0;
+        };
+
+        std::vector<Block> m_blocks;
+        size_t m_block = 0;  // current block
+        size_t m_offset = 0; // into the current block
+        size_t m_blockSize = kDefaultBlockSize;
+    };
+
+    // STL allocator over a FrameArena; deallocate() is a no-op. Containers using it must be destroyed
+    // before their arena is reset or their Scope closes.
+    template <typename T>
+    class ArenaAllocator
+    {
+    public:
+        using value_type = T;
+
+        explicit ArenaAllocator(FrameArena &arena) noexcept : m_arena(&arena) {}
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U> &other) noexcept : m_arena(other.arena()) {}
+
+        T *allocate(size_t n) { return m_arena->allocateArray<T>(n); }
+        void deallocate(T *, size_t) noexcept {}
+
+        FrameArena *arena() const noexcept { return m_arena; }
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U> &other) const noexcept { return m_arena == other.arena(); }
+        template <typename U>
+        bool operator!=(const ArenaAllocator<U> &other) const noexcept { return m_arena != other.arena(); }
+
+    private:
+        FrameArena *m_arena;
+    };
+
+    template <typename T>
+    using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace Engine
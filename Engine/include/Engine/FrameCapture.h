@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Engine/Profiler.h"
+#include "Engine/GpuProfiler.h"
+
+namespace Engine
+{
+    // ============================================================
+    // FrameCapture
+    // ============================================================
+    // Records frames of CPU scope events (every thread, see CpuProfiler::setEventCapture), GPU pass
+    // timings and frame markers, and writes them as Chrome trace JSON ("traceEvents"), which
+    // chrome://tracing, ui.perfetto.dev and Tracy's import-chrome tool can open.
+    // - request(): capture the next N frames (Application binds this to F2).
+    // - Hitch trigger: with a threshold set, the last preRollFrames frames are kept in a ring;
+    //   a frame slower than the threshold dumps the ring plus postRollFrames more, so the trace
+    //   shows the frames leading up to the hitch as well as the hitch itself.
+    // GPU passes go on their own track, laid out from the frame they were resolved in (their
+    // timestamps are not calibrated against the CPU clock, and they lag by the frames in flight).
+    // Files are written on a background thread.
+    class FrameCapture
+    {
+    public:
+        struct Settings
+        {
+            std::string directory = ".";
+            uint32_t requestFrames = 120;
+            float hitchThresholdMs = 0.0f; // 0 = hitch trigger off
+            uint32_t preRollFrames = 60;
+            uint32_t postRollFrames = 30;
+            float hitchCooldownSeconds = 10.0f; // ignore hitches this long after one was captured
+            uint32_t warmupFrames = 120;        // startup frames never count as hitches
+        };
+
+        FrameCapture() = default;
+        ~FrameCapture();
+        FrameCapture(const FrameCapture &) = delete;
+        FrameCapture &operator=(const FrameCapture &) = delete;
+
+        void configure(const Settings &settings);
+        const Settings &settings() const { return m_settings; }
+
+        // Capture the next 'frames' frames (0: Settings::requestFrames). Ignored while capturing.
+        void request(uint32_t frames = 0);
+        bool capturing() const { return m_remaining > 0; }
+
+        // Frame boundary, once per frame on the main thread. 'gpu' may be null.
+        void endFrame(const GpuProfiler *gpu);
+
+        // Path of the last trace handed to the writer (empty before the first).
+        const std::string &lastTracePath() const { return m_lastPath; }
+
+    private:
+        struct FrameRecord
+        {
+            uint64_t index = 0;
+            uint64_t startNs = 0;
+            uint64_t endNs = 0;
+            bool hitch = false;
+            std::vector<CpuProfiler::ScopeEvent> cpu;
+            std::vector<GpuProfiler::TimerResult> gpu;
+        };
+
+        void updateEventCapture();
+        void finish();
+        static void writeTrace(const std::string &path, const std::string &reason, const std::vector<FrameRecord> &frames,
+                               const std::vector<std::pair<uint32_t, std::string>> &threads);
+
+        Settings m_settings;
+        uint64_t m_frameIndex = 0;
+        uint64_t m_lastFrameEndNs = 0;
+        uint64_t m_lastHitchNs = 0;
+        uint64_t m_gpuSerial = 0;
+
+        std::deque<FrameRecord> m_ring;    // pre-roll for the hitch trigger
+        std::vector<FrameRecord> m_frames; // capture in progress
+        uint32_t m_remaining = 0;
+        std::string m_reason;
+
+        std::thread m_writer;
+        std::string m_lastPath;
+    };
+
+} // namespace Engine
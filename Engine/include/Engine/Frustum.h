@@ -0,0 +1,99 @@
+#pragma once
+/*
+  Frustum.h
+  ---------
+  Purpose:
+    - Six view-frustum planes extracted from a Vulkan projection * view matrix, plus sphere / AABB tests.
+    - Shared by CPU culling (RenderSystem) and the GPU instance culler (planes are pushed as vec4s).
+
+  Usage:
+    - Frustum f = Frustum::fromViewProj(viewProj);   // a camera's is already in Camera::GetViewData().frustum
+    - if (!f.intersectsSphere(center, radius)) continue;
+
+  Notes:
+    - Planes are (n.xyz, d) with n pointing inwards, so dot(n, p) + d >= 0 means "inside".
+    - Assumes Vulkan clip space (depth 0..1); the Y flip applied to the projection does not matter.
+*/
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+namespace Engine
+{
+    struct Frustum
+    {
+        enum Plane
+        {
+            Left = 0,
+            Right,
+            Bottom,
+            Top,
+            Near,
+            Far,
+            Count
+        };
+
+        glm::vec4 planes[Count]{};
+
+        // Gribb/Hartmann extraction from the rows of the combined matrix (glm is column-major).
+        static Frustum fromViewProj(const glm::mat4 &viewProj)
+        {
+            const glm::vec4 r0(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+            const glm::vec4 r1(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+            const glm::vec4 r2(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+            const glm::vec4 r3(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+            Frustum f;
+            f.planes[Left] = r3 + r0;
+            f.planes[Right] = r3 - r0;
+            f.planes[Bottom] = r3 + r1;
+            f.planes[Top] = r3 - r1;
+            f.planes[Near] = r2; // depth range 0..1
+            f.planes[Far] = r3 - r2;
+
+            for (glm::vec4 &p : f.planes)
+            {
+                const float len = glm::length(glm::vec3(p));
+                if (len > 0.0f)
+                    p /= len;
+            }
+            return f;
+        }
+
+        bool intersectsSphere(const glm::vec3 &center, float radius) const
+        {
+            for (const glm::vec4 &p : planes)
+            {
+                if (glm::dot(glm::vec3(p), center) + p.w < -radius)
+                    return false;
+            }
+            return true;
+        }
+
+        // Conservative: may accept boxes that are just outside a frustum corner.
+        bool intersectsAabb(const glm::vec3 &mn, const glm::vec3 &mx) const
+        {
+            for (const glm::vec4 &p : planes)
+            {
+                // Corner furthest along the plane normal.
+                const glm::vec3 v(p.x >= 0.0f ? mx.x : mn.x,
+                                  p.y >= 0.0f ? mx.y : mn.y,
+                                  p.z >= 0.0f ? mx.z : mn.z);
+                if (glm::dot(glm::vec3(p), v) + p.w < 0.0f)
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    // Largest axis scale of an affine transform (for transforming bounding-sphere radii).
+    inline float maxAxisScale(const glm::mat4 &m)
+    {
+        const float sx = glm::length(glm::vec3(m[0]));
+        const float sy = glm::length(glm::vec3(m[1]));
+        const float sz = glm::length(glm::vec3(m[2]));
+        return std::fmax(sx, std::fmax(sy, sz));
+    }
+
+} // namespace Engine
@@ -0,0 +1,154 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Engine
+{
+    // What an allocation is used for; only affects the per-category usage report.
+    enum class GpuMemoryCategory : uint32_t
+    {
+        Geometry,     // vertex / index buffers
+        Texture,      // sampled images
+        RenderTarget, // depth / color attachments
+        Dynamic,      // per-frame instance, palette and uniform data
+        Staging,      // upload sources
+        Compute,      // compute pre-pass buffers
+        Other,
+        Count
+    };
+
+    const char *gpuMemoryCategoryName(GpuMemoryCategory category);
+
+    // A sub-range of a VkDeviceMemory block (or a dedicated allocation). Bind with
+    // vkBind*Memory(device, x, allocation.memory, allocation.offset); never vkFreeMemory() it.
+    struct GpuAllocation
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void *mapped = nullptr; // host-visible memory only: persistently mapped, already offset
+        uint32_t memoryType = 0;
+        uint32_t block = 0; // index into the allocator's blocks, or kDedicated
+        GpuMemoryCategory category = GpuMemoryCategory::Other;
+
+        static constexpr uint32_t kDedicated = 0xFFFFFFFFu;
+        bool valid() const { return memory != VK_NULL_HANDLE; }
+    };
+
+    // Engine-wide device memory sub-allocator: one per VkDevice, shared by every module.
+    // Requests are packed first-fit into large per-memory-type blocks, so a map with thousands
+    // of buffers and images needs only a few dozen vkAllocateMemory calls (well under
+    // maxMemoryAllocationCount). Host-visible blocks are mapped once for their lifetime.
+    // Requests larger than half a block get a dedicated allocation. Thread-safe.
+    class GpuAllocator
+    {
+    public:
+        struct Stats
+        {
+            VkDeviceSize usedBytes[static_cast<size_t>(GpuMemoryCategory::Count)] = {};
+            VkDeviceSize usedDeviceLocalBytes = 0;
+            VkDeviceSize reservedBytes = 0;   // sum of all VkDeviceMemory objects
+            VkDeviceSize reservedHeapBytes[VK_MAX_MEMORY_HEAPS] = {}; // reservedBytes per memory heap
+            uint32_t deviceMemoryCount = 0;   // live vkAllocateMemory objects
+            uint32_t allocationCount = 0;     // live GpuAllocations
+        };
+
+        // One memory heap. With VK_EXT_memory_budget 'budget' and 'usage' come from the driver and
+        // include other processes and driver allocations; otherwise budget is the heap size and
+        // usage this allocator's reservation.
+        struct HeapBudget
+        {
+            VkDeviceSize size = 0;
+            VkDeviceSize budget = 0;
+            VkDeviceSize usage = 0;
+            VkDeviceSize allocatorBytes = 0; // reserved by this allocator
+            bool deviceLocal = false;
+            bool fromDriver = false;
+        };
+
+        // The allocator for 'device', created on first use. VulkanContext releases it before
+        // destroying the device; every allocation must have been freed by then.
+        static GpuAllocator &forDevice(VkDevice device, VkPhysicalDevice physicalDevice);
+        // The existing allocator for 'device', or nullptr (for release paths without a physical device).
+        static GpuAllocator *find(VkDevice device);
+        static void releaseDevice(VkDevice device);
+
+        GpuAllocator(VkDevice device, VkPhysicalDevice physicalDevice);
+        ~GpuAllocator();
+        GpuAllocator(const GpuAllocator &) = delete;
+        GpuAllocator &operator=(const GpuAllocator &) = delete;
+
+        // 'required' must be satisfied; 'preferred' is tried first (e.g. DEVICE_LOCAL for ReBAR).
+        VkResult allocate(const VkMemoryRequirements &req, VkMemoryPropertyFlags required,
+                          GpuMemoryCategory category, GpuAllocation &out,
+                          VkMemoryPropertyFlags preferred = 0);
+        void free(GpuAllocation &allocation);
+
+        // Create + allocate + bind. On failure nothing is left behind.
+        VkResult createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags required,
+                              GpuMemoryCategory category, VkBuffer &outBuffer, GpuAllocation &outAllocation,
+                              VkMemoryPropertyFlags preferred = 0);
+        // Buffers from the overload above are shared CONCURRENT across these families when there are
+        // two or more (graphics + async compute), so either queue may use them without ownership
+        // transfers. Set once by VulkanContext before any buffer is created.
+        void setBufferQueueFamilies(std::vector<uint32_t> families) { m_bufferQueueFamilies = std::move(families); }
+
+        // Same, for callers that need a non-default sharing mode or create flags.
+        VkResult createBuffer(const VkBufferCreateInfo &info, VkMemoryPropertyFlags required,
+                              GpuMemoryCategory category, VkBuffer &outBuffer, GpuAllocation &outAllocation,
+                              VkMemoryPropertyFlags preferred = 0);
+        void destroyBuffer(VkBuffer &buffer, GpuAllocation &allocation);
+
+        VkResult createImage(const VkImageCreateInfo &info, VkMemoryPropertyFlags required,
+                             GpuMemoryCategory category, VkImage &outImage, GpuAllocation &outAllocation);
+        void destroyImage(VkImage &image, GpuAllocation &allocation);
+
+        bool findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties, uint32_t &outType) const;
+        Stats stats() const;
+
+        // Per-heap budgets. Pass vkGetPhysicalDeviceMemoryProperties2(KHR) once VK_EXT_memory_budget
+        // is enabled on the device; without it heapBudgets() reports heap sizes only.
+        void setMemoryBudgetQuery(PFN_vkGetPhysicalDeviceMemoryProperties2KHR query) { m_budgetQuery = query; }
+        std::vector<HeapBudget> heapBudgets() const;
+
+        VkDevice device() const { return m_device; }
+
+    private:
+        struct Range
+        {
+            VkDeviceSize offset = 0;
+            VkDeviceSize size = 0;
+        };
+
+        struct Block
+        {
+            VkDeviceMemory memory = VK_NULL_HANDLE; // VK_NULL_HANDLE: slot free for reuse
+            VkDeviceSize size = 0;
+            void *mapped = nullptr;
+            uint32_t memoryType = 0;
+            uint32_t liveCount = 0;
+            std::vector<Range> freeRanges; // sorted by offset, coalesced
+        };
+
+        VkResult allocateOfType(uint32_t memoryType, const VkMemoryRequirements &req, GpuAllocation &out);
+        bool allocateFromBlock(uint32_t blockIndex, VkDeviceSize size, VkDeviceSize alignment, GpuAllocation &out);
+        VkResult allocateMemory(uint32_t memoryType, VkDeviceSize size, VkDeviceMemory &outMemory, void *&outMapped);
+        VkDeviceSize blockSizeFor(uint32_t memoryType) const;
+        bool isHostVisible(uint32_t memoryType) const;
+        bool isDeviceLocal(uint32_t memoryType) const;
+
+        VkDevice m_device = VK_NULL_HANDLE;
+        VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+        VkPhysicalDeviceMemoryProperties m_memProps{};
+        std::vector<uint32_t> m_bufferQueueFamilies; // see setBufferQueueFamilies
+        VkDeviceSize m_granularity = 1; // bufferImageGranularity: linear and optimal resources share blocks
+        PFN_vkGetPhysicalDeviceMemoryProperties2KHR m_budgetQuery = nullptr;
+
+        mutable std::mutex m_mutex;
+        std::vector<Block> m_blocks;
+        Stats m_stats;
+    };
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include "Engine/Frustum.h"
+#include <vulkan/vulkan.h>
+#include "Engine/GpuAllocator.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+    class VulkanContext;
+
+    // Compute pre-pass for instanced SModel draws: frustum-culls instances on the GPU, compacts the
+    // visible instance records and writes the visible count into indirect draw commands, so record()
+    // can use vkCmdDrawIndexedIndirect with the unchanged vertex shaders. Palettes are not moved: each
+    // instance record carries its palette slot.
+    //
+    // Needs shaders/smodel_cull.comp.spv and shaders/smodel_cull_args.comp.spv; without them
+    // create() returns false and callers keep drawing every instance. Occlusion culling against a
+    // HiZPyramid additionally needs shaders/smodel_cull_occlusion.comp.spv (see occlusionReady()).
+    class GpuInstanceCuller
+    {
+    public:
+        struct Inputs
+        {
+            VkBuffer worlds = VK_NULL_HANDLE;    // instance records (needs STORAGE usage)
+            VkBuffer nodes = VK_NULL_HANDLE;     // node palette, bound unchanged into drawSet binding 1
+            VkBuffer joints = VK_NULL_HANDLE;    // joint palette, bound unchanged into drawSet binding 2
+            VkBuffer cameraUbo = VK_NULL_HANDLE; // bound unchanged into drawSet binding 0
+            VkDeviceSize cameraUboSize = 0;
+            uint32_t instanceCount = 0;
+            uint32_t instanceStride = sizeof(glm::mat4); // bytes per record: 64 (mat4) or 32 (compact)
+            bool compactInstances = false;               // records are SModelRenderPassModule::CompactInstance
+        };
+
+        // Hi-Z pyramid of this frame's depth pre-pass (HiZPyramid::view()/sampler()), drawn with the
+        // camera in Inputs::cameraUbo.
+        struct Occlusion
+        {
+            VkImageView hiZ = VK_NULL_HANDLE;
+            VkSampler sampler = VK_NULL_HANDLE;
+        };
+
+        GpuInstanceCuller() = default;
+        ~GpuInstanceCuller() = default;
+        GpuInstanceCuller(const GpuInstanceCuller &) = delete;
+        GpuInstanceCuller &operator=(const GpuInstanceCuller &) = delete;
+
+        // drawSetLayout: layout of the draw pipeline's set 0 (camera UBO, node palette, joint palette).
+        bool create(VulkanContext &ctx, size_t frameCount, VkDescriptorSetLayout drawSetLayout);
+        void destroy();
+        bool ready() const { return m_cullPipeline != VK_NULL_HANDLE; }
+        bool occlusionReady() const { return m_occlusionPipeline != VK_NULL_HANDLE; }
+
+        // Record the culling dispatches into 'cmd' (outside any render pass). 'commands' are the
+        // indirect draws in draw order; their instanceCount is overwritten on the GPU.
+        // 'sphere' is the model-space bounding sphere (xyz center, w radius) including any base model matrix.
+        // Returns false if nothing was recorded; the caller should then draw unculled.
+        // 'asyncQueue': 'cmd' goes to the async compute queue, whose semaphore the graphics submission
+        // waits on; the closing barrier towards indirect/vertex stages (not valid there) is left out.
+        bool record(VkCommandBuffer cmd, uint32_t frameIndex, const Inputs &in,
+                    const Frustum &frustum, const glm::vec4 &sphere,
+                    const std::vector<VkDrawIndexedIndirectCommand> &commands, bool asyncQueue = false);
+
+        // record() in two steps, for dispatches that must wait for later commands (the Hi-Z pyramid)
+        // while draws referencing the outputs are queued now. prepare() grows the frame's buffers,
+        // writes 'commands' and the descriptor sets; once it returned true the outputs below are
+        // valid and recordDispatch() must be called for the frame before they are drawn.
+        bool prepare(uint32_t frameIndex, const Inputs &in, const std::vector<VkDrawIndexedIndirectCommand> &commands);
+        // 'occlusion' (needs occlusionReady()) also drops instances hidden behind the depth pre-pass.
+        void recordDispatch(VkCommandBuffer cmd, uint32_t frameIndex, const Frustum &frustum, const glm::vec4 &sphere,
+                            const Occlusion *occlusion = nullptr, bool asyncQueue = false);
+
+        // Valid for a frame after record() returned true for it.
+        VkBuffer visibleWorlds(uint32_t frameIndex) const { return m_frames[frameIndex % m_frames.size()].worlds.buffer; }
+        VkBuffer drawCommands(uint32_t frameIndex) const { return m_frames[frameIndex % m_frames.size()].commands.buffer; }
+        VkDescriptorSet drawSet(uint32_t frameIndex) const { return m_frames[frameIndex % m_frames.size()].drawSet; }
+
+    private:
+        struct Buffer
+        {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            GpuAllocation allocation;
+            VkDeviceSize size = 0;
+            void *mapped = nullptr; // host-visible buffers only
+        };
+
+        struct Frame
+        {
+            Buffer worlds;   // compacted instance records (vertex binding 1)
+            Buffer visible;  // uint visible count
+            Buffer commands; // VkDrawIndexedIndirectCommand[] (host-written, instanceCount from GPU)
+            VkDescriptorSet computeSet = VK_NULL_HANDLE;
+            VkDescriptorSet drawSet = VK_NULL_HANDLE;
+            VkDescriptorSet occlusionSet = VK_NULL_HANDLE; // set 1: camera UBO, Hi-Z (occlusionReady() only)
+
+            // What prepare() set up for recordDispatch().
+            VkBuffer cameraUbo = VK_NULL_HANDLE;
+            VkDeviceSize cameraUboSize = 0;
+            glm::uvec4 counts{0u};
+        };
+
+        struct PushConstants
+        {
+            glm::vec4 planes[6];
+            glm::vec4 sphere;
+            glm::uvec4 counts; // x=instanceCount, y=vec4s per instance, z=compact, w=drawCount
+        };
+        static_assert(sizeof(PushConstants) == 128, "GpuInstanceCuller::PushConstants must match smodel_cull.comp");
+
+        // Optional: without the shader (or on failure) occlusionReady() stays false.
+        void createOcclusionPipeline(VkPushConstantRange pcRange);
+        bool ensureBuffer(Buffer &b, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible);
+        void destroyBuffer(Buffer &b);
+
+        VkDevice m_device = VK_NULL_HANDLE;
+        VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_pool = VK_NULL_HANDLE;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        VkPipeline m_cullPipeline = VK_NULL_HANDLE;
+        VkPipeline m_argsPipeline = VK_NULL_HANDLE;
+
+        // smodel_cull_occlusion.comp: set 0 as above plus set 1 (m_occlusionSetLayout)
+        VkDescriptorSetLayout m_occlusionSetLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_occlusionPipelineLayout = VK_NULL_HANDLE;
+        VkPipeline m_occlusionPipeline = VK_NULL_HANDLE;
+
+        std::vector<Frame> m_frames;
+    };
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "Engine/GpuAllocator.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+    class VulkanContext;
+    struct ModelAsset;
+
+    // Per-instance animation state uploaded for GPU pose evaluation (16 bytes, matches smodel_pose.comp).
+    struct GpuInstanceAnimation
+    {
+        uint32_t clip = 0;
+        float timeSec = 0.0f;
+        uint32_t _pad0 = 0;
+        uint32_t _pad1 = 0;
+    };
+    static_assert(sizeof(GpuInstanceAnimation) == 16, "GpuInstanceAnimation must match smodel_pose.comp");
+
+    // Compute pre-pass that builds SModel node and joint palettes on the GPU from a model's baked clips
+    // (ModelAsset::bakeClips): the baked frames, clip table and inverse binds are uploaded once per
+    // model, then each frame only GpuInstanceAnimation records are written.
+    //
+    // Palettes are laid out like the CPU path with one slot per instance: nodes [instance][node],
+    // joints [instance][totalJointCount]. Needs shaders/smodel_pose.comp.spv; without it create()
+    // returns false and callers keep building palettes on the CPU.
+    class GpuPoseEvaluator
+    {
+    public:
+        GpuPoseEvaluator() = default;
+        ~GpuPoseEvaluator() = default;
+        GpuPoseEvaluator(const GpuPoseEvaluator &) = delete;
+        GpuPoseEvaluator &operator=(const GpuPoseEvaluator &) = delete;
+
+        // drawSetLayout: layout of the draw pipeline's set 0 (camera UBO, node palette, joint palette).
+        bool create(VulkanContext &ctx, size_t frameCount, VkDescriptorSetLayout drawSetLayout);
+        void destroy();
+        bool ready() const { return m_pipeline != VK_NULL_HANDLE; }
+
+        // True if 'model' has baked clips covering every clip.
+        static bool supports(const ModelAsset &model);
+
+        // Record palette generation into 'cmd' (outside any render pass). Returns false if nothing was
+        // recorded; the caller should then upload CPU palettes. 'asyncQueue': 'cmd' goes to the async
+        // compute queue; the closing barrier then only covers later compute work (see GpuInstanceCuller).
+        bool record(VkCommandBuffer cmd, uint32_t frameIndex, const ModelAsset &model,
+                    const GpuInstanceAnimation *states, uint32_t instanceCount,
+                    VkBuffer cameraUbo, VkDeviceSize cameraUboSize, bool asyncQueue = false);
+
+        // Valid for a frame after record() returned true for it.
+        VkBuffer nodePalette(uint32_t frameIndex) const { return m_frames[frameIndex % m_frames.size()].nodes.buffer; }
+        VkBuffer jointPalette(uint32_t frameIndex) const { return m_frames[frameIndex % m_frames.size()].joints.buffer; }
+        VkDescriptorSet drawSet(uint32_t frameIndex) const { return m_frames[frameIndex % m_frames.size()].drawSet; }
+
+    private:
+        struct Buffer
+        {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            GpuAllocation allocation;
+            VkDeviceSize size = 0;
+            void *mapped = nullptr; // host-visible buffers only
+        };
+
+        struct Frame
+        {
+            Buffer states; // GpuInstanceAnimation[] (host-written)
+            Buffer nodes;  // node palette (device-local)
+            Buffer joints; // joint palette (device-local)
+            VkDescriptorSet computeSet = VK_NULL_HANDLE;
+            VkDescriptorSet drawSet = VK_NULL_HANDLE;
+        };
+
+        // Per-model constant data, uploaded once through a staging copy.
+        struct StaticData
+        {
+            const ModelAsset *model = nullptr;
+            Buffer baked;  // mat4 [clip frames][node]
+            Buffer clips;  // ClipInfo per clip
+            Buffer joints; // JointInfo per joint slot
+            uint32_t nodeCount = 0;
+            uint32_t jointCount = 0;
+            uint32_t clipCount = 0;
+        };
+
+        struct ClipInfo
+        {
+            uint32_t firstMatrix;
+            uint32_t frameCount;
+            float sampleRate;
+            uint32_t _pad;
+        };
+
+        struct JointInfo
+        {
+            glm::mat4 inverseBind;
+            uint32_t node;
+            uint32_t _pad[3];
+        };
+        static_assert(sizeof(JointInfo) == 80, "JointInfo must match smodel_pose.comp (std430)");
+
+        struct PushConstants
+        {
+            glm::uvec4 counts; // x=instanceCount, y=nodeCount, z=jointCount, w=clipCount
+            glm::uvec4 base;   // x=first item of the dispatch
+        };
+
+        // Buffers still referenced by frames in flight; destroyed once framesLeft reaches 0.
+        struct Retired
+        {
+            Buffer buffer;
+            uint32_t framesLeft = 0;
+        };
+
+        bool uploadStatic(VkCommandBuffer cmd, const ModelAsset &model);
+        void retire(Buffer &b);
+        void tickRetired();
+
+        bool ensureBuffer(Buffer &b, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible);
+        bool createBuffer(Buffer &b, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible);
+        void destroyBuffer(Buffer &b);
+
+        VkDevice m_device = VK_NULL_HANDLE;
+        VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+        uint32_t m_maxGroupsX = 65535;
+
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_pool = VK_NULL_HANDLE;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        VkPipeline m_pipeline = VK_NULL_HANDLE;
+
+        std::vector<Frame> m_frames;
+        StaticData m_static;
+        std::vector<Retired> m_retired;
+    };
+}
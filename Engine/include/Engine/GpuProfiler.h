@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Engine
+{
+    // ============================================================
+    // GpuProfiler
+    // ============================================================
+    // Named GPU timers backed by one timestamp query pool (two queries per timer) and, where the
+    // device has pipelineStatisticsQuery, one pipeline statistics pool (one query per timer).
+    // - Every frame-in-flight slot owns kMaxTimers timers. beginFrame() resolves the slot's
+    //   previous results (its fence has been waited on, so nothing stalls) and resets its queries.
+    // - beginTimer()/endTimer() may be called from several recording threads at once, into
+    //   primary or secondary command buffers; indices come from an atomic counter per slot.
+    // - Timers with the same name are summed, so timers may nest (a child's time is included in
+    //   its parent's) but statistics queries may not: only outermost timers should ask for stats.
+    // Results lag rendering by framesInFlight frames.
+    class GpuProfiler
+    {
+    public:
+        static constexpr uint32_t kMaxTimers = 64; // per frame; further timers are dropped
+        static constexpr uint32_t kInvalidTimer = ~0u;
+
+        // VK_QUERY_TYPE_PIPELINE_STATISTICS counters, in the order the pool returns them.
+        struct PipelineStats
+        {
+            uint64_t inputAssemblyPrimitives = 0;
+            uint64_t vertexShaderInvocations = 0;
+            uint64_t clippingPrimitives = 0;
+            uint64_t fragmentShaderInvocations = 0;
+            uint64_t computeShaderInvocations = 0;
+        };
+
+        struct TimerResult
+        {
+            std::string name;
+            uint32_t count = 0; // timers merged into this entry
+            float ms = 0.0f;    // last resolved frame
+            float startMs = 0.0f; // start of the first merged timer, relative to the frame's first timer
+            float avgMs = 0.0f; // exponential moving average
+            bool hasStats = false;
+            PipelineStats stats;
+        };
+
+        GpuProfiler() = default;
+        ~GpuProfiler() = default;
+        GpuProfiler(const GpuProfiler &) = delete;
+        GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+        // Returns false (and stays disabled) when the device has no graphics/compute timestamps.
+        bool init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t framesInFlight, bool pipelineStatistics);
+        void destroy();
+
+        bool enabled() const { return m_timestampPool != VK_NULL_HANDLE; }
+        bool pipelineStatisticsEnabled() const { return m_statsPool != VK_NULL_HANDLE; }
+
+        // Start of a frame slot's command buffer, outside any render pass, after the slot's fence wait.
+        void beginFrame(VkCommandBuffer cmd, uint32_t slot);
+
+        // Bracket GPU work. 'name' is copied on resolve. withStats is ignored without the feature.
+        // beginTimer() returns kInvalidTimer when disabled or out of timers; endTimer() accepts it.
+        uint32_t beginTimer(VkCommandBuffer cmd, const char *name, bool withStats = false);
+        void endTimer(VkCommandBuffer cmd, uint32_t timer);
+
+        // Results of the latest resolved frame in GPU execution order (by start time). Thread-safe.
+        std::vector<TimerResult> results() const;
+
+        // Last resolved time of the timer named 'name' (0 if absent).
+        float lastMs(const char *name) const;
+
+        // Number of frames resolved so far; results() changes when this does.
+        uint64_t resolvedFrames() const { return m_resolvedFrames.load(std::memory_order_relaxed); }
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint32_t> used{0}; // timers begun since the slot's last beginFrame()
+            const char *names[kMaxTimers]{};
+            bool withStats[kMaxTimers]{};
+        };
+
+        void resolve(uint32_t slot);
+
+        VkDevice m_device = VK_NULL_HANDLE;
+        VkQueryPool m_timestampPool = VK_NULL_HANDLE;
+        VkQueryPool m_statsPool = VK_NULL_HANDLE;
+        float m_timestampPeriod = 1.0f; // nanoseconds per tick
+        uint32_t m_currentSlot = 0;
+        uint32_t m_slotCount = 0;
+        std::unique_ptr<Slot[]> m_slots;
+
+        std::vector<uint64_t> m_scratch; // resolve() readback
+        mutable std::mutex m_resultsMutex;
+        std::vector<TimerResult> m_results;
+        std::atomic<uint64_t> m_resolvedFrames{0};
+    };
+
+    // RAII GPU timer. A null profiler makes it a no-op.
+    class GpuScope
+    {
+    public:
+        GpuScope(GpuProfiler *profiler, VkCommandBuffer cmd, const char *name, bool withStats = false)
+            : m_profiler(profiler), m_cmd(cmd)
+        {
+            if (m_profiler)
+                m_timer = m_profiler->beginTimer(cmd, name, withStats);
+        }
+
+        ~GpuScope()
+        {
+            if (m_profiler)
+                m_profiler->endTimer(m_cmd, m_timer);
+        }
+
+        GpuScope(const GpuScope &) = delete;
+        GpuScope &operator=(const GpuScope &) = delete;
+
+    private:
+        GpuProfiler *m_profiler = nullptr;
+        VkCommandBuffer m_cmd = VK_NULL_HANDLE;
+        uint32_t m_timer = GpuProfiler::kInvalidTimer;
+    };
+
+} // namespace Engine
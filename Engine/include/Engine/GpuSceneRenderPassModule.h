@@ -0,0 +1,270 @@
+#pragma once
+#include "Engine/Renderer.h"
+#include "Engine/GpuAllocator.h"
+#include "Engine/Pipeline.h"
+#include "Engine/SModelRenderer.h"
+#include "assets/AssetManager.h"
+#include "assets/Handles.h"
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Engine
+{
+    struct ModelAsset;
+    struct ViewData;
+
+    // GPU-driven path for many instances of SModel models: instead of one SModelRenderPassModule per
+    // model, the game keeps one persistent record per instance (model, transform, clip, time) in a
+    // device-local scene buffer and the GPU does the rest each frame:
+    //  1. gpu_scene_cull(_occlusion).comp: frustum (and Hi-Z) culling, LOD level, baked animation frames
+    //  2. gpu_scene_args.comp: one VkDrawIndexedIndirectCommand per (model, node primitive, LOD level)
+    //  3. gpu_scene_scatter.comp: the visible instances of every draw
+    // record() then issues one indirect call per pipeline/material group (vkCmdDrawIndexedIndirectCount
+    // with VK_KHR_draw_indirect_count, otherwise multi-draw indirect or one indirect draw per command).
+    // CPU cost per frame is the changed instance records plus O(groups), independent of instance count.
+    //
+    // Animation is sampled in gpu_scene.vert from each model's baked clips (ModelAsset::bakeClips;
+    // models without them use their rest pose), with joints pre-multiplied by their inverse bind, so
+    // there are no per-frame palettes. BLEND primitives are not sorted back to front, and scene
+    // instances are not drawn into the depth pre-pass (they are only occlusion-tested against it).
+    //
+    // Needs drawIndirectFirstInstance and the gpu_scene shaders; otherwise ready() stays false after
+    // onCreate() and callers keep their per-model modules. The camera is the Renderer's (setCamera).
+    class GpuSceneRenderPassModule final : public RenderPassModule
+    {
+    public:
+        static constexpr uint32_t kInvalidId = ~0u;
+
+        // One instance as the game describes it; converted to the 32-byte GPU record.
+        struct Instance
+        {
+            glm::vec3 position{0.0f};
+            float scale = 1.0f;
+            float yaw = 0.0f;        // radians about +Y
+            uint32_t model = 0;      // addModel() index
+            uint32_t clip = 0;       // clamped to the model's clips
+            float timeSec = 0.0f;
+        };
+
+        GpuSceneRenderPassModule() = default;
+        ~GpuSceneRenderPassModule() override = default;
+
+        void setEnabled(bool en) { m_enabled = en; }
+        void setAssets(AssetManager *assets) { m_assets = assets; }
+
+        // Label of this pass in the GPU profiler (default "GpuScene").
+        void setDebugName(std::string name) { m_debugName = std::move(name); }
+        const char *debugName() const override { return m_debugName.c_str(); }
+
+        // Same meaning as SModelRenderPassModule::setLodPixelError (0 always draws LOD 0).
+        void setLodPixelError(float pixels) { m_lodPixelError = pixels; }
+        // Test against the depth pre-pass's Hi-Z pyramid when the renderer builds one (default on).
+        void setOcclusionCulling(bool enabled) { m_occlusionCulling = enabled; }
+
+        // After onCreate(): the GPU path can draw on this device.
+        bool ready() const { return m_ready; }
+
+        // Main thread. Scene index of 'model' (the same handle always gets the same index). The model's
+        // tables are built on the render thread once it and its meshes are resident; until then its
+        // instances are not drawn.
+        uint32_t addModel(ModelHandle model);
+
+        // Main thread. Instance ids are stable until removeInstance(); freed ids are reused.
+        // updateInstance() only uploads records that changed.
+        uint32_t addInstance(const Instance &instance);
+        void updateInstance(uint32_t id, const Instance &instance);
+        void removeInstance(uint32_t id);
+        uint32_t instanceCount() const { return m_liveCount; }
+
+        void onCreate(VulkanContext &ctx, VkRenderPass pass, const std::vector<VkFramebuffer> &fbs) override;
+        void record(FrameContext &frameCtx, VkCommandBuffer cmd) override;
+        void onResize(VulkanContext &ctx, VkExtent2D newExtent) override;
+        void onDestroy(VulkanContext &ctx) override;
+        void onFrameSnapshot() override;
+        void recordPrePass(FrameContext &frameCtx, VkCommandBuffer cmd) override;
+        void recordOcclusionCull(FrameContext &frameCtx, VkCommandBuffer cmd) override;
+
+    private:
+        static constexpr uint32_t kFreeModel = 0xFFFFu; // model field of a free slot
+
+        // GPU instance record (gpu_scene_cull.comp SceneInstance).
+        struct GpuInstance
+        {
+            glm::vec4 posScale{0.0f};
+            uint32_t yawSin = 0;  // float bits
+            uint32_t yawCos = 0;  // float bits
+            uint32_t modelClip = kFreeModel; // model | clip << 16
+            uint32_t timeSec = 0; // float bits
+        };
+        static_assert(sizeof(GpuInstance) == 32, "GpuInstance must match gpu_scene_cull.comp");
+
+        struct GpuModel
+        {
+            glm::mat4 base{1.0f};
+            glm::vec4 sphere{0.0f};
+            glm::uvec4 draws{0u}; // x=first draw, y=draws per level, z=levels, w=node count
+            glm::uvec4 anim{0u};  // x=first clip, y=clip count, z=joint count
+            glm::vec4 lodError{0.0f};
+        };
+        static_assert(sizeof(GpuModel) == 128, "GpuModel must match gpu_scene_cull.comp ModelInfo");
+
+        struct GpuDraw
+        {
+            glm::uvec4 geom{0u};  // x=indexCount, y=firstIndex, z=vertexOffset bits, w=node
+            glm::uvec4 skin{0u};  // x=skin base joint, y=skin joint count
+            glm::uvec4 quant{0u}; // mesh box halves
+            glm::uvec4 slot{0u};  // x=command slot, y=group, z=group's first command slot
+        };
+        static_assert(sizeof(GpuDraw) == 64, "GpuDraw must match gpu_scene_args.comp DrawInfo");
+
+        struct GpuClip
+        {
+            uint32_t firstNode;
+            uint32_t firstJoint;
+            uint32_t frameCount;
+            float sampleRate;
+        };
+
+        struct CullPushConstants
+        {
+            glm::uvec4 counts; // x=instance slots, y=model count, z=draw count
+            glm::vec4 lod;     // x=pixels per unit at distance 1, y=max error in pixels
+        };
+
+        // Draws sharing pipeline, buffers and material: one indirect call.
+        struct Group
+        {
+            uint32_t alphaMode = 0;
+            bool quantized = false;
+            VkBuffer vertexBuffer = VK_NULL_HANDLE;
+            VkBuffer indexBuffer = VK_NULL_HANDLE;
+            VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+            MaterialHandle material{};
+            uint32_t firstCommand = 0;
+            uint32_t commandCount = 0;
+        };
+
+        struct Buffer
+        {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            GpuAllocation allocation;
+            VkDeviceSize size = 0;
+            void *mapped = nullptr; // host-visible buffers only
+        };
+
+        struct Frame
+        {
+            Buffer staging;       // changed instance records (host-written)
+            Buffer visible;       // VisibleRecord per visible instance
+            Buffer drawState;     // uvec4 per draw: count, base, cursor
+            Buffer drawInstances; // uvec2 (visible record, draw) per drawn instance
+            Buffer counters;      // visible count, scatter dispatch, per-group draw counts
+            Buffer commands;      // VkDrawIndexedIndirectCommand per draw
+            VkDescriptorSet set = VK_NULL_HANDLE;
+            VkDescriptorSet hiZSet = VK_NULL_HANDLE;
+            bool prepared = false; // buffers and set are ready for recordCull() this frame
+            bool culled = false;   // the compute passes were recorded for this frame
+        };
+
+        // Buffers still referenced by frames in flight; destroyed once framesLeft reaches 0.
+        struct Retired
+        {
+            Buffer buffer;
+            uint32_t framesLeft = 0;
+        };
+
+        // What the render thread works from; written in onFrameSnapshot().
+        struct RecordState
+        {
+            std::vector<ModelHandle> models;
+            std::vector<uint32_t> modelInstances; // live instances per model (capacity bound)
+            std::vector<GpuInstance> instances;   // mirror of the scene buffer
+            std::vector<uint32_t> dirty;          // slots to upload
+            std::vector<uint8_t> dirtyFlag;
+            float lodPixelError = 1.0f;
+            bool occlusionCulling = true;
+        };
+
+        static GpuInstance pack(const Instance &instance);
+        bool createPipelines(VulkanContext &ctx, VkRenderPass pass);
+        bool createDescriptors(size_t frameCount);
+        void destroyPipelines();
+
+        // Render thread: model tables when a model became resident; false while nothing can draw.
+        bool refreshStatic(VkCommandBuffer cmd);
+        bool buildStatic(VkCommandBuffer cmd);
+        bool uploadInstances(VkCommandBuffer cmd, Frame &f);
+        void recordCull(FrameContext &frameCtx, VkCommandBuffer cmd, bool occlusion);
+        // Mip streaming feedback (AssetManager::reportMaterialScreenSize) from the instance mirror.
+        void reportScreenSizes(const ViewData &view);
+        void markDirty(uint32_t slot);
+
+        bool ensureBuffer(Buffer &b, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible);
+        bool createBuffer(Buffer &b, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible);
+        void destroyBuffer(Buffer &b);
+        void retire(Buffer &b);
+        void tickRetired();
+
+        bool m_enabled = true;
+        bool m_ready = false;
+        AssetManager *m_assets = nullptr;
+        std::string m_debugName = "GpuScene";
+        float m_lodPixelError = 1.0f;
+        bool m_occlusionCulling = true;
+
+        // Main thread
+        std::vector<ModelHandle> m_models;
+        std::unordered_map<uint64_t, uint32_t> m_modelIndex; // handle id -> latest index
+        std::vector<uint32_t> m_modelInstances;
+        std::vector<GpuInstance> m_instances;
+        std::vector<uint32_t> m_freeIds;
+        std::vector<uint32_t> m_dirty;
+        std::vector<uint8_t> m_dirtyFlag;
+        uint32_t m_liveCount = 0;
+
+        RecordState m_record;
+
+        VkDevice m_device = VK_NULL_HANDLE;
+        VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+        VkExtent2D m_extent{};
+        uint32_t m_maxGroupsX = 65535;
+        bool m_multiDraw = false;
+        PFN_vkCmdDrawIndexedIndirectCountKHR m_drawIndexedIndirectCount = nullptr;
+
+        std::shared_ptr<SModelRenderer> m_shared; // material sets
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkDescriptorSetLayout m_hiZSetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_pool = VK_NULL_HANDLE;
+        VkPipelineLayout m_computeLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_drawLayout = VK_NULL_HANDLE;
+        VkPipeline m_cullPipeline = VK_NULL_HANDLE;
+        VkPipeline m_occlusionPipeline = VK_NULL_HANDLE; // optional
+        VkPipeline m_argsPipeline = VK_NULL_HANDLE;
+        VkPipeline m_scatterPipeline = VK_NULL_HANDLE;
+        Pipeline m_pipelines[2][3]; // [quantized][alphaMode]
+
+        // Render thread: model tables and the persistent scene buffer
+        Buffer m_instanceBuffer;
+        Buffer m_modelBuffer;
+        Buffer m_drawBuffer;
+        Buffer m_clipBuffer;
+        Buffer m_bakedBuffer;
+        std::vector<const ModelAsset *> m_builtModels; // per model index; null: not built
+        std::vector<uint32_t> m_drawsPerInstance;      // per model: draws per LOD level
+        std::vector<glm::vec4> m_modelSpheres;         // per model: GpuModel::sphere
+        std::vector<float> m_feedbackPixels;           // per model: largest size of the current sweep
+        uint32_t m_feedbackCursor = 0;
+        std::vector<Group> m_groups;
+        uint32_t m_drawCount = 0;
+        bool m_staticValid = false;
+
+        std::vector<Frame> m_frames;
+        std::vector<Retired> m_retired;
+        std::vector<VkBufferCopy> m_copyScratch;
+    };
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace Engine
+{
+    // ============================================================
+    // GpuTimeline
+    // ============================================================
+    // One VK_KHR_timeline_semaphore whose value only grows: every submission on the owning queue
+    // signals the next value, so "the GPU finished submission N" is a single integer comparison.
+    // - reserve() hands out the value the next submission signals. Values must be signalled in
+    //   submission order, so one timeline belongs to one queue (other queues wait on it GPU-side).
+    // - completed() is a non-blocking query; wait() blocks the CPU only when the caller must.
+    // - deferUntil() queues a release (old buffer after growth, staging chunk reuse) that collect()
+    //   runs once the timeline reaches the value - no per-resource fences or frame countdowns.
+    class GpuTimeline
+    {
+    public:
+        GpuTimeline() = default;
+        ~GpuTimeline() = default;
+        GpuTimeline(const GpuTimeline &) = delete;
+        GpuTimeline &operator=(const GpuTimeline &) = delete;
+
+        // Returns false (and stays invalid) without VK_KHR_timeline_semaphore; callers keep fences then.
+        bool create(VkDevice device, uint64_t initialValue = 0);
+
+        // Runs every pending release; the caller must have waited for the device to go idle.
+        void destroy();
+
+        bool valid() const { return m_semaphore != VK_NULL_HANDLE; }
+        VkSemaphore semaphore() const { return m_semaphore; }
+
+        // Value the next submission signals. Not thread-safe: reserve from the submitting thread.
+        uint64_t reserve() { return ++m_lastReserved; }
+        uint64_t lastReserved() const { return m_lastReserved; }
+
+        // Highest value the GPU has signalled.
+        uint64_t completed() const;
+
+        // Block until the timeline reaches 'value'; false on timeout or device loss.
+        bool wait(uint64_t value, uint64_t timeoutNs = UINT64_MAX) const;
+
+        // Run 'release' from collect() once the timeline reaches 'value'. Thread-safe.
+        void deferUntil(uint64_t value, std::function<void()> release);
+
+        // Run the releases whose value has been reached.
+        void collect();
+
+    private:
+        struct Deferred
+        {
+            uint64_t value = 0;
+            std::function<void()> release;
+        };
+
+        VkDevice m_device = VK_NULL_HANDLE;
+        VkSemaphore m_semaphore = VK_NULL_HANDLE;
+        PFN_vkGetSemaphoreCounterValueKHR m_getCounterValue = nullptr;
+        PFN_vkWaitSemaphoresKHR m_waitSemaphores = nullptr;
+        uint64_t m_lastReserved = 0;
+
+        std::mutex m_deferredMutex;
+        std::vector<Deferred> m_deferred;
+        std::vector<Deferred> m_ready; // collect() scratch
+    };
+}
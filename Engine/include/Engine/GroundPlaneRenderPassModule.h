@@ -5,10 +5,9 @@
 #include "assets/AssetManager.h"
 #include "assets/Handles.h"
 
-#include "Engine/Camera.h"
 #include "Engine/Pipeline.h"
 
-#include "utils/BufferUtils.h"
+#include "Engine/GpuAllocator.h"
 
 #include <glm/glm.hpp>
 
@@ -19,8 +18,18 @@
 
 namespace Engine
 {
-    // Renders a single ground plane (XZ) with a tiled base-color texture.
-    // Uses the existing smodel shaders so we can reuse the texture/material path.
+    class Heightfield;
+
+    // Renders the ground (XZ) with a tiled base-color texture as a geometry clipmap generated in
+    // ground.vert: no vertex or index buffers, nothing rewritten per frame. Level L is a grid of
+    // gridQuads x gridQuads cells of baseCellSize * 2^L meters centered on the camera (snapped so
+    // vertices do not swim); levels above 0 skip the cells the finer level covers, and the outer
+    // border of every level follows the coarser level's edges, so there are no cracks.
+    //
+    // Heights come from an optional Heightfield mirrored into an R32_SFLOAT texture; without one the
+    // ground is flat at y = 0. Heightfield edits are picked up in onFrameSnapshot() and only the
+    // dirty rectangle is uploaded in recordPrePass(). The camera is the Renderer's (setCamera): the
+    // shader reads the frame's shared ViewData block, and nothing is drawn without one.
     class GroundPlaneRenderPassModule final : public RenderPassModule
     {
     public:
@@ -29,108 +38,108 @@ namespace Engine
 
         void setEnabled(bool enabled) { m_enabled = enabled; }
         void setAssets(AssetManager *assets) { m_assets = assets; }
-        void setCamera(Camera *camera) { m_camera = camera; }
         void setBaseColorTexture(TextureHandle tex) { m_baseColorTexture = tex; }
 
-        // Half-size (meters) of the quad around the camera.
+        // Half-size (meters) of the ground around the camera: the coarsest level reaches at least this far.
         void setHalfSize(float halfSize) { m_halfSize = halfSize; }
 
         // World-space meters per one texture repeat.
         void setTileWorldSize(float metersPerRepeat) { m_tileWorldSize = metersPerRepeat; }
 
+        // Clipmap shape: cells per level side (rounded up to a multiple of 4, at least 8) and the
+        // finest cell size in meters.
+        void setGridQuads(uint32_t quads) { m_gridQuads = quads; }
+        void setBaseCellSize(float meters) { m_baseCellSize = meters; }
+
+        // Not owned; read on the main thread in onFrameSnapshot(), which also consumes its dirty
+        // rectangle (one render module per heightfield). Null: flat ground.
+        void setHeightfield(Heightfield *heightfield) { m_heightfield = heightfield; }
+
         void onCreate(VulkanContext &ctx, VkRenderPass pass, const std::vector<VkFramebuffer> &fbs) override;
         void record(FrameContext &frameCtx, VkCommandBuffer cmd) override;
         void onResize(VulkanContext &ctx, VkExtent2D newExtent) override;
         void onDestroy(VulkanContext &ctx) override;
+        void onFrameSnapshot() override;
+        void recordPrePass(FrameContext &frameCtx, VkCommandBuffer cmd) override;
+        const char *debugName() const override { return "GroundPlane"; }
 
     private:
-        struct CameraUBO
-        {
-            glm::mat4 view{1.0f};
-            glm::mat4 proj{1.0f};
-        };
-
+        // Must match ground.vert.
         struct PushConstants
         {
-            glm::mat4 model{1.0f};
-            glm::vec4 baseColorFactor{1.0f};
-            glm::vec4 materialParams{0.0f}; // x=alphaCutoff, y=alphaMode
-
-            // Matches smodel.vert push constants (x=nodeIndex, y=nodeCount)
-            glm::uvec4 nodeInfo{0u, 1u, 0u, 0u};
-
-            // Matches smodel.vert skinInfo (unused for ground)
-            glm::uvec4 skinInfo{0u, 0u, 1u, 0u};
+            glm::vec4 cameraPos{0.0f};   // xyz, w = finest cell size
+            glm::vec4 grid{0.0f};        // x = quads per level side, y = levels, z = 1 / tileWorldSize
+            glm::vec4 heightfield{0.0f}; // xy = origin, z = 1 / cellSize
         };
 
-        static_assert(sizeof(PushConstants) == 128, "GroundPlane PushConstants must match smodel.vert");
-        static_assert(offsetof(PushConstants, nodeInfo) == 96, "GroundPlane PushConstants::nodeInfo offset must match smodel.vert");
+        static_assert(sizeof(PushConstants) == 48, "GroundPlane PushConstants must match ground.vert");
 
         struct CameraFrame
         {
             VkDescriptorSet set = VK_NULL_HANDLE;
-            VkBuffer buffer = VK_NULL_HANDLE;
-            VkDeviceMemory memory = VK_NULL_HANDLE;
-
-            VkBuffer paletteBuffer = VK_NULL_HANDLE;
-            VkDeviceMemory paletteMemory = VK_NULL_HANDLE;
-            void *paletteMapped = nullptr;
-            uint32_t paletteCapacityMatrices = 0;
-
-            VkBuffer jointPaletteBuffer = VK_NULL_HANDLE;
-            VkDeviceMemory jointPaletteMemory = VK_NULL_HANDLE;
-            void *jointPaletteMapped = nullptr;
-            uint32_t jointPaletteCapacityMatrices = 0;
+            uint32_t viewVersion = 0;                // FrameContext::viewBuffer written to binding 0 (dynamic UBO)
+            VkImageView heightView = VK_NULL_HANDLE; // written to the set's binding 1
+
+            // Heightfield upload source; reused once this slot's previous frame has completed.
+            VkBuffer stagingBuffer = VK_NULL_HANDLE;
+            GpuAllocation stagingAllocation;
+            VkDeviceSize stagingCapacity = 0;
         };
 
-        struct InstanceFrame
+        struct HeightImage
         {
-            VkBuffer buffer = VK_NULL_HANDLE;
-            VkDeviceMemory memory = VK_NULL_HANDLE;
-            void *mapped = nullptr;
+            VkImage image = VK_NULL_HANDLE;
+            GpuAllocation allocation;
+            VkImageView view = VK_NULL_HANDLE;
+            uint32_t framesLeft = 0; // retired without a timeline: destroyed after this many pre-passes
         };
 
-        struct PlaneVertex
+        // Heightfield texels copied on the main thread, uploaded by the next recordPrePass().
+        struct HeightUpload
         {
-            glm::vec3 pos;
-            glm::vec3 normal;
-            glm::vec2 uv0;
-            glm::vec4 tangent;
-
-            glm::u16vec4 joints{0, 0, 0, 0};
-            glm::vec4 weights{0.0f};
+            bool pending = false;
+            bool recreate = false; // new texture of width x depth
+            uint32_t width = 0;
+            uint32_t depth = 0;
+            uint32_t x = 0;
+            uint32_t z = 0;
+            uint32_t rectWidth = 0;
+            uint32_t rectDepth = 0;
+            std::vector<float> texels; // rectWidth x rectDepth
+            glm::vec2 origin{0.0f};
+            float cellSize = 1.0f;
         };
 
     private:
         bool createCameraResources(VulkanContext &ctx, size_t frameCount);
         void destroyCameraResources();
 
-        bool createInstanceResources(VulkanContext &ctx, size_t frameCount);
-        void destroyInstanceResources();
-
         bool createMaterialResources(VulkanContext &ctx, size_t frameCount);
         void destroyMaterialResources();
 
-        bool createGeometryResources(VulkanContext &ctx, size_t frameCount);
-        void destroyGeometryResources();
-
-        void updatePlaneForFrame(uint32_t frameIndex);
+        void snapshotHeightfield();
+        bool uploadHeights(FrameContext &frameCtx, VkCommandBuffer cmd, CameraFrame &frame);
+        void retireHeightImage(FrameContext &frameCtx);
+        void destroyHeightImage(HeightImage &img);
 
     private:
         bool m_enabled = true;
-        AssetManager *m_assets = nullptr; // not owned
-        Camera *m_camera = nullptr;       // not owned
+        AssetManager *m_assets = nullptr;           // not owned
+        Heightfield *m_heightfield = nullptr;       // not owned
 
         TextureHandle m_baseColorTexture{};
 
         float m_halfSize = 250.0f;
         float m_tileWorldSize = 5.0f;
+        uint32_t m_gridQuads = 64;
+        float m_baseCellSize = 1.0f;
 
         VkDevice m_device = VK_NULL_HANDLE;
         VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
         VkExtent2D m_extent{};
+        uint32_t m_frameCount = 1;
 
-        // Camera descriptor set (set=0)
+        // Camera descriptor set (set=0): UBO + height texture
         VkDescriptorSetLayout m_cameraSetLayout = VK_NULL_HANDLE;
         VkDescriptorPool m_cameraPool = VK_NULL_HANDLE;
         std::vector<CameraFrame> m_cameraFrames;
@@ -140,15 +149,22 @@ namespace Engine
         VkDescriptorPool m_materialPool = VK_NULL_HANDLE;
         std::vector<VkDescriptorSet> m_materialSets;
 
-        // Per-frame instance buffer (binding=1)
-        std::vector<InstanceFrame> m_instanceFrames;
+        // Height texture (record thread); texelFetch only, so the sampler is nearest/clamp.
+        HeightImage m_height;
+        std::vector<HeightImage> m_retiredHeights;
+        VkSampler m_heightSampler = VK_NULL_HANDLE;
+        bool m_heightInitialized = false; // out of UNDEFINED
+        glm::vec2 m_heightOrigin{0.0f};
+        float m_heightCellSize = 1.0f;
 
-        // Per-frame plane VB (binding=0)
-        std::vector<VertexBufferHandle> m_planeVB;
-        IndexBufferHandle m_planeIB{};
+        // Main-thread side of the heightfield mirror
+        uint32_t m_snapshotLayoutRevision = 0;
+        bool m_snapshotHasTexture = false;
+        HeightUpload m_upload;
 
         Pipeline m_pipeline;
 
-        PushConstants m_pc{};
+        // Enable state copied in onFrameSnapshot(); record() reads only this.
+        bool m_recordEnabled = true;
     };
 }
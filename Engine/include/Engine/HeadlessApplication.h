@@ -0,0 +1,93 @@
+#pragma once
+/*
+  HeadlessApplication.h
+  ---------------------
+  Purpose:
+    - Application without a window or graphics device, for dedicated simulation servers and
+      benchmark machines: an ECS context, CPU-only model loading (HeadlessAssetManager) and a
+      fixed-tick loop. Part of EngineCore, which links neither Vulkan nor GLFW.
+
+  Usage:
+    - class Server : public Engine::HeadlessApplication
+      {
+          void OnStart() override { ...load prefabs with &GetAssets(), spawn... }
+          void OnFixedUpdate(Engine::TimeStep ts) override { systems.FixedUpdate(GetECS(), ts.DeltaSeconds); }
+      };
+      Server server;
+      server.SetTickRate(30.0f);
+      server.Run(); // until Close() (or SetTickLimit ticks)
+
+  Notes:
+    - Real-time mode sleeps to the tick rate; a tick that ends after the next one was due makes the
+      loop catch up (at most maxCatchUpTicks back to back), the rest of the backlog is dropped and
+      counted. SetRealtime(false) runs ticks back to back (offline simulation, CI).
+    - Every tick closes one CpuProfiler frame (per-system timings as in the windowed build) and is
+      recorded as a Telemetry frame; ECS archetype counts and dropped ticks are Telemetry sources.
+      Set STRATO_TELEMETRY_* (Engine/Telemetry.h) to export them.
+*/
+
+#include "Engine/TimeStep.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace Engine
+{
+    class HeadlessAssetManager;
+
+    namespace ECS
+    {
+        struct ECSContext;
+    }
+
+    class HeadlessApplication
+    {
+    public:
+        HeadlessApplication();
+        virtual ~HeadlessApplication();
+        HeadlessApplication(const HeadlessApplication &) = delete;
+        HeadlessApplication &operator=(const HeadlessApplication &) = delete;
+
+        // Run the tick loop on the calling thread (blocks).
+        void Run();
+
+        // Once at the start of Run(), before the first tick.
+        virtual void OnStart() {}
+
+        // One simulation tick: DeltaSeconds = FixedDeltaSeconds = 1 / tick rate, FixedSteps = ticks
+        // already run this loop iteration.
+        virtual void OnFixedUpdate(TimeStep) {}
+
+        // Once when Run() returns.
+        virtual void OnStop() {}
+
+        // Ticks per second (> 0) and the catch-up limit after a slow tick.
+        void SetTickRate(float hz, uint32_t maxCatchUpTicks = 5);
+        float GetTickRate() const;
+
+        // false: no sleeping, every tick starts when the previous one ends.
+        void SetRealtime(bool realtime);
+
+        // Stop after this many ticks (0, default: until Close()).
+        void SetTickLimit(uint64_t ticks);
+
+        struct TickStats
+        {
+            uint64_t ticks = 0;        // OnFixedUpdate calls so far
+            uint64_t droppedTicks = 0; // real-time ticks skipped after falling behind
+            float lastTickMs = 0.0f;
+            float maxTickMs = 0.0f;
+        };
+        const TickStats &GetTickStats() const;
+
+        ECS::ECSContext &GetECS();
+        HeadlessAssetManager &GetAssets();
+
+        // Stop after the current tick. Any thread.
+        virtual void Close();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> m_Impl;
+    };
+}
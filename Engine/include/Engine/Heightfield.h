@@ -0,0 +1,152 @@
+#pragma once
+/*
+  Heightfield.h
+  -------------
+  Purpose:
+    - Terrain heights on a regular XZ grid: the CPU copy that gameplay queries (heightAt() for units'
+      Position.y) and that GroundPlaneRenderPassModule mirrors into an R32_SFLOAT texture.
+    - The GPU samples it with the same bilinear rule as heightAt(), so units stand exactly on the
+      rendered surface.
+
+  Usage:
+    - Heightfield h; h.resize(513, 513, 2.0f, {-512.0f, -512.0f});
+    - h.setRegion(x0, z0, w, d, heights);   // edits mark a dirty rectangle
+    - float y = h.heightAt(pos.x, pos.z);
+
+  Notes:
+    - Sample (i, j) sits at origin + (i, j) * cellSize; queries outside the grid clamp to the edge.
+    - Not thread-safe: edit between frames on the main thread. The render module copies dirty
+      rectangles in onFrameSnapshot() and uploads only those texels.
+*/
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+    class Heightfield
+    {
+    public:
+        // Texel rectangle [x, x + width) x [z, z + depth).
+        struct Rect
+        {
+            uint32_t x = 0;
+            uint32_t z = 0;
+            uint32_t width = 0;
+            uint32_t depth = 0;
+
+            bool empty() const { return width == 0 || depth == 0; }
+        };
+
+        // Flat at height 0; the whole grid is dirty.
+        void resize(uint32_t width, uint32_t depth, float cellSize, glm::vec2 origin)
+        {
+            m_width = width;
+            m_depth = depth;
+            m_cellSize = std::max(cellSize, 1e-4f);
+            m_origin = origin;
+            m_heights.assign(static_cast<size_t>(width) * depth, 0.0f);
+            m_dirty = Rect{0, 0, width, depth};
+            ++m_layoutRevision;
+        }
+
+        uint32_t width() const { return m_width; }
+        uint32_t depth() const { return m_depth; }
+        float cellSize() const { return m_cellSize; }
+        glm::vec2 origin() const { return m_origin; }
+        bool empty() const { return m_heights.empty(); }
+        const float *data() const { return m_heights.data(); }
+
+        // Changes whenever resize() changes the grid (the GPU texture is recreated).
+        uint32_t layoutRevision() const { return m_layoutRevision; }
+
+        float sample(uint32_t x, uint32_t z) const { return m_heights[static_cast<size_t>(z) * m_width + x]; }
+
+        void setSample(uint32_t x, uint32_t z, float height)
+        {
+            if (x >= m_width || z >= m_depth)
+                return;
+            m_heights[static_cast<size_t>(z) * m_width + x] = height;
+            markDirty(Rect{x, z, 1, 1});
+        }
+
+        // Copy 'width x depth' heights (row-major, z rows) to texel (x, z); clipped to the grid.
+        void setRegion(uint32_t x, uint32_t z, uint32_t width, uint32_t depth, const float *heights)
+        {
+            if (!heights || x >= m_width || z >= m_depth)
+                return;
+            const uint32_t w = std::min(width, m_width - x);
+            const uint32_t d = std::min(depth, m_depth - z);
+            for (uint32_t row = 0; row < d; ++row)
+                std::copy(heights + static_cast<size_t>(row) * width, heights + static_cast<size_t>(row) * width + w,
+                          m_heights.begin() + static_cast<size_t>(z + row) * m_width + x);
+            markDirty(Rect{x, z, w, d});
+        }
+
+        // Bilinear height at world (x, z); 0 for an empty heightfield.
+        float heightAt(float x, float z) const
+        {
+            if (m_heights.empty())
+                return 0.0f;
+
+            const float gx = std::clamp((x - m_origin.x) / m_cellSize, 0.0f, static_cast<float>(m_width - 1));
+            const float gz = std::clamp((z - m_origin.y) / m_cellSize, 0.0f, static_cast<float>(m_depth - 1));
+            const uint32_t x0 = std::min(static_cast<uint32_t>(gx), m_width > 1 ? m_width - 2 : 0u);
+            const uint32_t z0 = std::min(static_cast<uint32_t>(gz), m_depth > 1 ? m_depth - 2 : 0u);
+            const uint32_t x1 = std::min(x0 + 1, m_width - 1);
+            const uint32_t z1 = std::min(z0 + 1, m_depth - 1);
+            const float fx = gx - static_cast<float>(x0);
+            const float fz = gz - static_cast<float>(z0);
+
+            const float h0 = sample(x0, z0) + (sample(x1, z0) - sample(x0, z0)) * fx;
+            const float h1 = sample(x0, z1) + (sample(x1, z1) - sample(x0, z1)) * fx;
+            return h0 + (h1 - h0) * fz;
+        }
+
+        // Unit surface normal at world (x, z) from central differences of heightAt().
+        glm::vec3 normalAt(float x, float z) const
+        {
+            const float e = m_cellSize;
+            const float dx = heightAt(x + e, z) - heightAt(x - e, z);
+            const float dz = heightAt(x, z + e) - heightAt(x, z - e);
+            return glm::normalize(glm::vec3(-dx, 2.0f * e, -dz));
+        }
+
+        // Texels changed since the last takeDirty() (their bounding rectangle), then clears it.
+        Rect takeDirty()
+        {
+            const Rect r = m_dirty;
+            m_dirty = Rect{};
+            return r;
+        }
+
+    private:
+        void markDirty(const Rect &r)
+        {
+            if (r.empty())
+                return;
+            if (m_dirty.empty())
+            {
+                m_dirty = r;
+                return;
+            }
+            const uint32_t x0 = std::min(m_dirty.x, r.x);
+            const uint32_t z0 = std::min(m_dirty.z, r.z);
+            const uint32_t x1 = std::max(m_dirty.x + m_dirty.width, r.x + r.width);
+            const uint32_t z1 = std::max(m_dirty.z + m_dirty.depth, r.z + r.depth);
+            m_dirty = Rect{x0, z0, x1 - x0, z1 - z0};
+        }
+
+        uint32_t m_width = 0;
+        uint32_t m_depth = 0;
+        float m_cellSize = 1.0f;
+        glm::vec2 m_origin{0.0f};
+        std::vector<float> m_heights;
+        Rect m_dirty;
+        uint32_t m_layoutRevision = 0;
+    };
+}
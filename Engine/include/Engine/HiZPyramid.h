@@ -0,0 +1,81 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "Engine/GpuAllocator.h"
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+    class VulkanContext;
+
+    // Hierarchical-Z pyramid of the depth pre-pass: R32_SFLOAT levels whose texels hold the farthest
+    // depth of everything below them, so an occlusion test reads at most 2x2 texels per object.
+    // Level 0 is half the depth resolution and every level halves again, rounding up: texel x of
+    // level L covers depth pixels [x << (L + 1), (x + 1) << (L + 1)).
+    //
+    // One pyramid per frame in flight, kept in VK_IMAGE_LAYOUT_GENERAL and rebuilt on the graphics
+    // queue between the depth pre-pass and the main render pass (see Renderer::setDepthPrePass).
+    // Needs shaders/hiz_build.comp.spv; without it create() returns false and nothing is occlusion-culled.
+    class HiZPyramid
+    {
+    public:
+        HiZPyramid() = default;
+        ~HiZPyramid() = default;
+        HiZPyramid(const HiZPyramid &) = delete;
+        HiZPyramid &operator=(const HiZPyramid &) = delete;
+
+        bool create(VulkanContext &ctx, uint32_t frameCount);
+        void destroy();
+        bool ready() const { return m_pipeline != VK_NULL_HANDLE && !m_frames.empty(); }
+
+        // (Re)create the pyramids for a depth buffer of 'depthExtent'. The device must be idle.
+        bool resize(VkExtent2D depthExtent);
+
+        // Build this frame's pyramid from 'depthView' (depth aspect only, in
+        // DEPTH_STENCIL_READ_ONLY_OPTIMAL; the caller makes the depth writes visible to compute).
+        // Afterwards the pyramid is readable by compute shaders.
+        void record(VkCommandBuffer cmd, uint32_t frameIndex, VkImageView depthView);
+
+        // All levels, for texelFetch(hiZ, texel, level) in culling shaders.
+        VkImageView view(uint32_t frameIndex) const;
+        VkSampler sampler() const { return m_sampler; }
+        VkExtent2D extent() const { return m_extent; } // level 0
+        uint32_t mipCount() const { return m_mipCount; }
+
+    private:
+        struct Frame
+        {
+            VkImage image = VK_NULL_HANDLE;
+            GpuAllocation allocation;
+            VkImageView view = VK_NULL_HANDLE;      // all levels
+            std::vector<VkImageView> levelViews;    // one per level
+            std::vector<VkDescriptorSet> levelSets; // level L: source L-1 (depth for 0), target L
+            bool initialized = false;               // moved out of UNDEFINED
+        };
+
+        struct PushConstants
+        {
+            uint32_t srcWidth;
+            uint32_t srcHeight;
+            uint32_t dstWidth;
+            uint32_t dstHeight;
+        };
+
+        void destroyFrames();
+
+        VkDevice m_device = VK_NULL_HANDLE;
+        VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+        uint32_t m_frameCount = 0;
+
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        VkPipeline m_pipeline = VK_NULL_HANDLE;
+        VkSampler m_sampler = VK_NULL_HANDLE;
+        VkDescriptorPool m_pool = VK_NULL_HANDLE; // sized for the current extent
+
+        VkExtent2D m_depthExtent{};
+        VkExtent2D m_extent{};
+        uint32_t m_mipCount = 0;
+        std::vector<Frame> m_frames;
+    };
+}
@@ -0,0 +1,182 @@
+#pragma once
+#include "Engine/Renderer.h"
+#include "assets/AssetManager.h"
+#include "Engine/Camera.h"
+#include "Engine/Pipeline.h"
+#include "Engine/GpuAllocator.h"
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Engine
+{
+    class SModelRenderer;
+
+    // Draws far instances of one model as camera-facing sprites cut from an atlas baked from the model
+    // itself. Atlas column k is the view from azimuth k * 360 / directions (about +Y, looking down at
+    // a fixed elevation), row r one pose: framesPerClip evenly spaced times of every animation clip,
+    // or the rest pose for models without clips. All instances are one instanced quad draw; the vertex
+    // shader picks the column from the camera direction and the row comes from the instance's clip time.
+    //
+    // The atlas is baked on the graphics queue by the first recordPrePass() that finds the model and
+    // its textures resident (whether or not the module is enabled), drawing the model with the SModel
+    // shaders into an offscreen pass, so sprites match the full model's shading. Needs
+    // shaders/impostor.vert.spv and shaders/impostor.frag.spv; without them ready() stays false and
+    // callers keep drawing the full model.
+    class ImpostorRenderPassModule : public RenderPassModule
+    {
+    public:
+        // Must be set before onCreate(). The atlas is directions * cellSize texels wide and
+        // (clips * framesPerClip) * cellSize high; framesPerClip shrinks to fit the device's image limit.
+        struct Settings
+        {
+            uint32_t directions = 8;
+            uint32_t framesPerClip = 8;
+            uint32_t cellSize = 64;
+            float elevationDegrees = 35.0f; // camera pitch of the bake views
+        };
+
+        // 32 bytes like SModelRenderPassModule::CompactInstance. The model is drawn unscaled at
+        // 'position', rotated by 'yaw' radians about +Y (glm::rotate convention).
+        struct Instance
+        {
+            glm::vec3 position{0.0f};
+            float scale = 1.0f;
+            float yaw = 0.0f;
+            uint32_t clip = 0;
+            float timeSec = 0.0f;
+            float _pad = 0.0f;
+        };
+        static_assert(sizeof(Instance) == 32, "ImpostorRenderPassModule::Instance must stay 32 bytes");
+
+        ImpostorRenderPassModule() = default;
+        ~ImpostorRenderPassModule() override;
+
+        void setEnabled(bool en) { m_enabled = en; }
+        void setAssets(AssetManager *assets) { m_assets = assets; }
+        // One model per module; set before registerPass().
+        void setModel(ModelHandle h) { m_model = h; }
+        void setCamera(Camera *cam) { m_camera = cam; }
+        void setSettings(const Settings &settings) { m_settings = settings; }
+
+        // Label of this pass in the GPU profiler (default "Impostors").
+        void setDebugName(std::string name) { m_debugName = std::move(name); }
+        const char *debugName() const override { return m_debugName.c_str(); }
+
+        void setInstances(const Instance *instances, uint32_t count);
+
+        // The sprite pipeline exists (shaders found).
+        bool ready() const { return m_pipeline.getVkPipeline() != VK_NULL_HANDLE; }
+        // The atlas has been recorded; instances set from now on are drawn.
+        bool baked() const { return m_baked.load(std::memory_order_acquire); }
+
+        void onCreate(VulkanContext &ctx, VkRenderPass pass, const std::vector<VkFramebuffer> &fbs) override;
+        void record(FrameContext &frameCtx, VkCommandBuffer cmd) override;
+        void onResize(VulkanContext &ctx, VkExtent2D newExtent) override;
+        void onDestroy(VulkanContext &ctx) override;
+        void onFrameSnapshot() override;
+        void recordPrePass(FrameContext &frameCtx, VkCommandBuffer cmd) override;
+
+    private:
+        struct RecordState
+        {
+            bool enabled = true;
+            glm::mat4 viewProj{1.0f};
+            glm::vec3 cameraPos{0.0f};
+            std::vector<Instance> instances;
+        };
+
+        // Per instance on the GPU: xyz position, w scale; x/y yaw sin/cos, z atlas row.
+        struct GpuInstance
+        {
+            glm::vec4 positionScale;
+            glm::vec4 yawRow;
+        };
+        static_assert(sizeof(GpuInstance) == 32, "GpuInstance must match impostor.vert");
+
+        // Push constants of impostor.vert.
+        struct PushConstants
+        {
+            glm::mat4 viewProj;
+            glm::vec4 cameraPos; // xyz
+            glm::vec4 sphere;    // instance-space center xyz, radius w: the sprite's extent
+            glm::vec4 atlas;     // x=directions, y=rows, z=1/directions, w=1/rows
+        };
+        static_assert(sizeof(PushConstants) == 112, "PushConstants must match impostor.vert");
+
+        // Rows of one clip in the atlas.
+        struct ClipRows
+        {
+            uint32_t firstRow = 0;
+            uint32_t rowCount = 1;
+            float durationSec = 0.0f;
+        };
+
+        // Offscreen pass and buffers only the bake uses; released once the bake has executed.
+        struct BakeResources
+        {
+            VkDevice device = VK_NULL_HANDLE;
+            VkRenderPass renderPass = VK_NULL_HANDLE;
+            VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+            std::shared_ptr<SModelRenderer> renderer; // SModel pipelines built for renderPass
+            VkImage depthImage = VK_NULL_HANDLE;
+            GpuAllocation depthAllocation;
+            VkImageView depthView = VK_NULL_HANDLE;
+            VkFramebuffer framebuffer = VK_NULL_HANDLE;
+            VkDescriptorPool pool = VK_NULL_HANDLE;
+            std::vector<VkBuffer> buffers; // camera UBOs, palettes, pose instances
+            std::vector<GpuAllocation> allocations;
+
+            ~BakeResources();
+        };
+
+        bool createPipeline(VkRenderPass pass);
+        bool createBakePass(VulkanContext &ctx);
+        bool createAtlas(uint32_t width, uint32_t height);
+        void destroyResources();
+
+        // All primitives resident with their textures (streaming ones are baked once they arrive).
+        bool bakeable(const ModelAsset &model) const;
+        bool bake(FrameContext &frameCtx, VkCommandBuffer cmd, const ModelAsset &model);
+        bool createBakeBuffer(VkDeviceSize size, VkBufferUsageFlags usage, void *&mapped);
+        uint32_t rowOf(const Instance &instance) const;
+
+    private:
+        VkDevice m_device = VK_NULL_HANDLE;
+        VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+        VkExtent2D m_extent{};
+
+        AssetManager *m_assets = nullptr; // not owned
+        ModelHandle m_model{};
+        Camera *m_camera = nullptr; // not owned
+        std::string m_debugName = "Impostors";
+        Settings m_settings;
+        bool m_enabled = true;
+        std::vector<Instance> m_instances;
+        RecordState m_record;
+
+        // Sprite pipeline (main render pass): set 0 = atlas sampler
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        Pipeline m_pipeline;
+        VkDescriptorPool m_pool = VK_NULL_HANDLE;
+        VkDescriptorSet m_set = VK_NULL_HANDLE;
+
+        // Atlas (written by the bake, then sampled)
+        VkImage m_atlas = VK_NULL_HANDLE;
+        GpuAllocation m_atlasAllocation;
+        VkImageView m_atlasView = VK_NULL_HANDLE;
+        VkSampler m_sampler = VK_NULL_HANDLE;
+        uint32_t m_directions = 0;
+        uint32_t m_rows = 0;
+        glm::vec4 m_sphere{0.0f};
+        std::vector<ClipRows> m_clipRows;
+
+        std::shared_ptr<BakeResources> m_bake; // null once released
+        bool m_bakeFailed = false;
+        std::atomic<bool> m_baked{false};
+    };
+}
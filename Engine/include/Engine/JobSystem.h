@@ -0,0 +1,168 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Engine
+{
+    // Frame-critical work runs before anything else; background work never delays a frame's wait().
+    enum class JobPriority : uint8_t
+    {
+        High = 0,       // parallel-for ranges, system graph, command recording
+        Normal = 1,     // work the frame will want soon
+        Background = 2, // streaming, decoding, path / flow field builds
+    };
+
+    // Jobs outstanding in a group. Submitting with a counter adds one, finishing a job removes one;
+    // JobSystem::wait() returns when it reaches zero. Continuations (submitAfter) start then.
+    // Must outlive its jobs: wait() on it before destroying it.
+    class JobCounter
+    {
+    public:
+        JobCounter() = default;
+        JobCounter(const JobCounter &) = delete;
+        JobCounter &operator=(const JobCounter &) = delete;
+
+        uint32_t pending() const { return m_pending.load(std::memory_order_acquire); }
+        bool done() const { return pending() == 0; }
+
+    private:
+        friend class JobSystem;
+
+        struct Continuation
+        {
+            std::function<void()> fn;
+            JobCounter *counter = nullptr;
+            JobPriority priority = JobPriority::Normal;
+        };
+
+        std::atomic<uint32_t> m_pending{0};
+        std::mutex m_mutex;
+        std::vector<Continuation> m_continuations; // submitted when m_pending reaches zero
+        std::exception_ptr m_error;                // first exception of a job in the group
+    };
+
+    // ============================================================
+    // JobSystem
+    // ============================================================
+    // The engine's one thread pool: every worker owns a deque per priority, pops its own work LIFO
+    // and steals FIFO from the others, always taking the highest priority available. At most
+    // workerCount() - 1 background jobs run at once, so one worker is always free for frame work.
+    //
+    // Threads that wait (wait(), parallelFor()) run High and Normal jobs meanwhile; nested waits from
+    // inside jobs therefore cannot deadlock. Every job runs inside a FrameArena::Scope.
+    //
+    // Main-thread jobs (GLFW, window and swapchain calls) queue from any thread and run in
+    // pumpMainThread(), which Application calls once per frame; a wait() on the main thread pumps too.
+    // The main thread is the one that created the instance (Application does, first thing).
+    class JobSystem
+    {
+    public:
+        using Fn = std::function<void()>;
+
+        // workerCount = 0 picks hardware_concurrency() - 1, at least 1 (the waiting thread helps too).
+        explicit JobSystem(uint32_t workerCount = 0);
+        ~JobSystem();
+        JobSystem(const JobSystem &) = delete;
+        JobSystem &operator=(const JobSystem &) = delete;
+
+        // Process-wide instance, created on first use.
+        static JobSystem &get();
+
+        uint32_t workerCount() const { return static_cast<uint32_t>(m_threads.size()); }
+        bool isMainThread() const { return std::this_thread::get_id() == m_mainThread; }
+
+        // Any thread. An exception escaping 'fn' is kept in 'counter' (rethrown by wait()) or logged.
+        void submit(Fn fn, JobPriority priority = JobPriority::Normal, JobCounter *counter = nullptr);
+
+        // Submit 'fn' once 'dependency' reaches zero (now, if it already has). 'counter' counts it
+        // from this call on, so waiting on 'counter' also covers the dependency.
+        void submitAfter(JobCounter &dependency, Fn fn, JobPriority priority = JobPriority::Normal,
+                         JobCounter *counter = nullptr);
+
+        // Block until 'counter' reaches zero, running jobs up to 'helpUpTo' meanwhile; rethrows the
+        // first exception of the group. Background is only worth helping with from shutdown paths.
+        void wait(JobCounter &counter, JobPriority helpUpTo = JobPriority::Normal);
+
+        // Run fn(begin, end) over [0, count) split into ranges of at most 'grain' items and wait.
+        template <typename Body>
+        void parallelFor(uint32_t count, uint32_t grain, Body &&fn, JobPriority priority = JobPriority::High)
+        {
+            if (count == 0)
+                return;
+            grain = std::max<uint32_t>(1u, grain);
+            if (count <= grain)
+            {
+                fn(0u, count);
+                return;
+            }
+
+            JobCounter counter;
+            for (uint32_t begin = 0; begin < count; begin += grain)
+            {
+                const uint32_t end = std::min(count, begin + grain);
+                submit([&fn, begin, end]
+                       { fn(begin, end); },
+                       priority, &counter);
+            }
+            wait(counter, priority < JobPriority::Normal ? JobPriority::Normal : priority);
+        }
+
+        // Any thread: run 'fn' on the main thread at its next pumpMainThread().
+        void submitMainThread(Fn fn, JobCounter *counter = nullptr);
+        // Main thread only.
+        void pumpMainThread();
+
+    private:
+        static constexpr size_t kPriorityCount = 3;
+
+        struct Job
+        {
+            Fn fn;
+            JobCounter *counter = nullptr;
+            JobPriority priority = JobPriority::Normal;
+        };
+
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Job> jobs[kPriorityCount];
+        };
+
+        void push(Job job);
+        bool tryRunOne(size_t self, JobPriority maxPriority);
+        bool take(size_t self, size_t priority, Job &out);
+        void execute(Job &job);
+        void finish(JobCounter *counter);
+        size_t selfQueue() const;
+        bool hasRunnableWork() const;
+        void workerLoop(size_t self);
+
+        std::vector<std::unique_ptr<Queue>> m_queues; // [0]: threads outside the pool, [i]: worker i
+        std::vector<std::thread> m_threads;
+        std::thread::id m_mainThread;
+
+        std::atomic<uint32_t> m_queued{0};           // all priorities
+        std::atomic<uint32_t> m_queuedBackground{0};
+        std::atomic<uint32_t> m_nextQueue{0};
+        std::atomic<uint32_t> m_backgroundRunning{0};
+        uint32_t m_maxBackground = 1;
+
+        std::mutex m_sleepMutex;
+        std::condition_variable m_wake;
+        bool m_quit = false;
+
+        std::mutex m_mainMutex;
+        std::vector<Job> m_mainJobs;
+        std::atomic<uint32_t> m_mainQueued{0};
+    };
+
+} // namespace Engine
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Engine
+{
+    // ============================================================
+    // MemoryStats
+    // ============================================================
+    // Per-subsystem memory counters ("Assets" / "Textures", "ECS" / "Columns", ...).
+    // - Subsystems register a reporter that appends their current usage; nothing is counted
+    //   per allocation, so reporting costs nothing between collect() calls.
+    // - collect() runs every reporter, merges counters with the same (subsystem, name), keeps
+    //   the peak of each and checks subsystem totals against budgets set with setBudget().
+    //   Crossing a budget logs once to std::cerr until the subsystem drops back under it.
+    // Reporters run on the collecting thread, inside the registry lock: they must not add or
+    // remove reporters. PerformanceMonitor collects on the main thread with no frame recording,
+    // so reporters may read render-thread state without locks; other callers must do the same.
+    class MemoryStats
+    {
+    public:
+        struct Counter
+        {
+            std::string subsystem;
+            std::string name;
+            uint64_t cpuBytes = 0;
+            uint64_t gpuBytes = 0;
+            uint64_t count = 0;     // objects behind the bytes (meshes, stores, passes, ...)
+            uint64_t peakBytes = 0; // cpu + gpu, filled in by collect()
+        };
+
+        struct SubsystemTotal
+        {
+            std::string subsystem;
+            uint64_t cpuBytes = 0;
+            uint64_t gpuBytes = 0;
+            uint64_t peakBytes = 0;
+            uint64_t budgetBytes = 0; // 0: no budget
+            bool overBudget = false;
+        };
+
+        using Reporter = std::function<void(std::vector<Counter> &out)>;
+
+        // Returns an id for removeReporter() (never 0).
+        static uint32_t addReporter(Reporter reporter);
+        static void removeReporter(uint32_t id);
+
+        // Budget for a subsystem's cpu + gpu bytes (0 removes it).
+        static void setBudget(const std::string &subsystem, uint64_t bytes);
+
+        // Counters sorted by subsystem then name, and one total per subsystem.
+        static void collect(std::vector<Counter> &counters, std::vector<SubsystemTotal> &totals);
+
+        // RAII reporter registration; declare it as the last member so the reporter is removed
+        // before anything it reads is destroyed.
+        class Registration
+        {
+        public:
+            Registration() = default;
+            explicit Registration(Reporter reporter) : m_id(addReporter(std::move(reporter))) {}
+            ~Registration() { reset(); }
+
+            Registration(const Registration &) = delete;
+            Registration &operator=(const Registration &) = delete;
+            Registration(Registration &&other) noexcept : m_id(other.m_id) { other.m_id = 0; }
+            Registration &operator=(Registration &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    m_id = other.m_id;
+                    other.m_id = 0;
+                }
+                return *this;
+            }
+
+            void reset()
+            {
+                if (m_id != 0)
+                    removeReporter(m_id);
+                m_id = 0;
+            }
+
+        private:
+            uint32_t m_id = 0;
+        };
+    };
+
+} // namespace Engine
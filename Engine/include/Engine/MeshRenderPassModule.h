@@ -18,6 +18,7 @@ namespace Engine
             VkDeviceSize indexOffset = 0;
             uint32_t indexCount = 0;
             VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+            uint32_t vertexStride = 32; // MeshAsset::getVertexStride(); 16 selects the compact layout
         };
 
         MeshRenderPassModule() = default;
@@ -29,6 +30,7 @@ namespace Engine
         void record(FrameContext &frameCtx, VkCommandBuffer cmd) override;
         void onResize(VulkanContext &ctx, VkExtent2D newExtent) override;
         void onDestroy(VulkanContext &ctx) override;
+        const char *debugName() const override { return "Mesh"; }
         void setEnabled(bool en) { m_enabled = en; }
 
     private:
@@ -39,6 +41,7 @@ namespace Engine
         VkDevice m_device = VK_NULL_HANDLE;
         VkExtent2D m_extent{};
         Pipeline m_pipeline;
+        Pipeline m_pipelineCompact; // SMeshVertexCompact vertices
         VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
         MeshBinding m_binding;
         bool m_enabled = false;
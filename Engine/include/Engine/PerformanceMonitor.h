@@ -4,6 +4,13 @@
 #include <deque>
 #include <cstdint>
 #include <string>
+#include <vector>
+
+#include "Engine/Profiler.h"
+#include "Engine/GpuProfiler.h"
+#include "Engine/GpuAllocator.h"
+#include "Engine/MemoryStats.h"
+#include "Engine/Telemetry.h"
 
 namespace Engine
 {
@@ -15,7 +22,8 @@ namespace Engine
      * @brief Performance monitoring system that tracks and displays real-time metrics.
      * 
      * Collects FPS, frame times, draw calls, and system information.
-     * Renders an ImGui-based overlay when enabled.
+     * Renders an ImGui-based overlay when enabled, and feeds Telemetry (frame times every frame;
+     * GPU passes, draw calls and VRAM heaps as a source) for export to an external collector.
      */
     class PerformanceMonitor
     {
@@ -91,9 +99,33 @@ namespace Engine
         uint32_t getResolutionWidth() const;
         uint32_t getResolutionHeight() const;
 
+        /**
+         * @brief CPU scope timings (PERF_SCOPE), depth-first, refreshed every UPDATE_INTERVAL.
+         */
+        const std::vector<CpuProfiler::NodeStats> &getScopeStats() const { return m_scopeStats; }
+
+        /**
+         * @brief GPU timers per render pass (Renderer's GpuProfiler), refreshed every UPDATE_INTERVAL.
+         */
+        const std::vector<GpuProfiler::TimerResult> &getGpuPassStats() const { return m_gpuPassStats; }
+
+        /**
+         * @brief MemoryStats counters and subsystem totals, refreshed every UPDATE_INTERVAL.
+         */
+        const std::vector<MemoryStats::Counter> &getMemoryCounters() const { return m_memoryCounters; }
+        const std::vector<MemoryStats::SubsystemTotal> &getMemoryTotals() const { return m_memoryTotals; }
+
+        /**
+         * @brief Per-heap VRAM budget and usage (VK_EXT_memory_budget when available).
+         */
+        const std::vector<GpuAllocator::HeapBudget> &getHeapBudgets() const { return m_heapBudgets; }
+
     private:
         void updateMetrics();
         void calculatePercentileFPS();
+        void renderScopeBreakdown();
+        void renderGpuPassBreakdown();
+        void renderMemoryBreakdown();
 
     private:
         // References to engine systems
@@ -138,9 +170,23 @@ namespace Engine
         uint32_t m_lastFrameDrawCalls = 0;
         uint32_t m_primitiveCount = 0;
 
+        // CPU scope breakdown (snapshot of CpuProfiler)
+        std::vector<CpuProfiler::NodeStats> m_scopeStats;
+
+        // GPU pass breakdown (copy of the renderer's GpuProfiler results)
+        std::vector<GpuProfiler::TimerResult> m_gpuPassStats;
+
+        // Memory accounting (MemoryStats::collect and the device's GpuAllocator)
+        std::vector<MemoryStats::Counter> m_memoryCounters;
+        std::vector<MemoryStats::SubsystemTotal> m_memoryTotals;
+        std::vector<GpuAllocator::HeapBudget> m_heapBudgets;
+
         // Metrics update interval
         float m_updateTimer = 0.0f;
         static constexpr float UPDATE_INTERVAL = 0.1f; // Update every 100ms
+
+        // Per-frame GPU metrics for Telemetry exports (last: removed before what it reads)
+        Telemetry::Registration m_telemetryReport;
     };
 
     /**
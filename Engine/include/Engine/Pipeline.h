@@ -53,7 +53,7 @@ namespace Engine
     std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
     std::vector<VkPushConstantRange> pushConstantRanges;
 
-    // Optional pipeline cache to accelerate creation (VK_NULL_HANDLE ok)
+    // Optional pipeline cache to accelerate creation (VK_NULL_HANDLE = the engine's PipelineCache)
     VkPipelineCache pipelineCache = VK_NULL_HANDLE;
   };
 
@@ -0,0 +1,25 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <string>
+
+namespace Engine
+{
+    // Engine-wide VkPipelineCache: one per VkDevice, used by every graphics and compute pipeline
+    // (Pipeline::create falls back to it when PipelineCreateInfo::pipelineCache is null).
+    // The cache is seeded from disk on open() and written back on close(), so pipelines compiled
+    // in one run are cheap in the next. A file from another GPU, driver or header version is
+    // ignored. Vulkan pipeline caches are internally synchronized, so get() is usable from any thread.
+    class PipelineCache
+    {
+    public:
+        // Create the cache for 'device', seeded from 'path' when its header matches this device.
+        static void open(VkDevice device, VkPhysicalDevice physicalDevice, const std::string &path);
+
+        // The cache for 'device', or VK_NULL_HANDLE if none was opened (creation then runs uncached).
+        static VkPipelineCache get(VkDevice device);
+
+        // Save to the path given to open() and destroy the cache. VulkanContext calls this
+        // before destroying the device.
+        static void close(VkDevice device);
+    };
+}
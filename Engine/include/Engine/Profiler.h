@@ -0,0 +1,151 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Set to 0 (CMake: -DENGINE_PROFILER=OFF) to compile PERF_SCOPE and PerfScope out.
+#ifndef ENGINE_PROFILER
+#define ENGINE_PROFILER 1
+#endif
+
+namespace Engine
+{
+    // ============================================================
+    // CpuProfiler
+    // ============================================================
+    // Hierarchical CPU scope timing.
+    // - Scopes nest per thread into one global tree; a node is (parent node, name), so
+    //   "FixedUpdate > LocalAvoidanceSystem" is the same node on every thread.
+    // - Each thread accumulates into its own atomic counters: no locks on the hot path
+    //   (only the first visit of a node from a thread takes the registry mutex).
+    // - collectFrame() drains every thread once per frame into a rolling history per node;
+    //   snapshot() turns that into averages and percentiles for the overlay.
+    // - With event capture on, every scope is also kept as a timed event per thread until
+    //   drainEvents() (FrameCapture writes them out as a trace).
+    // Names must outlive the profiler (string literals, IGameplaySystem::name()).
+    class CpuProfiler
+    {
+    public:
+        static constexpr uint32_t kMaxNodes = 512;   // further nodes are dropped
+        static constexpr uint32_t kRootNode = 0;     // implicit parent of top-level scopes
+        static constexpr uint32_t kHistoryFrames = 300;
+
+        struct NodeStats
+        {
+            const char *name = nullptr;
+            uint32_t node = kRootNode;
+            uint32_t parent = kRootNode;
+            uint32_t depth = 0; // 1 for top-level scopes
+            uint32_t calls = 0; // in the last collected frame
+            float lastMs = 0.0f;
+            float avgMs = 0.0f;
+            float p50Ms = 0.0f;
+            float p95Ms = 0.0f;
+            float p99Ms = 0.0f;
+            float maxMs = 0.0f;
+        };
+
+        // One closed scope, for trace export. Times are nowNs() values.
+        struct ScopeEvent
+        {
+            const char *name = nullptr;
+            uint32_t node = kRootNode;
+            uint32_t thread = 0; // registration order of the thread, from 1
+            uint64_t startNs = 0;
+            uint64_t durationNs = 0;
+        };
+
+        // Node of 'name' under 'parent' (created on first use).
+        static uint32_t node(const char *name, uint32_t parent);
+
+        // Innermost open scope of the calling thread (kRootNode outside any scope).
+        static uint32_t currentScope();
+
+        // Scope bookkeeping behind PerfScope. enter() returns the previous current scope.
+        static uint32_t enter(uint32_t node);
+        static void leave(uint32_t node, uint32_t previous, uint64_t startNs, uint64_t elapsedNs);
+
+        // Timestamp base of ScopeEvent (steady clock, nanoseconds).
+        static uint64_t nowNs()
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now().time_since_epoch())
+                                             .count());
+        }
+
+        // Frame boundary: moves every thread's totals into the per-node history.
+        // Call once per frame from one thread (PerformanceMonitor::endFrame does).
+        static void collectFrame();
+
+        // Nodes seen so far in depth-first order (children after their parent) with rolling
+        // statistics over the last kHistoryFrames collected frames.
+        static void snapshot(std::vector<NodeStats> &out);
+
+        // Rolling statistics of one node (avgMs etc. stay 0 for unknown nodes).
+        static NodeStats stats(uint32_t node);
+
+        // Keep closed scopes as events (off by default). Each thread buffers at most
+        // kMaxPendingEvents between drains; older ones are dropped.
+        static constexpr uint32_t kMaxPendingEvents = 1u << 16;
+        static void setEventCapture(bool enabled);
+        static bool eventCapture();
+
+        // Appends and clears every thread's buffered events (unordered across threads).
+        static void drainEvents(std::vector<ScopeEvent> &out);
+
+        // Label of the calling thread in traces (copied), and (thread, label) of all named threads.
+        static void setThreadName(const char *name);
+        static void threadNames(std::vector<std::pair<uint32_t, std::string>> &out);
+    };
+
+    // RAII scope: times its lifetime into the node (name, parent).
+    class PerfScope
+    {
+    public:
+#if ENGINE_PROFILER
+        explicit PerfScope(const char *name)
+            : PerfScope(name, CpuProfiler::currentScope())
+        {
+        }
+
+        PerfScope(const char *name, uint32_t parent)
+            : m_node(CpuProfiler::node(name, parent))
+        {
+            m_previous = CpuProfiler::enter(m_node);
+            m_startNs = CpuProfiler::nowNs();
+        }
+
+        ~PerfScope()
+        {
+            CpuProfiler::leave(m_node, m_previous, m_startNs, CpuProfiler::nowNs() - m_startNs);
+        }
+#else
+        explicit PerfScope(const char *) {}
+        PerfScope(const char *, uint32_t) {}
+#endif
+
+        PerfScope(const PerfScope &) = delete;
+        PerfScope &operator=(const PerfScope &) = delete;
+
+    private:
+#if ENGINE_PROFILER
+        uint32_t m_node = CpuProfiler::kRootNode;
+        uint32_t m_previous = CpuProfiler::kRootNode;
+        uint64_t m_startNs = 0;
+#endif
+    };
+
+} // namespace Engine
+
+#define ENGINE_PERF_CONCAT_(a, b) a##b
+#define ENGINE_PERF_CONCAT(a, b) ENGINE_PERF_CONCAT_(a, b)
+
+#if ENGINE_PROFILER
+// Times the rest of the enclosing block: PERF_SCOPE("Avoidance");
+#define PERF_SCOPE(name) ::Engine::PerfScope ENGINE_PERF_CONCAT(perfScope_, __LINE__)(name)
+#else
+#define PERF_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+/*
+  Random.h
+  --------
+  Purpose:
+    - Seeded random numbers that produce the same sequence on every compiler, standard library
+      and CPU (std::uniform_*_distribution and std::hash are implementation-defined), so lockstep
+      peers that share a seed spawn identical worlds.
+
+  Usage:
+    - Engine::Random rng(Engine::Random::hashString("blue_infantry") ^ scenarioSeed);
+    - float j = rng.uniform(-jitter, jitter);
+
+  Notes:
+    - PCG32 (XSH-RR): 64-bit state, 32-bit output.
+    - uniform() builds floats from the top 24 bits, so it only uses exact float operations.
+*/
+
+#include <cstdint>
+#include <string_view>
+
+namespace Engine
+{
+    class Random
+    {
+    public:
+        explicit Random(uint64_t seed = 0x853c49e6748fea9bull, uint64_t stream = 0xda3e39cb94b95bdbull)
+        {
+            m_inc = (stream << 1u) | 1u;
+            next();
+            m_state += seed;
+            next();
+        }
+
+        uint32_t next()
+        {
+            const uint64_t old = m_state;
+            m_state = old * 6364136223846793005ull + m_inc;
+            const uint32_t xorShifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+            const uint32_t rot = static_cast<uint32_t>(old >> 59u);
+            return (xorShifted >> rot) | (xorShifted << ((32u - rot) & 31u));
+        }
+
+        // [0, 1)
+        float unit() { return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f); }
+
+        // [lo, hi); lo when the range is empty.
+        float uniform(float lo, float hi) { return lo + (hi - lo) * unit(); }
+
+        // [0, bound) without modulo bias; 0 when bound == 0.
+        uint32_t below(uint32_t bound)
+        {
+            if (bound == 0)
+                return 0;
+            const uint32_t threshold = (0u - bound) % bound;
+            for (;;)
+            {
+                const uint32_t r = next();
+                if (r >= threshold)
+                    return r % bound;
+            }
+        }
+
+        // FNV-1a: a portable replacement for std::hash when deriving seeds from names.
+        static uint64_t hashString(std::string_view s)
+        {
+            uint64_t h = 1469598103934665603ull;
+            for (const char c : s)
+            {
+                h ^= static_cast<uint8_t>(c);
+                h *= 1099511628211ull;
+            }
+            return h;
+        }
+
+    private:
+        uint64_t m_state = 0;
+        uint64_t m_inc = 0;
+    };
+}
@@ -1,16 +1,67 @@
 #pragma once
 
 #include <vulkan/vulkan.h>
+#include <atomic>
+#include <chrono>
 #include <vector>
 #include <memory>
 #include <functional>
 #include "Structs/FrameContextStruct.h"
+#include "Engine/GpuAllocator.h"
+#include "Engine/GpuProfiler.h"
+#include "Engine/GpuTimeline.h"
+#include "Engine/HiZPyramid.h"
+#include "Engine/TransientAllocator.h"
+#include "Engine/ViewData.h"
 
 namespace Engine
 {
     class VulkanContext;
+    class Camera;
     class SwapChain;
     class RenderPassModule;
+    namespace ECS
+    {
+        class WorkerPool;
+    }
+    // Latency / power trade-off of frame submission (see Renderer::setFramePacing).
+    struct FramePacing
+    {
+        // MAILBOX and IMMEDIATE present without waiting for vblank (IMMEDIATE may tear); FIFO (vsync) and
+        // FIFO_RELAXED cap the frame rate at the refresh rate. Unsupported modes fall back to FIFO.
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+
+        // Frames the CPU may record ahead of the GPU; clamped to [1, swapchain image count].
+        uint32_t framesInFlight = 2;
+
+        // With VK_KHR_present_wait: a frame starts only once no more than this many earlier presents are
+        // still waiting to reach the screen (1: the previous frame is displayed). 0 disables the wait.
+        uint32_t maxQueuedPresents = 0;
+
+        // CPU frame limiter in frames per second; 0 = uncapped.
+        float maxFps = 0.0f;
+
+        // Shortest input-to-photon path: one frame in flight, wait for each present to be displayed.
+        static FramePacing lowLatency()
+        {
+            FramePacing p;
+            p.presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+            p.framesInFlight = 1;
+            p.maxQueuedPresents = 1;
+            return p;
+        }
+
+        // Vsync, optionally capped below the refresh rate, so the GPU idles between frames.
+        static FramePacing powerSaving(float maxFps = 0.0f)
+        {
+            FramePacing p;
+            p.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+            p.framesInFlight = 2;
+            p.maxFps = maxFps;
+            return p;
+        }
+    };
+
     // Renderer: owns the main on-screen VkRenderPass, per-swapchain VkFramebuffer objects,
     // and per-frame command pools/buffers and synchronization objects. It calls registered
     // RenderPassModule::record() while the main render pass is active.
@@ -29,11 +80,46 @@ namespace Engine
         // Destroy all renderer resources. Waits for device idle internally.
         void cleanup();
 
-        // Per-frame draw: acquire, record main render pass, submit, present
+        // Window resize: recreate the swapchain (handing over the old one) and only what depends on
+        // its extent - depth images and framebuffers. The render pass, pipelines and module resources
+        // survive (viewport/scissor are dynamic); modules get onResize(). If the image format or count
+        // changed, modules are rebuilt as well and false is returned: the main render pass was
+        // replaced, so anything else built against it (ImGui) must be recreated by the caller.
+        bool resize(VkExtent2D extent);
+
+        // Apply present mode / frames in flight (swapchain and frame slots are recreated only when they
+        // change) and the pacing waits. Call with no drawFrame() running. Returns false when the
+        // main render pass was replaced, as resize() does.
+        bool setFramePacing(const FramePacing &pacing);
+        const FramePacing &getFramePacing() const { return m_pacing; }
+
+        // Block until the pacing allows the next frame to begin: the present wait, then the frame
+        // limiter. Call on the main thread with no drawFrame() running, ideally right before input
+        // is sampled so the wait does not add latency to it.
+        void waitForFrameStart();
+
+        // Camera of the frame (not owned). snapshotFrame() sets its aspect to the swapchain's and
+        // freezes its ViewData; drawFrame() uploads that once and hands it to every module through
+        // FrameContext::view / viewBuffer. Null leaves both unset.
+        void setCamera(Camera *camera) { m_camera = camera; }
+
+        // Per-frame draw: acquire, record main render pass, submit, present.
+        // Safe to call from a render thread while the main thread simulates the next frame,
+        // as long as snapshotFrame() ran on the main thread beforehand.
         void drawFrame();
 
-        // Register a RenderPassModule to be invoked each frame. If init() was already called,
-        // the module's onCreate(...) will be invoked immediately so it can allocate resources.
+        // Record each RenderPassModule into its own secondary command buffer, spread over 'pool'
+        // (executed in registration order with vkCmdExecuteCommands). Null records inline into the
+        // primary buffer. With a pool, modules' record() must be safe to run concurrently.
+        void setRecordWorkerPool(ECS::WorkerPool *pool) { m_recordPool = pool; }
+
+        // Freeze the state the next drawFrame() consumes: creates passes registered since the
+        // last snapshot and calls RenderPassModule::onFrameSnapshot(). Call with no drawFrame() running.
+        void snapshotFrame();
+
+        // Register a RenderPassModule to be invoked each frame. Before init() the module is created
+        // by init(); afterwards its onCreate(...) runs at the next snapshotFrame(), so registering
+        // from simulation code never races a frame that is being recorded.
         void registerPass(std::shared_ptr<RenderPassModule> pass);
 
         // Create the main render pass that targets the swapchain (implementation helper).
@@ -45,12 +131,39 @@ namespace Engine
         VkRenderPass getMainRenderPass() const { return m_mainRenderPass; }
         VkExtent2D getExtent() const { return m_extent; }
 
+        // Optional depth-only pass ahead of the main render pass: modules draw opaque occluders in
+        // RenderPassModule::recordDepthPrePass(), a Hi-Z pyramid is built from the result for
+        // RenderPassModule::recordOcclusionCull(), and the main pass loads that depth instead of
+        // clearing it, so hidden fragments are rejected before shading. Off by default. Call with no
+        // drawFrame() running; only the depth targets are recreated, pipelines and modules survive.
+        void setDepthPrePass(bool enabled);
+        bool depthPrePassEnabled() const { return m_depthPrePassEnabled; }
+
+        // Graphics queue timeline: every frame submission signals the next value (see FrameContext).
+        // Null without VK_KHR_timeline_semaphore, in which case frames are fenced.
+        GpuTimeline *getTimeline() { return m_timeline.valid() ? &m_timeline : nullptr; }
+
+        // Compute queue timeline, signalled by each frame's async compute submission. Null without
+        // VulkanContext::HasAsyncCompute(); RenderPassModule::recordAsyncCompute is not called then.
+        GpuTimeline *getComputeTimeline() { return m_computeTimeline.valid() ? &m_computeTimeline : nullptr; }
+
+        // Make the next frame's submission wait GPU-side until 'timeline' (another queue's, e.g. an
+        // upload or async compute timeline) reaches 'value' at 'stage'. Takes effect at the next
+        // snapshotFrame(). Returns false without timeline support: the caller must wait on the CPU.
+        bool addFrameWait(VkSemaphore timeline, uint64_t value, VkPipelineStageFlags stage);
+
         // Set a callback for rendering ImGui (called after all render pass modules)
         using ImGuiRenderCallback = std::function<void(VkCommandBuffer)>;
         void setImGuiRenderCallback(ImGuiRenderCallback callback) { m_imguiRenderCallback = callback; }
 
         // Get the last measured GPU frame time in milliseconds
-        float getGpuTimeMs() const { return m_gpuTimeMs; }
+        float getGpuTimeMs() const { return m_gpuTimeMs.load(std::memory_order_relaxed); }
+
+        // Per-pass GPU timers ("Frame", "Pre-pass", "Depth pre-pass", "Hi-Z", one per
+        // RenderPassModule::debugName(), "ImGui" and any timers modules add through
+        // FrameContext::gpuProfiler), m_maxFrames frames old.
+        std::vector<GpuProfiler::TimerResult> getGpuPassTimings() const { return m_gpuProfiler.results(); }
+        const GpuProfiler &getGpuProfiler() const { return m_gpuProfiler; }
 
     private:
         VulkanContext *m_ctx = nullptr;
@@ -62,6 +175,13 @@ namespace Engine
         uint32_t m_maxFrames = 2;
         bool m_initialized = false;
 
+        // Frame pacing (see setFramePacing)
+        FramePacing m_pacing;
+        PFN_vkWaitForPresentKHR m_waitForPresent = nullptr; // null without VK_KHR_present_wait
+        uint64_t m_presentId = 0;                           // id of the last vkQueuePresentKHR
+        uint64_t m_firstPresentIdOfSwapchain = 1;           // ids below belong to a retired swapchain
+        std::chrono::steady_clock::time_point m_nextFrameStart{};
+
         // Main render-pass and per-swapchain framebuffers
         VkRenderPass m_mainRenderPass = VK_NULL_HANDLE;
         std::vector<VkFramebuffer> m_framebuffers;
@@ -71,31 +191,79 @@ namespace Engine
         // Depth attachment resources (one per swapchain image)
         VkFormat m_depthFormat = VK_FORMAT_UNDEFINED;
         std::vector<VkImage> m_depthImages;
-        std::vector<VkDeviceMemory> m_depthMemories;
+        std::vector<GpuAllocation> m_depthAllocations;
         std::vector<VkImageView> m_depthImageViews;
 
+        // Depth pre-pass (see setDepthPrePass); the render passes exist only while it is enabled.
+        bool m_depthPrePassEnabled = false;
+        VkRenderPass m_depthPrePass = VK_NULL_HANDLE;            // depth only, cleared and stored
+        VkRenderPass m_mainRenderPassLoadDepth = VK_NULL_HANDLE; // m_mainRenderPass loading the depth
+        std::vector<VkFramebuffer> m_depthFramebuffers;          // per swapchain image
+        std::vector<VkImageView> m_depthSampleViews;             // depth aspect only; empty: no Hi-Z
+        HiZPyramid m_hiZ;
+
         std::vector<FrameContext> m_frames;
         uint32_t m_currentFrame = 0;
 
         // Registered render-pass modules that will record into the main render pass.
         std::vector<std::shared_ptr<RenderPassModule>> m_passes;
+        std::vector<std::shared_ptr<RenderPassModule>> m_pendingPasses; // registered after init(), created in snapshotFrame()
+
+        // Graphics timeline and cross-queue waits of the next submission (see addFrameWait)
+        GpuTimeline m_timeline;
+        GpuTimeline m_computeTimeline; // async compute submissions (see getComputeTimeline)
+        VkQueue m_computeQueue = VK_NULL_HANDLE;
+        struct TimelineWait
+        {
+            VkSemaphore semaphore = VK_NULL_HANDLE;
+            uint64_t value = 0;
+            VkPipelineStageFlags stage = 0;
+        };
+        std::vector<TimelineWait> m_pendingWaits; // added since the last snapshot
+        std::vector<TimelineWait> m_frameWaits;   // consumed by the next drawFrame()
+        std::vector<VkSemaphore> m_submitWaitSemaphores; // per-frame scratch of drawFrame()
+        std::vector<VkPipelineStageFlags> m_submitWaitStages;
+        std::vector<uint64_t> m_submitWaitValues;
 
         // Optional ImGui render callback
         ImGuiRenderCallback m_imguiRenderCallback;
 
-        // GPU timestamp query support
-        VkQueryPool m_timestampQueryPool = VK_NULL_HANDLE;
-        float m_timestampPeriod = 1.0f;  // Nanoseconds per timestamp tick
-        float m_gpuTimeMs = 0.0f;        // Last measured GPU time in milliseconds
-        bool m_timestampsSupported = false;
+        // Parallel secondary recording (see setRecordWorkerPool)
+        ECS::WorkerPool *m_recordPool = nullptr; // not owned
+        std::vector<VkCommandBuffer> m_secondaryOrder; // per-frame scratch, pass order + ImGui
+
+        // Per-frame transient buffers (FrameContext::transient), one slot per frame in flight
+        TransientAllocator m_transient;
+
+        // Frame camera and the ViewData frozen by snapshotFrame()
+        Camera *m_camera = nullptr; // not owned
+        ViewData m_view;
+        bool m_hasView = false;
+
+        // GPU timestamp / pipeline statistics queries
+        GpuProfiler m_gpuProfiler;
+        std::atomic<float> m_gpuTimeMs{0.0f}; // Last measured GPU time in milliseconds (written by drawFrame)
 
     private:
         // Create semaphores and fences for each frame slot (called during init).
         void createSyncObjects();
 
+        // 'frames' limited to [1, swapchain image count]: modules keep one resource set per image.
+        uint32_t clampFramesInFlight(uint32_t frames) const;
+
         // Create per-frame command pools and allocate one primary command buffer per frame.
         void createCommandPoolsAndBuffers();
 
+        // Grow frame.secondarySlots to 'slotCount' pools and reset them for this frame.
+        void prepareSecondarySlots(FrameContext &frame, uint32_t slotCount);
+
+        // Record every pass's recordAsyncCompute() and submit it to the compute queue; returns true if
+        // anything was submitted (the graphics submission must then wait for frame.computeTimelineValue).
+        bool submitAsyncCompute(FrameContext &frame);
+
+        // Record all passes (+ ImGui) into secondary buffers on m_recordPool; fills m_secondaryOrder.
+        void recordPassesParallel(FrameContext &frame, VkFramebuffer framebuffer);
+
         // Destroy helpers
         void destroySyncObjects();
         void destroyCommandPoolsAndBuffers();
@@ -104,12 +272,31 @@ namespace Engine
         void createDepthResources();
         void destroyDepthResources();
 
-        // Swapchain-dependent recreate helper
-        void recreateSwapchainDependent();
+        // Main render pass; loadDepth keeps the attachment's contents (compatible with the clearing one).
+        VkRenderPass buildMainRenderPass(bool loadDepth) const;
+
+        // Depth pre-pass helpers: render passes, framebuffers, sample views and the Hi-Z pyramid.
+        // keepPasses: only destroy what depends on the swapchain images.
+        void createDepthPrePassResources();
+        void destroyDepthPrePassResources(bool keepPasses);
+
+        // Depth pre-pass, Hi-Z build and occlusion culling of one frame (primary buffer, before the main pass).
+        void recordDepthPrePass(FrameContext &frame, uint32_t imageIndex);
+
+        // Swapchain-dependent recreate helper (see resize); returns true if the render pass was kept.
+        bool recreateSwapchainDependent();
 
         // GPU timestamp helpers
         void createTimestampQueryPool();
         void destroyTimestampQueryPool();
+
+        // Transient ring (one slot per frame in flight); recreated with the frame slots.
+        void createTransientBuffers();
+        // Write this frame's GpuViewData into the ring and point the FrameContext at it.
+        void uploadView(FrameContext &frame);
+
+        // Render pass modules' record() with a GPU timer (and statistics) around it.
+        void recordPassTimed(RenderPassModule &pass, FrameContext &frame, VkCommandBuffer cmd);
     };
 
     class RenderPassModule
@@ -128,5 +315,51 @@ namespace Engine
 
         // Called to destroy any device resources owned by this module (pipelines, layouts, shaders, descriptors, etc.)
         virtual void onDestroy(VulkanContext &ctx) = 0;
+
+        // Label of this module's GPU timer in the profiler; must stay valid while the module exists.
+        virtual const char *debugName() const { return "RenderPass"; }
+
+        // Called on the main thread before each frame is handed to record(), while no frame is being
+        // recorded. Copy here anything record() reads that the simulation keeps changing (camera,
+        // per-instance data), so the next simulation step can overlap with recording.
+        virtual void onFrameSnapshot() {}
+
+        // Record compute work that depends only on host-written data (culling, pose evaluation) into the
+        // async compute command buffer. Called before any recordPrePass(), in registration order, and only
+        // when FrameContext::computeCommandBuffer exists. The frame's graphics work waits for the whole
+        // submission, so results need no cross-queue barriers (buffers are shared by both families).
+        // frameCtx.gpuProfiler is null here: GPU timers live on the graphics queue. Return true if
+        // anything was recorded; work not done here belongs in recordPrePass().
+        virtual bool recordAsyncCompute(FrameContext &frameCtx, VkCommandBuffer cmd)
+        {
+            (void)frameCtx;
+            (void)cmd;
+            return false;
+        }
+
+        // Record work that must run outside the main render pass, before it begins (compute culling,
+        // buffer fills). Called on the primary command buffer for every pass, in registration order.
+        virtual void recordPrePass(FrameContext &frameCtx, VkCommandBuffer cmd)
+        {
+            (void)frameCtx;
+            (void)cmd;
+        }
+
+        // Renderer::setDepthPrePass: draw opaque occluders depth-only (no color attachment) into
+        // frameCtx.depthPrePass, after every recordPrePass(). The main pass starts from this depth, so
+        // whatever is drawn here must be drawn again in record() with a LESS_OR_EQUAL depth test.
+        virtual void recordDepthPrePass(FrameContext &frameCtx, VkCommandBuffer cmd)
+        {
+            (void)frameCtx;
+            (void)cmd;
+        }
+
+        // Called once the Hi-Z pyramid of the depth pre-pass is built (only when frameCtx.hiZView is
+        // set), outside any render pass: occlusion culling dispatches for the main pass's draws.
+        virtual void recordOcclusionCull(FrameContext &frameCtx, VkCommandBuffer cmd)
+        {
+            (void)frameCtx;
+            (void)cmd;
+        }
     };
 }
\ No newline at end of file
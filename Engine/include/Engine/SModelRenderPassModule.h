@@ -1,21 +1,60 @@
 #pragma once
 #include "Engine/Renderer.h"
-#include "Engine/Pipeline.h"
 #include "assets/AssetManager.h"
-#include "assets/TextureAsset.h"
 #include "Engine/Camera.h"
+#include "Engine/Frustum.h"
+#include "Engine/GpuInstanceCuller.h"
+#include "Engine/GpuPoseEvaluator.h"
+#include "Engine/SModelRenderer.h"
+#include "Engine/MemoryStats.h"
 #include <vulkan/vulkan.h>
 #include <vector>
-#include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <string>
 
 namespace Engine
 {
 
     // RenderPassModule to render a cooked .smodel (ModelAsset) without node graph.
     // Draws all primitives at identity transform (or a caller-provided model matrix).
+    // Modules on the same render pass share pipelines, descriptor layouts, the camera UBO and
+    // material sets through SModelRenderer; instance buffers and palettes stay per module.
     class SModelRenderPassModule : public RenderPassModule
     {
     public:
+        // Per-instance vertex data layout; selects smodel.vert or smodel_compact.vert.
+        //  Matrix:  one glm::mat4 world per instance (64 bytes).
+        //  Compact: CompactInstance (32 bytes): translation, uniform scale and yaw about +Y.
+        enum class InstanceFormat
+        {
+            Matrix,
+            Compact
+        };
+
+        struct CompactInstance
+        {
+            glm::vec3 position{0.0f};
+            float scale = 1.0f;
+            float yawSin = 0.0f;
+            float yawCos = 1.0f;
+            float paletteSlot = 0.0f; // written by the module
+            float _pad = 0.0f;
+        };
+        static_assert(sizeof(CompactInstance) == 32, "CompactInstance must match smodel_compact.vert instance inputs");
+
+        // Where the per-frame instance and palette data lives (chosen in onCreate()):
+        //  HostVisible: host-visible system memory, read by the GPU over the bus (default).
+        //  ReBar:       host-visible device-local memory (resizable BAR), written directly.
+        //  Staged:      the host-visible buffers are a per-frame staging ring copied into
+        //               device-local buffers with vkCmdCopyBuffer in recordPrePass().
+        enum class UploadPath
+        {
+            HostVisible,
+            ReBar,
+            Staged
+        };
+
         SModelRenderPassModule() = default;
         ~SModelRenderPassModule() override;
 
@@ -34,89 +73,148 @@ namespace Engine
 
         void setCamera(Camera *cam) { m_camera = cam; }
 
+        // Label of this pass in the GPU profiler (default "SModel"; same labels are summed).
+        // Set before registerPass(): the render thread reads it.
+        void setDebugName(std::string name) { m_debugName = std::move(name); }
+        const char *debugName() const override { return m_debugName.c_str(); }
+
+        // Must be set before onCreate() (i.e. before the pass is registered). Either setInstances()
+        // overload works with either format; records are converted on upload if they differ
+        // (matrices to Compact keep only translation, uniform scale and yaw).
+        void setInstanceFormat(InstanceFormat format) { m_instanceFormat = format; }
+        InstanceFormat instanceFormat() const { return m_instanceFormat; }
+
         // Per-instance world transforms for instanced drawing.
         // If not called (or count==0), the module defaults to drawing 1 instance at identity.
         void setInstances(const glm::mat4 *instanceWorlds, uint32_t count);
+        void setInstances(const CompactInstance *instances, uint32_t count);
 
-        // Per-instance node global matrices, flattened as [instance][node].
-        // Must be called when using per-entity animation (palette indexed by gl_InstanceIndex).
-        void setNodePalette(const glm::mat4 *nodeGlobals, uint32_t instanceCount, uint32_t nodeCount);
+        // Node global matrices per palette slot, flattened as [slot][node].
+        // Must be called when using per-entity animation. Without setPaletteSlots() there is one slot
+        // per instance (slot == instance index).
+        void setNodePalette(const glm::mat4 *nodeGlobals, uint32_t paletteCount, uint32_t nodeCount);
 
-        // Per-instance joint matrices, flattened as [instance][joint].
+        // Joint matrices per palette slot, flattened as [slot][joint].
         // Joint indices in the vertex stream are local to a skin; the shader uses push constants
         // to offset into this global joint palette.
-        void setJointPalette(const glm::mat4 *jointMatrices, uint32_t instanceCount, uint32_t jointCount);
+        void setJointPalette(const glm::mat4 *jointMatrices, uint32_t paletteCount, uint32_t jointCount);
+
+        // Palette slot of each instance, so instances sharing a pose share one palette entry.
+        // Ignored unless count matches setInstances(); slots must be < the palette count.
+        // The slot travels in instance world [0][3], so instance worlds must be affine.
+        void setPaletteSlots(const uint32_t *slots, uint32_t count);
 
         // Column-major 4x4 matrix (16 floats). Defaults to identity.
         void setModelMatrix(const float *m16);
 
+        // Bounding sphere of the model in instance space (xyz center, w radius; w = 0 if the model has
+        // no bounds): cooked bounds through the model matrix, padded for animation.
+        glm::vec4 instanceBoundingSphere() const;
+
+        // Per-instance LOD selection for primitives with cooked LODs: each instance draws the coarsest
+        // level whose error projects to at most this many pixels (default 1). 0 always draws LOD 0.
+        // Instances are grouped by level in the instance buffer; with GPU culling the whole batch
+        // uses the finest level any instance needs.
+        void setLodPixelError(float pixels) { m_lodPixelError = pixels; }
+
+        // Frustum-cull instances in a compute pre-pass and draw the survivors with indirect draws.
+        // Falls back to drawing every instance when the cull shaders are unavailable.
+        void setGpuCulling(bool enabled) { m_gpuCulling = enabled; }
+
+        // With the renderer's depth pre-pass (Renderer::setDepthPrePass): an occluder draws its OPAQUE
+        // primitives into the pre-pass (large, near geometry: buildings, terrain props); every other
+        // GPU-culled module additionally drops instances behind that depth (setOcclusionCulling, on by
+        // default). Occluders themselves are only frustum-culled.
+        void setOccluder(bool occluder) { m_occluder = occluder; }
+        void setOcclusionCulling(bool enabled) { m_occlusionCulling = enabled; }
+
+        // Keep instance/palette data in device-local memory: ReBar when the driver exposes a large
+        // host-visible device-local heap, otherwise Staged. Must be set before onCreate().
+        void setDeviceLocalUploads(bool enabled) { m_deviceLocalUploads = enabled; }
+        UploadPath uploadPath() const { return m_uploadPath; }
+
+        // Build the node/joint palettes on the GPU from the model's baked clips instead of uploading
+        // setNodePalette()/setJointPalette(). Needs one setInstanceAnimation() entry per instance;
+        // otherwise (or without the pose shader / baked clips) the CPU palettes are used.
+        void setGpuPoses(bool enabled) { m_gpuPoses = enabled; }
+        void setInstanceAnimation(const GpuInstanceAnimation *states, uint32_t count);
+        bool gpuPosesAvailable() const { return m_poseEvaluator.ready(); }
+
         void onCreate(VulkanContext &ctx, VkRenderPass pass, const std::vector<VkFramebuffer> &fbs) override;
         void record(FrameContext &frameCtx, VkCommandBuffer cmd) override;
         void onResize(VulkanContext &ctx, VkExtent2D newExtent) override;
         void onDestroy(VulkanContext &ctx) override;
+        void onFrameSnapshot() override;
+        void recordPrePass(FrameContext &frameCtx, VkCommandBuffer cmd) override;
+        // Pose and cull dispatches on the async compute queue (not for UploadPath::Staged, whose
+        // copies run on the graphics queue first); recordPrePass() then only queues the draws.
+        bool recordAsyncCompute(FrameContext &frameCtx, VkCommandBuffer cmd) override;
+        void recordDepthPrePass(FrameContext &frameCtx, VkCommandBuffer cmd) override;
+        // The cull deferred by recordDispatches() until the Hi-Z pyramid exists.
+        void recordOcclusionCull(FrameContext &frameCtx, VkCommandBuffer cmd) override;
 
     private:
-        struct InstanceFrame
+        // Everything record() reads that the setters above change. Copied in onFrameSnapshot()
+        // so the simulation can keep calling setters while a pipelined frame is recorded.
+        struct RecordState
         {
-            VkBuffer buffer = VK_NULL_HANDLE;
-            VkDeviceMemory memory = VK_NULL_HANDLE;
-            void *mapped = nullptr;
-            uint32_t capacity = 0;
+            bool enabled = true;
+            ViewData view; // the camera's, as is (matrices and frustum are not rebuilt per module)
+            glm::mat4 model{1.0f};
+            std::vector<glm::mat4> instanceWorlds;
+            std::vector<CompactInstance> compactInstances; // used when instanceWorlds is empty
+            std::vector<uint32_t> paletteSlots; // empty: slot == instance index
+            uint32_t paletteCount = 0;
+            std::vector<glm::mat4> nodePalette;
+            std::vector<glm::mat4> jointPalette;
+            uint32_t jointPaletteJointCount = 0;
+            bool gpuCulling = false;
+            bool occluder = false;
+            bool occlusionCulling = true;
+            bool gpuPoses = false;
+            std::vector<GpuInstanceAnimation> instanceAnimation;
+            float lodPixelError = 1.0f;
         };
 
-        struct PushConstantsModel
+        // Device-local copy of a host-visible buffer (UploadPath::Staged only).
+        struct DeviceMirror
         {
-            float model[16];
-            float baseColorFactor[4];
-            float materialParams[4]; // x=alphaCutoff, y=alphaMode, z/w unused
-
-            // Which node is being drawn; vertex shader fetches from palette[gl_InstanceIndex][nodeIndex]
-            uint32_t nodeIndex = 0;
-            uint32_t nodeCount = 0;
-
-            // Pad to match GLSL uvec4 nodeInfo
-            uint32_t _pad0 = 0;
-            uint32_t _pad1 = 0;
-
-            // Skinning info:
-            // - skinBaseJoint: base offset into joint palette for this primitive's skin
-            // - skinJointCount: number of joints in this skin (0 => unskinned)
-            // - jointPaletteStride: total joint count for this model (used to stride per instance)
-            // - flags: reserved
-            uint32_t skinBaseJoint = 0;
-            uint32_t skinJointCount = 0;
-            uint32_t jointPaletteStride = 0;
-            uint32_t flags = 0;
+            VkBuffer buffer = VK_NULL_HANDLE;
+            GpuAllocation allocation;
+            VkDeviceSize size = 0;
         };
 
-        static_assert(sizeof(PushConstantsModel) == 128, "PushConstantsModel must match smodel.vert push constant block size");
-        static_assert(offsetof(PushConstantsModel, nodeIndex) == 96, "PushConstantsModel::nodeIndex offset must match GLSL");
-
-        struct CameraUBO
+        struct InstanceFrame
         {
-            glm::mat4 view;
-            glm::mat4 proj;
+            VkBuffer buffer = VK_NULL_HANDLE;
+            GpuAllocation allocation;
+            void *mapped = nullptr;
+            uint32_t capacity = 0;
+            DeviceMirror device;
         };
 
+        using PushConstantsModel = SModelRenderer::PushConstants;
+
+        // Set 0 for one frame: the shared camera UBO plus this module's palettes.
         struct CameraFrame
         {
-            VkBuffer buffer = VK_NULL_HANDLE;
-            VkDeviceMemory memory = VK_NULL_HANDLE;
             VkDescriptorSet set = VK_NULL_HANDLE;
 
             VkBuffer paletteBuffer = VK_NULL_HANDLE;
-            VkDeviceMemory paletteMemory = VK_NULL_HANDLE;
+            GpuAllocation paletteAllocation;
             void *paletteMapped = nullptr;
             uint32_t paletteCapacityMatrices = 0;
 
             VkBuffer jointPaletteBuffer = VK_NULL_HANDLE;
-            VkDeviceMemory jointPaletteMemory = VK_NULL_HANDLE;
+            GpuAllocation jointPaletteAllocation;
             void *jointPaletteMapped = nullptr;
             uint32_t jointPaletteCapacityMatrices = 0;
+
+            DeviceMirror paletteDevice;
+            DeviceMirror jointPaletteDevice;
         };
 
         void destroyResources();
-        void createPipelines(VulkanContext &ctx, VkRenderPass pass);
         bool refreshModelMatrix();
         bool createCameraResources(VulkanContext &ctx, size_t frameCount);
         void destroyCameraResources();
@@ -126,12 +224,50 @@ namespace Engine
         bool createInstanceResources(VulkanContext &ctx, size_t frameCount);
         void destroyInstanceResources();
         bool ensureInstanceCapacity(InstanceFrame &frame, uint32_t needed);
-
-        bool createMaterialResources(VulkanContext &ctx);
-        void destroyMaterialResources();
-        VkDescriptorSet getOrCreateMaterialSet(MaterialHandle h, const MaterialAsset *mat);
-
-        VkPipelineColorBlendStateCreateInfo makeBlendState(bool enableBlend, VkPipelineColorBlendAttachmentState &outAttachment) const;
+        VkDeviceSize instanceStride() const;
+        uint32_t recordInstanceCount() const; // instances in m_record (0: none set)
+
+        // Write this frame's instance buffer and palettes from m_record (the camera is m_shared's).
+        // writePalettes=false: palettes come from m_poseEvaluator (one slot per instance).
+        bool uploadFrameData(uint32_t frameIndex, ModelAsset &model, bool writePalettes = true);
+        // Grow this frame's buffers for m_record before draws referencing them are queued, so a
+        // later uploadFrameData() never swaps a buffer or rewrites a descriptor set.
+        bool reserveFrameData(uint32_t frameIndex, const ModelAsset &model);
+
+        // Reset the per-frame flags and get the model ready for dispatches/draws (buffers reserved,
+        // LODs selected); null if nothing is drawn this frame.
+        ModelAsset *beginFrame(FrameContext &frameCtx);
+        // Pose/cull compute dispatches and the uploads they (or the staged copy) depend on. With a Hi-Z
+        // pyramid this frame the cull is only prepared here and dispatched by recordOcclusionCull().
+        void recordDispatches(FrameContext &frameCtx, VkCommandBuffer cmd, ModelAsset &model, bool asyncQueue = false);
+        // Assign m_record's instances to LOD levels (m_lodOrder / m_lodFirst) before they are uploaded.
+        // batch: one level for all instances, kept in order (GPU culling compacts them itself).
+        void selectLods(const ModelAsset &model, bool batch);
+        // Mip streaming feedback: the nearest instance's on-screen size for every material of the model.
+        void reportScreenSizes(const ModelAsset &model);
+        // Queue this frame's primitives on m_shared, enumerated like buildIndirectCommands().
+        void queueDraws(uint32_t frameIndex, ModelAsset &model);
+        // View-space z of the instances' bounds centers (BLEND ordering across modules).
+        float batchViewDepth(const ModelAsset &model) const;
+
+        // UploadPath::Staged: copy what uploadFrameData() wrote into the device-local mirrors.
+        UploadPath selectUploadPath() const;
+        bool copyToDevice(VkCommandBuffer cmd, uint32_t frameIndex, bool palettes);
+        // Host buffers are allocated with m_hostBufferProps and persistently mapped.
+        bool createHostBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer, GpuAllocation &allocation, void *&mapped);
+        void destroyHostBuffer(VkBuffer &buffer, GpuAllocation &allocation, void *&mapped);
+        bool ensureMirror(DeviceMirror &mirror, VkDeviceSize size, VkBufferUsageFlags usage);
+        void destroyMirror(DeviceMirror &mirror);
+        // Refresh the byte counts MemoryStats reads (render thread, after buffers may have grown).
+        void publishMemoryUsage();
+        void bindPalettes(CameraFrame &frame, VkBuffer nodes, VkBuffer joints);
+
+        // Buffers the GPU reads this frame (mirrors when staged).
+        VkBuffer gpuInstanceBuffer(const InstanceFrame &frame) const;
+        VkBuffer gpuPaletteBuffer(const CameraFrame &frame) const;
+        VkBuffer gpuJointPaletteBuffer(const CameraFrame &frame) const;
+        bool isDrawable(const ModelPrimitive &prim, uint32_t pass) const;
+        void buildIndirectCommands(ModelAsset &model);
 
     private:
         VkDevice m_device = VK_NULL_HANDLE;
@@ -140,36 +276,78 @@ namespace Engine
 
         AssetManager *m_assets = nullptr;
         ModelHandle m_model{};
+        std::string m_debugName = "SModel";
         Camera *m_camera = nullptr;
 
         bool m_enabled = true;
 
-        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
-        Pipeline m_pipelineOpaque;
-        Pipeline m_pipelineMask;
-        Pipeline m_pipelineBlend;
+        // Pipelines, layouts, camera UBO and material sets, shared with every module on this render pass.
+        std::shared_ptr<SModelRenderer> m_shared;
 
-        VkDescriptorSetLayout m_cameraSetLayout = VK_NULL_HANDLE;
         VkDescriptorPool m_cameraPool = VK_NULL_HANDLE;
         std::vector<CameraFrame> m_cameraFrames;
 
-        VkDescriptorSetLayout m_materialSetLayout = VK_NULL_HANDLE;
-        VkDescriptorPool m_materialPool = VK_NULL_HANDLE;
-        std::unordered_map<uint64_t, VkDescriptorSet> m_materialSetCache;
-
         std::vector<InstanceFrame> m_instanceFrames;
+        InstanceFormat m_instanceFormat = InstanceFormat::Matrix;
         std::vector<glm::mat4> m_instanceWorlds;
+        std::vector<CompactInstance> m_compactInstances;
+        std::vector<uint32_t> m_paletteSlots;
 
         // Flattened node globals uploaded to a per-frame SSBO
         std::vector<glm::mat4> m_nodePalette;
         std::vector<glm::mat4> m_jointPalette;
         uint32_t m_jointPaletteJointCount = 0;
-        uint32_t m_paletteInstanceCount = 0;
+        uint32_t m_paletteCount = 0;
         uint32_t m_paletteNodeCount = 0;
 
-        TextureAsset m_fallbackWhiteTexture;
-
         PushConstantsModel m_pc{};
+
+        RecordState m_record;
+
+        // Levels 0..kMaxLods; bucket l is upload positions [m_lodFirst[l], m_lodFirst[l + 1]).
+        static constexpr uint32_t kLodLevels = ModelPrimitive::kMaxLods + 1;
+        float m_lodPixelError = 1.0f;
+        std::vector<uint32_t> m_lodOrder; // upload position -> instance index; empty: identity
+        uint32_t m_lodFirst[kLodLevels + 1]{};
+        uint32_t m_lodBatchLevel = 0; // level of the GPU-culled draws
+        std::vector<uint8_t> m_lodScratch; // per-instance level
+
+        bool m_gpuCulling = false;
+        GpuInstanceCuller m_culler;
+        bool m_occluder = false;
+        bool m_occlusionCulling = true;
+        std::vector<VkDrawIndexedIndirectCommand> m_indirectCommands; // draw order of record()
+
+        bool m_deviceLocalUploads = false;
+        UploadPath m_uploadPath = UploadPath::HostVisible;
+        VkMemoryPropertyFlags m_hostBufferProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        // Bytes written by the last uploadFrameData() (copied by copyToDevice()).
+        VkDeviceSize m_uploadedInstanceBytes = 0;
+        VkDeviceSize m_uploadedPaletteBytes = 0;
+        VkDeviceSize m_uploadedJointBytes = 0;
+
+        bool m_gpuPoses = false;
+        GpuPoseEvaluator m_poseEvaluator;
+        std::vector<GpuInstanceAnimation> m_instanceAnimation;
+
+        // Set by recordPrePass() for the frame record() is about to draw.
+        bool m_frameUploaded = false;
+        bool m_cullActive = false;
+        bool m_poseActive = false;
+        // m_culler was prepared; recordOcclusionCull() dispatches it with m_cullSphere.
+        bool m_cullDeferred = false;
+        glm::vec4 m_cullSphere{0.0f};
+        // Draws were queued but the host buffers are written in record() (not staged).
+        bool m_uploadPending = false;
+        // Model whose dispatches recordAsyncCompute() recorded this frame (null: recordPrePass() does it).
+        ModelAsset *m_asyncModel = nullptr;
+
+        // Instance / node palette / joint palette buffer bytes, host + device mirrors.
+        std::atomic<uint64_t> m_instanceBytes{0};
+        std::atomic<uint64_t> m_paletteBytes{0};
+        std::atomic<uint64_t> m_jointPaletteBytes{0};
+        MemoryStats::Registration m_memoryReport; // last: removed before the counters it reads
     };
 
 } // namespace Engine
@@ -0,0 +1,287 @@
+#pragma once
+#include "Engine/Pipeline.h"
+#include "Engine/GpuAllocator.h"
+#include "assets/Handles.h"
+#include "assets/TextureAsset.h"
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Engine
+{
+    class VulkanContext;
+    class AssetManager;
+    class MaterialAsset;
+    class SModelRenderPassModule;
+
+    // Resources shared by every SModelRenderPassModule drawing into the same render pass:
+    // - descriptor set layouts (set 0: camera UBO + node/joint palettes, set 1: material)
+    // - the pipeline layout and the OPAQUE/MASK/BLEND pipelines, per instance format, vertex layout and
+    //   skinned/unskinned; each is a specialization of the smodel shaders (vertex: kQuantizedVertices,
+    //   kSkinned; fragment: kAlphaMode), so no draw pays for a branch its primitive never takes
+    // - one camera UBO per frame in flight, written once per frame
+    // - material bindings: with VK_EXT_descriptor_indexing (and shaders/smodel_bindless.frag.spv) one
+    //   set holding every texture plus a material SSBO indexed from push constants; otherwise one
+    //   descriptor set per material handle. Both fall back to a white texture.
+    // - the merged draw list: every module queues its primitives in recordPrePass() and the first
+    //   attached module records them all in one pass, sorted by pipeline, material and mesh, with
+    //   BLEND primitives ordered back to front across models
+    // - depth-only OPAQUE pipelines for the renderer's depth pre-pass (Renderer::setDepthPrePass)
+    // Modules acquire() it in onCreate() and drop the reference in onDestroy(); the last one
+    // destroys it. Modules sharing a renderer must draw with the same camera.
+    class SModelRenderer
+    {
+    public:
+        struct CameraUBO
+        {
+            glm::mat4 view;
+            glm::mat4 proj;
+        };
+
+        // Push constant block of smodel.vert / smodel.frag.
+        struct PushConstants
+        {
+            float model[16];
+            float baseColorFactor[4];
+            float materialParams[2]; // x=alphaCutoff, y=alphaMode
+
+            // Quantized vertices: the mesh AABB as six halves (min.xyz, extent.xyz), two per word;
+            // the last pair is quantBox2. Written by setQuantizationBox().
+            uint32_t quantBox[2] = {0, 0};
+
+            // Which node is being drawn; vertex shader fetches from palette[gl_InstanceIndex][nodeIndex]
+            uint32_t nodeIndex = 0;
+            uint32_t nodeCount = 0;
+
+            // Rest of GLSL uvec4 nodeInfo; materialIndex is read by smodel_bindless.frag
+            uint32_t materialIndex = 0;
+            uint32_t quantBox2 = 0;
+
+            // Skinning info:
+            // - skinBaseJoint: base offset into joint palette for this primitive's skin
+            // - skinJointCount: number of joints in this skin (0 => unskinned)
+            // - jointPaletteStride: total joint count for this model (used to stride per instance)
+            // - flags: reserved
+            uint32_t skinBaseJoint = 0;
+            uint32_t skinJointCount = 0;
+            uint32_t jointPaletteStride = 0;
+            uint32_t flags = 0;
+
+            void setQuantizationBox(const float aabbMin[3], const float aabbMax[3]);
+        };
+
+        static_assert(sizeof(PushConstants) == 128, "PushConstants must match smodel.vert push constant block size");
+        static_assert(offsetof(PushConstants, nodeIndex) == 96, "PushConstants::nodeIndex offset must match GLSL");
+
+        // One primitive of one module, drawn for all of the module's instances.
+        struct DrawItem
+        {
+            PushConstants pc{};
+            VkDescriptorSet frameSet = VK_NULL_HANDLE;
+            VkDescriptorSet materialSet = VK_NULL_HANDLE; // null: keep whatever is bound
+            VkBuffer instanceBuffer = VK_NULL_HANDLE;
+            VkBuffer vertexBuffer = VK_NULL_HANDLE;
+            VkBuffer indexBuffer = VK_NULL_HANDLE;
+            VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+            uint32_t indexCount = 0;
+            uint32_t firstIndex = 0;
+            int32_t vertexOffset = 0;
+            uint32_t instanceCount = 1;
+            uint32_t firstInstance = 0;
+            VkBuffer indirectBuffer = VK_NULL_HANDLE; // set: GPU-culled, one command at indirectOffset
+            VkDeviceSize indirectOffset = 0;
+            uint64_t material = 0; // MaterialHandle id, sort key
+            uint32_t alphaMode = 0;
+            bool compactInstances = false;
+            bool quantizedVertices = false; // smodel::SModelVertexQuantized mesh
+            bool skinned = false;           // pc.skinJointCount > 0: the kSkinned vertex variant
+            float viewDepth = 0.0f; // BLEND: view-space z of the module's instances, drawn far to near
+            bool depthPrePass = false; // OPAQUE occluder: also drawn by recordDepthDraws()
+        };
+
+        // The renderer for (device, pass), created on first use. Also builds the pipelines for the
+        // requested instance format if no module used it yet.
+        static std::shared_ptr<SModelRenderer> acquire(VulkanContext &ctx, VkRenderPass pass,
+                                                       uint32_t frameCount, bool compactInstances);
+
+        // Use acquire(); public for std::make_shared.
+        SModelRenderer(VulkanContext &ctx, VkRenderPass pass, uint32_t frameCount);
+        ~SModelRenderer();
+        SModelRenderer(const SModelRenderer &) = delete;
+        SModelRenderer &operator=(const SModelRenderer &) = delete;
+
+        VkDescriptorSetLayout frameSetLayout() const { return m_frameSetLayout; }
+        VkDescriptorSetLayout materialSetLayout() const { return m_materialSetLayout; }
+        VkPipelineLayout pipelineLayout() const { return m_pipelineLayout; }
+
+        // alphaMode: 0=OPAQUE, 1=MASK, 2=BLEND (glTF order)
+        const Pipeline &pipeline(bool compactInstances, bool quantizedVertices, bool skinned, uint32_t alphaMode) const;
+
+        // Modules attach in onCreate() order, which is also their recordPrePass()/record() order.
+        void attach(const SModelRenderPassModule *module);
+        void detach(const SModelRenderPassModule *module);
+
+        // Main thread, onFrameSnapshot(): camera for the next frame.
+        void setCamera(const glm::mat4 &view, const glm::mat4 &proj);
+        VkBuffer cameraBuffer(uint32_t frameIndex) const;
+
+        // recordPrePass(), serial: the first attached module uploads the camera and clears the
+        // draw list; every module then queues its draws.
+        void beginPrePass(uint32_t frameIndex, const SModelRenderPassModule *module);
+        // Upload the camera into this frame's UBO once per frame: async compute reads it before
+        // beginPrePass() runs, so a second write from the pre-pass could race that read.
+        void writeCamera(uint32_t frameIndex);
+        void queueDraw(const DrawItem &item)
+        {
+            m_draws.push_back(item);
+            m_drawsSorted = false;
+        }
+
+        // recordDepthPrePass(): like recordDraws(), for the draws flagged depthPrePass, into 'depthPass'
+        // (FrameContext::depthPrePass) with vertex-only pipelines created on first use.
+        void recordDepthDraws(VkCommandBuffer cmd, const SModelRenderPassModule *module, VkExtent2D extent, VkRenderPass depthPass);
+
+        // record(): the first attached module records every queued draw; a no-op for the others.
+        void recordDraws(VkCommandBuffer cmd, const SModelRenderPassModule *module, VkExtent2D extent);
+
+        struct MaterialBinding
+        {
+            VkDescriptorSet set = VK_NULL_HANDLE; // set 1 (the same set for every material when bindless)
+            uint32_t index = 0;                   // PushConstants::materialIndex (bindless only)
+        };
+
+        // Set 1 for 'h' (base color, or the fallback texture). Thread-safe.
+        MaterialBinding material(AssetManager &assets, MaterialHandle h, const MaterialAsset &mat);
+        bool bindless() const { return m_bindless; }
+
+    private:
+        struct Pipelines
+        {
+            Pipeline opaque;
+            Pipeline mask;
+            Pipeline blend;
+            bool created = false;
+        };
+
+        struct DepthPipeline
+        {
+            Pipeline pipeline;
+            bool attempted = false; // created or failed for m_depthPass
+        };
+
+        struct CameraFrame
+        {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            GpuAllocation allocation;
+        };
+
+        // What the draw loop last bound, to skip redundant binds.
+        struct BoundState
+        {
+            const Pipeline *pipeline = nullptr;
+            VkDescriptorSet frameSet = VK_NULL_HANDLE;
+            VkDescriptorSet materialSet = VK_NULL_HANDLE;
+            VkBuffer instances = VK_NULL_HANDLE;
+            VkBuffer vertices = VK_NULL_HANDLE;
+            VkBuffer indices = VK_NULL_HANDLE;
+            VkIndexType indexType = VK_INDEX_TYPE_MAX_ENUM;
+        };
+
+        void createLayouts();
+        void createFallbackTexture(VulkanContext &ctx);
+        void createBindlessResources();
+        VkDescriptorSet legacyMaterialSet(AssetManager &assets, MaterialHandle h, const MaterialAsset &mat);
+        MaterialBinding bindlessMaterial(AssetManager &assets, MaterialHandle h, const MaterialAsset &mat);
+        uint32_t bindlessTextureSlot(TextureHandle h, const TextureAsset &tex, uint32_t version);
+        void createCameraBuffers(uint32_t frameCount);
+        void createPipelines(Pipelines &out, bool compactInstances, bool quantizedVertices, bool skinned);
+        // Null if the depth-only pipeline for 'depthPass' cannot be created (the draw then only
+        // happens in the main pass).
+        const Pipeline *depthPipeline(bool compactInstances, bool quantizedVertices, bool skinned, VkRenderPass depthPass);
+        void destroyDepthPipelines();
+        void sortDraws();
+        void recordDraw(VkCommandBuffer cmd, const DrawItem &d, const Pipeline &pipe, bool bindMaterial, BoundState &bound);
+        bool growMaterialPool();
+
+        VkDevice m_device = VK_NULL_HANDLE;
+        VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+        VkRenderPass m_renderPass = VK_NULL_HANDLE;
+
+        VkDescriptorSetLayout m_frameSetLayout = VK_NULL_HANDLE;
+        VkDescriptorSetLayout m_materialSetLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        Pipelines m_pipelines[2][2][2]; // [compactInstances][quantizedVertices][skinned]
+        DepthPipeline m_depthPipelines[2][2][2];
+        VkRenderPass m_depthPass = VK_NULL_HANDLE; // pass m_depthPipelines were created for
+
+        std::vector<CameraFrame> m_cameraFrames;
+        CameraUBO m_camera{glm::mat4(1.0f), glm::mat4(1.0f)};
+        uint32_t m_cameraWrittenFrame = UINT32_MAX; // frame slot already holding m_camera this frame
+
+        TextureAsset m_fallbackWhiteTexture;
+
+        std::vector<const SModelRenderPassModule *> m_modules;
+        std::vector<DrawItem> m_draws;
+        bool m_drawsSorted = false;
+
+        std::mutex m_materialMutex;
+        std::vector<VkDescriptorPool> m_materialPools; // last one is allocated from
+        struct MaterialSet
+        {
+            VkDescriptorSet set = VK_NULL_HANDLE;
+            uint32_t textureVersion = 0; // AssetManager::textureVersion() the set was written with
+        };
+        std::unordered_map<uint64_t, MaterialSet> m_materialSets;
+        uint32_t m_frameSerial = 0; // frames begun (beginPrePass)
+
+        // Bindless: texture array + material SSBO (GPU layout of smodel_bindless.frag's Material).
+        struct GpuMaterial
+        {
+            float baseColorFactor[4];
+            float alphaCutoff;
+            uint32_t alphaMode;
+            uint32_t textureIndex;
+            uint32_t _pad;
+        };
+        static_assert(sizeof(GpuMaterial) == 32, "GpuMaterial must match smodel_bindless.frag");
+
+        struct BindlessEntry
+        {
+            uint32_t index = 0;
+            bool final = false; // false: base color texture still streaming, re-resolved on use
+            uint32_t textureVersion = 0;
+        };
+
+        struct BindlessTexture
+        {
+            uint32_t slot = 0;
+            uint32_t version = 0;
+        };
+
+        // Slots of replaced texture images, reusable once the frames begun before 'frame' completed
+        struct FreeTextureSlot
+        {
+            uint32_t slot = 0;
+            uint32_t frame = 0;
+        };
+
+        bool m_bindless = false;
+        uint32_t m_maxBindlessTextures = 0;
+        uint32_t m_maxBindlessMaterials = 0;
+        VkDescriptorPool m_bindlessPool = VK_NULL_HANDLE;
+        VkDescriptorSet m_bindlessSet = VK_NULL_HANDLE;
+        VkBuffer m_materialBuffer = VK_NULL_HANDLE;
+        GpuAllocation m_materialAllocation;
+        std::unordered_map<uint64_t, BindlessEntry> m_bindlessMaterials;
+        std::unordered_map<uint64_t, BindlessTexture> m_bindlessTextures;
+        std::deque<FreeTextureSlot> m_freeTextureSlots;
+        uint32_t m_bindlessTextureCount = 0;
+        bool m_bindlessFullWarned = false;
+    };
+}
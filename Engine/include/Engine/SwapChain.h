@@ -23,14 +23,19 @@ namespace Engine
         // Destroy owned Vulkan objects (image views, swapchain). Safe to call multiple times.
         void Cleanup();
 
-        // Recreate the swapchain (e.g., on window resize). Caller should ensure device is idle or use fences.
+        // Recreate the swapchain (e.g., on window resize), passing the current one as oldSwapchain.
+        // Caller should ensure device is idle or use fences.
         void Recreate(VkExtent2D newExtent);
 
+        // Present mode used by the next Init()/Recreate(); FIFO (always supported) is the fallback.
+        void SetPreferredPresentMode(VkPresentModeKHR mode) { m_PreferredPresentMode = mode; }
+
         // Accessors
         VkSwapchainKHR GetSwapchain() const { return m_Swapchain; }
         const std::vector<VkImageView> &GetImageViews() const { return m_ImageViews; }
         VkFormat GetImageFormat() const { return m_ImageFormat; }
         VkExtent2D GetExtent() const { return m_Extent; }
+        VkPresentModeKHR GetPresentMode() const { return m_PresentMode; }
 
     private:
         // internal helpers (similar to previous free functions)
@@ -50,6 +55,8 @@ namespace Engine
         std::vector<VkImageView> m_ImageViews;
         VkFormat m_ImageFormat = VK_FORMAT_UNDEFINED;
         VkExtent2D m_Extent{};
+        VkPresentModeKHR m_PreferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+        VkPresentModeKHR m_PresentMode = VK_PRESENT_MODE_FIFO_KHR;
 
         // Initial extent (window size) provided by VulkanContext when constructing
         VkExtent2D m_InitialExtent{};
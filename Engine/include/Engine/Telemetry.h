@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Engine
+{
+    // ============================================================
+    // Telemetry
+    // ============================================================
+    // Periodic export of runtime metrics to an external collector, for fleet-wide monitoring
+    // (the F1 overlay only shows one instance). Every Config::intervalSeconds, update() gathers:
+    // - frame time quantiles over the frames recorded since the last export (recordFrame()),
+    // - CpuProfiler scope averages and p95 up to Config::maxScopeDepth ("FixedUpdate/Movement"),
+    // - MemoryStats subsystem totals, budgets and over-budget flags,
+    // - whatever registered sources append (GPU passes, archetype entity counts, asset load
+    //   latency, tick stats; see PerformanceMonitor, Application, AssetManager).
+    // The batch is handed to the sinks on a JobSystem background job, so socket and file I/O never
+    // run on the frame. With no sink, recordFrame() and update() return after one atomic load.
+    //
+    // Metric names are lower_snake_case without the prefix; each carries at most one label
+    // besides the instance label. Values are gauges over the last interval (counts are per
+    // interval, not cumulative), so collectors can aggregate instances without rate().
+    //
+    // recordFrame() and update() are main-thread calls. Sources run there too, inside the
+    // registry lock: they must not add or remove sources, and may read main-thread state freely.
+    class Telemetry
+    {
+    public:
+        struct Metric
+        {
+            std::string name;
+            std::string labelKey; // empty: no label
+            std::string labelValue;
+            double value = 0.0;
+        };
+
+        struct Config
+        {
+            float intervalSeconds = 10.0f; // <= 0 disables exporting
+            std::string prefix = "stratosphere";
+            std::string instance;       // "instance" label on every metric (empty: none)
+            uint32_t maxScopeDepth = 3; // deepest CpuProfiler scope exported
+            uint32_t maxArchetypes = 16; // largest archetypes exported by name, the rest as "other"
+            bool frameTimes = true;
+            bool cpuScopes = true;
+            bool memory = true;
+            bool sources = true;
+        };
+
+        struct Batch
+        {
+            uint64_t unixMs = 0;   // wall clock at gather time
+            uint64_t sequence = 0; // 1 for the first batch of the process
+            std::vector<Metric> metrics;
+        };
+
+        // Destination of exported batches. publish() runs on a background worker, one batch at a time.
+        class Sink
+        {
+        public:
+            virtual ~Sink() = default;
+            virtual void publish(const Config &config, const Batch &batch) = 0;
+        };
+
+        using Source = std::function<void(const Config &config, std::vector<Metric> &out)>;
+
+        static void configure(const Config &config);
+        static Config config();
+
+        // Read STRATO_TELEMETRY_STATSD (host:port), STRATO_TELEMETRY_PROMETHEUS_FILE (path),
+        // STRATO_TELEMETRY_INTERVAL (seconds) and STRATO_TELEMETRY_INSTANCE, adding a sink per
+        // destination set. Application and HeadlessApplication call this at construction.
+        static void configureFromEnvironment();
+
+        static void addSink(std::unique_ptr<Sink> sink);
+        // Waits for an in-flight publish first.
+        static void clearSinks();
+
+        // True when there is a sink and a positive interval.
+        static bool enabled();
+
+        // Returns an id for removeSource() (never 0).
+        static uint32_t addSource(Source source);
+        static void removeSource(uint32_t id);
+
+        // Duration of one frame or simulation tick. Main thread.
+        static void recordFrame(float frameMs);
+
+        // Export if the interval has elapsed (and the previous batch is out). Main thread, once per
+        // frame after CpuProfiler::collectFrame().
+        static void update();
+
+        // Wait for an in-flight publish (shutdown, tests).
+        static void flush();
+
+        // Samples (milliseconds) of one interval, reported as "<name>{quantile=...}", "<name>_max"
+        // and "<name>_count". Keeps the first 'capacity' samples; later ones only raise count and max.
+        class Window
+        {
+        public:
+            explicit Window(size_t capacity = 4096) : m_capacity(capacity) {}
+
+            void record(float ms);
+            uint64_t count() const { return m_count; }
+
+            // Append the quantiles, max and count (nothing but a zero count if empty), then clear.
+            void appendAndReset(const std::string &name, std::vector<Metric> &out);
+
+        private:
+            std::vector<float> m_samples;
+            size_t m_capacity;
+            uint64_t m_count = 0;
+            float m_max = 0.0f;
+        };
+
+        // RAII source registration; declare it after anything the source reads.
+        class Registration
+        {
+        public:
+            Registration() = default;
+            explicit Registration(Source source) : m_id(addSource(std::move(source))) {}
+            ~Registration() { reset(); }
+
+            Registration(const Registration &) = delete;
+            Registration &operator=(const Registration &) = delete;
+            Registration(Registration &&other) noexcept : m_id(other.m_id) { other.m_id = 0; }
+            Registration &operator=(Registration &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    m_id = other.m_id;
+                    other.m_id = 0;
+                }
+                return *this;
+            }
+
+            void reset()
+            {
+                if (m_id != 0)
+                    removeSource(m_id);
+                m_id = 0;
+            }
+
+        private:
+            uint32_t m_id = 0;
+        };
+    };
+
+    // StatsD over UDP: one "prefix.name:value|g" line per metric, packed into datagrams of at most
+    // 1432 bytes. With 'tags', labels go out as DogStatsD tags ("|#instance:a,scope:b", understood by
+    // the Datadog agent, Telegraf and statsd_exporter); without, the label value is appended to the
+    // name and the instance is dropped. Address resolution happens once, here.
+    class StatsdSink : public Telemetry::Sink
+    {
+    public:
+        StatsdSink(const std::string &host, uint16_t port, bool tags = true);
+        ~StatsdSink() override;
+        StatsdSink(const StatsdSink &) = delete;
+        StatsdSink &operator=(const StatsdSink &) = delete;
+
+        bool valid() const;
+        void publish(const Telemetry::Config &config, const Telemetry::Batch &batch) override;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> m_Impl;
+        bool m_tags;
+    };
+
+    // Prometheus text exposition format written to 'path' (through a temporary file and a rename,
+    // so readers never see a partial file), for node_exporter's textfile collector or a sidecar
+    // that serves or forwards it.
+    class PrometheusFileSink : public Telemetry::Sink
+    {
+    public:
+        explicit PrometheusFileSink(std::string path) : m_path(std::move(path)) {}
+        void publish(const Telemetry::Config &config, const Telemetry::Batch &batch) override;
+
+    private:
+        std::string m_path;
+    };
+
+} // namespace Engine
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+
+namespace Engine
+{
+    struct TimeStep
+    {
+        float DeltaSeconds = 0.0f;
+
+        // Fixed-step simulation info (Application::SetFixedTimestep, HeadlessApplication::SetTickRate).
+        float FixedDeltaSeconds = 0.0f; // 0 when fixed stepping is disabled
+        uint32_t FixedSteps = 0;        // OnFixedUpdate calls made this frame
+        float Alpha = 1.0f;             // [0,1) progress from the last tick towards the next, for interpolation
+    };
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "Engine/GpuAllocator.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Engine
+{
+    // Memory for data written once per frame and read only by that frame (camera UBOs, instance
+    // streams, small per-draw blocks): one persistently mapped, host-coherent buffer per frame slot,
+    // bump-allocated and rewound when the Renderer starts reusing the slot. Allocating is a single
+    // atomic add, so modules recording in parallel share it without locks, and nothing is mapped,
+    // created or destroyed per frame.
+    //
+    // Offsets are aligned for uniform and storage buffers, so an allocation can back a
+    // *_BUFFER_DYNAMIC descriptor (pass 'offset' as the dynamic offset) or be bound as a vertex /
+    // index buffer at 'offset'. A slot that ran out grows before its next frame; the allocation
+    // that did not fit fails (buffer is null) and the caller skips that one frame's work. Growing
+    // replaces the slot's VkBuffer, which bumps Allocation::bufferVersion: modules that
+    // keep descriptor sets pointing at the buffer rewrite them when the version they wrote changes.
+    //
+    // Owned by the Renderer and handed to modules through FrameContext::transient.
+    class TransientAllocator
+    {
+    public:
+        TransientAllocator() = default;
+        ~TransientAllocator() = default;
+        TransientAllocator(const TransientAllocator &) = delete;
+        TransientAllocator &operator=(const TransientAllocator &) = delete;
+
+        // 'bytesPerFrame' is the initial size of every slot.
+        bool create(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t frameCount, VkDeviceSize bytesPerFrame);
+        // The device must be idle.
+        void destroy();
+        bool valid() const { return !m_frames.empty(); }
+
+        // Renderer, after the slot's previous frame completed: grow the slot if it overflowed, rewind it.
+        void beginFrame(uint32_t frameIndex);
+
+        struct Allocation
+        {
+            VkBuffer buffer = VK_NULL_HANDLE; // null: out of space this frame
+            VkDeviceSize offset = 0;
+            VkDeviceSize size = 0;
+            void *mapped = nullptr;      // host pointer of 'offset'
+            uint32_t bufferVersion = 0;  // changes whenever 'buffer' is a newly created buffer
+
+            explicit operator bool() const { return buffer != VK_NULL_HANDLE; }
+        };
+
+        // Thread-safe. 'alignment' must be a power of two; offsets are also aligned for UBO/SSBO use.
+        Allocation allocate(uint32_t frameIndex, VkDeviceSize size, VkDeviceSize alignment = 16);
+
+        // Bytes handed out in the slot's current frame, and the slot's capacity.
+        VkDeviceSize used(uint32_t frameIndex) const;
+        VkDeviceSize capacity(uint32_t frameIndex) const;
+
+    private:
+        struct Frame
+        {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            GpuAllocation allocation;
+            VkDeviceSize capacity = 0;
+            uint32_t version = 0;
+            std::atomic<VkDeviceSize> cursor{0};
+            std::atomic<VkDeviceSize> requested{0}; // bytes asked for this frame, including failures
+        };
+
+        bool createFrameBuffer(Frame &frame, VkDeviceSize capacity);
+
+        VkDevice m_device = VK_NULL_HANDLE;
+        VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+        VkDeviceSize m_minAlignment = 16;
+        uint32_t m_nextVersion = 1;
+        std::vector<std::unique_ptr<Frame>> m_frames; // atomics are not movable
+    };
+}
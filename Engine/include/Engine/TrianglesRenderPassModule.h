@@ -54,6 +54,7 @@ namespace Engine
         void record(FrameContext &frameCtx, VkCommandBuffer cmd) override;
         void onResize(VulkanContext &ctx, VkExtent2D newExtent) override;
         void onDestroy(VulkanContext &ctx) override;
+        const char *debugName() const override { return "Triangles"; }
 
     private:
         void destroyResources();
@@ -0,0 +1,67 @@
+#pragma once
+/*
+  ViewData.h
+  ----------
+  Purpose:
+    - Everything derived from a Camera that a frame needs: view / projection matrices, their product,
+      the frustum planes and the camera position. Camera keeps one up to date (Camera::GetViewData()),
+      so passes, CPU culling, GPU culling and picking share one set of matrices and one frustum
+      instead of each rebuilding them.
+    - GpuViewData is its std140 image; the Renderer uploads it once per frame
+      (FrameContext::viewBuffer) for passes that bind it as a uniform buffer.
+
+  Usage:
+    - const Engine::ViewData &v = camera.GetViewData();
+    - if (!v.frustum.intersectsSphere(center, radius)) continue;
+    - float d2 = v.distanceSq(center); // sort / LOD keys relative to the camera
+
+  Notes:
+    - The projection is Vulkan-style (Y flipped, depth 0..1), like Camera::GetProjectionMatrix().
+*/
+
+#include "Engine/Frustum.h"
+
+#include <glm/glm.hpp>
+
+namespace Engine
+{
+    struct ViewData
+    {
+        glm::mat4 view{1.0f};
+        glm::mat4 proj{1.0f};
+        glm::mat4 viewProj{1.0f};
+        glm::vec3 position{0.0f};
+        glm::vec3 forward{0.0f, 0.0f, -1.0f};
+        Frustum frustum;
+
+        // Squared distance from the camera, the key for front-to-back / back-to-front sorting.
+        float distanceSq(const glm::vec3 &p) const
+        {
+            const glm::vec3 d = p - position;
+            return glm::dot(d, d);
+        }
+    };
+
+    // Uniform block layout of ViewData; a shader may declare any prefix of it.
+    struct GpuViewData
+    {
+        glm::mat4 view;
+        glm::mat4 proj;
+        glm::mat4 viewProj;
+        glm::vec4 position; // xyz
+        glm::vec4 planes[Frustum::Count];
+
+        static GpuViewData from(const ViewData &v)
+        {
+            GpuViewData g{};
+            g.view = v.view;
+            g.proj = v.proj;
+            g.viewProj = v.viewProj;
+            g.position = glm::vec4(v.position, 1.0f);
+            for (int i = 0; i < Frustum::Count; ++i)
+                g.planes[i] = v.frustum.planes[i];
+            return g;
+        }
+    };
+    static_assert(sizeof(GpuViewData) == 304, "GpuViewData must match the shaders' ViewData block");
+}
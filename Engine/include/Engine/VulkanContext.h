@@ -4,6 +4,7 @@
 #include <optional>
 #include <vector>
 #include <memory>
+#include <mutex>
 
 namespace Engine
 {
@@ -25,6 +26,38 @@ namespace Engine
         VkQueue GetPresentQueue() const { return m_PresentQueue; }
         VkInstance GetInstance() const { return m_Instance; }
         uint32_t GetGraphicsQueueFamilyIndex() const { return m_SelectedDeviceInfo.queueFamilyIndices.graphicsFamily.value(); }
+
+        // Queue used for asset streaming uploads. Prefers a transfer-only family, then a second
+        // graphics queue; on devices with neither it aliases the graphics queue (TransferQueueIsShared()).
+        VkQueue GetTransferQueue() const { return m_TransferQueue; }
+        uint32_t GetTransferQueueFamilyIndex() const { return m_TransferFamily; }
+        bool TransferQueueIsShared() const { return m_TransferQueue == m_GraphicsQueue; }
+
+        // Dedicated compute queue (a compute family without graphics) that overlaps the graphics queue.
+        // Null when the device has none or lacks timeline semaphores; compute then stays on graphics.
+        bool HasAsyncCompute() const { return m_AsyncCompute; }
+        VkQueue GetComputeQueue() const { return m_ComputeQueue; }
+        uint32_t GetComputeQueueFamilyIndex() const { return m_ComputeFamily; }
+
+        // Held around vkQueueSubmit/vkQueuePresentKHR on queues that may be shared between threads.
+        std::mutex &GetQueueMutex() { return m_QueueMutex; }
+
+        // VK_KHR_timeline_semaphore was enabled on the device.
+        bool SupportsTimelineSemaphores() const { return m_TimelineSemaphores; }
+        // pipelineStatisticsQuery was enabled (per-pass VS/FS invocation counts in the profiler).
+        bool SupportsPipelineStatistics() const { return m_PipelineStatistics; }
+        // VK_EXT_memory_budget was enabled (GpuAllocator::heapBudgets() reports driver numbers).
+        bool SupportsMemoryBudget() const { return m_MemoryBudget; }
+        // VK_KHR_present_id + VK_KHR_present_wait were enabled (Renderer frame pacing can wait for display).
+        bool SupportsPresentWait() const { return m_PresentWait; }
+        // multiDrawIndirect / drawIndirectFirstInstance were enabled (several indirect draws per call,
+        // indirect commands with firstInstance != 0).
+        bool SupportsMultiDrawIndirect() const { return m_MultiDrawIndirect; }
+        bool SupportsDrawIndirectFirstInstance() const { return m_DrawIndirectFirstInstance; }
+        // VK_KHR_draw_indirect_count was enabled (load vkCmdDrawIndexedIndirectCountKHR with vkGetDeviceProcAddr).
+        bool SupportsDrawIndirectCount() const { return m_DrawIndirectCount; }
+        // Size of the bindless texture array VK_EXT_descriptor_indexing allows (0: not enabled).
+        uint32_t GetMaxBindlessTextures() const { return m_MaxBindlessTextures; }
         SwapChain *GetSwapChain() const { return m_SwapChain.get(); }
 
     private:
@@ -41,6 +74,11 @@ namespace Engine
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device) const;
 
         void createLogicalDevice();
+        void pickTransferQueueFamily();
+        void pickComputeQueueFamily();
+        bool deviceSupportsExtension(const char *name) const;
+        bool queryBindlessSupport();
+        bool queryPresentWaitSupport();
 
         bool checkValidationLayerSupport();
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
@@ -60,6 +98,23 @@ namespace Engine
         VkDevice m_Device = VK_NULL_HANDLE;       // logical device
         VkQueue m_GraphicsQueue = VK_NULL_HANDLE; // graphics queue handle
         VkQueue m_PresentQueue = VK_NULL_HANDLE;
+        VkQueue m_TransferQueue = VK_NULL_HANDLE;
+        uint32_t m_TransferFamily = 0;
+        uint32_t m_TransferQueueIndex = 0;
+        VkQueue m_ComputeQueue = VK_NULL_HANDLE;
+        uint32_t m_ComputeFamily = 0;
+        uint32_t m_ComputeQueueIndex = 0;
+        bool m_AsyncCompute = false;
+        bool m_TimelineSemaphores = false;
+        bool m_PipelineStatistics = false;
+        bool m_MemoryBudget = false;
+        bool m_PresentWait = false;
+        bool m_PhysicalDeviceProperties2 = false;
+        bool m_MultiDrawIndirect = false;
+        bool m_DrawIndirectFirstInstance = false;
+        bool m_DrawIndirectCount = false;
+        uint32_t m_MaxBindlessTextures = 0;
+        std::mutex m_QueueMutex;
 
         std::unique_ptr<SwapChain> m_SwapChain;
     };
@@ -1,5 +1,15 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include <vector>
+
+namespace Engine
+{
+    class GpuProfiler;
+    class GpuTimeline;
+    class TransientAllocator;
+    struct ViewData;
+}
+
 // Per-frame resources (one slot per in-flight frame)
 struct FrameContext
 {
@@ -9,4 +19,49 @@ struct FrameContext
     VkSemaphore renderFinishedSemaphore = VK_NULL_HANDLE;
     VkFence inFlightFence = VK_NULL_HANDLE;
     uint32_t frameIndex = 0;
+
+    // Graphics timeline value this frame's submission signals (0: not submitted yet). With
+    // VK_KHR_timeline_semaphore the slot waits for it instead of inFlightFence, and modules can hand
+    // resources the frame still reads to timeline->deferUntil(timelineValue, ...). Null without it.
+    Engine::GpuTimeline *timeline = nullptr;
+    uint64_t timelineValue = 0;
+
+    // Async compute (VulkanContext::HasAsyncCompute()): a primary buffer submitted to the compute queue
+    // before this frame's graphics work, which waits for it. computeCommandBuffer is null otherwise.
+    VkCommandPool computePool = VK_NULL_HANDLE;
+    VkCommandBuffer computeCommandBuffer = VK_NULL_HANDLE;
+    uint64_t computeTimelineValue = 0; // value of the compute timeline its submission signals
+
+    // Depth pre-pass (Renderer::setDepthPrePass): the depth-only render pass of
+    // RenderPassModule::recordDepthPrePass() (null when disabled) and this frame's Hi-Z pyramid of it
+    // (null when occlusion culling is unavailable). Set before recordAsyncCompute(); the pyramid is
+    // only readable from recordOcclusionCull() on.
+    VkRenderPass depthPrePass = VK_NULL_HANDLE;
+    VkImageView hiZView = VK_NULL_HANDLE;
+    VkSampler hiZSampler = VK_NULL_HANDLE;
+
+    // Per-frame bump allocator for data only this frame reads (camera, instances, per-draw blocks):
+    // transient->allocate(frameIndex, size). Rewound when this slot is reused; never null while recording.
+    Engine::TransientAllocator *transient = nullptr;
+
+    // Renderer::setCamera's view of this frame (null without a camera) and its GpuViewData, written
+    // once into 'transient' at viewOffset (bind viewBuffer as a dynamic uniform buffer; rewrite the
+    // descriptor when viewBufferVersion changes). viewBuffer is null when there is no view.
+    const Engine::ViewData *view = nullptr;
+    VkBuffer viewBuffer = VK_NULL_HANDLE;
+    VkDeviceSize viewOffset = 0;
+    uint32_t viewBufferVersion = 0;
+
+    // GPU timers for this frame (null when timestamps are unsupported). Modules may bracket work in
+    // record()/recordPrePass() with Engine::GpuScope; see GpuProfiler for the nesting rules.
+    Engine::GpuProfiler *gpuProfiler = nullptr;
+
+    // Parallel pass recording: one command pool per recording slot (a VkCommandPool must not be used
+    // from two threads at once). Each slot's secondary buffers are reused after a pool reset.
+    struct SecondarySlot
+    {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> buffers;
+    };
+    std::vector<SecondarySlot> secondarySlots;
 };
\ No newline at end of file
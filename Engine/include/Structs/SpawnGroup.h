@@ -4,6 +4,7 @@ struct SpawnGroupResolved
 {
     std::string id;
     std::string unitType;
+    std::string team; // scenario team name ("Blue", "Red"...); empty: no Team component
     int count = 0;
     float originX = 0.0f;
     float originZ = 0.0f;
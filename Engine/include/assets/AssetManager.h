@@ -5,11 +5,16 @@
 #include <unordered_map>
 #include <memory>
 #include <vector>
+#include <deque>
+#include <mutex>
 
 #include "assets/Handles.h"
+#include "assets/ModelSource.h"
+#include "assets/SlotArray.h"
 
 #include "assets/MeshFormats.h"
 #include "assets/MeshAsset.h"
+#include "assets/GeometryPool.h"
 
 #include "assets/SModelLoader.h"
 #include "assets/ModelFormat.h"
@@ -18,19 +23,28 @@
 #include "assets/MaterialAsset.h"
 #include "assets/ModelAsset.h"
 
+#include "Engine/JobSystem.h"
+#include "Engine/MemoryStats.h"
+#include "Engine/Telemetry.h"
+
 namespace Engine
 {
+    namespace ECS
+    {
+        class WorkerPool;
+    }
+
     // ---------------------------
     // AssetManager
     // ---------------------------
-    class AssetManager
+    class AssetManager : public ModelSource
     {
     public:
         AssetManager(VkDevice device,
                      VkPhysicalDevice phys,
                      VkQueue graphicsQueue,
                      uint32_t graphicsQueueFamilyIndex);
-        ~AssetManager();
+        ~AssetManager() override;
 
         // Existing mesh API
         MeshHandle loadMesh(const std::string &cookedMeshPath);
@@ -39,16 +53,31 @@ namespace Engine
         void addRef(MeshHandle h);
         void release(MeshHandle h);
 
+        // Vertex/index storage shared by every mesh this manager uploads.
+        GeometryPool &geometryPool() { return *m_geometry; }
+
         // New smodel/model API
         ModelHandle loadModel(const std::string &cookedModelPath);
-        ModelAsset *getModel(ModelHandle h);
+
+        // Load several models with one command buffer, one staging arena and one fence wait.
+        // Handles come back in input order (invalid for files that failed).
+        std::vector<ModelHandle> loadModels(const std::vector<std::string> &cookedModelPaths);
+
+        // Decode PNG/JPG textures of loadModel()/loadModels() on this pool (not owned), overlapping
+        // with mesh staging. Without a pool they decode serially on the calling thread.
+        void setDecodeWorkerPool(ECS::WorkerPool *pool) { m_decodePool = pool; }
+
+        // Bake animation clips of models loaded from now on to this many frames per second
+        // (ModelAsset::bakeClips). 0 (default) keeps keyframe sampling.
+        void setAnimationBakeRate(float framesPerSecond) { m_animationBakeRate = framesPerSecond; }
+        ModelAsset *getModel(ModelHandle h) override;
 
         MaterialAsset *getMaterial(MaterialHandle h);
         TextureAsset *getTexture(TextureHandle h);
         TextureHandle loadTextureFromFile(const std::string &filePath);
 
-        void addRef(ModelHandle h);
-        void release(ModelHandle h);
+        void addRef(ModelHandle h) override;
+        void release(ModelHandle h) override;
 
         void addRef(MaterialHandle h);
         void release(MaterialHandle h);
@@ -56,26 +85,207 @@ namespace Engine
         void addRef(TextureHandle h);
         void release(TextureHandle h);
 
-        // Collect all zero-ref assets (and clear caches)
+        // Collect all zero-ref assets (and clear caches). Pending async loads are kept.
         void garbageCollect();
 
+        // ---------------------------
+        // Async streaming
+        // ---------------------------
+        // Uploads go to 'queue' (family 'queueFamilyIndex'), completion is tracked with a timeline
+        // semaphore when 'timelineSemaphores' (VK_KHR_timeline_semaphore enabled), else one fence per
+        // load. Pass 'queueMutex' when the queue is also used by other threads (see
+        // VulkanContext::TransferQueueIsShared). Without this call streaming uses the graphics queue.
+        void setTransferQueue(VkQueue queue, uint32_t queueFamilyIndex, bool timelineSemaphores,
+                              std::mutex *queueMutex = nullptr);
+
+        // Return a handle immediately; file I/O, .smodel parsing and image decode run as background
+        // jobs on the JobSystem, the upload on the transfer queue. The asset appears once updateStreaming() sees it
+        // complete; until then get*() returns nullptr and resolve*() the placeholder.
+        ModelHandle loadModelAsync(const std::string &cookedModelPath) override;
+        TextureHandle loadTextureAsync(const std::string &filePath);
+
+        AssetState modelState(ModelHandle h) const override;
+        AssetState textureState(TextureHandle h) const;
+
+        // Drawn in place of assets that are not Ready (e.g. a unit-sized proxy, a 1x1 grey texture).
+        void setPlaceholderModel(ModelHandle h) { m_placeholderModel = h; }
+        void setPlaceholderTexture(TextureHandle h) { m_placeholderTexture = h; }
+        ModelHandle resolveModel(ModelHandle h);
+        TextureHandle resolveTexture(TextureHandle h);
+
+        // Submit decoded loads and register finished uploads. Call once per frame from the thread
+        // that owns the AssetManager while no frame is being recorded.
+        void updateStreaming();
+
+        uint32_t pendingStreamCount() const { return m_streamPending; }
+
+        // ---------------------------
+        // Residency
+        // ---------------------------
+        // VRAM budget for asset meshes and textures, applied by updateStreaming(). Over budget, models
+        // are evicted in least-recently-used order: unreferenced ones (and their unreferenced
+        // textures) first, then referenced models idle for at least minIdleFrames. An evicted model
+        // keeps its handle; resolveModel() reloads it through the async path and returns the
+        // placeholder until it is Ready again. Use is recorded by resolveModel(), once per
+        // updateStreaming() frame. GPU resources of evicted assets are destroyed retireFrames
+        // updateStreaming() calls later, once no frame in flight can reference them.
+        struct ResidencyPolicy
+        {
+            uint64_t budgetBytes = 0;           // 0: no fixed budget
+            float deviceBudgetFraction = 0.0f;  // > 0: also cap at this share of the device-local heap
+                                                // budget (VK_EXT_memory_budget) left over by non-asset memory
+            uint32_t minIdleFrames = 600;
+            uint32_t retireFrames = 3;
+
+            // Texture mip streaming: > 0 makes textures of async loads resident with only their mip
+            // levels of at most this many texels per side. Finer levels stream in as render passes
+            // report how large their materials are on screen (reportMaterialScreenSize()); over budget
+            // they drop back toward that tail before any referenced model is evicted.
+            uint32_t streamedMipExtent = 0;
+            uint32_t mipStreamJobs = 2; // mip reloads in flight at once
+        };
+        void setResidencyPolicy(const ResidencyPolicy &policy) { m_residency = policy; }
+        const ResidencyPolicy &residencyPolicy() const { return m_residency; }
+
+        // GPU bytes of resident meshes and textures, and models evicted so far (last updateStreaming()).
+        uint64_t residentBytes() const { return m_residentBytes; }
+        uint32_t evictionCount() const { return m_evictionCount; }
+
+        // Any thread (render passes while recording). 'pixels': the largest on-screen extent this
+        // frame of a surface drawn with the material. Each of its textures wants the coarsest level
+        // still at least that large; the request is applied by the next updateStreaming().
+        void reportMaterialScreenSize(MaterialHandle h, float pixels);
+        bool textureStreamingEnabled() const { return m_residency.streamedMipExtent > 0; }
+
+        // Changes whenever the texture's GPU image is replaced (streamed in, other mip levels
+        // resident). Renderers caching its view or sampler re-resolve when it differs.
+        uint32_t textureVersion(TextureHandle h) const;
+
+        // Resident assets and their sizes (also reported to MemoryStats as "Assets").
+        struct MemoryUsage
+        {
+            uint32_t meshCount = 0;
+            uint64_t meshGpuBytes = 0; // vertex + index ranges
+            uint32_t textureCount = 0;
+            uint64_t textureGpuBytes = 0;
+            uint32_t materialCount = 0;
+            uint32_t modelCount = 0;
+            uint64_t modelCpuBytes = 0; // node, skin and animation tables
+        };
+        MemoryUsage memoryUsage() const;
+
     private:
-        MeshHandle createMeshFromData_Internal(const MeshData &data, const std::string &path, uint32_t initialRef);
+        struct StreamJob;
+        struct ModelEntry;
+        struct TextureEntry;
+
+        MeshHandle createMeshFromData_Internal(const MeshDataView &data, const std::string &path, uint32_t initialRef);
+        MeshHandle registerMesh_Internal(std::unique_ptr<MeshAsset> mesh, const std::string &path, uint32_t initialRef);
         TextureHandle createTexture_Internal(std::unique_ptr<TextureAsset> tex, uint32_t initialRef);
         MaterialHandle createMaterial_Internal(std::unique_ptr<MaterialAsset> mat, uint32_t initialRef);
         ModelHandle createModel_Internal(std::unique_ptr<ModelAsset> model, const std::string &path, uint32_t initialRef);
 
+        // Materials, primitives, skins, nodes and animation of a parsed .smodel whose textures and
+        // meshes are already registered. Fills the model's dependency lists (addRef'd).
+        std::unique_ptr<ModelAsset> buildModel_Internal(const smodel::SModelFileView &view,
+                                                        const std::vector<TextureHandle> &textureHandles,
+                                                        const std::vector<MeshHandle> &meshHandles,
+                                                        std::vector<MeshHandle> &outMeshDeps,
+                                                        std::vector<MaterialHandle> &outMaterialDeps);
+
+        // Register uploaded textures/meshes of a parsed .smodel (refCount 0) and build the model.
+        std::unique_ptr<ModelAsset> assembleModel_Internal(const std::string &path,
+                                                           const smodel::SModelFileView &view,
+                                                           std::vector<std::unique_ptr<TextureAsset>> &textures,
+                                                           std::vector<std::unique_ptr<MeshAsset>> &meshes,
+                                                           std::vector<MeshHandle> &outMeshDeps,
+                                                           std::vector<MaterialHandle> &outMaterialDeps);
+
+        void enqueueStreamJob(std::unique_ptr<StreamJob> job);
+        void decodeNextStreamRequest();              // background job
+        static void decodeStreamJob(StreamJob &job); // background job
+        bool submitStreamJob(StreamJob &job);
+        void pollStreamUploads_Internal();
+        void finishStreamJob(StreamJob &job);
+        void failStreamJob(StreamJob &job);
+        void discardStreamJob(StreamJob &job);
+        void shutdownStreaming();
+
+        // Residency (updateStreaming()): budget, LRU eviction, delayed destruction.
+        void updateResidency_Internal();
+        uint64_t residencyBudget_Internal(uint64_t residentBytes) const;
+        uint64_t modelGpuBytes_Internal(const ModelEntry &e);
+        void evictModel_Internal(ModelEntry &e);
+        // Mip streaming: first level of the resident tail, feedback and upgrades within 'budget',
+        // drops toward the tail; true once pending drops bring the projected bytes within 'budget'.
+        uint32_t streamedMipStart_Internal(uint32_t width, uint32_t height, uint32_t levels) const;
+        void streamTextureMips_Internal(uint64_t budget);
+        bool dropTextureMips_Internal(uint64_t budget);
+        void enqueueMipJob_Internal(uint64_t id, TextureEntry &e, uint32_t firstLevel);
+        // Free zero-ref assets; with 'retire' their GPU resources wait in m_retiredAssets.
+        uint64_t collect_Internal(bool retire);
+        void tickRetiredAssets_Internal(bool all);
+
     private:
         VkDevice m_device = VK_NULL_HANDLE;
         VkPhysicalDevice m_phys = VK_NULL_HANDLE;
         VkQueue m_graphicsQueue = VK_NULL_HANDLE;
         uint32_t m_graphicsQueueFamilyIndex = 0;
 
-        // Separate ID spaces
-        uint64_t m_nextMeshID = 1;
-        uint64_t m_nextTextureID = 1;
-        uint64_t m_nextMaterialID = 1;
-        uint64_t m_nextModelID = 1;
+        std::unique_ptr<GeometryPool> m_geometry;
+
+        float m_animationBakeRate = 0.0f;
+        ECS::WorkerPool *m_decodePool = nullptr; // not owned
+
+        // Streaming (main-thread side unless noted)
+        VkQueue m_transferQueue = VK_NULL_HANDLE;
+        uint32_t m_transferQueueFamilyIndex = 0;
+        bool m_transferOnly = false;
+        std::mutex *m_transferQueueMutex = nullptr;
+        VkCommandPool m_streamPool = VK_NULL_HANDLE;
+        VkSemaphore m_streamTimeline = VK_NULL_HANDLE;
+        uint64_t m_streamTimelineValue = 0;
+        PFN_vkGetSemaphoreCounterValueKHR m_getSemaphoreCounterValue = nullptr;
+        std::vector<std::unique_ptr<StreamJob>> m_streamInFlight;
+        uint32_t m_streamPending = 0;
+
+        ModelHandle m_placeholderModel{};
+        TextureHandle m_placeholderTexture{};
+
+        // Background decode hand-off (guarded by m_streamMutex). One JobSystem background job per
+        // request, so decodes run concurrently on the shared workers.
+        JobCounter m_streamJobs;
+        std::mutex m_streamMutex;
+        std::deque<std::unique_ptr<StreamJob>> m_streamRequests;
+        std::vector<std::unique_ptr<StreamJob>> m_streamDecoded;
+        bool m_streamStop = false;
+
+        // Request to Ready of streamed textures and models (evicted reloads included), exported
+        // through Telemetry with the failures of the same interval. Main thread.
+        Telemetry::Window m_loadLatency;
+        uint32_t m_loadFailures = 0;
+
+        // Residency (main thread)
+        ResidencyPolicy m_residency;
+        uint32_t m_residencyFrame = 0;
+        uint64_t m_residentBytes = 0;
+        uint32_t m_evictionCount = 0;
+        uint32_t m_mipJobs = 0; // TextureMips stream jobs in flight
+
+        // Screen-size feedback: material id -> largest extent in pixels (guarded by m_mipFeedbackMutex)
+        std::mutex m_mipFeedbackMutex;
+        std::unordered_map<uint64_t, float> m_mipFeedback;
+        std::unordered_map<uint64_t, float> m_mipFeedbackScratch;
+
+        // Assets dropped while frames may still use them; destroyed when framesLeft reaches 0.
+        struct RetiredAsset
+        {
+            std::unique_ptr<ModelAsset> model;
+            std::unique_ptr<MeshAsset> mesh;
+            std::unique_ptr<TextureAsset> texture;
+            uint32_t framesLeft = 0;
+        };
+        std::vector<RetiredAsset> m_retiredAssets;
 
         // ---------------------------
         // Mesh entries
@@ -96,9 +306,19 @@ namespace Engine
             std::unique_ptr<TextureAsset> asset;
             uint32_t generation = 1;
             uint32_t refCount = 0;
+            AssetState state = AssetState::Ready;
+            uint32_t version = 0; // textureVersion()
+
+            // Where mip streaming reloads levels from (empty: not reloadable)
+            std::string sourcePath;
+            int32_t sourceTexture = -1; // texture record of the .smodel at sourcePath, -1: image file
+
+            uint32_t wantedMip = 0;       // finest level reported at lastWantedFrame
+            uint32_t lastWantedFrame = 0; // m_residencyFrame; 0: never reported
+            uint32_t pendingMip = ~0u;    // first level of the reload in flight
         };
 
-        std::unordered_map<uint64_t, TextureEntry> m_textures;
+        SlotArray<TextureEntry> m_textures;
 
         // ---------------------------
         // Material entries
@@ -113,7 +333,7 @@ namespace Engine
             std::vector<TextureHandle> textureDeps;
         };
 
-        std::unordered_map<uint64_t, MaterialEntry> m_materials;
+        SlotArray<MaterialEntry> m_materials;
 
         // ---------------------------
         // Model entries
@@ -124,17 +344,22 @@ namespace Engine
             uint32_t generation = 1;
             uint32_t refCount = 0;
             std::string path;
+            AssetState state = AssetState::Ready;
+            uint32_t lastUsedFrame = 0; // m_residencyFrame of the last resolveModel()
 
             // Dependencies: meshes + materials used by this model
             std::vector<MeshHandle> meshDeps;
             std::vector<MaterialHandle> materialDeps;
         };
 
-        std::unordered_map<uint64_t, MeshEntry> m_meshes;
+        SlotArray<MeshEntry> m_meshes;
         std::unordered_map<std::string, MeshHandle> m_meshPathCache;
 
-        std::unordered_map<uint64_t, ModelEntry> m_models;
+        SlotArray<ModelEntry> m_models;
         std::unordered_map<std::string, ModelHandle> m_modelPathCache;
+
+        MemoryStats::Registration m_memoryReport; // last: removed before the maps it reads
+        Telemetry::Registration m_telemetryReport; // likewise
     };
 
 } // namespace Engine
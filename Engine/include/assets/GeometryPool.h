@@ -0,0 +1,80 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "Engine/GpuAllocator.h"
+
+namespace Engine
+{
+    // A sub-range of one of the pool's buffers.
+    struct GeometryRange
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        uint32_t block = 0;
+
+        bool valid() const { return buffer != VK_NULL_HANDLE; }
+    };
+
+    // Shared device-local vertex + index storage for every mesh of an AssetManager. Meshes
+    // sub-allocate first-fit from a few large buffers (usable as vertex AND index buffer), so a
+    // scene binds one buffer and addresses meshes through firstIndex / vertexOffset.
+    // Vertex ranges are aligned to their stride and index ranges to the index size, so byte
+    // offsets convert exactly to element offsets. Requests larger than a block get their own
+    // buffer. Thread-safe (the streaming worker allocates while the main thread frees).
+    class GeometryPool
+    {
+    public:
+        static constexpr VkDeviceSize kDefaultBlockSize = 64ull * 1024 * 1024;
+
+        GeometryPool(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize = kDefaultBlockSize);
+        ~GeometryPool();
+        GeometryPool(const GeometryPool &) = delete;
+        GeometryPool &operator=(const GeometryPool &) = delete;
+
+        // Queue families that copy into / draw from new blocks (VK_SHARING_MODE_CONCURRENT when
+        // more than one). Blocks created earlier keep their families and are only used by
+        // uploads whose families they cover.
+        void setQueueFamilies(const std::vector<uint32_t> &families);
+
+        // 'families': the uploading UploadContext's queueFamilies; a new block covers them and the
+        // pool's families.
+        bool allocate(VkDeviceSize size, VkDeviceSize alignment, const std::vector<uint32_t> &families,
+                      GeometryRange &out);
+        void free(GeometryRange &range);
+
+        uint32_t blockCount() const;
+
+    private:
+        struct Range
+        {
+            VkDeviceSize offset = 0;
+            VkDeviceSize size = 0;
+        };
+
+        struct Block
+        {
+            VkBuffer buffer = VK_NULL_HANDLE; // VK_NULL_HANDLE: slot free for reuse
+            GpuAllocation allocation;
+            VkDeviceSize size = 0;
+            uint32_t liveCount = 0;
+            bool dedicated = false;
+            std::vector<uint32_t> families;
+            std::vector<Range> freeRanges; // sorted by offset, coalesced
+        };
+
+        bool allocateFromBlock(uint32_t blockIndex, VkDeviceSize size, VkDeviceSize alignment, GeometryRange &out);
+        bool createBlock(VkDeviceSize size, bool dedicated, const std::vector<uint32_t> &families, uint32_t &outIndex);
+        bool covers(const Block &b, const std::vector<uint32_t> &families) const;
+
+        VkDevice m_device = VK_NULL_HANDLE;
+        VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+        VkDeviceSize m_blockSize = kDefaultBlockSize;
+
+        mutable std::mutex m_mutex;
+        std::vector<uint32_t> m_families;
+        std::vector<Block> m_blocks;
+    };
+}
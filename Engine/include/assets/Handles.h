@@ -30,4 +30,14 @@ namespace Engine
         uint32_t generation = 0;
         bool isValid() const { return id != 0; }
     };
+
+    // Lifecycle of a handle returned by the async load API.
+    enum class AssetState : uint8_t
+    {
+        Missing, // unknown or stale handle
+        Pending, // decoding on the worker / uploading on the transfer queue
+        Ready,
+        Failed,
+        Evicted  // unloaded to meet the VRAM budget; reloads on the next resolve*()
+    };
 }
@@ -0,0 +1,115 @@
+#pragma once
+/*
+  HeadlessAssetManager.h
+  ----------------------
+  Purpose:
+    - Model loading without a graphics device, for dedicated servers, benchmarks and tools
+      (EngineCore target, see Engine/CMakeLists.txt). A .smodel is parsed and turned into a
+      ModelAsset with its primitive ranges, bounds, skins, node hierarchy and animation tables
+      (assets/ModelBuild.h, shared with AssetManager); vertex, index and image data is never read.
+
+  Usage:
+    - HeadlessAssetManager assets;
+      Prefab p = loadPrefabFile(path, ecs.components, ecs.archetypes, &assets);
+    - Once per tick (HeadlessApplication does this): assets.updateStreaming();
+
+  Notes:
+    - Same handle semantics as AssetManager's model API (ModelSource): one reference per load,
+      path-cached, Pending until updateStreaming() publishes the background parse.
+    - Primitive mesh/material handles stay invalid; nothing here can be drawn.
+*/
+
+#include "assets/Handles.h"
+#include "assets/ModelAsset.h"
+#include "assets/ModelSource.h"
+#include "assets/SlotArray.h"
+
+#include "Engine/JobSystem.h"
+#include "Engine/MemoryStats.h"
+#include "Engine/Telemetry.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Engine
+{
+    class HeadlessAssetManager : public ModelSource
+    {
+    public:
+        HeadlessAssetManager();
+        ~HeadlessAssetManager() override; // waits for background loads
+        HeadlessAssetManager(const HeadlessAssetManager &) = delete;
+        HeadlessAssetManager &operator=(const HeadlessAssetManager &) = delete;
+
+        // Parse and build on the calling thread; invalid handle if the file failed.
+        ModelHandle loadModel(const std::string &cookedModelPath);
+
+        // Parse on a JobSystem background worker; Ready after the updateStreaming() that sees it done.
+        ModelHandle loadModelAsync(const std::string &cookedModelPath) override;
+
+        // See AssetManager::setAnimationBakeRate (servers sampling poses for hit tests may bake too).
+        void setAnimationBakeRate(float framesPerSecond) { m_animationBakeRate = framesPerSecond; }
+
+        ModelAsset *getModel(ModelHandle h) override;
+        AssetState modelState(ModelHandle h) const override;
+
+        void addRef(ModelHandle h) override;
+        void release(ModelHandle h) override;
+
+        // Publish finished background loads. Call from the owning thread, e.g. once per tick.
+        void updateStreaming();
+        uint32_t pendingStreamCount() const { return m_streamPending; }
+
+        // Free zero-ref models. Pending loads are kept.
+        void garbageCollect();
+
+        // Also reported to MemoryStats as "Assets".
+        struct MemoryUsage
+        {
+            uint32_t modelCount = 0;
+            uint64_t modelCpuBytes = 0; // node, skin and animation tables
+        };
+        MemoryUsage memoryUsage() const;
+
+    private:
+        struct ModelEntry
+        {
+            std::unique_ptr<ModelAsset> asset;
+            uint32_t generation = 1;
+            uint32_t refCount = 0;
+            std::string path;
+            AssetState state = AssetState::Ready;
+        };
+
+        struct Decoded
+        {
+            uint64_t id = 0;
+            std::unique_ptr<ModelAsset> asset; // null: failed
+            uint64_t requestNs = 0;            // CpuProfiler::nowNs() at loadModelAsync
+        };
+
+        static std::unique_ptr<ModelAsset> buildModel_Internal(const std::string &path, float bakeRate);
+
+        float m_animationBakeRate = 0.0f;
+
+        SlotArray<ModelEntry> m_models;
+        std::unordered_map<std::string, ModelHandle> m_modelPathCache;
+
+        // Background parse hand-off (m_streamDecoded guarded by m_streamMutex)
+        JobCounter m_streamJobs;
+        std::mutex m_streamMutex;
+        std::vector<Decoded> m_streamDecoded;
+        uint32_t m_streamPending = 0;
+
+        // Request to Ready of async loads, exported through Telemetry with the interval's failures
+        Telemetry::Window m_loadLatency;
+        uint32_t m_loadFailures = 0;
+
+        MemoryStats::Registration m_memoryReport; // last: removed before the entries it reads
+        Telemetry::Registration m_telemetryReport; // likewise
+    };
+}
@@ -3,39 +3,73 @@
 #include <cstdint>
 #include "assets/MeshFormats.h"
 #include "utils/BufferUtils.h"
+#include "assets/GeometryPool.h"
 
 namespace Engine
 {
+    struct UploadContext; // forward decl from ImageUtils
 
-    // GPU-backed mesh asset: owns device-local vertex/index buffers and metadata
+    // GPU-backed mesh asset: device-local vertex/index data and metadata. Uploaded with a
+    // GeometryPool the data lives in the pool's shared buffers (draw with getFirstIndex() /
+    // getVertexOffset()); otherwise the mesh owns one buffer of each.
     class MeshAsset
     {
     public:
         MeshAsset() = default;
         ~MeshAsset() = default;
 
-        // Upload MeshData into device-local buffers using staging.
+        // Upload mesh data into device-local buffers using staging (one submit + fence wait).
         // Requires a command pool and queue for the copy operations.
         bool upload(VkDevice device,
                     VkPhysicalDevice phys,
                     VkCommandPool commandPool,
                     VkQueue queue,
-                    const MeshData &data);
+                    const MeshDataView &data,
+                    GeometryPool *pool = nullptr);
 
-        // Destroy GPU resources
+        // Record the staging copies into ctx.cmd instead of submitting (see UploadContext).
+        // Buffers are shared across ctx.queueFamilies; valid for drawing once ctx completed.
+        bool upload_Deferred(UploadContext &ctx, const MeshData &data, GeometryPool *pool = nullptr);
+        bool upload_Deferred(UploadContext &ctx, const MeshDataView &data, GeometryPool *pool = nullptr);
+
+        // Staging arena bytes upload_Deferred() consumes (for ReserveStaging).
+        static VkDeviceSize stagingBytes(const MeshData &data);
+        static VkDeviceSize stagingBytes(const MeshDataView &data);
+
+        // Destroy GPU resources (or return the pool ranges)
         void destroy(VkDevice device);
 
-        // Accessors for rendering
-        VkBuffer getVertexBuffer() const { return m_vb.buffer; }
-        VkBuffer getIndexBuffer() const { return m_ib.buffer; }
+        // Accessors for rendering. Several meshes may share one vertex/index buffer.
+        VkBuffer getVertexBuffer() const { return m_pool ? m_vertexRange.buffer : m_vb.buffer; }
+        VkBuffer getIndexBuffer() const { return m_pool ? m_indexRange.buffer : m_ib.buffer; }
+        uint32_t getFirstIndex() const { return m_firstIndex; }   // of index 0, buffer bound at offset 0
+        int32_t getVertexOffset() const { return m_vertexOffset; } // of vertex 0, buffer bound at offset 0
+        bool isPooled() const { return m_pool != nullptr; }
+        // smodel::SModelVertexQuantized vertices, dequantized over the AABB
+        bool isQuantized() const { return m_quantized; }
+        uint32_t getVertexStride() const { return m_vertexStride; } // 16: .smesh SMeshVertexCompact
         uint32_t getIndexCount() const { return m_indexCount; }
         VkIndexType getIndexType() const { return m_indexType; }
         const float *getAABBMin() const { return m_aabbMin; }
         const float *getAABBMax() const { return m_aabbMax; }
+        // Bytes of vertex + index storage this mesh holds (its pool ranges when pooled)
+        VkDeviceSize gpuBytes() const
+        {
+            return m_pool ? m_vertexRange.size + m_indexRange.size : m_vb.allocation.size + m_ib.allocation.size;
+        }
 
     private:
+        bool uploadPooled(UploadContext &ctx, const MeshDataView &data, GeometryPool &pool);
+
         VertexBufferHandle m_vb{};
         IndexBufferHandle m_ib{};
+        GeometryPool *m_pool = nullptr; // not owned
+        GeometryRange m_vertexRange{};
+        GeometryRange m_indexRange{};
+        uint32_t m_firstIndex = 0;
+        int32_t m_vertexOffset = 0;
+        bool m_quantized = false;
+        uint32_t m_vertexStride = 0;
         uint32_t m_indexCount = 0;
         VkIndexType m_indexType = VK_INDEX_TYPE_UINT32;
         float m_aabbMin[3]{};
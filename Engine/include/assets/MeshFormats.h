@@ -3,6 +3,8 @@
 #include <vector>
 #include <string>
 
+#include "utils/MappedFile.h"
+
 namespace Engine
 {
 
@@ -19,6 +21,55 @@ namespace Engine
         uint32_t indexDataOffset;
     };
 
+    // ------------------------------------------------------------
+    // .smesh v1
+    // ------------------------------------------------------------
+    // [SMeshHeaderV1][vertices][indices], each section 16-byte aligned, so the file is
+    // memory-mapped and its sections go straight into staging (see LoadSMeshFile).
+    constexpr char kSMeshMagic[4] = {'S', 'M', 'S', 'H'};
+    constexpr uint16_t kSMeshVersionMajor = 1;
+    constexpr uint16_t kSMeshVersionMinor = 0;
+    constexpr uint64_t kSMeshSectionAlignment = 16;
+
+    enum SMeshFlags : uint32_t
+    {
+        // SMeshVertexCompact instead of the 32-byte pos3/norm3/uv2 vertex
+        SMESH_VERTEX_COMPACT = 1u << 0,
+    };
+
+    // 16 bytes; every attribute is a format the vertex fetch converts to float, so the same
+    // shader reads both layouts (half4 position, snorm8x4 normal, half2 uv).
+    struct SMeshVertexCompact
+    {
+        uint16_t position[4]; // w = 1.0h
+        int8_t normal[4];     // w = 0
+        uint16_t uv[2];
+    };
+    static_assert(sizeof(SMeshVertexCompact) == 16, "SMeshVertexCompact must be 16 bytes");
+
+    struct SMeshHeaderV1
+    {
+        char magic[4]; // "SMSH"
+        uint16_t versionMajor;
+        uint16_t versionMinor;
+        uint32_t headerSize; // sizeof(SMeshHeaderV1) when written
+        uint32_t flags;      // SMeshFlags
+
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t vertexStride; // 32, or 16 with SMESH_VERTEX_COMPACT
+        uint32_t indexFormat;  // 0=uint16, 1=uint32
+        float aabbMin[3];
+        float aabbMax[3];
+
+        uint64_t vertexDataOffset; // from file start, kSMeshSectionAlignment aligned
+        uint64_t vertexDataSize;
+        uint64_t indexDataOffset;
+        uint64_t indexDataSize;
+        uint64_t fileSizeBytes;
+    };
+    static_assert(sizeof(SMeshHeaderV1) == 96, "SMeshHeaderV1 layout changed");
+
     struct MeshData
     {
         std::vector<uint8_t> vertexBytes; // size = vertexCount * vertexStride
@@ -32,7 +83,62 @@ namespace Engine
         float aabbMax[3]{};
     };
 
+    // Non-owning MeshData: byte ranges point into memory that outlives the upload recording
+    // (e.g. a memory-mapped .smodel), so they go straight into staging without a copy.
+    struct MeshDataView
+    {
+        const void *vertexBytes = nullptr;
+        uint64_t vertexByteSize = 0;
+        const void *indexBytes = nullptr;
+        uint64_t indexByteSize = 0;
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        uint32_t vertexStride = 0;
+        uint32_t indexFormat = 1; // 0=uint16, 1=uint32
+        uint32_t layoutFlags = 0; // smodel::VertexLayoutFlags (0: .smesh layout)
+        float aabbMin[3]{};
+        float aabbMax[3]{};
+    };
+
+    inline MeshDataView MakeMeshDataView(const MeshData &d)
+    {
+        MeshDataView v;
+        v.vertexBytes = d.vertexBytes.data();
+        v.vertexByteSize = d.vertexBytes.size();
+        if (d.indexFormat == 1)
+        {
+            v.indexBytes = d.indices32.data();
+            v.indexByteSize = d.indices32.size() * sizeof(uint32_t);
+        }
+        else
+        {
+            v.indexBytes = d.indices16.data();
+            v.indexByteSize = d.indices16.size() * sizeof(uint16_t);
+        }
+        v.vertexCount = d.vertexCount;
+        v.indexCount = d.indexCount;
+        v.vertexStride = d.vertexStride;
+        v.indexFormat = d.indexFormat;
+        for (int i = 0; i < 3; ++i)
+        {
+            v.aabbMin[i] = d.aabbMin[i];
+            v.aabbMax[i] = d.aabbMax[i];
+        }
+        return v;
+    }
+
     // Returns true on success, fills MeshData
     bool LoadSMeshV0FromFile(const std::string &path, MeshData &out);
 
+    // Mapped .smesh (v1, or a headerless v0 file); 'mesh' points into the mapping.
+    struct SMeshFileView
+    {
+        MappedFile file;                       // owns the mapping
+        const SMeshHeaderV1 *header = nullptr; // null for v0 files
+        MeshDataView mesh;                     // into 'file'
+    };
+
+    // Maps and validates the file. On failure returns false and sets outError.
+    bool LoadSMeshFile(const std::string &path, SMeshFileView &out, std::string &outError);
+
 } // namespace Engine
\ No newline at end of file
@@ -2,13 +2,14 @@
 #include <vector>
 #include <cstdint>
 #include <cmath>
+#include <cstring>
 #include <algorithm>
-#include <functional>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "assets/Handles.h" // MeshHandle, MaterialHandle
 #include "assets/model/SModelAnimationRecords.h"
+#include "assets/model/SModelAnimPacking.h"
 
 namespace Engine
 {
@@ -22,12 +23,26 @@ namespace Engine
         MeshHandle mesh{};
         MaterialHandle material{};
 
+        // Relative to the start of the mesh's vertex/index buffers, which the GeometryPool
+        // shares between meshes (MeshAsset::getFirstIndex / getVertexOffset already added).
         uint32_t firstIndex = 0;
         uint32_t indexCount = 0;
         int32_t vertexOffset = 0;
 
         // Skinning (V4): -1 means unskinned.
         int32_t skinIndex = -1;
+
+        // Simplified index ranges (V4.3), finest first; LOD 0 is firstIndex/indexCount above.
+        // 'error' is the object-space deviation, used to pick a level from projected size.
+        struct Lod
+        {
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            float error = 0.0f;
+        };
+        static constexpr uint32_t kMaxLods = 3;
+        Lod lods[kMaxLods];
+        uint32_t lodCount = 0;
     };
 
     struct ModelAsset
@@ -96,11 +111,36 @@ namespace Engine
         std::vector<NodeTRS> restTRS;     // bind pose derived from localMatrix at load
         std::vector<NodeTRS> animatedTRS; // evaluated each frame
 
+        // Parent-before-child node order (buildNodeOrder()). Nodes not reachable from a root are absent.
+        std::vector<uint32_t> nodeEvalOrder;
+
+        // Per-clip evaluation tables (buildClipTables()): rest-pose local matrices and, per clip,
+        // the distinct nodes its channels animate (clipAnimatedNodes[range.first .. first+count)).
+        struct ClipNodeRange
+        {
+            uint32_t first = 0;
+            uint32_t count = 0;
+        };
+        std::vector<glm::mat4> restLocals;
+        std::vector<ClipNodeRange> clipNodeRanges;
+        std::vector<uint32_t> clipAnimatedNodes;
+
+        // Optional clip bake (bakeClips()): node globals resampled at a fixed rate, so evaluatePoseInto()
+        // becomes an indexed lookup plus a lerp between neighbouring frames. Empty = sample keyframes.
+        struct BakedClip
+        {
+            float sampleRate = 0.0f;         // frames per second
+            uint32_t frameCount = 0;         // frame i is at min(i / sampleRate, duration)
+            std::vector<glm::mat4> globals;  // [frame][node]
+        };
+        std::vector<BakedClip> bakedClips; // parallel to animClips
+
         std::vector<smodel::SModelAnimationClipRecord> animClips;
         std::vector<smodel::SModelAnimationChannelRecord> animChannels;
         std::vector<smodel::SModelAnimationSamplerRecord> animSamplers;
         std::vector<float> animTimes;
         std::vector<float> animValues;
+        std::vector<uint8_t> animPacked; // quantized sampler values (V4.4), see SModelAnimPacking.h
 
         // Optional debug name (string table later)
         const char *debugName = "";
@@ -206,43 +246,208 @@ namespace Engine
             return glm::normalize(glm::slerp(q0, q1, a));
         }
 
-        inline void recomputeGlobals()
+        // Sample one sampler record, float or packed. Returns false (out untouched) when the record's
+        // ranges don't fit the loaded tables.
+        inline bool sampleVec3(const smodel::SModelAnimationSamplerRecord &s, float t, glm::vec3 &out) const
         {
-            const uint32_t nodeCount = static_cast<uint32_t>(nodes.size());
-            if (nodeCount == 0)
-                return;
+            if (s.timeCount == 0 || s.valueType == uint8_t(smodel::SModelAnimValueType::QuatSmallest3) ||
+                size_t(s.firstTime) + s.timeCount > animTimes.size())
+                return false;
+            const float *times = animTimes.data() + s.firstTime;
+
+            if (s.valueType != uint8_t(smodel::SModelAnimValueType::Vec3Quantized))
+            {
+                if (size_t(s.firstValue) + s.valueCount > animValues.size())
+                    return false;
+                out = SampleVec3(times, animValues.data() + s.firstValue, s.timeCount, t);
+                return true;
+            }
+
+            if (size_t(s.firstValue) + s.valueCount > animPacked.size() ||
+                s.valueCount < smodel::animPackedBytes(s.valueType, s.timeCount))
+                return false;
+            const uint8_t *base = animPacked.data() + s.firstValue;
+            smodel::SModelAnimVec3Range range;
+            std::memcpy(&range, base, sizeof(range));
+            const uint8_t *keys = base + sizeof(range);
+
+            float v0[3], v1[3];
+            if (s.timeCount == 1)
+            {
+                smodel::unpackVec3Quantized(keys, range, v0);
+                out = glm::vec3(v0[0], v0[1], v0[2]);
+                return true;
+            }
+            const uint32_t i = FindKeyInterval(times, s.timeCount, t);
+            const float a = ComputeAlpha(times[i], times[i + 1], t);
+            smodel::unpackVec3Quantized(keys + i * smodel::kAnimPackedKeyBytes, range, v0);
+            smodel::unpackVec3Quantized(keys + (i + 1) * smodel::kAnimPackedKeyBytes, range, v1);
+            out = glm::mix(glm::vec3(v0[0], v0[1], v0[2]), glm::vec3(v1[0], v1[1], v1[2]), a);
+            return true;
+        }
+
+        inline bool sampleQuat(const smodel::SModelAnimationSamplerRecord &s, float t, glm::quat &out) const
+        {
+            if (s.timeCount == 0 || s.valueType == uint8_t(smodel::SModelAnimValueType::Vec3Quantized) ||
+                size_t(s.firstTime) + s.timeCount > animTimes.size())
+                return false;
+            const float *times = animTimes.data() + s.firstTime;
+
+            if (s.valueType != uint8_t(smodel::SModelAnimValueType::QuatSmallest3))
+            {
+                if (size_t(s.firstValue) + s.valueCount > animValues.size())
+                    return false;
+                out = SampleQuat(times, animValues.data() + s.firstValue, s.timeCount, t);
+                return true;
+            }
+
+            if (size_t(s.firstValue) + s.valueCount > animPacked.size() ||
+                s.valueCount < smodel::animPackedBytes(s.valueType, s.timeCount))
+                return false;
+            const uint8_t *keys = animPacked.data() + s.firstValue;
+
+            float v0[4], v1[4];
+            if (s.timeCount == 1)
+            {
+                smodel::unpackQuatSmallest3(keys, v0);
+                out = glm::normalize(glm::quat(v0[3], v0[0], v0[1], v0[2]));
+                return true;
+            }
+            const uint32_t i = FindKeyInterval(times, s.timeCount, t);
+            const float a = ComputeAlpha(times[i], times[i + 1], t);
+            smodel::unpackQuatSmallest3(keys + i * smodel::kAnimPackedKeyBytes, v0);
+            smodel::unpackQuatSmallest3(keys + (i + 1) * smodel::kAnimPackedKeyBytes, v1);
+            const glm::quat q0(v0[3], v0[0], v0[1], v0[2]);
+            glm::quat q1(v1[3], v1[0], v1[1], v1[2]);
+            if (glm::dot(q0, q1) < 0.0f)
+                q1 = -q1;
+            out = glm::normalize(glm::slerp(q0, q1, a));
+            return true;
+        }
+
+        // CPU-side bytes held by the node, skin and animation tables (capacity, not size).
+        inline size_t cpuBytes() const
+        {
+            auto bytes = [](const auto &v)
+            { return v.capacity() * sizeof(v[0]); };
+
+            size_t total = bytes(primitives) + bytes(nodes) + bytes(nodePrimitiveIndices) + bytes(nodeChildIndices) +
+                           bytes(skins) + bytes(restTRS) + bytes(animatedTRS) + bytes(nodeEvalOrder) +
+                           bytes(restLocals) + bytes(clipNodeRanges) + bytes(clipAnimatedNodes) + bytes(bakedClips) +
+                           bytes(animClips) + bytes(animChannels) + bytes(animSamplers) + bytes(animTimes) + bytes(animValues) +
+                           bytes(animPacked);
+            for (const ModelSkin &skin : skins)
+                total += bytes(skin.jointNodeIndices) + bytes(skin.inverseBind);
+            for (const BakedClip &clip : bakedClips)
+                total += bytes(clip.globals);
+            return total;
+        }
 
+        // Build nodeEvalOrder: breadth-first from every root along the child lists, so each node
+        // follows its parent. Call once after nodes/nodeChildIndices are filled.
+        inline void buildNodeOrder()
+        {
+            const uint32_t nodeCount = static_cast<uint32_t>(nodes.size());
             const uint32_t U32_MAX = ~0u;
+
+            nodeEvalOrder.clear();
+            nodeEvalOrder.reserve(nodeCount);
             std::vector<uint8_t> visited(nodeCount, 0);
 
-            std::function<void(uint32_t, const glm::mat4 &)> compute = [&](uint32_t nodeIdx, const glm::mat4 &parentGlobal)
+            for (uint32_t i = 0; i < nodeCount; ++i)
             {
-                if (nodeIdx >= nodeCount)
-                    return;
-                if (visited[nodeIdx])
-                    return;
-                visited[nodeIdx] = 1;
+                if (nodes[i].parentIndex != U32_MAX || visited[i])
+                    continue;
 
-                ModelNode &n = nodes[nodeIdx];
-                n.globalMatrix = parentGlobal * n.localMatrix;
+                visited[i] = 1;
+                size_t head = nodeEvalOrder.size();
+                nodeEvalOrder.push_back(i);
+                while (head < nodeEvalOrder.size())
+                {
+                    const ModelNode &n = nodes[nodeEvalOrder[head++]];
+                    if (n.childCount == 0 || n.firstChildIndex == U32_MAX)
+                        continue;
+                    for (uint32_t ci = 0; ci < n.childCount; ++ci)
+                    {
+                        const size_t slot = static_cast<size_t>(n.firstChildIndex) + ci;
+                        if (slot >= nodeChildIndices.size())
+                            break;
+                        const uint32_t child = nodeChildIndices[slot];
+                        if (child >= nodeCount || visited[child])
+                            continue;
+                        visited[child] = 1;
+                        nodeEvalOrder.push_back(child);
+                    }
+                }
+            }
+        }
 
-                if (n.childCount == 0)
-                    return;
-                if (n.firstChildIndex == U32_MAX)
-                    return;
+        // Build restLocals and the per-clip animated node lists. Call after restTRS and the
+        // animation tables are loaded.
+        inline void buildClipTables()
+        {
+            const uint32_t nodeCount = static_cast<uint32_t>(nodes.size());
 
-                const uint32_t start = n.firstChildIndex;
-                for (uint32_t ci = 0; ci < n.childCount; ++ci)
+            restLocals.resize(nodeCount);
+            for (uint32_t i = 0; i < nodeCount; ++i)
+                restLocals[i] = (restTRS.size() == nodes.size()) ? ComposeTRS(restTRS[i]) : glm::mat4(1.0f);
+
+            clipNodeRanges.assign(animClips.size(), ClipNodeRange{});
+            clipAnimatedNodes.clear();
+            std::vector<uint8_t> seen(nodeCount, 0);
+            for (size_t c = 0; c < animClips.size(); ++c)
+            {
+                ClipNodeRange &range = clipNodeRanges[c];
+                range.first = static_cast<uint32_t>(clipAnimatedNodes.size());
+
+                const auto &clip = animClips[c];
+                for (uint32_t ci = 0; ci < clip.channelCount; ++ci)
                 {
-                    const uint32_t child = nodeChildIndices[start + ci];
-                    compute(child, n.globalMatrix);
+                    const uint32_t chIdx = clip.firstChannel + ci;
+                    if (chIdx >= animChannels.size())
+                        break;
+                    const uint32_t node = animChannels[chIdx].targetNode;
+                    if (node >= nodeCount || seen[node])
+                        continue;
+                    seen[node] = 1;
+                    clipAnimatedNodes.push_back(node);
                 }
-            };
+
+                range.count = static_cast<uint32_t>(clipAnimatedNodes.size()) - range.first;
+                for (uint32_t k = range.first; k < range.first + range.count; ++k)
+                    seen[clipAnimatedNodes[k]] = 0;
+            }
+        }
+
+        // globals[i] holds node i's local matrix on entry and its global matrix on return.
+        inline void localsToGlobals(glm::mat4 *globals) const
+        {
+            const uint32_t U32_MAX = ~0u;
+            for (const uint32_t nodeIdx : nodeEvalOrder)
+            {
+                const uint32_t parent = nodes[nodeIdx].parentIndex;
+                if (parent != U32_MAX)
+                    globals[nodeIdx] = globals[parent] * globals[nodeIdx];
+            }
+        }
+
+        inline void recomputeGlobals()
+        {
+            const uint32_t nodeCount = static_cast<uint32_t>(nodes.size());
+            if (nodeCount == 0)
+                return;
+            if (nodeEvalOrder.empty())
+                buildNodeOrder();
 
             for (uint32_t i = 0; i < nodeCount; ++i)
+                nodes[i].globalMatrix = glm::mat4(1.0f);
+
+            // Parents precede children in nodeEvalOrder, so one linear pass suffices.
+            const uint32_t U32_MAX = ~0u;
+            for (const uint32_t nodeIdx : nodeEvalOrder)
             {
-                if (nodes[i].parentIndex == U32_MAX)
-                    compute(i, glm::mat4(1.0f));
+                ModelNode &n = nodes[nodeIdx];
+                n.globalMatrix = (n.parentIndex != U32_MAX) ? nodes[n.parentIndex].globalMatrix * n.localMatrix : n.localMatrix;
             }
         }
 
@@ -305,30 +510,12 @@ namespace Engine
                 if (ch.targetNode >= animatedTRS.size())
                     continue;
 
-                if (s.timeCount == 0)
-                    continue;
-                if (s.firstTime + s.timeCount > animTimes.size())
-                    continue;
-
-                const float *times = animTimes.data() + s.firstTime;
-                const float *values = nullptr;
-                if (s.firstValue + s.valueCount <= animValues.size())
-                    values = animValues.data() + s.firstValue;
-                else
-                    continue;
-
                 if (ch.path == (uint16_t)smodel::SModelAnimPath::Translation)
-                {
-                    animatedTRS[ch.targetNode].t = SampleVec3(times, values, s.timeCount, t);
-                }
+                    sampleVec3(s, t, animatedTRS[ch.targetNode].t);
                 else if (ch.path == (uint16_t)smodel::SModelAnimPath::Scale)
-                {
-                    animatedTRS[ch.targetNode].s = SampleVec3(times, values, s.timeCount, t);
-                }
+                    sampleVec3(s, t, animatedTRS[ch.targetNode].s);
                 else if (ch.path == (uint16_t)smodel::SModelAnimPath::Rotation)
-                {
-                    animatedTRS[ch.targetNode].r = SampleQuat(times, values, s.timeCount, t);
-                }
+                    sampleQuat(s, t, animatedTRS[ch.targetNode].r);
             }
 
             for (size_t i = 0; i < nodes.size(); i++)
@@ -339,38 +526,97 @@ namespace Engine
             recomputeGlobals();
         }
 
+        // Resample every clip to 'sampleRate' frames per second of node globals (memory:
+        // frames * nodes * 64 bytes per clip). Call after buildClipTables(); sampleRate <= 0 clears.
+        inline void bakeClips(float sampleRate)
+        {
+            bakedClips.clear();
+            if (sampleRate <= 0.0f || nodes.empty() || animClips.empty())
+                return;
+
+            const uint32_t nodeCount = static_cast<uint32_t>(nodes.size());
+            std::vector<NodeTRS> trs;
+            std::vector<glm::mat4> globals;
+
+            // Sample the keyframes (bakedClips is empty while baking, so these are exact evaluations).
+            std::vector<BakedClip> baked(animClips.size());
+            for (uint32_t c = 0; c < static_cast<uint32_t>(animClips.size()); ++c)
+            {
+                const float duration = std::max(animClips[c].durationSec, 0.0f);
+                BakedClip &b = baked[c];
+                b.sampleRate = sampleRate;
+                b.frameCount = static_cast<uint32_t>(std::ceil(duration * sampleRate)) + 1u;
+                b.globals.resize(static_cast<size_t>(b.frameCount) * nodeCount);
+                for (uint32_t f = 0; f < b.frameCount; ++f)
+                {
+                    const float t = std::min(static_cast<float>(f) / sampleRate, duration);
+                    evaluatePoseInto(c, t, trs, globals);
+                    std::copy(globals.begin(), globals.end(), b.globals.begin() + static_cast<size_t>(f) * nodeCount);
+                }
+            }
+            bakedClips = std::move(baked);
+        }
+
         // Evaluate clip at an explicit time into globalsOut (nodeCount matrices).
         // This does not mutate nodes/local/global matrices, so it can be used per entity.
+        // Allocation-free once the scratch vectors have grown: non-animated nodes copy their rest
+        // local, only the clip's animated nodes are sampled and composed, and globals come from one
+        // pass over nodeEvalOrder.
         inline void evaluatePoseInto(uint32_t clipIndex, float timeSec,
                                      std::vector<NodeTRS> &trsScratch,
-                                     std::vector<glm::mat4> &localsScratch,
-                                     std::vector<glm::mat4> &globalsOut,
-                                     std::vector<uint8_t> &visitedScratch) const
+                                     std::vector<glm::mat4> &globalsOut) const
         {
             const uint32_t nodeCount = static_cast<uint32_t>(nodes.size());
-            globalsOut.assign(nodeCount, glm::mat4(1.0f));
             if (nodeCount == 0)
+            {
+                globalsOut.clear();
                 return;
+            }
 
-            trsScratch.resize(nodeCount);
-            localsScratch.resize(nodeCount);
-            visitedScratch.assign(nodeCount, 0);
-
-            // Start from rest pose if available.
-            if (restTRS.size() == nodes.size())
+            // Tables are built by AssetManager at load; fall back to identity if they are missing.
+            if (restLocals.size() != nodes.size())
             {
-                trsScratch = restTRS;
+                globalsOut.assign(nodeCount, glm::mat4(1.0f));
+                return;
             }
-            else
+
+            // Baked: blend the two neighbouring frames (matrix lerp; fine at typical bake rates).
+            if (!animClips.empty() && bakedClips.size() == animClips.size())
             {
-                for (uint32_t i = 0; i < nodeCount; ++i)
-                    trsScratch[i] = NodeTRS{};
+                const uint32_t safeClip = std::min(clipIndex, static_cast<uint32_t>(animClips.size() - 1));
+                const BakedClip &b = bakedClips[safeClip];
+                if (b.frameCount > 0 && b.globals.size() == static_cast<size_t>(b.frameCount) * nodeCount)
+                {
+                    const float f = std::max(timeSec, 0.0f) * b.sampleRate;
+                    const uint32_t f0 = std::min(static_cast<uint32_t>(f), b.frameCount - 1);
+                    const uint32_t f1 = std::min(f0 + 1, b.frameCount - 1);
+                    const float a = std::min(f - static_cast<float>(f0), 1.0f);
+
+                    globalsOut.resize(nodeCount);
+                    const glm::mat4 *m0 = b.globals.data() + static_cast<size_t>(f0) * nodeCount;
+                    const glm::mat4 *m1 = b.globals.data() + static_cast<size_t>(f1) * nodeCount;
+                    for (uint32_t i = 0; i < nodeCount; ++i)
+                        globalsOut[i] = m0[i] + (m1[i] - m0[i]) * a;
+                    return;
+                }
             }
 
-            if (!animClips.empty() && !animChannels.empty() && !animSamplers.empty())
+            globalsOut.assign(restLocals.begin(), restLocals.end());
+            trsScratch.resize(nodeCount);
+
+            if (!animClips.empty() && !animChannels.empty() && !animSamplers.empty() && clipNodeRanges.size() == animClips.size())
             {
                 const uint32_t safeClip = std::min(clipIndex, static_cast<uint32_t>(animClips.size() - 1));
                 const auto &clip = animClips[safeClip];
+                const ClipNodeRange &range = clipNodeRanges[safeClip];
+                const bool hasRest = restTRS.size() == nodes.size();
+
+                // Animated nodes start from the rest pose; channels overwrite their T/R/S.
+                for (uint32_t k = range.first; k < range.first + range.count; ++k)
+                {
+                    const uint32_t node = clipAnimatedNodes[k];
+                    trsScratch[node] = hasRest ? restTRS[node] : NodeTRS{};
+                }
 
                 const float t = timeSec;
                 const uint32_t clipFirst = clip.firstChannel;
@@ -386,70 +632,36 @@ namespace Engine
                         continue;
                     const auto &s = animSamplers[ch.samplerIndex];
 
-                    if (ch.targetNode >= trsScratch.size())
-                        continue;
-
-                    if (s.timeCount == 0)
-                        continue;
-                    if (s.firstTime + s.timeCount > animTimes.size())
-                        continue;
-
-                    const float *times = animTimes.data() + s.firstTime;
-                    const float *values = nullptr;
-                    if (s.firstValue + s.valueCount <= animValues.size())
-                        values = animValues.data() + s.firstValue;
-                    else
+                    if (ch.targetNode >= nodeCount)
                         continue;
 
                     if (ch.path == (uint16_t)smodel::SModelAnimPath::Translation)
-                    {
-                        trsScratch[ch.targetNode].t = SampleVec3(times, values, s.timeCount, t);
-                    }
+                        sampleVec3(s, t, trsScratch[ch.targetNode].t);
                     else if (ch.path == (uint16_t)smodel::SModelAnimPath::Scale)
-                    {
-                        trsScratch[ch.targetNode].s = SampleVec3(times, values, s.timeCount, t);
-                    }
+                        sampleVec3(s, t, trsScratch[ch.targetNode].s);
                     else if (ch.path == (uint16_t)smodel::SModelAnimPath::Rotation)
-                    {
-                        trsScratch[ch.targetNode].r = SampleQuat(times, values, s.timeCount, t);
-                    }
+                        sampleQuat(s, t, trsScratch[ch.targetNode].r);
                 }
-            }
-
-            for (uint32_t i = 0; i < nodeCount; ++i)
-                localsScratch[i] = ComposeTRS(trsScratch[i]);
-
-            const uint32_t U32_MAX = ~0u;
-
-            std::function<void(uint32_t, const glm::mat4 &)> compute = [&](uint32_t nodeIdx, const glm::mat4 &parentGlobal)
-            {
-                if (nodeIdx >= nodeCount)
-                    return;
-                if (visitedScratch[nodeIdx])
-                    return;
-                visitedScratch[nodeIdx] = 1;
-
-                globalsOut[nodeIdx] = parentGlobal * localsScratch[nodeIdx];
-
-                const ModelNode &n = nodes[nodeIdx];
-                if (n.childCount == 0)
-                    return;
-                if (n.firstChildIndex == U32_MAX)
-                    return;
 
-                const uint32_t start = n.firstChildIndex;
-                for (uint32_t ci = 0; ci < n.childCount; ++ci)
+                for (uint32_t k = range.first; k < range.first + range.count; ++k)
                 {
-                    const uint32_t child = nodeChildIndices[start + ci];
-                    compute(child, globalsOut[nodeIdx]);
+                    const uint32_t node = clipAnimatedNodes[k];
+                    globalsOut[node] = ComposeTRS(trsScratch[node]);
                 }
-            };
+            }
 
-            for (uint32_t i = 0; i < nodeCount; ++i)
+            // Nodes unreachable from a root stay identity, as before.
+            if (nodeEvalOrder.size() != nodes.size())
             {
-                if (nodes[i].parentIndex == U32_MAX)
-                    compute(i, glm::mat4(1.0f));
+                std::vector<uint8_t> reached(nodeCount, 0);
+                for (const uint32_t nodeIdx : nodeEvalOrder)
+                    reached[nodeIdx] = 1;
+                for (uint32_t i = 0; i < nodeCount; ++i)
+                    if (!reached[i])
+                        globalsOut[i] = glm::mat4(1.0f);
             }
+
+            localsToGlobals(globalsOut.data());
         }
     };
 
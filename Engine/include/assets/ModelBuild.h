@@ -0,0 +1,32 @@
+#pragma once
+/*
+  ModelBuild.h
+  ------------
+  Purpose:
+    - The device-independent half of turning a parsed .smodel into a ModelAsset: primitive ranges
+      and LODs, bounds and fit scale from the mesh records, skins, the node hierarchy, animation
+      tables and the rest pose.
+    - Shared by AssetManager (which then binds mesh/material handles and rebases the ranges into
+      its GeometryPool) and HeadlessAssetManager (no device: the tables are all a server needs).
+
+  Usage:
+    - auto model = std::make_unique<ModelAsset>();
+      if (!buildModelFromView(view, bakeRate, *model, err)) { ... }
+
+  Notes:
+    - Primitive mesh/material handles are left invalid.
+    - Clips are baked at 'animationBakeRate' frames per second (ModelAsset::bakeClips; 0 keeps
+      keyframe sampling).
+*/
+
+#include "assets/ModelAsset.h"
+#include "assets/SModelLoader.h"
+
+#include <string>
+
+namespace Engine
+{
+    // Returns false with a short reason on malformed skin tables ('model' is then incomplete).
+    bool buildModelFromView(const smodel::SModelFileView &view, float animationBakeRate, ModelAsset &model,
+                            std::string &outError);
+}
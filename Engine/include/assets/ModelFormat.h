@@ -22,6 +22,8 @@
 #include "assets/model/SModelSkinRecord.h"
 
 #include "assets/model/SModelAnimationRecords.h"
+#include "assets/model/SModelAnimPacking.h"
+#include "assets/model/SModelMeshletRecord.h"
 namespace Engine::smodel
 {
     // 'SMOD' little-endian magic
@@ -0,0 +1,36 @@
+#pragma once
+/*
+  ModelSource.h
+  -------------
+  Purpose:
+    - The model half of an asset manager, for code that needs models but no device: prefab
+      loading (ECS/Prefab.h) and gameplay reading node/animation tables.
+    - Implemented by AssetManager (GPU uploads) and HeadlessAssetManager (CPU tables only, for
+      servers and tools without a graphics device).
+
+  Notes:
+    - Same contract as AssetManager's model API: loadModelAsync() returns a handle holding one
+      reference; getModel() is null until modelState() is Ready.
+*/
+
+#include "assets/Handles.h"
+
+#include <string>
+
+namespace Engine
+{
+    struct ModelAsset;
+
+    class ModelSource
+    {
+    public:
+        virtual ~ModelSource() = default;
+
+        virtual ModelHandle loadModelAsync(const std::string &cookedModelPath) = 0;
+        virtual ModelAsset *getModel(ModelHandle h) = 0;
+        virtual AssetState modelState(ModelHandle h) const = 0;
+
+        virtual void addRef(ModelHandle h) = 0;
+        virtual void release(ModelHandle h) = 0;
+    };
+}
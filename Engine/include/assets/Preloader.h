@@ -0,0 +1,143 @@
+#pragma once
+/*
+  Preloader.h
+  -----------
+  Purpose:
+    - Declarative startup loading. A preload manifest lists the models, textures, prefabs, shaders
+      and other files a game needs before its first playable frame:
+
+        {
+          "models":   ["assets/Knight/Knight.smodel"],
+          "textures": ["assets/raw/menu.png"],
+          "prefabs":  ["entities/LightInfantry.json"],
+          "shaders":  ["shaders/smodel.vert.spv"],
+          "files":    ["Scinerio.json"]
+        }
+
+    - Stage 1 (start(), no device needed): every listed file is opened and read on JobSystem
+      background workers, so its pages are in memory before the loaders ask for them. Application
+      starts this first thing, overlapping window, device, swapchain and pipeline creation.
+    - Stage 2 (attach(), once the game created its AssetManager): models and textures stream through
+      the async path (AssetManager::loadModelAsync / loadTextureAsync).
+    - update() (Application, once per frame) refreshes progress(); Application::OnLoading is called
+      instead of the simulation until it is done(), so a loading screen can draw from the counters.
+
+  Notes:
+    - Prefabs and shaders are only read ahead: building them needs the component registry / device,
+      which belong to the game and renderer. For a prefab JSON the cooked .sprefab next to it is read too.
+    - Archive entries (AssetArchive) are read ahead as their stored byte range in the archive mapping,
+      without decompressing LZ4 / Zstd entries; the later open decompresses from memory.
+      bytesRead counts stored bytes.
+    - The preloader holds one reference per streamed asset (model()/texture()) until detach(), which
+      must run before the AssetManager is destroyed.
+*/
+
+#include "assets/Handles.h"
+#include "Engine/JobSystem.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Engine
+{
+    class AssetManager;
+
+    struct PreloadManifest
+    {
+        std::vector<std::string> models;
+        std::vector<std::string> textures;
+        std::vector<std::string> prefabs;
+        std::vector<std::string> shaders;
+        std::vector<std::string> files; // read ahead only (scenarios, configs)
+
+        bool empty() const
+        {
+            return models.empty() && textures.empty() && prefabs.empty() && shaders.empty() && files.empty();
+        }
+
+        // Parse a manifest (JSON, see above; through MappedFile, so mounted archives serve it too).
+        static bool load(const std::string &path, PreloadManifest &out, std::string &outError);
+    };
+
+    struct PreloadProgress
+    {
+        uint32_t filesTotal = 0;  // stage 1
+        uint32_t filesRead = 0;
+        uint32_t filesFailed = 0; // missing or unreadable (still counted as read)
+        uint64_t bytesRead = 0;
+
+        uint32_t assetsTotal = 0; // stage 2: models + textures
+        uint32_t assetsReady = 0;
+        uint32_t assetsFailed = 0;
+        bool attached = false;
+
+        float elapsedMs = 0.0f; // since start(); frozen once done
+
+        // Streamed assets count only after attach(); a manifest without models/textures needs none.
+        bool done() const
+        {
+            return filesRead == filesTotal && (assetsTotal == 0 || (attached && assetsReady + assetsFailed == assetsTotal));
+        }
+
+        // [0, 1], files and assets weighted equally per item.
+        float fraction() const
+        {
+            const uint32_t total = filesTotal + assetsTotal;
+            return total ? static_cast<float>(filesRead + assetsReady + assetsFailed) / static_cast<float>(total) : 1.0f;
+        }
+    };
+
+    class Preloader
+    {
+    public:
+        Preloader() = default;
+        ~Preloader(); // waits for outstanding reads
+        Preloader(const Preloader &) = delete;
+        Preloader &operator=(const Preloader &) = delete;
+
+        // Stage 1: queue the reads. Once per preloader, any thread (Application's constructor).
+        void start(PreloadManifest manifest);
+
+        // Stage 2: stream the manifest's models and textures into 'assets'. Main thread, once.
+        void attach(AssetManager &assets);
+
+        // Drop the preloader's references (the assets stay while others hold them). Call before the
+        // AssetManager passed to attach() is destroyed.
+        void detach();
+
+        // Main thread, once per frame (Application::Run): refresh progress().
+        void update();
+
+        const PreloadProgress &progress() const { return m_progress; }
+        const PreloadManifest &manifest() const { return m_manifest; }
+
+        // True from start() until progress().done().
+        bool loading() const { return m_started && !m_progress.done(); }
+
+        // Handles streamed by attach() (invalid for paths not in the manifest, or before attach()).
+        ModelHandle model(const std::string &path) const;
+        TextureHandle texture(const std::string &path) const;
+
+    private:
+        PreloadManifest m_manifest;
+        PreloadProgress m_progress;
+        bool m_started = false;
+        bool m_reported = false;
+        std::chrono::steady_clock::time_point m_startTime;
+
+        // Stage 1 (workers)
+        JobCounter m_reads;
+        std::atomic<uint32_t> m_filesRead{0};
+        std::atomic<uint32_t> m_filesFailed{0};
+        std::atomic<uint64_t> m_bytesRead{0};
+
+        // Stage 2 (main thread)
+        AssetManager *m_assets = nullptr;
+        std::unordered_map<std::string, ModelHandle> m_models;
+        std::unordered_map<std::string, TextureHandle> m_textures;
+    };
+}
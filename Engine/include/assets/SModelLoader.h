@@ -5,22 +5,25 @@
 #include <vector>
 
 #include "assets/ModelFormat.h" // umbrella include for SModel structs
+#include "utils/MappedFile.h"
 
 namespace Engine::smodel
 {
     // ------------------------------------------------------------
     // SModelFileView
     // ------------------------------------------------------------
-    // Owns file bytes and provides typed views (pointers) into it.
+    // Memory-maps the file and provides typed views (pointers) into it.
+    // Record tables are read in place; blob ranges are copied straight from the
+    // mapping into staging memory. Move-only (owns the mapping).
     // AssetManager will use this to build GPU resources later.
     struct SModelFileView
     {
-        std::vector<uint8_t> fileBytes; // owns the whole file memory
+        MappedFile file; // owns the mapping
 
-        // Header pointer inside fileBytes
+        // Header pointer inside the mapping
         const SModelHeader *header = nullptr;
 
-        // Record table pointers inside fileBytes
+        // Record table pointers inside the mapping
         const SModelMeshRecord *meshes = nullptr;
         const SModelPrimitiveRecord *primitives = nullptr;
         const SModelMaterialRecord *materials = nullptr;
@@ -37,12 +40,21 @@ namespace Engine::smodel
         const SModelAnimationSamplerRecord *animSamplers = nullptr;
         const float *animTimes = nullptr;
         const float *animValues = nullptr;
+        const uint8_t *animPacked = nullptr; // V4.4: quantized sampler values
 
         // Skinning (V4)
         const SModelSkinRecord *skins = nullptr;
         const uint32_t *skinJointNodeIndices = nullptr;
         const float *skinInverseBindMatrices = nullptr;
 
+        // Meshlets (V4.2, optional)
+        const SModelMeshletRecord *meshlets = nullptr;
+        const uint32_t *meshletVertices = nullptr;
+        const uint8_t *meshletTriangles = nullptr;
+
+        // Primitive LODs (V4.3, optional)
+        const SModelPrimitiveLodRecord *primitiveLods = nullptr;
+
         // String table start pointer (C-string table)
         const char *stringTable = nullptr;
 
@@ -89,6 +101,13 @@ namespace Engine::smodel
             return header->animValuesCount;
         }
 
+        uint32_t animPackedSize() const
+        {
+            if (!header || header->versionMinor < 4)
+                return 0;
+            return header->animPackedSize;
+        }
+
         uint32_t skinCount() const
         {
             if (!header || header->versionMajor < 4)
@@ -108,6 +127,32 @@ namespace Engine::smodel
             return header->skinInverseBindMatricesCount;
         }
 
+        uint32_t meshletCount() const
+        {
+            if (!header || header->versionMinor < 2)
+                return 0;
+            return header->meshletCount;
+        }
+        uint32_t meshletVerticesCount() const
+        {
+            if (!header || header->versionMinor < 2)
+                return 0;
+            return header->meshletVerticesCount;
+        }
+        uint32_t meshletTrianglesCount() const
+        {
+            if (!header || header->versionMinor < 2)
+                return 0;
+            return header->meshletTrianglesCount;
+        }
+
+        uint32_t primitiveLodCount() const
+        {
+            if (!header || header->versionMinor < 3)
+                return 0;
+            return header->primitiveLodCount;
+        }
+
         // Returns pointer to a null-terminated string in the string table.
         // Returns empty string if offset is 0 or invalid.
         const char *getStringOrEmpty(uint32_t strOffset) const;
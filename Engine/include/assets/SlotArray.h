@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Engine
+{
+    // Entries of one asset kind, stored densely by handle id: resolving a handle is one indexed
+    // load plus the generation check. Ids start at 1 and are never reused (renderer caches key
+    // on them), so erasing only clears the slot; generation 0 marks it empty.
+    template <typename Entry>
+    class SlotArray
+    {
+    public:
+        uint64_t insert(Entry &&e)
+        {
+            m_slots.push_back(std::move(e));
+            return static_cast<uint64_t>(m_slots.size());
+        }
+
+        // Live entry of 'id' (any generation), or nullptr.
+        Entry *find(uint64_t id)
+        {
+            Entry *e = (id - 1 < m_slots.size()) ? &m_slots[static_cast<size_t>(id - 1)] : nullptr;
+            return (e && e->generation != 0) ? e : nullptr;
+        }
+        const Entry *find(uint64_t id) const { return const_cast<SlotArray *>(this)->find(id); }
+
+        // Live entry the handle refers to, or nullptr (stale generation, erased or unknown id).
+        template <typename Handle>
+        Entry *get(const Handle &h)
+        {
+            Entry *e = find(h.id);
+            return (e && e->generation == h.generation) ? e : nullptr;
+        }
+        template <typename Handle>
+        const Entry *get(const Handle &h) const { return const_cast<SlotArray *>(this)->get(h); }
+
+        void erase(uint64_t id)
+        {
+            if (Entry *e = find(id))
+            {
+                *e = Entry{};
+                e->generation = 0;
+            }
+        }
+
+        // f(id, entry) for every live entry; f may erase the entry it is given.
+        template <typename F>
+        void forEach(F &&f)
+        {
+            for (size_t i = 0; i < m_slots.size(); ++i)
+            {
+                if (m_slots[i].generation != 0)
+                    f(static_cast<uint64_t>(i + 1), m_slots[i]);
+            }
+        }
+        template <typename F>
+        void forEach(F &&f) const
+        {
+            for (size_t i = 0; i < m_slots.size(); ++i)
+            {
+                if (m_slots[i].generation != 0)
+                    f(static_cast<uint64_t>(i + 1), m_slots[i]);
+            }
+        }
+
+        void clear() { m_slots.clear(); }
+
+    private:
+        std::vector<Entry> m_slots; // [id - 1]
+    };
+}
@@ -1,11 +1,39 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include <algorithm>
 #include <cstdint>
+#include <vector>
+#include "Engine/GpuAllocator.h"
 
 namespace Engine
 {
     struct UploadContext; // forward decl from ImageUtils
 
+    // RGBA8 pixels with a full box-filtered mip chain, tightly packed level after level.
+    // Produced on a worker thread so the upload needs only buffer->image copies (no blits),
+    // which is what a transfer-only queue can do.
+    struct DecodedImage
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels;
+        std::vector<VkDeviceSize> levelOffsets; // one per mip level
+
+        uint32_t mipLevels() const { return static_cast<uint32_t>(levelOffsets.size()); }
+    };
+
+    // Block-compressed image (4x4 blocks of 16 bytes: BC7/BC5/ASTC 4x4) with a prebuilt mip
+    // chain, levels tightly packed. Non-owning; usually points into a mapped .smodel blob.
+    struct BlockCompressedImage
+    {
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipLevels = 0;
+        const uint8_t *data = nullptr;
+        VkDeviceSize size = 0;
+    };
+
     // ============================================================
     // TextureAsset
     // ============================================================
@@ -47,6 +75,45 @@ namespace Engine
             VkSamplerMipmapMode mipMode,
             float maxAnisotropy);
 
+        // Staging bytes uploadEncodedImage_Deferred() will use (header only, no decode). 0 if unreadable.
+        static VkDeviceSize stagingBytesForEncoded(const uint8_t *encodedBytes, size_t encodedSize);
+
+        // Decode PNG/JPG to a single RGBA8 level (upload with uploadRGBA8_Deferred). Thread-safe.
+        static bool decodeRGBA8(const uint8_t *encodedBytes, size_t encodedSize, DecodedImage &out);
+
+        // Decode PNG/JPG and build the mip chain on the CPU. Thread-safe (no Vulkan calls).
+        static bool decodeWithMips(const uint8_t *encodedBytes, size_t encodedSize, DecodedImage &out);
+
+        // Record copies of a pre-decoded image. Works on transfer-only contexts; the image is
+        // shared across ctx.queueFamilies.
+        // firstLevel > 0 uploads only the mip tail from that level down (mip streaming): the GPU
+        // image's level 0 is the source's level firstLevel, so nothing finer can be sampled.
+        bool uploadDecoded_Deferred(
+            UploadContext &ctx,
+            const DecodedImage &image,
+            bool srgbFormat,
+            VkSamplerAddressMode wrapU,
+            VkSamplerAddressMode wrapV,
+            VkFilter minFilter,
+            VkFilter magFilter,
+            VkSamplerMipmapMode mipMode,
+            float maxAnisotropy,
+            uint32_t firstLevel = 0);
+
+        // Record copies of a block-compressed image as stored (no decode, no blits). Works on
+        // transfer-only contexts. Fails if the device cannot sample image.format.
+        // firstLevel: as for uploadDecoded_Deferred().
+        bool uploadBlockCompressed_Deferred(
+            UploadContext &ctx,
+            const BlockCompressedImage &image,
+            VkSamplerAddressMode wrapU,
+            VkSamplerAddressMode wrapV,
+            VkFilter minFilter,
+            VkFilter magFilter,
+            VkSamplerMipmapMode mipMode,
+            float maxAnisotropy,
+            uint32_t firstLevel = 0);
+
         // Destroy GPU resources (used by AssetManager when freeing)
         void destroy(VkDevice device);
 
@@ -58,18 +125,29 @@ namespace Engine
         uint32_t getHeight() const { return m_height; }
         uint32_t getMipLevels() const { return m_mipLevels; }
         VkFormat getFormat() const { return m_format; }
+        VkDeviceSize gpuBytes() const { return m_allocation.size; }
+
+        // Mip streaming: source level held as GPU level 0 (0: full resolution), and the source
+        // chain it was cut from. getWidth()/getHeight()/getMipLevels() describe the resident part.
+        uint32_t residentMip() const { return m_residentMip; }
+        uint32_t sourceMipLevels() const { return m_sourceMipLevels; }
+        uint32_t sourceExtent() const { return std::max(m_sourceWidth, m_sourceHeight); }
 
         bool isValid() const { return m_image != VK_NULL_HANDLE; }
 
     private:
         VkImage m_image = VK_NULL_HANDLE;
-        VkDeviceMemory m_memory = VK_NULL_HANDLE;
+        GpuAllocation m_allocation{};
         VkImageView m_view = VK_NULL_HANDLE;
         VkSampler m_sampler = VK_NULL_HANDLE;
 
         uint32_t m_width = 0;
         uint32_t m_height = 0;
         uint32_t m_mipLevels = 1;
+        uint32_t m_sourceWidth = 0;
+        uint32_t m_sourceHeight = 0;
+        uint32_t m_sourceMipLevels = 1;
+        uint32_t m_residentMip = 0;
         VkFormat m_format = VK_FORMAT_R8G8B8A8_UNORM;
     };
 
@@ -0,0 +1,106 @@
+#pragma once
+#include "assets/model/SModelAnimationRecords.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace Engine::smodel
+{
+    // ============================================================
+    // Packed animation samplers (V4.4)
+    // ============================================================
+    // Quantized samplers keep their times in animTimes (float seconds) and their values in the
+    // animPacked byte section; SModelAnimationSamplerRecord::firstValue / valueCount are a byte range.
+    //
+    //  Vec3Quantized: SModelAnimVec3Range (24 bytes), then per key uint16 x, y, z:
+    //                 v = min + extent * q / 65535. Ranges start 4-byte aligned.
+    //  QuatSmallest3: per key 48 bits, least significant byte first: bits 0-1 index of the dropped (largest)
+    //                 component, then the other three in XYZW order, 15 bits each, mapping
+    //                 [-1/sqrt(2), 1/sqrt(2)]. The dropped component is positive and rebuilt from
+    //                 unit length. Worst-case error is about 2e-5 per component.
+
+    struct SModelAnimVec3Range
+    {
+        float min[3];
+        float extent[3];
+    };
+    static_assert(sizeof(SModelAnimVec3Range) == 24, "SModelAnimVec3Range size mismatch");
+
+    static constexpr uint32_t kAnimPackedKeyBytes = 6; // both packed types
+
+    // Byte count of a packed sampler with 'keyCount' keys.
+    inline uint32_t animPackedBytes(uint8_t valueType, uint32_t keyCount)
+    {
+        const uint32_t keys = keyCount * kAnimPackedKeyBytes;
+        return (valueType == uint8_t(SModelAnimValueType::Vec3Quantized)) ? uint32_t(sizeof(SModelAnimVec3Range)) + keys : keys;
+    }
+
+    // q: XYZW, unit length
+    inline void packQuatSmallest3(const float q[4], uint8_t out[6])
+    {
+        uint32_t largest = 0;
+        for (uint32_t i = 1; i < 4; ++i)
+        {
+            if (std::fabs(q[i]) > std::fabs(q[largest]))
+                largest = i;
+        }
+        const float sign = (q[largest] < 0.0f) ? -1.0f : 1.0f;
+
+        uint64_t bits = largest;
+        uint32_t shift = 2;
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            if (i == largest)
+                continue;
+            const float n = std::min(std::max(q[i] * sign * 0.70710678f + 0.5f, 0.0f), 1.0f);
+            bits |= uint64_t(static_cast<uint32_t>(n * 32767.0f + 0.5f)) << shift;
+            shift += 15;
+        }
+        for (uint32_t b = 0; b < 6; ++b)
+            out[b] = static_cast<uint8_t>(bits >> (8 * b));
+    }
+
+    inline void unpackQuatSmallest3(const uint8_t in[6], float q[4])
+    {
+        uint64_t bits = 0;
+        for (uint32_t b = 0; b < 6; ++b)
+            bits |= uint64_t(in[b]) << (8 * b);
+
+        const uint32_t largest = static_cast<uint32_t>(bits & 3u);
+        uint32_t shift = 2;
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            if (i == largest)
+                continue;
+            const float n = static_cast<float>((bits >> shift) & 0x7FFFu) * (1.0f / 32767.0f);
+            q[i] = (n - 0.5f) * 1.41421356f;
+            sum += q[i] * q[i];
+            shift += 15;
+        }
+        q[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+    }
+
+    inline void packVec3Quantized(const float v[3], const SModelAnimVec3Range &range, uint8_t out[6])
+    {
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            const float n = (range.extent[i] > 0.0f) ? (v[i] - range.min[i]) / range.extent[i] : 0.0f;
+            const uint16_t q = static_cast<uint16_t>(std::min(std::max(n, 0.0f), 1.0f) * 65535.0f + 0.5f);
+            std::memcpy(out + 2 * i, &q, sizeof(q));
+        }
+    }
+
+    inline void unpackVec3Quantized(const uint8_t in[6], const SModelAnimVec3Range &range, float v[3])
+    {
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            uint16_t q;
+            std::memcpy(&q, in + 2 * i, sizeof(q));
+            v[i] = range.min[i] + range.extent[i] * (static_cast<float>(q) * (1.0f / 65535.0f));
+        }
+    }
+
+} // namespace Engine::smodel
@@ -23,6 +23,9 @@ namespace Engine::smodel
     {
         Vec3 = 0,
         Quat = 1,
+        // V4.4, in the animPacked section (see SModelAnimPacking.h)
+        Vec3Quantized = 2, // unorm16 xyz over the sampler's box
+        QuatSmallest3 = 3, // 48-bit smallest-three
     };
 
     struct SModelAnimationClipRecord
@@ -45,8 +48,10 @@ namespace Engine::smodel
         uint32_t firstTime; // index into animTimes (float)
         uint32_t timeCount;
 
-        uint32_t firstValue; // index into animValues (float)
-        uint32_t valueCount; // floats count (timeCount*3 or timeCount*4)
+        // Vec3 / Quat: float index into animValues and float count (timeCount*3 or timeCount*4).
+        // Vec3Quantized / QuatSmallest3: byte offset into animPacked and byte count.
+        uint32_t firstValue;
+        uint32_t valueCount;
 
         uint8_t interpolation; // SModelAnimInterpolation
         uint8_t valueType;     // SModelAnimValueType
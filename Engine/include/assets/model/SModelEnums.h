@@ -28,8 +28,22 @@ namespace Engine::smodel
         // Skinning (V4)
         VTX_JOINTS = (1u << 4),  // JOINTS0 (u16x4)
         VTX_WEIGHTS = (1u << 5), // WEIGHTS0 (f32x4)
+
+        // Quantized encodings of the attributes above (V4.1, SModelVertexQuantized)
+        VTX_POS_UNORM16 = (1u << 6),     // POSITION u16x4 unorm relative to the mesh AABB (w unused)
+        VTX_NORMAL_OCT16 = (1u << 7),    // NORMAL   octahedral, snorm16x2
+        VTX_TANGENT_SNORM8 = (1u << 8),  // TANGENT  snorm8x4 (w = handedness)
+        VTX_UV0_HALF = (1u << 9),        // TEXCOORD0 f16x2
+        VTX_JOINTS_U8 = (1u << 10),      // JOINTS0 u8x4
+        VTX_WEIGHTS_UNORM8 = (1u << 11), // WEIGHTS0 unorm8x4
     };
 
+    // The two vertex layouts the runtime draws (72 and 28 bytes); VTX_POS_UNORM16 selects the second.
+    constexpr uint32_t kVertexLayoutFull = VTX_POS | VTX_NORMAL | VTX_UV0 | VTX_TANGENT | VTX_JOINTS | VTX_WEIGHTS;
+    constexpr uint32_t kVertexLayoutQuantized = kVertexLayoutFull | VTX_POS_UNORM16 | VTX_NORMAL_OCT16 |
+                                                VTX_TANGENT_SNORM8 | VTX_UV0_HALF | VTX_JOINTS_U8 |
+                                                VTX_WEIGHTS_UNORM8;
+
     // ============================================================
     // Texture / Image Enums
     // ============================================================
@@ -45,13 +59,23 @@ namespace Engine::smodel
 
     // Image encoding describes how the texture bytes are stored in the blob.
     // Phase 1: embed PNG/JPG bytes (compressed) and decode at runtime.
+    // Block encodings are uploaded as-is: SModelBlockImageHeader + prebuilt mip chain.
     enum class ImageEncoding : uint32_t
     {
         PNG = 0,
         JPG = 1,
-        RAW = 2 // optional future (raw RGBA8 stored directly)
+        RAW = 2, // optional future (raw RGBA8 stored directly)
+
+        BC7 = 3,     // RGBA, desktop
+        BC5 = 4,     // RG only (normal maps), desktop
+        ASTC_4x4 = 5 // RGBA, mobile
     };
 
+    inline bool IsBlockCompressed(uint32_t encoding)
+    {
+        return encoding >= uint32_t(ImageEncoding::BC7) && encoding <= uint32_t(ImageEncoding::ASTC_4x4);
+    }
+
     // ============================================================
     // Sampler Enums
     // ============================================================
@@ -84,11 +84,31 @@ namespace Engine::smodel
 
         uint32_t skinInverseBindMatricesOffset; // float array (mat4 = 16 floats)
         uint32_t skinInverseBindMatricesCount;  // number of floats
+
+        // NEW in v4.2: meshlets (optional; counts can be 0). Files older than 4.2 end the
+        // header above, so read these (and later fields) only through the versioned
+        // SModelFileView accessors.
+        uint32_t meshletsOffset;
+        uint32_t meshletCount;
+
+        uint32_t meshletVerticesOffset; // uint32 mesh-local vertex indices
+        uint32_t meshletVerticesCount;
+
+        uint32_t meshletTrianglesOffset; // uint8 meshlet-local indices, 3 per triangle
+        uint32_t meshletTrianglesCount;  // number of bytes
+
+        // NEW in v4.3: primitive LODs (optional; count can be 0)
+        uint32_t primitiveLodsOffset;
+        uint32_t primitiveLodCount;
+
+        // NEW in v4.4: packed animation values for quantized samplers (optional; size can be 0)
+        uint32_t animPackedOffset;
+        uint32_t animPackedSize; // bytes
     };
 
 #pragma pack(pop)
 
     // Size must remain stable across tool/runtime.
-    static_assert(sizeof(SModelHeader) == 192, "SModelHeader size mismatch");
+    static_assert(sizeof(SModelHeader) == 232, "SModelHeader size mismatch");
 
 } // namespace Engine::smodel
\ No newline at end of file
@@ -35,8 +35,28 @@ namespace Engine::smodel
         float aabbMax[3];
     };
 
+    // ============================================================
+    // Vertex layouts
+    // ============================================================
+    // kVertexLayoutFull (72 bytes): pos f32x3, normal f32x3, uv0 f32x2, tangent f32x4,
+    // joints u16x4, weights f32x4.
+    //
+    // kVertexLayoutQuantized (28 bytes): decoded by smodel.vert. Positions are unorm16 over the
+    // mesh AABB, which the cooker snaps to values exactly representable as half floats (the
+    // runtime passes the box to the shader as halves, see SModelRenderer::PushConstants).
+    struct SModelVertexQuantized
+    {
+        uint16_t pos[4];   // unorm16: aabbMin + pos * (aabbMax - aabbMin); [3] = 0
+        int16_t normal[2]; // snorm16 octahedral
+        int8_t tangent[4]; // snorm8, w = +-1 handedness
+        uint16_t uv0[2];   // f16
+        uint8_t joints[4];
+        uint8_t weights[4]; // unorm8, sum 255
+    };
+
 #pragma pack(pop)
 
     static_assert(sizeof(SModelMeshRecord) == 80, "SModelMeshRecord size mismatch");
+    static_assert(sizeof(SModelVertexQuantized) == 28, "SModelVertexQuantized size mismatch");
 
 } // namespace Engine::smodel
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+namespace Engine::smodel
+{
+#pragma pack(push, 1)
+
+    // ============================================================
+    // Meshlet Record (V4.2, optional)
+    // ============================================================
+    // A cluster of at most kMeshletMaxVertices vertices / kMeshletMaxTriangles triangles of one
+    // mesh, for cluster culling or a mesh-shader path. Meshlets of a mesh are contiguous and
+    // together cover exactly that mesh's LOD 0 triangles.
+    //
+    // meshletVertices[] holds uint32 mesh-local vertex indices; meshletTriangles[] holds 3 bytes
+    // per triangle, each an index into the meshlet's own vertex list.
+    struct SModelMeshletRecord
+    {
+        uint32_t meshIndex;
+        uint32_t vertexOffset;   // first entry in meshletVertices[]
+        uint32_t triangleOffset; // first byte in meshletTriangles[]
+        uint16_t vertexCount;
+        uint16_t triangleCount;
+
+        // Bounding sphere (mesh space)
+        float center[3];
+        float radius;
+
+        // Backface cone: the whole meshlet faces away from a camera at 'eye' when
+        // dot(normalize(coneApex - eye), coneAxis) >= coneCutoff. coneCutoff = 1 disables the test.
+        float coneApex[3];
+        float coneAxis[3];
+        float coneCutoff;
+    };
+
+#pragma pack(pop)
+
+    static constexpr uint32_t kMeshletMaxVertices = 64;
+    static constexpr uint32_t kMeshletMaxTriangles = 124;
+
+    static_assert(sizeof(SModelMeshletRecord) == 60, "SModelMeshletRecord size mismatch");
+
+} // namespace Engine::smodel
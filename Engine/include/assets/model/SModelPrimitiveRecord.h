@@ -27,8 +27,26 @@ namespace Engine::smodel
         uint32_t reserved;
     };
 
+    // ============================================================
+    // Primitive LOD Record (V4.3, optional)
+    // ============================================================
+    // A simplified index range of a primitive over the same vertices; the primitive record itself
+    // is LOD 0. LODs of a primitive are contiguous, finest first, and their indices follow LOD 0's
+    // in the mesh's index data.
+    struct SModelPrimitiveLodRecord
+    {
+        uint32_t primitiveIndex;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        float error; // largest deviation from LOD 0, in mesh units
+    };
+
 #pragma pack(pop)
 
     static_assert(sizeof(SModelPrimitiveRecord) == 28, "SModelPrimitiveRecord size mismatch");
+    static_assert(sizeof(SModelPrimitiveLodRecord) == 16, "SModelPrimitiveLodRecord size mismatch");
+
+    // Simplified levels per primitive (LOD 0 not counted)
+    static constexpr uint32_t kMaxPrimitiveLods = 3;
 
 } // namespace Engine::smodel
\ No newline at end of file
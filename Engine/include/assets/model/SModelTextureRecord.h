@@ -11,9 +11,10 @@ namespace Engine::smodel
     // Stores:
     // - sampler parameters (wrap/filter)
     // - color space (sRGB/Linear)
-    // - embedded compressed image bytes (PNG/JPG) in the blob section
+    // - embedded compressed image bytes (PNG/JPG) in the blob section,
+    //   or a block-compressed mip chain (see SModelBlockImageHeader)
     //
-    // Runtime will decode bytes to RGBA8 and upload to VkImage.
+    // Runtime decodes PNG/JPG to RGBA8; block encodings upload directly.
     struct SModelTextureRecord
     {
         // Offset into string table (0 = none)
@@ -21,7 +22,7 @@ namespace Engine::smodel
         uint32_t uriStrOffset;  // original source path/uri (optional)
 
         uint32_t colorSpace; // TextureColorSpace
-        uint32_t encoding;   // ImageEncoding (PNG/JPG/RAW)
+        uint32_t encoding;   // ImageEncoding (PNG/JPG/RAW/BC7/BC5/ASTC_4x4)
 
         // Sampler settings (mapped later to VkSampler)
         uint32_t wrapU;     // WrapMode
@@ -40,8 +41,31 @@ namespace Engine::smodel
         uint32_t reserved1;
     };
 
+    // ============================================================
+    // Block Image Header
+    // ============================================================
+    // Leads the blob range of a block-compressed texture (BC7/BC5/ASTC 4x4).
+    // All supported encodings use 4x4 blocks of 16 bytes; mip levels follow
+    // the header tightly packed, level 0 first.
+    struct SModelBlockImageHeader
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipCount;
+        uint32_t reserved;
+    };
+
 #pragma pack(pop)
 
     static_assert(sizeof(SModelTextureRecord) == 64, "SModelTextureRecord size mismatch");
+    static_assert(sizeof(SModelBlockImageHeader) == 16, "SModelBlockImageHeader size mismatch");
+
+    // Byte size of one level of a block image.
+    inline uint64_t BlockImageLevelBytes(uint32_t width, uint32_t height, uint32_t level)
+    {
+        const uint64_t w = (width >> level) ? (width >> level) : 1u;
+        const uint64_t h = (height >> level) ? (height >> level) : 1u;
+        return ((w + 3) / 4) * ((h + 3) / 4) * 16u;
+    }
 
 } // namespace Engine::smodel
\ No newline at end of file
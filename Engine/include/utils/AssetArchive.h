@@ -0,0 +1,130 @@
+#pragma once
+#include "utils/MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Engine
+{
+    // ============================================================
+    // .spak asset archive
+    // ============================================================
+    // Many cooked files (.smodel, .smesh, .sprefab, entity JSON, images) in one file, so a cold start
+    // costs one open instead of thousands.
+    //
+    // Layout (little-endian):
+    //   ArchiveHeader
+    //   ArchiveEntry[entryCount]   sorted by (pathHash, path); binary-searched
+    //   path strings               UTF-8, '/'-separated, relative to the packed root, no terminators
+    //   entry data                 each starts on a kArchiveAlignment boundary
+    //
+    // Stored entries are handed out as views into the archive's mapping (no copy; 4K alignment keeps
+    // the views page-aligned for the loaders' typed records and for async reads). LZ4 and Zstd entries
+    // are decompressed into a private buffer on open. Zstd needs ENGINE_HAS_ZSTD at build time;
+    // without it those entries fail to open with an error.
+    static constexpr char kArchiveMagic[4] = {'S', 'P', 'A', 'K'};
+    static constexpr uint16_t kArchiveVersionMajor = 1;
+    static constexpr uint16_t kArchiveVersionMinor = 0;
+    static constexpr uint64_t kArchiveAlignment = 4096;
+
+    enum class ArchiveCodec : uint32_t
+    {
+        Stored = 0,
+        LZ4 = 1, // LZ4 block format (no frame)
+        Zstd = 2,
+    };
+
+    struct ArchiveHeader
+    {
+        char magic[4];
+        uint16_t versionMajor;
+        uint16_t versionMinor;
+        uint32_t headerSize; // sizeof(ArchiveHeader)
+        uint32_t entryCount;
+        uint64_t tocOffset;
+        uint64_t pathsOffset;
+        uint64_t pathsSize;
+        uint64_t fileSizeBytes;
+    };
+    static_assert(sizeof(ArchiveHeader) == 48, "ArchiveHeader layout changed");
+
+    struct ArchiveEntry
+    {
+        uint64_t pathHash;   // ArchivePathHash(path)
+        uint64_t dataOffset; // multiple of kArchiveAlignment
+        uint64_t storedSize; // bytes in the archive
+        uint64_t size;       // bytes after decompression
+        uint32_t pathOffset; // into the path strings
+        uint32_t pathSize;
+        uint32_t codec;      // ArchiveCodec
+        uint32_t reserved;
+    };
+    static_assert(sizeof(ArchiveEntry) == 48, "ArchiveEntry layout changed");
+
+    // '/'-separated, without "./" prefixes; archive lookups and packing both go through this.
+    std::string NormalizeArchivePath(const std::string &path);
+    // FNV-1a 64 of a normalized path.
+    uint64_t ArchivePathHash(const std::string &normalizedPath);
+
+    // LZ4 block codec. Compress returns the compressed size, or 0 when 'src' does not fit in 'capacity'
+    // (callers then store the entry). Decompress fails unless exactly 'dstSize' bytes come out.
+    size_t Lz4CompressBound(size_t srcSize);
+    size_t Lz4CompressBlock(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t capacity);
+    bool Lz4DecompressBlock(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize);
+
+    // Compresses 'src' with 'codec' into 'out'. Returns false (out untouched) when the codec is not
+    // compiled in or the result would not be smaller than the input.
+    bool CompressArchiveEntry(ArchiveCodec codec, const uint8_t *src, size_t srcSize, std::vector<uint8_t> &out);
+    bool ArchiveCodecAvailable(ArchiveCodec codec);
+
+    class AssetArchive
+    {
+    public:
+        // Map 'path' and validate header and table of contents.
+        bool open(const std::string &path, std::string &outError);
+
+        const std::string &path() const { return m_path; }
+        uint32_t entryCount() const { return m_entryCount; }
+        const ArchiveEntry &entry(uint32_t index) const { return m_entries[index]; }
+        std::string entryPath(const ArchiveEntry &e) const;
+
+        // Entry for 'path' (normalized here), or nullptr.
+        const ArchiveEntry *find(const std::string &path) const;
+
+        // Open 'e' as 'out': a view into the archive for stored entries, otherwise a decompressed copy.
+        // 'self' must own this archive; it keeps the mapping alive for as long as 'out' is open.
+        static bool openEntry(const std::shared_ptr<const AssetArchive> &self, const ArchiveEntry &e,
+                              MappedFile &out, std::string &outError);
+
+        // ---- Process-wide mounts ----
+        // MappedFile::open() looks paths up in the mounted archives (most recent first) before the
+        // file system. Any thread; entries already opened stay valid after unmount.
+        static bool mount(const std::string &archivePath, std::string &outError);
+        static void unmountAll();
+        static bool anyMounted();
+
+        // Paths of mounted entries directly inside 'directory' whose name ends in 'extension'
+        // ("entities", ".json" -> "entities/a.json", ...), sorted and without duplicates.
+        static std::vector<std::string> listMounted(const std::string &directory, const std::string &extension);
+
+        // Used by MappedFile::open(): true when a mounted archive has 'path' (then 'handled' is set and
+        // the result is in out / outError); false with handled == false to fall through to the disk.
+        static bool openMounted(const std::string &path, MappedFile &out, std::string &outError, bool &handled);
+
+        // Same lookup, but 'out' views the entry's stored bytes in the archive mapping, still compressed
+        // for LZ4 / Zstd entries (Preloader read-ahead: warms the pages without decompressing).
+        static bool openMountedStored(const std::string &path, MappedFile &out, std::string &outError, bool &handled);
+
+    private:
+        std::string m_path;
+        MappedFile m_file;
+        const ArchiveEntry *m_entries = nullptr;
+        uint32_t m_entryCount = 0;
+        const char *m_paths = nullptr;
+        uint64_t m_pathsSize = 0;
+    };
+
+} // namespace Engine
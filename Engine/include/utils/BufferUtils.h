@@ -1,25 +1,28 @@
 #pragma once
 #include <vulkan/vulkan.h>
 #include <cstdint>
+#include "Engine/GpuAllocator.h"
 
 namespace Engine
 {
+    struct UploadContext; // ImageUtils.h
 
     struct VertexBufferHandle
     {
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        GpuAllocation allocation;
     };
 
     struct IndexBufferHandle
     {
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        GpuAllocation allocation;
     };
 
-    // Host-visible vertex buffer (used as a staging source).
+    // Host-visible vertex buffer for data rewritten every frame (also usable as a staging source).
     // Implementation should create with usage:
     //   VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+    // Geometry that never changes belongs in CreateStaticVertexBuffer (device-local).
     VkResult CreateOrUpdateVertexBuffer(
         VkDevice device,
         VkPhysicalDevice physicalDevice,
@@ -30,9 +33,10 @@ namespace Engine
     // Destroy buffer and memory held by VertexBufferHandle
     void DestroyVertexBuffer(VkDevice device, VertexBufferHandle &handle);
 
-    // Host-visible index buffer (used as a staging source).
+    // Host-visible index buffer for data rewritten every frame (also usable as a staging source).
     // Implementation should create with usage:
     //   VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+    // Static indices belong in CreateStaticIndexBuffer (device-local).
     VkResult CreateOrUpdateIndexBuffer(
         VkDevice device,
         VkPhysicalDevice physicalDevice,
@@ -42,7 +46,38 @@ namespace Engine
 
     void DestroyIndexBuffer(VkDevice device, IndexBufferHandle &handle);
 
-    // Create a device-local buffer (not mappable) for fast GPU reads.
+    // Device-local buffer filled from ctx's staging arena; only the copy is recorded, so the
+    // buffer is valid once ctx completed. Shared across ctx.queueFamilies.
+    bool RecordDeviceLocalUpload(
+        UploadContext &ctx,
+        const void *data,
+        VkDeviceSize dataSize,
+        VkBufferUsageFlags usage,
+        VkBuffer &outBuffer,
+        GpuAllocation &outAllocation,
+        GpuMemoryCategory category = GpuMemoryCategory::Geometry);
+
+    // Immutable device-local vertex / index buffer: staged upload on 'queue' (one submit + wait).
+    // Destroy with DestroyVertexBuffer / DestroyIndexBuffer.
+    VkResult CreateStaticVertexBuffer(
+        VkDevice device,
+        VkPhysicalDevice physicalDevice,
+        uint32_t queueFamilyIndex,
+        VkQueue queue,
+        const void *vertexData,
+        VkDeviceSize dataSize,
+        VertexBufferHandle &handle);
+
+    VkResult CreateStaticIndexBuffer(
+        VkDevice device,
+        VkPhysicalDevice physicalDevice,
+        uint32_t queueFamilyIndex,
+        VkQueue queue,
+        const void *indexData,
+        VkDeviceSize dataSize,
+        IndexBufferHandle &handle);
+
+    // Create a device-local buffer (not mappable) for fast GPU reads, sub-allocated from GpuAllocator.
     // Caller must include the final role bit(s) and VK_BUFFER_USAGE_TRANSFER_DST_BIT in 'usage',
     // e.g., VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
     // or     VK_BUFFER_USAGE_INDEX_BUFFER_BIT  | VK_BUFFER_USAGE_TRANSFER_DST_BIT
@@ -52,7 +87,11 @@ namespace Engine
         VkDeviceSize size,
         VkBufferUsageFlags usage,
         VkBuffer &outBuffer,
-        VkDeviceMemory &outMemory);
+        GpuAllocation &outAllocation,
+        GpuMemoryCategory category = GpuMemoryCategory::Geometry);
+
+    // Destroy a buffer created by CreateDeviceLocalBuffer (or GpuAllocator::createBuffer).
+    void DestroyBuffer(VkDevice device, VkBuffer &buffer, GpuAllocation &allocation);
 
     // Copy bytes from src to dst using a one-time command buffer.
     // Requirements:
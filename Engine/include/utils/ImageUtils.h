@@ -2,6 +2,8 @@
 #include <vulkan/vulkan.h>
 #include <cstdint>
 #include <vector>
+#include <mutex>
+#include "Engine/GpuAllocator.h"
 
 namespace Engine
 {
@@ -13,7 +15,7 @@ namespace Engine
     struct StagingBufferHandle
     {
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        GpuAllocation allocation; // persistently mapped
         VkDeviceSize size = 0;
     };
 
@@ -31,7 +33,8 @@ namespace Engine
     // ============================================================
     // UploadContext (optimized path)
     // ============================================================
-    // This records *many* texture uploads into ONE command buffer and submits once.
+    // This records *many* texture/mesh uploads into ONE command buffer and submits once.
+    // Their source bytes share one staging arena (StageUpload).
     //
     // Typical usage:
     //   UploadContext ctx;
@@ -52,9 +55,36 @@ namespace Engine
         // We'll collect them here and destroy at the end.
         std::vector<StagingBufferHandle> pendingStaging;
 
+        // Current staging arena chunk and its linear allocation head (full chunks move to pendingStaging).
+        StagingBufferHandle stagingArena;
+        VkDeviceSize stagingHead = 0;
+
+        // Queue families that will use resources created through this context. With more than
+        // one family, images/buffers are created VK_SHARING_MODE_CONCURRENT (no ownership transfer).
+        std::vector<uint32_t> queueFamilies;
+
+        // 'queue' has no graphics capability: no blits, and final barriers stop at the transfer stage.
+        bool transferOnly = false;
+
         bool begun = false;
     };
 
+    // Fill sharing fields of a VkBufferCreateInfo / VkImageCreateInfo from ctx.queueFamilies.
+    template <typename CreateInfo>
+    inline void ApplyQueueSharing(const UploadContext &ctx, CreateInfo &info)
+    {
+        if (ctx.queueFamilies.size() > 1)
+        {
+            info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            info.queueFamilyIndexCount = static_cast<uint32_t>(ctx.queueFamilies.size());
+            info.pQueueFamilyIndices = ctx.queueFamilies.data();
+        }
+        else
+        {
+            info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        }
+    }
+
     bool BeginUploadContext(
         UploadContext &ctx,
         VkDevice device,
@@ -65,6 +95,35 @@ namespace Engine
     // Submits command buffer, waits for completion, destroys staging buffers, frees cmd buffer.
     bool EndSubmitAndWait(UploadContext &ctx);
 
+    // Ends and submits without waiting. Completion is reported by 'timeline' reaching 'signalValue'
+    // (when non-null, VK_KHR_timeline_semaphore) and/or by 'fence'. 'queueMutex' guards a queue
+    // that other threads submit to as well. Call ReleaseUploadContext() once the GPU is done.
+    bool SubmitUploadContext(
+        UploadContext &ctx,
+        VkSemaphore timeline,
+        uint64_t signalValue,
+        VkFence fence,
+        std::mutex *queueMutex = nullptr);
+
+    // Destroys staging buffers and frees the command buffer of a completed submission.
+    void ReleaseUploadContext(UploadContext &ctx);
+
+    // Make sure the next 'bytes' of StageUpload() come from a single staging buffer.
+    // Call with the batch total up front to get one arena for the whole batch.
+    bool ReserveStaging(UploadContext &ctx, VkDeviceSize bytes);
+
+    // Copy bytes into the staging arena. outBuffer/outOffset stay valid for copy commands until
+    // the context is released. Starts a new chunk when the current one is full.
+    bool StageUpload(
+        UploadContext &ctx,
+        const void *dataBytes,
+        VkDeviceSize dataSize,
+        VkBuffer &outBuffer,
+        VkDeviceSize &outOffset);
+
+    // Staging bytes StageUpload() consumes for 'dataSize' bytes (includes alignment padding).
+    VkDeviceSize StagingFootprint(VkDeviceSize dataSize);
+
     // ============================================================
     // Image creation helpers
     // ============================================================
@@ -79,7 +138,8 @@ namespace Engine
         VkFormat format,
         VkImageUsageFlags usage,
         VkImage &outImage,
-        VkDeviceMemory &outMemory);
+        GpuAllocation &outAllocation,
+        GpuMemoryCategory category = GpuMemoryCategory::Texture);
 
     // Create a 2D GPU image with explicit mip levels.
     VkResult CreateImage2D(
@@ -91,7 +151,11 @@ namespace Engine
         VkImageUsageFlags usage,
         uint32_t mipLevels,
         VkImage &outImage,
-        VkDeviceMemory &outMemory);
+        GpuAllocation &outAllocation,
+        GpuMemoryCategory category = GpuMemoryCategory::Texture);
+
+    // Destroy an image created by CreateImage2D and release its allocation.
+    void DestroyImage2D(VkDevice device, VkImage &image, GpuAllocation &allocation);
 
     // Create an image view for sampling.
     VkResult CreateImageView2D(
@@ -121,14 +185,17 @@ namespace Engine
         VkImage image,
         VkImageLayout oldLayout,
         VkImageLayout newLayout,
-        VkImageAspectFlags aspectFlags);
+        VkImageAspectFlags aspectFlags,
+        uint32_t levelCount = 1);
 
     void CmdCopyBufferToImage(
         UploadContext &ctx,
         VkBuffer buffer,
         VkImage image,
         uint32_t width,
-        uint32_t height);
+        uint32_t height,
+        uint32_t mipLevel = 0,
+        VkDeviceSize bufferOffset = 0);
 
     // Record mipmap generation via blits for a 2D color image.
     // Expects mip 0 to be in TRANSFER_DST_OPTIMAL.
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Engine
+{
+    // ============================================================
+    // MappedFile
+    // ============================================================
+    // Read-only memory mapping of a whole file (mmap / MapViewOfFile).
+    // Pages are faulted in on first touch, so only the ranges actually read cost RAM.
+    // Paths found in a mounted AssetArchive are served from the archive instead (see AssetArchive.h).
+    // Move-only; the mapping is released on destruction.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+
+        // Map 'path'. On failure returns false and sets outError; the object stays closed.
+        bool open(const std::string &path, std::string &outError);
+        void close();
+
+        // Serve [data, data + size) kept alive by 'owner' instead of a mapping of our own
+        // (AssetArchive entries); close() only drops the owner.
+        void adopt(const uint8_t *data, uint64_t size, std::shared_ptr<const void> owner);
+
+        // Hint that [offset, offset + size) will be read soon (e.g. before staging a blob range).
+        void prefetch(uint64_t offset, uint64_t size) const;
+
+        const uint8_t *data() const { return m_data; }
+        uint64_t size() const { return m_size; }
+        bool isOpen() const { return m_data != nullptr; }
+
+    private:
+        const uint8_t *m_data = nullptr;
+        uint64_t m_size = 0;
+        std::shared_ptr<const void> m_owner; // set for adopted views
+#if defined(_WIN32)
+        void *m_file = nullptr;    // HANDLE
+        void *m_mapping = nullptr; // HANDLE
+#endif
+    };
+
+} // namespace Engine
@@ -0,0 +1,139 @@
+#version 450
+
+// GpuSceneRenderPassModule draws: everything per instance comes from storage buffers written by the
+// gpu_scene_*.comp passes, so the only vertex input is the mesh (binding 0, same layout as smodel.vert).
+// Node and joint matrices are sampled from the baked clips here (two frames, blended) instead of a
+// per-frame palette. Pairs with smodel.frag / smodel_bindless.frag (material in push constants).
+layout(constant_id = 0) const bool kQuantizedVertices = false;
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inUV0;
+layout(location = 3) in vec4 inTangent;
+
+layout(location = 8) in uvec4 inJoints;
+layout(location = 9) in vec4 inWeights;
+
+struct SceneInstance
+{
+    vec4 posScale; // xyz translation, w uniform scale
+    uvec4 meta;    // x sin(yaw), y cos(yaw) (float bits), z model | clip << 16, w timeSec
+};
+
+struct ModelInfo
+{
+    mat4 base;
+    vec4 sphere;
+    uvec4 draws;
+    uvec4 anim;
+    vec4 lodError;
+};
+
+struct DrawInfo
+{
+    uvec4 geom;  // x=indexCount, y=firstIndex, z=vertexOffset (int bits), w=node index
+    uvec4 skin;  // x=skin base joint, y=skin joint count
+    uvec4 quant; // mesh box as halves: (min.x, min.y), (min.z, extent.x), (extent.y, extent.z)
+    uvec4 slot;
+};
+
+struct VisibleRecord
+{
+    uvec4 a; // x=instance slot, y=frame blend (float bits), z/w=node offset of the two frames
+    uvec4 b; // x/y=joint offset of the two frames, z=model, w=LOD level
+};
+
+layout(set = 0, binding = 0) uniform ViewData
+{
+    mat4 view;
+    mat4 proj;
+} viewData;
+
+layout(set = 0, binding = 1, std430) readonly buffer Instances { SceneInstance i[]; } instances;
+layout(set = 0, binding = 2, std430) readonly buffer Models { ModelInfo m[]; } models;
+layout(set = 0, binding = 3, std430) readonly buffer Draws { DrawInfo d[]; } draws;
+layout(set = 0, binding = 5, std430) readonly buffer Baked { mat4 m[]; } baked;
+layout(set = 0, binding = 6, std430) readonly buffer Visible { VisibleRecord r[]; } visible;
+layout(set = 0, binding = 8, std430) readonly buffer DrawInstances { uvec2 e[]; } drawInstances;
+
+layout(location = 0) out vec3 vNormal;
+layout(location = 1) out vec2 vUV0;
+
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.y += (n.y >= 0.0) ? -t : t;
+    return normalize(n);
+}
+
+mat4 blendFrames(uint offset0, uint offset1, uint index, float blend)
+{
+    mat4 m0 = baked.m[offset0 + index];
+    mat4 m1 = baked.m[offset1 + index];
+    return m0 + (m1 - m0) * blend;
+}
+
+void main()
+{
+    uvec2 entry = drawInstances.e[gl_InstanceIndex];
+    VisibleRecord rec = visible.r[entry.x];
+    DrawInfo draw = draws.d[entry.y];
+    SceneInstance inst = instances.i[rec.a.x];
+    mat4 base = models.m[rec.b.z].base;
+    float blend = uintBitsToFloat(rec.a.y);
+
+    vec3 position = inPosition.xyz;
+    vec3 normal = inNormal;
+    if (kQuantizedVertices)
+    {
+        vec2 q0 = unpackHalf2x16(draw.quant.x);
+        vec2 q1 = unpackHalf2x16(draw.quant.y);
+        vec2 q2 = unpackHalf2x16(draw.quant.z);
+        position = vec3(q0, q1.x) + position * vec3(q1.y, q2);
+        normal = octDecode(inNormal.xy);
+    }
+
+    float k = inst.posScale.w;
+    float sy = uintBitsToFloat(inst.meta.x);
+    float cy = uintBitsToFloat(inst.meta.y);
+    mat4 instanceWorld = mat4(vec4(cy * k, 0.0, -sy * k, 0.0),
+                              vec4(0.0, k, 0.0, 0.0),
+                              vec4(sy * k, 0.0, cy * k, 0.0),
+                              vec4(inst.posScale.xyz, 1.0));
+
+    uint skinBase = draw.skin.x;
+    uint skinJointCount = draw.skin.y;
+
+    mat4 M;
+    vec4 modelPos;
+    vec3 modelNormal;
+    if (skinJointCount > 0u)
+    {
+        // Baked joint matrices already bring vertices into model space.
+        uvec4 j = min(inJoints, uvec4(skinJointCount - 1u)) + uvec4(skinBase);
+        vec4 w = inWeights;
+        mat4 skinM = w.x * blendFrames(rec.b.x, rec.b.y, j.x, blend) +
+                     w.y * blendFrames(rec.b.x, rec.b.y, j.y, blend) +
+                     w.z * blendFrames(rec.b.x, rec.b.y, j.z, blend) +
+                     w.w * blendFrames(rec.b.x, rec.b.y, j.w, blend);
+
+        modelPos = skinM * vec4(position, 1.0);
+        modelNormal = normalize(mat3(skinM) * normal);
+        M = instanceWorld * base;
+    }
+    else
+    {
+        mat4 nodeM = blendFrames(rec.a.z, rec.a.w, draw.geom.w, blend);
+        M = instanceWorld * base * nodeM;
+        modelPos = vec4(position, 1.0);
+        modelNormal = normal;
+    }
+
+    vec4 worldPos = M * modelPos;
+    mat3 normalMat = mat3(transpose(inverse(M)));
+    vNormal = normalize(normalMat * modelNormal);
+    vUV0 = inUV0;
+    gl_Position = viewData.proj * viewData.view * worldPos;
+}
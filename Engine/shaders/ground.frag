@@ -0,0 +1,22 @@
+#version 450
+
+layout(location = 0) in vec3 vNormal;
+layout(location = 1) in vec2 vUV0;
+
+layout(set = 1, binding = 0) uniform sampler2D uBaseColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    // Same light as smodel.frag, so units and ground match.
+    vec3 n = normalize(vNormal);
+    vec3 base = texture(uBaseColor, vUV0).rgb;
+
+    vec3 lightDir = normalize(vec3(0.3, 0.7, 0.2));
+    float ndotl = clamp(dot(n, lightDir), 0.0, 1.0);
+    vec3 ambient = vec3(0.2);
+    vec3 lit = ambient + ndotl * vec3(0.8);
+
+    outColor = vec4(base * lit, 1.0);
+}
@@ -0,0 +1,98 @@
+#version 450
+
+// Geometry clipmap of the ground, generated from gl_VertexIndex (two triangles per cell) and
+// gl_InstanceIndex (level). See GroundPlaneRenderPassModule for the layout.
+
+// The frame's shared view block (Engine::GpuViewData); only its leading matrices are read.
+layout(set = 0, binding = 0) uniform ViewData
+{
+    mat4 view;
+    mat4 proj;
+} cam;
+
+// R32_SFLOAT heights, texelFetch only (bilinear below matches Heightfield::heightAt()).
+layout(set = 0, binding = 1) uniform sampler2D uHeight;
+
+layout(push_constant) uniform PushConstants
+{
+    vec4 cameraPos;   // xyz, w = finest cell size
+    vec4 grid;        // x = quads per level side, y = levels, z = 1 / tileWorldSize
+    vec4 heightfield; // xy = origin, z = 1 / cellSize
+} pc;
+
+layout(location = 0) out vec3 vNormal;
+layout(location = 1) out vec2 vUV0;
+
+const ivec2 CORNERS[6] = ivec2[](ivec2(0, 0), ivec2(1, 0), ivec2(0, 1), ivec2(0, 1), ivec2(1, 0), ivec2(1, 1));
+
+float texelHeight(ivec2 p, ivec2 size)
+{
+    return texelFetch(uHeight, clamp(p, ivec2(0), size - 1), 0).r;
+}
+
+float heightAt(vec2 xz)
+{
+    ivec2 size = textureSize(uHeight, 0);
+    vec2 g = clamp((xz - pc.heightfield.xy) * pc.heightfield.z, vec2(0.0), vec2(size - 1));
+    ivec2 p = min(ivec2(g), max(size - 2, ivec2(0)));
+    vec2 f = g - vec2(p);
+    float h0 = mix(texelHeight(p, size), texelHeight(p + ivec2(1, 0), size), f.x);
+    float h1 = mix(texelHeight(p + ivec2(0, 1), size), texelHeight(p + ivec2(1, 1), size), f.x);
+    return mix(h0, h1, f.y);
+}
+
+// Lower corner of level 'level': centered on the camera, snapped to twice the level's cell so the
+// next coarser level's vertices line up with every other vertex of this one.
+vec2 levelOrigin(int level, float quads)
+{
+    float cell = pc.cameraPos.w * exp2(float(level));
+    vec2 snapped = floor(pc.cameraPos.xz / (2.0 * cell)) * (2.0 * cell);
+    return snapped - vec2(0.5 * quads * cell);
+}
+
+void main()
+{
+    int quads = int(pc.grid.x);
+    int level = gl_InstanceIndex;
+    int quad = gl_VertexIndex / 6;
+    ivec2 q = ivec2(quad % quads, quad / quads);
+    ivec2 v = q + CORNERS[gl_VertexIndex % 6];
+
+    float cell = pc.cameraPos.w * exp2(float(level));
+    vec2 origin = levelOrigin(level, float(quads));
+
+    vNormal = vec3(0.0, 1.0, 0.0);
+    vUV0 = vec2(0.0);
+
+    // Cells covered by the finer level are collapsed to a point (zero-area triangles are not rasterized).
+    if (level > 0)
+    {
+        vec2 inner = levelOrigin(level - 1, float(quads));
+        vec2 innerEnd = inner + vec2(float(quads) * 0.5 * cell);
+        vec2 qMin = origin + vec2(q) * cell;
+        float eps = 0.25 * cell;
+        if (all(greaterThanEqual(qMin, inner - eps)) && all(lessThanEqual(qMin + cell, innerEnd + eps)))
+        {
+            gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+            return;
+        }
+    }
+
+    vec2 xz = origin + vec2(v) * cell;
+    float h = heightAt(xz);
+
+    // Odd vertices on the outer border sit halfway along a coarser edge: take that edge's height.
+    bool edgeX = v.x == 0 || v.x == quads;
+    bool edgeZ = v.y == 0 || v.y == quads;
+    if (edgeX && (v.y & 1) == 1)
+        h = 0.5 * (heightAt(xz - vec2(0.0, cell)) + heightAt(xz + vec2(0.0, cell)));
+    else if (edgeZ && (v.x & 1) == 1)
+        h = 0.5 * (heightAt(xz - vec2(cell, 0.0)) + heightAt(xz + vec2(cell, 0.0)));
+
+    float dx = heightAt(xz + vec2(cell, 0.0)) - heightAt(xz - vec2(cell, 0.0));
+    float dz = heightAt(xz + vec2(0.0, cell)) - heightAt(xz - vec2(0.0, cell));
+    vNormal = normalize(vec3(-dx, 2.0 * cell, -dz));
+    vUV0 = xz * pc.grid.z;
+
+    gl_Position = cam.proj * cam.view * vec4(xz.x, h, xz.y, 1.0);
+}
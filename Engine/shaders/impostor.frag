@@ -0,0 +1,16 @@
+#version 450
+
+layout(location = 0) in vec2 vUV;
+
+layout(set = 0, binding = 0) uniform sampler2D uAtlas;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    // The bake cleared to alpha 0: cut out everything outside the model's silhouette.
+    vec4 texel = texture(uAtlas, vUV);
+    if (texel.a < 0.5)
+        discard;
+    outColor = vec4(texel.rgb, 1.0);
+}
@@ -0,0 +1,51 @@
+#version 450
+
+// Camera-facing quad per instance, textured with the atlas cell of the nearest baked view direction
+// and the instance's pose row (see ImpostorRenderPassModule). Corners come from gl_VertexIndex of a
+// 4-vertex triangle strip.
+layout(location = 0) in vec4 iPositionScale; // xyz position, w scale
+layout(location = 1) in vec4 iYawRow;        // x=sin(yaw), y=cos(yaw), z=atlas row
+
+layout(push_constant) uniform PushConstants
+{
+    mat4 viewProj;
+    vec4 cameraPos; // xyz
+    vec4 sphere;    // instance-space center xyz, radius w
+    vec4 atlas;     // x=directions, y=rows, z=1/directions, w=1/rows
+} pc;
+
+layout(location = 0) out vec2 vUV;
+
+const float TWO_PI = 6.28318530718;
+
+void main()
+{
+    vec2 corner = vec2(float(gl_VertexIndex & 1), float(gl_VertexIndex >> 1)) * 2.0 - 1.0;
+    float s = iYawRow.x;
+    float c = iYawRow.y;
+    float scale = iPositionScale.w;
+
+    // Rotation about +Y by yaw (glm::rotate): x' = x*c + z*s, z' = -x*s + z*c
+    vec3 local = pc.sphere.xyz * scale;
+    vec3 center = iPositionScale.xyz + vec3(local.x * c + local.z * s, local.y, -local.x * s + local.z * c);
+    float radius = pc.sphere.w * scale;
+
+    // View direction in instance space (inverse yaw) selects the atlas column: column k was baked
+    // looking along (sin(2*pi*k/n), ., cos(2*pi*k/n)).
+    vec3 forward = center - pc.cameraPos.xyz;
+    vec2 d = vec2(forward.x * c - forward.z * s, forward.x * s + forward.z * c);
+    float column = 0.0;
+    if (dot(d, d) > 1e-8)
+        column = mod(round(atan(d.x, d.y) / TWO_PI * pc.atlas.x), pc.atlas.x);
+
+    vec3 fwd = normalize(forward);
+    vec3 right = cross(fwd, vec3(0.0, 1.0, 0.0));
+    right = (dot(right, right) > 1e-6) ? normalize(right) : vec3(1.0, 0.0, 0.0); // looking straight down
+    vec3 up = cross(right, fwd);
+
+    vec3 world = center + (right * corner.x + up * corner.y) * radius;
+    gl_Position = pc.viewProj * vec4(world, 1.0);
+
+    vec2 cell = vec2(corner.x * 0.5 + 0.5, 0.5 - corner.y * 0.5);
+    vUV = (vec2(column, iYawRow.z) + cell) * pc.atlas.zw;
+}
@@ -5,11 +5,14 @@ layout(location = 1) in vec2 vUV0;
 
 layout(set = 1, binding = 0) uniform sampler2D uBaseColor;
 
+// alphaMode of the pipeline variant (0=Opaque, 1=Mask, 2=Blend); only Mask keeps the discard.
+layout(constant_id = 0) const int kAlphaMode = 0;
+
 layout(push_constant) uniform PushConstants
 {
     mat4 model;
     vec4 baseColorFactor;
-    vec4 materialParams; // x=alphaCutoff, y=alphaMode
+    vec4 materialParams; // x=alphaCutoff, y=alphaMode (the pipeline's kAlphaMode decides)
 } pc;
 
 layout(location = 0) out vec4 outColor;
@@ -21,12 +24,9 @@ void main()
     vec4 tex = texture(uBaseColor, vUV0);
     vec4 base = tex * pc.baseColorFactor;
 
-    // alphaMode: 0=Opaque, 1=Mask, 2=Blend
-    float alphaMode = pc.materialParams.y;
-    float alphaCutoff = pc.materialParams.x;
-    if (alphaMode > 0.5 && alphaMode < 1.5)
+    if (kAlphaMode == 1)
     {
-        if (base.a < alphaCutoff)
+        if (base.a < pc.materialParams.x)
             discard;
     }
 
@@ -7,7 +7,15 @@
 // location 3: vec4 tangent
 // location 8: uvec4 joints (u16x4)
 // location 9: vec4 weights
-layout(location = 0) in vec3 inPosition;
+// With kQuantizedVertices the same locations carry smodel::SModelVertexQuantized: unorm16 position
+// over the mesh box (pc.quantBox), octahedral snorm16 normal, snorm8 tangent, half uv, u8 joints,
+// unorm8 weights. Only position and normal need decoding here.
+layout(constant_id = 0) const bool kQuantizedVertices = false;
+// kSkinned: the pipeline variant for primitives with a skin (pc.skinInfo.y > 0). Unskinned variants
+// compile out the joint fetches and the weighted blend; static props never touch the joint palette.
+layout(constant_id = 1) const bool kSkinned = false;
+
+layout(location = 0) in vec4 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inUV0;
 layout(location = 3) in vec4 inTangent;
@@ -15,7 +23,8 @@ layout(location = 3) in vec4 inTangent;
 layout(location = 8) in uvec4 inJoints;
 layout(location = 9) in vec4 inWeights;
 
-// Per-instance world matrix (mat4 consumes 4 locations)
+// Per-instance world matrix (mat4 consumes 4 locations).
+// Column 0 .w carries the instance's palette slot (as a float); the transform itself is affine.
 layout(location = 4) in vec4 inInstanceCol0;
 layout(location = 5) in vec4 inInstanceCol1;
 layout(location = 6) in vec4 inInstanceCol2;
@@ -26,13 +35,13 @@ layout(set = 0, binding = 0) uniform CameraUBO {
     mat4 proj;
 } cam;
 
-// Flattened node globals: [instance][node]
+// Flattened node globals: [palette slot][node]
 layout(set = 0, binding = 1, std430) readonly buffer NodePalette
 {
     mat4 nodeGlobals[];
 } palette;
 
-// Flattened joint matrices: [instance][joint]
+// Flattened joint matrices: [palette slot][joint]
 layout(set = 0, binding = 2, std430) readonly buffer JointPalette
 {
     mat4 jointMats[];
@@ -42,18 +51,42 @@ layout(push_constant) uniform PushConstants
 {
     mat4 model;
     vec4 baseColorFactor;
-    vec4 materialParams;
-    uvec4 nodeInfo; // x=nodeIndex, y=nodeCount
+    vec2 materialParams;
+    uvec2 quantBox; // halves: (min.x, min.y), (min.z, extent.x)
+    uvec4 nodeInfo; // x=nodeIndex, y=nodeCount, z=material index, w=halves (extent.y, extent.z)
     uvec4 skinInfo; // x=skinBaseJoint, y=skinJointCount, z=jointPaletteStride
 } pc;
 
 layout(location = 0) out vec3 vNormal;
 layout(location = 1) out vec2 vUV0;
 
+// The depth pre-pass runs this shader without a fragment stage; both must produce the same depth.
+invariant gl_Position;
+
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.y += (n.y >= 0.0) ? -t : t;
+    return normalize(n);
+}
+
 void main()
 {
-    mat4 instanceWorld = mat4(inInstanceCol0, inInstanceCol1, inInstanceCol2, inInstanceCol3);
-    uint instanceIndex = uint(gl_InstanceIndex);
+    vec3 position = inPosition.xyz;
+    vec3 normal = inNormal;
+    if (kQuantizedVertices)
+    {
+        vec2 q0 = unpackHalf2x16(pc.quantBox.x);
+        vec2 q1 = unpackHalf2x16(pc.quantBox.y);
+        vec2 q2 = unpackHalf2x16(pc.nodeInfo.w);
+        position = vec3(q0, q1.x) + position * vec3(q1.y, q2);
+        normal = octDecode(inNormal.xy);
+    }
+
+    mat4 instanceWorld = mat4(vec4(inInstanceCol0.xyz, 0.0), inInstanceCol1, inInstanceCol2, inInstanceCol3);
+    uint paletteSlot = uint(inInstanceCol0.w + 0.5);
     uint nodeIndex = pc.nodeInfo.x;
     uint nodeCount = max(pc.nodeInfo.y, 1u);
 
@@ -65,7 +98,7 @@ void main()
     vec4 modelPos;
     vec3 modelNormal;
 
-    if (skinJointCount > 0u)
+    if (kSkinned)
     {
         // Skinning: joint matrices already bring vertices into model space.
         // Build a weighted skin matrix from up to 4 joints.
@@ -75,24 +108,24 @@ void main()
         // Clamp joint indices to skinJointCount to avoid OOB.
         uvec4 j = min(inJoints, uvec4(max(skinJointCount - 1u, 0u)));
 
-        uint base = instanceIndex * jointStride + skinBase;
+        uint base = paletteSlot * jointStride + skinBase;
         skinM += w.x * joints.jointMats[base + j.x];
         skinM += w.y * joints.jointMats[base + j.y];
         skinM += w.z * joints.jointMats[base + j.z];
         skinM += w.w * joints.jointMats[base + j.w];
 
-        modelPos = skinM * vec4(inPosition, 1.0);
-        modelNormal = normalize(mat3(skinM) * inNormal);
+        modelPos = skinM * vec4(position, 1.0);
+        modelNormal = normalize(mat3(skinM) * normal);
 
         M = instanceWorld * pc.model;
     }
     else
     {
         // Unskinned: use node transform palette.
-        mat4 nodeM = palette.nodeGlobals[instanceIndex * nodeCount + nodeIndex];
+        mat4 nodeM = palette.nodeGlobals[paletteSlot * nodeCount + nodeIndex];
         M = instanceWorld * pc.model * nodeM;
-        modelPos = vec4(inPosition, 1.0);
-        modelNormal = inNormal;
+        modelPos = vec4(position, 1.0);
+        modelNormal = normal;
     }
 
     vec4 worldPos = M * modelPos;
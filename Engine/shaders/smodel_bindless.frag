@@ -0,0 +1,60 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 vNormal;
+layout(location = 1) in vec2 vUV0;
+
+// Bindless materials: every base color texture in one array, material constants in an SSBO.
+// Entry 0 of both is the white fallback.
+layout(set = 1, binding = 0) uniform sampler2D uTextures[];
+
+// alphaMode of the pipeline variant (0=Opaque, 1=Mask, 2=Blend); only Mask keeps the discard.
+layout(constant_id = 0) const int kAlphaMode = 0;
+
+struct Material
+{
+    vec4 baseColorFactor;
+    float alphaCutoff;
+    uint alphaMode; // 0=Opaque, 1=Mask, 2=Blend
+    uint textureIndex;
+    uint _pad;
+};
+
+layout(std430, set = 1, binding = 1) readonly buffer Materials
+{
+    Material materials[];
+};
+
+layout(push_constant) uniform PushConstants
+{
+    mat4 model;
+    vec4 baseColorFactor;
+    vec4 materialParams;
+    uvec4 nodeInfo; // x=nodeIndex, y=nodeCount, z=material index
+} pc;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    // The index comes from a push constant, so it is dynamically uniform: no nonuniformEXT needed.
+    Material m = materials[pc.nodeInfo.z];
+
+    vec3 n = normalize(vNormal);
+
+    vec4 tex = texture(uTextures[m.textureIndex], vUV0);
+    vec4 base = tex * m.baseColorFactor;
+
+    if (kAlphaMode == 1)
+    {
+        if (base.a < m.alphaCutoff)
+            discard;
+    }
+
+    vec3 lightDir = normalize(vec3(0.3, 0.7, 0.2));
+    float ndotl = clamp(dot(n, lightDir), 0.0, 1.0);
+    vec3 ambient = vec3(0.2);
+    vec3 lit = ambient + ndotl * vec3(0.8);
+
+    outColor = vec4(base.rgb * lit, base.a);
+}
@@ -5,10 +5,22 @@
 #include "Engine/SwapChain.h"
 #include "Engine/ImGuiLayer.h"
 #include "Engine/PerformanceMonitor.h"
+#include "Engine/Profiler.h"
+#include "Engine/FrameCapture.h"
+#include "Engine/FrameArena.h"
+#include "Engine/JobSystem.h"
+#include "Engine/MemoryStats.h"
+#include "Engine/Telemetry.h"
 #include "ECS/ECSContext.h"
 #include "Engine/ImGuiLayer.h"
+#include "assets/Preloader.h"
 #include <iostream>
 #include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
 
 namespace Engine
 {
@@ -20,14 +32,157 @@ namespace Engine
         std::unique_ptr<Renderer> renderer;
         std::unique_ptr<ImGuiLayer> imguiLayer;
         std::unique_ptr<PerformanceMonitor> perfMonitor;
+        FrameCapture frameCapture;
+        Preloader preloader;
         bool running = true;
         EventCallbackFn eventCallback;
         std::unique_ptr<ECS::ECSContext> ecs;
+        MemoryStats::Registration ecsMemoryReport; // after ecs: removed before it is destroyed
+        Telemetry::Registration ecsTelemetry;      // likewise
+
+        // Fixed-step simulation
+        float fixedDelta = 0.0f; // seconds per tick; 0 = disabled
+        uint32_t maxCatchUpSteps = 5;
+        float accumulator = 0.0f;
+
+        // Pipelined rendering: drawFrame() for frame N runs on renderThread while the main thread
+        // simulates frame N+1.
+        bool pipelined = false;
+        std::thread renderThread;
+        std::mutex renderMutex;
+        std::condition_variable renderCv;
+        bool frameQueued = false;
+        bool renderQuit = false;
+        std::exception_ptr renderError;
+
+        void startRenderThread()
+        {
+            if (renderThread.joinable())
+                return;
+            renderQuit = false;
+            renderThread = std::thread([this]
+                                       {
+                                           CpuProfiler::setThreadName("Render");
+                                           renderLoop(); });
+        }
+
+        void stopRenderThread()
+        {
+            if (!renderThread.joinable())
+                return;
+            {
+                std::lock_guard<std::mutex> lock(renderMutex);
+                renderQuit = true;
+            }
+            renderCv.notify_all();
+            renderThread.join();
+        }
+
+        // Hand the snapshotted frame to the render thread.
+        void kickFrame()
+        {
+            {
+                std::lock_guard<std::mutex> lock(renderMutex);
+                frameQueued = true;
+            }
+            renderCv.notify_all();
+        }
+
+        // Block until the render thread is idle; rethrows a drawFrame() failure on the main thread.
+        void waitForFrame()
+        {
+            if (!renderThread.joinable())
+                return;
+            std::unique_lock<std::mutex> lock(renderMutex);
+            renderCv.wait(lock, [this]
+                          { return !frameQueued; });
+            if (renderError)
+                std::rethrow_exception(std::exchange(renderError, nullptr));
+        }
+
+        // ImGui was built against the main render pass; after Renderer replaced it, rebuild ImGui.
+        void rebuildImGui()
+        {
+            if (!imguiLayer)
+                return;
+            imguiLayer->cleanup();
+            uint32_t imageCount = static_cast<uint32_t>(vkContext->GetSwapChain()->GetImageViews().size());
+            imguiLayer->init(*vkContext, *window, renderer->getMainRenderPass(), imageCount);
+
+            // Restore render callback
+            imguiLayer->setRenderCallback([this]() {
+                if (perfMonitor) {
+                    perfMonitor->renderOverlay();
+                }
+            });
+
+            // Restore renderer's ImGui callback
+            renderer->setImGuiRenderCallback([this](VkCommandBuffer cmd) {
+                if (imguiLayer && imguiLayer->isInitialized()) {
+                    imguiLayer->render(cmd);
+                }
+            });
+        }
+
+        void renderLoop()
+        {
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(renderMutex);
+                    renderCv.wait(lock, [this]
+                                  { return renderQuit || frameQueued; });
+                    if (!frameQueued)
+                        return;
+                }
+
+                // The render thread's frame boundary: scratch of the previous drawFrame() is done.
+                FrameArena::local().reset();
+                try
+                {
+                    PERF_SCOPE("DrawFrame");
+                    renderer->drawFrame();
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(renderMutex);
+                    renderError = std::current_exception();
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(renderMutex);
+                    frameQueued = false;
+                }
+                renderCv.notify_all();
+            }
+        }
     };
 
     Application::Application()
+        : Application(std::string{})
+    {
+    }
+
+    Application::Application(const std::string &preloadManifestPath)
         : m_Impl(std::make_unique<Impl>())
     {
+        // The job system's main thread is the one that creates it: this one, which owns the window.
+        JobSystem::get();
+
+        // Fleet monitoring: sinks and interval from STRATO_TELEMETRY_* (nothing is exported without them).
+        Telemetry::configureFromEnvironment();
+
+        // Manifest files are read on the workers while the window, device and swapchain come up.
+        if (!preloadManifestPath.empty())
+        {
+            PreloadManifest manifest;
+            std::string error;
+            if (PreloadManifest::load(preloadManifestPath, manifest, error))
+                m_Impl->preloader.start(std::move(manifest));
+            else
+                std::cerr << "[Preload] " << error << "\n";
+        }
+
         // Create window (platform-specific implementation returns a concrete Window)
         m_Impl->window = Window::Create({"Engine Window", 1280, 720});
 
@@ -36,7 +191,7 @@ namespace Engine
 
         // Create Vulkan context (owns instance, surface creation using the window handle)
         m_Impl->vkContext = std::make_unique<VulkanContext>(*m_Impl->window);
-        m_Impl->renderer = std::make_unique<Renderer>(m_Impl->vkContext.get(), m_Impl->vkContext->GetSwapChain(), 4);
+        m_Impl->renderer = std::make_unique<Renderer>(m_Impl->vkContext.get(), m_Impl->vkContext->GetSwapChain(), FramePacing{}.framesInFlight);
 
         // Initialize renderer now that swapchain exists
         m_Impl->renderer->init();
@@ -66,21 +221,147 @@ namespace Engine
         });
 
         m_Impl->ecs = std::make_unique<ECS::ECSContext>();
+        m_Impl->ecsMemoryReport = MemoryStats::Registration([ecs = m_Impl->ecs.get()](std::vector<MemoryStats::Counter> &out)
+                                                            {
+            const ECS::ECSContext::MemoryUsage usage = ecs->memoryUsage();
+            MemoryStats::Counter c;
+            c.subsystem = "ECS";
+            c.name = "Rows";
+            c.cpuBytes = usage.rowBytes;
+            c.count = usage.storeCount;
+            out.push_back(c);
+            c.name = "Entity records";
+            c.cpuBytes = usage.entityRecordBytes;
+            c.count = ecs->entities.capacity();
+            out.push_back(c);
+            c.name = "Commands";
+            c.cpuBytes = usage.commandBytes;
+            c.count = 0;
+            out.push_back(c);
+
+            // One counter per component type, summed over the stores holding it.
+            size_t namedBytes = 0;
+            for (const auto &store : ecs->stores.stores())
+            {
+                if (!store)
+                    continue;
+                store->forEachColumnBytes([&](uint32_t componentId, size_t bytes)
+                                          {
+                    MemoryStats::Counter column;
+                    column.subsystem = "ECS";
+                    column.name = "Column " + ecs->components.getName(componentId);
+                    column.cpuBytes = bytes;
+                    column.count = 1;
+                    namedBytes += bytes;
+                    out.push_back(std::move(column)); });
+            }
+            if (usage.columnBytes > namedBytes)
+            {
+                c.name = "Column padding";
+                c.cpuBytes = usage.columnBytes - namedBytes;
+                out.push_back(c);
+            } });
+
+        // Entities per archetype (largest Config::maxArchetypes by name) for telemetry exports.
+        m_Impl->ecsTelemetry = Telemetry::Registration([ecs = m_Impl->ecs.get()](const Telemetry::Config &config, std::vector<Telemetry::Metric> &out)
+                                                       {
+            uint64_t total = 0;
+            for (ECS::ECSContext::ArchetypeCount &a : ecs->archetypeCounts(config.maxArchetypes))
+            {
+                Telemetry::Metric m;
+                m.name = "ecs_archetype_entities";
+                m.labelKey = "archetype";
+                m.labelValue = std::move(a.components);
+                m.value = a.entities;
+                out.push_back(std::move(m));
+                total += a.entities;
+            }
+            Telemetry::Metric m;
+            m.name = "ecs_entities";
+            m.value = static_cast<double>(total);
+            out.push_back(std::move(m)); });
     }
 
-    Application::~Application() = default;
+    Application::~Application()
+    {
+        // Finishes a frame still being drawn, then joins.
+        m_Impl->stopRenderThread();
+        // The last batch may still be going out.
+        Telemetry::flush();
+    }
 
     void Application::Run()
     {
+        CpuProfiler::setThreadName("Main");
+        if (m_Impl->pipelined)
+            m_Impl->startRenderThread();
+
+        // Fixed-step simulation ticks, then one variable-rate update with the interpolation factor.
+        auto simulate = [this](float deltaSeconds)
+        {
+            TimeStep ts{};
+            ts.DeltaSeconds = deltaSeconds;
+
+            // The simulation starts with the first frame after preloading finished.
+            if (m_Impl->preloader.loading())
+            {
+                PERF_SCOPE("Loading");
+                OnLoading(ts, m_Impl->preloader.progress());
+                return;
+            }
+
+            if (m_Impl->fixedDelta > 0.0f)
+            {
+                const float fixedDelta = m_Impl->fixedDelta;
+                m_Impl->accumulator += deltaSeconds;
+
+                TimeStep tick{};
+                tick.DeltaSeconds = fixedDelta;
+                tick.FixedDeltaSeconds = fixedDelta;
+                while (m_Impl->accumulator >= fixedDelta && ts.FixedSteps < m_Impl->maxCatchUpSteps)
+                {
+                    PERF_SCOPE("FixedUpdate");
+                    OnFixedUpdate(tick);
+                    m_Impl->accumulator -= fixedDelta;
+                    ++ts.FixedSteps;
+                    ++tick.FixedSteps;
+                }
+
+                // Hitch: drop the backlog rather than spiralling into ever longer frames.
+                if (m_Impl->accumulator >= fixedDelta)
+                    m_Impl->accumulator = 0.0f;
+
+                ts.FixedDeltaSeconds = fixedDelta;
+                ts.Alpha = m_Impl->accumulator / fixedDelta;
+            }
+
+            PERF_SCOPE("Update");
+            OnUpdate(ts);
+        };
+
         auto lastFrameTime = std::chrono::steady_clock::now();
         while (m_Impl->running)
         {
+            // Main thread scratch (FrameArena) lives for one iteration.
+            FrameArena::local().reset();
+
+            // Jobs that need the main thread (GLFW, window) queued since the last frame.
+            JobSystem::get().pumpMainThread();
+
+            // Frame pacing waits before input is polled, so the input a frame sees is as fresh as possible.
+            // Pipelined mode waits with the render thread idle, before the frame is handed over.
+            if (!m_Impl->pipelined)
+            {
+                PERF_SCOPE("FramePacing");
+                m_Impl->renderer->waitForFrameStart();
+            }
+
             const auto now = std::chrono::steady_clock::now();
             const float deltaSeconds = std::chrono::duration<float>(now - lastFrameTime).count();
             lastFrameTime = now;
 
-            // Begin performance monitoring
-            if (m_Impl->perfMonitor)
+            // Begin performance monitoring (pipelined mode brackets the render thread's frame instead)
+            if (m_Impl->perfMonitor && !m_Impl->pipelined)
             {
                 m_Impl->perfMonitor->beginFrame();
             }
@@ -93,37 +374,91 @@ namespace Engine
             if (!m_Impl->running)
                 break;
 
-            // Begin ImGui frame
-            if (m_Impl->imguiLayer && m_Impl->imguiLayer->isInitialized())
+            const bool imgui = m_Impl->imguiLayer && m_Impl->imguiLayer->isInitialized();
+
+            if (m_Impl->pipelined)
             {
-                m_Impl->imguiLayer->beginFrame();
-            }
+                // Simulate frame N+1 while the render thread records/submits frame N.
+                simulate(deltaSeconds);
 
-            // User update/render hooks
-            TimeStep ts{};
-            ts.DeltaSeconds = deltaSeconds;
-            OnUpdate(ts);
-            OnRender();
+                // Sync point: ImGui draw data and pass snapshots are only touched with the render thread idle.
+                {
+                    PERF_SCOPE("WaitForRenderThread");
+                    m_Impl->waitForFrame();
+                }
+                if (m_Impl->perfMonitor)
+                    m_Impl->perfMonitor->endFrame();
+                m_Impl->frameCapture.endFrame(&m_Impl->renderer->getGpuProfiler());
 
-            // End ImGui frame (this also calls the render callback)
-            if (m_Impl->imguiLayer && m_Impl->imguiLayer->isInitialized())
-            {
-                m_Impl->imguiLayer->endFrame();
-            }
+                if (imgui)
+                    m_Impl->imguiLayer->beginFrame();
+                {
+                    PERF_SCOPE("Render");
+                    OnRender();
+                }
+                m_Impl->preloader.update();
+                if (imgui)
+                    m_Impl->imguiLayer->endFrame();
 
-            // Draw one frame (includes ImGui rendering)
-            m_Impl->renderer->drawFrame();
+                m_Impl->renderer->snapshotFrame();
 
-            // End performance monitoring
-            if (m_Impl->perfMonitor)
+                {
+                    PERF_SCOPE("FramePacing");
+                    m_Impl->renderer->waitForFrameStart();
+                }
+
+                // Draw-call counts and GPU time of this frame are read at the next sync point.
+                if (m_Impl->perfMonitor)
+                    m_Impl->perfMonitor->beginFrame();
+                m_Impl->kickFrame();
+            }
+            else
             {
-                m_Impl->perfMonitor->endFrame();
+                // Begin ImGui frame
+                if (imgui)
+                {
+                    m_Impl->imguiLayer->beginFrame();
+                }
+
+                // User update/render hooks
+                simulate(deltaSeconds);
+                {
+                    PERF_SCOPE("Render");
+                    OnRender();
+                }
+                m_Impl->preloader.update();
+
+                // End ImGui frame (this also calls the render callback)
+                if (imgui)
+                {
+                    m_Impl->imguiLayer->endFrame();
+                }
+
+                // Draw one frame (includes ImGui rendering)
+                m_Impl->renderer->snapshotFrame();
+                {
+                    PERF_SCOPE("DrawFrame");
+                    m_Impl->renderer->drawFrame();
+                }
+
+                // End performance monitoring
+                if (m_Impl->perfMonitor)
+                {
+                    m_Impl->perfMonitor->endFrame();
+                }
+                m_Impl->frameCapture.endFrame(&m_Impl->renderer->getGpuProfiler());
             }
         }
+
+        m_Impl->waitForFrame();
     }
 
     void Application::handleWindowEvent(const std::string &name)
     {
+        // Shutdown and swapchain recreation destroy resources the render thread may be using.
+        if (name == "WindowClose" || name == "EscapePressed" || name == "WindowResize")
+            m_Impl->waitForFrame();
+
         if (m_Impl->eventCallback)
             m_Impl->eventCallback(name);
         if (name == "WindowClose" || name == "EscapePressed")
@@ -138,43 +473,27 @@ namespace Engine
                 m_Impl->perfMonitor->toggle();
             }
         }
+        if (name == "F2Pressed")
+        {
+            // Write the next frames to a Chrome trace file
+            m_Impl->frameCapture.request();
+        }
         if (name == "WindowResize")
         {
             // Notify renderer that swapchain-dependent resources must be recreated
             if (m_Impl->renderer)
             {
-                // Cleanup ImGui before renderer cleanup
-                if (m_Impl->imguiLayer)
-                {
-                    m_Impl->imguiLayer->cleanup();
-                }
-
-                m_Impl->renderer->cleanup(); // Destroy renderer and all its resources
                 VkExtent2D new_extent = {m_Impl->window->GetWidth(), m_Impl->window->GetHeight()};
-                m_Impl->vkContext->GetSwapChain()->Recreate(new_extent);                // destroy the swapchain and recreate with new extents
-                m_Impl->renderer->init(m_Impl->vkContext->GetSwapChain()->GetExtent()); // Re-initialize renderer resources
+                // Minimized: no swapchain can have a zero extent; the restore sends another resize.
+                if (new_extent.width == 0 || new_extent.height == 0)
+                    return;
 
-                // Reinitialize ImGui with new render pass
-                if (m_Impl->imguiLayer)
-                {
-                    uint32_t imageCount = static_cast<uint32_t>(m_Impl->vkContext->GetSwapChain()->GetImageViews().size());
-                    m_Impl->imguiLayer->init(*m_Impl->vkContext, *m_Impl->window,
-                                              m_Impl->renderer->getMainRenderPass(), imageCount);
-                    
-                    // Restore render callback
-                    m_Impl->imguiLayer->setRenderCallback([this]() {
-                        if (m_Impl->perfMonitor) {
-                            m_Impl->perfMonitor->renderOverlay();
-                        }
-                    });
-
-                    // Restore renderer's ImGui callback
-                    m_Impl->renderer->setImGuiRenderCallback([this](VkCommandBuffer cmd) {
-                        if (m_Impl->imguiLayer && m_Impl->imguiLayer->isInitialized()) {
-                            m_Impl->imguiLayer->render(cmd);
-                        }
-                    });
-                }
+                // Swapchain, depth and framebuffers only; pipelines and module resources stay alive.
+                const bool renderPassKept = m_Impl->renderer->resize(new_extent);
+
+                // Reinitialize ImGui only if it was built against a render pass that no longer exists
+                if (!renderPassKept)
+                    m_Impl->rebuildImGui();
 
                 if (m_Impl->imguiLayer)
                 {
@@ -184,6 +503,26 @@ namespace Engine
         }
     }
 
+    void Application::SetFramePacing(const FramePacing &pacing)
+    {
+        // Frame slots and the swapchain may be recreated.
+        m_Impl->waitForFrame();
+        if (!m_Impl->renderer->setFramePacing(pacing))
+            m_Impl->rebuildImGui();
+    }
+
+    void Application::SetFixedTimestep(float hz, uint32_t maxCatchUpSteps)
+    {
+        m_Impl->fixedDelta = (hz > 0.0f) ? (1.0f / hz) : 0.0f;
+        m_Impl->maxCatchUpSteps = (maxCatchUpSteps > 0) ? maxCatchUpSteps : 1u;
+        m_Impl->accumulator = 0.0f;
+    }
+
+    void Application::SetPipelinedRendering(bool enabled)
+    {
+        m_Impl->pipelined = enabled;
+    }
+
     Window &Application::GetWindow() { return *m_Impl->window; }
     VulkanContext &Application::GetVulkanContext() { return *m_Impl->vkContext; }
     Renderer &Application::GetRenderer() { return *m_Impl->renderer; }
@@ -194,6 +533,16 @@ namespace Engine
         return m_Impl->imguiLayer.get();
     }
 
+    FrameCapture &Application::GetFrameCapture()
+    {
+        return m_Impl->frameCapture;
+    }
+
+    Preloader &Application::GetPreloader()
+    {
+        return m_Impl->preloader;
+    }
+
     void Application::Close()
     {
         // Signal loop exit first
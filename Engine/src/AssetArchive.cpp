@@ -0,0 +1,480 @@
+#include "utils/AssetArchive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+#if defined(ENGINE_HAS_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace Engine
+{
+    namespace
+    {
+        std::mutex g_mountMutex;
+        std::vector<std::shared_ptr<const AssetArchive>> g_mounted; // most recent last
+
+        // Most recently mounted archive with 'path'; 'archive' keeps it alive after the lock.
+        const ArchiveEntry *findMounted(const std::string &path, std::shared_ptr<const AssetArchive> &archive)
+        {
+            std::lock_guard<std::mutex> lock(g_mountMutex);
+            for (auto it = g_mounted.rbegin(); it != g_mounted.rend(); ++it)
+            {
+                if (const ArchiveEntry *entry = (*it)->find(path))
+                {
+                    archive = *it;
+                    return entry;
+                }
+            }
+            return nullptr;
+        }
+
+        uint32_t read32(const uint8_t *p)
+        {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        // Token length continuation: 255-valued bytes then the remainder.
+        uint8_t *writeLength(uint8_t *op, size_t length)
+        {
+            while (length >= 255)
+            {
+                *op++ = 255;
+                length -= 255;
+            }
+            *op++ = static_cast<uint8_t>(length);
+            return op;
+        }
+
+        bool readLength(const uint8_t *&ip, const uint8_t *iend, size_t &length)
+        {
+            uint8_t b = 0;
+            do
+            {
+                if (ip >= iend)
+                    return false;
+                b = *ip++;
+                length += b;
+            } while (b == 255);
+            return true;
+        }
+    }
+
+    std::string NormalizeArchivePath(const std::string &path)
+    {
+        std::string out = path;
+        std::replace(out.begin(), out.end(), '\\', '/');
+        while (out.compare(0, 2, "./") == 0)
+            out.erase(0, 2);
+        return out;
+    }
+
+    uint64_t ArchivePathHash(const std::string &normalizedPath)
+    {
+        uint64_t h = 1469598103934665603ull;
+        for (const char c : normalizedPath)
+        {
+            h ^= static_cast<uint8_t>(c);
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    // ------------------------------------------------------------
+    // LZ4 block format: sequences of [token][literal length+][literals][offset16][match length+].
+    // Greedy single-probe matcher; the decoder is the bounds-checked reference loop.
+    // ------------------------------------------------------------
+    size_t Lz4CompressBound(size_t srcSize)
+    {
+        return srcSize + srcSize / 255 + 16;
+    }
+
+    size_t Lz4CompressBlock(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t capacity)
+    {
+        constexpr uint32_t kHashBits = 16;
+        constexpr size_t kMinMatch = 4;
+        constexpr size_t kLastLiterals = 5; // the block ends in at least 5 literals
+        constexpr size_t kMatchLimit = 12;  // no match starts in the last 12 bytes
+        constexpr size_t kMaxOffset = 65535;
+
+        std::vector<uint32_t> table(size_t(1) << kHashBits, 0); // position + 1, 0 = empty
+        uint8_t *op = dst;
+        uint8_t *const oend = dst + capacity;
+
+        auto emit = [&](size_t anchor, size_t literals, size_t offset, size_t matchLength) -> bool
+        {
+            const size_t worst = 1 + literals / 255 + 1 + literals + 2 + matchLength / 255 + 1;
+            if (worst > size_t(oend - op))
+                return false;
+
+            uint8_t *token = op++;
+            *token = static_cast<uint8_t>(std::min<size_t>(literals, 15) << 4);
+            if (literals >= 15)
+                op = writeLength(op, literals - 15);
+            std::memcpy(op, src + anchor, literals);
+            op += literals;
+
+            if (matchLength == 0)
+                return true;
+            *op++ = static_cast<uint8_t>(offset & 0xFF);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+            const size_t ml = matchLength - kMinMatch;
+            *token |= static_cast<uint8_t>(std::min<size_t>(ml, 15));
+            if (ml >= 15)
+                op = writeLength(op, ml - 15);
+            return true;
+        };
+
+        size_t anchor = 0;
+        if (srcSize > kMatchLimit)
+        {
+            const size_t matchStartEnd = srcSize - kMatchLimit;
+            const size_t matchEnd = srcSize - kLastLiterals;
+            size_t ip = 0;
+            while (ip < matchStartEnd)
+            {
+                const uint32_t seq = read32(src + ip);
+                const uint32_t h = (seq * 2654435761u) >> (32 - kHashBits);
+                const uint32_t candidate = table[h];
+                table[h] = static_cast<uint32_t>(ip + 1);
+
+                if (candidate == 0 || ip - (candidate - 1) > kMaxOffset || read32(src + candidate - 1) != seq)
+                {
+                    ++ip;
+                    continue;
+                }
+
+                const size_t ref = candidate - 1;
+                size_t length = kMinMatch;
+                while (ip + length < matchEnd && src[ref + length] == src[ip + length])
+                    ++length;
+
+                if (!emit(anchor, ip - anchor, ip - ref, length))
+                    return 0;
+                ip += length;
+                anchor = ip;
+            }
+        }
+
+        if (!emit(anchor, srcSize - anchor, 0, 0))
+            return 0;
+        return static_cast<size_t>(op - dst);
+    }
+
+    bool Lz4DecompressBlock(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize)
+    {
+        const uint8_t *ip = src;
+        const uint8_t *const iend = src + srcSize;
+        uint8_t *op = dst;
+        uint8_t *const oend = dst + dstSize;
+
+        while (ip < iend)
+        {
+            const uint8_t token = *ip++;
+
+            size_t literals = token >> 4;
+            if (literals == 15 && !readLength(ip, iend, literals))
+                return false;
+            if (literals > size_t(iend - ip) || literals > size_t(oend - op))
+                return false;
+            std::memcpy(op, ip, literals);
+            ip += literals;
+            op += literals;
+
+            if (ip == iend)
+                break; // last sequence: literals only
+
+            if (iend - ip < 2)
+                return false;
+            const size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+            ip += 2;
+            if (offset == 0 || offset > size_t(op - dst))
+                return false;
+
+            size_t length = token & 15;
+            if (length == 15 && !readLength(ip, iend, length))
+                return false;
+            length += 4;
+            if (length > size_t(oend - op))
+                return false;
+
+            // Byte loop: matches may overlap their own output (runs).
+            const uint8_t *match = op - offset;
+            for (size_t i = 0; i < length; ++i)
+                op[i] = match[i];
+            op += length;
+        }
+        return op == oend;
+    }
+
+    bool ArchiveCodecAvailable(ArchiveCodec codec)
+    {
+        switch (codec)
+        {
+        case ArchiveCodec::Stored:
+        case ArchiveCodec::LZ4:
+            return true;
+        case ArchiveCodec::Zstd:
+#if defined(ENGINE_HAS_ZSTD)
+            return true;
+#else
+            return false;
+#endif
+        }
+        return false;
+    }
+
+    bool CompressArchiveEntry(ArchiveCodec codec, const uint8_t *src, size_t srcSize, std::vector<uint8_t> &out)
+    {
+        std::vector<uint8_t> packed;
+        size_t packedSize = 0;
+        switch (codec)
+        {
+        case ArchiveCodec::LZ4:
+            // Only worth keeping if smaller, so the input size bounds the output.
+            packed.resize(srcSize);
+            packedSize = Lz4CompressBlock(src, srcSize, packed.data(), packed.size());
+            break;
+        case ArchiveCodec::Zstd:
+#if defined(ENGINE_HAS_ZSTD)
+        {
+            packed.resize(ZSTD_compressBound(srcSize));
+            const size_t r = ZSTD_compress(packed.data(), packed.size(), src, srcSize, 19);
+            packedSize = ZSTD_isError(r) ? 0 : r;
+            break;
+        }
+#else
+            return false;
+#endif
+        case ArchiveCodec::Stored:
+            return false;
+        }
+
+        if (packedSize == 0 || packedSize >= srcSize)
+            return false;
+        packed.resize(packedSize);
+        out = std::move(packed);
+        return true;
+    }
+
+    // ------------------------------------------------------------
+    // AssetArchive
+    // ------------------------------------------------------------
+    bool AssetArchive::open(const std::string &path, std::string &outError)
+    {
+        m_entries = nullptr;
+        m_entryCount = 0;
+        m_paths = nullptr;
+        m_pathsSize = 0;
+        m_path = path;
+        if (!m_file.open(path, outError))
+            return false;
+
+        const uint8_t *base = m_file.data();
+        const uint64_t fileSize = m_file.size();
+        if (fileSize < sizeof(ArchiveHeader))
+        {
+            outError = "Archive too small: " + path;
+            return false;
+        }
+
+        ArchiveHeader header{};
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, kArchiveMagic, sizeof(kArchiveMagic)) != 0)
+        {
+            outError = "Not an asset archive: " + path;
+            return false;
+        }
+        if (header.versionMajor != kArchiveVersionMajor || header.headerSize != sizeof(ArchiveHeader))
+        {
+            outError = "Unsupported asset archive version: " + path;
+            return false;
+        }
+        if (header.fileSizeBytes != fileSize ||
+            header.tocOffset % alignof(ArchiveEntry) != 0 ||
+            header.tocOffset > fileSize ||
+            uint64_t(header.entryCount) * sizeof(ArchiveEntry) > fileSize - header.tocOffset ||
+            header.pathsOffset > fileSize || header.pathsSize > fileSize - header.pathsOffset)
+        {
+            outError = "Corrupt asset archive header: " + path;
+            return false;
+        }
+
+        const ArchiveEntry *entries = reinterpret_cast<const ArchiveEntry *>(base + header.tocOffset);
+        for (uint32_t i = 0; i < header.entryCount; ++i)
+        {
+            const ArchiveEntry &e = entries[i];
+            const bool pathOk = uint64_t(e.pathOffset) + e.pathSize <= header.pathsSize;
+            const bool dataOk = e.dataOffset % kArchiveAlignment == 0 && e.dataOffset <= fileSize &&
+                                e.storedSize <= fileSize - e.dataOffset;
+            const bool codecOk = e.codec <= uint32_t(ArchiveCodec::Zstd) &&
+                                 (e.codec != uint32_t(ArchiveCodec::Stored) || e.storedSize == e.size);
+            const bool sorted = i == 0 || entries[i - 1].pathHash <= e.pathHash;
+            if (!pathOk || !dataOk || !codecOk || !sorted)
+            {
+                outError = "Corrupt asset archive entry " + std::to_string(i) + ": " + path;
+                return false;
+            }
+        }
+
+        m_entries = entries;
+        m_entryCount = header.entryCount;
+        m_paths = reinterpret_cast<const char *>(base + header.pathsOffset);
+        m_pathsSize = header.pathsSize;
+        return true;
+    }
+
+    std::string AssetArchive::entryPath(const ArchiveEntry &e) const
+    {
+        return std::string(m_paths + e.pathOffset, e.pathSize);
+    }
+
+    const ArchiveEntry *AssetArchive::find(const std::string &path) const
+    {
+        const std::string key = NormalizeArchivePath(path);
+        const uint64_t hash = ArchivePathHash(key);
+
+        const ArchiveEntry *end = m_entries + m_entryCount;
+        const ArchiveEntry *it = std::lower_bound(m_entries, end, hash,
+                                                  [](const ArchiveEntry &e, uint64_t h)
+                                                  { return e.pathHash < h; });
+        for (; it != end && it->pathHash == hash; ++it)
+        {
+            if (it->pathSize == key.size() && std::memcmp(m_paths + it->pathOffset, key.data(), key.size()) == 0)
+                return it;
+        }
+        return nullptr;
+    }
+
+    bool AssetArchive::openEntry(const std::shared_ptr<const AssetArchive> &self, const ArchiveEntry &e,
+                                 MappedFile &out, std::string &outError)
+    {
+        const uint8_t *stored = self->m_file.data() + e.dataOffset;
+        const ArchiveCodec codec = static_cast<ArchiveCodec>(e.codec);
+
+        if (e.size == 0)
+        {
+            // MappedFile treats empty files as unreadable; keep that behaviour.
+            outError = "File is empty: " + self->entryPath(e);
+            return false;
+        }
+
+        if (codec == ArchiveCodec::Stored)
+        {
+            out.adopt(stored, e.size, self);
+            return true;
+        }
+
+        auto bytes = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(e.size));
+        bool ok = false;
+        if (codec == ArchiveCodec::LZ4)
+        {
+            ok = Lz4DecompressBlock(stored, static_cast<size_t>(e.storedSize), bytes->data(), bytes->size());
+        }
+        else if (codec == ArchiveCodec::Zstd)
+        {
+#if defined(ENGINE_HAS_ZSTD)
+            const size_t r = ZSTD_decompress(bytes->data(), bytes->size(), stored, static_cast<size_t>(e.storedSize));
+            ok = !ZSTD_isError(r) && r == bytes->size();
+#else
+            outError = "Zstd archive entry but the engine was built without Zstd: " + self->entryPath(e);
+            return false;
+#endif
+        }
+
+        if (!ok)
+        {
+            outError = "Failed to decompress archive entry: " + self->entryPath(e);
+            return false;
+        }
+
+        const uint8_t *data = bytes->data();
+        out.adopt(data, e.size, std::move(bytes));
+        return true;
+    }
+
+    bool AssetArchive::mount(const std::string &archivePath, std::string &outError)
+    {
+        // Open outside the lock: MappedFile::open() itself consults the mounts.
+        auto archive = std::make_shared<AssetArchive>();
+        if (!archive->open(archivePath, outError))
+            return false;
+
+        std::lock_guard<std::mutex> lock(g_mountMutex);
+        g_mounted.push_back(std::move(archive));
+        return true;
+    }
+
+    void AssetArchive::unmountAll()
+    {
+        std::lock_guard<std::mutex> lock(g_mountMutex);
+        g_mounted.clear();
+    }
+
+    bool AssetArchive::anyMounted()
+    {
+        std::lock_guard<std::mutex> lock(g_mountMutex);
+        return !g_mounted.empty();
+    }
+
+    std::vector<std::string> AssetArchive::listMounted(const std::string &directory, const std::string &extension)
+    {
+        std::string prefix = NormalizeArchivePath(directory);
+        if (!prefix.empty() && prefix.back() != '/')
+            prefix += '/';
+
+        std::vector<std::string> out;
+        std::lock_guard<std::mutex> lock(g_mountMutex);
+        for (const auto &archive : g_mounted)
+        {
+            for (uint32_t i = 0; i < archive->m_entryCount; ++i)
+            {
+                const ArchiveEntry &e = archive->m_entries[i];
+                const char *p = archive->m_paths + e.pathOffset;
+                const size_t n = e.pathSize;
+                if (n <= prefix.size() + extension.size() ||
+                    std::memcmp(p, prefix.data(), prefix.size()) != 0 ||
+                    std::memcmp(p + n - extension.size(), extension.data(), extension.size()) != 0 ||
+                    std::memchr(p + prefix.size(), '/', n - prefix.size()) != nullptr)
+                    continue;
+                out.emplace_back(p, n);
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+
+    bool AssetArchive::openMounted(const std::string &path, MappedFile &out, std::string &outError, bool &handled)
+    {
+        std::shared_ptr<const AssetArchive> archive;
+        const ArchiveEntry *entry = findMounted(path, archive);
+        handled = entry != nullptr;
+        if (!entry)
+            return false;
+
+        // Decompression happens outside the lock so loader threads do not serialize on it.
+        return openEntry(archive, *entry, out, outError);
+    }
+
+    bool AssetArchive::openMountedStored(const std::string &path, MappedFile &out, std::string &outError, bool &handled)
+    {
+        std::shared_ptr<const AssetArchive> archive;
+        const ArchiveEntry *entry = findMounted(path, archive);
+        handled = entry != nullptr;
+        if (!entry)
+            return false;
+
+        if (entry->storedSize == 0)
+        {
+            outError = "File is empty: " + archive->entryPath(*entry);
+            return false;
+        }
+        out.adopt(archive->m_file.data() + entry->dataOffset, entry->storedSize, archive);
+        return true;
+    }
+
+} // namespace Engine
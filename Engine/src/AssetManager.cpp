@@ -1,11 +1,10 @@
 #include "assets/AssetManager.h"
+#include "assets/ModelBuild.h"
 #include "utils/ImageUtils.h" // UploadContext
-
-// Needed for glm/gtx/* headers (matrix_decompose)
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/glm.hpp>
-#include <glm/gtc/type_ptr.hpp>
-#include <glm/gtx/matrix_decompose.hpp>
+#include "utils/MappedFile.h"
+#include "ECS/WorkerPool.h"
+#include "Engine/GpuAllocator.h"
+#include "Engine/Profiler.h"
 
 #include <utility>
 #include <cstring>
@@ -14,22 +13,11 @@
 #include <functional>
 #include <iostream>
 
-#include <fstream>
 #include <iterator>
+#include <string>
 
-const float TARGET = 10.0f; // Target size of models after scaling
 namespace Engine
 {
-    static ModelAsset::NodeTRS DecomposeTRS(const glm::mat4 &m)
-    {
-        ModelAsset::NodeTRS out{};
-        glm::vec3 skew;
-        glm::vec4 perspective;
-        glm::decompose(m, out.s, out.r, out.t, skew, perspective);
-        out.r = glm::normalize(out.r);
-        return out;
-    }
-
     // ------------------------------------------------------------
     // Helpers: map smodel enum ints -> Vulkan settings
     // ------------------------------------------------------------
@@ -76,9 +64,121 @@ namespace Engine
         }
     }
 
+    // Block-compressed texture record as a view into the (mapped) .smodel blob.
+    static bool blockImageFromRecord(const smodel::SModelFileView &view, const smodel::SModelTextureRecord &t,
+                                     BlockCompressedImage &out)
+    {
+        if (!smodel::IsBlockCompressed(t.encoding) || t.imageDataSize < sizeof(smodel::SModelBlockImageHeader))
+            return false;
+
+        smodel::SModelBlockImageHeader header{};
+        std::memcpy(&header, view.blob + t.imageDataOffset, sizeof(header));
+
+        const bool srgb = (t.colorSpace == 1);
+        switch (static_cast<smodel::ImageEncoding>(t.encoding))
+        {
+        case smodel::ImageEncoding::BC7:
+            out.format = srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+            break;
+        case smodel::ImageEncoding::BC5:
+            out.format = VK_FORMAT_BC5_UNORM_BLOCK;
+            break;
+        default:
+            out.format = srgb ? VK_FORMAT_ASTC_4x4_SRGB_BLOCK : VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+            break;
+        }
+
+        out.width = header.width;
+        out.height = header.height;
+        out.mipLevels = header.mipCount;
+        out.data = view.blob + t.imageDataOffset + sizeof(header);
+        out.size = t.imageDataSize - sizeof(header);
+        return true;
+    }
+
+    static bool uploadBlockTexture(UploadContext &upload, TextureAsset &tex,
+                                   const smodel::SModelFileView &view, const smodel::SModelTextureRecord &t,
+                                   uint32_t firstLevel = 0)
+    {
+        BlockCompressedImage image;
+        if (blockImageFromRecord(view, t, image) &&
+            tex.uploadBlockCompressed_Deferred(upload, image,
+                                               toVkWrap(t.wrapU), toVkWrap(t.wrapV),
+                                               toVkFilter(t.minFilter), toVkFilter(t.magFilter),
+                                               toVkMip(t.mipFilter), t.maxAnisotropy, firstLevel))
+            return true;
+
+        std::cerr << "[AssetManager] Block-compressed texture rejected (format unsupported by device or bad mip chain)\n";
+        return false;
+    }
+
+    // Mesh record as a view into the (mapped) .smodel blob; ranges were validated by LoadSModelFile.
+    static MeshDataView meshViewFromRecord(const smodel::SModelFileView &view, uint32_t i)
+    {
+        const auto &mr = view.meshes[i];
+
+        MeshDataView md;
+        md.vertexCount = mr.vertexCount;
+        md.indexCount = mr.indexCount;
+        md.vertexStride = mr.vertexStride;
+        md.indexFormat = (mr.indexType == 0) ? 0 : 1;
+        md.layoutFlags = mr.layoutFlags;
+
+        std::memcpy(md.aabbMin, mr.aabbMin, sizeof(md.aabbMin));
+        std::memcpy(md.aabbMax, mr.aabbMax, sizeof(md.aabbMax));
+
+        md.vertexBytes = view.blob + mr.vertexDataOffset;
+        md.vertexByteSize = mr.vertexDataSize;
+        md.indexBytes = view.blob + mr.indexDataOffset;
+        md.indexByteSize = uint64_t(md.indexCount) * (md.indexFormat == 0 ? sizeof(uint16_t) : sizeof(uint32_t));
+        return md;
+    }
+
+    // Through MappedFile so mounted archives (AssetArchive) serve image files too.
+    static bool readFileBytes(const std::string &path, std::vector<uint8_t> &out)
+    {
+        MappedFile file;
+        std::string error;
+        if (!file.open(path, error))
+            return false;
+
+        out.assign(file.data(), file.data() + file.size());
+        return true;
+    }
+
     // ------------------------------------------------------------
     // AssetManager
     // ------------------------------------------------------------
+    // One request travelling disk -> worker (decode) -> transfer queue -> registration.
+    struct AssetManager::StreamJob
+    {
+        enum class Kind
+        {
+            Texture,
+            Model,
+            TextureMips // reload of a resident texture with another first mip level
+        } kind = Kind::Texture;
+        std::string path;
+        uint64_t id = 0; // reserved texture/model id
+        int32_t sourceTexture = -1; // TextureMips: texture record in the .smodel at path, -1: image file
+        uint32_t firstLevel = 0;    // TextureMips
+        uint64_t requestNs = 0;     // CpuProfiler::nowNs() at enqueue, for load latency
+
+        // Worker output
+        bool decoded = false;
+        std::string error;
+        std::unique_ptr<smodel::SModelFileView> view; // Kind::Model
+        std::vector<DecodedImage> images;             // one per texture (view order for models)
+        std::vector<MeshDataView> meshes;             // one per view mesh (points into view)
+
+        // Upload (main thread)
+        UploadContext upload;
+        uint64_t timelineValue = 0;
+        VkFence fence = VK_NULL_HANDLE;
+        std::vector<std::unique_ptr<TextureAsset>> textures;
+        std::vector<std::unique_ptr<MeshAsset>> meshAssets;
+    };
+
     AssetManager::AssetManager(VkDevice device,
                                VkPhysicalDevice phys,
                                VkQueue graphicsQueue,
@@ -86,25 +186,96 @@ namespace Engine
         : m_device(device),
           m_phys(phys),
           m_graphicsQueue(graphicsQueue),
-          m_graphicsQueueFamilyIndex(graphicsQueueFamilyIndex)
+          m_graphicsQueueFamilyIndex(graphicsQueueFamilyIndex),
+          m_transferQueue(graphicsQueue),
+          m_transferQueueFamilyIndex(graphicsQueueFamilyIndex)
     {
+        m_geometry = std::make_unique<GeometryPool>(device, phys);
+        m_geometry->setQueueFamilies({graphicsQueueFamilyIndex});
+
+        m_memoryReport = MemoryStats::Registration([this](std::vector<MemoryStats::Counter> &out)
+                                                   {
+            const MemoryUsage usage = memoryUsage();
+            MemoryStats::Counter c;
+            c.subsystem = "Assets";
+            c.name = "Meshes";
+            c.gpuBytes = usage.meshGpuBytes;
+            c.count = usage.meshCount;
+            out.push_back(c);
+            c.name = "Textures";
+            c.gpuBytes = usage.textureGpuBytes;
+            c.count = usage.textureCount;
+            out.push_back(c);
+            c.name = "Models";
+            c.gpuBytes = 0;
+            c.cpuBytes = usage.modelCpuBytes;
+            c.count = usage.modelCount;
+            out.push_back(c);
+            c.name = "Materials";
+            c.cpuBytes = usage.materialCount * sizeof(MaterialAsset);
+            c.count = usage.materialCount;
+            out.push_back(c); });
+
+        m_telemetryReport = Telemetry::Registration([this](const Telemetry::Config &, std::vector<Telemetry::Metric> &out)
+                                                    {
+            m_loadLatency.appendAndReset("asset_load_ms", out);
+            Telemetry::Metric m;
+            m.name = "asset_load_failures";
+            m.value = m_loadFailures;
+            out.push_back(m);
+            m.name = "asset_streams_pending";
+            m.value = m_streamPending;
+            out.push_back(m);
+            m_loadFailures = 0; });
+    }
+
+    AssetManager::MemoryUsage AssetManager::memoryUsage() const
+    {
+        MemoryUsage usage{};
+        m_meshes.forEach([&](uint64_t, const MeshEntry &e)
+                         {
+            if (!e.asset)
+                return;
+            usage.meshCount++;
+            usage.meshGpuBytes += e.asset->gpuBytes(); });
+        m_textures.forEach([&](uint64_t, const TextureEntry &e)
+                           {
+            if (!e.asset)
+                return;
+            usage.textureCount++;
+            usage.textureGpuBytes += e.asset->gpuBytes(); });
+        m_materials.forEach([&](uint64_t, const MaterialEntry &e)
+                            {
+            if (e.asset)
+                usage.materialCount++; });
+        m_models.forEach([&](uint64_t, const ModelEntry &e)
+                         {
+            if (!e.asset)
+                return;
+            usage.modelCount++;
+            usage.modelCpuBytes += e.asset->cpuBytes(); });
+        return usage;
     }
 
     AssetManager::~AssetManager()
     {
+        shutdownStreaming();
+        tickRetiredAssets_Internal(true);
+
         // Destroy meshes
-        for (auto &kv : m_meshes)
-        {
-            if (kv.second.asset)
-                kv.second.asset->destroy(m_device);
-        }
+        m_meshes.forEach([&](uint64_t, MeshEntry &e)
+                         {
+            if (e.asset)
+                e.asset->destroy(m_device); });
 
         // Destroy textures
-        for (auto &kv : m_textures)
-        {
-            if (kv.second.asset)
-                kv.second.asset->destroy(m_device);
-        }
+        m_textures.forEach([&](uint64_t, TextureEntry &e)
+                           {
+            if (e.asset)
+                e.asset->destroy(m_device); });
+
+        // Every pooled mesh has returned its ranges
+        m_geometry.reset();
 
         // Materials + Models are CPU only (no gpu destroy needed)
         m_meshes.clear();
@@ -128,11 +299,16 @@ namespace Engine
             return it->second;
         }
 
-        MeshData data;
-        if (!LoadSMeshV0FromFile(cookedMeshPath, data))
+        // Mapped for the duration of the upload; sections are staged straight from the file.
+        SMeshFileView file;
+        std::string err;
+        if (!LoadSMeshFile(cookedMeshPath, file, err))
+        {
+            std::cerr << "[AssetManager] loadMesh: Failed to load .smesh: " << err << "\n";
             return MeshHandle{};
+        }
 
-        MeshHandle h = createMeshFromData_Internal(data, cookedMeshPath, 1);
+        MeshHandle h = createMeshFromData_Internal(file.mesh, cookedMeshPath, 1);
         if (h.isValid())
             m_meshPathCache.emplace(cookedMeshPath, h);
 
@@ -141,32 +317,24 @@ namespace Engine
 
     MeshAsset *AssetManager::getMesh(MeshHandle h)
     {
-        auto it = m_meshes.find(h.id);
-        if (it == m_meshes.end())
-            return nullptr;
-        if (it->second.generation != h.generation)
-            return nullptr;
-        return it->second.asset.get();
+        auto *e = m_meshes.get(h);
+        return e ? e->asset.get() : nullptr;
     }
 
     void AssetManager::addRef(MeshHandle h)
     {
-        auto it = m_meshes.find(h.id);
-        if (it != m_meshes.end() && it->second.generation == h.generation)
-            it->second.refCount++;
+        if (auto *e = m_meshes.get(h))
+            e->refCount++;
     }
 
     void AssetManager::release(MeshHandle h)
     {
-        auto it = m_meshes.find(h.id);
-        if (it != m_meshes.end() && it->second.generation == h.generation)
-        {
-            if (it->second.refCount > 0)
-                it->second.refCount--;
-        }
+        auto *e = m_meshes.get(h);
+        if (e && e->refCount > 0)
+            e->refCount--;
     }
 
-    MeshHandle AssetManager::createMeshFromData_Internal(const MeshData &data, const std::string &path, uint32_t initialRef)
+    MeshHandle AssetManager::createMeshFromData_Internal(const MeshDataView &data, const std::string &path, uint32_t initialRef)
     {
         // Transient pool per mesh upload
         VkCommandPoolCreateInfo poolInfo{};
@@ -180,21 +348,25 @@ namespace Engine
             return MeshHandle{};
 
         auto asset = std::make_unique<MeshAsset>();
-        const bool ok = asset->upload(m_device, m_phys, uploadPool, m_graphicsQueue, data);
+        const bool ok = asset->upload(m_device, m_phys, uploadPool, m_graphicsQueue, data, m_geometry.get());
 
         vkDestroyCommandPool(m_device, uploadPool, nullptr);
 
         if (!ok)
             return MeshHandle{};
 
-        const uint64_t id = m_nextMeshID++;
+        return registerMesh_Internal(std::move(asset), path, initialRef);
+    }
+
+    MeshHandle AssetManager::registerMesh_Internal(std::unique_ptr<MeshAsset> mesh, const std::string &path, uint32_t initialRef)
+    {
         MeshEntry entry;
-        entry.asset = std::move(asset);
+        entry.asset = std::move(mesh);
         entry.generation = 1;
         entry.refCount = initialRef;
         entry.path = path;
 
-        m_meshes.emplace(id, std::move(entry));
+        const uint64_t id = m_meshes.insert(std::move(entry));
 
         MeshHandle h;
         h.id = id;
@@ -207,13 +379,12 @@ namespace Engine
     // ------------------------------------------------------------
     TextureHandle AssetManager::createTexture_Internal(std::unique_ptr<TextureAsset> tex, uint32_t initialRef)
     {
-        const uint64_t id = m_nextTextureID++;
         TextureEntry e;
         e.asset = std::move(tex);
         e.generation = 1;
         e.refCount = initialRef;
 
-        m_textures.emplace(id, std::move(e));
+        const uint64_t id = m_textures.insert(std::move(e));
 
         TextureHandle h;
         h.id = id;
@@ -223,29 +394,15 @@ namespace Engine
 
     TextureAsset *AssetManager::getTexture(TextureHandle h)
     {
-        auto it = m_textures.find(h.id);
-        if (it == m_textures.end())
-            return nullptr;
-        if (it->second.generation != h.generation)
-            return nullptr;
-        return it->second.asset.get();
+        auto *e = m_textures.get(h);
+        return e ? e->asset.get() : nullptr;
     }
 
     Engine::TextureHandle AssetManager::loadTextureFromFile(const std::string &filePath)
 {
     // Read file contents into a vector<uint8_t>
-    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
-    if (!file)
-        return TextureHandle{};
-
-    const std::streamsize size = file.tellg();
-    if (size <= 0)
-        return TextureHandle{};
-
-    file.seekg(0, std::ios::beg);
     std::vector<uint8_t> bytes;
-    bytes.resize(static_cast<size_t>(size));
-    if (!file.read(reinterpret_cast<char*>(bytes.data()), size))
+    if (!readFileBytes(filePath, bytes))
         return TextureHandle{};
 
     // Create upload pool for single texture (similar to loadModel)
@@ -305,24 +462,21 @@ namespace Engine
 
     // Create a texture entry with refCount = 1 (caller gets an owned handle)
     TextureHandle th = createTexture_Internal(std::move(tex), 1);
+    m_textures.get(th)->sourcePath = filePath;
     return th;
 }
 
     void AssetManager::addRef(TextureHandle h)
     {
-        auto it = m_textures.find(h.id);
-        if (it != m_textures.end() && it->second.generation == h.generation)
-            it->second.refCount++;
+        if (auto *e = m_textures.get(h))
+            e->refCount++;
     }
 
     void AssetManager::release(TextureHandle h)
     {
-        auto it = m_textures.find(h.id);
-        if (it != m_textures.end() && it->second.generation == h.generation)
-        {
-            if (it->second.refCount > 0)
-                it->second.refCount--;
-        }
+        auto *e = m_textures.get(h);
+        if (e && e->refCount > 0)
+            e->refCount--;
     }
 
     // ------------------------------------------------------------
@@ -330,7 +484,6 @@ namespace Engine
     // ------------------------------------------------------------
     MaterialHandle AssetManager::createMaterial_Internal(std::unique_ptr<MaterialAsset> mat, uint32_t initialRef)
     {
-        const uint64_t id = m_nextMaterialID++;
         MaterialEntry e;
         e.asset = std::move(mat);
         e.generation = 1;
@@ -351,7 +504,7 @@ namespace Engine
                 e.textureDeps.push_back(e.asset->emissiveTexture);
         }
 
-        m_materials.emplace(id, std::move(e));
+        const uint64_t id = m_materials.insert(std::move(e));
 
         MaterialHandle h;
         h.id = id;
@@ -361,29 +514,21 @@ namespace Engine
 
     MaterialAsset *AssetManager::getMaterial(MaterialHandle h)
     {
-        auto it = m_materials.find(h.id);
-        if (it == m_materials.end())
-            return nullptr;
-        if (it->second.generation != h.generation)
-            return nullptr;
-        return it->second.asset.get();
+        auto *e = m_materials.get(h);
+        return e ? e->asset.get() : nullptr;
     }
 
     void AssetManager::addRef(MaterialHandle h)
     {
-        auto it = m_materials.find(h.id);
-        if (it != m_materials.end() && it->second.generation == h.generation)
-            it->second.refCount++;
+        if (auto *e = m_materials.get(h))
+            e->refCount++;
     }
 
     void AssetManager::release(MaterialHandle h)
     {
-        auto it = m_materials.find(h.id);
-        if (it != m_materials.end() && it->second.generation == h.generation)
-        {
-            if (it->second.refCount > 0)
-                it->second.refCount--;
-        }
+        auto *e = m_materials.get(h);
+        if (e && e->refCount > 0)
+            e->refCount--;
     }
 
     // ------------------------------------------------------------
@@ -391,15 +536,15 @@ namespace Engine
     // ------------------------------------------------------------
     ModelHandle AssetManager::createModel_Internal(std::unique_ptr<ModelAsset> model, const std::string &path, uint32_t initialRef)
     {
-        const uint64_t id = m_nextModelID++;
         ModelEntry e;
         e.asset = std::move(model);
         e.generation = 1;
         e.refCount = initialRef;
         e.path = path;
+        e.lastUsedFrame = m_residencyFrame;
 
         // Dependencies (fill later in loadModel)
-        m_models.emplace(id, std::move(e));
+        const uint64_t id = m_models.insert(std::move(e));
 
         ModelHandle h;
         h.id = id;
@@ -409,100 +554,284 @@ namespace Engine
 
     ModelHandle AssetManager::loadModel(const std::string &cookedModelPath)
     {
-        auto it = m_modelPathCache.find(cookedModelPath);
-        if (it != m_modelPathCache.end())
+        return loadModels({cookedModelPath})[0];
+    }
+
+    std::vector<ModelHandle> AssetManager::loadModels(const std::vector<std::string> &cookedModelPaths)
+    {
+        std::vector<ModelHandle> result(cookedModelPaths.size());
+
+        // Models of this batch that are not cached yet (a repeated path loads once)
+        struct BatchLoad
         {
-            addRef(it->second);
-            return it->second;
-        }
+            size_t slot = 0;
+            smodel::SModelFileView view;
+            std::vector<std::unique_ptr<TextureAsset>> textures;
+            std::vector<std::unique_ptr<MeshAsset>> meshes;
+            std::vector<DecodedImage> images; // decoded PNG/JPG (empty for block textures)
+            bool ok = true;
+        };
+        std::vector<std::unique_ptr<BatchLoad>> loads;
+        std::unordered_map<std::string, size_t> firstSlot;
 
         // --------------------------
-        // Parse cooked .smodel file
+        // Parse cooked .smodel files and size the staging arena
         // --------------------------
-        Engine::smodel::SModelFileView view;
-        std::string err;
-        if (!Engine::smodel::LoadSModelFile(cookedModelPath, view, err))
+        VkDeviceSize stagingBytes = 0;
+        for (size_t i = 0; i < cookedModelPaths.size(); ++i)
         {
-            std::cerr << "[AssetManager] loadModel: Failed to load .smodel: " << err << "\n";
-            return ModelHandle{};
-        }
+            const std::string &path = cookedModelPaths[i];
+            auto cached = m_modelPathCache.find(path);
+            if (cached != m_modelPathCache.end())
+            {
+                addRef(cached->second);
+                result[i] = cached->second;
+                continue;
+            }
+            if (!firstSlot.emplace(path, i).second)
+                continue;
 
-        // --------------------------
-        // Create upload pool for all textures (single submit)
-        // --------------------------
-        VkCommandPoolCreateInfo poolInfo{};
-        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        poolInfo.queueFamilyIndex = m_graphicsQueueFamilyIndex;
-        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            auto load = std::make_unique<BatchLoad>();
+            load->slot = i;
+            std::string err;
+            if (!Engine::smodel::LoadSModelFile(path, load->view, err))
+            {
+                std::cerr << "[AssetManager] loadModel: Failed to load .smodel: " << err << "\n";
+                continue;
+            }
 
-        VkCommandPool uploadPool = VK_NULL_HANDLE;
-        VkResult pr = vkCreateCommandPool(m_device, &poolInfo, nullptr, &uploadPool);
-        if (pr != VK_SUCCESS)
-            return ModelHandle{};
+            const smodel::SModelFileView &view = load->view;
+            for (uint32_t t = 0; t < view.textureCount(); ++t)
+            {
+                const auto &tr = view.textures[t];
+                if (smodel::IsBlockCompressed(tr.encoding))
+                    stagingBytes += StagingFootprint(tr.imageDataSize);
+                else
+                    stagingBytes += TextureAsset::stagingBytesForEncoded(view.blob + tr.imageDataOffset,
+                                                                         static_cast<size_t>(tr.imageDataSize));
+            }
+            for (uint32_t m = 0; m < view.meshCount(); ++m)
+                stagingBytes += MeshAsset::stagingBytes(meshViewFromRecord(view, m));
 
-        Engine::UploadContext upload{};
-        if (!Engine::BeginUploadContext(upload, m_device, m_phys, uploadPool, m_graphicsQueue))
-        {
-            vkDestroyCommandPool(m_device, uploadPool, nullptr);
-            return ModelHandle{};
+            // Start reading the blob in while the rest of the batch parses.
+            load->view.file.prefetch(view.header->blobOffset, view.header->blobSize);
+            loads.push_back(std::move(load));
         }
 
-        // --------------------------
-        // Upload textures (deferred)
-        // --------------------------
-        std::vector<TextureHandle> textureHandles;
-        textureHandles.resize(view.textureCount());
-
-        for (uint32_t i = 0; i < view.textureCount(); i++)
+        if (!loads.empty())
         {
-            const auto &t = view.textures[i];
+            // --------------------------
+            // Record textures + meshes of every model into one command buffer
+            // --------------------------
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.queueFamilyIndex = m_graphicsQueueFamilyIndex;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+            VkCommandPool uploadPool = VK_NULL_HANDLE;
+            Engine::UploadContext upload{};
+            bool begun = vkCreateCommandPool(m_device, &poolInfo, nullptr, &uploadPool) == VK_SUCCESS &&
+                         Engine::BeginUploadContext(upload, m_device, m_phys, uploadPool, m_graphicsQueue);
+
+            // One staging buffer for the whole batch (StageUpload adds chunks if this fails)
+            if (begun)
+                Engine::ReserveStaging(upload, stagingBytes);
+
+            // Decode every PNG/JPG texture of the batch on the pool while one task stages the meshes
+            // (the command buffer is only ever touched by that task, then by this thread).
+            struct DecodeItem
+            {
+                BatchLoad *load;
+                uint32_t texture;
+            };
+            std::vector<DecodeItem> decodes;
+            for (auto &load : loads)
+            {
+                load->ok = begun;
+                load->images.resize(load->view.textureCount());
+                for (uint32_t i = 0; begun && i < load->view.textureCount(); i++)
+                {
+                    if (!smodel::IsBlockCompressed(load->view.textures[i].encoding))
+                        decodes.push_back({load.get(), i});
+                }
+            }
+
+            auto decodeTexture = [&](const DecodeItem &d)
+            {
+                const auto &t = d.load->view.textures[d.texture];
+                TextureAsset::decodeRGBA8(d.load->view.blob + t.imageDataOffset,
+                                          static_cast<size_t>(t.imageDataSize), d.load->images[d.texture]);
+            };
+
+            auto recordMeshes = [&]
+            {
+                for (auto &load : loads)
+                {
+                    const smodel::SModelFileView &view = load->view;
+                    load->meshes.resize(view.meshCount());
+                    for (uint32_t i = 0; load->ok && i < view.meshCount(); i++)
+                    {
+                        load->meshes[i] = std::make_unique<MeshAsset>();
+                        // Straight from the mapping into the staging arena
+                        load->ok = load->meshes[i]->upload_Deferred(upload, meshViewFromRecord(view, i), m_geometry.get());
+                    }
+                }
+            };
+
+            const uint32_t decodeCount = static_cast<uint32_t>(decodes.size());
+            if (m_decodePool && decodeCount > 0)
+            {
+                m_decodePool->parallelFor(decodeCount + 1, 1, [&](uint32_t begin, uint32_t end)
+                                          {
+                    for (uint32_t i = begin; i < end; ++i)
+                    {
+                        if (i == decodeCount)
+                            recordMeshes();
+                        else
+                            decodeTexture(decodes[i]);
+                    } });
+            }
+            else
+            {
+                for (const DecodeItem &d : decodes)
+                    decodeTexture(d);
+                recordMeshes();
+            }
 
-            // These fields come from your .smodel texture record format
-            const bool isSRGB = (t.colorSpace == 1); // 1 = SRGB
-            const VkSamplerAddressMode wrapU = toVkWrap(t.wrapU);
-            const VkSamplerAddressMode wrapV = toVkWrap(t.wrapV);
-            const VkFilter minF = toVkFilter(t.minFilter);
-            const VkFilter magF = toVkFilter(t.magFilter);
-            const VkSamplerMipmapMode mipM = toVkMip(t.mipFilter);
-
-            const uint8_t *bytes = view.blob + t.imageDataOffset;
-            const size_t sizeBytes = static_cast<size_t>(t.imageDataSize);
-
-            auto tex = std::make_unique<TextureAsset>();
-
-            // IMPORTANT:
-            // We create textures with refCount=0 (materials will addRef them)
-            // This avoids leaking textures when model is destroyed.
-            if (!tex->uploadEncodedImage_Deferred(
-                    upload,
-                    bytes,
-                    sizeBytes,
-                    isSRGB,
-                    wrapU,
-                    wrapV,
-                    minF,
-                    magF,
-                    mipM,
-                    t.maxAnisotropy))
+            for (auto &load : loads)
             {
-                // Cleanup on failure
-                Engine::EndSubmitAndWait(upload);
+                const smodel::SModelFileView &view = load->view;
+
+                load->textures.resize(view.textureCount());
+                for (uint32_t i = 0; load->ok && i < view.textureCount(); i++)
+                {
+                    const auto &t = view.textures[i];
+
+                    // These fields come from your .smodel texture record format
+                    load->textures[i] = std::make_unique<TextureAsset>();
+                    if (smodel::IsBlockCompressed(t.encoding))
+                    {
+                        load->ok = uploadBlockTexture(upload, *load->textures[i], view, t);
+                        continue;
+                    }
+
+                    const DecodedImage &image = load->images[i];
+                    load->ok = !image.pixels.empty() &&
+                               load->textures[i]->uploadRGBA8_Deferred(
+                                   upload,
+                                   image.pixels.data(),
+                                   image.width,
+                                   image.height,
+                                   t.colorSpace == 1, // 1 = SRGB
+                                   toVkWrap(t.wrapU),
+                                   toVkWrap(t.wrapV),
+                                   toVkFilter(t.minFilter),
+                                   toVkFilter(t.magFilter),
+                                   toVkMip(t.mipFilter),
+                                   t.maxAnisotropy);
+                }
+
+                // Staging holds its own copy of the pixels now
+                std::vector<DecodedImage>().swap(load->images);
+            }
+
+            // ONE SUBMIT + fence wait for the whole batch
+            if (begun && !Engine::EndSubmitAndWait(upload))
+            {
+                for (auto &load : loads)
+                    load->ok = false;
+            }
+            Engine::ReleaseUploadContext(upload);
+            if (uploadPool != VK_NULL_HANDLE)
                 vkDestroyCommandPool(m_device, uploadPool, nullptr);
-                return ModelHandle{};
+
+            // --------------------------
+            // Register textures/meshes and build the models
+            // --------------------------
+            for (auto &load : loads)
+            {
+                const std::string &path = cookedModelPaths[load->slot];
+                if (!load->ok)
+                {
+                    for (auto &tex : load->textures)
+                    {
+                        if (tex)
+                            tex->destroy(m_device);
+                    }
+                    for (auto &mesh : load->meshes)
+                    {
+                        if (mesh)
+                            mesh->destroy(m_device);
+                    }
+                    std::cerr << "[AssetManager] loadModel: GPU upload failed: " << path << "\n";
+                    continue;
+                }
+
+                std::vector<MeshHandle> meshDeps;
+                std::vector<MaterialHandle> matDeps;
+                std::unique_ptr<ModelAsset> model = assembleModel_Internal(path, load->view, load->textures, load->meshes,
+                                                                           meshDeps, matDeps);
+                if (!model)
+                    continue;
+
+                // Register model and cache it
+                ModelHandle modelHandle = createModel_Internal(std::move(model), path, 1);
+
+                // Fill dependency lists inside the ModelEntry
+                if (ModelEntry *entry = m_models.get(modelHandle))
+                {
+                    entry->meshDeps = std::move(meshDeps);
+                    entry->materialDeps = std::move(matDeps);
+                }
+
+                m_modelPathCache.emplace(path, modelHandle);
+                result[load->slot] = modelHandle;
             }
+        }
 
-            textureHandles[i] = createTexture_Internal(std::move(tex), 0);
+        // Repeated paths share the first load of the batch
+        for (size_t i = 0; i < cookedModelPaths.size(); ++i)
+        {
+            auto first = firstSlot.find(cookedModelPaths[i]);
+            if (first != firstSlot.end() && first->second != i && result[first->second].isValid())
+            {
+                result[i] = result[first->second];
+                addRef(result[i]);
+            }
         }
+        return result;
+    }
 
-        // ONE SUBMIT for all textures
-        if (!Engine::EndSubmitAndWait(upload))
+    std::unique_ptr<ModelAsset> AssetManager::assembleModel_Internal(const std::string &path,
+                                                                     const smodel::SModelFileView &view,
+                                                                     std::vector<std::unique_ptr<TextureAsset>> &textures,
+                                                                     std::vector<std::unique_ptr<MeshAsset>> &meshes,
+                                                                     std::vector<MeshHandle> &outMeshDeps,
+                                                                     std::vector<MaterialHandle> &outMaterialDeps)
+    {
+        // Textures and meshes start at refCount=0; materials and the model addRef what they use.
+        std::vector<TextureHandle> textureHandles(textures.size());
+        for (size_t i = 0; i < textures.size(); ++i)
         {
-            vkDestroyCommandPool(m_device, uploadPool, nullptr);
-            return ModelHandle{};
+            textureHandles[i] = createTexture_Internal(std::move(textures[i]), 0);
+            TextureEntry *entry = m_textures.get(textureHandles[i]);
+            entry->sourcePath = path;
+            entry->sourceTexture = static_cast<int32_t>(i);
         }
 
-        vkDestroyCommandPool(m_device, uploadPool, nullptr);
+        std::vector<MeshHandle> meshHandles(meshes.size());
+        for (size_t i = 0; i < meshes.size(); ++i)
+            meshHandles[i] = registerMesh_Internal(std::move(meshes[i]), path + "#mesh" + std::to_string(i), 0);
+
+        return buildModel_Internal(view, textureHandles, meshHandles, outMeshDeps, outMaterialDeps);
+    }
 
+    std::unique_ptr<ModelAsset> AssetManager::buildModel_Internal(const smodel::SModelFileView &view,
+                                                                  const std::vector<TextureHandle> &textureHandles,
+                                                                  const std::vector<MeshHandle> &meshHandles,
+                                                                  std::vector<MeshHandle> &outMeshDeps,
+                                                                  std::vector<MaterialHandle> &outMaterialDeps)
+    {
         // --------------------------
         // Create materials (CPU only)
         // Materials addRef() to textures they use
@@ -572,66 +901,27 @@ namespace Engine
         }
 
         // --------------------------
-        // Create meshes (GPU upload)
-        // Model will addRef() meshes it uses
+        // CPU tables: ranges, bounds, skins, nodes, animation (ModelBuild.h)
         // --------------------------
-        std::vector<MeshHandle> meshHandles;
-        meshHandles.resize(view.meshCount());
-
-        for (uint32_t i = 0; i < view.meshCount(); i++)
-        {
-            const auto &mr = view.meshes[i];
-
-            MeshData md;
-            md.vertexCount = mr.vertexCount;
-            md.indexCount = mr.indexCount;
-            md.vertexStride = mr.vertexStride;
-            md.indexFormat = (mr.indexType == 0) ? 0 : 1;
-
-            std::memcpy(md.aabbMin, mr.aabbMin, sizeof(md.aabbMin));
-            std::memcpy(md.aabbMax, mr.aabbMax, sizeof(md.aabbMax));
-
-            // Copy vertex bytes from blob
-            const uint8_t *vb = view.blob + mr.vertexDataOffset;
-            md.vertexBytes.assign(vb, vb + mr.vertexDataSize);
-
-            // Copy index bytes
-            const uint8_t *ib = view.blob + mr.indexDataOffset;
+        auto model = std::make_unique<ModelAsset>();
 
-            if (md.indexFormat == 0)
-            {
-                md.indices16.resize(md.indexCount);
-                std::memcpy(md.indices16.data(), ib, md.indexCount * sizeof(uint16_t));
-            }
-            else
-            {
-                md.indices32.resize(md.indexCount);
-                std::memcpy(md.indices32.data(), ib, md.indexCount * sizeof(uint32_t));
-            }
+        model->debugName = ""; // optional: you can store filename later
 
-            // Create mesh with refCount=0 (model will addRef as needed)
-            meshHandles[i] = createMeshFromData_Internal(md, cookedModelPath + "#mesh" + std::to_string(i), 0);
+        std::string buildError;
+        if (!buildModelFromView(view, m_animationBakeRate, *model, buildError))
+        {
+            std::cout << "[AssetManager] loadModel: " << buildError << "\n";
+            return nullptr;
         }
 
         // --------------------------
-        // Create model primitives
+        // Bind primitives to their meshes/materials
         // Model addsRef() to mesh/material dependencies
         // --------------------------
-        auto model = std::make_unique<ModelAsset>();
-
-        model->debugName = ""; // optional: you can store filename later
-
-        // Initialize bounds as invalid until we see a mesh
-        model->hasBounds = false;
-        model->fitScale = 1.0f;
-        model->center[0] = model->center[1] = model->center[2] = 0.0f;
-        model->boundsMin[0] = model->boundsMin[1] = model->boundsMin[2] = 0.0f;
-        model->boundsMax[0] = model->boundsMax[1] = model->boundsMax[2] = 0.0f;
-
-        model->primitives.resize(view.primitiveCount());
-
-        std::vector<MeshHandle> meshDeps;
-        std::vector<MaterialHandle> matDeps;
+        std::vector<MeshHandle> &meshDeps = outMeshDeps;
+        std::vector<MaterialHandle> &matDeps = outMaterialDeps;
+        meshDeps.clear();
+        matDeps.clear();
 
         std::unordered_set<uint64_t> meshDepIds;
         std::unordered_set<uint64_t> matDepIds;
@@ -642,15 +932,18 @@ namespace Engine
         {
             const auto &p = view.primitives[i];
 
-            ModelPrimitive prim;
+            ModelPrimitive &prim = model->primitives[i];
             prim.mesh = meshHandles[p.meshIndex];
             prim.material = materialHandles[p.materialIndex];
-            prim.firstIndex = p.firstIndex;
-            prim.indexCount = p.indexCount;
-            prim.vertexOffset = p.vertexOffset;
-            prim.skinIndex = p.skinIndex;
 
-            model->primitives[i] = prim;
+            // Offsets into the (possibly shared) buffers the mesh was uploaded to
+            if (const MeshAsset *pooled = getMesh(prim.mesh))
+            {
+                prim.firstIndex += pooled->getFirstIndex();
+                prim.vertexOffset += pooled->getVertexOffset();
+                for (uint32_t l = 0; l < prim.lodCount; ++l)
+                    prim.lods[l].firstIndex += pooled->getFirstIndex();
+            }
 
             // Dependency refs:
             if (prim.mesh.isValid())
@@ -661,31 +954,6 @@ namespace Engine
                     addRef(prim.mesh);
                     meshDeps.push_back(prim.mesh);
                 }
-
-                // Expand model bounds from mesh bounds
-                MeshAsset *mesh = getMesh(prim.mesh);
-                if (mesh)
-                {
-                    const float *mn = mesh->getAABBMin();
-                    const float *mx = mesh->getAABBMax();
-
-                    if (!model->hasBounds)
-                    {
-                        std::memcpy(model->boundsMin, mn, sizeof(model->boundsMin));
-                        std::memcpy(model->boundsMax, mx, sizeof(model->boundsMax));
-                        model->hasBounds = true;
-                    }
-                    else
-                    {
-                        model->boundsMin[0] = std::min(model->boundsMin[0], mn[0]);
-                        model->boundsMin[1] = std::min(model->boundsMin[1], mn[1]);
-                        model->boundsMin[2] = std::min(model->boundsMin[2], mn[2]);
-
-                        model->boundsMax[0] = std::max(model->boundsMax[0], mx[0]);
-                        model->boundsMax[1] = std::max(model->boundsMax[1], mx[1]);
-                        model->boundsMax[2] = std::max(model->boundsMax[2], mx[2]);
-                    }
-                }
             }
             if (prim.material.isValid())
             {
@@ -698,332 +966,619 @@ namespace Engine
             }
         }
 
-        // --------------------------
-        // V4: Populate skin tables (optional)
-        // --------------------------
-        if (view.skinCount() > 0)
+        return model;
+    }
+
+    ModelAsset *AssetManager::getModel(ModelHandle h)
+    {
+        auto *e = m_models.get(h);
+        return e ? e->asset.get() : nullptr;
+    }
+
+    void AssetManager::addRef(ModelHandle h)
+    {
+        if (auto *e = m_models.get(h))
+            e->refCount++;
+    }
+
+    void AssetManager::release(ModelHandle h)
+    {
+        auto *e = m_models.get(h);
+        if (e && e->refCount > 0)
+            e->refCount--;
+    }
+
+    // ------------------------------------------------------------
+    // Async streaming
+    // ------------------------------------------------------------
+    void AssetManager::setTransferQueue(VkQueue queue, uint32_t queueFamilyIndex, bool timelineSemaphores,
+                                        std::mutex *queueMutex)
+    {
+        if (!m_streamInFlight.empty())
         {
-            model->skins.resize(view.skinCount());
-            model->totalJointCount = 0;
+            std::cerr << "[AssetManager] setTransferQueue: ignored while uploads are in flight\n";
+            return;
+        }
 
-            for (uint32_t si = 0; si < view.skinCount(); ++si)
-            {
-                const auto &sr = view.skins[si];
-                ModelAsset::ModelSkin skin{};
-                skin.debugName = view.getStringOrEmpty(sr.nameStrOffset);
-                skin.jointBase = model->totalJointCount;
-                skin.jointCount = sr.jointCount;
-
-                // Validate and copy joint node indices slice
-                if (sr.jointCount > 0)
-                {
-                    if (sr.firstJointNodeIndex + sr.jointCount > view.skinJointNodeIndicesCount())
-                    {
-                        std::cout << "[AssetManager] loadModel: Skin jointNodeIndices out of range (skinIndex=" << si << ")\n";
-                        return ModelHandle{};
-                    }
+        if (m_streamPool != VK_NULL_HANDLE && queueFamilyIndex != m_transferQueueFamilyIndex)
+        {
+            vkDestroyCommandPool(m_device, m_streamPool, nullptr);
+            m_streamPool = VK_NULL_HANDLE;
+        }
 
-                    const uint32_t *srcJ = view.skinJointNodeIndices + sr.firstJointNodeIndex;
-                    skin.jointNodeIndices.assign(srcJ, srcJ + sr.jointCount);
+        m_transferQueue = queue;
+        m_transferQueueFamilyIndex = queueFamilyIndex;
+        m_transferQueueMutex = queueMutex;
+        m_geometry->setQueueFamilies({m_graphicsQueueFamilyIndex, queueFamilyIndex});
 
-                    // Validate inverse bind matrices
-                    const uint64_t neededFloats = uint64_t(sr.jointCount) * 16ull;
-                    if (uint64_t(sr.firstInverseBindMatrix) + neededFloats > view.skinInverseBindMatricesCount())
-                    {
-                        std::cout << "[AssetManager] loadModel: Skin inverseBindMatrices out of range (skinIndex=" << si << ")\n";
-                        return ModelHandle{};
-                    }
+        uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(m_phys, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(m_phys, &familyCount, families.data());
+        m_transferOnly = queueFamilyIndex < familyCount &&
+                         (families[queueFamilyIndex].queueFlags & VK_QUEUE_GRAPHICS_BIT) == 0;
 
-                    skin.inverseBind.resize(sr.jointCount);
-                    const float *srcM = view.skinInverseBindMatrices + sr.firstInverseBindMatrix;
-                    for (uint32_t j = 0; j < sr.jointCount; ++j)
-                    {
-                        std::memcpy(glm::value_ptr(skin.inverseBind[j]), srcM + size_t(j) * 16u, sizeof(float) * 16u);
-                    }
-                }
+        if (timelineSemaphores && m_streamTimeline == VK_NULL_HANDLE)
+        {
+            m_getSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(
+                vkGetDeviceProcAddr(m_device, "vkGetSemaphoreCounterValueKHR"));
 
-                model->skins[si] = std::move(skin);
-                model->totalJointCount += sr.jointCount;
+            if (m_getSemaphoreCounterValue)
+            {
+                VkSemaphoreTypeCreateInfoKHR typeInfo{};
+                typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+                typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+                typeInfo.initialValue = m_streamTimelineValue;
+
+                VkSemaphoreCreateInfo si{};
+                si.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+                si.pNext = &typeInfo;
+                if (vkCreateSemaphore(m_device, &si, nullptr, &m_streamTimeline) != VK_SUCCESS)
+                    m_streamTimeline = VK_NULL_HANDLE;
             }
+
+            if (m_streamTimeline == VK_NULL_HANDLE)
+                std::cerr << "[AssetManager] Timeline semaphore unavailable; streaming uses fences\n";
         }
-        else
+    }
+
+    ModelHandle AssetManager::loadModelAsync(const std::string &cookedModelPath)
+    {
+        auto it = m_modelPathCache.find(cookedModelPath);
+        if (it != m_modelPathCache.end())
         {
-            model->skins.clear();
-            model->totalJointCount = 0;
+            addRef(it->second);
+            return it->second;
         }
 
-        // Precompute center and fit scale to 20 units if bounds are valid
-        if (model->hasBounds)
+        ModelEntry e;
+        e.generation = 1;
+        e.refCount = 1;
+        e.path = cookedModelPath;
+        e.state = AssetState::Pending;
+        e.lastUsedFrame = m_residencyFrame;
+        const uint64_t id = m_models.insert(std::move(e));
+
+        ModelHandle h;
+        h.id = id;
+        h.generation = 1;
+        m_modelPathCache.emplace(cookedModelPath, h);
+
+        auto job = std::make_unique<StreamJob>();
+        job->kind = StreamJob::Kind::Model;
+        job->path = cookedModelPath;
+        job->id = id;
+        enqueueStreamJob(std::move(job));
+        return h;
+    }
+
+    TextureHandle AssetManager::loadTextureAsync(const std::string &filePath)
+    {
+        TextureEntry e;
+        e.generation = 1;
+        e.refCount = 1;
+        e.state = AssetState::Pending;
+        e.sourcePath = filePath;
+        const uint64_t id = m_textures.insert(std::move(e));
+
+        auto job = std::make_unique<StreamJob>();
+        job->kind = StreamJob::Kind::Texture;
+        job->path = filePath;
+        job->id = id;
+        enqueueStreamJob(std::move(job));
+
+        TextureHandle h;
+        h.id = id;
+        h.generation = 1;
+        return h;
+    }
+
+    AssetState AssetManager::modelState(ModelHandle h) const
+    {
+        const ModelEntry *e = m_models.get(h);
+        return e ? e->state : AssetState::Missing;
+    }
+
+    AssetState AssetManager::textureState(TextureHandle h) const
+    {
+        const TextureEntry *e = m_textures.get(h);
+        return e ? e->state : AssetState::Missing;
+    }
+
+    uint32_t AssetManager::textureVersion(TextureHandle h) const
+    {
+        const TextureEntry *e = m_textures.get(h);
+        return e ? e->version : 0;
+    }
+
+    ModelHandle AssetManager::resolveModel(ModelHandle h)
+    {
+        ModelEntry *e = m_models.get(h);
+        if (!e)
+            return m_placeholderModel;
+        e->lastUsedFrame = m_residencyFrame;
+        if (e->state == AssetState::Evicted)
         {
-            model->center[0] = 0.5f * (model->boundsMin[0] + model->boundsMax[0]);
-            model->center[1] = 0.5f * (model->boundsMin[1] + model->boundsMax[1]);
-            model->center[2] = 0.5f * (model->boundsMin[2] + model->boundsMax[2]);
+            // Evicted for the budget: stream it back in under the same handle.
+            e->state = AssetState::Pending;
+            auto job = std::make_unique<StreamJob>();
+            job->kind = StreamJob::Kind::Model;
+            job->path = e->path;
+            job->id = h.id;
+            enqueueStreamJob(std::move(job));
+        }
+        return (e->state == AssetState::Ready) ? h : m_placeholderModel;
+    }
 
-            const float sizeX = model->boundsMax[0] - model->boundsMin[0];
-            const float sizeY = model->boundsMax[1] - model->boundsMin[1];
-            const float sizeZ = model->boundsMax[2] - model->boundsMin[2];
-            const float maxExtent = std::max(sizeX, std::max(sizeY, sizeZ));
+    TextureHandle AssetManager::resolveTexture(TextureHandle h)
+    {
+        return (textureState(h) == AssetState::Ready) ? h : m_placeholderTexture;
+    }
 
-            const float target = TARGET;
-            const float epsilon = 1e-4f;
-            if (maxExtent > epsilon)
-                model->fitScale = target / maxExtent;
-            else
-                model->fitScale = 4.0f;
+    void AssetManager::enqueueStreamJob(std::unique_ptr<StreamJob> job)
+    {
+        ++m_streamPending;
+        job->requestNs = CpuProfiler::nowNs();
+        {
+            std::lock_guard<std::mutex> lock(m_streamMutex);
+            m_streamRequests.push_back(std::move(job));
         }
+        JobSystem::get().submit([this]
+                                { decodeNextStreamRequest(); },
+                                JobPriority::Background, &m_streamJobs);
+    }
 
-        // --------------------------
-        // V2: Populate nodes and primitive index mapping
-        // --------------------------
-        if (view.nodeCount() > 0)
+    void AssetManager::decodeNextStreamRequest()
+    {
+        std::unique_ptr<StreamJob> job;
         {
-            model->nodes.resize(view.nodeCount());
-            model->nodePrimitiveIndices.resize(view.nodePrimitiveIndexCount());
-            model->nodeChildIndices.resize(view.nodeChildIndexCount());
+            std::lock_guard<std::mutex> lock(m_streamMutex);
+            if (m_streamStop || m_streamRequests.empty())
+                return;
+            job = std::move(m_streamRequests.front());
+            m_streamRequests.pop_front();
+        }
+
+        decodeStreamJob(*job);
+
+        std::lock_guard<std::mutex> lock(m_streamMutex);
+        m_streamDecoded.push_back(std::move(job));
+    }
 
-            // Copy primitive indices array
-            if (view.nodePrimitiveIndexCount() > 0 && view.nodePrimitiveIndices)
+    void AssetManager::decodeStreamJob(StreamJob &job)
+    {
+        if (job.kind == StreamJob::Kind::TextureMips && job.sourceTexture >= 0)
+        {
+            // One texture of a .smodel; block-compressed levels are uploaded from the mapping.
+            job.view = std::make_unique<smodel::SModelFileView>();
+            if (!smodel::LoadSModelFile(job.path, *job.view, job.error))
+                return;
+            if (static_cast<uint32_t>(job.sourceTexture) >= job.view->textureCount())
             {
-                std::memcpy(model->nodePrimitiveIndices.data(), view.nodePrimitiveIndices, sizeof(uint32_t) * view.nodePrimitiveIndexCount());
+                job.error = "texture " + std::to_string(job.sourceTexture) + " not in file";
+                return;
             }
+            const auto &t = job.view->textures[job.sourceTexture];
+            job.images.resize(1);
+            if (!smodel::IsBlockCompressed(t.encoding) &&
+                !TextureAsset::decodeWithMips(job.view->blob + t.imageDataOffset, static_cast<size_t>(t.imageDataSize), job.images[0]))
+            {
+                job.error = "texture " + std::to_string(job.sourceTexture) + " decode failed";
+                return;
+            }
+            job.decoded = true;
+            return;
+        }
 
-            // Copy child indices array
-            if (view.nodeChildIndexCount() > 0 && view.nodeChildIndices)
+        if (job.kind != StreamJob::Kind::Model)
+        {
+            std::vector<uint8_t> bytes;
+            if (!readFileBytes(job.path, bytes))
+            {
+                job.error = "cannot read file";
+                return;
+            }
+            job.images.resize(1);
+            if (!TextureAsset::decodeWithMips(bytes.data(), bytes.size(), job.images[0]))
             {
-                std::memcpy(model->nodeChildIndices.data(), view.nodeChildIndices, sizeof(uint32_t) * view.nodeChildIndexCount());
+                job.error = "image decode failed";
+                return;
             }
+            job.decoded = true;
+            return;
+        }
 
-            // Track first root (parentIndex == UINT32_MAX)
-            uint32_t rootIdx = 0;
-            const uint32_t U32_MAX = ~0u;
+        job.view = std::make_unique<smodel::SModelFileView>();
+        if (!smodel::LoadSModelFile(job.path, *job.view, job.error))
+            return;
 
-            for (uint32_t i = 0; i < view.nodeCount(); ++i)
+        const smodel::SModelFileView &view = *job.view;
+        job.images.resize(view.textureCount());
+        for (uint32_t i = 0; i < view.textureCount(); ++i)
+        {
+            const auto &t = view.textures[i];
+            if (smodel::IsBlockCompressed(t.encoding))
+                continue; // uploaded straight from the mapping, nothing to decode
+            if (!TextureAsset::decodeWithMips(view.blob + t.imageDataOffset, static_cast<size_t>(t.imageDataSize), job.images[i]))
             {
-                const Engine::smodel::SModelNodeRecord &nr = view.nodes[i];
-                ModelAsset::ModelNode &dst = model->nodes[i];
-
-                dst.parentIndex = nr.parentIndex;
-                dst.firstChildIndex = nr.childCount ? nr.firstChildIndex : U32_MAX;
-                dst.childCount = nr.childCount;
-                dst.firstPrimitiveIndex = nr.firstPrimitiveIndex;
-                dst.primitiveCount = nr.primitiveCount;
-                dst.debugName = view.getStringOrEmpty(nr.nameStrOffset);
+                job.error = "texture " + std::to_string(i) + " decode failed";
+                return;
+            }
+        }
 
-                // Copy local matrix (column-major)
-                std::memcpy(glm::value_ptr(dst.localMatrix), nr.localMatrix, sizeof(nr.localMatrix));
+        job.meshes.reserve(view.meshCount());
+        for (uint32_t i = 0; i < view.meshCount(); ++i)
+            job.meshes.push_back(meshViewFromRecord(view, i));
 
-                // Defer global computation; ordering is not guaranteed.
-                dst.globalMatrix = glm::mat4(1.0f);
+        job.decoded = true;
+    }
 
-                if (nr.parentIndex == U32_MAX)
-                    rootIdx = i;
+    bool AssetManager::submitStreamJob(StreamJob &job)
+    {
+        if (m_streamPool == VK_NULL_HANDLE)
+        {
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.queueFamilyIndex = m_transferQueueFamilyIndex;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_streamPool) != VK_SUCCESS)
+            {
+                m_streamPool = VK_NULL_HANDLE;
+                job.error = "cannot create upload command pool";
+                return false;
             }
+        }
+
+        if (!BeginUploadContext(job.upload, m_device, m_phys, m_streamPool, m_transferQueue))
+        {
+            job.error = "cannot begin upload";
+            return false;
+        }
+        job.upload.transferOnly = m_transferOnly;
+        if (m_transferQueueFamilyIndex != m_graphicsQueueFamilyIndex)
+            job.upload.queueFamilies = {m_transferQueueFamilyIndex, m_graphicsQueueFamilyIndex};
 
-            model->rootNodeIndex = rootIdx;
+        // .smodel record of job.images[i] (a TextureMips job holds only the texture it reloads)
+        auto textureRecord = [&](size_t i) -> const smodel::SModelTextureRecord *
+        {
+            if (!job.view)
+                return nullptr;
+            return &job.view->textures[job.kind == StreamJob::Kind::TextureMips ? static_cast<size_t>(job.sourceTexture) : i];
+        };
+
+        // One staging arena for the whole asset
+        VkDeviceSize stagingBytes = 0;
+        for (size_t i = 0; i < job.images.size(); ++i)
+        {
+            const smodel::SModelTextureRecord *t = textureRecord(i);
+            stagingBytes += (t && smodel::IsBlockCompressed(t->encoding))
+                                ? StagingFootprint(t->imageDataSize)
+                                : StagingFootprint(static_cast<VkDeviceSize>(job.images[i].pixels.size()));
+        }
+        for (const MeshDataView &mesh : job.meshes)
+            stagingBytes += MeshAsset::stagingBytes(mesh);
+        ReserveStaging(job.upload, stagingBytes);
 
-            // Compute globals using explicit child lists (supports any node ordering).
+        // Textures: mips were built on the worker (or cooked offline), so this is copies only.
+        job.textures.resize(job.images.size());
+        for (size_t i = 0; i < job.images.size(); ++i)
+        {
+            bool isSRGB = false;
+            VkSamplerAddressMode wrapU = toVkWrap(0);
+            VkSamplerAddressMode wrapV = toVkWrap(0);
+            VkFilter minF = toVkFilter(1);
+            VkFilter magF = toVkFilter(1);
+            VkSamplerMipmapMode mipM = toVkMip(2);
+            float maxAnisotropy = 1.0f;
+            const smodel::SModelTextureRecord *t = textureRecord(i);
+            if (t)
             {
-                const uint32_t nodeCount = static_cast<uint32_t>(model->nodes.size());
-                std::vector<uint8_t> visited(nodeCount, 0);
+                isSRGB = (t->colorSpace == 1);
+                wrapU = toVkWrap(t->wrapU);
+                wrapV = toVkWrap(t->wrapV);
+                minF = toVkFilter(t->minFilter);
+                magF = toVkFilter(t->magFilter);
+                mipM = toVkMip(t->mipFilter);
+                maxAnisotropy = t->maxAnisotropy;
+            }
 
-                std::function<void(uint32_t, const glm::mat4 &)> compute = [&](uint32_t nodeIdx, const glm::mat4 &parentGlobal)
-                {
-                    if (nodeIdx >= nodeCount)
-                        return;
-                    if (visited[nodeIdx])
-                        return;
-                    visited[nodeIdx] = 1;
-
-                    ModelAsset::ModelNode &n = model->nodes[nodeIdx];
-                    n.globalMatrix = parentGlobal * n.localMatrix;
-
-                    if (n.childCount == 0)
-                        return;
-                    if (n.firstChildIndex == U32_MAX)
-                        return;
-
-                    const uint32_t start = n.firstChildIndex;
-                    for (uint32_t ci = 0; ci < n.childCount; ++ci)
-                    {
-                        const uint32_t child = model->nodeChildIndices[start + ci];
-                        compute(child, n.globalMatrix);
-                    }
-                };
+            // New loads start with their mip tail when streaming; reloads get the level asked for.
+            const bool block = t && smodel::IsBlockCompressed(t->encoding);
+            uint32_t firstLevel = job.firstLevel;
+            if (job.kind != StreamJob::Kind::TextureMips)
+            {
+                BlockCompressedImage header;
+                if (!block)
+                    firstLevel = streamedMipStart_Internal(job.images[i].width, job.images[i].height, job.images[i].mipLevels());
+                else if (blockImageFromRecord(*job.view, *t, header))
+                    firstLevel = streamedMipStart_Internal(header.width, header.height, header.mipLevels);
+            }
 
-                for (uint32_t i = 0; i < nodeCount; ++i)
-                {
-                    if (model->nodes[i].parentIndex == U32_MAX)
-                        compute(i, glm::mat4(1.0f));
-                }
+            job.textures[i] = std::make_unique<TextureAsset>();
+            const bool uploaded =
+                block ? uploadBlockTexture(job.upload, *job.textures[i], *job.view, *t, firstLevel)
+                      : job.textures[i]->uploadDecoded_Deferred(job.upload, job.images[i], isSRGB,
+                                                                wrapU, wrapV, minF, magF, mipM, maxAnisotropy, firstLevel);
+            if (!uploaded)
+            {
+                job.error = "texture " + std::to_string(i) + " upload failed";
+                return false;
+            }
+        }
+
+        job.meshAssets.resize(job.meshes.size());
+        for (size_t i = 0; i < job.meshes.size(); ++i)
+        {
+            job.meshAssets[i] = std::make_unique<MeshAsset>();
+            if (!job.meshAssets[i]->upload_Deferred(job.upload, job.meshes[i], m_geometry.get()))
+            {
+                job.error = "mesh " + std::to_string(i) + " upload failed";
+                return false;
             }
+        }
 
-            // Recompute bounds in node-global space (node transforms applied)
-            bool firstCorner = true;
-            glm::vec3 bmin(0.0f);
-            glm::vec3 bmax(0.0f);
+        // Staging holds its own copy of the pixels from here on (mesh views stay with job.view).
+        std::vector<DecodedImage>().swap(job.images);
+        job.meshes.clear();
 
-            for (const auto &node : model->nodes)
+        if (m_streamTimeline != VK_NULL_HANDLE)
+        {
+            job.timelineValue = ++m_streamTimelineValue;
+        }
+        else
+        {
+            VkFenceCreateInfo fi{};
+            fi.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            if (vkCreateFence(m_device, &fi, nullptr, &job.fence) != VK_SUCCESS)
             {
-                if (node.primitiveCount == 0)
-                    continue;
+                job.fence = VK_NULL_HANDLE;
+                job.error = "cannot create fence";
+                return false;
+            }
+        }
 
-                for (uint32_t k = 0; k < node.primitiveCount; ++k)
-                {
-                    const uint32_t primIndex = model->nodePrimitiveIndices[node.firstPrimitiveIndex + k];
-                    if (primIndex >= model->primitives.size())
-                        continue;
+        if (!SubmitUploadContext(job.upload, m_streamTimeline, job.timelineValue, job.fence, m_transferQueueMutex))
+        {
+            job.error = "queue submit failed";
+            return false;
+        }
+        return true;
+    }
 
-                    const ModelPrimitive &prim = model->primitives[primIndex];
-                    MeshAsset *mesh = getMesh(prim.mesh);
-                    if (!mesh)
-                        continue;
+    void AssetManager::updateStreaming()
+    {
+        std::vector<std::unique_ptr<StreamJob>> decoded;
+        {
+            std::lock_guard<std::mutex> lock(m_streamMutex);
+            decoded.swap(m_streamDecoded);
+        }
 
-                    const float *mn = mesh->getAABBMin();
-                    const float *mx = mesh->getAABBMax();
+        for (auto &job : decoded)
+        {
+            if (job->decoded && submitStreamJob(*job))
+                m_streamInFlight.push_back(std::move(job));
+            else
+                failStreamJob(*job);
+        }
 
-                    const glm::vec3 c0(mn[0], mn[1], mn[2]);
-                    const glm::vec3 c1(mx[0], mn[1], mn[2]);
-                    const glm::vec3 c2(mn[0], mx[1], mn[2]);
-                    const glm::vec3 c3(mx[0], mx[1], mn[2]);
-                    const glm::vec3 c4(mn[0], mn[1], mx[2]);
-                    const glm::vec3 c5(mx[0], mn[1], mx[2]);
-                    const glm::vec3 c6(mn[0], mx[1], mx[2]);
-                    const glm::vec3 c7(mx[0], mx[1], mx[2]);
+        if (!m_streamInFlight.empty())
+            pollStreamUploads_Internal();
 
-                    const glm::vec3 corners[8] = {c0, c1, c2, c3, c4, c5, c6, c7};
-                    for (const glm::vec3 &corner : corners)
-                    {
-                        const glm::vec4 w = node.globalMatrix * glm::vec4(corner, 1.0f);
-                        const glm::vec3 p(w.x, w.y, w.z);
-                        if (firstCorner)
-                        {
-                            bmin = p;
-                            bmax = p;
-                            firstCorner = false;
-                        }
-                        else
-                        {
-                            bmin.x = std::min(bmin.x, p.x);
-                            bmin.y = std::min(bmin.y, p.y);
-                            bmin.z = std::min(bmin.z, p.z);
-                            bmax.x = std::max(bmax.x, p.x);
-                            bmax.y = std::max(bmax.y, p.y);
-                            bmax.z = std::max(bmax.z, p.z);
-                        }
-                    }
-                }
-            }
+        updateResidency_Internal();
+    }
+
+    void AssetManager::pollStreamUploads_Internal()
+    {
+        uint64_t completed = 0;
+        if (m_streamTimeline != VK_NULL_HANDLE)
+            m_getSemaphoreCounterValue(m_device, m_streamTimeline, &completed);
 
-            if (!firstCorner)
+        for (auto it = m_streamInFlight.begin(); it != m_streamInFlight.end();)
+        {
+            StreamJob &job = **it;
+            const bool done = (m_streamTimeline != VK_NULL_HANDLE)
+                                  ? completed >= job.timelineValue
+                                  : vkGetFenceStatus(m_device, job.fence) == VK_SUCCESS;
+            if (!done)
             {
-                model->boundsMin[0] = bmin.x;
-                model->boundsMin[1] = bmin.y;
-                model->boundsMin[2] = bmin.z;
-                model->boundsMax[0] = bmax.x;
-                model->boundsMax[1] = bmax.y;
-                model->boundsMax[2] = bmax.z;
-                model->hasBounds = true;
-
-                model->center[0] = 0.5f * (model->boundsMin[0] + model->boundsMax[0]);
-                model->center[1] = 0.5f * (model->boundsMin[1] + model->boundsMax[1]);
-                model->center[2] = 0.5f * (model->boundsMin[2] + model->boundsMax[2]);
-
-                const float sizeX = model->boundsMax[0] - model->boundsMin[0];
-                const float sizeY = model->boundsMax[1] - model->boundsMin[1];
-                const float sizeZ = model->boundsMax[2] - model->boundsMin[2];
-                const float maxExtent = std::max(sizeX, std::max(sizeY, sizeZ));
-
-                const float target = TARGET;
-                const float epsilon = 1e-4f;
-                model->fitScale = (maxExtent > epsilon) ? (target / maxExtent) : 1.0f;
+                ++it;
+                continue;
             }
+
+            finishStreamJob(job);
+            it = m_streamInFlight.erase(it);
         }
+    }
 
-        // --------------------------
-        // V3: Copy animations into ModelAsset (node TRS only)
-        // --------------------------
-        if (view.animClipCount() > 0)
+    void AssetManager::finishStreamJob(StreamJob &job)
+    {
+        ReleaseUploadContext(job.upload);
+        if (job.fence != VK_NULL_HANDLE)
         {
-            model->animClips.resize(view.animClipCount());
-            std::memcpy(model->animClips.data(), view.animClips, sizeof(smodel::SModelAnimationClipRecord) * view.animClipCount());
+            vkDestroyFence(m_device, job.fence, nullptr);
+            job.fence = VK_NULL_HANDLE;
         }
-        if (view.animChannelCount() > 0)
+
+        if (job.kind == StreamJob::Kind::Texture)
         {
-            model->animChannels.resize(view.animChannelCount());
-            std::memcpy(model->animChannels.data(), view.animChannels, sizeof(smodel::SModelAnimationChannelRecord) * view.animChannelCount());
+            TextureEntry *entry = m_textures.find(job.id);
+            if (!entry)
+            {
+                failStreamJob(job);
+                return;
+            }
+            entry->asset = std::move(job.textures[0]);
+            entry->state = AssetState::Ready;
+            ++entry->version;
+            --m_streamPending;
+            m_loadLatency.record(static_cast<float>(CpuProfiler::nowNs() - job.requestNs) * 1e-6f);
+            return;
         }
-        if (view.animSamplerCount() > 0)
+
+        if (job.kind == StreamJob::Kind::TextureMips)
         {
-            model->animSamplers.resize(view.animSamplerCount());
-            std::memcpy(model->animSamplers.data(), view.animSamplers, sizeof(smodel::SModelAnimationSamplerRecord) * view.animSamplerCount());
+            --m_mipJobs;
+            --m_streamPending;
+            TextureEntry *entry = m_textures.find(job.id);
+            if (!entry || !entry->asset)
+            {
+                // Freed while the reload was in flight
+                job.textures[0]->destroy(m_device);
+                return;
+            }
+            // Frames in flight may still sample the old image; renderers see the new view on next use.
+            RetiredAsset r;
+            r.texture = std::move(entry->asset);
+            r.framesLeft = m_residency.retireFrames;
+            m_retiredAssets.push_back(std::move(r));
+            entry->asset = std::move(job.textures[0]);
+            entry->pendingMip = ~0u;
+            ++entry->version;
+            return;
         }
-        if (view.animTimesCount() > 0)
+
+        ModelEntry *found = m_models.find(job.id);
+        if (!found)
         {
-            model->animTimes.resize(view.animTimesCount());
-            std::memcpy(model->animTimes.data(), view.animTimes, sizeof(float) * view.animTimesCount());
+            failStreamJob(job);
+            return;
         }
-        if (view.animValuesCount() > 0)
+
+        ModelEntry &entry = *found;
+        entry.asset = assembleModel_Internal(job.path, *job.view, job.textures, job.meshAssets,
+                                             entry.meshDeps, entry.materialDeps);
+        entry.state = entry.asset ? AssetState::Ready : AssetState::Failed;
+        entry.lastUsedFrame = m_residencyFrame;
+        if (entry.asset)
+            m_loadLatency.record(static_cast<float>(CpuProfiler::nowNs() - job.requestNs) * 1e-6f);
+        else
         {
-            model->animValues.resize(view.animValuesCount());
-            std::memcpy(model->animValues.data(), view.animValues, sizeof(float) * view.animValuesCount());
+            std::cerr << "[AssetManager] loadModelAsync: invalid model data in " << job.path << "\n";
+            ++m_loadFailures;
         }
+        --m_streamPending;
+    }
 
-        // --------------------------
-        // Initialize runtime animation TRS buffers from node local matrices
-        // --------------------------
-        model->restTRS.resize(model->nodes.size());
-        model->animatedTRS.resize(model->nodes.size());
-        for (size_t i = 0; i < model->nodes.size(); i++)
+    void AssetManager::discardStreamJob(StreamJob &job)
+    {
+        if (job.upload.device != VK_NULL_HANDLE)
+            ReleaseUploadContext(job.upload);
+        if (job.fence != VK_NULL_HANDLE)
+        {
+            vkDestroyFence(m_device, job.fence, nullptr);
+            job.fence = VK_NULL_HANDLE;
+        }
+        for (auto &tex : job.textures)
         {
-            const glm::mat4 local = model->nodes[i].localMatrix;
-            model->restTRS[i] = DecomposeTRS(local);
-            model->animatedTRS[i] = model->restTRS[i];
+            if (tex)
+                tex->destroy(m_device);
         }
+        for (auto &mesh : job.meshAssets)
+        {
+            if (mesh)
+                mesh->destroy(m_device);
+        }
+        job.textures.clear();
+        job.meshAssets.clear();
+    }
 
-        model->animState.clipIndex = 0;
-        model->animState.timeSec = 0.0f;
-        model->animState.loop = true;
-        model->animState.playing = true;
+    void AssetManager::failStreamJob(StreamJob &job)
+    {
+        discardStreamJob(job);
+        std::cerr << "[AssetManager] Async load failed: " << job.path
+                  << (job.error.empty() ? "" : " (" + job.error + ")") << "\n";
 
-        // Register model and cache it
-        ModelHandle modelHandle = createModel_Internal(std::move(model), cookedModelPath, 1);
+        if (job.kind != StreamJob::Kind::TextureMips)
+            ++m_loadFailures;
 
-        // Fill dependency lists inside the ModelEntry
-        auto modelIt = m_models.find(modelHandle.id);
-        if (modelIt != m_models.end())
+        if (job.kind == StreamJob::Kind::Texture)
         {
-            modelIt->second.meshDeps = std::move(meshDeps);
-            modelIt->second.materialDeps = std::move(matDeps);
+            if (TextureEntry *entry = m_textures.find(job.id))
+                entry->state = AssetState::Failed;
         }
-
-        m_modelPathCache.emplace(cookedModelPath, modelHandle);
-        return modelHandle;
+        else if (job.kind == StreamJob::Kind::TextureMips)
+        {
+            // The resident levels stay; the source is not retried.
+            --m_mipJobs;
+            if (TextureEntry *entry = m_textures.find(job.id))
+            {
+                entry->sourcePath.clear();
+                entry->pendingMip = ~0u;
+            }
+        }
+        else
+        {
+            if (ModelEntry *entry = m_models.find(job.id))
+            {
+                entry->state = AssetState::Failed;
+                // Let a later load retry the path.
+                auto cached = m_modelPathCache.find(entry->path);
+                if (cached != m_modelPathCache.end() && cached->second.id == job.id)
+                    m_modelPathCache.erase(cached);
+            }
+        }
+        --m_streamPending;
     }
 
-    ModelAsset *AssetManager::getModel(ModelHandle h)
+    void AssetManager::shutdownStreaming()
     {
-        auto it = m_models.find(h.id);
-        if (it == m_models.end())
-            return nullptr;
-        if (it->second.generation != h.generation)
-            return nullptr;
-        return it->second.asset.get();
-    }
+        {
+            std::lock_guard<std::mutex> lock(m_streamMutex);
+            m_streamStop = true;
+        }
+        // Jobs not yet started return at once; help with background work so this cannot stall.
+        JobSystem::get().wait(m_streamJobs, JobPriority::Background);
 
-    void AssetManager::addRef(ModelHandle h)
-    {
-        auto it = m_models.find(h.id);
-        if (it != m_models.end() && it->second.generation == h.generation)
-            it->second.refCount++;
-    }
+        if (!m_streamInFlight.empty())
+        {
+            // Uploads still reference their staging buffers and destination resources.
+            if (m_transferQueueMutex)
+            {
+                std::lock_guard<std::mutex> lock(*m_transferQueueMutex);
+                vkQueueWaitIdle(m_transferQueue);
+            }
+            else
+            {
+                vkQueueWaitIdle(m_transferQueue);
+            }
+            for (auto &job : m_streamInFlight)
+                discardStreamJob(*job);
+            m_streamInFlight.clear();
+        }
+        m_streamRequests.clear();
+        m_streamDecoded.clear();
+        m_streamPending = 0;
+        m_mipJobs = 0;
 
-    void AssetManager::release(ModelHandle h)
-    {
-        auto it = m_models.find(h.id);
-        if (it != m_models.end() && it->second.generation == h.generation)
+        if (m_streamPool != VK_NULL_HANDLE)
         {
-            if (it->second.refCount > 0)
-                it->second.refCount--;
+            vkDestroyCommandPool(m_device, m_streamPool, nullptr);
+            m_streamPool = VK_NULL_HANDLE;
+        }
+        if (m_streamTimeline != VK_NULL_HANDLE)
+        {
+            vkDestroySemaphore(m_device, m_streamTimeline, nullptr);
+            m_streamTimeline = VK_NULL_HANDLE;
         }
     }
 
@@ -1032,73 +1587,406 @@ namespace Engine
     // ------------------------------------------------------------
     void AssetManager::garbageCollect()
     {
-        // 1) Destroy models with refCount == 0
-        for (auto it = m_models.begin(); it != m_models.end();)
+        tickRetiredAssets_Internal(true);
+        collect_Internal(false);
+    }
+
+    uint64_t AssetManager::collect_Internal(bool retire)
+    {
+        uint64_t freedBytes = 0;
+        auto retireAsset = [&](RetiredAsset r)
         {
-            if (it->second.refCount == 0)
+            r.framesLeft = m_residency.retireFrames;
+            m_retiredAssets.push_back(std::move(r));
+        };
+
+        // 1) Destroy models with refCount == 0
+        m_models.forEach([&](uint64_t id, ModelEntry &e)
+                         {
+            if (e.refCount != 0 || e.state == AssetState::Pending)
+                return;
+            // Release model deps
+            for (auto &mh : e.meshDeps)
+                release(mh);
+            for (auto &mat : e.materialDeps)
+                release(mat);
+
+            if (retire && e.asset)
             {
-                // Release model deps
-                for (auto &mh : it->second.meshDeps)
-                    release(mh);
-                for (auto &mat : it->second.materialDeps)
-                    release(mat);
-
-                m_modelPathCache.erase(it->second.path);
-                it = m_models.erase(it);
+                RetiredAsset r;
+                r.model = std::move(e.asset);
+                retireAsset(std::move(r));
             }
-            else
+            m_modelPathCache.erase(e.path);
+            m_models.erase(id); });
+
+        // 2) Destroy materials with refCount == 0
+        m_materials.forEach([&](uint64_t id, MaterialEntry &e)
+                            {
+            if (e.refCount != 0)
+                return;
+            // Release textures referenced by this material
+            for (auto &th : e.textureDeps)
+                release(th);
+            m_materials.erase(id); });
+
+        // 3) Destroy meshes with refCount == 0
+        m_meshes.forEach([&](uint64_t id, MeshEntry &e)
+                         {
+            if (e.refCount != 0)
+                return;
+            if (e.asset)
             {
-                ++it;
+                freedBytes += e.asset->gpuBytes();
+                if (retire)
+                {
+                    RetiredAsset r;
+                    r.mesh = std::move(e.asset);
+                    retireAsset(std::move(r));
+                }
+                else
+                {
+                    e.asset->destroy(m_device);
+                }
             }
-        }
 
-        // 2) Destroy materials with refCount == 0
-        for (auto it = m_materials.begin(); it != m_materials.end();)
-        {
-            if (it->second.refCount == 0)
+            m_meshPathCache.erase(e.path);
+            m_meshes.erase(id); });
+
+        // 4) Destroy textures with refCount == 0
+        m_textures.forEach([&](uint64_t id, TextureEntry &e)
+                           {
+            if (e.refCount != 0 || e.state == AssetState::Pending)
+                return;
+            if (e.asset)
             {
-                // Release textures referenced by this material
-                for (auto &th : it->second.textureDeps)
-                    release(th);
-                it = m_materials.erase(it);
+                freedBytes += e.asset->gpuBytes();
+                if (retire)
+                {
+                    RetiredAsset r;
+                    r.texture = std::move(e.asset);
+                    retireAsset(std::move(r));
+                }
+                else
+                {
+                    e.asset->destroy(m_device);
+                }
             }
-            else
+            m_textures.erase(id); });
+
+        return freedBytes;
+    }
+
+    // ------------------------------------------------------------
+    // Residency
+    // ------------------------------------------------------------
+    void AssetManager::tickRetiredAssets_Internal(bool all)
+    {
+        for (size_t i = 0; i < m_retiredAssets.size();)
+        {
+            RetiredAsset &r = m_retiredAssets[i];
+            if (!all && r.framesLeft > 0)
             {
-                ++it;
+                --r.framesLeft;
+                ++i;
+                continue;
             }
+            if (r.mesh)
+                r.mesh->destroy(m_device);
+            if (r.texture)
+                r.texture->destroy(m_device);
+            m_retiredAssets[i] = std::move(m_retiredAssets.back());
+            m_retiredAssets.pop_back();
         }
+    }
 
-        // 3) Destroy meshes with refCount == 0
-        for (auto it = m_meshes.begin(); it != m_meshes.end();)
+    uint64_t AssetManager::residencyBudget_Internal(uint64_t residentBytes) const
+    {
+        uint64_t budget = m_residency.budgetBytes;
+        if (m_residency.deviceBudgetFraction > 0.0f)
         {
-            if (it->second.refCount == 0)
+            // Heap budgets include other processes and our own non-asset memory; only what is left
+            // after those is available to assets.
+            VkDeviceSize heapBudget = 0;
+            VkDeviceSize heapUsage = 0;
+            for (const GpuAllocator::HeapBudget &heap : GpuAllocator::forDevice(m_device, m_phys).heapBudgets())
             {
-                if (it->second.asset)
-                    it->second.asset->destroy(m_device);
+                if (!heap.deviceLocal)
+                    continue;
+                heapBudget += heap.budget;
+                heapUsage += heap.usage;
+            }
+            const uint64_t other = (heapUsage > residentBytes) ? heapUsage - residentBytes : 0;
+            const uint64_t share = static_cast<uint64_t>(static_cast<double>(heapBudget) * m_residency.deviceBudgetFraction);
+            const uint64_t deviceBudget = (share > other) ? share - other : 0;
+            budget = (budget == 0) ? deviceBudget : std::min(budget, deviceBudget);
+        }
+        return budget;
+    }
 
-                m_meshPathCache.erase(it->second.path);
-                it = m_meshes.erase(it);
+    uint64_t AssetManager::modelGpuBytes_Internal(const ModelEntry &e)
+    {
+        // Shared textures count once per model; good enough to rank candidates.
+        uint64_t bytes = 0;
+        for (const MeshHandle &mh : e.meshDeps)
+        {
+            if (const MeshEntry *mesh = m_meshes.get(mh))
+                bytes += mesh->asset ? mesh->asset->gpuBytes() : 0;
+        }
+        for (const MaterialHandle &mat : e.materialDeps)
+        {
+            const MaterialEntry *material = m_materials.get(mat);
+            if (!material)
+                continue;
+            for (const TextureHandle &th : material->textureDeps)
+            {
+                if (const TextureEntry *tex = m_textures.get(th))
+                    bytes += tex->asset ? tex->asset->gpuBytes() : 0;
             }
-            else
+        }
+        return bytes;
+    }
+
+    void AssetManager::evictModel_Internal(ModelEntry &e)
+    {
+        for (auto &mh : e.meshDeps)
+            release(mh);
+        for (auto &mat : e.materialDeps)
+            release(mat);
+        e.meshDeps.clear();
+        e.materialDeps.clear();
+
+        RetiredAsset r;
+        r.model = std::move(e.asset);
+        r.framesLeft = m_residency.retireFrames;
+        m_retiredAssets.push_back(std::move(r));
+        e.state = AssetState::Evicted;
+        ++m_evictionCount;
+    }
+
+    void AssetManager::updateResidency_Internal()
+    {
+        ++m_residencyFrame;
+        tickRetiredAssets_Internal(false);
+
+        const MemoryUsage usage = memoryUsage();
+        m_residentBytes = usage.meshGpuBytes + usage.textureGpuBytes;
+        const bool budgeted = m_residency.budgetBytes != 0 || m_residency.deviceBudgetFraction > 0.0f;
+        const uint64_t budget = budgeted ? residencyBudget_Internal(m_residentBytes) : UINT64_MAX;
+
+        if (m_residency.streamedMipExtent > 0)
+            streamTextureMips_Internal(budget);
+        if (m_residentBytes <= budget)
+            return;
+
+        // Unreferenced assets go first, all at once.
+        m_residentBytes -= std::min(m_residentBytes, collect_Internal(true));
+        if (m_residentBytes <= budget)
+            return;
+
+        // Then the finest mips of streamed textures, which cost detail rather than whole models.
+        if (m_residency.streamedMipExtent > 0 && dropTextureMips_Internal(budget))
+            return;
+
+        // Then referenced models that can be reloaded, least recently used first.
+        struct Candidate
+        {
+            uint64_t id;
+            uint32_t lastUsed;
+            uint64_t bytes;
+        };
+        std::vector<Candidate> candidates;
+        m_models.forEach([&](uint64_t id, const ModelEntry &e)
+                         {
+            if (e.state != AssetState::Ready || !e.asset || e.path.empty() || id == m_placeholderModel.id)
+                return;
+            if (m_residencyFrame - e.lastUsedFrame < m_residency.minIdleFrames)
+                return;
+            candidates.push_back({id, e.lastUsedFrame, modelGpuBytes_Internal(e)}); });
+        // Oldest first; among equally old ones the largest frees the most.
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+                  { return a.lastUsed != b.lastUsed ? a.lastUsed < b.lastUsed : a.bytes > b.bytes; });
+
+        for (const Candidate &c : candidates)
+        {
+            if (m_residentBytes <= budget)
+                break;
+            ModelEntry *e = m_models.find(c.id);
+            if (!e)
+                continue;
+            evictModel_Internal(*e);
+            m_residentBytes -= std::min(m_residentBytes, collect_Internal(true));
+        }
+    }
+
+    // ------------------------------------------------------------
+    // Texture mip streaming
+    // ------------------------------------------------------------
+    // Bytes of a texture 'levels' mips finer (> 0) or coarser (< 0) than one of 'bytes': each level
+    // is a quarter of the one above it.
+    static uint64_t mipShiftedBytes(uint64_t bytes, int32_t levels)
+    {
+        if (levels >= 0)
+            return bytes << std::min(2 * levels, 40);
+        return bytes >> std::min(-2 * levels, 63);
+    }
+
+    void AssetManager::reportMaterialScreenSize(MaterialHandle h, float pixels)
+    {
+        if (!h.isValid() || !(pixels > 0.0f))
+            return;
+        std::lock_guard<std::mutex> lock(m_mipFeedbackMutex);
+        float &largest = m_mipFeedback[h.id];
+        largest = std::max(largest, pixels);
+    }
+
+    uint32_t AssetManager::streamedMipStart_Internal(uint32_t width, uint32_t height, uint32_t levels) const
+    {
+        const uint32_t extent = m_residency.streamedMipExtent;
+        uint32_t level = 0;
+        while (extent > 0 && level + 1 < levels && (std::max(width, height) >> level) > extent)
+            ++level;
+        return level;
+    }
+
+    void AssetManager::enqueueMipJob_Internal(uint64_t id, TextureEntry &e, uint32_t firstLevel)
+    {
+        auto job = std::make_unique<StreamJob>();
+        job->kind = StreamJob::Kind::TextureMips;
+        job->path = e.sourcePath;
+        job->id = id;
+        job->sourceTexture = e.sourceTexture;
+        job->firstLevel = firstLevel;
+        e.pendingMip = firstLevel;
+        ++m_mipJobs;
+        enqueueStreamJob(std::move(job));
+    }
+
+    void AssetManager::streamTextureMips_Internal(uint64_t budget)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mipFeedbackMutex);
+            m_mipFeedbackScratch.swap(m_mipFeedback);
+        }
+
+        // Feedback: every texture of a reported material wants the coarsest level still covering
+        // the largest screen extent reported this frame.
+        for (const auto &[materialId, pixels] : m_mipFeedbackScratch)
+        {
+            const MaterialEntry *material = m_materials.find(materialId);
+            if (!material)
+                continue;
+            for (const TextureHandle &th : material->textureDeps)
             {
-                ++it;
+                TextureEntry *e = m_textures.get(th);
+                if (!e || !e->asset)
+                    continue;
+                const uint32_t levels = e->asset->sourceMipLevels();
+                const uint32_t extent = e->asset->sourceExtent();
+                uint32_t level = 0;
+                while (level + 1 < levels && static_cast<float>(extent >> (level + 1)) >= pixels)
+                    ++level;
+                e->wantedMip = (e->lastWantedFrame == m_residencyFrame) ? std::min(e->wantedMip, level) : level;
+                e->lastWantedFrame = m_residencyFrame;
             }
         }
+        m_mipFeedbackScratch.clear();
 
-        // 4) Destroy textures with refCount == 0
-        for (auto it = m_textures.begin(); it != m_textures.end();)
+        // Upgrades for textures reported last frame or this one, the largest shortfall first. They
+        // only start while they fit under 7/8 of the budget, so a drop under pressure is not
+        // immediately undone.
+        if (m_mipJobs >= m_residency.mipStreamJobs)
+            return;
+
+        struct Candidate
         {
-            if (it->second.refCount == 0)
+            uint64_t id;
+            uint32_t shortfall;
+            uint64_t growth;
+        };
+        std::vector<Candidate> candidates;
+        uint64_t pendingGrowth = 0;
+        m_textures.forEach([&](uint64_t id, const TextureEntry &e)
+                           {
+            if (!e.asset || e.sourcePath.empty())
+                return;
+            const uint64_t bytes = e.asset->gpuBytes();
+            const int32_t resident = static_cast<int32_t>(e.asset->residentMip());
+            if (e.pendingMip != ~0u)
             {
-                if (it->second.asset)
-                    it->second.asset->destroy(m_device);
-                it = m_textures.erase(it);
+                const uint64_t target = mipShiftedBytes(bytes, resident - static_cast<int32_t>(e.pendingMip));
+                pendingGrowth += (target > bytes) ? target - bytes : 0;
+                return;
             }
-            else
+            if (e.lastWantedFrame == 0 || m_residencyFrame - e.lastWantedFrame > 1 || e.wantedMip >= e.asset->residentMip())
+                return;
+            candidates.push_back({id, e.asset->residentMip() - e.wantedMip,
+                                  mipShiftedBytes(bytes, resident - static_cast<int32_t>(e.wantedMip)) - bytes}); });
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+                  { return a.shortfall > b.shortfall; });
+
+        const uint64_t limit = (budget == UINT64_MAX) ? budget : budget - budget / 8;
+        uint64_t projected = m_residentBytes + pendingGrowth;
+        for (const Candidate &c : candidates)
+        {
+            if (m_mipJobs >= m_residency.mipStreamJobs)
+                break;
+            if (projected + c.growth > limit)
+                continue;
+            TextureEntry *e = m_textures.find(c.id);
+            projected += c.growth;
+            enqueueMipJob_Internal(c.id, *e, e->wantedMip);
+        }
+    }
+
+    bool AssetManager::dropTextureMips_Internal(uint64_t budget)
+    {
+        // Textures not reported for minIdleFrames go back to their resident tail, others down to
+        // the level they want or, if they already have just that, one level coarser. Stalest first,
+        // then largest.
+        struct Candidate
+        {
+            uint64_t id;
+            uint32_t lastWanted;
+            uint64_t bytes;
+            uint32_t target;
+        };
+        std::vector<Candidate> candidates;
+        uint64_t pendingSavings = 0;
+        m_textures.forEach([&](uint64_t id, const TextureEntry &e)
+                           {
+            if (!e.asset || e.sourcePath.empty())
+                return;
+            const uint64_t bytes = e.asset->gpuBytes();
+            const uint32_t resident = e.asset->residentMip();
+            if (e.pendingMip != ~0u)
             {
-                ++it;
+                const uint64_t target = mipShiftedBytes(bytes, static_cast<int32_t>(resident) - static_cast<int32_t>(e.pendingMip));
+                pendingSavings += (target < bytes) ? bytes - target : 0;
+                return;
             }
+            const uint32_t tail = streamedMipStart_Internal(e.asset->sourceExtent(), e.asset->sourceExtent(),
+                                                            e.asset->sourceMipLevels());
+            if (resident >= tail)
+                return;
+            uint32_t target = tail;
+            if (e.lastWantedFrame != 0 && m_residencyFrame - e.lastWantedFrame < m_residency.minIdleFrames)
+                target = std::min(std::max(e.wantedMip, resident + 1), tail);
+            candidates.push_back({id, e.lastWantedFrame, bytes, target}); });
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+                  { return a.lastWanted != b.lastWanted ? a.lastWanted < b.lastWanted : a.bytes > b.bytes; });
+
+        uint64_t projected = m_residentBytes - std::min(m_residentBytes, pendingSavings);
+        for (const Candidate &c : candidates)
+        {
+            if (projected <= budget)
+                break;
+            TextureEntry *e = m_textures.find(c.id);
+            const uint64_t target = mipShiftedBytes(c.bytes, static_cast<int32_t>(e->asset->residentMip()) - static_cast<int32_t>(c.target));
+            projected -= std::min(projected, c.bytes - target);
+            enqueueMipJob_Internal(c.id, *e, c.target);
         }
+        return projected <= budget;
     }
 
 } // namespace Engine
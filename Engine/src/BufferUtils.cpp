@@ -1,114 +1,103 @@
 #include "utils/BufferUtils.h"
+#include "utils/ImageUtils.h" // UploadContext
 #include <cstring>
-#include <stdexcept>
 
 namespace Engine
 {
-    static uint32_t findMemoryType(VkPhysicalDevice phys, uint32_t typeFilter, VkMemoryPropertyFlags properties)
+    namespace
     {
-        VkPhysicalDeviceMemoryProperties memProps;
-        vkGetPhysicalDeviceMemoryProperties(phys, &memProps);
-        for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
+        // Host-visible buffer that is (re)created when too small and refilled through its persistent mapping.
+        VkResult createOrUpdateHostBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkBufferUsageFlags usage,
+                                          const void *data, VkDeviceSize dataSize,
+                                          VkBuffer &buffer, GpuAllocation &allocation)
         {
-            if ((typeFilter & (1u << i)) && (memProps.memoryTypes[i].propertyFlags & properties) == properties)
+            if (!data || dataSize == 0)
             {
-                return i;
+                return VK_ERROR_INITIALIZATION_FAILED;
             }
-        }
-        throw std::runtime_error("Failed to find suitable memory type");
-    }
 
-    VkResult CreateOrUpdateVertexBuffer(
-        VkDevice device,
-        VkPhysicalDevice physicalDevice,
-        const void *vertexData,
-        VkDeviceSize dataSize,
-        VertexBufferHandle &handle)
-    {
-        if (!vertexData || dataSize == 0)
-        {
-            return VK_ERROR_INITIALIZATION_FAILED;
+            GpuAllocator &allocator = GpuAllocator::forDevice(device, physicalDevice);
+            if (buffer != VK_NULL_HANDLE && allocation.size < dataSize)
+            {
+                allocator.destroyBuffer(buffer, allocation);
+            }
+
+            if (buffer == VK_NULL_HANDLE)
+            {
+                // Include TRANSFER_SRC so this host-visible buffer can be the staging source.
+                VkResult r = allocator.createBuffer(dataSize, usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                                    GpuMemoryCategory::Dynamic, buffer, allocation);
+                if (r != VK_SUCCESS)
+                    return r;
+            }
+
+            std::memcpy(allocation.mapped, data, static_cast<size_t>(dataSize));
+            return VK_SUCCESS;
         }
 
-        bool needCreate = (handle.buffer == VK_NULL_HANDLE);
-        VkMemoryRequirements req{};
-        if (!needCreate)
+        void destroyBuffer(VkDevice device, VkBuffer &buffer, GpuAllocation &allocation)
         {
-            vkGetBufferMemoryRequirements(device, handle.buffer, &req);
-            if (req.size < dataSize)
+            if (GpuAllocator *allocator = GpuAllocator::find(device))
             {
-                vkDestroyBuffer(device, handle.buffer, nullptr);
-                handle.buffer = VK_NULL_HANDLE;
-                vkFreeMemory(device, handle.memory, nullptr);
-                handle.memory = VK_NULL_HANDLE;
-                needCreate = true;
+                allocator->destroyBuffer(buffer, allocation);
+            }
+            else if (buffer != VK_NULL_HANDLE)
+            {
+                vkDestroyBuffer(device, buffer, nullptr);
+                buffer = VK_NULL_HANDLE;
             }
         }
 
-        if (needCreate)
+        // One-shot staged upload into a new device-local buffer.
+        VkResult createStaticBuffer(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex,
+                                    VkQueue queue, VkBufferUsageFlags usage, const void *data, VkDeviceSize dataSize,
+                                    VkBuffer &buffer, GpuAllocation &allocation)
         {
-            VkBufferCreateInfo bi{};
-            bi.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-            bi.size = dataSize;
-            // Include TRANSFER_SRC so this host-visible buffer can be the staging source.
-            bi.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-            bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-            VkBuffer buffer = VK_NULL_HANDLE;
-            VkResult r = vkCreateBuffer(device, &bi, nullptr, &buffer);
-            if (r != VK_SUCCESS)
-                return r;
+            if (!data || dataSize == 0)
+                return VK_ERROR_INITIALIZATION_FAILED;
 
-            vkGetBufferMemoryRequirements(device, buffer, &req);
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.queueFamilyIndex = queueFamilyIndex;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 
-            VkMemoryAllocateInfo ai{};
-            ai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            ai.allocationSize = req.size;
-            ai.memoryTypeIndex = findMemoryType(physicalDevice, req.memoryTypeBits,
-                                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-            VkDeviceMemory mem = VK_NULL_HANDLE;
-            r = vkAllocateMemory(device, &ai, nullptr, &mem);
+            VkCommandPool pool = VK_NULL_HANDLE;
+            VkResult r = vkCreateCommandPool(device, &poolInfo, nullptr, &pool);
             if (r != VK_SUCCESS)
-            {
-                vkDestroyBuffer(device, buffer, nullptr);
                 return r;
-            }
 
-            r = vkBindBufferMemory(device, buffer, mem, 0);
-            if (r != VK_SUCCESS)
+            UploadContext ctx{};
+            bool ok = BeginUploadContext(ctx, device, physicalDevice, pool, queue);
+            if (ok)
             {
-                vkDestroyBuffer(device, buffer, nullptr);
-                vkFreeMemory(device, mem, nullptr);
-                return r;
+                const bool recorded = RecordDeviceLocalUpload(ctx, data, dataSize, usage, buffer, allocation);
+                ok = EndSubmitAndWait(ctx) && recorded;
+                if (!ok)
+                {
+                    ReleaseUploadContext(ctx);
+                    destroyBuffer(device, buffer, allocation);
+                }
             }
-
-            handle.buffer = buffer;
-            handle.memory = mem;
+            vkDestroyCommandPool(device, pool, nullptr);
+            return ok ? VK_SUCCESS : VK_ERROR_INITIALIZATION_FAILED;
         }
+    }
 
-        void *mapped = nullptr;
-        VkResult r = vkMapMemory(device, handle.memory, 0, dataSize, 0, &mapped);
-        if (r != VK_SUCCESS)
-            return r;
-        std::memcpy(mapped, vertexData, static_cast<size_t>(dataSize));
-        vkUnmapMemory(device, handle.memory);
-
-        return VK_SUCCESS;
+    VkResult CreateOrUpdateVertexBuffer(
+        VkDevice device,
+        VkPhysicalDevice physicalDevice,
+        const void *vertexData,
+        VkDeviceSize dataSize,
+        VertexBufferHandle &handle)
+    {
+        return createOrUpdateHostBuffer(device, physicalDevice, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                        vertexData, dataSize, handle.buffer, handle.allocation);
     }
 
     void DestroyVertexBuffer(VkDevice device, VertexBufferHandle &handle)
     {
-        if (handle.buffer != VK_NULL_HANDLE)
-        {
-            vkDestroyBuffer(device, handle.buffer, nullptr);
-            handle.buffer = VK_NULL_HANDLE;
-        }
-        if (handle.memory != VK_NULL_HANDLE)
-        {
-            vkFreeMemory(device, handle.memory, nullptr);
-            handle.memory = VK_NULL_HANDLE;
-        }
+        destroyBuffer(device, handle.buffer, handle.allocation);
     }
 
     // Index buffer (host-visible, also a staging source)
@@ -119,90 +108,71 @@ namespace Engine
         VkDeviceSize dataSize,
         IndexBufferHandle &handle)
     {
-        if (!indexData || dataSize == 0)
-        {
-            return VK_ERROR_INITIALIZATION_FAILED;
-        }
-
-        bool needCreate = (handle.buffer == VK_NULL_HANDLE);
-        VkMemoryRequirements req{};
-        if (!needCreate)
-        {
-            vkGetBufferMemoryRequirements(device, handle.buffer, &req);
-            if (req.size < dataSize)
-            {
-                vkDestroyBuffer(device, handle.buffer, nullptr);
-                handle.buffer = VK_NULL_HANDLE;
-                vkFreeMemory(device, handle.memory, nullptr);
-                handle.memory = VK_NULL_HANDLE;
-                needCreate = true;
-            }
-        }
-
-        if (needCreate)
-        {
-            VkBufferCreateInfo bi{};
-            bi.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-            bi.size = dataSize;
-            // Include TRANSFER_SRC so this host-visible buffer can be the staging source.
-            bi.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-            bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-            VkBuffer buffer = VK_NULL_HANDLE;
-            VkResult r = vkCreateBuffer(device, &bi, nullptr, &buffer);
-            if (r != VK_SUCCESS)
-                return r;
-
-            vkGetBufferMemoryRequirements(device, buffer, &req);
-
-            VkMemoryAllocateInfo ai{};
-            ai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            ai.allocationSize = req.size;
-            ai.memoryTypeIndex = findMemoryType(physicalDevice, req.memoryTypeBits,
-                                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        return createOrUpdateHostBuffer(device, physicalDevice, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                        indexData, dataSize, handle.buffer, handle.allocation);
+    }
 
-            VkDeviceMemory mem = VK_NULL_HANDLE;
-            r = vkAllocateMemory(device, &ai, nullptr, &mem);
-            if (r != VK_SUCCESS)
-            {
-                vkDestroyBuffer(device, buffer, nullptr);
-                return r;
-            }
+    void DestroyIndexBuffer(VkDevice device, IndexBufferHandle &handle)
+    {
+        destroyBuffer(device, handle.buffer, handle.allocation);
+    }
 
-            r = vkBindBufferMemory(device, buffer, mem, 0);
-            if (r != VK_SUCCESS)
-            {
-                vkDestroyBuffer(device, buffer, nullptr);
-                vkFreeMemory(device, mem, nullptr);
-                return r;
-            }
+    bool RecordDeviceLocalUpload(
+        UploadContext &ctx,
+        const void *data,
+        VkDeviceSize dataSize,
+        VkBufferUsageFlags usage,
+        VkBuffer &outBuffer,
+        GpuAllocation &outAllocation,
+        GpuMemoryCategory category)
+    {
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        VkDeviceSize stagingOffset = 0;
+        if (!StageUpload(ctx, data, dataSize, stagingBuffer, stagingOffset))
+            return false;
 
-            handle.buffer = buffer;
-            handle.memory = mem;
-        }
+        VkBufferCreateInfo bi{};
+        bi.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bi.size = dataSize;
+        bi.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        ApplyQueueSharing(ctx, bi);
 
-        void *mapped = nullptr;
-        VkResult r = vkMapMemory(device, handle.memory, 0, dataSize, 0, &mapped);
+        VkResult r = GpuAllocator::forDevice(ctx.device, ctx.physicalDevice)
+                         .createBuffer(bi, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, category, outBuffer, outAllocation);
         if (r != VK_SUCCESS)
-            return r;
-        std::memcpy(mapped, indexData, static_cast<size_t>(dataSize));
-        vkUnmapMemory(device, handle.memory);
+            return false;
 
-        return VK_SUCCESS;
+        VkBufferCopy region{};
+        region.srcOffset = stagingOffset;
+        region.size = dataSize;
+        vkCmdCopyBuffer(ctx.cmd, stagingBuffer, outBuffer, 1, &region);
+        return true;
     }
 
-    void DestroyIndexBuffer(VkDevice device, IndexBufferHandle &handle)
+    VkResult CreateStaticVertexBuffer(
+        VkDevice device,
+        VkPhysicalDevice physicalDevice,
+        uint32_t queueFamilyIndex,
+        VkQueue queue,
+        const void *vertexData,
+        VkDeviceSize dataSize,
+        VertexBufferHandle &handle)
     {
-        if (handle.buffer != VK_NULL_HANDLE)
-        {
-            vkDestroyBuffer(device, handle.buffer, nullptr);
-            handle.buffer = VK_NULL_HANDLE;
-        }
-        if (handle.memory != VK_NULL_HANDLE)
-        {
-            vkFreeMemory(device, handle.memory, nullptr);
-            handle.memory = VK_NULL_HANDLE;
-        }
+        return createStaticBuffer(device, physicalDevice, queueFamilyIndex, queue, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                  vertexData, dataSize, handle.buffer, handle.allocation);
+    }
+
+    VkResult CreateStaticIndexBuffer(
+        VkDevice device,
+        VkPhysicalDevice physicalDevice,
+        uint32_t queueFamilyIndex,
+        VkQueue queue,
+        const void *indexData,
+        VkDeviceSize dataSize,
+        IndexBufferHandle &handle)
+    {
+        return createStaticBuffer(device, physicalDevice, queueFamilyIndex, queue, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                  indexData, dataSize, handle.buffer, handle.allocation);
     }
 
     // Device-local buffer creation (not mappable)
@@ -212,50 +182,20 @@ namespace Engine
         VkDeviceSize size,
         VkBufferUsageFlags usage,
         VkBuffer &outBuffer,
-        VkDeviceMemory &outMemory)
+        GpuAllocation &outAllocation,
+        GpuMemoryCategory category)
     {
-        VkBufferCreateInfo bi{};
-        bi.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        bi.size = size;
-        bi.usage = usage; // caller must include VK_BUFFER_USAGE_TRANSFER_DST_BIT
-        bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-        VkBuffer buffer = VK_NULL_HANDLE;
-        VkResult r = vkCreateBuffer(device, &bi, nullptr, &buffer);
-        if (r != VK_SUCCESS)
-            return r;
-
-        VkMemoryRequirements req{};
-        vkGetBufferMemoryRequirements(device, buffer, &req);
-
-        VkMemoryAllocateInfo ai{};
-        ai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        ai.allocationSize = req.size;
-        ai.memoryTypeIndex = findMemoryType(physicalDevice, req.memoryTypeBits,
-                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-        VkDeviceMemory mem = VK_NULL_HANDLE;
-        r = vkAllocateMemory(device, &ai, nullptr, &mem);
-        if (r != VK_SUCCESS)
-        {
-            vkDestroyBuffer(device, buffer, nullptr);
-            return r;
-        }
-
-        r = vkBindBufferMemory(device, buffer, mem, 0);
-        if (r != VK_SUCCESS)
-        {
-            vkDestroyBuffer(device, buffer, nullptr);
-            vkFreeMemory(device, mem, nullptr);
-            return r;
-        }
+        // caller must include VK_BUFFER_USAGE_TRANSFER_DST_BIT
+        return GpuAllocator::forDevice(device, physicalDevice)
+            .createBuffer(size, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, category, outBuffer, outAllocation);
+    }
 
-        outBuffer = buffer;
-        outMemory = mem;
-        return VK_SUCCESS;
+    void DestroyBuffer(VkDevice device, VkBuffer &buffer, GpuAllocation &allocation)
+    {
+        destroyBuffer(device, buffer, allocation);
     }
 
-    // One-shot buffer copy (submit and wait idle)
+    // One-shot buffer copy (submit and wait for this submission only)
     VkResult CopyBuffer(
         VkDevice device,
         VkCommandPool commandPool,
@@ -298,16 +238,28 @@ namespace Engine
             return r;
         }
 
+        // A fence waits for this copy alone; vkQueueWaitIdle would also wait for in-flight frames.
+        VkFence fence = VK_NULL_HANDLE;
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        r = vkCreateFence(device, &fenceInfo, nullptr, &fence);
+        if (r != VK_SUCCESS)
+        {
+            vkFreeCommandBuffers(device, commandPool, 1, &cmd);
+            return r;
+        }
+
         VkSubmitInfo submit{};
         submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         submit.commandBufferCount = 1;
         submit.pCommandBuffers = &cmd;
-        r = vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE);
+        r = vkQueueSubmit(queue, 1, &submit, fence);
         if (r == VK_SUCCESS)
         {
-            vkQueueWaitIdle(queue);
+            r = vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
         }
 
+        vkDestroyFence(device, fence, nullptr);
         vkFreeCommandBuffers(device, commandPool, 1, &cmd);
         return r;
     }
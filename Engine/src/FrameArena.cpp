@@ -0,0 +1,90 @@
+#include "Engine/FrameArena.h"
+
+#include <algorithm>
+
+namespace Engine
+{
+    FrameArena::FrameArena(size_t blockSize)
+        : m_blockSize(std::max<size_t>(blockSize, 1024))
+    {
+    }
+
+    FrameArena &FrameArena::local()
+    {
+        static thread_local FrameArena arena;
+        return arena;
+    }
+
+    void *FrameArena::allocate(size_t size, size_t alignment)
+    {
+        size = std::max<size_t>(size, 1);
+        for (;;)
+        {
+            if (m_block < m_blocks.size())
+            {
+                Block &b = m_blocks[m_block];
+                const uintptr_t base = reinterpret_cast<uintptr_t>(b.data.get());
+                const size_t aligned = static_cast<size_t>(((base + m_offset + alignment - 1) & ~uintptr_t(alignment - 1)) - base);
+                if (aligned <= b.size && size <= b.size - aligned)
+                {
+                    m_offset = aligned + size;
+                    return b.data.get() + aligned;
+                }
+
+                // Move on: reuse the next block if it is big enough, otherwise put a new one there.
+                ++m_block;
+                m_offset = 0;
+                if (m_block < m_blocks.size() && m_blocks[m_block].size >= size + alignment)
+                    continue;
+            }
+            else
+            {
+                m_block = m_blocks.size();
+                m_offset = 0;
+            }
+
+            Block block;
+            block.size = std::max(m_blockSize, size + alignment);
+            block.data.reset(new uint8_t[block.size]);
+            m_blocks.insert(m_blocks.begin() + static_cast<std::ptrdiff_t>(m_block), std::move(block));
+        }
+    }
+
+    void FrameArena::reset()
+    {
+        if (m_blocks.size() > 1)
+        {
+            // Spilled last frame: one block that holds all of it next time.
+            Block merged;
+            merged.size = capacity();
+            m_blocks.clear();
+            merged.data.reset(new uint8_t[merged.size]);
+            m_blocks.push_back(std::move(merged));
+        }
+        m_block = 0;
+        m_offset = 0;
+    }
+
+    void FrameArena::rewind(const Marker &m)
+    {
+        m_block = m.block;
+        m_offset = m.offset;
+    }
+
+    size_t FrameArena::used() const
+    {
+        size_t bytes = 0;
+        for (size_t i = 0; i < m_block && i < m_blocks.size(); ++i)
+            bytes += m_blocks[i].size;
+        return bytes + m_offset;
+    }
+
+    size_t FrameArena::capacity() const
+    {
+        size_t bytes = 0;
+        for (const Block &b : m_blocks)
+            bytes += b.size;
+        return bytes;
+    }
+
+} // namespace Engine
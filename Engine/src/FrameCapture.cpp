@@ -0,0 +1,236 @@
+#include "Engine/FrameCapture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+namespace Engine
+{
+    namespace
+    {
+        // Track ids next to the profiler's thread ids (1, 2, ...).
+        constexpr uint32_t kFrameTrack = 0;
+        constexpr uint32_t kGpuTrack = 1000000;
+
+        void writeJsonString(std::ostream &out, const char *text)
+        {
+            out << '"';
+            for (const char *c = text ? text : ""; *c; ++c)
+            {
+                if (*c == '"' || *c == '\\')
+                    out << '\\' << *c;
+                else if (static_cast<unsigned char>(*c) < 0x20)
+                    out << ' ';
+                else
+                    out << *c;
+            }
+            out << '"';
+        }
+
+        // Chrome trace timestamps are microseconds.
+        void writeMicros(std::ostream &out, uint64_t ns)
+        {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%" PRIu64 ".%03u", ns / 1000, static_cast<unsigned>(ns % 1000));
+            out << buf;
+        }
+
+        void writeCompleteEvent(std::ostream &out, bool &first, const char *name, uint32_t tid, uint64_t startNs, uint64_t durationNs)
+        {
+            out << (first ? "\n" : ",\n") << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << tid << ",\"name\":";
+            writeJsonString(out, name);
+            out << ",\"ts\":";
+            writeMicros(out, startNs);
+            out << ",\"dur\":";
+            writeMicros(out, durationNs);
+            out << "}";
+            first = false;
+        }
+
+        void writeThreadName(std::ostream &out, bool &first, uint32_t tid, const char *name)
+        {
+            out << (first ? "\n" : ",\n") << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+            writeJsonString(out, name);
+            out << "}}";
+            first = false;
+        }
+    } // namespace
+
+    FrameCapture::~FrameCapture()
+    {
+        CpuProfiler::setEventCapture(false);
+        if (m_writer.joinable())
+            m_writer.join();
+    }
+
+    void FrameCapture::configure(const Settings &settings)
+    {
+        m_settings = settings;
+        if (m_settings.hitchThresholdMs <= 0.0f)
+            m_ring.clear();
+        updateEventCapture();
+    }
+
+    void FrameCapture::request(uint32_t frames)
+    {
+        if (m_remaining > 0)
+            return;
+
+        m_remaining = frames > 0 ? frames : std::max(1u, m_settings.requestFrames);
+        m_reason = "request";
+        m_frames.clear();
+        updateEventCapture();
+        std::cout << "FrameCapture: capturing " << m_remaining << " frames\n";
+    }
+
+    void FrameCapture::updateEventCapture()
+    {
+        CpuProfiler::setEventCapture(m_remaining > 0 || m_settings.hitchThresholdMs > 0.0f);
+    }
+
+    void FrameCapture::endFrame(const GpuProfiler *gpu)
+    {
+        const uint64_t now = CpuProfiler::nowNs();
+        if (m_lastFrameEndNs == 0)
+            m_lastFrameEndNs = now;
+
+        FrameRecord frame;
+        frame.index = m_frameIndex++;
+        frame.startNs = m_lastFrameEndNs;
+        frame.endNs = now;
+        m_lastFrameEndNs = now;
+
+        const bool recording = CpuProfiler::eventCapture();
+        if (recording)
+            CpuProfiler::drainEvents(frame.cpu);
+        if (recording && gpu && gpu->resolvedFrames() != m_gpuSerial)
+        {
+            m_gpuSerial = gpu->resolvedFrames();
+            frame.gpu = gpu->results();
+        }
+        if (!recording)
+            return;
+
+        const float frameMs = static_cast<float>(static_cast<double>(frame.endNs - frame.startNs) * 1e-6);
+        const bool hitchTrigger = m_settings.hitchThresholdMs > 0.0f;
+        const uint64_t cooldownNs = static_cast<uint64_t>(std::max(0.0f, m_settings.hitchCooldownSeconds) * 1e9f);
+        frame.hitch = hitchTrigger && frameMs > m_settings.hitchThresholdMs && frame.index >= m_settings.warmupFrames;
+
+        if (m_remaining > 0)
+        {
+            m_frames.push_back(std::move(frame));
+            if (--m_remaining == 0)
+                finish();
+            return;
+        }
+
+        if (!hitchTrigger)
+            return;
+
+        const bool startCapture = frame.hitch && (m_lastHitchNs == 0 || now - m_lastHitchNs >= cooldownNs);
+        m_ring.push_back(std::move(frame));
+        while (m_ring.size() > std::max(1u, m_settings.preRollFrames + 1))
+            m_ring.pop_front();
+        if (!startCapture)
+            return;
+
+        m_lastHitchNs = now;
+        m_reason = "hitch";
+        m_frames.assign(std::make_move_iterator(m_ring.begin()), std::make_move_iterator(m_ring.end()));
+        m_ring.clear();
+        std::cout << "FrameCapture: " << frameMs << " ms hitch, capturing " << m_settings.postRollFrames << " more frames\n";
+
+        m_remaining = m_settings.postRollFrames;
+        if (m_remaining == 0)
+            finish();
+    }
+
+    void FrameCapture::finish()
+    {
+        updateEventCapture();
+        if (m_frames.empty())
+            return;
+
+        const std::time_t wall = std::time(nullptr);
+        char stamp[32] = "capture";
+        if (const std::tm *local = std::localtime(&wall))
+            std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", local);
+
+        std::error_code ec;
+        std::filesystem::create_directories(m_settings.directory, ec);
+        m_lastPath = (std::filesystem::path(m_settings.directory) /
+                      ("trace_" + std::string(stamp) + "_f" + std::to_string(m_frames.front().index) + "_" + m_reason + ".json"))
+                         .string();
+
+        std::vector<std::pair<uint32_t, std::string>> threads;
+        CpuProfiler::threadNames(threads);
+
+        // One trace written at a time; a later capture waits for the previous file.
+        if (m_writer.joinable())
+            m_writer.join();
+        m_writer = std::thread([path = m_lastPath, reason = m_reason, frames = std::move(m_frames), threads = std::move(threads)]()
+                               { writeTrace(path, reason, frames, threads); });
+        m_frames.clear();
+    }
+
+    void FrameCapture::writeTrace(const std::string &path, const std::string &reason, const std::vector<FrameRecord> &frames,
+                                  const std::vector<std::pair<uint32_t, std::string>> &threads)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            std::cerr << "FrameCapture: cannot write " << path << "\n";
+            return;
+        }
+
+        // Events are relative to the first frame so timestamps stay small.
+        uint64_t origin = frames.front().startNs;
+        for (const FrameRecord &f : frames)
+        {
+            for (const CpuProfiler::ScopeEvent &e : f.cpu)
+                origin = std::min(origin, e.startNs);
+        }
+
+        out << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"reason\":";
+        writeJsonString(out, reason.c_str());
+        out << "},\"traceEvents\":[";
+
+        bool first = true;
+        writeThreadName(out, first, kFrameTrack, "Frames");
+        writeThreadName(out, first, kGpuTrack, "GPU (resolved frame)");
+        for (const auto &t : threads)
+            writeThreadName(out, first, t.first, t.second.c_str());
+
+        char label[64];
+        for (const FrameRecord &f : frames)
+        {
+            std::snprintf(label, sizeof(label), "Frame %" PRIu64 "%s", f.index, f.hitch ? " (hitch)" : "");
+            writeCompleteEvent(out, first, label, kFrameTrack, f.startNs - origin, f.endNs - f.startNs);
+
+            for (const CpuProfiler::ScopeEvent &e : f.cpu)
+            {
+                if (e.name && e.startNs >= origin)
+                    writeCompleteEvent(out, first, e.name, e.thread, e.startNs - origin, e.durationNs);
+            }
+
+            for (const GpuProfiler::TimerResult &r : f.gpu)
+            {
+                const uint64_t startNs = f.startNs - origin + static_cast<uint64_t>(static_cast<double>(r.startMs) * 1e6);
+                writeCompleteEvent(out, first, r.name.c_str(), kGpuTrack, startNs, static_cast<uint64_t>(static_cast<double>(r.ms) * 1e6));
+            }
+        }
+        out << "\n]}\n";
+
+        if (out)
+            std::cout << "FrameCapture: wrote " << frames.size() << " frames to " << path << "\n";
+        else
+            std::cerr << "FrameCapture: write failed for " << path << "\n";
+    }
+
+} // namespace Engine
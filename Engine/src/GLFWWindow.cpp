@@ -64,6 +64,7 @@ namespace Engine
                     if (key == GLFW_KEY_DOWN)  d->EventCallback("DownPressed");
                     if (key == GLFW_KEY_ESCAPE) d->EventCallback("EscapePressed");
                     if (key == GLFW_KEY_F1) d->EventCallback("F1Pressed");
+                    if (key == GLFW_KEY_F2 && action == GLFW_PRESS) d->EventCallback("F2Pressed");
                 } });
 
             glfwSetCursorPosCallback(data->Window, [](GLFWwindow *wnd, double x, double y)
@@ -0,0 +1,222 @@
+#include "assets/GeometryPool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+
+namespace Engine
+{
+    namespace
+    {
+        VkDeviceSize alignUp(VkDeviceSize v, VkDeviceSize a)
+        {
+            // Not a power of two in general (vertex strides such as 48).
+            return (a > 1) ? (v + a - 1) / a * a : v;
+        }
+    }
+
+    GeometryPool::GeometryPool(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize)
+        : m_device(device), m_physicalDevice(physicalDevice), m_blockSize(blockSize)
+    {
+    }
+
+    GeometryPool::~GeometryPool()
+    {
+        GpuAllocator &allocator = GpuAllocator::forDevice(m_device, m_physicalDevice);
+        for (Block &b : m_blocks)
+        {
+            if (b.buffer != VK_NULL_HANDLE)
+                allocator.destroyBuffer(b.buffer, b.allocation);
+        }
+        m_blocks.clear();
+    }
+
+    void GeometryPool::setQueueFamilies(const std::vector<uint32_t> &families)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_families = families;
+        std::sort(m_families.begin(), m_families.end());
+        m_families.erase(std::unique(m_families.begin(), m_families.end()), m_families.end());
+    }
+
+    bool GeometryPool::covers(const Block &b, const std::vector<uint32_t> &families) const
+    {
+        // A block with one family is EXCLUSIVE to it; with several, CONCURRENT across them.
+        for (uint32_t f : families)
+        {
+            if (std::find(b.families.begin(), b.families.end(), f) == b.families.end())
+                return false;
+        }
+        return true;
+    }
+
+    bool GeometryPool::createBlock(VkDeviceSize size, bool dedicated, const std::vector<uint32_t> &families,
+                                   uint32_t &outIndex)
+    {
+        Block block;
+        block.size = size;
+        block.dedicated = dedicated;
+        block.families = m_families;
+        for (uint32_t f : families)
+        {
+            if (std::find(block.families.begin(), block.families.end(), f) == block.families.end())
+                block.families.push_back(f);
+        }
+
+        VkBufferCreateInfo bi{};
+        bi.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bi.size = size;
+        bi.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                   VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        if (block.families.size() > 1)
+        {
+            bi.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bi.queueFamilyIndexCount = static_cast<uint32_t>(block.families.size());
+            bi.pQueueFamilyIndices = block.families.data();
+        }
+        else
+        {
+            bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        }
+
+        if (GpuAllocator::forDevice(m_device, m_physicalDevice)
+                .createBuffer(bi, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuMemoryCategory::Geometry,
+                              block.buffer, block.allocation) != VK_SUCCESS)
+        {
+            std::cerr << "[GeometryPool] Failed to create a " << (size >> 20) << " MiB geometry buffer\n";
+            return false;
+        }
+        block.freeRanges.push_back(Range{0, size});
+
+        for (uint32_t i = 0; i < m_blocks.size(); ++i)
+        {
+            if (m_blocks[i].buffer == VK_NULL_HANDLE)
+            {
+                m_blocks[i] = std::move(block);
+                outIndex = i;
+                return true;
+            }
+        }
+        outIndex = static_cast<uint32_t>(m_blocks.size());
+        m_blocks.push_back(std::move(block));
+        return true;
+    }
+
+    bool GeometryPool::allocateFromBlock(uint32_t blockIndex, VkDeviceSize size, VkDeviceSize alignment, GeometryRange &out)
+    {
+        Block &b = m_blocks[blockIndex];
+        for (size_t i = 0; i < b.freeRanges.size(); ++i)
+        {
+            const Range r = b.freeRanges[i];
+            const VkDeviceSize offset = alignUp(r.offset, alignment);
+            const VkDeviceSize pad = offset - r.offset;
+            if (pad + size > r.size)
+                continue;
+
+            // Split into [r.offset, offset) and [offset + size, end).
+            const Range after{offset + size, r.size - pad - size};
+            if (pad > 0)
+            {
+                b.freeRanges[i].size = pad;
+                if (after.size > 0)
+                    b.freeRanges.insert(b.freeRanges.begin() + static_cast<std::ptrdiff_t>(i) + 1, after);
+            }
+            else if (after.size > 0)
+            {
+                b.freeRanges[i] = after;
+            }
+            else
+            {
+                b.freeRanges.erase(b.freeRanges.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+
+            out.buffer = b.buffer;
+            out.offset = offset;
+            out.size = size;
+            out.block = blockIndex;
+            ++b.liveCount;
+            return true;
+        }
+        return false;
+    }
+
+    bool GeometryPool::allocate(VkDeviceSize size, VkDeviceSize alignment, const std::vector<uint32_t> &families,
+                                GeometryRange &out)
+    {
+        out = GeometryRange{};
+        if (size == 0)
+            return false;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (size + alignment > m_blockSize / 2)
+        {
+            uint32_t index = 0;
+            return createBlock(size, true, families, index) && allocateFromBlock(index, size, 1, out);
+        }
+
+        for (uint32_t i = 0; i < m_blocks.size(); ++i)
+        {
+            const Block &b = m_blocks[i];
+            if (b.buffer != VK_NULL_HANDLE && !b.dedicated && covers(b, families) &&
+                allocateFromBlock(i, size, alignment, out))
+                return true;
+        }
+
+        uint32_t index = 0;
+        return createBlock(m_blockSize, false, families, index) && allocateFromBlock(index, size, alignment, out);
+    }
+
+    void GeometryPool::free(GeometryRange &range)
+    {
+        if (!range.valid())
+            return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Block &b = m_blocks[range.block];
+        const Range freed{range.offset, range.size};
+        auto it = std::lower_bound(b.freeRanges.begin(), b.freeRanges.end(), freed,
+                                   [](const Range &a, const Range &v)
+                                   { return a.offset < v.offset; });
+        it = b.freeRanges.insert(it, freed);
+
+        // Coalesce with the following and the preceding range.
+        if (it + 1 != b.freeRanges.end() && it->offset + it->size == (it + 1)->offset)
+        {
+            it->size += (it + 1)->size;
+            b.freeRanges.erase(it + 1);
+        }
+        if (it != b.freeRanges.begin() && (it - 1)->offset + (it - 1)->size == it->offset)
+        {
+            (it - 1)->size += it->size;
+            b.freeRanges.erase(it);
+        }
+
+        --b.liveCount;
+        const uint32_t blockIndex = range.block;
+        range = GeometryRange{};
+        if (b.liveCount > 0)
+            return;
+
+        // Dedicated blocks go right away; keep one empty shared block for the next load.
+        bool release = b.dedicated;
+        for (uint32_t i = 0; !release && i < m_blocks.size(); ++i)
+        {
+            const Block &other = m_blocks[i];
+            release = i != blockIndex && other.buffer != VK_NULL_HANDLE && !other.dedicated && other.liveCount == 0;
+        }
+        if (release)
+        {
+            GpuAllocator::forDevice(m_device, m_physicalDevice).destroyBuffer(b.buffer, b.allocation);
+            b = Block{};
+        }
+    }
+
+    uint32_t GeometryPool::blockCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint32_t n = 0;
+        for (const Block &b : m_blocks)
+            n += (b.buffer != VK_NULL_HANDLE) ? 1u : 0u;
+        return n;
+    }
+}
@@ -0,0 +1,507 @@
+#include "Engine/GpuAllocator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+
+namespace Engine
+{
+    namespace
+    {
+        constexpr VkDeviceSize kDeviceLocalBlockSize = 64ull * 1024ull * 1024ull;
+        constexpr VkDeviceSize kHostBlockSize = 16ull * 1024ull * 1024ull;
+        constexpr VkDeviceSize kMinBlockSize = 1ull * 1024ull * 1024ull;
+
+        VkDeviceSize alignUp(VkDeviceSize v, VkDeviceSize a)
+        {
+            return (a > 1) ? (v + a - 1) / a * a : v;
+        }
+
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<GpuAllocator>> allocators;
+        };
+
+        Registry &registry()
+        {
+            static Registry r;
+            return r;
+        }
+    }
+
+    const char *gpuMemoryCategoryName(GpuMemoryCategory category)
+    {
+        switch (category)
+        {
+        case GpuMemoryCategory::Geometry:
+            return "Geometry";
+        case GpuMemoryCategory::Texture:
+            return "Texture";
+        case GpuMemoryCategory::RenderTarget:
+            return "RenderTarget";
+        case GpuMemoryCategory::Dynamic:
+            return "Dynamic";
+        case GpuMemoryCategory::Staging:
+            return "Staging";
+        case GpuMemoryCategory::Compute:
+            return "Compute";
+        default:
+            return "Other";
+        }
+    }
+
+    GpuAllocator &GpuAllocator::forDevice(VkDevice device, VkPhysicalDevice physicalDevice)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const auto &a : r.allocators)
+        {
+            if (a->m_device == device)
+                return *a;
+        }
+        r.allocators.push_back(std::make_unique<GpuAllocator>(device, physicalDevice));
+        return *r.allocators.back();
+    }
+
+    GpuAllocator *GpuAllocator::find(VkDevice device)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const auto &a : r.allocators)
+        {
+            if (a->m_device == device)
+                return a.get();
+        }
+        return nullptr;
+    }
+
+    void GpuAllocator::releaseDevice(VkDevice device)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.allocators.erase(std::remove_if(r.allocators.begin(), r.allocators.end(),
+                                          [device](const std::unique_ptr<GpuAllocator> &a)
+                                          { return a->m_device == device; }),
+                           r.allocators.end());
+    }
+
+    GpuAllocator::GpuAllocator(VkDevice device, VkPhysicalDevice physicalDevice)
+        : m_device(device), m_physicalDevice(physicalDevice)
+    {
+        vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_memProps);
+
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(m_physicalDevice, &props);
+        m_granularity = std::max<VkDeviceSize>(1, props.limits.bufferImageGranularity);
+    }
+
+    GpuAllocator::~GpuAllocator()
+    {
+        if (m_stats.allocationCount > 0)
+        {
+            std::cerr << "[GpuAllocator] " << m_stats.allocationCount << " allocation(s) still live at shutdown\n";
+        }
+        for (Block &b : m_blocks)
+        {
+            if (b.memory == VK_NULL_HANDLE)
+                continue;
+            if (b.mapped)
+                vkUnmapMemory(m_device, b.memory);
+            vkFreeMemory(m_device, b.memory, nullptr);
+        }
+        m_blocks.clear();
+    }
+
+    bool GpuAllocator::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties, uint32_t &outType) const
+    {
+        for (uint32_t i = 0; i < m_memProps.memoryTypeCount; ++i)
+        {
+            if ((typeBits & (1u << i)) && (m_memProps.memoryTypes[i].propertyFlags & properties) == properties)
+            {
+                outType = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool GpuAllocator::isHostVisible(uint32_t memoryType) const
+    {
+        return (m_memProps.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+    }
+
+    bool GpuAllocator::isDeviceLocal(uint32_t memoryType) const
+    {
+        return (m_memProps.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0;
+    }
+
+    VkDeviceSize GpuAllocator::blockSizeFor(uint32_t memoryType) const
+    {
+        // Small heaps (e.g. the 256 MiB BAR window) get proportionally smaller blocks.
+        const VkDeviceSize heapSize = m_memProps.memoryHeaps[m_memProps.memoryTypes[memoryType].heapIndex].size;
+        const VkDeviceSize preferred = (isDeviceLocal(memoryType) && !isHostVisible(memoryType)) ? kDeviceLocalBlockSize : kHostBlockSize;
+        return std::max(kMinBlockSize, std::min(preferred, heapSize / 8));
+    }
+
+    VkResult GpuAllocator::allocateMemory(uint32_t memoryType, VkDeviceSize size, VkDeviceMemory &outMemory, void *&outMapped)
+    {
+        VkMemoryAllocateInfo ai{};
+        ai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        ai.allocationSize = size;
+        ai.memoryTypeIndex = memoryType;
+
+        outMemory = VK_NULL_HANDLE;
+        outMapped = nullptr;
+        VkResult r = vkAllocateMemory(m_device, &ai, nullptr, &outMemory);
+        if (r != VK_SUCCESS)
+            return r;
+
+        if (isHostVisible(memoryType))
+        {
+            r = vkMapMemory(m_device, outMemory, 0, VK_WHOLE_SIZE, 0, &outMapped);
+            if (r != VK_SUCCESS)
+            {
+                vkFreeMemory(m_device, outMemory, nullptr);
+                outMemory = VK_NULL_HANDLE;
+                return r;
+            }
+        }
+
+        m_stats.reservedBytes += size;
+        m_stats.reservedHeapBytes[m_memProps.memoryTypes[memoryType].heapIndex] += size;
+        ++m_stats.deviceMemoryCount;
+        return VK_SUCCESS;
+    }
+
+    bool GpuAllocator::allocateFromBlock(uint32_t blockIndex, VkDeviceSize size, VkDeviceSize alignment, GpuAllocation &out)
+    {
+        Block &b = m_blocks[blockIndex];
+        for (size_t i = 0; i < b.freeRanges.size(); ++i)
+        {
+            const Range r = b.freeRanges[i];
+            const VkDeviceSize offset = alignUp(r.offset, alignment);
+            const VkDeviceSize pad = offset - r.offset;
+            if (pad + size > r.size)
+                continue;
+
+            // Split into [r.offset, offset) and [offset + size, end).
+            const Range after{offset + size, r.size - pad - size};
+            if (pad > 0)
+            {
+                b.freeRanges[i].size = pad;
+                if (after.size > 0)
+                    b.freeRanges.insert(b.freeRanges.begin() + static_cast<std::ptrdiff_t>(i) + 1, after);
+            }
+            else if (after.size > 0)
+            {
+                b.freeRanges[i] = after;
+            }
+            else
+            {
+                b.freeRanges.erase(b.freeRanges.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+
+            out.memory = b.memory;
+            out.offset = offset;
+            out.size = size;
+            out.mapped = b.mapped ? static_cast<uint8_t *>(b.mapped) + offset : nullptr;
+            out.memoryType = b.memoryType;
+            out.block = blockIndex;
+            ++b.liveCount;
+            return true;
+        }
+        return false;
+    }
+
+    VkResult GpuAllocator::allocateOfType(uint32_t memoryType, const VkMemoryRequirements &req, GpuAllocation &out)
+    {
+        const VkDeviceSize alignment = std::max(req.alignment, m_granularity);
+        const VkDeviceSize size = alignUp(req.size, m_granularity);
+        const VkDeviceSize blockSize = blockSizeFor(memoryType);
+
+        if (size > blockSize / 2)
+        {
+            void *mapped = nullptr;
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            const VkResult r = allocateMemory(memoryType, size, memory, mapped);
+            if (r != VK_SUCCESS)
+                return r;
+            out.memory = memory;
+            out.offset = 0;
+            out.size = size;
+            out.mapped = mapped;
+            out.memoryType = memoryType;
+            out.block = GpuAllocation::kDedicated;
+            return VK_SUCCESS;
+        }
+
+        uint32_t freeSlot = GpuAllocation::kDedicated;
+        for (uint32_t i = 0; i < m_blocks.size(); ++i)
+        {
+            if (m_blocks[i].memory == VK_NULL_HANDLE)
+            {
+                if (freeSlot == GpuAllocation::kDedicated)
+                    freeSlot = i;
+                continue;
+            }
+            if (m_blocks[i].memoryType == memoryType && allocateFromBlock(i, size, alignment, out))
+                return VK_SUCCESS;
+        }
+
+        Block block;
+        block.size = blockSize;
+        block.memoryType = memoryType;
+        const VkResult r = allocateMemory(memoryType, blockSize, block.memory, block.mapped);
+        if (r != VK_SUCCESS)
+            return r;
+        block.freeRanges.push_back(Range{0, blockSize});
+
+        if (freeSlot == GpuAllocation::kDedicated)
+        {
+            freeSlot = static_cast<uint32_t>(m_blocks.size());
+            m_blocks.push_back(std::move(block));
+        }
+        else
+        {
+            m_blocks[freeSlot] = std::move(block);
+        }
+        return allocateFromBlock(freeSlot, size, alignment, out) ? VK_SUCCESS : VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+
+    VkResult GpuAllocator::allocate(const VkMemoryRequirements &req, VkMemoryPropertyFlags required,
+                                    GpuMemoryCategory category, GpuAllocation &out, VkMemoryPropertyFlags preferred)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out = GpuAllocation{};
+
+        // Try every compatible type with the preferred flags first, then with only the required ones
+        // (a full heap moves on to the next type instead of failing).
+        VkResult last = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        const VkMemoryPropertyFlags passes[2] = {required | preferred, required};
+        for (uint32_t pass = (preferred != 0) ? 0u : 1u; pass < 2; ++pass)
+        {
+            for (uint32_t i = 0; i < m_memProps.memoryTypeCount; ++i)
+            {
+                if (!(req.memoryTypeBits & (1u << i)) || (m_memProps.memoryTypes[i].propertyFlags & passes[pass]) != passes[pass])
+                    continue;
+
+                last = allocateOfType(i, req, out);
+                if (last != VK_SUCCESS)
+                    continue;
+
+                out.category = category;
+                m_stats.usedBytes[static_cast<size_t>(category)] += out.size;
+                if (isDeviceLocal(i))
+                    m_stats.usedDeviceLocalBytes += out.size;
+                ++m_stats.allocationCount;
+                return VK_SUCCESS;
+            }
+        }
+        return last;
+    }
+
+    void GpuAllocator::free(GpuAllocation &allocation)
+    {
+        if (!allocation.valid())
+            return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.usedBytes[static_cast<size_t>(allocation.category)] -= allocation.size;
+        if (isDeviceLocal(allocation.memoryType))
+            m_stats.usedDeviceLocalBytes -= allocation.size;
+        --m_stats.allocationCount;
+
+        if (allocation.block == GpuAllocation::kDedicated)
+        {
+            if (allocation.mapped)
+                vkUnmapMemory(m_device, allocation.memory);
+            vkFreeMemory(m_device, allocation.memory, nullptr);
+            m_stats.reservedBytes -= allocation.size;
+            m_stats.reservedHeapBytes[m_memProps.memoryTypes[allocation.memoryType].heapIndex] -= allocation.size;
+            --m_stats.deviceMemoryCount;
+            allocation = GpuAllocation{};
+            return;
+        }
+
+        Block &b = m_blocks[allocation.block];
+        const Range freed{allocation.offset, allocation.size};
+        auto it = std::lower_bound(b.freeRanges.begin(), b.freeRanges.end(), freed,
+                                   [](const Range &a, const Range &v)
+                                   { return a.offset < v.offset; });
+        it = b.freeRanges.insert(it, freed);
+
+        // Coalesce with the following and the preceding range.
+        if (it + 1 != b.freeRanges.end() && it->offset + it->size == (it + 1)->offset)
+        {
+            it->size += (it + 1)->size;
+            b.freeRanges.erase(it + 1);
+        }
+        if (it != b.freeRanges.begin() && (it - 1)->offset + (it - 1)->size == it->offset)
+        {
+            (it - 1)->size += it->size;
+            b.freeRanges.erase(it);
+        }
+
+        --b.liveCount;
+        const uint32_t blockIndex = allocation.block;
+        allocation = GpuAllocation{};
+        if (b.liveCount > 0)
+            return;
+
+        // Keep one empty block per memory type so grow/shrink cycles do not hit vkAllocateMemory.
+        for (uint32_t i = 0; i < m_blocks.size(); ++i)
+        {
+            const Block &other = m_blocks[i];
+            if (i != blockIndex && other.memory != VK_NULL_HANDLE && other.memoryType == b.memoryType && other.liveCount == 0)
+            {
+                if (b.mapped)
+                    vkUnmapMemory(m_device, b.memory);
+                vkFreeMemory(m_device, b.memory, nullptr);
+                m_stats.reservedBytes -= b.size;
+                m_stats.reservedHeapBytes[m_memProps.memoryTypes[b.memoryType].heapIndex] -= b.size;
+                --m_stats.deviceMemoryCount;
+                b = Block{};
+                return;
+            }
+        }
+    }
+
+    VkResult GpuAllocator::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags required,
+                                        GpuMemoryCategory category, VkBuffer &outBuffer, GpuAllocation &outAllocation,
+                                        VkMemoryPropertyFlags preferred)
+    {
+        VkBufferCreateInfo bi{};
+        bi.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bi.size = size;
+        bi.usage = usage;
+        if (m_bufferQueueFamilies.size() > 1)
+        {
+            bi.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bi.queueFamilyIndexCount = static_cast<uint32_t>(m_bufferQueueFamilies.size());
+            bi.pQueueFamilyIndices = m_bufferQueueFamilies.data();
+        }
+        else
+        {
+            bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        }
+
+        return createBuffer(bi, required, category, outBuffer, outAllocation, preferred);
+    }
+
+    VkResult GpuAllocator::createBuffer(const VkBufferCreateInfo &info, VkMemoryPropertyFlags required,
+                                        GpuMemoryCategory category, VkBuffer &outBuffer, GpuAllocation &outAllocation,
+                                        VkMemoryPropertyFlags preferred)
+    {
+        outBuffer = VK_NULL_HANDLE;
+        outAllocation = GpuAllocation{};
+
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkResult r = vkCreateBuffer(m_device, &info, nullptr, &buffer);
+        if (r != VK_SUCCESS)
+            return r;
+
+        VkMemoryRequirements req{};
+        vkGetBufferMemoryRequirements(m_device, buffer, &req);
+
+        GpuAllocation allocation;
+        r = allocate(req, required, category, allocation, preferred);
+        if (r == VK_SUCCESS)
+            r = vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+        if (r != VK_SUCCESS)
+        {
+            vkDestroyBuffer(m_device, buffer, nullptr);
+            free(allocation);
+            return r;
+        }
+
+        outBuffer = buffer;
+        outAllocation = allocation;
+        return VK_SUCCESS;
+    }
+
+    void GpuAllocator::destroyBuffer(VkBuffer &buffer, GpuAllocation &allocation)
+    {
+        if (buffer != VK_NULL_HANDLE)
+            vkDestroyBuffer(m_device, buffer, nullptr);
+        buffer = VK_NULL_HANDLE;
+        free(allocation);
+    }
+
+    VkResult GpuAllocator::createImage(const VkImageCreateInfo &info, VkMemoryPropertyFlags required,
+                                       GpuMemoryCategory category, VkImage &outImage, GpuAllocation &outAllocation)
+    {
+        outImage = VK_NULL_HANDLE;
+        outAllocation = GpuAllocation{};
+
+        VkImage image = VK_NULL_HANDLE;
+        VkResult r = vkCreateImage(m_device, &info, nullptr, &image);
+        if (r != VK_SUCCESS)
+            return r;
+
+        VkMemoryRequirements req{};
+        vkGetImageMemoryRequirements(m_device, image, &req);
+
+        GpuAllocation allocation;
+        r = allocate(req, required, category, allocation);
+        if (r == VK_SUCCESS)
+            r = vkBindImageMemory(m_device, image, allocation.memory, allocation.offset);
+        if (r != VK_SUCCESS)
+        {
+            vkDestroyImage(m_device, image, nullptr);
+            free(allocation);
+            return r;
+        }
+
+        outImage = image;
+        outAllocation = allocation;
+        return VK_SUCCESS;
+    }
+
+    void GpuAllocator::destroyImage(VkImage &image, GpuAllocation &allocation)
+    {
+        if (image != VK_NULL_HANDLE)
+            vkDestroyImage(m_device, image, nullptr);
+        image = VK_NULL_HANDLE;
+        free(allocation);
+    }
+
+    GpuAllocator::Stats GpuAllocator::stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+    std::vector<GpuAllocator::HeapBudget> GpuAllocator::heapBudgets() const
+    {
+        const Stats s = stats();
+        std::vector<HeapBudget> heaps(m_memProps.memoryHeapCount);
+        for (uint32_t h = 0; h < m_memProps.memoryHeapCount; ++h)
+        {
+            HeapBudget &hb = heaps[h];
+            hb.size = m_memProps.memoryHeaps[h].size;
+            hb.budget = hb.size;
+            hb.usage = s.reservedHeapBytes[h];
+            hb.allocatorBytes = s.reservedHeapBytes[h];
+            hb.deviceLocal = (m_memProps.memoryHeaps[h].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        }
+
+        if (m_budgetQuery)
+        {
+            VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+            budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+            VkPhysicalDeviceMemoryProperties2KHR props{};
+            props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+            props.pNext = &budget;
+            m_budgetQuery(m_physicalDevice, &props);
+            for (uint32_t h = 0; h < m_memProps.memoryHeapCount; ++h)
+            {
+                heaps[h].budget = budget.heapBudget[h];
+                heaps[h].usage = budget.heapUsage[h];
+                heaps[h].fromDriver = true;
+            }
+        }
+        return heaps;
+    }
+}
@@ -0,0 +1,429 @@
+#include "Engine/GpuInstanceCuller.h"
+#include "Engine/VulkanContext.h"
+#include "Engine/Pipeline.h"
+#include "Engine/PipelineCache.h"
+#include "utils/BufferUtils.h"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace Engine
+{
+    namespace
+    {
+        constexpr uint32_t kGroupSize = 64; // local_size_x in smodel_cull*.comp
+        constexpr uint32_t kBindingCount = 4;
+
+        VkPipeline createComputePipeline(VkDevice device, VkPipelineLayout layout, VkShaderModule module)
+        {
+            VkComputePipelineCreateInfo ci{};
+            ci.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            ci.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            ci.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+            ci.stage.module = module;
+            ci.stage.pName = "main";
+            ci.layout = layout;
+
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            if (vkCreateComputePipelines(device, PipelineCache::get(device), 1, &ci, nullptr, &pipeline) != VK_SUCCESS)
+                return VK_NULL_HANDLE;
+            return pipeline;
+        }
+    }
+
+    bool GpuInstanceCuller::create(VulkanContext &ctx, size_t frameCount, VkDescriptorSetLayout drawSetLayout)
+    {
+        destroy();
+
+        m_device = ctx.GetDevice();
+        m_physicalDevice = ctx.GetPhysicalDevice();
+        if (frameCount == 0)
+            frameCount = 1;
+
+        // Missing SPIR-V is not an error: the caller keeps the unculled path.
+        VkShaderModule cullModule = VK_NULL_HANDLE;
+        VkShaderModule argsModule = VK_NULL_HANDLE;
+        try
+        {
+            cullModule = Pipeline::createShaderModuleFromFile(m_device, "shaders/smodel_cull.comp.spv");
+            argsModule = Pipeline::createShaderModuleFromFile(m_device, "shaders/smodel_cull_args.comp.spv");
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[GpuInstanceCuller] GPU culling disabled: " << e.what() << "\n";
+            if (cullModule != VK_NULL_HANDLE)
+                vkDestroyShaderModule(m_device, cullModule, nullptr);
+            return false;
+        }
+
+        VkDescriptorSetLayoutBinding bindings[kBindingCount]{};
+        for (uint32_t b = 0; b < kBindingCount; ++b)
+        {
+            bindings[b].binding = b;
+            bindings[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[b].descriptorCount = 1;
+            bindings[b].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo dsl{};
+        dsl.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        dsl.bindingCount = kBindingCount;
+        dsl.pBindings = bindings;
+
+        VkPushConstantRange pcRange{};
+        pcRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pcRange.offset = 0;
+        pcRange.size = sizeof(PushConstants);
+
+        bool ok = vkCreateDescriptorSetLayout(m_device, &dsl, nullptr, &m_setLayout) == VK_SUCCESS;
+        if (ok)
+        {
+            VkPipelineLayoutCreateInfo pl{};
+            pl.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            pl.setLayoutCount = 1;
+            pl.pSetLayouts = &m_setLayout;
+            pl.pushConstantRangeCount = 1;
+            pl.pPushConstantRanges = &pcRange;
+            ok = vkCreatePipelineLayout(m_device, &pl, nullptr, &m_pipelineLayout) == VK_SUCCESS;
+        }
+        if (ok)
+        {
+            m_cullPipeline = createComputePipeline(m_device, m_pipelineLayout, cullModule);
+            m_argsPipeline = createComputePipeline(m_device, m_pipelineLayout, argsModule);
+            ok = m_cullPipeline != VK_NULL_HANDLE && m_argsPipeline != VK_NULL_HANDLE;
+        }
+
+        vkDestroyShaderModule(m_device, cullModule, nullptr);
+        vkDestroyShaderModule(m_device, argsModule, nullptr);
+
+        if (ok)
+            createOcclusionPipeline(pcRange);
+        const bool occlusion = occlusionReady();
+
+        // Per frame: one compute set (4 SSBOs) + one draw set (camera UBO + 2 SSBOs), plus the
+        // occlusion set (camera UBO + Hi-Z) when the occlusion shader is available.
+        if (ok)
+        {
+            const uint32_t frames = static_cast<uint32_t>(frameCount);
+            VkDescriptorPoolSize sizes[3]{};
+            sizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            sizes[0].descriptorCount = frames * (kBindingCount + 2u);
+            sizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            sizes[1].descriptorCount = frames * (occlusion ? 2u : 1u);
+            sizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            sizes[2].descriptorCount = frames;
+
+            VkDescriptorPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            poolInfo.maxSets = frames * (occlusion ? 3u : 2u);
+            poolInfo.poolSizeCount = occlusion ? 3u : 2u;
+            poolInfo.pPoolSizes = sizes;
+            ok = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_pool) == VK_SUCCESS;
+        }
+
+        if (ok)
+        {
+            m_frames.resize(frameCount);
+            for (Frame &f : m_frames)
+            {
+                VkDescriptorSetLayout layouts[3] = {m_setLayout, drawSetLayout, m_occlusionSetLayout};
+                VkDescriptorSet sets[3] = {VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE};
+
+                VkDescriptorSetAllocateInfo ai{};
+                ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+                ai.descriptorPool = m_pool;
+                ai.descriptorSetCount = occlusion ? 3u : 2u;
+                ai.pSetLayouts = layouts;
+                if (vkAllocateDescriptorSets(m_device, &ai, sets) != VK_SUCCESS)
+                {
+                    ok = false;
+                    break;
+                }
+                f.computeSet = sets[0];
+                f.drawSet = sets[1];
+                f.occlusionSet = sets[2];
+            }
+        }
+
+        if (!ok)
+        {
+            std::cerr << "[GpuInstanceCuller] GPU culling disabled: failed to create compute resources\n";
+            destroy();
+            return false;
+        }
+        return true;
+    }
+
+    void GpuInstanceCuller::destroy()
+    {
+        if (m_device == VK_NULL_HANDLE)
+            return;
+
+        for (Frame &f : m_frames)
+        {
+            destroyBuffer(f.worlds);
+            destroyBuffer(f.visible);
+            destroyBuffer(f.commands);
+        }
+        m_frames.clear();
+
+        if (m_cullPipeline != VK_NULL_HANDLE)
+            vkDestroyPipeline(m_device, m_cullPipeline, nullptr);
+        if (m_argsPipeline != VK_NULL_HANDLE)
+            vkDestroyPipeline(m_device, m_argsPipeline, nullptr);
+        if (m_occlusionPipeline != VK_NULL_HANDLE)
+            vkDestroyPipeline(m_device, m_occlusionPipeline, nullptr);
+        if (m_occlusionPipelineLayout != VK_NULL_HANDLE)
+            vkDestroyPipelineLayout(m_device, m_occlusionPipelineLayout, nullptr);
+        if (m_occlusionSetLayout != VK_NULL_HANDLE)
+            vkDestroyDescriptorSetLayout(m_device, m_occlusionSetLayout, nullptr);
+        if (m_pipelineLayout != VK_NULL_HANDLE)
+            vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+        if (m_pool != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(m_device, m_pool, nullptr); // frees the sets
+        if (m_setLayout != VK_NULL_HANDLE)
+            vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+
+        m_cullPipeline = VK_NULL_HANDLE;
+        m_argsPipeline = VK_NULL_HANDLE;
+        m_occlusionPipeline = VK_NULL_HANDLE;
+        m_occlusionPipelineLayout = VK_NULL_HANDLE;
+        m_occlusionSetLayout = VK_NULL_HANDLE;
+        m_pipelineLayout = VK_NULL_HANDLE;
+        m_pool = VK_NULL_HANDLE;
+        m_setLayout = VK_NULL_HANDLE;
+        m_device = VK_NULL_HANDLE;
+        m_physicalDevice = VK_NULL_HANDLE;
+    }
+
+    void GpuInstanceCuller::createOcclusionPipeline(VkPushConstantRange pcRange)
+    {
+        VkShaderModule module = VK_NULL_HANDLE;
+        try
+        {
+            module = Pipeline::createShaderModuleFromFile(m_device, "shaders/smodel_cull_occlusion.comp.spv");
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[GpuInstanceCuller] occlusion culling disabled: " << e.what() << "\n";
+            return;
+        }
+
+        VkDescriptorSetLayoutBinding bindings[2]{};
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        bindings[0].descriptorCount = 1;
+        bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[1].descriptorCount = 1;
+        bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutCreateInfo dsl{};
+        dsl.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        dsl.bindingCount = 2;
+        dsl.pBindings = bindings;
+
+        // Set 0 and the push constants match m_pipelineLayout, so both pipelines share set 0 bindings.
+        bool ok = vkCreateDescriptorSetLayout(m_device, &dsl, nullptr, &m_occlusionSetLayout) == VK_SUCCESS;
+        if (ok)
+        {
+            const VkDescriptorSetLayout layouts[2] = {m_setLayout, m_occlusionSetLayout};
+            VkPipelineLayoutCreateInfo pl{};
+            pl.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            pl.setLayoutCount = 2;
+            pl.pSetLayouts = layouts;
+            pl.pushConstantRangeCount = 1;
+            pl.pPushConstantRanges = &pcRange;
+            ok = vkCreatePipelineLayout(m_device, &pl, nullptr, &m_occlusionPipelineLayout) == VK_SUCCESS;
+        }
+        if (ok)
+            m_occlusionPipeline = createComputePipeline(m_device, m_occlusionPipelineLayout, module);
+        vkDestroyShaderModule(m_device, module, nullptr);
+
+        if (m_occlusionPipeline == VK_NULL_HANDLE)
+        {
+            std::cerr << "[GpuInstanceCuller] occlusion culling disabled: failed to create the pipeline\n";
+            if (m_occlusionPipelineLayout != VK_NULL_HANDLE)
+                vkDestroyPipelineLayout(m_device, m_occlusionPipelineLayout, nullptr);
+            if (m_occlusionSetLayout != VK_NULL_HANDLE)
+                vkDestroyDescriptorSetLayout(m_device, m_occlusionSetLayout, nullptr);
+            m_occlusionPipelineLayout = VK_NULL_HANDLE;
+            m_occlusionSetLayout = VK_NULL_HANDLE;
+        }
+    }
+
+    void GpuInstanceCuller::destroyBuffer(Buffer &b)
+    {
+        DestroyBuffer(m_device, b.buffer, b.allocation);
+        b = Buffer{};
+    }
+
+    bool GpuInstanceCuller::ensureBuffer(Buffer &b, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible)
+    {
+        if (size <= b.size && b.buffer != VK_NULL_HANDLE)
+            return true;
+
+        // Grow by doubling; the frame's fence has signalled, so the old buffer is idle.
+        VkDeviceSize newSize = (b.size > 0) ? b.size : 256;
+        while (newSize < size)
+            newSize *= 2;
+        destroyBuffer(b);
+
+        const VkMemoryPropertyFlags props = hostVisible
+                                                ? (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+                                                : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        if (GpuAllocator::forDevice(m_device, m_physicalDevice)
+                .createBuffer(newSize, usage, props, GpuMemoryCategory::Compute, b.buffer, b.allocation) != VK_SUCCESS)
+            return false;
+        b.mapped = b.allocation.mapped;
+        b.size = newSize;
+        return true;
+    }
+
+    bool GpuInstanceCuller::record(VkCommandBuffer cmd, uint32_t frameIndex, const Inputs &in,
+                                   const Frustum &frustum, const glm::vec4 &sphere,
+                                   const std::vector<VkDrawIndexedIndirectCommand> &commands, bool asyncQueue)
+    {
+        if (!prepare(frameIndex, in, commands))
+            return false;
+        recordDispatch(cmd, frameIndex, frustum, sphere, nullptr, asyncQueue);
+        return true;
+    }
+
+    bool GpuInstanceCuller::prepare(uint32_t frameIndex, const Inputs &in, const std::vector<VkDrawIndexedIndirectCommand> &commands)
+    {
+        if (!ready() || m_frames.empty() || in.instanceCount == 0 || commands.empty())
+            return false;
+        if (in.instanceStride == 0 || in.instanceStride % sizeof(glm::vec4) != 0)
+            return false;
+        if (in.worlds == VK_NULL_HANDLE || in.nodes == VK_NULL_HANDLE || in.joints == VK_NULL_HANDLE || in.cameraUbo == VK_NULL_HANDLE)
+            return false;
+
+        Frame &f = m_frames[frameIndex % m_frames.size()];
+        const bool ok =
+            ensureBuffer(f.worlds, static_cast<VkDeviceSize>(in.instanceStride) * in.instanceCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, false) &&
+            ensureBuffer(f.visible, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false) &&
+            ensureBuffer(f.commands, sizeof(VkDrawIndexedIndirectCommand) * commands.size(),
+                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, true);
+        if (!ok)
+            return false;
+
+        // Host writes before vkQueueSubmit are visible to the GPU without a barrier.
+        std::memcpy(f.commands.mapped, commands.data(), sizeof(VkDrawIndexedIndirectCommand) * commands.size());
+
+        // Buffers may have been recreated (ours or the caller's palettes), so rewrite both sets.
+        const VkBuffer computeBuffers[kBindingCount] = {in.worlds, f.worlds.buffer, f.visible.buffer, f.commands.buffer};
+        VkDescriptorBufferInfo infos[kBindingCount + 3]{};
+        VkWriteDescriptorSet writes[kBindingCount + 3]{};
+        for (uint32_t b = 0; b < kBindingCount; ++b)
+        {
+            infos[b] = {computeBuffers[b], 0, VK_WHOLE_SIZE};
+            writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[b].dstSet = f.computeSet;
+            writes[b].dstBinding = b;
+            writes[b].descriptorCount = 1;
+            writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[b].pBufferInfo = &infos[b];
+        }
+
+        infos[kBindingCount + 0] = {in.cameraUbo, 0, in.cameraUboSize};
+        infos[kBindingCount + 1] = {in.nodes, 0, VK_WHOLE_SIZE};
+        infos[kBindingCount + 2] = {in.joints, 0, VK_WHOLE_SIZE};
+        for (uint32_t b = 0; b < 3; ++b)
+        {
+            VkWriteDescriptorSet &w = writes[kBindingCount + b];
+            w.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            w.dstSet = f.drawSet;
+            w.dstBinding = b;
+            w.descriptorCount = 1;
+            w.descriptorType = (b == 0) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            w.pBufferInfo = &infos[kBindingCount + b];
+        }
+        vkUpdateDescriptorSets(m_device, kBindingCount + 3, writes, 0, nullptr);
+
+        f.cameraUbo = in.cameraUbo;
+        f.cameraUboSize = in.cameraUboSize;
+        f.counts = glm::uvec4(in.instanceCount, in.instanceStride / static_cast<uint32_t>(sizeof(glm::vec4)),
+                              in.compactInstances ? 1u : 0u, static_cast<uint32_t>(commands.size()));
+        return true;
+    }
+
+    void GpuInstanceCuller::recordDispatch(VkCommandBuffer cmd, uint32_t frameIndex, const Frustum &frustum, const glm::vec4 &sphere,
+                                           const Occlusion *occlusion, bool asyncQueue)
+    {
+        if (!ready() || m_frames.empty())
+            return;
+        Frame &f = m_frames[frameIndex % m_frames.size()];
+        if (occlusion && (!occlusionReady() || occlusion->hiZ == VK_NULL_HANDLE || occlusion->sampler == VK_NULL_HANDLE))
+            occlusion = nullptr;
+
+        PushConstants pc{};
+        for (int p = 0; p < Frustum::Count; ++p)
+            pc.planes[p] = frustum.planes[p];
+        pc.sphere = sphere;
+        pc.counts = f.counts;
+
+        if (occlusion)
+        {
+            // The Hi-Z view changes with the extent, so the set is rewritten every frame.
+            VkDescriptorBufferInfo camera{f.cameraUbo, 0, f.cameraUboSize};
+            VkDescriptorImageInfo hiZ{occlusion->sampler, occlusion->hiZ, VK_IMAGE_LAYOUT_GENERAL};
+            VkWriteDescriptorSet writes[2]{};
+            writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[0].dstSet = f.occlusionSet;
+            writes[0].dstBinding = 0;
+            writes[0].descriptorCount = 1;
+            writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            writes[0].pBufferInfo = &camera;
+            writes[1] = writes[0];
+            writes[1].dstBinding = 1;
+            writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[1].pBufferInfo = nullptr;
+            writes[1].pImageInfo = &hiZ;
+            vkUpdateDescriptorSets(m_device, 2, writes, 0, nullptr);
+        }
+
+        // Reset the visible counter.
+        vkCmdFillBuffer(cmd, f.visible.buffer, 0, sizeof(uint32_t), 0);
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &f.computeSet, 0, nullptr);
+        vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pc);
+
+        if (occlusion)
+        {
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_occlusionPipelineLayout, 1, 1, &f.occlusionSet, 0, nullptr);
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_occlusionPipeline);
+        }
+        else
+        {
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPipeline);
+        }
+        vkCmdDispatch(cmd, (f.counts.x + kGroupSize - 1) / kGroupSize, 1, 1);
+
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_argsPipeline);
+        vkCmdDispatch(cmd, (f.counts.w + kGroupSize - 1) / kGroupSize, 1, 1);
+
+        // Compacted instances feed vertex input / vertex shader; commands feed the indirect draws.
+        if (asyncQueue)
+            return;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+}
@@ -0,0 +1,447 @@
+#include "Engine/GpuPoseEvaluator.h"
+#include "Engine/VulkanContext.h"
+#include "Engine/Pipeline.h"
+#include "Engine/PipelineCache.h"
+#include "assets/ModelAsset.h"
+#include "utils/BufferUtils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace Engine
+{
+    namespace
+    {
+        constexpr uint32_t kGroupSize = 64; // local_size_x in smodel_pose.comp
+        constexpr uint32_t kBindingCount = 6;
+        constexpr VkDeviceSize kStagingAlign = 256;
+
+        VkDeviceSize alignUp(VkDeviceSize v, VkDeviceSize a)
+        {
+            return (v + a - 1) / a * a;
+        }
+    }
+
+    bool GpuPoseEvaluator::supports(const ModelAsset &model)
+    {
+        if (model.nodes.empty() || model.animClips.empty() || model.bakedClips.size() != model.animClips.size())
+            return false;
+        const size_t nodeCount = model.nodes.size();
+        for (const ModelAsset::BakedClip &b : model.bakedClips)
+        {
+            if (b.frameCount == 0 || b.globals.size() != static_cast<size_t>(b.frameCount) * nodeCount)
+                return false;
+        }
+        return true;
+    }
+
+    bool GpuPoseEvaluator::create(VulkanContext &ctx, size_t frameCount, VkDescriptorSetLayout drawSetLayout)
+    {
+        destroy();
+
+        m_device = ctx.GetDevice();
+        m_physicalDevice = ctx.GetPhysicalDevice();
+        if (frameCount == 0)
+            frameCount = 1;
+
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(m_physicalDevice, &props);
+        m_maxGroupsX = std::max(1u, props.limits.maxComputeWorkGroupCount[0]);
+
+        // Missing SPIR-V is not an error: the caller keeps the CPU palettes.
+        VkShaderModule module = VK_NULL_HANDLE;
+        try
+        {
+            module = Pipeline::createShaderModuleFromFile(m_device, "shaders/smodel_pose.comp.spv");
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[GpuPoseEvaluator] GPU poses disabled: " << e.what() << "\n";
+            return false;
+        }
+
+        VkDescriptorSetLayoutBinding bindings[kBindingCount]{};
+        for (uint32_t b = 0; b < kBindingCount; ++b)
+        {
+            bindings[b].binding = b;
+            bindings[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[b].descriptorCount = 1;
+            bindings[b].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo dsl{};
+        dsl.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        dsl.bindingCount = kBindingCount;
+        dsl.pBindings = bindings;
+
+        VkPushConstantRange pcRange{};
+        pcRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pcRange.offset = 0;
+        pcRange.size = sizeof(PushConstants);
+
+        bool ok = vkCreateDescriptorSetLayout(m_device, &dsl, nullptr, &m_setLayout) == VK_SUCCESS;
+        if (ok)
+        {
+            VkPipelineLayoutCreateInfo pl{};
+            pl.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            pl.setLayoutCount = 1;
+            pl.pSetLayouts = &m_setLayout;
+            pl.pushConstantRangeCount = 1;
+            pl.pPushConstantRanges = &pcRange;
+            ok = vkCreatePipelineLayout(m_device, &pl, nullptr, &m_pipelineLayout) == VK_SUCCESS;
+        }
+        if (ok)
+        {
+            VkComputePipelineCreateInfo ci{};
+            ci.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            ci.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            ci.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+            ci.stage.module = module;
+            ci.stage.pName = "main";
+            ci.layout = m_pipelineLayout;
+            ok = vkCreateComputePipelines(m_device, PipelineCache::get(m_device), 1, &ci, nullptr, &m_pipeline) == VK_SUCCESS;
+            if (!ok)
+                m_pipeline = VK_NULL_HANDLE;
+        }
+        vkDestroyShaderModule(m_device, module, nullptr);
+
+        // Per frame: one compute set (6 SSBOs) + one draw set (camera UBO + 2 SSBOs).
+        if (ok)
+        {
+            const uint32_t frames = static_cast<uint32_t>(frameCount);
+            VkDescriptorPoolSize sizes[2]{};
+            sizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            sizes[0].descriptorCount = frames * (kBindingCount + 2u);
+            sizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            sizes[1].descriptorCount = frames;
+
+            VkDescriptorPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            poolInfo.maxSets = frames * 2u;
+            poolInfo.poolSizeCount = 2;
+            poolInfo.pPoolSizes = sizes;
+            ok = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_pool) == VK_SUCCESS;
+        }
+
+        if (ok)
+        {
+            m_frames.resize(frameCount);
+            for (Frame &f : m_frames)
+            {
+                VkDescriptorSetLayout layouts[2] = {m_setLayout, drawSetLayout};
+                VkDescriptorSet sets[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+
+                VkDescriptorSetAllocateInfo ai{};
+                ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+                ai.descriptorPool = m_pool;
+                ai.descriptorSetCount = 2;
+                ai.pSetLayouts = layouts;
+                if (vkAllocateDescriptorSets(m_device, &ai, sets) != VK_SUCCESS)
+                {
+                    ok = false;
+                    break;
+                }
+                f.computeSet = sets[0];
+                f.drawSet = sets[1];
+            }
+        }
+
+        if (!ok)
+        {
+            std::cerr << "[GpuPoseEvaluator] GPU poses disabled: failed to create compute resources\n";
+            destroy();
+            return false;
+        }
+        return true;
+    }
+
+    void GpuPoseEvaluator::destroy()
+    {
+        if (m_device == VK_NULL_HANDLE)
+            return;
+
+        for (Frame &f : m_frames)
+        {
+            destroyBuffer(f.states);
+            destroyBuffer(f.nodes);
+            destroyBuffer(f.joints);
+        }
+        m_frames.clear();
+
+        destroyBuffer(m_static.baked);
+        destroyBuffer(m_static.clips);
+        destroyBuffer(m_static.joints);
+        m_static = StaticData{};
+
+        for (Retired &r : m_retired)
+            destroyBuffer(r.buffer);
+        m_retired.clear();
+
+        if (m_pipeline != VK_NULL_HANDLE)
+            vkDestroyPipeline(m_device, m_pipeline, nullptr);
+        if (m_pipelineLayout != VK_NULL_HANDLE)
+            vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+        if (m_pool != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(m_device, m_pool, nullptr); // frees the sets
+        if (m_setLayout != VK_NULL_HANDLE)
+            vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+
+        m_pipeline = VK_NULL_HANDLE;
+        m_pipelineLayout = VK_NULL_HANDLE;
+        m_pool = VK_NULL_HANDLE;
+        m_setLayout = VK_NULL_HANDLE;
+        m_device = VK_NULL_HANDLE;
+        m_physicalDevice = VK_NULL_HANDLE;
+    }
+
+    void GpuPoseEvaluator::destroyBuffer(Buffer &b)
+    {
+        DestroyBuffer(m_device, b.buffer, b.allocation);
+        b = Buffer{};
+    }
+
+    bool GpuPoseEvaluator::createBuffer(Buffer &b, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible)
+    {
+        b = Buffer{};
+        const VkMemoryPropertyFlags props = hostVisible
+                                                ? (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+                                                : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        if (GpuAllocator::forDevice(m_device, m_physicalDevice)
+                .createBuffer(size, usage, props, GpuMemoryCategory::Compute, b.buffer, b.allocation) != VK_SUCCESS)
+            return false;
+        b.mapped = b.allocation.mapped;
+        b.size = size;
+        return true;
+    }
+
+    bool GpuPoseEvaluator::ensureBuffer(Buffer &b, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible)
+    {
+        if (size <= b.size && b.buffer != VK_NULL_HANDLE)
+            return true;
+
+        // Grow by doubling; the frame's fence has signalled, so the old buffer is idle.
+        VkDeviceSize newSize = (b.size > 0) ? b.size : 256;
+        while (newSize < size)
+            newSize *= 2;
+        destroyBuffer(b);
+        return createBuffer(b, newSize, usage, hostVisible);
+    }
+
+    void GpuPoseEvaluator::retire(Buffer &b)
+    {
+        if (b.buffer == VK_NULL_HANDLE)
+            return;
+        Retired r;
+        r.buffer = b;
+        r.framesLeft = static_cast<uint32_t>(m_frames.size()) + 1u;
+        m_retired.push_back(r);
+        b = Buffer{};
+    }
+
+    void GpuPoseEvaluator::tickRetired()
+    {
+        for (size_t i = 0; i < m_retired.size();)
+        {
+            if (--m_retired[i].framesLeft == 0)
+            {
+                destroyBuffer(m_retired[i].buffer);
+                m_retired[i] = m_retired.back();
+                m_retired.pop_back();
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    bool GpuPoseEvaluator::uploadStatic(VkCommandBuffer cmd, const ModelAsset &model)
+    {
+        // A different model (or a reload at the same address with other sizes) replaces the tables;
+        // the old ones may still be read by frames in flight.
+        const uint32_t nodeCount = static_cast<uint32_t>(model.nodes.size());
+        const uint32_t jointCount = std::max(1u, model.totalJointCount);
+        const uint32_t clipCount = static_cast<uint32_t>(model.animClips.size());
+        if (m_static.model == &model && m_static.nodeCount == nodeCount && m_static.jointCount == jointCount &&
+            m_static.clipCount == clipCount && m_static.baked.buffer != VK_NULL_HANDLE)
+            return true;
+
+        retire(m_static.baked);
+        retire(m_static.clips);
+        retire(m_static.joints);
+        m_static = StaticData{};
+
+        std::vector<ClipInfo> clips(clipCount);
+        size_t matrixCount = 0;
+        for (uint32_t c = 0; c < clipCount; ++c)
+        {
+            const ModelAsset::BakedClip &b = model.bakedClips[c];
+            clips[c].firstMatrix = static_cast<uint32_t>(matrixCount);
+            clips[c].frameCount = b.frameCount;
+            clips[c].sampleRate = b.sampleRate;
+            clips[c]._pad = 0;
+            matrixCount += b.globals.size();
+        }
+
+        std::vector<JointInfo> joints(jointCount);
+        for (JointInfo &j : joints)
+        {
+            j.inverseBind = glm::mat4(1.0f);
+            j.node = ~0u;
+            j._pad[0] = j._pad[1] = j._pad[2] = 0;
+        }
+        for (const auto &skin : model.skins)
+        {
+            for (uint32_t j = 0; j < skin.jointCount; ++j)
+            {
+                const uint32_t slot = skin.jointBase + j;
+                if (slot >= jointCount || j >= skin.jointNodeIndices.size() || j >= skin.inverseBind.size())
+                    continue;
+                joints[slot].node = skin.jointNodeIndices[j];
+                joints[slot].inverseBind = skin.inverseBind[j];
+            }
+        }
+
+        const VkDeviceSize bakedBytes = sizeof(glm::mat4) * matrixCount;
+        const VkDeviceSize clipBytes = sizeof(ClipInfo) * clips.size();
+        const VkDeviceSize jointBytes = sizeof(JointInfo) * joints.size();
+        const VkDeviceSize clipOffset = alignUp(bakedBytes, kStagingAlign);
+        const VkDeviceSize jointOffset = clipOffset + alignUp(clipBytes, kStagingAlign);
+
+        Buffer staging;
+        if (!createBuffer(staging, jointOffset + jointBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, true))
+            return false;
+
+        uint8_t *dst = static_cast<uint8_t *>(staging.mapped);
+        size_t written = 0;
+        for (const ModelAsset::BakedClip &b : model.bakedClips)
+        {
+            std::memcpy(dst + written, b.globals.data(), sizeof(glm::mat4) * b.globals.size());
+            written += sizeof(glm::mat4) * b.globals.size();
+        }
+        std::memcpy(dst + clipOffset, clips.data(), clipBytes);
+        std::memcpy(dst + jointOffset, joints.data(), jointBytes);
+
+        const VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        if (!createBuffer(m_static.baked, bakedBytes, usage, false) ||
+            !createBuffer(m_static.clips, clipBytes, usage, false) ||
+            !createBuffer(m_static.joints, jointBytes, usage, false))
+        {
+            destroyBuffer(staging);
+            destroyBuffer(m_static.baked);
+            destroyBuffer(m_static.clips);
+            destroyBuffer(m_static.joints);
+            return false;
+        }
+
+        VkBufferCopy regions[3]{};
+        regions[0] = {0, 0, bakedBytes};
+        regions[1] = {clipOffset, 0, clipBytes};
+        regions[2] = {jointOffset, 0, jointBytes};
+        vkCmdCopyBuffer(cmd, staging.buffer, m_static.baked.buffer, 1, &regions[0]);
+        vkCmdCopyBuffer(cmd, staging.buffer, m_static.clips.buffer, 1, &regions[1]);
+        vkCmdCopyBuffer(cmd, staging.buffer, m_static.joints.buffer, 1, &regions[2]);
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        // The copy executes with this frame; free the staging buffer once it has retired.
+        retire(staging);
+
+        m_static.model = &model;
+        m_static.nodeCount = nodeCount;
+        m_static.jointCount = jointCount;
+        m_static.clipCount = clipCount;
+        return true;
+    }
+
+    bool GpuPoseEvaluator::record(VkCommandBuffer cmd, uint32_t frameIndex, const ModelAsset &model,
+                                  const GpuInstanceAnimation *states, uint32_t instanceCount,
+                                  VkBuffer cameraUbo, VkDeviceSize cameraUboSize, bool asyncQueue)
+    {
+        tickRetired();
+
+        if (!ready() || m_frames.empty() || !states || instanceCount == 0 || cameraUbo == VK_NULL_HANDLE)
+            return false;
+        if (!supports(model))
+            return false;
+        if (!uploadStatic(cmd, model))
+            return false;
+
+        Frame &f = m_frames[frameIndex % m_frames.size()];
+        const uint32_t nodeCount = m_static.nodeCount;
+        const uint32_t jointCount = m_static.jointCount;
+
+        const bool ok =
+            ensureBuffer(f.states, sizeof(GpuInstanceAnimation) * instanceCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true) &&
+            ensureBuffer(f.nodes, sizeof(glm::mat4) * instanceCount * nodeCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false) &&
+            ensureBuffer(f.joints, sizeof(glm::mat4) * instanceCount * jointCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false);
+        if (!ok)
+            return false;
+
+        // Host writes before vkQueueSubmit are visible to the GPU without a barrier.
+        std::memcpy(f.states.mapped, states, sizeof(GpuInstanceAnimation) * instanceCount);
+
+        const VkBuffer computeBuffers[kBindingCount] = {m_static.baked.buffer, m_static.clips.buffer, m_static.joints.buffer,
+                                                        f.states.buffer, f.nodes.buffer, f.joints.buffer};
+        VkDescriptorBufferInfo infos[kBindingCount + 3]{};
+        VkWriteDescriptorSet writes[kBindingCount + 3]{};
+        for (uint32_t b = 0; b < kBindingCount; ++b)
+        {
+            infos[b] = {computeBuffers[b], 0, VK_WHOLE_SIZE};
+            writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[b].dstSet = f.computeSet;
+            writes[b].dstBinding = b;
+            writes[b].descriptorCount = 1;
+            writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[b].pBufferInfo = &infos[b];
+        }
+
+        infos[kBindingCount + 0] = {cameraUbo, 0, cameraUboSize};
+        infos[kBindingCount + 1] = {f.nodes.buffer, 0, VK_WHOLE_SIZE};
+        infos[kBindingCount + 2] = {f.joints.buffer, 0, VK_WHOLE_SIZE};
+        for (uint32_t b = 0; b < 3; ++b)
+        {
+            VkWriteDescriptorSet &w = writes[kBindingCount + b];
+            w.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            w.dstSet = f.drawSet;
+            w.dstBinding = b;
+            w.descriptorCount = 1;
+            w.descriptorType = (b == 0) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            w.pBufferInfo = &infos[kBindingCount + b];
+        }
+        vkUpdateDescriptorSets(m_device, kBindingCount + 3, writes, 0, nullptr);
+
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &f.computeSet, 0, nullptr);
+
+        // One invocation per palette matrix; split so no dispatch exceeds maxComputeWorkGroupCount[0].
+        const uint64_t items = static_cast<uint64_t>(instanceCount) * (nodeCount + jointCount);
+        const uint64_t itemsPerDispatch = static_cast<uint64_t>(m_maxGroupsX) * kGroupSize;
+        PushConstants pc{};
+        pc.counts = glm::uvec4(instanceCount, nodeCount, jointCount, m_static.clipCount);
+        for (uint64_t first = 0; first < items; first += itemsPerDispatch)
+        {
+            const uint64_t count = std::min(itemsPerDispatch, items - first);
+            pc.base = glm::uvec4(static_cast<uint32_t>(first), 0u, 0u, 0u);
+            vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pc);
+            vkCmdDispatch(cmd, static_cast<uint32_t>((count + kGroupSize - 1) / kGroupSize), 1, 1);
+        }
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        const VkPipelineStageFlags readers = asyncQueue ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+                                                        : (VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, readers,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+        return true;
+    }
+}
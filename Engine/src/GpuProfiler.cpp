@@ -0,0 +1,242 @@
+#include "Engine/GpuProfiler.h"
+#include "Engine/FrameArena.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace Engine
+{
+    namespace
+    {
+        constexpr uint32_t kStatCount = 5; // PipelineStats fields
+        constexpr VkQueryPipelineStatisticFlags kStatFlags =
+            VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+        constexpr float kAverageFactor = 0.1f;
+    } // namespace
+
+    bool GpuProfiler::init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t framesInFlight, bool pipelineStatistics)
+    {
+        destroy();
+
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(physicalDevice, &props);
+        if (props.limits.timestampComputeAndGraphics == VK_FALSE || framesInFlight == 0)
+            return false;
+
+        m_device = device;
+        m_timestampPeriod = props.limits.timestampPeriod;
+        m_slotCount = framesInFlight;
+        m_slots = std::make_unique<Slot[]>(framesInFlight);
+
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = framesInFlight * kMaxTimers * 2;
+        if (vkCreateQueryPool(device, &poolInfo, nullptr, &m_timestampPool) != VK_SUCCESS)
+        {
+            m_timestampPool = VK_NULL_HANDLE;
+            destroy();
+            return false;
+        }
+
+        if (pipelineStatistics)
+        {
+            VkQueryPoolCreateInfo statsInfo{};
+            statsInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            statsInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            statsInfo.queryCount = framesInFlight * kMaxTimers;
+            statsInfo.pipelineStatistics = kStatFlags;
+            if (vkCreateQueryPool(device, &statsInfo, nullptr, &m_statsPool) != VK_SUCCESS)
+            {
+                std::cerr << "GpuProfiler: pipeline statistics pool creation failed, timing only\n";
+                m_statsPool = VK_NULL_HANDLE;
+            }
+        }
+        return true;
+    }
+
+    void GpuProfiler::destroy()
+    {
+        if (m_timestampPool != VK_NULL_HANDLE)
+            vkDestroyQueryPool(m_device, m_timestampPool, nullptr);
+        if (m_statsPool != VK_NULL_HANDLE)
+            vkDestroyQueryPool(m_device, m_statsPool, nullptr);
+        m_timestampPool = VK_NULL_HANDLE;
+        m_statsPool = VK_NULL_HANDLE;
+        m_slots.reset();
+        m_slotCount = 0;
+        m_currentSlot = 0;
+
+        std::lock_guard<std::mutex> lock(m_resultsMutex);
+        m_results.clear();
+    }
+
+    void GpuProfiler::beginFrame(VkCommandBuffer cmd, uint32_t slot)
+    {
+        if (!enabled())
+            return;
+
+        m_currentSlot = slot % m_slotCount;
+        resolve(m_currentSlot);
+
+        Slot &s = m_slots[m_currentSlot];
+        s.used.store(0, std::memory_order_relaxed);
+        vkCmdResetQueryPool(cmd, m_timestampPool, m_currentSlot * kMaxTimers * 2, kMaxTimers * 2);
+        if (m_statsPool != VK_NULL_HANDLE)
+            vkCmdResetQueryPool(cmd, m_statsPool, m_currentSlot * kMaxTimers, kMaxTimers);
+    }
+
+    uint32_t GpuProfiler::beginTimer(VkCommandBuffer cmd, const char *name, bool withStats)
+    {
+        if (!enabled() || !name)
+            return kInvalidTimer;
+
+        Slot &s = m_slots[m_currentSlot];
+        const uint32_t timer = s.used.fetch_add(1, std::memory_order_relaxed);
+        if (timer >= kMaxTimers)
+            return kInvalidTimer;
+
+        s.names[timer] = name;
+        s.withStats[timer] = withStats && m_statsPool != VK_NULL_HANDLE;
+
+        const uint32_t query = (m_currentSlot * kMaxTimers + timer) * 2;
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestampPool, query);
+        if (s.withStats[timer])
+            vkCmdBeginQuery(cmd, m_statsPool, m_currentSlot * kMaxTimers + timer, 0);
+        return timer;
+    }
+
+    void GpuProfiler::endTimer(VkCommandBuffer cmd, uint32_t timer)
+    {
+        if (timer >= kMaxTimers || !enabled())
+            return;
+
+        const Slot &s = m_slots[m_currentSlot];
+        if (s.withStats[timer])
+            vkCmdEndQuery(cmd, m_statsPool, m_currentSlot * kMaxTimers + timer);
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestampPool, (m_currentSlot * kMaxTimers + timer) * 2 + 1);
+    }
+
+    void GpuProfiler::resolve(uint32_t slot)
+    {
+        // Still holds the timers of the frame this slot last recorded.
+        const Slot &s = m_slots[slot];
+        const uint32_t count = std::min(s.used.load(std::memory_order_relaxed), kMaxTimers);
+        if (count == 0)
+            return;
+
+        // (value, availability) pairs: a timer whose end was never written is skipped, not waited on.
+        m_scratch.assign(static_cast<size_t>(count) * 2 * 2, 0);
+        const VkResult tsResult = vkGetQueryPoolResults(m_device, m_timestampPool, slot * kMaxTimers * 2, count * 2,
+                                                        m_scratch.size() * sizeof(uint64_t), m_scratch.data(),
+                                                        2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (tsResult != VK_SUCCESS && tsResult != VK_NOT_READY)
+            return;
+
+        struct Sample
+        {
+            const char *name;
+            uint64_t start;
+            float ms;
+            bool hasStats;
+            PipelineStats stats;
+        };
+        FrameArena::Scope scratch;
+        FrameVector<Sample> samples{ArenaAllocator<Sample>(scratch.arena())};
+        samples.reserve(count);
+
+        for (uint32_t t = 0; t < count; ++t)
+        {
+            const uint64_t *begin = &m_scratch[t * 4];
+            const uint64_t *end = &m_scratch[t * 4 + 2];
+            if (!s.names[t] || begin[1] == 0 || end[1] == 0 || end[0] < begin[0])
+                continue;
+
+            Sample sample{};
+            sample.name = s.names[t];
+            sample.start = begin[0];
+            sample.ms = static_cast<float>(static_cast<double>(end[0] - begin[0]) * m_timestampPeriod * 1e-6);
+
+            if (s.withStats[t])
+            {
+                uint64_t values[kStatCount + 1] = {};
+                if (vkGetQueryPoolResults(m_device, m_statsPool, slot * kMaxTimers + t, 1, sizeof(values), values,
+                                          sizeof(values), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT) == VK_SUCCESS &&
+                    values[kStatCount] != 0)
+                {
+                    sample.hasStats = true;
+                    sample.stats.inputAssemblyPrimitives = values[0];
+                    sample.stats.vertexShaderInvocations = values[1];
+                    sample.stats.clippingPrimitives = values[2];
+                    sample.stats.fragmentShaderInvocations = values[3];
+                    sample.stats.computeShaderInvocations = values[4];
+                }
+            }
+            samples.push_back(sample);
+        }
+
+        std::stable_sort(samples.begin(), samples.end(), [](const Sample &a, const Sample &b)
+                         { return a.start < b.start; });
+
+        std::lock_guard<std::mutex> lock(m_resultsMutex);
+        std::vector<TimerResult> previous;
+        previous.swap(m_results);
+
+        const uint64_t frameStart = samples.empty() ? 0 : samples.front().start;
+        for (const Sample &sample : samples)
+        {
+            auto it = std::find_if(m_results.begin(), m_results.end(), [&](const TimerResult &r)
+                                   { return r.name == sample.name; });
+            if (it == m_results.end())
+            {
+                TimerResult r;
+                r.name = sample.name;
+                r.startMs = static_cast<float>(static_cast<double>(sample.start - frameStart) * m_timestampPeriod * 1e-6);
+                m_results.push_back(std::move(r));
+                it = m_results.end() - 1;
+            }
+
+            it->count++;
+            it->ms += sample.ms;
+            if (sample.hasStats)
+            {
+                it->hasStats = true;
+                it->stats.inputAssemblyPrimitives += sample.stats.inputAssemblyPrimitives;
+                it->stats.vertexShaderInvocations += sample.stats.vertexShaderInvocations;
+                it->stats.clippingPrimitives += sample.stats.clippingPrimitives;
+                it->stats.fragmentShaderInvocations += sample.stats.fragmentShaderInvocations;
+                it->stats.computeShaderInvocations += sample.stats.computeShaderInvocations;
+            }
+        }
+
+        for (TimerResult &r : m_results)
+        {
+            auto prev = std::find_if(previous.begin(), previous.end(), [&](const TimerResult &p)
+                                     { return p.name == r.name; });
+            r.avgMs = (prev == previous.end()) ? r.ms : kAverageFactor * r.ms + (1.0f - kAverageFactor) * prev->avgMs;
+        }
+        m_resolvedFrames.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::vector<GpuProfiler::TimerResult> GpuProfiler::results() const
+    {
+        std::lock_guard<std::mutex> lock(m_resultsMutex);
+        return m_results;
+    }
+
+    float GpuProfiler::lastMs(const char *name) const
+    {
+        std::lock_guard<std::mutex> lock(m_resultsMutex);
+        for (const TimerResult &r : m_results)
+        {
+            if (r.name == name)
+                return r.ms;
+        }
+        return 0.0f;
+    }
+
+} // namespace Engine
@@ -0,0 +1,1316 @@
+#include "Engine/GpuSceneRenderPassModule.h"
+#include "Engine/VulkanContext.h"
+#include "Engine/SwapChain.h"
+#include "Engine/PipelineCache.h"
+#include "Engine/GpuPoseEvaluator.h"
+#include "Engine/ViewData.h"
+#include "assets/ModelAsset.h"
+#include "assets/MeshAsset.h"
+#include "assets/MaterialAsset.h"
+#include "assets/model/SModelMeshRecord.h"
+#include "utils/BufferUtils.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace Engine
+{
+    namespace
+    {
+        constexpr uint32_t kGroupSize = 64; // local_size_x of gpu_scene_cull.comp / gpu_scene_scatter.comp
+        constexpr uint32_t kBindingCount = 11;
+        constexpr uint32_t kLodLevels = ModelPrimitive::kMaxLods + 1;
+        constexpr VkDeviceSize kStagingAlign = 256;
+        constexpr VkDeviceSize kCommandStride = sizeof(VkDrawIndexedIndirectCommand);
+        constexpr VkDeviceSize kCountersHeader = 16; // visible count + scatter dispatch, then group counts
+        constexpr VkDeviceSize kVisibleRecordSize = 32;
+        constexpr VkDeviceSize kDrawStateSize = 16;
+        constexpr VkDeviceSize kDrawInstanceSize = 8;
+        constexpr uint32_t kFeedbackSlice = 16384; // instance slots measured per frame for mip streaming
+
+        // Set 0 bindings (gpu_scene_*.comp, gpu_scene.vert)
+        enum Binding : uint32_t
+        {
+            ViewBinding = 0,
+            InstanceBinding,
+            ModelBinding,
+            DrawBinding,
+            ClipBinding,
+            BakedBinding,
+            VisibleBinding,
+            DrawStateBinding,
+            DrawInstanceBinding,
+            CounterBinding,
+            CommandBinding
+        };
+
+        VkDeviceSize alignUp(VkDeviceSize v, VkDeviceSize a)
+        {
+            return (v + a - 1) / a * a;
+        }
+
+        uint32_t floatBits(float f)
+        {
+            uint32_t u = 0;
+            std::memcpy(&u, &f, sizeof(u));
+            return u;
+        }
+
+        float maxAxisScale(const glm::mat4 &m)
+        {
+            return std::max(glm::length(glm::vec3(m[0])), std::max(glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2]))));
+        }
+
+        // SModelRenderPassModule's model matrix for cooked bounds: centered in XZ, base at y = 0, fit scale.
+        glm::mat4 fitMatrix(const ModelAsset &model)
+        {
+            glm::mat4 m(1.0f);
+            if (!model.hasBounds)
+                return m;
+            const float s = model.fitScale;
+            m[0][0] = s;
+            m[1][1] = s;
+            m[2][2] = s;
+            m[3] = glm::vec4(-model.center[0] * s, -model.boundsMin[1] * s, -model.center[2] * s, 1.0f);
+            return m;
+        }
+
+        // Same padding as SModelRenderPassModule's culling sphere (bind-pose bounds, animated nodes).
+        glm::vec4 boundingSphere(const ModelAsset &model, const glm::mat4 &base)
+        {
+            if (!model.hasBounds)
+                return glm::vec4(0.0f);
+            const glm::vec3 bmin(model.boundsMin[0], model.boundsMin[1], model.boundsMin[2]);
+            const glm::vec3 bmax(model.boundsMax[0], model.boundsMax[1], model.boundsMax[2]);
+            const glm::vec3 center = glm::vec3(base * glm::vec4((bmin + bmax) * 0.5f, 1.0f));
+            return glm::vec4(center, glm::length(bmax - bmin) * 0.5f * maxAxisScale(base) * 1.5f);
+        }
+
+        VkPipeline createComputePipeline(VkDevice device, VkPipelineLayout layout, const char *path)
+        {
+            VkShaderModule module = Pipeline::createShaderModuleFromFile(device, path);
+
+            VkComputePipelineCreateInfo ci{};
+            ci.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            ci.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            ci.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+            ci.stage.module = module;
+            ci.stage.pName = "main";
+            ci.layout = layout;
+
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            if (vkCreateComputePipelines(device, PipelineCache::get(device), 1, &ci, nullptr, &pipeline) != VK_SUCCESS)
+                pipeline = VK_NULL_HANDLE;
+            vkDestroyShaderModule(device, module, nullptr);
+            return pipeline;
+        }
+    }
+
+    uint32_t GpuSceneRenderPassModule::addModel(ModelHandle model)
+    {
+        const auto it = m_modelIndex.find(model.id);
+        if (it != m_modelIndex.end() && m_models[it->second].generation == model.generation)
+            return it->second;
+        if (m_models.size() >= kFreeModel)
+            return kInvalidId;
+
+        const uint32_t index = static_cast<uint32_t>(m_models.size());
+        m_models.push_back(model);
+        m_modelInstances.push_back(0);
+        m_modelIndex[model.id] = index;
+        return index;
+    }
+
+    GpuSceneRenderPassModule::GpuInstance GpuSceneRenderPassModule::pack(const Instance &instance)
+    {
+        GpuInstance g;
+        g.posScale = glm::vec4(instance.position, instance.scale);
+        g.yawSin = floatBits(std::sin(instance.yaw));
+        g.yawCos = floatBits(std::cos(instance.yaw));
+        g.modelClip = instance.model | (std::min(instance.clip, 0xFFFFu) << 16);
+        g.timeSec = floatBits(instance.timeSec);
+        return g;
+    }
+
+    uint32_t GpuSceneRenderPassModule::addInstance(const Instance &instance)
+    {
+        if (instance.model >= m_models.size())
+            return kInvalidId;
+
+        uint32_t id;
+        if (!m_freeIds.empty())
+        {
+            id = m_freeIds.back();
+            m_freeIds.pop_back();
+        }
+        else
+        {
+            id = static_cast<uint32_t>(m_instances.size());
+            m_instances.emplace_back();
+        }
+
+        m_instances[id] = pack(instance);
+        ++m_modelInstances[instance.model];
+        ++m_liveCount;
+        markDirty(id);
+        return id;
+    }
+
+    void GpuSceneRenderPassModule::updateInstance(uint32_t id, const Instance &instance)
+    {
+        if (id >= m_instances.size() || instance.model >= m_models.size())
+            return;
+        GpuInstance &cur = m_instances[id];
+        const uint32_t oldModel = cur.modelClip & 0xFFFFu;
+        if (oldModel == kFreeModel)
+            return;
+
+        const GpuInstance g = pack(instance);
+        if (std::memcmp(&cur, &g, sizeof(GpuInstance)) == 0)
+            return;
+
+        --m_modelInstances[oldModel];
+        ++m_modelInstances[instance.model];
+        cur = g;
+        markDirty(id);
+    }
+
+    void GpuSceneRenderPassModule::removeInstance(uint32_t id)
+    {
+        if (id >= m_instances.size())
+            return;
+        GpuInstance &cur = m_instances[id];
+        const uint32_t model = cur.modelClip & 0xFFFFu;
+        if (model == kFreeModel)
+            return;
+
+        --m_modelInstances[model];
+        --m_liveCount;
+        cur = GpuInstance{};
+        m_freeIds.push_back(id);
+        markDirty(id);
+    }
+
+    void GpuSceneRenderPassModule::markDirty(uint32_t slot)
+    {
+        if (slot >= m_dirtyFlag.size())
+            m_dirtyFlag.resize(m_instances.size(), 0);
+        if (m_dirtyFlag[slot])
+            return;
+        m_dirtyFlag[slot] = 1;
+        m_dirty.push_back(slot);
+    }
+
+    void GpuSceneRenderPassModule::onFrameSnapshot()
+    {
+        RecordState &r = m_record;
+        r.models = m_models;
+        r.modelInstances = m_modelInstances;
+        r.lodPixelError = m_lodPixelError;
+        r.occlusionCulling = m_occlusionCulling;
+
+        // Dirty slots accumulate until a recordPrePass() uploads them.
+        if (r.instances.size() < m_instances.size())
+        {
+            r.instances.resize(m_instances.size());
+            r.dirtyFlag.resize(m_instances.size(), 0);
+        }
+        for (uint32_t slot : m_dirty)
+        {
+            m_dirtyFlag[slot] = 0;
+            r.instances[slot] = m_instances[slot];
+            if (!r.dirtyFlag[slot])
+            {
+                r.dirtyFlag[slot] = 1;
+                r.dirty.push_back(slot);
+            }
+        }
+        m_dirty.clear();
+    }
+
+    void GpuSceneRenderPassModule::onCreate(VulkanContext &ctx, VkRenderPass pass, const std::vector<VkFramebuffer> &fbs)
+    {
+        m_device = ctx.GetDevice();
+        m_physicalDevice = ctx.GetPhysicalDevice();
+        m_extent = ctx.GetSwapChain() ? ctx.GetSwapChain()->GetExtent() : VkExtent2D{};
+        m_ready = false;
+
+        if (!ctx.SupportsDrawIndirectFirstInstance())
+        {
+            std::cerr << "[GpuScene] GPU-driven rendering disabled: drawIndirectFirstInstance not supported\n";
+            return;
+        }
+
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(m_physicalDevice, &props);
+        m_maxGroupsX = std::max(1u, props.limits.maxComputeWorkGroupCount[0]);
+
+        m_multiDraw = ctx.SupportsMultiDrawIndirect();
+        m_drawIndexedIndirectCount = nullptr;
+        if (m_multiDraw && ctx.SupportsDrawIndirectCount())
+            m_drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+                vkGetDeviceProcAddr(m_device, "vkCmdDrawIndexedIndirectCountKHR"));
+
+        const size_t frameCount = fbs.empty() ? 1u : fbs.size();
+        m_shared = SModelRenderer::acquire(ctx, pass, static_cast<uint32_t>(frameCount), true);
+
+        // Missing SPIR-V is not an error: the caller keeps its per-model modules.
+        try
+        {
+            m_ready = createDescriptors(frameCount) && createPipelines(ctx, pass);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[GpuScene] GPU-driven rendering disabled: " << e.what() << "\n";
+            m_ready = false;
+        }
+
+        if (!m_ready)
+        {
+            destroyPipelines();
+            m_shared.reset();
+        }
+    }
+
+    bool GpuSceneRenderPassModule::createDescriptors(size_t frameCount)
+    {
+        VkDescriptorSetLayoutBinding bindings[kBindingCount]{};
+        for (uint32_t b = 0; b < kBindingCount; ++b)
+        {
+            bindings[b].binding = b;
+            bindings[b].descriptorType = (b == ViewBinding) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+                                                            : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[b].descriptorCount = 1;
+            bindings[b].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo dsl{};
+        dsl.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        dsl.bindingCount = kBindingCount;
+        dsl.pBindings = bindings;
+        if (vkCreateDescriptorSetLayout(m_device, &dsl, nullptr, &m_setLayout) != VK_SUCCESS)
+            return false;
+
+        VkDescriptorSetLayoutBinding hiZBinding{};
+        hiZBinding.binding = 0;
+        hiZBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        hiZBinding.descriptorCount = 1;
+        hiZBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        dsl.bindingCount = 1;
+        dsl.pBindings = &hiZBinding;
+        if (vkCreateDescriptorSetLayout(m_device, &dsl, nullptr, &m_hiZSetLayout) != VK_SUCCESS)
+            return false;
+
+        // Per frame: the scene set (dynamic view UBO + 10 SSBOs) and the Hi-Z set.
+        const uint32_t frames = static_cast<uint32_t>(frameCount);
+        VkDescriptorPoolSize sizes[3]{};
+        sizes[0] = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, frames};
+        sizes[1] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frames * (kBindingCount - 1u)};
+        sizes[2] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frames};
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = frames * 2u;
+        poolInfo.poolSizeCount = 3;
+        poolInfo.pPoolSizes = sizes;
+        if (vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_pool) != VK_SUCCESS)
+            return false;
+
+        m_frames.resize(frameCount);
+        for (Frame &f : m_frames)
+        {
+            VkDescriptorSetLayout layouts[2] = {m_setLayout, m_hiZSetLayout};
+            VkDescriptorSet sets[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+
+            VkDescriptorSetAllocateInfo ai{};
+            ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            ai.descriptorPool = m_pool;
+            ai.descriptorSetCount = 2;
+            ai.pSetLayouts = layouts;
+            if (vkAllocateDescriptorSets(m_device, &ai, sets) != VK_SUCCESS)
+                return false;
+            f.set = sets[0];
+            f.hiZSet = sets[1];
+        }
+        return true;
+    }
+
+    bool GpuSceneRenderPassModule::createPipelines(VulkanContext &ctx, VkRenderPass pass)
+    {
+        (void)ctx;
+
+        // Compute: set 0 + Hi-Z set (occlusion variant only), one push range shared by the three passes.
+        VkPushConstantRange computeRange{};
+        computeRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        computeRange.offset = 0;
+        computeRange.size = sizeof(CullPushConstants);
+
+        VkDescriptorSetLayout computeSets[2] = {m_setLayout, m_hiZSetLayout};
+        VkPipelineLayoutCreateInfo pl{};
+        pl.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pl.setLayoutCount = 2;
+        pl.pSetLayouts = computeSets;
+        pl.pushConstantRangeCount = 1;
+        pl.pPushConstantRanges = &computeRange;
+        if (vkCreatePipelineLayout(m_device, &pl, nullptr, &m_computeLayout) != VK_SUCCESS)
+            return false;
+
+        m_cullPipeline = createComputePipeline(m_device, m_computeLayout, "shaders/gpu_scene_cull.comp.spv");
+        m_argsPipeline = createComputePipeline(m_device, m_computeLayout, "shaders/gpu_scene_args.comp.spv");
+        m_scatterPipeline = createComputePipeline(m_device, m_computeLayout, "shaders/gpu_scene_scatter.comp.spv");
+        if (m_cullPipeline == VK_NULL_HANDLE || m_argsPipeline == VK_NULL_HANDLE || m_scatterPipeline == VK_NULL_HANDLE)
+            return false;
+
+        // Optional: without it the scene is only frustum-culled.
+        try
+        {
+            m_occlusionPipeline = createComputePipeline(m_device, m_computeLayout, "shaders/gpu_scene_cull_occlusion.comp.spv");
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[GpuScene] occlusion culling disabled: " << e.what() << "\n";
+        }
+
+        // Draw: set 0 + SModelRenderer's material set, SModelRenderer::PushConstants for the fragment shader.
+        VkPushConstantRange drawRange{};
+        drawRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        drawRange.offset = 0;
+        drawRange.size = sizeof(SModelRenderer::PushConstants);
+
+        VkDescriptorSetLayout drawSets[2] = {m_setLayout, m_shared->materialSetLayout()};
+        pl.pSetLayouts = drawSets;
+        pl.pPushConstantRanges = &drawRange;
+        if (vkCreatePipelineLayout(m_device, &pl, nullptr, &m_drawLayout) != VK_SUCCESS)
+            return false;
+
+        VkShaderModule vert = Pipeline::createShaderModuleFromFile(m_device, "shaders/gpu_scene.vert.spv");
+        VkShaderModule frag = VK_NULL_HANDLE;
+        try
+        {
+            frag = Pipeline::createShaderModuleFromFile(m_device, m_shared->bindless() ? "shaders/smodel_bindless.frag.spv"
+                                                                                       : "shaders/smodel.frag.spv");
+        }
+        catch (...)
+        {
+            vkDestroyShaderModule(m_device, vert, nullptr);
+            throw;
+        }
+
+        // Mesh vertices only (binding 0, smodel.vert layout); instances come from storage buffers.
+        std::array<VkVertexInputAttributeDescription, 6> attrs{};
+        VkVertexInputBindingDescription binding{};
+        binding.binding = 0;
+        binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        VkPipelineVertexInputStateCreateInfo vi{};
+        vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vi.vertexBindingDescriptionCount = 1;
+        vi.pVertexBindingDescriptions = &binding;
+        vi.vertexAttributeDescriptionCount = static_cast<uint32_t>(attrs.size());
+        vi.pVertexAttributeDescriptions = attrs.data();
+
+        VkPipelineInputAssemblyStateCreateInfo ia{};
+        ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+        VkPipelineRasterizationStateCreateInfo rs{};
+        rs.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rs.polygonMode = VK_POLYGON_MODE_FILL;
+        rs.lineWidth = 1.0f;
+        rs.cullMode = VK_CULL_MODE_NONE;
+        rs.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+        // LESS_OR_EQUAL like SModelRenderer: the main pass may start from the depth pre-pass.
+        VkPipelineDepthStencilStateCreateInfo ds{};
+        ds.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        ds.depthTestEnable = VK_TRUE;
+        ds.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+        VkPipelineColorBlendAttachmentState attachment{};
+        attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                    VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        attachment.colorBlendOp = VK_BLEND_OP_ADD;
+        attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+        VkPipelineColorBlendStateCreateInfo cb{};
+        cb.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        cb.attachmentCount = 1;
+        cb.pAttachments = &attachment;
+
+        // constant_id 0: kQuantizedVertices (vertex), kAlphaMode (fragment)
+        const VkSpecializationMapEntry specEntry{0, 0, sizeof(VkBool32)};
+        const VkSpecializationMapEntry alphaSpecEntry{0, 0, sizeof(int32_t)};
+        bool ok = true;
+        for (uint32_t quantized = 0; quantized < 2 && ok; ++quantized)
+        {
+            binding.stride = quantized ? static_cast<uint32_t>(sizeof(smodel::SModelVertexQuantized)) : 72u;
+            if (quantized)
+            {
+                attrs[0] = {0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(smodel::SModelVertexQuantized, pos)};
+                attrs[1] = {1, 0, VK_FORMAT_R16G16_SNORM, offsetof(smodel::SModelVertexQuantized, normal)};
+                attrs[2] = {2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(smodel::SModelVertexQuantized, uv0)};
+                attrs[3] = {3, 0, VK_FORMAT_R8G8B8A8_SNORM, offsetof(smodel::SModelVertexQuantized, tangent)};
+                attrs[4] = {8, 0, VK_FORMAT_R8G8B8A8_UINT, offsetof(smodel::SModelVertexQuantized, joints)};
+                attrs[5] = {9, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(smodel::SModelVertexQuantized, weights)};
+            }
+            else
+            {
+                attrs[0] = {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0};
+                attrs[1] = {1, 0, VK_FORMAT_R32G32B32_SFLOAT, 12};
+                attrs[2] = {2, 0, VK_FORMAT_R32G32_SFLOAT, 24};
+                attrs[3] = {3, 0, VK_FORMAT_R32G32B32A32_SFLOAT, 32};
+                attrs[4] = {8, 0, VK_FORMAT_R16G16B16A16_UINT, 48};
+                attrs[5] = {9, 0, VK_FORMAT_R32G32B32A32_SFLOAT, 56};
+            }
+
+            const VkBool32 quantizedSpec = quantized ? VK_TRUE : VK_FALSE;
+            VkSpecializationInfo spec{};
+            spec.mapEntryCount = 1;
+            spec.pMapEntries = &specEntry;
+            spec.dataSize = sizeof(quantizedSpec);
+            spec.pData = &quantizedSpec;
+
+            VkPipelineShaderStageCreateInfo vs{};
+            vs.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            vs.stage = VK_SHADER_STAGE_VERTEX_BIT;
+            vs.module = vert;
+            vs.pName = "main";
+            vs.pSpecializationInfo = &spec;
+
+            VkPipelineShaderStageCreateInfo fs{};
+            fs.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            fs.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+            fs.module = frag;
+            fs.pName = "main";
+
+            // OPAQUE / MASK / BLEND as in SModelRenderer
+            for (uint32_t alphaMode = 0; alphaMode < 3 && ok; ++alphaMode)
+            {
+                const int32_t alphaSpecValue = static_cast<int32_t>(alphaMode);
+                VkSpecializationInfo alphaSpec{};
+                alphaSpec.mapEntryCount = 1;
+                alphaSpec.pMapEntries = &alphaSpecEntry;
+                alphaSpec.dataSize = sizeof(alphaSpecValue);
+                alphaSpec.pData = &alphaSpecValue;
+                fs.pSpecializationInfo = &alphaSpec;
+
+                PipelineCreateInfo pci{};
+                pci.device = m_device;
+                pci.renderPass = pass;
+                pci.subpass = 0;
+                pci.pipelineLayout = m_drawLayout;
+                pci.shaderStages = {vs, fs};
+                pci.vertexInput = vi;
+                pci.vertexInputProvided = true;
+                pci.inputAssembly = ia;
+                pci.inputAssemblyProvided = true;
+                pci.rasterization = rs;
+                pci.rasterizationProvided = true;
+                pci.dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+                attachment.blendEnable = (alphaMode == 2) ? VK_TRUE : VK_FALSE;
+                ds.depthWriteEnable = (alphaMode == 2) ? VK_FALSE : VK_TRUE;
+                pci.depthStencil = ds;
+                pci.depthStencilProvided = true;
+                pci.colorBlend = cb;
+                pci.colorBlendProvided = true;
+
+                ok = m_pipelines[quantized][alphaMode].create(pci) == VK_SUCCESS;
+            }
+        }
+
+        vkDestroyShaderModule(m_device, vert, nullptr);
+        vkDestroyShaderModule(m_device, frag, nullptr);
+        return ok;
+    }
+
+    void GpuSceneRenderPassModule::destroyPipelines()
+    {
+        if (m_device == VK_NULL_HANDLE)
+            return;
+
+        for (auto &byAlpha : m_pipelines)
+        {
+            for (Pipeline &p : byAlpha)
+                p.destroy(m_device);
+        }
+
+        VkPipeline *computePipelines[] = {&m_cullPipeline, &m_occlusionPipeline, &m_argsPipeline, &m_scatterPipeline};
+        for (VkPipeline *p : computePipelines)
+        {
+            if (*p != VK_NULL_HANDLE)
+                vkDestroyPipeline(m_device, *p, nullptr);
+            *p = VK_NULL_HANDLE;
+        }
+        if (m_drawLayout != VK_NULL_HANDLE)
+            vkDestroyPipelineLayout(m_device, m_drawLayout, nullptr);
+        if (m_computeLayout != VK_NULL_HANDLE)
+            vkDestroyPipelineLayout(m_device, m_computeLayout, nullptr);
+        if (m_pool != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(m_device, m_pool, nullptr); // frees the sets
+        if (m_hiZSetLayout != VK_NULL_HANDLE)
+            vkDestroyDescriptorSetLayout(m_device, m_hiZSetLayout, nullptr);
+        if (m_setLayout != VK_NULL_HANDLE)
+            vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+
+        m_drawLayout = VK_NULL_HANDLE;
+        m_computeLayout = VK_NULL_HANDLE;
+        m_pool = VK_NULL_HANDLE;
+        m_hiZSetLayout = VK_NULL_HANDLE;
+        m_setLayout = VK_NULL_HANDLE;
+    }
+
+    void GpuSceneRenderPassModule::onResize(VulkanContext &ctx, VkExtent2D newExtent)
+    {
+        (void)ctx;
+        m_extent = newExtent;
+    }
+
+    void GpuSceneRenderPassModule::onDestroy(VulkanContext &ctx)
+    {
+        (void)ctx;
+        if (m_device == VK_NULL_HANDLE)
+            return;
+
+        for (Frame &f : m_frames)
+        {
+            destroyBuffer(f.staging);
+            destroyBuffer(f.visible);
+            destroyBuffer(f.drawState);
+            destroyBuffer(f.drawInstances);
+            destroyBuffer(f.counters);
+            destroyBuffer(f.commands);
+        }
+        m_frames.clear();
+
+        destroyBuffer(m_instanceBuffer);
+        destroyBuffer(m_modelBuffer);
+        destroyBuffer(m_drawBuffer);
+        destroyBuffer(m_clipBuffer);
+        destroyBuffer(m_bakedBuffer);
+        for (Retired &r : m_retired)
+            destroyBuffer(r.buffer);
+        m_retired.clear();
+
+        m_builtModels.clear();
+        m_drawsPerInstance.clear();
+        m_groups.clear();
+        m_drawCount = 0;
+        m_staticValid = false;
+
+        // A recreated module starts with an empty GPU buffer: upload every slot again.
+        m_record.dirty.clear();
+        std::fill(m_record.dirtyFlag.begin(), m_record.dirtyFlag.end(), 0);
+        for (uint32_t slot = 0; slot < m_record.instances.size(); ++slot)
+        {
+            m_record.dirtyFlag[slot] = 1;
+            m_record.dirty.push_back(slot);
+        }
+
+        destroyPipelines();
+        m_shared.reset();
+        m_ready = false;
+        m_device = VK_NULL_HANDLE;
+        m_physicalDevice = VK_NULL_HANDLE;
+        m_extent = {};
+    }
+
+    void GpuSceneRenderPassModule::destroyBuffer(Buffer &b)
+    {
+        DestroyBuffer(m_device, b.buffer, b.allocation);
+        b = Buffer{};
+    }
+
+    bool GpuSceneRenderPassModule::createBuffer(Buffer &b, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible)
+    {
+        b = Buffer{};
+        const VkMemoryPropertyFlags props = hostVisible
+                                                ? (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+                                                : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        if (GpuAllocator::forDevice(m_device, m_physicalDevice)
+                .createBuffer(size, usage, props, GpuMemoryCategory::Compute, b.buffer, b.allocation) != VK_SUCCESS)
+            return false;
+        b.mapped = b.allocation.mapped;
+        b.size = size;
+        return true;
+    }
+
+    bool GpuSceneRenderPassModule::ensureBuffer(Buffer &b, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible)
+    {
+        if (size <= b.size && b.buffer != VK_NULL_HANDLE)
+            return true;
+
+        // Grow by doubling; the frame's fence has signalled, so the old buffer is idle.
+        VkDeviceSize newSize = (b.size > 0) ? b.size : 256;
+        while (newSize < size)
+            newSize *= 2;
+        destroyBuffer(b);
+        return createBuffer(b, newSize, usage, hostVisible);
+    }
+
+    void GpuSceneRenderPassModule::retire(Buffer &b)
+    {
+        if (b.buffer == VK_NULL_HANDLE)
+            return;
+        Retired r;
+        r.buffer = b;
+        r.framesLeft = static_cast<uint32_t>(m_frames.size()) + 1u;
+        m_retired.push_back(r);
+        b = Buffer{};
+    }
+
+    void GpuSceneRenderPassModule::tickRetired()
+    {
+        for (size_t i = 0; i < m_retired.size();)
+        {
+            if (--m_retired[i].framesLeft == 0)
+            {
+                destroyBuffer(m_retired[i].buffer);
+                m_retired[i] = m_retired.back();
+                m_retired.pop_back();
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    bool GpuSceneRenderPassModule::uploadInstances(VkCommandBuffer cmd, Frame &f)
+    {
+        RecordState &r = m_record;
+        const VkDeviceSize needed = sizeof(GpuInstance) * std::max<size_t>(r.instances.size(), 1);
+
+        // The scene buffer is shared by every frame in flight: a larger one replaces it and is filled
+        // from the mirror, the old one is retired.
+        if (needed > m_instanceBuffer.size)
+        {
+            VkDeviceSize newSize = std::max<VkDeviceSize>(m_instanceBuffer.size, 4096);
+            while (newSize < needed)
+                newSize *= 2;
+            retire(m_instanceBuffer);
+            if (!createBuffer(m_instanceBuffer, newSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false))
+                return false;
+
+            r.dirty.clear();
+            for (uint32_t slot = 0; slot < r.instances.size(); ++slot)
+            {
+                r.dirtyFlag[slot] = 1;
+                r.dirty.push_back(slot);
+            }
+        }
+
+        if (r.dirty.empty())
+            return true;
+
+        const VkDeviceSize bytes = sizeof(GpuInstance) * r.dirty.size();
+        if (!ensureBuffer(f.staging, bytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, true))
+            return false;
+
+        // Sorted slots, one copy region per run of consecutive slots.
+        std::sort(r.dirty.begin(), r.dirty.end());
+        GpuInstance *dst = static_cast<GpuInstance *>(f.staging.mapped);
+        m_copyScratch.clear();
+        for (size_t i = 0; i < r.dirty.size(); ++i)
+        {
+            const uint32_t slot = r.dirty[i];
+            dst[i] = r.instances[slot];
+            r.dirtyFlag[slot] = 0;
+
+            const VkDeviceSize srcOffset = sizeof(GpuInstance) * i;
+            const VkDeviceSize dstOffset = sizeof(GpuInstance) * slot;
+            if (!m_copyScratch.empty() && m_copyScratch.back().dstOffset + m_copyScratch.back().size == dstOffset)
+                m_copyScratch.back().size += sizeof(GpuInstance);
+            else
+                m_copyScratch.push_back({srcOffset, dstOffset, sizeof(GpuInstance)});
+        }
+        r.dirty.clear();
+
+        // Earlier frames read the buffer in compute and vertex shaders: order the copy after them.
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+        vkCmdCopyBuffer(cmd, f.staging.buffer, m_instanceBuffer.buffer, static_cast<uint32_t>(m_copyScratch.size()), m_copyScratch.data());
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+        return true;
+    }
+
+    bool GpuSceneRenderPassModule::refreshStatic(VkCommandBuffer cmd)
+    {
+        // Rebuild when a model was added, reloaded, unloaded or finished streaming in; built models
+        // are compared by pointer only.
+        bool rebuild = !m_staticValid || m_builtModels.size() != m_record.models.size();
+        for (size_t i = 0; i < m_record.models.size() && !rebuild; ++i)
+        {
+            const ModelAsset *model = m_assets->getModel(m_record.models[i]);
+            if (model != m_builtModels[i])
+                rebuild = true;
+            else if (model && m_drawsPerInstance[i] == 0 && !model->primitives.empty())
+            {
+                // Built before its meshes were resident: retry once one is.
+                for (const ModelPrimitive &prim : model->primitives)
+                {
+                    MeshAsset *mesh = m_assets->getMesh(prim.mesh);
+                    if (mesh && mesh->getVertexBuffer() != VK_NULL_HANDLE && m_assets->getMaterial(prim.material))
+                    {
+                        rebuild = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (rebuild && !buildStatic(cmd))
+        {
+            m_staticValid = false;
+            return false;
+        }
+        return m_drawCount > 0;
+    }
+
+    bool GpuSceneRenderPassModule::buildStatic(VkCommandBuffer cmd)
+    {
+        const uint32_t modelCount = static_cast<uint32_t>(m_record.models.size());
+        std::vector<GpuModel> models(std::max(modelCount, 1u));
+        std::vector<GpuDraw> draws;
+        std::vector<GpuClip> clips;
+        std::vector<glm::mat4> baked;
+        std::vector<uint32_t> drawGroup;
+        std::vector<Group> groups;
+
+        m_builtModels.assign(modelCount, nullptr);
+        m_drawsPerInstance.assign(modelCount, 0);
+        m_modelSpheres.assign(modelCount, glm::vec4(0.0f));
+
+        struct Source
+        {
+            const ModelPrimitive *prim;
+            uint32_t node;
+        };
+        std::vector<Source> sources;
+
+        for (uint32_t m = 0; m < modelCount; ++m)
+        {
+            const ModelAsset *model = m_assets->getModel(m_record.models[m]);
+            m_builtModels[m] = model;
+            if (!model)
+                continue;
+
+            GpuModel &gm = models[m];
+            gm.base = fitMatrix(*model);
+            gm.sphere = boundingSphere(*model, gm.base);
+            m_modelSpheres[m] = gm.sphere;
+
+            // Drawable primitives in SModelRenderPassModule order: pass, then node, then node primitive.
+            auto drawable = [&](const ModelPrimitive &prim, uint32_t alphaMode)
+            {
+                MeshAsset *mesh = m_assets->getMesh(prim.mesh);
+                MaterialAsset *mat = m_assets->getMaterial(prim.material);
+                return mesh && mat && mat->alphaMode == alphaMode && mesh->getVertexBuffer() != VK_NULL_HANDLE &&
+                       mesh->getIndexBuffer() != VK_NULL_HANDLE && prim.indexCount != 0;
+            };
+            sources.clear();
+            for (uint32_t alphaMode = 0; alphaMode < 3; ++alphaMode)
+            {
+                if (model->nodes.empty())
+                {
+                    for (const ModelPrimitive &prim : model->primitives)
+                    {
+                        if (drawable(prim, alphaMode))
+                            sources.push_back({&prim, 0u});
+                    }
+                    continue;
+                }
+                for (uint32_t n = 0; n < static_cast<uint32_t>(model->nodes.size()); ++n)
+                {
+                    const auto &node = model->nodes[n];
+                    for (uint32_t k = 0; k < node.primitiveCount; ++k)
+                    {
+                        const uint32_t primIndex = model->nodePrimitiveIndices[node.firstPrimitiveIndex + k];
+                        if (primIndex < model->primitives.size() && drawable(model->primitives[primIndex], alphaMode))
+                            sources.push_back({&model->primitives[primIndex], n});
+                    }
+                }
+            }
+
+            // Model-wide LOD error per level, as SModelRenderPassModule::selectLods()
+            uint32_t levels = 1;
+            float levelError[kLodLevels] = {};
+            for (const Source &s : sources)
+            {
+                if (s.prim->lodCount == 0)
+                    continue;
+                levels = std::max(levels, s.prim->lodCount + 1);
+                for (uint32_t l = 1; l < kLodLevels; ++l)
+                    levelError[l] = std::max(levelError[l], s.prim->lods[std::min(l, s.prim->lodCount) - 1].error);
+            }
+            const float fitScale = maxAxisScale(gm.base);
+            gm.lodError = glm::vec4(0.0f, levelError[1] * fitScale, levelError[2] * fitScale, levelError[3] * fitScale);
+
+            const uint32_t nodeCount = std::max<uint32_t>(static_cast<uint32_t>(model->nodes.size()), 1u);
+            const uint32_t jointCount = std::max(model->totalJointCount, 1u);
+            const uint32_t perLevel = static_cast<uint32_t>(sources.size());
+            gm.draws = glm::uvec4(static_cast<uint32_t>(draws.size()), perLevel, levels, nodeCount);
+            m_drawsPerInstance[m] = perLevel;
+
+            for (uint32_t level = 0; level < levels; ++level)
+            {
+                for (const Source &s : sources)
+                {
+                    const ModelPrimitive &prim = *s.prim;
+                    MeshAsset *mesh = m_assets->getMesh(prim.mesh);
+                    MaterialAsset *mat = m_assets->getMaterial(prim.material);
+
+                    const uint32_t lod = std::min(level, prim.lodCount);
+                    GpuDraw d;
+                    d.geom.x = (lod == 0) ? prim.indexCount : prim.lods[lod - 1].indexCount;
+                    d.geom.y = (lod == 0) ? prim.firstIndex : prim.lods[lod - 1].firstIndex;
+                    d.geom.z = static_cast<uint32_t>(prim.vertexOffset);
+                    d.geom.w = s.node;
+                    if (prim.skinIndex >= 0 && static_cast<uint32_t>(prim.skinIndex) < model->skins.size())
+                    {
+                        const auto &skin = model->skins[static_cast<uint32_t>(prim.skinIndex)];
+                        d.skin = glm::uvec4(skin.jointBase, skin.jointCount, 0u, 0u);
+                    }
+                    if (mesh->isQuantized())
+                    {
+                        SModelRenderer::PushConstants q;
+                        q.setQuantizationBox(mesh->getAABBMin(), mesh->getAABBMax());
+                        d.quant = glm::uvec4(q.quantBox[0], q.quantBox[1], q.quantBox2, 0u);
+                    }
+
+                    Group key;
+                    key.alphaMode = mat->alphaMode;
+                    key.quantized = mesh->isQuantized();
+                    key.vertexBuffer = mesh->getVertexBuffer();
+                    key.indexBuffer = mesh->getIndexBuffer();
+                    key.indexType = mesh->getIndexType();
+                    key.material = prim.material;
+                    uint32_t g = 0;
+                    while (g < groups.size() &&
+                           !(groups[g].alphaMode == key.alphaMode && groups[g].quantized == key.quantized &&
+                             groups[g].vertexBuffer == key.vertexBuffer && groups[g].indexBuffer == key.indexBuffer &&
+                             groups[g].indexType == key.indexType && groups[g].material.id == key.material.id &&
+                             groups[g].material.generation == key.material.generation))
+                        ++g;
+                    if (g == groups.size())
+                        groups.push_back(key);
+                    ++groups[g].commandCount;
+
+                    draws.push_back(d);
+                    drawGroup.push_back(g);
+                }
+            }
+
+            // Baked frames: node globals, then joint matrices (global * inverse bind), per clip.
+            std::vector<uint32_t> jointNode(jointCount, ~0u);
+            std::vector<glm::mat4> inverseBind(jointCount, glm::mat4(1.0f));
+            for (const auto &skin : model->skins)
+            {
+                for (uint32_t j = 0; j < skin.jointCount; ++j)
+                {
+                    const uint32_t slot = skin.jointBase + j;
+                    if (slot >= jointCount || j >= skin.jointNodeIndices.size() || j >= skin.inverseBind.size())
+                        continue;
+                    jointNode[slot] = skin.jointNodeIndices[j];
+                    inverseBind[slot] = skin.inverseBind[j];
+                }
+            }
+
+            auto appendFrames = [&](const glm::mat4 *globals, uint32_t frameCount, float sampleRate)
+            {
+                GpuClip c;
+                c.firstNode = static_cast<uint32_t>(baked.size());
+                c.frameCount = frameCount;
+                c.sampleRate = sampleRate;
+                baked.insert(baked.end(), globals, globals + static_cast<size_t>(frameCount) * nodeCount);
+                c.firstJoint = static_cast<uint32_t>(baked.size());
+                for (uint32_t f = 0; f < frameCount; ++f)
+                {
+                    const glm::mat4 *frame = globals + static_cast<size_t>(f) * nodeCount;
+                    for (uint32_t j = 0; j < jointCount; ++j)
+                        baked.push_back(jointNode[j] < nodeCount ? frame[jointNode[j]] * inverseBind[j] : glm::mat4(1.0f));
+                }
+                clips.push_back(c);
+            };
+
+            gm.anim = glm::uvec4(static_cast<uint32_t>(clips.size()), 0u, jointCount, 0u);
+            if (GpuPoseEvaluator::supports(*model))
+            {
+                for (const ModelAsset::BakedClip &b : model->bakedClips)
+                    appendFrames(b.globals.data(), b.frameCount, b.sampleRate);
+            }
+            else
+            {
+                // Rest pose as a one-frame clip.
+                std::vector<glm::mat4> rest(nodeCount, glm::mat4(1.0f));
+                for (size_t n = 0; n < model->nodes.size(); ++n)
+                    rest[n] = model->nodes[n].globalMatrix;
+                appendFrames(rest.data(), 1, 0.0f);
+            }
+            gm.anim.y = static_cast<uint32_t>(clips.size()) - gm.anim.x;
+        }
+
+        // Commands grouped by pipeline group, OPAQUE then MASK then BLEND.
+        std::vector<uint32_t> order(groups.size());
+        for (uint32_t g = 0; g < order.size(); ++g)
+            order[g] = g;
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+                         { return groups[a].alphaMode < groups[b].alphaMode; });
+        std::vector<uint32_t> remap(groups.size());
+        std::vector<Group> sorted(groups.size());
+        uint32_t nextCommand = 0;
+        for (uint32_t i = 0; i < order.size(); ++i)
+        {
+            remap[order[i]] = i;
+            sorted[i] = groups[order[i]];
+            sorted[i].firstCommand = nextCommand;
+            nextCommand += sorted[i].commandCount;
+        }
+        std::vector<uint32_t> cursor(sorted.size(), 0);
+        for (size_t d = 0; d < draws.size(); ++d)
+        {
+            const uint32_t g = remap[drawGroup[d]];
+            draws[d].slot = glm::uvec4(sorted[g].firstCommand + cursor[g]++, g, sorted[g].firstCommand, 0u);
+        }
+
+        // One staging buffer, copied into fresh device-local tables; the old ones are retired.
+        if (draws.empty())
+            draws.emplace_back();
+        if (clips.empty())
+            clips.push_back(GpuClip{0, 0, 1, 0.0f});
+        if (baked.empty())
+            baked.emplace_back(1.0f);
+
+        const VkDeviceSize modelBytes = sizeof(GpuModel) * models.size();
+        const VkDeviceSize drawBytes = sizeof(GpuDraw) * draws.size();
+        const VkDeviceSize clipBytes = sizeof(GpuClip) * clips.size();
+        const VkDeviceSize bakedBytes = sizeof(glm::mat4) * baked.size();
+        const VkDeviceSize drawOffset = alignUp(modelBytes, kStagingAlign);
+        const VkDeviceSize clipOffset = drawOffset + alignUp(drawBytes, kStagingAlign);
+        const VkDeviceSize bakedOffset = clipOffset + alignUp(clipBytes, kStagingAlign);
+
+        Buffer staging;
+        if (!createBuffer(staging, bakedOffset + bakedBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, true))
+            return false;
+        uint8_t *dst = static_cast<uint8_t *>(staging.mapped);
+        std::memcpy(dst, models.data(), modelBytes);
+        std::memcpy(dst + drawOffset, draws.data(), drawBytes);
+        std::memcpy(dst + clipOffset, clips.data(), clipBytes);
+        std::memcpy(dst + bakedOffset, baked.data(), bakedBytes);
+
+        retire(m_modelBuffer);
+        retire(m_drawBuffer);
+        retire(m_clipBuffer);
+        retire(m_bakedBuffer);
+        const VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        if (!createBuffer(m_modelBuffer, modelBytes, usage, false) || !createBuffer(m_drawBuffer, drawBytes, usage, false) ||
+            !createBuffer(m_clipBuffer, clipBytes, usage, false) || !createBuffer(m_bakedBuffer, bakedBytes, usage, false))
+        {
+            std::cerr << "[GpuScene] failed to allocate model tables\n";
+            destroyBuffer(staging);
+            destroyBuffer(m_modelBuffer);
+            destroyBuffer(m_drawBuffer);
+            destroyBuffer(m_clipBuffer);
+            destroyBuffer(m_bakedBuffer);
+            m_groups.clear();
+            m_drawCount = 0;
+            return false;
+        }
+
+        const VkBufferCopy regions[4] = {{0, 0, modelBytes}, {drawOffset, 0, drawBytes}, {clipOffset, 0, clipBytes}, {bakedOffset, 0, bakedBytes}};
+        vkCmdCopyBuffer(cmd, staging.buffer, m_modelBuffer.buffer, 1, &regions[0]);
+        vkCmdCopyBuffer(cmd, staging.buffer, m_drawBuffer.buffer, 1, &regions[1]);
+        vkCmdCopyBuffer(cmd, staging.buffer, m_clipBuffer.buffer, 1, &regions[2]);
+        vkCmdCopyBuffer(cmd, staging.buffer, m_bakedBuffer.buffer, 1, &regions[3]);
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        // The copy executes with this frame; free the staging buffer once it has retired.
+        retire(staging);
+
+        m_groups = std::move(sorted);
+        m_drawCount = nextCommand;
+        m_staticValid = true;
+        return true;
+    }
+
+    void GpuSceneRenderPassModule::reportScreenSizes(const ViewData &view)
+    {
+        if (!m_assets->textureStreamingEnabled() || m_extent.height == 0)
+            return;
+
+        // Projected diameter of each instance's bounds, a slice of the scene per frame; every model's
+        // largest is reported once a sweep over all slots completes.
+        const float pixelScale = std::abs(view.proj[1][1]) * 0.5f * static_cast<float>(m_extent.height);
+        const uint32_t slots = static_cast<uint32_t>(m_record.instances.size());
+        const uint32_t end = std::min(m_feedbackCursor + kFeedbackSlice, slots);
+        m_feedbackPixels.resize(m_builtModels.size(), 0.0f);
+        for (uint32_t i = m_feedbackCursor; i < end; ++i)
+        {
+            const GpuInstance &inst = m_record.instances[i];
+            const uint32_t model = inst.modelClip & 0xFFFFu;
+            if (model >= m_builtModels.size() || !m_builtModels[model])
+                continue;
+
+            float sy = 0.0f;
+            float cy = 1.0f;
+            std::memcpy(&sy, &inst.yawSin, sizeof(sy));
+            std::memcpy(&cy, &inst.yawCos, sizeof(cy));
+            const glm::vec4 &sphere = m_modelSpheres[model];
+            const float scale = inst.posScale.w;
+            // Same rotation as gpu_scene.vert: yaw about +Y, then uniform scale.
+            const glm::vec3 r(cy * sphere.x + sy * sphere.z, sphere.y, -sy * sphere.x + cy * sphere.z);
+            const glm::vec3 center = glm::vec3(inst.posScale) + r * scale;
+            const float dist = std::max(glm::length(center - view.position) - sphere.w * scale, 1e-3f);
+            m_feedbackPixels[model] = std::max(m_feedbackPixels[model], 2.0f * sphere.w * scale * pixelScale / dist);
+        }
+
+        m_feedbackCursor = end;
+        if (end < slots)
+            return;
+        m_feedbackCursor = 0;
+        for (size_t m = 0; m < m_builtModels.size(); ++m)
+        {
+            if (m_builtModels[m] && m_feedbackPixels[m] > 0.0f)
+            {
+                for (const ModelPrimitive &prim : m_builtModels[m]->primitives)
+                    m_assets->reportMaterialScreenSize(prim.material, m_feedbackPixels[m]);
+            }
+            m_feedbackPixels[m] = 0.0f;
+        }
+    }
+
+    void GpuSceneRenderPassModule::recordPrePass(FrameContext &frameCtx, VkCommandBuffer cmd)
+    {
+        tickRetired();
+        if (!m_ready || m_frames.empty() || !m_assets)
+            return;
+
+        Frame &f = m_frames[frameCtx.frameIndex % m_frames.size()];
+        f.prepared = false;
+        f.culled = false;
+
+        // The scene buffer follows the game even while the pass is disabled.
+        if (!uploadInstances(cmd, f))
+            return;
+        if (!m_enabled || !frameCtx.view || frameCtx.viewBuffer == VK_NULL_HANDLE || m_record.instances.empty())
+            return;
+        if (!refreshStatic(cmd))
+            return;
+        reportScreenSizes(*frameCtx.view);
+
+        // Per-frame outputs, sized by their upper bounds: every slot visible, every instance in all
+        // draws of one LOD level.
+        VkDeviceSize drawInstanceCount = 1;
+        for (size_t m = 0; m < m_drawsPerInstance.size() && m < m_record.modelInstances.size(); ++m)
+            drawInstanceCount += static_cast<VkDeviceSize>(m_record.modelInstances[m]) * m_drawsPerInstance[m];
+
+        const VkBufferUsageFlags storage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        const VkBufferUsageFlags cleared = storage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        const VkBufferUsageFlags indirect = storage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+        const bool ok =
+            ensureBuffer(f.visible, kVisibleRecordSize * m_record.instances.size(), storage, false) &&
+            ensureBuffer(f.drawState, kDrawStateSize * m_drawCount, cleared, false) &&
+            ensureBuffer(f.drawInstances, kDrawInstanceSize * drawInstanceCount, storage, false) &&
+            ensureBuffer(f.counters, kCountersHeader + sizeof(uint32_t) * m_groups.size(), cleared | indirect, false) &&
+            ensureBuffer(f.commands, kCommandStride * m_drawCount, indirect, false);
+        if (!ok)
+            return;
+
+        const VkBuffer buffers[kBindingCount] = {frameCtx.viewBuffer, m_instanceBuffer.buffer, m_modelBuffer.buffer, m_drawBuffer.buffer,
+                                                 m_clipBuffer.buffer, m_bakedBuffer.buffer, f.visible.buffer, f.drawState.buffer,
+                                                 f.drawInstances.buffer, f.counters.buffer, f.commands.buffer};
+        VkDescriptorBufferInfo infos[kBindingCount]{};
+        VkWriteDescriptorSet writes[kBindingCount]{};
+        for (uint32_t b = 0; b < kBindingCount; ++b)
+        {
+            infos[b] = {buffers[b], 0, (b == ViewBinding) ? static_cast<VkDeviceSize>(sizeof(GpuViewData)) : VK_WHOLE_SIZE};
+            writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[b].dstSet = f.set;
+            writes[b].dstBinding = b;
+            writes[b].descriptorCount = 1;
+            writes[b].descriptorType = (b == ViewBinding) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[b].pBufferInfo = &infos[b];
+        }
+        vkUpdateDescriptorSets(m_device, kBindingCount, writes, 0, nullptr);
+
+        vkCmdFillBuffer(cmd, f.drawState.buffer, 0, VK_WHOLE_SIZE, 0);
+        vkCmdFillBuffer(cmd, f.counters.buffer, 0, VK_WHOLE_SIZE, 0);
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+        f.prepared = true;
+
+        // With a Hi-Z pyramid this frame the passes wait for recordOcclusionCull().
+        const bool occlusion = m_record.occlusionCulling && m_occlusionPipeline != VK_NULL_HANDLE &&
+                               frameCtx.hiZView != VK_NULL_HANDLE && frameCtx.hiZSampler != VK_NULL_HANDLE;
+        if (!occlusion)
+            recordCull(frameCtx, cmd, false);
+    }
+
+    void GpuSceneRenderPassModule::recordOcclusionCull(FrameContext &frameCtx, VkCommandBuffer cmd)
+    {
+        if (!m_ready || m_frames.empty())
+            return;
+        Frame &f = m_frames[frameCtx.frameIndex % m_frames.size()];
+        if (f.prepared && !f.culled)
+            recordCull(frameCtx, cmd, true);
+    }
+
+    void GpuSceneRenderPassModule::recordCull(FrameContext &frameCtx, VkCommandBuffer cmd, bool occlusion)
+    {
+        Frame &f = m_frames[frameCtx.frameIndex % m_frames.size()];
+        const uint32_t slotCount = static_cast<uint32_t>(std::min<size_t>(m_record.instances.size(),
+                                                                          static_cast<size_t>(m_maxGroupsX) * kGroupSize));
+        const uint32_t viewOffset = static_cast<uint32_t>(frameCtx.viewOffset);
+
+        CullPushConstants pc{};
+        pc.counts = glm::uvec4(slotCount, static_cast<uint32_t>(m_record.models.size()), m_drawCount, 0u);
+        const float pixelScale = std::abs(frameCtx.view->proj[1][1]) * 0.5f * static_cast<float>(m_extent.height);
+        pc.lod = glm::vec4(pixelScale, m_extent.height > 0 ? m_record.lodPixelError : 0.0f, 0.0f, 0.0f);
+
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computeLayout, 0, 1, &f.set, 1, &viewOffset);
+        if (occlusion)
+        {
+            VkDescriptorImageInfo hiZ{frameCtx.hiZSampler, frameCtx.hiZView, VK_IMAGE_LAYOUT_GENERAL};
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = f.hiZSet;
+            write.dstBinding = 0;
+            write.descriptorCount = 1;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            write.pImageInfo = &hiZ;
+            vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computeLayout, 1, 1, &f.hiZSet, 0, nullptr);
+        }
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+
+        // 1. cull: visible records + per-draw counts
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, occlusion ? m_occlusionPipeline : m_cullPipeline);
+        vkCmdPushConstants(cmd, m_computeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+        vkCmdDispatch(cmd, (slotCount + kGroupSize - 1) / kGroupSize, 1, 1);
+
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        // 2. args: draw ranges, commands, scatter dispatch
+        const glm::uvec4 args(m_drawCount, m_drawIndexedIndirectCount ? 1u : 0u, m_maxGroupsX, 0u);
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_argsPipeline);
+        vkCmdPushConstants(cmd, m_computeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(args), &args);
+        vkCmdDispatch(cmd, 1, 1, 1);
+
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        // 3. scatter: visible instances into their draws' ranges
+        const glm::uvec4 scatter(static_cast<uint32_t>(f.drawInstances.size / kDrawInstanceSize), 0u, 0u, 0u);
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_scatterPipeline);
+        vkCmdPushConstants(cmd, m_computeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(scatter), &scatter);
+        vkCmdDispatchIndirect(cmd, f.counters.buffer, sizeof(uint32_t));
+
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+        f.culled = true;
+    }
+
+    void GpuSceneRenderPassModule::record(FrameContext &frameCtx, VkCommandBuffer cmd)
+    {
+        if (!m_ready || !m_enabled || m_frames.empty() || m_extent.width == 0 || m_extent.height == 0)
+            return;
+        const Frame &f = m_frames[frameCtx.frameIndex % m_frames.size()];
+        if (!f.culled)
+            return;
+
+        VkViewport vp{0.0f, 0.0f, static_cast<float>(m_extent.width), static_cast<float>(m_extent.height), 0.0f, 1.0f};
+        VkRect2D sc{{0, 0}, m_extent};
+        vkCmdSetViewport(cmd, 0, 1, &vp);
+        vkCmdSetScissor(cmd, 0, 1, &sc);
+
+        const uint32_t viewOffset = static_cast<uint32_t>(frameCtx.viewOffset);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_drawLayout, 0, 1, &f.set, 1, &viewOffset);
+
+        const Pipeline *boundPipeline = nullptr;
+        VkDescriptorSet boundMaterial = VK_NULL_HANDLE;
+        for (uint32_t g = 0; g < m_groups.size(); ++g)
+        {
+            const Group &group = m_groups[g];
+            MaterialAsset *mat = m_assets->getMaterial(group.material);
+            if (!mat || group.commandCount == 0)
+                continue;
+
+            const Pipeline &pipe = m_pipelines[group.quantized ? 1 : 0][std::min(group.alphaMode, 2u)];
+            if (&pipe != boundPipeline)
+            {
+                pipe.bind(cmd);
+                boundPipeline = &pipe;
+            }
+
+            // Re-resolved every frame: streaming base color textures switch from the fallback.
+            const SModelRenderer::MaterialBinding mb = m_shared->material(*m_assets, group.material, *mat);
+            if (mb.set != boundMaterial && mb.set != VK_NULL_HANDLE)
+            {
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_drawLayout, 1, 1, &mb.set, 0, nullptr);
+                boundMaterial = mb.set;
+            }
+
+            SModelRenderer::PushConstants pc{};
+            pc.model[0] = pc.model[5] = pc.model[10] = pc.model[15] = 1.0f;
+            std::memcpy(pc.baseColorFactor, mat->baseColorFactor, sizeof(pc.baseColorFactor));
+            pc.materialParams[0] = mat->alphaCutoff;
+            pc.materialParams[1] = static_cast<float>(mat->alphaMode);
+            pc.materialIndex = mb.index;
+            vkCmdPushConstants(cmd, m_drawLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pc), &pc);
+
+            const VkDeviceSize zero = 0;
+            vkCmdBindVertexBuffers(cmd, 0, 1, &group.vertexBuffer, &zero);
+            vkCmdBindIndexBuffer(cmd, group.indexBuffer, 0, group.indexType);
+
+            const VkDeviceSize offset = kCommandStride * group.firstCommand;
+            if (m_drawIndexedIndirectCount)
+            {
+                m_drawIndexedIndirectCount(cmd, f.commands.buffer, offset, f.counters.buffer,
+                                           kCountersHeader + sizeof(uint32_t) * g, group.commandCount,
+                                           static_cast<uint32_t>(kCommandStride));
+            }
+            else if (m_multiDraw)
+            {
+                vkCmdDrawIndexedIndirect(cmd, f.commands.buffer, offset, group.commandCount, static_cast<uint32_t>(kCommandStride));
+            }
+            else
+            {
+                for (uint32_t c = 0; c < group.commandCount; ++c)
+                    vkCmdDrawIndexedIndirect(cmd, f.commands.buffer, offset + kCommandStride * c, 1, static_cast<uint32_t>(kCommandStride));
+            }
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#include "Engine/GpuTimeline.h"
+
+#include <utility>
+
+namespace Engine
+{
+    bool GpuTimeline::create(VkDevice device, uint64_t initialValue)
+    {
+        destroy();
+
+        m_getCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(
+            vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR"));
+        m_waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(
+            vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR"));
+        if (!m_getCounterValue || !m_waitSemaphores)
+            return false;
+
+        VkSemaphoreTypeCreateInfoKHR typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+        typeInfo.initialValue = initialValue;
+
+        VkSemaphoreCreateInfo si{};
+        si.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        si.pNext = &typeInfo;
+        if (vkCreateSemaphore(device, &si, nullptr, &m_semaphore) != VK_SUCCESS)
+        {
+            m_semaphore = VK_NULL_HANDLE;
+            return false;
+        }
+
+        m_device = device;
+        m_lastReserved = initialValue;
+        return true;
+    }
+
+    void GpuTimeline::destroy()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_deferredMutex);
+            m_ready.swap(m_deferred);
+        }
+        for (Deferred &d : m_ready)
+            d.release();
+        m_ready.clear();
+
+        if (m_semaphore != VK_NULL_HANDLE)
+            vkDestroySemaphore(m_device, m_semaphore, nullptr);
+        m_semaphore = VK_NULL_HANDLE;
+        m_device = VK_NULL_HANDLE;
+        m_lastReserved = 0;
+    }
+
+    uint64_t GpuTimeline::completed() const
+    {
+        if (!valid())
+            return 0;
+        uint64_t value = 0;
+        m_getCounterValue(m_device, m_semaphore, &value);
+        return value;
+    }
+
+    bool GpuTimeline::wait(uint64_t value, uint64_t timeoutNs) const
+    {
+        if (!valid())
+            return false;
+
+        VkSemaphoreWaitInfoKHR waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &m_semaphore;
+        waitInfo.pValues = &value;
+        return m_waitSemaphores(m_device, &waitInfo, timeoutNs) == VK_SUCCESS;
+    }
+
+    void GpuTimeline::deferUntil(uint64_t value, std::function<void()> release)
+    {
+        std::lock_guard<std::mutex> lock(m_deferredMutex);
+        m_deferred.push_back({value, std::move(release)});
+    }
+
+    void GpuTimeline::collect()
+    {
+        const uint64_t done = completed();
+        {
+            std::lock_guard<std::mutex> lock(m_deferredMutex);
+            for (size_t i = 0; i < m_deferred.size();)
+            {
+                if (m_deferred[i].value <= done)
+                {
+                    m_ready.push_back(std::move(m_deferred[i]));
+                    m_deferred[i] = std::move(m_deferred.back());
+                    m_deferred.pop_back();
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+        }
+
+        // Outside the lock: a release may defer further work.
+        for (Deferred &d : m_ready)
+            d.release();
+        m_ready.clear();
+    }
+}
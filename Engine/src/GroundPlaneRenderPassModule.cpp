@@ -3,60 +3,48 @@
 #include "Engine/VulkanContext.h"
 #include "Engine/SwapChain.h"
 #include "Engine/PerformanceMonitor.h"
+#include "Engine/GpuAllocator.h"
+#include "Engine/Heightfield.h"
+
+#include "utils/ImageUtils.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <stdexcept>
 
 namespace Engine
 {
-    static bool findMemoryType(VkPhysicalDevice phys, uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t &typeIndex)
+    namespace
     {
-        VkPhysicalDeviceMemoryProperties memProps{};
-        vkGetPhysicalDeviceMemoryProperties(phys, &memProps);
-        for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
-        {
-            if ((typeFilter & (1u << i)) && (memProps.memoryTypes[i].propertyFlags & properties) == properties)
-            {
-                typeIndex = i;
-                return true;
-            }
-        }
-        return false;
+        constexpr uint32_t kMaxLevels = 16;
     }
 
     void GroundPlaneRenderPassModule::onCreate(VulkanContext &ctx, VkRenderPass pass, const std::vector<VkFramebuffer> &fbs)
     {
-        (void)pass;
-
         m_device = ctx.GetDevice();
         m_physicalDevice = ctx.GetPhysicalDevice();
         m_extent = ctx.GetSwapChain() ? ctx.GetSwapChain()->GetExtent() : VkExtent2D{};
 
         const size_t frameCount = (fbs.empty() ? 1u : fbs.size());
+        m_frameCount = static_cast<uint32_t>(frameCount);
 
         if (!createCameraResources(ctx, frameCount))
             throw std::runtime_error("GroundPlaneRenderPassModule: failed to create camera resources");
 
-        if (!createInstanceResources(ctx, frameCount))
-            throw std::runtime_error("GroundPlaneRenderPassModule: failed to create instance resources");
-
         if (!createMaterialResources(ctx, frameCount))
             throw std::runtime_error("GroundPlaneRenderPassModule: failed to create material resources");
 
-        if (!createGeometryResources(ctx, frameCount))
-            throw std::runtime_error("GroundPlaneRenderPassModule: failed to create geometry resources");
-
-        // Pipeline: reuse smodel shaders (camera set + material set + push constants)
+        // Pipeline: clipmap vertices from gl_VertexIndex / gl_InstanceIndex, no vertex input.
         PipelineCreateInfo pci{};
         pci.device = ctx.GetDevice();
         pci.renderPass = pass;
         pci.subpass = 0;
 
-        VkShaderModule vert = Pipeline::createShaderModuleFromFile(pci.device, "shaders/smodel.vert.spv");
-        VkShaderModule frag = Pipeline::createShaderModuleFromFile(pci.device, "shaders/smodel.frag.spv");
+        VkShaderModule vert = Pipeline::createShaderModuleFromFile(pci.device, "shaders/ground.vert.spv");
+        VkShaderModule frag = Pipeline::createShaderModuleFromFile(pci.device, "shaders/ground.frag.spv");
 
         VkPipelineShaderStageCreateInfo vs{};
         vs.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -72,37 +60,8 @@ namespace Engine
 
         pci.shaderStages = {vs, fs};
 
-        // Vertex input matches SModelRenderPassModule (VertexPNTTJW)
-        std::array<VkVertexInputBindingDescription, 2> bindingDescs{};
-        bindingDescs[0].binding = 0;
-        bindingDescs[0].stride = 72;
-        bindingDescs[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-        bindingDescs[1].binding = 1;
-        bindingDescs[1].stride = sizeof(glm::mat4);
-        bindingDescs[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
-
-        std::array<VkVertexInputAttributeDescription, 10> attrs{};
-        attrs[0] = {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0};
-        attrs[1] = {1, 0, VK_FORMAT_R32G32B32_SFLOAT, 12};
-        attrs[2] = {2, 0, VK_FORMAT_R32G32_SFLOAT, 24};
-        attrs[3] = {3, 0, VK_FORMAT_R32G32B32A32_SFLOAT, 32};
-
-        // Skinning inputs (unused for ground, but required by smodel.vert interface)
-        attrs[4] = {8, 0, VK_FORMAT_R16G16B16A16_UINT, 48};
-        attrs[5] = {9, 0, VK_FORMAT_R32G32B32A32_SFLOAT, 56};
-
-        attrs[6] = {4, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 0};
-        attrs[7] = {5, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 16};
-        attrs[8] = {6, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 32};
-        attrs[9] = {7, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 48};
-
         VkPipelineVertexInputStateCreateInfo vi{};
         vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vi.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescs.size());
-        vi.pVertexBindingDescriptions = bindingDescs.data();
-        vi.vertexAttributeDescriptionCount = static_cast<uint32_t>(attrs.size());
-        vi.pVertexAttributeDescriptions = attrs.data();
         pci.vertexInput = vi;
         pci.vertexInputProvided = true;
 
@@ -138,7 +97,7 @@ namespace Engine
         pci.dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
 
         VkPushConstantRange pcRange{};
-        pcRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        pcRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
         pcRange.offset = 0;
         pcRange.size = sizeof(PushConstants);
 
@@ -169,9 +128,19 @@ namespace Engine
 
         m_pipeline.destroy(m_device);
 
-        destroyGeometryResources();
+        for (auto &img : m_retiredHeights)
+            destroyHeightImage(img);
+        m_retiredHeights.clear();
+        destroyHeightImage(m_height);
+        m_heightInitialized = false;
+        m_snapshotHasTexture = false;
+        if (m_heightSampler != VK_NULL_HANDLE)
+        {
+            vkDestroySampler(m_device, m_heightSampler, nullptr);
+            m_heightSampler = VK_NULL_HANDLE;
+        }
+
         destroyMaterialResources();
-        destroyInstanceResources();
         destroyCameraResources();
 
         m_device = VK_NULL_HANDLE;
@@ -187,36 +156,30 @@ namespace Engine
 
         VkDescriptorSetLayoutBinding camBinding{};
         camBinding.binding = 0;
-        camBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        camBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         camBinding.descriptorCount = 1;
         camBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
-        VkDescriptorSetLayoutBinding paletteBinding{};
-        paletteBinding.binding = 1;
-        paletteBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        paletteBinding.descriptorCount = 1;
-        paletteBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-        VkDescriptorSetLayoutBinding jointPaletteBinding{};
-        jointPaletteBinding.binding = 2;
-        jointPaletteBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        jointPaletteBinding.descriptorCount = 1;
-        jointPaletteBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        VkDescriptorSetLayoutBinding heightBinding{};
+        heightBinding.binding = 1;
+        heightBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        heightBinding.descriptorCount = 1;
+        heightBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
         VkDescriptorSetLayoutCreateInfo dsl{};
         dsl.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        VkDescriptorSetLayoutBinding bindings[3] = {camBinding, paletteBinding, jointPaletteBinding};
-        dsl.bindingCount = 3;
+        VkDescriptorSetLayoutBinding bindings[2] = {camBinding, heightBinding};
+        dsl.bindingCount = 2;
         dsl.pBindings = bindings;
 
         if (vkCreateDescriptorSetLayout(ctx.GetDevice(), &dsl, nullptr, &m_cameraSetLayout) != VK_SUCCESS)
             return false;
 
         VkDescriptorPoolSize poolSizes[2]{};
-        poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         poolSizes[0].descriptorCount = static_cast<uint32_t>(frameCount);
-        poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        poolSizes[1].descriptorCount = static_cast<uint32_t>(frameCount) * 2u; // node palette + joint palette
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSizes[1].descriptorCount = static_cast<uint32_t>(frameCount);
 
         VkDescriptorPoolCreateInfo poolInfo{};
         poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -238,208 +201,39 @@ namespace Engine
         if (vkAllocateDescriptorSets(ctx.GetDevice(), &allocInfo, sets.data()) != VK_SUCCESS)
             return false;
 
-        m_cameraFrames.resize(frameCount);
+        // Heights are read with texelFetch (bilinear done in ground.vert, like Heightfield::heightAt).
+        VkSamplerCreateInfo si{};
+        si.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        si.magFilter = VK_FILTER_NEAREST;
+        si.minFilter = VK_FILTER_NEAREST;
+        si.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        si.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        si.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        si.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        if (vkCreateSampler(ctx.GetDevice(), &si, nullptr, &m_heightSampler) != VK_SUCCESS)
+            return false;
 
-        const VkDeviceSize bufSize = sizeof(CameraUBO);
+        // Both bindings are written by record(): binding 0 points at the frame's transient buffer,
+        // binding 1 at the height texture once it exists.
+        m_cameraFrames.resize(frameCount);
         for (size_t i = 0; i < frameCount; ++i)
-        {
-            CameraFrame &cf = m_cameraFrames[i];
-            cf.set = sets[i];
-
-            VkBufferCreateInfo binfo{};
-            binfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-            binfo.size = bufSize;
-            binfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-            binfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-            if (vkCreateBuffer(ctx.GetDevice(), &binfo, nullptr, &cf.buffer) != VK_SUCCESS)
-                return false;
-
-            VkMemoryRequirements memReq{};
-            vkGetBufferMemoryRequirements(ctx.GetDevice(), cf.buffer, &memReq);
-
-            VkMemoryAllocateInfo mai{};
-            mai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            mai.allocationSize = memReq.size;
-            uint32_t memType = 0;
-            if (!findMemoryType(ctx.GetPhysicalDevice(), memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memType))
-                return false;
-            mai.memoryTypeIndex = memType;
-
-            if (vkAllocateMemory(ctx.GetDevice(), &mai, nullptr, &cf.memory) != VK_SUCCESS)
-                return false;
-
-            vkBindBufferMemory(ctx.GetDevice(), cf.buffer, cf.memory, 0);
-
-            // Palette SSBO: allocate a tiny buffer (identity matrix) to satisfy smodel.vert.
-            cf.paletteCapacityMatrices = 4;
-
-            VkBufferCreateInfo pbinfo{};
-            pbinfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-            pbinfo.size = static_cast<VkDeviceSize>(cf.paletteCapacityMatrices) * sizeof(glm::mat4);
-            pbinfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-            pbinfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-            if (vkCreateBuffer(ctx.GetDevice(), &pbinfo, nullptr, &cf.paletteBuffer) != VK_SUCCESS)
-                return false;
-
-            VkMemoryRequirements pmemReq{};
-            vkGetBufferMemoryRequirements(ctx.GetDevice(), cf.paletteBuffer, &pmemReq);
-
-            VkMemoryAllocateInfo pmai{};
-            pmai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            pmai.allocationSize = pmemReq.size;
-            uint32_t pmemType = 0;
-            if (!findMemoryType(ctx.GetPhysicalDevice(), pmemReq.memoryTypeBits,
-                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, pmemType))
-                return false;
-            pmai.memoryTypeIndex = pmemType;
-
-            if (vkAllocateMemory(ctx.GetDevice(), &pmai, nullptr, &cf.paletteMemory) != VK_SUCCESS)
-                return false;
-
-            vkBindBufferMemory(ctx.GetDevice(), cf.paletteBuffer, cf.paletteMemory, 0);
-
-            cf.paletteMapped = nullptr;
-            if (vkMapMemory(ctx.GetDevice(), cf.paletteMemory, 0, VK_WHOLE_SIZE, 0, &cf.paletteMapped) != VK_SUCCESS)
-                return false;
-
-            if (cf.paletteMapped)
-            {
-                const glm::mat4 I(1.0f);
-                std::memcpy(cf.paletteMapped, &I, sizeof(glm::mat4));
-            }
-
-            // Joint palette SSBO: allocate a tiny buffer (identity matrix) to satisfy smodel.vert.
-            cf.jointPaletteCapacityMatrices = 4;
-
-            VkBufferCreateInfo jbinfo{};
-            jbinfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-            jbinfo.size = static_cast<VkDeviceSize>(cf.jointPaletteCapacityMatrices) * sizeof(glm::mat4);
-            jbinfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-            jbinfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-            if (vkCreateBuffer(ctx.GetDevice(), &jbinfo, nullptr, &cf.jointPaletteBuffer) != VK_SUCCESS)
-                return false;
-
-            VkMemoryRequirements jmemReq{};
-            vkGetBufferMemoryRequirements(ctx.GetDevice(), cf.jointPaletteBuffer, &jmemReq);
-
-            VkMemoryAllocateInfo jmai{};
-            jmai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            jmai.allocationSize = jmemReq.size;
-            uint32_t jmemType = 0;
-            if (!findMemoryType(ctx.GetPhysicalDevice(), jmemReq.memoryTypeBits,
-                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, jmemType))
-                return false;
-            jmai.memoryTypeIndex = jmemType;
-
-            if (vkAllocateMemory(ctx.GetDevice(), &jmai, nullptr, &cf.jointPaletteMemory) != VK_SUCCESS)
-                return false;
-
-            vkBindBufferMemory(ctx.GetDevice(), cf.jointPaletteBuffer, cf.jointPaletteMemory, 0);
-
-            cf.jointPaletteMapped = nullptr;
-            if (vkMapMemory(ctx.GetDevice(), cf.jointPaletteMemory, 0, VK_WHOLE_SIZE, 0, &cf.jointPaletteMapped) != VK_SUCCESS)
-                return false;
-
-            if (cf.jointPaletteMapped)
-            {
-                const glm::mat4 I(1.0f);
-                std::memcpy(cf.jointPaletteMapped, &I, sizeof(glm::mat4));
-            }
-
-            VkDescriptorBufferInfo dbi{};
-            dbi.buffer = cf.buffer;
-            dbi.offset = 0;
-            dbi.range = bufSize;
-
-            VkDescriptorBufferInfo pbi{};
-            pbi.buffer = cf.paletteBuffer;
-            pbi.offset = 0;
-            pbi.range = static_cast<VkDeviceSize>(cf.paletteCapacityMatrices) * sizeof(glm::mat4);
-
-            VkDescriptorBufferInfo jbi{};
-            jbi.buffer = cf.jointPaletteBuffer;
-            jbi.offset = 0;
-            jbi.range = static_cast<VkDeviceSize>(cf.jointPaletteCapacityMatrices) * sizeof(glm::mat4);
-
-            VkWriteDescriptorSet writes[3]{};
-            writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            writes[0].dstSet = cf.set;
-            writes[0].dstBinding = 0;
-            writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            writes[0].descriptorCount = 1;
-            writes[0].pBufferInfo = &dbi;
-
-            writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            writes[1].dstSet = cf.set;
-            writes[1].dstBinding = 1;
-            writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-            writes[1].descriptorCount = 1;
-            writes[1].pBufferInfo = &pbi;
-
-            writes[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            writes[2].dstSet = cf.set;
-            writes[2].dstBinding = 2;
-            writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-            writes[2].descriptorCount = 1;
-            writes[2].pBufferInfo = &jbi;
-
-            vkUpdateDescriptorSets(ctx.GetDevice(), 3, writes, 0, nullptr);
-        }
+            m_cameraFrames[i].set = sets[i];
 
         return true;
     }
 
     void GroundPlaneRenderPassModule::destroyCameraResources()
     {
+        GpuAllocator *allocator = GpuAllocator::find(m_device);
         for (auto &cf : m_cameraFrames)
         {
-            if (cf.jointPaletteMapped && cf.jointPaletteMemory != VK_NULL_HANDLE)
-            {
-                vkUnmapMemory(m_device, cf.jointPaletteMemory);
-                cf.jointPaletteMapped = nullptr;
-            }
-            if (cf.jointPaletteBuffer != VK_NULL_HANDLE)
+            if (allocator)
             {
-                vkDestroyBuffer(m_device, cf.jointPaletteBuffer, nullptr);
-                cf.jointPaletteBuffer = VK_NULL_HANDLE;
-            }
-            if (cf.jointPaletteMemory != VK_NULL_HANDLE)
-            {
-                vkFreeMemory(m_device, cf.jointPaletteMemory, nullptr);
-                cf.jointPaletteMemory = VK_NULL_HANDLE;
-            }
-            cf.jointPaletteCapacityMatrices = 0;
-
-            if (cf.paletteMapped && cf.paletteMemory != VK_NULL_HANDLE)
-            {
-                vkUnmapMemory(m_device, cf.paletteMemory);
-                cf.paletteMapped = nullptr;
-            }
-            if (cf.paletteBuffer != VK_NULL_HANDLE)
-            {
-                vkDestroyBuffer(m_device, cf.paletteBuffer, nullptr);
-                cf.paletteBuffer = VK_NULL_HANDLE;
-            }
-            if (cf.paletteMemory != VK_NULL_HANDLE)
-            {
-                vkFreeMemory(m_device, cf.paletteMemory, nullptr);
-                cf.paletteMemory = VK_NULL_HANDLE;
-            }
-            cf.paletteCapacityMatrices = 0;
-
-            if (cf.buffer != VK_NULL_HANDLE)
-            {
-                vkDestroyBuffer(m_device, cf.buffer, nullptr);
-                cf.buffer = VK_NULL_HANDLE;
-            }
-            if (cf.memory != VK_NULL_HANDLE)
-            {
-                vkFreeMemory(m_device, cf.memory, nullptr);
-                cf.memory = VK_NULL_HANDLE;
+                allocator->destroyBuffer(cf.stagingBuffer, cf.stagingAllocation);
             }
+            cf.stagingCapacity = 0;
+            cf.viewVersion = 0;
+            cf.heightView = VK_NULL_HANDLE;
             cf.set = VK_NULL_HANDLE;
         }
         m_cameraFrames.clear();
@@ -456,78 +250,6 @@ namespace Engine
         }
     }
 
-    bool GroundPlaneRenderPassModule::createInstanceResources(VulkanContext &ctx, size_t frameCount)
-    {
-        destroyInstanceResources();
-        if (frameCount == 0)
-            frameCount = 1;
-
-        m_instanceFrames.resize(frameCount);
-
-        const VkDeviceSize bufSize = sizeof(glm::mat4);
-        for (size_t i = 0; i < frameCount; ++i)
-        {
-            InstanceFrame &fr = m_instanceFrames[i];
-
-            VkBufferCreateInfo binfo{};
-            binfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-            binfo.size = bufSize;
-            binfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-            binfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-            if (vkCreateBuffer(ctx.GetDevice(), &binfo, nullptr, &fr.buffer) != VK_SUCCESS)
-                return false;
-
-            VkMemoryRequirements memReq{};
-            vkGetBufferMemoryRequirements(ctx.GetDevice(), fr.buffer, &memReq);
-
-            VkMemoryAllocateInfo mai{};
-            mai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            mai.allocationSize = memReq.size;
-            uint32_t memType = 0;
-            if (!findMemoryType(ctx.GetPhysicalDevice(), memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memType))
-                return false;
-            mai.memoryTypeIndex = memType;
-
-            if (vkAllocateMemory(ctx.GetDevice(), &mai, nullptr, &fr.memory) != VK_SUCCESS)
-                return false;
-
-            vkBindBufferMemory(ctx.GetDevice(), fr.buffer, fr.memory, 0);
-
-            fr.mapped = nullptr;
-            if (vkMapMemory(ctx.GetDevice(), fr.memory, 0, VK_WHOLE_SIZE, 0, &fr.mapped) != VK_SUCCESS)
-                return false;
-        }
-
-        return true;
-    }
-
-    void GroundPlaneRenderPassModule::destroyInstanceResources()
-    {
-        if (m_device == VK_NULL_HANDLE)
-            return;
-
-        for (auto &fr : m_instanceFrames)
-        {
-            if (fr.mapped && fr.memory != VK_NULL_HANDLE)
-            {
-                vkUnmapMemory(m_device, fr.memory);
-                fr.mapped = nullptr;
-            }
-            if (fr.buffer != VK_NULL_HANDLE)
-            {
-                vkDestroyBuffer(m_device, fr.buffer, nullptr);
-                fr.buffer = VK_NULL_HANDLE;
-            }
-            if (fr.memory != VK_NULL_HANDLE)
-            {
-                vkFreeMemory(m_device, fr.memory, nullptr);
-                fr.memory = VK_NULL_HANDLE;
-            }
-        }
-        m_instanceFrames.clear();
-    }
-
     bool GroundPlaneRenderPassModule::createMaterialResources(VulkanContext &ctx, size_t frameCount)
     {
         destroyMaterialResources();
@@ -616,85 +338,203 @@ namespace Engine
         m_materialSets.clear();
     }
 
-    bool GroundPlaneRenderPassModule::createGeometryResources(VulkanContext &ctx, size_t frameCount)
+    void GroundPlaneRenderPassModule::snapshotHeightfield()
     {
-        destroyGeometryResources();
-        if (frameCount == 0)
-            frameCount = 1;
+        HeightUpload &up = m_upload;
 
-        // Index buffer (shared)
-        const uint16_t indices[6] = {0, 1, 2, 2, 1, 3};
-        if (CreateOrUpdateIndexBuffer(ctx.GetDevice(), ctx.GetPhysicalDevice(), indices, sizeof(indices), m_planeIB) != VK_SUCCESS)
-            return false;
+        // Flat ground: one texel at height 0.
+        if (!m_heightfield || m_heightfield->empty())
+        {
+            if (m_snapshotHasTexture && m_snapshotLayoutRevision == 0)
+                return;
+            up.pending = true;
+            up.recreate = true;
+            up.width = up.depth = 1;
+            up.x = up.z = 0;
+            up.rectWidth = up.rectDepth = 1;
+            up.texels.assign(1, 0.0f);
+            up.origin = glm::vec2(0.0f);
+            up.cellSize = 1.0f;
+            m_snapshotLayoutRevision = 0;
+            m_snapshotHasTexture = true;
+            return;
+        }
 
-        m_planeVB.resize(frameCount);
-        // Initialize vertex buffers with some data.
-        for (size_t i = 0; i < frameCount; ++i)
+        Heightfield &hf = *m_heightfield;
+        Heightfield::Rect dirty = hf.takeDirty();
+        const bool relayout = !m_snapshotHasTexture || hf.layoutRevision() != m_snapshotLayoutRevision;
+        if (!relayout && dirty.empty())
+            return;
+
+        // A previous snapshot not consumed by a frame yet: fold it in by sending everything.
+        if (relayout || up.pending)
         {
-            PlaneVertex verts[4]{};
-            if (CreateOrUpdateVertexBuffer(ctx.GetDevice(), ctx.GetPhysicalDevice(), verts, sizeof(verts), m_planeVB[i]) != VK_SUCCESS)
-                return false;
+            up.recreate = up.recreate || relayout;
+            dirty = Heightfield::Rect{0, 0, hf.width(), hf.depth()};
         }
 
-        return true;
+        up.pending = true;
+        up.width = hf.width();
+        up.depth = hf.depth();
+        up.x = dirty.x;
+        up.z = dirty.z;
+        up.rectWidth = dirty.width;
+        up.rectDepth = dirty.depth;
+        up.texels.resize(static_cast<size_t>(dirty.width) * dirty.depth);
+        for (uint32_t row = 0; row < dirty.depth; ++row)
+        {
+            const float *src = hf.data() + static_cast<size_t>(dirty.z + row) * hf.width() + dirty.x;
+            std::copy(src, src + dirty.width, up.texels.begin() + static_cast<size_t>(row) * dirty.width);
+        }
+        up.origin = hf.origin();
+        up.cellSize = hf.cellSize();
+        m_snapshotLayoutRevision = hf.layoutRevision();
+        m_snapshotHasTexture = true;
     }
 
-    void GroundPlaneRenderPassModule::destroyGeometryResources()
+    void GroundPlaneRenderPassModule::onFrameSnapshot()
     {
-        if (m_device == VK_NULL_HANDLE)
-            return;
+        m_recordEnabled = m_enabled;
 
-        for (auto &vb : m_planeVB)
-            DestroyVertexBuffer(m_device, vb);
-        m_planeVB.clear();
+        if (m_device != VK_NULL_HANDLE)
+            snapshotHeightfield();
+    }
 
-        DestroyIndexBuffer(m_device, m_planeIB);
+    void GroundPlaneRenderPassModule::destroyHeightImage(HeightImage &img)
+    {
+        if (img.view != VK_NULL_HANDLE)
+            vkDestroyImageView(m_device, img.view, nullptr);
+        img.view = VK_NULL_HANDLE;
+        DestroyImage2D(m_device, img.image, img.allocation);
     }
 
-    void GroundPlaneRenderPassModule::updatePlaneForFrame(uint32_t frameIndex)
+    void GroundPlaneRenderPassModule::retireHeightImage(FrameContext &frameCtx)
     {
-        if (m_planeVB.empty())
+        if (m_height.image == VK_NULL_HANDLE)
             return;
 
-        const uint32_t idx = frameIndex % static_cast<uint32_t>(m_planeVB.size());
+        // Earlier frames may still sample it.
+        HeightImage old = m_height;
+        m_height = HeightImage{};
+        if (frameCtx.timeline)
+        {
+            const VkDevice device = m_device;
+            frameCtx.timeline->deferUntil(frameCtx.timelineValue, [device, old]() mutable
+                                          {
+                                              if (old.view != VK_NULL_HANDLE)
+                                                  vkDestroyImageView(device, old.view, nullptr);
+                                              DestroyImage2D(device, old.image, old.allocation); });
+            return;
+        }
+        old.framesLeft = m_frameCount + 1;
+        m_retiredHeights.push_back(old);
+    }
 
-        const float half = std::max(1.0f, m_halfSize);
-        const float tile = std::max(0.001f, m_tileWorldSize);
+    bool GroundPlaneRenderPassModule::uploadHeights(FrameContext &frameCtx, VkCommandBuffer cmd, CameraFrame &frame)
+    {
+        HeightUpload &up = m_upload;
+        if (up.recreate || m_height.image == VK_NULL_HANDLE)
+        {
+            retireHeightImage(frameCtx);
+            m_heightInitialized = false;
+            if (CreateImage2D(m_device, m_physicalDevice, up.width, up.depth, VK_FORMAT_R32_SFLOAT,
+                              VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                              m_height.image, m_height.allocation) != VK_SUCCESS ||
+                CreateImageView2D(m_device, m_height.image, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, m_height.view) != VK_SUCCESS)
+            {
+                destroyHeightImage(m_height);
+                return false;
+            }
+            // A new texture needs every texel.
+            if (up.rectWidth != up.width || up.rectDepth != up.depth)
+                return false;
+        }
 
-        float cx = 0.0f;
-        float cz = 0.0f;
-        if (m_camera)
+        const VkDeviceSize bytes = sizeof(float) * up.texels.size();
+        if (bytes > frame.stagingCapacity)
         {
-            const glm::vec3 p = m_camera->GetPosition();
-            cx = p.x;
-            cz = p.z;
+            GpuAllocator &allocator = GpuAllocator::forDevice(m_device, m_physicalDevice);
+            allocator.destroyBuffer(frame.stagingBuffer, frame.stagingAllocation);
+            frame.stagingCapacity = 0;
+            if (allocator.createBuffer(bytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                       GpuMemoryCategory::Staging, frame.stagingBuffer, frame.stagingAllocation) != VK_SUCCESS ||
+                !frame.stagingAllocation.mapped)
+            {
+                allocator.destroyBuffer(frame.stagingBuffer, frame.stagingAllocation);
+                return false;
+            }
+            frame.stagingCapacity = bytes;
         }
+        std::memcpy(frame.stagingAllocation.mapped, up.texels.data(), static_cast<size_t>(bytes));
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = m_heightInitialized ? VK_ACCESS_SHADER_READ_BIT : 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = m_heightInitialized ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = m_height.image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        vkCmdPipelineBarrier(cmd, m_heightInitialized ? VK_PIPELINE_STAGE_VERTEX_SHADER_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = up.rectWidth;
+        region.bufferImageHeight = up.rectDepth;
+        region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.imageOffset = {static_cast<int32_t>(up.x), static_cast<int32_t>(up.z), 0};
+        region.imageExtent = {up.rectWidth, up.rectDepth, 1};
+        vkCmdCopyBufferToImage(cmd, frame.stagingBuffer, m_height.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        m_heightInitialized = true;
+        m_heightOrigin = up.origin;
+        m_heightCellSize = up.cellSize;
+        return true;
+    }
 
-        const float x0 = cx - half;
-        const float x1 = cx + half;
-        const float z0 = cz - half;
-        const float z1 = cz + half;
+    void GroundPlaneRenderPassModule::recordPrePass(FrameContext &frameCtx, VkCommandBuffer cmd)
+    {
+        if (m_device == VK_NULL_HANDLE || m_cameraFrames.empty())
+            return;
 
-        auto uv = [&](float x, float z) -> glm::vec2
+        for (auto it = m_retiredHeights.begin(); it != m_retiredHeights.end();)
         {
-            return glm::vec2(x / tile, z / tile);
-        };
-
-        PlaneVertex verts[4]{};
-        const glm::vec3 n(0.0f, 1.0f, 0.0f);
-        const glm::vec4 t(1.0f, 0.0f, 0.0f, 1.0f);
+            if (--it->framesLeft == 0)
+            {
+                destroyHeightImage(*it);
+                it = m_retiredHeights.erase(it);
+            }
+            else
+                ++it;
+        }
 
-        verts[0] = {glm::vec3(x0, 0.0f, z0), n, uv(x0, z0), t};
-        verts[1] = {glm::vec3(x1, 0.0f, z0), n, uv(x1, z0), t};
-        verts[2] = {glm::vec3(x0, 0.0f, z1), n, uv(x0, z1), t};
-        verts[3] = {glm::vec3(x1, 0.0f, z1), n, uv(x1, z1), t};
+        if (!m_upload.pending)
+            return;
 
-        (void)CreateOrUpdateVertexBuffer(m_device, m_physicalDevice, verts, sizeof(verts), m_planeVB[idx]);
+        CameraFrame &frame = m_cameraFrames[frameCtx.frameIndex % static_cast<uint32_t>(m_cameraFrames.size())];
+        if (!uploadHeights(frameCtx, cmd, frame))
+        {
+            // Ask for the whole heightfield again next snapshot.
+            m_snapshotHasTexture = false;
+        }
+        m_upload.pending = false;
+        m_upload.recreate = false;
     }
 
     void GroundPlaneRenderPassModule::record(FrameContext &frameCtx, VkCommandBuffer cmd)
     {
-        if (!m_enabled)
+        if (!m_recordEnabled)
             return;
         if (m_device == VK_NULL_HANDLE)
             return;
@@ -702,7 +542,9 @@ namespace Engine
             return;
         if (!m_assets || !m_baseColorTexture.isValid())
             return;
-        if (m_materialSets.empty())
+        if (m_materialSets.empty() || m_cameraFrames.empty())
+            return;
+        if (!m_heightInitialized || !frameCtx.view || frameCtx.viewBuffer == VK_NULL_HANDLE)
             return;
 
         VkViewport vp{0.0f, 0.0f, static_cast<float>(m_extent.width), static_cast<float>(m_extent.height), 0.0f, 1.0f};
@@ -710,67 +552,69 @@ namespace Engine
         vkCmdSetViewport(cmd, 0, 1, &vp);
         vkCmdSetScissor(cmd, 0, 1, &sc);
 
-        // Update camera UBO
-        const uint32_t camIndex = (!m_cameraFrames.empty()) ? (frameCtx.frameIndex % static_cast<uint32_t>(m_cameraFrames.size())) : 0;
-        CameraFrame *camFrame = (!m_cameraFrames.empty()) ? &m_cameraFrames[camIndex] : nullptr;
-        if (camFrame && camFrame->memory != VK_NULL_HANDLE)
+        const uint32_t camIndex = frameCtx.frameIndex % static_cast<uint32_t>(m_cameraFrames.size());
+        CameraFrame &camFrame = m_cameraFrames[camIndex];
+
+        // This slot's previous frame has completed, so its set may point at a new view buffer
+        // (the transient ring grew) or a new height texture.
+        if (camFrame.viewVersion != frameCtx.viewBufferVersion)
         {
-            CameraUBO ubo{};
-            const float aspect = (m_extent.height > 0) ? (static_cast<float>(m_extent.width) / static_cast<float>(m_extent.height)) : 1.0f;
-            if (m_camera)
-            {
-                m_camera->SetAspect(aspect);
-                ubo.view = m_camera->GetViewMatrix();
-                ubo.proj = m_camera->GetProjectionMatrix();
-            }
-            else
-            {
-                glm::mat4 view = glm::lookAt(glm::vec3(0, 0, 3), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
-                glm::mat4 proj = glm::perspective(glm::radians(60.0f), aspect, 0.1f, 100.0f);
-                proj[1][1] *= -1.0f;
-                ubo.view = view;
-                ubo.proj = proj;
-            }
+            VkDescriptorBufferInfo dbi{};
+            dbi.buffer = frameCtx.viewBuffer;
+            dbi.offset = 0;
+            dbi.range = sizeof(GpuViewData);
 
-            void *mapped = nullptr;
-            if (vkMapMemory(m_device, camFrame->memory, 0, sizeof(CameraUBO), 0, &mapped) == VK_SUCCESS && mapped)
-            {
-                std::memcpy(mapped, &ubo, sizeof(CameraUBO));
-                vkUnmapMemory(m_device, camFrame->memory);
-            }
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = camFrame.set;
+            write.dstBinding = 0;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            write.descriptorCount = 1;
+            write.pBufferInfo = &dbi;
+            vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+            camFrame.viewVersion = frameCtx.viewBufferVersion;
         }
 
-        // Update per-frame instance transform (identity)
-        const uint32_t instIndex = (!m_instanceFrames.empty()) ? (frameCtx.frameIndex % static_cast<uint32_t>(m_instanceFrames.size())) : 0;
-        InstanceFrame *instFrame = (!m_instanceFrames.empty()) ? &m_instanceFrames[instIndex] : nullptr;
-        if (!instFrame || !instFrame->mapped)
-            return;
-        const glm::mat4 I(1.0f);
-        std::memcpy(instFrame->mapped, &I, sizeof(glm::mat4));
+        if (camFrame.heightView != m_height.view)
+        {
+            VkDescriptorImageInfo di{};
+            di.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            di.imageView = m_height.view;
+            di.sampler = m_heightSampler;
 
-        // Update plane vertices (centered around camera; UVs in world-space)
-        updatePlaneForFrame(frameCtx.frameIndex);
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = camFrame.set;
+            write.dstBinding = 1;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            write.descriptorCount = 1;
+            write.pImageInfo = &di;
+            vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+            camFrame.heightView = m_height.view;
+        }
 
-        // Push constants: opaque material
-        m_pc.model = glm::mat4(1.0f);
-        m_pc.baseColorFactor = glm::vec4(1.0f);
-        m_pc.materialParams = glm::vec4(0.5f, 0.0f, 0.0f, 0.0f); // alphaCutoff=0.5, alphaMode=Opaque
-        m_pc.nodeInfo = glm::uvec4(0u, 1u, 0u, 0u);
+        // Enough levels for the coarsest one to reach halfSize: level L spans quads/2 * cell * 2^L each way.
+        const uint32_t quads = std::max(8u, (m_gridQuads + 3u) & ~3u);
+        const float baseCell = std::max(0.01f, m_baseCellSize);
+        const float finestHalf = 0.5f * static_cast<float>(quads) * baseCell;
+        const float ratio = std::max(1.0f, std::max(1.0f, m_halfSize) / finestHalf);
+        const uint32_t levels = std::min(kMaxLevels, 1u + static_cast<uint32_t>(std::ceil(std::log2(ratio))));
+
+        PushConstants pc{};
+        pc.cameraPos = glm::vec4(frameCtx.view->position, baseCell);
+        pc.grid = glm::vec4(static_cast<float>(quads), static_cast<float>(levels), 1.0f / std::max(0.001f, m_tileWorldSize), 0.0f);
+        pc.heightfield = glm::vec4(m_heightOrigin, 1.0f / m_heightCellSize, 0.0f);
 
         m_pipeline.bind(cmd);
 
-        VkDescriptorSet camSet = (!m_cameraFrames.empty()) ? m_cameraFrames[camIndex].set : VK_NULL_HANDLE;
         VkDescriptorSet matSet = m_materialSets[frameCtx.frameIndex % static_cast<uint32_t>(m_materialSets.size())];
-        VkDescriptorSet sets[2] = {camSet, matSet};
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline.getLayout(), 0, 2, sets, 0, nullptr);
-        vkCmdPushConstants(cmd, m_pipeline.getLayout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstants), &m_pc);
-
-        const uint32_t vbIndex = frameCtx.frameIndex % static_cast<uint32_t>(m_planeVB.size());
-        VkBuffer vbs[2] = {m_planeVB[vbIndex].buffer, instFrame->buffer};
-        VkDeviceSize offs[2] = {0, 0};
-        vkCmdBindVertexBuffers(cmd, 0, 2, vbs, offs);
-        vkCmdBindIndexBuffer(cmd, m_planeIB.buffer, 0, VK_INDEX_TYPE_UINT16);
-        vkCmdDrawIndexed(cmd, 6, 1, 0, 0, 0);
+        VkDescriptorSet sets[2] = {camFrame.set, matSet};
+        const uint32_t viewOffset = static_cast<uint32_t>(frameCtx.viewOffset);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline.getLayout(), 0, 2, sets, 1, &viewOffset);
+        vkCmdPushConstants(cmd, m_pipeline.getLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &pc);
+
+        // Two triangles per cell, one instance per level.
+        vkCmdDraw(cmd, quads * quads * 6u, levels, 0, 0);
         DrawCallCounter::increment();
     }
 }
@@ -0,0 +1,190 @@
+#include "Engine/HeadlessApplication.h"
+#include "Engine/FrameArena.h"
+#include "Engine/JobSystem.h"
+#include "Engine/MemoryStats.h"
+#include "Engine/Profiler.h"
+#include "Engine/Telemetry.h"
+#include "ECS/ECSContext.h"
+#include "assets/HeadlessAssetManager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace Engine
+{
+    struct HeadlessApplication::Impl
+    {
+        std::unique_ptr<ECS::ECSContext> ecs;
+        std::unique_ptr<HeadlessAssetManager> assets;
+        MemoryStats::Registration ecsMemoryReport; // after ecs: removed before it is destroyed
+        Telemetry::Registration ecsTelemetry;      // likewise
+
+        std::atomic<bool> running{true};
+        float tickRate = 30.0f;
+        uint32_t maxCatchUpTicks = 5;
+        bool realtime = true;
+        uint64_t tickLimit = 0;
+        TickStats stats;
+        Telemetry::Registration tickTelemetry; // after stats: removed before it is destroyed
+    };
+
+    HeadlessApplication::HeadlessApplication()
+        : m_Impl(std::make_unique<Impl>())
+    {
+        // The job system's main thread is the one that creates it: this one, which runs the ticks.
+        JobSystem::get();
+
+        // Fleet monitoring: sinks and interval from STRATO_TELEMETRY_* (nothing is exported without them).
+        Telemetry::configureFromEnvironment();
+
+        m_Impl->ecs = std::make_unique<ECS::ECSContext>();
+        m_Impl->assets = std::make_unique<HeadlessAssetManager>();
+        m_Impl->ecsMemoryReport = MemoryStats::Registration([ecs = m_Impl->ecs.get()](std::vector<MemoryStats::Counter> &out)
+                                                            {
+            const ECS::ECSContext::MemoryUsage usage = ecs->memoryUsage();
+            MemoryStats::Counter c;
+            c.subsystem = "ECS";
+            c.name = "Rows";
+            c.cpuBytes = usage.rowBytes;
+            c.count = usage.storeCount;
+            out.push_back(c);
+            c.name = "Columns";
+            c.cpuBytes = usage.columnBytes;
+            out.push_back(c);
+            c.name = "Entity records";
+            c.cpuBytes = usage.entityRecordBytes;
+            c.count = ecs->entities.capacity();
+            out.push_back(c);
+            c.name = "Commands";
+            c.cpuBytes = usage.commandBytes;
+            c.count = 0;
+            out.push_back(c); });
+
+        // Entities per archetype (largest Config::maxArchetypes by name) for telemetry exports.
+        m_Impl->ecsTelemetry = Telemetry::Registration([ecs = m_Impl->ecs.get()](const Telemetry::Config &config, std::vector<Telemetry::Metric> &out)
+                                                       {
+            uint64_t total = 0;
+            for (ECS::ECSContext::ArchetypeCount &a : ecs->archetypeCounts(config.maxArchetypes))
+            {
+                Telemetry::Metric m;
+                m.name = "ecs_archetype_entities";
+                m.labelKey = "archetype";
+                m.labelValue = std::move(a.components);
+                m.value = a.entities;
+                out.push_back(std::move(m));
+                total += a.entities;
+            }
+            Telemetry::Metric m;
+            m.name = "ecs_entities";
+            m.value = static_cast<double>(total);
+            out.push_back(std::move(m)); });
+
+        // Tick overruns since the previous export ("frame_ms" already carries the tick durations).
+        m_Impl->tickTelemetry = Telemetry::Registration([impl = m_Impl.get(), reported = uint64_t(0)](const Telemetry::Config &, std::vector<Telemetry::Metric> &out) mutable
+                                                        {
+            Telemetry::Metric m;
+            m.name = "dropped_ticks";
+            m.value = static_cast<double>(impl->stats.droppedTicks - reported);
+            reported = impl->stats.droppedTicks;
+            out.push_back(std::move(m)); });
+    }
+
+    HeadlessApplication::~HeadlessApplication()
+    {
+        // The last batch may still be going out.
+        Telemetry::flush();
+    }
+
+    void HeadlessApplication::Run()
+    {
+        using Clock = std::chrono::steady_clock;
+
+        CpuProfiler::setThreadName("Main");
+        m_Impl->running = true;
+        OnStart();
+
+        const float fixedDelta = 1.0f / m_Impl->tickRate;
+        const auto tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(fixedDelta));
+        auto nextTick = Clock::now();
+
+        while (m_Impl->running)
+        {
+            // Main thread scratch (FrameArena) lives for one iteration.
+            FrameArena::local().reset();
+            JobSystem::get().pumpMainThread();
+            m_Impl->assets->updateStreaming();
+
+            // Ticks due now: one, or a bounded catch-up after falling behind.
+            uint32_t due = 1;
+            if (m_Impl->realtime)
+            {
+                const auto now = Clock::now();
+                if (now < nextTick)
+                {
+                    std::this_thread::sleep_until(nextTick);
+                }
+                else
+                {
+                    due = 1 + static_cast<uint32_t>(std::min<Clock::rep>((now - nextTick) / tickDuration, 1 << 20));
+                    if (due > m_Impl->maxCatchUpTicks)
+                    {
+                        // Hitch: drop the backlog rather than spiralling into ever longer iterations.
+                        m_Impl->stats.droppedTicks += due - m_Impl->maxCatchUpTicks;
+                        due = m_Impl->maxCatchUpTicks;
+                        nextTick = now - tickDuration * (due - 1);
+                    }
+                }
+            }
+
+            TimeStep tick{};
+            tick.DeltaSeconds = fixedDelta;
+            tick.FixedDeltaSeconds = fixedDelta;
+            for (uint32_t i = 0; i < due && m_Impl->running; ++i)
+            {
+                const uint64_t start = CpuProfiler::nowNs();
+                {
+                    PERF_SCOPE("FixedUpdate");
+                    OnFixedUpdate(tick);
+                }
+                const float ms = static_cast<float>(CpuProfiler::nowNs() - start) * 1e-6f;
+                CpuProfiler::collectFrame();
+                Telemetry::recordFrame(ms);
+                Telemetry::update();
+
+                TickStats &stats = m_Impl->stats;
+                ++stats.ticks;
+                stats.lastTickMs = ms;
+                stats.maxTickMs = std::max(stats.maxTickMs, ms);
+                ++tick.FixedSteps;
+                nextTick += tickDuration;
+
+                if (m_Impl->tickLimit > 0 && stats.ticks >= m_Impl->tickLimit)
+                    m_Impl->running = false;
+            }
+        }
+
+        OnStop();
+    }
+
+    void HeadlessApplication::SetTickRate(float hz, uint32_t maxCatchUpTicks)
+    {
+        if (hz > 0.0f)
+            m_Impl->tickRate = hz;
+        m_Impl->maxCatchUpTicks = (maxCatchUpTicks > 0) ? maxCatchUpTicks : 1u;
+    }
+
+    float HeadlessApplication::GetTickRate() const { return m_Impl->tickRate; }
+    void HeadlessApplication::SetRealtime(bool realtime) { m_Impl->realtime = realtime; }
+    void HeadlessApplication::SetTickLimit(uint64_t ticks) { m_Impl->tickLimit = ticks; }
+    const HeadlessApplication::TickStats &HeadlessApplication::GetTickStats() const { return m_Impl->stats; }
+
+    ECS::ECSContext &HeadlessApplication::GetECS() { return *m_Impl->ecs; }
+    HeadlessAssetManager &HeadlessApplication::GetAssets() { return *m_Impl->assets; }
+
+    void HeadlessApplication::Close()
+    {
+        m_Impl->running = false;
+    }
+}
@@ -0,0 +1,210 @@
+#include "assets/HeadlessAssetManager.h"
+#include "assets/ModelBuild.h"
+#include "assets/SModelLoader.h"
+#include "Engine/Profiler.h"
+
+#include <iostream>
+#include <utility>
+
+namespace Engine
+{
+    HeadlessAssetManager::HeadlessAssetManager()
+    {
+        m_memoryReport = MemoryStats::Registration([this](std::vector<MemoryStats::Counter> &out)
+                                                   {
+            const MemoryUsage usage = memoryUsage();
+            MemoryStats::Counter c;
+            c.subsystem = "Assets";
+            c.name = "Models";
+            c.cpuBytes = usage.modelCpuBytes;
+            c.count = usage.modelCount;
+            out.push_back(c); });
+
+        m_telemetryReport = Telemetry::Registration([this](const Telemetry::Config &, std::vector<Telemetry::Metric> &out)
+                                                    {
+            m_loadLatency.appendAndReset("asset_load_ms", out);
+            Telemetry::Metric m;
+            m.name = "asset_load_failures";
+            m.value = m_loadFailures;
+            out.push_back(m);
+            m.name = "asset_streams_pending";
+            m.value = m_streamPending;
+            out.push_back(m);
+            m_loadFailures = 0; });
+    }
+
+    HeadlessAssetManager::~HeadlessAssetManager()
+    {
+        // Jobs write into m_streamDecoded; parsing is worth helping with here.
+        JobSystem::get().wait(m_streamJobs, JobPriority::Background);
+    }
+
+    std::unique_ptr<ModelAsset> HeadlessAssetManager::buildModel_Internal(const std::string &path, float bakeRate)
+    {
+        smodel::SModelFileView view;
+        std::string error;
+        if (!smodel::LoadSModelFile(path, view, error))
+        {
+            std::cerr << "[HeadlessAssetManager] " << path << ": " << error << "\n";
+            return nullptr;
+        }
+
+        auto model = std::make_unique<ModelAsset>();
+        if (!buildModelFromView(view, bakeRate, *model, error))
+        {
+            std::cerr << "[HeadlessAssetManager] " << path << ": " << error << "\n";
+            return nullptr;
+        }
+        return model;
+    }
+
+    ModelHandle HeadlessAssetManager::loadModel(const std::string &cookedModelPath)
+    {
+        auto it = m_modelPathCache.find(cookedModelPath);
+        if (it != m_modelPathCache.end() && modelState(it->second) != AssetState::Pending)
+        {
+            addRef(it->second);
+            return it->second;
+        }
+
+        std::unique_ptr<ModelAsset> model = buildModel_Internal(cookedModelPath, m_animationBakeRate);
+        if (!model)
+            return ModelHandle{};
+
+        // A pending async load of the same path gets the result now; its decode is dropped later.
+        if (it != m_modelPathCache.end())
+        {
+            ModelEntry *e = m_models.get(it->second);
+            e->asset = std::move(model);
+            e->state = AssetState::Ready;
+            e->refCount++;
+            m_streamPending--;
+            return it->second;
+        }
+
+        ModelEntry e;
+        e.asset = std::move(model);
+        e.refCount = 1;
+        e.path = cookedModelPath;
+        ModelHandle h;
+        h.id = m_models.insert(std::move(e));
+        h.generation = 1;
+        m_modelPathCache.emplace(cookedModelPath, h);
+        return h;
+    }
+
+    ModelHandle HeadlessAssetManager::loadModelAsync(const std::string &cookedModelPath)
+    {
+        auto it = m_modelPathCache.find(cookedModelPath);
+        if (it != m_modelPathCache.end())
+        {
+            addRef(it->second);
+            return it->second;
+        }
+
+        ModelEntry e;
+        e.refCount = 1;
+        e.path = cookedModelPath;
+        e.state = AssetState::Pending;
+        const uint64_t id = m_models.insert(std::move(e));
+
+        ModelHandle h;
+        h.id = id;
+        h.generation = 1;
+        m_modelPathCache.emplace(cookedModelPath, h);
+        m_streamPending++;
+
+        JobSystem::get().submit([this, id, path = cookedModelPath, bakeRate = m_animationBakeRate, requestNs = CpuProfiler::nowNs()]
+                                {
+                                    Decoded done;
+                                    done.id = id;
+                                    done.requestNs = requestNs;
+                                    done.asset = buildModel_Internal(path, bakeRate);
+                                    std::lock_guard<std::mutex> lock(m_streamMutex);
+                                    m_streamDecoded.push_back(std::move(done)); },
+                                JobPriority::Background, &m_streamJobs);
+        return h;
+    }
+
+    void HeadlessAssetManager::updateStreaming()
+    {
+        std::vector<Decoded> decoded;
+        {
+            std::lock_guard<std::mutex> lock(m_streamMutex);
+            decoded.swap(m_streamDecoded);
+        }
+
+        for (Decoded &d : decoded)
+        {
+            // Already satisfied by a synchronous loadModel() of the same path.
+            ModelEntry *e = m_models.find(d.id);
+            if (!e || e->state != AssetState::Pending)
+                continue;
+
+            m_streamPending--;
+            if (d.asset)
+            {
+                e->asset = std::move(d.asset);
+                e->state = AssetState::Ready;
+                m_loadLatency.record(static_cast<float>(CpuProfiler::nowNs() - d.requestNs) * 1e-6f);
+                continue;
+            }
+
+            // Failed: a later load of the path tries again.
+            e->state = AssetState::Failed;
+            ++m_loadFailures;
+            auto cached = m_modelPathCache.find(e->path);
+            if (cached != m_modelPathCache.end() && cached->second.id == d.id)
+                m_modelPathCache.erase(cached);
+        }
+    }
+
+    ModelAsset *HeadlessAssetManager::getModel(ModelHandle h)
+    {
+        ModelEntry *e = m_models.get(h);
+        return e ? e->asset.get() : nullptr;
+    }
+
+    AssetState HeadlessAssetManager::modelState(ModelHandle h) const
+    {
+        const ModelEntry *e = m_models.get(h);
+        return e ? e->state : AssetState::Missing;
+    }
+
+    void HeadlessAssetManager::addRef(ModelHandle h)
+    {
+        if (ModelEntry *e = m_models.get(h))
+            e->refCount++;
+    }
+
+    void HeadlessAssetManager::release(ModelHandle h)
+    {
+        ModelEntry *e = m_models.get(h);
+        if (e && e->refCount > 0)
+            e->refCount--;
+    }
+
+    void HeadlessAssetManager::garbageCollect()
+    {
+        m_models.forEach([&](uint64_t id, ModelEntry &e)
+                         {
+            if (e.refCount != 0 || e.state == AssetState::Pending)
+                return;
+            auto cached = m_modelPathCache.find(e.path);
+            if (cached != m_modelPathCache.end() && cached->second.id == id)
+                m_modelPathCache.erase(cached);
+            m_models.erase(id); });
+    }
+
+    HeadlessAssetManager::MemoryUsage HeadlessAssetManager::memoryUsage() const
+    {
+        MemoryUsage usage{};
+        m_models.forEach([&](uint64_t, const ModelEntry &e)
+                         {
+            if (!e.asset)
+                return;
+            usage.modelCount++;
+            usage.modelCpuBytes += e.asset->cpuBytes(); });
+        return usage;
+    }
+}
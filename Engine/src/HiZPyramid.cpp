@@ -0,0 +1,330 @@
+#include "Engine/HiZPyramid.h"
+#include "Engine/VulkanContext.h"
+#include "Engine/Pipeline.h"
+#include "Engine/PipelineCache.h"
+#include "utils/ImageUtils.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace Engine
+{
+    namespace
+    {
+        constexpr uint32_t kGroupSize = 8; // local_size_x/y in hiz_build.comp
+        constexpr VkFormat kFormat = VK_FORMAT_R32_SFLOAT;
+
+        uint32_t halfUp(uint32_t v) { return std::max(1u, (v + 1u) / 2u); }
+    }
+
+    bool HiZPyramid::create(VulkanContext &ctx, uint32_t frameCount)
+    {
+        destroy();
+
+        m_device = ctx.GetDevice();
+        m_physicalDevice = ctx.GetPhysicalDevice();
+        m_frameCount = std::max(1u, frameCount);
+
+        VkFormatProperties props{};
+        vkGetPhysicalDeviceFormatProperties(m_physicalDevice, kFormat, &props);
+        const VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+        if ((props.optimalTilingFeatures & needed) != needed)
+        {
+            std::cerr << "[HiZPyramid] occlusion culling disabled: R32_SFLOAT storage images unsupported\n";
+            return false;
+        }
+
+        // Missing SPIR-V is not an error: the depth pre-pass still runs, nothing is occlusion-culled.
+        VkShaderModule module = VK_NULL_HANDLE;
+        try
+        {
+            module = Pipeline::createShaderModuleFromFile(m_device, "shaders/hiz_build.comp.spv");
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[HiZPyramid] occlusion culling disabled: " << e.what() << "\n";
+            return false;
+        }
+
+        VkDescriptorSetLayoutBinding bindings[2]{};
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[0].descriptorCount = 1;
+        bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        bindings[1].descriptorCount = 1;
+        bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutCreateInfo dsl{};
+        dsl.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        dsl.bindingCount = 2;
+        dsl.pBindings = bindings;
+
+        VkPushConstantRange pcRange{};
+        pcRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pcRange.size = sizeof(PushConstants);
+
+        bool ok = vkCreateDescriptorSetLayout(m_device, &dsl, nullptr, &m_setLayout) == VK_SUCCESS;
+        if (ok)
+        {
+            VkPipelineLayoutCreateInfo pl{};
+            pl.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            pl.setLayoutCount = 1;
+            pl.pSetLayouts = &m_setLayout;
+            pl.pushConstantRangeCount = 1;
+            pl.pPushConstantRanges = &pcRange;
+            ok = vkCreatePipelineLayout(m_device, &pl, nullptr, &m_pipelineLayout) == VK_SUCCESS;
+        }
+        if (ok)
+        {
+            VkComputePipelineCreateInfo ci{};
+            ci.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            ci.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            ci.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+            ci.stage.module = module;
+            ci.stage.pName = "main";
+            ci.layout = m_pipelineLayout;
+            ok = vkCreateComputePipelines(m_device, PipelineCache::get(m_device), 1, &ci, nullptr, &m_pipeline) == VK_SUCCESS;
+            if (!ok)
+                m_pipeline = VK_NULL_HANDLE;
+        }
+        vkDestroyShaderModule(m_device, module, nullptr);
+
+        if (ok)
+        {
+            // Culling shaders only texelFetch, so filtering never applies.
+            VkSamplerCreateInfo si{};
+            si.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+            si.magFilter = VK_FILTER_NEAREST;
+            si.minFilter = VK_FILTER_NEAREST;
+            si.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            si.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            si.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            si.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            si.maxLod = VK_LOD_CLAMP_NONE;
+            ok = vkCreateSampler(m_device, &si, nullptr, &m_sampler) == VK_SUCCESS;
+        }
+
+        if (!ok)
+        {
+            std::cerr << "[HiZPyramid] occlusion culling disabled: failed to create compute resources\n";
+            destroy();
+            return false;
+        }
+        m_frames.resize(m_frameCount);
+        return true;
+    }
+
+    void HiZPyramid::destroy()
+    {
+        if (m_device == VK_NULL_HANDLE)
+            return;
+
+        destroyFrames();
+        m_frames.clear();
+
+        if (m_pipeline != VK_NULL_HANDLE)
+            vkDestroyPipeline(m_device, m_pipeline, nullptr);
+        if (m_pipelineLayout != VK_NULL_HANDLE)
+            vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+        if (m_setLayout != VK_NULL_HANDLE)
+            vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+        if (m_sampler != VK_NULL_HANDLE)
+            vkDestroySampler(m_device, m_sampler, nullptr);
+
+        m_pipeline = VK_NULL_HANDLE;
+        m_pipelineLayout = VK_NULL_HANDLE;
+        m_setLayout = VK_NULL_HANDLE;
+        m_sampler = VK_NULL_HANDLE;
+        m_depthExtent = {};
+        m_extent = {};
+        m_mipCount = 0;
+        m_device = VK_NULL_HANDLE;
+        m_physicalDevice = VK_NULL_HANDLE;
+    }
+
+    void HiZPyramid::destroyFrames()
+    {
+        for (Frame &f : m_frames)
+        {
+            for (VkImageView v : f.levelViews)
+                vkDestroyImageView(m_device, v, nullptr);
+            if (f.view != VK_NULL_HANDLE)
+                vkDestroyImageView(m_device, f.view, nullptr);
+            DestroyImage2D(m_device, f.image, f.allocation);
+            f = Frame{};
+        }
+        if (m_pool != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(m_device, m_pool, nullptr); // frees the sets
+        m_pool = VK_NULL_HANDLE;
+    }
+
+    bool HiZPyramid::resize(VkExtent2D depthExtent)
+    {
+        if (m_pipeline == VK_NULL_HANDLE)
+            return false;
+        if (depthExtent.width == m_depthExtent.width && depthExtent.height == m_depthExtent.height && m_mipCount > 0)
+            return true;
+
+        destroyFrames();
+        m_depthExtent = depthExtent;
+        m_extent = {halfUp(depthExtent.width), halfUp(depthExtent.height)};
+        m_mipCount = 1;
+        for (uint32_t w = m_extent.width, h = m_extent.height; w > 1 || h > 1; w = halfUp(w), h = halfUp(h))
+            ++m_mipCount;
+
+        const uint32_t sets = m_frameCount * m_mipCount;
+        VkDescriptorPoolSize sizes[2]{};
+        sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        sizes[0].descriptorCount = sets;
+        sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        sizes[1].descriptorCount = sets;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = sets;
+        poolInfo.poolSizeCount = 2;
+        poolInfo.pPoolSizes = sizes;
+        bool ok = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_pool) == VK_SUCCESS;
+
+        for (size_t i = 0; ok && i < m_frames.size(); ++i)
+        {
+            Frame &f = m_frames[i];
+            ok = CreateImage2D(m_device, m_physicalDevice, m_extent.width, m_extent.height, kFormat,
+                               VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, m_mipCount,
+                               f.image, f.allocation, GpuMemoryCategory::RenderTarget) == VK_SUCCESS;
+
+            VkImageViewCreateInfo vi{};
+            vi.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            vi.image = f.image;
+            vi.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            vi.format = kFormat;
+            vi.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            vi.subresourceRange.levelCount = m_mipCount;
+            vi.subresourceRange.layerCount = 1;
+            ok = ok && vkCreateImageView(m_device, &vi, nullptr, &f.view) == VK_SUCCESS;
+
+            f.levelViews.assign(m_mipCount, VK_NULL_HANDLE);
+            vi.subresourceRange.levelCount = 1;
+            for (uint32_t level = 0; ok && level < m_mipCount; ++level)
+            {
+                vi.subresourceRange.baseMipLevel = level;
+                ok = vkCreateImageView(m_device, &vi, nullptr, &f.levelViews[level]) == VK_SUCCESS;
+            }
+            if (!ok)
+                break;
+
+            f.levelSets.assign(m_mipCount, VK_NULL_HANDLE);
+            std::vector<VkDescriptorSetLayout> layouts(m_mipCount, m_setLayout);
+            VkDescriptorSetAllocateInfo ai{};
+            ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            ai.descriptorPool = m_pool;
+            ai.descriptorSetCount = m_mipCount;
+            ai.pSetLayouts = layouts.data();
+            ok = vkAllocateDescriptorSets(m_device, &ai, f.levelSets.data()) == VK_SUCCESS;
+            if (!ok)
+                break;
+
+            // Levels above 0 always read the level below; level 0's source is written per frame.
+            for (uint32_t level = 0; level < m_mipCount; ++level)
+            {
+                VkDescriptorImageInfo src{m_sampler, level > 0 ? f.levelViews[level - 1] : VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL};
+                VkDescriptorImageInfo dst{VK_NULL_HANDLE, f.levelViews[level], VK_IMAGE_LAYOUT_GENERAL};
+
+                VkWriteDescriptorSet writes[2]{};
+                writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[0].dstSet = f.levelSets[level];
+                writes[0].dstBinding = 0;
+                writes[0].descriptorCount = 1;
+                writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                writes[0].pImageInfo = &src;
+                writes[1] = writes[0];
+                writes[1].dstBinding = 1;
+                writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+                writes[1].pImageInfo = &dst;
+                if (level > 0)
+                    vkUpdateDescriptorSets(m_device, 2, writes, 0, nullptr);
+                else
+                    vkUpdateDescriptorSets(m_device, 1, &writes[1], 0, nullptr);
+            }
+        }
+
+        if (!ok)
+        {
+            std::cerr << "[HiZPyramid] failed to create " << m_extent.width << "x" << m_extent.height << " pyramid\n";
+            destroyFrames();
+            m_depthExtent = {};
+            m_extent = {};
+            m_mipCount = 0;
+            return false;
+        }
+        return true;
+    }
+
+    VkImageView HiZPyramid::view(uint32_t frameIndex) const
+    {
+        if (m_frames.empty() || m_mipCount == 0)
+            return VK_NULL_HANDLE;
+        return m_frames[frameIndex % m_frames.size()].view;
+    }
+
+    void HiZPyramid::record(VkCommandBuffer cmd, uint32_t frameIndex, VkImageView depthView)
+    {
+        if (!ready() || m_mipCount == 0 || depthView == VK_NULL_HANDLE)
+            return;
+
+        Frame &f = m_frames[frameIndex % m_frames.size()];
+
+        // The slot's previous frame has completed, so its set is idle and can point at this image.
+        VkDescriptorImageInfo depthInfo{m_sampler, depthView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = f.levelSets[0];
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo = &depthInfo;
+        vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+
+        // Earlier frames' culling reads on this queue finish before the levels are overwritten.
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.oldLayout = f.initialized ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = f.image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, m_mipCount, 0, 1};
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &barrier);
+        f.initialized = true;
+
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+
+        VkExtent2D src = m_depthExtent;
+        VkExtent2D dst = m_extent;
+        for (uint32_t level = 0; level < m_mipCount; ++level)
+        {
+            const PushConstants pc{src.width, src.height, dst.width, dst.height};
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &f.levelSets[level], 0, nullptr);
+            vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pc);
+            vkCmdDispatch(cmd, (dst.width + kGroupSize - 1) / kGroupSize, (dst.height + kGroupSize - 1) / kGroupSize, 1);
+
+            // The next level (or the culling shaders after the last one) reads this one.
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+            barrier.subresourceRange.baseMipLevel = level;
+            barrier.subresourceRange.levelCount = 1;
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+            src = dst;
+            dst = {halfUp(dst.width), halfUp(dst.height)};
+        }
+    }
+}
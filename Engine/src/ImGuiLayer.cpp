@@ -1,5 +1,6 @@
 #include "Engine/ImGuiLayer.h"
 #include "Engine/VulkanContext.h"
+#include "Engine/PipelineCache.h"
 #include "Engine/Window.h"
 
 #include <imgui.h>
@@ -49,7 +50,7 @@ namespace Engine
         initInfo.Device = ctx.GetDevice();
         initInfo.QueueFamily = ctx.GetGraphicsQueueFamilyIndex();
         initInfo.Queue = ctx.GetGraphicsQueue();
-        initInfo.PipelineCache = VK_NULL_HANDLE;
+        initInfo.PipelineCache = PipelineCache::get(ctx.GetDevice());
         initInfo.DescriptorPool = m_descriptorPool;
         initInfo.Subpass = 0;
         initInfo.MinImageCount = imageCount;
@@ -1,27 +1,9 @@
 #include "utils/ImageUtils.h"
 #include <cstring>
-#include <stdexcept>
+#include <algorithm>
 
 namespace Engine
 {
-    // ============================================================
-    // Memory helper
-    // ============================================================
-
-    static uint32_t findMemoryType(VkPhysicalDevice phys, uint32_t typeBits, VkMemoryPropertyFlags props)
-    {
-        VkPhysicalDeviceMemoryProperties memProps{};
-        vkGetPhysicalDeviceMemoryProperties(phys, &memProps);
-
-        for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
-        {
-            if ((typeBits & (1u << i)) && (memProps.memoryTypes[i].propertyFlags & props) == props)
-                return i;
-        }
-
-        throw std::runtime_error("ImageUtils: failed to find suitable memory type");
-    }
-
     // ============================================================
     // Staging buffer
     // ============================================================
@@ -36,51 +18,14 @@ namespace Engine
         if (!dataBytes || dataSize == 0)
             return VK_ERROR_INITIALIZATION_FAILED;
 
-        VkBufferCreateInfo bi{};
-        bi.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        bi.size = dataSize;
-        bi.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-        VkResult r = vkCreateBuffer(device, &bi, nullptr, &out.buffer);
+        VkResult r = GpuAllocator::forDevice(device, physicalDevice)
+                         .createBuffer(dataSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                       GpuMemoryCategory::Staging, out.buffer, out.allocation);
         if (r != VK_SUCCESS)
             return r;
 
-        VkMemoryRequirements req{};
-        vkGetBufferMemoryRequirements(device, out.buffer, &req);
-
-        VkMemoryAllocateInfo ai{};
-        ai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        ai.allocationSize = req.size;
-        ai.memoryTypeIndex = findMemoryType(
-            physicalDevice, req.memoryTypeBits,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-        r = vkAllocateMemory(device, &ai, nullptr, &out.memory);
-        if (r != VK_SUCCESS)
-        {
-            vkDestroyBuffer(device, out.buffer, nullptr);
-            out.buffer = VK_NULL_HANDLE;
-            return r;
-        }
-
-        r = vkBindBufferMemory(device, out.buffer, out.memory, 0);
-        if (r != VK_SUCCESS)
-        {
-            vkDestroyBuffer(device, out.buffer, nullptr);
-            vkFreeMemory(device, out.memory, nullptr);
-            out.buffer = VK_NULL_HANDLE;
-            out.memory = VK_NULL_HANDLE;
-            return r;
-        }
-
-        void *mapped = nullptr;
-        r = vkMapMemory(device, out.memory, 0, dataSize, 0, &mapped);
-        if (r != VK_SUCCESS)
-            return r;
-
-        std::memcpy(mapped, dataBytes, static_cast<size_t>(dataSize));
-        vkUnmapMemory(device, out.memory);
+        std::memcpy(out.allocation.mapped, dataBytes, static_cast<size_t>(dataSize));
 
         out.size = dataSize;
         return VK_SUCCESS;
@@ -88,15 +33,9 @@ namespace Engine
 
     void DestroyStagingBuffer(VkDevice device, StagingBufferHandle &h)
     {
-        if (h.buffer != VK_NULL_HANDLE)
+        if (GpuAllocator *allocator = GpuAllocator::find(device))
         {
-            vkDestroyBuffer(device, h.buffer, nullptr);
-            h.buffer = VK_NULL_HANDLE;
-        }
-        if (h.memory != VK_NULL_HANDLE)
-        {
-            vkFreeMemory(device, h.memory, nullptr);
-            h.memory = VK_NULL_HANDLE;
+            allocator->destroyBuffer(h.buffer, h.allocation);
         }
         h.size = 0;
     }
@@ -118,6 +57,7 @@ namespace Engine
         ctx.queue = queue;
         ctx.pendingStaging.clear();
         ctx.begun = false;
+        // queueFamilies / transferOnly are configured by the caller and left untouched.
 
         // Allocate one primary command buffer
         VkCommandBufferAllocateInfo alloc{};
@@ -151,25 +91,15 @@ namespace Engine
         if (!ctx.begun || ctx.cmd == VK_NULL_HANDLE)
             return false;
 
-        VkResult r = vkEndCommandBuffer(ctx.cmd);
-        if (r != VK_SUCCESS)
-            return false;
-
         // Fence so we can wait for completion (better than queueWaitIdle spam)
         VkFence fence = VK_NULL_HANDLE;
         VkFenceCreateInfo fi{};
         fi.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        r = vkCreateFence(ctx.device, &fi, nullptr, &fence);
+        VkResult r = vkCreateFence(ctx.device, &fi, nullptr, &fence);
         if (r != VK_SUCCESS)
             return false;
 
-        VkSubmitInfo submit{};
-        submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submit.commandBufferCount = 1;
-        submit.pCommandBuffers = &ctx.cmd;
-
-        r = vkQueueSubmit(ctx.queue, 1, &submit, fence);
-        if (r != VK_SUCCESS)
+        if (!SubmitUploadContext(ctx, VK_NULL_HANDLE, 0, fence))
         {
             vkDestroyFence(ctx.device, fence, nullptr);
             return false;
@@ -182,16 +112,134 @@ namespace Engine
         if (r != VK_SUCCESS)
             return false;
 
+        ReleaseUploadContext(ctx);
+        return true;
+    }
+
+    bool SubmitUploadContext(
+        UploadContext &ctx,
+        VkSemaphore timeline,
+        uint64_t signalValue,
+        VkFence fence,
+        std::mutex *queueMutex)
+    {
+        if (!ctx.begun || ctx.cmd == VK_NULL_HANDLE)
+            return false;
+
+        VkResult r = vkEndCommandBuffer(ctx.cmd);
+        if (r != VK_SUCCESS)
+            return false;
+
+        VkSubmitInfo submit{};
+        submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit.commandBufferCount = 1;
+        submit.pCommandBuffers = &ctx.cmd;
+
+        VkTimelineSemaphoreSubmitInfoKHR timelineInfo{};
+        if (timeline != VK_NULL_HANDLE)
+        {
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+            timelineInfo.signalSemaphoreValueCount = 1;
+            timelineInfo.pSignalSemaphoreValues = &signalValue;
+            submit.pNext = &timelineInfo;
+            submit.signalSemaphoreCount = 1;
+            submit.pSignalSemaphores = &timeline;
+        }
+
+        if (queueMutex)
+        {
+            std::lock_guard<std::mutex> lock(*queueMutex);
+            r = vkQueueSubmit(ctx.queue, 1, &submit, fence);
+        }
+        else
+        {
+            r = vkQueueSubmit(ctx.queue, 1, &submit, fence);
+        }
+        return r == VK_SUCCESS;
+    }
+
+    void ReleaseUploadContext(UploadContext &ctx)
+    {
         // Now safe to destroy all staging buffers
         for (auto &sb : ctx.pendingStaging)
             DestroyStagingBuffer(ctx.device, sb);
         ctx.pendingStaging.clear();
+        DestroyStagingBuffer(ctx.device, ctx.stagingArena);
+        ctx.stagingHead = 0;
 
         // Free command buffer
-        vkFreeCommandBuffers(ctx.device, ctx.commandPool, 1, &ctx.cmd);
+        if (ctx.cmd != VK_NULL_HANDLE)
+            vkFreeCommandBuffers(ctx.device, ctx.commandPool, 1, &ctx.cmd);
         ctx.cmd = VK_NULL_HANDLE;
         ctx.begun = false;
+    }
+
+    // ============================================================
+    // Staging arena
+    // ============================================================
+
+    // Satisfies buffer->image copy offsets (multiple of 4 and of the texel size, up to 16-byte texels).
+    static constexpr VkDeviceSize kStagingAlignment = 16;
+    static constexpr VkDeviceSize kMinStagingChunk = 4ull * 1024ull * 1024ull;
+
+    static VkDeviceSize alignStaging(VkDeviceSize v)
+    {
+        return (v + kStagingAlignment - 1) & ~(kStagingAlignment - 1);
+    }
+
+    VkDeviceSize StagingFootprint(VkDeviceSize dataSize)
+    {
+        return alignStaging(dataSize);
+    }
+
+    bool ReserveStaging(UploadContext &ctx, VkDeviceSize bytes)
+    {
+        if (ctx.stagingArena.buffer != VK_NULL_HANDLE && alignStaging(ctx.stagingHead) + bytes <= ctx.stagingArena.size)
+            return true;
+
+        // Retire the current chunk (its copies are already recorded) or drop it if unused.
+        if (ctx.stagingArena.buffer != VK_NULL_HANDLE)
+        {
+            if (ctx.stagingHead > 0)
+                ctx.pendingStaging.push_back(ctx.stagingArena);
+            else
+                DestroyStagingBuffer(ctx.device, ctx.stagingArena);
+            ctx.stagingArena = StagingBufferHandle{};
+        }
+        ctx.stagingHead = 0;
+
+        const VkDeviceSize size = std::max(alignStaging(bytes), kMinStagingChunk);
+        StagingBufferHandle chunk{};
+        VkResult r = GpuAllocator::forDevice(ctx.device, ctx.physicalDevice)
+                         .createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                       GpuMemoryCategory::Staging, chunk.buffer, chunk.allocation);
+        if (r != VK_SUCCESS)
+            return false;
 
+        chunk.size = size;
+        ctx.stagingArena = chunk;
+        return true;
+    }
+
+    bool StageUpload(
+        UploadContext &ctx,
+        const void *dataBytes,
+        VkDeviceSize dataSize,
+        VkBuffer &outBuffer,
+        VkDeviceSize &outOffset)
+    {
+        if (!dataBytes || dataSize == 0)
+            return false;
+        if (!ReserveStaging(ctx, dataSize))
+            return false;
+
+        const VkDeviceSize offset = alignStaging(ctx.stagingHead);
+        std::memcpy(static_cast<uint8_t *>(ctx.stagingArena.allocation.mapped) + offset, dataBytes, static_cast<size_t>(dataSize));
+        ctx.stagingHead = offset + dataSize;
+
+        outBuffer = ctx.stagingArena.buffer;
+        outOffset = offset;
         return true;
     }
 
@@ -207,9 +255,10 @@ namespace Engine
         VkFormat format,
         VkImageUsageFlags usage,
         VkImage &outImage,
-        VkDeviceMemory &outMemory)
+        GpuAllocation &outAllocation,
+        GpuMemoryCategory category)
     {
-        return CreateImage2D(device, physicalDevice, width, height, format, usage, 1u, outImage, outMemory);
+        return CreateImage2D(device, physicalDevice, width, height, format, usage, 1u, outImage, outAllocation, category);
     }
 
     VkResult CreateImage2D(
@@ -221,7 +270,8 @@ namespace Engine
         VkImageUsageFlags usage,
         uint32_t mipLevels,
         VkImage &outImage,
-        VkDeviceMemory &outMemory)
+        GpuAllocation &outAllocation,
+        GpuMemoryCategory category)
     {
         VkImageCreateInfo ii{};
         ii.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -238,37 +288,21 @@ namespace Engine
         ii.samples = VK_SAMPLE_COUNT_1_BIT;
         ii.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        VkResult r = vkCreateImage(device, &ii, nullptr, &outImage);
-        if (r != VK_SUCCESS)
-            return r;
-
-        VkMemoryRequirements req{};
-        vkGetImageMemoryRequirements(device, outImage, &req);
-
-        VkMemoryAllocateInfo ai{};
-        ai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        ai.allocationSize = req.size;
-        ai.memoryTypeIndex = findMemoryType(physicalDevice, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        return GpuAllocator::forDevice(device, physicalDevice)
+            .createImage(ii, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, category, outImage, outAllocation);
+    }
 
-        r = vkAllocateMemory(device, &ai, nullptr, &outMemory);
-        if (r != VK_SUCCESS)
+    void DestroyImage2D(VkDevice device, VkImage &image, GpuAllocation &allocation)
+    {
+        if (GpuAllocator *allocator = GpuAllocator::find(device))
         {
-            vkDestroyImage(device, outImage, nullptr);
-            outImage = VK_NULL_HANDLE;
-            return r;
+            allocator->destroyImage(image, allocation);
         }
-
-        r = vkBindImageMemory(device, outImage, outMemory, 0);
-        if (r != VK_SUCCESS)
+        else if (image != VK_NULL_HANDLE)
         {
-            vkDestroyImage(device, outImage, nullptr);
-            vkFreeMemory(device, outMemory, nullptr);
-            outImage = VK_NULL_HANDLE;
-            outMemory = VK_NULL_HANDLE;
-            return r;
+            vkDestroyImage(device, image, nullptr);
+            image = VK_NULL_HANDLE;
         }
-
-        return VK_SUCCESS;
     }
 
     VkResult CreateImageView2D(
@@ -310,6 +344,7 @@ namespace Engine
 
     // Minimal barrier config to support our common transitions.
     static void fillBarrierMasks(
+        bool transferOnly,
         VkImageLayout oldLayout,
         VkImageLayout newLayout,
         VkAccessFlags &outSrcAccess,
@@ -337,6 +372,13 @@ namespace Engine
             outDstAccess = VK_ACCESS_SHADER_READ_BIT;
             outSrcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
             outDstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            if (transferOnly)
+            {
+                // Fragment stages don't exist on a transfer queue. The image is only sampled
+                // after the host has seen the submission complete, so only the layout matters here.
+                outDstAccess = 0;
+                outDstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+            }
         }
         else
         {
@@ -353,7 +395,8 @@ namespace Engine
         VkImage image,
         VkImageLayout oldLayout,
         VkImageLayout newLayout,
-        VkImageAspectFlags aspectFlags)
+        VkImageAspectFlags aspectFlags,
+        uint32_t levelCount)
     {
         VkImageMemoryBarrier barrier{};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -365,13 +408,13 @@ namespace Engine
 
         barrier.subresourceRange.aspectMask = aspectFlags;
         barrier.subresourceRange.baseMipLevel = 0;
-        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.levelCount = (levelCount == 0) ? 1u : levelCount;
         barrier.subresourceRange.baseArrayLayer = 0;
         barrier.subresourceRange.layerCount = 1;
 
         VkPipelineStageFlags srcStage, dstStage;
         VkAccessFlags srcAccess, dstAccess;
-        fillBarrierMasks(oldLayout, newLayout, srcAccess, dstAccess, srcStage, dstStage);
+        fillBarrierMasks(ctx.transferOnly, oldLayout, newLayout, srcAccess, dstAccess, srcStage, dstStage);
 
         barrier.srcAccessMask = srcAccess;
         barrier.dstAccessMask = dstAccess;
@@ -391,15 +434,17 @@ namespace Engine
         VkBuffer buffer,
         VkImage image,
         uint32_t width,
-        uint32_t height)
+        uint32_t height,
+        uint32_t mipLevel,
+        VkDeviceSize bufferOffset)
     {
         VkBufferImageCopy region{};
-        region.bufferOffset = 0;
+        region.bufferOffset = bufferOffset;
         region.bufferRowLength = 0;
         region.bufferImageHeight = 0;
 
         region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.mipLevel = mipLevel;
         region.imageSubresource.baseArrayLayer = 0;
         region.imageSubresource.layerCount = 1;
 
@@ -427,6 +472,8 @@ namespace Engine
             return false;
         if (mipLevels <= 1)
             return true;
+        if (ctx.transferOnly)
+            return false; // vkCmdBlitImage needs a graphics queue
 
         VkFormatProperties props{};
         vkGetPhysicalDeviceFormatProperties(ctx.physicalDevice, format, &props);
@@ -0,0 +1,787 @@
+#include "Engine/ImpostorRenderPassModule.h"
+#include "Engine/VulkanContext.h"
+#include "Engine/SwapChain.h"
+#include "Engine/SModelRenderer.h"
+#include "Engine/GpuProfiler.h"
+#include "Engine/PerformanceMonitor.h"
+#include "assets/ModelAsset.h"
+#include "assets/MeshAsset.h"
+#include "assets/MaterialAsset.h"
+#include "utils/BufferUtils.h"
+#include "utils/ImageUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace Engine
+{
+    namespace
+    {
+        constexpr VkFormat kAtlasFormat = VK_FORMAT_R8G8B8A8_SRGB; // smodel.frag writes linear color
+        constexpr float kTwoPi = 6.28318530718f;
+
+        // Cooked bounds are bind-pose; a little margin keeps animated limbs inside their cell.
+        constexpr float kSpritePadding = 1.1f;
+
+        VkFormat findBakeDepthFormat(VkPhysicalDevice phys)
+        {
+            const VkFormat candidates[] = {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM};
+            for (VkFormat f : candidates)
+            {
+                VkFormatProperties props{};
+                vkGetPhysicalDeviceFormatProperties(phys, f, &props);
+                if (props.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+                    return f;
+            }
+            return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    ImpostorRenderPassModule::BakeResources::~BakeResources()
+    {
+        if (device == VK_NULL_HANDLE)
+            return;
+        if (framebuffer != VK_NULL_HANDLE)
+            vkDestroyFramebuffer(device, framebuffer, nullptr);
+        if (depthView != VK_NULL_HANDLE)
+            vkDestroyImageView(device, depthView, nullptr);
+        DestroyImage2D(device, depthImage, depthAllocation);
+        if (pool != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(device, pool, nullptr);
+        for (size_t i = 0; i < buffers.size(); ++i)
+            DestroyBuffer(device, buffers[i], allocations[i]);
+        renderer.reset(); // its pipelines reference renderPass
+        if (renderPass != VK_NULL_HANDLE)
+            vkDestroyRenderPass(device, renderPass, nullptr);
+    }
+
+    ImpostorRenderPassModule::~ImpostorRenderPassModule()
+    {
+        // resources freed in onDestroy
+    }
+
+    void ImpostorRenderPassModule::setInstances(const Instance *instances, uint32_t count)
+    {
+        if (!instances || count == 0)
+        {
+            m_instances.clear();
+            return;
+        }
+        m_instances.assign(instances, instances + count);
+    }
+
+    void ImpostorRenderPassModule::onCreate(VulkanContext &ctx, VkRenderPass pass, const std::vector<VkFramebuffer> &fbs)
+    {
+        (void)fbs;
+        m_device = ctx.GetDevice();
+        m_physicalDevice = ctx.GetPhysicalDevice();
+        m_extent = ctx.GetSwapChain() ? ctx.GetSwapChain()->GetExtent() : VkExtent2D{};
+
+        m_settings.directions = std::max(1u, m_settings.directions);
+        m_settings.framesPerClip = std::max(1u, m_settings.framesPerClip);
+        m_settings.cellSize = std::max(8u, m_settings.cellSize);
+
+        // Missing shaders are not an error: ready() stays false and callers draw the full model.
+        if (!createPipeline(pass))
+            return;
+
+        if (!createBakePass(ctx))
+        {
+            m_bakeFailed = true;
+            return;
+        }
+    }
+
+    bool ImpostorRenderPassModule::createPipeline(VkRenderPass pass)
+    {
+        VkShaderModule vert = VK_NULL_HANDLE;
+        VkShaderModule frag = VK_NULL_HANDLE;
+        try
+        {
+            vert = Pipeline::createShaderModuleFromFile(m_device, "shaders/impostor.vert.spv");
+            frag = Pipeline::createShaderModuleFromFile(m_device, "shaders/impostor.frag.spv");
+        }
+        catch (const std::exception &e)
+        {
+            if (vert != VK_NULL_HANDLE)
+                vkDestroyShaderModule(m_device, vert, nullptr);
+            std::cerr << "[ImpostorRenderPassModule] impostors disabled: " << e.what() << "\n";
+            return false;
+        }
+
+        // Set 0: the atlas
+        VkDescriptorSetLayoutBinding binding{};
+        binding.binding = 0;
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        binding.descriptorCount = 1;
+        binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        VkDescriptorSetLayoutCreateInfo dsl{};
+        dsl.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        dsl.bindingCount = 1;
+        dsl.pBindings = &binding;
+
+        VkPushConstantRange pcRange{};
+        pcRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        pcRange.offset = 0;
+        pcRange.size = sizeof(PushConstants);
+
+        VkPipelineLayoutCreateInfo pl{};
+        pl.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pl.setLayoutCount = 1;
+        pl.pSetLayouts = &m_setLayout;
+        pl.pushConstantRangeCount = 1;
+        pl.pPushConstantRanges = &pcRange;
+
+        VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1};
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = 1;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+
+        bool ok = vkCreateDescriptorSetLayout(m_device, &dsl, nullptr, &m_setLayout) == VK_SUCCESS &&
+                  vkCreatePipelineLayout(m_device, &pl, nullptr, &m_pipelineLayout) == VK_SUCCESS &&
+                  vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_pool) == VK_SUCCESS;
+        if (ok)
+        {
+            VkDescriptorSetAllocateInfo alloc{};
+            alloc.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            alloc.descriptorPool = m_pool;
+            alloc.descriptorSetCount = 1;
+            alloc.pSetLayouts = &m_setLayout;
+            ok = vkAllocateDescriptorSets(m_device, &alloc, &m_set) == VK_SUCCESS;
+        }
+
+        if (ok)
+        {
+            PipelineCreateInfo pci{};
+            pci.device = m_device;
+            pci.renderPass = pass;
+            pci.subpass = 0;
+            pci.pipelineLayout = m_pipelineLayout;
+
+            VkPipelineShaderStageCreateInfo vs{};
+            vs.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            vs.stage = VK_SHADER_STAGE_VERTEX_BIT;
+            vs.module = vert;
+            vs.pName = "main";
+
+            VkPipelineShaderStageCreateInfo fs{};
+            fs.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            fs.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+            fs.module = frag;
+            fs.pName = "main";
+            pci.shaderStages = {vs, fs};
+
+            // Binding 0: GpuInstance, advanced per instance; the quad corners come from gl_VertexIndex.
+            VkVertexInputBindingDescription bindingDesc{0, sizeof(GpuInstance), VK_VERTEX_INPUT_RATE_INSTANCE};
+            VkVertexInputAttributeDescription attrs[2] = {
+                {0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, 0},
+                {1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, 16}};
+
+            VkPipelineVertexInputStateCreateInfo vi{};
+            vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+            vi.vertexBindingDescriptionCount = 1;
+            vi.pVertexBindingDescriptions = &bindingDesc;
+            vi.vertexAttributeDescriptionCount = 2;
+            vi.pVertexAttributeDescriptions = attrs;
+            pci.vertexInput = vi;
+            pci.vertexInputProvided = true;
+
+            VkPipelineInputAssemblyStateCreateInfo ia{};
+            ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+            ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+            pci.inputAssembly = ia;
+            pci.inputAssemblyProvided = true;
+
+            VkPipelineRasterizationStateCreateInfo rs{};
+            rs.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+            rs.polygonMode = VK_POLYGON_MODE_FILL;
+            rs.lineWidth = 1.0f;
+            rs.cullMode = VK_CULL_MODE_NONE;
+            rs.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+            pci.rasterization = rs;
+            pci.rasterizationProvided = true;
+
+            pci.dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+            // Alpha-tested cutouts: opaque depth like the SModel pipelines.
+            VkPipelineDepthStencilStateCreateInfo ds{};
+            ds.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+            ds.depthTestEnable = VK_TRUE;
+            ds.depthWriteEnable = VK_TRUE;
+            ds.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+            pci.depthStencil = ds;
+            pci.depthStencilProvided = true;
+
+            ok = m_pipeline.create(pci) == VK_SUCCESS;
+        }
+
+        vkDestroyShaderModule(m_device, vert, nullptr);
+        vkDestroyShaderModule(m_device, frag, nullptr);
+        if (!ok)
+        {
+            std::cerr << "[ImpostorRenderPassModule] impostors disabled: failed to create the sprite pipeline\n";
+            destroyResources();
+        }
+        return ok;
+    }
+
+    bool ImpostorRenderPassModule::createBakePass(VulkanContext &ctx)
+    {
+        auto bake = std::make_shared<BakeResources>();
+        bake->device = m_device;
+        bake->depthFormat = findBakeDepthFormat(m_physicalDevice);
+        if (bake->depthFormat == VK_FORMAT_UNDEFINED)
+        {
+            std::cerr << "[ImpostorRenderPassModule] no depth format for the bake pass\n";
+            return false;
+        }
+
+        VkAttachmentDescription attachments[2]{};
+        attachments[0].format = kAtlasFormat;
+        attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        attachments[0].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        attachments[1].format = bake->depthFormat;
+        attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference colorRef{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+        VkAttachmentReference depthRef{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorRef;
+        subpass.pDepthStencilAttachment = &depthRef;
+
+        // The main pass samples the atlas right after the bake, in the same command buffer.
+        VkSubpassDependency dependency{};
+        dependency.srcSubpass = 0;
+        dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        dependency.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        VkRenderPassCreateInfo rpInfo{};
+        rpInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        rpInfo.attachmentCount = 2;
+        rpInfo.pAttachments = attachments;
+        rpInfo.subpassCount = 1;
+        rpInfo.pSubpasses = &subpass;
+        rpInfo.dependencyCount = 1;
+        rpInfo.pDependencies = &dependency;
+        if (vkCreateRenderPass(m_device, &rpInfo, nullptr, &bake->renderPass) != VK_SUCCESS)
+        {
+            std::cerr << "[ImpostorRenderPassModule] failed to create the bake render pass\n";
+            return false;
+        }
+
+        // SModel pipelines, layouts and material sets for the bake pass (matrix instances: the bake
+        // instance carries only the pose's palette slot).
+        bake->renderer = SModelRenderer::acquire(ctx, bake->renderPass, 1, false);
+        m_bake = std::move(bake);
+        return true;
+    }
+
+    bool ImpostorRenderPassModule::createAtlas(uint32_t width, uint32_t height)
+    {
+        if (CreateImage2D(m_device, m_physicalDevice, width, height, kAtlasFormat,
+                          VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                          m_atlas, m_atlasAllocation) != VK_SUCCESS)
+            return false;
+        if (CreateImageView2D(m_device, m_atlas, kAtlasFormat, VK_IMAGE_ASPECT_COLOR_BIT, m_atlasView) != VK_SUCCESS)
+            return false;
+
+        VkSamplerCreateInfo si{};
+        si.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        si.magFilter = VK_FILTER_LINEAR;
+        si.minFilter = VK_FILTER_LINEAR;
+        si.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        si.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        si.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        si.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        si.maxLod = 0.0f;
+        if (vkCreateSampler(m_device, &si, nullptr, &m_sampler) != VK_SUCCESS)
+            return false;
+
+        VkDescriptorImageInfo di{};
+        di.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        di.imageView = m_atlasView;
+        di.sampler = m_sampler;
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_set;
+        write.dstBinding = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.descriptorCount = 1;
+        write.pImageInfo = &di;
+        vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+        return true;
+    }
+
+    bool ImpostorRenderPassModule::createBakeBuffer(VkDeviceSize size, VkBufferUsageFlags usage, void *&mapped)
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        GpuAllocation allocation;
+        if (GpuAllocator::forDevice(m_device, m_physicalDevice)
+                .createBuffer(size, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                              GpuMemoryCategory::Staging, buffer, allocation) != VK_SUCCESS ||
+            !allocation.mapped)
+        {
+            DestroyBuffer(m_device, buffer, allocation);
+            return false;
+        }
+        mapped = allocation.mapped;
+        m_bake->buffers.push_back(buffer);
+        m_bake->allocations.push_back(allocation);
+        return true;
+    }
+
+    bool ImpostorRenderPassModule::bakeable(const ModelAsset &model) const
+    {
+        for (const ModelPrimitive &prim : model.primitives)
+        {
+            MeshAsset *mesh = m_assets->getMesh(prim.mesh);
+            MaterialAsset *mat = m_assets->getMaterial(prim.material);
+            if (!mesh || !mat)
+                return false;
+            if (mat->baseColorTexture.isValid() && m_assets->textureState(mat->baseColorTexture) == AssetState::Pending)
+                return false;
+        }
+        return true;
+    }
+
+    bool ImpostorRenderPassModule::bake(FrameContext &frameCtx, VkCommandBuffer cmd, const ModelAsset &model)
+    {
+        if (!model.hasBounds || model.nodes.empty())
+        {
+            std::cerr << "[ImpostorRenderPassModule] model has no bounds or nodes, nothing to bake\n";
+            return false;
+        }
+
+        const glm::vec3 bmin(model.boundsMin[0], model.boundsMin[1], model.boundsMin[2]);
+        const glm::vec3 bmax(model.boundsMax[0], model.boundsMax[1], model.boundsMax[2]);
+        const glm::vec3 center = (bmin + bmax) * 0.5f;
+        const float radius = glm::length(bmax - bmin) * 0.5f * kSpritePadding;
+        if (!(radius > 0.0f))
+            return false;
+
+        // Atlas layout, clamped to the device's image size limit.
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(m_physicalDevice, &props);
+        const uint32_t cell = m_settings.cellSize;
+        const uint32_t maxCells = std::max(1u, props.limits.maxImageDimension2D / cell);
+        const uint32_t directions = std::min(m_settings.directions, maxCells);
+        const uint32_t clipCount = std::min(std::max(1u, static_cast<uint32_t>(model.animClips.size())), maxCells);
+        const uint32_t rowsPerClip = model.animClips.empty() ? 1u : std::max(1u, std::min(m_settings.framesPerClip, maxCells / clipCount));
+
+        m_clipRows.assign(clipCount, ClipRows{});
+        for (uint32_t c = 0; c < clipCount; ++c)
+        {
+            m_clipRows[c].firstRow = c * rowsPerClip;
+            m_clipRows[c].rowCount = rowsPerClip;
+            m_clipRows[c].durationSec = (c < model.animClips.size()) ? std::max(model.animClips[c].durationSec, 0.0f) : 0.0f;
+        }
+        const uint32_t rows = clipCount * rowsPerClip;
+
+        if (!createAtlas(directions * cell, rows * cell))
+        {
+            std::cerr << "[ImpostorRenderPassModule] failed to create the atlas\n";
+            return false;
+        }
+
+        BakeResources &bake = *m_bake;
+        if (CreateImage2D(m_device, m_physicalDevice, directions * cell, rows * cell, bake.depthFormat,
+                          VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, bake.depthImage, bake.depthAllocation,
+                          GpuMemoryCategory::RenderTarget) != VK_SUCCESS ||
+            CreateImageView2D(m_device, bake.depthImage, bake.depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, bake.depthView) != VK_SUCCESS)
+        {
+            std::cerr << "[ImpostorRenderPassModule] failed to create the bake depth buffer\n";
+            return false;
+        }
+
+        const VkImageView views[2] = {m_atlasView, bake.depthView};
+        VkFramebufferCreateInfo fbInfo{};
+        fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        fbInfo.renderPass = bake.renderPass;
+        fbInfo.attachmentCount = 2;
+        fbInfo.pAttachments = views;
+        fbInfo.width = directions * cell;
+        fbInfo.height = rows * cell;
+        fbInfo.layers = 1;
+        if (vkCreateFramebuffer(m_device, &fbInfo, nullptr, &bake.framebuffer) != VK_SUCCESS)
+            return false;
+
+        // Poses: palette slot r is atlas row r.
+        const uint32_t nodeCount = static_cast<uint32_t>(model.nodes.size());
+        const uint32_t jointStride = std::max(1u, model.totalJointCount);
+        void *nodesMapped = nullptr;
+        void *jointsMapped = nullptr;
+        void *instancesMapped = nullptr;
+        if (!createBakeBuffer(sizeof(glm::mat4) * rows * nodeCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, nodesMapped) ||
+            !createBakeBuffer(sizeof(glm::mat4) * rows * jointStride, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, jointsMapped) ||
+            !createBakeBuffer(sizeof(glm::mat4) * rows, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, instancesMapped))
+            return false;
+        const VkBuffer nodeBuffer = bake.buffers[0];
+        const VkBuffer jointBuffer = bake.buffers[1];
+        const VkBuffer instanceBuffer = bake.buffers[2];
+
+        glm::mat4 *nodeOut = static_cast<glm::mat4 *>(nodesMapped);
+        glm::mat4 *jointOut = static_cast<glm::mat4 *>(jointsMapped);
+        glm::mat4 *instanceOut = static_cast<glm::mat4 *>(instancesMapped);
+        std::vector<ModelAsset::NodeTRS> trs;
+        std::vector<glm::mat4> globals;
+        for (uint32_t c = 0; c < clipCount; ++c)
+        {
+            const ClipRows &clip = m_clipRows[c];
+            for (uint32_t f = 0; f < clip.rowCount; ++f)
+            {
+                const uint32_t row = clip.firstRow + f;
+                model.evaluatePoseInto(c, clip.durationSec * static_cast<float>(f) / static_cast<float>(clip.rowCount), trs, globals);
+                globals.resize(nodeCount, glm::mat4(1.0f));
+                std::copy(globals.begin(), globals.end(), nodeOut + static_cast<size_t>(row) * nodeCount);
+
+                glm::mat4 *joints = jointOut + static_cast<size_t>(row) * jointStride;
+                std::fill(joints, joints + jointStride, glm::mat4(1.0f));
+                for (const auto &skin : model.skins)
+                {
+                    for (uint32_t j = 0; j < skin.jointCount && j < skin.jointNodeIndices.size() && j < skin.inverseBind.size(); ++j)
+                    {
+                        const uint32_t node = skin.jointNodeIndices[j];
+                        if (node < nodeCount && skin.jointBase + j < jointStride)
+                            joints[skin.jointBase + j] = globals[node] * skin.inverseBind[j];
+                    }
+                }
+
+                // Identity world; the palette slot travels in [0][3] (see smodel.vert).
+                instanceOut[row] = glm::mat4(1.0f);
+                instanceOut[row][0][3] = static_cast<float>(row);
+            }
+        }
+
+        // One frame set per view direction: its camera UBO plus the shared palettes.
+        VkDescriptorPoolSize poolSizes[2] = {
+            {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, directions},
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, directions * 2}};
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = directions;
+        poolInfo.poolSizeCount = 2;
+        poolInfo.pPoolSizes = poolSizes;
+        if (vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &bake.pool) != VK_SUCCESS)
+            return false;
+
+        SModelRenderer &renderer = *bake.renderer;
+        const VkDescriptorSetLayout frameLayout = renderer.frameSetLayout();
+        std::vector<VkDescriptorSet> frameSets(directions, VK_NULL_HANDLE);
+        const float elevation = glm::radians(m_settings.elevationDegrees);
+        for (uint32_t k = 0; k < directions; ++k)
+        {
+            // Looking at the sprite center along v (azimuth k * 360 / directions in instance space).
+            const float azimuth = kTwoPi * static_cast<float>(k) / static_cast<float>(directions);
+            const glm::vec3 v(std::sin(azimuth) * std::cos(elevation), -std::sin(elevation), std::cos(azimuth) * std::cos(elevation));
+
+            SModelRenderer::CameraUBO camera{};
+            camera.view = glm::lookAt(center - v * (2.0f * radius), center, glm::vec3(0.0f, 1.0f, 0.0f));
+            camera.proj = glm::orthoRH_ZO(-radius, radius, -radius, radius, 0.0f, 4.0f * radius);
+            camera.proj[1][1] *= -1.0f;
+
+            void *cameraMapped = nullptr;
+            if (!createBakeBuffer(sizeof(camera), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, cameraMapped))
+                return false;
+            std::memcpy(cameraMapped, &camera, sizeof(camera));
+
+            VkDescriptorSetAllocateInfo alloc{};
+            alloc.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            alloc.descriptorPool = bake.pool;
+            alloc.descriptorSetCount = 1;
+            alloc.pSetLayouts = &frameLayout;
+            if (vkAllocateDescriptorSets(m_device, &alloc, &frameSets[k]) != VK_SUCCESS)
+                return false;
+
+            VkDescriptorBufferInfo infos[3] = {
+                {bake.buffers.back(), 0, sizeof(camera)},
+                {nodeBuffer, 0, VK_WHOLE_SIZE},
+                {jointBuffer, 0, VK_WHOLE_SIZE}};
+            VkWriteDescriptorSet writes[3]{};
+            for (uint32_t b = 0; b < 3; ++b)
+            {
+                writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[b].dstSet = frameSets[k];
+                writes[b].dstBinding = b;
+                writes[b].descriptorCount = 1;
+                writes[b].descriptorType = (b == 0) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writes[b].pBufferInfo = &infos[b];
+            }
+            vkUpdateDescriptorSets(m_device, 3, writes, 0, nullptr);
+        }
+
+        // Draws like SModelRenderPassModule::queueDraws(): OPAQUE, MASK, BLEND, by node, full detail.
+        struct BakeDraw
+        {
+            SModelRenderer::PushConstants pc{};
+            const ModelPrimitive *prim = nullptr;
+            MeshAsset *mesh = nullptr;
+            VkDescriptorSet materialSet = VK_NULL_HANDLE;
+            uint32_t alphaMode = 0;
+        };
+        std::vector<BakeDraw> draws;
+        auto add = [&](const ModelPrimitive &prim, uint32_t nodeIndex, uint32_t pass)
+        {
+            MeshAsset *mesh = m_assets->getMesh(prim.mesh);
+            MaterialAsset *mat = m_assets->getMaterial(prim.material);
+            if (!mesh || !mat || mat->alphaMode != pass || prim.indexCount == 0 ||
+                mesh->getVertexBuffer() == VK_NULL_HANDLE || mesh->getIndexBuffer() == VK_NULL_HANDLE)
+                return;
+
+            BakeDraw d;
+            const glm::mat4 identity(1.0f);
+            std::memcpy(d.pc.model, glm::value_ptr(identity), sizeof(d.pc.model));
+            std::memcpy(d.pc.baseColorFactor, mat->baseColorFactor, sizeof(d.pc.baseColorFactor));
+            d.pc.materialParams[0] = mat->alphaCutoff;
+            d.pc.materialParams[1] = static_cast<float>(mat->alphaMode);
+            d.pc.nodeIndex = nodeIndex;
+            d.pc.nodeCount = nodeCount;
+            d.pc.jointPaletteStride = jointStride;
+            if (prim.skinIndex >= 0 && static_cast<uint32_t>(prim.skinIndex) < model.skins.size())
+            {
+                const auto &skin = model.skins[static_cast<uint32_t>(prim.skinIndex)];
+                d.pc.skinBaseJoint = skin.jointBase;
+                d.pc.skinJointCount = skin.jointCount;
+            }
+            if (mesh->isQuantized())
+                d.pc.setQuantizationBox(mesh->getAABBMin(), mesh->getAABBMax());
+            const auto mb = renderer.material(*m_assets, prim.material, *mat);
+            d.materialSet = mb.set;
+            d.pc.materialIndex = mb.index;
+            d.prim = &prim;
+            d.mesh = mesh;
+            d.alphaMode = mat->alphaMode;
+            draws.push_back(d);
+        };
+        for (uint32_t pass = 0; pass < 3; ++pass)
+        {
+            for (uint32_t nodeIndex = 0; nodeIndex < nodeCount; ++nodeIndex)
+            {
+                const auto &node = model.nodes[nodeIndex];
+                for (uint32_t k = 0; k < node.primitiveCount; ++k)
+                {
+                    const uint32_t primIndex = model.nodePrimitiveIndices[node.firstPrimitiveIndex + k];
+                    if (primIndex < model.primitives.size())
+                        add(model.primitives[primIndex], nodeIndex, pass);
+                }
+            }
+        }
+
+        GpuScope gpu(frameCtx.gpuProfiler, cmd, "Impostor bake");
+
+        VkClearValue clears[2]{};
+        clears[0].color = {{0.0f, 0.0f, 0.0f, 0.0f}};
+        clears[1].depthStencil = {1.0f, 0};
+
+        VkRenderPassBeginInfo rpBegin{};
+        rpBegin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        rpBegin.renderPass = bake.renderPass;
+        rpBegin.framebuffer = bake.framebuffer;
+        rpBegin.renderArea.extent = {directions * cell, rows * cell};
+        rpBegin.clearValueCount = 2;
+        rpBegin.pClearValues = clears;
+        vkCmdBeginRenderPass(cmd, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
+
+        const VkDeviceSize zero = 0;
+        vkCmdBindVertexBuffers(cmd, 1, 1, &instanceBuffer, &zero);
+        for (uint32_t k = 0; k < directions; ++k)
+        {
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer.pipelineLayout(), 0, 1, &frameSets[k], 0, nullptr);
+            for (uint32_t row = 0; row < rows; ++row)
+            {
+                // The cell is the whole viewport: every view frames the same sphere.
+                VkViewport vp{static_cast<float>(k * cell), static_cast<float>(row * cell), static_cast<float>(cell), static_cast<float>(cell), 0.0f, 1.0f};
+                VkRect2D sc{{static_cast<int32_t>(k * cell), static_cast<int32_t>(row * cell)}, {cell, cell}};
+                vkCmdSetViewport(cmd, 0, 1, &vp);
+                vkCmdSetScissor(cmd, 0, 1, &sc);
+
+                for (const BakeDraw &d : draws)
+                {
+                    renderer.pipeline(false, d.mesh->isQuantized(), d.pc.skinJointCount > 0, d.alphaMode).bind(cmd);
+                    if (d.materialSet != VK_NULL_HANDLE)
+                        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer.pipelineLayout(), 1, 1, &d.materialSet, 0, nullptr);
+                    const VkBuffer vertexBuffer = d.mesh->getVertexBuffer();
+                    vkCmdBindVertexBuffers(cmd, 0, 1, &vertexBuffer, &zero);
+                    vkCmdBindIndexBuffer(cmd, d.mesh->getIndexBuffer(), 0, d.mesh->getIndexType());
+                    vkCmdPushConstants(cmd, renderer.pipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                                       0, sizeof(d.pc), &d.pc);
+                    vkCmdDrawIndexed(cmd, d.prim->indexCount, 1, d.prim->firstIndex, d.prim->vertexOffset, row);
+                    DrawCallCounter::increment();
+                }
+            }
+        }
+        vkCmdEndRenderPass(cmd);
+
+        m_directions = directions;
+        m_rows = rows;
+        m_sphere = glm::vec4(center, radius);
+        return true;
+    }
+
+    void ImpostorRenderPassModule::recordPrePass(FrameContext &frameCtx, VkCommandBuffer cmd)
+    {
+        if (!m_bake || m_bakeFailed || baked() || !m_assets || !m_model.isValid())
+            return;
+
+        const ModelAsset *model = m_assets->getModel(m_model);
+        if (!model || model->primitives.empty() || !bakeable(*model))
+            return; // still streaming
+
+        if (!bake(frameCtx, cmd, *model))
+        {
+            // Nothing of a failed bake was recorded into 'cmd'; callers keep drawing the full model.
+            std::cerr << "[ImpostorRenderPassModule] bake failed, impostors disabled for this model\n";
+            m_bakeFailed = true;
+            if (m_atlasView != VK_NULL_HANDLE)
+                vkDestroyImageView(m_device, m_atlasView, nullptr);
+            m_atlasView = VK_NULL_HANDLE;
+            DestroyImage2D(m_device, m_atlas, m_atlasAllocation);
+            m_bake.reset();
+            return;
+        }
+        m_baked.store(true, std::memory_order_release);
+
+        // The bake pass, its SModel pipelines and buffers are only needed until this frame executes.
+        if (frameCtx.timeline)
+        {
+            std::shared_ptr<BakeResources> bake = std::move(m_bake);
+            frameCtx.timeline->deferUntil(frameCtx.timelineValue, [bake]() mutable
+                                          { bake.reset(); });
+        }
+    }
+
+    uint32_t ImpostorRenderPassModule::rowOf(const Instance &instance) const
+    {
+        if (m_clipRows.empty())
+            return 0;
+        const ClipRows &clip = m_clipRows[std::min(instance.clip, static_cast<uint32_t>(m_clipRows.size() - 1))];
+        if (clip.rowCount <= 1 || clip.durationSec <= 1e-6f)
+            return clip.firstRow;
+
+        // Nearest baked pose; clips loop, so the last frame wraps to the first.
+        float t = std::fmod(std::max(instance.timeSec, 0.0f), clip.durationSec);
+        const uint32_t frame = static_cast<uint32_t>(t / clip.durationSec * static_cast<float>(clip.rowCount) + 0.5f) % clip.rowCount;
+        return clip.firstRow + frame;
+    }
+
+    void ImpostorRenderPassModule::record(FrameContext &frameCtx, VkCommandBuffer cmd)
+    {
+        if (!m_record.enabled || !baked() || m_record.instances.empty() || !frameCtx.transient)
+            return;
+        if (m_extent.width == 0 || m_extent.height == 0)
+            return;
+
+        // This frame's instance stream lives in the renderer's transient ring.
+        const uint32_t count = static_cast<uint32_t>(m_record.instances.size());
+        const TransientAllocator::Allocation stream =
+            frameCtx.transient->allocate(frameCtx.frameIndex, sizeof(GpuInstance) * count, alignof(GpuInstance));
+        if (!stream)
+            return;
+
+        GpuInstance *out = static_cast<GpuInstance *>(stream.mapped);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const Instance &in = m_record.instances[i];
+            out[i].positionScale = glm::vec4(in.position, in.scale);
+            out[i].yawRow = glm::vec4(std::sin(in.yaw), std::cos(in.yaw), static_cast<float>(rowOf(in)), 0.0f);
+        }
+
+        PushConstants pc{};
+        pc.viewProj = m_record.viewProj;
+        pc.cameraPos = glm::vec4(m_record.cameraPos, 1.0f);
+        pc.sphere = m_sphere;
+        pc.atlas = glm::vec4(static_cast<float>(m_directions), static_cast<float>(m_rows),
+                             1.0f / static_cast<float>(m_directions), 1.0f / static_cast<float>(m_rows));
+
+        VkViewport vp{0.0f, 0.0f, static_cast<float>(m_extent.width), static_cast<float>(m_extent.height), 0.0f, 1.0f};
+        VkRect2D sc{{0, 0}, m_extent};
+        vkCmdSetViewport(cmd, 0, 1, &vp);
+        vkCmdSetScissor(cmd, 0, 1, &sc);
+
+        m_pipeline.bind(cmd);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_set, 0, nullptr);
+        vkCmdBindVertexBuffers(cmd, 0, 1, &stream.buffer, &stream.offset);
+        vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pc), &pc);
+        vkCmdDraw(cmd, 4, count, 0, 0);
+        DrawCallCounter::increment();
+    }
+
+    void ImpostorRenderPassModule::onFrameSnapshot()
+    {
+        m_record.enabled = m_enabled;
+        m_record.instances = m_instances;
+        if (m_camera)
+        {
+            const ViewData &view = m_camera->GetViewData();
+            m_record.viewProj = view.viewProj;
+            m_record.cameraPos = view.position;
+        }
+    }
+
+    void ImpostorRenderPassModule::onResize(VulkanContext &ctx, VkExtent2D newExtent)
+    {
+        (void)ctx;
+        m_extent = newExtent;
+    }
+
+    void ImpostorRenderPassModule::onDestroy(VulkanContext &ctx)
+    {
+        (void)ctx;
+        destroyResources();
+    }
+
+    void ImpostorRenderPassModule::destroyResources()
+    {
+        if (m_device == VK_NULL_HANDLE)
+            return;
+
+        m_bake.reset();
+
+        if (m_sampler != VK_NULL_HANDLE)
+            vkDestroySampler(m_device, m_sampler, nullptr);
+        if (m_atlasView != VK_NULL_HANDLE)
+            vkDestroyImageView(m_device, m_atlasView, nullptr);
+        DestroyImage2D(m_device, m_atlas, m_atlasAllocation);
+        m_sampler = VK_NULL_HANDLE;
+        m_atlasView = VK_NULL_HANDLE;
+        m_baked.store(false, std::memory_order_release);
+
+        m_pipeline.destroy(m_device);
+        if (m_pool != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(m_device, m_pool, nullptr);
+        if (m_pipelineLayout != VK_NULL_HANDLE)
+            vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+        if (m_setLayout != VK_NULL_HANDLE)
+            vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+        m_pool = VK_NULL_HANDLE;
+        m_set = VK_NULL_HANDLE;
+        m_pipelineLayout = VK_NULL_HANDLE;
+        m_setLayout = VK_NULL_HANDLE;
+    }
+}
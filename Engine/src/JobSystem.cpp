@@ -0,0 +1,296 @@
+#include "Engine/JobSystem.h"
+#include "Engine/FrameArena.h"
+#include "Engine/Profiler.h"
+
+#include <iostream>
+#include <string>
+#include <utility>
+
+namespace Engine
+{
+    namespace
+    {
+        // Queue of the current thread in the pool it works for (0 outside any pool).
+        thread_local const JobSystem *t_pool = nullptr;
+        thread_local size_t t_queue = 0;
+    }
+
+    JobSystem::JobSystem(uint32_t workerCount)
+        : m_mainThread(std::this_thread::get_id())
+    {
+        if (workerCount == 0)
+        {
+            const uint32_t hw = std::thread::hardware_concurrency();
+            workerCount = (hw > 1) ? (hw - 1) : 1;
+        }
+        m_maxBackground = std::max(1u, workerCount - 1);
+
+        m_queues.resize(static_cast<size_t>(workerCount) + 1);
+        for (auto &q : m_queues)
+            q = std::make_unique<Queue>();
+
+        m_threads.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; ++i)
+            m_threads.emplace_back([this, i]
+                                   { workerLoop(i + 1); });
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_quit = true;
+        }
+        m_wake.notify_all();
+        for (auto &t : m_threads)
+            t.join();
+    }
+
+    JobSystem &JobSystem::get()
+    {
+        static JobSystem instance;
+        return instance;
+    }
+
+    size_t JobSystem::selfQueue() const
+    {
+        return (t_pool == this) ? t_queue : 0;
+    }
+
+    void JobSystem::submit(Fn fn, JobPriority priority, JobCounter *counter)
+    {
+        if (counter)
+            counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+        push(Job{std::move(fn), counter, priority});
+    }
+
+    void JobSystem::submitAfter(JobCounter &dependency, Fn fn, JobPriority priority, JobCounter *counter)
+    {
+        if (counter)
+            counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(dependency.m_mutex);
+            if (dependency.m_pending.load(std::memory_order_acquire) > 0)
+            {
+                dependency.m_continuations.push_back(JobCounter::Continuation{std::move(fn), counter, priority});
+                return;
+            }
+        }
+        push(Job{std::move(fn), counter, priority});
+    }
+
+    void JobSystem::submitMainThread(Fn fn, JobCounter *counter)
+    {
+        if (counter)
+            counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(m_mainMutex);
+        m_mainJobs.push_back(Job{std::move(fn), counter, JobPriority::High});
+        m_mainQueued.fetch_add(1, std::memory_order_release);
+    }
+
+    void JobSystem::pumpMainThread()
+    {
+        if (m_mainQueued.load(std::memory_order_acquire) == 0)
+            return;
+
+        // A local list: main-thread jobs may wait() and so pump again.
+        std::vector<Job> jobs;
+        {
+            std::lock_guard<std::mutex> lock(m_mainMutex);
+            jobs.swap(m_mainJobs);
+            m_mainQueued.fetch_sub(static_cast<uint32_t>(jobs.size()), std::memory_order_acq_rel);
+        }
+        for (Job &job : jobs)
+            execute(job);
+    }
+
+    void JobSystem::wait(JobCounter &counter, JobPriority helpUpTo)
+    {
+        const size_t self = selfQueue();
+        const bool mainThread = isMainThread();
+        while (counter.m_pending.load(std::memory_order_acquire) > 0)
+        {
+            if (mainThread)
+                pumpMainThread();
+            if (!tryRunOne(self, helpUpTo))
+                std::this_thread::yield();
+        }
+
+        // Taking the lock orders us after the finishing thread's last touch of the counter.
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(counter.m_mutex);
+            error = std::exchange(counter.m_error, nullptr);
+        }
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    void JobSystem::push(Job job)
+    {
+        // Workers keep their own spawns (cache-warm, LIFO); other threads spread round-robin.
+        size_t qi = selfQueue();
+        if (qi == 0)
+            qi = 1 + (m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_threads.size());
+
+        const bool background = job.priority == JobPriority::Background;
+        {
+            std::lock_guard<std::mutex> lock(m_queues[qi]->mutex);
+            m_queues[qi]->jobs[static_cast<size_t>(job.priority)].push_back(std::move(job));
+        }
+        if (background)
+            m_queuedBackground.fetch_add(1, std::memory_order_release);
+        m_queued.fetch_add(1, std::memory_order_release);
+        {
+            // Pairs with the predicate check in workerLoop() so the wakeup cannot be lost.
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_wake.notify_one();
+    }
+
+    bool JobSystem::take(size_t self, size_t priority, Job &out)
+    {
+        {
+            Queue &own = *m_queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            auto &jobs = own.jobs[priority];
+            if (!jobs.empty())
+            {
+                out = std::move(jobs.back());
+                jobs.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < m_queues.size(); ++k)
+        {
+            Queue &victim = *m_queues[(self + k) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            auto &jobs = victim.jobs[priority];
+            if (!jobs.empty())
+            {
+                out = std::move(jobs.front());
+                jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool JobSystem::tryRunOne(size_t self, JobPriority maxPriority)
+    {
+        if (m_queued.load(std::memory_order_acquire) == 0)
+            return false;
+
+        Job job;
+        for (size_t p = 0; p <= static_cast<size_t>(maxPriority); ++p)
+        {
+            const bool background = p == static_cast<size_t>(JobPriority::Background);
+            if (background)
+            {
+                // Reserve a background slot first so frame work always has a worker left.
+                if (m_backgroundRunning.fetch_add(1, std::memory_order_acq_rel) >= m_maxBackground)
+                {
+                    m_backgroundRunning.fetch_sub(1, std::memory_order_acq_rel);
+                    return false;
+                }
+            }
+
+            if (!take(self, p, job))
+            {
+                if (background)
+                    m_backgroundRunning.fetch_sub(1, std::memory_order_acq_rel);
+                continue;
+            }
+
+            m_queued.fetch_sub(1, std::memory_order_acq_rel);
+            if (background)
+                m_queuedBackground.fetch_sub(1, std::memory_order_acq_rel);
+            execute(job);
+            if (background)
+            {
+                m_backgroundRunning.fetch_sub(1, std::memory_order_acq_rel);
+                if (m_queuedBackground.load(std::memory_order_acquire) > 0)
+                {
+                    std::lock_guard<std::mutex> lock(m_sleepMutex);
+                    m_wake.notify_one();
+                }
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void JobSystem::execute(Job &job)
+    {
+        {
+            // Scratch a job takes from this thread's FrameArena ends with the job.
+            FrameArena::Scope scratch;
+            try
+            {
+                job.fn();
+            }
+            catch (...)
+            {
+                if (job.counter)
+                {
+                    std::lock_guard<std::mutex> lock(job.counter->m_mutex);
+                    if (!job.counter->m_error)
+                        job.counter->m_error = std::current_exception();
+                }
+                else
+                {
+                    std::cerr << "[JobSystem] Unhandled exception in a job without a counter\n";
+                }
+            }
+        }
+
+        // Captures go before the counter does: a waiter may free what they reference once it is 0.
+        job.fn = nullptr;
+        finish(job.counter);
+    }
+
+    void JobSystem::finish(JobCounter *counter)
+    {
+        if (!counter)
+            return;
+
+        std::vector<JobCounter::Continuation> released;
+        {
+            std::lock_guard<std::mutex> lock(counter->m_mutex);
+            if (counter->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                released.swap(counter->m_continuations);
+        }
+        // 'counter' may be gone from here on.
+        for (JobCounter::Continuation &c : released)
+            push(Job{std::move(c.fn), c.counter, c.priority});
+    }
+
+    bool JobSystem::hasRunnableWork() const
+    {
+        const uint32_t queued = m_queued.load(std::memory_order_acquire);
+        const uint32_t background = m_queuedBackground.load(std::memory_order_acquire);
+        return queued > background ||
+               (background > 0 && m_backgroundRunning.load(std::memory_order_acquire) < m_maxBackground);
+    }
+
+    void JobSystem::workerLoop(size_t self)
+    {
+        t_pool = this;
+        t_queue = self;
+        const std::string threadName = "Job " + std::to_string(self);
+        CpuProfiler::setThreadName(threadName.c_str());
+
+        for (;;)
+        {
+            if (tryRunOne(self, JobPriority::Background))
+                continue;
+
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wake.wait(lock, [this]
+                        { return m_quit || hasRunnableWork(); });
+            if (m_quit)
+                return;
+        }
+    }
+
+} // namespace Engine
@@ -0,0 +1,208 @@
+#include "utils/MappedFile.h"
+#include "utils/AssetArchive.h"
+
+#include <algorithm>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Engine
+{
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile::MappedFile(MappedFile &&other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_owner = std::move(other.m_owner);
+#if defined(_WIN32)
+            m_file = std::exchange(other.m_file, nullptr);
+            m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+        }
+        return *this;
+    }
+
+    void MappedFile::adopt(const uint8_t *data, uint64_t size, std::shared_ptr<const void> owner)
+    {
+        close();
+        m_data = data;
+        m_size = size;
+        m_owner = std::move(owner);
+    }
+
+#if defined(_WIN32)
+
+    bool MappedFile::open(const std::string &path, std::string &outError)
+    {
+        close();
+
+        bool handled = false;
+        const bool ok = AssetArchive::openMounted(path, *this, outError, handled);
+        if (handled)
+            return ok;
+
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            outError = "Failed to open file: " + path;
+            return false;
+        }
+
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+        {
+            CloseHandle(file);
+            outError = "File is empty: " + path;
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+        {
+            CloseHandle(file);
+            outError = "Failed to map file: " + path;
+            return false;
+        }
+
+        const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!view)
+        {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            outError = "Failed to map file view: " + path;
+            return false;
+        }
+
+        m_file = file;
+        m_mapping = mapping;
+        m_data = static_cast<const uint8_t *>(view);
+        m_size = static_cast<uint64_t>(size.QuadPart);
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (m_owner)
+        {
+            m_owner.reset();
+            m_data = nullptr;
+            m_size = 0;
+            return;
+        }
+        if (m_data)
+            UnmapViewOfFile(m_data);
+        if (m_mapping)
+            CloseHandle(static_cast<HANDLE>(m_mapping));
+        if (m_file)
+            CloseHandle(static_cast<HANDLE>(m_file));
+        m_data = nullptr;
+        m_size = 0;
+        m_mapping = nullptr;
+        m_file = nullptr;
+    }
+
+    void MappedFile::prefetch(uint64_t offset, uint64_t size) const
+    {
+        if (!m_data || offset >= m_size || size == 0)
+            return;
+        WIN32_MEMORY_RANGE_ENTRY range{};
+        range.VirtualAddress = const_cast<uint8_t *>(m_data + offset);
+        range.NumberOfBytes = static_cast<SIZE_T>(std::min(size, m_size - offset));
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+
+#else
+
+    bool MappedFile::open(const std::string &path, std::string &outError)
+    {
+        close();
+
+        bool handled = false;
+        const bool ok = AssetArchive::openMounted(path, *this, outError, handled);
+        if (handled)
+            return ok;
+
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            outError = "Failed to open file: " + path;
+            return false;
+        }
+
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            ::close(fd);
+            outError = "File is empty: " + path;
+            return false;
+        }
+
+        void *view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps the file referenced
+        if (view == MAP_FAILED)
+        {
+            outError = "Failed to map file: " + path;
+            return false;
+        }
+
+        m_data = static_cast<const uint8_t *>(view);
+        m_size = static_cast<uint64_t>(st.st_size);
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (m_owner)
+        {
+            m_owner.reset();
+            m_data = nullptr;
+            m_size = 0;
+            return;
+        }
+        if (m_data)
+            munmap(const_cast<uint8_t *>(m_data), static_cast<size_t>(m_size));
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    void MappedFile::prefetch(uint64_t offset, uint64_t size) const
+    {
+        if (!m_data || offset >= m_size || size == 0)
+            return;
+
+        // madvise needs a page-aligned start (adopted views need not start on a page)
+        const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(m_data + offset) & ~(page - 1);
+        const uintptr_t end = reinterpret_cast<uintptr_t>(m_data + std::min(offset + size, m_size));
+        madvise(reinterpret_cast<void *>(begin), static_cast<size_t>(end - begin), MADV_WILLNEED);
+    }
+
+#endif
+
+} // namespace Engine
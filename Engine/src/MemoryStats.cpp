@@ -0,0 +1,124 @@
+#include "Engine/MemoryStats.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace Engine
+{
+    namespace
+    {
+        struct Registry
+        {
+            std::mutex mutex;
+            uint32_t nextId = 1;
+            std::vector<std::pair<uint32_t, MemoryStats::Reporter>> reporters;
+            std::map<std::string, uint64_t> budgets;
+            std::map<std::pair<std::string, std::string>, uint64_t> counterPeaks;
+            std::map<std::string, uint64_t> subsystemPeaks;
+            std::map<std::string, bool> overBudget; // last state, to log crossings once
+        };
+
+        Registry &registry()
+        {
+            static Registry r;
+            return r;
+        }
+    } // namespace
+
+    uint32_t MemoryStats::addReporter(Reporter reporter)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        const uint32_t id = r.nextId++;
+        r.reporters.emplace_back(id, std::move(reporter));
+        return id;
+    }
+
+    void MemoryStats::removeReporter(uint32_t id)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.reporters.erase(std::remove_if(r.reporters.begin(), r.reporters.end(),
+                                         [id](const auto &e)
+                                         { return e.first == id; }),
+                          r.reporters.end());
+    }
+
+    void MemoryStats::setBudget(const std::string &subsystem, uint64_t bytes)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        if (bytes == 0)
+            r.budgets.erase(subsystem);
+        else
+            r.budgets[subsystem] = bytes;
+    }
+
+    void MemoryStats::collect(std::vector<Counter> &counters, std::vector<SubsystemTotal> &totals)
+    {
+        counters.clear();
+        totals.clear();
+
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        std::vector<Counter> raw;
+        for (auto &entry : r.reporters)
+            entry.second(raw);
+
+        // Merge same-named counters (e.g. one per render pass module).
+        std::map<std::pair<std::string, std::string>, Counter> merged;
+        for (Counter &c : raw)
+        {
+            Counter &m = merged[{c.subsystem, c.name}];
+            if (m.subsystem.empty())
+            {
+                m.subsystem = std::move(c.subsystem);
+                m.name = std::move(c.name);
+            }
+            m.cpuBytes += c.cpuBytes;
+            m.gpuBytes += c.gpuBytes;
+            m.count += c.count;
+        }
+
+        for (auto &entry : merged)
+        {
+            Counter &c = entry.second;
+            uint64_t &peak = r.counterPeaks[entry.first];
+            peak = std::max(peak, c.cpuBytes + c.gpuBytes);
+            c.peakBytes = peak;
+
+            if (totals.empty() || totals.back().subsystem != c.subsystem)
+            {
+                SubsystemTotal t;
+                t.subsystem = c.subsystem;
+                totals.push_back(std::move(t));
+            }
+            totals.back().cpuBytes += c.cpuBytes;
+            totals.back().gpuBytes += c.gpuBytes;
+            counters.push_back(std::move(c));
+        }
+
+        for (SubsystemTotal &t : totals)
+        {
+            const uint64_t bytes = t.cpuBytes + t.gpuBytes;
+            uint64_t &peak = r.subsystemPeaks[t.subsystem];
+            peak = std::max(peak, bytes);
+            t.peakBytes = peak;
+
+            auto budget = r.budgets.find(t.subsystem);
+            t.budgetBytes = budget != r.budgets.end() ? budget->second : 0;
+            t.overBudget = t.budgetBytes > 0 && bytes > t.budgetBytes;
+
+            bool &wasOver = r.overBudget[t.subsystem];
+            if (t.overBudget && !wasOver)
+                std::cerr << "MemoryStats: " << t.subsystem << " uses " << bytes << " bytes, over its budget of "
+                          << t.budgetBytes << "\n";
+            wasOver = t.overBudget;
+        }
+    }
+
+} // namespace Engine
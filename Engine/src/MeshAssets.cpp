@@ -1,127 +1,135 @@
 #include "assets/MeshAsset.h"
+#include "utils/ImageUtils.h"
+#include "assets/model/SModelEnums.h"
 #include <cstring>
 
 namespace Engine
 {
-
-    bool MeshAsset::upload(VkDevice device,
-                           VkPhysicalDevice phys,
-                           VkCommandPool commandPool,
-                           VkQueue queue,
-                           const MeshData &data)
+    // Copy into a sub-range of the pool's buffer; the copy is only recorded.
+    static bool recordPooledUpload(UploadContext &ctx, const void *bytes, VkDeviceSize size, VkDeviceSize alignment,
+                                   GeometryPool &pool, GeometryRange &outRange)
     {
-        // 1) Vertex: create host-visible staging buffer and fill it
-        VertexBufferHandle stagingVB{};
-        VkResult rv = CreateOrUpdateVertexBuffer(
-            device, phys,
-            data.vertexBytes.data(),
-            static_cast<VkDeviceSize>(data.vertexBytes.size()),
-            stagingVB);
-        if (rv != VK_SUCCESS)
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        VkDeviceSize stagingOffset = 0;
+        if (!pool.allocate(size, alignment, ctx.queueFamilies, outRange))
             return false;
-
-        // 2) Vertex: create device-local destination and copy
-        VkBuffer dstVBuffer = VK_NULL_HANDLE;
-        VkDeviceMemory dstVMemory = VK_NULL_HANDLE;
-        rv = CreateDeviceLocalBuffer(
-            device, phys,
-            static_cast<VkDeviceSize>(data.vertexBytes.size()),
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            dstVBuffer, dstVMemory);
-        if (rv != VK_SUCCESS)
+        if (!StageUpload(ctx, bytes, size, stagingBuffer, stagingOffset))
         {
-            DestroyVertexBuffer(device, stagingVB);
+            pool.free(outRange);
             return false;
         }
-        rv = CopyBuffer(device, commandPool, queue,
-                        stagingVB.buffer, dstVBuffer,
-                        static_cast<VkDeviceSize>(data.vertexBytes.size()));
-        // Free staging after copy
-        DestroyVertexBuffer(device, stagingVB);
-        if (rv != VK_SUCCESS)
-        {
-            vkDestroyBuffer(device, dstVBuffer, nullptr);
-            vkFreeMemory(device, dstVMemory, nullptr);
+
+        VkBufferCopy region{};
+        region.srcOffset = stagingOffset;
+        region.dstOffset = outRange.offset;
+        region.size = size;
+        vkCmdCopyBuffer(ctx.cmd, stagingBuffer, outRange.buffer, 1, &region);
+        return true;
+    }
+
+    bool MeshAsset::upload_Deferred(UploadContext &ctx, const MeshData &data, GeometryPool *pool)
+    {
+        return upload_Deferred(ctx, MakeMeshDataView(data), pool);
+    }
+
+    bool MeshAsset::uploadPooled(UploadContext &ctx, const MeshDataView &data, GeometryPool &pool)
+    {
+        const VkDeviceSize indexSize = (data.indexFormat == 1) ? sizeof(uint32_t) : sizeof(uint16_t);
+        if (data.vertexStride == 0 ||
+            !recordPooledUpload(ctx, data.vertexBytes, static_cast<VkDeviceSize>(data.vertexByteSize),
+                                data.vertexStride, pool, m_vertexRange))
             return false;
-        }
-        // Store device-local vertex buffer
-        m_vb.buffer = dstVBuffer;
-        m_vb.memory = dstVMemory;
-
-        // 3) Index: create host-visible staging buffer and fill it
-        IndexBufferHandle stagingIB{};
-        VkDeviceSize indexBytes = 0;
-        if (data.indexFormat == 1)
-        {
-            indexBytes = static_cast<VkDeviceSize>(data.indices32.size() * sizeof(uint32_t));
-            rv = CreateOrUpdateIndexBuffer(
-                device, phys,
-                data.indices32.data(),
-                indexBytes,
-                stagingIB);
-            m_indexType = VK_INDEX_TYPE_UINT32;
-            m_indexCount = data.indexCount;
-        }
-        else
-        {
-            indexBytes = static_cast<VkDeviceSize>(data.indices16.size() * sizeof(uint16_t));
-            rv = CreateOrUpdateIndexBuffer(
-                device, phys,
-                data.indices16.data(),
-                indexBytes,
-                stagingIB);
-            m_indexType = VK_INDEX_TYPE_UINT16;
-            m_indexCount = data.indexCount;
-        }
-        if (rv != VK_SUCCESS)
+
+        if (!recordPooledUpload(ctx, data.indexBytes, static_cast<VkDeviceSize>(data.indexByteSize), indexSize,
+                                pool, m_indexRange))
         {
-            // Clean up vertex device-local resources
-            DestroyVertexBuffer(device, m_vb);
+            pool.free(m_vertexRange);
             return false;
         }
 
-        // 4) Index: create device-local destination and copy
-        VkBuffer dstIBuffer = VK_NULL_HANDLE;
-        VkDeviceMemory dstIMemory = VK_NULL_HANDLE;
-        rv = CreateDeviceLocalBuffer(
-            device, phys,
-            indexBytes,
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            dstIBuffer, dstIMemory);
-        if (rv != VK_SUCCESS)
-        {
-            DestroyIndexBuffer(device, stagingIB);
-            DestroyVertexBuffer(device, m_vb);
+        // Ranges are aligned to the element size, so the byte offsets divide exactly.
+        m_pool = &pool;
+        m_vertexOffset = static_cast<int32_t>(m_vertexRange.offset / data.vertexStride);
+        m_firstIndex = static_cast<uint32_t>(m_indexRange.offset / indexSize);
+        return true;
+    }
+
+    bool MeshAsset::upload_Deferred(UploadContext &ctx, const MeshDataView &data, GeometryPool *pool)
+    {
+        if (!ctx.begun || ctx.cmd == VK_NULL_HANDLE || !data.vertexBytes || data.vertexByteSize == 0)
             return false;
-        }
-        rv = CopyBuffer(device, commandPool, queue,
-                        stagingIB.buffer, dstIBuffer,
-                        indexBytes);
-        // Free staging after copy
-        DestroyIndexBuffer(device, stagingIB);
-        if (rv != VK_SUCCESS)
+
+        // A full pool (or a mesh without stride) falls back to buffers of our own.
+        if (!pool || !uploadPooled(ctx, data, *pool))
         {
-            vkDestroyBuffer(device, dstIBuffer, nullptr);
-            vkFreeMemory(device, dstIMemory, nullptr);
-            DestroyVertexBuffer(device, m_vb);
-            return false;
+            if (!RecordDeviceLocalUpload(ctx, data.vertexBytes, static_cast<VkDeviceSize>(data.vertexByteSize),
+                                         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, m_vb.buffer, m_vb.allocation))
+                return false;
+
+            if (!RecordDeviceLocalUpload(ctx, data.indexBytes, static_cast<VkDeviceSize>(data.indexByteSize),
+                                         VK_BUFFER_USAGE_INDEX_BUFFER_BIT, m_ib.buffer, m_ib.allocation))
+            {
+                DestroyVertexBuffer(ctx.device, m_vb);
+                return false;
+            }
         }
-        // Store device-local index buffer
-        m_ib.buffer = dstIBuffer;
-        m_ib.memory = dstIMemory;
 
-        // 5) Copy AABB
+        m_indexType = (data.indexFormat == 1) ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+        m_indexCount = data.indexCount;
+        m_quantized = (data.layoutFlags & smodel::VTX_POS_UNORM16) != 0;
+        m_vertexStride = data.vertexStride;
         std::memcpy(m_aabbMin, data.aabbMin, sizeof(m_aabbMin));
         std::memcpy(m_aabbMax, data.aabbMax, sizeof(m_aabbMax));
+        return true;
+    }
 
+    bool MeshAsset::upload(VkDevice device,
+                           VkPhysicalDevice phys,
+                           VkCommandPool commandPool,
+                           VkQueue queue,
+                           const MeshDataView &data,
+                           GeometryPool *pool)
+    {
+        // One command buffer, one staging arena and one fence for vertex + index data.
+        UploadContext ctx{};
+        if (!BeginUploadContext(ctx, device, phys, commandPool, queue))
+            return false;
+        ReserveStaging(ctx, stagingBytes(data));
+
+        const bool recorded = upload_Deferred(ctx, data, pool);
+        if (!EndSubmitAndWait(ctx) || !recorded)
+        {
+            ReleaseUploadContext(ctx);
+            destroy(device);
+            return false;
+        }
         return true;
     }
 
+    VkDeviceSize MeshAsset::stagingBytes(const MeshData &data)
+    {
+        return stagingBytes(MakeMeshDataView(data));
+    }
+
+    VkDeviceSize MeshAsset::stagingBytes(const MeshDataView &data)
+    {
+        return StagingFootprint(static_cast<VkDeviceSize>(data.vertexByteSize)) +
+               StagingFootprint(static_cast<VkDeviceSize>(data.indexByteSize));
+    }
+
     void MeshAsset::destroy(VkDevice device)
     {
+        if (m_pool)
+        {
+            m_pool->free(m_vertexRange);
+            m_pool->free(m_indexRange);
+            m_pool = nullptr;
+        }
         DestroyVertexBuffer(device, m_vb);
         DestroyIndexBuffer(device, m_ib);
         m_indexCount = 0;
+        m_firstIndex = 0;
+        m_vertexOffset = 0;
     }
 
 } // namespace Engine
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "Engine/VulkanContext.h"
 #include "Engine/SwapChain.h"
 #include "Engine/PerformanceMonitor.h"
+#include "assets/MeshFormats.h"
+#include <cstddef>
 #include <stdexcept>
 #include <iostream>
 
@@ -67,7 +69,8 @@ namespace Engine
         }
         pci.pipelineLayout = m_pipelineLayout;
 
-        // Vertex input: binding 0, stride 32; pos3, norm3, uv2
+        // Vertex input: binding 0, stride 32; pos3, norm3, uv2 (float), or the 16-byte
+        // SMeshVertexCompact (half4 / snorm8x4 / half2), which fetch converts to the same inputs
         VkVertexInputBindingDescription bindingDesc{};
         bindingDesc.binding = 0;
         bindingDesc.stride = 32;
@@ -87,6 +90,14 @@ namespace Engine
         attrs[2].format = VK_FORMAT_R32G32_SFLOAT;
         attrs[2].offset = 24;
 
+        VkVertexInputBindingDescription compactBinding = bindingDesc;
+        compactBinding.stride = sizeof(SMeshVertexCompact);
+
+        VkVertexInputAttributeDescription compactAttrs[3]{};
+        compactAttrs[0] = {0, 0, VK_FORMAT_R16G16B16A16_SFLOAT, static_cast<uint32_t>(offsetof(SMeshVertexCompact, position))};
+        compactAttrs[1] = {1, 0, VK_FORMAT_R8G8B8A8_SNORM, static_cast<uint32_t>(offsetof(SMeshVertexCompact, normal))};
+        compactAttrs[2] = {2, 0, VK_FORMAT_R16G16_SFLOAT, static_cast<uint32_t>(offsetof(SMeshVertexCompact, uv))};
+
         VkPipelineVertexInputStateCreateInfo vi{};
         vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
         vi.vertexBindingDescriptionCount = 1;
@@ -121,6 +132,12 @@ namespace Engine
         pci.dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
 
         VkResult r = m_pipeline.create(pci);
+        if (r == VK_SUCCESS)
+        {
+            pci.vertexInput.pVertexBindingDescriptions = &compactBinding;
+            pci.vertexInput.pVertexAttributeDescriptions = compactAttrs;
+            r = m_pipelineCompact.create(pci);
+        }
 
         vkDestroyShaderModule(pci.device, vert, nullptr);
         vkDestroyShaderModule(pci.device, frag, nullptr);
@@ -145,7 +162,10 @@ namespace Engine
             return;
         }
 
-        m_pipeline.bind(cmd);
+        if (m_binding.vertexStride == sizeof(SMeshVertexCompact))
+            m_pipelineCompact.bind(cmd);
+        else
+            m_pipeline.bind(cmd);
 
         VkViewport vp{0.0f, 0.0f, static_cast<float>(m_extent.width), static_cast<float>(m_extent.height), 0.0f, 1.0f};
         VkRect2D sc{{0, 0}, {m_extent.width, m_extent.height}};
@@ -179,6 +199,7 @@ namespace Engine
             m_pipelineLayout = VK_NULL_HANDLE;
         }
         m_pipeline.destroy(m_device);
+        m_pipelineCompact.destroy(m_device);
     }
 
     void MeshRenderPassModule::onDestroy(VulkanContext &ctx)
@@ -0,0 +1,345 @@
+#include "assets/ModelBuild.h"
+
+// Needed for glm/gtx/* headers (matrix_decompose)
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtx/matrix_decompose.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+const float TARGET = 10.0f; // Target size of models after scaling
+namespace Engine
+{
+    static ModelAsset::NodeTRS DecomposeTRS(const glm::mat4 &m)
+    {
+        ModelAsset::NodeTRS out{};
+        glm::vec3 skew;
+        glm::vec4 perspective;
+        glm::decompose(m, out.s, out.r, out.t, skew, perspective);
+        out.r = glm::normalize(out.r);
+        return out;
+    }
+
+    bool buildModelFromView(const smodel::SModelFileView &view, float animationBakeRate, ModelAsset &model,
+                            std::string &outError)
+    {
+        // Initialize bounds as invalid until we see a mesh
+        model.hasBounds = false;
+        model.fitScale = 1.0f;
+        model.center[0] = model.center[1] = model.center[2] = 0.0f;
+        model.boundsMin[0] = model.boundsMin[1] = model.boundsMin[2] = 0.0f;
+        model.boundsMax[0] = model.boundsMax[1] = model.boundsMax[2] = 0.0f;
+
+        // --------------------------
+        // Primitive ranges (relative to their mesh; handles are bound by the caller)
+        // --------------------------
+        model.primitives.resize(view.primitiveCount());
+
+        uint32_t lodCursor = 0;
+        for (uint32_t i = 0; i < view.primitiveCount(); i++)
+        {
+            const auto &p = view.primitives[i];
+
+            ModelPrimitive prim;
+            prim.firstIndex = p.firstIndex;
+            prim.indexCount = p.indexCount;
+            prim.vertexOffset = p.vertexOffset;
+            prim.skinIndex = p.skinIndex;
+
+            // LOD records are grouped by primitive, in primitive order
+            while (lodCursor < view.primitiveLodCount() && view.primitiveLods[lodCursor].primitiveIndex <= i)
+            {
+                const auto &lod = view.primitiveLods[lodCursor++];
+                if (lod.primitiveIndex == i && prim.lodCount < ModelPrimitive::kMaxLods)
+                    prim.lods[prim.lodCount++] = ModelPrimitive::Lod{lod.firstIndex, lod.indexCount, lod.error};
+            }
+
+            model.primitives[i] = prim;
+
+            // Expand model bounds from mesh bounds
+            if (p.meshIndex >= view.meshCount())
+                continue;
+            const float *mn = view.meshes[p.meshIndex].aabbMin;
+            const float *mx = view.meshes[p.meshIndex].aabbMax;
+
+            if (!model.hasBounds)
+            {
+                std::memcpy(model.boundsMin, mn, sizeof(model.boundsMin));
+                std::memcpy(model.boundsMax, mx, sizeof(model.boundsMax));
+                model.hasBounds = true;
+            }
+            else
+            {
+                model.boundsMin[0] = std::min(model.boundsMin[0], mn[0]);
+                model.boundsMin[1] = std::min(model.boundsMin[1], mn[1]);
+                model.boundsMin[2] = std::min(model.boundsMin[2], mn[2]);
+
+                model.boundsMax[0] = std::max(model.boundsMax[0], mx[0]);
+                model.boundsMax[1] = std::max(model.boundsMax[1], mx[1]);
+                model.boundsMax[2] = std::max(model.boundsMax[2], mx[2]);
+            }
+        }
+
+        // --------------------------
+        // V4: Populate skin tables (optional)
+        // --------------------------
+        if (view.skinCount() > 0)
+        {
+            model.skins.resize(view.skinCount());
+            model.totalJointCount = 0;
+
+            for (uint32_t si = 0; si < view.skinCount(); ++si)
+            {
+                const auto &sr = view.skins[si];
+                ModelAsset::ModelSkin skin{};
+                skin.debugName = view.getStringOrEmpty(sr.nameStrOffset);
+                skin.jointBase = model.totalJointCount;
+                skin.jointCount = sr.jointCount;
+
+                // Validate and copy joint node indices slice
+                if (sr.jointCount > 0)
+                {
+                    if (sr.firstJointNodeIndex + sr.jointCount > view.skinJointNodeIndicesCount())
+                    {
+                        outError = "Skin jointNodeIndices out of range (skinIndex=" + std::to_string(si) + ")";
+                        return false;
+                    }
+
+                    const uint32_t *srcJ = view.skinJointNodeIndices + sr.firstJointNodeIndex;
+                    skin.jointNodeIndices.assign(srcJ, srcJ + sr.jointCount);
+
+                    // Validate inverse bind matrices
+                    const uint64_t neededFloats = uint64_t(sr.jointCount) * 16ull;
+                    if (uint64_t(sr.firstInverseBindMatrix) + neededFloats > view.skinInverseBindMatricesCount())
+                    {
+                        outError = "Skin inverseBindMatrices out of range (skinIndex=" + std::to_string(si) + ")";
+                        return false;
+                    }
+
+                    skin.inverseBind.resize(sr.jointCount);
+                    const float *srcM = view.skinInverseBindMatrices + sr.firstInverseBindMatrix;
+                    for (uint32_t j = 0; j < sr.jointCount; ++j)
+                    {
+                        std::memcpy(glm::value_ptr(skin.inverseBind[j]), srcM + size_t(j) * 16u, sizeof(float) * 16u);
+                    }
+                }
+
+                model.skins[si] = std::move(skin);
+                model.totalJointCount += sr.jointCount;
+            }
+        }
+        else
+        {
+            model.skins.clear();
+            model.totalJointCount = 0;
+        }
+
+        // Precompute center and fit scale to 20 units if bounds are valid
+        if (model.hasBounds)
+        {
+            model.center[0] = 0.5f * (model.boundsMin[0] + model.boundsMax[0]);
+            model.center[1] = 0.5f * (model.boundsMin[1] + model.boundsMax[1]);
+            model.center[2] = 0.5f * (model.boundsMin[2] + model.boundsMax[2]);
+
+            const float sizeX = model.boundsMax[0] - model.boundsMin[0];
+            const float sizeY = model.boundsMax[1] - model.boundsMin[1];
+            const float sizeZ = model.boundsMax[2] - model.boundsMin[2];
+            const float maxExtent = std::max(sizeX, std::max(sizeY, sizeZ));
+
+            const float target = TARGET;
+            const float epsilon = 1e-4f;
+            if (maxExtent > epsilon)
+                model.fitScale = target / maxExtent;
+            else
+                model.fitScale = 4.0f;
+        }
+
+        // --------------------------
+        // V2: Populate nodes and primitive index mapping
+        // --------------------------
+        if (view.nodeCount() > 0)
+        {
+            model.nodes.resize(view.nodeCount());
+            model.nodePrimitiveIndices.resize(view.nodePrimitiveIndexCount());
+            model.nodeChildIndices.resize(view.nodeChildIndexCount());
+
+            // Copy primitive indices array
+            if (view.nodePrimitiveIndexCount() > 0 && view.nodePrimitiveIndices)
+            {
+                std::memcpy(model.nodePrimitiveIndices.data(), view.nodePrimitiveIndices, sizeof(uint32_t) * view.nodePrimitiveIndexCount());
+            }
+
+            // Copy child indices array
+            if (view.nodeChildIndexCount() > 0 && view.nodeChildIndices)
+            {
+                std::memcpy(model.nodeChildIndices.data(), view.nodeChildIndices, sizeof(uint32_t) * view.nodeChildIndexCount());
+            }
+
+            // Track first root (parentIndex == UINT32_MAX)
+            uint32_t rootIdx = 0;
+            const uint32_t U32_MAX = ~0u;
+
+            for (uint32_t i = 0; i < view.nodeCount(); ++i)
+            {
+                const Engine::smodel::SModelNodeRecord &nr = view.nodes[i];
+                ModelAsset::ModelNode &dst = model.nodes[i];
+
+                dst.parentIndex = nr.parentIndex;
+                dst.firstChildIndex = nr.childCount ? nr.firstChildIndex : U32_MAX;
+                dst.childCount = nr.childCount;
+                dst.firstPrimitiveIndex = nr.firstPrimitiveIndex;
+                dst.primitiveCount = nr.primitiveCount;
+                dst.debugName = view.getStringOrEmpty(nr.nameStrOffset);
+
+                // Copy local matrix (column-major)
+                std::memcpy(glm::value_ptr(dst.localMatrix), nr.localMatrix, sizeof(nr.localMatrix));
+
+                // Defer global computation; ordering is not guaranteed.
+                dst.globalMatrix = glm::mat4(1.0f);
+
+                if (nr.parentIndex == U32_MAX)
+                    rootIdx = i;
+            }
+
+            model.rootNodeIndex = rootIdx;
+
+            // Parent-before-child order from the explicit child lists (supports any node ordering).
+            model.buildNodeOrder();
+            model.recomputeGlobals();
+
+            // Recompute bounds in node-global space (node transforms applied)
+            bool firstCorner = true;
+            glm::vec3 bmin(0.0f);
+            glm::vec3 bmax(0.0f);
+
+            for (const auto &node : model.nodes)
+            {
+                if (node.primitiveCount == 0)
+                    continue;
+
+                for (uint32_t k = 0; k < node.primitiveCount; ++k)
+                {
+                    const uint32_t primIndex = model.nodePrimitiveIndices[node.firstPrimitiveIndex + k];
+                    if (primIndex >= model.primitives.size())
+                        continue;
+
+                    const uint32_t meshIndex = view.primitives[primIndex].meshIndex;
+                    if (meshIndex >= view.meshCount())
+                        continue;
+
+                    const float *mn = view.meshes[meshIndex].aabbMin;
+                    const float *mx = view.meshes[meshIndex].aabbMax;
+
+                    const glm::vec3 c0(mn[0], mn[1], mn[2]);
+                    const glm::vec3 c1(mx[0], mn[1], mn[2]);
+                    const glm::vec3 c2(mn[0], mx[1], mn[2]);
+                    const glm::vec3 c3(mx[0], mx[1], mn[2]);
+                    const glm::vec3 c4(mn[0], mn[1], mx[2]);
+                    const glm::vec3 c5(mx[0], mn[1], mx[2]);
+                    const glm::vec3 c6(mn[0], mx[1], mx[2]);
+                    const glm::vec3 c7(mx[0], mx[1], mx[2]);
+
+                    const glm::vec3 corners[8] = {c0, c1, c2, c3, c4, c5, c6, c7};
+                    for (const glm::vec3 &corner : corners)
+                    {
+                        const glm::vec4 w = node.globalMatrix * glm::vec4(corner, 1.0f);
+                        const glm::vec3 p(w.x, w.y, w.z);
+                        if (firstCorner)
+                        {
+                            bmin = p;
+                            bmax = p;
+                            firstCorner = false;
+                        }
+                        else
+                        {
+                            bmin.x = std::min(bmin.x, p.x);
+                            bmin.y = std::min(bmin.y, p.y);
+                            bmin.z = std::min(bmin.z, p.z);
+                            bmax.x = std::max(bmax.x, p.x);
+                            bmax.y = std::max(bmax.y, p.y);
+                            bmax.z = std::max(bmax.z, p.z);
+                        }
+                    }
+                }
+            }
+
+            if (!firstCorner)
+            {
+                model.boundsMin[0] = bmin.x;
+                model.boundsMin[1] = bmin.y;
+                model.boundsMin[2] = bmin.z;
+                model.boundsMax[0] = bmax.x;
+                model.boundsMax[1] = bmax.y;
+                model.boundsMax[2] = bmax.z;
+                model.hasBounds = true;
+
+                model.center[0] = 0.5f * (model.boundsMin[0] + model.boundsMax[0]);
+                model.center[1] = 0.5f * (model.boundsMin[1] + model.boundsMax[1]);
+                model.center[2] = 0.5f * (model.boundsMin[2] + model.boundsMax[2]);
+
+                const float sizeX = model.boundsMax[0] - model.boundsMin[0];
+                const float sizeY = model.boundsMax[1] - model.boundsMin[1];
+                const float sizeZ = model.boundsMax[2] - model.boundsMin[2];
+                const float maxExtent = std::max(sizeX, std::max(sizeY, sizeZ));
+
+                const float target = TARGET;
+                const float epsilon = 1e-4f;
+                model.fitScale = (maxExtent > epsilon) ? (target / maxExtent) : 1.0f;
+            }
+        }
+
+        // --------------------------
+        // V3: Copy animations into ModelAsset (node TRS only)
+        // --------------------------
+        if (view.animClipCount() > 0)
+        {
+            model.animClips.resize(view.animClipCount());
+            std::memcpy(model.animClips.data(), view.animClips, sizeof(smodel::SModelAnimationClipRecord) * view.animClipCount());
+        }
+        if (view.animChannelCount() > 0)
+        {
+            model.animChannels.resize(view.animChannelCount());
+            std::memcpy(model.animChannels.data(), view.animChannels, sizeof(smodel::SModelAnimationChannelRecord) * view.animChannelCount());
+        }
+        if (view.animSamplerCount() > 0)
+        {
+            model.animSamplers.resize(view.animSamplerCount());
+            std::memcpy(model.animSamplers.data(), view.animSamplers, sizeof(smodel::SModelAnimationSamplerRecord) * view.animSamplerCount());
+        }
+        if (view.animTimesCount() > 0)
+        {
+            model.animTimes.resize(view.animTimesCount());
+            std::memcpy(model.animTimes.data(), view.animTimes, sizeof(float) * view.animTimesCount());
+        }
+        if (view.animValuesCount() > 0)
+        {
+            model.animValues.resize(view.animValuesCount());
+            std::memcpy(model.animValues.data(), view.animValues, sizeof(float) * view.animValuesCount());
+        }
+        if (view.animPackedSize() > 0)
+            model.animPacked.assign(view.animPacked, view.animPacked + view.animPackedSize());
+
+        // --------------------------
+        // Initialize runtime animation TRS buffers from node local matrices
+        // --------------------------
+        model.restTRS.resize(model.nodes.size());
+        model.animatedTRS.resize(model.nodes.size());
+        for (size_t i = 0; i < model.nodes.size(); i++)
+        {
+            const glm::mat4 local = model.nodes[i].localMatrix;
+            model.restTRS[i] = DecomposeTRS(local);
+            model.animatedTRS[i] = model.restTRS[i];
+        }
+        model.buildClipTables();
+        model.bakeClips(animationBakeRate);
+
+        model.animState.clipIndex = 0;
+        model.animState.timeSec = 0.0f;
+        model.animState.loop = true;
+        model.animState.playing = true;
+
+        return true;
+    }
+}
@@ -2,12 +2,15 @@
 #include "Engine/VulkanContext.h"
 #include "Engine/Renderer.h"
 #include "Engine/Window.h"
+#include "Engine/GpuAllocator.h"
+#include "Engine/FrameArena.h"
 
 #include <imgui.h>
 #include <algorithm>
 #include <numeric>
 #include <atomic>
 #include <cmath>
+#include <cstdio>
 
 namespace Engine
 {
@@ -47,10 +50,43 @@ namespace Engine
         m_window = window;
         m_initialized = true;
         m_frameTimeHistory.clear();
+
+        m_telemetryReport = Telemetry::Registration([this](const Telemetry::Config &, std::vector<Telemetry::Metric> &out)
+                                                    {
+            auto push = [&out](const char *name, double value, const char *labelKey = nullptr, std::string labelValue = {})
+            {
+                Telemetry::Metric m;
+                m.name = name;
+                if (labelKey)
+                {
+                    m.labelKey = labelKey;
+                    m.labelValue = std::move(labelValue);
+                }
+                m.value = value;
+                out.push_back(std::move(m));
+            };
+
+            push("draw_calls", m_lastFrameDrawCalls);
+            if (m_renderer)
+            {
+                push("gpu_frame_ms", m_gpuTimeMs);
+                for (const GpuProfiler::TimerResult &r : m_renderer->getGpuPassTimings())
+                    push("gpu_pass_ms", r.avgMs, "pass", r.name);
+            }
+            if (GpuAllocator *allocator = m_ctx ? GpuAllocator::find(m_ctx->GetDevice()) : nullptr)
+            {
+                const std::vector<GpuAllocator::HeapBudget> heaps = allocator->heapBudgets();
+                for (size_t h = 0; h < heaps.size(); ++h)
+                {
+                    push("gpu_heap_usage_bytes", static_cast<double>(heaps[h].usage), "heap", std::to_string(h));
+                    push("gpu_heap_budget_bytes", static_cast<double>(heaps[h].budget), "heap", std::to_string(h));
+                }
+            } });
     }
 
     void PerformanceMonitor::cleanup()
     {
+        m_telemetryReport.reset();
         m_initialized = false;
         m_frameTimeHistory.clear();
     }
@@ -82,6 +118,10 @@ namespace Engine
         // Get draw call count from global counter
         m_lastFrameDrawCalls = DrawCallCounter::get();
 
+        // Frame boundary for PERF_SCOPE totals (all threads)
+        CpuProfiler::collectFrame();
+        Telemetry::recordFrame(frameTimeMs);
+
         // Get GPU time from renderer if available
         if (m_renderer)
         {
@@ -107,6 +147,9 @@ namespace Engine
         }
 
         m_frameTimeMs = frameTimeMs;
+
+        // Exports at its own interval, after this frame's CPU scopes are collected
+        Telemetry::update();
     }
 
     void PerformanceMonitor::recordDrawCall(uint32_t primitiveCount)
@@ -142,6 +185,15 @@ namespace Engine
 
         // Calculate percentile FPS
         calculatePercentileFPS();
+
+        CpuProfiler::snapshot(m_scopeStats);
+
+        if (m_renderer)
+            m_gpuPassStats = m_renderer->getGpuPassTimings();
+
+        MemoryStats::collect(m_memoryCounters, m_memoryTotals);
+        if (GpuAllocator *allocator = m_ctx ? GpuAllocator::find(m_ctx->GetDevice()) : nullptr)
+            m_heapBudgets = allocator->heapBudgets();
     }
 
     void PerformanceMonitor::calculatePercentileFPS()
@@ -153,12 +205,14 @@ namespace Engine
             return;
         }
 
-        // Copy and sort frame times (descending - longest times first = worst frames)
-        std::vector<float> sortedTimes(m_frameTimeHistory.begin(), m_frameTimeHistory.end());
-        std::sort(sortedTimes.begin(), sortedTimes.end(), std::greater<float>());
+        // Copy frame times into frame scratch; only the worst 1% need to be sorted (descending).
+        FrameArena::Scope scratch;
+        FrameVector<float> sortedTimes(m_frameTimeHistory.begin(), m_frameTimeHistory.end(), ArenaAllocator<float>(scratch.arena()));
+        size_t onePercentCount = std::max(static_cast<size_t>(1), sortedTimes.size() / 100);
+        std::partial_sort(sortedTimes.begin(), sortedTimes.begin() + static_cast<std::ptrdiff_t>(onePercentCount),
+                          sortedTimes.end(), std::greater<float>());
 
         // 1% low = average of worst 1% of frames
-        size_t onePercentCount = std::max(static_cast<size_t>(1), sortedTimes.size() / 100);
         float sum1Percent = 0.0f;
         for (size_t i = 0; i < onePercentCount; ++i)
         {
@@ -192,6 +246,131 @@ namespace Engine
         return 0;
     }
 
+    void PerformanceMonitor::renderScopeBreakdown()
+    {
+        if (m_scopeStats.empty())
+            return;
+
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 1.0f, 0.4f, 1.0f));
+        ImGui::Text("CPU Scopes (ms)");
+        ImGui::PopStyleColor();
+        ImGui::TextDisabled("  %-28s %6s %6s %6s %6s", "", "avg", "p50", "p95", "p99");
+
+        // Times are summed over threads, so parallel children can exceed their parent.
+        for (const CpuProfiler::NodeStats &s : m_scopeStats)
+        {
+            const int indent = static_cast<int>(s.depth) * 2;
+            const int nameWidth = std::max(1, 28 - indent + 2);
+            const bool slow = s.p95Ms > 2.0f * std::max(s.p50Ms, 0.01f) && s.p95Ms > 0.5f;
+            if (slow)
+                ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.6f, 0.3f, 1.0f)); // spiky
+            ImGui::Text("%*s%-*s %6.2f %6.2f %6.2f %6.2f", indent, "", nameWidth, s.name,
+                        s.avgMs, s.p50Ms, s.p95Ms, s.p99Ms);
+            if (slow)
+                ImGui::PopStyleColor();
+        }
+
+        ImGui::Spacing();
+    }
+
+    void PerformanceMonitor::renderGpuPassBreakdown()
+    {
+        if (m_gpuPassStats.empty())
+            return;
+
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 1.0f, 0.4f, 1.0f));
+        ImGui::Text("GPU Passes (ms)");
+        ImGui::PopStyleColor();
+
+        const bool anyStats = std::any_of(m_gpuPassStats.begin(), m_gpuPassStats.end(),
+                                          [](const GpuProfiler::TimerResult &r) { return r.hasStats; });
+        if (anyStats)
+            ImGui::TextDisabled("  %-22s %6s %6s %9s %9s %9s", "", "avg", "last", "VS", "FS", "CS");
+        else
+            ImGui::TextDisabled("  %-22s %6s %6s", "", "avg", "last");
+
+        for (const GpuProfiler::TimerResult &r : m_gpuPassStats)
+        {
+            char name[48];
+            if (r.count > 1)
+                std::snprintf(name, sizeof(name), "%s x%u", r.name.c_str(), r.count);
+            else
+                std::snprintf(name, sizeof(name), "%s", r.name.c_str());
+
+            if (r.hasStats)
+            {
+                ImGui::Text("  %-22s %6.2f %6.2f %9llu %9llu %9llu", name, r.avgMs, r.ms,
+                            static_cast<unsigned long long>(r.stats.vertexShaderInvocations),
+                            static_cast<unsigned long long>(r.stats.fragmentShaderInvocations),
+                            static_cast<unsigned long long>(r.stats.computeShaderInvocations));
+            }
+            else
+            {
+                ImGui::Text("  %-22s %6.2f %6.2f", name, r.avgMs, r.ms);
+            }
+        }
+
+        ImGui::Spacing();
+    }
+
+    void PerformanceMonitor::renderMemoryBreakdown()
+    {
+        if (m_heapBudgets.empty() && m_memoryTotals.empty())
+            return;
+
+        constexpr double kMiB = 1024.0 * 1024.0;
+        const ImVec4 red(1.0f, 0.4f, 0.4f, 1.0f);
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 1.0f, 0.4f, 1.0f));
+        ImGui::Text("Memory (MiB)");
+        ImGui::PopStyleColor();
+
+        // Usage past 90% of the driver's budget is where evictions and stalls start.
+        for (size_t h = 0; h < m_heapBudgets.size(); ++h)
+        {
+            const GpuAllocator::HeapBudget &b = m_heapBudgets[h];
+            const bool tight = b.budget > 0 && b.usage * 10 > b.budget * 9;
+            if (tight)
+                ImGui::PushStyleColor(ImGuiCol_Text, red);
+            ImGui::Text("  Heap %zu %-6s %8.1f / %8.1f (engine %.1f)%s", h, b.deviceLocal ? "VRAM" : "system",
+                        static_cast<double>(b.usage) / kMiB, static_cast<double>(b.budget) / kMiB,
+                        static_cast<double>(b.allocatorBytes) / kMiB, b.fromDriver ? "" : " *");
+            if (tight)
+                ImGui::PopStyleColor();
+        }
+        if (!m_heapBudgets.empty() && !m_heapBudgets.front().fromDriver)
+            ImGui::TextDisabled("  * no VK_EXT_memory_budget: heap size / engine reservation");
+
+        if (!m_memoryTotals.empty())
+            ImGui::TextDisabled("  %-22s %8s %8s %8s", "", "CPU", "GPU", "peak");
+        for (const MemoryStats::SubsystemTotal &t : m_memoryTotals)
+        {
+            if (t.overBudget)
+                ImGui::PushStyleColor(ImGuiCol_Text, red);
+            char label[48];
+            std::snprintf(label, sizeof(label), "%s##mem", t.subsystem.c_str());
+            const bool open = ImGui::TreeNode(label, "%-20s %8.1f %8.1f %8.1f", t.subsystem.c_str(),
+                                              static_cast<double>(t.cpuBytes) / kMiB, static_cast<double>(t.gpuBytes) / kMiB,
+                                              static_cast<double>(t.peakBytes) / kMiB);
+            if (t.overBudget)
+                ImGui::PopStyleColor();
+            if (!open)
+                continue;
+
+            if (t.budgetBytes > 0)
+                ImGui::TextDisabled("  budget %.1f", static_cast<double>(t.budgetBytes) / kMiB);
+            for (const MemoryStats::Counter &c : m_memoryCounters)
+            {
+                if (c.subsystem != t.subsystem)
+                    continue;
+                ImGui::Text("  %-18.18s %8.2f %8.2f %8.2f", c.name.c_str(), static_cast<double>(c.cpuBytes) / kMiB,
+                            static_cast<double>(c.gpuBytes) / kMiB, static_cast<double>(c.peakBytes) / kMiB);
+            }
+            ImGui::TreePop();
+        }
+
+        ImGui::Spacing();
+    }
+
     void PerformanceMonitor::renderOverlay()
     {
         if (!m_visible || !m_initialized)
@@ -285,6 +464,31 @@ namespace Engine
             ImGui::Text("  Draw Calls: %u", m_lastFrameDrawCalls);
 
             ImGui::Spacing();
+
+            renderScopeBreakdown();
+            renderGpuPassBreakdown();
+
+            // GPU memory (engine allocator)
+            if (GpuAllocator *allocator = m_ctx ? GpuAllocator::find(m_ctx->GetDevice()) : nullptr)
+            {
+                const GpuAllocator::Stats stats = allocator->stats();
+                constexpr double kMiB = 1024.0 * 1024.0;
+                ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 1.0f, 0.4f, 1.0f));
+                ImGui::Text("GPU Memory");
+                ImGui::PopStyleColor();
+                ImGui::Text("  VRAM used: %.1f MiB", static_cast<double>(stats.usedDeviceLocalBytes) / kMiB);
+                ImGui::Text("  Reserved:  %.1f MiB (%u blocks, %u allocs)",
+                            static_cast<double>(stats.reservedBytes) / kMiB, stats.deviceMemoryCount, stats.allocationCount);
+                for (size_t c = 0; c < static_cast<size_t>(GpuMemoryCategory::Count); ++c)
+                {
+                    if (stats.usedBytes[c] == 0)
+                        continue;
+                    ImGui::TextDisabled("    %-12s %.1f MiB", gpuMemoryCategoryName(static_cast<GpuMemoryCategory>(c)),
+                                        static_cast<double>(stats.usedBytes[c]) / kMiB);
+                }
+                ImGui::Spacing();
+            }
+            renderMemoryBreakdown();
             ImGui::Separator();
             ImGui::TextDisabled("Press F1 to toggle");
         }
@@ -1,4 +1,5 @@
 #include "Engine/Pipeline.h"
+#include "Engine/PipelineCache.h"
 #include <fstream>
 #include <stdexcept>
 #include <vector>
@@ -188,7 +189,8 @@ namespace Engine
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
         pipelineInfo.basePipelineIndex = -1;
 
-        VkResult res = vkCreateGraphicsPipelines(device, info.pipelineCache, 1, &pipelineInfo, nullptr, &m_pipeline);
+        const VkPipelineCache cache = (info.pipelineCache != VK_NULL_HANDLE) ? info.pipelineCache : PipelineCache::get(device);
+        VkResult res = vkCreateGraphicsPipelines(device, cache, 1, &pipelineInfo, nullptr, &m_pipeline);
         if (res != VK_SUCCESS)
         {
             if (m_ownsLayout && layout != VK_NULL_HANDLE)
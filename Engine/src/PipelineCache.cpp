@@ -0,0 +1,158 @@
+#include "Engine/PipelineCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+namespace Engine
+{
+    namespace
+    {
+        struct Entry
+        {
+            VkDevice device = VK_NULL_HANDLE;
+            VkPipelineCache cache = VK_NULL_HANDLE;
+            std::string path;
+        };
+
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<Entry> entries;
+        };
+
+        Registry &registry()
+        {
+            static Registry r;
+            return r;
+        }
+
+        // VkPipelineCacheHeaderVersionOne, read field by field (the blob has no alignment guarantee).
+        bool headerMatches(const std::vector<char> &data, const VkPhysicalDeviceProperties &props)
+        {
+            constexpr size_t kHeaderSize = 16 + VK_UUID_SIZE;
+            if (data.size() < kHeaderSize)
+                return false;
+
+            uint32_t headerLength = 0, headerVersion = 0, vendorID = 0, deviceID = 0;
+            std::memcpy(&headerLength, data.data() + 0, 4);
+            std::memcpy(&headerVersion, data.data() + 4, 4);
+            std::memcpy(&vendorID, data.data() + 8, 4);
+            std::memcpy(&deviceID, data.data() + 12, 4);
+
+            return headerLength >= kHeaderSize && headerLength <= data.size() &&
+                   headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                   vendorID == props.vendorID && deviceID == props.deviceID &&
+                   std::memcmp(data.data() + 16, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        }
+    }
+
+    void PipelineCache::open(VkDevice device, VkPhysicalDevice physicalDevice, const std::string &path)
+    {
+        if (get(device) != VK_NULL_HANDLE)
+            return;
+
+        std::vector<char> data;
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (file.is_open())
+                data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(physicalDevice, &props);
+        if (!data.empty() && !headerMatches(data, props))
+        {
+            std::cout << "[PipelineCache] " << path << " is from another device or driver, starting empty\n";
+            data.clear();
+        }
+
+        VkPipelineCacheCreateInfo ci{};
+        ci.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        ci.initialDataSize = data.size();
+        ci.pInitialData = data.empty() ? nullptr : data.data();
+
+        VkPipelineCache cache = VK_NULL_HANDLE;
+        VkResult r = vkCreatePipelineCache(device, &ci, nullptr, &cache);
+        if (r != VK_SUCCESS && !data.empty())
+        {
+            // Drivers may still reject a matching header (corrupt body); retry empty.
+            ci.initialDataSize = 0;
+            ci.pInitialData = nullptr;
+            r = vkCreatePipelineCache(device, &ci, nullptr, &cache);
+        }
+        if (r != VK_SUCCESS)
+        {
+            std::cerr << "[PipelineCache] vkCreatePipelineCache failed, pipelines will compile uncached\n";
+            return;
+        }
+
+        std::cout << "[PipelineCache] " << (data.empty() ? "created empty" : "loaded " + std::to_string(data.size()) + " bytes")
+                  << " (" << path << ")\n";
+
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.entries.push_back({device, cache, path});
+    }
+
+    VkPipelineCache PipelineCache::get(VkDevice device)
+    {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (const Entry &e : reg.entries)
+        {
+            if (e.device == device)
+                return e.cache;
+        }
+        return VK_NULL_HANDLE;
+    }
+
+    void PipelineCache::close(VkDevice device)
+    {
+        Entry entry;
+        {
+            Registry &reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            auto it = std::find_if(reg.entries.begin(), reg.entries.end(),
+                                   [device](const Entry &e)
+                                   { return e.device == device; });
+            if (it == reg.entries.end())
+                return;
+            entry = *it;
+            reg.entries.erase(it);
+        }
+
+        size_t size = 0;
+        std::vector<char> data;
+        if (vkGetPipelineCacheData(device, entry.cache, &size, nullptr) == VK_SUCCESS && size > 0)
+        {
+            data.resize(size);
+            if (vkGetPipelineCacheData(device, entry.cache, &size, data.data()) != VK_SUCCESS)
+                data.clear();
+            data.resize(std::min(size, data.size()));
+        }
+        vkDestroyPipelineCache(device, entry.cache, nullptr);
+
+        if (data.empty())
+            return;
+
+        // Write next to the target and rename, so a crash mid-write never leaves a torn cache behind.
+        const std::string tmpPath = entry.path + ".tmp";
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open() || !file.write(data.data(), static_cast<std::streamsize>(data.size())))
+            {
+                std::cerr << "[PipelineCache] cannot write " << tmpPath << "\n";
+                return;
+            }
+        }
+        std::remove(entry.path.c_str());
+        if (std::rename(tmpPath.c_str(), entry.path.c_str()) != 0)
+            std::cerr << "[PipelineCache] cannot replace " << entry.path << "\n";
+    }
+}
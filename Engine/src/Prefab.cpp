@@ -0,0 +1,424 @@
+#include "ECS/Prefab.h"
+
+#include "utils/MappedFile.h"
+
+#include <nlohmann/json.hpp>
+
+#include <cstring>
+#include <filesystem>
+
+namespace Engine::ECS
+{
+    namespace
+    {
+        using json = nlohmann::json;
+
+        // ------------------------------------------------------------
+        // .sprefab layout (native byte order, no alignment)
+        // ------------------------------------------------------------
+        //   FileHeader, name, model path
+        //   componentCount x { uint32 nameLength, name }
+        //   defaultCount   x { uint32 nameLength, uint32 valueSize, name, value bytes }
+
+        constexpr char kMagic[8] = {'S', 'T', 'R', 'P', 'F', 'A', 'B', '\0'};
+        constexpr uint32_t kByteOrder = 0x01020304u;
+
+        struct FileHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t byteOrder;
+            uint32_t nameLength;
+            uint32_t modelPathLength;
+            uint32_t componentCount;
+            uint32_t defaultCount;
+        };
+
+        class Writer
+        {
+        public:
+            explicit Writer(std::vector<uint8_t> &out) : m_out(out) {}
+
+            void bytes(const void *data, size_t size)
+            {
+                if (size == 0)
+                    return;
+                const size_t at = m_out.size();
+                m_out.resize(at + size);
+                std::memcpy(m_out.data() + at, data, size);
+            }
+
+            template <typename T>
+            void pod(const T &value) { bytes(&value, sizeof(T)); }
+
+        private:
+            std::vector<uint8_t> &m_out;
+        };
+
+        class Reader
+        {
+        public:
+            Reader(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+
+            const uint8_t *take(size_t size)
+            {
+                if (size > m_size - m_pos)
+                    return nullptr;
+                const uint8_t *p = m_data + m_pos;
+                m_pos += size;
+                return p;
+            }
+
+            template <typename T>
+            bool pod(T &value)
+            {
+                const uint8_t *p = take(sizeof(T));
+                if (p)
+                    std::memcpy(&value, p, sizeof(T));
+                return p != nullptr;
+            }
+
+            bool string(uint32_t length, std::string &out)
+            {
+                const uint8_t *p = take(length);
+                if (p)
+                    out.assign(reinterpret_cast<const char *>(p), length);
+                return p != nullptr;
+            }
+
+            bool atEnd() const { return m_pos == m_size; }
+            size_t remaining() const { return m_size - m_pos; }
+
+        private:
+            const uint8_t *m_data;
+            size_t m_size;
+            size_t m_pos = 0;
+        };
+
+        bool isVisualComponent(const std::string &name)
+        {
+            return name == "RenderModel" || name == "RenderAnimation";
+        }
+
+        // Load the model and add RenderModel / RenderAnimation (defaults: clip 0, time 0, looping, playing).
+        void applyVisual(Prefab &p, ComponentRegistry &registry, Engine::ModelSource *assets)
+        {
+            if (!assets || p.modelPath.empty())
+                return;
+
+            // Streams in the background; RenderSystem draws the placeholder until it's ready.
+            const Engine::ModelHandle h = assets->loadModelAsync(p.modelPath);
+            if (!h.isValid())
+            {
+                std::cerr << "[Prefab] Warning: Failed to load model mesh: " << p.modelPath << " for prefab " << p.name << "\n";
+                return;
+            }
+
+            const uint32_t rmId = registry.ensureId("RenderModel");
+            p.signature.set(rmId);
+            RenderModel rm{};
+            rm.handle = h;
+            p.defaults.set(rmId, rm);
+
+            const uint32_t raId = registry.ensureId("RenderAnimation");
+            p.signature.set(raId);
+            p.defaults.set(raId, RenderAnimation{});
+        }
+
+        // Resolve the archetype and drop defaults for components outside the signature.
+        void finishPrefab(Prefab &p, ArchetypeManager &archetypes)
+        {
+            p.archetypeId = archetypes.getOrCreate(p.signature);
+            if (!p.validateDefaults())
+                p.defaults.retain(p.signature);
+        }
+
+        float number(const json &object, const char *key, float fallback)
+        {
+            const auto it = object.find(key);
+            return (it != object.end() && it->is_number()) ? it->get<float>() : fallback;
+        }
+
+        // One reader per built-in default; missing fields keep the component's own default.
+        // Game components get theirs in code (Prefab::defaults.set) before PrefabManager::add.
+        void readDefault(const std::string &component, const json &v, Prefab &p, ComponentRegistry &registry)
+        {
+            if (!v.is_object())
+                return;
+
+            const uint32_t id = registry.ensureId(component);
+            if (component == "Position")
+            {
+                Position c{};
+                c.x = number(v, "x", c.x);
+                c.y = number(v, "y", c.y);
+                c.z = number(v, "z", c.z);
+                p.defaults.set(id, c);
+            }
+            else if (component == "Velocity")
+            {
+                Velocity c{};
+                c.x = number(v, "x", c.x);
+                c.y = number(v, "y", c.y);
+                c.z = number(v, "z", c.z);
+                p.defaults.set(id, c);
+            }
+            else if (component == "Health")
+            {
+                Health c{};
+                c.value = number(v, "value", c.value);
+                p.defaults.set(id, c);
+            }
+            else if (component == "MoveTarget")
+            {
+                MoveTarget c{};
+                c.x = number(v, "x", c.x);
+                c.y = number(v, "y", c.y);
+                c.z = number(v, "z", c.z);
+                c.active = static_cast<uint8_t>(number(v, "active", c.active));
+                p.defaults.set(id, c);
+            }
+            else if (component == "MoveSpeed")
+            {
+                MoveSpeed c{};
+                c.value = number(v, "value", c.value);
+                p.defaults.set(id, c);
+            }
+            else if (component == "Radius")
+            {
+                Radius c{};
+                c.r = number(v, "r", c.r);
+                p.defaults.set(id, c);
+            }
+            else if (component == "Separation")
+            {
+                Separation c{};
+                c.value = number(v, "value", c.value);
+                p.defaults.set(id, c);
+            }
+            else if (component == "AvoidanceParams")
+            {
+                AvoidanceParams c{};
+                c.strength = number(v, "strength", c.strength);
+                c.maxAccel = number(v, "maxAccel", c.maxAccel);
+                c.blend = number(v, "blend", c.blend);
+                p.defaults.set(id, c);
+            }
+            else
+            {
+                return; // game component without a JSON reader
+            }
+        }
+    }
+
+    Prefab loadPrefabFromJson(const std::string &jsonText,
+                              ComponentRegistry &registry,
+                              ArchetypeManager &archetypes,
+                              Engine::ModelSource *assets)
+    {
+        Prefab p;
+
+        const json j = json::parse(jsonText, nullptr, /*allow_exceptions=*/false);
+        if (!j.is_object())
+        {
+            std::cerr << "[Prefab] JSON parse error\n";
+            return p;
+        }
+
+        const auto name = j.find("name");
+        if (name != j.end() && name->is_string())
+            p.name = name->get<std::string>();
+
+        const auto components = j.find("components");
+        if (components != j.end() && components->is_array())
+        {
+            std::vector<std::string> names;
+            names.reserve(components->size());
+            for (const json &c : *components)
+            {
+                if (c.is_string())
+                    names.push_back(c.get<std::string>());
+            }
+            p.signature = buildSignatureFromNames(names, registry);
+        }
+
+        // Optional visuals. JSON schema: "visual": { "model": "path" , ... }
+        const auto visual = j.find("visual");
+        if (visual != j.end() && visual->is_object())
+        {
+            const auto model = visual->find("model");
+            if (model != visual->end() && model->is_string())
+                p.modelPath = model->get<std::string>();
+        }
+        applyVisual(p, registry, assets);
+
+        const auto defaults = j.find("defaults");
+        if (defaults != j.end() && defaults->is_object())
+        {
+            for (auto it = defaults->begin(); it != defaults->end(); ++it)
+                readDefault(it.key(), it.value(), p, registry);
+        }
+
+        finishPrefab(p, archetypes);
+        return p;
+    }
+
+    bool writePrefabBinary(const Prefab &prefab, const ComponentRegistry &registry, std::vector<uint8_t> &out)
+    {
+        out.clear();
+        if (prefab.name.empty())
+            return false;
+
+        // Visual components come back from the model path when the cooked prefab is loaded.
+        std::vector<uint32_t> componentIds;
+        for (uint32_t id = 0; id < registry.count(); ++id)
+        {
+            if (prefab.signature.has(id) && !isVisualComponent(registry.getName(id)))
+                componentIds.push_back(id);
+        }
+        uint32_t defaultCount = 0;
+        for (const RowTemplate::Value &v : prefab.defaults.values)
+        {
+            if (!isVisualComponent(registry.getName(v.componentId)))
+                ++defaultCount;
+        }
+
+        Writer w(out);
+        FileHeader header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = PrefabBinaryVersion;
+        header.byteOrder = kByteOrder;
+        header.nameLength = static_cast<uint32_t>(prefab.name.size());
+        header.modelPathLength = static_cast<uint32_t>(prefab.modelPath.size());
+        header.componentCount = static_cast<uint32_t>(componentIds.size());
+        header.defaultCount = defaultCount;
+        w.pod(header);
+        w.bytes(prefab.name.data(), prefab.name.size());
+        w.bytes(prefab.modelPath.data(), prefab.modelPath.size());
+
+        for (uint32_t id : componentIds)
+        {
+            const std::string &name = registry.getName(id);
+            w.pod(static_cast<uint32_t>(name.size()));
+            w.bytes(name.data(), name.size());
+        }
+
+        for (const RowTemplate::Value &v : prefab.defaults.values)
+        {
+            const std::string &name = registry.getName(v.componentId);
+            if (isVisualComponent(name))
+                continue;
+            w.pod(static_cast<uint32_t>(name.size()));
+            w.pod(v.size);
+            w.bytes(name.data(), name.size());
+            w.bytes(prefab.defaults.data(v), v.size);
+        }
+        return true;
+    }
+
+    Prefab loadPrefabFromBinary(const uint8_t *data, size_t size,
+                                ComponentRegistry &registry,
+                                ArchetypeManager &archetypes,
+                                Engine::ModelSource *assets)
+    {
+        Prefab p;
+        Reader r(data, size);
+
+        FileHeader header{};
+        if (!r.pod(header) || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+            header.version != PrefabBinaryVersion || header.byteOrder != kByteOrder)
+            return p;
+
+        std::string name;
+        if (!r.string(header.nameLength, name) || !r.string(header.modelPathLength, p.modelPath))
+            return Prefab{};
+
+        // Each component entry takes at least 4 bytes and each default at least 8: a corrupt count
+        // fails here (and the caller falls back to the JSON) instead of in a huge allocation.
+        if (header.componentCount > r.remaining() / 4 ||
+            header.defaultCount > (r.remaining() - static_cast<size_t>(header.componentCount) * 4) / 8)
+            return Prefab{};
+
+        std::vector<std::string> components(header.componentCount);
+        for (std::string &c : components)
+        {
+            uint32_t length = 0;
+            if (!r.pod(length) || !r.string(length, c))
+                return Prefab{};
+        }
+        p.signature = buildSignatureFromNames(components, registry);
+
+        std::string component;
+        for (uint32_t i = 0; i < header.defaultCount; ++i)
+        {
+            uint32_t length = 0, valueSize = 0;
+            if (!r.pod(length) || !r.pod(valueSize) || !r.string(length, component))
+                return Prefab{};
+            const uint8_t *bytes = r.take(valueSize);
+            if (!bytes)
+                return Prefab{};
+            // Cooked against another layout of the type: re-cook from the JSON.
+            const uint32_t id = registry.ensureId(component);
+            const ComponentTypeInfo *type = registry.typeInfo(id);
+            if (type && (!type->trivial || type->size != valueSize))
+                return Prefab{};
+            p.defaults.set(id, bytes, valueSize);
+        }
+        if (!r.atEnd())
+            return Prefab{};
+
+        p.name = std::move(name);
+        applyVisual(p, registry, assets);
+        finishPrefab(p, archetypes);
+        return p;
+    }
+
+    Prefab loadPrefabFile(const std::string &jsonPath,
+                          ComponentRegistry &registry,
+                          ArchetypeManager &archetypes,
+                          Engine::ModelSource *assets)
+    {
+        namespace fs = std::filesystem;
+        const fs::path cookedPath = fs::path(jsonPath).replace_extension(".sprefab");
+
+        std::error_code jsonEc, cookedEc;
+        const auto jsonTime = fs::last_write_time(jsonPath, jsonEc);
+        const auto cookedTime = fs::last_write_time(cookedPath, cookedEc);
+        // Neither on disk: both may come from a mounted archive, which is packed after cooking.
+        const bool packed = cookedEc && jsonEc;
+        if (packed || (!cookedEc && (jsonEc || cookedTime >= jsonTime)))
+        {
+            MappedFile file;
+            std::string error;
+            if (file.open(cookedPath.string(), error))
+            {
+                Prefab p = loadPrefabFromBinary(file.data(), static_cast<size_t>(file.size()), registry, archetypes, assets);
+                if (!p.name.empty())
+                    return p;
+            }
+        }
+
+        const std::string jsonText = readFileText(jsonPath);
+        if (jsonText.empty())
+            return Prefab{};
+        Prefab p = loadPrefabFromJson(jsonText, registry, archetypes, assets);
+
+        // Best effort: a read-only install just keeps parsing the JSON.
+        std::vector<uint8_t> bytes;
+        if (!packed && writePrefabBinary(p, registry, bytes))
+        {
+            const fs::path temp = fs::path(cookedPath).concat(".tmp");
+            bool written = false;
+            {
+                std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+                written = out && out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            }
+            std::error_code ec;
+            if (written)
+                fs::rename(temp, cookedPath, ec);
+            if (!written || ec)
+                fs::remove(temp, ec);
+        }
+        return p;
+    }
+}
@@ -0,0 +1,226 @@
+#include "assets/Preloader.h"
+
+#include "assets/AssetManager.h"
+#include "utils/AssetArchive.h"
+#include "utils/MappedFile.h"
+
+#include <nlohmann/json.hpp>
+
+#include <filesystem>
+#include <iostream>
+#include <utility>
+
+namespace Engine
+{
+    namespace
+    {
+        using json = nlohmann::json;
+
+        bool readList(const json &doc, const char *key, std::vector<std::string> &out, std::string &outError)
+        {
+            const auto it = doc.find(key);
+            if (it == doc.end())
+                return true;
+            if (!it->is_array())
+            {
+                outError = std::string("'") + key + "' must be an array of paths";
+                return false;
+            }
+            for (const json &entry : *it)
+            {
+                if (!entry.is_string())
+                {
+                    outError = std::string("'") + key + "' must be an array of paths";
+                    return false;
+                }
+                out.push_back(entry.get<std::string>());
+            }
+            return true;
+        }
+
+        // Map 'path' and touch every page, so later opens find it in memory. Returns the bytes read.
+        // Archive entries are touched as stored: decompressing here would build a copy nobody keeps.
+        bool readAhead(const std::string &path, uint64_t &outBytes)
+        {
+            MappedFile file;
+            std::string error;
+            bool handled = false;
+            bool ok = AssetArchive::openMountedStored(path, file, error, handled);
+            if (!handled)
+                ok = file.open(path, error);
+            if (!ok)
+                return false;
+
+            file.prefetch(0, file.size());
+            const uint8_t *data = file.data();
+            uint8_t sink = 0;
+            for (uint64_t offset = 0; offset < file.size(); offset += 4096)
+                sink ^= data[offset];
+            static std::atomic<uint8_t> s_sink{0}; // keeps the loads
+            s_sink.fetch_xor(sink, std::memory_order_relaxed);
+
+            outBytes = file.size();
+            return true;
+        }
+    }
+
+    bool PreloadManifest::load(const std::string &path, PreloadManifest &out, std::string &outError)
+    {
+        MappedFile file;
+        if (!file.open(path, outError))
+            return false;
+
+        const std::string text(reinterpret_cast<const char *>(file.data()), static_cast<size_t>(file.size()));
+        const json doc = json::parse(text, nullptr, false);
+        if (doc.is_discarded() || !doc.is_object())
+        {
+            outError = "Preload manifest '" + path + "' is not a JSON object";
+            return false;
+        }
+
+        PreloadManifest manifest;
+        if (!readList(doc, "models", manifest.models, outError) ||
+            !readList(doc, "textures", manifest.textures, outError) ||
+            !readList(doc, "prefabs", manifest.prefabs, outError) ||
+            !readList(doc, "shaders", manifest.shaders, outError) ||
+            !readList(doc, "files", manifest.files, outError))
+        {
+            outError = "Preload manifest '" + path + "': " + outError;
+            return false;
+        }
+        out = std::move(manifest);
+        return true;
+    }
+
+    Preloader::~Preloader()
+    {
+        // Reads only touch this object's counters; background work is worth helping with here.
+        JobSystem::get().wait(m_reads, JobPriority::Background);
+    }
+
+    void Preloader::start(PreloadManifest manifest)
+    {
+        if (m_started)
+            return;
+        m_started = true;
+        m_startTime = std::chrono::steady_clock::now();
+        m_manifest = std::move(manifest);
+
+        // Prefab JSON is parsed from its cooked copy when that is current (ECS::loadPrefabFile).
+        struct Read
+        {
+            std::string path;
+            bool optional = false;
+        };
+        std::vector<Read> reads;
+        for (const auto *list : {&m_manifest.models, &m_manifest.textures, &m_manifest.prefabs, &m_manifest.shaders, &m_manifest.files})
+        {
+            for (const std::string &path : *list)
+                reads.push_back({path, false});
+        }
+        for (const std::string &path : m_manifest.prefabs)
+        {
+            if (std::filesystem::path(path).extension() == ".json")
+                reads.push_back({std::filesystem::path(path).replace_extension(".sprefab").generic_string(), true});
+        }
+
+        m_progress.filesTotal = static_cast<uint32_t>(reads.size());
+        m_progress.assetsTotal = static_cast<uint32_t>(m_manifest.models.size() + m_manifest.textures.size());
+
+        JobSystem &jobs = JobSystem::get();
+        for (Read &read : reads)
+        {
+            jobs.submit([this, read = std::move(read)]
+                        {
+                            uint64_t bytes = 0;
+                            if (readAhead(read.path, bytes))
+                                m_bytesRead.fetch_add(bytes, std::memory_order_relaxed);
+                            else if (!read.optional)
+                                m_filesFailed.fetch_add(1, std::memory_order_relaxed);
+                            m_filesRead.fetch_add(1, std::memory_order_release); },
+                        JobPriority::Background, &m_reads);
+        }
+    }
+
+    void Preloader::attach(AssetManager &assets)
+    {
+        if (m_assets)
+            return;
+        m_assets = &assets;
+        m_progress.attached = true;
+
+        for (const std::string &path : m_manifest.models)
+        {
+            if (m_models.find(path) == m_models.end())
+                m_models.emplace(path, assets.loadModelAsync(path));
+        }
+        for (const std::string &path : m_manifest.textures)
+        {
+            if (m_textures.find(path) == m_textures.end())
+                m_textures.emplace(path, assets.loadTextureAsync(path));
+        }
+    }
+
+    void Preloader::detach()
+    {
+        if (!m_assets)
+            return;
+        for (auto &[path, h] : m_models)
+            m_assets->release(h);
+        for (auto &[path, h] : m_textures)
+            m_assets->release(h);
+        m_models.clear();
+        m_textures.clear();
+        m_assets = nullptr;
+    }
+
+    void Preloader::update()
+    {
+        if (!m_started || m_reported)
+            return;
+
+        m_progress.filesRead = m_filesRead.load(std::memory_order_acquire);
+        m_progress.filesFailed = m_filesFailed.load(std::memory_order_relaxed);
+        m_progress.bytesRead = m_bytesRead.load(std::memory_order_relaxed);
+
+        if (m_assets)
+        {
+            // Duplicate manifest entries share one handle; count them once per entry like assetsTotal.
+            uint32_t ready = 0, failed = 0;
+            auto count = [&](AssetState state)
+            {
+                ready += (state == AssetState::Ready) ? 1u : 0u;
+                failed += (state == AssetState::Failed || state == AssetState::Missing) ? 1u : 0u;
+            };
+            for (const std::string &path : m_manifest.models)
+                count(m_assets->modelState(model(path)));
+            for (const std::string &path : m_manifest.textures)
+                count(m_assets->textureState(texture(path)));
+            m_progress.assetsReady = ready;
+            m_progress.assetsFailed = failed;
+        }
+
+        m_progress.elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_startTime).count();
+        if (m_progress.done())
+        {
+            m_reported = true;
+            std::cout << "[Preload] " << m_progress.filesRead << " files (" << (m_progress.bytesRead >> 10) << " KiB), "
+                      << m_progress.assetsReady << " assets ready in " << m_progress.elapsedMs << " ms\n";
+            if (m_progress.filesFailed > 0 || m_progress.assetsFailed > 0)
+                std::cerr << "[Preload] " << m_progress.filesFailed << " files missing, " << m_progress.assetsFailed
+                          << " assets failed\n";
+        }
+    }
+
+    ModelHandle Preloader::model(const std::string &path) const
+    {
+        const auto it = m_models.find(path);
+        return (it != m_models.end()) ? it->second : ModelHandle{};
+    }
+
+    TextureHandle Preloader::texture(const std::string &path) const
+    {
+        const auto it = m_textures.find(path);
+        return (it != m_textures.end()) ? it->second : TextureHandle{};
+    }
+}
@@ -0,0 +1,303 @@
+#include "Engine/Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Engine
+{
+    namespace
+    {
+        // Written by the owning thread (fetch_add), drained by collectFrame (exchange).
+        struct ThreadCounters
+        {
+            std::atomic<uint64_t> ns[CpuProfiler::kMaxNodes];
+            std::atomic<uint32_t> calls[CpuProfiler::kMaxNodes];
+            uint32_t id = 0;
+
+            // Event capture only: appended by the owner, swapped out by drainEvents().
+            std::mutex eventMutex;
+            std::vector<CpuProfiler::ScopeEvent> events;
+            std::string name; // guarded by the registry mutex
+
+            ThreadCounters()
+            {
+                for (uint32_t i = 0; i < CpuProfiler::kMaxNodes; ++i)
+                {
+                    ns[i].store(0, std::memory_order_relaxed);
+                    calls[i].store(0, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        struct Node
+        {
+            const char *name = nullptr;
+            uint32_t parent = CpuProfiler::kRootNode;
+            uint32_t depth = 0;
+            uint32_t lastCalls = 0;
+            float history[CpuProfiler::kHistoryFrames]{}; // ms per frame, ring
+        };
+
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<Node> nodes{Node{}}; // [0] = root
+            std::vector<std::unique_ptr<ThreadCounters>> threads; // never freed: threads may outlive a frame
+            uint32_t historyHead = 0;
+            uint32_t historyCount = 0;
+            std::atomic<bool> captureEvents{false};
+        };
+
+        Registry &registry()
+        {
+            static Registry r;
+            return r;
+        }
+
+        struct ThreadState
+        {
+            ThreadCounters *counters = nullptr;
+            uint32_t current = CpuProfiler::kRootNode;
+            std::unordered_map<uint64_t, uint32_t> children; // (parent, name pointer) -> node
+        };
+
+        ThreadState &threadState()
+        {
+            thread_local ThreadState state;
+            if (!state.counters)
+            {
+                Registry &r = registry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                r.threads.push_back(std::make_unique<ThreadCounters>());
+                state.counters = r.threads.back().get();
+                state.counters->id = static_cast<uint32_t>(r.threads.size());
+            }
+            return state;
+        }
+
+        uint32_t internNode(const char *name, uint32_t parent)
+        {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            if (parent >= r.nodes.size())
+                parent = CpuProfiler::kRootNode;
+
+            // Same text from another call site (or a copy of the name) is the same node
+            for (uint32_t i = 1; i < r.nodes.size(); ++i)
+            {
+                const Node &n = r.nodes[i];
+                if (n.parent == parent && (n.name == name || std::strcmp(n.name, name) == 0))
+                    return i;
+            }
+
+            if (r.nodes.size() >= CpuProfiler::kMaxNodes)
+                return CpuProfiler::kRootNode;
+
+            Node n;
+            n.name = name;
+            n.parent = parent;
+            n.depth = r.nodes[parent].depth + 1;
+            r.nodes.push_back(n);
+            return static_cast<uint32_t>(r.nodes.size() - 1);
+        }
+
+        void fillStats(const Registry &r, uint32_t index, CpuProfiler::NodeStats &out)
+        {
+            const Node &n = r.nodes[index];
+            out.name = n.name;
+            out.node = index;
+            out.parent = n.parent;
+            out.depth = n.depth;
+            out.calls = n.lastCalls;
+            if (r.historyCount == 0)
+                return;
+
+            const uint32_t last = (r.historyHead + CpuProfiler::kHistoryFrames - 1) % CpuProfiler::kHistoryFrames;
+            out.lastMs = n.history[last];
+
+            float window[CpuProfiler::kHistoryFrames];
+            float sum = 0.0f;
+            for (uint32_t i = 0; i < r.historyCount; ++i)
+            {
+                window[i] = n.history[(r.historyHead + CpuProfiler::kHistoryFrames - 1 - i) % CpuProfiler::kHistoryFrames];
+                sum += window[i];
+            }
+            std::sort(window, window + r.historyCount);
+            auto percentile = [&](float p)
+            {
+                const uint32_t k = std::min(r.historyCount - 1, static_cast<uint32_t>(p * static_cast<float>(r.historyCount - 1) + 0.5f));
+                return window[k];
+            };
+            out.avgMs = sum / static_cast<float>(r.historyCount);
+            out.p50Ms = percentile(0.50f);
+            out.p95Ms = percentile(0.95f);
+            out.p99Ms = percentile(0.99f);
+            out.maxMs = window[r.historyCount - 1];
+        }
+    } // namespace
+
+    uint32_t CpuProfiler::node(const char *name, uint32_t parent)
+    {
+        if (!name)
+            return kRootNode;
+
+        ThreadState &ts = threadState();
+        const uint64_t key = (static_cast<uint64_t>(parent) << 48) ^ static_cast<uint64_t>(reinterpret_cast<uintptr_t>(name));
+        auto it = ts.children.find(key);
+        if (it != ts.children.end())
+            return it->second;
+
+        const uint32_t n = internNode(name, parent);
+        ts.children.emplace(key, n);
+        return n;
+    }
+
+    uint32_t CpuProfiler::currentScope()
+    {
+        return threadState().current;
+    }
+
+    uint32_t CpuProfiler::enter(uint32_t node)
+    {
+        ThreadState &ts = threadState();
+        const uint32_t previous = ts.current;
+        ts.current = node;
+        return previous;
+    }
+
+    void CpuProfiler::leave(uint32_t node, uint32_t previous, uint64_t startNs, uint64_t elapsedNs)
+    {
+        ThreadState &ts = threadState();
+        ts.current = previous;
+        if (node == kRootNode)
+            return;
+        ts.counters->ns[node].fetch_add(elapsedNs, std::memory_order_relaxed);
+        ts.counters->calls[node].fetch_add(1, std::memory_order_relaxed);
+
+        if (registry().captureEvents.load(std::memory_order_relaxed))
+        {
+            ScopeEvent e;
+            e.node = node;
+            e.thread = ts.counters->id;
+            e.startNs = startNs;
+            e.durationNs = elapsedNs;
+
+            std::lock_guard<std::mutex> lock(ts.counters->eventMutex);
+            if (ts.counters->events.size() < kMaxPendingEvents)
+                ts.counters->events.push_back(e);
+        }
+    }
+
+    void CpuProfiler::collectFrame()
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        for (uint32_t i = 1; i < r.nodes.size(); ++i)
+        {
+            uint64_t ns = 0;
+            uint32_t calls = 0;
+            for (const auto &t : r.threads)
+            {
+                ns += t->ns[i].exchange(0, std::memory_order_relaxed);
+                calls += t->calls[i].exchange(0, std::memory_order_relaxed);
+            }
+            r.nodes[i].history[r.historyHead] = static_cast<float>(static_cast<double>(ns) * 1e-6);
+            r.nodes[i].lastCalls = calls;
+        }
+
+        r.historyHead = (r.historyHead + 1) % kHistoryFrames;
+        r.historyCount = std::min(r.historyCount + 1, kHistoryFrames);
+    }
+
+    void CpuProfiler::snapshot(std::vector<NodeStats> &out)
+    {
+        out.clear();
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        // Depth-first, siblings in first-seen order
+        std::vector<std::vector<uint32_t>> children(r.nodes.size());
+        for (uint32_t i = 1; i < r.nodes.size(); ++i)
+            children[r.nodes[i].parent].push_back(i);
+
+        std::vector<uint32_t> stack(children[kRootNode].rbegin(), children[kRootNode].rend());
+        while (!stack.empty())
+        {
+            const uint32_t i = stack.back();
+            stack.pop_back();
+
+            NodeStats s;
+            fillStats(r, i, s);
+            out.push_back(s);
+
+            stack.insert(stack.end(), children[i].rbegin(), children[i].rend());
+        }
+    }
+
+    CpuProfiler::NodeStats CpuProfiler::stats(uint32_t node)
+    {
+        NodeStats s;
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        if (node != kRootNode && node < r.nodes.size())
+            fillStats(r, node, s);
+        return s;
+    }
+
+    void CpuProfiler::setEventCapture(bool enabled)
+    {
+        registry().captureEvents.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool CpuProfiler::eventCapture()
+    {
+        return registry().captureEvents.load(std::memory_order_relaxed);
+    }
+
+    void CpuProfiler::drainEvents(std::vector<ScopeEvent> &out)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        std::vector<ScopeEvent> events;
+        for (const auto &t : r.threads)
+        {
+            {
+                std::lock_guard<std::mutex> eventLock(t->eventMutex);
+                events.swap(t->events);
+            }
+
+            const size_t first = out.size();
+            out.insert(out.end(), events.begin(), events.end());
+            for (size_t i = first; i < out.size(); ++i)
+                out[i].name = out[i].node < r.nodes.size() ? r.nodes[out[i].node].name : nullptr;
+            events.clear();
+        }
+    }
+
+    void CpuProfiler::setThreadName(const char *name)
+    {
+        ThreadState &ts = threadState();
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        ts.counters->name = name ? name : "";
+    }
+
+    void CpuProfiler::threadNames(std::vector<std::pair<uint32_t, std::string>> &out)
+    {
+        out.clear();
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const auto &t : r.threads)
+        {
+            if (!t->name.empty())
+                out.emplace_back(t->id, t->name);
+        }
+    }
+
+} // namespace Engine
@@ -0,0 +1,266 @@
+#include "ECS/RegionPartition.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace Engine::ECS
+{
+    namespace
+    {
+        // ------------------------------------------------------------
+        // Message layout (native byte order)
+        // ------------------------------------------------------------
+        //   MessageHeader
+        //   migrants: entity-subset snapshot (migrateBytes, may be 0), padded to 8 bytes
+        //   halo:     entity-subset snapshot (haloBytes, may be 0; only with HasHalo)
+
+        constexpr char kMagic[4] = {'S', 'R', 'G', 'N'};
+        constexpr uint32_t kMessageVersion = 1;
+        constexpr uint32_t kHasHalo = 1u;
+
+        struct MessageHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t fromRegion;
+            uint32_t toRegion;
+            uint32_t tick;
+            uint32_t flags;
+            uint64_t migrateBytes;
+            uint64_t haloBytes;
+        };
+
+        size_t padded(size_t n) { return (n + 7) & ~size_t(7); }
+
+        bool fail(std::string &outError, const std::string &message)
+        {
+            outError = "Region message: " + message;
+            return false;
+        }
+    }
+
+    // ------------------------------------------------------------
+    // RegionLayout
+    // ------------------------------------------------------------
+
+    uint32_t RegionLayout::regionAt(float x, float z) const
+    {
+        const float sizeX = (maxX - minX) / static_cast<float>(regionsX);
+        const float sizeZ = (maxZ - minZ) / static_cast<float>(regionsZ);
+        const int rx = static_cast<int>(std::floor((x - minX) / sizeX));
+        const int rz = static_cast<int>(std::floor((z - minZ) / sizeZ));
+        const uint32_t cx = static_cast<uint32_t>(std::min(std::max(rx, 0), static_cast<int>(regionsX) - 1));
+        const uint32_t cz = static_cast<uint32_t>(std::min(std::max(rz, 0), static_cast<int>(regionsZ) - 1));
+        return cz * regionsX + cx;
+    }
+
+    void RegionLayout::bounds(uint32_t region, float &outMinX, float &outMinZ, float &outMaxX, float &outMaxZ) const
+    {
+        const float sizeX = (maxX - minX) / static_cast<float>(regionsX);
+        const float sizeZ = (maxZ - minZ) / static_cast<float>(regionsZ);
+        const uint32_t cx = region % regionsX;
+        const uint32_t cz = region / regionsX;
+        outMinX = minX + static_cast<float>(cx) * sizeX;
+        outMinZ = minZ + static_cast<float>(cz) * sizeZ;
+        outMaxX = (cx + 1 == regionsX) ? maxX : outMinX + sizeX;
+        outMaxZ = (cz + 1 == regionsZ) ? maxZ : outMinZ + sizeZ;
+    }
+
+    float RegionLayout::distanceTo(uint32_t region, float x, float z) const
+    {
+        float x0, z0, x1, z1;
+        bounds(region, x0, z0, x1, z1);
+        const uint32_t cx = region % regionsX;
+        const uint32_t cz = region / regionsX;
+        const float dx = (cx > 0 && x < x0) ? x0 - x : (cx + 1 < regionsX && x > x1) ? x - x1 : 0.0f;
+        const float dz = (cz > 0 && z < z0) ? z0 - z : (cz + 1 < regionsZ && z > z1) ? z - z1 : 0.0f;
+        return std::sqrt(dx * dx + dz * dz);
+    }
+
+    // ------------------------------------------------------------
+    // RegionShard
+    // ------------------------------------------------------------
+
+    RegionShard::RegionShard(const RegionLayout &layout, uint32_t region, float haloWidth)
+        : m_layout(layout), m_region(region), m_haloWidth(std::max(0.0f, haloWidth))
+    {
+        const uint32_t count = m_layout.valid() ? m_layout.regionCount() : 0;
+        m_ghosts.resize(count);
+        m_lastHaloTick.assign(count, 0);
+        m_outgoing.resize(count);
+        m_halo.resize(count);
+
+        if (region >= count)
+            return;
+        float x0, z0, x1, z1;
+        m_layout.bounds(region, x0, z0, x1, z1);
+        for (uint32_t r = 0; r < count; ++r)
+        {
+            if (r == region)
+                continue;
+            // Gap between the two rectangles along each axis.
+            float rx0, rz0, rx1, rz1;
+            m_layout.bounds(r, rx0, rz0, rx1, rz1);
+            const float gx = std::max(0.0f, std::max(rx0 - x1, x0 - rx1));
+            const float gz = std::max(0.0f, std::max(rz0 - z1, z0 - rz1));
+            if (gx * gx + gz * gz <= m_haloWidth * m_haloWidth)
+                m_neighbors.push_back(r);
+        }
+    }
+
+    void RegionShard::initialize(ComponentRegistry &registry)
+    {
+        m_ghostId = registry.ensureId(GhostTagName);
+    }
+
+    const std::vector<SnapshotSpawn> &RegionShard::ghosts(uint32_t region) const
+    {
+        static const std::vector<SnapshotSpawn> kNone;
+        return region < m_ghosts.size() ? m_ghosts[region] : kNone;
+    }
+
+    bool RegionShard::exportTick(ECSContext &ecs, std::vector<RegionMessage> &out, std::string &outError)
+    {
+        out.clear();
+        if (m_region >= m_ghosts.size() || m_ghostId == ComponentRegistry::InvalidID)
+        {
+            outError = "RegionShard: invalid layout/region or initialize() not called";
+            return false;
+        }
+
+        ++m_tick;
+        m_stats.migratedOut = 0;
+        m_stats.haloSent = 0;
+        m_stats.migratedIn = 0;
+        for (auto &list : m_outgoing)
+            list.clear();
+        for (auto &list : m_halo)
+            list.clear();
+
+        // Classify owned entities (ghost stores are never re-exported).
+        const auto &stores = ecs.stores.stores();
+        for (const auto &store : stores)
+        {
+            if (!store || store->size() == 0 || !store->hasPosition() || store->signature().has(m_ghostId))
+                continue;
+            const auto positions = std::as_const(*store).positions();
+            const auto &entities = store->entities();
+            for (uint32_t row = 0; row < store->size(); ++row)
+            {
+                const Position p = positions[row];
+                const uint32_t owner = m_layout.regionAt(p.x, p.z);
+                if (owner != m_region)
+                {
+                    m_outgoing[owner].push_back(entities[row]);
+                    continue;
+                }
+                for (uint32_t n : m_neighbors)
+                {
+                    if (m_layout.distanceTo(n, p.x, p.z) <= m_haloWidth)
+                        m_halo[n].push_back(entities[row]);
+                }
+            }
+        }
+
+        for (uint32_t r = 0; r < static_cast<uint32_t>(m_outgoing.size()); ++r)
+        {
+            const bool neighbor = std::find(m_neighbors.begin(), m_neighbors.end(), r) != m_neighbors.end();
+            if (m_outgoing[r].empty() && !neighbor)
+                continue;
+
+            m_migrateBytes.clear();
+            m_haloBytes.clear();
+            if (!m_outgoing[r].empty() &&
+                !writeSnapshotEntities(ecs, m_outgoing[r].data(), m_outgoing[r].size(), m_migrateBytes, outError))
+                return false;
+            if (neighbor && !m_halo[r].empty() &&
+                !writeSnapshotEntities(ecs, m_halo[r].data(), m_halo[r].size(), m_haloBytes, outError))
+                return false;
+
+            MessageHeader header{};
+            std::memcpy(header.magic, kMagic, sizeof(kMagic));
+            header.version = kMessageVersion;
+            header.fromRegion = m_region;
+            header.toRegion = r;
+            header.tick = m_tick;
+            header.flags = neighbor ? kHasHalo : 0u;
+            header.migrateBytes = m_migrateBytes.size();
+            header.haloBytes = m_haloBytes.size();
+
+            RegionMessage &message = out.emplace_back();
+            message.toRegion = r;
+            message.bytes.resize(sizeof(MessageHeader) + padded(m_migrateBytes.size()) + m_haloBytes.size(), 0);
+            uint8_t *dst = message.bytes.data();
+            std::memcpy(dst, &header, sizeof(header));
+            if (!m_migrateBytes.empty())
+                std::memcpy(dst + sizeof(MessageHeader), m_migrateBytes.data(), m_migrateBytes.size());
+            if (!m_haloBytes.empty())
+                std::memcpy(dst + sizeof(MessageHeader) + padded(m_migrateBytes.size()), m_haloBytes.data(), m_haloBytes.size());
+
+            m_stats.migratedOut += static_cast<uint32_t>(m_outgoing[r].size());
+            m_stats.haloSent += neighbor ? static_cast<uint32_t>(m_halo[r].size()) : 0u;
+        }
+
+        // Packed: the migrants now belong to their new owners.
+        for (const auto &list : m_outgoing)
+        {
+            for (Entity e : list)
+                ecs.destroyEntity(e);
+        }
+        return true;
+    }
+
+    bool RegionShard::importMessage(ECSContext &ecs, const uint8_t *data, size_t size, std::string &outError)
+    {
+        m_arrivals.clear();
+        if (m_ghostId == ComponentRegistry::InvalidID)
+            return fail(outError, "initialize() not called");
+
+        MessageHeader header{};
+        if (size < sizeof(MessageHeader))
+            return fail(outError, "truncated header");
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kMessageVersion)
+            return fail(outError, "not a region message (or another version)");
+        if (header.toRegion != m_region || header.fromRegion >= m_ghosts.size() || header.fromRegion == m_region)
+            return fail(outError, "addressed from/to the wrong region");
+        const size_t migrateSpan = padded(static_cast<size_t>(header.migrateBytes));
+        if (header.migrateBytes > size || header.haloBytes > size ||
+            sizeof(MessageHeader) + migrateSpan + header.haloBytes != size)
+            return fail(outError, "size mismatch");
+
+        const uint8_t *migrate = data + sizeof(MessageHeader);
+        if (header.migrateBytes > 0 &&
+            !appendSnapshotEntities(ecs, migrate, static_cast<size_t>(header.migrateBytes), ComponentMask{}, &m_arrivals, outError))
+            return false;
+        m_stats.migratedIn += static_cast<uint32_t>(m_arrivals.size());
+
+        const uint32_t from = header.fromRegion;
+        if ((header.flags & kHasHalo) && header.tick > m_lastHaloTick[from])
+        {
+            m_lastHaloTick[from] = header.tick;
+            dropGhosts(ecs, from);
+            if (header.haloBytes > 0)
+            {
+                ComponentMask ghostTag;
+                ghostTag.set(m_ghostId);
+                if (!appendSnapshotEntities(ecs, migrate + migrateSpan, static_cast<size_t>(header.haloBytes), ghostTag,
+                                            &m_ghosts[from], outError))
+                    return false;
+                m_stats.ghosts += static_cast<uint32_t>(m_ghosts[from].size());
+            }
+        }
+        return true;
+    }
+
+    void RegionShard::dropGhosts(ECSContext &ecs, uint32_t fromRegion)
+    {
+        auto &list = m_ghosts[fromRegion];
+        for (const SnapshotSpawn &g : list)
+            ecs.destroyEntity(g.created);
+        m_stats.ghosts -= std::min(m_stats.ghosts, static_cast<uint32_t>(list.size()));
+        list.clear();
+    }
+}
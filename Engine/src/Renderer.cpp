@@ -4,7 +4,13 @@
 #include "Engine/Renderer.h"
 #include "Engine/VulkanContext.h"
 #include "Engine/SwapChain.h"
+#include "Engine/Camera.h"
 #include "utils/ImageUtils.h"
+#include "ECS/WorkerPool.h"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
 
 namespace Engine
 {
@@ -41,6 +47,13 @@ namespace Engine
             VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
     }
 
+    static bool depthSampleable(VkPhysicalDevice phys, VkFormat fmt)
+    {
+        VkFormatProperties props{};
+        vkGetPhysicalDeviceFormatProperties(phys, fmt, &props);
+        return (props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+    }
+
     static VkImageAspectFlags depthAspectFlags(VkFormat fmt)
     {
         VkImageAspectFlags flags = VK_IMAGE_ASPECT_DEPTH_BIT;
@@ -61,9 +74,13 @@ namespace Engine
         m_device = m_ctx->GetDevice();
         m_graphicsQueue = m_ctx->GetGraphicsQueue();
         m_presentQueue = m_ctx->GetPresentQueue();
+        m_computeQueue = m_ctx->HasAsyncCompute() ? m_ctx->GetComputeQueue() : VK_NULL_HANDLE;
 
         m_swapchainImageFormat = m_swapchain->GetImageFormat();
         m_extent = m_swapchain->GetExtent();
+
+        m_pacing.presentMode = m_swapchain->GetPresentMode();
+        m_pacing.framesInFlight = maxFramesInFlight;
     }
 
     Renderer::~Renderer()
@@ -94,7 +111,10 @@ namespace Engine
         }
 
         // prepare per-frame slots
+        m_maxFrames = clampFramesInFlight(m_maxFrames);
         m_frames.resize(m_maxFrames);
+        if (m_ctx->SupportsPresentWait())
+            m_waitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(m_device, "vkWaitForPresentKHR"));
 
         // swapchain-dependent
         m_swapchainImageFormat = m_swapchain->GetImageFormat();
@@ -103,9 +123,12 @@ namespace Engine
         createDepthResources();
         createMainRenderPass();
         createFramebuffers();
+        if (m_depthPrePassEnabled)
+            createDepthPrePassResources();
         createSyncObjects();
         createCommandPoolsAndBuffers();
         createTimestampQueryPool();
+        createTransientBuffers();
 
         // notify registered passes so they can create pipelines/resources that depend on renderpass/framebuffers
         for (auto &p : m_passes)
@@ -123,7 +146,10 @@ namespace Engine
             return;
 
         // prepare per-frame slots
+        m_maxFrames = clampFramesInFlight(m_maxFrames);
         m_frames.resize(m_maxFrames);
+        if (m_ctx->SupportsPresentWait())
+            m_waitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(m_device, "vkWaitForPresentKHR"));
 
         // swapchain-dependent
         m_swapchainImageFormat = m_swapchain->GetImageFormat();
@@ -132,9 +158,12 @@ namespace Engine
         createDepthResources();
         createMainRenderPass();
         createFramebuffers();
+        if (m_depthPrePassEnabled)
+            createDepthPrePassResources();
         createSyncObjects();
         createCommandPoolsAndBuffers();
         createTimestampQueryPool();
+        createTransientBuffers();
 
         // notify registered passes so they can create pipelines/resources that depend on renderpass/framebuffers
         for (auto &p : m_passes)
@@ -164,6 +193,7 @@ namespace Engine
         destroyTimestampQueryPool();
         destroyCommandPoolsAndBuffers();
         destroySyncObjects();
+        m_transient.destroy();
 
         // Destroy framebuffers
         for (auto fb : m_framebuffers)
@@ -175,6 +205,7 @@ namespace Engine
         }
         m_framebuffers.clear();
 
+        destroyDepthPrePassResources(false);
         destroyDepthResources();
 
         // Destroy main render pass
@@ -191,12 +222,66 @@ namespace Engine
     {
         if (!pass)
             return;
-        m_passes.push_back(pass);
-        if (m_initialized)
+        if (!m_initialized)
         {
-            // Immediately call onCreate so the pass can create pipelines that depend on renderpass/framebuffers.
+            // init() calls onCreate for every registered pass.
+            m_passes.push_back(pass);
+            return;
+        }
+
+        // drawFrame() may be iterating m_passes on the render thread; create it at the next snapshot.
+        m_pendingPasses.push_back(std::move(pass));
+    }
+
+    void Renderer::snapshotFrame()
+    {
+        if (!m_initialized)
+            return;
+
+        for (auto &pass : m_pendingPasses)
+        {
+            // onCreate creates pipelines that depend on the render pass/framebuffers.
             pass->onCreate(*m_ctx, m_mainRenderPass, m_framebuffers);
+            m_passes.push_back(std::move(pass));
         }
+        m_pendingPasses.clear();
+
+        m_frameWaits.insert(m_frameWaits.end(), m_pendingWaits.begin(), m_pendingWaits.end());
+        m_pendingWaits.clear();
+
+        // One view for the whole frame; modules snapshot after it, so their camera reads agree.
+        m_hasView = m_camera != nullptr;
+        if (m_camera)
+        {
+            if (m_extent.width > 0 && m_extent.height > 0)
+                m_camera->SetAspect(static_cast<float>(m_extent.width) / static_cast<float>(m_extent.height));
+            m_view = m_camera->GetViewData();
+        }
+
+        for (auto &p : m_passes)
+        {
+            if (p)
+                p->onFrameSnapshot();
+        }
+    }
+
+    bool Renderer::addFrameWait(VkSemaphore timeline, uint64_t value, VkPipelineStageFlags stage)
+    {
+        if (!m_timeline.valid() || timeline == VK_NULL_HANDLE)
+            return false;
+
+        // Several waits on one timeline collapse into the highest value.
+        for (TimelineWait &w : m_pendingWaits)
+        {
+            if (w.semaphore == timeline)
+            {
+                w.value = std::max(w.value, value);
+                w.stage |= stage;
+                return true;
+            }
+        }
+        m_pendingWaits.push_back({timeline, value, stage});
+        return true;
     }
 
     void Renderer::createMainRenderPass()
@@ -205,7 +290,11 @@ namespace Engine
         {
             m_depthFormat = findDepthFormat(m_ctx->GetPhysicalDevice());
         }
+        m_mainRenderPass = buildMainRenderPass(false);
+    }
 
+    VkRenderPass Renderer::buildMainRenderPass(bool loadDepth) const
+    {
         // Color attachment tied to swapchain image format
         VkAttachmentDescription colorAttachment{};
         colorAttachment.format = m_swapchainImageFormat;
@@ -217,15 +306,16 @@ namespace Engine
         colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
         colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
-        // Depth attachment (one image per swapchain image)
+        // Depth attachment (one image per swapchain image); loaded when a depth pre-pass filled it.
+        // Only load/store ops and layouts differ, so both variants are compatible render passes.
         VkAttachmentDescription depthAttachment{};
         depthAttachment.format = m_depthFormat;
         depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.loadOp = loadDepth ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
         depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        depthAttachment.initialLayout = loadDepth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
         depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
         VkAttachmentReference colorAttachmentRef{};
@@ -261,10 +351,12 @@ namespace Engine
         rpInfo.dependencyCount = 1;
         rpInfo.pDependencies = &dependency;
 
-        if (vkCreateRenderPass(m_device, &rpInfo, nullptr, &m_mainRenderPass) != VK_SUCCESS)
+        VkRenderPass pass = VK_NULL_HANDLE;
+        if (vkCreateRenderPass(m_device, &rpInfo, nullptr, &pass) != VK_SUCCESS)
         {
             throw std::runtime_error("Renderer::createMainRenderPass - failed to create render pass");
         }
+        return pass;
     }
 
     void Renderer::createFramebuffers()
@@ -309,9 +401,14 @@ namespace Engine
 
         const auto &imageViews = m_swapchain->GetImageViews();
         m_depthImages.resize(imageViews.size(), VK_NULL_HANDLE);
-        m_depthMemories.resize(imageViews.size(), VK_NULL_HANDLE);
+        m_depthAllocations.resize(imageViews.size());
         m_depthImageViews.resize(imageViews.size(), VK_NULL_HANDLE);
 
+        // The Hi-Z build samples the depth pre-pass result.
+        VkImageUsageFlags usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        if (m_depthPrePassEnabled && depthSampleable(m_ctx->GetPhysicalDevice(), m_depthFormat))
+            usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+
         for (size_t i = 0; i < imageViews.size(); ++i)
         {
             VkResult r = CreateImage2D(
@@ -320,9 +417,10 @@ namespace Engine
                 m_extent.width,
                 m_extent.height,
                 m_depthFormat,
-                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                usage,
                 m_depthImages[i],
-                m_depthMemories[i]);
+                m_depthAllocations[i],
+                GpuMemoryCategory::RenderTarget);
             if (r != VK_SUCCESS)
             {
                 throw std::runtime_error("Renderer::createDepthResources - failed to create depth image");
@@ -351,38 +449,329 @@ namespace Engine
                 iv = VK_NULL_HANDLE;
             }
         }
-        for (auto &img : m_depthImages)
+        for (size_t i = 0; i < m_depthImages.size(); ++i)
         {
-            if (img != VK_NULL_HANDLE)
+            DestroyImage2D(m_device, m_depthImages[i], m_depthAllocations[i]);
+        }
+        m_depthImageViews.clear();
+        m_depthImages.clear();
+        m_depthAllocations.clear();
+    }
+
+    void Renderer::createDepthPrePassResources()
+    {
+        if (m_depthPrePass == VK_NULL_HANDLE)
+        {
+            VkAttachmentDescription depthAttachment{};
+            depthAttachment.format = m_depthFormat;
+            depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+            VkAttachmentReference depthAttachmentRef{};
+            depthAttachmentRef.attachment = 0;
+            depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+            VkSubpassDescription subpass{};
+            subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+            // The previous frame on this image finished its depth tests before the clear.
+            VkSubpassDependency dependency{};
+            dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+            dependency.dstSubpass = 0;
+            dependency.srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            dependency.dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            dependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+            VkRenderPassCreateInfo rpInfo{};
+            rpInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+            rpInfo.attachmentCount = 1;
+            rpInfo.pAttachments = &depthAttachment;
+            rpInfo.subpassCount = 1;
+            rpInfo.pSubpasses = &subpass;
+            rpInfo.dependencyCount = 1;
+            rpInfo.pDependencies = &dependency;
+
+            if (vkCreateRenderPass(m_device, &rpInfo, nullptr, &m_depthPrePass) != VK_SUCCESS)
             {
-                vkDestroyImage(m_device, img, nullptr);
-                img = VK_NULL_HANDLE;
+                throw std::runtime_error("Renderer::createDepthPrePassResources - failed to create render pass");
             }
+            m_mainRenderPassLoadDepth = buildMainRenderPass(true);
         }
-        for (auto &mem : m_depthMemories)
+
+        m_depthFramebuffers.resize(m_depthImageViews.size(), VK_NULL_HANDLE);
+        for (size_t i = 0; i < m_depthImageViews.size(); ++i)
         {
-            if (mem != VK_NULL_HANDLE)
+            VkFramebufferCreateInfo fbInfo{};
+            fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            fbInfo.renderPass = m_depthPrePass;
+            fbInfo.attachmentCount = 1;
+            fbInfo.pAttachments = &m_depthImageViews[i];
+            fbInfo.width = m_extent.width;
+            fbInfo.height = m_extent.height;
+            fbInfo.layers = 1;
+
+            if (vkCreateFramebuffer(m_device, &fbInfo, nullptr, &m_depthFramebuffers[i]) != VK_SUCCESS)
             {
-                vkFreeMemory(m_device, mem, nullptr);
-                mem = VK_NULL_HANDLE;
+                throw std::runtime_error("Renderer::createDepthPrePassResources - failed to create framebuffer");
             }
         }
-        m_depthImageViews.clear();
-        m_depthImages.clear();
-        m_depthMemories.clear();
+
+        // Occlusion culling is optional: without a sampleable depth format or the Hi-Z shader the
+        // depth pre-pass still saves shading, nothing is culled against it.
+        if (!depthSampleable(m_ctx->GetPhysicalDevice(), m_depthFormat))
+            return;
+        if (!m_hiZ.ready() && !m_hiZ.create(*m_ctx, static_cast<uint32_t>(m_depthImages.size())))
+            return;
+        if (!m_hiZ.resize(m_extent))
+            return;
+
+        m_depthSampleViews.resize(m_depthImages.size(), VK_NULL_HANDLE);
+        for (size_t i = 0; i < m_depthImages.size(); ++i)
+        {
+            if (CreateImageView2D(m_device, m_depthImages[i], m_depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, m_depthSampleViews[i]) != VK_SUCCESS)
+            {
+                std::cerr << "Renderer: failed to create depth sample view, occlusion culling disabled\n";
+                for (VkImageView &v : m_depthSampleViews)
+                {
+                    if (v != VK_NULL_HANDLE)
+                        vkDestroyImageView(m_device, v, nullptr);
+                }
+                m_depthSampleViews.clear();
+                return;
+            }
+        }
+    }
+
+    void Renderer::destroyDepthPrePassResources(bool keepPasses)
+    {
+        for (VkImageView v : m_depthSampleViews)
+        {
+            if (v != VK_NULL_HANDLE)
+                vkDestroyImageView(m_device, v, nullptr);
+        }
+        m_depthSampleViews.clear();
+        for (VkFramebuffer fb : m_depthFramebuffers)
+        {
+            if (fb != VK_NULL_HANDLE)
+                vkDestroyFramebuffer(m_device, fb, nullptr);
+        }
+        m_depthFramebuffers.clear();
+
+        if (keepPasses)
+            return;
+
+        // The pyramid holds one level set per swapchain image, so it follows the render passes.
+        m_hiZ.destroy();
+        if (m_mainRenderPassLoadDepth != VK_NULL_HANDLE)
+            vkDestroyRenderPass(m_device, m_mainRenderPassLoadDepth, nullptr);
+        if (m_depthPrePass != VK_NULL_HANDLE)
+            vkDestroyRenderPass(m_device, m_depthPrePass, nullptr);
+        m_mainRenderPassLoadDepth = VK_NULL_HANDLE;
+        m_depthPrePass = VK_NULL_HANDLE;
     }
 
-    void Renderer::recreateSwapchainDependent()
+    void Renderer::setDepthPrePass(bool enabled)
     {
+        if (enabled == m_depthPrePassEnabled)
+            return;
+        m_depthPrePassEnabled = enabled;
+        if (!m_initialized)
+            return;
+
+        // Depth images gain/lose sampled usage; the main render pass and every module stay.
         vkDeviceWaitIdle(m_device);
+        for (auto fb : m_framebuffers)
+        {
+            if (fb != VK_NULL_HANDLE)
+                vkDestroyFramebuffer(m_device, fb, nullptr);
+        }
+        m_framebuffers.clear();
+        destroyDepthPrePassResources(false);
+        destroyDepthResources();
 
-        // Destroy pass-owned resources that depend on renderpass/framebuffers
+        createDepthResources();
+        createFramebuffers();
+        if (m_depthPrePassEnabled)
+            createDepthPrePassResources();
+    }
+
+    void Renderer::recordDepthPrePass(FrameContext &frame, uint32_t imageIndex)
+    {
+        VkCommandBuffer cmd = frame.commandBuffer;
+
+        {
+            GpuScope gpu(frame.gpuProfiler, cmd, "Depth pre-pass", true);
+
+            VkClearValue clear{};
+            clear.depthStencil = {1.0f, 0};
+
+            VkRenderPassBeginInfo rpBegin{};
+            rpBegin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            rpBegin.renderPass = m_depthPrePass;
+            rpBegin.framebuffer = m_depthFramebuffers[imageIndex];
+            rpBegin.renderArea.offset = {0, 0};
+            rpBegin.renderArea.extent = m_extent;
+            rpBegin.clearValueCount = 1;
+            rpBegin.pClearValues = &clear;
+
+            vkCmdBeginRenderPass(cmd, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
+            for (auto &p : m_passes)
+            {
+                if (p)
+                    p->recordDepthPrePass(frame, cmd);
+            }
+            vkCmdEndRenderPass(cmd);
+        }
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = m_depthImages[imageIndex];
+        barrier.subresourceRange = {depthAspectFlags(m_depthFormat), 0, 1, 0, 1};
+
+        const VkPipelineStageFlags fragmentTests = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        if (frame.hiZView == VK_NULL_HANDLE)
+        {
+            // The main pass loads the depth right away.
+            barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            vkCmdPipelineBarrier(cmd, fragmentTests, fragmentTests, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+            return;
+        }
+
+        // Depth -> Hi-Z build -> occlusion culling, then back to an attachment for the main pass.
+        barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(cmd, fragmentTests, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        {
+            GpuScope gpu(frame.gpuProfiler, cmd, "Hi-Z", true);
+            m_hiZ.record(cmd, m_currentFrame, m_depthSampleViews[imageIndex]);
+        }
         for (auto &p : m_passes)
         {
             if (p)
-                p->onDestroy(*m_ctx);
+                p->recordOcclusionCull(frame, cmd);
         }
 
+        barrier.srcAccessMask = 0; // reads only
+        barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, fragmentTests, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    bool Renderer::resize(VkExtent2D extent)
+    {
+        if (!m_initialized)
+            return true;
+
+        vkDeviceWaitIdle(m_device);
+        m_swapchain->Recreate(extent);
+        m_firstPresentIdOfSwapchain = m_presentId + 1;
+        return recreateSwapchainDependent();
+    }
+
+    uint32_t Renderer::clampFramesInFlight(uint32_t frames) const
+    {
+        const uint32_t images = static_cast<uint32_t>(m_swapchain->GetImageViews().size());
+        return std::max(1u, images > 0 ? std::min(frames, images) : frames);
+    }
+
+    bool Renderer::setFramePacing(const FramePacing &pacing)
+    {
+        const bool presentModeChanged = pacing.presentMode != m_pacing.presentMode;
+        m_pacing = pacing;
+        m_nextFrameStart = {};
+        m_swapchain->SetPreferredPresentMode(pacing.presentMode);
+
+        if (!m_initialized)
+        {
+            m_maxFrames = std::max(1u, pacing.framesInFlight);
+            return true;
+        }
+
+        bool renderPassKept = true;
+        if (presentModeChanged)
+            renderPassKept = resize(m_extent);
+
+        const uint32_t frames = clampFramesInFlight(pacing.framesInFlight);
+        if (frames != m_maxFrames)
+        {
+            // Frame slots only: modules index their per-image resources, which do not change here.
+            vkDeviceWaitIdle(m_device);
+            destroyTimestampQueryPool();
+            destroyCommandPoolsAndBuffers();
+            destroySyncObjects();
+            m_transient.destroy();
+
+            m_maxFrames = frames;
+            m_frames.assign(m_maxFrames, FrameContext{});
+            m_currentFrame = 0;
+
+            createSyncObjects();
+            createCommandPoolsAndBuffers();
+            createTimestampQueryPool();
+            createTransientBuffers();
+        }
+
+        std::cout << "Renderer: present mode " << m_swapchain->GetPresentMode() << ", " << m_maxFrames
+                  << " frame(s) in flight, present wait "
+                  << (m_waitForPresent && m_pacing.maxQueuedPresents > 0 ? "on" : "off")
+                  << ", fps cap " << m_pacing.maxFps << "\n";
+        return renderPassKept;
+    }
+
+    void Renderer::waitForFrameStart()
+    {
+        if (!m_initialized)
+            return;
+
+        const uint64_t queued = m_pacing.maxQueuedPresents;
+        if (m_waitForPresent && queued > 0 && m_presentId >= queued)
+        {
+            // Presents made before the last swapchain recreation can no longer be waited on.
+            const uint64_t target = m_presentId - (queued - 1);
+            if (target >= m_firstPresentIdOfSwapchain)
+            {
+                // Bounded: an occluded window may never display the image.
+                constexpr uint64_t kPresentWaitTimeoutNs = 100'000'000;
+                m_waitForPresent(m_device, m_swapchain->GetSwapchain(), target, kPresentWaitTimeoutNs);
+            }
+        }
+
+        if (m_pacing.maxFps > 0.0f)
+        {
+            using Clock = std::chrono::steady_clock;
+            const auto period = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(1.0 / m_pacing.maxFps));
+            const auto now = Clock::now();
+            // More than a period late (first frame, hitch): restart the schedule instead of bursting.
+            if (m_nextFrameStart == Clock::time_point{} || now - m_nextFrameStart > period)
+                m_nextFrameStart = now;
+            else if (now < m_nextFrameStart)
+                std::this_thread::sleep_until(m_nextFrameStart);
+            m_nextFrameStart += period;
+        }
+    }
+
+    bool Renderer::recreateSwapchainDependent()
+    {
+        // Swapchain itself has been recreated by caller; only extent-dependent targets follow it.
+        vkDeviceWaitIdle(m_device);
+
         for (auto fb : m_framebuffers)
         {
             if (fb != VK_NULL_HANDLE)
@@ -390,34 +779,60 @@ namespace Engine
         }
         m_framebuffers.clear();
 
+        // Modules size per-image resources by the framebuffer count and build pipelines against the
+        // render pass, so a new image format or count still needs the full module rebuild.
+        const size_t previousImageCount = m_depthImages.size();
+        const bool keepPasses = m_swapchain->GetImageFormat() == m_swapchainImageFormat &&
+                                m_swapchain->GetImageViews().size() == previousImageCount;
+        destroyDepthPrePassResources(keepPasses);
         destroyDepthResources();
 
-        if (m_mainRenderPass != VK_NULL_HANDLE)
+        if (!keepPasses)
         {
-            vkDestroyRenderPass(m_device, m_mainRenderPass, nullptr);
-            m_mainRenderPass = VK_NULL_HANDLE;
+            for (auto &p : m_passes)
+            {
+                if (p)
+                    p->onDestroy(*m_ctx);
+            }
+            if (m_mainRenderPass != VK_NULL_HANDLE)
+            {
+                vkDestroyRenderPass(m_device, m_mainRenderPass, nullptr);
+                m_mainRenderPass = VK_NULL_HANDLE;
+            }
         }
 
-        // Swapchain itself has been recreated by caller.
         m_swapchainImageFormat = m_swapchain->GetImageFormat();
         m_extent = m_swapchain->GetExtent();
 
         createDepthResources();
-        createMainRenderPass();
+        if (!keepPasses)
+            createMainRenderPass();
         createFramebuffers();
+        if (m_depthPrePassEnabled)
+            createDepthPrePassResources();
 
+        // Pipelines use dynamic viewport/scissor, so surviving modules only need the new extent.
         for (auto &p : m_passes)
         {
             if (!p)
                 continue;
             p->onResize(*m_ctx, m_extent);
-            p->onCreate(*m_ctx, m_mainRenderPass, m_framebuffers);
+            if (!keepPasses)
+                p->onCreate(*m_ctx, m_mainRenderPass, m_framebuffers);
         }
+        return keepPasses;
     }
 
     void Renderer::createSyncObjects()
     {
-        // For now we create sync objects per frame in flight to support only single threaded rendering
+        // Frame completion is tracked on the graphics timeline when available; fences are the fallback.
+        if (m_ctx->SupportsTimelineSemaphores() && !m_timeline.create(m_device))
+            std::cerr << "Renderer: timeline semaphore unavailable, frames use fences\n";
+        // Async compute is ordered against graphics with timeline values only.
+        if (m_computeQueue != VK_NULL_HANDLE && m_timeline.valid() && !m_computeTimeline.create(m_device))
+            std::cerr << "Renderer: compute timeline unavailable, compute stays on the graphics queue\n";
+
+        // Binary semaphores per frame in flight: swapchain acquire/present cannot use timelines.
         VkSemaphoreCreateInfo semaphoreInfo{};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
@@ -444,7 +859,7 @@ namespace Engine
 
     void Renderer::createCommandPoolsAndBuffers()
     {
-        // For now we create one command pool and buffer per frame in flight to support only single threaded rendering
+        // One primary pool/buffer per frame in flight; secondary pools for parallel recording are created on demand
         for (uint32_t i = 0; i < m_maxFrames; ++i)
         {
             FrameContext &f = m_frames[i];
@@ -469,9 +884,178 @@ namespace Engine
             {
                 throw std::runtime_error("Renderer::createCommandPoolsAndBuffers - failed to allocate command buffer");
             }
+
+            if (!m_computeTimeline.valid())
+                continue;
+
+            poolInfo.queueFamilyIndex = m_ctx->GetComputeQueueFamilyIndex();
+            if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &f.computePool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Renderer::createCommandPoolsAndBuffers - failed to create compute command pool");
+            }
+            allocInfo.commandPool = f.computePool;
+            if (vkAllocateCommandBuffers(m_device, &allocInfo, &f.computeCommandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Renderer::createCommandPoolsAndBuffers - failed to allocate compute command buffer");
+            }
         }
     }
 
+    void Renderer::prepareSecondarySlots(FrameContext &frame, uint32_t slotCount)
+    {
+        while (frame.secondarySlots.size() < slotCount)
+        {
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = m_ctx->GetGraphicsQueueFamilyIndex();
+
+            FrameContext::SecondarySlot slot;
+            if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &slot.pool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Renderer::prepareSecondarySlots - failed to create command pool");
+            }
+            frame.secondarySlots.push_back(std::move(slot));
+        }
+
+        // The frame's fence has signalled, so none of these buffers is still executing.
+        for (uint32_t s = 0; s < slotCount; ++s)
+            vkResetCommandPool(m_device, frame.secondarySlots[s].pool, 0);
+    }
+
+    void Renderer::recordPassesParallel(FrameContext &frame, VkFramebuffer framebuffer)
+    {
+        const uint32_t passCount = static_cast<uint32_t>(m_passes.size());
+        const uint32_t slotCount = std::min(passCount, m_recordPool->threadCount() + 1);
+        const uint32_t passesPerSlot = (passCount + slotCount - 1) / slotCount;
+        const bool imgui = static_cast<bool>(m_imguiRenderCallback);
+
+        prepareSecondarySlots(frame, slotCount);
+
+        // Slot s records passes [s * passesPerSlot, ...) into its own buffers; slot 0 also gets ImGui.
+        for (uint32_t s = 0; s < slotCount; ++s)
+        {
+            const uint32_t first = s * passesPerSlot;
+            const uint32_t count = std::min(passesPerSlot, passCount - std::min(passCount, first)) + ((s == 0 && imgui) ? 1u : 0u);
+            auto &slot = frame.secondarySlots[s];
+            if (slot.buffers.size() < count)
+            {
+                const size_t have = slot.buffers.size();
+                slot.buffers.resize(count, VK_NULL_HANDLE);
+
+                VkCommandBufferAllocateInfo allocInfo{};
+                allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                allocInfo.commandPool = slot.pool;
+                allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                allocInfo.commandBufferCount = static_cast<uint32_t>(count - have);
+                if (vkAllocateCommandBuffers(m_device, &allocInfo, slot.buffers.data() + have) != VK_SUCCESS)
+                {
+                    slot.buffers.resize(have);
+                    throw std::runtime_error("Renderer::recordPassesParallel - failed to allocate secondary command buffers");
+                }
+            }
+        }
+
+        VkCommandBufferInheritanceInfo inheritance{};
+        inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance.renderPass = m_mainRenderPass;
+        inheritance.subpass = 0;
+        inheritance.framebuffer = framebuffer;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritance;
+
+        m_secondaryOrder.assign(passCount, VK_NULL_HANDLE);
+
+        // Ranges of passesPerSlot map 1:1 onto slots, so each pool is only touched by one thread.
+        m_recordPool->parallelFor(passCount, passesPerSlot, [&](uint32_t begin, uint32_t end)
+                                  {
+            auto &slot = frame.secondarySlots[begin / passesPerSlot];
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                VkCommandBuffer cmd = slot.buffers[i - begin];
+                vkBeginCommandBuffer(cmd, &beginInfo);
+                if (m_passes[i])
+                    recordPassTimed(*m_passes[i], frame, cmd);
+                vkEndCommandBuffer(cmd);
+                m_secondaryOrder[i] = cmd;
+            } });
+
+        // ImGui draw data is single-threaded; record it last, after the workers released slot 0.
+        if (imgui)
+        {
+            VkCommandBuffer cmd = frame.secondarySlots[0].buffers[std::min(passesPerSlot, passCount)];
+            vkBeginCommandBuffer(cmd, &beginInfo);
+            {
+                GpuScope gpu(frame.gpuProfiler, cmd, "ImGui", true);
+                m_imguiRenderCallback(cmd);
+            }
+            vkEndCommandBuffer(cmd);
+            m_secondaryOrder.push_back(cmd);
+        }
+    }
+
+    bool Renderer::submitAsyncCompute(FrameContext &frame)
+    {
+        if (frame.computeCommandBuffer == VK_NULL_HANDLE)
+            return false;
+
+        vkResetCommandBuffer(frame.computeCommandBuffer, 0);
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(frame.computeCommandBuffer, &beginInfo);
+
+        frame.gpuProfiler = nullptr;
+        bool recorded = false;
+        for (auto &p : m_passes)
+        {
+            if (p)
+                recorded = p->recordAsyncCompute(frame, frame.computeCommandBuffer) || recorded;
+        }
+        vkEndCommandBuffer(frame.computeCommandBuffer);
+        if (!recorded)
+            return false;
+
+        frame.computeTimelineValue = m_computeTimeline.reserve();
+        const VkSemaphore signal = m_computeTimeline.semaphore();
+
+        VkTimelineSemaphoreSubmitInfoKHR timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+        timelineInfo.signalSemaphoreValueCount = 1;
+        timelineInfo.pSignalSemaphoreValues = &frame.computeTimelineValue;
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &frame.computeCommandBuffer;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &signal;
+
+        VkResult r;
+        {
+            std::lock_guard<std::mutex> lock(m_ctx->GetQueueMutex());
+            r = vkQueueSubmit(m_computeQueue, 1, &submitInfo, VK_NULL_HANDLE);
+        }
+        if (r != VK_SUCCESS)
+        {
+            // Nothing will signal the reserved value; graphics must not wait for it.
+            fprintf(stderr, "Renderer: async compute submit failed: %d\n", r);
+            frame.computeTimelineValue = 0;
+            return false;
+        }
+        return true;
+    }
+
+    void Renderer::recordPassTimed(RenderPassModule &pass, FrameContext &frame, VkCommandBuffer cmd)
+    {
+        GpuScope gpu(frame.gpuProfiler, cmd, pass.debugName(), true);
+        pass.record(frame, cmd);
+    }
+
     void Renderer::drawFrame()
     {
         if (!m_initialized)
@@ -480,15 +1064,46 @@ namespace Engine
         FrameContext &frame = m_frames[m_currentFrame];
         frame.frameIndex = m_currentFrame;
 
-        // Wait for previous frame to finish
-        VkResult r = vkWaitForFences(m_device, 1, &frame.inFlightFence, VK_TRUE, UINT64_MAX);
-        if (r != VK_SUCCESS)
+        // Wait for this slot's previous frame to finish
+        if (m_timeline.valid())
         {
-            fprintf(stderr, "vkWaitForFences failed: %d\n", r);
-            // Recover strategy: mark device lost or try a soft return
-            return;
+            // A compute submission whose frame was dropped (out-of-date swapchain) is not covered by
+            // the graphics value, so its command buffer is waited for separately.
+            if (!m_timeline.wait(frame.timelineValue) ||
+                (m_computeTimeline.valid() && !m_computeTimeline.wait(frame.computeTimelineValue)))
+            {
+                fprintf(stderr, "Renderer: graphics timeline wait failed\n");
+                return;
+            }
+            m_timeline.collect();
+            m_computeTimeline.collect();
+        }
+        else
+        {
+            VkResult r = vkWaitForFences(m_device, 1, &frame.inFlightFence, VK_TRUE, UINT64_MAX);
+            if (r != VK_SUCCESS)
+            {
+                fprintf(stderr, "vkWaitForFences failed: %d\n", r);
+                // Recover strategy: mark device lost or try a soft return
+                return;
+            }
         }
 
+        // The slot's previous frame is done with its transient data.
+        m_transient.beginFrame(m_currentFrame);
+        frame.transient = &m_transient;
+        uploadView(frame);
+
+        // Depth pre-pass targets of this frame; the pyramid is per frame slot, the depth per image.
+        const bool depthPrePass = m_depthPrePass != VK_NULL_HANDLE;
+        const bool hiZ = depthPrePass && !m_depthSampleViews.empty() && m_hiZ.ready();
+        frame.depthPrePass = depthPrePass ? m_depthPrePass : VK_NULL_HANDLE;
+        frame.hiZView = hiZ ? m_hiZ.view(m_currentFrame) : VK_NULL_HANDLE;
+        frame.hiZSampler = hiZ ? m_hiZ.sampler() : VK_NULL_HANDLE;
+
+        // Async compute goes first: it overlaps the previous frame's graphics work and the acquire.
+        const bool computeSubmitted = submitAsyncCompute(frame);
+
         // Acquire next image
         uint32_t imageIndex = 0;
         VkResult acquireRes = vkAcquireNextImageKHR(
@@ -502,10 +1117,8 @@ namespace Engine
         if (acquireRes == VK_ERROR_OUT_OF_DATE_KHR)
         {
             // Window resized or swapchain invalid -> recreate and skip this frame
-            m_swapchain->Recreate(m_extent);
-            // Framebuffers/renderpass depend on swapchain.
-            recreateSwapchainDependent();
-            return; // IMPORTANT: we did NOT reset the fence, so next frame’s wait will pass.
+            resize(m_extent);
+            return; // IMPORTANT: we did NOT reset the fence / signal a new value, so next frame’s wait will pass.
         }
         if (acquireRes != VK_SUCCESS && acquireRes != VK_SUBOPTIMAL_KHR)
         {
@@ -513,6 +1126,10 @@ namespace Engine
             return; // Do not reset the fence on failure paths
         }
 
+        // Value this submission signals; set before recording so modules can defer releases against it.
+        frame.timeline = m_timeline.valid() ? &m_timeline : nullptr;
+        frame.timelineValue = frame.timeline ? m_timeline.reserve() : 0;
+
         // Record command buffer
         vkResetCommandBuffer(frame.commandBuffer, 0);
 
@@ -521,16 +1138,31 @@ namespace Engine
         beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
         vkBeginCommandBuffer(frame.commandBuffer, &beginInfo);
 
-        // GPU timestamp: reset queries for this frame
-        const uint32_t startQuery = m_currentFrame * 2;
-        const uint32_t endQuery = startQuery + 1;
-        if (m_timestampsSupported && m_timestampQueryPool != VK_NULL_HANDLE)
+        // GPU timers: this slot's fence has signalled, so its previous results are final. Resolve
+        // them, then reset the slot's queries for this frame.
+        frame.gpuProfiler = m_gpuProfiler.enabled() ? &m_gpuProfiler : nullptr;
+        m_gpuProfiler.beginFrame(frame.commandBuffer, m_currentFrame);
+        if (frame.gpuProfiler)
         {
-            vkCmdResetQueryPool(frame.commandBuffer, m_timestampQueryPool, startQuery, 2);
-            // Write start timestamp (at top of pipe for earliest possible time)
-            vkCmdWriteTimestamp(frame.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestampQueryPool, startQuery);
+            const float frameMs = m_gpuProfiler.lastMs("Frame");
+            if (frameMs > 0.0f)
+                m_gpuTimeMs.store(frameMs, std::memory_order_relaxed);
+        }
+        const uint32_t frameTimer = m_gpuProfiler.beginTimer(frame.commandBuffer, "Frame");
+
+        // Pre-pass work (compute culling etc.) must be recorded before the render pass begins.
+        {
+            GpuScope gpu(frame.gpuProfiler, frame.commandBuffer, "Pre-pass", true);
+            for (auto &p : m_passes)
+            {
+                if (p)
+                    p->recordPrePass(frame, frame.commandBuffer);
+            }
         }
 
+        if (depthPrePass)
+            recordDepthPrePass(frame, imageIndex);
+
         // Begin render pass
         VkClearValue clears[2]{};
         clears[0].color = {{0.02f, 0.02f, 0.04f, 1.0f}};
@@ -538,81 +1170,106 @@ namespace Engine
 
         VkRenderPassBeginInfo rpBegin{};
         rpBegin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        rpBegin.renderPass = m_mainRenderPass;
+        rpBegin.renderPass = depthPrePass ? m_mainRenderPassLoadDepth : m_mainRenderPass;
         rpBegin.framebuffer = m_framebuffers[imageIndex];
         rpBegin.renderArea.offset = {0, 0};
         rpBegin.renderArea.extent = m_extent;
         rpBegin.clearValueCount = 2;
         rpBegin.pClearValues = clears;
 
-        vkCmdBeginRenderPass(frame.commandBuffer, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
-
-        // Let modules record draw commands
-        for (auto &p : m_passes)
+        if (m_recordPool && m_passes.size() > 1)
         {
-            if (p)
-                p->record(frame, frame.commandBuffer);
-        }
+            // Modules record in parallel into secondaries; the primary only executes them.
+            recordPassesParallel(frame, m_framebuffers[imageIndex]);
 
-        // Render ImGui if callback is set
-        if (m_imguiRenderCallback)
+            vkCmdBeginRenderPass(frame.commandBuffer, &rpBegin, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            if (!m_secondaryOrder.empty())
+                vkCmdExecuteCommands(frame.commandBuffer, static_cast<uint32_t>(m_secondaryOrder.size()), m_secondaryOrder.data());
+        }
+        else
         {
-            m_imguiRenderCallback(frame.commandBuffer);
+            vkCmdBeginRenderPass(frame.commandBuffer, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
+
+            // Let modules record draw commands
+            for (auto &p : m_passes)
+            {
+                if (p)
+                    recordPassTimed(*p, frame, frame.commandBuffer);
+            }
+
+            // Render ImGui if callback is set
+            if (m_imguiRenderCallback)
+            {
+                GpuScope gpu(frame.gpuProfiler, frame.commandBuffer, "ImGui", true);
+                m_imguiRenderCallback(frame.commandBuffer);
+            }
         }
 
         vkCmdEndRenderPass(frame.commandBuffer);
 
-        // GPU timestamp: write end timestamp (at bottom of pipe for latest possible time)
-        if (m_timestampsSupported && m_timestampQueryPool != VK_NULL_HANDLE)
+        m_gpuProfiler.endTimer(frame.commandBuffer, frameTimer);
+
+        vkEndCommandBuffer(frame.commandBuffer);
+
+        // Submit to graphics queue: wait for the swapchain image and any cross-queue timeline waits,
+        // signal the present semaphore and the graphics timeline.
+        std::vector<VkSemaphore> &waitSemaphores = m_submitWaitSemaphores;
+        std::vector<VkPipelineStageFlags> &waitStages = m_submitWaitStages;
+        std::vector<uint64_t> &waitValues = m_submitWaitValues;
+        waitSemaphores.assign(1, frame.imageAcquiredSemaphore);
+        waitStages.assign(1, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT);
+        waitValues.assign(1, 0); // binary semaphores ignore their value
+        for (const TimelineWait &w : m_frameWaits)
+        {
+            waitSemaphores.push_back(w.semaphore);
+            waitStages.push_back(w.stage);
+            waitValues.push_back(w.value);
+        }
+        m_frameWaits.clear();
+        if (computeSubmitted)
         {
-            vkCmdWriteTimestamp(frame.commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestampQueryPool, endQuery);
+            // Results feed pre-pass copies/dispatches, indirect arguments and vertex fetch.
+            waitSemaphores.push_back(m_computeTimeline.semaphore());
+            waitStages.push_back(VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                                 VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                                 VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+            waitValues.push_back(frame.computeTimelineValue);
         }
 
-        vkEndCommandBuffer(frame.commandBuffer);
+        const VkSemaphore signalSemaphores[2] = {frame.renderFinishedSemaphore, m_timeline.semaphore()};
+        const uint64_t signalValues[2] = {0, frame.timelineValue};
 
-        // Submit to graphics queue
-        VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT};
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.waitSemaphoreCount = 1;
-        submitInfo.pWaitSemaphores = &frame.imageAcquiredSemaphore;
-        submitInfo.pWaitDstStageMask = waitStages;
+        submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+        submitInfo.pWaitSemaphores = waitSemaphores.data();
+        submitInfo.pWaitDstStageMask = waitStages.data();
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &frame.commandBuffer;
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = &frame.renderFinishedSemaphore;
-
-        vkResetFences(m_device, 1, &frame.inFlightFence);
-        vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, frame.inFlightFence);
+        submitInfo.signalSemaphoreCount = frame.timeline ? 2u : 1u;
+        submitInfo.pSignalSemaphores = signalSemaphores;
 
-        // Read GPU timestamp results from the PREVIOUS frame (which has definitely completed due to fence wait above)
-        // We read from the previous frame's queries since the current frame hasn't finished yet
-        if (m_timestampsSupported && m_timestampQueryPool != VK_NULL_HANDLE && m_maxFrames > 1)
+        VkTimelineSemaphoreSubmitInfoKHR timelineInfo{};
+        if (frame.timeline)
         {
-            // Calculate the previous frame's query indices
-            const uint32_t prevFrame = (m_currentFrame + m_maxFrames - 1) % m_maxFrames;
-            const uint32_t prevStartQuery = prevFrame * 2;
-            uint64_t timestamps[2] = {0, 0};
-            
-            VkResult queryResult = vkGetQueryPoolResults(
-                m_device,
-                m_timestampQueryPool,
-                prevStartQuery,
-                2,  // Query count
-                sizeof(timestamps),
-                timestamps,
-                sizeof(uint64_t),
-                VK_QUERY_RESULT_64_BIT
-            );
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+            timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+            timelineInfo.pWaitSemaphoreValues = waitValues.data();
+            timelineInfo.signalSemaphoreValueCount = 2;
+            timelineInfo.pSignalSemaphoreValues = signalValues;
+            submitInfo.pNext = &timelineInfo;
+        }
 
-            if (queryResult == VK_SUCCESS && timestamps[1] > timestamps[0])
-            {
-                // Calculate GPU time in milliseconds
-                // timestampPeriod is in nanoseconds per tick
-                const uint64_t ticksDelta = timestamps[1] - timestamps[0];
-                const float nanoseconds = static_cast<float>(ticksDelta) * m_timestampPeriod;
-                m_gpuTimeMs = nanoseconds / 1000000.0f;  // Convert ns to ms
-            }
+        VkFence submitFence = VK_NULL_HANDLE;
+        if (!frame.timeline)
+        {
+            vkResetFences(m_device, 1, &frame.inFlightFence);
+            submitFence = frame.inFlightFence;
+        }
+        {
+            // Asset streaming may submit to this queue from the main thread.
+            std::lock_guard<std::mutex> lock(m_ctx->GetQueueMutex());
+            vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, submitFence);
         }
 
         // Present
@@ -625,13 +1282,37 @@ namespace Engine
         presentInfo.pSwapchains = swapchains;
         presentInfo.pImageIndices = &imageIndex;
 
-        vkQueuePresentKHR(m_presentQueue, &presentInfo);
+        // Tag the present so waitForFrameStart() can wait until it is on screen.
+        uint64_t presentId = 0;
+        VkPresentIdKHR presentIdInfo{};
+        if (m_waitForPresent)
+        {
+            presentId = m_presentId + 1;
+            presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+            presentIdInfo.swapchainCount = 1;
+            presentIdInfo.pPresentIds = &presentId;
+            presentInfo.pNext = &presentIdInfo;
+        }
+
+        VkResult presentRes;
+        {
+            std::lock_guard<std::mutex> lock(m_ctx->GetQueueMutex());
+            presentRes = vkQueuePresentKHR(m_presentQueue, &presentInfo);
+        }
+        if (m_waitForPresent && (presentRes == VK_SUCCESS || presentRes == VK_SUBOPTIMAL_KHR))
+            m_presentId = presentId;
         // Advance frame index
         m_currentFrame = (m_currentFrame + 1) % m_maxFrames;
     }
 
     void Renderer::destroySyncObjects()
     {
+        // Callers waited for device idle, so every deferred release is safe to run now.
+        m_timeline.destroy();
+        m_computeTimeline.destroy();
+        m_frameWaits.clear();
+        m_pendingWaits.clear();
+
         for (auto &f : m_frames)
         {
             if (f.imageAcquiredSemaphore != VK_NULL_HANDLE)
@@ -662,47 +1343,61 @@ namespace Engine
                 f.commandPool = VK_NULL_HANDLE;
                 f.commandBuffer = VK_NULL_HANDLE;
             }
+            if (f.computePool != VK_NULL_HANDLE)
+            {
+                vkDestroyCommandPool(m_device, f.computePool, nullptr);
+                f.computePool = VK_NULL_HANDLE;
+                f.computeCommandBuffer = VK_NULL_HANDLE;
+            }
+
+            // Destroying a pool frees its secondary buffers.
+            for (auto &slot : f.secondarySlots)
+            {
+                if (slot.pool != VK_NULL_HANDLE)
+                    vkDestroyCommandPool(m_device, slot.pool, nullptr);
+            }
+            f.secondarySlots.clear();
         }
     }
 
     void Renderer::createTimestampQueryPool()
     {
-        destroyTimestampQueryPool();
-
-        // Check if the device supports timestamps
-        VkPhysicalDeviceProperties props{};
-        vkGetPhysicalDeviceProperties(m_ctx->GetPhysicalDevice(), &props);
+        // Pipeline statistics are optional (needs the pipelineStatisticsQuery device feature).
+        if (!m_gpuProfiler.init(m_device, m_ctx->GetPhysicalDevice(), m_maxFrames, m_ctx->SupportsPipelineStatistics()))
+            std::cerr << "Renderer: GPU timestamps unsupported, pass timings disabled\n";
+    }
 
-        if (props.limits.timestampComputeAndGraphics == VK_FALSE)
-        {
-            m_timestampsSupported = false;
+    void Renderer::uploadView(FrameContext &frame)
+    {
+        frame.view = m_hasView ? &m_view : nullptr;
+        frame.viewBuffer = VK_NULL_HANDLE;
+        frame.viewOffset = 0;
+        if (!m_hasView)
             return;
-        }
-
-        m_timestampPeriod = props.limits.timestampPeriod; // Nanoseconds per tick
-        m_timestampsSupported = true;
 
-        // Create a query pool with 2 queries per frame (start and end)
-        // We use 2 * maxFrames to have per-frame queries
-        VkQueryPoolCreateInfo poolInfo{};
-        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
-        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
-        poolInfo.queryCount = m_maxFrames * 2; // 2 timestamps per frame
+        const TransientAllocator::Allocation block = m_transient.allocate(m_currentFrame, sizeof(GpuViewData));
+        if (!block)
+            return;
+        const GpuViewData data = GpuViewData::from(m_view);
+        std::memcpy(block.mapped, &data, sizeof(GpuViewData));
+        frame.viewBuffer = block.buffer;
+        frame.viewOffset = block.offset;
+        frame.viewBufferVersion = block.bufferVersion;
+    }
 
-        if (vkCreateQueryPool(m_device, &poolInfo, nullptr, &m_timestampQueryPool) != VK_SUCCESS)
-        {
-            m_timestampsSupported = false;
-            m_timestampQueryPool = VK_NULL_HANDLE;
-        }
+    void Renderer::createTransientBuffers()
+    {
+        // Grows per slot on overflow; 1 MiB covers the sample's camera and impostor streams.
+        if (!m_transient.create(m_device, m_ctx->GetPhysicalDevice(), m_maxFrames, 1024 * 1024))
+            throw std::runtime_error("Renderer::createTransientBuffers - failed to create transient buffers");
+        for (auto &f : m_frames)
+            f.transient = &m_transient;
     }
 
     void Renderer::destroyTimestampQueryPool()
     {
-        if (m_timestampQueryPool != VK_NULL_HANDLE)
-        {
-            vkDestroyQueryPool(m_device, m_timestampQueryPool, nullptr);
-            m_timestampQueryPool = VK_NULL_HANDLE;
-        }
-        m_timestampsSupported = false;
+        m_gpuProfiler.destroy();
+        for (auto &f : m_frames)
+            f.gpuProfiler = nullptr;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,691 @@
+#include "ECS/Replication.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace Engine::ECS
+{
+    namespace
+    {
+        // ------------------------------------------------------------
+        // Packet layout (varints are LEB128, signed values zigzag encoded)
+        // ------------------------------------------------------------
+        //   uint8 version, varint tick, varint baselineTick (0 = none), varint entryCount
+        //   entryCount x { varint index - previousIndex, uint8 flags,
+        //                  Full:     varint generation, 3 x svarint position, 3 x svarint velocity
+        //                  Position: 3 x svarint (position - baseline)
+        //                  Velocity: 3 x svarint (velocity - baseline) }
+        // Entries are in ascending index order; entities not listed are unchanged from the baseline.
+
+        constexpr uint8_t kPacketVersion = 1;
+
+        enum PacketFlag : uint8_t
+        {
+            Removed = 1,
+            Full = 2,
+            PositionDelta = 4,
+            VelocityDelta = 8,
+        };
+
+        // Rows compared with one memcmp before looking at single rows.
+        constexpr uint32_t kBlockRows = 64;
+
+        void putVarint(std::vector<uint8_t> &out, uint64_t v)
+        {
+            while (v >= 0x80)
+            {
+                out.push_back(static_cast<uint8_t>(v | 0x80));
+                v >>= 7;
+            }
+            out.push_back(static_cast<uint8_t>(v));
+        }
+
+        void putSigned(std::vector<uint8_t> &out, int64_t v)
+        {
+            putVarint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+        }
+
+        uint32_t varintSize(uint64_t v)
+        {
+            uint32_t n = 1;
+            while (v >= 0x80)
+            {
+                v >>= 7;
+                ++n;
+            }
+            return n;
+        }
+
+        uint32_t signedSize(int64_t v)
+        {
+            return varintSize((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+        }
+
+        class PacketReader
+        {
+        public:
+            PacketReader(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+
+            size_t remaining() const { return m_size - m_pos; }
+
+            bool byte(uint8_t &v)
+            {
+                if (m_pos >= m_size)
+                    return false;
+                v = m_data[m_pos++];
+                return true;
+            }
+
+            bool varint(uint64_t &v)
+            {
+                v = 0;
+                for (uint32_t shift = 0; shift < 64; shift += 7)
+                {
+                    uint8_t b;
+                    if (!byte(b))
+                        return false;
+                    v |= static_cast<uint64_t>(b & 0x7f) << shift;
+                    if ((b & 0x80) == 0)
+                        return true;
+                }
+                return false;
+            }
+
+            bool u32(uint32_t &v)
+            {
+                uint64_t w;
+                if (!varint(w) || w > UINT32_MAX)
+                    return false;
+                v = static_cast<uint32_t>(w);
+                return true;
+            }
+
+            bool svarint(int64_t &v)
+            {
+                uint64_t w;
+                if (!varint(w))
+                    return false;
+                v = static_cast<int64_t>(w >> 1) ^ -static_cast<int64_t>(w & 1);
+                return true;
+            }
+
+            bool atEnd() const { return m_pos == m_size; }
+
+        private:
+            const uint8_t *m_data;
+            size_t m_size;
+            size_t m_pos = 0;
+        };
+
+        template <typename T>
+        T quantize(float value, float step)
+        {
+            const double q = std::floor(static_cast<double>(value) / step + 0.5);
+            if (!std::isfinite(q))
+                return 0;
+            return static_cast<T>(std::clamp(q, static_cast<double>(std::numeric_limits<T>::min()),
+                                             static_cast<double>(std::numeric_limits<T>::max())));
+        }
+
+        bool samePosition(const NetEntityState &a, const NetEntityState &b)
+        {
+            return std::memcmp(a.position, b.position, sizeof(a.position)) == 0;
+        }
+
+        bool sameVelocity(const NetEntityState &a, const NetEntityState &b)
+        {
+            return std::memcmp(a.velocity, b.velocity, sizeof(a.velocity)) == 0;
+        }
+
+        // Encoded size of one entry without its index field.
+        uint32_t entryBytes(uint8_t kind, const NetEntityState *base, const NetEntityState &now)
+        {
+            uint32_t n = 1;
+            if (kind & Full)
+            {
+                n += varintSize(now.generation);
+                for (int a = 0; a < 3; ++a)
+                    n += signedSize(now.position[a]) + signedSize(now.velocity[a]);
+                return n;
+            }
+            for (int a = 0; a < 3; ++a)
+            {
+                if (kind & PositionDelta)
+                    n += signedSize(static_cast<int64_t>(now.position[a]) - base->position[a]);
+                if (kind & VelocityDelta)
+                    n += signedSize(static_cast<int64_t>(now.velocity[a]) - base->velocity[a]);
+            }
+            return n;
+        }
+
+        bool fail(std::string &outError, const std::string &message)
+        {
+            outError = "Replication: " + message;
+            return false;
+        }
+    }
+
+    // ------------------------------------------------------------
+    // ColumnChangeTracker
+    // ------------------------------------------------------------
+
+    void ColumnChangeTracker::track(uint32_t componentId)
+    {
+        m_tracked.set(componentId);
+        // The new column has no copies yet: compare whole stores once.
+        for (StoreCopy &copy : m_stores)
+            copy.valid = false;
+    }
+
+    void ColumnChangeTracker::reset()
+    {
+        m_stores.clear();
+        m_dirty.clear();
+        m_departed.clear();
+    }
+
+    void ColumnChangeTracker::update(const ArchetypeStoreManager &stores)
+    {
+        m_dirty.clear();
+        m_departed.clear();
+
+        // Rows written after 'since' are the only candidates; the copies hold everything up to it.
+        const uint32_t since = m_seenVersion;
+        m_seenVersion = stores.advanceChangeVersion();
+
+        const auto &all = stores.stores();
+        if (m_stores.size() < all.size())
+            m_stores.resize(all.size());
+
+        for (uint32_t storeId = 0; storeId < static_cast<uint32_t>(all.size()); ++storeId)
+        {
+            const ArchetypeStore *store = all[storeId].get();
+            if (!store || store->signature().containsNone(m_tracked))
+                continue;
+
+            StoreCopy &copy = m_stores[storeId];
+            const std::vector<Entity> &entities = store->entities();
+            const uint32_t rows = store->size();
+            const uint32_t prevRows = static_cast<uint32_t>(copy.entities.size());
+
+            // Same rows as last time (and copies of them): only written chunks need a look.
+            const bool sameRows = copy.valid && prevRows == rows && store->structureVersion() <= since;
+            if (sameRows && !store->changedSince(m_tracked, since))
+                continue;
+
+            m_rowChanged.assign(rows, 0);
+            if (!sameRows)
+            {
+                for (uint32_t row = 0; row < rows; ++row)
+                {
+                    if (row >= prevRows)
+                    {
+                        m_rowChanged[row] = 1;
+                        continue;
+                    }
+                    const Entity &was = copy.entities[row];
+                    if (was.index != entities[row].index || was.generation != entities[row].generation)
+                    {
+                        m_rowChanged[row] = 1;
+                        m_departed.push_back(was);
+                    }
+                }
+                for (uint32_t row = rows; row < prevRows; ++row)
+                    m_departed.push_back(copy.entities[row]);
+                copy.entities.assign(entities.begin(), entities.end());
+            }
+            copy.valid = true;
+
+            store->forEachColumnData([&](uint32_t componentId, const ComponentTypeInfo &type, const void *data)
+                                     {
+                                         if (!m_tracked.has(componentId))
+                                             return;
+                                         ColumnCopy *col = nullptr;
+                                         for (ColumnCopy &c : copy.columns)
+                                         {
+                                             if (c.componentId == componentId)
+                                                 col = &c;
+                                         }
+                                         if (!col)
+                                         {
+                                             copy.columns.push_back(ColumnCopy{componentId, {}});
+                                             col = &copy.columns.back();
+                                         }
+
+                                         const size_t elem = type.size;
+                                         const uint8_t *now = static_cast<const uint8_t *>(data);
+                                         const uint32_t copiedRows = static_cast<uint32_t>(col->bytes.size() / elem);
+                                         col->bytes.resize(static_cast<size_t>(rows) * elem);
+                                         uint8_t *was = col->bytes.data();
+
+                                         auto closeRange = [&](uint32_t begin, uint32_t end)
+                                         {
+                                             m_dirty.push_back(DirtyRange{storeId, componentId, begin, end});
+                                             std::memcpy(was + begin * elem, now + begin * elem, (end - begin) * elem);
+                                         };
+
+                                         // Diff rows [first, last): block memcmp first, then single rows.
+                                         auto diffRows = [&](uint32_t first, uint32_t last)
+                                         {
+                                             uint32_t runBegin = UINT32_MAX;
+                                             for (uint32_t block = first; block < last; block += kBlockRows)
+                                             {
+                                                 const uint32_t blockEnd = std::min(last, block + kBlockRows);
+                                                 const bool clean = blockEnd <= copiedRows &&
+                                                                    std::memcmp(was + block * elem, now + block * elem, (blockEnd - block) * elem) == 0 &&
+                                                                    std::find(m_rowChanged.begin() + block, m_rowChanged.begin() + blockEnd, 1) == m_rowChanged.begin() + blockEnd;
+                                                 for (uint32_t row = block; row < blockEnd; ++row)
+                                                 {
+                                                     const bool dirty = !clean &&
+                                                                        (m_rowChanged[row] || row >= copiedRows ||
+                                                                         std::memcmp(was + row * elem, now + row * elem, elem) != 0);
+                                                     if (dirty && runBegin == UINT32_MAX)
+                                                         runBegin = row;
+                                                     else if (!dirty && runBegin != UINT32_MAX)
+                                                     {
+                                                         closeRange(runBegin, row);
+                                                         runBegin = UINT32_MAX;
+                                                     }
+                                                 }
+                                             }
+                                             if (runBegin != UINT32_MAX)
+                                                 closeRange(runBegin, last);
+                                         };
+
+                                         if (!sameRows || copiedRows != rows)
+                                         {
+                                             diffRows(0, rows);
+                                             return;
+                                         }
+                                         ComponentMask column;
+                                         column.set(componentId);
+                                         store->forEachChangedRange(column, since, diffRows); });
+        }
+    }
+
+    // ------------------------------------------------------------
+    // ReplicationServer
+    // ------------------------------------------------------------
+
+    void ReplicationServer::initialize(const ComponentRegistry &registry)
+    {
+        m_positionId = registry.typeId<Position>();
+        m_velocityId = registry.typeId<Velocity>();
+        m_changes = ColumnChangeTracker{};
+        if (m_positionId != ComponentRegistry::InvalidID)
+            m_changes.track(m_positionId);
+        if (m_velocityId != ComponentRegistry::InvalidID)
+            m_changes.track(m_velocityId);
+        m_world.clear();
+    }
+
+    uint32_t ReplicationServer::addClient()
+    {
+        for (uint32_t id = 0; id < static_cast<uint32_t>(m_clients.size()); ++id)
+        {
+            if (!m_clients[id].active)
+            {
+                m_clients[id] = Client{};
+                m_clients[id].active = true;
+                return id;
+            }
+        }
+        m_clients.emplace_back();
+        m_clients.back().active = true;
+        return static_cast<uint32_t>(m_clients.size() - 1);
+    }
+
+    void ReplicationServer::removeClient(uint32_t clientId)
+    {
+        if (clientId < m_clients.size())
+            m_clients[clientId] = Client{};
+    }
+
+    void ReplicationServer::setClientView(uint32_t clientId, float x, float z, float interestRadius)
+    {
+        if (clientId >= m_clients.size() || !m_clients[clientId].active)
+            return;
+        Client &c = m_clients[clientId];
+        c.viewX = x;
+        c.viewZ = z;
+        c.interestRadius = interestRadius;
+    }
+
+    void ReplicationServer::acknowledge(uint32_t clientId, uint32_t tick)
+    {
+        if (clientId >= m_clients.size() || !m_clients[clientId].active)
+            return;
+        Client &c = m_clients[clientId];
+        if ((c.hasAck && tick <= c.ackedTick) || !findView(c, tick))
+            return;
+        c.ackedTick = tick;
+        c.hasAck = true;
+        while (!c.history.empty() && c.history.front().tick < tick)
+            c.history.pop_front();
+    }
+
+    const ReplicationServer::View *ReplicationServer::findView(const Client &c, uint32_t tick) const
+    {
+        for (const View &v : c.history)
+        {
+            if (v.tick == tick)
+                return &v;
+        }
+        return nullptr;
+    }
+
+    void ReplicationServer::refreshRow(const ArchetypeStore &store, uint32_t row)
+    {
+        const Entity e = store.entities()[row];
+        if (e.index >= m_world.size())
+            m_world.resize(static_cast<size_t>(e.index) + 1);
+
+        WorldEntry &w = m_world[e.index];
+        w.alive = true;
+        w.state.index = e.index;
+        w.state.generation = e.generation;
+
+        const Position &p = store.positions()[row];
+        w.state.position[0] = quantize<int32_t>(p.x, m_config.positionStep);
+        w.state.position[1] = quantize<int32_t>(p.y, m_config.positionStep);
+        w.state.position[2] = quantize<int32_t>(p.z, m_config.positionStep);
+
+        const Velocity v = store.hasVelocity() ? store.velocities()[row] : Velocity{};
+        w.state.velocity[0] = quantize<int16_t>(v.x, m_config.velocityStep);
+        w.state.velocity[1] = quantize<int16_t>(v.y, m_config.velocityStep);
+        w.state.velocity[2] = quantize<int16_t>(v.z, m_config.velocityStep);
+    }
+
+    void ReplicationServer::captureTick(const ECSContext &ecs)
+    {
+        ++m_tick;
+        m_changes.update(ecs.stores);
+
+        // Departures first: an index reused within the tick is picked up again by its dirty row below.
+        for (const Entity &e : m_changes.departed())
+        {
+            if (e.index >= m_world.size())
+                continue;
+            WorldEntry &w = m_world[e.index];
+            if (!w.alive || w.state.generation != e.generation)
+                continue;
+            const EntityRecord *rec = ecs.entities.find(e);
+            const ArchetypeStore *store = rec ? ecs.stores.get(rec->archetypeId) : nullptr;
+            if (!store || !store->hasPosition())
+                w.alive = false;
+        }
+
+        for (const ColumnChangeTracker::DirtyRange &r : m_changes.dirtyRanges())
+        {
+            const ArchetypeStore *store = ecs.stores.get(r.storeId);
+            if (!store || !store->hasPosition())
+                continue;
+            for (uint32_t row = r.begin; row < r.end; ++row)
+                refreshRow(*store, row);
+        }
+    }
+
+    bool ReplicationServer::writePacket(uint32_t clientId, std::vector<uint8_t> &out)
+    {
+        out.clear();
+        if (clientId >= m_clients.size() || !m_clients[clientId].active)
+            return false;
+        Client &c = m_clients[clientId];
+
+        // Baseline: the last view the client acknowledged; without one every entity is sent in full.
+        static const std::vector<NetEntityState> kNone;
+        const View *baseline = c.hasAck ? findView(c, c.ackedTick) : nullptr;
+        const std::vector<NetEntityState> &known = baseline ? baseline->entities : kNone;
+        if (c.wait.size() < m_world.size())
+            c.wait.resize(m_world.size(), 0);
+
+        const float radius2 = c.interestRadius * c.interestRadius;
+        const uint32_t end = std::max<uint32_t>(static_cast<uint32_t>(m_world.size()), known.empty() ? 0u : known.back().index + 1);
+
+        // Everything the client's view differs in, with a send priority.
+        m_candidates.clear();
+        uint64_t totalBytes = 0;
+        size_t k = 0;
+        for (uint32_t index = 0; index < end; ++index)
+        {
+            const NetEntityState *base = (k < known.size() && known[k].index == index) ? &known[k++] : nullptr;
+            const WorldEntry *w = (index < m_world.size() && m_world[index].alive) ? &m_world[index] : nullptr;
+
+            float dist2 = 0.0f;
+            if (w)
+            {
+                const float dx = static_cast<float>(w->state.position[0]) * m_config.positionStep - c.viewX;
+                const float dz = static_cast<float>(w->state.position[2]) * m_config.positionStep - c.viewZ;
+                dist2 = dx * dx + dz * dz;
+                if (c.interestRadius > 0.0f && dist2 > radius2)
+                    w = nullptr;
+            }
+
+            Candidate cand;
+            cand.index = index;
+            cand.base = base;
+            if (!w)
+            {
+                if (!base)
+                    continue;
+                // Removals are tiny and always go first.
+                cand.kind = Removed;
+                cand.priority = -1.0f;
+                cand.bytes = 1;
+            }
+            else
+            {
+                if (base && base->generation == w->state.generation)
+                {
+                    cand.kind = (samePosition(*base, w->state) ? 0 : PositionDelta) |
+                                (sameVelocity(*base, w->state) ? 0 : VelocityDelta);
+                    if (cand.kind == 0)
+                    {
+                        c.wait[index] = 0;
+                        continue;
+                    }
+                }
+                else
+                {
+                    cand.kind = Full;
+                }
+                const float waited = 1.0f + static_cast<float>(c.wait[index]);
+                cand.priority = dist2 / (waited * waited);
+                cand.bytes = entryBytes(cand.kind, base, w->state);
+            }
+            cand.bytes += varintSize(index); // bound for the index delta
+            totalBytes += cand.bytes;
+            m_candidates.push_back(cand);
+        }
+
+        // Over budget: keep the highest-priority entries, defer the rest to later ticks.
+        if (totalBytes > m_config.maxPacketBytes)
+        {
+            std::sort(m_candidates.begin(), m_candidates.end(), [](const Candidate &a, const Candidate &b)
+                      { return a.priority < b.priority || (a.priority == b.priority && a.index < b.index); });
+            uint64_t used = 0;
+            size_t kept = 0;
+            for (Candidate &cand : m_candidates)
+            {
+                if (cand.kind == Removed || used + cand.bytes <= m_config.maxPacketBytes)
+                {
+                    used += cand.bytes;
+                    m_candidates[kept++] = cand;
+                }
+                else if (c.wait[cand.index] < UINT16_MAX)
+                {
+                    ++c.wait[cand.index];
+                }
+            }
+            m_candidates.resize(kept);
+            std::sort(m_candidates.begin(), m_candidates.end(), [](const Candidate &a, const Candidate &b)
+                      { return a.index < b.index; });
+        }
+
+        out.push_back(kPacketVersion);
+        putVarint(out, m_tick);
+        putVarint(out, baseline ? baseline->tick : 0u);
+        putVarint(out, m_candidates.size());
+
+        // The client's new view: the baseline with the sent entries applied (deferred ones keep their old state).
+        View view;
+        view.tick = m_tick;
+        view.entities.reserve(known.size() + m_candidates.size());
+        size_t b = 0;
+        uint32_t previous = 0;
+        for (const Candidate &cand : m_candidates)
+        {
+            while (b < known.size() && known[b].index < cand.index)
+                view.entities.push_back(known[b++]);
+            if (b < known.size() && known[b].index == cand.index)
+                ++b;
+
+            putVarint(out, cand.index - previous);
+            previous = cand.index;
+            out.push_back(cand.kind);
+            if (cand.kind == Removed)
+                continue;
+
+            const NetEntityState &now = m_world[cand.index].state;
+            c.wait[cand.index] = 0;
+            view.entities.push_back(now);
+            if (cand.kind == Full)
+            {
+                putVarint(out, now.generation);
+                for (int a = 0; a < 3; ++a)
+                    putSigned(out, now.position[a]);
+                for (int a = 0; a < 3; ++a)
+                    putSigned(out, now.velocity[a]);
+                continue;
+            }
+            if (cand.kind & PositionDelta)
+            {
+                for (int a = 0; a < 3; ++a)
+                    putSigned(out, static_cast<int64_t>(now.position[a]) - cand.base->position[a]);
+            }
+            if (cand.kind & VelocityDelta)
+            {
+                for (int a = 0; a < 3; ++a)
+                    putSigned(out, static_cast<int64_t>(now.velocity[a]) - cand.base->velocity[a]);
+            }
+        }
+        while (b < known.size())
+            view.entities.push_back(known[b++]);
+
+        // A second packet in the same tick replaces the first one's view.
+        if (!c.history.empty() && c.history.back().tick == m_tick)
+            c.history.pop_back();
+        c.history.push_back(std::move(view));
+        // Dropping the acked view makes the next packet a full one.
+        while (c.history.size() > std::max<uint32_t>(1u, m_config.historyTicks))
+            c.history.pop_front();
+        return true;
+    }
+
+    // ------------------------------------------------------------
+    // ReplicationClient
+    // ------------------------------------------------------------
+
+    bool ReplicationClient::readPacket(const uint8_t *data, size_t size, std::string &outError)
+    {
+        PacketReader r(data, size);
+
+        uint8_t version = 0;
+        uint32_t tick = 0, baselineTick = 0, count = 0;
+        if (!r.byte(version) || version != kPacketVersion)
+            return fail(outError, "unknown packet version");
+        if (!r.u32(tick) || !r.u32(baselineTick) || !r.u32(count))
+            return fail(outError, "truncated packet header");
+        // Every entry takes at least two bytes (index delta, kind); bounds the reserve below.
+        if (count > r.remaining() / 2)
+            return fail(outError, "entry count exceeds the packet");
+        if (!m_history.empty() && tick <= m_history.back().tick)
+            return true;
+
+        static const std::vector<NetEntityState> kNone;
+        const std::vector<NetEntityState> *known = &kNone;
+        if (baselineTick != 0)
+        {
+            known = nullptr;
+            for (const View &v : m_history)
+            {
+                if (v.tick == baselineTick)
+                    known = &v.entities;
+            }
+            if (!known)
+                return fail(outError, "baseline tick " + std::to_string(baselineTick) + " is not held");
+        }
+
+        View view;
+        view.tick = tick;
+        view.entities.reserve(known->size() + count);
+        size_t b = 0;
+        uint32_t index = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t delta = 0;
+            uint8_t kind = 0;
+            if (!r.u32(delta) || !r.byte(kind))
+                return fail(outError, "truncated entry");
+            if ((i > 0 && delta == 0) || delta > UINT32_MAX - index)
+                return fail(outError, "entries out of order");
+            index += delta;
+
+            while (b < known->size() && (*known)[b].index < index)
+                view.entities.push_back((*known)[b++]);
+            const NetEntityState *base = (b < known->size() && (*known)[b].index == index) ? &(*known)[b++] : nullptr;
+
+            if (kind == Removed)
+                continue;
+
+            NetEntityState s;
+            s.index = index;
+            int64_t v[6] = {};
+            if (kind == Full)
+            {
+                if (!r.u32(s.generation))
+                    return fail(outError, "truncated entry");
+                for (int64_t &c : v)
+                {
+                    if (!r.svarint(c))
+                        return fail(outError, "truncated entry");
+                }
+                for (int a = 0; a < 3; ++a)
+                {
+                    s.position[a] = static_cast<int32_t>(v[a]);
+                    s.velocity[a] = static_cast<int16_t>(v[3 + a]);
+                }
+            }
+            else
+            {
+                if (!base || (kind & ~(PositionDelta | VelocityDelta)) != 0 || kind == 0)
+                    return fail(outError, "delta for entity " + std::to_string(index) + " without a baseline state");
+                s = *base;
+                for (int a = 0; a < 3 && (kind & PositionDelta); ++a)
+                {
+                    if (!r.svarint(v[a]))
+                        return fail(outError, "truncated entry");
+                    s.position[a] = static_cast<int32_t>(base->position[a] + v[a]);
+                }
+                for (int a = 0; a < 3 && (kind & VelocityDelta); ++a)
+                {
+                    if (!r.svarint(v[3 + a]))
+                        return fail(outError, "truncated entry");
+                    s.velocity[a] = static_cast<int16_t>(base->velocity[a] + v[3 + a]);
+                }
+            }
+            view.entities.push_back(s);
+        }
+        while (b < known->size())
+            view.entities.push_back((*known)[b++]);
+        if (!r.atEnd())
+            return fail(outError, "trailing bytes");
+
+        m_history.push_back(std::move(view));
+        while (m_history.size() > std::max<uint32_t>(1u, m_config.historyTicks))
+            m_history.pop_front();
+        return true;
+    }
+}
@@ -1,6 +1,7 @@
 #include "assets/MeshFormats.h"
 #include <cstdio>
 #include <cstring>
+#include <sstream>
 
 namespace Engine
 {
@@ -92,4 +93,96 @@ namespace Engine
         return true;
     }
 
+    static bool rangeInside(uint64_t offset, uint64_t size, uint64_t fileSize)
+    {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+
+    bool LoadSMeshFile(const std::string &path, SMeshFileView &out, std::string &outError)
+    {
+        out = SMeshFileView{};
+        if (!out.file.open(path, outError))
+            return false;
+
+        const uint8_t *base = out.file.data();
+        const uint64_t fileSize = out.file.size();
+        MeshDataView &m = out.mesh;
+
+        if (fileSize >= sizeof(SMeshHeaderV1) && std::memcmp(base, kSMeshMagic, sizeof(kSMeshMagic)) == 0)
+        {
+            const SMeshHeaderV1 *hdr = reinterpret_cast<const SMeshHeaderV1 *>(base);
+            if (hdr->versionMajor != kSMeshVersionMajor || hdr->headerSize < sizeof(SMeshHeaderV1))
+            {
+                std::ostringstream oss;
+                oss << "Unsupported .smesh version " << hdr->versionMajor << "." << hdr->versionMinor;
+                outError = oss.str();
+                out.file.close();
+                return false;
+            }
+
+            const bool compact = (hdr->flags & SMESH_VERTEX_COMPACT) != 0;
+            const uint32_t expectedStride = compact ? sizeof(SMeshVertexCompact) : 32u;
+            const uint64_t indexSize = hdr->indexFormat == 0 ? sizeof(uint16_t) : sizeof(uint32_t);
+            if (hdr->vertexStride != expectedStride || hdr->indexFormat > 1u ||
+                hdr->vertexDataSize != uint64_t(hdr->vertexCount) * hdr->vertexStride ||
+                hdr->indexDataSize != uint64_t(hdr->indexCount) * indexSize ||
+                hdr->vertexDataOffset % kSMeshSectionAlignment != 0 ||
+                hdr->indexDataOffset % kSMeshSectionAlignment != 0 ||
+                !rangeInside(hdr->vertexDataOffset, hdr->vertexDataSize, fileSize) ||
+                !rangeInside(hdr->indexDataOffset, hdr->indexDataSize, fileSize))
+            {
+                outError = "Corrupt .smesh v1 header (stride, index format or section range)";
+                out.file.close();
+                return false;
+            }
+
+            out.header = hdr;
+            m.vertexBytes = base + hdr->vertexDataOffset;
+            m.vertexByteSize = hdr->vertexDataSize;
+            m.indexBytes = base + hdr->indexDataOffset;
+            m.indexByteSize = hdr->indexDataSize;
+            m.vertexCount = hdr->vertexCount;
+            m.indexCount = hdr->indexCount;
+            m.vertexStride = hdr->vertexStride;
+            m.indexFormat = hdr->indexFormat;
+            std::memcpy(m.aabbMin, hdr->aabbMin, sizeof(m.aabbMin));
+            std::memcpy(m.aabbMax, hdr->aabbMax, sizeof(m.aabbMax));
+            return true;
+        }
+
+        // v0: no magic, same checks as LoadSMeshV0FromFile, but read in place
+        SMeshHeaderV0 hdr{};
+        if (fileSize < sizeof(hdr))
+        {
+            outError = "File too small for a .smesh header";
+            out.file.close();
+            return false;
+        }
+        std::memcpy(&hdr, base, sizeof(hdr));
+
+        const uint64_t vertexBytes = uint64_t(hdr.vertexCount) * hdr.vertexStride;
+        const uint64_t indexBytes = uint64_t(hdr.indexCount) * (hdr.indexFormat == 0 ? sizeof(uint16_t) : sizeof(uint32_t));
+        const uint64_t indexAlign = hdr.indexFormat == 0 ? alignof(uint16_t) : alignof(uint32_t);
+        if (hdr.vertexStride != 32 || hdr.indexFormat > 1u || hdr.indexDataOffset % indexAlign != 0 ||
+            !rangeInside(hdr.vertexDataOffset, vertexBytes, fileSize) ||
+            !rangeInside(hdr.indexDataOffset, indexBytes, fileSize))
+        {
+            outError = "Not a .smesh file (bad v0 header)";
+            out.file.close();
+            return false;
+        }
+
+        m.vertexBytes = base + hdr.vertexDataOffset;
+        m.vertexByteSize = vertexBytes;
+        m.indexBytes = base + hdr.indexDataOffset;
+        m.indexByteSize = indexBytes;
+        m.vertexCount = hdr.vertexCount;
+        m.indexCount = hdr.indexCount;
+        m.vertexStride = hdr.vertexStride;
+        m.indexFormat = hdr.indexFormat;
+        std::memcpy(m.aabbMin, hdr.aabbMin, sizeof(m.aabbMin));
+        std::memcpy(m.aabbMax, hdr.aabbMax, sizeof(m.aabbMax));
+        return true;
+    }
+
 } // namespace Engine
\ No newline at end of file
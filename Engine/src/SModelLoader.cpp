@@ -1,7 +1,7 @@
 #include "assets/SModelLoader.h"
 
-#include <fstream>
 #include <sstream>
+#include <cstddef> // offsetof
 #include <cstring> // std::memcpy
 #include <limits>
 
@@ -88,33 +88,14 @@ namespace Engine
             outView = SModelFileView{}; // reset
 
             // --------------------------
-            // Read file bytes
+            // Map file (no read, no copy)
             // --------------------------
-            std::ifstream file(path, std::ios::binary | std::ios::ate);
-            if (!file.is_open())
-            {
-                outError = "Failed to open file: " + path;
-                return false;
-            }
-
-            const std::streamsize fileSize = file.tellg();
-            if (fileSize <= 0)
-            {
-                outError = "File is empty: " + path;
-                return false;
-            }
-
-            file.seekg(0, std::ios::beg);
-
-            outView.fileBytes.resize(static_cast<size_t>(fileSize));
-            if (!file.read(reinterpret_cast<char *>(outView.fileBytes.data()), fileSize))
-            {
-                outError = "Failed to read file bytes: " + path;
+            if (!outView.file.open(path, outError))
                 return false;
-            }
 
-            const uint64_t uFileSize = static_cast<uint64_t>(outView.fileBytes.size());
-            if (uFileSize < sizeof(SModelHeader))
+            const uint64_t uFileSize = outView.file.size();
+            // Headers before v4.2 end at the meshlet fields
+            if (uFileSize < offsetof(SModelHeader, meshletsOffset))
             {
                 outError = "File too small to contain SModelHeader.";
                 return false;
@@ -123,7 +104,7 @@ namespace Engine
             // --------------------------
             // Interpret header
             // --------------------------
-            outView.header = reinterpret_cast<const SModelHeader *>(outView.fileBytes.data());
+            outView.header = reinterpret_cast<const SModelHeader *>(outView.file.data());
 
             // Basic compatibility
             if (!isHeaderCompatible(*outView.header))
@@ -141,6 +122,16 @@ namespace Engine
                 return false;
             }
 
+            const uint64_t headerSize = (outView.header->versionMinor >= 4)   ? sizeof(SModelHeader)
+                                        : (outView.header->versionMinor >= 3) ? offsetof(SModelHeader, animPackedOffset)
+                                        : (outView.header->versionMinor >= 2) ? offsetof(SModelHeader, primitiveLodsOffset)
+                                                                              : offsetof(SModelHeader, meshletsOffset);
+            if (uFileSize < headerSize)
+            {
+                outError = "File too small to contain SModelHeader.";
+                return false;
+            }
+
             // --------------------------
             // Validate section bounds
             // --------------------------
@@ -251,7 +242,7 @@ namespace Engine
             // --------------------------
             // Build pointers/views
             // --------------------------
-            const uint8_t *base = outView.fileBytes.data();
+            const uint8_t *base = outView.file.data();
 
             outView.meshes = reinterpret_cast<const SModelMeshRecord *>(base + outView.header->meshesOffset);
             outView.primitives = reinterpret_cast<const SModelPrimitiveRecord *>(base + outView.header->primitivesOffset);
@@ -289,6 +280,9 @@ namespace Engine
             if (!outError.empty())
                 return false;
             outView.animValues = ptrAt<float>(base, uFileSize, outView.header->animValuesOffset, outView.header->animValuesCount, outError);
+            if (!outError.empty())
+                return false;
+            outView.animPacked = ptrAt<uint8_t>(base, uFileSize, outView.header->versionMinor >= 4 ? outView.header->animPackedOffset : 0, outView.animPackedSize(), outError);
             if (!outError.empty())
                 return false;
 
@@ -306,6 +300,63 @@ namespace Engine
                     return false;
             }
 
+            // V4.2: meshlet tables (optional sections)
+            const uint32_t meshletCount = outView.meshletCount();
+            const uint32_t meshletVerticesCount = outView.meshletVerticesCount();
+            const uint32_t meshletTrianglesCount = outView.meshletTrianglesCount();
+            if (meshletCount > 0)
+            {
+                outView.meshlets = ptrAt<SModelMeshletRecord>(base, uFileSize, outView.header->meshletsOffset, meshletCount, outError);
+                if (!outError.empty())
+                    return false;
+                outView.meshletVertices = ptrAt<uint32_t>(base, uFileSize, outView.header->meshletVerticesOffset, meshletVerticesCount, outError);
+                if (!outError.empty())
+                    return false;
+                outView.meshletTriangles = ptrAt<uint8_t>(base, uFileSize, outView.header->meshletTrianglesOffset, meshletTrianglesCount, outError);
+                if (!outError.empty())
+                    return false;
+
+                for (uint32_t i = 0; i < meshletCount; i++)
+                {
+                    const SModelMeshletRecord &ml = outView.meshlets[i];
+                    if (ml.meshIndex >= outView.header->meshCount ||
+                        ml.vertexCount > kMeshletMaxVertices || ml.triangleCount > kMeshletMaxTriangles ||
+                        uint64_t(ml.vertexOffset) + ml.vertexCount > meshletVerticesCount ||
+                        uint64_t(ml.triangleOffset) + uint64_t(ml.triangleCount) * 3 > meshletTrianglesCount)
+                    {
+                        outError = "Meshlet record out of range (meshletIndex=" + std::to_string(i) + ")";
+                        return false;
+                    }
+                }
+            }
+
+            // V4.3: primitive LODs (optional section)
+            const uint32_t primitiveLodCount = outView.primitiveLodCount();
+            if (primitiveLodCount > 0)
+            {
+                outView.primitiveLods = ptrAt<SModelPrimitiveLodRecord>(base, uFileSize, outView.header->primitiveLodsOffset, primitiveLodCount, outError);
+                if (!outError.empty())
+                    return false;
+
+                for (uint32_t i = 0; i < primitiveLodCount; i++)
+                {
+                    const SModelPrimitiveLodRecord &lod = outView.primitiveLods[i];
+                    if (lod.primitiveIndex >= outView.header->primitiveCount)
+                    {
+                        outError = "Primitive LOD references an invalid primitive (lodIndex=" + std::to_string(i) + ")";
+                        return false;
+                    }
+
+                    const SModelPrimitiveRecord &prim = outView.primitives[lod.primitiveIndex];
+                    if (prim.meshIndex >= outView.header->meshCount ||
+                        uint64_t(lod.firstIndex) + lod.indexCount > outView.meshes[prim.meshIndex].indexCount)
+                    {
+                        outError = "Primitive LOD index range out of bounds (lodIndex=" + std::to_string(i) + ")";
+                        return false;
+                    }
+                }
+            }
+
             // --------------------------
             // Validate record internal offsets (blob offsets)
             // --------------------------
@@ -345,6 +396,17 @@ namespace Engine
                     outError = "Mesh vertexDataSize mismatch (meshIndex=" + std::to_string(i) + ")";
                     return false;
                 }
+
+                // The renderer has one vertex input layout per encoding
+                const bool quantized = (m.layoutFlags & VTX_POS_UNORM16) != 0;
+                const bool fullLayout = !quantized && m.vertexStride == 72;
+                const bool quantizedLayout = quantized && (m.layoutFlags & kVertexLayoutQuantized) == kVertexLayoutQuantized &&
+                                             m.vertexStride == sizeof(SModelVertexQuantized);
+                if (!fullLayout && !quantizedLayout)
+                {
+                    outError = "Mesh has an unsupported vertex layout (meshIndex=" + std::to_string(i) + ")";
+                    return false;
+                }
             }
 
             // Validate texture image slices
@@ -528,8 +590,10 @@ namespace Engine
             };
             auto isValidValueType = [](uint8_t vt)
             {
-                return vt == uint8_t(SModelAnimValueType::Vec3) || vt == uint8_t(SModelAnimValueType::Quat);
+                return vt == uint8_t(SModelAnimValueType::Vec3) || vt == uint8_t(SModelAnimValueType::Quat) ||
+                       vt == uint8_t(SModelAnimValueType::Vec3Quantized) || vt == uint8_t(SModelAnimValueType::QuatSmallest3);
             };
+            const uint32_t packedSize = outView.animPackedSize();
 
             // Validate clips
             for (uint32_t ci = 0; ci < clipCount; ++ci)
@@ -590,12 +654,6 @@ namespace Engine
                     return false;
                 }
 
-                if (s.firstValue + s.valueCount > valuesCount)
-                {
-                    outError = "Animation sampler value range out of bounds";
-                    return false;
-                }
-
                 if (!isValidInterpolation(s.interpolation))
                 {
                     outError = "Animation sampler interpolation is invalid";
@@ -608,7 +666,16 @@ namespace Engine
                     return false;
                 }
 
-                const uint64_t expected = (s.valueType == uint8_t(SModelAnimValueType::Vec3))
+                const bool packed = s.valueType == uint8_t(SModelAnimValueType::Vec3Quantized) ||
+                                    s.valueType == uint8_t(SModelAnimValueType::QuatSmallest3);
+                if (uint64_t(s.firstValue) + s.valueCount > (packed ? packedSize : valuesCount))
+                {
+                    outError = "Animation sampler value range out of bounds";
+                    return false;
+                }
+
+                const uint64_t expected = packed ? uint64_t(animPackedBytes(s.valueType, s.timeCount))
+                                          : (s.valueType == uint8_t(SModelAnimValueType::Vec3))
                                               ? uint64_t(s.timeCount) * 3ull
                                               : uint64_t(s.timeCount) * 4ull;
 
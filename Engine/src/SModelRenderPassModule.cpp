@@ -1,17 +1,15 @@
 #include "Engine/SModelRenderPassModule.h"
 #include "Engine/VulkanContext.h"
 #include "Engine/SwapChain.h"
-#include "Engine/PerformanceMonitor.h"
 #include "assets/ModelAsset.h"
 #include "assets/MeshAsset.h"
 #include "assets/MaterialAsset.h"
-#include "utils/ImageUtils.h"
+#include "utils/BufferUtils.h"
 
 #include <algorithm>
-#include <array>
 #include <cstring>
 #include <stdexcept>
-#include <unordered_set>
+#include <utility>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -32,227 +30,113 @@ namespace Engine
         return glm::mat4(1.0f);
     }
 
-    SModelRenderPassModule::~SModelRenderPassModule()
+    // Cooked bounds are bind-pose, so the radius is padded for animated nodes/joints reaching outside them.
+    static glm::vec4 boundingSphere(const ModelAsset &model, const glm::mat4 &modelMatrix)
     {
-        // resources freed in onDestroy
+        const glm::vec3 bmin(model.boundsMin[0], model.boundsMin[1], model.boundsMin[2]);
+        const glm::vec3 bmax(model.boundsMax[0], model.boundsMax[1], model.boundsMax[2]);
+        const glm::vec3 center = glm::vec3(modelMatrix * glm::vec4((bmin + bmax) * 0.5f, 1.0f));
+        const float radius = glm::length(bmax - bmin) * 0.5f * maxAxisScale(modelMatrix) * 1.5f;
+        return glm::vec4(center, radius);
     }
 
-    bool SModelRenderPassModule::createMaterialResources(VulkanContext &ctx)
+    // Index range of a primitive at an LOD level; primitives with fewer levels use their coarsest.
+    static void lodRange(const ModelPrimitive &prim, uint32_t level, uint32_t &firstIndex, uint32_t &indexCount)
     {
-        destroyMaterialResources();
-
-        // Descriptor set layout: baseColor combined sampler
-        VkDescriptorSetLayoutBinding baseColorBinding{};
-        baseColorBinding.binding = 0;
-        baseColorBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        baseColorBinding.descriptorCount = 1;
-        baseColorBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-        VkDescriptorSetLayoutCreateInfo dsl{};
-        dsl.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        dsl.bindingCount = 1;
-        dsl.pBindings = &baseColorBinding;
-
-        if (vkCreateDescriptorSetLayout(ctx.GetDevice(), &dsl, nullptr, &m_materialSetLayout) != VK_SUCCESS)
-        {
-            return false;
-        }
-
-        // Fallback 1x1 white texture (sRGB)
-        {
-            VkCommandPoolCreateInfo poolInfo{};
-            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-            poolInfo.queueFamilyIndex = ctx.GetGraphicsQueueFamilyIndex();
-            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
-
-            VkCommandPool uploadPool = VK_NULL_HANDLE;
-            if (vkCreateCommandPool(ctx.GetDevice(), &poolInfo, nullptr, &uploadPool) != VK_SUCCESS)
-                return false;
-
-            UploadContext upload{};
-            if (!BeginUploadContext(upload, ctx.GetDevice(), ctx.GetPhysicalDevice(), uploadPool, ctx.GetGraphicsQueue()))
-            {
-                vkDestroyCommandPool(ctx.GetDevice(), uploadPool, nullptr);
-                return false;
-            }
-
-            const uint8_t white[4] = {255, 255, 255, 255};
-            const bool ok = m_fallbackWhiteTexture.uploadRGBA8_Deferred(
-                upload,
-                white,
-                1,
-                1,
-                true,
-                VK_SAMPLER_ADDRESS_MODE_REPEAT,
-                VK_SAMPLER_ADDRESS_MODE_REPEAT,
-                VK_FILTER_LINEAR,
-                VK_FILTER_LINEAR,
-                VK_SAMPLER_MIPMAP_MODE_NEAREST,
-                1.0f);
-
-            const bool submitted = ok && EndSubmitAndWait(upload);
-            vkDestroyCommandPool(ctx.GetDevice(), uploadPool, nullptr);
-
-            if (!submitted)
-                return false;
-        }
-
-        // Descriptor pool (size tuned to current model if available)
-        uint32_t uniqueMatCount = 32;
-        if (m_assets && m_model.isValid())
-        {
-            if (ModelAsset *model = m_assets->getModel(m_model))
-            {
-                std::unordered_set<uint64_t> unique;
-                unique.reserve(model->primitives.size());
-                for (const auto &p : model->primitives)
-                {
-                    if (p.material.isValid())
-                        unique.insert(p.material.id);
-                }
-                if (!unique.empty())
-                    uniqueMatCount = static_cast<uint32_t>(unique.size());
-            }
-        }
-
-        VkDescriptorPoolSize poolSize{};
-        poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        poolSize.descriptorCount = uniqueMatCount;
-
-        VkDescriptorPoolCreateInfo poolInfo{};
-        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolInfo.maxSets = uniqueMatCount;
-        poolInfo.poolSizeCount = 1;
-        poolInfo.pPoolSizes = &poolSize;
-
-        if (vkCreateDescriptorPool(ctx.GetDevice(), &poolInfo, nullptr, &m_materialPool) != VK_SUCCESS)
-            return false;
-
-        m_materialSetCache.clear();
-        return true;
+        level = std::min(level, prim.lodCount);
+        firstIndex = (level == 0) ? prim.firstIndex : prim.lods[level - 1].firstIndex;
+        indexCount = (level == 0) ? prim.indexCount : prim.lods[level - 1].indexCount;
     }
 
-    void SModelRenderPassModule::destroyMaterialResources()
+    SModelRenderPassModule::~SModelRenderPassModule()
     {
-        m_materialSetCache.clear();
-
-        if (m_materialPool != VK_NULL_HANDLE)
-        {
-            vkDestroyDescriptorPool(m_device, m_materialPool, nullptr);
-            m_materialPool = VK_NULL_HANDLE;
-        }
-
-        if (m_materialSetLayout != VK_NULL_HANDLE)
-        {
-            vkDestroyDescriptorSetLayout(m_device, m_materialSetLayout, nullptr);
-            m_materialSetLayout = VK_NULL_HANDLE;
-        }
+        // resources freed in onDestroy
+    }
 
-        if (m_device != VK_NULL_HANDLE && m_fallbackWhiteTexture.isValid())
+    void SModelRenderPassModule::setModelMatrix(const float *m16)
+    {
+        if (!m16)
         {
-            m_fallbackWhiteTexture.destroy(m_device);
+            setIdentity(m_pc.model);
+            return;
         }
+        std::memcpy(m_pc.model, m16, sizeof(float) * 16);
     }
 
-    VkDescriptorSet SModelRenderPassModule::getOrCreateMaterialSet(MaterialHandle h, const MaterialAsset *mat)
+    void SModelRenderPassModule::setInstances(const glm::mat4 *instanceWorlds, uint32_t count)
     {
-        if (!h.isValid() || !mat)
-            return VK_NULL_HANDLE;
-        if (m_materialPool == VK_NULL_HANDLE || m_materialSetLayout == VK_NULL_HANDLE)
-            return VK_NULL_HANDLE;
-
-        auto it = m_materialSetCache.find(h.id);
-        if (it != m_materialSetCache.end())
-            return it->second;
-
-        VkDescriptorSetAllocateInfo alloc{};
-        alloc.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        alloc.descriptorPool = m_materialPool;
-        alloc.descriptorSetCount = 1;
-        alloc.pSetLayouts = &m_materialSetLayout;
-
-        VkDescriptorSet set = VK_NULL_HANDLE;
-        if (vkAllocateDescriptorSets(m_device, &alloc, &set) != VK_SUCCESS)
-            return VK_NULL_HANDLE;
+        m_instanceWorlds.clear();
+        m_compactInstances.clear();
+        if (!instanceWorlds || count == 0)
+            return;
 
-        VkImageView view = m_fallbackWhiteTexture.getView();
-        VkSampler sampler = m_fallbackWhiteTexture.getSampler();
+        m_instanceWorlds.assign(instanceWorlds, instanceWorlds + count);
+    }
 
-        if (mat->baseColorTexture.isValid() && m_assets)
-        {
-            if (TextureAsset *tex = m_assets->getTexture(mat->baseColorTexture))
-            {
-                if (tex->getView() != VK_NULL_HANDLE && tex->getSampler() != VK_NULL_HANDLE)
-                {
-                    view = tex->getView();
-                    sampler = tex->getSampler();
-                }
-            }
-        }
+    void SModelRenderPassModule::setInstances(const CompactInstance *instances, uint32_t count)
+    {
+        m_instanceWorlds.clear();
+        m_compactInstances.clear();
+        if (!instances || count == 0)
+            return;
 
-        VkDescriptorImageInfo di{};
-        di.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        di.imageView = view;
-        di.sampler = sampler;
+        m_compactInstances.assign(instances, instances + count);
+    }
 
-        VkWriteDescriptorSet write{};
-        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        write.dstSet = set;
-        write.dstBinding = 0;
-        write.dstArrayElement = 0;
-        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        write.descriptorCount = 1;
-        write.pImageInfo = &di;
-        vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+    VkDeviceSize SModelRenderPassModule::instanceStride() const
+    {
+        return (m_instanceFormat == InstanceFormat::Compact) ? sizeof(CompactInstance) : sizeof(glm::mat4);
+    }
 
-        m_materialSetCache.emplace(h.id, set);
-        return set;
+    uint32_t SModelRenderPassModule::recordInstanceCount() const
+    {
+        return static_cast<uint32_t>(m_record.instanceWorlds.empty() ? m_record.compactInstances.size()
+                                                                     : m_record.instanceWorlds.size());
     }
 
-    void SModelRenderPassModule::setModelMatrix(const float *m16)
+    void SModelRenderPassModule::setPaletteSlots(const uint32_t *slots, uint32_t count)
     {
-        if (!m16)
-        {
-            setIdentity(m_pc.model);
+        m_paletteSlots.clear();
+        if (!slots || count == 0)
             return;
-        }
-        std::memcpy(m_pc.model, m16, sizeof(float) * 16);
+
+        m_paletteSlots.assign(slots, slots + count);
     }
 
-    void SModelRenderPassModule::setInstances(const glm::mat4 *instanceWorlds, uint32_t count)
+    void SModelRenderPassModule::setInstanceAnimation(const GpuInstanceAnimation *states, uint32_t count)
     {
-        m_instanceWorlds.clear();
-        if (!instanceWorlds || count == 0)
+        m_instanceAnimation.clear();
+        if (!states || count == 0)
             return;
 
-        m_instanceWorlds.assign(instanceWorlds, instanceWorlds + count);
+        m_instanceAnimation.assign(states, states + count);
     }
 
-    void SModelRenderPassModule::setNodePalette(const glm::mat4 *nodeGlobals, uint32_t instanceCount, uint32_t nodeCount)
+    void SModelRenderPassModule::setNodePalette(const glm::mat4 *nodeGlobals, uint32_t paletteCount, uint32_t nodeCount)
     {
         m_nodePalette.clear();
-        m_paletteInstanceCount = 0;
+        m_paletteCount = 0;
         m_paletteNodeCount = 0;
 
-        if (!nodeGlobals || instanceCount == 0 || nodeCount == 0)
+        if (!nodeGlobals || paletteCount == 0 || nodeCount == 0)
             return;
 
-        m_paletteInstanceCount = instanceCount;
+        m_paletteCount = paletteCount;
         m_paletteNodeCount = nodeCount;
-        const size_t total = static_cast<size_t>(instanceCount) * static_cast<size_t>(nodeCount);
+        const size_t total = static_cast<size_t>(paletteCount) * static_cast<size_t>(nodeCount);
         m_nodePalette.assign(nodeGlobals, nodeGlobals + total);
     }
 
-    void SModelRenderPassModule::setJointPalette(const glm::mat4 *jointMatrices, uint32_t instanceCount, uint32_t jointCount)
+    void SModelRenderPassModule::setJointPalette(const glm::mat4 *jointMatrices, uint32_t paletteCount, uint32_t jointCount)
     {
         m_jointPalette.clear();
         m_jointPaletteJointCount = 0;
 
-        if (!jointMatrices || instanceCount == 0 || jointCount == 0)
+        if (!jointMatrices || paletteCount == 0 || jointCount == 0)
             return;
 
         m_jointPaletteJointCount = jointCount;
-        const size_t total = static_cast<size_t>(instanceCount) * static_cast<size_t>(jointCount);
+        const size_t total = static_cast<size_t>(paletteCount) * static_cast<size_t>(jointCount);
         m_jointPalette.assign(jointMatrices, jointMatrices + total);
     }
 
@@ -367,7 +251,17 @@ namespace Engine
             setIdentity(m_pc.model);
         }
 
+        // Instance/palette buffers: plain host-visible, ReBAR, or host staging + device-local mirrors.
+        m_uploadPath = selectUploadPath();
+        m_hostBufferProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        if (m_uploadPath == UploadPath::ReBar)
+            m_hostBufferProps |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
         const size_t frameCount = fbs.size();
+        m_shared = SModelRenderer::acquire(ctx, pass, static_cast<uint32_t>(frameCount > 0 ? frameCount : 1),
+                                           m_instanceFormat == InstanceFormat::Compact);
+        m_shared->attach(this);
+
         if (!createCameraResources(ctx, frameCount > 0 ? frameCount : 1))
         {
             throw std::runtime_error("SModelRenderPassModule: failed to create camera resources");
@@ -378,37 +272,27 @@ namespace Engine
             throw std::runtime_error("SModelRenderPassModule: failed to create instance resources");
         }
 
-        if (!createMaterialResources(ctx))
-        {
-            throw std::runtime_error("SModelRenderPassModule: failed to create material resources");
-        }
-
-        createPipelines(ctx, pass);
-    }
-
-    VkPipelineColorBlendStateCreateInfo SModelRenderPassModule::makeBlendState(bool enableBlend, VkPipelineColorBlendAttachmentState &outAttachment) const
-    {
-        std::memset(&outAttachment, 0, sizeof(outAttachment));
-        outAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
-                                       VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-        outAttachment.blendEnable = enableBlend ? VK_TRUE : VK_FALSE;
-        if (enableBlend)
-        {
-            // Standard alpha blending
-            outAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-            outAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-            outAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-            outAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-            outAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-            outAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-        }
-
-        VkPipelineColorBlendStateCreateInfo cb{};
-        cb.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-        cb.logicOpEnable = VK_FALSE;
-        cb.attachmentCount = 1;
-        cb.pAttachments = &outAttachment;
-        return cb;
+        // Optional: without the cull shaders record() keeps drawing every instance.
+        m_culler.create(ctx, frameCount > 0 ? frameCount : 1, m_shared->frameSetLayout());
+
+        // Optional: without the pose shader the CPU palettes are uploaded.
+        m_poseEvaluator.create(ctx, frameCount > 0 ? frameCount : 1, m_shared->frameSetLayout());
+
+        publishMemoryUsage();
+        m_memoryReport = MemoryStats::Registration([this](std::vector<MemoryStats::Counter> &out)
+                                                   {
+            MemoryStats::Counter c;
+            c.subsystem = "Renderer";
+            c.count = 1;
+            c.name = "SModel instances";
+            c.gpuBytes = m_instanceBytes.load(std::memory_order_relaxed);
+            out.push_back(c);
+            c.name = "SModel palettes";
+            c.gpuBytes = m_paletteBytes.load(std::memory_order_relaxed);
+            out.push_back(c);
+            c.name = "SModel joint palettes";
+            c.gpuBytes = m_jointPaletteBytes.load(std::memory_order_relaxed);
+            out.push_back(c); });
     }
 
     bool SModelRenderPassModule::createCameraResources(VulkanContext &ctx, size_t frameCount)
@@ -418,35 +302,6 @@ namespace Engine
         if (frameCount == 0)
             frameCount = 1;
 
-        VkDescriptorSetLayoutBinding camBinding{};
-        camBinding.binding = 0;
-        camBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        camBinding.descriptorCount = 1;
-        camBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-        VkDescriptorSetLayoutBinding paletteBinding{};
-        paletteBinding.binding = 1;
-        paletteBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        paletteBinding.descriptorCount = 1;
-        paletteBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-        VkDescriptorSetLayoutBinding jointPaletteBinding{};
-        jointPaletteBinding.binding = 2;
-        jointPaletteBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        jointPaletteBinding.descriptorCount = 1;
-        jointPaletteBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-        VkDescriptorSetLayoutCreateInfo dsl{};
-        dsl.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        VkDescriptorSetLayoutBinding bindings[3] = {camBinding, paletteBinding, jointPaletteBinding};
-        dsl.bindingCount = 3;
-        dsl.pBindings = bindings;
-
-        if (vkCreateDescriptorSetLayout(ctx.GetDevice(), &dsl, nullptr, &m_cameraSetLayout) != VK_SUCCESS)
-        {
-            return false;
-        }
-
         // Pool: one uniform buffer descriptor + two storage buffer descriptors per frame
         VkDescriptorPoolSize poolSizes[2]{};
         poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -465,7 +320,7 @@ namespace Engine
             return false;
         }
 
-        std::vector<VkDescriptorSetLayout> layouts(frameCount, m_cameraSetLayout);
+        std::vector<VkDescriptorSetLayout> layouts(frameCount, m_shared->frameSetLayout());
         VkDescriptorSetAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
         allocInfo.descriptorPool = m_cameraPool;
@@ -480,122 +335,31 @@ namespace Engine
             return false;
         }
 
-        auto findMemoryType = [&](uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t &typeIndex) -> bool
-        {
-            VkPhysicalDeviceMemoryProperties memProps{};
-            vkGetPhysicalDeviceMemoryProperties(ctx.GetPhysicalDevice(), &memProps);
-            for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
-            {
-                if ((typeFilter & (1u << i)) && (memProps.memoryTypes[i].propertyFlags & properties) == properties)
-                {
-                    typeIndex = i;
-                    return true;
-                }
-            }
-            return false;
-        };
-
-        const VkDeviceSize bufSize = sizeof(CameraUBO);
         for (size_t i = 0; i < frameCount; ++i)
         {
             CameraFrame &cf = m_cameraFrames[i];
             cf.set = sets[i];
 
-            VkBufferCreateInfo binfo{};
-            binfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-            binfo.size = bufSize;
-            binfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-            binfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-            if (vkCreateBuffer(ctx.GetDevice(), &binfo, nullptr, &cf.buffer) != VK_SUCCESS)
-                return false;
-
-            VkMemoryRequirements memReq{};
-            vkGetBufferMemoryRequirements(ctx.GetDevice(), cf.buffer, &memReq);
-
-            VkMemoryAllocateInfo mai{};
-            mai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            mai.allocationSize = memReq.size;
-            uint32_t memType = 0;
-            if (!findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memType))
-                return false;
-            mai.memoryTypeIndex = memType;
-
-            if (vkAllocateMemory(ctx.GetDevice(), &mai, nullptr, &cf.memory) != VK_SUCCESS)
-                return false;
-
-            vkBindBufferMemory(ctx.GetDevice(), cf.buffer, cf.memory, 0);
-
-            // Palette SSBO (host-visible, coherent, persistently mapped)
+            // Palette SSBO (host-visible, coherent, persistently mapped); src: staged uploads
             constexpr uint32_t kDefaultPaletteCapacityMatrices = 1024;
             cf.paletteCapacityMatrices = kDefaultPaletteCapacityMatrices;
-
-            VkBufferCreateInfo pbinfo{};
-            pbinfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-            pbinfo.size = static_cast<VkDeviceSize>(cf.paletteCapacityMatrices) * sizeof(glm::mat4);
-            pbinfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-            pbinfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-            if (vkCreateBuffer(ctx.GetDevice(), &pbinfo, nullptr, &cf.paletteBuffer) != VK_SUCCESS)
-                return false;
-
-            VkMemoryRequirements pmemReq{};
-            vkGetBufferMemoryRequirements(ctx.GetDevice(), cf.paletteBuffer, &pmemReq);
-
-            VkMemoryAllocateInfo pmai{};
-            pmai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            pmai.allocationSize = pmemReq.size;
-            uint32_t pmemType = 0;
-            if (!findMemoryType(pmemReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, pmemType))
-                return false;
-            pmai.memoryTypeIndex = pmemType;
-
-            if (vkAllocateMemory(ctx.GetDevice(), &pmai, nullptr, &cf.paletteMemory) != VK_SUCCESS)
-                return false;
-
-            vkBindBufferMemory(ctx.GetDevice(), cf.paletteBuffer, cf.paletteMemory, 0);
-
-            cf.paletteMapped = nullptr;
-            if (vkMapMemory(ctx.GetDevice(), cf.paletteMemory, 0, VK_WHOLE_SIZE, 0, &cf.paletteMapped) != VK_SUCCESS)
+            if (!createHostBuffer(static_cast<VkDeviceSize>(cf.paletteCapacityMatrices) * sizeof(glm::mat4),
+                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                  cf.paletteBuffer, cf.paletteAllocation, cf.paletteMapped))
                 return false;
 
             // Joint palette SSBO (host-visible, coherent, persistently mapped)
             constexpr uint32_t kDefaultJointPaletteCapacityMatrices = 1024;
             cf.jointPaletteCapacityMatrices = kDefaultJointPaletteCapacityMatrices;
-
-            VkBufferCreateInfo jbinfo{};
-            jbinfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-            jbinfo.size = static_cast<VkDeviceSize>(cf.jointPaletteCapacityMatrices) * sizeof(glm::mat4);
-            jbinfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-            jbinfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-            if (vkCreateBuffer(ctx.GetDevice(), &jbinfo, nullptr, &cf.jointPaletteBuffer) != VK_SUCCESS)
-                return false;
-
-            VkMemoryRequirements jmemReq{};
-            vkGetBufferMemoryRequirements(ctx.GetDevice(), cf.jointPaletteBuffer, &jmemReq);
-
-            VkMemoryAllocateInfo jmai{};
-            jmai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            jmai.allocationSize = jmemReq.size;
-            uint32_t jmemType = 0;
-            if (!findMemoryType(jmemReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, jmemType))
-                return false;
-            jmai.memoryTypeIndex = jmemType;
-
-            if (vkAllocateMemory(ctx.GetDevice(), &jmai, nullptr, &cf.jointPaletteMemory) != VK_SUCCESS)
-                return false;
-
-            vkBindBufferMemory(ctx.GetDevice(), cf.jointPaletteBuffer, cf.jointPaletteMemory, 0);
-
-            cf.jointPaletteMapped = nullptr;
-            if (vkMapMemory(ctx.GetDevice(), cf.jointPaletteMemory, 0, VK_WHOLE_SIZE, 0, &cf.jointPaletteMapped) != VK_SUCCESS)
+            if (!createHostBuffer(static_cast<VkDeviceSize>(cf.jointPaletteCapacityMatrices) * sizeof(glm::mat4),
+                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                  cf.jointPaletteBuffer, cf.jointPaletteAllocation, cf.jointPaletteMapped))
                 return false;
 
             VkDescriptorBufferInfo dbi{};
-            dbi.buffer = cf.buffer;
+            dbi.buffer = m_shared->cameraBuffer(static_cast<uint32_t>(i));
             dbi.offset = 0;
-            dbi.range = bufSize;
+            dbi.range = sizeof(SModelRenderer::CameraUBO);
 
             VkDescriptorBufferInfo pbi{};
             pbi.buffer = cf.paletteBuffer;
@@ -642,52 +406,15 @@ namespace Engine
     {
         for (auto &cf : m_cameraFrames)
         {
-            if (cf.paletteMapped && cf.paletteMemory != VK_NULL_HANDLE)
-            {
-                vkUnmapMemory(m_device, cf.paletteMemory);
-                cf.paletteMapped = nullptr;
-            }
-
-            if (cf.jointPaletteMapped && cf.jointPaletteMemory != VK_NULL_HANDLE)
-            {
-                vkUnmapMemory(m_device, cf.jointPaletteMemory);
-                cf.jointPaletteMapped = nullptr;
-            }
-
-            if (cf.paletteBuffer != VK_NULL_HANDLE)
-            {
-                vkDestroyBuffer(m_device, cf.paletteBuffer, nullptr);
-                cf.paletteBuffer = VK_NULL_HANDLE;
-            }
-            if (cf.paletteMemory != VK_NULL_HANDLE)
-            {
-                vkFreeMemory(m_device, cf.paletteMemory, nullptr);
-                cf.paletteMemory = VK_NULL_HANDLE;
-            }
+            destroyHostBuffer(cf.paletteBuffer, cf.paletteAllocation, cf.paletteMapped);
             cf.paletteCapacityMatrices = 0;
 
-            if (cf.jointPaletteBuffer != VK_NULL_HANDLE)
-            {
-                vkDestroyBuffer(m_device, cf.jointPaletteBuffer, nullptr);
-                cf.jointPaletteBuffer = VK_NULL_HANDLE;
-            }
-            if (cf.jointPaletteMemory != VK_NULL_HANDLE)
-            {
-                vkFreeMemory(m_device, cf.jointPaletteMemory, nullptr);
-                cf.jointPaletteMemory = VK_NULL_HANDLE;
-            }
+            destroyHostBuffer(cf.jointPaletteBuffer, cf.jointPaletteAllocation, cf.jointPaletteMapped);
             cf.jointPaletteCapacityMatrices = 0;
 
-            if (cf.buffer != VK_NULL_HANDLE)
-            {
-                vkDestroyBuffer(m_device, cf.buffer, nullptr);
-                cf.buffer = VK_NULL_HANDLE;
-            }
-            if (cf.memory != VK_NULL_HANDLE)
-            {
-                vkFreeMemory(m_device, cf.memory, nullptr);
-                cf.memory = VK_NULL_HANDLE;
-            }
+            destroyMirror(cf.paletteDevice);
+            destroyMirror(cf.jointPaletteDevice);
+
             cf.set = VK_NULL_HANDLE;
         }
         m_cameraFrames.clear();
@@ -697,11 +424,6 @@ namespace Engine
             vkDestroyDescriptorPool(m_device, m_cameraPool, nullptr);
             m_cameraPool = VK_NULL_HANDLE;
         }
-        if (m_cameraSetLayout != VK_NULL_HANDLE)
-        {
-            vkDestroyDescriptorSetLayout(m_device, m_cameraSetLayout, nullptr);
-            m_cameraSetLayout = VK_NULL_HANDLE;
-        }
     }
 
     bool SModelRenderPassModule::ensurePaletteCapacity(CameraFrame &frame, uint32_t neededMatrices)
@@ -717,67 +439,15 @@ namespace Engine
         while (newCap < neededMatrices)
             newCap *= 2u;
 
-        if (frame.paletteMapped && frame.paletteMemory != VK_NULL_HANDLE)
-        {
-            vkUnmapMemory(m_device, frame.paletteMemory);
-            frame.paletteMapped = nullptr;
-        }
-        if (frame.paletteBuffer != VK_NULL_HANDLE)
-        {
-            vkDestroyBuffer(m_device, frame.paletteBuffer, nullptr);
-            frame.paletteBuffer = VK_NULL_HANDLE;
-        }
-        if (frame.paletteMemory != VK_NULL_HANDLE)
-        {
-            vkFreeMemory(m_device, frame.paletteMemory, nullptr);
-            frame.paletteMemory = VK_NULL_HANDLE;
-        }
-
-        auto findMemoryType = [&](uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t &typeIndex) -> bool
-        {
-            VkPhysicalDeviceMemoryProperties memProps{};
-            vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &memProps);
-            for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
-            {
-                if ((typeFilter & (1u << i)) && (memProps.memoryTypes[i].propertyFlags & properties) == properties)
-                {
-                    typeIndex = i;
-                    return true;
-                }
-            }
-            return false;
-        };
-
-        VkBufferCreateInfo binfo{};
-        binfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        binfo.size = static_cast<VkDeviceSize>(newCap) * sizeof(glm::mat4);
-        binfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-        binfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-        if (vkCreateBuffer(m_device, &binfo, nullptr, &frame.paletteBuffer) != VK_SUCCESS)
-            return false;
-
-        VkMemoryRequirements memReq{};
-        vkGetBufferMemoryRequirements(m_device, frame.paletteBuffer, &memReq);
-
-        VkMemoryAllocateInfo mai{};
-        mai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        mai.allocationSize = memReq.size;
-        uint32_t memType = 0;
-        if (!findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memType))
-            return false;
-        mai.memoryTypeIndex = memType;
-
-        if (vkAllocateMemory(m_device, &mai, nullptr, &frame.paletteMemory) != VK_SUCCESS)
-            return false;
-
-        vkBindBufferMemory(m_device, frame.paletteBuffer, frame.paletteMemory, 0);
-
-        frame.paletteMapped = nullptr;
-        if (vkMapMemory(m_device, frame.paletteMemory, 0, VK_WHOLE_SIZE, 0, &frame.paletteMapped) != VK_SUCCESS)
+        destroyHostBuffer(frame.paletteBuffer, frame.paletteAllocation, frame.paletteMapped);
+        if (!createHostBuffer(static_cast<VkDeviceSize>(newCap) * sizeof(glm::mat4),
+                              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                              frame.paletteBuffer, frame.paletteAllocation, frame.paletteMapped))
             return false;
 
         frame.paletteCapacityMatrices = newCap;
+        if (m_uploadPath == UploadPath::Staged)
+            return true; // the set keeps pointing at the device-local mirror
 
         VkDescriptorBufferInfo pbi{};
         pbi.buffer = frame.paletteBuffer;
@@ -810,67 +480,15 @@ namespace Engine
         while (newCap < neededMatrices)
             newCap *= 2u;
 
-        if (frame.jointPaletteMapped && frame.jointPaletteMemory != VK_NULL_HANDLE)
-        {
-            vkUnmapMemory(m_device, frame.jointPaletteMemory);
-            frame.jointPaletteMapped = nullptr;
-        }
-        if (frame.jointPaletteBuffer != VK_NULL_HANDLE)
-        {
-            vkDestroyBuffer(m_device, frame.jointPaletteBuffer, nullptr);
-            frame.jointPaletteBuffer = VK_NULL_HANDLE;
-        }
-        if (frame.jointPaletteMemory != VK_NULL_HANDLE)
-        {
-            vkFreeMemory(m_device, frame.jointPaletteMemory, nullptr);
-            frame.jointPaletteMemory = VK_NULL_HANDLE;
-        }
-
-        auto findMemoryType = [&](uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t &typeIndex) -> bool
-        {
-            VkPhysicalDeviceMemoryProperties memProps{};
-            vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &memProps);
-            for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
-            {
-                if ((typeFilter & (1u << i)) && (memProps.memoryTypes[i].propertyFlags & properties) == properties)
-                {
-                    typeIndex = i;
-                    return true;
-                }
-            }
-            return false;
-        };
-
-        VkBufferCreateInfo binfo{};
-        binfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        binfo.size = static_cast<VkDeviceSize>(newCap) * sizeof(glm::mat4);
-        binfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-        binfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-        if (vkCreateBuffer(m_device, &binfo, nullptr, &frame.jointPaletteBuffer) != VK_SUCCESS)
-            return false;
-
-        VkMemoryRequirements memReq{};
-        vkGetBufferMemoryRequirements(m_device, frame.jointPaletteBuffer, &memReq);
-
-        VkMemoryAllocateInfo mai{};
-        mai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        mai.allocationSize = memReq.size;
-        uint32_t memType = 0;
-        if (!findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memType))
-            return false;
-        mai.memoryTypeIndex = memType;
-
-        if (vkAllocateMemory(m_device, &mai, nullptr, &frame.jointPaletteMemory) != VK_SUCCESS)
-            return false;
-
-        vkBindBufferMemory(m_device, frame.jointPaletteBuffer, frame.jointPaletteMemory, 0);
-
-        frame.jointPaletteMapped = nullptr;
-        if (vkMapMemory(m_device, frame.jointPaletteMemory, 0, VK_WHOLE_SIZE, 0, &frame.jointPaletteMapped) != VK_SUCCESS)
+        destroyHostBuffer(frame.jointPaletteBuffer, frame.jointPaletteAllocation, frame.jointPaletteMapped);
+        if (!createHostBuffer(static_cast<VkDeviceSize>(newCap) * sizeof(glm::mat4),
+                              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                              frame.jointPaletteBuffer, frame.jointPaletteAllocation, frame.jointPaletteMapped))
             return false;
 
         frame.jointPaletteCapacityMatrices = newCap;
+        if (m_uploadPath == UploadPath::Staged)
+            return true; // the set keeps pointing at the device-local mirror
 
         VkDescriptorBufferInfo jbi{};
         jbi.buffer = frame.jointPaletteBuffer;
@@ -897,59 +515,20 @@ namespace Engine
         if (frameCount == 0)
             frameCount = 1;
 
-        auto findMemoryType = [&](uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t &typeIndex) -> bool
-        {
-            VkPhysicalDeviceMemoryProperties memProps{};
-            vkGetPhysicalDeviceMemoryProperties(ctx.GetPhysicalDevice(), &memProps);
-            for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
-            {
-                if ((typeFilter & (1u << i)) && (memProps.memoryTypes[i].propertyFlags & properties) == properties)
-                {
-                    typeIndex = i;
-                    return true;
-                }
-            }
-            return false;
-        };
-
         m_instanceFrames.resize(frameCount);
 
         // Start with a modest default capacity; grows on demand.
         constexpr uint32_t kDefaultCapacity = 256;
-        const VkDeviceSize bufSize = static_cast<VkDeviceSize>(kDefaultCapacity) * sizeof(glm::mat4);
+        const VkDeviceSize bufSize = static_cast<VkDeviceSize>(kDefaultCapacity) * instanceStride();
 
         for (size_t i = 0; i < frameCount; ++i)
         {
             InstanceFrame &fr = m_instanceFrames[i];
             fr.capacity = kDefaultCapacity;
 
-            VkBufferCreateInfo binfo{};
-            binfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-            binfo.size = bufSize;
-            binfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-            binfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-            if (vkCreateBuffer(ctx.GetDevice(), &binfo, nullptr, &fr.buffer) != VK_SUCCESS)
-                return false;
-
-            VkMemoryRequirements memReq{};
-            vkGetBufferMemoryRequirements(ctx.GetDevice(), fr.buffer, &memReq);
-
-            VkMemoryAllocateInfo mai{};
-            mai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            mai.allocationSize = memReq.size;
-            uint32_t memType = 0;
-            if (!findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memType))
-                return false;
-            mai.memoryTypeIndex = memType;
-
-            if (vkAllocateMemory(ctx.GetDevice(), &mai, nullptr, &fr.memory) != VK_SUCCESS)
-                return false;
-
-            vkBindBufferMemory(ctx.GetDevice(), fr.buffer, fr.memory, 0);
-
-            fr.mapped = nullptr;
-            if (vkMapMemory(ctx.GetDevice(), fr.memory, 0, VK_WHOLE_SIZE, 0, &fr.mapped) != VK_SUCCESS)
+            // storage: GPU culling input
+            if (!createHostBuffer(bufSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                  fr.buffer, fr.allocation, fr.mapped))
                 return false;
         }
 
@@ -963,25 +542,9 @@ namespace Engine
 
         for (auto &fr : m_instanceFrames)
         {
-            if (fr.mapped && fr.memory != VK_NULL_HANDLE)
-            {
-                vkUnmapMemory(m_device, fr.memory);
-                fr.mapped = nullptr;
-            }
-
-            if (fr.buffer != VK_NULL_HANDLE)
-            {
-                vkDestroyBuffer(m_device, fr.buffer, nullptr);
-                fr.buffer = VK_NULL_HANDLE;
-            }
-
-            if (fr.memory != VK_NULL_HANDLE)
-            {
-                vkFreeMemory(m_device, fr.memory, nullptr);
-                fr.memory = VK_NULL_HANDLE;
-            }
-
+            destroyHostBuffer(fr.buffer, fr.allocation, fr.mapped);
             fr.capacity = 0;
+            destroyMirror(fr.device);
         }
         m_instanceFrames.clear();
     }
@@ -998,509 +561,952 @@ namespace Engine
         while (newCap < needed)
             newCap *= 2u;
 
-        if (frame.mapped && frame.memory != VK_NULL_HANDLE)
-        {
-            vkUnmapMemory(m_device, frame.memory);
-            frame.mapped = nullptr;
-        }
-        if (frame.buffer != VK_NULL_HANDLE)
-        {
-            vkDestroyBuffer(m_device, frame.buffer, nullptr);
-            frame.buffer = VK_NULL_HANDLE;
-        }
-        if (frame.memory != VK_NULL_HANDLE)
-        {
-            vkFreeMemory(m_device, frame.memory, nullptr);
-            frame.memory = VK_NULL_HANDLE;
-        }
+        destroyHostBuffer(frame.buffer, frame.allocation, frame.mapped);
 
-        auto findMemoryType = [&](uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t &typeIndex) -> bool
-        {
-            VkPhysicalDeviceMemoryProperties memProps{};
-            vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &memProps);
-            for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
-            {
-                if ((typeFilter & (1u << i)) && (memProps.memoryTypes[i].propertyFlags & properties) == properties)
-                {
-                    typeIndex = i;
-                    return true;
-                }
-            }
+        // storage: GPU culling input
+        const VkDeviceSize bufSize = static_cast<VkDeviceSize>(newCap) * instanceStride();
+        if (!createHostBuffer(bufSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                              frame.buffer, frame.allocation, frame.mapped))
             return false;
-        };
 
-        const VkDeviceSize bufSize = static_cast<VkDeviceSize>(newCap) * sizeof(glm::mat4);
-        VkBufferCreateInfo binfo{};
-        binfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        binfo.size = bufSize;
-        binfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-        binfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        frame.capacity = newCap;
+        return true;
+    }
 
-        if (vkCreateBuffer(m_device, &binfo, nullptr, &frame.buffer) != VK_SUCCESS)
-            return false;
+    bool SModelRenderPassModule::uploadFrameData(uint32_t frameIndex, ModelAsset &model, bool writePalettes)
+    {
+        const uint32_t camIndex = (!m_cameraFrames.empty()) ? (frameIndex % static_cast<uint32_t>(m_cameraFrames.size())) : 0;
+        CameraFrame *camFrame = (!m_cameraFrames.empty()) ? &m_cameraFrames[camIndex] : nullptr;
 
-        VkMemoryRequirements memReq{};
-        vkGetBufferMemoryRequirements(m_device, frame.buffer, &memReq);
+        // Update instance buffer for this frame
+        const uint32_t instIndex = (!m_instanceFrames.empty()) ? (frameIndex % static_cast<uint32_t>(m_instanceFrames.size())) : 0;
+        InstanceFrame *instFrame = (!m_instanceFrames.empty()) ? &m_instanceFrames[instIndex] : nullptr;
 
-        VkMemoryAllocateInfo mai{};
-        mai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        mai.allocationSize = memReq.size;
-        uint32_t memType = 0;
-        if (!findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memType))
-            return false;
-        mai.memoryTypeIndex = memType;
+        m_uploadedInstanceBytes = 0;
+        m_uploadedPaletteBytes = 0;
+        m_uploadedJointBytes = 0;
 
-        if (vkAllocateMemory(m_device, &mai, nullptr, &frame.memory) != VK_SUCCESS)
-            return false;
+        const uint32_t recorded = recordInstanceCount();
+        const uint32_t instanceCount = (recorded == 0) ? 1u : recorded;
+        const bool slotted = writePalettes && !m_record.paletteSlots.empty() && m_record.paletteCount > 0;
+        const uint32_t paletteCount = slotted ? m_record.paletteCount : instanceCount;
+        if (instFrame)
+        {
+            if (!ensureInstanceCapacity(*instFrame, instanceCount))
+                return false;
+            m_uploadedInstanceBytes = static_cast<VkDeviceSize>(instanceCount) * instanceStride();
 
-        vkBindBufferMemory(m_device, frame.buffer, frame.memory, 0);
+            // Palette slot goes in [0][3] (smodel.vert) or paletteSlot (smodel_compact.vert);
+            // out-of-range slots fall back to 0.
+            auto slotOf = [&](uint32_t i) -> float
+            {
+                const uint32_t slot = slotted ? m_record.paletteSlots[i] : i;
+                return static_cast<float>(slot < paletteCount ? slot : 0u);
+            };
+            // Instance written at upload position j (grouped by LOD level, see selectLods())
+            const bool reordered = m_lodOrder.size() == instanceCount;
+            auto sourceOf = [&](uint32_t j) -> uint32_t
+            { return reordered ? m_lodOrder[j] : j; };
+
+            if (m_instanceFormat == InstanceFormat::Compact)
+            {
+                CompactInstance *dst = static_cast<CompactInstance *>(instFrame->mapped);
+                if (!m_record.compactInstances.empty())
+                {
+                    for (uint32_t j = 0; j < instanceCount; ++j)
+                    {
+                        const uint32_t i = sourceOf(j);
+                        dst[j] = m_record.compactInstances[i];
+                        dst[j].paletteSlot = slotOf(i);
+                    }
+                }
+                else if (!m_record.instanceWorlds.empty())
+                {
+                    for (uint32_t j = 0; j < instanceCount; ++j)
+                    {
+                        const uint32_t i = sourceOf(j);
+                        const glm::mat4 &w = m_record.instanceWorlds[i];
+                        const float scale = glm::length(glm::vec3(w[0]));
+                        CompactInstance c;
+                        c.position = glm::vec3(w[3]);
+                        c.scale = scale;
+                        c.yawSin = (scale > 0.0f) ? -w[0][2] / scale : 0.0f;
+                        c.yawCos = (scale > 0.0f) ? w[0][0] / scale : 1.0f;
+                        c.paletteSlot = slotOf(i);
+                        dst[j] = c;
+                    }
+                }
+                else
+                {
+                    dst[0] = CompactInstance{};
+                }
+            }
+            else
+            {
+                glm::mat4 *dst = static_cast<glm::mat4 *>(instFrame->mapped);
+                if (!m_record.instanceWorlds.empty())
+                {
+                    for (uint32_t j = 0; j < instanceCount; ++j)
+                    {
+                        const uint32_t i = sourceOf(j);
+                        glm::mat4 w = m_record.instanceWorlds[i];
+                        w[0][3] = slotOf(i);
+                        dst[j] = w;
+                    }
+                }
+                else if (!m_record.compactInstances.empty())
+                {
+                    for (uint32_t j = 0; j < instanceCount; ++j)
+                    {
+                        const uint32_t i = sourceOf(j);
+                        const CompactInstance &c = m_record.compactInstances[i];
+                        glm::mat4 w(1.0f);
+                        w[0] = glm::vec4(c.yawCos * c.scale, 0.0f, -c.yawSin * c.scale, slotOf(i));
+                        w[1] = glm::vec4(0.0f, c.scale, 0.0f, 0.0f);
+                        w[2] = glm::vec4(c.yawSin * c.scale, 0.0f, c.yawCos * c.scale, 0.0f);
+                        w[3] = glm::vec4(c.position, 1.0f);
+                        dst[j] = w;
+                    }
+                }
+                else
+                {
+                    dst[0] = identityMat4();
+                }
+            }
+        }
 
-        frame.mapped = nullptr;
-        if (vkMapMemory(m_device, frame.memory, 0, VK_WHOLE_SIZE, 0, &frame.mapped) != VK_SUCCESS)
-            return false;
+        if (!writePalettes)
+            return true;
+
+        // Update node palette buffer for this frame (SSBO in set=0 binding=1).
+        const uint32_t nodeCount = model.nodes.empty() ? 1u : static_cast<uint32_t>(model.nodes.size());
+        const uint32_t neededMatrices = paletteCount * nodeCount;
+        if (camFrame && camFrame->paletteMapped)
+        {
+            if (!ensurePaletteCapacity(*camFrame, neededMatrices))
+                return false;
+            m_uploadedPaletteBytes = sizeof(glm::mat4) * static_cast<VkDeviceSize>(neededMatrices);
+
+            const size_t expected = static_cast<size_t>(neededMatrices);
+
+            // Prefer the explicitly provided palette; otherwise fall back to the model's current node globals.
+            if (m_record.nodePalette.size() == expected)
+            {
+                std::memcpy(camFrame->paletteMapped, m_record.nodePalette.data(), sizeof(glm::mat4) * expected);
+            }
+            else
+            {
+                // Minimal fallback palette: replicate current per-node globals for each instance,
+                // written straight into the mapped buffer (no per-frame scratch).
+                glm::mat4 *dst = static_cast<glm::mat4 *>(camFrame->paletteMapped);
+                const uint32_t modelNodeCount = static_cast<uint32_t>(model.nodes.size());
+                for (uint32_t inst = 0; inst < paletteCount; ++inst)
+                {
+                    for (uint32_t ni = 0; ni < nodeCount; ++ni)
+                    {
+                        glm::mat4 g = glm::mat4(1.0f);
+                        if (ni < modelNodeCount)
+                            g = model.nodes[ni].globalMatrix;
+                        std::memcpy(dst + static_cast<size_t>(inst) * nodeCount + ni, &g, sizeof(g));
+                    }
+                }
+            }
+        }
+
+        // Update joint palette buffer for this frame (SSBO in set=0 binding=2).
+        const uint32_t jointStride = (model.totalJointCount > 0) ? model.totalJointCount : 1u;
+        const uint32_t neededJointMatrices = paletteCount * jointStride;
+        if (camFrame && camFrame->jointPaletteMapped)
+        {
+            if (!ensureJointPaletteCapacity(*camFrame, neededJointMatrices))
+                return false;
+            m_uploadedJointBytes = sizeof(glm::mat4) * static_cast<VkDeviceSize>(neededJointMatrices);
+
+            const size_t expected = static_cast<size_t>(neededJointMatrices);
+            if (model.totalJointCount > 0 && m_record.jointPaletteJointCount == model.totalJointCount && m_record.jointPalette.size() == expected)
+            {
+                std::memcpy(camFrame->jointPaletteMapped, m_record.jointPalette.data(), sizeof(glm::mat4) * expected);
+            }
+            else
+            {
+                // Default to identity matrices. Shader will not use these unless skinJointCount > 0.
+                const glm::mat4 identity(1.0f);
+                glm::mat4 *dst = static_cast<glm::mat4 *>(camFrame->jointPaletteMapped);
+                for (size_t i = 0; i < expected; ++i)
+                    std::memcpy(dst + i, &identity, sizeof(identity));
+            }
+        }
 
-        frame.capacity = newCap;
         return true;
     }
 
-    void SModelRenderPassModule::createPipelines(VulkanContext &ctx, VkRenderPass pass)
+    bool SModelRenderPassModule::reserveFrameData(uint32_t frameIndex, const ModelAsset &model)
+    {
+        if (m_cameraFrames.empty() || m_instanceFrames.empty())
+            return false;
+
+        CameraFrame &camFrame = m_cameraFrames[frameIndex % static_cast<uint32_t>(m_cameraFrames.size())];
+        InstanceFrame &instFrame = m_instanceFrames[frameIndex % static_cast<uint32_t>(m_instanceFrames.size())];
+
+        // Same counts as uploadFrameData() with palettes written (the larger case).
+        const uint32_t instanceCount = std::max(1u, recordInstanceCount());
+        const bool slotted = !m_record.paletteSlots.empty() && m_record.paletteCount > 0;
+        const uint32_t paletteCount = slotted ? m_record.paletteCount : instanceCount;
+        const uint32_t nodeCount = model.nodes.empty() ? 1u : static_cast<uint32_t>(model.nodes.size());
+        const uint32_t jointStride = (model.totalJointCount > 0) ? model.totalJointCount : 1u;
+
+        return ensureInstanceCapacity(instFrame, instanceCount) &&
+               ensurePaletteCapacity(camFrame, paletteCount * nodeCount) &&
+               ensureJointPaletteCapacity(camFrame, paletteCount * jointStride);
+    }
+
+    float SModelRenderPassModule::batchViewDepth(const ModelAsset &model) const
     {
-        if (m_cameraSetLayout == VK_NULL_HANDLE)
+        const glm::vec3 bmin(model.boundsMin[0], model.boundsMin[1], model.boundsMin[2]);
+        const glm::vec3 bmax(model.boundsMax[0], model.boundsMax[1], model.boundsMax[2]);
+        const glm::vec4 local = m_record.model * glm::vec4((bmin + bmax) * 0.5f, 1.0f);
+
+        glm::vec3 sum(0.0f);
+        uint32_t count = 0;
+        if (!m_record.instanceWorlds.empty())
         {
-            throw std::runtime_error("SModelRenderPassModule: camera descriptor set layout not created");
+            for (const glm::mat4 &w : m_record.instanceWorlds)
+                sum += glm::vec3(w * local);
+            count = static_cast<uint32_t>(m_record.instanceWorlds.size());
         }
-        if (m_materialSetLayout == VK_NULL_HANDLE)
+        else if (!m_record.compactInstances.empty())
         {
-            throw std::runtime_error("SModelRenderPassModule: material descriptor set layout not created");
+            for (const CompactInstance &c : m_record.compactInstances)
+            {
+                // Same rotation as the compact vertex shader: yaw about +Y, then uniform scale.
+                const glm::vec3 r(c.yawCos * local.x + c.yawSin * local.z, local.y, -c.yawSin * local.x + c.yawCos * local.z);
+                sum += c.position + r * c.scale;
+            }
+            count = static_cast<uint32_t>(m_record.compactInstances.size());
         }
-
-        // Shared pipeline layout: camera set + push constants.
-        VkPushConstantRange pcRange{};
-        pcRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pcRange.offset = 0;
-        pcRange.size = sizeof(PushConstantsModel);
-
-        VkPipelineLayoutCreateInfo plInfo{};
-        plInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        VkDescriptorSetLayout setLayouts[2] = {m_cameraSetLayout, m_materialSetLayout};
-        plInfo.setLayoutCount = 2;
-        plInfo.pSetLayouts = setLayouts;
-        plInfo.pushConstantRangeCount = 1;
-        plInfo.pPushConstantRanges = &pcRange;
-
-        if (vkCreatePipelineLayout(ctx.GetDevice(), &plInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
+        else
         {
-            throw std::runtime_error("SModelRenderPassModule: failed to create pipeline layout");
+            sum = glm::vec3(local);
+            count = 1;
         }
 
-        // Common pipeline create info
-        PipelineCreateInfo pci{};
-        pci.device = ctx.GetDevice();
-        pci.renderPass = pass;
-        pci.subpass = 0;
-        pci.pipelineLayout = m_pipelineLayout;
-
-        // Load shader modules
-        VkShaderModule vert = Pipeline::createShaderModuleFromFile(pci.device, "shaders/smodel.vert.spv");
-        VkShaderModule frag = Pipeline::createShaderModuleFromFile(pci.device, "shaders/smodel.frag.spv");
-        if (vert == VK_NULL_HANDLE || frag == VK_NULL_HANDLE)
+        return (m_record.view.view * glm::vec4(sum / static_cast<float>(count), 1.0f)).z;
+    }
+
+    void SModelRenderPassModule::selectLods(const ModelAsset &model, bool batch)
+    {
+        const uint32_t instanceCount = std::max(1u, recordInstanceCount());
+        m_lodOrder.clear();
+        m_lodBatchLevel = 0;
+
+        // Model-wide error per level: the largest of its primitives (clamped to their coarsest)
+        float levelError[kLodLevels] = {};
+        uint32_t levels = 1;
+        for (const ModelPrimitive &prim : model.primitives)
         {
-            throw std::runtime_error("SModelRenderPassModule: failed to load shader modules (smodel.vert/frag.spv)");
+            if (prim.lodCount == 0)
+                continue;
+            levels = std::max(levels, prim.lodCount + 1);
+            for (uint32_t l = 1; l < kLodLevels; ++l)
+                levelError[l] = std::max(levelError[l], prim.lods[std::min(l, prim.lodCount) - 1].error);
         }
 
-        VkPipelineShaderStageCreateInfo vs{};
-        vs.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        vs.stage = VK_SHADER_STAGE_VERTEX_BIT;
-        vs.module = vert;
-        vs.pName = "main";
-
-        VkPipelineShaderStageCreateInfo fs{};
-        fs.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        fs.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        fs.module = frag;
-        fs.pName = "main";
-
-        pci.shaderStages = {vs, fs};
-
-        // Vertex input:
-        //  binding 0: VertexPNTTJW (72 bytes)
-        //  binding 1: Instance mat4 (64 bytes), advanced per-instance
-        std::array<VkVertexInputBindingDescription, 2> bindingDescs{};
-        bindingDescs[0].binding = 0;
-        bindingDescs[0].stride = 72;
-        bindingDescs[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-        bindingDescs[1].binding = 1;
-        bindingDescs[1].stride = sizeof(glm::mat4);
-        bindingDescs[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
-
-        std::array<VkVertexInputAttributeDescription, 10> attrs{};
-        attrs[0] = {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0};     // pos
-        attrs[1] = {1, 0, VK_FORMAT_R32G32B32_SFLOAT, 12};    // normal
-        attrs[2] = {2, 0, VK_FORMAT_R32G32_SFLOAT, 24};       // uv0
-        attrs[3] = {3, 0, VK_FORMAT_R32G32B32A32_SFLOAT, 32}; // tangent
-
-        // Skinning inputs
-        attrs[4] = {8, 0, VK_FORMAT_R16G16B16A16_UINT, 48};   // joints (u16x4)
-        attrs[5] = {9, 0, VK_FORMAT_R32G32B32A32_SFLOAT, 56}; // weights (f32x4)
-
-        // mat4 consumes 4 locations (vec4 columns)
-        attrs[6] = {4, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 0};
-        attrs[7] = {5, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 16};
-        attrs[8] = {6, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 32};
-        attrs[9] = {7, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 48};
-
-        VkPipelineVertexInputStateCreateInfo vi{};
-        vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vi.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescs.size());
-        vi.pVertexBindingDescriptions = bindingDescs.data();
-        vi.vertexAttributeDescriptionCount = static_cast<uint32_t>(attrs.size());
-        vi.pVertexAttributeDescriptions = attrs.data();
-        pci.vertexInput = vi;
-        pci.vertexInputProvided = true;
-
-        // Input assembly: triangle list
-        VkPipelineInputAssemblyStateCreateInfo ia{};
-        ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        ia.primitiveRestartEnable = VK_FALSE;
-        pci.inputAssembly = ia;
-        pci.inputAssemblyProvided = true;
-
-        // Rasterization: no cull (safe for now; honors doubleSided by default)
-        VkPipelineRasterizationStateCreateInfo rs{};
-        rs.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-        rs.depthClampEnable = VK_FALSE;
-        rs.rasterizerDiscardEnable = VK_FALSE;
-        rs.polygonMode = VK_POLYGON_MODE_FILL;
-        rs.lineWidth = 1.0f;
-        rs.cullMode = VK_CULL_MODE_NONE;
-        rs.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-        rs.depthBiasEnable = VK_FALSE;
-        pci.rasterization = rs;
-        pci.rasterizationProvided = true;
-
-        // Dynamic viewport/scissor
-        pci.dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
-
-        // Depth/stencil (main render pass has a depth attachment)
-        VkPipelineDepthStencilStateCreateInfo ds{};
-        ds.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-        ds.depthTestEnable = VK_TRUE;
-        ds.depthWriteEnable = VK_TRUE;
-        ds.depthCompareOp = VK_COMPARE_OP_LESS;
-        ds.depthBoundsTestEnable = VK_FALSE;
-        ds.stencilTestEnable = VK_FALSE;
-        pci.depthStencil = ds;
-        pci.depthStencilProvided = true;
-
-        // Pipelines: OPAQUE / MASK / BLEND (mask currently uses same state as opaque)
-        VkPipelineColorBlendAttachmentState attOpaque{};
-        VkPipelineColorBlendStateCreateInfo cbOpaque = makeBlendState(false, attOpaque);
-        pci.colorBlend = cbOpaque;
-        pci.colorBlendProvided = true;
-        VkResult r0 = m_pipelineOpaque.create(pci);
-
-        VkPipelineColorBlendAttachmentState attMask{};
-        VkPipelineColorBlendStateCreateInfo cbMask = makeBlendState(false, attMask);
-        pci.colorBlend = cbMask;
-        pci.colorBlendProvided = true;
-        VkResult r1 = m_pipelineMask.create(pci);
-
-        VkPipelineColorBlendAttachmentState attBlend{};
-        VkPipelineColorBlendStateCreateInfo cbBlend = makeBlendState(true, attBlend);
-        pci.colorBlend = cbBlend;
-        pci.colorBlendProvided = true;
-
-        // Transparent: test depth but don't write
-        pci.depthStencil.depthWriteEnable = VK_FALSE;
-        VkResult r2 = m_pipelineBlend.create(pci);
-
-        // Cleanup shader modules
-        vkDestroyShaderModule(pci.device, vert, nullptr);
-        vkDestroyShaderModule(pci.device, frag, nullptr);
-
-        if (r0 != VK_SUCCESS || r1 != VK_SUCCESS || r2 != VK_SUCCESS)
+        auto allAt = [&](uint32_t level)
         {
-            throw std::runtime_error("SModelRenderPassModule: failed to create one or more pipelines");
-        }
-    }
+            for (uint32_t l = 0; l <= kLodLevels; ++l)
+                m_lodFirst[l] = (l <= level) ? 0u : instanceCount;
+        };
 
-    void SModelRenderPassModule::record(FrameContext &frameCtx, VkCommandBuffer cmd)
-    {
-        if (!m_enabled)
-            return;
-        if (!m_assets || !m_model.isValid())
-            return;
-        if (m_extent.width == 0 || m_extent.height == 0)
+        if (levels == 1 || m_record.lodPixelError <= 0.0f || m_extent.height == 0)
+        {
+            allAt(0);
             return;
+        }
 
-        ModelAsset *model = m_assets->getModel(m_model);
-        if (!model || model->primitives.empty())
-            return;
+        // Pixels per world unit at distance d: proj[1][1] * height / 2 / d.
+        const glm::vec4 sphere = boundingSphere(model, m_record.model);
+        const glm::vec3 localCenter(sphere);
+        const float modelScale = maxAxisScale(m_record.model);
+        const float pixelScale = std::abs(m_record.view.proj[1][1]) * 0.5f * static_cast<float>(m_extent.height);
 
-        VkViewport vp{0.0f, 0.0f, static_cast<float>(m_extent.width), static_cast<float>(m_extent.height), 0.0f, 1.0f};
-        VkRect2D sc{{0, 0}, {m_extent.width, m_extent.height}};
-        vkCmdSetViewport(cmd, 0, 1, &vp);
-        vkCmdSetScissor(cmd, 0, 1, &sc);
+        auto levelOf = [&](const glm::vec3 &center, float scale) -> uint32_t
+        {
+            const float dist = std::max(glm::length(glm::vec3(m_record.view.view * glm::vec4(center, 1.0f))) - sphere.w * scale, 1e-3f);
+            const float pixelsPerUnit = pixelScale * modelScale * scale / dist;
+            uint32_t level = 0;
+            while (level + 1 < levels && levelError[level + 1] * pixelsPerUnit <= m_record.lodPixelError)
+                ++level;
+            return level;
+        };
 
-        // Update camera UBO for this frame
-        const uint32_t camIndex = (!m_cameraFrames.empty()) ? (frameCtx.frameIndex % static_cast<uint32_t>(m_cameraFrames.size())) : 0;
-        CameraFrame *camFrame = (!m_cameraFrames.empty()) ? &m_cameraFrames[camIndex] : nullptr;
-        if (camFrame && camFrame->memory != VK_NULL_HANDLE)
+        std::vector<uint8_t> &levelOfInstance = m_lodScratch;
+        levelOfInstance.resize(instanceCount);
+        if (!m_record.instanceWorlds.empty())
         {
-            CameraUBO ubo{};
-            const float aspect = (m_extent.height > 0) ? (static_cast<float>(m_extent.width) / static_cast<float>(m_extent.height)) : 1.0f;
-            if (m_camera)
+            for (uint32_t i = 0; i < instanceCount; ++i)
             {
-                m_camera->SetAspect(aspect);
-                ubo.view = m_camera->GetViewMatrix();
-                ubo.proj = m_camera->GetProjectionMatrix();
+                const glm::mat4 &w = m_record.instanceWorlds[i];
+                levelOfInstance[i] = static_cast<uint8_t>(levelOf(glm::vec3(w * glm::vec4(localCenter, 1.0f)), maxAxisScale(w)));
             }
-            else
+        }
+        else if (!m_record.compactInstances.empty())
+        {
+            for (uint32_t i = 0; i < instanceCount; ++i)
             {
-                glm::mat4 view = glm::lookAt(glm::vec3(0, 0, 3), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
-                glm::mat4 proj = glm::perspective(glm::radians(60.0f), aspect, 0.1f, 100.0f);
-                proj[1][1] *= -1.0f;
-                ubo.view = view;
-                ubo.proj = proj;
+                // Same transform as smodel_compact.vert: yaw about +Y, then uniform scale.
+                const CompactInstance &c = m_record.compactInstances[i];
+                const glm::vec3 r(c.yawCos * localCenter.x + c.yawSin * localCenter.z, localCenter.y,
+                                  -c.yawSin * localCenter.x + c.yawCos * localCenter.z);
+                levelOfInstance[i] = static_cast<uint8_t>(levelOf(c.position + r * c.scale, c.scale));
             }
+        }
+        else
+        {
+            levelOfInstance[0] = static_cast<uint8_t>(levelOf(localCenter, 1.0f));
+        }
 
-            void *mapped = nullptr;
-            if (vkMapMemory(m_device, camFrame->memory, 0, sizeof(CameraUBO), 0, &mapped) == VK_SUCCESS && mapped)
-            {
-                std::memcpy(mapped, &ubo, sizeof(CameraUBO));
-                vkUnmapMemory(m_device, camFrame->memory);
-            }
+        uint32_t counts[kLodLevels] = {};
+        uint32_t finest = kLodLevels - 1;
+        for (uint8_t level : levelOfInstance)
+        {
+            ++counts[level];
+            finest = std::min<uint32_t>(finest, level);
         }
 
-        // Update instance buffer for this frame
-        const uint32_t instIndex = (!m_instanceFrames.empty()) ? (frameCtx.frameIndex % static_cast<uint32_t>(m_instanceFrames.size())) : 0;
-        InstanceFrame *instFrame = (!m_instanceFrames.empty()) ? &m_instanceFrames[instIndex] : nullptr;
+        // GPU culling keeps instance order: everything draws at the finest level needed.
+        if (batch || counts[finest] == instanceCount)
+        {
+            m_lodBatchLevel = finest;
+            allAt(finest);
+            return;
+        }
 
-        const uint32_t instanceCount = m_instanceWorlds.empty() ? 1u : static_cast<uint32_t>(m_instanceWorlds.size());
-        if (instFrame)
+        // Counting sort into per-level buckets
+        m_lodFirst[0] = 0;
+        for (uint32_t l = 0; l < kLodLevels; ++l)
+            m_lodFirst[l + 1] = m_lodFirst[l] + counts[l];
+
+        uint32_t cursor[kLodLevels];
+        std::copy(m_lodFirst, m_lodFirst + kLodLevels, cursor);
+        m_lodOrder.resize(instanceCount);
+        for (uint32_t i = 0; i < instanceCount; ++i)
+            m_lodOrder[cursor[levelOfInstance[i]]++] = i;
+    }
+
+    void SModelRenderPassModule::reportScreenSizes(const ModelAsset &model)
+    {
+        if (!m_assets->textureStreamingEnabled() || m_extent.height == 0)
+            return;
+
+        // Projected diameter of the bounds, as in selectLods(); culling is ignored so instances just
+        // off screen keep their detail.
+        const glm::vec4 sphere = boundingSphere(model, m_record.model);
+        const glm::vec3 localCenter(sphere);
+        const float pixelScale = std::abs(m_record.view.proj[1][1]) * 0.5f * static_cast<float>(m_extent.height);
+
+        float largest = 0.0f;
+        auto measure = [&](const glm::vec3 &center, float scale)
         {
-            if (!ensureInstanceCapacity(*instFrame, instanceCount))
-                return;
+            const float dist = std::max(glm::length(glm::vec3(m_record.view.view * glm::vec4(center, 1.0f))) - sphere.w * scale, 1e-3f);
+            largest = std::max(largest, 2.0f * sphere.w * scale * pixelScale / dist);
+        };
 
-            const glm::mat4 *src = m_instanceWorlds.empty() ? nullptr : m_instanceWorlds.data();
-            if (src)
+        const uint32_t instanceCount = std::max(1u, recordInstanceCount());
+        if (!m_record.instanceWorlds.empty())
+        {
+            for (uint32_t i = 0; i < instanceCount; ++i)
             {
-                std::memcpy(instFrame->mapped, src, sizeof(glm::mat4) * instanceCount);
+                const glm::mat4 &w = m_record.instanceWorlds[i];
+                measure(glm::vec3(w * glm::vec4(localCenter, 1.0f)), maxAxisScale(w));
             }
-            else
+        }
+        else if (!m_record.compactInstances.empty())
+        {
+            for (uint32_t i = 0; i < instanceCount; ++i)
             {
-                const glm::mat4 I = identityMat4();
-                std::memcpy(instFrame->mapped, &I, sizeof(glm::mat4));
+                const CompactInstance &c = m_record.compactInstances[i];
+                const glm::vec3 r(c.yawCos * localCenter.x + c.yawSin * localCenter.z, localCenter.y,
+                                  -c.yawSin * localCenter.x + c.yawCos * localCenter.z);
+                measure(c.position + r * c.scale, c.scale);
             }
         }
-
-        // Update node palette buffer for this frame (SSBO in set=0 binding=1).
-        const uint32_t nodeCount = model->nodes.empty() ? 1u : static_cast<uint32_t>(model->nodes.size());
-        const uint32_t neededMatrices = instanceCount * nodeCount;
-        if (camFrame && camFrame->paletteMapped)
+        else
         {
-            if (!ensurePaletteCapacity(*camFrame, neededMatrices))
-                return;
+            measure(localCenter, 1.0f);
+        }
 
-            const size_t expected = static_cast<size_t>(neededMatrices);
+        for (const ModelPrimitive &prim : model.primitives)
+            m_assets->reportMaterialScreenSize(prim.material, largest);
+    }
 
-            // Prefer the explicitly provided palette; otherwise fall back to the model's current node globals.
-            if (m_nodePalette.size() == expected)
+    void SModelRenderPassModule::queueDraws(uint32_t frameIndex, ModelAsset &model)
+    {
+        const bool culled = m_cullActive;
+        const CameraFrame &camFrame = m_cameraFrames[frameIndex % static_cast<uint32_t>(m_cameraFrames.size())];
+        const InstanceFrame &instFrame = m_instanceFrames[frameIndex % static_cast<uint32_t>(m_instanceFrames.size())];
+
+        const uint32_t jointStride = (model.totalJointCount > 0) ? model.totalJointCount : 1u;
+        const uint32_t nodeCount = model.nodes.empty() ? 1u : static_cast<uint32_t>(model.nodes.size());
+        const bool compact = m_instanceFormat == InstanceFormat::Compact;
+
+        // Culled frames read the compacted instances and GPU-written draw counts; GPU poses replace the
+        // host palettes (the culler's draw set already binds them when both are active).
+        VkDescriptorSet frameSet = camFrame.set;
+        if (culled)
+            frameSet = m_culler.drawSet(frameIndex);
+        else if (m_poseActive)
+            frameSet = m_poseEvaluator.drawSet(frameIndex);
+        const VkBuffer instanceBuffer = culled ? m_culler.visibleWorlds(frameIndex) : gpuInstanceBuffer(instFrame);
+        const VkBuffer indirectBuffer = culled ? m_culler.drawCommands(frameIndex) : VK_NULL_HANDLE;
+        VkDeviceSize drawSlot = 0;
+
+        bool haveDepth = false;
+        float viewDepth = 0.0f;
+
+        auto queue = [&](const ModelPrimitive &prim, uint32_t nodeIndex)
+        {
+            MeshAsset *mesh = m_assets->getMesh(prim.mesh);
+            MaterialAsset *mat = m_assets->getMaterial(prim.material);
+
+            SModelRenderer::DrawItem d{};
+            std::memcpy(d.pc.model, glm::value_ptr(m_record.model), sizeof(d.pc.model));
+            std::memcpy(d.pc.baseColorFactor, mat->baseColorFactor, sizeof(d.pc.baseColorFactor));
+            d.pc.materialParams[0] = mat->alphaCutoff;
+            d.pc.materialParams[1] = static_cast<float>(mat->alphaMode);
+            d.pc.nodeIndex = nodeIndex;
+            d.pc.nodeCount = nodeCount;
+
+            // Skinning per-primitive
+            d.pc.jointPaletteStride = jointStride;
+            if (prim.skinIndex >= 0 && static_cast<uint32_t>(prim.skinIndex) < model.skins.size())
             {
-                std::memcpy(camFrame->paletteMapped, m_nodePalette.data(), sizeof(glm::mat4) * expected);
+                const auto &skin = model.skins[static_cast<uint32_t>(prim.skinIndex)];
+                d.pc.skinBaseJoint = skin.jointBase;
+                d.pc.skinJointCount = skin.jointCount;
             }
-            else
+            d.skinned = d.pc.skinJointCount > 0;
+
+            d.frameSet = frameSet;
+            const auto mb = m_shared->material(*m_assets, prim.material, *mat);
+            d.materialSet = mb.set;
+            d.pc.materialIndex = mb.index;
+            d.instanceBuffer = instanceBuffer;
+            d.vertexBuffer = mesh->getVertexBuffer();
+            d.indexBuffer = mesh->getIndexBuffer();
+            d.indexType = mesh->getIndexType();
+            d.vertexOffset = prim.vertexOffset;
+            if (mesh->isQuantized())
+            {
+                d.quantizedVertices = true;
+                d.pc.setQuantizationBox(mesh->getAABBMin(), mesh->getAABBMax());
+            }
+            d.material = prim.material.id;
+            d.alphaMode = mat->alphaMode;
+            d.compactInstances = compact;
+            d.depthPrePass = m_record.occluder && d.alphaMode == 0;
+            if (d.alphaMode == 2)
             {
-                // Build a minimal fallback palette: replicate current per-node globals for each instance.
-                std::vector<glm::mat4> fallback;
-                fallback.resize(expected);
-                const uint32_t modelNodeCount = static_cast<uint32_t>(model->nodes.size());
-                for (uint32_t inst = 0; inst < instanceCount; ++inst)
+                if (!haveDepth)
                 {
-                    for (uint32_t ni = 0; ni < nodeCount; ++ni)
-                    {
-                        glm::mat4 g = glm::mat4(1.0f);
-                        if (ni < modelNodeCount)
-                            g = model->nodes[ni].globalMatrix;
-                        fallback[static_cast<size_t>(inst) * nodeCount + ni] = g;
-                    }
+                    viewDepth = batchViewDepth(model);
+                    haveDepth = true;
                 }
-                std::memcpy(camFrame->paletteMapped, fallback.data(), sizeof(glm::mat4) * expected);
+                d.viewDepth = viewDepth;
             }
-        }
 
-        // Update joint palette buffer for this frame (SSBO in set=0 binding=2).
-        const uint32_t jointStride = (model->totalJointCount > 0) ? model->totalJointCount : 1u;
-        const uint32_t neededJointMatrices = instanceCount * jointStride;
-        if (camFrame && camFrame->jointPaletteMapped)
-        {
-            if (!ensureJointPaletteCapacity(*camFrame, neededJointMatrices))
+            if (culled)
+            {
+                lodRange(prim, m_lodBatchLevel, d.firstIndex, d.indexCount);
+                d.indirectBuffer = indirectBuffer;
+                d.indirectOffset = sizeof(VkDrawIndexedIndirectCommand) * drawSlot++;
+                m_shared->queueDraw(d);
                 return;
+            }
 
-            const size_t expected = static_cast<size_t>(neededJointMatrices);
-            if (model->totalJointCount > 0 && m_jointPaletteJointCount == model->totalJointCount && m_jointPalette.size() == expected)
+            // One draw per LOD bucket (selectLods() grouped the instance buffer by level)
+            for (uint32_t level = 0; level < kLodLevels; ++level)
+            {
+                d.firstInstance = m_lodFirst[level];
+                d.instanceCount = m_lodFirst[level + 1] - m_lodFirst[level];
+                if (d.instanceCount == 0)
+                    continue;
+                lodRange(prim, level, d.firstIndex, d.indexCount);
+                m_shared->queueDraw(d);
+            }
+        };
+
+        // Pass ordering like glTF: 0=OPAQUE,1=MASK,2=BLEND; the draw slots must match buildIndirectCommands().
+        for (uint32_t pass = 0; pass < 3; ++pass)
+        {
+            if (!model.nodes.empty())
             {
-                std::memcpy(camFrame->jointPaletteMapped, m_jointPalette.data(), sizeof(glm::mat4) * expected);
+                // Draw by nodes: push base model matrix + node index; vertex shader fetches node matrix from palette
+                for (uint32_t nodeIndex = 0; nodeIndex < static_cast<uint32_t>(model.nodes.size()); ++nodeIndex)
+                {
+                    const auto &node = model.nodes[nodeIndex];
+                    for (uint32_t k = 0; k < node.primitiveCount; ++k)
+                    {
+                        const uint32_t primIndex = model.nodePrimitiveIndices[node.firstPrimitiveIndex + k];
+                        if (primIndex < model.primitives.size() && isDrawable(model.primitives[primIndex], pass))
+                            queue(model.primitives[primIndex], nodeIndex);
+                    }
+                }
             }
             else
             {
-                // Default to identity matrices. Shader will not use these unless skinJointCount > 0.
-                std::vector<glm::mat4> fallback;
-                fallback.assign(expected, glm::mat4(1.0f));
-                std::memcpy(camFrame->jointPaletteMapped, fallback.data(), sizeof(glm::mat4) * expected);
+                // Fallback: draw all primitives with base model matrix
+                for (const ModelPrimitive &prim : model.primitives)
+                {
+                    if (isDrawable(prim, pass))
+                        queue(prim, 0);
+                }
             }
         }
+    }
 
-        // Pass ordering like glTF: 0=OPAQUE,1=MASK,2=BLEND
-        for (uint32_t pass = 0; pass < 3; ++pass)
+    void SModelRenderPassModule::record(FrameContext &frameCtx, VkCommandBuffer cmd)
+    {
+        // Host-visible data the pre-pass did not need is written here, so modules still fill their
+        // buffers in parallel when passes are recorded on worker threads.
+        if (m_uploadPending)
         {
-            const Pipeline *pipe = nullptr;
-            if (pass == 0)
-                pipe = &m_pipelineOpaque;
-            else if (pass == 1)
-                pipe = &m_pipelineMask;
-            else
-                pipe = &m_pipelineBlend;
+            if (ModelAsset *model = m_assets->getModel(m_model))
+                uploadFrameData(frameCtx.frameIndex, *model);
+        }
+        m_uploadPending = false;
+        m_frameUploaded = false;
+        m_cullActive = false;
+        m_poseActive = false;
+        m_cullDeferred = false;
+
+        // The first module on the render pass draws what every module queued.
+        if (m_shared)
+            m_shared->recordDraws(cmd, this, m_extent);
+        publishMemoryUsage();
+    }
 
-            pipe->bind(cmd);
+    void SModelRenderPassModule::onFrameSnapshot()
+    {
+        m_record.enabled = m_enabled;
 
-            if (camFrame && camFrame->set != VK_NULL_HANDLE)
-            {
-                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &camFrame->set, 0, nullptr);
-            }
+        const float aspect = (m_extent.height > 0) ? (static_cast<float>(m_extent.width) / static_cast<float>(m_extent.height)) : 1.0f;
+        if (m_camera)
+        {
+            m_camera->SetAspect(aspect);
+            m_record.view = m_camera->GetViewData();
+        }
+        else
+        {
+            ViewData &v = m_record.view;
+            v.view = glm::lookAt(glm::vec3(0, 0, 3), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+            v.proj = glm::perspective(glm::radians(60.0f), aspect, 0.1f, 100.0f);
+            v.proj[1][1] *= -1.0f;
+            v.viewProj = v.proj * v.view;
+            v.position = glm::vec3(0, 0, 3);
+            v.forward = glm::vec3(0, 0, -1);
+            v.frustum = Frustum::fromViewProj(v.viewProj);
+        }
+        if (m_shared)
+            m_shared->setCamera(m_record.view.view, m_record.view.proj);
 
-            if (instFrame && instFrame->buffer != VK_NULL_HANDLE)
-            {
-                VkDeviceSize instOffset = 0;
-                vkCmdBindVertexBuffers(cmd, 1, 1, &instFrame->buffer, &instOffset);
-            }
+        m_record.model = glm::make_mat4(m_pc.model);
+        m_record.instanceWorlds = m_instanceWorlds;
+        m_record.compactInstances = m_compactInstances;
+        if (m_paletteSlots.size() == recordInstanceCount())
+        {
+            m_record.paletteSlots = m_paletteSlots;
+            m_record.paletteCount = m_paletteCount;
+        }
+        else
+        {
+            m_record.paletteSlots.clear();
+            m_record.paletteCount = 0;
+        }
+        m_record.nodePalette = m_nodePalette;
+        m_record.jointPalette = m_jointPalette;
+        m_record.jointPaletteJointCount = m_jointPaletteJointCount;
+        m_record.gpuCulling = m_gpuCulling;
+        m_record.occluder = m_occluder;
+        m_record.occlusionCulling = m_occlusionCulling;
+        m_record.gpuPoses = m_gpuPoses;
+        m_record.instanceAnimation = m_instanceAnimation;
+        m_record.lodPixelError = m_lodPixelError;
+    }
+
+    glm::vec4 SModelRenderPassModule::instanceBoundingSphere() const
+    {
+        const ModelAsset *model = (m_assets && m_model.isValid()) ? m_assets->getModel(m_model) : nullptr;
+        if (!model)
+            return glm::vec4(0.0f);
+        return boundingSphere(*model, glm::make_mat4(m_pc.model));
+    }
+
+    bool SModelRenderPassModule::isDrawable(const ModelPrimitive &prim, uint32_t pass) const
+    {
+        MeshAsset *mesh = m_assets->getMesh(prim.mesh);
+        MaterialAsset *mat = m_assets->getMaterial(prim.material);
+        if (!mesh || !mat || mat->alphaMode != pass)
+            return false;
+        return mesh->getVertexBuffer() != VK_NULL_HANDLE && mesh->getIndexBuffer() != VK_NULL_HANDLE && prim.indexCount != 0;
+    }
+
+    void SModelRenderPassModule::buildIndirectCommands(ModelAsset &model)
+    {
+        // Must enumerate draws exactly like record(): pass, then node, then node primitive.
+        m_indirectCommands.clear();
+        auto add = [&](const ModelPrimitive &prim)
+        {
+            VkDrawIndexedIndirectCommand c{};
+            lodRange(prim, m_lodBatchLevel, c.firstIndex, c.indexCount);
+            c.instanceCount = 0; // written by the cull shader
+            c.vertexOffset = prim.vertexOffset;
+            c.firstInstance = 0;
+            m_indirectCommands.push_back(c);
+        };
 
-            if (!model->nodes.empty())
+        for (uint32_t pass = 0; pass < 3; ++pass)
+        {
+            if (!model.nodes.empty())
             {
-                // Draw by nodes: push base model matrix + node index; vertex shader fetches node matrix from palette
-                const glm::mat4 baseM = glm::make_mat4(m_pc.model);
-                for (uint32_t nodeIndex = 0; nodeIndex < static_cast<uint32_t>(model->nodes.size()); ++nodeIndex)
+                for (const auto &node : model.nodes)
                 {
-                    const auto &node = model->nodes[nodeIndex];
-
                     for (uint32_t k = 0; k < node.primitiveCount; ++k)
                     {
-                        const uint32_t primIndex = model->nodePrimitiveIndices[node.firstPrimitiveIndex + k];
-                        if (primIndex >= model->primitives.size())
-                            continue;
-                        const ModelPrimitive &prim = model->primitives[primIndex];
-
-                        MeshAsset *mesh = m_assets->getMesh(prim.mesh);
-                        MaterialAsset *mat = m_assets->getMaterial(prim.material);
-                        if (!mesh || !mat)
-                            continue;
-                        if (mat->alphaMode != pass)
-                            continue;
-
-                        VkDescriptorSet matSet = getOrCreateMaterialSet(prim.material, mat);
-                        if (matSet != VK_NULL_HANDLE)
-                        {
-                            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 1, 1, &matSet, 0, nullptr);
-                        }
-
-                        PushConstantsModel pc{};
-                        std::memcpy(pc.model, glm::value_ptr(baseM), sizeof(pc.model));
-                        std::memcpy(pc.baseColorFactor, mat->baseColorFactor, sizeof(pc.baseColorFactor));
-                        pc.materialParams[0] = mat->alphaCutoff;
-                        pc.materialParams[1] = static_cast<float>(mat->alphaMode);
-                        pc.materialParams[2] = 0.0f;
-                        pc.materialParams[3] = 0.0f;
-                        pc.nodeIndex = nodeIndex;
-                        pc.nodeCount = static_cast<uint32_t>(model->nodes.size());
-
-                        // Skinning per-primitive
-                        pc.jointPaletteStride = jointStride;
-                        if (prim.skinIndex >= 0 && static_cast<uint32_t>(prim.skinIndex) < model->skins.size())
-                        {
-                            const auto &skin = model->skins[static_cast<uint32_t>(prim.skinIndex)];
-                            pc.skinBaseJoint = skin.jointBase;
-                            pc.skinJointCount = skin.jointCount;
-                        }
-                        else
-                        {
-                            pc.skinBaseJoint = 0;
-                            pc.skinJointCount = 0;
-                        }
-                        vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstantsModel), &pc);
-
-                        VkBuffer vb = mesh->getVertexBuffer();
-                        VkBuffer ib = mesh->getIndexBuffer();
-                        if (vb == VK_NULL_HANDLE || ib == VK_NULL_HANDLE || prim.indexCount == 0)
-                            continue;
-
-                        VkDeviceSize vbOffset = 0;
-                        vkCmdBindVertexBuffers(cmd, 0, 1, &vb, &vbOffset);
-                        vkCmdBindIndexBuffer(cmd, ib, 0, mesh->getIndexType());
-
-                        vkCmdDrawIndexed(cmd, prim.indexCount, instanceCount, prim.firstIndex, prim.vertexOffset, 0);
-                        DrawCallCounter::increment();
+                        const uint32_t primIndex = model.nodePrimitiveIndices[node.firstPrimitiveIndex + k];
+                        if (primIndex < model.primitives.size() && isDrawable(model.primitives[primIndex], pass))
+                            add(model.primitives[primIndex]);
                     }
                 }
             }
             else
             {
-                // Fallback: draw all primitives with base model matrix
-                const glm::mat4 baseM = glm::make_mat4(m_pc.model);
-                for (const ModelPrimitive &prim : model->primitives)
+                for (const ModelPrimitive &prim : model.primitives)
                 {
-                    MeshAsset *mesh = m_assets->getMesh(prim.mesh);
-                    MaterialAsset *mat = m_assets->getMaterial(prim.material);
-                    if (!mesh || !mat)
-                        continue;
-                    if (mat->alphaMode != pass)
-                        continue;
-
-                    VkDescriptorSet matSet = getOrCreateMaterialSet(prim.material, mat);
-                    if (matSet != VK_NULL_HANDLE)
-                    {
-                        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 1, 1, &matSet, 0, nullptr);
-                    }
+                    if (isDrawable(prim, pass))
+                        add(prim);
+                }
+            }
+        }
+    }
 
-                    PushConstantsModel pc{};
-                    std::memcpy(pc.model, glm::value_ptr(baseM), sizeof(pc.model));
-                    std::memcpy(pc.baseColorFactor, mat->baseColorFactor, sizeof(pc.baseColorFactor));
-                    pc.materialParams[0] = mat->alphaCutoff;
-                    pc.materialParams[1] = static_cast<float>(mat->alphaMode);
-                    pc.materialParams[2] = 0.0f;
-                    pc.materialParams[3] = 0.0f;
-                    pc.nodeIndex = 0;
-                    pc.nodeCount = 1;
-
-                    pc.jointPaletteStride = jointStride;
-                    if (prim.skinIndex >= 0 && static_cast<uint32_t>(prim.skinIndex) < model->skins.size())
-                    {
-                        const auto &skin = model->skins[static_cast<uint32_t>(prim.skinIndex)];
-                        pc.skinBaseJoint = skin.jointBase;
-                        pc.skinJointCount = skin.jointCount;
-                    }
-                    else
-                    {
-                        pc.skinBaseJoint = 0;
-                        pc.skinJointCount = 0;
-                    }
-                    vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstantsModel), &pc);
+    ModelAsset *SModelRenderPassModule::beginFrame(FrameContext &frameCtx)
+    {
+        m_frameUploaded = false;
+        m_cullActive = false;
+        m_poseActive = false;
+        m_cullDeferred = false;
+        m_uploadPending = false;
 
-                    VkBuffer vb = mesh->getVertexBuffer();
-                    VkBuffer ib = mesh->getIndexBuffer();
-                    if (vb == VK_NULL_HANDLE || ib == VK_NULL_HANDLE || prim.indexCount == 0)
-                        continue;
+        if (!m_record.enabled || !m_assets || !m_model.isValid())
+            return nullptr;
 
-                    VkDeviceSize vbOffset = 0;
-                    vkCmdBindVertexBuffers(cmd, 0, 1, &vb, &vbOffset);
-                    vkCmdBindIndexBuffer(cmd, ib, 0, mesh->getIndexType());
+        ModelAsset *model = m_assets->getModel(m_model);
+        if (!model || model->primitives.empty() || !reserveFrameData(frameCtx.frameIndex, *model))
+            return nullptr;
 
-                    vkCmdDrawIndexed(cmd, prim.indexCount, instanceCount, prim.firstIndex, prim.vertexOffset, 0);
-                    DrawCallCounter::increment();
-                }
-            }
+        selectLods(*model, m_record.gpuCulling && m_culler.ready() && recordInstanceCount() > 0);
+        reportScreenSizes(*model);
+        return model;
+    }
+
+    bool SModelRenderPassModule::recordAsyncCompute(FrameContext &frameCtx, VkCommandBuffer cmd)
+    {
+        m_asyncModel = nullptr;
+        if (!m_shared || m_uploadPath == UploadPath::Staged)
+            return false;
+
+        // The dispatches read the camera before any pre-pass runs.
+        m_shared->writeCamera(frameCtx.frameIndex);
+
+        ModelAsset *model = beginFrame(frameCtx);
+        if (!model)
+            return false;
+        recordDispatches(frameCtx, cmd, *model, true);
+        m_asyncModel = model;
+        return m_poseActive || (m_cullActive && !m_cullDeferred);
+    }
+
+    void SModelRenderPassModule::recordPrePass(FrameContext &frameCtx, VkCommandBuffer cmd)
+    {
+        ModelAsset *model = std::exchange(m_asyncModel, nullptr);
+        if (!model)
+        {
+            m_frameUploaded = false;
+            m_cullActive = false;
+            m_poseActive = false;
+            m_cullDeferred = false;
+            m_uploadPending = false;
+        }
+        if (!m_shared)
+            return;
+
+        // Pre-passes run serially in registration order; the first module writes the shared camera
+        // and starts the merged draw list.
+        m_shared->beginPrePass(frameCtx.frameIndex, this);
+
+        if (!model)
+        {
+            model = beginFrame(frameCtx);
+            if (!model)
+                return;
+            recordDispatches(frameCtx, cmd, *model);
+        }
+
+        // Staged data only reaches the GPU through the pre-pass copy.
+        if (m_uploadPath == UploadPath::Staged && !m_frameUploaded)
+            return;
+        m_uploadPending = !m_frameUploaded;
+        queueDraws(frameCtx.frameIndex, *model);
+    }
+
+    void SModelRenderPassModule::recordDispatches(FrameContext &frameCtx, VkCommandBuffer cmd, ModelAsset &model, bool asyncQueue)
+    {
+        const uint32_t instanceCount = recordInstanceCount();
+        const bool staged = m_uploadPath == UploadPath::Staged;
+        const bool wantPoses = m_record.gpuPoses && m_poseEvaluator.ready() && instanceCount > 0 &&
+                               m_record.instanceAnimation.size() == instanceCount;
+        const bool wantCull = m_record.gpuCulling && m_culler.ready() && instanceCount > 0;
+        if (!wantPoses && !wantCull && !staged)
+            return;
+
+        const CameraFrame &camFrame = m_cameraFrames[frameCtx.frameIndex % static_cast<uint32_t>(m_cameraFrames.size())];
+        const InstanceFrame &instFrame = m_instanceFrames[frameCtx.frameIndex % static_cast<uint32_t>(m_instanceFrames.size())];
+
+        if (wantPoses && GpuPoseEvaluator::supports(model))
+        {
+            GpuScope gpu(frameCtx.gpuProfiler, cmd, "SModel poses");
+            m_poseActive = m_poseEvaluator.record(cmd, frameCtx.frameIndex, model, m_record.instanceAnimation.data(),
+                                                  instanceCount, m_shared->cameraBuffer(frameCtx.frameIndex),
+                                                  sizeof(SModelRenderer::CameraUBO), asyncQueue);
         }
+
+        // The dispatches read this frame's buffers, so upload them here instead of in record().
+        if (!uploadFrameData(frameCtx.frameIndex, model, !m_poseActive) ||
+            (staged && !copyToDevice(cmd, frameCtx.frameIndex, !m_poseActive)))
+        {
+            m_poseActive = false;
+            return;
+        }
+        m_frameUploaded = true;
+
+        if (!wantCull)
+            return;
+
+        buildIndirectCommands(model);
+        if (m_indirectCommands.empty())
+            return;
+
+        GpuInstanceCuller::Inputs in{};
+        in.worlds = gpuInstanceBuffer(instFrame);
+        in.nodes = m_poseActive ? m_poseEvaluator.nodePalette(frameCtx.frameIndex) : gpuPaletteBuffer(camFrame);
+        in.joints = m_poseActive ? m_poseEvaluator.jointPalette(frameCtx.frameIndex) : gpuJointPaletteBuffer(camFrame);
+        in.cameraUbo = m_shared->cameraBuffer(frameCtx.frameIndex);
+        in.cameraUboSize = sizeof(SModelRenderer::CameraUBO);
+        in.instanceCount = instanceCount;
+        in.instanceStride = static_cast<uint32_t>(instanceStride());
+        in.compactInstances = m_instanceFormat == InstanceFormat::Compact;
+
+        const glm::vec4 sphere = boundingSphere(model, m_record.model);
+        if (!(sphere.w > 0.0f))
+            return; // no cooked bounds: draw everything
+
+        // Occludees wait for the Hi-Z pyramid; the draws queued meanwhile read the prepared outputs.
+        if (frameCtx.hiZView != VK_NULL_HANDLE && m_record.occlusionCulling && !m_record.occluder && m_culler.occlusionReady())
+        {
+            m_cullActive = m_culler.prepare(frameCtx.frameIndex, in, m_indirectCommands);
+            m_cullDeferred = m_cullActive;
+            m_cullSphere = sphere;
+            return;
+        }
+
+        GpuScope gpu(frameCtx.gpuProfiler, cmd, "SModel cull");
+        m_cullActive = m_culler.record(cmd, frameCtx.frameIndex, in, m_record.view.frustum, sphere, m_indirectCommands, asyncQueue);
+    }
+
+    void SModelRenderPassModule::recordDepthPrePass(FrameContext &frameCtx, VkCommandBuffer cmd)
+    {
+        // The first module on the render pass draws every module's occluders.
+        if (m_shared)
+            m_shared->recordDepthDraws(cmd, this, m_extent, frameCtx.depthPrePass);
+    }
+
+    void SModelRenderPassModule::recordOcclusionCull(FrameContext &frameCtx, VkCommandBuffer cmd)
+    {
+        // Once prepared, the dispatch must run: draws already reference its indirect commands.
+        if (!std::exchange(m_cullDeferred, false))
+            return;
+
+        GpuInstanceCuller::Occlusion occlusion{};
+        occlusion.hiZ = frameCtx.hiZView;
+        occlusion.sampler = frameCtx.hiZSampler;
+
+        GpuScope gpu(frameCtx.gpuProfiler, cmd, "SModel cull");
+        m_culler.recordDispatch(cmd, frameCtx.frameIndex, m_record.view.frustum, m_cullSphere, &occlusion);
+    }
+
+    SModelRenderPassModule::UploadPath SModelRenderPassModule::selectUploadPath() const
+    {
+        if (!m_deviceLocalUploads || m_physicalDevice == VK_NULL_HANDLE)
+            return UploadPath::HostVisible;
+
+        // Without resizable BAR the host-visible device-local heap is a 256 MiB window shared with
+        // the driver, too small to hold palettes for every pass.
+        constexpr VkDeviceSize kMinReBarHeap = 256ull * 1024ull * 1024ull;
+        const VkMemoryPropertyFlags wanted = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        VkPhysicalDeviceMemoryProperties memProps{};
+        vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &memProps);
+        for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
+        {
+            const VkMemoryType &type = memProps.memoryTypes[i];
+            if ((type.propertyFlags & wanted) == wanted && memProps.memoryHeaps[type.heapIndex].size > kMinReBarHeap)
+                return UploadPath::ReBar;
+        }
+        return UploadPath::Staged;
+    }
+
+    bool SModelRenderPassModule::createHostBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer,
+                                                  GpuAllocation &allocation, void *&mapped)
+    {
+        mapped = nullptr;
+        if (GpuAllocator::forDevice(m_device, m_physicalDevice)
+                .createBuffer(size, usage, m_hostBufferProps, GpuMemoryCategory::Dynamic, buffer, allocation) != VK_SUCCESS)
+            return false;
+        mapped = allocation.mapped;
+        return true;
+    }
+
+    void SModelRenderPassModule::destroyHostBuffer(VkBuffer &buffer, GpuAllocation &allocation, void *&mapped)
+    {
+        mapped = nullptr;
+        DestroyBuffer(m_device, buffer, allocation);
+    }
+
+    bool SModelRenderPassModule::ensureMirror(DeviceMirror &mirror, VkDeviceSize size, VkBufferUsageFlags usage)
+    {
+        if (size <= mirror.size && mirror.buffer != VK_NULL_HANDLE)
+            return true;
+
+        // Grow by doubling; this frame's fence has signalled, so the old copy is idle.
+        VkDeviceSize newSize = std::max<VkDeviceSize>(mirror.size, 256);
+        while (newSize < size)
+            newSize *= 2;
+        destroyMirror(mirror);
+
+        if (CreateDeviceLocalBuffer(m_device, m_physicalDevice, newSize, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                    mirror.buffer, mirror.allocation, GpuMemoryCategory::Dynamic) != VK_SUCCESS)
+        {
+            destroyMirror(mirror);
+            return false;
+        }
+        mirror.size = newSize;
+        return true;
+    }
+
+    void SModelRenderPassModule::destroyMirror(DeviceMirror &mirror)
+    {
+        if (m_device == VK_NULL_HANDLE)
+            return;
+        DestroyBuffer(m_device, mirror.buffer, mirror.allocation);
+        mirror = DeviceMirror{};
+    }
+
+    void SModelRenderPassModule::publishMemoryUsage()
+    {
+        uint64_t instances = 0;
+        for (const InstanceFrame &fr : m_instanceFrames)
+            instances += fr.allocation.size + fr.device.allocation.size;
+        uint64_t palettes = 0;
+        uint64_t joints = 0;
+        for (const CameraFrame &cf : m_cameraFrames)
+        {
+            palettes += cf.paletteAllocation.size + cf.paletteDevice.allocation.size;
+            joints += cf.jointPaletteAllocation.size + cf.jointPaletteDevice.allocation.size;
+        }
+        m_instanceBytes.store(instances, std::memory_order_relaxed);
+        m_paletteBytes.store(palettes, std::memory_order_relaxed);
+        m_jointPaletteBytes.store(joints, std::memory_order_relaxed);
+    }
+
+    void SModelRenderPassModule::bindPalettes(CameraFrame &frame, VkBuffer nodes, VkBuffer joints)
+    {
+        VkDescriptorBufferInfo infos[2]{};
+        infos[0] = {nodes, 0, VK_WHOLE_SIZE};
+        infos[1] = {joints, 0, VK_WHOLE_SIZE};
+
+        VkWriteDescriptorSet writes[2]{};
+        for (uint32_t b = 0; b < 2; ++b)
+        {
+            writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[b].dstSet = frame.set;
+            writes[b].dstBinding = 1 + b;
+            writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[b].descriptorCount = 1;
+            writes[b].pBufferInfo = &infos[b];
+        }
+        vkUpdateDescriptorSets(m_device, 2, writes, 0, nullptr);
+    }
+
+    bool SModelRenderPassModule::copyToDevice(VkCommandBuffer cmd, uint32_t frameIndex, bool palettes)
+    {
+        if (m_cameraFrames.empty() || m_instanceFrames.empty())
+            return false;
+
+        CameraFrame &cf = m_cameraFrames[frameIndex % static_cast<uint32_t>(m_cameraFrames.size())];
+        InstanceFrame &inst = m_instanceFrames[frameIndex % static_cast<uint32_t>(m_instanceFrames.size())];
+
+        const VkBuffer oldNodes = cf.paletteDevice.buffer;
+        const VkBuffer oldJoints = cf.jointPaletteDevice.buffer;
+        const VkDeviceSize paletteBytes = palettes ? m_uploadedPaletteBytes : 0;
+        const VkDeviceSize jointBytes = palettes ? m_uploadedJointBytes : 0;
+
+        // Mirrors always exist so the descriptor set never falls back to the staging buffers.
+        const bool ok =
+            ensureMirror(inst.device, std::max<VkDeviceSize>(m_uploadedInstanceBytes, 1),
+                         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) &&
+            ensureMirror(cf.paletteDevice, std::max<VkDeviceSize>(paletteBytes, 1), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) &&
+            ensureMirror(cf.jointPaletteDevice, std::max<VkDeviceSize>(jointBytes, 1), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        if (!ok)
+            return false;
+
+        if (cf.paletteDevice.buffer != oldNodes || cf.jointPaletteDevice.buffer != oldJoints)
+            bindPalettes(cf, cf.paletteDevice.buffer, cf.jointPaletteDevice.buffer);
+
+        auto copy = [&](VkBuffer src, VkBuffer dst, VkDeviceSize bytes)
+        {
+            if (bytes == 0)
+                return;
+            VkBufferCopy region{0, 0, bytes};
+            vkCmdCopyBuffer(cmd, src, dst, 1, &region);
+        };
+        copy(inst.buffer, inst.device.buffer, m_uploadedInstanceBytes);
+        copy(cf.paletteBuffer, cf.paletteDevice.buffer, paletteBytes);
+        copy(cf.jointPaletteBuffer, cf.jointPaletteDevice.buffer, jointBytes);
+
+        // Culling reads the instances in compute; drawing reads all three in the vertex stage.
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+        return true;
+    }
+
+    VkBuffer SModelRenderPassModule::gpuInstanceBuffer(const InstanceFrame &frame) const
+    {
+        return (m_uploadPath == UploadPath::Staged) ? frame.device.buffer : frame.buffer;
+    }
+
+    VkBuffer SModelRenderPassModule::gpuPaletteBuffer(const CameraFrame &frame) const
+    {
+        return (m_uploadPath == UploadPath::Staged) ? frame.paletteDevice.buffer : frame.paletteBuffer;
+    }
+
+    VkBuffer SModelRenderPassModule::gpuJointPaletteBuffer(const CameraFrame &frame) const
+    {
+        return (m_uploadPath == UploadPath::Staged) ? frame.jointPaletteDevice.buffer : frame.jointPaletteBuffer;
     }
 
     void SModelRenderPassModule::onResize(VulkanContext &ctx, VkExtent2D newExtent)
@@ -1514,25 +1520,16 @@ namespace Engine
         if (m_device == VK_NULL_HANDLE)
             return;
 
+        m_memoryReport.reset();
+        m_culler.destroy(); // its draw sets use m_shared's frame set layout
+        m_poseEvaluator.destroy();
         destroyCameraResources();
         destroyInstanceResources();
-        destroyMaterialResources();
-
-        m_pipelineOpaque.destroy(m_device);
-        m_pipelineMask.destroy(m_device);
-        m_pipelineBlend.destroy(m_device);
 
-        if (m_pipelineLayout != VK_NULL_HANDLE)
-        {
-            vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
-            m_pipelineLayout = VK_NULL_HANDLE;
-        }
-
-        if (m_cameraSetLayout != VK_NULL_HANDLE)
-        {
-            vkDestroyDescriptorSetLayout(m_device, m_cameraSetLayout, nullptr);
-            m_cameraSetLayout = VK_NULL_HANDLE;
-        }
+        // The last module on this render pass destroys the shared pipelines and sets.
+        if (m_shared)
+            m_shared->detach(this);
+        m_shared.reset();
     }
 
     void SModelRenderPassModule::onDestroy(VulkanContext &ctx)
@@ -0,0 +1,1041 @@
+#include "Engine/SModelRenderer.h"
+#include "Engine/VulkanContext.h"
+#include "Engine/PerformanceMonitor.h"
+#include "assets/AssetManager.h"
+#include "assets/MaterialAsset.h"
+#include "utils/BufferUtils.h"
+#include "utils/ImageUtils.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace Engine
+{
+    namespace
+    {
+        struct Entry
+        {
+            VkDevice device = VK_NULL_HANDLE;
+            VkRenderPass pass = VK_NULL_HANDLE;
+            std::weak_ptr<SModelRenderer> renderer;
+        };
+
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<Entry> entries;
+        };
+
+        Registry &registry()
+        {
+            static Registry r;
+            return r;
+        }
+
+        const char *const kBindlessFragShader = "shaders/smodel_bindless.frag.spv";
+
+        // Material table of the bindless path; index 0 is the default white material.
+        constexpr uint32_t kMaxBindlessMaterials = 4096;
+
+        VkPipelineColorBlendStateCreateInfo makeBlendState(bool enableBlend, VkPipelineColorBlendAttachmentState &outAttachment)
+        {
+            std::memset(&outAttachment, 0, sizeof(outAttachment));
+            outAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                           VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+            outAttachment.blendEnable = enableBlend ? VK_TRUE : VK_FALSE;
+            if (enableBlend)
+            {
+                // Standard alpha blending
+                outAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+                outAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                outAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+                outAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+                outAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                outAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+            }
+
+            VkPipelineColorBlendStateCreateInfo cb{};
+            cb.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+            cb.logicOpEnable = VK_FALSE;
+            cb.attachmentCount = 1;
+            cb.pAttachments = &outAttachment;
+            return cb;
+        }
+
+        // Vertex input of smodel.vert / smodel_compact.vert; 'out' holds the descriptions the
+        // returned state points at.
+        struct VertexLayout
+        {
+            std::array<VkVertexInputBindingDescription, 2> bindings{};
+            std::array<VkVertexInputAttributeDescription, 10> attrs{};
+        };
+
+        VkPipelineVertexInputStateCreateInfo makeVertexInput(bool compactInstances, bool quantizedVertices, VertexLayout &out)
+        {
+            // binding 0: VertexPNTTJW (72 bytes) or smodel::SModelVertexQuantized (28 bytes)
+            // binding 1: Instance mat4 (64 bytes) or CompactInstance (32 bytes), advanced per-instance
+            auto &bindingDescs = out.bindings;
+            bindingDescs[0].binding = 0;
+            bindingDescs[0].stride = quantizedVertices ? static_cast<uint32_t>(sizeof(smodel::SModelVertexQuantized)) : 72u;
+            bindingDescs[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+            bindingDescs[1].binding = 1;
+            bindingDescs[1].stride = compactInstances ? 32u : static_cast<uint32_t>(sizeof(glm::mat4));
+            bindingDescs[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+            auto &attrs = out.attrs;
+            attrs[0] = {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0};     // pos
+            attrs[1] = {1, 0, VK_FORMAT_R32G32B32_SFLOAT, 12};    // normal
+            attrs[2] = {2, 0, VK_FORMAT_R32G32_SFLOAT, 24};       // uv0
+            attrs[3] = {3, 0, VK_FORMAT_R32G32B32A32_SFLOAT, 32}; // tangent
+
+            // Skinning inputs
+            attrs[4] = {8, 0, VK_FORMAT_R16G16B16A16_UINT, 48};   // joints (u16x4)
+            attrs[5] = {9, 0, VK_FORMAT_R32G32B32A32_SFLOAT, 56}; // weights (f32x4)
+
+            if (quantizedVertices)
+            {
+                // Same locations, narrower formats; the shader finishes position and normal decode.
+                attrs[0] = {0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(smodel::SModelVertexQuantized, pos)};
+                attrs[1] = {1, 0, VK_FORMAT_R16G16_SNORM, offsetof(smodel::SModelVertexQuantized, normal)};
+                attrs[2] = {2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(smodel::SModelVertexQuantized, uv0)};
+                attrs[3] = {3, 0, VK_FORMAT_R8G8B8A8_SNORM, offsetof(smodel::SModelVertexQuantized, tangent)};
+                attrs[4] = {8, 0, VK_FORMAT_R8G8B8A8_UINT, offsetof(smodel::SModelVertexQuantized, joints)};
+                attrs[5] = {9, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(smodel::SModelVertexQuantized, weights)};
+            }
+
+            // mat4 consumes 4 locations (vec4 columns); CompactInstance uses 2 (position/scale, yaw/slot)
+            attrs[6] = {4, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 0};
+            attrs[7] = {5, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 16};
+            attrs[8] = {6, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 32};
+            attrs[9] = {7, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 48};
+
+            VkPipelineVertexInputStateCreateInfo vi{};
+            vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+            vi.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescs.size());
+            vi.pVertexBindingDescriptions = bindingDescs.data();
+            vi.vertexAttributeDescriptionCount = compactInstances ? 8u : static_cast<uint32_t>(attrs.size());
+            vi.pVertexAttributeDescriptions = attrs.data();
+            return vi;
+        }
+
+        // Triangle lists, no culling, dynamic viewport/scissor and a LESS_OR_EQUAL depth test with
+        // writes: the main pass redraws depth pre-pass occluders at exactly the depth they stored.
+        void setFixedFunctionState(PipelineCreateInfo &pci)
+        {
+            VkPipelineInputAssemblyStateCreateInfo ia{};
+            ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+            ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+            ia.primitiveRestartEnable = VK_FALSE;
+            pci.inputAssembly = ia;
+            pci.inputAssemblyProvided = true;
+
+            // Rasterization: no cull (safe for now; honors doubleSided by default)
+            VkPipelineRasterizationStateCreateInfo rs{};
+            rs.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+            rs.depthClampEnable = VK_FALSE;
+            rs.rasterizerDiscardEnable = VK_FALSE;
+            rs.polygonMode = VK_POLYGON_MODE_FILL;
+            rs.lineWidth = 1.0f;
+            rs.cullMode = VK_CULL_MODE_NONE;
+            rs.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+            rs.depthBiasEnable = VK_FALSE;
+            pci.rasterization = rs;
+            pci.rasterizationProvided = true;
+
+            pci.dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+            VkPipelineDepthStencilStateCreateInfo ds{};
+            ds.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+            ds.depthTestEnable = VK_TRUE;
+            ds.depthWriteEnable = VK_TRUE;
+            ds.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+            ds.depthBoundsTestEnable = VK_FALSE;
+            ds.stencilTestEnable = VK_FALSE;
+            pci.depthStencil = ds;
+            pci.depthStencilProvided = true;
+        }
+
+        // Vertex shader specialization constants: constant_id 0 kQuantizedVertices, 1 kSkinned.
+        struct VertexSpec
+        {
+            VkBool32 quantized = VK_FALSE;
+            VkBool32 skinned = VK_FALSE;
+        };
+        const VkSpecializationMapEntry kVertexSpecEntries[2] = {
+            {0, offsetof(VertexSpec, quantized), sizeof(VkBool32)},
+            {1, offsetof(VertexSpec, skinned), sizeof(VkBool32)},
+        };
+
+        VkSpecializationInfo makeVertexSpec(const VertexSpec &data)
+        {
+            VkSpecializationInfo info{};
+            info.mapEntryCount = 2;
+            info.pMapEntries = kVertexSpecEntries;
+            info.dataSize = sizeof(VertexSpec);
+            info.pData = &data;
+            return info;
+        }
+
+        // Fragment shader specialization constant: constant_id 0 kAlphaMode.
+        const VkSpecializationMapEntry kAlphaModeSpecEntry{0, 0, sizeof(int32_t)};
+    }
+
+    std::shared_ptr<SModelRenderer> SModelRenderer::acquire(VulkanContext &ctx, VkRenderPass pass,
+                                                            uint32_t frameCount, bool compactInstances)
+    {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        // Drop entries whose last module went away (e.g. the pass was recreated).
+        reg.entries.erase(std::remove_if(reg.entries.begin(), reg.entries.end(),
+                                         [](const Entry &e)
+                                         { return e.renderer.expired(); }),
+                          reg.entries.end());
+
+        std::shared_ptr<SModelRenderer> renderer;
+        for (const Entry &e : reg.entries)
+        {
+            if (e.device == ctx.GetDevice() && e.pass == pass)
+            {
+                renderer = e.renderer.lock();
+                break;
+            }
+        }
+
+        if (!renderer)
+        {
+            renderer = std::make_shared<SModelRenderer>(ctx, pass, frameCount);
+            reg.entries.push_back({ctx.GetDevice(), pass, renderer});
+        }
+        else if (frameCount > renderer->m_cameraFrames.size())
+        {
+            renderer->createCameraBuffers(frameCount);
+        }
+
+        // Both vertex layouts and both skinning variants: a module's models may mix full and quantized
+        // meshes, skinned characters and static props. Later runs get these from the PipelineCache.
+        for (int quantized = 0; quantized < 2; ++quantized)
+        {
+            for (int skinned = 0; skinned < 2; ++skinned)
+            {
+                Pipelines &pipelines = renderer->m_pipelines[compactInstances ? 1 : 0][quantized][skinned];
+                if (!pipelines.created)
+                    renderer->createPipelines(pipelines, compactInstances, quantized != 0, skinned != 0);
+            }
+        }
+        return renderer;
+    }
+
+    void SModelRenderer::PushConstants::setQuantizationBox(const float aabbMin[3], const float aabbMax[3])
+    {
+        // The cooker snapped min and extent to exact halves, so nothing is lost here.
+        const glm::vec3 mn(aabbMin[0], aabbMin[1], aabbMin[2]);
+        const glm::vec3 extent = glm::vec3(aabbMax[0], aabbMax[1], aabbMax[2]) - mn;
+        quantBox[0] = glm::packHalf2x16(glm::vec2(mn.x, mn.y));
+        quantBox[1] = glm::packHalf2x16(glm::vec2(mn.z, extent.x));
+        quantBox2 = glm::packHalf2x16(glm::vec2(extent.y, extent.z));
+    }
+
+    SModelRenderer::SModelRenderer(VulkanContext &ctx, VkRenderPass pass, uint32_t frameCount)
+        : m_device(ctx.GetDevice()), m_physicalDevice(ctx.GetPhysicalDevice()), m_renderPass(pass)
+    {
+        m_maxBindlessTextures = ctx.GetMaxBindlessTextures();
+        m_bindless = m_maxBindlessTextures > 0 && std::ifstream(kBindlessFragShader, std::ios::binary).is_open();
+        if (m_maxBindlessTextures > 0 && !m_bindless)
+            std::cerr << "[SModelRenderer] " << kBindlessFragShader << " missing, using per-material descriptor sets\n";
+
+        createLayouts();
+        createFallbackTexture(ctx);
+        createCameraBuffers(frameCount > 0 ? frameCount : 1);
+        if (m_bindless)
+            createBindlessResources();
+    }
+
+    SModelRenderer::~SModelRenderer()
+    {
+        destroyDepthPipelines();
+        for (auto &byFormat : m_pipelines)
+        {
+            for (auto &byLayout : byFormat)
+            {
+                for (Pipelines &p : byLayout)
+                {
+                    p.opaque.destroy(m_device);
+                    p.mask.destroy(m_device);
+                    p.blend.destroy(m_device);
+                    p.created = false;
+                }
+            }
+        }
+
+        if (m_pipelineLayout != VK_NULL_HANDLE)
+            vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+
+        for (CameraFrame &cf : m_cameraFrames)
+            DestroyBuffer(m_device, cf.buffer, cf.allocation);
+        m_cameraFrames.clear();
+
+        m_materialSets.clear();
+        for (VkDescriptorPool pool : m_materialPools)
+            vkDestroyDescriptorPool(m_device, pool, nullptr);
+        m_materialPools.clear();
+
+        m_bindlessMaterials.clear();
+        m_bindlessTextures.clear();
+        m_freeTextureSlots.clear();
+        if (m_bindlessPool != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(m_device, m_bindlessPool, nullptr);
+        DestroyBuffer(m_device, m_materialBuffer, m_materialAllocation);
+
+        if (m_fallbackWhiteTexture.isValid())
+            m_fallbackWhiteTexture.destroy(m_device);
+
+        if (m_materialSetLayout != VK_NULL_HANDLE)
+            vkDestroyDescriptorSetLayout(m_device, m_materialSetLayout, nullptr);
+        if (m_frameSetLayout != VK_NULL_HANDLE)
+            vkDestroyDescriptorSetLayout(m_device, m_frameSetLayout, nullptr);
+    }
+
+    void SModelRenderer::createLayouts()
+    {
+        // Set 0: camera UBO (shared), node palette and joint palette SSBOs (per module)
+        VkDescriptorSetLayoutBinding frameBindings[3]{};
+        frameBindings[0].binding = 0;
+        frameBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        frameBindings[0].descriptorCount = 1;
+        frameBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        for (uint32_t b = 1; b < 3; ++b)
+        {
+            frameBindings[b].binding = b;
+            frameBindings[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            frameBindings[b].descriptorCount = 1;
+            frameBindings[b].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo dsl{};
+        dsl.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        dsl.bindingCount = 3;
+        dsl.pBindings = frameBindings;
+        if (vkCreateDescriptorSetLayout(m_device, &dsl, nullptr, &m_frameSetLayout) != VK_SUCCESS)
+            throw std::runtime_error("SModelRenderer: failed to create frame descriptor set layout");
+
+        // Set 1: baseColor combined sampler, or (bindless) every texture plus the material SSBO.
+        VkDescriptorSetLayoutBinding materialBindings[2]{};
+        materialBindings[0].binding = 0;
+        materialBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        materialBindings[0].descriptorCount = m_bindless ? m_maxBindlessTextures : 1;
+        materialBindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        materialBindings[1].binding = 1;
+        materialBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        materialBindings[1].descriptorCount = 1;
+        materialBindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        // Texture slots are written as assets stream in, while earlier frames using the set are in flight.
+        const VkDescriptorBindingFlagsEXT bindingFlags[2] = {
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+                VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT,
+            0};
+        VkDescriptorSetLayoutBindingFlagsCreateInfoEXT flagsInfo{};
+        flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+        flagsInfo.bindingCount = 2;
+        flagsInfo.pBindingFlags = bindingFlags;
+
+        dsl.bindingCount = m_bindless ? 2 : 1;
+        dsl.pBindings = materialBindings;
+        if (m_bindless)
+        {
+            dsl.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+            dsl.pNext = &flagsInfo;
+        }
+        if (vkCreateDescriptorSetLayout(m_device, &dsl, nullptr, &m_materialSetLayout) != VK_SUCCESS)
+            throw std::runtime_error("SModelRenderer: failed to create material descriptor set layout");
+
+        VkPushConstantRange pcRange{};
+        pcRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        pcRange.offset = 0;
+        pcRange.size = sizeof(PushConstants);
+
+        VkPipelineLayoutCreateInfo plInfo{};
+        plInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        VkDescriptorSetLayout setLayouts[2] = {m_frameSetLayout, m_materialSetLayout};
+        plInfo.setLayoutCount = 2;
+        plInfo.pSetLayouts = setLayouts;
+        plInfo.pushConstantRangeCount = 1;
+        plInfo.pPushConstantRanges = &pcRange;
+        if (vkCreatePipelineLayout(m_device, &plInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
+            throw std::runtime_error("SModelRenderer: failed to create pipeline layout");
+    }
+
+    void SModelRenderer::createFallbackTexture(VulkanContext &ctx)
+    {
+        // Fallback 1x1 white texture (sRGB)
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = ctx.GetGraphicsQueueFamilyIndex();
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        VkCommandPool uploadPool = VK_NULL_HANDLE;
+        if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &uploadPool) != VK_SUCCESS)
+            throw std::runtime_error("SModelRenderer: failed to create upload command pool");
+
+        UploadContext upload{};
+        bool ok = BeginUploadContext(upload, m_device, m_physicalDevice, uploadPool, ctx.GetGraphicsQueue());
+        if (ok)
+        {
+            const uint8_t white[4] = {255, 255, 255, 255};
+            ok = m_fallbackWhiteTexture.uploadRGBA8_Deferred(
+                     upload,
+                     white,
+                     1,
+                     1,
+                     true,
+                     VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                     VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                     VK_FILTER_LINEAR,
+                     VK_FILTER_LINEAR,
+                     VK_SAMPLER_MIPMAP_MODE_NEAREST,
+                     1.0f) &&
+                 EndSubmitAndWait(upload);
+        }
+        vkDestroyCommandPool(m_device, uploadPool, nullptr);
+
+        if (!ok)
+            throw std::runtime_error("SModelRenderer: failed to upload fallback texture");
+    }
+
+    void SModelRenderer::createCameraBuffers(uint32_t frameCount)
+    {
+        // Only grows; existing buffers may be referenced by module descriptor sets.
+        while (m_cameraFrames.size() < frameCount)
+        {
+            CameraFrame cf{};
+            if (GpuAllocator::forDevice(m_device, m_physicalDevice)
+                    .createBuffer(sizeof(CameraUBO), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                  GpuMemoryCategory::Dynamic, cf.buffer, cf.allocation) != VK_SUCCESS)
+                throw std::runtime_error("SModelRenderer: failed to create camera buffer");
+            m_cameraFrames.push_back(cf);
+        }
+    }
+
+    void SModelRenderer::createPipelines(Pipelines &out, bool compactInstances, bool quantizedVertices, bool skinned)
+    {
+        PipelineCreateInfo pci{};
+        pci.device = m_device;
+        pci.renderPass = m_renderPass;
+        pci.subpass = 0;
+        pci.pipelineLayout = m_pipelineLayout;
+
+        // Load shader modules
+        VkShaderModule vert = Pipeline::createShaderModuleFromFile(pci.device, compactInstances ? "shaders/smodel_compact.vert.spv" : "shaders/smodel.vert.spv");
+        VkShaderModule frag = Pipeline::createShaderModuleFromFile(pci.device, m_bindless ? kBindlessFragShader : "shaders/smodel.frag.spv");
+        if (vert == VK_NULL_HANDLE || frag == VK_NULL_HANDLE)
+        {
+            if (vert != VK_NULL_HANDLE)
+                vkDestroyShaderModule(pci.device, vert, nullptr);
+            if (frag != VK_NULL_HANDLE)
+                vkDestroyShaderModule(pci.device, frag, nullptr);
+            throw std::runtime_error("SModelRenderer: failed to load shader modules (smodel.vert/frag.spv)");
+        }
+
+        VertexSpec vertSpecData;
+        vertSpecData.quantized = quantizedVertices ? VK_TRUE : VK_FALSE;
+        vertSpecData.skinned = skinned ? VK_TRUE : VK_FALSE;
+        const VkSpecializationInfo vertSpec = makeVertexSpec(vertSpecData);
+
+        VkPipelineShaderStageCreateInfo vs{};
+        vs.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        vs.stage = VK_SHADER_STAGE_VERTEX_BIT;
+        vs.module = vert;
+        vs.pName = "main";
+        vs.pSpecializationInfo = &vertSpec;
+
+        VkPipelineShaderStageCreateInfo fs{};
+        fs.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        fs.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        fs.module = frag;
+        fs.pName = "main";
+
+        pci.shaderStages = {vs, fs};
+
+        // Fragment specialization per pipeline: kAlphaMode = 0 / 1 / 2
+        const int32_t alphaModes[3] = {0, 1, 2};
+        VkSpecializationInfo fragSpecs[3]{};
+        for (int i = 0; i < 3; ++i)
+        {
+            fragSpecs[i].mapEntryCount = 1;
+            fragSpecs[i].pMapEntries = &kAlphaModeSpecEntry;
+            fragSpecs[i].dataSize = sizeof(int32_t);
+            fragSpecs[i].pData = &alphaModes[i];
+        }
+
+        VertexLayout vertexLayout;
+        pci.vertexInput = makeVertexInput(compactInstances, quantizedVertices, vertexLayout);
+        pci.vertexInputProvided = true;
+        setFixedFunctionState(pci);
+
+        // Pipelines: OPAQUE / MASK / BLEND (mask currently uses same state as opaque)
+        VkPipelineColorBlendAttachmentState attOpaque{};
+        pci.colorBlend = makeBlendState(false, attOpaque);
+        pci.colorBlendProvided = true;
+        pci.shaderStages[1].pSpecializationInfo = &fragSpecs[0];
+        VkResult r0 = out.opaque.create(pci);
+
+        VkPipelineColorBlendAttachmentState attMask{};
+        pci.colorBlend = makeBlendState(false, attMask);
+        pci.shaderStages[1].pSpecializationInfo = &fragSpecs[1];
+        VkResult r1 = out.mask.create(pci);
+
+        VkPipelineColorBlendAttachmentState attBlend{};
+        pci.colorBlend = makeBlendState(true, attBlend);
+        pci.shaderStages[1].pSpecializationInfo = &fragSpecs[2];
+
+        // Transparent: test depth but don't write
+        pci.depthStencil.depthWriteEnable = VK_FALSE;
+        VkResult r2 = out.blend.create(pci);
+
+        // Cleanup shader modules
+        vkDestroyShaderModule(pci.device, vert, nullptr);
+        vkDestroyShaderModule(pci.device, frag, nullptr);
+
+        if (r0 != VK_SUCCESS || r1 != VK_SUCCESS || r2 != VK_SUCCESS)
+        {
+            out.opaque.destroy(m_device);
+            out.mask.destroy(m_device);
+            out.blend.destroy(m_device);
+            throw std::runtime_error("SModelRenderer: failed to create one or more pipelines");
+        }
+        out.created = true;
+    }
+
+    const Pipeline &SModelRenderer::pipeline(bool compactInstances, bool quantizedVertices, bool skinned, uint32_t alphaMode) const
+    {
+        const Pipelines &p = m_pipelines[compactInstances ? 1 : 0][quantizedVertices ? 1 : 0][skinned ? 1 : 0];
+        if (alphaMode == 0)
+            return p.opaque;
+        return (alphaMode == 1) ? p.mask : p.blend;
+    }
+
+    const Pipeline *SModelRenderer::depthPipeline(bool compactInstances, bool quantizedVertices, bool skinned, VkRenderPass depthPass)
+    {
+        // A new pass means the renderer recreated its depth targets, with the device idle.
+        if (depthPass != m_depthPass)
+        {
+            destroyDepthPipelines();
+            m_depthPass = depthPass;
+        }
+
+        DepthPipeline &out = m_depthPipelines[compactInstances ? 1 : 0][quantizedVertices ? 1 : 0][skinned ? 1 : 0];
+        if (out.attempted)
+            return out.pipeline.getVkPipeline() != VK_NULL_HANDLE ? &out.pipeline : nullptr;
+        out.attempted = true;
+
+        PipelineCreateInfo pci{};
+        pci.device = m_device;
+        pci.renderPass = depthPass;
+        pci.subpass = 0;
+        pci.pipelineLayout = m_pipelineLayout;
+
+        VkShaderModule vert = Pipeline::createShaderModuleFromFile(pci.device, compactInstances ? "shaders/smodel_compact.vert.spv" : "shaders/smodel.vert.spv");
+        if (vert == VK_NULL_HANDLE)
+        {
+            std::cerr << "[SModelRenderer] failed to load the vertex shader, no depth pre-pass draws\n";
+            return nullptr;
+        }
+
+        VertexSpec vertSpecData;
+        vertSpecData.quantized = quantizedVertices ? VK_TRUE : VK_FALSE;
+        vertSpecData.skinned = skinned ? VK_TRUE : VK_FALSE;
+        const VkSpecializationInfo vertSpec = makeVertexSpec(vertSpecData);
+
+        // Vertex stage only: OPAQUE depth needs no fragment shader.
+        VkPipelineShaderStageCreateInfo vs{};
+        vs.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        vs.stage = VK_SHADER_STAGE_VERTEX_BIT;
+        vs.module = vert;
+        vs.pName = "main";
+        vs.pSpecializationInfo = &vertSpec;
+        pci.shaderStages = {vs};
+
+        VertexLayout vertexLayout;
+        pci.vertexInput = makeVertexInput(compactInstances, quantizedVertices, vertexLayout);
+        pci.vertexInputProvided = true;
+        setFixedFunctionState(pci);
+
+        // No color attachments
+        VkPipelineColorBlendStateCreateInfo cb{};
+        cb.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        cb.attachmentCount = 0;
+        pci.colorBlend = cb;
+        pci.colorBlendProvided = true;
+
+        const VkResult r = out.pipeline.create(pci);
+        vkDestroyShaderModule(pci.device, vert, nullptr);
+        if (r != VK_SUCCESS)
+        {
+            std::cerr << "[SModelRenderer] failed to create a depth pre-pass pipeline (" << r << ")\n";
+            out.pipeline.destroy(m_device);
+            return nullptr;
+        }
+        return &out.pipeline;
+    }
+
+    void SModelRenderer::destroyDepthPipelines()
+    {
+        for (auto &byFormat : m_depthPipelines)
+        {
+            for (auto &byLayout : byFormat)
+            {
+                for (DepthPipeline &p : byLayout)
+                {
+                    p.pipeline.destroy(m_device);
+                    p.attempted = false;
+                }
+            }
+        }
+        m_depthPass = VK_NULL_HANDLE;
+    }
+
+    void SModelRenderer::attach(const SModelRenderPassModule *module)
+    {
+        if (std::find(m_modules.begin(), m_modules.end(), module) == m_modules.end())
+            m_modules.push_back(module);
+    }
+
+    void SModelRenderer::detach(const SModelRenderPassModule *module)
+    {
+        m_modules.erase(std::remove(m_modules.begin(), m_modules.end(), module), m_modules.end());
+    }
+
+    void SModelRenderer::setCamera(const glm::mat4 &view, const glm::mat4 &proj)
+    {
+        m_camera.view = view;
+        m_camera.proj = proj;
+        m_cameraWrittenFrame = UINT32_MAX;
+    }
+
+    void SModelRenderer::writeCamera(uint32_t frameIndex)
+    {
+        if (m_cameraWrittenFrame == frameIndex || m_cameraFrames.empty())
+            return;
+        CameraFrame &cf = m_cameraFrames[frameIndex % static_cast<uint32_t>(m_cameraFrames.size())];
+        if (cf.allocation.mapped)
+            std::memcpy(cf.allocation.mapped, &m_camera, sizeof(CameraUBO));
+        m_cameraWrittenFrame = frameIndex;
+    }
+
+    void SModelRenderer::beginPrePass(uint32_t frameIndex, const SModelRenderPassModule *module)
+    {
+        if (m_modules.empty() || m_modules.front() != module)
+            return;
+
+        m_draws.clear();
+        ++m_frameSerial;
+        writeCamera(frameIndex);
+        m_cameraWrittenFrame = UINT32_MAX; // the next frame writes again
+    }
+
+    void SModelRenderer::sortDraws()
+    {
+        if (m_drawsSorted)
+            return;
+
+        // OPAQUE, MASK, BLEND like glTF. Opaque and mask group by pipeline, material, mesh and module;
+        // blend goes far to near (more negative view z first), stable within a module.
+        std::stable_sort(m_draws.begin(), m_draws.end(),
+                         [](const DrawItem &a, const DrawItem &b)
+                         {
+                             if (a.alphaMode != b.alphaMode)
+                                 return a.alphaMode < b.alphaMode;
+                             if (a.alphaMode == 2)
+                                 return a.viewDepth < b.viewDepth;
+                             if (a.compactInstances != b.compactInstances)
+                                 return a.compactInstances < b.compactInstances;
+                             if (a.quantizedVertices != b.quantizedVertices)
+                                 return a.quantizedVertices < b.quantizedVertices;
+                             if (a.skinned != b.skinned)
+                                 return a.skinned < b.skinned;
+                             if (a.material != b.material)
+                                 return a.material < b.material;
+                             if (a.vertexBuffer != b.vertexBuffer)
+                                 return a.vertexBuffer < b.vertexBuffer;
+                             if (a.indexType != b.indexType)
+                                 return a.indexType < b.indexType;
+                             return a.frameSet < b.frameSet;
+                         });
+        m_drawsSorted = true;
+    }
+
+    void SModelRenderer::recordDraw(VkCommandBuffer cmd, const DrawItem &d, const Pipeline &pipe, bool bindMaterial, BoundState &bound)
+    {
+        if (&pipe != bound.pipeline)
+        {
+            pipe.bind(cmd);
+            bound.pipeline = &pipe;
+        }
+
+        if (d.frameSet != VK_NULL_HANDLE && d.frameSet != bound.frameSet)
+        {
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &d.frameSet, 0, nullptr);
+            bound.frameSet = d.frameSet;
+        }
+        if (bindMaterial && d.materialSet != VK_NULL_HANDLE && d.materialSet != bound.materialSet)
+        {
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 1, 1, &d.materialSet, 0, nullptr);
+            bound.materialSet = d.materialSet;
+        }
+
+        if (d.instanceBuffer != VK_NULL_HANDLE && d.instanceBuffer != bound.instances)
+        {
+            VkDeviceSize instOffset = 0;
+            vkCmdBindVertexBuffers(cmd, 1, 1, &d.instanceBuffer, &instOffset);
+            bound.instances = d.instanceBuffer;
+        }
+        if (d.vertexBuffer != bound.vertices)
+        {
+            VkDeviceSize vbOffset = 0;
+            vkCmdBindVertexBuffers(cmd, 0, 1, &d.vertexBuffer, &vbOffset);
+            bound.vertices = d.vertexBuffer;
+        }
+        // Pooled meshes of both index types share one buffer
+        if (d.indexBuffer != bound.indices || d.indexType != bound.indexType)
+        {
+            vkCmdBindIndexBuffer(cmd, d.indexBuffer, 0, d.indexType);
+            bound.indices = d.indexBuffer;
+            bound.indexType = d.indexType;
+        }
+
+        vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstants), &d.pc);
+
+        if (d.indirectBuffer != VK_NULL_HANDLE)
+            vkCmdDrawIndexedIndirect(cmd, d.indirectBuffer, d.indirectOffset, 1, sizeof(VkDrawIndexedIndirectCommand));
+        else
+            vkCmdDrawIndexed(cmd, d.indexCount, d.instanceCount, d.firstIndex, d.vertexOffset, d.firstInstance);
+        DrawCallCounter::increment();
+    }
+
+    void SModelRenderer::recordDepthDraws(VkCommandBuffer cmd, const SModelRenderPassModule *module, VkExtent2D extent, VkRenderPass depthPass)
+    {
+        if (m_modules.empty() || m_modules.front() != module || m_draws.empty() || depthPass == VK_NULL_HANDLE)
+            return;
+        if (extent.width == 0 || extent.height == 0)
+            return;
+
+        sortDraws();
+
+        VkViewport vp{0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f};
+        VkRect2D sc{{0, 0}, {extent.width, extent.height}};
+        vkCmdSetViewport(cmd, 0, 1, &vp);
+        vkCmdSetScissor(cmd, 0, 1, &sc);
+
+        BoundState bound;
+        for (const DrawItem &d : m_draws)
+        {
+            if (!d.depthPrePass || d.alphaMode != 0)
+                continue;
+            if (const Pipeline *pipe = depthPipeline(d.compactInstances, d.quantizedVertices, d.skinned, depthPass))
+                recordDraw(cmd, d, *pipe, false, bound);
+        }
+    }
+
+    void SModelRenderer::recordDraws(VkCommandBuffer cmd, const SModelRenderPassModule *module, VkExtent2D extent)
+    {
+        if (m_modules.empty() || m_modules.front() != module || m_draws.empty())
+            return;
+        if (extent.width == 0 || extent.height == 0)
+            return;
+
+        sortDraws();
+
+        VkViewport vp{0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f};
+        VkRect2D sc{{0, 0}, {extent.width, extent.height}};
+        vkCmdSetViewport(cmd, 0, 1, &vp);
+        vkCmdSetScissor(cmd, 0, 1, &sc);
+
+        BoundState bound;
+        for (const DrawItem &d : m_draws)
+            recordDraw(cmd, d, pipeline(d.compactInstances, d.quantizedVertices, d.skinned, d.alphaMode), true, bound);
+    }
+
+    VkBuffer SModelRenderer::cameraBuffer(uint32_t frameIndex) const
+    {
+        if (m_cameraFrames.empty())
+            return VK_NULL_HANDLE;
+        return m_cameraFrames[frameIndex % static_cast<uint32_t>(m_cameraFrames.size())].buffer;
+    }
+
+    bool SModelRenderer::growMaterialPool()
+    {
+        constexpr uint32_t kSetsPerPool = 64;
+
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSize.descriptorCount = kSetsPerPool;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = kSetsPerPool;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        if (vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+            return false;
+        m_materialPools.push_back(pool);
+        return true;
+    }
+
+    SModelRenderer::MaterialBinding SModelRenderer::material(AssetManager &assets, MaterialHandle h, const MaterialAsset &mat)
+    {
+        if (!h.isValid())
+            return {};
+
+        std::lock_guard<std::mutex> lock(m_materialMutex);
+        if (m_bindless)
+            return bindlessMaterial(assets, h, mat);
+        return {legacyMaterialSet(assets, h, mat), 0};
+    }
+
+    VkDescriptorSet SModelRenderer::legacyMaterialSet(AssetManager &assets, MaterialHandle h, const MaterialAsset &mat)
+    {
+        // A replaced texture image (streamed in, other mip levels resident) gets a new set: frames in
+        // flight still use the old one, which stays allocated until its pool is destroyed.
+        const uint32_t textureVersion = mat.baseColorTexture.isValid() ? assets.textureVersion(mat.baseColorTexture) : 0;
+        auto it = m_materialSets.find(h.id);
+        if (it != m_materialSets.end() && it->second.textureVersion == textureVersion)
+            return it->second.set;
+
+        VkDescriptorSetAllocateInfo alloc{};
+        alloc.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc.descriptorSetCount = 1;
+        alloc.pSetLayouts = &m_materialSetLayout;
+
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        alloc.descriptorPool = m_materialPools.empty() ? VK_NULL_HANDLE : m_materialPools.back();
+        if (alloc.descriptorPool == VK_NULL_HANDLE || vkAllocateDescriptorSets(m_device, &alloc, &set) != VK_SUCCESS)
+        {
+            // Current pool exhausted (or none yet): start a new one.
+            if (!growMaterialPool())
+                return VK_NULL_HANDLE;
+            alloc.descriptorPool = m_materialPools.back();
+            if (vkAllocateDescriptorSets(m_device, &alloc, &set) != VK_SUCCESS)
+                return VK_NULL_HANDLE;
+        }
+
+        VkImageView view = m_fallbackWhiteTexture.getView();
+        VkSampler sampler = m_fallbackWhiteTexture.getSampler();
+
+        if (mat.baseColorTexture.isValid())
+        {
+            if (TextureAsset *tex = assets.getTexture(mat.baseColorTexture))
+            {
+                if (tex->getView() != VK_NULL_HANDLE && tex->getSampler() != VK_NULL_HANDLE)
+                {
+                    view = tex->getView();
+                    sampler = tex->getSampler();
+                }
+            }
+        }
+
+        VkDescriptorImageInfo di{};
+        di.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        di.imageView = view;
+        di.sampler = sampler;
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = set;
+        write.dstBinding = 0;
+        write.dstArrayElement = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.descriptorCount = 1;
+        write.pImageInfo = &di;
+        vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+
+        m_materialSets[h.id] = MaterialSet{set, textureVersion};
+        return set;
+    }
+
+    void SModelRenderer::createBindlessResources()
+    {
+        m_maxBindlessMaterials = kMaxBindlessMaterials;
+
+        VkDescriptorPoolSize poolSizes[2]{};
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSizes[0].descriptorCount = m_maxBindlessTextures;
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSizes[1].descriptorCount = 1;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+        poolInfo.maxSets = 1;
+        poolInfo.poolSizeCount = 2;
+        poolInfo.pPoolSizes = poolSizes;
+        if (vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_bindlessPool) != VK_SUCCESS)
+            throw std::runtime_error("SModelRenderer: failed to create bindless descriptor pool");
+
+        VkDescriptorSetAllocateInfo alloc{};
+        alloc.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc.descriptorPool = m_bindlessPool;
+        alloc.descriptorSetCount = 1;
+        alloc.pSetLayouts = &m_materialSetLayout;
+        if (vkAllocateDescriptorSets(m_device, &alloc, &m_bindlessSet) != VK_SUCCESS)
+            throw std::runtime_error("SModelRenderer: failed to allocate bindless descriptor set");
+
+        // Host-visible so new materials are a memcpy; entries in use by in-flight frames are never moved.
+        const VkDeviceSize bytes = sizeof(GpuMaterial) * static_cast<VkDeviceSize>(m_maxBindlessMaterials);
+        if (GpuAllocator::forDevice(m_device, m_physicalDevice)
+                .createBuffer(bytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                              GpuMemoryCategory::Dynamic, m_materialBuffer, m_materialAllocation) != VK_SUCCESS ||
+            !m_materialAllocation.mapped)
+            throw std::runtime_error("SModelRenderer: failed to create bindless material buffer");
+
+        VkDescriptorBufferInfo bi{};
+        bi.buffer = m_materialBuffer;
+        bi.offset = 0;
+        bi.range = bytes;
+
+        // Slot 0: white fallback texture, material 0: white opaque.
+        VkDescriptorImageInfo di{};
+        di.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        di.imageView = m_fallbackWhiteTexture.getView();
+        di.sampler = m_fallbackWhiteTexture.getSampler();
+
+        VkWriteDescriptorSet writes[2]{};
+        writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[0].dstSet = m_bindlessSet;
+        writes[0].dstBinding = 0;
+        writes[0].dstArrayElement = 0;
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[0].descriptorCount = 1;
+        writes[0].pImageInfo = &di;
+        writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[1].dstSet = m_bindlessSet;
+        writes[1].dstBinding = 1;
+        writes[1].dstArrayElement = 0;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[1].descriptorCount = 1;
+        writes[1].pBufferInfo = &bi;
+        vkUpdateDescriptorSets(m_device, 2, writes, 0, nullptr);
+        m_bindlessTextureCount = 1;
+
+        GpuMaterial white{};
+        white.baseColorFactor[0] = white.baseColorFactor[1] = white.baseColorFactor[2] = white.baseColorFactor[3] = 1.0f;
+        white.alphaCutoff = 0.5f;
+        std::memcpy(m_materialAllocation.mapped, &white, sizeof(white));
+        m_bindlessMaterials.reserve(256);
+        m_bindlessMaterials.emplace(0, BindlessEntry{0, true}); // handle id 0 is never valid
+    }
+
+    uint32_t SModelRenderer::bindlessTextureSlot(TextureHandle h, const TextureAsset &tex, uint32_t version)
+    {
+        auto it = m_bindlessTextures.find(h.id);
+        if (it != m_bindlessTextures.end())
+        {
+            if (it->second.version == version)
+                return it->second.slot;
+            // Replaced image: frames in flight may still sample the old slot, so it is only reused
+            // once they have completed.
+            m_freeTextureSlots.push_back({it->second.slot, m_frameSerial});
+            m_bindlessTextures.erase(it);
+        }
+
+        uint32_t slot = 0;
+        const uint32_t framesInFlight = static_cast<uint32_t>(m_cameraFrames.size());
+        if (!m_freeTextureSlots.empty() && m_frameSerial - m_freeTextureSlots.front().frame > framesInFlight)
+        {
+            slot = m_freeTextureSlots.front().slot;
+            m_freeTextureSlots.pop_front();
+        }
+        else if (m_bindlessTextureCount < m_maxBindlessTextures)
+        {
+            slot = m_bindlessTextureCount++;
+        }
+        else
+        {
+            if (!m_bindlessFullWarned)
+                std::cerr << "[SModelRenderer] bindless texture array full (" << m_maxBindlessTextures
+                          << "), further textures draw white\n";
+            m_bindlessFullWarned = true;
+            return 0;
+        }
+
+        VkDescriptorImageInfo di{};
+        di.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        di.imageView = tex.getView();
+        di.sampler = tex.getSampler();
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_bindlessSet;
+        write.dstBinding = 0;
+        write.dstArrayElement = slot;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.descriptorCount = 1;
+        write.pImageInfo = &di;
+        vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+
+        m_bindlessTextures.emplace(h.id, BindlessTexture{slot, version});
+        return slot;
+    }
+
+    SModelRenderer::MaterialBinding SModelRenderer::bindlessMaterial(AssetManager &assets, MaterialHandle h, const MaterialAsset &mat)
+    {
+        // A replaced texture image needs a new slot and the material entry rewritten.
+        const uint32_t textureVersion = mat.baseColorTexture.isValid() ? assets.textureVersion(mat.baseColorTexture) : 0;
+        auto it = m_bindlessMaterials.find(h.id);
+        if (it != m_bindlessMaterials.end() && it->second.final && it->second.textureVersion == textureVersion)
+            return {m_bindlessSet, it->second.index};
+
+        uint32_t index = 0;
+        if (it != m_bindlessMaterials.end())
+        {
+            index = it->second.index;
+        }
+        else
+        {
+            if (m_bindlessMaterials.size() >= m_maxBindlessMaterials)
+            {
+                if (!m_bindlessFullWarned)
+                    std::cerr << "[SModelRenderer] bindless material table full (" << m_maxBindlessMaterials
+                              << "), further materials draw white\n";
+                m_bindlessFullWarned = true;
+                return {m_bindlessSet, 0};
+            }
+            index = static_cast<uint32_t>(m_bindlessMaterials.size());
+            it = m_bindlessMaterials.emplace(h.id, BindlessEntry{index, false}).first;
+        }
+
+        // Until a streamed texture is resident the material samples the white fallback.
+        uint32_t textureSlot = 0;
+        bool final = true;
+        if (mat.baseColorTexture.isValid())
+        {
+            TextureAsset *tex = assets.getTexture(mat.baseColorTexture);
+            if (tex && tex->getView() != VK_NULL_HANDLE && tex->getSampler() != VK_NULL_HANDLE)
+                textureSlot = bindlessTextureSlot(mat.baseColorTexture, *tex, textureVersion);
+            else
+                final = false;
+        }
+
+        GpuMaterial gm{};
+        std::memcpy(gm.baseColorFactor, mat.baseColorFactor, sizeof(gm.baseColorFactor));
+        gm.alphaCutoff = mat.alphaCutoff;
+        gm.alphaMode = mat.alphaMode;
+        gm.textureIndex = textureSlot;
+        std::memcpy(static_cast<GpuMaterial *>(m_materialAllocation.mapped) + index, &gm, sizeof(gm));
+
+        it->second.final = final;
+        it->second.textureVersion = textureVersion;
+        return {m_bindlessSet, index};
+    }
+}
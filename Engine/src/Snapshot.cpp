@@ -0,0 +1,614 @@
+#include "ECS/Snapshot.h"
+
+#include "utils/MappedFile.h"
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+
+namespace Engine::ECS
+{
+    namespace
+    {
+        // ------------------------------------------------------------
+        // File layout (native byte order, every section 8-byte aligned)
+        // ------------------------------------------------------------
+        //   FileHeader
+        //   component table: componentCount x { uint32 nameLength, uint32 elementSize (0 = tag), name }
+        //   entities:        uint32 generations[entityCapacity], EntityRecord records[entityCapacity],
+        //                    uint32 freeList[freeCount]   (empty in entity subsets)
+        //   stores:          storeCount x { StoreHeader, ComponentMask signature, Entity entities[rows],
+        //                                   ComponentMask rowMasks[rows],
+        //                                   columnCount x { ColumnHeader, bytes } }
+
+        constexpr char kMagic[8] = {'S', 'T', 'R', 'S', 'N', 'A', 'P', '\0'};
+        constexpr uint32_t kByteOrder = 0x01020304u;
+        constexpr uint32_t kFlagEntitySubset = 1u; // FileHeader::flags: listed entities only, no entity table
+
+        struct FileHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t byteOrder;
+            uint32_t maskWords;
+            uint32_t componentCount;
+            uint32_t storeCount;
+            uint32_t entityCapacity;
+            uint32_t freeCount;
+            uint32_t flags;
+            uint64_t totalBytes;
+        };
+
+        struct StoreHeader
+        {
+            uint32_t archetypeId;
+            uint32_t rows;
+            uint32_t columnCount;
+            uint32_t reserved;
+        };
+
+        struct ColumnHeader
+        {
+            uint32_t componentId;
+            uint32_t elementSize;
+            uint64_t bytes;
+        };
+
+        static_assert(std::is_trivially_copyable_v<ComponentMask>, "row masks are written as raw blocks");
+        static_assert(std::is_trivially_copyable_v<Entity> && std::is_trivially_copyable_v<EntityRecord>,
+                      "entity tables are written as raw blocks");
+
+        class Writer
+        {
+        public:
+            explicit Writer(std::vector<uint8_t> &out) : m_out(out) {}
+
+            void bytes(const void *data, size_t size)
+            {
+                if (size == 0)
+                    return;
+                const size_t at = m_out.size();
+                m_out.resize(at + size);
+                std::memcpy(m_out.data() + at, data, size);
+            }
+
+            template <typename T>
+            void pod(const T &value) { bytes(&value, sizeof(T)); }
+
+            void align() { m_out.resize((m_out.size() + 7) & ~size_t(7), 0); }
+
+        private:
+            std::vector<uint8_t> &m_out;
+        };
+
+        class Reader
+        {
+        public:
+            Reader(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+
+            // Pointer to the next 'size' bytes, or nullptr past the end.
+            const uint8_t *take(size_t size)
+            {
+                if (size > m_size - m_pos)
+                    return nullptr;
+                const uint8_t *p = m_data + m_pos;
+                m_pos += size;
+                return p;
+            }
+
+            template <typename T>
+            bool pod(T &value)
+            {
+                const uint8_t *p = take(sizeof(T));
+                if (p)
+                    std::memcpy(&value, p, sizeof(T));
+                return p != nullptr;
+            }
+
+            bool align()
+            {
+                const size_t aligned = (m_pos + 7) & ~size_t(7);
+                if (aligned > m_size)
+                    return false;
+                m_pos = aligned;
+                return true;
+            }
+
+        private:
+            const uint8_t *m_data;
+            size_t m_size;
+            size_t m_pos = 0;
+        };
+
+        struct StoreView
+        {
+            StoreHeader header{};
+            ComponentMask signature;
+            const Entity *entities = nullptr;
+            const ComponentMask *rowMasks = nullptr;
+            std::vector<std::pair<ColumnHeader, const uint8_t *>> columns;
+        };
+
+        ComponentMask remapMask(const ComponentMask &saved, const std::vector<uint32_t> &idMap)
+        {
+            ComponentMask m;
+            for (uint32_t id = 0; id < static_cast<uint32_t>(idMap.size()); ++id)
+            {
+                if (saved.has(id))
+                    m.set(idMap[id]);
+            }
+            return m;
+        }
+
+        bool fail(std::string &outError, const std::string &message)
+        {
+            outError = "ECS snapshot: " + message;
+            return false;
+        }
+
+        bool checkTrivialColumns(const ComponentRegistry &registry, const ArchetypeStore &store, std::string &outError)
+        {
+            bool ok = true;
+            store.forEachColumnData([&](uint32_t componentId, const ComponentTypeInfo &type, const void *)
+                                    {
+                                        if (!type.trivial && ok)
+                                        {
+                                            ok = false;
+                                            fail(outError, "component '" + registry.getName(componentId) + "' is not trivially copyable");
+                                        } });
+            return ok;
+        }
+
+        void writeHeaderAndComponents(Writer &w, const ComponentRegistry &registry, FileHeader header)
+        {
+            std::memcpy(header.magic, kMagic, sizeof(kMagic));
+            header.version = SnapshotVersion;
+            header.byteOrder = kByteOrder;
+            header.maskWords = static_cast<uint32_t>(ComponentMask::WordCount);
+            header.componentCount = registry.count();
+            w.pod(header);
+
+            for (uint32_t id = 0; id < registry.count(); ++id)
+            {
+                const std::string &name = registry.getName(id);
+                const ComponentTypeInfo *type = registry.typeInfo(id);
+                w.pod(static_cast<uint32_t>(name.size()));
+                w.pod(type ? type->size : 0u);
+                w.bytes(name.data(), name.size());
+                w.align();
+            }
+        }
+
+        // One store section: every row, or only 'rows' (in that order) when given.
+        void writeStore(Writer &w, uint32_t archetypeId, const ArchetypeStore &store, const std::vector<uint32_t> *rows)
+        {
+            uint32_t columnCount = 0;
+            store.forEachColumnData([&](uint32_t, const ComponentTypeInfo &, const void *)
+                                    { ++columnCount; });
+
+            const uint32_t count = rows ? static_cast<uint32_t>(rows->size()) : store.size();
+            w.pod(StoreHeader{archetypeId, count, columnCount, 0});
+            w.pod(store.signature());
+            if (!rows)
+            {
+                w.bytes(store.entities().data(), count * sizeof(Entity));
+                w.align();
+                w.bytes(store.rowMasks().data(), count * sizeof(ComponentMask));
+            }
+            else
+            {
+                for (uint32_t row : *rows)
+                    w.pod(store.entities()[row]);
+                w.align();
+                for (uint32_t row : *rows)
+                    w.pod(store.rowMasks()[row]);
+            }
+
+            store.forEachColumnData([&](uint32_t componentId, const ComponentTypeInfo &type, const void *data)
+                                    {
+                                        const uint64_t bytes = static_cast<uint64_t>(type.size) * count;
+                                        w.pod(ColumnHeader{componentId, type.size, bytes});
+                                        if (!rows)
+                                        {
+                                            w.bytes(data, static_cast<size_t>(bytes));
+                                        }
+                                        else
+                                        {
+                                            const uint8_t *base = static_cast<const uint8_t *>(data);
+                                            for (uint32_t row : *rows)
+                                                w.bytes(base + static_cast<size_t>(row) * type.size, type.size);
+                                        }
+                                        w.align(); });
+        }
+
+        void finish(std::vector<uint8_t> &out)
+        {
+            const uint64_t total = out.size();
+            std::memcpy(out.data() + offsetof(FileHeader, totalBytes), &total, sizeof(total));
+        }
+
+        // A validated file: component id map and store sections pointing into the caller's bytes.
+        struct Parsed
+        {
+            FileHeader header{};
+            std::vector<uint32_t> idMap; // saved component id -> id in this registry (matched by name)
+            std::vector<uint32_t> elementSizes; // saved component id -> component table element size (0 = tag)
+            bool identity = true;        // idMap[id] == id for every id
+            std::vector<uint32_t> generations;
+            std::vector<EntityRecord> records;
+            std::vector<uint32_t> freeList;
+            std::vector<StoreView> views;
+
+            ComponentMask mask(const ComponentMask &saved) const { return identity ? saved : remapMask(saved, idMap); }
+        };
+
+        bool parse(ECSContext &ecs, const uint8_t *data, size_t size, bool subset, Parsed &p, std::string &outError)
+        {
+            Reader r(data, size);
+
+            FileHeader &header = p.header;
+            if (!r.pod(header) || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0)
+                return fail(outError, "not a snapshot file");
+            if (header.version != SnapshotVersion)
+                return fail(outError, "version " + std::to_string(header.version) + " (expected " + std::to_string(SnapshotVersion) + ")");
+            if (header.byteOrder != kByteOrder)
+                return fail(outError, "written with another byte order");
+            if (header.maskWords != ComponentMask::WordCount)
+                return fail(outError, "written with ENGINE_ECS_MAX_COMPONENTS=" + std::to_string(header.maskWords * 64));
+            if (header.totalBytes != size)
+                return fail(outError, "truncated (" + std::to_string(size) + " of " + std::to_string(header.totalBytes) + " bytes)");
+            if (((header.flags & kFlagEntitySubset) != 0) != subset)
+                return fail(outError, subset ? "a whole world, not an entity subset" : "an entity subset, not a whole world");
+
+            // Counts size allocations below: bound them by the bytes they need (8+ per component table
+            // entry, 12+ per entity slot, 4 per free index, 16+ per store) before trusting them.
+            if (header.componentCount > size / 8 || header.entityCapacity > size / 12 || header.freeCount > size / 4 ||
+                header.storeCount > size / 16)
+                return fail(outError, "counts exceed the file size");
+
+            p.idMap.resize(header.componentCount);
+            p.elementSizes.resize(header.componentCount);
+            for (uint32_t id = 0; id < header.componentCount; ++id)
+            {
+                uint32_t nameLength = 0, elementSize = 0;
+                if (!r.pod(nameLength) || !r.pod(elementSize))
+                    return fail(outError, "truncated component table");
+                const uint8_t *name = r.take(nameLength);
+                if (!name || !r.align())
+                    return fail(outError, "truncated component table");
+
+                const std::string componentName(reinterpret_cast<const char *>(name), nameLength);
+                try
+                {
+                    p.idMap[id] = ecs.components.ensureId(componentName);
+                }
+                catch (const std::exception &e)
+                {
+                    return fail(outError, e.what());
+                }
+                if (elementSize != 0)
+                {
+                    const ComponentTypeInfo *type = ecs.components.typeInfo(p.idMap[id]);
+                    if (!type || type->size != elementSize || !type->trivial)
+                        return fail(outError, "component '" + componentName + "' is not registered with the saved layout");
+                }
+                p.elementSizes[id] = elementSize;
+                p.identity = p.identity && p.idMap[id] == id;
+            }
+
+            p.generations.resize(header.entityCapacity);
+            p.records.resize(header.entityCapacity);
+            p.freeList.resize(header.freeCount);
+            {
+                const uint8_t *gen = r.take(p.generations.size() * sizeof(uint32_t));
+                const bool genOk = gen && r.align();
+                const uint8_t *rec = genOk ? r.take(p.records.size() * sizeof(EntityRecord)) : nullptr;
+                const uint8_t *fl = rec ? r.take(p.freeList.size() * sizeof(uint32_t)) : nullptr;
+                if (!fl || !r.align())
+                    return fail(outError, "truncated entity table");
+                if (!p.generations.empty())
+                {
+                    std::memcpy(p.generations.data(), gen, p.generations.size() * sizeof(uint32_t));
+                    std::memcpy(p.records.data(), rec, p.records.size() * sizeof(EntityRecord));
+                }
+                if (!p.freeList.empty())
+                    std::memcpy(p.freeList.data(), fl, p.freeList.size() * sizeof(uint32_t));
+            }
+
+            // Parse and validate every store before touching the world.
+            p.views.resize(header.storeCount);
+            for (StoreView &v : p.views)
+            {
+                if (!r.pod(v.header) || !r.pod(v.signature))
+                    return fail(outError, "truncated store header");
+                const uint32_t rows = v.header.rows;
+                v.entities = reinterpret_cast<const Entity *>(r.take(static_cast<size_t>(rows) * sizeof(Entity)));
+                if (!v.entities || !r.align())
+                    return fail(outError, "truncated store entities");
+                v.rowMasks = reinterpret_cast<const ComponentMask *>(r.take(static_cast<size_t>(rows) * sizeof(ComponentMask)));
+                if (!v.rowMasks)
+                    return fail(outError, "truncated store row masks");
+
+                for (uint32_t c = 0; c < v.header.columnCount; ++c)
+                {
+                    ColumnHeader column{};
+                    if (!r.pod(column) || column.componentId >= header.componentCount ||
+                        column.bytes != static_cast<uint64_t>(column.elementSize) * rows)
+                        return fail(outError, "bad column header");
+
+                    // setColumnRows copies the registered size per row: the saved element size must
+                    // match it and the component table, and the column must belong to the store.
+                    const ComponentTypeInfo *type = ecs.components.typeInfo(p.idMap[column.componentId]);
+                    if (!v.signature.has(column.componentId) || column.elementSize == 0 ||
+                        column.elementSize != p.elementSizes[column.componentId] || !type ||
+                        type->size != column.elementSize || !type->trivial)
+                        return fail(outError, "column of component " + std::to_string(column.componentId) +
+                                                  " does not match the store or the component table");
+                    const uint8_t *bytes = r.take(static_cast<size_t>(column.bytes));
+                    if (!bytes || !r.align())
+                        return fail(outError, "truncated column");
+                    v.columns.emplace_back(column, bytes);
+                }
+            }
+            return true;
+        }
+
+        // Append the rows of one parsed store under 'handles' (one per row); returns the first row.
+        // Columns are saved packed; setColumnRows re-lays them out for split columns.
+        uint32_t appendStore(ECSContext &ecs, const Parsed &p, const StoreView &v, const ComponentMask &extraTags,
+                             const Entity *handles, uint32_t &outArchetypeId, std::vector<ComponentMask> &scratch)
+        {
+            ComponentMask signature = p.mask(v.signature);
+            signature.merge(extraTags);
+            const uint32_t archetypeId = ecs.archetypes.getOrCreate(signature);
+            ArchetypeStore *store = ecs.stores.getOrCreate(archetypeId, signature, ecs.components);
+            outArchetypeId = archetypeId;
+
+            const uint32_t rows = v.header.rows;
+            const uint32_t first = store->createRows(handles, rows);
+            if (p.identity && extraTags.empty())
+            {
+                store->setRowMasks(first, v.rowMasks, rows);
+            }
+            else
+            {
+                scratch.resize(rows);
+                for (uint32_t row = 0; row < rows; ++row)
+                {
+                    scratch[row] = p.mask(v.rowMasks[row]);
+                    scratch[row].merge(extraTags);
+                }
+                store->setRowMasks(first, scratch.data(), rows);
+            }
+
+            for (const auto &[column, bytes] : v.columns)
+            {
+                if (rows)
+                    store->setColumnRows(p.idMap[column.componentId], first, rows, bytes);
+            }
+            return first;
+        }
+    }
+
+    bool writeSnapshot(const ECSContext &ecs, std::vector<uint8_t> &out, std::string &outError)
+    {
+        const ComponentRegistry &registry = ecs.components;
+        const auto &stores = ecs.stores.stores();
+
+        uint32_t storeCount = 0;
+        for (const auto &store : stores)
+        {
+            if (!store || store->size() == 0)
+                continue;
+            if (!checkTrivialColumns(registry, *store, outError))
+                return false;
+            ++storeCount;
+        }
+
+        const auto &generations = ecs.entities.generations();
+        const auto &records = ecs.entities.records();
+        const auto &freeList = ecs.entities.freeList();
+
+        out.clear();
+        Writer w(out);
+
+        FileHeader header{};
+        header.storeCount = storeCount;
+        header.entityCapacity = static_cast<uint32_t>(generations.size());
+        header.freeCount = static_cast<uint32_t>(freeList.size());
+        writeHeaderAndComponents(w, registry, header);
+
+        w.bytes(generations.data(), generations.size() * sizeof(uint32_t));
+        w.align();
+        w.bytes(records.data(), records.size() * sizeof(EntityRecord));
+        w.bytes(freeList.data(), freeList.size() * sizeof(uint32_t));
+        w.align();
+
+        for (uint32_t archetypeId = 0; archetypeId < static_cast<uint32_t>(stores.size()); ++archetypeId)
+        {
+            const ArchetypeStore *store = stores[archetypeId].get();
+            if (store && store->size() != 0)
+                writeStore(w, archetypeId, *store, nullptr);
+        }
+
+        finish(out);
+        return true;
+    }
+
+    bool writeSnapshotEntities(const ECSContext &ecs, const Entity *entities, size_t count,
+                               std::vector<uint8_t> &out, std::string &outError)
+    {
+        const ComponentRegistry &registry = ecs.components;
+
+        // Rows per archetype, in the order the entities were listed.
+        std::vector<std::vector<uint32_t>> rows(ecs.stores.stores().size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            const EntityRecord *rec = ecs.entities.find(entities[i]);
+            if (!rec)
+                return fail(outError, "entity " + std::to_string(entities[i].index) + " is not alive");
+            rows[rec->archetypeId].push_back(rec->row);
+        }
+
+        uint32_t storeCount = 0;
+        for (uint32_t archetypeId = 0; archetypeId < static_cast<uint32_t>(rows.size()); ++archetypeId)
+        {
+            if (rows[archetypeId].empty())
+                continue;
+            if (!checkTrivialColumns(registry, *ecs.stores.get(archetypeId), outError))
+                return false;
+            ++storeCount;
+        }
+
+        out.clear();
+        Writer w(out);
+
+        FileHeader header{};
+        header.storeCount = storeCount;
+        header.flags = kFlagEntitySubset;
+        writeHeaderAndComponents(w, registry, header);
+
+        for (uint32_t archetypeId = 0; archetypeId < static_cast<uint32_t>(rows.size()); ++archetypeId)
+        {
+            if (!rows[archetypeId].empty())
+                writeStore(w, archetypeId, *ecs.stores.get(archetypeId), &rows[archetypeId]);
+        }
+
+        finish(out);
+        return true;
+    }
+
+    bool readSnapshot(ECSContext &ecs, const uint8_t *data, size_t size, std::string &outError)
+    {
+        Parsed p;
+        if (!parse(ecs, data, size, /*subset=*/false, p, outError))
+            return false;
+        const std::vector<StoreView> &views = p.views;
+
+        std::vector<uint32_t> archetypeMap; // saved archetype id -> index into views
+        for (uint32_t i = 0; i < static_cast<uint32_t>(views.size()); ++i)
+        {
+            const uint32_t saved = views[i].header.archetypeId;
+            if (saved >= archetypeMap.size())
+                archetypeMap.resize(static_cast<size_t>(saved) + 1, UINT32_MAX);
+            if (archetypeMap[saved] != UINT32_MAX)
+                return fail(outError, "archetype " + std::to_string(saved) + " saved twice");
+            archetypeMap[saved] = i;
+        }
+        for (const EntityRecord &rec : p.records)
+        {
+            if (!rec.attached())
+                continue;
+            if (rec.archetypeId >= archetypeMap.size() || archetypeMap[rec.archetypeId] == UINT32_MAX ||
+                rec.row >= views[archetypeMap[rec.archetypeId]].header.rows)
+                return fail(outError, "entity record points outside the saved stores");
+        }
+
+        // And every stored row must be the entity its record points at, or records and stores
+        // would disagree after the restore.
+        for (const StoreView &v : views)
+        {
+            for (uint32_t row = 0; row < v.header.rows; ++row)
+            {
+                const Entity e = v.entities[row];
+                if (e.index >= p.records.size() || p.generations[e.index] != e.generation ||
+                    p.records[e.index].archetypeId != v.header.archetypeId || p.records[e.index].row != row)
+                    return fail(outError, "store row does not match its entity record");
+            }
+        }
+
+        // Replace the world. Stores are emptied rather than destroyed so cached queries stay valid.
+        for (const auto &store : ecs.stores.stores())
+        {
+            if (store)
+                store->clear();
+        }
+        ecs.commands.clear();
+        ecs.selection = SelectionSet{};
+
+        std::vector<uint32_t> currentArchetype(views.size());
+        std::vector<ComponentMask> scratch;
+        for (size_t i = 0; i < views.size(); ++i)
+            appendStore(ecs, p, views[i], ComponentMask{}, views[i].entities, currentArchetype[i], scratch);
+
+        for (EntityRecord &rec : p.records)
+        {
+            if (rec.attached())
+                rec.archetypeId = currentArchetype[archetypeMap[rec.archetypeId]];
+        }
+        ecs.entities.restore(std::move(p.generations), std::move(p.freeList), std::move(p.records));
+
+        const uint32_t selectedId = ecs.components.getId("Selected");
+        if (selectedId != ComponentRegistry::InvalidID)
+        {
+            for (const StoreView &v : views)
+            {
+                for (uint32_t row = 0; row < v.header.rows; ++row)
+                {
+                    if (p.mask(v.rowMasks[row]).has(selectedId))
+                        ecs.selection.add(v.entities[row]);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool appendSnapshotEntities(ECSContext &ecs, const uint8_t *data, size_t size, const ComponentMask &extraTags,
+                                std::vector<SnapshotSpawn> *outSpawned, std::string &outError)
+    {
+        Parsed p;
+        if (!parse(ecs, data, size, /*subset=*/true, p, outError))
+            return false;
+
+        std::vector<Entity> handles;
+        std::vector<ComponentMask> scratch;
+        for (const StoreView &v : p.views)
+        {
+            const uint32_t rows = v.header.rows;
+            handles.resize(rows);
+            ecs.entities.reserve(rows);
+            for (uint32_t row = 0; row < rows; ++row)
+                handles[row] = ecs.entities.create();
+
+            uint32_t archetypeId = 0;
+            const uint32_t first = appendStore(ecs, p, v, extraTags, handles.data(), archetypeId, scratch);
+            for (uint32_t row = 0; row < rows; ++row)
+            {
+                ecs.entities.attach(handles[row], archetypeId, first + row);
+                if (outSpawned)
+                    outSpawned->push_back(SnapshotSpawn{v.entities[row], handles[row]});
+            }
+        }
+        return true;
+    }
+
+    bool saveSnapshot(const ECSContext &ecs, const std::string &path, std::string &outError)
+    {
+        std::vector<uint8_t> bytes;
+        if (!writeSnapshot(ecs, bytes, outError))
+            return false;
+
+        // Write next to the target and rename, so a crash never leaves a truncated save behind.
+        const std::string temp = path + ".tmp";
+        {
+            std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+            if (!out || !out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size())))
+                return fail(outError, "cannot write " + temp);
+        }
+        std::error_code ec;
+        std::filesystem::rename(temp, path, ec);
+        if (ec)
+            return fail(outError, "cannot replace " + path + ": " + ec.message());
+        return true;
+    }
+
+    bool loadSnapshot(ECSContext &ecs, const std::string &path, std::string &outError)
+    {
+        MappedFile file;
+        if (!file.open(path, outError))
+            return false;
+        return readSnapshot(ecs, file.data(), static_cast<size_t>(file.size()), outError);
+    }
+}
@@ -93,12 +93,13 @@ namespace Engine
 
         m_ImageFormat = surfaceFormat.format;
         m_Extent = extent;
+        m_PresentMode = presentMode;
 
         // create image views for use in framebuffers
         createImageViews();
 
-        // If replacing an old swapchain, cleanup the old one (vkDestroySwapchainKHR must be handled by caller or here if oldSwapchain used)
-        std::cout << "SwapChain initialized: images=" << m_Images.size() << " format=" << m_ImageFormat << "\n";
+        // When replacing a swapchain, Recreate() destroys the old one after this returns.
+        std::cout << "SwapChain initialized: images=" << m_Images.size() << " format=" << m_ImageFormat << " presentMode=" << m_PresentMode << "\n";
     }
 
     void SwapChain::Cleanup()
@@ -121,10 +122,21 @@ namespace Engine
 
     void SwapChain::Recreate(VkExtent2D newExtent)
     {
-        // caller should ensure device idle or use fences; here we simply cleanup and init
-        Cleanup();
+        // Caller ensures the device is idle. The old swapchain is passed as oldSwapchain so the
+        // presentation engine can hand its images over instead of tearing down the surface first.
+        for (auto iv : m_ImageViews)
+        {
+            if (iv != VK_NULL_HANDLE)
+                vkDestroyImageView(m_Device, iv, nullptr);
+        }
+        m_ImageViews.clear();
+
+        const VkSwapchainKHR old = m_Swapchain;
         m_Extent = newExtent;
+        m_InitialExtent = newExtent; // used when the surface leaves the extent to us
         Init();
+        if (old != VK_NULL_HANDLE)
+            vkDestroySwapchainKHR(m_Device, old, nullptr);
     }
 
     // helpers
@@ -142,7 +154,7 @@ namespace Engine
     {
         for (const auto &av : available)
         {
-            if (av == VK_PRESENT_MODE_MAILBOX_KHR)
+            if (av == m_PreferredPresentMode)
                 return av;
         }
         return VK_PRESENT_MODE_FIFO_KHR;
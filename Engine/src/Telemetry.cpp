@@ -0,0 +1,550 @@
+#include "Engine/Telemetry.h"
+#include "Engine/JobSystem.h"
+#include "Engine/MemoryStats.h"
+#include "Engine/Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+namespace Engine
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        struct Registry
+        {
+            std::mutex mutex;
+            uint32_t nextId = 1;
+            std::vector<std::pair<uint32_t, Telemetry::Source>> sources;
+            std::vector<std::shared_ptr<Telemetry::Sink>> sinks;
+            Telemetry::Config config;
+            std::atomic<bool> enabled{false};
+
+            // Main thread only
+            Telemetry::Window frames{16384};
+            Clock::time_point lastExport{};
+            uint64_t sequence = 0;
+            JobCounter publishJob;
+        };
+
+        Registry &registry()
+        {
+            static Registry r;
+            return r;
+        }
+
+        // Caller holds r.mutex.
+        void refreshEnabled(Registry &r)
+        {
+            r.enabled.store(!r.sinks.empty() && r.config.intervalSeconds > 0.0f, std::memory_order_relaxed);
+        }
+
+        void pushMetric(std::vector<Telemetry::Metric> &out, std::string name, double value,
+                        const char *labelKey = nullptr, std::string labelValue = {})
+        {
+            Telemetry::Metric m;
+            m.name = std::move(name);
+            if (labelKey)
+            {
+                m.labelKey = labelKey;
+                m.labelValue = std::move(labelValue);
+            }
+            m.value = value;
+            out.push_back(std::move(m));
+        }
+
+        void gatherCpuScopes(const Telemetry::Config &config, std::vector<Telemetry::Metric> &out)
+        {
+            std::vector<CpuProfiler::NodeStats> nodes;
+            CpuProfiler::snapshot(nodes);
+
+            // Depth-first order: the path stack holds the ancestors of the current node.
+            std::vector<std::string> path;
+            for (const CpuProfiler::NodeStats &s : nodes)
+            {
+                if (s.depth == 0 || s.depth > config.maxScopeDepth)
+                    continue;
+                path.resize(s.depth - 1);
+                path.push_back(path.empty() ? std::string(s.name) : path.back() + "/" + s.name);
+                pushMetric(out, "cpu_scope_ms", s.avgMs, "scope", path.back());
+                pushMetric(out, "cpu_scope_p95_ms", s.p95Ms, "scope", path.back());
+            }
+        }
+
+        void gatherMemory(std::vector<Telemetry::Metric> &out)
+        {
+            std::vector<MemoryStats::Counter> counters;
+            std::vector<MemoryStats::SubsystemTotal> totals;
+            MemoryStats::collect(counters, totals);
+            for (const MemoryStats::SubsystemTotal &t : totals)
+            {
+                pushMetric(out, "memory_cpu_bytes", static_cast<double>(t.cpuBytes), "subsystem", t.subsystem);
+                pushMetric(out, "memory_gpu_bytes", static_cast<double>(t.gpuBytes), "subsystem", t.subsystem);
+                if (t.budgetBytes == 0)
+                    continue;
+                pushMetric(out, "memory_budget_bytes", static_cast<double>(t.budgetBytes), "subsystem", t.subsystem);
+                pushMetric(out, "memory_over_budget", t.overBudget ? 1.0 : 0.0, "subsystem", t.subsystem);
+            }
+        }
+
+        // Integers print exactly (byte counts), everything else with 6 significant digits.
+        void formatValue(double value, char (&buf)[32])
+        {
+            if (!std::isfinite(value))
+                std::snprintf(buf, sizeof(buf), "0");
+            else if (value == std::floor(value) && std::fabs(value) < 1e15)
+                std::snprintf(buf, sizeof(buf), "%" PRId64, static_cast<int64_t>(value));
+            else
+                std::snprintf(buf, sizeof(buf), "%.6g", value);
+        }
+    } // namespace
+
+    // ------------------------------------------------------------
+    // Telemetry
+    // ------------------------------------------------------------
+
+    void Telemetry::configure(const Config &config)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.config = config;
+        refreshEnabled(r);
+    }
+
+    Telemetry::Config Telemetry::config()
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        return r.config;
+    }
+
+    void Telemetry::configureFromEnvironment()
+    {
+        const char *statsd = std::getenv("STRATO_TELEMETRY_STATSD");
+        const char *promFile = std::getenv("STRATO_TELEMETRY_PROMETHEUS_FILE");
+        const char *interval = std::getenv("STRATO_TELEMETRY_INTERVAL");
+        const char *instance = std::getenv("STRATO_TELEMETRY_INSTANCE");
+
+        Config c = config();
+        if (interval)
+            c.intervalSeconds = std::strtof(interval, nullptr);
+        if (instance)
+            c.instance = instance;
+        configure(c);
+
+        if (!statsd && !promFile)
+            return;
+
+        clearSinks();
+        if (statsd)
+        {
+            const std::string address = statsd;
+            const size_t colon = address.rfind(':');
+            const unsigned long port = (colon != std::string::npos) ? std::strtoul(address.c_str() + colon + 1, nullptr, 10) : 8125;
+            auto sink = std::make_unique<StatsdSink>(address.substr(0, colon), static_cast<uint16_t>(port));
+            if (sink->valid())
+                addSink(std::move(sink));
+        }
+        if (promFile && *promFile)
+            addSink(std::make_unique<PrometheusFileSink>(promFile));
+
+        if (enabled())
+            std::cout << "[Telemetry] Exporting every " << c.intervalSeconds << " s" << (statsd ? " to StatsD " + std::string(statsd) : "")
+                      << (promFile ? " to " + std::string(promFile) : "") << "\n";
+    }
+
+    void Telemetry::addSink(std::unique_ptr<Sink> sink)
+    {
+        if (!sink)
+            return;
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.sinks.push_back(std::shared_ptr<Sink>(std::move(sink)));
+        refreshEnabled(r);
+    }
+
+    void Telemetry::clearSinks()
+    {
+        flush();
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.sinks.clear();
+        refreshEnabled(r);
+    }
+
+    bool Telemetry::enabled()
+    {
+        return registry().enabled.load(std::memory_order_relaxed);
+    }
+
+    uint32_t Telemetry::addSource(Source source)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        const uint32_t id = r.nextId++;
+        r.sources.emplace_back(id, std::move(source));
+        return id;
+    }
+
+    void Telemetry::removeSource(uint32_t id)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.sources.erase(std::remove_if(r.sources.begin(), r.sources.end(),
+                                       [id](const auto &s)
+                                       { return s.first == id; }),
+                        r.sources.end());
+    }
+
+    void Telemetry::recordFrame(float frameMs)
+    {
+        Registry &r = registry();
+        if (r.enabled.load(std::memory_order_relaxed))
+            r.frames.record(frameMs);
+    }
+
+    void Telemetry::update()
+    {
+        Registry &r = registry();
+        if (!r.enabled.load(std::memory_order_relaxed))
+            return;
+
+        const Clock::time_point now = Clock::now();
+        if (r.lastExport == Clock::time_point{})
+        {
+            r.lastExport = now; // first interval starts with the first update
+            return;
+        }
+
+        // A slow sink delays the next batch rather than queueing them; the frame window keeps filling.
+        if (!r.publishJob.done())
+            return;
+
+        auto batch = std::make_shared<Batch>();
+        std::vector<std::shared_ptr<Sink>> sinks;
+        Config config;
+        {
+            std::lock_guard<std::mutex> lock(r.mutex);
+            config = r.config;
+            if (std::chrono::duration<float>(now - r.lastExport).count() < config.intervalSeconds)
+                return;
+            r.lastExport = now;
+            sinks = r.sinks;
+
+            PERF_SCOPE("Telemetry");
+            std::vector<Metric> &out = batch->metrics;
+            if (config.frameTimes)
+                r.frames.appendAndReset("frame_ms", out);
+            if (config.cpuScopes)
+                gatherCpuScopes(config, out);
+            if (config.memory)
+                gatherMemory(out);
+            if (config.sources)
+            {
+                for (auto &source : r.sources)
+                    source.second(config, out);
+            }
+        }
+        batch->sequence = ++r.sequence;
+        batch->unixMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                  std::chrono::system_clock::now().time_since_epoch())
+                                                  .count());
+
+        JobSystem::get().submit([batch, sinks = std::move(sinks), config = std::move(config)]
+                                {
+                                    for (const auto &sink : sinks)
+                                        sink->publish(config, *batch); },
+                                JobPriority::Background, &r.publishJob);
+    }
+
+    void Telemetry::flush()
+    {
+        Registry &r = registry();
+        if (!r.publishJob.done())
+            JobSystem::get().wait(r.publishJob, JobPriority::Background);
+    }
+
+    // ------------------------------------------------------------
+    // Telemetry::Window
+    // ------------------------------------------------------------
+
+    void Telemetry::Window::record(float ms)
+    {
+        if (m_samples.size() < m_capacity)
+            m_samples.push_back(ms);
+        ++m_count;
+        m_max = std::max(m_max, ms);
+    }
+
+    void Telemetry::Window::appendAndReset(const std::string &name, std::vector<Metric> &out)
+    {
+        pushMetric(out, name + "_count", static_cast<double>(m_count));
+        if (m_samples.empty())
+            return;
+
+        static constexpr std::pair<double, const char *> kQuantiles[] = {{0.5, "0.5"}, {0.95, "0.95"}, {0.99, "0.99"}};
+        std::sort(m_samples.begin(), m_samples.end());
+        const size_t last = m_samples.size() - 1;
+        for (const auto &q : kQuantiles)
+        {
+            const size_t i = std::min(last, static_cast<size_t>(q.first * static_cast<double>(last) + 0.5));
+            pushMetric(out, name, m_samples[i], "quantile", q.second);
+        }
+        pushMetric(out, name + "_max", m_max);
+
+        m_samples.clear();
+        m_count = 0;
+        m_max = 0.0f;
+    }
+
+    // ------------------------------------------------------------
+    // StatsdSink
+    // ------------------------------------------------------------
+
+#if defined(_WIN32)
+    using SocketHandle = SOCKET;
+    static const SocketHandle kInvalidSocket = INVALID_SOCKET;
+    static void closeSocket(SocketHandle s) { closesocket(s); }
+#else
+    using SocketHandle = int;
+    static const SocketHandle kInvalidSocket = -1;
+    static void closeSocket(SocketHandle s) { ::close(s); }
+#endif
+
+    struct StatsdSink::Impl
+    {
+        SocketHandle socket = kInvalidSocket;
+        sockaddr_storage address{};
+        socklen_t addressLength = 0;
+#if defined(_WIN32)
+        bool wsaStarted = false;
+#endif
+    };
+
+    StatsdSink::StatsdSink(const std::string &host, uint16_t port, bool tags)
+        : m_Impl(std::make_unique<Impl>()), m_tags(tags)
+    {
+#if defined(_WIN32)
+        WSADATA wsa;
+        m_Impl->wsaStarted = WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+        if (!m_Impl->wsaStarted)
+            return;
+#endif
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+        addrinfo *result = nullptr;
+        const std::string service = std::to_string(port);
+        if (getaddrinfo(host.c_str(), service.c_str(), &hints, &result) != 0 || !result)
+        {
+            std::cerr << "[Telemetry] StatsD: cannot resolve " << host << ":" << port << "\n";
+            return;
+        }
+
+        m_Impl->socket = ::socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+        if (m_Impl->socket != kInvalidSocket)
+        {
+            std::memcpy(&m_Impl->address, result->ai_addr, result->ai_addrlen);
+            m_Impl->addressLength = static_cast<socklen_t>(result->ai_addrlen);
+        }
+        else
+        {
+            std::cerr << "[Telemetry] StatsD: cannot create a UDP socket\n";
+        }
+        freeaddrinfo(result);
+    }
+
+    StatsdSink::~StatsdSink()
+    {
+        if (m_Impl->socket != kInvalidSocket)
+            closeSocket(m_Impl->socket);
+#if defined(_WIN32)
+        if (m_Impl->wsaStarted)
+            WSACleanup();
+#endif
+    }
+
+    bool StatsdSink::valid() const
+    {
+        return m_Impl->socket != kInvalidSocket;
+    }
+
+    void StatsdSink::publish(const Telemetry::Config &config, const Telemetry::Batch &batch)
+    {
+        if (!valid())
+            return;
+
+        // ':', '|', '@', '#' and ',' are StatsD syntax.
+        auto sanitize = [](std::string s)
+        {
+            for (char &c : s)
+            {
+                if (c == ':' || c == '|' || c == '@' || c == '#' || c == ',' || c == ' ' || c == '\n')
+                    c = '_';
+            }
+            return s;
+        };
+
+        // Fits a 1500-byte Ethernet MTU after IPv6 and UDP headers.
+        constexpr size_t kMaxDatagram = 1432;
+        std::string datagram;
+        auto send = [&]
+        {
+            if (datagram.empty())
+                return;
+            // Fire and forget: a full socket buffer or unreachable collector loses this interval only.
+            sendto(m_Impl->socket, datagram.data(), static_cast<int>(datagram.size()), 0,
+                   reinterpret_cast<const sockaddr *>(&m_Impl->address), m_Impl->addressLength);
+            datagram.clear();
+        };
+
+        const std::string instance = sanitize(config.instance);
+        std::string line;
+        char value[32];
+        for (const Telemetry::Metric &m : batch.metrics)
+        {
+            formatValue(m.value, value);
+            line = config.prefix.empty() ? std::string() : config.prefix + ".";
+            line += sanitize(m.name);
+            if (!m_tags && !m.labelKey.empty())
+                line += "." + sanitize(m.labelValue);
+            line += ":";
+            line += value;
+            line += "|g";
+            if (m_tags && (!instance.empty() || !m.labelKey.empty()))
+            {
+                line += "|#";
+                if (!instance.empty())
+                    line += "instance:" + instance + (m.labelKey.empty() ? "" : ",");
+                if (!m.labelKey.empty())
+                    line += sanitize(m.labelKey) + ":" + sanitize(m.labelValue);
+            }
+
+            if (!datagram.empty() && datagram.size() + 1 + line.size() > kMaxDatagram)
+                send();
+            if (!datagram.empty())
+                datagram += '\n';
+            datagram += line;
+        }
+        send();
+    }
+
+    // ------------------------------------------------------------
+    // PrometheusFileSink
+    // ------------------------------------------------------------
+
+    void PrometheusFileSink::publish(const Telemetry::Config &config, const Telemetry::Batch &batch)
+    {
+        auto sanitize = [](std::string s)
+        {
+            for (char &c : s)
+            {
+                if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == ':'))
+                    c = '_';
+            }
+            return s;
+        };
+        auto metricName = [&](const std::string &name)
+        {
+            return sanitize(config.prefix.empty() ? name : config.prefix + "_" + name);
+        };
+        auto labelValue = [](const std::string &v)
+        {
+            std::string s;
+            s.reserve(v.size());
+            for (char c : v)
+            {
+                if (c == '\\' || c == '"')
+                    s += '\\';
+                if (c == '\n')
+                {
+                    s += "\\n";
+                    continue;
+                }
+                s += c;
+            }
+            return s;
+        };
+
+        // The format wants all samples of a metric together, under one TYPE line.
+        std::vector<const Telemetry::Metric *> sorted;
+        sorted.reserve(batch.metrics.size());
+        for (const Telemetry::Metric &m : batch.metrics)
+            sorted.push_back(&m);
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Telemetry::Metric *a, const Telemetry::Metric *b)
+                         { return a->name < b->name; });
+
+        const std::string tmpPath = m_path + ".tmp";
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                std::cerr << "[Telemetry] Cannot write " << tmpPath << "\n";
+                return;
+            }
+
+            const std::string instance = labelValue(config.instance);
+            const std::string *previous = nullptr;
+            char value[32];
+            for (const Telemetry::Metric *m : sorted)
+            {
+                const std::string name = metricName(m->name);
+                if (!previous || *previous != m->name)
+                    file << "# TYPE " << name << " gauge\n";
+                previous = &m->name;
+
+                file << name;
+                if (!instance.empty() || !m->labelKey.empty())
+                {
+                    file << '{';
+                    if (!instance.empty())
+                        file << "instance=\"" << instance << '"' << (m->labelKey.empty() ? "" : ",");
+                    if (!m->labelKey.empty())
+                        file << sanitize(m->labelKey) << "=\"" << labelValue(m->labelValue) << '"';
+                    file << '}';
+                }
+                formatValue(m->value, value);
+                file << ' ' << value << '\n';
+            }
+            if (!file)
+            {
+                std::cerr << "[Telemetry] Cannot write " << tmpPath << "\n";
+                return;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, m_path, ec);
+        if (ec)
+            std::cerr << "[Telemetry] Cannot replace " << m_path << ": " << ec.message() << "\n";
+    }
+
+} // namespace Engine
@@ -48,27 +48,28 @@ namespace Engine
         m_width = width;
         m_height = height;
         m_mipLevels = calcMipLevels(width, height);
+        m_sourceWidth = width;
+        m_sourceHeight = height;
+        m_sourceMipLevels = m_mipLevels;
+        m_residentMip = 0;
         m_format = srgbFormat ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
 
         const VkDeviceSize pixelBytes = VkDeviceSize(width) * VkDeviceSize(height) * 4u;
 
-        // 1) Create staging buffer (must survive until submit finishes)
-        StagingBufferHandle staging{};
-        VkResult r = CreateStagingBuffer(ctx.device, ctx.physicalDevice, rgbaPixels, pixelBytes, staging);
-        if (r != VK_SUCCESS)
+        // 1) Copy into the context's staging arena (lives until the context is released)
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        VkDeviceSize stagingOffset = 0;
+        if (!StageUpload(ctx, rgbaPixels, pixelBytes, stagingBuffer, stagingOffset))
             return false;
 
-        // Keep staging alive until EndSubmitAndWait
-        ctx.pendingStaging.push_back(staging);
-
         // 2) Create GPU image (with mip levels)
-        r = CreateImage2D(
+        VkResult r = CreateImage2D(
             ctx.device, ctx.physicalDevice,
             width, height,
             m_format,
             VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
             m_mipLevels,
-            m_image, m_memory);
+            m_image, m_allocation);
 
         if (r != VK_SUCCESS)
             return false;
@@ -81,7 +82,7 @@ namespace Engine
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             VK_IMAGE_ASPECT_COLOR_BIT);
 
-        CmdCopyBufferToImage(ctx, staging.buffer, m_image, width, height);
+        CmdCopyBufferToImage(ctx, stagingBuffer, m_image, width, height, 0, stagingOffset);
 
         // 3b) Generate mipmaps if possible; otherwise just transition mip 0.
         if (m_mipLevels > 1)
@@ -98,6 +99,7 @@ namespace Engine
             {
                 // Fall back to no mips.
                 m_mipLevels = 1;
+                m_sourceMipLevels = 1;
                 CmdTransitionImageLayout(
                     ctx,
                     m_image,
@@ -189,6 +191,323 @@ namespace Engine
         return ok;
     }
 
+    bool TextureAsset::decodeRGBA8(const uint8_t *encodedBytes, size_t encodedSize, DecodedImage &out)
+    {
+        out = DecodedImage{};
+        if (!encodedBytes || encodedSize == 0)
+            return false;
+
+        int w = 0, h = 0, comp = 0;
+        unsigned char *decoded = stbi_load_from_memory(
+            encodedBytes,
+            static_cast<int>(encodedSize),
+            &w, &h,
+            &comp,
+            4);
+
+        if (!decoded || w <= 0 || h <= 0)
+        {
+            if (decoded)
+                stbi_image_free(decoded);
+            return false;
+        }
+
+        out.width = static_cast<uint32_t>(w);
+        out.height = static_cast<uint32_t>(h);
+        out.pixels.assign(decoded, decoded + size_t(out.width) * out.height * 4u);
+        out.levelOffsets.assign(1, 0);
+        stbi_image_free(decoded);
+        return true;
+    }
+
+    bool TextureAsset::decodeWithMips(const uint8_t *encodedBytes, size_t encodedSize, DecodedImage &out)
+    {
+        if (!decodeRGBA8(encodedBytes, encodedSize, out))
+            return false;
+
+        const uint32_t levels = calcMipLevels(out.width, out.height);
+        VkDeviceSize total = 0;
+        out.levelOffsets.resize(levels);
+        for (uint32_t i = 0; i < levels; ++i)
+        {
+            const VkDeviceSize lw = std::max(1u, out.width >> i);
+            const VkDeviceSize lh = std::max(1u, out.height >> i);
+            out.levelOffsets[i] = total;
+            total += lw * lh * 4u;
+        }
+
+        out.pixels.resize(static_cast<size_t>(total)); // level 0 is already in place
+
+        // 2x2 box filter per level (edge texels clamp for odd sizes). Averages in stored space,
+        // same as the blit path does for UNORM views.
+        for (uint32_t i = 1; i < levels; ++i)
+        {
+            const uint32_t sw = std::max(1u, out.width >> (i - 1));
+            const uint32_t sh = std::max(1u, out.height >> (i - 1));
+            const uint32_t dw = std::max(1u, out.width >> i);
+            const uint32_t dh = std::max(1u, out.height >> i);
+            const uint8_t *src = out.pixels.data() + out.levelOffsets[i - 1];
+            uint8_t *dst = out.pixels.data() + out.levelOffsets[i];
+
+            for (uint32_t y = 0; y < dh; ++y)
+            {
+                const uint32_t y0 = std::min(y * 2u, sh - 1u);
+                const uint32_t y1 = std::min(y * 2u + 1u, sh - 1u);
+                for (uint32_t x = 0; x < dw; ++x)
+                {
+                    const uint32_t x0 = std::min(x * 2u, sw - 1u);
+                    const uint32_t x1 = std::min(x * 2u + 1u, sw - 1u);
+                    const uint8_t *a = src + (size_t(y0) * sw + x0) * 4u;
+                    const uint8_t *b = src + (size_t(y0) * sw + x1) * 4u;
+                    const uint8_t *c = src + (size_t(y1) * sw + x0) * 4u;
+                    const uint8_t *d = src + (size_t(y1) * sw + x1) * 4u;
+                    uint8_t *o = dst + (size_t(y) * dw + x) * 4u;
+                    for (int k = 0; k < 4; ++k)
+                        o[k] = static_cast<uint8_t>((unsigned(a[k]) + b[k] + c[k] + d[k] + 2u) >> 2);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool TextureAsset::uploadDecoded_Deferred(
+        UploadContext &ctx,
+        const DecodedImage &image,
+        bool srgbFormat,
+        VkSamplerAddressMode wrapU,
+        VkSamplerAddressMode wrapV,
+        VkFilter minFilter,
+        VkFilter magFilter,
+        VkSamplerMipmapMode mipMode,
+        float maxAnisotropy,
+        uint32_t firstLevel)
+    {
+        if (!ctx.begun || ctx.cmd == VK_NULL_HANDLE)
+            return false;
+
+        if (image.width == 0 || image.height == 0 || image.levelOffsets.empty())
+            return false;
+
+        if (isValid())
+            destroy(ctx.device);
+
+        firstLevel = std::min(firstLevel, image.mipLevels() - 1);
+        m_sourceWidth = image.width;
+        m_sourceHeight = image.height;
+        m_sourceMipLevels = image.mipLevels();
+        m_residentMip = firstLevel;
+        m_width = std::max(1u, image.width >> firstLevel);
+        m_height = std::max(1u, image.height >> firstLevel);
+        m_mipLevels = image.mipLevels() - firstLevel;
+        m_format = srgbFormat ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+
+        // 1) Every resident level in one staging range
+        const VkDeviceSize firstOffset = image.levelOffsets[firstLevel];
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        VkDeviceSize stagingOffset = 0;
+        if (!StageUpload(ctx, image.pixels.data() + firstOffset,
+                         static_cast<VkDeviceSize>(image.pixels.size()) - firstOffset,
+                         stagingBuffer, stagingOffset))
+            return false;
+
+        // 2) GPU image, concurrent across the upload and graphics families when they differ
+        VkImageCreateInfo ii{};
+        ii.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        ii.imageType = VK_IMAGE_TYPE_2D;
+        ii.extent = {m_width, m_height, 1};
+        ii.mipLevels = m_mipLevels;
+        ii.arrayLayers = 1;
+        ii.format = m_format;
+        ii.tiling = VK_IMAGE_TILING_OPTIMAL;
+        ii.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        ii.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        ii.samples = VK_SAMPLE_COUNT_1_BIT;
+        ApplyQueueSharing(ctx, ii);
+
+        VkResult r = GpuAllocator::forDevice(ctx.device, ctx.physicalDevice)
+                         .createImage(ii, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuMemoryCategory::Texture, m_image, m_allocation);
+        if (r != VK_SUCCESS)
+            return false;
+
+        // 3) Transition all levels, copy each one, transition to shader-read
+        CmdTransitionImageLayout(
+            ctx,
+            m_image,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            m_mipLevels);
+
+        for (uint32_t i = 0; i < m_mipLevels; ++i)
+        {
+            CmdCopyBufferToImage(ctx, stagingBuffer, m_image,
+                                 std::max(1u, m_width >> i), std::max(1u, m_height >> i),
+                                 i, stagingOffset + image.levelOffsets[firstLevel + i] - firstOffset);
+        }
+
+        CmdTransitionImageLayout(
+            ctx,
+            m_image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            m_mipLevels);
+
+        // 4) View + sampler
+        r = CreateImageView2D(ctx.device, m_image, m_format, VK_IMAGE_ASPECT_COLOR_BIT, m_mipLevels, m_view);
+        if (r != VK_SUCCESS)
+            return false;
+
+        r = CreateTextureSampler(
+            ctx.device,
+            ctx.physicalDevice,
+            wrapU,
+            wrapV,
+            minFilter,
+            magFilter,
+            mipMode,
+            maxAnisotropy,
+            static_cast<float>(m_mipLevels - 1),
+            m_sampler);
+
+        return r == VK_SUCCESS;
+    }
+
+    static VkDeviceSize blockLevelBytes(uint32_t width, uint32_t height, uint32_t level)
+    {
+        const VkDeviceSize w = std::max(1u, width >> level);
+        const VkDeviceSize h = std::max(1u, height >> level);
+        return ((w + 3) / 4) * ((h + 3) / 4) * 16u;
+    }
+
+    bool TextureAsset::uploadBlockCompressed_Deferred(
+        UploadContext &ctx,
+        const BlockCompressedImage &image,
+        VkSamplerAddressMode wrapU,
+        VkSamplerAddressMode wrapV,
+        VkFilter minFilter,
+        VkFilter magFilter,
+        VkSamplerMipmapMode mipMode,
+        float maxAnisotropy,
+        uint32_t firstLevel)
+    {
+        if (!ctx.begun || ctx.cmd == VK_NULL_HANDLE)
+            return false;
+
+        if (!image.data || image.width == 0 || image.height == 0 || image.mipLevels == 0 ||
+            image.mipLevels > calcMipLevels(image.width, image.height))
+            return false;
+
+        VkDeviceSize expected = 0;
+        for (uint32_t i = 0; i < image.mipLevels; ++i)
+            expected += blockLevelBytes(image.width, image.height, i);
+        if (expected != image.size)
+            return false;
+
+        // Compressed formats are optional device features (textureCompressionBC / _ASTC_LDR)
+        VkFormatProperties props{};
+        vkGetPhysicalDeviceFormatProperties(ctx.physicalDevice, image.format, &props);
+        if (!(props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+            return false;
+
+        if (isValid())
+            destroy(ctx.device);
+
+        firstLevel = std::min(firstLevel, image.mipLevels - 1);
+        VkDeviceSize firstOffset = 0;
+        for (uint32_t i = 0; i < firstLevel; ++i)
+            firstOffset += blockLevelBytes(image.width, image.height, i);
+
+        m_sourceWidth = image.width;
+        m_sourceHeight = image.height;
+        m_sourceMipLevels = image.mipLevels;
+        m_residentMip = firstLevel;
+        m_width = std::max(1u, image.width >> firstLevel);
+        m_height = std::max(1u, image.height >> firstLevel);
+        m_mipLevels = image.mipLevels - firstLevel;
+        m_format = image.format;
+
+        // 1) The resident chain in one staging range (16-byte aligned, so every level is block aligned)
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        VkDeviceSize stagingOffset = 0;
+        if (!StageUpload(ctx, image.data + firstOffset, image.size - firstOffset, stagingBuffer, stagingOffset))
+            return false;
+
+        // 2) GPU image, concurrent across the upload and graphics families when they differ
+        VkImageCreateInfo ii{};
+        ii.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        ii.imageType = VK_IMAGE_TYPE_2D;
+        ii.extent = {m_width, m_height, 1};
+        ii.mipLevels = m_mipLevels;
+        ii.arrayLayers = 1;
+        ii.format = m_format;
+        ii.tiling = VK_IMAGE_TILING_OPTIMAL;
+        ii.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        ii.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        ii.samples = VK_SAMPLE_COUNT_1_BIT;
+        ApplyQueueSharing(ctx, ii);
+
+        VkResult r = GpuAllocator::forDevice(ctx.device, ctx.physicalDevice)
+                         .createImage(ii, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuMemoryCategory::Texture, m_image, m_allocation);
+        if (r != VK_SUCCESS)
+            return false;
+
+        // 3) Copy each level; extents are in texels (partial edge blocks are allowed at the image edge)
+        CmdTransitionImageLayout(
+            ctx,
+            m_image,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            m_mipLevels);
+
+        VkDeviceSize levelOffset = 0;
+        for (uint32_t i = 0; i < m_mipLevels; ++i)
+        {
+            CmdCopyBufferToImage(ctx, stagingBuffer, m_image,
+                                 std::max(1u, m_width >> i), std::max(1u, m_height >> i),
+                                 i, stagingOffset + levelOffset);
+            levelOffset += blockLevelBytes(m_width, m_height, i);
+        }
+
+        CmdTransitionImageLayout(
+            ctx,
+            m_image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            m_mipLevels);
+
+        // 4) View + sampler
+        r = CreateImageView2D(ctx.device, m_image, m_format, VK_IMAGE_ASPECT_COLOR_BIT, m_mipLevels, m_view);
+        if (r != VK_SUCCESS)
+            return false;
+
+        r = CreateTextureSampler(
+            ctx.device,
+            ctx.physicalDevice,
+            wrapU,
+            wrapV,
+            minFilter,
+            magFilter,
+            mipMode,
+            maxAnisotropy,
+            static_cast<float>(m_mipLevels - 1),
+            m_sampler);
+
+        return r == VK_SUCCESS;
+    }
+
+    VkDeviceSize TextureAsset::stagingBytesForEncoded(const uint8_t *encodedBytes, size_t encodedSize)
+    {
+        int w = 0, h = 0, comp = 0;
+        if (!encodedBytes || encodedSize == 0 ||
+            !stbi_info_from_memory(encodedBytes, static_cast<int>(encodedSize), &w, &h, &comp))
+            return 0;
+        return StagingFootprint(VkDeviceSize(w) * VkDeviceSize(h) * 4u);
+    }
+
     void TextureAsset::destroy(VkDevice device)
     {
         if (m_sampler != VK_NULL_HANDLE)
@@ -203,21 +522,15 @@ namespace Engine
             m_view = VK_NULL_HANDLE;
         }
 
-        if (m_image != VK_NULL_HANDLE)
-        {
-            vkDestroyImage(device, m_image, nullptr);
-            m_image = VK_NULL_HANDLE;
-        }
-
-        if (m_memory != VK_NULL_HANDLE)
-        {
-            vkFreeMemory(device, m_memory, nullptr);
-            m_memory = VK_NULL_HANDLE;
-        }
+        DestroyImage2D(device, m_image, m_allocation);
 
         m_width = 0;
         m_height = 0;
         m_mipLevels = 1;
+        m_sourceWidth = 0;
+        m_sourceHeight = 0;
+        m_sourceMipLevels = 1;
+        m_residentMip = 0;
         m_format = VK_FORMAT_R8G8B8A8_UNORM;
     }
 
@@ -0,0 +1,135 @@
+#include "Engine/TransientAllocator.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace Engine
+{
+    namespace
+    {
+        constexpr VkBufferUsageFlags kTransientUsage =
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+        VkDeviceSize alignUp(VkDeviceSize v, VkDeviceSize a)
+        {
+            return (v + a - 1) & ~(a - 1);
+        }
+    }
+
+    bool TransientAllocator::create(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t frameCount, VkDeviceSize bytesPerFrame)
+    {
+        destroy();
+        m_device = device;
+        m_physicalDevice = physicalDevice;
+
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(physicalDevice, &props);
+        m_minAlignment = std::max<VkDeviceSize>({16, props.limits.minUniformBufferOffsetAlignment,
+                                                 props.limits.minStorageBufferOffsetAlignment});
+
+        m_frames.reserve(frameCount);
+        for (uint32_t i = 0; i < frameCount; ++i)
+        {
+            m_frames.push_back(std::make_unique<Frame>());
+            if (!createFrameBuffer(*m_frames.back(), bytesPerFrame))
+            {
+                std::cerr << "TransientAllocator: failed to create a " << bytesPerFrame << "-byte frame buffer\n";
+                destroy();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool TransientAllocator::createFrameBuffer(Frame &frame, VkDeviceSize capacity)
+    {
+        GpuAllocator &allocator = GpuAllocator::forDevice(m_device, m_physicalDevice);
+        allocator.destroyBuffer(frame.buffer, frame.allocation);
+        frame.capacity = 0;
+
+        capacity = alignUp(std::max<VkDeviceSize>(capacity, 64 * 1024), m_minAlignment);
+        if (allocator.createBuffer(capacity, kTransientUsage,
+                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                   GpuMemoryCategory::Dynamic, frame.buffer, frame.allocation) != VK_SUCCESS ||
+            !frame.allocation.mapped)
+        {
+            allocator.destroyBuffer(frame.buffer, frame.allocation);
+            return false;
+        }
+        frame.capacity = capacity;
+        frame.version = m_nextVersion++;
+        return true;
+    }
+
+    void TransientAllocator::destroy()
+    {
+        if (GpuAllocator *allocator = GpuAllocator::find(m_device))
+        {
+            for (auto &f : m_frames)
+                allocator->destroyBuffer(f->buffer, f->allocation);
+        }
+        m_frames.clear();
+    }
+
+    void TransientAllocator::beginFrame(uint32_t frameIndex)
+    {
+        if (m_frames.empty())
+            return;
+        Frame &f = *m_frames[frameIndex % m_frames.size()];
+
+        // Overflowed last time: grow to the next power of two above what was asked for.
+        const VkDeviceSize requested = f.requested.load(std::memory_order_relaxed);
+        if (requested > f.capacity)
+        {
+            VkDeviceSize capacity = f.capacity;
+            while (capacity < requested)
+                capacity *= 2;
+            const VkDeviceSize old = f.capacity;
+            if (!createFrameBuffer(f, capacity) && !createFrameBuffer(f, old))
+                std::cerr << "TransientAllocator: out of memory for frame slot " << frameIndex << "\n";
+        }
+
+        f.cursor.store(0, std::memory_order_relaxed);
+        f.requested.store(0, std::memory_order_relaxed);
+    }
+
+    TransientAllocator::Allocation TransientAllocator::allocate(uint32_t frameIndex, VkDeviceSize size, VkDeviceSize alignment)
+    {
+        Allocation out;
+        if (m_frames.empty() || size == 0)
+            return out;
+        Frame &f = *m_frames[frameIndex % m_frames.size()];
+
+        const VkDeviceSize align = std::max(alignment, m_minAlignment);
+        const VkDeviceSize padded = alignUp(size, align);
+        f.requested.fetch_add(padded, std::memory_order_relaxed);
+
+        VkDeviceSize cursor = f.cursor.load(std::memory_order_relaxed);
+        VkDeviceSize offset = 0;
+        do
+        {
+            offset = alignUp(cursor, align);
+            if (offset + size > f.capacity)
+                return out;
+        } while (!f.cursor.compare_exchange_weak(cursor, offset + size, std::memory_order_relaxed));
+
+        out.buffer = f.buffer;
+        out.offset = offset;
+        out.size = size;
+        out.mapped = static_cast<uint8_t *>(f.allocation.mapped) + offset;
+        out.bufferVersion = f.version;
+        return out;
+    }
+
+    VkDeviceSize TransientAllocator::used(uint32_t frameIndex) const
+    {
+        return m_frames.empty() ? 0 : m_frames[frameIndex % m_frames.size()]->cursor.load(std::memory_order_relaxed);
+    }
+
+    VkDeviceSize TransientAllocator::capacity(uint32_t frameIndex) const
+    {
+        return m_frames.empty() ? 0 : m_frames[frameIndex % m_frames.size()]->capacity;
+    }
+}
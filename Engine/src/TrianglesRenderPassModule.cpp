@@ -30,9 +30,11 @@ namespace Engine
         // Ensure we always have an instance buffer bound (even for a single draw)
         // Instance data layout: { vec2 offset; vec3 color; }
         const float defaultInstance[5] = {0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
-        VkResult instRes = CreateOrUpdateVertexBuffer(
+        VkResult instRes = CreateStaticVertexBuffer(
             ctx.GetDevice(),
             ctx.GetPhysicalDevice(),
+            ctx.GetGraphicsQueueFamilyIndex(),
+            ctx.GetGraphicsQueue(),
             defaultInstance,
             sizeof(defaultInstance),
             m_defaultInstanceVB);
@@ -1,10 +1,13 @@
 #include "Engine/VulkanContext.h"
 #include "Engine/Window.h"
 #include "Engine/SwapChain.h"
+#include "Engine/GpuAllocator.h"
+#include "Engine/PipelineCache.h"
 #include "utils/VulkanValidationUtils.h"
 #include <GLFW/glfw3.h> // for glfwCreateWindowSurface
 #include <iostream>
 #include <vector>
+#include <map>
 #include <set>
 #include <stdexcept>
 #include <algorithm>
@@ -58,6 +61,9 @@ namespace Engine
         // Destroy device first (this will free device-local resources)
         if (m_Device != VK_NULL_HANDLE)
         {
+            // Every module has released its allocations by now; free the allocator's blocks.
+            PipelineCache::close(m_Device);
+            GpuAllocator::releaseDevice(m_Device);
             vkDestroyDevice(m_Device, nullptr);
             m_Device = VK_NULL_HANDLE;
         }
@@ -137,6 +143,23 @@ namespace Engine
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
         }
 
+        // Needed to query descriptor indexing support on a 1.0 instance.
+        {
+            uint32_t count = 0;
+            vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
+            std::vector<VkExtensionProperties> available(count);
+            vkEnumerateInstanceExtensionProperties(nullptr, &count, available.data());
+            for (const auto &e : available)
+            {
+                if (std::strcmp(e.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0)
+                {
+                    extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+                    m_PhysicalDeviceProperties2 = true;
+                    break;
+                }
+            }
+        }
+
         VkApplicationInfo appInfo{};
         appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
         appInfo.pApplicationName = "MyEngine";
@@ -321,25 +344,54 @@ namespace Engine
             throw std::runtime_error("Queue families are not complete for logical device creation");
         }
 
-        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies;
-        uniqueQueueFamilies.insert(indices.graphicsFamily.value());
-        uniqueQueueFamilies.insert(indices.presentFamily.value());
+        pickTransferQueueFamily();
+        pickComputeQueueFamily();
 
-        float queuePriority = 1.0f;
-        for (uint32_t queueFamily : uniqueQueueFamilies)
+        // Queues per family and their priorities; streaming uploads get a lower priority than frame
+        // and async compute submissions. Queues shared by two roles keep the higher priority.
+        std::map<uint32_t, std::vector<float>> familyPriorities;
+        auto requestQueue = [&familyPriorities](uint32_t family, uint32_t index, float priority)
+        {
+            std::vector<float> &priorities = familyPriorities[family];
+            if (priorities.size() <= index)
+                priorities.resize(index + 1, 0.0f);
+            priorities[index] = std::max(priorities[index], priority);
+        };
+        requestQueue(indices.graphicsFamily.value(), 0, 1.0f);
+        requestQueue(indices.presentFamily.value(), 0, 1.0f);
+        requestQueue(m_TransferFamily, m_TransferQueueIndex, 0.5f);
+        if (m_AsyncCompute)
+            requestQueue(m_ComputeFamily, m_ComputeQueueIndex, 1.0f);
+
+        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+        for (const auto &[queueFamily, priorities] : familyPriorities)
         {
             VkDeviceQueueCreateInfo queueCreate{};
             queueCreate.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
             queueCreate.queueFamilyIndex = queueFamily;
-            queueCreate.queueCount = 1;
-            queueCreate.pQueuePriorities = &queuePriority;
+            queueCreate.queueCount = static_cast<uint32_t>(priorities.size());
+            queueCreate.pQueuePriorities = priorities.data();
             queueCreateInfos.push_back(queueCreate);
         }
 
         // (Optional) request device features here
+        VkPhysicalDeviceFeatures supportedFeatures{};
+        vkGetPhysicalDeviceFeatures(m_SelectedDeviceInfo.physicalDevice, &supportedFeatures);
+
         VkPhysicalDeviceFeatures deviceFeatures{};
         // deviceFeatures.samplerAnisotropy = VK_TRUE; // enable if needed
+        // Cooked .smodel textures may be BC7/BC5 (desktop) or ASTC (mobile); enable whichever exists.
+        deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+        deviceFeatures.textureCompressionASTC_LDR = supportedFeatures.textureCompressionASTC_LDR;
+        // Profiler-only: pipeline statistics queries around each render pass module.
+        deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+        m_PipelineStatistics = supportedFeatures.pipelineStatisticsQuery == VK_TRUE;
+        // GPU-driven drawing (GpuSceneRenderPassModule): many indirect draws per call, each with its own
+        // firstInstance.
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+        m_MultiDrawIndirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+        m_DrawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance == VK_TRUE;
 
         VkDeviceCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -347,9 +399,66 @@ namespace Engine
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
         createInfo.pEnabledFeatures = &deviceFeatures;
 
-        // Device extensions (swapchain)
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        // Device extensions (swapchain, plus timeline semaphores for streaming completion when available)
+        std::vector<const char *> extensions = deviceExtensions;
+        VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures{};
+        timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+        m_TimelineSemaphores = deviceSupportsExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+        if (m_TimelineSemaphores)
+        {
+            extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+            timelineFeatures.timelineSemaphore = VK_TRUE;
+            createInfo.pNext = &timelineFeatures;
+        }
+
+        // Bindless material textures: one update-after-bind, partially bound sampler array.
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures{};
+        indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        if (queryBindlessSupport() && deviceSupportsExtension(VK_KHR_MAINTENANCE3_EXTENSION_NAME))
+        {
+            extensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+            extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+            indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+            indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+            indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+            indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+            indexingFeatures.pNext = const_cast<void *>(createInfo.pNext);
+            createInfo.pNext = &indexingFeatures;
+        }
+        else
+        {
+            m_MaxBindlessTextures = 0;
+        }
+
+        // Frame pacing: VK_KHR_present_id tags presents, VK_KHR_present_wait blocks until one is displayed.
+        VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+        presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+        presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+        m_PresentWait = queryPresentWaitSupport();
+        if (m_PresentWait)
+        {
+            extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+            extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+            presentIdFeatures.presentId = VK_TRUE;
+            presentWaitFeatures.presentWait = VK_TRUE;
+            presentIdFeatures.pNext = &presentWaitFeatures;
+            presentWaitFeatures.pNext = const_cast<void *>(createInfo.pNext);
+            createInfo.pNext = &presentIdFeatures;
+        }
+
+        // Per-heap budget/usage from the driver for the memory overlay (no features to enable).
+        m_MemoryBudget = m_PhysicalDeviceProperties2 && deviceSupportsExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (m_MemoryBudget)
+            extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+        // Draw counts read from a GPU buffer (vkCmdDrawIndexedIndirectCountKHR; no features to enable).
+        m_DrawIndirectCount = deviceSupportsExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        if (m_DrawIndirectCount)
+            extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
 
         // No device layers (deprecated), validation layers enabled at instance level if desired
         createInfo.enabledLayerCount = 0;
@@ -364,7 +473,193 @@ namespace Engine
         // Retrieve queue handles
         vkGetDeviceQueue(m_Device, indices.graphicsFamily.value(), 0, &m_GraphicsQueue);
         vkGetDeviceQueue(m_Device, indices.presentFamily.value(), 0, &m_PresentQueue);
+        vkGetDeviceQueue(m_Device, m_TransferFamily, m_TransferQueueIndex, &m_TransferQueue);
+        if (m_AsyncCompute)
+        {
+            vkGetDeviceQueue(m_Device, m_ComputeFamily, m_ComputeQueueIndex, &m_ComputeQueue);
+
+            // Compute results are read by graphics (and palettes written by graphics-side copies are read
+            // by compute), so plain buffers are shared by both families instead of changing ownership.
+            GpuAllocator::forDevice(m_Device, m_SelectedDeviceInfo.physicalDevice)
+                .setBufferQueueFamilies({indices.graphicsFamily.value(), m_ComputeFamily});
+        }
+
+        if (m_MemoryBudget)
+        {
+            auto query = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(
+                vkGetInstanceProcAddr(m_Instance, "vkGetPhysicalDeviceMemoryProperties2KHR"));
+            m_MemoryBudget = query != nullptr;
+            GpuAllocator::forDevice(m_Device, m_SelectedDeviceInfo.physicalDevice).setMemoryBudgetQuery(query);
+        }
 
         std::cout << "Graphics queue and Present queue retrieved\n";
+        std::cout << "Transfer queue: family " << m_TransferFamily << " index " << m_TransferQueueIndex
+                  << (TransferQueueIsShared() ? " (shared with graphics)" : "")
+                  << ", timeline semaphores " << (m_TimelineSemaphores ? "on" : "off")
+                  << ", bindless textures " << m_MaxBindlessTextures
+                  << ", memory budget " << (m_MemoryBudget ? "on" : "off")
+                  << ", present wait " << (m_PresentWait ? "on" : "off") << "\n";
+        if (m_AsyncCompute)
+            std::cout << "Async compute queue: family " << m_ComputeFamily << " index " << m_ComputeQueueIndex << "\n";
+        else
+            std::cout << "Async compute queue: none (compute runs on the graphics queue)\n";
+
+        // Shared by every pipeline creation; saved back to disk in Shutdown().
+        PipelineCache::open(m_Device, m_SelectedDeviceInfo.physicalDevice, "pipeline_cache.bin");
+    }
+
+    void VulkanContext::pickTransferQueueFamily()
+    {
+        const uint32_t graphicsFamily = m_SelectedDeviceInfo.queueFamilyIndices.graphicsFamily.value();
+
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(m_SelectedDeviceInfo.physicalDevice, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(m_SelectedDeviceInfo.physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+        // 1) A DMA-only family, 2) any non-graphics family (compute queues can also copy),
+        // 3) a second queue in the graphics family, 4) the graphics queue itself.
+        int transferOnly = -1;
+        int nonGraphics = -1;
+        for (uint32_t i = 0; i < queueFamilyCount; ++i)
+        {
+            const VkQueueFlags flags = queueFamilies[i].queueFlags;
+            if (queueFamilies[i].queueCount == 0 || (flags & VK_QUEUE_GRAPHICS_BIT))
+                continue;
+            if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_COMPUTE_BIT) && transferOnly < 0)
+                transferOnly = static_cast<int>(i);
+            if ((flags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT)) && nonGraphics < 0)
+                nonGraphics = static_cast<int>(i);
+        }
+
+        m_TransferQueueIndex = 0;
+        if (transferOnly >= 0)
+            m_TransferFamily = static_cast<uint32_t>(transferOnly);
+        else if (nonGraphics >= 0)
+            m_TransferFamily = static_cast<uint32_t>(nonGraphics);
+        else
+        {
+            m_TransferFamily = graphicsFamily;
+            if (queueFamilies[graphicsFamily].queueCount > 1)
+                m_TransferQueueIndex = 1;
+        }
+    }
+
+    void VulkanContext::pickComputeQueueFamily()
+    {
+        m_AsyncCompute = false;
+        m_ComputeQueue = VK_NULL_HANDLE;
+        m_ComputeFamily = m_SelectedDeviceInfo.queueFamilyIndices.graphicsFamily.value();
+        m_ComputeQueueIndex = 0;
+
+        // Cross-queue waits are expressed with timeline values (Renderer).
+        if (!deviceSupportsExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+            return;
+
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(m_SelectedDeviceInfo.physicalDevice, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(m_SelectedDeviceInfo.physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+        // A compute family without graphics runs beside the graphics queue. Prefer one the streaming
+        // uploads do not use; in the transfer family take a second queue, never share the upload queue.
+        int shared = -1;
+        for (uint32_t i = 0; i < queueFamilyCount; ++i)
+        {
+            const VkQueueFlags flags = queueFamilies[i].queueFlags;
+            if (queueFamilies[i].queueCount == 0 || (flags & VK_QUEUE_GRAPHICS_BIT) || !(flags & VK_QUEUE_COMPUTE_BIT))
+                continue;
+            if (i != m_TransferFamily)
+            {
+                m_ComputeFamily = i;
+                m_AsyncCompute = true;
+                return;
+            }
+            if (queueFamilies[i].queueCount > m_TransferQueueIndex + 1)
+                shared = static_cast<int>(i);
+        }
+        if (shared >= 0)
+        {
+            m_ComputeFamily = static_cast<uint32_t>(shared);
+            m_ComputeQueueIndex = m_TransferQueueIndex + 1;
+            m_AsyncCompute = true;
+        }
+    }
+
+    bool VulkanContext::queryBindlessSupport()
+    {
+        m_MaxBindlessTextures = 0;
+        if (!m_PhysicalDeviceProperties2 || !deviceSupportsExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+            return false;
+
+        auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+            vkGetInstanceProcAddr(m_Instance, "vkGetPhysicalDeviceFeatures2KHR"));
+        auto getProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2KHR>(
+            vkGetInstanceProcAddr(m_Instance, "vkGetPhysicalDeviceProperties2KHR"));
+        if (!getFeatures2 || !getProperties2)
+            return false;
+
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexing{};
+        indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        VkPhysicalDeviceFeatures2KHR features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+        features.pNext = &indexing;
+        getFeatures2(m_SelectedDeviceInfo.physicalDevice, &features);
+        if (!indexing.runtimeDescriptorArray || !indexing.descriptorBindingPartiallyBound ||
+            !indexing.descriptorBindingSampledImageUpdateAfterBind || !indexing.descriptorBindingUpdateUnusedWhilePending)
+            return false;
+
+        VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProps{};
+        indexingProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2KHR props{};
+        props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+        props.pNext = &indexingProps;
+        getProperties2(m_SelectedDeviceInfo.physicalDevice, &props);
+
+        // Plenty for an RTS material set; bounded so the descriptor pool stays small.
+        constexpr uint32_t kMaxBindlessTextures = 4096;
+        m_MaxBindlessTextures = std::min({kMaxBindlessTextures,
+                                          indexingProps.maxPerStageDescriptorUpdateAfterBindSamplers,
+                                          indexingProps.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                          indexingProps.maxDescriptorSetUpdateAfterBindSamplers,
+                                          indexingProps.maxDescriptorSetUpdateAfterBindSampledImages});
+        return m_MaxBindlessTextures > 0;
+    }
+
+    bool VulkanContext::queryPresentWaitSupport()
+    {
+        if (!m_PhysicalDeviceProperties2 || !deviceSupportsExtension(VK_KHR_PRESENT_ID_EXTENSION_NAME) ||
+            !deviceSupportsExtension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+            return false;
+
+        auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+            vkGetInstanceProcAddr(m_Instance, "vkGetPhysicalDeviceFeatures2KHR"));
+        if (!getFeatures2)
+            return false;
+
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWait{};
+        presentWait.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+        VkPhysicalDevicePresentIdFeaturesKHR presentId{};
+        presentId.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+        presentId.pNext = &presentWait;
+        VkPhysicalDeviceFeatures2KHR features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+        features.pNext = &presentId;
+        getFeatures2(m_SelectedDeviceInfo.physicalDevice, &features);
+        return presentId.presentId == VK_TRUE && presentWait.presentWait == VK_TRUE;
+    }
+
+    bool VulkanContext::deviceSupportsExtension(const char *name) const
+    {
+        uint32_t count = 0;
+        vkEnumerateDeviceExtensionProperties(m_SelectedDeviceInfo.physicalDevice, nullptr, &count, nullptr);
+        std::vector<VkExtensionProperties> props(count);
+        vkEnumerateDeviceExtensionProperties(m_SelectedDeviceInfo.physicalDevice, nullptr, &count, props.data());
+        for (const auto &p : props)
+        {
+            if (std::strcmp(p.extensionName, name) == 0)
+                return true;
+        }
+        return false;
     }
 }
\ No newline at end of file
@@ -0,0 +1,391 @@
+#include "BlockCompress.h"
+
+#include "assets/ModelFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "ThirdParty/Stb/stb_image.h"
+
+namespace sm = Engine::smodel;
+
+// ------------------------------------------------------------
+// Bit packing (LSB first, as BC6H/BC7 define it)
+// ------------------------------------------------------------
+struct BlockBits
+{
+    uint8_t bytes[16] = {};
+    uint32_t cursor = 0;
+
+    void put(uint32_t value, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i, ++cursor)
+        {
+            if (value & (1u << i))
+                bytes[cursor >> 3] |= uint8_t(1u << (cursor & 7));
+        }
+    }
+};
+
+// ------------------------------------------------------------
+// BC7 mode 6: RGBA 7-bit endpoints + per-endpoint p-bit, 4-bit indices
+// ------------------------------------------------------------
+static const int kBC7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct BC7Endpoints
+{
+    int q[2][4] = {}; // 7-bit channel values
+    int p[2] = {};    // p-bits
+};
+
+static void QuantizeEndpoint(const float v[4], int q[4], int &p)
+{
+    float bestErr = 1e30f;
+    for (int pb = 0; pb < 2; ++pb)
+    {
+        int cand[4];
+        float err = 0.0f;
+        for (int c = 0; c < 4; ++c)
+        {
+            cand[c] = std::clamp(int(std::lround((v[c] - pb) * 0.5f)), 0, 127);
+            const float d = float((cand[c] << 1) | pb) - v[c];
+            err += d * d;
+        }
+        if (err < bestErr)
+        {
+            bestErr = err;
+            p = pb;
+            std::memcpy(q, cand, sizeof(cand));
+        }
+    }
+}
+
+// Pick the best palette entry per texel; returns squared error.
+static float AssignBC7Indices(const uint8_t px[16][4], const BC7Endpoints &e, int indices[16])
+{
+    int palette[16][4];
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            const int a = (e.q[0][c] << 1) | e.p[0];
+            const int b = (e.q[1][c] << 1) | e.p[1];
+            palette[i][c] = ((64 - kBC7Weights4[i]) * a + kBC7Weights4[i] * b + 32) >> 6;
+        }
+    }
+
+    float total = 0.0f;
+    for (int t = 0; t < 16; ++t)
+    {
+        int best = 0;
+        int bestErr = 1 << 30;
+        for (int i = 0; i < 16; ++i)
+        {
+            int err = 0;
+            for (int c = 0; c < 4; ++c)
+            {
+                const int d = palette[i][c] - px[t][c];
+                err += d * d;
+            }
+            if (err < bestErr)
+            {
+                bestErr = err;
+                best = i;
+            }
+        }
+        indices[t] = best;
+        total += float(bestErr);
+    }
+    return total;
+}
+
+static void EncodeBC7Block(const uint8_t px[16][4], uint8_t out[16])
+{
+    // Principal axis of the block in RGBA space (power iteration on the covariance)
+    float mean[4] = {};
+    for (int t = 0; t < 16; ++t)
+        for (int c = 0; c < 4; ++c)
+            mean[c] += px[t][c] / 16.0f;
+
+    float cov[4][4] = {};
+    for (int t = 0; t < 16; ++t)
+    {
+        float d[4];
+        for (int c = 0; c < 4; ++c)
+            d[c] = px[t][c] - mean[c];
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+                cov[i][j] += d[i] * d[j];
+    }
+
+    float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    for (int iter = 0; iter < 8; ++iter)
+    {
+        float next[4] = {};
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+                next[i] += cov[i][j] * axis[j];
+        const float len = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+        if (len < 1e-6f)
+            break;
+        for (int i = 0; i < 4; ++i)
+            axis[i] = next[i] / len;
+    }
+
+    float tMin = 1e30f, tMax = -1e30f;
+    for (int t = 0; t < 16; ++t)
+    {
+        float proj = 0.0f;
+        for (int c = 0; c < 4; ++c)
+            proj += (px[t][c] - mean[c]) * axis[c];
+        tMin = std::min(tMin, proj);
+        tMax = std::max(tMax, proj);
+    }
+
+    float end[2][4];
+    for (int c = 0; c < 4; ++c)
+    {
+        end[0][c] = std::clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f);
+        end[1][c] = std::clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f);
+    }
+
+    BC7Endpoints best;
+    QuantizeEndpoint(end[0], best.q[0], best.p[0]);
+    QuantizeEndpoint(end[1], best.q[1], best.p[1]);
+    int bestIndices[16];
+    float bestErr = AssignBC7Indices(px, best, bestIndices);
+
+    // One least-squares refit of the endpoints against the chosen weights
+    {
+        float a = 0, b = 0, cc = 0, r0[4] = {}, r1[4] = {};
+        for (int t = 0; t < 16; ++t)
+        {
+            const float w = kBC7Weights4[bestIndices[t]] / 64.0f;
+            a += (1 - w) * (1 - w);
+            b += (1 - w) * w;
+            cc += w * w;
+            for (int c = 0; c < 4; ++c)
+            {
+                r0[c] += (1 - w) * px[t][c];
+                r1[c] += w * px[t][c];
+            }
+        }
+
+        const float det = a * cc - b * b;
+        if (std::fabs(det) > 1e-6f)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                end[0][c] = std::clamp((cc * r0[c] - b * r1[c]) / det, 0.0f, 255.0f);
+                end[1][c] = std::clamp((a * r1[c] - b * r0[c]) / det, 0.0f, 255.0f);
+            }
+
+            BC7Endpoints refit;
+            QuantizeEndpoint(end[0], refit.q[0], refit.p[0]);
+            QuantizeEndpoint(end[1], refit.q[1], refit.p[1]);
+            int refitIndices[16];
+            const float refitErr = AssignBC7Indices(px, refit, refitIndices);
+            if (refitErr < bestErr)
+            {
+                best = refit;
+                std::memcpy(bestIndices, refitIndices, sizeof(bestIndices));
+            }
+        }
+    }
+
+    // Anchor texel's index MSB is implicit 0: swap endpoints if needed.
+    if (bestIndices[0] & 8)
+    {
+        std::swap(best.q[0], best.q[1]);
+        std::swap(best.p[0], best.p[1]);
+        for (int t = 0; t < 16; ++t)
+            bestIndices[t] = 15 - bestIndices[t];
+    }
+
+    BlockBits bits;
+    bits.put(1u << 6, 7); // mode 6
+    for (int c = 0; c < 4; ++c)
+    {
+        bits.put(uint32_t(best.q[0][c]), 7);
+        bits.put(uint32_t(best.q[1][c]), 7);
+    }
+    bits.put(uint32_t(best.p[0]), 1);
+    bits.put(uint32_t(best.p[1]), 1);
+    bits.put(uint32_t(bestIndices[0]), 3);
+    for (int t = 1; t < 16; ++t)
+        bits.put(uint32_t(bestIndices[t]), 4);
+
+    std::memcpy(out, bits.bytes, 16);
+}
+
+// ------------------------------------------------------------
+// BC4 / BC5
+// ------------------------------------------------------------
+static void EncodeBC4Block(const uint8_t values[16], uint8_t out[8])
+{
+    uint8_t lo = 255, hi = 0;
+    for (int t = 0; t < 16; ++t)
+    {
+        lo = std::min(lo, values[t]);
+        hi = std::max(hi, values[t]);
+    }
+
+    out[0] = hi;
+    out[1] = lo;
+
+    // hi > lo selects the 8-value palette; a flat block uses index 0 everywhere.
+    int palette[8] = {hi, lo};
+    for (int i = 2; i < 8; ++i)
+        palette[i] = ((8 - i) * hi + (i - 1) * lo + 3) / 7;
+
+    uint64_t indexBits = 0;
+    for (int t = 0; t < 16; ++t)
+    {
+        int best = 0;
+        int bestErr = 1 << 30;
+        for (int i = 0; hi != lo && i < 8; ++i)
+        {
+            const int err = std::abs(palette[i] - values[t]);
+            if (err < bestErr)
+            {
+                bestErr = err;
+                best = i;
+            }
+        }
+        indexBits |= uint64_t(best) << (3 * t);
+    }
+
+    for (int i = 0; i < 6; ++i)
+        out[2 + i] = uint8_t(indexBits >> (8 * i));
+}
+
+static void EncodeBC5Block(const uint8_t px[16][4], uint8_t out[16])
+{
+    uint8_t r[16], g[16];
+    for (int t = 0; t < 16; ++t)
+    {
+        r[t] = px[t][0];
+        g[t] = px[t][1];
+    }
+    EncodeBC4Block(r, out);
+    EncodeBC4Block(g, out + 8);
+}
+
+// ------------------------------------------------------------
+// Mips + image encode
+// ------------------------------------------------------------
+static void DownsampleRGBA8(const std::vector<uint8_t> &src, uint32_t sw, uint32_t sh,
+                            std::vector<uint8_t> &dst, uint32_t dw, uint32_t dh, bool normalMap)
+{
+    dst.resize(size_t(dw) * dh * 4u);
+    for (uint32_t y = 0; y < dh; ++y)
+    {
+        const uint32_t y0 = std::min(y * 2u, sh - 1u);
+        const uint32_t y1 = std::min(y * 2u + 1u, sh - 1u);
+        for (uint32_t x = 0; x < dw; ++x)
+        {
+            const uint32_t x0 = std::min(x * 2u, sw - 1u);
+            const uint32_t x1 = std::min(x * 2u + 1u, sw - 1u);
+            const uint8_t *a = &src[(size_t(y0) * sw + x0) * 4u];
+            const uint8_t *b = &src[(size_t(y0) * sw + x1) * 4u];
+            const uint8_t *c = &src[(size_t(y1) * sw + x0) * 4u];
+            const uint8_t *d = &src[(size_t(y1) * sw + x1) * 4u];
+            uint8_t *o = &dst[(size_t(y) * dw + x) * 4u];
+            for (int k = 0; k < 4; ++k)
+                o[k] = static_cast<uint8_t>((unsigned(a[k]) + b[k] + c[k] + d[k] + 2u) >> 2);
+
+            // Averaged normals get shorter; push them back onto the unit sphere.
+            if (normalMap)
+            {
+                float n[3];
+                for (int k = 0; k < 3; ++k)
+                    n[k] = o[k] / 127.5f - 1.0f;
+                const float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                if (len > 1e-4f)
+                {
+                    for (int k = 0; k < 3; ++k)
+                        o[k] = uint8_t(std::clamp(std::lround((n[k] / len + 1.0f) * 127.5f), 0l, 255l));
+                }
+            }
+        }
+    }
+}
+
+static void EncodeLevel(const std::vector<uint8_t> &rgba, uint32_t w, uint32_t h,
+                        BlockFormat format, std::vector<uint8_t> &out)
+{
+    const uint32_t bw = (w + 3) / 4;
+    const uint32_t bh = (h + 3) / 4;
+    const size_t base = out.size();
+    out.resize(base + size_t(bw) * bh * 16u);
+
+    uint8_t px[16][4];
+    for (uint32_t by = 0; by < bh; ++by)
+    {
+        for (uint32_t bx = 0; bx < bw; ++bx)
+        {
+            // Edge blocks replicate the last row/column
+            for (uint32_t t = 0; t < 16; ++t)
+            {
+                const uint32_t x = std::min(bx * 4u + (t & 3u), w - 1u);
+                const uint32_t y = std::min(by * 4u + (t >> 2), h - 1u);
+                std::memcpy(px[t], &rgba[(size_t(y) * w + x) * 4u], 4);
+            }
+
+            uint8_t *dst = &out[base + (size_t(by) * bw + bx) * 16u];
+            if (format == BlockFormat::BC7)
+                EncodeBC7Block(px, dst);
+            else
+                EncodeBC5Block(px, dst);
+        }
+    }
+}
+
+bool CookBlockCompressedTexture(
+    const std::vector<uint8_t> &encodedBytes,
+    BlockFormat format,
+    std::vector<uint8_t> &outBytes)
+{
+    int w = 0, h = 0, comp = 0;
+    unsigned char *decoded = stbi_load_from_memory(
+        encodedBytes.data(), static_cast<int>(encodedBytes.size()), &w, &h, &comp, 4);
+    if (!decoded || w <= 0 || h <= 0)
+    {
+        if (decoded)
+            stbi_image_free(decoded);
+        return false;
+    }
+
+    std::vector<uint8_t> level(decoded, decoded + size_t(w) * h * 4u);
+    stbi_image_free(decoded);
+
+    sm::SModelBlockImageHeader header{};
+    header.width = uint32_t(w);
+    header.height = uint32_t(h);
+    header.mipCount = 1;
+    while ((header.width >> header.mipCount) || (header.height >> header.mipCount))
+        ++header.mipCount;
+
+    outBytes.clear();
+    outBytes.resize(sizeof(header));
+    std::memcpy(outBytes.data(), &header, sizeof(header));
+
+    const bool normalMap = (format == BlockFormat::BC5);
+    std::vector<uint8_t> next;
+    for (uint32_t i = 0; i < header.mipCount; ++i)
+    {
+        const uint32_t lw = std::max(1u, header.width >> i);
+        const uint32_t lh = std::max(1u, header.height >> i);
+        EncodeLevel(level, lw, lh, format, outBytes);
+
+        if (i + 1 < header.mipCount)
+        {
+            DownsampleRGBA8(level, lw, lh, next,
+                            std::max(1u, header.width >> (i + 1)), std::max(1u, header.height >> (i + 1)), normalMap);
+            level.swap(next);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// ------------------------------------------------------------
+// Offline block compression for cooked textures
+// ------------------------------------------------------------
+// Decodes PNG/JPG source bytes, builds a box-filtered mip chain and
+// encodes every level as 4x4 blocks of 16 bytes:
+// - BC7 (mode 6, single subset RGBA) for color/data textures
+// - BC5 (two BC4 channels, RG) for tangent-space normal maps
+//
+// Output layout matches the runtime: SModelBlockImageHeader followed by
+// the levels tightly packed (see SModelTextureRecord.h).
+
+enum class BlockFormat : uint32_t
+{
+    BC7,
+    BC5
+};
+
+// Returns false if the source image cannot be decoded.
+bool CookBlockCompressedTexture(
+    const std::vector<uint8_t> &encodedBytes,
+    BlockFormat format,
+    std::vector<uint8_t> &outBytes);
@@ -0,0 +1,175 @@
+#include "CookCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+static bool ReadWholeFile(const std::string &path, std::vector<uint8_t> &out)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open())
+        return false;
+    out.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    return true;
+}
+
+uint64_t HashBytes(const void *data, size_t size, uint64_t hash)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static int HexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// glTF URIs are percent-encoded ("my%20texture.png").
+static std::string DecodeUri(const std::string &uri)
+{
+    std::string out;
+    out.reserve(uri.size());
+    for (size_t i = 0; i < uri.size(); ++i)
+    {
+        if (uri[i] == '%' && i + 2 < uri.size())
+        {
+            const int hi = HexDigit(uri[i + 1]);
+            const int lo = HexDigit(uri[i + 2]);
+            if (hi >= 0 && lo >= 0)
+            {
+                out.push_back(static_cast<char>(hi * 16 + lo));
+                i += 2;
+                continue;
+            }
+        }
+        out.push_back(uri[i]);
+    }
+    return out;
+}
+
+std::vector<std::string> FindGltfDependencies(const std::string &inputPath)
+{
+    std::vector<std::string> deps;
+
+    std::vector<uint8_t> bytes;
+    if (!ReadWholeFile(inputPath, bytes))
+        return deps;
+
+    // .glb: only the first (JSON) chunk holds URIs; the BIN chunk may contain anything.
+    const char *json = reinterpret_cast<const char *>(bytes.data());
+    size_t jsonSize = bytes.size();
+    if (bytes.size() >= 20 && std::memcmp(bytes.data(), "glTF", 4) == 0)
+    {
+        uint32_t chunkLength = 0;
+        std::memcpy(&chunkLength, bytes.data() + 12, sizeof(chunkLength));
+        json = reinterpret_cast<const char *>(bytes.data() + 20);
+        jsonSize = std::min<size_t>(chunkLength, bytes.size() - 20);
+    }
+
+    const std::string text(json, jsonSize);
+    const std::filesystem::path modelDir = std::filesystem::path(inputPath).parent_path();
+
+    // Not a JSON parser: every "uri" key in glTF is a string naming a buffer or image.
+    size_t pos = 0;
+    while ((pos = text.find("\"uri\"", pos)) != std::string::npos)
+    {
+        pos += 5;
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r' || text[pos] == '\n' || text[pos] == ':'))
+            ++pos;
+        if (pos >= text.size() || text[pos] != '"')
+            continue;
+
+        std::string uri;
+        for (++pos; pos < text.size() && text[pos] != '"'; ++pos)
+        {
+            if (text[pos] == '\\' && pos + 1 < text.size())
+                ++pos; // "\/" and friends
+            uri.push_back(text[pos]);
+        }
+
+        if (uri.empty() || uri.rfind("data:", 0) == 0)
+            continue;
+
+        const std::filesystem::path dep = (modelDir / DecodeUri(uri)).lexically_normal();
+        deps.push_back(dep.generic_string());
+    }
+
+    return deps;
+}
+
+bool ComputeCookKey(const std::string &inputPath, const std::string &settingsTag, uint64_t &outKey)
+{
+    std::vector<uint8_t> bytes;
+    if (!ReadWholeFile(inputPath, bytes))
+        return false;
+
+    uint64_t h = HashBytes(settingsTag.data(), settingsTag.size());
+    h = HashBytes(bytes.data(), bytes.size(), h);
+
+    // Dependencies hash by name and content; a missing one hashes by name only, so it
+    // changes the key once the file shows up.
+    for (const std::string &dep : FindGltfDependencies(inputPath))
+    {
+        const std::string name = std::filesystem::path(dep).filename().generic_string();
+        h = HashBytes(name.data(), name.size() + 1, h);
+        if (ReadWholeFile(dep, bytes))
+            h = HashBytes(bytes.data(), bytes.size(), h);
+    }
+
+    outKey = h;
+    return true;
+}
+
+std::string CookKeyToString(uint64_t key)
+{
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(key));
+    return buf;
+}
+
+std::string CookStampPath(const std::string &outputPath)
+{
+    return outputPath + ".cookhash";
+}
+
+bool ReadCookStamp(const std::string &outputPath, uint64_t &outKey)
+{
+    std::ifstream f(CookStampPath(outputPath));
+    std::string text;
+    if (!f.is_open() || !(f >> text) || text.size() != 16)
+        return false;
+
+    uint64_t key = 0;
+    for (char c : text)
+    {
+        const int d = HexDigit(c);
+        if (d < 0)
+            return false;
+        key = (key << 4) | static_cast<uint64_t>(d);
+    }
+    outKey = key;
+    return true;
+}
+
+bool WriteCookStamp(const std::string &outputPath, uint64_t key)
+{
+    std::ofstream f(CookStampPath(outputPath), std::ios::trunc);
+    if (!f.is_open())
+        return false;
+    f << CookKeyToString(key) << "\n";
+    return static_cast<bool>(f);
+}
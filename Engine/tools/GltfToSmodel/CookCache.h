@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------
+// Incremental cooking: content keys and output stamps
+// ------------------------------------------------------------
+// A cook key is FNV-1a 64 over the cooker version, the cook options and the bytes of the
+// source file plus every file it references (glTF buffers and images). Each output gets a
+// "<output>.cookhash" stamp holding the key it was cooked from; a matching stamp means the
+// output is current. With a cache directory, outputs are also kept as "<cache>/<key>.smodel"
+// so switching branches or options back and forth doesn't recook.
+
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ull;
+
+uint64_t HashBytes(const void *data, size_t size, uint64_t hash = kFnvOffsetBasis);
+
+// External files a .gltf/.glb references through "uri" (data: URIs skipped), resolved
+// against the model directory. Missing files are still listed.
+std::vector<std::string> FindGltfDependencies(const std::string &inputPath);
+
+// False when the input itself can't be read.
+bool ComputeCookKey(const std::string &inputPath, const std::string &settingsTag, uint64_t &outKey);
+
+std::string CookKeyToString(uint64_t key);
+
+// Stamp sidecar next to a cooked output.
+std::string CookStampPath(const std::string &outputPath);
+bool ReadCookStamp(const std::string &outputPath, uint64_t &outKey);
+bool WriteCookStamp(const std::string &outputPath, uint64_t key);
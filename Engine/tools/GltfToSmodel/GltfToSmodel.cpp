@@ -11,10 +11,20 @@
 #include <filesystem>
 #include <cstring>
 #include <algorithm>
+#include <cmath>
 #include <functional>
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 // Your engine format header (adjust include path if needed)
 #include "assets/ModelFormat.h"
+#include "BlockCompress.h"
+#include "VertexQuantize.h"
+#include "MeshOptimize.h"
+#include "CookCache.h"
 
 #ifndef AI_MATKEY_GLTF_ALPHACUTOFF
 // Older Assimp doesn't expose this macro, but the property exists in glTF materials.
@@ -141,6 +151,9 @@ struct VertexPNTTJW
 };
 static_assert(sizeof(VertexPNTTJW) == 72, "VertexPNTTJW expected to be 72 bytes");
 
+// Stop the LOD chain below this many indices (a few dozen triangles).
+static constexpr size_t kMinLodIndices = 64 * 3;
+
 // ------------------------------------------------------------
 // AABB compute
 // ------------------------------------------------------------
@@ -293,7 +306,8 @@ struct LoadedImageBytes
 static LoadedImageBytes LoadTextureBytesFromAssimp(
     const aiScene *scene,
     const std::string &modelDir,
-    const std::string &assimpPath)
+    const std::string &assimpPath,
+    std::ostream &log)
 {
     LoadedImageBytes out{};
     out.debugURI = assimpPath;
@@ -304,14 +318,14 @@ static LoadedImageBytes LoadTextureBytesFromAssimp(
         const int idx = EmbeddedTextureIndex(assimpPath);
         if (!scene || idx < 0 || idx >= (int)scene->mNumTextures)
         {
-            std::cout << "Embedded texture index invalid: " << assimpPath << "\n";
+            log << "Embedded texture index invalid: " << assimpPath << "\n";
             return out;
         }
 
         const aiTexture *tex = scene->mTextures[idx];
         if (!tex)
         {
-            std::cout << "Embedded texture missing: " << assimpPath << "\n";
+            log << "Embedded texture missing: " << assimpPath << "\n";
             return out;
         }
 
@@ -328,8 +342,8 @@ static LoadedImageBytes LoadTextureBytesFromAssimp(
 
         // If it's raw (rare for glTF), we cannot store as compressed reliably without encoding.
         // You can add stb_image_write here later if you want to support it.
-        std::cout << "WARNING: Embedded texture is raw (mHeight>0). Not supported in phase 1: "
-                  << assimpPath << "\n";
+        log << "WARNING: Embedded texture is raw (mHeight>0). Not supported in phase 1: "
+            << assimpPath << "\n";
         return out;
     }
 
@@ -337,7 +351,7 @@ static LoadedImageBytes LoadTextureBytesFromAssimp(
     const std::string resolved = ResolveTexturePath(modelDir, assimpPath);
     if (!ReadFileBytes(resolved, out.bytes))
     {
-        std::cout << "Failed to read external texture: " << resolved << "\n";
+        log << "Failed to read external texture: " << resolved << "\n";
         return out;
     }
 
@@ -376,28 +390,189 @@ static inline float TicksToSeconds(double ticks, double ticksPerSecond)
     return (float)(ticks / tps);
 }
 
-static uint16_t AddVec3Sampler(const aiVectorKey *keys,
-                               uint32_t keyCount,
-                               double tps,
-                               sm::SModelAnimInterpolation interp,
-                               std::vector<float> &animTimes,
-                               std::vector<float> &animValues,
-                               std::vector<sm::SModelAnimationSamplerRecord> &animSamplers)
+// Sampler encoding shared by every track of a cook.
+struct AnimCookParams
+{
+    bool quantize = true;   // packed values (V4.4) instead of floats
+    float maxError = 1e-3f; // keyframe reduction tolerance: units for T/S, radians for R
+};
+
+// Rotation angle between two unit quats, from the chord length (acos of the dot product has no
+// float precision left near 1).
+static float QuatAngle(const float *a, const float *b)
+{
+    const float sign = (a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3] < 0.0f) ? -1.0f : 1.0f;
+    float chord = 0.0f;
+    for (int i = 0; i < 4; ++i)
+        chord += (a[i] - sign * b[i]) * (a[i] - sign * b[i]);
+    return 4.0f * std::asin(std::min(std::sqrt(chord) * 0.5f, 1.0f));
+}
+
+static void QuatSlerp(const float *a, const float *b, float t, float *out)
+{
+    float d = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    const float sign = (d < 0.0f) ? -1.0f : 1.0f;
+    d = std::fabs(d);
+    float wa = 1.0f - t, wb = t;
+    if (d < 0.9995f)
+    {
+        const float theta = std::acos(d);
+        const float sinTheta = std::sin(theta);
+        wa = std::sin((1.0f - t) * theta) / sinTheta;
+        wb = std::sin(t * theta) / sinTheta;
+    }
+    float len = 0.0f;
+    for (int i = 0; i < 4; ++i)
+    {
+        out[i] = wa * a[i] + wb * sign * b[i];
+        len += out[i] * out[i];
+    }
+    len = std::sqrt(len);
+    for (int i = 0; i < 4; ++i)
+        out[i] /= (len > 0.0f) ? len : 1.0f;
+}
+
+// Greedy keyframe reduction: from each kept key, extend the segment while interpolating between
+// its ends reproduces every skipped key within 'maxError'. The first and last keys stay; a track
+// that never leaves its first value collapses to one key. Returns the kept key indices.
+static std::vector<uint32_t> ReduceKeys(const std::vector<float> &times, const std::vector<float> &values,
+                                        uint32_t width, float maxError)
+{
+    const uint32_t n = static_cast<uint32_t>(times.size());
+    std::vector<uint32_t> kept;
+    if (n == 0)
+        return kept;
+    kept.push_back(0);
+
+    auto error = [&](uint32_t a, uint32_t b, uint32_t k)
+    {
+        const float span = times[b] - times[a];
+        const float t = (span > 0.0f) ? (times[k] - times[a]) / span : 0.0f;
+        const float *va = values.data() + size_t(a) * width;
+        const float *vb = values.data() + size_t(b) * width;
+        const float *vk = values.data() + size_t(k) * width;
+        if (width == 4)
+        {
+            float q[4];
+            QuatSlerp(va, vb, t, q);
+            return QuatAngle(q, vk);
+        }
+        float e = 0.0f;
+        for (uint32_t i = 0; i < width; ++i)
+            e = std::max(e, std::fabs(va[i] + (vb[i] - va[i]) * t - vk[i]));
+        return e;
+    };
+
+    uint32_t anchor = 0;
+    for (uint32_t end = anchor + 2; end < n; ++end)
+    {
+        bool fits = true;
+        for (uint32_t k = anchor + 1; k < end && fits; ++k)
+            fits = error(anchor, end, k) <= maxError;
+        if (!fits)
+        {
+            anchor = end - 1;
+            kept.push_back(anchor);
+        }
+    }
+    if (n > 1)
+        kept.push_back(n - 1);
+
+    // Constant track: every key within tolerance of the first.
+    if (kept.size() == 2)
+    {
+        bool constant = true;
+        for (uint32_t k = 1; k < n && constant; ++k)
+            constant = error(0, 0, k) <= maxError;
+        if (constant)
+            kept.pop_back();
+    }
+    return kept;
+}
+
+// Appends the reduced keys of one track (width 3: vec3, 4: XYZW quat) and returns its sampler index.
+static uint16_t AddSampler(std::vector<float> &&times,
+                           std::vector<float> &&values,
+                           uint32_t width,
+                           sm::SModelAnimInterpolation interp,
+                           const AnimCookParams &params,
+                           std::vector<float> &animTimes,
+                           std::vector<float> &animValues,
+                           std::vector<uint8_t> &animPacked,
+                           std::vector<sm::SModelAnimationSamplerRecord> &animSamplers)
 {
+    if (width == 4)
+    {
+        // Hemisphere continuity, so neighbouring keys interpolate the short way.
+        for (size_t k = 1; k < times.size(); ++k)
+        {
+            float *q = values.data() + k * 4;
+            const float *p = q - 4;
+            if (p[0] * q[0] + p[1] * q[1] + p[2] * q[2] + p[3] * q[3] < 0.0f)
+            {
+                for (int i = 0; i < 4; ++i)
+                    q[i] = -q[i];
+            }
+        }
+    }
+
+    const std::vector<uint32_t> kept = ReduceKeys(times, values, width, params.maxError);
+    const uint32_t keyCount = static_cast<uint32_t>(kept.size());
+
     sm::SModelAnimationSamplerRecord s{};
     s.firstTime = (uint32_t)animTimes.size();
     s.timeCount = keyCount;
-    s.firstValue = (uint32_t)animValues.size();
-    s.valueCount = keyCount * 3;
     s.interpolation = (uint8_t)interp;
-    s.valueType = (uint8_t)sm::SModelAnimValueType::Vec3;
+    for (uint32_t k : kept)
+        animTimes.push_back(times[k]);
 
-    for (uint32_t i = 0; i < keyCount; i++)
+    if (!params.quantize)
     {
-        animTimes.push_back(TicksToSeconds(keys[i].mTime, tps));
-        animValues.push_back((float)keys[i].mValue.x);
-        animValues.push_back((float)keys[i].mValue.y);
-        animValues.push_back((float)keys[i].mValue.z);
+        s.valueType = (uint8_t)((width == 4) ? sm::SModelAnimValueType::Quat : sm::SModelAnimValueType::Vec3);
+        s.firstValue = (uint32_t)animValues.size();
+        s.valueCount = keyCount * width;
+        for (uint32_t k : kept)
+            animValues.insert(animValues.end(), values.begin() + size_t(k) * width, values.begin() + size_t(k + 1) * width);
+    }
+    else
+    {
+        s.valueType = (uint8_t)((width == 4) ? sm::SModelAnimValueType::QuatSmallest3 : sm::SModelAnimValueType::Vec3Quantized);
+        animPacked.resize((animPacked.size() + 3) & ~size_t(3), 0); // ranges start 4-byte aligned
+        s.firstValue = (uint32_t)animPacked.size();
+        s.valueCount = sm::animPackedBytes(s.valueType, keyCount);
+        animPacked.resize(animPacked.size() + s.valueCount, 0);
+        uint8_t *dst = animPacked.data() + s.firstValue;
+
+        if (width == 4)
+        {
+            for (uint32_t k : kept)
+            {
+                sm::packQuatSmallest3(values.data() + size_t(k) * 4, dst);
+                dst += sm::kAnimPackedKeyBytes;
+            }
+        }
+        else
+        {
+            sm::SModelAnimVec3Range range{};
+            for (int i = 0; i < 3; ++i)
+            {
+                float lo = values[size_t(kept[0]) * 3 + i], hi = lo;
+                for (uint32_t k : kept)
+                {
+                    lo = std::min(lo, values[size_t(k) * 3 + i]);
+                    hi = std::max(hi, values[size_t(k) * 3 + i]);
+                }
+                range.min[i] = lo;
+                range.extent[i] = hi - lo;
+            }
+            std::memcpy(dst, &range, sizeof(range));
+            dst += sizeof(range);
+            for (uint32_t k : kept)
+            {
+                sm::packVec3Quantized(values.data() + size_t(k) * 3, range, dst);
+                dst += sm::kAnimPackedKeyBytes;
+            }
+        }
     }
 
     uint32_t samplerIndex = (uint32_t)animSamplers.size();
@@ -405,35 +580,50 @@ static uint16_t AddVec3Sampler(const aiVectorKey *keys,
     return (uint16_t)samplerIndex;
 }
 
-static uint16_t AddQuatSampler(const aiQuatKey *keys,
+static uint16_t AddVec3Sampler(const aiVectorKey *keys,
                                uint32_t keyCount,
                                double tps,
                                sm::SModelAnimInterpolation interp,
+                               const AnimCookParams &params,
                                std::vector<float> &animTimes,
                                std::vector<float> &animValues,
+                               std::vector<uint8_t> &animPacked,
                                std::vector<sm::SModelAnimationSamplerRecord> &animSamplers)
 {
-    sm::SModelAnimationSamplerRecord s{};
-    s.firstTime = (uint32_t)animTimes.size();
-    s.timeCount = keyCount;
-    s.firstValue = (uint32_t)animValues.size();
-    s.valueCount = keyCount * 4;
-    s.interpolation = (uint8_t)interp;
-    s.valueType = (uint8_t)sm::SModelAnimValueType::Quat;
-
+    std::vector<float> times(keyCount), values(size_t(keyCount) * 3);
     for (uint32_t i = 0; i < keyCount; i++)
     {
-        animTimes.push_back(TicksToSeconds(keys[i].mTime, tps));
-        // Store quat as XYZW (consistent with loader validation expectations)
-        animValues.push_back((float)keys[i].mValue.x);
-        animValues.push_back((float)keys[i].mValue.y);
-        animValues.push_back((float)keys[i].mValue.z);
-        animValues.push_back((float)keys[i].mValue.w);
+        times[i] = TicksToSeconds(keys[i].mTime, tps);
+        values[i * 3 + 0] = (float)keys[i].mValue.x;
+        values[i * 3 + 1] = (float)keys[i].mValue.y;
+        values[i * 3 + 2] = (float)keys[i].mValue.z;
     }
+    return AddSampler(std::move(times), std::move(values), 3, interp, params, animTimes, animValues, animPacked, animSamplers);
+}
 
-    uint32_t samplerIndex = (uint32_t)animSamplers.size();
-    animSamplers.push_back(s);
-    return (uint16_t)samplerIndex;
+static uint16_t AddQuatSampler(const aiQuatKey *keys,
+                               uint32_t keyCount,
+                               double tps,
+                               sm::SModelAnimInterpolation interp,
+                               const AnimCookParams &params,
+                               std::vector<float> &animTimes,
+                               std::vector<float> &animValues,
+                               std::vector<uint8_t> &animPacked,
+                               std::vector<sm::SModelAnimationSamplerRecord> &animSamplers)
+{
+    std::vector<float> times(keyCount), values(size_t(keyCount) * 4);
+    for (uint32_t i = 0; i < keyCount; i++)
+    {
+        times[i] = TicksToSeconds(keys[i].mTime, tps);
+        // Store quat as XYZW (consistent with loader validation expectations), normalized for packing
+        aiQuaternion q = keys[i].mValue;
+        q.Normalize();
+        values[i * 4 + 0] = (float)q.x;
+        values[i * 4 + 1] = (float)q.y;
+        values[i * 4 + 2] = (float)q.z;
+        values[i * 4 + 3] = (float)q.w;
+    }
+    return AddSampler(std::move(times), std::move(values), 4, interp, params, animTimes, animValues, animPacked, animSamplers);
 }
 
 static void WriteBytes(std::ofstream &out, const std::vector<uint8_t> &b)
@@ -449,23 +639,29 @@ static void WriteChars(std::ofstream &out, const std::vector<char> &c)
 }
 
 // ------------------------------------------------------------
-// Main
+// Cook one model
 // ------------------------------------------------------------
-int main(int argc, char **argv)
+struct CookOptions
+{
+    bool compressTextures = true;
+    bool quantizeVertices = true;
+    bool buildMeshlets = false;
+    uint32_t lodLevels = sm::kMaxPrimitiveLods;
+    AnimCookParams anim;
+};
+
+// Returns 0 on success, 1 when the import fails, 2 when the output can't be written.
+// All progress goes to 'log' so manifest jobs can buffer their output per model.
+static int CookModel(const std::string &inputArg, const std::string &outputArg, const CookOptions &opts, std::ostream &log)
 {
-    if (argc < 3)
-    {
-        std::cout << "Usage: GltfToSModel <input.gltf/.glb> <output.smodel>\n";
-        return 0;
-    }
 
-    const std::string inputPath = NormalizePathSlashes(argv[1]);
-    const std::string outputPath = NormalizePathSlashes(argv[2]);
+    const std::string inputPath = NormalizePathSlashes(inputArg);
+    const std::string outputPath = NormalizePathSlashes(outputArg);
     const std::string modelDir = GetDirectoryOfFile(inputPath);
 
-    std::cout << "Input  : " << inputPath << "\n";
-    std::cout << "Output : " << outputPath << "\n";
-    std::cout << "ModelDir: " << modelDir << "\n";
+    log << "Input  : " << inputPath << "\n";
+    log << "Output : " << outputPath << "\n";
+    log << "ModelDir: " << modelDir << "\n";
 
     // ------------------------------------------------------------
     // Assimp importer options:
@@ -489,7 +685,7 @@ int main(int argc, char **argv)
     const aiScene *scene = importer.ReadFile(inputPath, flags);
     if (!scene)
     {
-        std::cout << "Assimp failed: " << importer.GetErrorString() << "\n";
+        log << "Assimp failed: " << importer.GetErrorString() << "\n";
         return 1;
     }
 
@@ -513,6 +709,16 @@ int main(int argc, char **argv)
     std::vector<sm::SModelAnimationSamplerRecord> animSamplers;
     std::vector<float> animTimes;  // seconds
     std::vector<float> animValues; // packed floats (vec3/quats)
+    std::vector<uint8_t> animPacked; // quantized samplers (V4.4)
+    const AnimCookParams &animParams = opts.anim;
+
+    // Meshlets (V4.2, --meshlets)
+    std::vector<sm::SModelMeshletRecord> meshletRecords;
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint8_t> meshletTriangles;
+
+    // Primitive LODs (V4.3)
+    std::vector<sm::SModelPrimitiveLodRecord> primitiveLods;
 
     // Skinning (V4)
     struct TmpSkin
@@ -554,7 +760,7 @@ int main(int argc, char **argv)
             return it->second;
 
         // Load bytes
-        LoadedImageBytes img = LoadTextureBytesFromAssimp(scene, modelDir, assimpTexPath);
+        LoadedImageBytes img = LoadTextureBytesFromAssimp(scene, modelDir, assimpTexPath, log);
         if (!img.ok)
             return -1;
 
@@ -579,8 +785,26 @@ int main(int argc, char **argv)
         tr.mipFilter = DefaultMipNone();
         tr.maxAnisotropy = 1.0f;
 
+        // Block-compress offline so the runtime uploads the mip chain as-is
+        if (opts.compressTextures)
+        {
+            const bool normalMap = (type == aiTextureType_NORMALS);
+            std::vector<uint8_t> cooked;
+            if (CookBlockCompressedTexture(img.bytes, normalMap ? BlockFormat::BC5 : BlockFormat::BC7, cooked))
+            {
+                tr.encoding = static_cast<uint32_t>(normalMap ? sm::ImageEncoding::BC5 : sm::ImageEncoding::BC7);
+                tr.mipFilter = static_cast<uint32_t>(sm::MipMode::Linear);
+                img.bytes.swap(cooked);
+            }
+            else
+            {
+                log << "WARNING: cannot decode texture for compression, embedding source bytes: "
+                    << img.debugURI << "\n";
+            }
+        }
+
         // Blob store (compressed)
-        blob.align(8);
+        blob.align(16);
         tr.imageDataOffset = blob.append(img.bytes.data(), img.bytes.size());
         tr.imageDataSize = static_cast<uint32_t>(img.bytes.size());
 
@@ -935,6 +1159,70 @@ int main(int argc, char **argv)
             indices.push_back(face.mIndices[2]);
         }
 
+        // Reorder for the post-transform cache, overdraw and vertex fetch (in that order).
+        // LODs are appended to 'indices' after LOD 0 and share the vertices.
+        const uint32_t lod0IndexCount = static_cast<uint32_t>(indices.size());
+        std::vector<sm::SModelPrimitiveLodRecord> meshLods;
+        if (!indices.empty())
+        {
+            const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+            const float acmrIn = ComputeACMR(indices, vertexCount);
+
+            OptimizeVertexCache(indices, vertexCount);
+            OptimizeOverdraw(indices, vertices[0].pos, sizeof(VertexPNTTJW), vertexCount);
+
+            // Each level targets a quarter of the previous level's triangles, simplified from LOD 0 so
+            // the error is measured against the full mesh.
+            size_t prevCount = indices.size();
+            for (uint32_t level = 1; level <= opts.lodLevels; ++level)
+            {
+                const size_t target = (lod0IndexCount >> (2 * level)) / 3 * 3;
+                if (target < kMinLodIndices)
+                    break;
+
+                float error = 0.0f;
+                std::vector<uint32_t> lod = SimplifyMesh(std::vector<uint32_t>(indices.begin(), indices.begin() + lod0IndexCount),
+                                                         vertices[0].pos, sizeof(VertexPNTTJW), vertexCount, target, error);
+                if (lod.empty() || lod.size() * 5 > prevCount * 4)
+                    break; // locked borders/seams: no worthwhile reduction
+                OptimizeVertexCache(lod, vertexCount);
+
+                sm::SModelPrimitiveLodRecord lr{};
+                lr.firstIndex = static_cast<uint32_t>(indices.size());
+                lr.indexCount = static_cast<uint32_t>(lod.size());
+                lr.error = error;
+                meshLods.push_back(lr);
+
+                prevCount = lod.size();
+                indices.insert(indices.end(), lod.begin(), lod.end());
+            }
+
+            std::vector<uint32_t> remap;
+            const uint32_t usedCount = OptimizeVertexFetch(indices, vertexCount, remap);
+            std::vector<VertexPNTTJW> reordered(usedCount);
+            for (uint32_t vi = 0; vi < vertexCount; ++vi)
+            {
+                if (remap[vi] != UINT32_MAX)
+                    reordered[remap[vi]] = vertices[vi];
+            }
+            vertices.swap(reordered);
+
+            log << "  mesh " << meshIdx << ": ACMR " << acmrIn << " -> " << ComputeACMR(indices, usedCount);
+            if (usedCount != vertexCount)
+                log << ", dropped " << (vertexCount - usedCount) << " unreferenced vertices";
+            for (const sm::SModelPrimitiveLodRecord &lr : meshLods)
+                log << ", LOD " << (lr.indexCount / 3) << " tris (error " << lr.error << ")";
+            log << "\n";
+
+            if (opts.buildMeshlets)
+            {
+                const std::vector<uint32_t> lod0(indices.begin(), indices.begin() + lod0IndexCount);
+                BuildMeshlets(lod0, vertices[0].pos, sizeof(VertexPNTTJW), usedCount,
+                              static_cast<uint32_t>(meshRecords.size()),
+                              meshletRecords, meshletVertices, meshletTriangles);
+            }
+        }
+
         // Fill mesh record
         sm::SModelMeshRecord mr{};
         {
@@ -944,11 +1232,6 @@ int main(int argc, char **argv)
 
         mr.vertexCount = static_cast<uint32_t>(vertices.size());
         mr.indexCount = static_cast<uint32_t>(indices.size());
-        mr.vertexStride = static_cast<uint32_t>(sizeof(VertexPNTTJW));
-
-        // layout flags should match your enum in ModelFormats.h
-        // If your enum differs, update accordingly.
-        mr.layoutFlags = sm::VTX_POS | sm::VTX_NORMAL | sm::VTX_UV0 | sm::VTX_TANGENT | sm::VTX_JOINTS | sm::VTX_WEIGHTS;
 
         // Indices are always U32 in phase 1
         mr.indexType = 1; // assume 1=U32 (match your IndexType enum if different)
@@ -956,10 +1239,58 @@ int main(int argc, char **argv)
         // AABB
         ComputeAABB(vertices, mr.aabbMin, mr.aabbMax);
 
-        // Store vertex/index bytes in blob
+        // The quantized layout stores joints as u8; larger skeletons keep the float layout.
+        uint32_t maxJoint = 0;
+        for (const auto &vx : vertices)
+            maxJoint = std::max<uint32_t>(maxJoint, *std::max_element(vx.joints, vx.joints + 4));
+
+        float qMin[3];
+        float qExtent[3];
+        const bool boxFits = SnapQuantizationBox(mr.aabbMin, mr.aabbMax, qMin, qExtent);
+
         blob.align(8);
-        mr.vertexDataOffset = blob.append(vertices.data(), vertices.size() * sizeof(VertexPNTTJW));
-        mr.vertexDataSize = static_cast<uint32_t>(vertices.size() * sizeof(VertexPNTTJW));
+        if (opts.quantizeVertices && maxJoint < 256u && boxFits)
+        {
+            std::vector<sm::SModelVertexQuantized> packed(vertices.size());
+            for (size_t vi = 0; vi < vertices.size(); ++vi)
+            {
+                const VertexPNTTJW &v = vertices[vi];
+                sm::SModelVertexQuantized &q = packed[vi];
+                for (int a = 0; a < 3; ++a)
+                    q.pos[a] = QuantizeUnorm16(v.pos[a], qMin[a], qExtent[a]);
+                q.pos[3] = 0xFFFFu;
+                OctEncodeSnorm16(v.normal, q.normal);
+                for (int a = 0; a < 4; ++a)
+                    q.tangent[a] = FloatToSnorm8(v.tangent[a]);
+                q.uv0[0] = FloatToHalf(v.uv0[0]);
+                q.uv0[1] = FloatToHalf(v.uv0[1]);
+                for (int a = 0; a < 4; ++a)
+                    q.joints[a] = static_cast<uint8_t>(v.joints[a]);
+                WeightsToUnorm8(v.weights, q.weights);
+            }
+
+            // The runtime dequantizes against the record AABB: store the snapped box.
+            for (int a = 0; a < 3; ++a)
+            {
+                mr.aabbMin[a] = qMin[a];
+                mr.aabbMax[a] = qMin[a] + qExtent[a];
+            }
+
+            mr.vertexStride = static_cast<uint32_t>(sizeof(sm::SModelVertexQuantized));
+            mr.layoutFlags = sm::kVertexLayoutQuantized;
+            mr.vertexDataOffset = blob.append(packed.data(), packed.size() * sizeof(sm::SModelVertexQuantized));
+            mr.vertexDataSize = static_cast<uint32_t>(packed.size() * sizeof(sm::SModelVertexQuantized));
+        }
+        else
+        {
+            if (opts.quantizeVertices)
+                log << "  mesh " << meshIdx << ": joint index > 255 or bounds beyond half range, keeping float vertices\n";
+
+            mr.vertexStride = static_cast<uint32_t>(sizeof(VertexPNTTJW));
+            mr.layoutFlags = sm::kVertexLayoutFull;
+            mr.vertexDataOffset = blob.append(vertices.data(), vertices.size() * sizeof(VertexPNTTJW));
+            mr.vertexDataSize = static_cast<uint32_t>(vertices.size() * sizeof(VertexPNTTJW));
+        }
 
         blob.align(8);
         mr.indexDataOffset = blob.append(indices.data(), indices.size() * sizeof(uint32_t));
@@ -973,10 +1304,15 @@ int main(int argc, char **argv)
         pr.meshIndex = outMeshIndex;
         pr.materialIndex = static_cast<uint32_t>(mesh->mMaterialIndex);
         pr.firstIndex = 0;
-        pr.indexCount = mr.indexCount;
+        pr.indexCount = lod0IndexCount;
         pr.vertexOffset = 0;
         pr.skinIndex = skinIndex;
 
+        for (sm::SModelPrimitiveLodRecord &lr : meshLods)
+        {
+            lr.primitiveIndex = static_cast<uint32_t>(primRecords.size());
+            primitiveLods.push_back(lr);
+        }
         primRecords.push_back(pr);
         meshIndexToPrimIndex[meshIdx] = static_cast<int32_t>(primRecords.size() - 1);
     }
@@ -1071,7 +1407,7 @@ int main(int argc, char **argv)
             auto it = nodeNameToIndex.find(jointName);
             if (it == nodeNameToIndex.end())
             {
-                std::cout << "Skin joint node not found in node table: '" << jointName << "'\n";
+                log << "Skin joint node not found in node table: '" << jointName << "'\n";
                 return 2;
             }
             skinJointNodeIndices.push_back(it->second);
@@ -1131,8 +1467,10 @@ int main(int argc, char **argv)
                                                                  (uint32_t)ch->mNumPositionKeys,
                                                                  tps,
                                                                  interp,
+                                                                 animParams,
                                                                  animTimes,
                                                                  animValues,
+                                                                 animPacked,
                                                                  animSamplers);
 
                     sm::SModelAnimationChannelRecord outCh{};
@@ -1150,8 +1488,10 @@ int main(int argc, char **argv)
                                                                  (uint32_t)ch->mNumRotationKeys,
                                                                  tps,
                                                                  interp,
+                                                                 animParams,
                                                                  animTimes,
                                                                  animValues,
+                                                                 animPacked,
                                                                  animSamplers);
 
                     sm::SModelAnimationChannelRecord outCh{};
@@ -1169,8 +1509,10 @@ int main(int argc, char **argv)
                                                                  (uint32_t)ch->mNumScalingKeys,
                                                                  tps,
                                                                  interp,
+                                                                 animParams,
                                                                  animTimes,
                                                                  animValues,
+                                                                 animPacked,
                                                                  animSamplers);
 
                     sm::SModelAnimationChannelRecord outCh{};
@@ -1209,13 +1551,16 @@ int main(int argc, char **argv)
     // SkinJointNodeIndices
     // SkinInverseBindMatrices
     // Anim*
+    // Meshlets, MeshletVertices, MeshletTriangles
+    // PrimitiveLods
+    // AnimPacked (4-byte aligned)
     // StringTable
     // Blob
     // ------------------------------------------------------------
     sm::SModelHeader header{};
     header.magic = sm::SMODEL_MAGIC;
     header.versionMajor = 4;
-    header.versionMinor = 0;
+    header.versionMinor = 4; // 4.1: quantized vertex layouts, 4.2: meshlets, 4.3: primitive LODs, 4.4: packed animation
 
     header.meshCount = static_cast<uint32_t>(meshRecords.size());
     header.primitiveCount = static_cast<uint32_t>(primRecords.size());
@@ -1233,6 +1578,10 @@ int main(int argc, char **argv)
     header.animSamplersCount = static_cast<uint32_t>(animSamplers.size());
     header.animTimesCount = static_cast<uint32_t>(animTimes.size());
     header.animValuesCount = static_cast<uint32_t>(animValues.size());
+    header.meshletCount = static_cast<uint32_t>(meshletRecords.size());
+    header.meshletVerticesCount = static_cast<uint32_t>(meshletVertices.size());
+    header.meshletTrianglesCount = static_cast<uint32_t>(meshletTriangles.size());
+    header.primitiveLodCount = static_cast<uint32_t>(primitiveLods.size());
 
     uint64_t cursor = sizeof(sm::SModelHeader);
 
@@ -1286,6 +1635,27 @@ int main(int argc, char **argv)
     header.animValuesOffset = static_cast<uint32_t>(cursor);
     cursor += uint64_t(animValues.size()) * sizeof(float);
 
+    // Meshlets (V4.2)
+    header.meshletsOffset = static_cast<uint32_t>(cursor);
+    cursor += uint64_t(meshletRecords.size()) * sizeof(sm::SModelMeshletRecord);
+
+    header.meshletVerticesOffset = static_cast<uint32_t>(cursor);
+    cursor += uint64_t(meshletVertices.size()) * sizeof(uint32_t);
+
+    header.meshletTrianglesOffset = static_cast<uint32_t>(cursor);
+    cursor += uint64_t(meshletTriangles.size());
+
+    // Primitive LODs (V4.3)
+    header.primitiveLodsOffset = static_cast<uint32_t>(cursor);
+    cursor += uint64_t(primitiveLods.size()) * sizeof(sm::SModelPrimitiveLodRecord);
+
+    // Packed animation values (V4.4)
+    const uint64_t animPackedPad = (4 - (cursor & 3)) & 3;
+    cursor += animPackedPad;
+    header.animPackedOffset = static_cast<uint32_t>(cursor);
+    header.animPackedSize = static_cast<uint32_t>(animPacked.size());
+    cursor += animPacked.size();
+
     header.stringTableOffset = cursor;
     header.stringTableSize = static_cast<uint64_t>(strings.data.size());
     cursor += strings.data.size();
@@ -1304,7 +1674,7 @@ int main(int argc, char **argv)
     std::ofstream out(outputPath, std::ios::binary);
     if (!out.is_open())
     {
-        std::cout << "Failed to open output file: " << outputPath << "\n";
+        log << "Failed to open output file: " << outputPath << "\n";
         return 2;
     }
 
@@ -1324,27 +1694,306 @@ int main(int argc, char **argv)
     WriteVector(out, animSamplers);
     WriteVector(out, animTimes);
     WriteVector(out, animValues);
+    WriteVector(out, meshletRecords);
+    WriteVector(out, meshletVertices);
+    WriteVector(out, meshletTriangles);
+    WriteVector(out, primitiveLods);
+    WriteBytes(out, std::vector<uint8_t>(animPackedPad, 0));
+    WriteBytes(out, animPacked);
     WriteChars(out, strings.data);
     WriteBytes(out, blob.bytes);
 
     out.close();
 
-    std::cout << "\nCook complete \n";
-    std::cout << "Meshes     : " << header.meshCount << "\n";
-    std::cout << "Primitives : " << header.primitiveCount << "\n";
-    std::cout << "Materials  : " << header.materialCount << "\n";
-    std::cout << "Textures   : " << header.textureCount << "\n";
-    std::cout << "Nodes      : " << header.nodeCount << "\n";
-    std::cout << "NodePrimIx : " << header.nodePrimitiveIndexCount << "\n";
-    std::cout << "Skins      : " << header.skinCount << "\n";
-    std::cout << "AnimClips  : " << header.animClipsCount << "\n";
-    std::cout << "AnimChans  : " << header.animChannelsCount << "\n";
-    std::cout << "AnimSamplers: " << header.animSamplersCount << "\n";
-    std::cout << "AnimTimes  : " << header.animTimesCount << " floats\n";
-    std::cout << "AnimValues : " << header.animValuesCount << " floats\n";
-    std::cout << "StringTable: " << header.stringTableSize << " bytes\n";
-    std::cout << "Blob       : " << header.blobSize << " bytes\n";
-    std::cout << "FileSize   : " << header.fileSizeBytes << " bytes\n";
+    log << "\nCook complete \n";
+    log << "Meshes     : " << header.meshCount << "\n";
+    log << "Primitives : " << header.primitiveCount << "\n";
+    log << "Materials  : " << header.materialCount << "\n";
+    log << "Textures   : " << header.textureCount << "\n";
+    log << "Nodes      : " << header.nodeCount << "\n";
+    log << "NodePrimIx : " << header.nodePrimitiveIndexCount << "\n";
+    log << "Skins      : " << header.skinCount << "\n";
+    log << "AnimClips  : " << header.animClipsCount << "\n";
+    log << "AnimChans  : " << header.animChannelsCount << "\n";
+    log << "AnimSamplers: " << header.animSamplersCount << "\n";
+    log << "AnimTimes  : " << header.animTimesCount << " floats\n";
+    log << "AnimValues : " << header.animValuesCount << " floats\n";
+    log << "AnimPacked : " << header.animPackedSize << " bytes\n";
+    log << "Meshlets   : " << header.meshletCount << "\n";
+    log << "PrimLODs   : " << header.primitiveLodCount << "\n";
+    log << "StringTable: " << header.stringTableSize << " bytes\n";
+    log << "Blob       : " << header.blobSize << " bytes\n";
+    log << "FileSize   : " << header.fileSizeBytes << " bytes\n";
 
     return 0;
 }
+
+// ------------------------------------------------------------
+// Manifest mode: many models, cooked in parallel, only when changed
+// ------------------------------------------------------------
+// Bump when the cooker's output changes without a format version change
+// (new optimizer heuristics, encoder fixes...) so stamps and cache entries go stale.
+static const char *kCookerVersion = "GltfToSmodel 4.4.0";
+
+struct CookJob
+{
+    std::string input;
+    std::string output;
+};
+
+// One "<input> <output>" pair per line (quote paths with spaces); '#' starts a comment.
+// Relative paths are relative to the manifest.
+static bool ReadManifest(const std::string &manifestPath, std::vector<CookJob> &outJobs)
+{
+    std::ifstream f(manifestPath);
+    if (!f.is_open())
+        return false;
+
+    const std::filesystem::path baseDir = std::filesystem::path(manifestPath).parent_path();
+    auto resolve = [&](const std::string &p)
+    {
+        std::filesystem::path fp(p);
+        if (!fp.is_absolute())
+            fp = baseDir / fp;
+        return NormalizePathSlashes(fp.lexically_normal().string());
+    };
+
+    std::string line;
+    uint32_t lineNo = 0;
+    while (std::getline(f, line))
+    {
+        ++lineNo;
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+            continue;
+
+        std::istringstream ls(line);
+        CookJob job;
+        if (!(ls >> std::quoted(job.input) >> std::quoted(job.output)))
+        {
+            std::cout << manifestPath << ":" << lineNo << ": expected '<input> <output>', skipped\n";
+            continue;
+        }
+        job.input = resolve(job.input);
+        job.output = resolve(job.output);
+        outJobs.push_back(std::move(job));
+    }
+    return true;
+}
+
+static std::string CookSettingsTag(const CookOptions &opts)
+{
+    std::ostringstream tag;
+    tag << kCookerVersion
+        << " textures=" << (opts.compressTextures ? "bc" : "source")
+        << " vertices=" << (opts.quantizeVertices ? "quantized" : "float")
+        << " meshlets=" << (opts.buildMeshlets ? 1 : 0)
+        << " lods=" << opts.lodLevels
+        << " anim=" << (opts.anim.quantize ? "quantized" : "float")
+        << " animError=" << opts.anim.maxError;
+    return tag.str();
+}
+
+enum class CookResult
+{
+    Cooked,
+    UpToDate,
+    FromCache,
+    Failed
+};
+
+static CookResult CookIncremental(const CookJob &job, const CookOptions &opts, const std::string &settings,
+                                  const std::string &cacheDir, bool force, std::ostream &log)
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+
+    uint64_t key = 0;
+    if (!ComputeCookKey(job.input, settings, key))
+    {
+        log << "Failed to read input: " << job.input << "\n";
+        return CookResult::Failed;
+    }
+
+    uint64_t stamped = 0;
+    if (!force && fs::exists(job.output, ec) && ReadCookStamp(job.output, stamped) && stamped == key)
+        return CookResult::UpToDate;
+
+    // Drop the old stamp first so a failed cook never leaves a stale output looking current.
+    fs::remove(CookStampPath(job.output), ec);
+
+    const std::string cached = cacheDir.empty() ? std::string() : (fs::path(cacheDir) / (CookKeyToString(key) + ".smodel")).string();
+    if (!force && !cached.empty() && fs::exists(cached, ec))
+    {
+        fs::create_directories(fs::path(job.output).parent_path(), ec);
+        if (fs::copy_file(cached, job.output, fs::copy_options::overwrite_existing, ec))
+        {
+            WriteCookStamp(job.output, key);
+            return CookResult::FromCache;
+        }
+        log << "WARNING: cache copy failed (" << ec.message() << "), recooking: " << job.input << "\n";
+    }
+
+    if (CookModel(job.input, job.output, opts, log) != 0)
+        return CookResult::Failed;
+
+    WriteCookStamp(job.output, key);
+
+    if (!cached.empty())
+    {
+        // Copy-then-rename: another job (or a concurrent build) may publish the same key.
+        const std::string temp = cached + ".tmp" + CookKeyToString(HashBytes(job.output.data(), job.output.size()));
+        fs::create_directories(cacheDir, ec);
+        if (fs::copy_file(job.output, temp, fs::copy_options::overwrite_existing, ec))
+        {
+            fs::rename(temp, cached, ec);
+            if (ec)
+                fs::remove(temp, ec);
+        }
+    }
+    return CookResult::Cooked;
+}
+
+static int RunManifest(const std::string &manifestPath, const CookOptions &opts, uint32_t jobCount,
+                       const std::string &cacheDir, bool force)
+{
+    std::vector<CookJob> jobs;
+    if (!ReadManifest(manifestPath, jobs))
+    {
+        std::cout << "Failed to open manifest: " << manifestPath << "\n";
+        return 1;
+    }
+
+    const std::string settings = CookSettingsTag(opts);
+    if (jobCount == 0)
+        jobCount = std::max(1u, std::thread::hardware_concurrency());
+    jobCount = std::min<uint32_t>(jobCount, static_cast<uint32_t>(std::max<size_t>(jobs.size(), 1)));
+
+    std::cout << "Manifest : " << manifestPath << " (" << jobs.size() << " models, " << jobCount << " jobs)\n";
+    if (!cacheDir.empty())
+        std::cout << "Cache    : " << cacheDir << "\n";
+
+    std::atomic<size_t> next{0};
+    std::atomic<uint32_t> counts[4] = {};
+    std::mutex printMutex;
+
+    // Each job buffers its log and prints it in one piece, so parallel cooks don't interleave.
+    auto worker = [&]()
+    {
+        for (;;)
+        {
+            const size_t i = next.fetch_add(1);
+            if (i >= jobs.size())
+                return;
+
+            std::ostringstream log;
+            const CookResult result = CookIncremental(jobs[i], opts, settings, cacheDir, force, log);
+            counts[static_cast<int>(result)].fetch_add(1);
+
+            std::lock_guard<std::mutex> lock(printMutex);
+            switch (result)
+            {
+            case CookResult::Cooked:
+                std::cout << log.str() << "[cooked]     " << jobs[i].input << "\n";
+                break;
+            case CookResult::UpToDate:
+                std::cout << "[up to date] " << jobs[i].input << "\n";
+                break;
+            case CookResult::FromCache:
+                std::cout << "[cached]     " << jobs[i].input << "\n";
+                break;
+            case CookResult::Failed:
+                std::cout << log.str() << "[FAILED]     " << jobs[i].input << "\n";
+                break;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 1; t < jobCount; ++t)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread &t : threads)
+        t.join();
+
+    const uint32_t failed = counts[static_cast<int>(CookResult::Failed)].load();
+    std::cout << "\nManifest complete: "
+              << counts[static_cast<int>(CookResult::Cooked)].load() << " cooked, "
+              << counts[static_cast<int>(CookResult::FromCache)].load() << " from cache, "
+              << counts[static_cast<int>(CookResult::UpToDate)].load() << " up to date, "
+              << failed << " failed\n";
+    return failed ? 2 : 0;
+}
+
+// ------------------------------------------------------------
+// Main
+// ------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    CookOptions opts;
+    std::string manifestPath;
+    std::string cacheDir;
+    uint32_t jobCount = 0;
+    bool force = false;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0)
+            positional.push_back(arg);
+        else if (arg == "--textures=source")
+            opts.compressTextures = false;
+        else if (arg == "--textures=bc")
+            opts.compressTextures = true;
+        else if (arg == "--vertices=quantized")
+            opts.quantizeVertices = true;
+        else if (arg == "--vertices=float")
+            opts.quantizeVertices = false;
+        else if (arg == "--meshlets")
+            opts.buildMeshlets = true;
+        else if (arg.rfind("--lods=", 0) == 0)
+            opts.lodLevels = std::min<uint32_t>(static_cast<uint32_t>(std::atoi(arg.c_str() + 7)), sm::kMaxPrimitiveLods);
+        else if (arg == "--anim=quantized")
+            opts.anim.quantize = true;
+        else if (arg == "--anim=float")
+            opts.anim.quantize = false;
+        else if (arg.rfind("--anim-error=", 0) == 0)
+            opts.anim.maxError = std::max(0.0f, static_cast<float>(std::atof(arg.c_str() + 13)));
+        else if (arg.rfind("--manifest=", 0) == 0)
+            manifestPath = NormalizePathSlashes(arg.substr(11));
+        else if (arg.rfind("--cache=", 0) == 0)
+            cacheDir = NormalizePathSlashes(arg.substr(8));
+        else if (arg.rfind("--jobs=", 0) == 0)
+            jobCount = static_cast<uint32_t>(std::max(0, std::atoi(arg.c_str() + 7)));
+        else if (arg == "--force")
+            force = true;
+        else
+            std::cout << "WARNING: unknown option ignored: " << arg << "\n";
+    }
+
+    if (!manifestPath.empty())
+        return RunManifest(manifestPath, opts, jobCount, cacheDir, force);
+
+    if (positional.size() < 2)
+    {
+        std::cout << "Usage: GltfToSModel <input.gltf/.glb> <output.smodel> [options]\n";
+        std::cout << "       GltfToSModel --manifest=<file> [--jobs=N] [--cache=<dir>] [--force] [options]\n";
+        std::cout << "  --textures=bc        BC7 color / BC5 normal maps with prebuilt mips (default)\n";
+        std::cout << "  --textures=source    embed the original PNG/JPG bytes (decoded at load)\n";
+        std::cout << "  --vertices=quantized 28-byte vertices: unorm16 position, octahedral normal (default)\n";
+        std::cout << "  --vertices=float     72-byte full-precision vertices\n";
+        std::cout << "  --meshlets           also write meshlets with culling cones (64 verts / 124 tris)\n";
+        std::cout << "  --lods=N             simplified LODs per primitive, 1/4 of the triangles each (default 3)\n";
+        std::cout << "  --anim=quantized     48-bit smallest-three rotations, unorm16 translation/scale (default)\n";
+        std::cout << "  --anim=float         full-precision animation keys\n";
+        std::cout << "  --anim-error=X       drop keys reproduced within X (units, radians for rotations; default 1e-3)\n";
+        std::cout << "  --manifest=<file>    cook every '<input> <output>' line, skipping unchanged models\n";
+        std::cout << "  --jobs=N             parallel cooks in manifest mode (default: hardware threads)\n";
+        std::cout << "  --cache=<dir>        keep outputs by content hash, reused across options/branches\n";
+        std::cout << "  --force              ignore stamps and the cache, recook everything\n";
+        return 0;
+    }
+
+    return CookModel(positional[0], positional[1], opts, std::cout);
+}
@@ -0,0 +1,728 @@
+#include "MeshOptimize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace sm = Engine::smodel;
+
+namespace
+{
+    // ------------------------------------------------------------
+    // Small vector helpers
+    // ------------------------------------------------------------
+    struct V3
+    {
+        float x, y, z;
+    };
+
+    V3 operator+(V3 a, V3 b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+    V3 operator-(V3 a, V3 b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+    V3 operator*(V3 a, float s) { return {a.x * s, a.y * s, a.z * s}; }
+    float dot(V3 a, V3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    V3 cross(V3 a, V3 b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+    float length(V3 a) { return std::sqrt(dot(a, a)); }
+
+    V3 positionOf(const float *positions, size_t stride, uint32_t v)
+    {
+        const float *p = reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(positions) + stride * v);
+        return {p[0], p[1], p[2]};
+    }
+
+    // ------------------------------------------------------------
+    // Vertex cache (Forsyth, "Linear-Speed Vertex Cache Optimisation")
+    // ------------------------------------------------------------
+    constexpr uint32_t kScoreCacheSize = 32;
+
+    float vertexScore(int cachePos, uint32_t remainingTris)
+    {
+        if (remainingTris == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+        if (cachePos >= 0)
+        {
+            // The last triangle's vertices score flat so its neighbours are not preferred over
+            // slightly older ones (avoids strip-like zig-zag).
+            if (cachePos < 3)
+                score = 0.75f;
+            else
+                score = std::pow(1.0f - float(cachePos - 3) / float(kScoreCacheSize - 3), 1.5f);
+        }
+
+        // Valence boost: finish off vertices with few triangles left.
+        return score + 2.0f / std::sqrt(float(remainingTris));
+    }
+
+    // FIFO cache simulation; returns per-triangle miss counts (0..3).
+    constexpr uint32_t kFifoCacheSize = 16;
+
+    void simulateFifo(const std::vector<uint32_t> &indices, uint32_t vertexCount, uint32_t cacheSize,
+                      std::vector<uint8_t> &outMisses)
+    {
+        std::vector<uint32_t> insertedAt(vertexCount, 0);
+        uint32_t time = cacheSize + 1;
+
+        outMisses.assign(indices.size() / 3, 0);
+        for (size_t t = 0; t < outMisses.size(); ++t)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                const uint32_t v = indices[t * 3 + k];
+                if (time - insertedAt[v] > cacheSize)
+                {
+                    insertedAt[v] = time++;
+                    ++outMisses[t];
+                }
+            }
+        }
+    }
+
+    // ------------------------------------------------------------
+    // Plane quadrics (Garland & Heckbert), normalized by accumulated area
+    // ------------------------------------------------------------
+    struct Quadric
+    {
+        double a2 = 0, ab = 0, ac = 0, ad = 0;
+        double b2 = 0, bc = 0, bd = 0;
+        double c2 = 0, cd = 0;
+        double d2 = 0;
+        double w = 0;
+
+        void addPlane(double a, double b, double c, double d, double weight)
+        {
+            a2 += weight * a * a;
+            ab += weight * a * b;
+            ac += weight * a * c;
+            ad += weight * a * d;
+            b2 += weight * b * b;
+            bc += weight * b * c;
+            bd += weight * b * d;
+            c2 += weight * c * c;
+            cd += weight * c * d;
+            d2 += weight * d * d;
+            w += weight;
+        }
+
+        void add(const Quadric &q)
+        {
+            a2 += q.a2;
+            ab += q.ab;
+            ac += q.ac;
+            ad += q.ad;
+            b2 += q.b2;
+            bc += q.bc;
+            bd += q.bd;
+            c2 += q.c2;
+            cd += q.cd;
+            d2 += q.d2;
+            w += q.w;
+        }
+
+        // Mean squared distance of p to the accumulated planes
+        double error(V3 p) const
+        {
+            const double x = p.x, y = p.y, z = p.z;
+            const double e = a2 * x * x + b2 * y * y + c2 * z * z + 2.0 * (ab * x * y + ac * x * z + bc * y * z) +
+                             2.0 * (ad * x + bd * y + cd * z) + d2;
+            return (w > 0.0) ? std::max(0.0, e / w) : 0.0;
+        }
+    };
+
+    struct PositionKey
+    {
+        uint32_t bits[3];
+        bool operator==(const PositionKey &o) const { return std::memcmp(bits, o.bits, sizeof(bits)) == 0; }
+    };
+
+    struct PositionKeyHash
+    {
+        size_t operator()(const PositionKey &k) const
+        {
+            return (size_t(k.bits[0]) * 73856093u) ^ (size_t(k.bits[1]) * 19349663u) ^ (size_t(k.bits[2]) * 83492791u);
+        }
+    };
+}
+
+void OptimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount)
+{
+    const size_t triCount = indices.size() / 3;
+    if (triCount < 2 || vertexCount == 0)
+        return;
+
+    // Vertex -> triangle adjacency (the live part of each list is [0, remaining[v]))
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (uint32_t v : indices)
+        ++remaining[v];
+
+    std::vector<uint32_t> adjOffset(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        adjOffset[v + 1] = adjOffset[v] + remaining[v];
+
+    std::vector<uint32_t> adj(indices.size());
+    {
+        std::vector<uint32_t> fill(adjOffset.begin(), adjOffset.end() - 1);
+        for (size_t t = 0; t < triCount; ++t)
+        {
+            for (int k = 0; k < 3; ++k)
+                adj[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<int> cachePos(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        score[v] = vertexScore(-1, remaining[v]);
+
+    auto triScore = [&](size_t t)
+    { return score[indices[t * 3 + 0]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]]; };
+
+    std::vector<uint8_t> emitted(triCount, 0);
+    std::vector<uint32_t> out;
+    out.reserve(indices.size());
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(kScoreCacheSize + 3);
+    newCache.reserve(kScoreCacheSize + 3);
+
+    size_t best = 0;
+    {
+        float bestScore = -1.0f;
+        for (size_t t = 0; t < triCount; ++t)
+        {
+            const float s = triScore(t);
+            if (s > bestScore)
+            {
+                bestScore = s;
+                best = t;
+            }
+        }
+    }
+
+    size_t scanCursor = 0;
+    for (size_t n = 0; n < triCount; ++n)
+    {
+        if (best == std::numeric_limits<size_t>::max())
+        {
+            // Nothing adjacent to the cache: continue with the next triangle in input order.
+            while (emitted[scanCursor])
+                ++scanCursor;
+            best = scanCursor;
+        }
+
+        emitted[best] = 1;
+        const uint32_t tri[3] = {indices[best * 3 + 0], indices[best * 3 + 1], indices[best * 3 + 2]};
+        out.insert(out.end(), tri, tri + 3);
+
+        // Drop the triangle from its vertices' live adjacency
+        for (uint32_t v : tri)
+        {
+            uint32_t *list = adj.data() + adjOffset[v];
+            for (uint32_t i = 0; i < remaining[v]; ++i)
+            {
+                if (list[i] == best)
+                {
+                    std::swap(list[i], list[remaining[v] - 1]);
+                    --remaining[v];
+                    break;
+                }
+            }
+        }
+
+        // LRU update: the triangle's vertices move to the front
+        newCache.assign(tri, tri + 3);
+        for (uint32_t v : cache)
+        {
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                newCache.push_back(v);
+        }
+        for (size_t i = kScoreCacheSize; i < newCache.size(); ++i)
+        {
+            cachePos[newCache[i]] = -1;
+            score[newCache[i]] = vertexScore(-1, remaining[newCache[i]]);
+        }
+        if (newCache.size() > kScoreCacheSize)
+            newCache.resize(kScoreCacheSize);
+        cache.swap(newCache);
+
+        for (size_t i = 0; i < cache.size(); ++i)
+        {
+            cachePos[cache[i]] = static_cast<int>(i);
+            score[cache[i]] = vertexScore(static_cast<int>(i), remaining[cache[i]]);
+        }
+
+        // Next: the best live triangle touching the cache
+        best = std::numeric_limits<size_t>::max();
+        float bestScore = -1.0f;
+        for (uint32_t v : cache)
+        {
+            const uint32_t *list = adj.data() + adjOffset[v];
+            for (uint32_t i = 0; i < remaining[v]; ++i)
+            {
+                const float s = triScore(list[i]);
+                if (s > bestScore)
+                {
+                    bestScore = s;
+                    best = list[i];
+                }
+            }
+        }
+    }
+
+    indices.swap(out);
+}
+
+void OptimizeOverdraw(std::vector<uint32_t> &indices, const float *positions, size_t stride, uint32_t vertexCount)
+{
+    // Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw":
+    // cut the cache-optimized order into clusters at cache-cold triangles, then draw clusters
+    // that face away from the mesh centre (likely occluders) first.
+    const size_t triCount = indices.size() / 3;
+    if (triCount < 2 || vertexCount == 0)
+        return;
+
+    std::vector<uint8_t> misses;
+    simulateFifo(indices, vertexCount, kFifoCacheSize, misses);
+
+    const float globalAcmr = float(std::accumulate(misses.begin(), misses.end(), 0u)) / float(triCount);
+    const float kThreshold = 1.05f; // allowed ACMR regression per cluster
+
+    // Split only where it does not hurt cache efficiency much
+    std::vector<size_t> clusterStart{0};
+    uint32_t clusterMisses = 0;
+    for (size_t t = 0; t < triCount; ++t)
+    {
+        const size_t begin = clusterStart.back();
+        if (t > begin && misses[t] == 3 &&
+            float(clusterMisses) / float(t - begin) <= globalAcmr * kThreshold)
+        {
+            clusterStart.push_back(t);
+            clusterMisses = 0;
+        }
+        clusterMisses += misses[t];
+    }
+    clusterStart.push_back(triCount);
+
+    const size_t clusterCount = clusterStart.size() - 1;
+    if (clusterCount < 2)
+        return;
+
+    // Mesh centroid (area weighted)
+    V3 meshCentroid{0, 0, 0};
+    float meshArea = 0.0f;
+    for (size_t t = 0; t < triCount; ++t)
+    {
+        const V3 a = positionOf(positions, stride, indices[t * 3 + 0]);
+        const V3 b = positionOf(positions, stride, indices[t * 3 + 1]);
+        const V3 c = positionOf(positions, stride, indices[t * 3 + 2]);
+        const float area = length(cross(b - a, c - a));
+        meshCentroid = meshCentroid + (a + b + c) * (area / 3.0f);
+        meshArea += area;
+    }
+    if (meshArea <= 0.0f)
+        return;
+    meshCentroid = meshCentroid * (1.0f / meshArea);
+
+    std::vector<float> sortKey(clusterCount, 0.0f);
+    for (size_t ci = 0; ci < clusterCount; ++ci)
+    {
+        V3 centroid{0, 0, 0};
+        V3 normal{0, 0, 0};
+        float area = 0.0f;
+        for (size_t t = clusterStart[ci]; t < clusterStart[ci + 1]; ++t)
+        {
+            const V3 a = positionOf(positions, stride, indices[t * 3 + 0]);
+            const V3 b = positionOf(positions, stride, indices[t * 3 + 1]);
+            const V3 c = positionOf(positions, stride, indices[t * 3 + 2]);
+            const V3 n = cross(b - a, c - a);
+            const float triArea = length(n);
+            centroid = centroid + (a + b + c) * (triArea / 3.0f);
+            normal = normal + n;
+            area += triArea;
+        }
+
+        const float nl = length(normal);
+        if (area > 0.0f && nl > 0.0f)
+            sortKey[ci] = dot(centroid * (1.0f / area) - meshCentroid, normal * (1.0f / nl));
+    }
+
+    std::vector<size_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                     { return sortKey[a] > sortKey[b]; });
+
+    std::vector<uint32_t> out;
+    out.reserve(indices.size());
+    for (size_t ci : order)
+        out.insert(out.end(), indices.begin() + clusterStart[ci] * 3, indices.begin() + clusterStart[ci + 1] * 3);
+    indices.swap(out);
+}
+
+uint32_t OptimizeVertexFetch(std::vector<uint32_t> &indices, uint32_t vertexCount, std::vector<uint32_t> &outRemap)
+{
+    outRemap.assign(vertexCount, std::numeric_limits<uint32_t>::max());
+
+    uint32_t next = 0;
+    for (uint32_t &v : indices)
+    {
+        if (outRemap[v] == std::numeric_limits<uint32_t>::max())
+            outRemap[v] = next++;
+        v = outRemap[v];
+    }
+    return next;
+}
+
+void BuildMeshlets(const std::vector<uint32_t> &indices, const float *positions, size_t stride, uint32_t vertexCount,
+                   uint32_t meshIndex,
+                   std::vector<sm::SModelMeshletRecord> &meshlets,
+                   std::vector<uint32_t> &meshletVertices,
+                   std::vector<uint8_t> &meshletTriangles)
+{
+    std::vector<uint8_t> localIndex(vertexCount, 0xFF);
+
+    sm::SModelMeshletRecord current{};
+    auto begin = [&]()
+    {
+        current = sm::SModelMeshletRecord{};
+        current.meshIndex = meshIndex;
+        current.vertexOffset = static_cast<uint32_t>(meshletVertices.size());
+        current.triangleOffset = static_cast<uint32_t>(meshletTriangles.size());
+    };
+
+    auto finish = [&]()
+    {
+        if (current.triangleCount == 0)
+            return;
+
+        const uint32_t *verts = meshletVertices.data() + current.vertexOffset;
+        const uint8_t *tris = meshletTriangles.data() + current.triangleOffset;
+
+        // Bounding sphere: AABB centre + farthest vertex
+        V3 lo = positionOf(positions, stride, verts[0]);
+        V3 hi = lo;
+        for (uint32_t i = 1; i < current.vertexCount; ++i)
+        {
+            const V3 p = positionOf(positions, stride, verts[i]);
+            lo = {std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z)};
+            hi = {std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z)};
+        }
+        const V3 center = (lo + hi) * 0.5f;
+        float radius = 0.0f;
+        for (uint32_t i = 0; i < current.vertexCount; ++i)
+            radius = std::max(radius, length(positionOf(positions, stride, verts[i]) - center));
+
+        // Normal cone
+        std::vector<V3> normals;
+        normals.reserve(current.triangleCount);
+        V3 axis{0, 0, 0};
+        for (uint32_t t = 0; t < current.triangleCount; ++t)
+        {
+            const V3 a = positionOf(positions, stride, verts[tris[t * 3 + 0]]);
+            const V3 b = positionOf(positions, stride, verts[tris[t * 3 + 1]]);
+            const V3 c = positionOf(positions, stride, verts[tris[t * 3 + 2]]);
+            V3 n = cross(b - a, c - a);
+            const float l = length(n);
+            if (l <= 0.0f)
+                continue; // degenerate triangles never face the camera
+            n = n * (1.0f / l);
+            normals.push_back(n);
+            axis = axis + n;
+        }
+
+        current.center[0] = center.x;
+        current.center[1] = center.y;
+        current.center[2] = center.z;
+        current.radius = radius;
+
+        current.coneApex[0] = center.x;
+        current.coneApex[1] = center.y;
+        current.coneApex[2] = center.z;
+        current.coneCutoff = 1.0f;
+
+        const float axisLen = length(axis);
+        if (axisLen > 0.0f)
+        {
+            axis = axis * (1.0f / axisLen);
+            float minDp = 1.0f;
+            for (const V3 &n : normals)
+                minDp = std::min(minDp, dot(axis, n));
+
+            current.coneAxis[0] = axis.x;
+            current.coneAxis[1] = axis.y;
+            current.coneAxis[2] = axis.z;
+
+            // Wider than ~84 degrees: the cone can hardly ever cull, leave it disabled.
+            if (minDp > 0.1f)
+            {
+                // Move the apex back until every triangle plane is in front of it.
+                float maxT = 0.0f;
+                for (uint32_t t = 0, ni = 0; t < current.triangleCount; ++t)
+                {
+                    const V3 a = positionOf(positions, stride, verts[tris[t * 3 + 0]]);
+                    const V3 b = positionOf(positions, stride, verts[tris[t * 3 + 1]]);
+                    const V3 c = positionOf(positions, stride, verts[tris[t * 3 + 2]]);
+                    if (length(cross(b - a, c - a)) <= 0.0f)
+                        continue;
+                    const V3 &n = normals[ni++];
+                    maxT = std::max(maxT, dot(center - a, n) / dot(axis, n));
+                }
+
+                const V3 apex = center - axis * maxT;
+                current.coneApex[0] = apex.x;
+                current.coneApex[1] = apex.y;
+                current.coneApex[2] = apex.z;
+                current.coneCutoff = std::sqrt(1.0f - minDp * minDp);
+            }
+        }
+
+        for (uint32_t i = 0; i < current.vertexCount; ++i)
+            localIndex[verts[i]] = 0xFF;
+
+        meshlets.push_back(current);
+    };
+
+    begin();
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        const uint32_t tri[3] = {indices[t], indices[t + 1], indices[t + 2]};
+
+        uint32_t newVerts = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            const bool repeat = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+            if (localIndex[tri[k]] == 0xFF && !repeat)
+                ++newVerts;
+        }
+
+        if (current.vertexCount + newVerts > sm::kMeshletMaxVertices ||
+            current.triangleCount + 1u > sm::kMeshletMaxTriangles)
+        {
+            finish();
+            begin();
+        }
+
+        for (uint32_t v : tri)
+        {
+            if (localIndex[v] == 0xFF)
+            {
+                localIndex[v] = static_cast<uint8_t>(current.vertexCount++);
+                meshletVertices.push_back(v);
+            }
+            meshletTriangles.push_back(localIndex[v]);
+        }
+        ++current.triangleCount;
+    }
+    finish();
+}
+
+float ComputeACMR(const std::vector<uint32_t> &indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+    const size_t triCount = indices.size() / 3;
+    if (triCount == 0)
+        return 0.0f;
+
+    std::vector<uint8_t> misses;
+    simulateFifo(indices, vertexCount, cacheSize, misses);
+    return float(std::accumulate(misses.begin(), misses.end(), 0u)) / float(triCount);
+}
+
+std::vector<uint32_t> SimplifyMesh(const std::vector<uint32_t> &indices, const float *positions, size_t stride,
+                                   uint32_t vertexCount, size_t targetIndexCount, float &outError)
+{
+    outError = 0.0f;
+    std::vector<uint32_t> result(indices);
+    if (result.size() <= targetIndexCount || vertexCount == 0)
+        return result;
+
+    // Vertices sharing a position (attribute seams) collapse as one "wedge"
+    std::vector<uint32_t> wedge(vertexCount);
+    std::vector<uint32_t> wedgeSize(vertexCount, 0);
+    {
+        std::unordered_map<PositionKey, uint32_t, PositionKeyHash> firstAt;
+        firstAt.reserve(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            const float *p = reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(positions) + stride * v);
+            PositionKey key{};
+            std::memcpy(key.bits, p, sizeof(key.bits));
+            wedge[v] = firstAt.emplace(key, v).first->second;
+            ++wedgeSize[wedge[v]];
+        }
+    }
+
+    // Lock seams and open borders (edges, by position, used by a single triangle)
+    std::vector<uint8_t> locked(vertexCount, 0);
+    {
+        std::unordered_map<uint64_t, int32_t> edgeUse; // +1 per a<b direction, -1 per b<a
+        edgeUse.reserve(result.size());
+        for (size_t i = 0; i + 2 < result.size(); i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                const uint32_t a = wedge[result[i + k]];
+                const uint32_t b = wedge[result[i + (k + 1) % 3]];
+                const uint64_t key = (a < b) ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a);
+                edgeUse[key] += (a < b) ? 1 : -1;
+            }
+        }
+        // A closed manifold edge is used once in each direction (sum 0)
+        for (const auto &e : edgeUse)
+        {
+            if (e.second != 0)
+            {
+                locked[uint32_t(e.first >> 32)] = 1;
+                locked[uint32_t(e.first & 0xFFFFFFFFu)] = 1;
+            }
+        }
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            if (wedgeSize[wedge[v]] > 1)
+                locked[wedge[v]] = 1;
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i + 2 < result.size(); i += 3)
+    {
+        const V3 a = positionOf(positions, stride, result[i + 0]);
+        const V3 b = positionOf(positions, stride, result[i + 1]);
+        const V3 c = positionOf(positions, stride, result[i + 2]);
+        V3 n = cross(b - a, c - a);
+        const float area = length(n);
+        if (area <= 0.0f)
+            continue;
+        n = n * (1.0f / area);
+        const double d = -double(dot(n, a));
+        for (int k = 0; k < 3; ++k)
+            quadrics[wedge[result[i + k]]].addPlane(n.x, n.y, n.z, d, area);
+    }
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+    std::vector<Collapse> candidates;
+    std::vector<uint32_t> triOffset(vertexCount + 1);
+    std::vector<uint32_t> triList;
+    std::vector<uint32_t> collapseTo(vertexCount);
+    std::vector<uint8_t> touched(vertexCount);
+    double maxCost = 0.0;
+
+    for (int pass = 0; pass < 32 && result.size() > targetIndexCount; ++pass)
+    {
+        const size_t triCount = result.size() / 3;
+
+        // Vertex -> triangles for the flip test
+        std::fill(triOffset.begin(), triOffset.end(), 0u);
+        for (uint32_t v : result)
+            ++triOffset[v + 1];
+        for (uint32_t v = 0; v < vertexCount; ++v)
+            triOffset[v + 1] += triOffset[v];
+        triList.resize(result.size());
+        {
+            std::vector<uint32_t> fill(triOffset.begin(), triOffset.end() - 1);
+            for (size_t t = 0; t < triCount; ++t)
+            {
+                for (int k = 0; k < 3; ++k)
+                    triList[fill[result[t * 3 + k]]++] = static_cast<uint32_t>(t);
+            }
+        }
+
+        // Directed edge collapses from -> to, onto an existing vertex
+        candidates.clear();
+        for (size_t t = 0; t < triCount; ++t)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                const uint32_t a = result[t * 3 + k];
+                const uint32_t b = result[t * 3 + (k + 1) % 3];
+                for (int dir = 0; dir < 2; ++dir)
+                {
+                    const uint32_t from = dir ? b : a;
+                    const uint32_t to = dir ? a : b;
+                    if (locked[wedge[from]] || wedge[from] == wedge[to])
+                        continue;
+                    Quadric q = quadrics[wedge[from]];
+                    q.add(quadrics[wedge[to]]);
+                    candidates.push_back({from, to, q.error(positionOf(positions, stride, to))});
+                }
+            }
+        }
+        if (candidates.empty())
+            break;
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse &x, const Collapse &y)
+                  { return x.cost < y.cost; });
+
+        // Each collapse removes about two triangles
+        const size_t targetTris = targetIndexCount / 3;
+        const size_t wanted = (triCount - targetTris) / 2 + 1;
+
+        std::iota(collapseTo.begin(), collapseTo.end(), 0u);
+        std::fill(touched.begin(), touched.end(), uint8_t(0));
+        size_t collapsed = 0;
+        for (const Collapse &c : candidates)
+        {
+            if (collapsed >= wanted)
+                break;
+            if (touched[wedge[c.from]] || touched[wedge[c.to]])
+                continue;
+
+            // Reject collapses that flip or squash a surviving triangle
+            const V3 target = positionOf(positions, stride, c.to);
+            bool ok = true;
+            for (uint32_t i = triOffset[c.from]; ok && i < triOffset[c.from + 1]; ++i)
+            {
+                const uint32_t *tri = &result[size_t(triList[i]) * 3];
+                if (wedge[tri[0]] == wedge[c.to] || wedge[tri[1]] == wedge[c.to] || wedge[tri[2]] == wedge[c.to])
+                    continue; // becomes degenerate and is removed
+
+                V3 p[3];
+                for (int k = 0; k < 3; ++k)
+                    p[k] = positionOf(positions, stride, tri[k]);
+                const V3 before = cross(p[1] - p[0], p[2] - p[0]);
+                for (int k = 0; k < 3; ++k)
+                {
+                    if (tri[k] == c.from)
+                        p[k] = target;
+                }
+                const V3 after = cross(p[1] - p[0], p[2] - p[0]);
+                ok = dot(before, after) > 0.25f * length(before) * length(after);
+            }
+            if (!ok)
+                continue;
+
+            collapseTo[c.from] = c.to;
+            touched[wedge[c.from]] = 1;
+            touched[wedge[c.to]] = 1;
+            quadrics[wedge[c.to]].add(quadrics[wedge[c.from]]);
+            maxCost = std::max(maxCost, c.cost);
+            ++collapsed;
+        }
+        if (collapsed == 0)
+            break;
+
+        // Apply and drop triangles that lost an edge
+        size_t write = 0;
+        for (size_t t = 0; t < triCount; ++t)
+        {
+            const uint32_t a = collapseTo[result[t * 3 + 0]];
+            const uint32_t b = collapseTo[result[t * 3 + 1]];
+            const uint32_t c = collapseTo[result[t * 3 + 2]];
+            if (wedge[a] == wedge[b] || wedge[b] == wedge[c] || wedge[a] == wedge[c])
+                continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    outError = static_cast<float>(std::sqrt(maxCost));
+    return result;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "assets/model/SModelMeshletRecord.h"
+
+// ------------------------------------------------------------
+// Offline mesh optimization for cooked meshes
+// ------------------------------------------------------------
+// Run in this order on a triangle list:
+// 1) OptimizeVertexCache  - reorder triangles for the post-transform cache
+// 2) OptimizeOverdraw     - reorder cache-friendly clusters front-to-back-ish
+// 3) OptimizeVertexFetch  - renumber vertices in first-use order
+// 4) BuildMeshlets        - optional clusters, built from the final order
+//
+// SimplifyMesh builds LOD index lists over the same vertices (run it on the step 1/2 output,
+// then renumber all LODs together in step 3).
+//
+// 'positions' points at the first vertex's float[3] position, 'stride' is the vertex size.
+
+void OptimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount);
+
+void OptimizeOverdraw(std::vector<uint32_t> &indices, const float *positions, size_t stride, uint32_t vertexCount);
+
+// Rewrites 'indices' and fills outRemap[oldVertex] = newVertex (UINT32_MAX for vertices no
+// triangle references, which are dropped). Returns the new vertex count.
+uint32_t OptimizeVertexFetch(std::vector<uint32_t> &indices, uint32_t vertexCount, std::vector<uint32_t> &outRemap);
+
+// Appends one mesh's meshlets to the file-wide tables (see SModelMeshletRecord.h).
+void BuildMeshlets(const std::vector<uint32_t> &indices, const float *positions, size_t stride, uint32_t vertexCount,
+                   uint32_t meshIndex,
+                   std::vector<Engine::smodel::SModelMeshletRecord> &meshlets,
+                   std::vector<uint32_t> &meshletVertices,
+                   std::vector<uint8_t> &meshletTriangles);
+
+// Quadric edge collapse down to about targetIndexCount indices, reusing the input vertices
+// (collapses snap onto an existing neighbour). Open borders and attribute seams are locked.
+// outError: the largest collapse error, as an object-space distance.
+std::vector<uint32_t> SimplifyMesh(const std::vector<uint32_t> &indices, const float *positions, size_t stride,
+                                   uint32_t vertexCount, size_t targetIndexCount, float &outError);
+
+// Average post-transform cache misses per triangle for a FIFO cache (reporting only).
+float ComputeACMR(const std::vector<uint32_t> &indices, uint32_t vertexCount, uint32_t cacheSize = 16);
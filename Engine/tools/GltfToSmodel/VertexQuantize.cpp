@@ -0,0 +1,157 @@
+#include "VertexQuantize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+uint16_t FloatToHalf(float v)
+{
+    uint32_t x = 0;
+    std::memcpy(&x, &v, sizeof(x));
+
+    const uint32_t sign = (x >> 16) & 0x8000u;
+    const uint32_t fexp = (x >> 23) & 0xFFu;
+    uint32_t mant = x & 0x7FFFFFu;
+
+    if (fexp == 0xFFu)
+        return static_cast<uint16_t>(sign | 0x7C00u | (mant ? 0x200u : 0u)); // inf / nan
+
+    const int32_t exp = static_cast<int32_t>(fexp) - 127 + 15;
+    if (exp >= 31)
+        return static_cast<uint16_t>(sign | 0x7C00u);
+
+    if (exp <= 0)
+    {
+        // Half subnormal (or zero)
+        if (exp < -10)
+            return static_cast<uint16_t>(sign);
+        mant |= 0x800000u;
+        const uint32_t shift = static_cast<uint32_t>(14 - exp);
+        uint32_t h = mant >> shift;
+        const uint32_t rem = mant & ((1u << shift) - 1u);
+        const uint32_t halfway = 1u << (shift - 1u);
+        if (rem > halfway || (rem == halfway && (h & 1u)))
+            ++h;
+        return static_cast<uint16_t>(sign | h);
+    }
+
+    // A carry out of the mantissa correctly bumps the exponent.
+    uint32_t h = (static_cast<uint32_t>(exp) << 10) | (mant >> 13);
+    const uint32_t rem = mant & 0x1FFFu;
+    if (rem > 0x1000u || (rem == 0x1000u && (h & 1u)))
+        ++h;
+    return static_cast<uint16_t>(sign | h);
+}
+
+float HalfToFloat(uint16_t h)
+{
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    const uint32_t exp = (h >> 10) & 0x1Fu;
+    const uint32_t mant = h & 0x3FFu;
+
+    if (exp == 0)
+    {
+        const float f = std::ldexp(static_cast<float>(mant), -24);
+        return sign ? -f : f;
+    }
+
+    uint32_t bits = 0;
+    if (exp == 31)
+        bits = sign | 0x7F800000u | (mant << 13);
+    else
+        bits = sign | ((exp + 112u) << 23) | (mant << 13);
+
+    float f = 0.0f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// Neighbouring halves towards -inf / +inf (finite inputs).
+static uint16_t halfStepDown(uint16_t h)
+{
+    if (h == 0x0000u)
+        return 0x8001u;
+    return (h & 0x8000u) ? static_cast<uint16_t>(h + 1u) : static_cast<uint16_t>(h - 1u);
+}
+
+static uint16_t halfStepUp(uint16_t h)
+{
+    if (h == 0x8000u || h == 0x0000u)
+        return 0x0001u;
+    return (h & 0x8000u) ? static_cast<uint16_t>(h - 1u) : static_cast<uint16_t>(h + 1u);
+}
+
+bool SnapQuantizationBox(const float inMin[3], const float inMax[3], float outMin[3], float outExtent[3])
+{
+    for (int a = 0; a < 3; ++a)
+    {
+        uint16_t lo = FloatToHalf(inMin[a]);
+        if (HalfToFloat(lo) > inMin[a])
+            lo = halfStepDown(lo);
+        const float mn = HalfToFloat(lo);
+
+        uint16_t ext = FloatToHalf(std::max(0.0f, inMax[a] - mn));
+        while (mn + HalfToFloat(ext) < inMax[a] && (ext & 0x7C00u) != 0x7C00u)
+            ext = halfStepUp(ext);
+
+        outMin[a] = mn;
+        outExtent[a] = HalfToFloat(ext);
+        if (!std::isfinite(mn) || !std::isfinite(outExtent[a]))
+            return false;
+    }
+    return true;
+}
+
+uint16_t QuantizeUnorm16(float v, float min, float extent)
+{
+    if (extent <= 0.0f)
+        return 0;
+    const float t = std::clamp((v - min) / extent, 0.0f, 1.0f);
+    return static_cast<uint16_t>(std::lround(t * 65535.0f));
+}
+
+void OctEncodeSnorm16(const float n[3], int16_t out[2])
+{
+    const float l1 = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
+    if (l1 <= 0.0f)
+    {
+        out[0] = out[1] = 0; // decodes to +Z
+        return;
+    }
+
+    float x = n[0] / l1;
+    float y = n[1] / l1;
+    if (n[2] < 0.0f)
+    {
+        // Fold the lower hemisphere over the diagonals (sign(0) = +1, as in the decoder).
+        const float fx = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float fy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+
+    out[0] = static_cast<int16_t>(std::lround(std::clamp(x, -1.0f, 1.0f) * 32767.0f));
+    out[1] = static_cast<int16_t>(std::lround(std::clamp(y, -1.0f, 1.0f) * 32767.0f));
+}
+
+int8_t FloatToSnorm8(float v)
+{
+    return static_cast<int8_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 127.0f));
+}
+
+void WeightsToUnorm8(const float w[4], uint8_t out[4])
+{
+    int sum = 0;
+    int largest = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        out[i] = static_cast<uint8_t>(std::lround(std::clamp(w[i], 0.0f, 1.0f) * 255.0f));
+        sum += out[i];
+        if (w[i] > w[largest])
+            largest = i;
+    }
+
+    // Rounding error goes to the dominant joint so the skin matrix stays affine.
+    if (sum > 0)
+        out[largest] = static_cast<uint8_t>(std::clamp(int(out[largest]) + 255 - sum, 0, 255));
+}
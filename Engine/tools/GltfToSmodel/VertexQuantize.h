@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+
+// ------------------------------------------------------------
+// Attribute encoders for the quantized .smodel vertex layout
+// ------------------------------------------------------------
+// See Engine::smodel::SModelVertexQuantized for the layout and smodel.vert for the decode.
+
+// IEEE half <-> float (round to nearest even; overflow -> inf).
+uint16_t FloatToHalf(float v);
+float HalfToFloat(uint16_t h);
+
+// Grow [inMin, inMax] to a box whose min and extent are exact halves, so the runtime can
+// pass it to the shader as halves without moving a single vertex. False when the box does not
+// fit in half range (|v| > 65504).
+bool SnapQuantizationBox(const float inMin[3], const float inMax[3], float outMin[3], float outExtent[3]);
+
+// v in [min, min + extent] -> unorm16 (0 for a flat axis).
+uint16_t QuantizeUnorm16(float v, float min, float extent);
+
+// Unit vector -> octahedral snorm16x2.
+void OctEncodeSnorm16(const float n[3], int16_t out[2]);
+
+int8_t FloatToSnorm8(float v);
+
+// Normalized weights -> unorm8 that sum to exactly 255.
+void WeightsToUnorm8(const float w[4], uint8_t out[4]);
@@ -1,7 +1,8 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "tiny_obj_loader.h"
 
-#include "assets/MeshFormats.h" // reuse SMeshHeaderV0
+#include "assets/MeshFormats.h" // SMeshHeaderV1, SMeshVertexCompact
+#include "VertexQuantize.h"       // shared with GltfToSmodel: FloatToHalf, FloatToSnorm8
 
 #include <cstdint>
 #include <cstdio>
@@ -80,12 +81,17 @@ static void computeAABB(const std::vector<VertexPNUT> &verts, float minOut[3], f
     }
 }
 
+static uint64_t alignUp(uint64_t v, uint64_t a)
+{
+    return (v + a - 1) / a * a;
+}
+
 static int32_t qfloat(float x, float scale)
 {
     return static_cast<int32_t>(std::round(x * scale));
 }
 
-static bool convertObjToSMesh(const fs::path &objPath, const fs::path &outPath)
+static bool convertObjToSMesh(const fs::path &objPath, const fs::path &outPath, bool compactVertices)
 {
     tinyobj::attrib_t attrib;
     std::vector<tinyobj::shape_t> shapes;
@@ -203,35 +209,88 @@ static bool convertObjToSMesh(const fs::path &objPath, const fs::path &outPath)
         return false;
     }
 
-    // Normalize positions into a stable [-1, 1] range so the runtime shader can
-    // use inPosition directly as clip-space without a camera/model matrix.
-    // We center the mesh on its AABB center and scale by the largest half-extent.
     float aabbMin[3], aabbMax[3];
     computeAABB(vertices, aabbMin, aabbMax);
 
-    Engine::SMeshHeaderV0 hdr{};
+    // Half positions hold ~3 significant digits and stop at 65504
+    if (compactVertices)
+    {
+        for (int a = 0; a < 3; ++a)
+        {
+            if (std::fabs(aabbMin[a]) > 65504.0f || std::fabs(aabbMax[a]) > 65504.0f)
+            {
+                std::cerr << "Bounds beyond half range, keeping float vertices: " << objPath << "\n";
+                compactVertices = false;
+                break;
+            }
+        }
+    }
+
+    Engine::SMeshHeaderV1 hdr{};
+    std::memcpy(hdr.magic, Engine::kSMeshMagic, sizeof(hdr.magic));
+    hdr.versionMajor = Engine::kSMeshVersionMajor;
+    hdr.versionMinor = Engine::kSMeshVersionMinor;
+    hdr.headerSize = sizeof(Engine::SMeshHeaderV1);
+    hdr.flags = compactVertices ? Engine::SMESH_VERTEX_COMPACT : 0u;
     hdr.vertexCount = static_cast<uint32_t>(vertices.size());
     hdr.indexCount = static_cast<uint32_t>(indices.size());
-    hdr.vertexStride = sizeof(VertexPNUT); // 32
-    hdr.indexFormat = 1;                   // uint32 for now
-    hdr.aabbMin[0] = aabbMin[0];
-    hdr.aabbMin[1] = aabbMin[1];
-    hdr.aabbMin[2] = aabbMin[2];
-    hdr.aabbMax[0] = aabbMax[0];
-    hdr.aabbMax[1] = aabbMax[1];
-    hdr.aabbMax[2] = aabbMax[2];
+    hdr.vertexStride = compactVertices ? sizeof(Engine::SMeshVertexCompact) : sizeof(VertexPNUT); // 16 / 32
+    hdr.indexFormat = vertices.size() <= 0xFFFFu ? 0u : 1u; // uint16 whenever it fits
+    std::memcpy(hdr.aabbMin, aabbMin, sizeof(aabbMin));
+    std::memcpy(hdr.aabbMax, aabbMax, sizeof(aabbMax));
 
-    const uint32_t headerSize = sizeof(Engine::SMeshHeaderV0);
-    const uint32_t vertexBytes = hdr.vertexCount * hdr.vertexStride;
-    const uint32_t indexBytes = hdr.indexCount * sizeof(uint32_t);
-    hdr.vertexDataOffset = headerSize;
-    hdr.indexDataOffset = headerSize + vertexBytes;
+    std::vector<uint8_t> vertexBytes;
+    if (compactVertices)
+    {
+        std::vector<Engine::SMeshVertexCompact> compact(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            const VertexPNUT &v = vertices[i];
+            Engine::SMeshVertexCompact &c = compact[i];
+            c.position[0] = FloatToHalf(v.px);
+            c.position[1] = FloatToHalf(v.py);
+            c.position[2] = FloatToHalf(v.pz);
+            c.position[3] = FloatToHalf(1.0f);
+            c.normal[0] = FloatToSnorm8(v.nx);
+            c.normal[1] = FloatToSnorm8(v.ny);
+            c.normal[2] = FloatToSnorm8(v.nz);
+            c.normal[3] = 0;
+            c.uv[0] = FloatToHalf(v.u);
+            c.uv[1] = FloatToHalf(v.v);
+        }
+        vertexBytes.resize(compact.size() * sizeof(Engine::SMeshVertexCompact));
+        std::memcpy(vertexBytes.data(), compact.data(), vertexBytes.size());
+    }
+    else
+    {
+        vertexBytes.resize(vertices.size() * sizeof(VertexPNUT));
+        std::memcpy(vertexBytes.data(), vertices.data(), vertexBytes.size());
+    }
 
-    std::vector<uint8_t> blob;
-    blob.resize(headerSize + vertexBytes + indexBytes);
+    std::vector<uint8_t> indexBytes;
+    if (hdr.indexFormat == 0)
+    {
+        std::vector<uint16_t> indices16(indices.begin(), indices.end());
+        indexBytes.resize(indices16.size() * sizeof(uint16_t));
+        std::memcpy(indexBytes.data(), indices16.data(), indexBytes.size());
+    }
+    else
+    {
+        indexBytes.resize(indices.size() * sizeof(uint32_t));
+        std::memcpy(indexBytes.data(), indices.data(), indexBytes.size());
+    }
+
+    // Aligned sections: the runtime maps the file and stages them in place
+    hdr.vertexDataOffset = alignUp(sizeof(hdr), Engine::kSMeshSectionAlignment);
+    hdr.vertexDataSize = vertexBytes.size();
+    hdr.indexDataOffset = alignUp(hdr.vertexDataOffset + hdr.vertexDataSize, Engine::kSMeshSectionAlignment);
+    hdr.indexDataSize = indexBytes.size();
+    hdr.fileSizeBytes = hdr.indexDataOffset + hdr.indexDataSize;
+
+    std::vector<uint8_t> blob(static_cast<size_t>(hdr.fileSizeBytes), 0);
     std::memcpy(blob.data(), &hdr, sizeof(hdr));
-    std::memcpy(blob.data() + hdr.vertexDataOffset, vertices.data(), vertexBytes);
-    std::memcpy(blob.data() + hdr.indexDataOffset, indices.data(), indexBytes);
+    std::memcpy(blob.data() + hdr.vertexDataOffset, vertexBytes.data(), vertexBytes.size());
+    std::memcpy(blob.data() + hdr.indexDataOffset, indexBytes.data(), indexBytes.size());
 
     fs::create_directories(outPath.parent_path());
     if (!writeBinary(outPath.string(), blob))
@@ -239,7 +298,8 @@ static bool convertObjToSMesh(const fs::path &objPath, const fs::path &outPath)
         std::cerr << "Failed to write: " << outPath << "\n";
         return false;
     }
-    std::cout << "Wrote " << outPath << " (verts=" << hdr.vertexCount << ", indices=" << hdr.indexCount << ")\n";
+    std::cout << "Wrote " << outPath << " (verts=" << hdr.vertexCount << ", indices=" << hdr.indexCount
+              << (compactVertices ? ", compact" : "") << ")\n";
     return true;
 }
 
@@ -247,9 +307,22 @@ int main(int argc, char **argv)
 {
     if (argc < 3)
     {
-        std::cerr << "Usage: ObjToSMesh <input_obj_or_dir> <output_dir>\n";
+        std::cerr << "Usage: ObjToSMesh <input_obj_or_dir> <output_dir> [--vertices=float|compact]\n";
+        std::cerr << "  --vertices=float     32-byte pos3/norm3/uv2 vertices (default)\n";
+        std::cerr << "  --vertices=compact   16-byte half position/uv, snorm8 normal\n";
         return 1;
     }
+    bool compactVertices = false;
+    for (int i = 3; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--vertices=compact")
+            compactVertices = true;
+        else if (arg == "--vertices=float")
+            compactVertices = false;
+        else
+            std::cerr << "WARNING: unknown option ignored: " << arg << "\n";
+    }
     fs::path input = argv[1];
     fs::path outDir = argv[2];
     std::error_code ec;
@@ -258,7 +331,7 @@ int main(int argc, char **argv)
     if (fs::is_regular_file(input) && input.extension() == ".obj")
     {
         fs::path outPath = outDir / (input.stem().string() + ".smesh");
-        return convertObjToSMesh(input, outPath) ? 0 : 2;
+        return convertObjToSMesh(input, outPath, compactVertices) ? 0 : 2;
     }
     else if (fs::is_directory(input))
     {
@@ -271,7 +344,7 @@ int main(int argc, char **argv)
                 fs::path outPath = outDir / rel;
                 outPath.replace_extension(".smesh");
                 fs::create_directories(outPath.parent_path(), ec);
-                if (!convertObjToSMesh(p.path(), outPath))
+                if (!convertObjToSMesh(p.path(), outPath, compactVertices))
                     failures++;
             }
         }
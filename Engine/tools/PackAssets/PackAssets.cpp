@@ -0,0 +1,238 @@
+// PackAssets: bundles cooked runtime files into one .spak archive (format in utils/AssetArchive.h).
+//
+//   PackAssets <output.spak> <root_dir> [<subdir>...] [--codec=lz4|zstd|none] [--min-size=N]
+//
+// Entry paths are relative to <root_dir> ("assets/Knight/knight.smodel", "entities/knight.json"),
+// the same relative paths the game opens, so a mounted archive shadows the loose files.
+// With subdirs only those trees are packed. Files that do not shrink are stored uncompressed.
+
+#include "utils/AssetArchive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace Engine;
+
+namespace
+{
+    struct InputFile
+    {
+        std::string path; // normalized archive path
+        fs::path source;
+    };
+
+    bool readFile(const fs::path &path, std::vector<uint8_t> &out)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+        const std::streamsize size = file.tellg();
+        if (size < 0)
+            return false;
+        file.seekg(0, std::ios::beg);
+        out.resize(static_cast<size_t>(size));
+        return size == 0 || static_cast<bool>(file.read(reinterpret_cast<char *>(out.data()), size));
+    }
+
+    bool writeZeros(std::ofstream &out, uint64_t count)
+    {
+        static const char zeros[4096] = {};
+        while (count > 0)
+        {
+            const uint64_t n = std::min<uint64_t>(count, sizeof(zeros));
+            if (!out.write(zeros, static_cast<std::streamsize>(n)))
+                return false;
+            count -= n;
+        }
+        return true;
+    }
+
+    uint64_t alignUp(uint64_t v, uint64_t a)
+    {
+        return (v + a - 1) / a * a;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: PackAssets <output.spak> <root_dir> [<subdir>...] [--codec=lz4|zstd|none] [--min-size=N]\n";
+        std::cerr << "  --codec=lz4     LZ4 block compression (default; fast to decode)\n";
+        std::cerr << "  --codec=zstd    Zstd level 19 (smaller; needs a Zstd-enabled build)\n";
+        std::cerr << "  --codec=none    store everything\n";
+        std::cerr << "  --min-size=N    store files smaller than N bytes (default 512)\n";
+        return 1;
+    }
+
+    const fs::path outPath = argv[1];
+    const fs::path root = argv[2];
+    ArchiveCodec codec = ArchiveCodec::LZ4;
+    uint64_t minCompressSize = 512;
+    std::vector<fs::path> trees;
+    for (int i = 3; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--codec=lz4")
+            codec = ArchiveCodec::LZ4;
+        else if (arg == "--codec=zstd")
+            codec = ArchiveCodec::Zstd;
+        else if (arg == "--codec=none")
+            codec = ArchiveCodec::Stored;
+        else if (arg.rfind("--min-size=", 0) == 0)
+            minCompressSize = std::stoull(arg.substr(11));
+        else if (arg.rfind("--", 0) == 0)
+            std::cerr << "WARNING: unknown option ignored: " << arg << "\n";
+        else
+            trees.push_back(root / arg);
+    }
+    if (!ArchiveCodecAvailable(codec))
+    {
+        std::cerr << "WARNING: Zstd support not compiled in; using LZ4\n";
+        codec = ArchiveCodec::LZ4;
+    }
+    if (trees.empty())
+        trees.push_back(root);
+
+    // ---- Gather ----
+    std::error_code ec;
+    const fs::path outAbs = fs::weakly_canonical(outPath, ec);
+    std::vector<InputFile> inputs;
+    for (const fs::path &tree : trees)
+    {
+        if (!fs::is_directory(tree))
+        {
+            std::cerr << "ERROR: not a directory: " << tree.string() << "\n";
+            return 2;
+        }
+        for (const auto &entry : fs::recursive_directory_iterator(tree))
+        {
+            if (!entry.is_regular_file())
+                continue;
+            const fs::path &p = entry.path();
+            if (p.extension() == ".tmp" || fs::weakly_canonical(p, ec) == outAbs)
+                continue;
+            inputs.push_back({NormalizeArchivePath(p.lexically_relative(root).generic_string()), p});
+        }
+    }
+    std::sort(inputs.begin(), inputs.end(), [](const InputFile &a, const InputFile &b)
+              { return a.path < b.path; });
+    inputs.erase(std::unique(inputs.begin(), inputs.end(), [](const InputFile &a, const InputFile &b)
+                             { return a.path == b.path; }),
+                 inputs.end());
+    if (inputs.empty())
+    {
+        std::cerr << "ERROR: nothing to pack under " << root.string() << "\n";
+        return 2;
+    }
+
+    // ---- Fixed-size front: header, TOC, path strings ----
+    std::string paths;
+    std::vector<ArchiveEntry> entries(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        ArchiveEntry &e = entries[i];
+        e = ArchiveEntry{};
+        e.pathHash = ArchivePathHash(inputs[i].path);
+        e.pathOffset = static_cast<uint32_t>(paths.size());
+        e.pathSize = static_cast<uint32_t>(inputs[i].path.size());
+        paths += inputs[i].path;
+    }
+
+    ArchiveHeader header{};
+    std::memcpy(header.magic, kArchiveMagic, sizeof(header.magic));
+    header.versionMajor = kArchiveVersionMajor;
+    header.versionMinor = kArchiveVersionMinor;
+    header.headerSize = sizeof(ArchiveHeader);
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.tocOffset = sizeof(ArchiveHeader);
+    header.pathsOffset = header.tocOffset + entries.size() * sizeof(ArchiveEntry);
+    header.pathsSize = paths.size();
+
+    const fs::path temp = fs::path(outPath).concat(".tmp");
+    std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        std::cerr << "ERROR: cannot write " << temp.string() << "\n";
+        return 3;
+    }
+
+    // ---- Data, in path order so a directory's files sit together ----
+    uint64_t cursor = alignUp(header.pathsOffset + header.pathsSize, kArchiveAlignment);
+    if (!writeZeros(out, cursor))
+        return 3;
+
+    uint64_t totalIn = 0;
+    uint64_t totalStored = 0;
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> packed;
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        if (!readFile(inputs[i].source, bytes))
+        {
+            std::cerr << "ERROR: cannot read " << inputs[i].source.string() << "\n";
+            return 3;
+        }
+
+        ArchiveEntry &e = entries[i];
+        e.dataOffset = cursor;
+        e.size = bytes.size();
+        e.codec = static_cast<uint32_t>(ArchiveCodec::Stored);
+        const std::vector<uint8_t> *payload = &bytes;
+        if (codec != ArchiveCodec::Stored && bytes.size() >= minCompressSize &&
+            CompressArchiveEntry(codec, bytes.data(), bytes.size(), packed))
+        {
+            e.codec = static_cast<uint32_t>(codec);
+            payload = &packed;
+        }
+        e.storedSize = payload->size();
+
+        if (!out.write(reinterpret_cast<const char *>(payload->data()), static_cast<std::streamsize>(payload->size())))
+            return 3;
+        const uint64_t end = cursor + e.storedSize;
+        cursor = alignUp(end, kArchiveAlignment);
+        if (!writeZeros(out, cursor - end))
+            return 3;
+
+        totalIn += e.size;
+        totalStored += e.storedSize;
+    }
+    header.fileSizeBytes = cursor;
+
+    // ---- Front, now that data offsets are known ----
+    std::sort(entries.begin(), entries.end(), [&](const ArchiveEntry &a, const ArchiveEntry &b)
+              {
+                  if (a.pathHash != b.pathHash)
+                      return a.pathHash < b.pathHash;
+                  return paths.compare(a.pathOffset, a.pathSize, paths, b.pathOffset, b.pathSize) < 0;
+              });
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(ArchiveEntry)));
+    out.write(paths.data(), static_cast<std::streamsize>(paths.size()));
+    out.close();
+    if (!out)
+    {
+        std::cerr << "ERROR: failed writing " << temp.string() << "\n";
+        fs::remove(temp, ec);
+        return 3;
+    }
+
+    fs::rename(temp, outPath, ec);
+    if (ec)
+    {
+        std::cerr << "ERROR: cannot replace " << outPath.string() << ": " << ec.message() << "\n";
+        fs::remove(temp, ec);
+        return 3;
+    }
+
+    std::cout << "[PackAssets] " << entries.size() << " files, " << totalIn << " -> " << totalStored
+              << " bytes (" << cursor << " with alignment) -> " << outPath.string() << "\n";
+    return 0;
+}
@@ -3,6 +3,7 @@
 #include "Engine/Application.h"
 #include "Engine/Camera.h"
 #include "src/MenuManager.h"
+#include "src/Picking.h"
 
 #include "update.h"
 
@@ -27,6 +28,7 @@ public:
 
     void Close() override;
     void OnUpdate(Engine::TimeStep ts) override;
+    void OnFixedUpdate(Engine::TimeStep ts) override;
     void OnRender() override;
 
 private:
@@ -34,6 +36,9 @@ private:
     void OnEvent(const std::string &name);
     void ApplyRTSCamera(float aspect);
     void PickAndSelectEntityAtCursor();
+    void BoxSelectEntities(glm::vec2 from, glm::vec2 to);
+    void SelectEntities(const std::vector<Engine::ECS::Entity> &picked); // replaces ecs.selection
+    Sample::PickView CurrentPickView();
 
 private:
     struct RTSCameraController
@@ -61,6 +66,9 @@ private:
     bool m_isPanning = false;
     bool m_panJustStarted = false;
     float m_scrollDelta = 0.0f;
+    bool m_isBoxSelecting = false; // right button held: click on release, or box if dragged
+    glm::vec2 m_boxStart{0.0f, 0.0f};
+    std::vector<Engine::ECS::Entity> m_pickScratch;
     Engine::Camera m_camera;
 
     // Simple background ground plane
@@ -72,8 +80,9 @@ private:
         // Menu
     MenuManager m_menu;
 
-    // Small save slot filename
+    // Small save slot filename (camera/window); the world goes to a binary ECS snapshot next to it
     std::string m_saveFilePath = "sample_save.json";
+    std::string m_worldSaveFilePath = "sample_save.ecs";
 
     // Helpers
     void SaveGameState();
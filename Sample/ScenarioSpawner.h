@@ -8,9 +8,25 @@ namespace Engine::ECS
     struct ECSContext;
 }
 
+class NavGrid;
+class FormationGroups;
+
 namespace Sample
 {
     // Spawns entities described in the scenario JSON.
-    // Returns total number of spawned entities.
-    uint32_t SpawnFromScenarioFile(Engine::ECS::ECSContext &ecs, const std::string &scenarioPath, bool selectSpawned = true);
+    // Returns total number of spawned entities. 'selectSpawned' adds them to ecs.selection.
+    // 'totalUnits' > 0 rescales every group's count (and grid columns, keeping its shape) so the
+    // scenario spawns about that many units in the same proportions (StratosphereBench).
+    // With 'formations', every spawn group becomes one formation whose slots are its grid/circle layout.
+    // Jitter is seeded from each group id and the scenario's optional "seed", identically on every platform.
+    // 'deterministic' (lockstep) lays circle formations out without libm sin/cos, so peers on
+    // different platforms spawn bit-identical positions.
+    uint32_t SpawnFromScenarioFile(Engine::ECS::ECSContext &ecs, const std::string &scenarioPath, bool selectSpawned = true,
+                                   uint32_t totalUnits = 0, FormationGroups *formations = nullptr,
+                                   bool deterministic = false);
+
+    // Applies the scenario's optional "obstacles" array to the navigation grid:
+    //   {"kind": "rect", "x", "z", "halfX_m", "halfZ_m", "cost"?} or {"kind": "circle", "x", "z", "radius_m"},
+    // positions relative to an optional "anchor". Returns the number of obstacles applied.
+    uint32_t LoadScenarioObstacles(const std::string &scenarioPath, NavGrid &grid);
 }
@@ -0,0 +1,348 @@
+// StratosphereMicroBench: Google Benchmark suite for the hot ECS, spatial and animation kernels.
+//
+//   StratosphereMicroBench --benchmark_format=json --benchmark_out=micro.json
+//   StratosphereMicroBench --benchmark_filter=Avoidance
+//
+// Fixtures are synthetic (inline prefab, jittered grids, generated skeletons) so the numbers do
+// not depend on cooked assets. Density arguments are the grid spacing in centimetres between
+// units: 150 is a packed blob, 400 a loose formation.
+
+#include "ECS/ECSContext.h"
+#include "ECS/Prefab.h"
+#include "ECS/PrefabSpawner.h"
+#include "assets/ModelAsset.h"
+
+#include "systems/SpatialIndexSystem.h"
+#include "systems/LocalAvoidanceSystem.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using namespace Engine::ECS;
+
+    // HeavyInfantry without visuals.
+    const char *kUnitPrefab = R"({
+        "name": "BenchUnit",
+        "components": ["Position", "Velocity", "Health", "MoveTarget", "MoveSpeed", "Radius", "Separation", "AvoidanceParams"],
+        "defaults": {
+            "Position": { "x": 0.0, "y": 0.0, "z": 0.0 },
+            "Velocity": { "x": 0.0, "y": 0.0, "z": 0.0 },
+            "Health": { "value": 140.0 },
+            "MoveTarget": { "x": 0.0, "y": 0.0, "z": 0.0, "active": 0 },
+            "MoveSpeed": { "value": 2.8 },
+            "Radius": { "r": 0.5 },
+            "Separation": { "value": 0.3 },
+            "AvoidanceParams": { "strength": 3.0, "maxAccel": 7.0, "blend": 0.55 }
+        }
+    })";
+
+    // 'units' BenchUnits on a jittered square grid centred on the origin, moving in random directions.
+    struct Crowd
+    {
+        ECSContext ecs;
+        Prefab prefab;
+        std::vector<Position> positions;
+
+        Crowd(uint32_t units, float spacingM)
+        {
+            prefab = loadPrefabFromJson(kUnitPrefab, ecs.components, ecs.archetypes, nullptr);
+
+            std::mt19937 rng(1234);
+            std::uniform_real_distribution<float> jitter(-0.25f * spacingM, 0.25f * spacingM);
+            const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(units))));
+            const float half = 0.5f * static_cast<float>(side - 1) * spacingM;
+            positions.resize(units);
+            for (uint32_t i = 0; i < units; ++i)
+            {
+                positions[i].x = static_cast<float>(i % side) * spacingM - half + jitter(rng);
+                positions[i].z = static_cast<float>(i / side) * spacingM - half + jitter(rng);
+            }
+
+            const SpawnBatchResult res = spawnBatchFromPrefab(prefab, units, positions.data(), ecs.components,
+                                                              ecs.archetypes, ecs.stores, ecs.entities);
+            std::uniform_real_distribution<float> dir(-1.0f, 1.0f);
+            if (ArchetypeStore *store = ecs.stores.get(res.archetypeId))
+            {
+                auto vel = store->velocities();
+                for (uint32_t r = 0; r < store->size(); ++r)
+                {
+                    vel[r].x = dir(rng) * 2.0f;
+                    vel[r].z = dir(rng) * 2.0f;
+                }
+            }
+        }
+
+        ArchetypeStore &store() { return *ecs.stores.get(prefab.archetypeId); }
+    };
+
+    float spacingArg(const benchmark::State &state) { return static_cast<float>(state.range(1)) * 0.01f; }
+
+    // ------------------------------------------------------------
+    // ArchetypeStore rows
+    // ------------------------------------------------------------
+    // Steady population of range(0) rows: one createRow + one swap-erase destroyRow per iteration.
+    void BM_ArchetypeStoreCreateDestroyRow(benchmark::State &state)
+    {
+        Crowd crowd(static_cast<uint32_t>(state.range(0)), 2.0f);
+        ArchetypeStore &store = crowd.store();
+        uint32_t next = 0;
+        for (auto _ : state)
+        {
+            const uint32_t row = store.createRow(Entity{next++, 1});
+            benchmark::DoNotOptimize(store.destroyRow(row / 2));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_ArchetypeStoreCreateDestroyRow)->Arg(1000)->Arg(100000);
+
+    // One wave of range(0) units from a prefab, with (range(1) = 1) or without its resolved row template.
+    void BM_PrefabSpawnBatch(benchmark::State &state)
+    {
+        const uint32_t units = static_cast<uint32_t>(state.range(0));
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            auto ecs = std::make_unique<ECSContext>();
+            Prefab prefab = loadPrefabFromJson(kUnitPrefab, ecs->components, ecs->archetypes, nullptr);
+            if (state.range(1) != 0)
+                resolveRowTemplate(prefab, ecs->components);
+            state.ResumeTiming();
+
+            benchmark::DoNotOptimize(spawnBatchFromPrefab(prefab, units, nullptr, ecs->components,
+                                                          ecs->archetypes, ecs->stores, ecs->entities));
+
+            state.PauseTiming();
+            ecs.reset();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * units);
+    }
+    BENCHMARK(BM_PrefabSpawnBatch)->ArgsProduct({{1000, 100000}, {0, 1}})->ArgNames({"units", "template"});
+
+    // ------------------------------------------------------------
+    // ComponentMask
+    // ------------------------------------------------------------
+    void BM_ComponentMaskMatches(benchmark::State &state)
+    {
+        constexpr uint32_t kMasks = 4096;
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<uint32_t> bit(0, ComponentMask::MaxComponents - 1);
+        std::vector<ComponentMask> masks(kMasks);
+        for (ComponentMask &m : masks)
+        {
+            for (int b = 0; b < 12; ++b)
+                m.set(bit(rng));
+        }
+        ComponentMask required;
+        required.set(bit(rng));
+        required.set(bit(rng));
+        ComponentMask excluded;
+        excluded.set(bit(rng));
+
+        for (auto _ : state)
+        {
+            uint32_t hits = 0;
+            for (const ComponentMask &m : masks)
+                hits += m.matches(required, excluded) ? 1u : 0u;
+            benchmark::DoNotOptimize(hits);
+        }
+        state.SetItemsProcessed(state.iterations() * kMasks);
+    }
+    BENCHMARK(BM_ComponentMaskMatches);
+
+    // ------------------------------------------------------------
+    // SpatialIndexSystem
+    // ------------------------------------------------------------
+    // Full re-bin of every unit (incremental off) into the bounded grid the Sample uses.
+    void BM_SpatialIndexUpdate(benchmark::State &state)
+    {
+        Crowd crowd(static_cast<uint32_t>(state.range(0)), spacingArg(state));
+        SpatialIndexSystem spatial(2.0f);
+        spatial.buildMasks(crowd.ecs.components);
+        spatial.setWorldBounds(-1024.0f, -1024.0f, 1024.0f, 1024.0f);
+        spatial.setIncremental(false);
+
+        for (auto _ : state)
+            spatial.update(crowd.ecs.stores, 1.0f / 30.0f);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_SpatialIndexUpdate)->ArgsProduct({{10000, 100000}, {150, 400}});
+
+    // One 3x3 neighbourhood visit per unit.
+    void BM_SpatialIndexForNeighbors(benchmark::State &state)
+    {
+        Crowd crowd(static_cast<uint32_t>(state.range(0)), spacingArg(state));
+        SpatialIndexSystem spatial(2.0f);
+        spatial.buildMasks(crowd.ecs.components);
+        spatial.setWorldBounds(-1024.0f, -1024.0f, 1024.0f, 1024.0f);
+        spatial.update(crowd.ecs.stores, 1.0f / 30.0f);
+
+        uint64_t visited = 0;
+        for (auto _ : state)
+        {
+            for (const Position &p : crowd.positions)
+            {
+                spatial.forNeighbors(p.x, p.z, [&](uint32_t storeId, uint32_t row)
+                                     { visited += storeId + row; });
+            }
+            benchmark::DoNotOptimize(visited);
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_SpatialIndexForNeighbors)->ArgsProduct({{10000, 100000}, {150, 400}});
+
+    // ------------------------------------------------------------
+    // LocalAvoidanceSystem
+    // ------------------------------------------------------------
+    // Serial update over a fixed grid; items/s is units per second, so 1/that is the per-unit cost.
+    void BM_LocalAvoidance(benchmark::State &state)
+    {
+        Crowd crowd(static_cast<uint32_t>(state.range(0)), spacingArg(state));
+        SpatialIndexSystem spatial(2.0f);
+        spatial.buildMasks(crowd.ecs.components);
+        spatial.setWorldBounds(-1024.0f, -1024.0f, 1024.0f, 1024.0f);
+        spatial.update(crowd.ecs.stores, 1.0f / 30.0f);
+
+        LocalAvoidanceSystem avoidance(&spatial);
+        avoidance.buildMasks(crowd.ecs.components);
+        avoidance.setSimdEnabled(state.range(2) != 0);
+
+        for (auto _ : state)
+            avoidance.update(crowd.ecs.stores, 1.0f / 30.0f);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_LocalAvoidance)->ArgsProduct({{10000, 50000}, {150, 400}, {0, 1}})->ArgNames({"units", "spacing_cm", "simd"});
+
+    // ------------------------------------------------------------
+    // ModelAsset::evaluatePoseInto
+    // ------------------------------------------------------------
+    // Binary-tree skeleton of 'nodeCount' nodes with one clip animating every node's rotation and
+    // translation over 'keys' keyframes.
+    std::unique_ptr<Engine::ModelAsset> makeSkeleton(uint32_t nodeCount, uint32_t keys)
+    {
+        auto model = std::make_unique<Engine::ModelAsset>();
+        model->nodes.resize(nodeCount);
+        for (uint32_t i = 0; i < nodeCount; ++i)
+        {
+            Engine::ModelAsset::ModelNode &n = model->nodes[i];
+            n.parentIndex = (i == 0) ? ~0u : (i - 1) / 2;
+            n.firstChildIndex = static_cast<uint32_t>(model->nodeChildIndices.size());
+            for (uint32_t c = 2 * i + 1; c <= 2 * i + 2 && c < nodeCount; ++c)
+            {
+                model->nodeChildIndices.push_back(c);
+                n.childCount++;
+            }
+            n.localMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.1f, 0.0f));
+        }
+        model->restTRS.resize(nodeCount);
+        for (auto &trs : model->restTRS)
+            trs.t = glm::vec3(0.0f, 0.1f, 0.0f);
+
+        const float duration = 1.0f;
+        Engine::smodel::SModelAnimationClipRecord clip{};
+        clip.durationSec = duration;
+        clip.channelCount = nodeCount * 2;
+        model->animClips.push_back(clip);
+
+        for (uint32_t i = 0; i < nodeCount; ++i)
+        {
+            for (uint16_t path : {static_cast<uint16_t>(Engine::smodel::SModelAnimPath::Translation),
+                                  static_cast<uint16_t>(Engine::smodel::SModelAnimPath::Rotation)})
+            {
+                const bool rotation = path == static_cast<uint16_t>(Engine::smodel::SModelAnimPath::Rotation);
+                Engine::smodel::SModelAnimationSamplerRecord s{};
+                s.firstTime = static_cast<uint32_t>(model->animTimes.size());
+                s.timeCount = keys;
+                s.firstValue = static_cast<uint32_t>(model->animValues.size());
+                s.valueCount = keys * (rotation ? 4 : 3);
+                s.interpolation = static_cast<uint8_t>(Engine::smodel::SModelAnimInterpolation::Linear);
+                for (uint32_t k = 0; k < keys; ++k)
+                {
+                    const float t = duration * static_cast<float>(k) / static_cast<float>(keys - 1);
+                    model->animTimes.push_back(t);
+                    if (rotation)
+                    {
+                        const glm::quat q = glm::angleAxis(t, glm::vec3(0.0f, 0.0f, 1.0f));
+                        model->animValues.insert(model->animValues.end(), {q.x, q.y, q.z, q.w});
+                    }
+                    else
+                    {
+                        model->animValues.insert(model->animValues.end(), {0.0f, 0.1f + 0.01f * t, 0.0f});
+                    }
+                }
+
+                Engine::smodel::SModelAnimationChannelRecord ch{};
+                ch.targetNode = i;
+                ch.path = path;
+                ch.samplerIndex = static_cast<uint16_t>(model->animSamplers.size());
+                model->animSamplers.push_back(s);
+                model->animChannels.push_back(ch);
+            }
+        }
+
+        model->buildNodeOrder();
+        model->buildClipTables();
+        return model;
+    }
+
+    // range(1) = bake rate (0: keyframe sampling).
+    void BM_EvaluatePose(benchmark::State &state)
+    {
+        const uint32_t nodeCount = static_cast<uint32_t>(state.range(0));
+        std::unique_ptr<Engine::ModelAsset> model = makeSkeleton(nodeCount, 30);
+        if (state.range(1) > 0)
+            model->bakeClips(static_cast<float>(state.range(1)));
+
+        std::vector<Engine::ModelAsset::NodeTRS> trs;
+        std::vector<glm::mat4> globals;
+        float t = 0.0f;
+        for (auto _ : state)
+        {
+            model->evaluatePoseInto(0, t, trs, globals);
+            benchmark::DoNotOptimize(globals.data());
+            t = (t > 0.99f) ? 0.0f : t + 0.0137f;
+        }
+        state.SetItemsProcessed(state.iterations() * nodeCount);
+    }
+    BENCHMARK(BM_EvaluatePose)->ArgsProduct({{16, 64, 128}, {0, 30}})->ArgNames({"nodes", "bake_hz"});
+
+    // ------------------------------------------------------------
+    // EntitiesRecord::find
+    // ------------------------------------------------------------
+    // Random-order lookups over range(0) attached entities.
+    void BM_EntitiesRecordFind(benchmark::State &state)
+    {
+        const uint32_t count = static_cast<uint32_t>(state.range(0));
+        EntitiesRecord entities;
+        std::vector<Entity> handles(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            handles[i] = entities.create();
+            entities.attach(handles[i], 1, i);
+        }
+        std::shuffle(handles.begin(), handles.end(), std::mt19937(42));
+
+        for (auto _ : state)
+        {
+            uint64_t rows = 0;
+            for (const Entity &e : handles)
+            {
+                if (const EntityRecord *rec = entities.find(e))
+                    rows += rec->row;
+            }
+            benchmark::DoNotOptimize(rows);
+        }
+        state.SetItemsProcessed(state.iterations() * count);
+    }
+    BENCHMARK(BM_EntitiesRecordFind)->Arg(1000)->Arg(100000);
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,414 @@
+// StratosphereBench: headless, reproducible simulation benchmark.
+//
+// Loads the prefabs and a Scinerio.json-style scenario, rescales it to each requested unit
+// count, issues one move order to every unit and runs Sample::SystemRunner::FixedUpdate for a
+// fixed number of fixed-dt ticks. Every tick is timed as a whole and per system (the PerfScopes
+// SystemScheduler opens), and the results are written as JSON for CI to diff against a baseline.
+//
+//   StratosphereBench [--scenario Scinerio.json] [--entities entities] [--units 1000,10000,50000,100000]
+//                     [--ticks 600] [--warmup 60] [--rate 30] [--target x,z] [--no-orders]
+//                     [--out bench_results.json] [--baseline previous.json] [--tolerance 0.15]
+//                     [--deterministic] [--replicate radius]
+//
+// Exit code: 0 ok, 1 setup failure, 2 a run's mean tick time regressed past the baseline.
+// No window or GPU is created: prefab visuals are skipped, so render batching, animation and
+// GPU passes are not part of the numbers.
+// --deterministic runs the lockstep mode and records the final state hash per run, so two
+// machines can compare their outputs for desyncs.
+// --replicate streams every measured tick to one loopback spectator client whose camera sits at
+// the order target (ECS/Replication.h; radius 0 = no interest limit) and records packet bytes
+// and the server-side encode time; both stay outside the tick samples.
+
+#include "update.h"
+#include "ScenarioSpawner.h"
+
+#include "ECS/ECSContext.h"
+#include "ECS/Prefab.h"
+#include "ECS/Replication.h"
+#include "Engine/Profiler.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace
+{
+    struct Options
+    {
+        std::string scenario = "Scinerio.json";
+        std::string entities = "entities";
+        std::vector<uint32_t> unitCounts{1000, 10000, 50000, 100000};
+        uint32_t ticks = 600;
+        uint32_t warmupTicks = 60;
+        float tickRate = 30.0f;
+        bool orders = true;
+        float targetX = 0.0f;
+        float targetZ = 0.0f;
+        std::string out = "bench_results.json";
+        std::string baseline;
+        float tolerance = 0.15f;
+        bool deterministic = false;
+        bool replicate = false;
+        float replicateRadius = 0.0f;
+    };
+
+    struct Summary
+    {
+        double meanMs = 0.0;
+        double p50Ms = 0.0;
+        double p95Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+    };
+
+    Summary summarize(std::vector<float> samples)
+    {
+        Summary s;
+        if (samples.empty())
+            return s;
+
+        std::sort(samples.begin(), samples.end());
+        double total = 0.0;
+        for (float v : samples)
+            total += v;
+
+        // Nearest rank.
+        auto rank = [&](double p)
+        {
+            const size_t i = static_cast<size_t>(p * static_cast<double>(samples.size() - 1) + 0.5);
+            return static_cast<double>(samples[std::min(i, samples.size() - 1)]);
+        };
+        s.meanMs = total / static_cast<double>(samples.size());
+        s.p50Ms = rank(0.50);
+        s.p95Ms = rank(0.95);
+        s.p99Ms = rank(0.99);
+        s.maxMs = samples.back();
+        return s;
+    }
+
+    json toJson(const Summary &s)
+    {
+        return json{{"meanMs", s.meanMs}, {"p50Ms", s.p50Ms}, {"p95Ms", s.p95Ms}, {"p99Ms", s.p99Ms}, {"maxMs", s.maxMs}};
+    }
+
+    bool parseUnitList(const std::string &text, std::vector<uint32_t> &out)
+    {
+        out.clear();
+        std::stringstream ss(text);
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            char *end = nullptr;
+            const unsigned long v = std::strtoul(item.c_str(), &end, 10);
+            if (item.empty() || *end != '\0' || v == 0)
+                return false;
+            out.push_back(static_cast<uint32_t>(v));
+        }
+        return !out.empty();
+    }
+
+    bool parseArgs(int argc, char **argv, Options &o)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--scenario" && hasValue)
+                o.scenario = argv[++i];
+            else if (arg == "--entities" && hasValue)
+                o.entities = argv[++i];
+            else if (arg == "--units" && hasValue)
+            {
+                if (!parseUnitList(argv[++i], o.unitCounts))
+                    return false;
+            }
+            else if (arg == "--ticks" && hasValue)
+                o.ticks = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            else if (arg == "--warmup" && hasValue)
+                o.warmupTicks = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            else if (arg == "--rate" && hasValue)
+                o.tickRate = std::strtof(argv[++i], nullptr);
+            else if (arg == "--target" && hasValue)
+            {
+                if (std::sscanf(argv[++i], "%f,%f", &o.targetX, &o.targetZ) != 2)
+                    return false;
+            }
+            else if (arg == "--deterministic")
+                o.deterministic = true;
+            else if (arg == "--replicate" && hasValue)
+            {
+                o.replicate = true;
+                o.replicateRadius = std::strtof(argv[++i], nullptr);
+            }
+            else if (arg == "--no-orders")
+                o.orders = false;
+            else if (arg == "--out" && hasValue)
+                o.out = argv[++i];
+            else if (arg == "--baseline" && hasValue)
+                o.baseline = argv[++i];
+            else if (arg == "--tolerance" && hasValue)
+                o.tolerance = std::strtof(argv[++i], nullptr);
+            else
+                return false;
+        }
+        return o.ticks > 0 && o.tickRate > 0.0f;
+    }
+
+    size_t loadPrefabs(Engine::ECS::ECSContext &ecs, const std::string &directory)
+    {
+        size_t count = 0;
+        std::error_code ec;
+        for (const auto &entry : std::filesystem::directory_iterator(directory, ec))
+        {
+            if (!entry.is_regular_file() || entry.path().extension() != ".json")
+                continue;
+            Engine::ECS::Prefab p = Engine::ECS::loadPrefabFile(entry.path().generic_string(), ecs.components, ecs.archetypes, nullptr);
+            if (p.name.empty())
+                continue;
+            ecs.prefabs.add(std::move(p), ecs.components);
+            ++count;
+        }
+        if (ec)
+            std::cerr << "[Bench] Cannot read " << directory << ": " << ec.message() << "\n";
+        return count;
+    }
+
+    // One scenario at one unit count; returns an empty object when nothing could be spawned.
+    json runScenario(const Options &o, uint32_t units)
+    {
+        Engine::ECS::ECSContext ecs;
+        if (loadPrefabs(ecs, o.entities) == 0)
+        {
+            std::cerr << "[Bench] No prefabs in " << o.entities << "\n";
+            return json();
+        }
+
+        Sample::SystemRunner systems;
+        const uint32_t spawned = Sample::SpawnFromScenarioFile(ecs, o.scenario, /*selectSpawned=*/true, units, &systems.Formations(),
+                                                               o.deterministic);
+        if (spawned == 0)
+            return json();
+        systems.Initialize(ecs.components);
+        // Reproducible ticks: flow fields and paths are built inside the tick that first needs them.
+        systems.FlowFields().setAsync(false);
+        systems.Paths().setAsync(false);
+        systems.SetDeterministic(o.deterministic);
+        Sample::LoadScenarioObstacles(o.scenario, systems.Navigation());
+        if (o.orders)
+            systems.SetGlobalMoveTarget(o.targetX, 0.0f, o.targetZ);
+
+        // Setup scopes (spawning, first-visit registration) stay out of the samples.
+        Engine::CpuProfiler::collectFrame();
+
+        const float dt = 1.0f / o.tickRate;
+        std::vector<float> tickMs;
+        tickMs.reserve(o.ticks);
+        std::map<std::string, std::vector<float>> systemMs;
+        std::vector<Engine::CpuProfiler::NodeStats> nodes;
+
+        Engine::ECS::ReplicationServer server;
+        Engine::ECS::ReplicationClient client;
+        uint32_t clientId = 0;
+        if (o.replicate)
+        {
+            server.initialize(ecs.components);
+            clientId = server.addClient();
+            server.setClientView(clientId, o.targetX, o.targetZ, o.replicateRadius);
+        }
+        std::vector<uint8_t> packet;
+        std::vector<float> packetBytes;
+        std::vector<float> encodeMs;
+        std::string replicationError;
+
+        for (uint32_t t = 0; t < o.warmupTicks + o.ticks; ++t)
+        {
+            const uint64_t start = Engine::CpuProfiler::nowNs();
+            {
+                Engine::PerfScope scope("Tick");
+                systems.FixedUpdate(ecs, dt);
+            }
+            const uint64_t elapsed = Engine::CpuProfiler::nowNs() - start;
+            Engine::CpuProfiler::collectFrame();
+
+            if (o.replicate)
+            {
+                const uint64_t encodeStart = Engine::CpuProfiler::nowNs();
+                server.captureTick(ecs);
+                server.writePacket(clientId, packet);
+                const uint64_t encodeNs = Engine::CpuProfiler::nowNs() - encodeStart;
+                if (!client.readPacket(packet.data(), packet.size(), replicationError))
+                    std::cerr << "[Bench] " << replicationError << "\n";
+                server.acknowledge(clientId, client.ackTick());
+                if (t >= o.warmupTicks)
+                {
+                    packetBytes.push_back(static_cast<float>(packet.size()));
+                    encodeMs.push_back(static_cast<float>(static_cast<double>(encodeNs) * 1e-6));
+                }
+            }
+            if (t < o.warmupTicks)
+                continue;
+
+            tickMs.push_back(static_cast<float>(static_cast<double>(elapsed) * 1e-6));
+            Engine::CpuProfiler::snapshot(nodes);
+            for (const Engine::CpuProfiler::NodeStats &n : nodes)
+            {
+                // Scopes below "Tick": the scheduler's systems and anything they open.
+                if (n.depth >= 2 && n.name)
+                    systemMs[n.name].push_back(n.lastMs);
+            }
+        }
+
+        json run;
+        run["units"] = spawned;
+        run["tick"] = toJson(summarize(tickMs));
+        json systemsJson = json::array();
+        for (auto &entry : systemMs)
+        {
+            json s = toJson(summarize(entry.second));
+            s["name"] = entry.first;
+            systemsJson.push_back(std::move(s));
+        }
+        run["systems"] = std::move(systemsJson);
+        if (o.deterministic)
+        {
+            char hash[17];
+            std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(systems.StateHash()));
+            run["stateHash"] = hash;
+        }
+        if (o.replicate)
+        {
+            const Summary bytes = summarize(packetBytes);
+            run["replication"] = json{{"interestRadius", o.replicateRadius},
+                                      {"meanBytes", bytes.meanMs},
+                                      {"p99Bytes", bytes.p99Ms},
+                                      {"maxBytes", bytes.maxMs},
+                                      {"encode", toJson(summarize(encodeMs))},
+                                      {"clientEntities", client.entityCount()}};
+        }
+
+        const Engine::ECS::ECSContext::MemoryUsage mem = ecs.memoryUsage();
+        run["memory"] = json{{"ecsColumnBytes", mem.columnBytes},
+                             {"ecsRowBytes", mem.rowBytes},
+                             {"ecsEntityRecordBytes", mem.entityRecordBytes},
+                             {"ecsCommandBytes", mem.commandBytes},
+                             {"ecsStoreCount", mem.storeCount}};
+
+        const Summary tick = summarize(tickMs);
+        std::printf("[Bench] %7u units: tick mean %.3f ms, p99 %.3f ms\n", spawned, tick.meanMs, tick.p99Ms);
+        for (auto &entry : systemMs)
+        {
+            const Summary s = summarize(entry.second);
+            std::printf("[Bench]   %-28s mean %.3f ms, p99 %.3f ms\n", entry.first.c_str(), s.meanMs, s.p99Ms);
+        }
+        if (o.replicate)
+        {
+            const Summary bytes = summarize(packetBytes);
+            std::printf("[Bench]   replication: %.0f bytes/tick mean, %.0f max, encode %.3f ms mean\n",
+                        bytes.meanMs, bytes.maxMs, summarize(encodeMs).meanMs);
+        }
+        return run;
+    }
+
+    // Runs whose mean tick time exceeds the baseline run with the same unit count by more than
+    // 'tolerance' (fraction). Returns the number of regressions.
+    int compareToBaseline(const json &results, const std::string &path, float tolerance)
+    {
+        std::ifstream in(path);
+        if (!in.is_open())
+        {
+            std::cerr << "[Bench] Baseline " << path << " not found, skipping comparison\n";
+            return 0;
+        }
+
+        json baseline;
+        try
+        {
+            in >> baseline;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[Bench] Baseline parse error: " << e.what() << "\n";
+            return 0;
+        }
+
+        int regressions = 0;
+        for (const json &run : results["runs"])
+        {
+            for (const json &base : baseline.value("runs", json::array()))
+            {
+                if (base.value("units", 0u) != run["units"].get<uint32_t>())
+                    continue;
+                const double was = base["tick"].value("meanMs", 0.0);
+                const double now = run["tick"]["meanMs"].get<double>();
+                if (was > 0.0 && now > was * (1.0 + tolerance))
+                {
+                    std::printf("[Bench] REGRESSION %u units: %.3f ms -> %.3f ms (+%.1f%%)\n",
+                                run["units"].get<uint32_t>(), was, now, (now / was - 1.0) * 100.0);
+                    ++regressions;
+                }
+            }
+        }
+        return regressions;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options o;
+    if (!parseArgs(argc, argv, o))
+    {
+        std::cerr << "usage: StratosphereBench [--scenario file] [--entities dir] [--units a,b,...] [--ticks n]\n"
+                     "                         [--warmup n] [--rate hz] [--target x,z] [--no-orders]\n"
+                     "                         [--out file] [--baseline file] [--tolerance fraction] [--deterministic]\n"
+                     "                         [--replicate radius]\n";
+        return 1;
+    }
+    Engine::CpuProfiler::setThreadName("Main");
+
+    json results;
+    results["schema"] = "stratosphere_bench_v1";
+    results["scenario"] = o.scenario;
+    results["ticks"] = o.ticks;
+    results["warmupTicks"] = o.warmupTicks;
+    results["tickRate"] = o.tickRate;
+    results["orders"] = o.orders;
+    results["hardwareThreads"] = std::thread::hardware_concurrency();
+    results["profiler"] = ENGINE_PROFILER != 0;
+    results["runs"] = json::array();
+
+    for (uint32_t units : o.unitCounts)
+    {
+        json run = runScenario(o, units);
+        if (run.is_null())
+        {
+            std::cerr << "[Bench] Run with " << units << " units failed\n";
+            return 1;
+        }
+        results["runs"].push_back(std::move(run));
+    }
+
+    std::ofstream out(o.out, std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "[Bench] Cannot write " << o.out << "\n";
+        return 1;
+    }
+    out << results.dump(2) << "\n";
+    std::cout << "[Bench] Results written to " << o.out << "\n";
+
+    if (!o.baseline.empty() && compareToBaseline(results, o.baseline, o.tolerance) > 0)
+        return 2;
+    return 0;
+}
@@ -0,0 +1,259 @@
+#include "nav/FlowField.h"
+
+#include "Engine/JobSystem.h"
+#include "Engine/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <utility>
+
+// Neighbor order: E, W, N(+z), S(-z), then diagonals NE, NW, SE, SW.
+const float FlowField::kDirX[8] = {1.0f, -1.0f, 0.0f, 0.0f, 0.70710678f, -0.70710678f, 0.70710678f, -0.70710678f};
+const float FlowField::kDirZ[8] = {0.0f, 0.0f, 1.0f, -1.0f, 0.70710678f, 0.70710678f, -0.70710678f, -0.70710678f};
+
+namespace
+{
+    constexpr int kOffX[8] = {1, -1, 0, 0, 1, -1, 1, -1};
+    constexpr int kOffZ[8] = {0, 0, 1, -1, 1, 1, -1, -1};
+    constexpr float kStep[8] = {1.0f, 1.0f, 1.0f, 1.0f, 1.41421356f, 1.41421356f, 1.41421356f, 1.41421356f};
+    constexpr float kInf = std::numeric_limits<float>::infinity();
+}
+
+void FlowField::build(const NavGrid &grid, int goalX0, int goalZ0, int goalX1, int goalZ1)
+{
+    Engine::PerfScope scope("FlowField::build");
+
+    m_minX = grid.minX();
+    m_minZ = grid.minZ();
+    m_cellSize = grid.cellSize();
+    m_cellsX = grid.cellsX();
+    m_cellsZ = grid.cellsZ();
+    m_gridVersion = grid.version();
+
+    const size_t cellCount = grid.cellCount();
+    m_integration.assign(cellCount, kInf);
+    m_direction.assign(cellCount, kNoDirection);
+
+    using Node = std::pair<float, uint32_t>; // (cost, cell)
+    std::vector<Node> heapStorage;
+    heapStorage.reserve(cellCount / 4);
+    std::priority_queue<Node, std::vector<Node>, std::greater<Node>> open(std::greater<Node>(), std::move(heapStorage));
+
+    goalX0 = std::max(goalX0, 0);
+    goalZ0 = std::max(goalZ0, 0);
+    goalX1 = std::min(goalX1, m_cellsX - 1);
+    goalZ1 = std::min(goalZ1, m_cellsZ - 1);
+    for (int cz = goalZ0; cz <= goalZ1; ++cz)
+    {
+        for (int cx = goalX0; cx <= goalX1; ++cx)
+        {
+            const uint32_t c = grid.cellIndex(cx, cz);
+            if (grid.blocked(c))
+                continue;
+            m_integration[c] = 0.0f;
+            m_direction[c] = kGoal;
+            open.emplace(0.0f, c);
+        }
+    }
+
+    // Integration field: Dijkstra outwards from the goal region.
+    while (!open.empty())
+    {
+        const auto [d, c] = open.top();
+        open.pop();
+        if (d > m_integration[c])
+            continue;
+
+        const int cx = static_cast<int>(c % static_cast<uint32_t>(m_cellsX));
+        const int cz = static_cast<int>(c / static_cast<uint32_t>(m_cellsX));
+        for (int k = 0; k < 8; ++k)
+        {
+            const int nx = cx + kOffX[k];
+            const int nz = cz + kOffZ[k];
+            if (nx < 0 || nz < 0 || nx >= m_cellsX || nz >= m_cellsZ)
+                continue;
+            const uint32_t n = grid.cellIndex(nx, nz);
+            if (grid.blocked(n))
+                continue;
+            // No corner cutting: a diagonal step needs both orthogonal cells open.
+            if (k >= 4 && (grid.blocked(grid.cellIndex(nx, cz)) || grid.blocked(grid.cellIndex(cx, nz))))
+                continue;
+
+            const float nd = d + kStep[k] * static_cast<float>(grid.cost(n));
+            if (nd < m_integration[n])
+            {
+                m_integration[n] = nd;
+                open.emplace(nd, n);
+            }
+        }
+    }
+
+    // Direction field: each reachable cell points at its cheapest neighbor (same corner rule).
+    for (int cz = 0; cz < m_cellsZ; ++cz)
+    {
+        for (int cx = 0; cx < m_cellsX; ++cx)
+        {
+            const uint32_t c = grid.cellIndex(cx, cz);
+            if (m_direction[c] == kGoal || m_integration[c] == kInf)
+                continue;
+
+            float best = m_integration[c];
+            uint8_t bestDir = kNoDirection;
+            for (int k = 0; k < 8; ++k)
+            {
+                const int nx = cx + kOffX[k];
+                const int nz = cz + kOffZ[k];
+                if (nx < 0 || nz < 0 || nx >= m_cellsX || nz >= m_cellsZ)
+                    continue;
+                if (k >= 4 && (grid.blocked(grid.cellIndex(nx, cz)) || grid.blocked(grid.cellIndex(cx, nz))))
+                    continue;
+                const float v = m_integration[grid.cellIndex(nx, nz)];
+                if (v < best)
+                {
+                    best = v;
+                    bestDir = static_cast<uint8_t>(k);
+                }
+            }
+            m_direction[c] = bestDir;
+        }
+    }
+}
+
+uint32_t FlowField::cellAt(float x, float z) const
+{
+    const int cx = std::min(std::max(static_cast<int>(std::floor((x - m_minX) / m_cellSize)), 0), m_cellsX - 1);
+    const int cz = std::min(std::max(static_cast<int>(std::floor((z - m_minZ) / m_cellSize)), 0), m_cellsZ - 1);
+    return static_cast<uint32_t>(cz) * static_cast<uint32_t>(m_cellsX) + static_cast<uint32_t>(cx);
+}
+
+float FlowField::distance(float x, float z) const
+{
+    return m_integration.empty() ? kInf : m_integration[cellAt(x, z)];
+}
+
+// ------------------------------------------------------------
+// FlowFieldCache
+// ------------------------------------------------------------
+
+void FlowFieldCache::setGrid(const NavGrid *grid)
+{
+    clear();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_grid = grid;
+}
+
+void FlowFieldCache::setGoalBlockCells(int cells)
+{
+    clear();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_goalBlockCells = std::max(1, cells);
+}
+
+uint32_t FlowFieldCache::goalKey(float x, float z) const
+{
+    if (!m_grid || !m_grid->valid())
+        return UINT32_MAX;
+    const uint32_t bx = static_cast<uint32_t>(m_grid->cellX(x) / m_goalBlockCells);
+    const uint32_t bz = static_cast<uint32_t>(m_grid->cellZ(z) / m_goalBlockCells);
+    return (bz << 16) | bx;
+}
+
+void FlowFieldCache::startBuild(Entry &entry, uint32_t key)
+{
+    const int gx0 = static_cast<int>(key & 0xFFFFu) * m_goalBlockCells;
+    const int gz0 = static_cast<int>(key >> 16) * m_goalBlockCells;
+    const int gx1 = gx0 + m_goalBlockCells - 1;
+    const int gz1 = gz0 + m_goalBlockCells - 1;
+
+    if (!m_async)
+    {
+        auto field = std::make_shared<FlowField>();
+        field->build(*m_grid, gx0, gz0, gx1, gz1);
+        entry.field = std::move(field);
+        return;
+    }
+
+    // The copy keeps the build independent of later grid edits (it is rebuilt on the next acquire).
+    auto job = std::make_shared<std::packaged_task<std::shared_ptr<const FlowField>()>>(
+        [grid = *m_grid, gx0, gz0, gx1, gz1]()
+        {
+            auto field = std::make_shared<FlowField>();
+            field->build(grid, gx0, gz0, gx1, gz1);
+            return std::shared_ptr<const FlowField>(std::move(field));
+        });
+    entry.pending = job->get_future();
+
+    // The job owns everything it touches, so it may outlive the cache.
+    Engine::JobSystem::get().submit([job]
+                                    { (*job)(); },
+                                    Engine::JobPriority::Background);
+}
+
+std::shared_ptr<const FlowField> FlowFieldCache::acquire(float goalX, float goalZ)
+{
+    const uint32_t key = goalKey(goalX, goalZ);
+    if (key == UINT32_MAX)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Entry &entry = m_entries[key];
+    entry.lastUse = ++m_useCounter;
+
+    if (entry.pending.valid() && entry.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        entry.field = entry.pending.get();
+
+    const bool stale = !entry.field || entry.field->gridVersion() != m_grid->version();
+    if (stale && !entry.pending.valid())
+    {
+        startBuild(entry, key);
+        if (m_entries.size() > m_capacity)
+            evict();
+    }
+    return entry.field;
+}
+
+void FlowFieldCache::evict()
+{
+    auto victim = m_entries.end();
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+        if (it->second.pending.valid())
+            continue;
+        if (victim == m_entries.end() || it->second.lastUse < victim->second.lastUse)
+            victim = it;
+    }
+    // Never evicts the entry just used: it has the newest lastUse (or a pending build).
+    if (victim != m_entries.end() && victim->second.lastUse != m_useCounter)
+        m_entries.erase(victim);
+}
+
+void FlowFieldCache::clear()
+{
+    std::unordered_map<uint32_t, Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entries.swap(m_entries);
+    }
+    // Builds still queued finish into futures nobody reads.
+}
+
+size_t FlowFieldCache::fieldCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+size_t FlowFieldCache::memoryBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t bytes = 0;
+    for (const auto &kv : m_entries)
+    {
+        if (kv.second.field)
+            bytes += kv.second.field->memoryBytes();
+    }
+    return bytes;
+}
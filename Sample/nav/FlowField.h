@@ -0,0 +1,125 @@
+#pragma once
+/*
+  FlowField.h
+  -----------
+  Purpose:
+    - Grid flow fields: one integration field (path cost to a goal region) plus one direction
+      field (which neighbor lowers that cost) per goal, so any number of units heading to the
+      same goal steer around obstacles with one O(1) lookup each.
+    - FlowFieldCache builds fields on demand, keyed by goal region, and keeps the most recently
+      used ones.
+
+  Usage:
+    - cache.setGrid(&navGrid); cache.setAsync(true);
+    - std::shared_ptr<const FlowField> f = cache.acquire(target.x, target.z); // thread-safe
+    - if (f && f->direction(pos.x, pos.z, dx, dz)) steer along (dx, dz); else steer straight.
+
+  Notes:
+    - Goals are regions of goalBlockCells x goalBlockCells nav cells, so formation slots around one
+      clicked point share a field; inside the region (direction() returns false) steer directly.
+    - Integration is Dijkstra over 8 neighbors (diagonals may not cut blocked corners); entering a
+      cell costs step length * NavGrid cost.
+    - Async builds run as background jobs on the engine JobSystem, from a copy of the grid; acquire()
+      returns nullptr (or the stale field after a grid edit) until the build finishes.
+      Sync mode builds inside acquire(), which keeps lockstep simulations deterministic.
+*/
+
+#include "nav/NavGrid.h"
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class FlowField
+{
+public:
+    static constexpr uint8_t kNoDirection = 0xFF; // unreachable or blocked
+    static constexpr uint8_t kGoal = 0xFE;        // inside the goal region
+
+    // Integrate from every passable cell in [goalX0, goalX1] x [goalZ0, goalZ1] (cell coordinates).
+    void build(const NavGrid &grid, int goalX0, int goalZ0, int goalX1, int goalZ1);
+
+    // Unit direction toward the goal at world (x, z); false in the goal region or where unreachable.
+    bool direction(float x, float z, float &dx, float &dz) const
+    {
+        if (m_direction.empty())
+            return false;
+        const uint8_t code = m_direction[cellAt(x, z)];
+        if (code >= 8)
+            return false;
+        dx = kDirX[code];
+        dz = kDirZ[code];
+        return true;
+    }
+
+    // Path cost from world (x, z) to the goal region (infinity if unreachable).
+    float distance(float x, float z) const;
+
+    uint32_t gridVersion() const { return m_gridVersion; }
+    size_t memoryBytes() const { return m_integration.capacity() * sizeof(float) + m_direction.capacity(); }
+
+    static const float kDirX[8];
+    static const float kDirZ[8];
+
+private:
+    uint32_t cellAt(float x, float z) const;
+
+    float m_minX = 0.0f, m_minZ = 0.0f, m_cellSize = 1.0f;
+    int m_cellsX = 0, m_cellsZ = 0;
+    uint32_t m_gridVersion = 0;
+    std::vector<float> m_integration; // per cell, row-major like NavGrid
+    std::vector<uint8_t> m_direction; // neighbor index 0..7, kGoal or kNoDirection
+};
+
+class FlowFieldCache
+{
+public:
+    FlowFieldCache() = default;
+
+    FlowFieldCache(const FlowFieldCache &) = delete;
+    FlowFieldCache &operator=(const FlowFieldCache &) = delete;
+
+    // The grid must outlive the cache; edit it only between simulation ticks.
+    void setGrid(const NavGrid *grid);
+    const NavGrid *grid() const { return m_grid; }
+
+    // Goal region edge in nav cells (default 4).
+    void setGoalBlockCells(int cells);
+    // Fields kept; the least recently used one without a pending build is evicted (default 8).
+    void setCapacity(size_t fields) { m_capacity = fields > 0 ? fields : 1; }
+    void setAsync(bool async) { m_async = async; }
+
+    // Goal region of world (x, z); lock-free, for per-chunk memoization of acquire().
+    uint32_t goalKey(float x, float z) const;
+
+    // Field toward the goal region around (goalX, goalZ), starting a build if there is none or the
+    // grid changed since it was built. nullptr while the first build is pending (async mode).
+    std::shared_ptr<const FlowField> acquire(float goalX, float goalZ);
+
+    void clear();
+    size_t fieldCount() const;
+    size_t memoryBytes() const;
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<const FlowField> field;
+        std::future<std::shared_ptr<const FlowField>> pending;
+        uint64_t lastUse = 0;
+    };
+
+    void startBuild(Entry &entry, uint32_t key);
+    void evict();
+
+    const NavGrid *m_grid = nullptr;
+    int m_goalBlockCells = 4;
+    size_t m_capacity = 8;
+    bool m_async = false;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint32_t, Entry> m_entries;
+    uint64_t m_useCounter = 0;
+};
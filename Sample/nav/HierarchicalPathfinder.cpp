@@ -0,0 +1,538 @@
+#include "nav/HierarchicalPathfinder.h"
+
+#include "Engine/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace
+{
+    constexpr int kOffX[8] = {1, -1, 0, 0, 1, -1, 1, -1};
+    constexpr int kOffZ[8] = {0, 0, 1, -1, 1, 1, -1, -1};
+    constexpr float kStep[8] = {1.0f, 1.0f, 1.0f, 1.0f, 1.41421356f, 1.41421356f, 1.41421356f, 1.41421356f};
+    constexpr float kInf = std::numeric_limits<float>::infinity();
+
+    // Entrances at least this wide get a transition at each end instead of one in the middle.
+    constexpr int kWideEntrance = 6;
+
+    using HeapNode = std::pair<float, uint32_t>; // (priority, index)
+    using MinHeap = std::priority_queue<HeapNode, std::vector<HeapNode>, std::greater<HeapNode>>;
+
+    float octile(int dx, int dz)
+    {
+        dx = std::abs(dx);
+        dz = std::abs(dz);
+        return static_cast<float>(std::max(dx, dz)) + 0.41421356f * static_cast<float>(std::min(dx, dz));
+    }
+
+    // Per-thread search buffers (path requests run on several workers).
+    struct Scratch
+    {
+        std::vector<float> dist;
+        std::vector<uint32_t> parent;
+        std::vector<uint32_t> cells;
+        std::vector<uint32_t> segment;
+        std::vector<float> startCosts;
+        std::vector<float> goalCosts;
+        std::vector<uint32_t> route;
+    };
+
+    Scratch &scratch()
+    {
+        thread_local Scratch s;
+        return s;
+    }
+
+    MinHeap makeHeap()
+    {
+        std::vector<HeapNode> storage;
+        storage.reserve(256);
+        return MinHeap(std::greater<HeapNode>(), std::move(storage));
+    }
+}
+
+uint32_t HierarchicalPathfinder::clusterOf(uint32_t cell) const
+{
+    const int cx = static_cast<int>(cell % static_cast<uint32_t>(m_grid.cellsX()));
+    const int cz = static_cast<int>(cell / static_cast<uint32_t>(m_grid.cellsX()));
+    return static_cast<uint32_t>((cz / m_clusterCells) * m_clustersX + cx / m_clusterCells);
+}
+
+void HierarchicalPathfinder::clusterRect(uint32_t cluster, int &x0, int &z0, int &x1, int &z1) const
+{
+    x0 = static_cast<int>(cluster % static_cast<uint32_t>(m_clustersX)) * m_clusterCells;
+    z0 = static_cast<int>(cluster / static_cast<uint32_t>(m_clustersX)) * m_clusterCells;
+    x1 = std::min(x0 + m_clusterCells, m_grid.cellsX()) - 1;
+    z1 = std::min(z0 + m_clusterCells, m_grid.cellsZ()) - 1;
+}
+
+uint32_t HierarchicalPathfinder::addNode(uint32_t cell, std::unordered_map<uint32_t, uint32_t> &nodeOfCell)
+{
+    auto it = nodeOfCell.find(cell);
+    if (it != nodeOfCell.end())
+        return it->second;
+
+    const uint32_t id = static_cast<uint32_t>(m_nodes.size());
+    const uint32_t cluster = clusterOf(cell);
+    m_nodes.push_back(Node{cell, cluster});
+    m_edges.emplace_back();
+    m_nodeSlot.push_back(static_cast<uint32_t>(m_clusterNodes[cluster].size()));
+    m_clusterNodes[cluster].push_back(id);
+    nodeOfCell.emplace(cell, id);
+    return id;
+}
+
+void HierarchicalPathfinder::addEntrances(int fixed, int from, int to, bool alongZ, std::unordered_map<uint32_t, uint32_t> &nodeOfCell)
+{
+    auto cellA = [&](int t)
+    { return alongZ ? m_grid.cellIndex(fixed, t) : m_grid.cellIndex(t, fixed); };
+    auto cellB = [&](int t)
+    { return alongZ ? m_grid.cellIndex(fixed + 1, t) : m_grid.cellIndex(t, fixed + 1); };
+
+    auto addTransition = [&](int t)
+    {
+        const uint32_t a = cellA(t);
+        const uint32_t b = cellB(t);
+        const uint32_t na = addNode(a, nodeOfCell);
+        const uint32_t nb = addNode(b, nodeOfCell);
+        const float cost = 0.5f * static_cast<float>(m_grid.cost(a) + m_grid.cost(b));
+        m_edges[na].push_back(Edge{nb, cost});
+        m_edges[nb].push_back(Edge{na, cost});
+    };
+
+    int runStart = -1;
+    for (int t = from; t <= to + 1; ++t)
+    {
+        const bool open = t <= to && !m_grid.blocked(cellA(t)) && !m_grid.blocked(cellB(t));
+        if (open && runStart < 0)
+            runStart = t;
+        if (open || runStart < 0)
+            continue;
+
+        const int runEnd = t - 1;
+        if (runEnd - runStart + 1 >= kWideEntrance)
+        {
+            addTransition(runStart);
+            addTransition(runEnd);
+        }
+        else
+        {
+            addTransition((runStart + runEnd) / 2);
+        }
+        runStart = -1;
+    }
+}
+
+void HierarchicalPathfinder::build(const NavGrid &grid, int clusterCells)
+{
+    Engine::PerfScope scope("HierarchicalPathfinder::build");
+
+    m_grid = grid;
+    m_clusterCells = std::max(2, clusterCells);
+    m_clustersX = (grid.cellsX() + m_clusterCells - 1) / m_clusterCells;
+    m_clustersZ = (grid.cellsZ() + m_clusterCells - 1) / m_clusterCells;
+    m_nodes.clear();
+    m_edges.clear();
+    m_nodeSlot.clear();
+    m_clusterNodes.assign(static_cast<size_t>(m_clustersX) * static_cast<size_t>(m_clustersZ), {});
+    {
+        std::lock_guard<std::mutex> lock(m_routeMutex);
+        m_routes.clear();
+    }
+    if (!grid.valid())
+        return;
+
+    // Abstract nodes: transitions across every border between neighbouring clusters.
+    std::unordered_map<uint32_t, uint32_t> nodeOfCell;
+    for (int cz = 0; cz < m_clustersZ; ++cz)
+    {
+        for (int cx = 0; cx < m_clustersX; ++cx)
+        {
+            const int x0 = cx * m_clusterCells;
+            const int z0 = cz * m_clusterCells;
+            const int x1 = std::min(x0 + m_clusterCells, grid.cellsX()) - 1;
+            const int z1 = std::min(z0 + m_clusterCells, grid.cellsZ()) - 1;
+            if (cx + 1 < m_clustersX)
+                addEntrances(x1, z0, z1, /*alongZ=*/true, nodeOfCell);
+            if (cz + 1 < m_clustersZ)
+                addEntrances(z1, x0, x1, /*alongZ=*/false, nodeOfCell);
+        }
+    }
+
+    // Intra-cluster edges: one Dijkstra per node gives its distance to every other node.
+    std::vector<float> costs;
+    for (uint32_t cluster = 0; cluster < m_clusterNodes.size(); ++cluster)
+    {
+        const std::vector<uint32_t> &nodes = m_clusterNodes[cluster];
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            costsToClusterNodes(m_nodes[nodes[i]].cell, cluster, costs);
+            for (size_t j = 0; j < nodes.size(); ++j)
+            {
+                if (j != i && costs[j] < kInf)
+                    m_edges[nodes[i]].push_back(Edge{nodes[j], costs[j]});
+            }
+        }
+    }
+}
+
+void HierarchicalPathfinder::costsToClusterNodes(uint32_t start, uint32_t cluster, std::vector<float> &costs) const
+{
+    int x0, z0, x1, z1;
+    clusterRect(cluster, x0, z0, x1, z1);
+    const int w = x1 - x0 + 1;
+    const int h = z1 - z0 + 1;
+
+    Scratch &s = scratch();
+    s.dist.assign(static_cast<size_t>(w) * static_cast<size_t>(h), kInf);
+    auto local = [&](int cx, int cz)
+    { return static_cast<uint32_t>((cz - z0) * w + (cx - x0)); };
+
+    const int sx = static_cast<int>(start % static_cast<uint32_t>(m_grid.cellsX()));
+    const int sz = static_cast<int>(start / static_cast<uint32_t>(m_grid.cellsX()));
+    MinHeap open = makeHeap();
+    if (sx >= x0 && sx <= x1 && sz >= z0 && sz <= z1 && !m_grid.blocked(start))
+    {
+        s.dist[local(sx, sz)] = 0.0f;
+        open.emplace(0.0f, local(sx, sz));
+    }
+
+    while (!open.empty())
+    {
+        const auto [d, l] = open.top();
+        open.pop();
+        if (d > s.dist[l])
+            continue;
+        const int cx = x0 + static_cast<int>(l % static_cast<uint32_t>(w));
+        const int cz = z0 + static_cast<int>(l / static_cast<uint32_t>(w));
+        for (int k = 0; k < 8; ++k)
+        {
+            const int nx = cx + kOffX[k];
+            const int nz = cz + kOffZ[k];
+            if (nx < x0 || nz < z0 || nx > x1 || nz > z1)
+                continue;
+            const uint32_t n = m_grid.cellIndex(nx, nz);
+            if (m_grid.blocked(n))
+                continue;
+            if (k >= 4 && (m_grid.blocked(m_grid.cellIndex(nx, cz)) || m_grid.blocked(m_grid.cellIndex(cx, nz))))
+                continue;
+            const float nd = d + kStep[k] * static_cast<float>(m_grid.cost(n));
+            if (nd < s.dist[local(nx, nz)])
+            {
+                s.dist[local(nx, nz)] = nd;
+                open.emplace(nd, local(nx, nz));
+            }
+        }
+    }
+
+    const std::vector<uint32_t> &nodes = m_clusterNodes[cluster];
+    costs.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        const uint32_t c = m_nodes[nodes[i]].cell;
+        costs[i] = s.dist[local(static_cast<int>(c % static_cast<uint32_t>(m_grid.cellsX())),
+                                static_cast<int>(c / static_cast<uint32_t>(m_grid.cellsX())))];
+    }
+}
+
+bool HierarchicalPathfinder::searchRect(uint32_t start, uint32_t goal, int x0, int z0, int x1, int z1,
+                                        std::vector<uint32_t> &cells) const
+{
+    const int w = x1 - x0 + 1;
+    const int h = z1 - z0 + 1;
+    const uint32_t cellsX = static_cast<uint32_t>(m_grid.cellsX());
+    const int gx = static_cast<int>(goal % cellsX);
+    const int gz = static_cast<int>(goal / cellsX);
+    const int sx = static_cast<int>(start % cellsX);
+    const int sz = static_cast<int>(start / cellsX);
+    if (sx < x0 || sx > x1 || sz < z0 || sz > z1 || gx < x0 || gx > x1 || gz < z0 || gz > z1)
+        return false;
+    if (m_grid.blocked(start) || m_grid.blocked(goal))
+        return false;
+
+    Scratch &s = scratch();
+    const size_t area = static_cast<size_t>(w) * static_cast<size_t>(h);
+    s.dist.assign(area, kInf);
+    s.parent.assign(area, UINT32_MAX);
+    auto local = [&](int cx, int cz)
+    { return static_cast<uint32_t>((cz - z0) * w + (cx - x0)); };
+
+    MinHeap open = makeHeap();
+    s.dist[local(sx, sz)] = 0.0f;
+    open.emplace(octile(gx - sx, gz - sz), local(sx, sz));
+    const uint32_t goalLocal = local(gx, gz);
+
+    bool found = false;
+    while (!open.empty())
+    {
+        const uint32_t l = open.top().second;
+        const float f = open.top().first;
+        open.pop();
+        const int cx = x0 + static_cast<int>(l % static_cast<uint32_t>(w));
+        const int cz = z0 + static_cast<int>(l / static_cast<uint32_t>(w));
+        const float d = s.dist[l];
+        if (f > d + octile(gx - cx, gz - cz) + 1e-4f)
+            continue; // stale entry
+        if (l == goalLocal)
+        {
+            found = true;
+            break;
+        }
+        for (int k = 0; k < 8; ++k)
+        {
+            const int nx = cx + kOffX[k];
+            const int nz = cz + kOffZ[k];
+            if (nx < x0 || nz < z0 || nx > x1 || nz > z1)
+                continue;
+            const uint32_t n = m_grid.cellIndex(nx, nz);
+            if (m_grid.blocked(n))
+                continue;
+            if (k >= 4 && (m_grid.blocked(m_grid.cellIndex(nx, cz)) || m_grid.blocked(m_grid.cellIndex(cx, nz))))
+                continue;
+            const float nd = d + kStep[k] * static_cast<float>(m_grid.cost(n));
+            const uint32_t nl = local(nx, nz);
+            if (nd < s.dist[nl])
+            {
+                s.dist[nl] = nd;
+                s.parent[nl] = l;
+                open.emplace(nd + octile(gx - nx, gz - nz), nl);
+            }
+        }
+    }
+    if (!found)
+        return false;
+
+    const size_t first = cells.size();
+    for (uint32_t l = goalLocal; l != UINT32_MAX; l = s.parent[l])
+        cells.push_back(m_grid.cellIndex(x0 + static_cast<int>(l % static_cast<uint32_t>(w)),
+                                         z0 + static_cast<int>(l / static_cast<uint32_t>(w))));
+    std::reverse(cells.begin() + static_cast<std::ptrdiff_t>(first), cells.end());
+    return true;
+}
+
+bool HierarchicalPathfinder::abstractSearch(uint32_t startCluster, const std::vector<float> &startCosts, uint32_t goalCluster,
+                                            const std::vector<float> &goalCosts, uint32_t goalCell, std::vector<uint32_t> &route) const
+{
+    const uint32_t n = static_cast<uint32_t>(m_nodes.size());
+    const uint32_t goalNode = n; // virtual node joined to every goal-cluster node
+    const uint32_t cellsX = static_cast<uint32_t>(m_grid.cellsX());
+    const int gx = static_cast<int>(goalCell % cellsX);
+    const int gz = static_cast<int>(goalCell / cellsX);
+    auto heuristic = [&](uint32_t node)
+    {
+        const uint32_t c = m_nodes[node].cell;
+        return octile(gx - static_cast<int>(c % cellsX), gz - static_cast<int>(c / cellsX));
+    };
+
+    std::vector<float> g(n + 1, kInf);
+    std::vector<uint32_t> parent(n + 1, UINT32_MAX);
+    MinHeap open = makeHeap();
+
+    const std::vector<uint32_t> &startNodes = m_clusterNodes[startCluster];
+    for (size_t i = 0; i < startNodes.size(); ++i)
+    {
+        if (startCosts[i] < kInf)
+        {
+            g[startNodes[i]] = startCosts[i];
+            open.emplace(startCosts[i] + heuristic(startNodes[i]), startNodes[i]);
+        }
+    }
+
+    while (!open.empty())
+    {
+        const auto [f, u] = open.top();
+        open.pop();
+        if (u == goalNode)
+            break;
+        if (f > g[u] + heuristic(u) + 1e-4f)
+            continue;
+
+        if (m_nodes[u].cluster == goalCluster)
+        {
+            const float cost = goalCosts[m_nodeSlot[u]];
+            if (cost < kInf && g[u] + cost < g[goalNode])
+            {
+                g[goalNode] = g[u] + cost;
+                parent[goalNode] = u;
+                open.emplace(g[goalNode], goalNode);
+            }
+        }
+        for (const Edge &e : m_edges[u])
+        {
+            const float nd = g[u] + e.cost;
+            if (nd < g[e.to])
+            {
+                g[e.to] = nd;
+                parent[e.to] = u;
+                open.emplace(nd + heuristic(e.to), e.to);
+            }
+        }
+    }
+    if (parent[goalNode] == UINT32_MAX)
+        return false;
+
+    route.clear();
+    for (uint32_t u = parent[goalNode]; u != UINT32_MAX; u = parent[u])
+        route.push_back(u);
+    std::reverse(route.begin(), route.end());
+    return true;
+}
+
+bool HierarchicalPathfinder::lineOfSight(uint32_t a, uint32_t b) const
+{
+    // Grid traversal between cell centers; touching a corner checks both cells beside it.
+    const uint32_t cellsX = static_cast<uint32_t>(m_grid.cellsX());
+    int x = static_cast<int>(a % cellsX), z = static_cast<int>(a / cellsX);
+    const int bx = static_cast<int>(b % cellsX), bz = static_cast<int>(b / cellsX);
+    const int dx = std::abs(bx - x), dz = std::abs(bz - z);
+    const int stepX = bx > x ? 1 : -1, stepZ = bz > z ? 1 : -1;
+
+    int error = dx - dz;
+    for (int n = dx + dz; n > 0; --n)
+    {
+        if (error > 0)
+        {
+            x += stepX;
+            error -= 2 * dz;
+        }
+        else if (error < 0)
+        {
+            z += stepZ;
+            error += 2 * dx;
+        }
+        else
+        {
+            // Exactly through a corner: both side cells must be open.
+            if (m_grid.blocked(m_grid.cellIndex(x + stepX, z)) || m_grid.blocked(m_grid.cellIndex(x, z + stepZ)))
+                return false;
+            x += stepX;
+            z += stepZ;
+            error += 2 * (dx - dz);
+            --n;
+        }
+        if (m_grid.blocked(m_grid.cellIndex(x, z)))
+            return false;
+    }
+    return true;
+}
+
+void HierarchicalPathfinder::smooth(const std::vector<uint32_t> &cells, float goalX, float goalZ, std::vector<PathPoint> &out) const
+{
+    const uint32_t cellsX = static_cast<uint32_t>(m_grid.cellsX());
+    auto center = [&](uint32_t c)
+    {
+        return PathPoint{m_grid.cellCenterX(static_cast<int>(c % cellsX)), m_grid.cellCenterZ(static_cast<int>(c / cellsX))};
+    };
+
+    // String pulling: keep a cell only where the straight line from the last kept one gets blocked.
+    size_t anchor = 0;
+    for (size_t k = 2; k < cells.size(); ++k)
+    {
+        if (!lineOfSight(cells[anchor], cells[k]))
+        {
+            anchor = k - 1;
+            out.push_back(center(cells[anchor]));
+        }
+    }
+    out.push_back(PathPoint{goalX, goalZ});
+}
+
+bool HierarchicalPathfinder::findPath(float startX, float startZ, float goalX, float goalZ, std::vector<PathPoint> &out) const
+{
+    out.clear();
+    if (!built())
+        return false;
+
+    const uint32_t start = m_grid.cellAt(startX, startZ);
+    const uint32_t goal = m_grid.cellAt(goalX, goalZ);
+    if (m_grid.blocked(start) || m_grid.blocked(goal))
+        return false;
+
+    Scratch &s = scratch();
+    s.cells.clear();
+    const uint32_t startCluster = clusterOf(start);
+    const uint32_t goalCluster = clusterOf(goal);
+
+    int x0, z0, x1, z1;
+    if (startCluster == goalCluster)
+    {
+        clusterRect(startCluster, x0, z0, x1, z1);
+        if (searchRect(start, goal, x0, z0, x1, z1, s.cells))
+        {
+            smooth(s.cells, goalX, goalZ, out);
+            return true;
+        }
+        s.cells.clear(); // the way round may leave the cluster
+    }
+
+    costsToClusterNodes(start, startCluster, s.startCosts);
+    costsToClusterNodes(goal, goalCluster, s.goalCosts);
+
+    // Cached route between the two clusters, if this start and goal can join it.
+    const uint64_t key = (static_cast<uint64_t>(startCluster) << 32) | goalCluster;
+    bool haveRoute = false;
+    if (m_routeCapacity > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_routeMutex);
+        auto it = m_routes.find(key);
+        if (it != m_routes.end() && !it->second.empty() &&
+            s.startCosts[m_nodeSlot[it->second.front()]] < kInf && s.goalCosts[m_nodeSlot[it->second.back()]] < kInf)
+        {
+            s.route = it->second;
+            haveRoute = true;
+        }
+    }
+    if (!haveRoute)
+    {
+        if (!abstractSearch(startCluster, s.startCosts, goalCluster, s.goalCosts, goal, s.route))
+            return false;
+        if (m_routeCapacity > 0)
+        {
+            std::lock_guard<std::mutex> lock(m_routeMutex);
+            if (m_routes.size() >= m_routeCapacity)
+                m_routes.clear();
+            m_routes[key] = s.route;
+        }
+    }
+
+    // Refine: a cluster-local search for each intra-cluster hop; border crossings are one step.
+    s.cells.push_back(start);
+    auto appendHop = [&](uint32_t to)
+    {
+        const uint32_t from = s.cells.back();
+        if (from == to)
+            return true;
+        if (clusterOf(from) != clusterOf(to))
+        {
+            s.cells.push_back(to);
+            return true;
+        }
+        int cx0, cz0, cx1, cz1;
+        clusterRect(clusterOf(from), cx0, cz0, cx1, cz1);
+        s.segment.clear();
+        if (!searchRect(from, to, cx0, cz0, cx1, cz1, s.segment))
+            return false;
+        s.cells.insert(s.cells.end(), s.segment.begin() + 1, s.segment.end());
+        return true;
+    };
+    for (uint32_t node : s.route)
+    {
+        if (!appendHop(m_nodes[node].cell))
+            return false;
+    }
+    if (!appendHop(goal))
+        return false;
+
+    smooth(s.cells, goalX, goalZ, out);
+    return true;
+}
+
+size_t HierarchicalPathfinder::routeCacheSize() const
+{
+    std::lock_guard<std::mutex> lock(m_routeMutex);
+    return m_routes.size();
+}
@@ -0,0 +1,91 @@
+#pragma once
+/*
+  HierarchicalPathfinder.h
+  ------------------------
+  Purpose:
+    - HPA* over a NavGrid: the grid is cut into clusters, entrances between neighbouring clusters
+      become abstract nodes, and intra-cluster distances between them are precomputed. A query
+      searches the small abstract graph, then refines each hop with a search inside one cluster
+      and smooths the result with grid line-of-sight checks.
+    - Abstract routes are cached by (start cluster, goal cluster), so groups ordered between the
+      same areas skip the abstract search.
+
+  Usage:
+    - HierarchicalPathfinder hpa; hpa.build(grid, 16);
+    - std::vector<PathPoint> points; if (hpa.findPath(sx, sz, gx, gz, points)) ...
+
+  Notes:
+    - build() keeps a copy of the grid; rebuild after editing it (compare builtVersion()).
+    - findPath() is safe to call from several threads at once: searches use thread-local scratch,
+      the route cache has its own lock.
+    - Points exclude the start and end exactly at the goal.
+*/
+
+#include "nav/NavGrid.h"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct PathPoint
+{
+    float x = 0.0f;
+    float z = 0.0f;
+};
+
+class HierarchicalPathfinder
+{
+public:
+    void build(const NavGrid &grid, int clusterCells = 16);
+
+    bool built() const { return m_grid.valid(); }
+    uint32_t builtVersion() const { return m_grid.version(); }
+    size_t nodeCount() const { return m_nodes.size(); }
+
+    bool findPath(float startX, float startZ, float goalX, float goalZ, std::vector<PathPoint> &out) const;
+
+    // Cached (start cluster, goal cluster) routes; cleared when full, 0 disables the cache.
+    void setRouteCacheCapacity(size_t routes) { m_routeCapacity = routes; }
+    size_t routeCacheSize() const;
+
+private:
+    struct Edge
+    {
+        uint32_t to;
+        float cost;
+    };
+
+    struct Node
+    {
+        uint32_t cell;
+        uint32_t cluster;
+    };
+
+    uint32_t clusterOf(uint32_t cell) const;
+    void clusterRect(uint32_t cluster, int &x0, int &z0, int &x1, int &z1) const;
+    uint32_t addNode(uint32_t cell, std::unordered_map<uint32_t, uint32_t> &nodeOfCell);
+    // Cell pairs (fixed, t) | (fixed + 1, t) if alongZ, else (t, fixed) | (t, fixed + 1), for t in [from, to].
+    void addEntrances(int fixed, int from, int to, bool alongZ, std::unordered_map<uint32_t, uint32_t> &nodeOfCell);
+
+    // Grid search inside [x0, x1] x [z0, z1]; cells from start to goal (inclusive) in order.
+    bool searchRect(uint32_t start, uint32_t goal, int x0, int z0, int x1, int z1, std::vector<uint32_t> &cells) const;
+    // Costs from 'start' to every node of 'cluster' (infinity where unreachable).
+    void costsToClusterNodes(uint32_t start, uint32_t cluster, std::vector<float> &costs) const;
+    bool abstractSearch(uint32_t startCluster, const std::vector<float> &startCosts, uint32_t goalCluster,
+                        const std::vector<float> &goalCosts, uint32_t goalCell, std::vector<uint32_t> &route) const;
+    bool lineOfSight(uint32_t a, uint32_t b) const;
+    void smooth(const std::vector<uint32_t> &cells, float goalX, float goalZ, std::vector<PathPoint> &out) const;
+
+    NavGrid m_grid;
+    int m_clusterCells = 16;
+    int m_clustersX = 0, m_clustersZ = 0;
+    std::vector<Node> m_nodes;
+    std::vector<std::vector<Edge>> m_edges;
+    std::vector<std::vector<uint32_t>> m_clusterNodes; // cluster -> node ids
+    std::vector<uint32_t> m_nodeSlot;                  // node -> index in its cluster's m_clusterNodes
+
+    mutable std::mutex m_routeMutex;
+    mutable std::unordered_map<uint64_t, std::vector<uint32_t>> m_routes; // (start, goal cluster) -> node ids
+    size_t m_routeCapacity = 4096;
+};
@@ -0,0 +1,123 @@
+#pragma once
+/*
+  NavGrid.h
+  ---------
+  Purpose:
+    - Walkability / traversal cost of the ground plane (X/Z, meters) on a flat grid, shared by
+      the navigation modules (flow fields, HPA* paths).
+
+  Usage:
+    - grid.configure(-512, -512, 512, 512, 2.0f);
+    - grid.blockRect(minX, minZ, maxX, maxZ);        // walls, cliffs, water
+    - grid.setCostRect(minX, minZ, maxX, maxZ, 3);   // slow terrain (mud, forest)
+
+  Notes:
+    - cost 1 is open ground, kBlocked is impassable. A cell costs cost * step length to enter.
+    - Every edit bumps version(); caches keyed by goal compare versions to know a field is stale.
+    - Positions outside the bounds clamp to edge cells, like SpatialIndexSystem's bounded grid.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+class NavGrid
+{
+public:
+    static constexpr uint8_t kOpen = 1;
+    static constexpr uint8_t kBlocked = 255;
+
+    void configure(float minX, float minZ, float maxX, float maxZ, float cellSize)
+    {
+        m_cellSize = std::max(cellSize, 1e-3f);
+        m_minX = minX;
+        m_minZ = minZ;
+        m_cellsX = std::max(1, static_cast<int>(std::ceil((maxX - minX) / m_cellSize)));
+        m_cellsZ = std::max(1, static_cast<int>(std::ceil((maxZ - minZ) / m_cellSize)));
+        m_cost.assign(static_cast<size_t>(m_cellsX) * static_cast<size_t>(m_cellsZ), kOpen);
+        ++m_version;
+    }
+
+    bool valid() const { return !m_cost.empty(); }
+    int cellsX() const { return m_cellsX; }
+    int cellsZ() const { return m_cellsZ; }
+    size_t cellCount() const { return m_cost.size(); }
+    float cellSize() const { return m_cellSize; }
+    float minX() const { return m_minX; }
+    float minZ() const { return m_minZ; }
+    uint32_t version() const { return m_version; }
+
+    int cellX(float x) const
+    {
+        const int c = static_cast<int>(std::floor((x - m_minX) / m_cellSize));
+        return std::min(std::max(c, 0), m_cellsX - 1);
+    }
+
+    int cellZ(float z) const
+    {
+        const int c = static_cast<int>(std::floor((z - m_minZ) / m_cellSize));
+        return std::min(std::max(c, 0), m_cellsZ - 1);
+    }
+
+    uint32_t cellIndex(int cx, int cz) const { return static_cast<uint32_t>(cz) * static_cast<uint32_t>(m_cellsX) + static_cast<uint32_t>(cx); }
+    uint32_t cellAt(float x, float z) const { return cellIndex(cellX(x), cellZ(z)); }
+
+    float cellCenterX(int cx) const { return m_minX + (static_cast<float>(cx) + 0.5f) * m_cellSize; }
+    float cellCenterZ(int cz) const { return m_minZ + (static_cast<float>(cz) + 0.5f) * m_cellSize; }
+
+    uint8_t cost(uint32_t cell) const { return m_cost[cell]; }
+    bool blocked(uint32_t cell) const { return m_cost[cell] == kBlocked; }
+    const std::vector<uint8_t> &costs() const { return m_cost; }
+
+    // Cost of every cell the rectangle overlaps.
+    void setCostRect(float minX, float minZ, float maxX, float maxZ, uint8_t cost)
+    {
+        if (!valid())
+            return;
+        cost = std::max<uint8_t>(cost, kOpen);
+        const int x0 = cellX(std::min(minX, maxX)), x1 = cellX(std::max(minX, maxX));
+        const int z0 = cellZ(std::min(minZ, maxZ)), z1 = cellZ(std::max(minZ, maxZ));
+        for (int cz = z0; cz <= z1; ++cz)
+        {
+            for (int cx = x0; cx <= x1; ++cx)
+                m_cost[cellIndex(cx, cz)] = cost;
+        }
+        ++m_version;
+    }
+
+    void blockRect(float minX, float minZ, float maxX, float maxZ) { setCostRect(minX, minZ, maxX, maxZ, kBlocked); }
+
+    void blockCircle(float x, float z, float radius)
+    {
+        if (!valid())
+            return;
+        const int x0 = cellX(x - radius), x1 = cellX(x + radius);
+        const int z0 = cellZ(z - radius), z1 = cellZ(z + radius);
+        const float r2 = radius * radius;
+        for (int cz = z0; cz <= z1; ++cz)
+        {
+            for (int cx = x0; cx <= x1; ++cx)
+            {
+                const float dx = cellCenterX(cx) - x;
+                const float dz = cellCenterZ(cz) - z;
+                if (dx * dx + dz * dz <= r2)
+                    m_cost[cellIndex(cx, cz)] = kBlocked;
+            }
+        }
+        ++m_version;
+    }
+
+    void clearCosts()
+    {
+        std::fill(m_cost.begin(), m_cost.end(), kOpen);
+        ++m_version;
+    }
+
+private:
+    float m_minX = 0.0f, m_minZ = 0.0f;
+    float m_cellSize = 1.0f;
+    int m_cellsX = 0, m_cellsZ = 0;
+    std::vector<uint8_t> m_cost; // row-major, z outer
+    uint32_t m_version = 0;
+};
@@ -0,0 +1,218 @@
+#include "nav/PathService.h"
+
+#include "Engine/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+PathService::~PathService()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    // Drains return at their next check; one in the middle of a search finishes it first.
+    Engine::JobSystem::get().wait(m_jobs, Engine::JobPriority::Background);
+}
+
+void PathService::setGrid(const NavGrid *grid)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_grid = grid;
+    m_gridVersion = 0; // next beginFrame() takes a fresh copy
+    m_hpa.reset();
+    m_pendingGrid.reset();
+}
+
+
+uint32_t PathService::request(Engine::ECS::Entity entity, float startX, float startZ, float goalX, float goalZ)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const uint32_t id = ++m_nextId;
+    m_latest[entity.index] = id;
+    const Request req{entity, id, startX, startZ, goalX, goalZ};
+
+    if (!m_async)
+    {
+        if (!m_grid || !m_grid->valid())
+        {
+            Result failed{entity, id, false, PathFollow{}};
+            failed.path.requestId = id;
+            failed.path.state = PathFollow::Failed;
+            m_results.push_back(failed);
+            return id;
+        }
+        if (!m_hpa || m_hpa->builtVersion() != m_grid->version())
+        {
+            auto hpa = std::make_shared<HierarchicalPathfinder>();
+            hpa->setRouteCacheCapacity(0); // answers must not depend on request order
+            hpa->build(*m_grid, m_clusterCells);
+            m_hpa = std::move(hpa);
+        }
+        m_results.push_back(solve(*m_hpa, req));
+        return id;
+    }
+
+    m_requests.push_back(req);
+    kickLocked();
+    return id;
+}
+
+void PathService::beginFrame()
+{
+    m_budgetLeft.store(m_budgetNs, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_async && m_grid && m_grid->valid() && m_grid->version() != m_gridVersion)
+    {
+        m_pendingGrid = std::make_shared<const NavGrid>(*m_grid);
+        m_gridVersion = m_grid->version();
+    }
+    kickLocked();
+}
+
+bool PathService::isLatest(const Request &req) const
+{
+    auto it = m_latest.find(req.entity.index);
+    return it != m_latest.end() && it->second == req.id;
+}
+
+bool PathService::hasWorkLocked() const
+{
+    if (m_quit || m_building)
+        return false;
+    if (m_pendingGrid)
+        return true;
+    // Answer only with a hierarchy of the newest grid copy.
+    return m_hpa && !m_requests.empty() && m_budgetLeft.load(std::memory_order_relaxed) > 0;
+}
+
+void PathService::kickLocked()
+{
+    while (m_draining < m_workerCount && hasWorkLocked())
+    {
+        ++m_draining;
+        Engine::JobSystem::get().submit([this]
+                                        { drain(); },
+                                        Engine::JobPriority::Background, &m_jobs);
+        if (m_pendingGrid)
+            break; // one job rebuilds; it starts the others once the hierarchy is ready
+    }
+}
+
+void PathService::drain()
+{
+    for (;;)
+    {
+        std::shared_ptr<const NavGrid> rebuild;
+        std::shared_ptr<const HierarchicalPathfinder> hpa;
+        Request req;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!hasWorkLocked())
+            {
+                --m_draining;
+                return;
+            }
+
+            if (m_pendingGrid)
+            {
+                rebuild = std::move(m_pendingGrid);
+                m_building = true;
+            }
+            else
+            {
+                req = m_requests.front();
+                m_requests.pop_front();
+                if (!isLatest(req))
+                    continue; // superseded by a newer order for the same unit
+                hpa = m_hpa;
+            }
+        }
+
+        if (rebuild)
+        {
+            auto next = std::make_shared<HierarchicalPathfinder>();
+            next->build(*rebuild, m_clusterCells);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_hpa = std::move(next);
+            m_building = false;
+            kickLocked();
+            continue;
+        }
+
+        const auto t0 = std::chrono::steady_clock::now();
+        Result result = solve(*hpa, req);
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+        m_budgetLeft.fetch_sub(static_cast<int64_t>(ns), std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (isLatest(req))
+            m_results.push_back(result);
+    }
+}
+
+PathService::Result PathService::solve(const HierarchicalPathfinder &hpa, const Request &req) const
+{
+    Engine::PerfScope scope("PathService::solve");
+
+    Result result;
+    result.entity = req.entity;
+    result.id = req.id;
+    result.path.requestId = req.id;
+
+    thread_local std::vector<PathPoint> points;
+    result.found = hpa.findPath(req.startX, req.startZ, req.goalX, req.goalZ, points);
+    if (!result.found)
+    {
+        result.path.state = PathFollow::Failed;
+        return result;
+    }
+
+    const size_t count = std::min<size_t>(points.size(), PathFollow::kMaxPoints);
+    for (size_t i = 0; i < count; ++i)
+    {
+        result.path.x[i] = points[i].x;
+        result.path.z[i] = points[i].z;
+    }
+    result.path.count = static_cast<uint8_t>(count);
+    result.path.next = 0;
+    result.path.partial = points.size() > PathFollow::kMaxPoints ? 1 : 0;
+    result.path.state = PathFollow::Following;
+    return result;
+}
+
+uint32_t PathService::deliver(const Engine::ECS::EntitiesRecord &records, Engine::ECS::ArchetypeStoreManager &stores)
+{
+    std::vector<Result> results;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        results.swap(m_results);
+        for (const Result &r : results)
+        {
+            auto it = m_latest.find(r.entity.index);
+            if (it != m_latest.end() && it->second == r.id)
+                m_latest.erase(it);
+        }
+    }
+
+    uint32_t delivered = 0;
+    for (const Result &r : results)
+    {
+        const Engine::ECS::EntityRecord *rec = records.find(r.entity);
+        Engine::ECS::ArchetypeStore *store = rec ? stores.get(rec->archetypeId) : nullptr;
+        if (!store || !store->hasColumn<PathFollow>())
+            continue;
+        PathFollow &follow = store->column<PathFollow>()[rec->row];
+        if (follow.requestId != r.id)
+            continue; // the unit was ordered again since
+        follow = r.path;
+        ++delivered;
+    }
+    return delivered;
+}
+
+size_t PathService::pendingCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_requests.size();
+}
@@ -0,0 +1,139 @@
+#pragma once
+/*
+  PathService.h
+  -------------
+  Purpose:
+    - Asynchronous path requests for individual units: requests queue up, background jobs on the
+      engine JobSystem answer them with HierarchicalPathfinder (HPA*) under a per-tick time budget,
+      and the simulation thread copies finished paths into each unit's PathFollow component.
+    - The simulation thread never waits on a search: requesting and delivering are O(1) per path.
+
+  Usage:
+    - service.setGrid(&navGrid);
+    - id = service.request(entity, pos.x, pos.z, target.x, target.z); // any thread
+    - per tick, before systems run: service.beginFrame(); service.deliver(ecs.entities, ecs.stores);
+    - SteeringSystem follows PathFollow waypoints while state == Following.
+
+  Notes:
+    - Jobs search a private copy of the grid; beginFrame() takes a new copy when the grid's
+      version changes and the hierarchy is rebuilt in a job before newer requests are answered.
+    - Up to setWorkerCount() jobs drain the queue at once; each returns when the queue is empty or
+      the budget is spent, and request() / beginFrame() start new ones.
+    - Only the newest request per entity is searched or delivered; results are matched to
+      PathFollow::requestId, so a later order silently supersedes an in-flight one.
+    - Sync mode (setAsync(false)) answers inside request(), which keeps lockstep runs deterministic.
+*/
+
+#include "ECS/ArchetypeStore.h"
+#include "ECS/Entity.h"
+#include "Engine/JobSystem.h"
+#include "nav/HierarchicalPathfinder.h"
+#include "nav/NavGrid.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Waypoints toward MoveTarget, stored inline so the component stays trivially copyable.
+struct PathFollow
+{
+    static constexpr uint32_t kMaxPoints = 16;
+
+    enum State : uint8_t
+    {
+        Idle = 0,  // no path: steer straight / along flow fields
+        Pending,   // waiting for the service; hold position
+        Following, // steering through x/z[next .. count)
+        Failed,    // no path exists; steer straight
+    };
+
+    float x[kMaxPoints] = {};
+    float z[kMaxPoints] = {};
+    uint32_t requestId = 0;
+    uint8_t count = 0;
+    uint8_t next = 0;
+    uint8_t state = Idle;
+    uint8_t partial = 0; // longer path truncated to kMaxPoints: request again at the last point
+};
+
+class PathService
+{
+public:
+    PathService() = default;
+    ~PathService();
+
+    PathService(const PathService &) = delete;
+    PathService &operator=(const PathService &) = delete;
+
+    // The grid must outlive the service; edit it only between simulation ticks.
+    void setGrid(const NavGrid *grid);
+    const NavGrid *grid() const { return m_grid; }
+
+    // Searches running at once (default 1).
+    void setWorkerCount(uint32_t workers) { m_workerCount = workers > 0 ? workers : 1; }
+    void setClusterCells(int cells) { m_clusterCells = cells; }
+    void setAsync(bool async) { m_async = async; }
+
+    // Search time granted per beginFrame(), summed over all jobs (default 2 ms).
+    void setFrameBudgetMs(float ms) { m_budgetNs = static_cast<int64_t>(ms * 1.0e6f); }
+
+    // Queue a path from (startX, startZ) to (goalX, goalZ); returns the id to store in PathFollow.
+    uint32_t request(Engine::ECS::Entity entity, float startX, float startZ, float goalX, float goalZ);
+
+    // Simulation thread, once per tick: refill the time budget and pick up grid edits.
+    void beginFrame();
+
+    // Simulation thread, outside system updates: copy finished paths into matching PathFollow rows.
+    // Returns the number of paths delivered.
+    uint32_t deliver(const Engine::ECS::EntitiesRecord &records, Engine::ECS::ArchetypeStoreManager &stores);
+
+    size_t pendingCount() const;
+
+private:
+    struct Request
+    {
+        Engine::ECS::Entity entity;
+        uint32_t id = 0;
+        float startX = 0.0f, startZ = 0.0f, goalX = 0.0f, goalZ = 0.0f;
+    };
+
+    struct Result
+    {
+        Engine::ECS::Entity entity;
+        uint32_t id = 0;
+        bool found = false;
+        PathFollow path;
+    };
+
+    bool hasWorkLocked() const; // m_mutex held
+    void kickLocked();          // m_mutex held: start drain jobs up to m_workerCount
+    void drain();
+    Result solve(const HierarchicalPathfinder &hpa, const Request &req) const;
+    bool isLatest(const Request &req) const; // m_mutex held
+
+    const NavGrid *m_grid = nullptr;
+    uint32_t m_workerCount = 1;
+    int m_clusterCells = 16;
+    bool m_async = true;
+    int64_t m_budgetNs = 2000000;
+
+    mutable std::mutex m_mutex;
+    std::deque<Request> m_requests;
+    std::vector<Result> m_results;
+    std::unordered_map<uint32_t, uint32_t> m_latest; // entity index -> newest request id
+    uint32_t m_nextId = 0;
+
+    std::shared_ptr<const HierarchicalPathfinder> m_hpa;
+    std::shared_ptr<const NavGrid> m_pendingGrid; // copy waiting for a hierarchy rebuild
+    uint32_t m_gridVersion = 0;                   // version of the last copy taken
+    bool m_building = false;
+
+    std::atomic<int64_t> m_budgetLeft{0};
+    uint32_t m_draining = 0; // drain jobs running or queued
+    bool m_quit = false;
+    Engine::JobCounter m_jobs;
+};
@@ -0,0 +1,199 @@
+// StratosphereServer: dedicated simulation process without a window or graphics device.
+//
+// Loads the prefabs (model node/animation tables through HeadlessAssetManager, no GPU uploads),
+// spawns a Scinerio.json-style scenario and runs Sample::SystemRunner::FixedUpdate on
+// Engine::HeadlessApplication's real-time tick loop until interrupted. Links EngineCore only, so it
+// builds with -DENGINE_HEADLESS=ON on machines without the Vulkan SDK.
+//
+//   StratosphereServer [--scenario Scinerio.json] [--entities entities] [--units N] [--rate 30]
+//                      [--ticks N] [--target x,z] [--deterministic] [--status seconds]
+//
+// --ticks stops after N ticks (default: run until SIGINT/SIGTERM). --status prints tick timings,
+// entity count and memory every 'seconds' of simulated time (0 = never).
+
+#include "update.h"
+#include "ScenarioSpawner.h"
+
+#include "ECS/ECSContext.h"
+#include "ECS/Prefab.h"
+#include "Engine/HeadlessApplication.h"
+#include "Engine/MemoryStats.h"
+#include "assets/HeadlessAssetManager.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        std::string scenario = "Scinerio.json";
+        std::string entities = "entities";
+        uint32_t units = 0; // 0: as authored
+        float tickRate = 30.0f;
+        uint64_t ticks = 0;
+        bool orders = false;
+        float targetX = 0.0f;
+        float targetZ = 0.0f;
+        bool deterministic = false;
+        float statusSeconds = 10.0f;
+    };
+
+    bool parseArgs(int argc, char **argv, Options &o)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--scenario" && hasValue)
+                o.scenario = argv[++i];
+            else if (arg == "--entities" && hasValue)
+                o.entities = argv[++i];
+            else if (arg == "--units" && hasValue)
+                o.units = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            else if (arg == "--rate" && hasValue)
+                o.tickRate = std::strtof(argv[++i], nullptr);
+            else if (arg == "--ticks" && hasValue)
+                o.ticks = std::strtoull(argv[++i], nullptr, 10);
+            else if (arg == "--target" && hasValue)
+            {
+                if (std::sscanf(argv[++i], "%f,%f", &o.targetX, &o.targetZ) != 2)
+                    return false;
+                o.orders = true;
+            }
+            else if (arg == "--deterministic")
+                o.deterministic = true;
+            else if (arg == "--status" && hasValue)
+                o.statusSeconds = std::strtof(argv[++i], nullptr);
+            else
+                return false;
+        }
+        return o.tickRate > 0.0f;
+    }
+
+    class Server : public Engine::HeadlessApplication
+    {
+    public:
+        explicit Server(const Options &options) : m_options(options) {}
+
+        bool Setup()
+        {
+            Engine::ECS::ECSContext &ecs = GetECS();
+            Engine::HeadlessAssetManager &assets = GetAssets();
+
+            size_t prefabs = 0;
+            std::error_code ec;
+            for (const auto &entry : std::filesystem::directory_iterator(m_options.entities, ec))
+            {
+                if (!entry.is_regular_file() || entry.path().extension() != ".json")
+                    continue;
+                Engine::ECS::Prefab p = Engine::ECS::loadPrefabFile(entry.path().generic_string(), ecs.components, ecs.archetypes, &assets);
+                if (p.name.empty())
+                    continue;
+                ecs.prefabs.add(std::move(p), ecs.components);
+                ++prefabs;
+            }
+            if (prefabs == 0)
+            {
+                std::cerr << "[Server] No prefabs in " << m_options.entities << (ec ? ": " + ec.message() : std::string{}) << "\n";
+                return false;
+            }
+
+            const uint32_t spawned = Sample::SpawnFromScenarioFile(ecs, m_options.scenario, /*selectSpawned=*/m_options.orders,
+                                                                   m_options.units, &m_systems.Formations(), m_options.deterministic);
+            if (spawned == 0)
+            {
+                std::cerr << "[Server] Nothing spawned from " << m_options.scenario << "\n";
+                return false;
+            }
+
+            m_systems.SetDeterministic(m_options.deterministic);
+            m_systems.Initialize(ecs.components);
+            Sample::LoadScenarioObstacles(m_options.scenario, m_systems.Navigation());
+            if (m_options.orders)
+                m_systems.SetGlobalMoveTarget(m_options.targetX, 0.0f, m_options.targetZ);
+
+            SetTickRate(m_options.tickRate);
+            SetTickLimit(m_options.ticks);
+            std::cout << "[Server] " << prefabs << " prefabs, " << spawned << " units, " << m_options.tickRate << " Hz\n";
+            return true;
+        }
+
+        void OnFixedUpdate(Engine::TimeStep ts) override
+        {
+            m_systems.FixedUpdate(GetECS(), ts.DeltaSeconds);
+
+            const uint64_t statusTicks = static_cast<uint64_t>(m_options.statusSeconds * m_options.tickRate);
+            if (statusTicks > 0 && m_systems.SimulationTick() % statusTicks == 0)
+                printStatus();
+        }
+
+        void OnStop() override
+        {
+            printStatus();
+        }
+
+    private:
+        void printStatus()
+        {
+            const TickStats &stats = GetTickStats();
+            std::vector<Engine::MemoryStats::Counter> counters;
+            std::vector<Engine::MemoryStats::SubsystemTotal> totals;
+            Engine::MemoryStats::collect(counters, totals);
+            uint64_t cpuBytes = 0;
+            for (const Engine::MemoryStats::SubsystemTotal &t : totals)
+                cpuBytes += t.cpuBytes;
+
+            const auto &entities = GetECS().entities;
+            const size_t alive = entities.capacity() - entities.freeList().size();
+            std::cout << "[Server] tick " << m_systems.SimulationTick() << ": " << alive << " entities, last "
+                      << stats.lastTickMs << " ms, max " << stats.maxTickMs << " ms, " << stats.droppedTicks << " dropped, "
+                      << (cpuBytes >> 20) << " MiB";
+            if (m_options.deterministic)
+            {
+                char hash[17];
+                std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(m_systems.StateHash()));
+                std::cout << ", state " << hash;
+            }
+            std::cout << "\n";
+        }
+
+        Options m_options;
+        Sample::SystemRunner m_systems;
+    };
+
+    Server *g_server = nullptr;
+
+    void onSignal(int)
+    {
+        if (g_server)
+            g_server->Close();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseArgs(argc, argv, options))
+    {
+        std::cerr << "usage: StratosphereServer [--scenario file] [--entities dir] [--units N] [--rate hz] [--ticks N]\n"
+                     "                          [--target x,z] [--deterministic] [--status seconds]\n";
+        return 1;
+    }
+
+    Server server(options);
+    if (!server.Setup())
+        return 1;
+
+    g_server = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    server.Run();
+    g_server = nullptr;
+    return 0;
+}
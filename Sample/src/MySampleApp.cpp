@@ -8,21 +8,26 @@
 #include "ECS/Prefab.h"
 #include "ECS/PrefabSpawner.h"
 #include "ECS/ECSContext.h"
+#include "ECS/Snapshot.h"
 
 #include "ScenarioSpawner.h"
+#include "Picking.h"
 #include "assets/AssetManager.h"
+#include "assets/Preloader.h"
+#include "utils/AssetArchive.h"
 
 #include "Engine/GroundPlaneRenderPassModule.h"
 
 #include <nlohmann/json.hpp>
 #include <fstream>
 
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
-#include <limits>
 #include <sstream>
 
 #include <cmath>
+#include <cstdio>
 
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -31,7 +36,8 @@
 
 using json = nlohmann::json;
 
-MySampleApp::MySampleApp() : Engine::Application()
+// preload.json: unit models, prefabs, shaders and the scenario, read while the device is created.
+MySampleApp::MySampleApp() : Engine::Application("preload.json")
 {
     m_assets = std::make_unique<Engine::AssetManager>(
         GetVulkanContext().GetDevice(),
@@ -39,6 +45,28 @@ MySampleApp::MySampleApp() : Engine::Application()
         GetVulkanContext().GetGraphicsQueue(),
         GetVulkanContext().GetGraphicsQueueFamilyIndex());
 
+    // Prefab models stream in on the transfer queue (see AssetManager::loadModelAsync).
+    {
+        Engine::VulkanContext &vk = GetVulkanContext();
+        m_assets->setTransferQueue(vk.GetTransferQueue(), vk.GetTransferQueueFamilyIndex(),
+                                   vk.SupportsTimelineSemaphores(),
+                                   vk.TransferQueueIsShared() ? &vk.GetQueueMutex() : nullptr);
+    }
+
+    // Crowds loop a handful of clips; resampled palettes are cheaper than keyframe search per unit.
+    m_assets->setAnimationBakeRate(30.0f);
+
+    // Keep streamed unit types within most of the VRAM the driver grants us; idle ones reload on demand.
+    {
+        Engine::AssetManager::ResidencyPolicy residency;
+        residency.deviceBudgetFraction = 0.8f;
+        residency.streamedMipExtent = 128;
+        m_assets->setResidencyPolicy(residency);
+    }
+
+    // Manifest models stream from here on; the simulation waits for them (OnLoading).
+    GetPreloader().attach(*m_assets);
+
 
         m_menu.SetTextureLoader([this](const std::string& relpath) -> ImTextureID {
             if (!m_assets)
@@ -98,6 +126,14 @@ MySampleApp::MySampleApp() : Engine::Application()
     m_systems.SetAssetManager(m_assets.get());
     m_systems.SetRenderer(&GetRenderer());
     m_systems.SetCamera(&m_camera);
+    // Every pass, culler and picking reads this camera's ViewData.
+    GetRenderer().setCamera(&m_camera);
+
+    // Steering/avoidance tick at 30 Hz; rendering interpolates positions in between.
+    SetFixedTimestep(30.0f, 5);
+
+    // Simulate the next frame while the previous one is recorded and submitted.
+    SetPipelinedRendering(true);
 
     // ------------------------------------------------------------
     // Background: simple ground-plane pass using ground baseColor tex
@@ -131,7 +167,6 @@ MySampleApp::MySampleApp() : Engine::Application()
         {
             m_groundPass = std::make_shared<Engine::GroundPlaneRenderPassModule>();
             m_groundPass->setAssets(m_assets.get());
-            m_groundPass->setCamera(&m_camera);
             m_groundPass->setBaseColorTexture(m_groundTexture);
             m_groundPass->setHalfSize(350.0f);
             m_groundPass->setTileWorldSize(5.0f);
@@ -144,6 +179,8 @@ MySampleApp::MySampleApp() : Engine::Application()
 
     // Systems can be initialized after prefabs are registered.
     m_systems.Initialize(GetECS().components);
+    // Initialize() sizes the nav grid, so obstacles go in after it.
+    Sample::LoadScenarioObstacles("Scinerio.json", m_systems.Navigation());
 
     // Hook engine window events into our handler.
     SetEventCallback([this](const std::string &e)
@@ -165,6 +202,7 @@ void MySampleApp::Close()
 
     if (m_assets)
     {
+        GetPreloader().detach();
         if (m_groundTexture.isValid())
             m_assets->release(m_groundTexture);
         m_assets->garbageCollect();
@@ -233,122 +271,71 @@ void MySampleApp::OnUpdate(Engine::TimeStep ts)
     // Apply RTS state to engine camera every frame.
     ApplyRTSCamera(aspect);
 
-    m_systems.Update(GetECS(), ts.DeltaSeconds);
+    // Without fixed stepping, simulate once per frame.
+    if (ts.FixedDeltaSeconds <= 0.0f)
+        m_systems.FixedUpdate(GetECS(), ts.DeltaSeconds);
+
+    m_systems.Update(GetECS(), ts.DeltaSeconds, ts.Alpha);
 }
 
-void MySampleApp::PickAndSelectEntityAtCursor()
+void MySampleApp::OnFixedUpdate(Engine::TimeStep ts)
+{
+    m_systems.FixedUpdate(GetECS(), ts.DeltaSeconds);
+}
+
+Sample::PickView MySampleApp::CurrentPickView()
 {
-    auto &ecs = GetECS();
     auto &win = GetWindow();
+    Sample::PickView view;
+    const Engine::ViewData &camera = m_camera.GetViewData();
+    view.viewProj = camera.viewProj;
+    view.cameraPos = camera.position;
+    view.width = static_cast<float>(win.GetWidth());
+    view.height = static_cast<float>(win.GetHeight());
+    return view;
+}
 
+void MySampleApp::PickAndSelectEntityAtCursor()
+{
+    auto &win = GetWindow();
     double mx = 0.0, my = 0.0;
     win.GetCursorPosition(mx, my);
 
-    const float mouseX = static_cast<float>(mx);
-    const float mouseY = static_cast<float>(my);
-    const float width = static_cast<float>(win.GetWidth());
-    const float height = static_cast<float>(win.GetHeight());
-
-    const uint32_t selectedId = ecs.components.ensureId("Selected");
-    const uint32_t posId = ecs.components.ensureId("Position");
-    const uint32_t rmId = ecs.components.ensureId("RenderModel");
-    const uint32_t raId = ecs.components.ensureId("RenderAnimation");
-    const uint32_t disabledId = ecs.components.ensureId("Disabled");
-    const uint32_t deadId = ecs.components.ensureId("Dead");
-
-    Engine::ECS::ComponentMask required;
-    required.set(posId);
-    required.set(rmId);
-    required.set(raId);
-
-    Engine::ECS::ComponentMask excluded;
-    excluded.set(disabledId);
-    excluded.set(deadId);
-
-    // Clear existing selection first.
-    for (const auto &ptr : ecs.stores.stores())
-    {
-        if (!ptr)
-            continue;
-        auto &store = *ptr;
-        auto &masks = store.rowMasks();
-        for (auto &mask : masks)
-            mask.clear(selectedId);
-    }
+    constexpr float kPickRadiusPx = 50.0f;
+    const Engine::ECS::Entity picked = Sample::PickEntity(GetECS(), m_systems.Spatial(), CurrentPickView(),
+                                                          {static_cast<float>(mx), static_cast<float>(my)}, kPickRadiusPx);
 
-    // Project entities to screen; pick closest to cursor within a small radius.
-    const glm::mat4 view = m_camera.GetViewMatrix();
-    const glm::mat4 proj = m_camera.GetProjectionMatrix();
-    const glm::mat4 vp = proj * view;
+    m_pickScratch.clear();
+    if (picked.valid())
+        m_pickScratch.push_back(picked);
+    SelectEntities(m_pickScratch);
+}
 
-    constexpr float kPickRadiusPx = 50.0f;
-    const float bestRadius2 = kPickRadiusPx * kPickRadiusPx;
-    float bestD2 = bestRadius2;
-    float bestCamD2 = std::numeric_limits<float>::infinity();
+void MySampleApp::BoxSelectEntities(glm::vec2 from, glm::vec2 to)
+{
+    m_pickScratch.clear();
+    Sample::BoxSelectEntities(GetECS(), m_systems.Spatial(), CurrentPickView(), from, to, m_pickScratch);
+    SelectEntities(m_pickScratch);
+}
 
-    Engine::ECS::ArchetypeStore *bestStore = nullptr;
-    uint32_t bestRow = 0;
+void MySampleApp::SelectEntities(const std::vector<Engine::ECS::Entity> &picked)
+{
+    auto &ecs = GetECS();
+    ecs.selection.clear();
 
-    for (const auto &ptr : ecs.stores.stores())
+    // Apply selection and start animation.
+    for (Engine::ECS::Entity e : picked)
     {
-        if (!ptr)
+        if (!ecs.selection.add(e))
             continue;
-        auto &store = *ptr;
-        if (!store.signature().containsAll(required))
+        const Engine::ECS::EntityRecord *rec = ecs.entities.find(e);
+        Engine::ECS::ArchetypeStore *store = rec ? ecs.stores.get(rec->archetypeId) : nullptr;
+        if (!store || !store->hasRenderAnimation())
             continue;
-        if (!store.signature().containsNone(excluded))
-            continue;
-        if (!store.hasPosition() || !store.hasRenderModel() || !store.hasRenderAnimation())
-            continue;
-
-        const auto &masks = store.rowMasks();
-        const auto &positions = store.positions();
-        const uint32_t n = store.size();
-        for (uint32_t row = 0; row < n; ++row)
-        {
-            if (!masks[row].matches(required, excluded))
-                continue;
-
-            const auto &p = positions[row];
-            const glm::vec4 world(p.x, p.y, p.z, 1.0f);
-            const glm::vec4 clip = vp * world;
-            if (clip.w <= 1e-6f)
-                continue;
-
-            const glm::vec3 ndc = glm::vec3(clip) / clip.w;
-            if (ndc.x < -1.0f || ndc.x > 1.0f || ndc.y < -1.0f || ndc.y > 1.0f)
-                continue;
-
-            const float sx = (ndc.x * 0.5f + 0.5f) * width;
-            // Camera projection already flips Y for Vulkan, so NDC Y is in the same "down is +" sense as window pixels.
-            const float sy = (ndc.y * 0.5f + 0.5f) * height;
-
-            const float dx = sx - mouseX;
-            const float dy = sy - mouseY;
-            const float d2 = dx * dx + dy * dy;
-
-            const glm::vec3 camPos = m_camera.GetPosition();
-            const glm::vec3 worldPos(p.x, p.y, p.z);
-            const float camD2 = glm::dot(worldPos - camPos, worldPos - camPos);
-
-            if (d2 < bestD2 || (std::abs(d2 - bestD2) < 1e-4f && camD2 < bestCamD2))
-            {
-                bestD2 = d2;
-                bestCamD2 = camD2;
-                bestStore = &store;
-                bestRow = row;
-            }
-        }
+        auto &anim = store->renderAnimations()[rec->row];
+        anim.playing = true;
+        anim.timeSec = 0.0f;
     }
-
-    if (!bestStore)
-        return;
-
-    // Apply selection and start animation.
-    bestStore->rowMasks()[bestRow].set(selectedId);
-    auto &anim = bestStore->renderAnimations()[bestRow];
-    anim.playing = true;
-    anim.timeSec = 0.0f;
 }
 
 void MySampleApp::ApplyRTSCamera(float aspect)
@@ -380,6 +367,10 @@ void MySampleApp::ApplyRTSCamera(float aspect)
 
 void MySampleApp::OnRender()
 {
+    // The render thread is idle here, so finished uploads can be registered safely.
+    if (m_assets)
+        m_assets->updateStreaming();
+
     // Rendering handled by Renderer/Engine.
      // If ImGui frame active, draw the menu. (Application's Run begins an ImGui frame before OnRender.)
          // Apply fade-in effect to game world rendering
@@ -392,6 +383,35 @@ void MySampleApp::OnRender()
     }
     m_menu.OnImGuiFrame();
 
+    // Loading bar until the preload manifest is in.
+    const Engine::Preloader &preload = GetPreloader();
+    if (preload.loading())
+    {
+        const Engine::PreloadProgress &p = preload.progress();
+        const ImVec2 display = ImGui::GetIO().DisplaySize;
+        ImGui::SetNextWindowPos(ImVec2(display.x * 0.5f, display.y - 40.0f), ImGuiCond_Always, ImVec2(0.5f, 1.0f));
+        ImGui::SetNextWindowSize(ImVec2(360.0f, 0.0f), ImGuiCond_Always);
+        ImGui::Begin("##Loading", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoSavedSettings);
+        char label[64];
+        std::snprintf(label, sizeof(label), "Loading %u/%u", p.filesRead + p.assetsReady + p.assetsFailed, p.filesTotal + p.assetsTotal);
+        ImGui::ProgressBar(p.fraction(), ImVec2(-1.0f, 0.0f), label);
+        ImGui::End();
+    }
+
+    // Box selection outline while the right button is held.
+    if (m_isBoxSelecting)
+    {
+        const glm::vec2 size = glm::abs(m_lastMouse - m_boxStart);
+        if (size.x >= 1.0f || size.y >= 1.0f)
+        {
+            ImDrawList *draw = ImGui::GetForegroundDrawList();
+            const ImVec2 a(std::min(m_boxStart.x, m_lastMouse.x), std::min(m_boxStart.y, m_lastMouse.y));
+            const ImVec2 b(std::max(m_boxStart.x, m_lastMouse.x), std::max(m_boxStart.y, m_lastMouse.y));
+            draw->AddRectFilled(a, b, IM_COL32(80, 200, 80, 40));
+            draw->AddRect(a, b, IM_COL32(80, 220, 80, 200));
+        }
+    }
+
     // If menu produced a result, handle it
     if (m_menu.GetResult() != MenuManager::Result::None)
     {
@@ -401,6 +421,7 @@ void MySampleApp::OnRender()
         if (res == MenuManager::Result::NewGame)
         {
             std::remove(m_saveFilePath.c_str());
+            std::remove(m_worldSaveFilePath.c_str());
             m_menu.SetHasSaveFile(false);
     
             // Start fade-in effect instead of just hiding
@@ -425,31 +446,36 @@ void MySampleApp::setupECSFromPrefabs()
 {
     auto &ecs = GetECS();
 
+    // Movement and avoidance stream x/y/z separately; must be set before any store exists.
+    ecs.components.setSplitLayout<Engine::ECS::Position>();
+    ecs.components.setSplitLayout<Engine::ECS::Velocity>();
+
     // Load all prefab definitions from JSON copied next to executable.
     // (CMake copies Sample/entities/*.json -> <build>/Sample/entities/)
+    // With a mounted archive the list comes from its table of contents instead of the directory.
     size_t prefabCount = 0;
     try
     {
-        for (const auto &entry : std::filesystem::directory_iterator("entities"))
+        std::vector<std::string> paths = Engine::AssetArchive::listMounted("entities", ".json");
+        if (paths.empty())
         {
-            if (!entry.is_regular_file())
-                continue;
-            if (entry.path().extension() != ".json")
-                continue;
-            const std::string path = entry.path().generic_string();
-            const std::string jsonText = Engine::ECS::readFileText(path);
-            if (jsonText.empty())
+            for (const auto &entry : std::filesystem::directory_iterator("entities"))
             {
-                std::cerr << "[Prefab] Failed to read: " << path << "\n";
-                continue;
+                if (entry.is_regular_file() && entry.path().extension() == ".json")
+                    paths.push_back(entry.path().generic_string());
             }
-            Engine::ECS::Prefab p = Engine::ECS::loadPrefabFromJson(jsonText, ecs.components, ecs.archetypes, *m_assets);
+        }
+
+        for (const std::string &path : paths)
+        {
+            // Uses the cooked entities/<name>.sprefab when it is up to date (written on first load).
+            Engine::ECS::Prefab p = Engine::ECS::loadPrefabFile(path, ecs.components, ecs.archetypes, m_assets.get());
             if (p.name.empty())
             {
-                std::cerr << "[Prefab] Missing name in: " << path << "\n";
+                std::cerr << "[Prefab] Failed to load (unreadable or missing name): " << path << "\n";
                 continue;
             }
-            ecs.prefabs.add(p);
+            ecs.prefabs.add(p, ecs.components);
             ++prefabCount;
             std::cout << "[Prefab] Loaded " << p.name << " from " << path << "\n";
         }
@@ -466,7 +492,7 @@ void MySampleApp::setupECSFromPrefabs()
         return;
     }
 
-    Sample::SpawnFromScenarioFile(ecs, "Scinerio.json", /*selectSpawned=*/true);
+    Sample::SpawnFromScenarioFile(ecs, "Scinerio.json", /*selectSpawned=*/true, /*totalUnits=*/0, &m_systems.Formations());
 }
 
 void MySampleApp::OnEvent(const std::string &name)
@@ -495,7 +521,30 @@ void MySampleApp::OnEvent(const std::string &name)
 
     if (evt == "MouseButtonRightDown")
     {
-        PickAndSelectEntityAtCursor();
+        double mx = 0.0, my = 0.0;
+        GetWindow().GetCursorPosition(mx, my);
+        m_isBoxSelecting = true;
+        m_boxStart = {static_cast<float>(mx), static_cast<float>(my)};
+        return;
+    }
+
+    if (evt == "MouseButtonRightUp")
+    {
+        if (!m_isBoxSelecting)
+            return;
+        m_isBoxSelecting = false;
+
+        double mx = 0.0, my = 0.0;
+        GetWindow().GetCursorPosition(mx, my);
+        const glm::vec2 end{static_cast<float>(mx), static_cast<float>(my)};
+
+        // A short drag is still a click.
+        constexpr float kBoxMinPx = 6.0f;
+        const glm::vec2 size = glm::abs(end - m_boxStart);
+        if (size.x < kBoxMinPx && size.y < kBoxMinPx)
+            PickAndSelectEntityAtCursor();
+        else
+            BoxSelectEntities(m_boxStart, end);
         return;
     }
 
@@ -510,6 +559,7 @@ void MySampleApp::OnEvent(const std::string &name)
 
     if (name == "EscapePressed")
     {
+        SaveGameState();
         Close();
         return;
     }
@@ -542,6 +592,10 @@ void MySampleApp::SaveGameState()
     std::ofstream o(m_saveFilePath);
     if (o.good())
         o << j.dump(4);
+
+    std::string error;
+    if (!Engine::ECS::saveSnapshot(GetECS(), m_worldSaveFilePath, error))
+        std::cerr << "[Save] " << error << "\n";
 }
 
 void MySampleApp::LoadGameState()
@@ -558,6 +612,16 @@ void MySampleApp::LoadGameState()
     m_rtsCam.pitchDeg = j.value("pitchDeg", m_rtsCam.pitchDeg);
     m_rtsCam.height = j.value("height", m_rtsCam.height);
 
+    // Units, selection and orders; systems drop state that referred to the replaced world.
+    std::string error;
+    if (std::filesystem::exists(m_worldSaveFilePath))
+    {
+        if (Engine::ECS::loadSnapshot(GetECS(), m_worldSaveFilePath, error))
+            m_systems.OnWorldReplaced(GetECS());
+        else
+            std::cerr << "[Save] " << error << "\n";
+    }
+
     // Re-apply camera projection with current window aspect
     auto &win = GetWindow();
     const float aspect = static_cast<float>(win.GetWidth()) / static_cast<float>(win.GetHeight());
@@ -0,0 +1,225 @@
+#include "Picking.h"
+
+#include "ECS/ECSContext.h"
+#include "Engine/Frustum.h"
+#include "systems/SpatialIndexSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace Sample
+{
+    namespace
+    {
+        // Unit positions sit on or near the ground; cell boxes span this height range (meters).
+        constexpr float kCellMinY = -2.0f;
+        constexpr float kCellMaxY = 4.0f;
+
+        // Which stores hold pickable units; resolved once per query, per store.
+        class PickableStores
+        {
+        public:
+            explicit PickableStores(Engine::ECS::ECSContext &ecs) : m_ecs(ecs)
+            {
+                m_required.set(ecs.components.ensureId("Position"));
+                m_required.set(ecs.components.ensureId("RenderModel"));
+                m_required.set(ecs.components.ensureId("RenderAnimation"));
+                m_excluded.set(ecs.components.ensureId("Disabled"));
+                m_excluded.set(ecs.components.ensureId("Dead"));
+                m_state.assign(ecs.stores.stores().size(), kUnknown);
+            }
+
+            // Store of a grid entry if its row is still a pickable unit.
+            Engine::ECS::ArchetypeStore *resolve(const GridEntry &e)
+            {
+                if (e.storeId >= m_state.size() || m_state[e.storeId] == kNo)
+                    return nullptr;
+                Engine::ECS::ArchetypeStore *store = m_ecs.stores.get(e.storeId);
+                if (m_state[e.storeId] == kUnknown)
+                {
+                    const bool ok = store && store->hasPosition() && store->hasRenderModel() && store->hasRenderAnimation() &&
+                                    store->signature().containsAll(m_required) && store->signature().containsNone(m_excluded);
+                    m_state[e.storeId] = ok ? kYes : kNo;
+                    if (!ok)
+                        return nullptr;
+                }
+                // The grid is from the last tick; playback may have shrunk the store since.
+                if (e.row >= store->size())
+                    return nullptr;
+                if (!store->rowTags().containsNone(m_excluded) && !store->rowMasks()[e.row].matches(m_required, m_excluded))
+                    return nullptr;
+                return store;
+            }
+
+        private:
+            enum : uint8_t
+            {
+                kUnknown,
+                kYes,
+                kNo
+            };
+
+            Engine::ECS::ECSContext &m_ecs;
+            Engine::ECS::ComponentMask m_required;
+            Engine::ECS::ComponentMask m_excluded;
+            std::vector<uint8_t> m_state;
+        };
+
+        glm::vec2 toNdc(const PickView &view, glm::vec2 pixel)
+        {
+            // Camera projection already flips Y for Vulkan, so NDC Y grows downwards like window pixels.
+            return {pixel.x / view.width * 2.0f - 1.0f, pixel.y / view.height * 2.0f - 1.0f};
+        }
+    } // namespace
+
+    void ScreenRay(const PickView &view, glm::vec2 pixel, glm::vec3 &origin, glm::vec3 &dir)
+    {
+        const glm::vec2 ndc = toNdc(view, pixel);
+        const glm::mat4 inv = glm::inverse(view.viewProj);
+        const glm::vec4 nearH = inv * glm::vec4(ndc.x, ndc.y, 0.0f, 1.0f); // Vulkan depth 0..1
+        const glm::vec4 farH = inv * glm::vec4(ndc.x, ndc.y, 1.0f, 1.0f);
+        origin = glm::vec3(nearH) / nearH.w;
+        dir = glm::vec3(farH) / farH.w - origin;
+    }
+
+    bool ScreenToGround(const PickView &view, glm::vec2 pixel, float groundY, glm::vec3 &hit)
+    {
+        glm::vec3 origin, dir;
+        ScreenRay(view, pixel, origin, dir);
+        if (std::abs(dir.y) < 1e-6f)
+            return false;
+        const float t = (groundY - origin.y) / dir.y;
+        if (t < 0.0f || t > 1.0f)
+            return false;
+        hit = origin + dir * t;
+        return true;
+    }
+
+    Engine::ECS::Entity PickEntity(Engine::ECS::ECSContext &ecs, const SpatialIndexSystem &spatial,
+                                   const PickView &view, glm::vec2 cursor, float radiusPx)
+    {
+        glm::vec3 center;
+        if (!ScreenToGround(view, cursor, 0.0f, center))
+            return {};
+
+        // World radius covered by radiusPx around the cursor (perspective stretches it unevenly).
+        float radiusM = spatial.getCellSize();
+        const glm::vec2 offsets[] = {{radiusPx, 0.0f}, {-radiusPx, 0.0f}, {0.0f, radiusPx}, {0.0f, -radiusPx}};
+        for (const glm::vec2 &o : offsets)
+        {
+            glm::vec3 edge;
+            if (ScreenToGround(view, cursor + o, 0.0f, edge))
+                radiusM = std::max(radiusM, glm::length(glm::vec2(edge.x - center.x, edge.z - center.z)));
+        }
+        // Units stand above their ground point: pad by a cell so tall or raised ones stay candidates.
+        radiusM += spatial.getCellSize();
+
+        PickableStores pickable(ecs);
+        const float radius2 = radiusPx * radiusPx;
+        float bestD2 = radius2;
+        float bestCamD2 = std::numeric_limits<float>::infinity();
+        Engine::ECS::Entity best;
+
+        spatial.forCellsInRect(center.x - radiusM, center.z - radiusM, center.x + radiusM, center.z + radiusM,
+                               [&](float, float, float, float, const GridEntry *begin, const GridEntry *end)
+                               {
+                                   for (const GridEntry *e = begin; e != end; ++e)
+                                   {
+                                       Engine::ECS::ArchetypeStore *store = pickable.resolve(*e);
+                                       if (!store)
+                                           continue;
+
+                                       const auto &p = std::as_const(*store).positions()[e->row];
+                                       const glm::vec4 clip = view.viewProj * glm::vec4(p.x, p.y, p.z, 1.0f);
+                                       if (clip.w <= 1e-6f)
+                                           continue;
+                                       const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+                                       if (ndc.x < -1.0f || ndc.x > 1.0f || ndc.y < -1.0f || ndc.y > 1.0f)
+                                           continue;
+
+                                       const float dx = (ndc.x * 0.5f + 0.5f) * view.width - cursor.x;
+                                       const float dy = (ndc.y * 0.5f + 0.5f) * view.height - cursor.y;
+                                       const float d2 = dx * dx + dy * dy;
+                                       const glm::vec3 toCam = glm::vec3(p.x, p.y, p.z) - view.cameraPos;
+                                       const float camD2 = glm::dot(toCam, toCam);
+
+                                       if (d2 < bestD2 || (std::abs(d2 - bestD2) < 1e-4f && camD2 < bestCamD2))
+                                       {
+                                           bestD2 = d2;
+                                           bestCamD2 = camD2;
+                                           best = store->entities()[e->row];
+                                       }
+                                   }
+                               });
+        return best;
+    }
+
+    void BoxSelectEntities(Engine::ECS::ECSContext &ecs, const SpatialIndexSystem &spatial,
+                           const PickView &view, glm::vec2 a, glm::vec2 b,
+                           std::vector<Engine::ECS::Entity> &out)
+    {
+        const glm::vec2 lo = glm::max(glm::min(a, b), glm::vec2(0.0f));
+        const glm::vec2 hi = glm::min(glm::max(a, b), glm::vec2(view.width, view.height));
+        if (hi.x - lo.x < 1.0f || hi.y - lo.y < 1.0f)
+            return;
+
+        // Sub-frustum of the rectangle: remap its NDC range to [-1, 1] before extracting planes.
+        const glm::vec2 n0 = toNdc(view, lo);
+        const glm::vec2 n1 = toNdc(view, hi);
+        glm::mat4 remap(1.0f);
+        remap[0][0] = 2.0f / (n1.x - n0.x);
+        remap[3][0] = -(n1.x + n0.x) / (n1.x - n0.x);
+        remap[1][1] = 2.0f / (n1.y - n0.y);
+        remap[3][1] = -(n1.y + n0.y) / (n1.y - n0.y);
+        const Engine::Frustum frustum = Engine::Frustum::fromViewProj(remap * view.viewProj);
+
+        // Ground footprint: corner rays meet the ground, or (looking past the horizon) the far plane bounds it.
+        glm::vec2 rectMin(std::numeric_limits<float>::max());
+        glm::vec2 rectMax(std::numeric_limits<float>::lowest());
+        const glm::vec2 corners[] = {lo, {hi.x, lo.y}, hi, {lo.x, hi.y}};
+        bool missed = false;
+        for (const glm::vec2 &c : corners)
+        {
+            glm::vec3 hit;
+            if (!ScreenToGround(view, c, 0.0f, hit))
+            {
+                missed = true;
+                continue;
+            }
+            rectMin = glm::min(rectMin, glm::vec2(hit.x, hit.z));
+            rectMax = glm::max(rectMax, glm::vec2(hit.x, hit.z));
+        }
+        if (missed)
+        {
+            for (const glm::vec2 &c : corners)
+            {
+                glm::vec3 origin, dir;
+                ScreenRay(view, c, origin, dir);
+                const glm::vec3 farPoint = origin + dir;
+                rectMin = glm::min(rectMin, glm::vec2(farPoint.x, farPoint.z));
+                rectMax = glm::max(rectMax, glm::vec2(farPoint.x, farPoint.z));
+            }
+        }
+        const float pad = spatial.getCellSize();
+
+        PickableStores pickable(ecs);
+        spatial.forCellsInRect(rectMin.x - pad, rectMin.y - pad, rectMax.x + pad, rectMax.y + pad,
+                               [&](float minX, float minZ, float maxX, float maxZ, const GridEntry *begin, const GridEntry *end)
+                               {
+                                   if (!frustum.intersectsAabb(glm::vec3(minX, kCellMinY, minZ), glm::vec3(maxX, kCellMaxY, maxZ)))
+                                       return;
+                                   for (const GridEntry *e = begin; e != end; ++e)
+                                   {
+                                       Engine::ECS::ArchetypeStore *store = pickable.resolve(*e);
+                                       if (!store)
+                                           continue;
+                                       const auto &p = std::as_const(*store).positions()[e->row];
+                                       if (frustum.intersectsSphere(glm::vec3(p.x, p.y, p.z), 0.0f))
+                                           out.push_back(store->entities()[e->row]);
+                                   }
+                               });
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ECS/Entity.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace Engine::ECS
+{
+    struct ECSContext;
+}
+
+class SpatialIndexSystem;
+
+namespace Sample
+{
+    // Camera state for screen-space picking (window pixels, origin top-left).
+    struct PickView
+    {
+        glm::mat4 viewProj{1.0f};
+        glm::vec3 cameraPos{0.0f};
+        float width = 1.0f;
+        float height = 1.0f;
+    };
+
+    // World-space ray under a window pixel (origin on the near plane, dir reaches the far plane).
+    void ScreenRay(const PickView &view, glm::vec2 pixel, glm::vec3 &origin, glm::vec3 &dir);
+
+    // Where the ray under 'pixel' meets the ground plane y = groundY within the far plane.
+    bool ScreenToGround(const PickView &view, glm::vec2 pixel, float groundY, glm::vec3 &hit);
+
+    // Pickable unit (Position + RenderModel + RenderAnimation, not Disabled/Dead) whose position
+    // projects closest to 'cursor' within 'radiusPx'; ties go to the unit nearer the camera.
+    // Only the grid cells around the cursor's ground point are searched. Invalid if none.
+    Engine::ECS::Entity PickEntity(Engine::ECS::ECSContext &ecs, const SpatialIndexSystem &spatial,
+                                   const PickView &view, glm::vec2 cursor, float radiusPx);
+
+    // Pickable units whose position projects inside the screen rectangle a..b, appended to 'out'.
+    // The rectangle's sub-frustum culls grid cells before any entity is tested.
+    void BoxSelectEntities(Engine::ECS::ECSContext &ecs, const SpatialIndexSystem &spatial,
+                           const PickView &view, glm::vec2 a, glm::vec2 b,
+                           std::vector<Engine::ECS::Entity> &out);
+}
@@ -5,13 +5,18 @@
 #include "ECS/ECSContext.h"
 #include "ECS/Prefab.h"
 #include "ECS/PrefabSpawner.h"
+#include "Engine/Random.h"
+#include "nav/NavGrid.h"
+#include "systems/FormationSystem.h"
+#include "systems/SpatialIndexSystem.h"
 
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
-#include <random>
 #include <unordered_map>
+#include <vector>
 
 namespace
 {
@@ -20,15 +25,10 @@ namespace
         const uint32_t radId = registry.ensureId("Radius");
         const uint32_t sepId = registry.ensureId("Separation");
 
-        float r = 0.0f;
-        float s = 0.0f;
-        if (auto it = prefab.defaults.find(radId);
-            it != prefab.defaults.end() && std::holds_alternative<Engine::ECS::Radius>(it->second))
-            r = std::get<Engine::ECS::Radius>(it->second).r;
-
-        if (auto it = prefab.defaults.find(sepId);
-            it != prefab.defaults.end() && std::holds_alternative<Engine::ECS::Separation>(it->second))
-            s = std::get<Engine::ECS::Separation>(it->second).value;
+        Engine::ECS::Radius radius{};
+        Engine::ECS::Separation separation{};
+        const float r = prefab.defaults.get(radId, radius) ? radius.r : 0.0f;
+        const float s = prefab.defaults.get(sepId, separation) ? separation.value : 0.0f;
 
         // For same-type units, desired center-to-center distance is:
         // (r1+r2) + (sep1+sep2) = 2r + 2sep.
@@ -60,6 +60,7 @@ namespace
         SpawnGroupResolved sg;
         sg.id = g.value("id", std::string("(no-id)"));
         sg.unitType = g.value("unitType", std::string(""));
+        sg.team = g.value("team", std::string(""));
         sg.count = g.value("count", 0);
 
         const std::string anchorName = g.value("anchor", std::string(""));
@@ -105,11 +106,40 @@ namespace
         return sg;
     }
 
-    std::pair<float, float> computeFormationOffset(const SpawnGroupResolved &sg, int i, float spacingM)
+    // cos/sin of 'turns' full turns from +, * and / only (no libm), so every platform gets the
+    // same bits under the engine's strict float flags. Reduced by quarter turns to |x| <= pi/4,
+    // where the Taylor terms below leave an error under 1e-9.
+    std::pair<float, float> deterministicCosSin(double turns)
+    {
+        const double quarter = std::floor(turns * 4.0 + 0.5);
+        const double x = (turns - quarter * 0.25) * 6.283185307179586;
+        const double x2 = x * x;
+        const double s = x * (1.0 - x2 / 6.0 * (1.0 - x2 / 20.0 * (1.0 - x2 / 42.0 * (1.0 - x2 / 72.0))));
+        const double c = 1.0 - x2 / 2.0 * (1.0 - x2 / 12.0 * (1.0 - x2 / 30.0 * (1.0 - x2 / 56.0 * (1.0 - x2 / 90.0))));
+        switch (static_cast<int64_t>(quarter) & 3)
+        {
+        case 0:
+            return {static_cast<float>(c), static_cast<float>(s)};
+        case 1:
+            return {static_cast<float>(-s), static_cast<float>(c)};
+        case 2:
+            return {static_cast<float>(-c), static_cast<float>(-s)};
+        default:
+            return {static_cast<float>(s), static_cast<float>(-c)};
+        }
+    }
+
+    std::pair<float, float> computeFormationOffset(const SpawnGroupResolved &sg, int i, float spacingM, bool deterministic)
     {
         const bool isCircle = (sg.formationKind == "circle");
         if (isCircle)
         {
+            if (deterministic)
+            {
+                const double turns = (sg.count > 0) ? static_cast<double>(i) / static_cast<double>(sg.count) : 0.0;
+                const auto [c, s] = deterministicCosSin(turns);
+                return {c * sg.circleRadiusM, s * sg.circleRadiusM};
+            }
             const float angle = (sg.count > 0)
                                     ? (static_cast<float>(i) * 6.28318530718f / static_cast<float>(sg.count))
                                     : 0.0f;
@@ -134,7 +164,8 @@ namespace
 
 namespace Sample
 {
-    uint32_t SpawnFromScenarioFile(Engine::ECS::ECSContext &ecs, const std::string &scenarioPath, bool selectSpawned)
+    uint32_t SpawnFromScenarioFile(Engine::ECS::ECSContext &ecs, const std::string &scenarioPath, bool selectSpawned,
+                                   uint32_t totalUnits, FormationGroups *formations, bool deterministic)
     {
         const std::string text = Engine::ECS::readFileText(scenarioPath);
         if (text.empty())
@@ -157,6 +188,9 @@ namespace Sample
         const std::string scenarioName = j.value("name", std::string("(unnamed)"));
         std::cout << "[Scenario] Loading: " << scenarioName << "\n";
 
+        // Jitter comes from Engine::Random, so lockstep peers loading the same file spawn the same world.
+        const uint64_t seed = j.value("seed", uint64_t{0});
+
         if (!j.contains("spawnGroups") || !j["spawnGroups"].is_array())
         {
             std::cerr << "[Scenario] Missing spawnGroups[]\n";
@@ -164,13 +198,59 @@ namespace Sample
         }
 
         const auto anchors = parseAnchors(j);
-        const uint32_t selectedId = ecs.components.ensureId("Selected");
 
-        uint32_t totalSpawned = 0;
+        std::vector<SpawnGroupResolved> groups;
+        int scenarioUnits = 0;
         for (const auto &g : j["spawnGroups"])
         {
-            const SpawnGroupResolved sg = parseSpawnGroup(g, anchors);
+            groups.push_back(parseSpawnGroup(g, anchors));
+            scenarioUnits += std::max(0, groups.back().count);
+        }
+
+        if (totalUnits > 0 && scenarioUnits > 0)
+        {
+            // Largest remainder keeps the total exact; columns grow with sqrt so blocks stay blocks.
+            const double scale = static_cast<double>(totalUnits) / static_cast<double>(scenarioUnits);
+            std::vector<std::pair<double, size_t>> remainders;
+            int assigned = 0;
+            for (size_t i = 0; i < groups.size(); ++i)
+            {
+                SpawnGroupResolved &sg = groups[i];
+                if (sg.count <= 0)
+                    continue;
+                const double exact = sg.count * scale;
+                sg.count = static_cast<int>(std::floor(exact));
+                assigned += sg.count;
+                remainders.emplace_back(exact - sg.count, i);
+                if (sg.columns > 0)
+                    sg.columns = std::max(1, static_cast<int>(std::lround(sg.columns * std::sqrt(scale))));
+                sg.circleRadiusM *= static_cast<float>(std::sqrt(scale));
+            }
+            std::stable_sort(remainders.begin(), remainders.end(), [](const auto &a, const auto &b)
+                             { return a.first > b.first; });
+            for (size_t k = 0; assigned < static_cast<int>(totalUnits) && k < remainders.size(); ++k, ++assigned)
+                groups[remainders[k].second].count++;
+        }
+
+        // Same registration as SystemRunner::Initialize, which may run after spawning.
+        if (formations)
+            ecs.components.registerType<FormationMember>("FormationMember");
+        ecs.components.registerType<Team>("Team");
+        std::vector<Engine::ECS::Entity> spawnedEntities;
+
+        // Team ids in order of first appearance, so every peer assigns the same ids.
+        std::vector<std::string> teamNames;
+        auto teamId = [&](const std::string &name)
+        {
+            auto it = std::find(teamNames.begin(), teamNames.end(), name);
+            if (it == teamNames.end())
+                it = teamNames.insert(teamNames.end(), name);
+            return static_cast<uint8_t>(it - teamNames.begin());
+        };
 
+        uint32_t totalSpawned = 0;
+        for (const SpawnGroupResolved &sg : groups)
+        {
             if (sg.unitType.empty() || sg.count <= 0)
             {
                 std::cerr << "[Scenario] Skipping group id=" << sg.id << " (missing unitType or count)\n";
@@ -186,8 +266,7 @@ namespace Sample
 
             const float spacingM = sg.spacingAuto ? prefabAutoSpacingMeters(*prefab, ecs.components) : sg.spacingM;
 
-            std::mt19937 rng(static_cast<uint32_t>(std::hash<std::string>{}(sg.id)));
-            std::uniform_real_distribution<float> jitter(-sg.jitterM, sg.jitterM);
+            Engine::Random rng(Engine::Random::hashString(sg.id) ^ seed);
 
             std::cout << "[Scenario] Spawn group id=" << sg.id
                       << " unitType=" << sg.unitType
@@ -197,38 +276,118 @@ namespace Sample
                       << " spacingM=" << spacingM
                       << " jitterM=" << sg.jitterM << "\n";
 
+            std::vector<Engine::ECS::Position> positions(static_cast<size_t>(sg.count));
+            std::vector<FormationMember> slots(formations ? static_cast<size_t>(sg.count) : 0);
+            const uint32_t group = formations ? formations->create(sg.originX, sg.originZ) : FormationMember::kNoGroup;
             for (int i = 0; i < sg.count; ++i)
             {
                 float x = sg.originX;
                 float z = sg.originZ;
 
-                const auto [ox, oz] = computeFormationOffset(sg, i, spacingM);
+                const auto [ox, oz] = computeFormationOffset(sg, i, spacingM, deterministic);
                 x += ox;
                 z += oz;
 
-                x += jitter(rng);
-                z += jitter(rng);
+                x += rng.uniform(-sg.jitterM, sg.jitterM);
+                z += rng.uniform(-sg.jitterM, sg.jitterM);
 
-                Engine::ECS::SpawnResult res = Engine::ECS::spawnFromPrefab(*prefab, ecs.components, ecs.archetypes, ecs.stores, ecs.entities);
-                Engine::ECS::ArchetypeStore *store = ecs.stores.get(res.archetypeId);
-                if (!store || !store->hasPosition())
-                    continue;
+                positions[static_cast<size_t>(i)] = Engine::ECS::Position{x, 0.0f, z};
+                if (formations)
+                    slots[static_cast<size_t>(i)] = FormationMember{group, x - sg.originX, z - sg.originZ, 0};
+            }
 
-                auto &p = store->positions()[res.row];
-                p.x = x;
-                p.y = 0.0f;
-                p.z = z;
+            const Engine::ECS::SpawnBatchResult res = Engine::ECS::spawnBatchFromPrefab(
+                *prefab, static_cast<uint32_t>(sg.count), positions.data(),
+                ecs.components, ecs.archetypes, ecs.stores, ecs.entities);
+            Engine::ECS::ArchetypeStore *store = ecs.stores.get(res.archetypeId);
+            if (!store || !store->hasPosition())
+                continue;
+
+            if (selectSpawned)
+            {
+                const auto &ents = store->entities();
+                for (uint32_t r = res.firstRow; r < res.firstRow + res.count; ++r)
+                    ecs.selection.add(ents[r]);
+            }
 
-                if (selectSpawned)
+            // Copy the handles first: adding components moves rows out of this store.
+            const auto &ents = store->entities();
+            spawnedEntities.assign(ents.begin() + res.firstRow, ents.begin() + res.firstRow + res.count);
+
+            if (formations)
+            {
+                // The spawn layout becomes the group's slots (jitter included, so nobody moves at start).
+                for (uint32_t k = 0; k < res.count; ++k)
                 {
-                    store->rowMasks()[res.row].set(selectedId);
+                    if (ecs.addComponent(spawnedEntities[k], slots[k]))
+                        formations->assign(group);
                 }
+            }
 
-                ++totalSpawned;
+            if (!sg.team.empty())
+            {
+                const Team team{teamId(sg.team)};
+                for (const Engine::ECS::Entity e : spawnedEntities)
+                    ecs.addComponent(e, team);
             }
+
+            totalSpawned += res.count;
         }
 
         std::cout << "[Scenario] Total units spawned: " << totalSpawned << "\n";
         return totalSpawned;
     }
+
+    uint32_t LoadScenarioObstacles(const std::string &scenarioPath, NavGrid &grid)
+    {
+        const std::string text = Engine::ECS::readFileText(scenarioPath);
+        if (text.empty() || !grid.valid())
+            return 0;
+
+        nlohmann::json j;
+        try
+        {
+            j = nlohmann::json::parse(text);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[Scenario] JSON parse error: " << e.what() << "\n";
+            return 0;
+        }
+        if (!j.contains("obstacles") || !j["obstacles"].is_array())
+            return 0;
+
+        const auto anchors = parseAnchors(j);
+        uint32_t applied = 0;
+        for (const auto &o : j["obstacles"])
+        {
+            const std::string anchorName = o.value("anchor", std::string(""));
+            const auto anchorIt = anchors.find(anchorName);
+            const float x = o.value("x", 0.0f) + (anchorIt != anchors.end() ? anchorIt->second.first : 0.0f);
+            const float z = o.value("z", 0.0f) + (anchorIt != anchors.end() ? anchorIt->second.second : 0.0f);
+
+            const std::string kind = o.value("kind", std::string("rect"));
+            if (kind == "circle")
+            {
+                grid.blockCircle(x, z, o.value("radius_m", 0.0f));
+            }
+            else if (kind == "rect")
+            {
+                // cost 255 (default) blocks; lower values only slow paths down.
+                const float hx = o.value("halfX_m", 0.0f);
+                const float hz = o.value("halfZ_m", 0.0f);
+                const int cost = std::clamp(o.value("cost", static_cast<int>(NavGrid::kBlocked)), 1, 255);
+                grid.setCostRect(x - hx, z - hz, x + hx, z + hz, static_cast<uint8_t>(cost));
+            }
+            else
+            {
+                std::cerr << "[Scenario] Unknown obstacle kind '" << kind << "'\n";
+                continue;
+            }
+            ++applied;
+        }
+
+        std::cout << "[Scenario] Obstacles applied: " << applied << "\n";
+        return applied;
+    }
 }
@@ -1,9 +1,22 @@
+#include <filesystem>
 #include <iostream>
 
 #include "MySampleApp.h"
+#include "utils/AssetArchive.h"
 
 int main()
 {
+    // Cooked files packed by PackAssetsTool (STRATO_PACK_SAMPLE_ASSETS) shadow the loose copies.
+    // Mounted before the app exists: its preload reads start in the Application constructor.
+    if (std::filesystem::exists("assets.spak"))
+    {
+        std::string error;
+        if (Engine::AssetArchive::mount("assets.spak", error))
+            std::cout << "[Assets] Mounted assets.spak\n";
+        else
+            std::cerr << "[Assets] " << error << "\n";
+    }
+
     try
     {
         MySampleApp app;
@@ -1,5 +1,7 @@
 #include "update.h"
 
+#include "ECS/StateHash.h"
+
 namespace Sample
 {
     void SystemRunner::Initialize(Engine::ECS::ComponentRegistry &registry)
@@ -8,23 +10,83 @@ namespace Sample
             return;
 
         // Ensure common IDs exist up-front (also used by scenario spawner selection).
-        (void)registry.ensureId("Selected");
+        m_selectedId = registry.ensureId("Selected");
+        const uint32_t pathFollowId = registry.registerType<PathFollow>("PathFollow");
+        const uint32_t formationMemberId = registry.registerType<FormationMember>("FormationMember");
+        registry.registerType<Team>("Team");
+        const uint32_t inFormationId = registry.ensureId("InFormation");
 
         m_command.buildMasks(registry);
         m_steering.buildMasks(registry);
+        m_formation.buildMasks(registry);
         m_spatial.buildMasks(registry);
         m_avoidance.buildMasks(registry);
         m_movement.buildMasks(registry);
+#if !SAMPLE_HEADLESS
         m_characterAnim.buildMasks(registry);
         m_renderModel.buildMasks(registry);
+#endif
 
         // Neighbor radius (meters). Tune later; matches SpatialIndexSystem doc.
         m_spatial.setCellSize(m_spatial.getCellSize());
+        // Flat grid over the playable area (scenario anchors stay within about +-350 m).
+        m_spatial.setWorldBounds(-512.0f, -512.0f, 512.0f, 512.0f);
+        m_spatial.setIncremental(true);
+
+        // Flow fields over the same area: one per goal region, built off the simulation thread.
+        m_nav.configure(-512.0f, -512.0f, 512.0f, 512.0f, 2.0f);
+        m_flowFields.setGrid(&m_nav);
+        m_flowFields.setAsync(!m_deterministic);
+        m_steering.setFlowFields(&m_flowFields);
+
+        // Small groups path individually with HPA*, answered by workers under a per-tick budget.
+        m_paths.setGrid(&m_nav);
+        m_paths.setWorkerCount(2);
+        m_paths.setFrameBudgetMs(2.0f);
+        m_paths.setAsync(!m_deterministic);
+        m_command.setPathService(&m_paths, pathFollowId);
+        m_steering.setPathService(&m_paths);
+
+        // Larger groups move as formations: one anchor steered per group, members hold slots.
+        m_formation.setGroups(&m_formations);
+        m_formation.setNavigation(&m_flowFields, &m_nav);
+        m_formation.setInFormationTag(inFormationId);
+        m_command.setFormations(&m_formations, formationMemberId, inFormationId);
+
+        // Row-parallel systems split their stores into chunks on the shared pool.
+        m_steering.setWorkerPool(&m_pool);
+        m_formation.setWorkerPool(&m_pool);
+        m_movement.setWorkerPool(&m_pool);
+        m_avoidance.setWorkerPool(&m_pool); // bounded grid: snapshot-driven, deterministic
+
+#if !SAMPLE_HEADLESS
+        // Palettes from baked clips in a compute pre-pass; falls back to CPU poses per model.
+        m_renderModel.setGpuSkinning(true);
+
+        // Culling, LOD and draw commands for every unit on the GPU; the per-model path above is the fallback.
+        m_renderModel.setGpuScene(true);
+
+        // Units covering under ~1% of the view height draw as baked sprites once their atlas exists.
+        RenderSystem::ImpostorPolicy impostors;
+        impostors.enabled = true;
+        m_renderModel.setImpostors(impostors);
+#endif
+
+        // Registration order is the logical order (suggested order per LocalAvoidanceSystem.h);
+        // the scheduler only reorders systems whose access sets do not conflict.
+        // Animation and rendering are per-frame and run in Update().
+        m_scheduler.add(&m_command);
+        m_scheduler.add(&m_steering);
+        m_scheduler.add(&m_formation);
+        m_scheduler.add(&m_spatial);
+        m_scheduler.add(&m_avoidance);
+        m_scheduler.add(&m_movement);
+        m_scheduler.build();
 
         m_initialized = true;
     }
 
-    void SystemRunner::Update(Engine::ECS::ECSContext &ecs, float dtSeconds)
+    void SystemRunner::FixedUpdate(Engine::ECS::ECSContext &ecs, float dtSeconds)
     {
         if (!m_initialized)
             Initialize(ecs.components);
@@ -32,13 +94,62 @@ namespace Sample
         if (dtSeconds <= 0.0f)
             return;
 
-        // Suggested order per LocalAvoidanceSystem.h
-        m_command.update(ecs.stores, dtSeconds);
-        m_steering.update(ecs.stores, dtSeconds);
-        m_spatial.update(ecs.stores, dtSeconds);
-        m_avoidance.update(ecs.stores, dtSeconds);
-        m_movement.update(ecs.stores, dtSeconds);
-        m_characterAnim.update(ecs.stores, dtSeconds);
+        if (m_commands != &ecs.commands)
+        {
+            m_commands = &ecs.commands;
+            m_command.setCommandBuffer(m_commands);
+            m_steering.setCommandBuffer(m_commands);
+            m_formation.setCommandBuffer(m_commands);
+            m_spatial.setCommandBuffer(m_commands);
+            m_avoidance.setCommandBuffer(m_commands);
+            m_movement.setCommandBuffer(m_commands);
+#if !SAMPLE_HEADLESS
+            m_characterAnim.setCommandBuffer(m_commands);
+            m_renderModel.setCommandBuffer(m_commands);
+#endif
+            m_command.setSelection(&ecs.selection, &ecs.entities);
+        }
+
+        // Row-mask consumers (animation) see selection changes made since the last tick or frame.
+        if (ecs.selection.dirty())
+            ecs.selection.syncRowTags(ecs.entities, ecs.stores, m_selectedId);
+
+        // Paths finished since the last tick land in PathFollow before anything reads it.
+        m_paths.beginFrame();
+        m_paths.deliver(ecs.entities, ecs.stores);
+
+        // Render interpolation blends from here to the post-tick positions.
+        m_history.capture(ecs.stores);
+
+        m_scheduler.run(ecs.stores, dtSeconds);
+
+        // Sync point: structural changes recorded by systems become visible to the next tick.
+        ecs.playbackCommands();
+
+        ++m_tick;
+        if (m_deterministic)
+            m_stateHash = Engine::ECS::hashSimulationState(ecs.entities, ecs.stores);
+    }
+
+#if !SAMPLE_HEADLESS
+    void SystemRunner::Update(Engine::ECS::ECSContext &ecs, float dtSeconds, float alpha)
+    {
+        if (!m_initialized)
+            Initialize(ecs.components);
+
+        if (dtSeconds <= 0.0f)
+            return;
+
+        if (ecs.selection.dirty())
+            ecs.selection.syncRowTags(ecs.entities, ecs.stores, m_selectedId);
+
+        {
+            Engine::PerfScope scope(m_characterAnim.name());
+            m_characterAnim.update(ecs.stores, dtSeconds);
+        }
+
+        Engine::PerfScope scope(m_renderModel.name());
+        m_renderModel.setInterpolation(&m_history, alpha);
         m_renderModel.update(ecs.stores, dtSeconds);
     }
 
@@ -46,20 +157,55 @@ namespace Sample
     {
         m_characterAnim.setAssetManager(assets);
         m_renderModel.setAssetManager(assets);
+
+        // Model loads decode their textures on the simulation pool.
+        if (assets)
+            assets->setDecodeWorkerPool(&m_pool);
     }
 
     void SystemRunner::SetRenderer(Engine::Renderer *renderer)
     {
         m_renderModel.setRenderer(renderer);
+
+        // One SModel pass per unit model: record them in parallel on the simulation pool.
+        if (renderer)
+            renderer->setRecordWorkerPool(&m_pool);
     }
 
     void SystemRunner::SetCamera(Engine::Camera *camera)
     {
         m_renderModel.setCamera(camera);
     }
+#endif
 
     void SystemRunner::SetGlobalMoveTarget(float x, float y, float z)
     {
         m_command.SetGlobalMoveTarget(x, y, z);
     }
+
+    void SystemRunner::OnWorldReplaced(Engine::ECS::ECSContext &ecs)
+    {
+        // Members of unknown groups are ignored until they are ordered into a new formation.
+        m_formations.clear();
+
+        // Answers to requests made before the load would never arrive: steer without a path instead.
+        for (const auto &store : ecs.stores.stores())
+        {
+            if (!store || !store->hasColumn<PathFollow>())
+                continue;
+            for (PathFollow &follow : store->column<PathFollow>())
+            {
+                if (follow.state == PathFollow::Pending)
+                    follow = PathFollow{};
+            }
+        }
+    }
+
+    void SystemRunner::SetDeterministic(bool enabled)
+    {
+        m_deterministic = enabled;
+        m_flowFields.setAsync(!enabled);
+        m_paths.setAsync(!enabled);
+        m_avoidance.setDeterministic(enabled);
+    }
 }
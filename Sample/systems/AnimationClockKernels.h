@@ -0,0 +1,109 @@
+#pragma once
+/*
+  AnimationClockKernels.h
+  -----------------------
+  Purpose:
+    - Time advance used by CharacterAnimationSystem over packed per-row arrays gathered from the
+      RenderAnimation column: t += dt * rate, then wrap (looping) or clamp to [0, duration].
+    - SSE2 / NEON process 4 clocks per iteration; a scalar loop handles tails and other CPUs.
+
+  Notes:
+    - Wrapping is t - duration * floor(t / duration) with the cached reciprocal, so no fmod and no
+      per-row branch; looping and clamped rows are blended by mask.
+    - Rows must have duration > 0 (the system only gathers those).
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SAMPLE_ANIMCLOCK_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SAMPLE_ANIMCLOCK_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace AnimationClockKernels
+{
+    // loop[i] is 1.0f for looping clips, 0.0f for clamped ones.
+    inline void scalar(float *time, const float *rate, const float *duration, const float *invDuration,
+                       const float *loop, uint32_t begin, uint32_t end, float dt)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const float t = time[i] + dt * rate[i];
+            const float d = duration[i];
+            const float wrapped = std::min(std::max(t - d * std::floor(t * invDuration[i]), 0.0f), d);
+            const float clamped = std::min(std::max(t, 0.0f), d);
+            time[i] = (loop[i] != 0.0f) ? wrapped : clamped;
+        }
+    }
+
+#if defined(SAMPLE_ANIMCLOCK_SSE2)
+    inline void sse2(float *time, const float *rate, const float *duration, const float *invDuration,
+                     const float *loop, uint32_t begin, uint32_t end, float dt)
+    {
+        const __m128 step = _mm_set1_ps(dt);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+
+        uint32_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            const __m128 d = _mm_loadu_ps(duration + i);
+            const __m128 t = _mm_add_ps(_mm_loadu_ps(time + i), _mm_mul_ps(step, _mm_loadu_ps(rate + i)));
+
+            // floor() without SSE4.1: truncate, then step down where truncation rounded up (t < 0).
+            const __m128 q = _mm_mul_ps(t, _mm_loadu_ps(invDuration + i));
+            const __m128 tq = _mm_cvtepi32_ps(_mm_cvttps_epi32(q));
+            const __m128 fq = _mm_sub_ps(tq, _mm_and_ps(_mm_cmpgt_ps(tq, q), one));
+
+            const __m128 wrapped = _mm_min_ps(_mm_max_ps(_mm_sub_ps(t, _mm_mul_ps(d, fq)), zero), d);
+            const __m128 clamped = _mm_min_ps(_mm_max_ps(t, zero), d);
+            const __m128 isLoop = _mm_cmpneq_ps(_mm_loadu_ps(loop + i), zero);
+            _mm_storeu_ps(time + i, _mm_or_ps(_mm_and_ps(isLoop, wrapped), _mm_andnot_ps(isLoop, clamped)));
+        }
+
+        scalar(time, rate, duration, invDuration, loop, i, end, dt);
+    }
+#endif // SAMPLE_ANIMCLOCK_SSE2
+
+#if defined(SAMPLE_ANIMCLOCK_NEON)
+    inline void neon(float *time, const float *rate, const float *duration, const float *invDuration,
+                     const float *loop, uint32_t begin, uint32_t end, float dt)
+    {
+        const float32x4_t step = vdupq_n_f32(dt);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+
+        uint32_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            const float32x4_t d = vld1q_f32(duration + i);
+            const float32x4_t t = vmlaq_f32(vld1q_f32(time + i), step, vld1q_f32(rate + i));
+            const float32x4_t fq = vrndmq_f32(vmulq_f32(t, vld1q_f32(invDuration + i)));
+
+            const float32x4_t wrapped = vminq_f32(vmaxq_f32(vmlsq_f32(t, d, fq), zero), d);
+            const float32x4_t clamped = vminq_f32(vmaxq_f32(t, zero), d);
+            const uint32x4_t isLoop = vmvnq_u32(vceqq_f32(vld1q_f32(loop + i), zero));
+            vst1q_f32(time + i, vbslq_f32(isLoop, wrapped, clamped));
+        }
+
+        scalar(time, rate, duration, invDuration, loop, i, end, dt);
+    }
+#endif // SAMPLE_ANIMCLOCK_NEON
+
+    // Widest kernel for the target (SSE2 is baseline on x86-64, NEON on AArch64).
+    inline void advance(float *time, const float *rate, const float *duration, const float *invDuration,
+                        const float *loop, uint32_t count, float dt)
+    {
+#if defined(SAMPLE_ANIMCLOCK_SSE2)
+        sse2(time, rate, duration, invDuration, loop, 0, count, dt);
+#elif defined(SAMPLE_ANIMCLOCK_NEON)
+        neon(time, rate, duration, invDuration, loop, 0, count, dt);
+#else
+        scalar(time, rate, duration, invDuration, loop, 0, count, dt);
+#endif
+    }
+} // namespace AnimationClockKernels
@@ -0,0 +1,272 @@
+#pragma once
+/*
+  AvoidanceKernels.h
+  ------------------
+  Purpose:
+    - Separation kernel used by LocalAvoidanceSystem over the packed SpatialSnapshot arrays.
+    - SIMD paths process 8 (AVX2) or 4 (SSE2 / NEON) neighbors per iteration; a scalar loop
+      handles tails and other CPUs.
+    - The widest x86 path is picked once at runtime (CPUID); NEON is always present on AArch64.
+
+  Usage:
+    - const AvoidanceKernelFn kernel = selectAvoidanceKernel();
+    - kernel(self, snap.x.data(), snap.z.data(), snap.radius.data(), snap.separation.data(),
+             begin, end, corrX, corrZ);
+
+  Notes:
+    - Same math as the scalar loop: weight = (desired - dist) / desired for 1e-6 < dist < desired,
+      correction += normalize(self - neighbor) * weight. Neighbors with negative radius are skipped,
+      and the entity itself contributes nothing (dist == 0), so callers need not skip self.
+    - Results differ from the scalar path only by float summation order.
+    - fixedPoint() (lockstep mode) sums contributions as integers on a 2^-24 grid, so its result
+      does not depend on neighbor order or on which CPU runs it. It is never picked automatically.
+*/
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SAMPLE_AVOIDANCE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SAMPLE_AVOIDANCE_AVX2_TARGET
+#else
+#define SAMPLE_AVOIDANCE_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SAMPLE_AVOIDANCE_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Per-unit inputs the kernel needs about the unit being corrected.
+struct AvoidanceSelf
+{
+    float x = 0.0f;
+    float z = 0.0f;
+    float radius = 0.0f;
+    float separation = 0.0f;
+};
+
+using AvoidanceKernelFn = void (*)(const AvoidanceSelf &self,
+                                   const float *xs, const float *zs, const float *radii, const float *seps,
+                                   uint32_t begin, uint32_t end, float &corrX, float &corrZ);
+
+namespace AvoidanceKernels
+{
+    inline void scalar(const AvoidanceSelf &self,
+                       const float *xs, const float *zs, const float *radii, const float *seps,
+                       uint32_t begin, uint32_t end, float &corrX, float &corrZ)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            if (radii[i] < 0.0f)
+                continue;
+
+            float dx = self.x - xs[i];
+            float dz = self.z - zs[i];
+            const float dist2 = dx * dx + dz * dz;
+            const float dist = (dist2 > 1e-12f) ? std::sqrt(dist2) : 0.0f;
+            const float desiredDist = (self.radius + radii[i]) + (self.separation + seps[i]);
+            if (!(dist < desiredDist && dist > 1e-6f))
+                continue;
+
+            const float w = (desiredDist - dist) / desiredDist;
+            dx /= dist;
+            dz /= dist;
+            corrX += dx * w;
+            corrZ += dz * w;
+        }
+    }
+
+    constexpr float kFixedScale = 16777216.0f; // 2^24: scaling is exact, truncation is the only rounding
+
+    inline int64_t toFixed(float v) { return static_cast<int64_t>(v * kFixedScale); }
+    inline float fromFixed(int64_t v) { return static_cast<float>(v) * (1.0f / kFixedScale); }
+
+    // Scalar math, order-independent accumulation.
+    inline void fixedPoint(const AvoidanceSelf &self,
+                           const float *xs, const float *zs, const float *radii, const float *seps,
+                           uint32_t begin, uint32_t end, float &corrX, float &corrZ)
+    {
+        int64_t accX = 0, accZ = 0;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            if (radii[i] < 0.0f)
+                continue;
+
+            const float dx = self.x - xs[i];
+            const float dz = self.z - zs[i];
+            const float dist2 = dx * dx + dz * dz;
+            const float dist = (dist2 > 1e-12f) ? std::sqrt(dist2) : 0.0f;
+            const float desiredDist = (self.radius + radii[i]) + (self.separation + seps[i]);
+            if (!(dist < desiredDist && dist > 1e-6f))
+                continue;
+
+            const float w = (desiredDist - dist) / desiredDist;
+            accX += toFixed((dx / dist) * w);
+            accZ += toFixed((dz / dist) * w);
+        }
+        corrX += fromFixed(accX);
+        corrZ += fromFixed(accZ);
+    }
+
+#if defined(SAMPLE_AVOIDANCE_X86)
+    inline void sse2(const AvoidanceSelf &self,
+                     const float *xs, const float *zs, const float *radii, const float *seps,
+                     uint32_t begin, uint32_t end, float &corrX, float &corrZ)
+    {
+        const __m128 px = _mm_set1_ps(self.x);
+        const __m128 pz = _mm_set1_ps(self.z);
+        const __m128 selfR = _mm_set1_ps(self.radius + self.separation);
+        const __m128 eps = _mm_set1_ps(1e-6f);
+        const __m128 zero = _mm_setzero_ps();
+        __m128 accX = zero;
+        __m128 accZ = zero;
+
+        uint32_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            const __m128 nr = _mm_loadu_ps(radii + i);
+            const __m128 dx = _mm_sub_ps(px, _mm_loadu_ps(xs + i));
+            const __m128 dz = _mm_sub_ps(pz, _mm_loadu_ps(zs + i));
+            const __m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz)));
+            const __m128 desired = _mm_add_ps(selfR, _mm_add_ps(nr, _mm_loadu_ps(seps + i)));
+
+            const __m128 valid = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(dist, desired), _mm_cmpgt_ps(dist, eps)),
+                                            _mm_cmpge_ps(nr, zero));
+            // w / dist folded into one factor; invalid lanes are zeroed by the mask.
+            const __m128 scale = _mm_div_ps(_mm_div_ps(_mm_sub_ps(desired, dist), desired), dist);
+            const __m128 s = _mm_and_ps(valid, scale);
+            accX = _mm_add_ps(accX, _mm_mul_ps(dx, s));
+            accZ = _mm_add_ps(accZ, _mm_mul_ps(dz, s));
+        }
+
+        alignas(16) float lx[4], lz[4];
+        _mm_store_ps(lx, accX);
+        _mm_store_ps(lz, accZ);
+        corrX += (lx[0] + lx[1]) + (lx[2] + lx[3]);
+        corrZ += (lz[0] + lz[1]) + (lz[2] + lz[3]);
+
+        scalar(self, xs, zs, radii, seps, i, end, corrX, corrZ);
+    }
+
+    SAMPLE_AVOIDANCE_AVX2_TARGET
+    inline void avx2(const AvoidanceSelf &self,
+                     const float *xs, const float *zs, const float *radii, const float *seps,
+                     uint32_t begin, uint32_t end, float &corrX, float &corrZ)
+    {
+        const __m256 px = _mm256_set1_ps(self.x);
+        const __m256 pz = _mm256_set1_ps(self.z);
+        const __m256 selfR = _mm256_set1_ps(self.radius + self.separation);
+        const __m256 eps = _mm256_set1_ps(1e-6f);
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 accX = zero;
+        __m256 accZ = zero;
+
+        uint32_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            const __m256 nr = _mm256_loadu_ps(radii + i);
+            const __m256 dx = _mm256_sub_ps(px, _mm256_loadu_ps(xs + i));
+            const __m256 dz = _mm256_sub_ps(pz, _mm256_loadu_ps(zs + i));
+            const __m256 dist = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dz, dz)));
+            const __m256 desired = _mm256_add_ps(selfR, _mm256_add_ps(nr, _mm256_loadu_ps(seps + i)));
+
+            const __m256 valid = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(dist, desired, _CMP_LT_OQ),
+                                                             _mm256_cmp_ps(dist, eps, _CMP_GT_OQ)),
+                                               _mm256_cmp_ps(nr, zero, _CMP_GE_OQ));
+            const __m256 scale = _mm256_div_ps(_mm256_div_ps(_mm256_sub_ps(desired, dist), desired), dist);
+            const __m256 s = _mm256_and_ps(valid, scale);
+            accX = _mm256_add_ps(accX, _mm256_mul_ps(dx, s));
+            accZ = _mm256_add_ps(accZ, _mm256_mul_ps(dz, s));
+        }
+
+        alignas(32) float lx[8], lz[8];
+        _mm256_store_ps(lx, accX);
+        _mm256_store_ps(lz, accZ);
+        corrX += ((lx[0] + lx[1]) + (lx[2] + lx[3])) + ((lx[4] + lx[5]) + (lx[6] + lx[7]));
+        corrZ += ((lz[0] + lz[1]) + (lz[2] + lz[3])) + ((lz[4] + lz[5]) + (lz[6] + lz[7]));
+
+        sse2(self, xs, zs, radii, seps, i, end, corrX, corrZ);
+    }
+
+    inline bool cpuHasAvx2()
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4] = {};
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif // SAMPLE_AVOIDANCE_X86
+
+#if defined(SAMPLE_AVOIDANCE_NEON)
+    inline void neon(const AvoidanceSelf &self,
+                     const float *xs, const float *zs, const float *radii, const float *seps,
+                     uint32_t begin, uint32_t end, float &corrX, float &corrZ)
+    {
+        const float32x4_t px = vdupq_n_f32(self.x);
+        const float32x4_t pz = vdupq_n_f32(self.z);
+        const float32x4_t selfR = vdupq_n_f32(self.radius + self.separation);
+        const float32x4_t eps = vdupq_n_f32(1e-6f);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        float32x4_t accX = zero;
+        float32x4_t accZ = zero;
+
+        uint32_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            const float32x4_t nr = vld1q_f32(radii + i);
+            const float32x4_t dx = vsubq_f32(px, vld1q_f32(xs + i));
+            const float32x4_t dz = vsubq_f32(pz, vld1q_f32(zs + i));
+            const float32x4_t dist = vsqrtq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dz, dz)));
+            const float32x4_t desired = vaddq_f32(selfR, vaddq_f32(nr, vld1q_f32(seps + i)));
+
+            const uint32x4_t valid = vandq_u32(vandq_u32(vcltq_f32(dist, desired), vcgtq_f32(dist, eps)),
+                                               vcgeq_f32(nr, zero));
+            const float32x4_t scale = vdivq_f32(vdivq_f32(vsubq_f32(desired, dist), desired), dist);
+            const float32x4_t s = vreinterpretq_f32_u32(vandq_u32(valid, vreinterpretq_u32_f32(scale)));
+            accX = vaddq_f32(accX, vmulq_f32(dx, s));
+            accZ = vaddq_f32(accZ, vmulq_f32(dz, s));
+        }
+
+        corrX += vaddvq_f32(accX);
+        corrZ += vaddvq_f32(accZ);
+
+        scalar(self, xs, zs, radii, seps, i, end, corrX, corrZ);
+    }
+#endif // SAMPLE_AVOIDANCE_NEON
+} // namespace AvoidanceKernels
+
+// Widest kernel supported by this CPU (decided once).
+inline AvoidanceKernelFn selectAvoidanceKernel()
+{
+#if defined(SAMPLE_AVOIDANCE_X86)
+    static const AvoidanceKernelFn fn = AvoidanceKernels::cpuHasAvx2() ? &AvoidanceKernels::avx2 : &AvoidanceKernels::sse2;
+    return fn;
+#elif defined(SAMPLE_AVOIDANCE_NEON)
+    return &AvoidanceKernels::neon;
+#else
+    return &AvoidanceKernels::scalar;
+#endif
+}
+
+// Name of the kernel selectAvoidanceKernel() returns ("avx2", "sse2", "neon" or "scalar").
+inline const char *avoidanceKernelName()
+{
+#if defined(SAMPLE_AVOIDANCE_X86)
+    return AvoidanceKernels::cpuHasAvx2() ? "avx2" : "sse2";
+#elif defined(SAMPLE_AVOIDANCE_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
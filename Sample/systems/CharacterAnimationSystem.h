@@ -1,15 +1,18 @@
 #pragma once
 
 #include "ECS/SystemFormat.h"
+#include "Engine/FrameArena.h"
 #include "assets/AssetManager.h"
+#include "systems/AnimationClockKernels.h"
 
 #include <algorithm>
-#include <cmath>
 #include <cstdint>
 
 // CharacterAnimationSystem
 // - Advances per-entity RenderAnimation time
-// - Only applies to entities tagged as Selected (row mask)
+// - Only applies to entities tagged as Selected (row mask mirrored from ECSContext::selection)
+// - Clip durations are cached in RenderAnimation when the clip changes; the per-frame advance is a
+//   SIMD pass over the gathered clocks (AnimationClockKernels) with no asset lookups
 class CharacterAnimationSystem : public Engine::ECS::SystemBase
 {
 public:
@@ -17,6 +20,8 @@ public:
     {
         setRequiredNames({"RenderModel", "RenderAnimation"});
         setExcludedNames({"Disabled", "Dead"});
+        setReadNames({"RenderModel"});
+        setWriteNames({"RenderAnimation"});
     }
 
     const char *name() const override { return "CharacterAnimationSystem"; }
@@ -34,71 +39,83 @@ public:
         if (!m_assets)
             return;
 
-        for (const auto &ptr : mgr.stores())
+        for (uint32_t sid : matchingStores(mgr))
         {
-            if (!ptr)
-                continue;
-
-            auto &store = *ptr;
-            if (!store.signature().containsAll(required()))
-                continue;
-            if (!store.signature().containsNone(excluded()))
-                continue;
+            auto &store = *mgr.get(sid);
             if (!store.hasRenderModel() || !store.hasRenderAnimation())
                 continue;
 
-            auto &renderModels = store.renderModels();
-            auto &renderAnimations = store.renderAnimations();
+            auto renderModels = store.renderModels();
+            auto renderAnimations = store.renderAnimations();
             const auto &masks = store.rowMasks();
+            const bool filterRows = !store.rowTags().containsNone(excluded());
             const uint32_t n = store.size();
 
+            // Gather playing clocks into packed arrays; asset lookups only for rows whose clip changed.
+            Engine::FrameArena::Scope scratch;
+            Engine::FrameArena &arena = scratch.arena();
+            uint32_t *rows = arena.allocateArray<uint32_t>(n);
+            float *time = arena.allocateArray<float>(n);
+            float *rate = arena.allocateArray<float>(n);
+            float *duration = arena.allocateArray<float>(n);
+            float *invDuration = arena.allocateArray<float>(n);
+            float *loop = arena.allocateArray<float>(n);
+            uint32_t count = 0;
+
             for (uint32_t row = 0; row < n; ++row)
             {
-                if (!masks[row].matches(required(), excluded()))
+                if (filterRows && !masks[row].matches(required(), excluded()))
                     continue;
                 if (!masks[row].has(m_selectedId))
                     continue;
 
-                const Engine::ModelHandle handle = renderModels[row].handle;
-                Engine::ModelAsset *asset = m_assets->getModel(handle);
-                if (!asset)
-                    continue;
-
                 auto &anim = renderAnimations[row];
-
-                if (asset->animClips.empty())
-                {
-                    anim.clipIndex = 0;
-                    anim.timeSec = 0.0f;
+                if (anim.durationClip != anim.clipIndex && !resolveClip(renderModels[row].handle, anim))
                     continue;
-                }
-
-                const uint32_t safeClip = std::min(anim.clipIndex, static_cast<uint32_t>(asset->animClips.size() - 1));
-                anim.clipIndex = safeClip;
-
-                const float duration = asset->animClips[safeClip].durationSec;
-                if (!anim.playing || duration <= 1e-6f)
+                if (!anim.playing || anim.durationSec <= 1e-6f)
                     continue;
 
-                anim.timeSec += dt * anim.speed;
-                if (anim.loop)
-                {
-                    anim.timeSec = std::fmod(anim.timeSec, duration);
-                    if (anim.timeSec < 0.0f)
-                        anim.timeSec += duration;
-                }
-                else
-                {
-                    if (anim.timeSec < 0.0f)
-                        anim.timeSec = 0.0f;
-                    if (anim.timeSec > duration)
-                        anim.timeSec = duration;
-                }
+                rows[count] = row;
+                time[count] = anim.timeSec;
+                rate[count] = anim.speed;
+                duration[count] = anim.durationSec;
+                invDuration[count] = anim.invDurationSec;
+                loop[count] = anim.loop ? 1.0f : 0.0f;
+                ++count;
             }
+
+            AnimationClockKernels::advance(time, rate, duration, invDuration, loop, count, dt);
+
+            for (uint32_t i = 0; i < count; ++i)
+                renderAnimations[rows[i]].timeSec = time[i];
         }
     }
 
 private:
+    // Clamp clipIndex and cache its duration. False while the model is not loaded (retried next frame).
+    bool resolveClip(Engine::ModelHandle handle, Engine::ECS::RenderAnimation &anim) const
+    {
+        const Engine::ModelAsset *asset = m_assets->getModel(handle);
+        if (!asset)
+            return false;
+
+        if (asset->animClips.empty())
+        {
+            anim.clipIndex = 0;
+            anim.timeSec = 0.0f;
+            anim.durationSec = 0.0f;
+            anim.invDurationSec = 0.0f;
+        }
+        else
+        {
+            anim.clipIndex = std::min(anim.clipIndex, static_cast<uint32_t>(asset->animClips.size() - 1));
+            anim.durationSec = asset->animClips[anim.clipIndex].durationSec;
+            anim.invDurationSec = (anim.durationSec > 1e-6f) ? 1.0f / anim.durationSec : 0.0f;
+        }
+        anim.durationClip = anim.clipIndex;
+        return true;
+    }
+
     Engine::AssetManager *m_assets = nullptr;
     uint32_t m_selectedId = Engine::ECS::ComponentRegistry::InvalidID;
 };
@@ -1,8 +1,14 @@
 #pragma once
 #include "ECS/SystemFormat.h"
+#include "ECS/CommandBuffer.h"
+#include "ECS/Selection.h"
+#include "nav/PathService.h"
+#include "systems/FormationSystem.h"
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <utility>
 #include <vector>
 
 class CommandSystem : public Engine::ECS::SystemBase
@@ -12,15 +18,42 @@ public:
     {
         // Require MoveTarget + MoveSpeed so we only command movable units.
         setRequiredNames({"MoveTarget", "MoveSpeed"});
-        setExcludedNames({"Disabled", "Dead"});
+        setExcludedNames({"Disabled", "Dead", "RegionGhost"});
+        setReadNames({"Position", "MoveSpeed"});
+        setWriteNames({"MoveTarget", "PathFollow", "FormationMember", "FormationGroups"});
     }
 
     const char *name() const override { return "CommandSystem"; }
 
     void buildMasks(Engine::ECS::ComponentRegistry &registry) override
     {
-        Engine::ECS::SystemBase::buildMasks(registry);
-        m_selectedId = registry.ensureId("Selected");
+        SystemBase::buildMasks(registry);
+        m_atRestId = registry.ensureId("AtRest");
+    }
+
+    // Selected units come from 'selection' (resolved through 'records'); both outlive the system.
+    void setSelection(const Engine::ECS::SelectionSet *selection, const Engine::ECS::EntitiesRecord *records)
+    {
+        m_selection = selection;
+        m_records = records;
+    }
+
+    // Optional: small groups (up to maxGroup units) get individual HPA* paths from 'paths', stored in
+    // PathFollow (id 'pathFollowId'); larger groups share flow fields in SteeringSystem.
+    void setPathService(PathService *paths, uint32_t pathFollowId, uint32_t maxGroup = 32)
+    {
+        m_paths = paths;
+        m_pathFollowId = pathFollowId;
+        m_maxPathGroup = maxGroup;
+    }
+
+    // Optional: groups too large for individual paths move as one formation (FormationSystem).
+    // A selection that is exactly one existing formation keeps its slots (e.g. a spawn layout).
+    void setFormations(FormationGroups *groups, uint32_t memberId, uint32_t inFormationTagId)
+    {
+        m_formations = groups;
+        m_formationMemberId = memberId;
+        m_inFormationId = inFormationTagId;
     }
 
     // Set the last clicked target; system will write it to entities on next update.
@@ -36,6 +69,9 @@ public:
     {
         if (!m_hasPending)
             return;
+        m_hasPending = false;
+        if (!m_selection || !m_records)
+            return;
 
         // Formation tuning in gameplay world coordinates (meters).
         // Ground plane is X/Z (Y is height).
@@ -47,65 +83,190 @@ public:
         auto clamp = [](float v, float a, float b)
         { return std::max(a, std::min(v, b)); };
 
-        for (const auto &ptr : mgr.stores())
+        // Resolve selected, commandable units first so we can distribute target offsets.
+        m_targets.clear();
+        m_targets.reserve(m_selection->size());
+        for (Engine::ECS::Entity e : m_selection->entities())
         {
-            if (!ptr)
+            const Engine::ECS::EntityRecord *rec = m_records->find(e);
+            Engine::ECS::ArchetypeStore *store = rec ? mgr.get(rec->archetypeId) : nullptr;
+            if (!store || !store->hasMoveTarget())
                 continue;
-            auto &store = *ptr;
-            if (!store.signature().containsAll(required()))
+            if (!store->signature().containsAll(required()) || !store->signature().containsNone(excluded()))
                 continue;
-            if (!store.signature().containsNone(excluded()))
+            if (!store->rowTags().containsNone(excluded()) && !store->rowMasks()[rec->row].matches(required(), excluded()))
                 continue;
+            m_targets.push_back(Target{store, rec->row, e});
+        }
+
+        const uint32_t selCount = static_cast<uint32_t>(m_targets.size());
+        if (selCount == 0)
+            return;
+
+        // Distribute selected units over a centered grid around the clicked target.
+        // Example (selCount=5, side=3): offsets at (-1, -1), (0,-1), (1,-1), (-1,0), (0,0) * spacing.
+        const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(selCount))));
+        const float half = (static_cast<float>(side) - 1.0f) * 0.5f;
 
-            auto &targets = const_cast<std::vector<Engine::ECS::MoveTarget> &>(store.moveTargets());
-            auto &masks = store.rowMasks();
-            const uint32_t n = store.size();
+        const bool usePaths = m_paths && selCount <= m_maxPathGroup;
+        if (m_formations && !usePaths)
+        {
+            orderFormation(side, half, spacing);
+            std::cout << "[CommandSystem] Selected=" << selCount
+                      << " baseTarget=(" << m_pendingX << "," << m_pendingZ << ")"
+                      << " formation=" << m_lastGroup << "\n";
+            return;
+        }
 
-            // Collect selected rows first so we can distribute target offsets.
-            std::vector<uint32_t> selectedRows;
-            selectedRows.reserve(n);
-            for (uint32_t i = 0; i < n; ++i)
+        for (uint32_t k = 0; k < selCount; ++k)
+        {
+            const uint32_t row = k / side;
+            const uint32_t col = k % side;
+            const float ox = (static_cast<float>(col) - half) * spacing;
+            const float oz = (static_cast<float>(row) - half) * spacing;
+
+            Engine::ECS::ArchetypeStore *store = m_targets[k].store;
+            const uint32_t r = m_targets[k].row;
+            auto &target = store->moveTargets()[r];
+            target.x = clamp(m_pendingX + ox, kMinWorld, kMaxWorld);
+            target.y = m_pendingY; // height
+            target.z = clamp(m_pendingZ + oz, kMinWorld, kMaxWorld);
+            target.active = 1;
+
+            leaveFormation(m_targets[k]);
+            // Resting units are skipped by steering until the tag is dropped at playback.
+            if (commandBuffer() && store->rowMasks()[r].has(m_atRestId))
+                commandBuffer()->removeTag(m_targets[k].entity, m_atRestId);
+
+            const bool hasPath = store->hasColumn<PathFollow>();
+            if (usePaths && store->hasColumn<Engine::ECS::Position>())
+            {
+                const Engine::ECS::Position pos = std::as_const(*store).positions()[r];
+                PathFollow follow;
+                follow.requestId = m_paths->request(m_targets[k].entity, pos.x, pos.z, target.x, target.z);
+                follow.state = PathFollow::Pending;
+                if (hasPath)
+                    store->column<PathFollow>()[r] = follow;
+                else if (commandBuffer())
+                    commandBuffer()->addComponent(m_targets[k].entity, m_pathFollowId, follow);
+            }
+            else if (hasPath)
             {
-                if (!masks[i].matches(required(), excluded()))
-                    continue;
-                if (m_selectedId == Engine::ECS::ComponentRegistry::InvalidID || !masks[i].has(m_selectedId))
-                    continue;
-                selectedRows.push_back(i);
+                store->column<PathFollow>()[r] = PathFollow{}; // drop any old path: flow fields take over
             }
+        }
 
-            const uint32_t selCount = static_cast<uint32_t>(selectedRows.size());
-            if (selCount == 0)
-                continue;
+        std::cout << "[CommandSystem] Selected=" << selCount
+                  << " baseTarget=(" << m_pendingX << "," << m_pendingZ << ")"
+                  << " gridSide=" << side << " spacing=" << spacing
+                  << (usePaths ? " paths=hpa" : "") << "\n";
+    }
 
-            // Distribute selected units over a centered grid around the clicked target.
-            // Example (selCount=5, side=3): offsets at (-1, -1), (0,-1), (1,-1), (-1,0), (0,0) * spacing.
-            const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(selCount))));
-            const float half = (static_cast<float>(side) - 1.0f) * 0.5f;
+private:
+    struct Target
+    {
+        Engine::ECS::ArchetypeStore *store;
+        uint32_t row;
+        Engine::ECS::Entity entity;
+    };
 
-            for (uint32_t k = 0; k < selCount; ++k)
+    void leaveFormation(const Target &t)
+    {
+        if (!m_formations || !t.store->hasColumn<FormationMember>())
+            return;
+        FormationMember &m = t.store->column<FormationMember>()[t.row];
+        m_formations->unassign(m.group);
+        if (m.inSlot && commandBuffer() && m_inFormationId != Engine::ECS::ComponentRegistry::InvalidID)
+            commandBuffer()->removeTag(t.entity, m_inFormationId);
+        m = FormationMember{};
+    }
+
+    // One anchor for the whole selection; members keep slots around it instead of MoveTargets.
+    void orderFormation(uint32_t side, float half, float spacing)
+    {
+        using Engine::ECS::MoveSpeed;
+        using Engine::ECS::Position;
+
+        // Centroid, slowest member and whether the selection is exactly one existing formation.
+        float cx = 0.0f, cz = 0.0f;
+        float speed = std::numeric_limits<float>::max();
+        uint32_t shared = FormationMember::kNoGroup;
+        bool sameGroup = true;
+        for (size_t k = 0; k < m_targets.size(); ++k)
+        {
+            const Target &t = m_targets[k];
+            const Engine::ECS::ArchetypeStore &store = std::as_const(*t.store); // reads: no change marks
+            if (store.hasColumn<Position>())
             {
-                const uint32_t row = k / side;
-                const uint32_t col = k % side;
-                const float ox = (static_cast<float>(col) - half) * spacing;
-                const float oz = (static_cast<float>(row) - half) * spacing;
-
-                const uint32_t i = selectedRows[k];
-                targets[i].x = clamp(m_pendingX + ox, kMinWorld, kMaxWorld);
-                targets[i].y = m_pendingY; // height
-                targets[i].z = clamp(m_pendingZ + oz, kMinWorld, kMaxWorld);
-                targets[i].active = 1;
+                const Position pos = store.positions()[t.row];
+                cx += pos.x;
+                cz += pos.z;
             }
-
-            std::cout << "[CommandSystem] Selected=" << selCount
-                      << " baseTarget=(" << m_pendingX << "," << m_pendingZ << ")"
-                      << " gridSide=" << side << " spacing=" << spacing << "\n";
+            speed = std::min(speed, store.column<MoveSpeed>()[t.row].value);
+            const uint32_t g = store.hasColumn<FormationMember>() ? store.column<FormationMember>()[t.row].group
+                                                                  : FormationMember::kNoGroup;
+            if (k == 0)
+                shared = g;
+            else if (g != shared)
+                sameGroup = false;
         }
+        const uint32_t count = static_cast<uint32_t>(m_targets.size());
+        const bool reuse = sameGroup && m_formations->valid(shared) && (*m_formations)[shared].members == count;
+        const uint32_t id = reuse ? shared : m_formations->create(cx / count, cz / count);
 
-        m_hasPending = false;
+        // Slightly under the slowest member's speed so stragglers can close up.
+        constexpr float kGroupSpeedScale = 0.85f;
+        m_formations->order(id, m_pendingX, m_pendingZ, speed * kGroupSpeedScale);
+        m_lastGroup = id;
+        const FormationGroup &g = (*m_formations)[id];
+
+        for (uint32_t k = 0; k < count; ++k)
+        {
+            const Target &t = m_targets[k];
+            FormationMember member;
+            if (reuse)
+            {
+                member = t.store->column<FormationMember>()[t.row];
+            }
+            else
+            {
+                const uint32_t inSlot = t.store->hasColumn<FormationMember>() ? t.store->column<FormationMember>()[t.row].inSlot : 0;
+                if (t.store->hasColumn<FormationMember>())
+                    m_formations->unassign(t.store->column<FormationMember>()[t.row].group);
+                member.group = id;
+                member.slotX = (static_cast<float>(k % side) - half) * spacing;
+                member.slotZ = (static_cast<float>(k / side) - half) * spacing;
+                member.inSlot = static_cast<uint8_t>(inSlot); // tag state carries over
+                m_formations->assign(id);
+            }
+
+            // Final slot for anyone reading MoveTarget; inactive so SteeringSystem leaves the unit to the group.
+            auto &target = t.store->moveTargets()[t.row];
+            target.x = m_pendingX + g.forwardZ * member.slotX + g.forwardX * member.slotZ;
+            target.y = m_pendingY;
+            target.z = m_pendingZ - g.forwardX * member.slotX + g.forwardZ * member.slotZ;
+            target.active = 0;
+
+            if (t.store->hasColumn<PathFollow>())
+                t.store->column<PathFollow>()[t.row] = PathFollow{};
+            if (t.store->hasColumn<FormationMember>())
+                t.store->column<FormationMember>()[t.row] = member;
+            else if (commandBuffer())
+                commandBuffer()->addComponent(t.entity, m_formationMemberId, member);
+        }
     }
 
-private:
     bool m_hasPending = false;
     float m_pendingX = 0.0f, m_pendingY = 0.0f, m_pendingZ = 0.0f;
-    uint32_t m_selectedId = Engine::ECS::ComponentRegistry::InvalidID;
+    const Engine::ECS::SelectionSet *m_selection = nullptr;
+    const Engine::ECS::EntitiesRecord *m_records = nullptr;
+    PathService *m_paths = nullptr;
+    uint32_t m_pathFollowId = Engine::ECS::ComponentRegistry::InvalidID;
+    uint32_t m_maxPathGroup = 32;
+    FormationGroups *m_formations = nullptr;
+    uint32_t m_formationMemberId = Engine::ECS::ComponentRegistry::InvalidID;
+    uint32_t m_inFormationId = Engine::ECS::ComponentRegistry::InvalidID;
+    uint32_t m_atRestId = Engine::ECS::ComponentRegistry::InvalidID;
+    uint32_t m_lastGroup = FormationMember::kNoGroup;
+    std::vector<Target> m_targets; // resolved selection scratch
 };
\ No newline at end of file
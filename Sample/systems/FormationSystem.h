@@ -0,0 +1,312 @@
+#pragma once
+/*
+  FormationSystem.h
+  -----------------
+  Purpose:
+    - Group movement: each formation has one virtual anchor that is steered toward the group's
+      target (once per group, along flow fields when available); members hold slot offsets around
+      it instead of steering and avoiding each other individually.
+
+  Usage:
+    - FormationGroups groups; uint32_t g = groups.create(x, z);
+    - members carry FormationMember{g, slotX, slotZ}; groups.order(g, targetX, targetZ, speed) moves them.
+    - Run after SteeringSystem and before SpatialIndexSystem (it writes preferred velocities).
+
+  Notes:
+    - Slots are in the formation's frame: +z is its facing, +x its right. order() turns the
+      formation toward the target; a fresh group faces +z, so spawn layouts keep their world shape.
+    - Members within slotTolerance of their slot carry the "InFormation" row tag, which
+      LocalAvoidanceSystem skips: the slot layout already spaces them. Other units still avoid them.
+    - Cost per tick is O(groups) for anchors plus O(members) for slot tracking, with no neighbor
+      queries. Members whose slot falls on a blocked nav cell follow the anchor instead.
+    - Member counts are maintained by whoever assigns members (assign/unassign); destroyed units
+      are not subtracted, so an emptied group simply keeps an idle anchor until it is reused.
+    - Members settled in the slot of a stopped group go to rest ("AtRest" row tag, shared with
+      SteeringSystem) and are skipped until their group moves again or a neighbor pushes them.
+*/
+
+#include "ECS/SystemFormat.h"
+#include "ECS/CommandBuffer.h"
+#include "ECS/Components.h"
+#include "nav/FlowField.h"
+#include "nav/NavGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+struct FormationMember
+{
+    static constexpr uint32_t kNoGroup = UINT32_MAX;
+
+    uint32_t group = kNoGroup;
+    float slotX = 0.0f; // formation frame, meters
+    float slotZ = 0.0f;
+    uint8_t inSlot = 0; // mirrors the "InFormation" row tag
+};
+
+struct FormationGroup
+{
+    float x = 0.0f, z = 0.0f;             // anchor (virtual centroid)
+    float vx = 0.0f, vz = 0.0f;           // anchor velocity of the latest tick
+    float targetX = 0.0f, targetZ = 0.0f; // anchor destination
+    float forwardX = 0.0f, forwardZ = 1.0f;
+    float speed = 0.0f;
+    uint32_t members = 0;
+    uint8_t moving = 0;
+    uint8_t alive = 0;
+};
+
+class FormationGroups
+{
+public:
+    uint32_t create(float x, float z)
+    {
+        uint32_t id;
+        if (!m_free.empty())
+        {
+            id = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            id = static_cast<uint32_t>(m_groups.size());
+            m_groups.emplace_back();
+        }
+        FormationGroup &g = m_groups[id];
+        g = FormationGroup{};
+        g.x = g.targetX = x;
+        g.z = g.targetZ = z;
+        g.alive = 1;
+        return id;
+    }
+
+    // Move the anchor to (targetX, targetZ) at 'speed', facing the direction of travel.
+    void order(uint32_t id, float targetX, float targetZ, float speed)
+    {
+        FormationGroup &g = m_groups[id];
+        const float dx = targetX - g.x, dz = targetZ - g.z;
+        const float len = std::sqrt(dx * dx + dz * dz);
+        if (len > 1e-3f)
+        {
+            g.forwardX = dx / len;
+            g.forwardZ = dz / len;
+        }
+        g.targetX = targetX;
+        g.targetZ = targetZ;
+        g.speed = speed;
+        g.moving = 1;
+    }
+
+    void assign(uint32_t id) { ++m_groups[id].members; }
+
+    // Drops one member; the group is recycled when none remain.
+    void unassign(uint32_t id)
+    {
+        if (!valid(id))
+            return;
+        FormationGroup &g = m_groups[id];
+        if (g.members > 0 && --g.members == 0)
+        {
+            g.alive = 0;
+            m_free.push_back(id);
+        }
+    }
+
+    bool valid(uint32_t id) const { return id < m_groups.size() && m_groups[id].alive; }
+    FormationGroup &operator[](uint32_t id) { return m_groups[id]; }
+    const FormationGroup &operator[](uint32_t id) const { return m_groups[id]; }
+    uint32_t capacity() const { return static_cast<uint32_t>(m_groups.size()); }
+
+    void clear()
+    {
+        m_groups.clear();
+        m_free.clear();
+    }
+
+private:
+    std::vector<FormationGroup> m_groups;
+    std::vector<uint32_t> m_free;
+};
+
+class FormationSystem : public Engine::ECS::SystemBase
+{
+public:
+    FormationSystem()
+    {
+        setRequiredNames({"Position", "Velocity", "MoveSpeed", "FormationMember"});
+        setExcludedNames({"Disabled", "Dead", "RegionGhost"});
+        setReadNames({"Position", "MoveSpeed"});
+        setWriteNames({"Velocity", "FormationMember", "FormationGroups"});
+    }
+
+    const char *name() const override { return "FormationSystem"; }
+
+    void buildMasks(Engine::ECS::ComponentRegistry &registry) override
+    {
+        SystemBase::buildMasks(registry);
+        m_atRestId = registry.ensureId("AtRest");
+    }
+
+    // Groups shared with CommandSystem / ScenarioSpawner; must outlive the system.
+    void setGroups(FormationGroups *groups) { m_groups = groups; }
+    // Optional: anchors follow flow fields; slots on blocked cells fall back to the anchor.
+    void setNavigation(FlowFieldCache *flowFields, const NavGrid *grid)
+    {
+        m_flowFields = flowFields;
+        m_nav = grid;
+    }
+    // Row tag set while a member holds its slot (InvalidID disables tagging).
+    void setInFormationTag(uint32_t tagId) { m_inFormationId = tagId; }
+
+    void update(Engine::ECS::ArchetypeStoreManager &mgr, float dt) override
+    {
+        if (!m_groups || dt <= 0.0f)
+            return;
+
+        steerAnchors(dt);
+
+        constexpr float kArrival = 0.25f;      // same radius as SteeringSystem
+        constexpr float kGain = 2.0f;          // slot error (m) -> correction speed (m/s)
+        constexpr float kSlotTolerance = 1.0f; // closer than this counts as "in formation"
+
+        const FormationGroups &groups = *m_groups;
+        const NavGrid *nav = (m_nav && m_nav->valid()) ? m_nav : nullptr;
+
+        using namespace Engine::ECS;
+        query<Position, Velocity, MoveSpeed, FormationMember>(mgr).parallelForChunks(
+            workerPool(),
+            [&](const QueryChunk &chunk, Vec3ColumnView<Position> positions, Vec3ColumnView<Velocity> velocities, MoveSpeed *speeds,
+                FormationMember *members)
+            {
+                const bool mayRest = chunk.store->rowTags().has(m_atRestId);
+                for (uint32_t i = chunk.begin; i < chunk.end; ++i)
+                {
+                    if (!chunk.rowMatches(i))
+                        continue;
+                    FormationMember &m = members[i];
+                    if (!groups.valid(m.group))
+                        continue;
+
+                    const FormationGroup &g = groups[m.group];
+                    const Position pos = positions[i];
+                    auto vel = velocities[i];
+
+                    const bool resting = mayRest && chunk.store->rowMasks()[i].has(m_atRestId);
+                    if (resting)
+                    {
+                        if (!g.moving)
+                            continue;
+                        setTag(chunk.store->entities()[i], m_atRestId, false);
+                    }
+
+                    // Slot in world space: right = (forwardZ, -forwardX).
+                    float sx = g.x + g.forwardZ * m.slotX + g.forwardX * m.slotZ;
+                    float sz = g.z - g.forwardX * m.slotX + g.forwardZ * m.slotZ;
+                    const bool slotBlocked = nav && nav->blocked(nav->cellAt(sx, sz));
+                    if (slotBlocked)
+                    {
+                        sx = g.x;
+                        sz = g.z;
+                    }
+
+                    const float ex = sx - pos.x, ez = sz - pos.z;
+                    const float err = std::sqrt(ex * ex + ez * ez);
+
+                    if (!g.moving && err <= kArrival)
+                    {
+                        // Settled when nothing pushed the member during the last tick either.
+                        if (!resting && vel.x * vel.x + vel.z * vel.z < kRestSpeed2)
+                            setTag(chunk.store->entities()[i], m_atRestId, true);
+                        vel.x = vel.y = vel.z = 0.0f;
+                    }
+                    else
+                    {
+                        // Anchor velocity plus a proportional pull toward the slot, capped at the unit's speed.
+                        float vx = g.vx + ex * kGain;
+                        float vz = g.vz + ez * kGain;
+                        const float v = std::sqrt(vx * vx + vz * vz);
+                        const float maxV = std::min(speeds[i].value, err / dt + std::sqrt(g.vx * g.vx + g.vz * g.vz));
+                        if (v > maxV && v > 1e-6f)
+                        {
+                            vx *= maxV / v;
+                            vz *= maxV / v;
+                        }
+                        vel.x = vx;
+                        vel.y = 0.0f;
+                        vel.z = vz;
+                    }
+
+                    // Units squeezing through the anchor's cell keep avoiding each other.
+                    const uint8_t inSlot = (!slotBlocked && err <= kSlotTolerance) ? 1 : 0;
+                    if (inSlot != m.inSlot)
+                        setTag(chunk.store->entities()[i], m_inFormationId, inSlot != 0);
+                    m.inSlot = inSlot;
+                }
+            });
+    }
+
+private:
+    static constexpr float kRestSpeed2 = 1e-4f; // (m/s)^2, as in SteeringSystem
+
+    void setTag(Engine::ECS::Entity e, uint32_t tagId, bool on) const
+    {
+        if (tagId == Engine::ECS::ComponentRegistry::InvalidID || !commandBuffer())
+            return;
+        if (on)
+            commandBuffer()->addTag(e, tagId);
+        else
+            commandBuffer()->removeTag(e, tagId);
+    }
+
+    // O(groups): advance every moving anchor one tick.
+    void steerAnchors(float dt)
+    {
+        FlowFieldCache *flowFields = (m_flowFields && m_flowFields->grid()) ? m_flowFields : nullptr;
+        for (uint32_t id = 0; id < m_groups->capacity(); ++id)
+        {
+            FormationGroup &g = (*m_groups)[id];
+            g.vx = g.vz = 0.0f;
+            if (!g.alive || !g.moving)
+                continue;
+
+            float dx = g.targetX - g.x, dz = g.targetZ - g.z;
+            const float dist = std::sqrt(dx * dx + dz * dz);
+            const float step = g.speed * dt;
+            if (dist <= step || g.speed <= 0.0f)
+            {
+                g.x = g.targetX;
+                g.z = g.targetZ;
+                g.moving = 0;
+                continue;
+            }
+            dx /= dist;
+            dz /= dist;
+
+            if (flowFields)
+            {
+                if (auto field = flowFields->acquire(g.targetX, g.targetZ))
+                {
+                    float fx = 0.0f, fz = 0.0f;
+                    if (field->direction(g.x, g.z, fx, fz))
+                    {
+                        dx = fx;
+                        dz = fz;
+                    }
+                }
+            }
+
+            g.vx = dx * g.speed;
+            g.vz = dz * g.speed;
+            g.x += g.vx * dt;
+            g.z += g.vz * dt;
+        }
+    }
+
+    FormationGroups *m_groups = nullptr;
+    FlowFieldCache *m_flowFields = nullptr;
+    const NavGrid *m_nav = nullptr;
+    uint32_t m_inFormationId = Engine::ECS::ComponentRegistry::InvalidID;
+    uint32_t m_atRestId = Engine::ECS::ComponentRegistry::InvalidID;
+};
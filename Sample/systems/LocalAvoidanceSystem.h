@@ -10,22 +10,40 @@
     - Components present in stores: "Position", "Velocity", "Radius", "AvoidanceParams".
         - Optional component: "Separation" (extra desired spacing beyond radii).
     - SpatialIndexSystem must have run earlier in the frame (grid built).
+      In bounded mode neighbors are read from its packed snapshot instead of the stores.
     - Steering should have already produced a "preferred" velocity, stored in Velocity.
       This system keeps final speeds close to that magnitude.
+    - Rows tagged "InFormation" are left alone (FormationSystem spaces them by slot); they stay in
+      the grid, so other units still avoid them.
+    - Rows tagged "AtRest" (idle units, see SteeringSystem) are only corrected when something nearby
+      moved (SpatialIndexSystem::motionNear in bounded mode); a correction wakes them by removing
+      the tag through the command buffer.
+
+  Threading:
+    - With a bounded SpatialIndexSystem grid and a worker pool (setWorkerPool), the update reads
+      only the grid snapshot (last written velocities = preferred velocities) and writes fresh
+      velocities into the stores, split by cell ranges across the pool. Deterministic for any
+      thread count.
+    - setDeterministic(true) (lockstep) also makes results independent of the CPU and of neighbor
+      order: the fixed-point kernel replaces the SIMD ones, in both grid modes.
 
   Suggested order per frame:
-    CommandSystem -> SteeringSystem -> SpatialIndexSystem -> LocalAvoidanceSystem -> MovementSystem
+    CommandSystem -> SteeringSystem -> FormationSystem -> SpatialIndexSystem -> LocalAvoidanceSystem -> MovementSystem
 */
 
 #include "ECS/SystemFormat.h"
 #include "ECS/Components.h"
 #include "ECS/ArchetypeStore.h"
+#include "ECS/CommandBuffer.h"
 
 // The grid index system for neighbor queries
 #include "systems/SpatialIndexSystem.h"
+#include "systems/AvoidanceKernels.h"
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <vector>
 
 class LocalAvoidanceSystem : public Engine::ECS::SystemBase
 {
@@ -35,13 +53,32 @@ public:
     {
         // Require the data we adjust/read
         setRequiredNames({"Position", "Velocity", "Radius", "AvoidanceParams"});
-        setExcludedNames({"Disabled", "Dead"});
+        setExcludedNames({"Disabled", "Dead", "InFormation", "RegionGhost"});
+        setReadNames({"Position", "Radius", "Separation", "AvoidanceParams", "SpatialGrid"});
+        setWriteNames({"Velocity"});
     }
 
     const char *name() const override { return "LocalAvoidanceSystem"; }
 
+    void buildMasks(Engine::ECS::ComponentRegistry &registry) override
+    {
+        SystemBase::buildMasks(registry);
+        m_atRestId = registry.ensureId("AtRest");
+    }
+
     void setGrid(const SpatialIndexSystem *grid) { m_grid = grid; }
 
+    // SIMD kernel (widest available) for the bounded-grid path; false forces the scalar kernel.
+    void setSimdEnabled(bool enabled) { m_kernel = enabled ? selectAvoidanceKernel() : &AvoidanceKernels::scalar; }
+
+    // Lockstep: bit-identical corrections on every machine (see AvoidanceKernels::fixedPoint).
+    void setDeterministic(bool enabled)
+    {
+        m_deterministic = enabled;
+        m_kernel = enabled ? &AvoidanceKernels::fixedPoint : selectAvoidanceKernel();
+    }
+    bool deterministic() const { return m_deterministic; }
+
     void update(Engine::ECS::ArchetypeStoreManager &mgr, float dt) override
     {
         if (!m_grid)
@@ -49,85 +86,55 @@ public:
         if (dt <= 0.0f)
             return;
 
-        auto clamp = [](float v, float a, float b)
-        { return std::max(a, std::min(v, b)); };
-        auto length2 = [](float x, float z)
-        { return x * x + z * z; };
-        auto length = [&](float x, float z)
-        { return std::sqrt(length2(x, z)); };
-        auto lerp = [](float a, float b, float t)
-        { return a + (b - a) * t; };
-
-        uint32_t sid = 0;
-        for (const auto &ptr : mgr.stores())
+        if (m_grid->bounded() && workerPool())
         {
-            if (!ptr)
-            {
-                ++sid;
-                continue;
-            }
-            auto &store = *ptr;
+            updateParallel(mgr, dt);
+            return;
+        }
 
-            // Store-level mask filter
-            if (!store.signature().containsAll(required()))
-            {
-                ++sid;
-                continue;
-            }
-            if (!store.signature().containsNone(excluded()))
-            {
-                ++sid;
-                continue;
-            }
+        // Stores matching the required/excluded masks (cached by the store manager)
+        for (uint32_t sid : matchingStores(mgr))
+        {
+            auto &store = *mgr.get(sid);
 
-            auto &positions = const_cast<std::vector<Engine::ECS::Position> &>(store.positions());
-            auto &velocities = const_cast<std::vector<Engine::ECS::Velocity> &>(store.velocities());
-            auto &radii = const_cast<std::vector<Engine::ECS::Radius> &>(store.radii());
-            auto &params = const_cast<std::vector<Engine::ECS::AvoidanceParams> &>(store.avoidanceParams());
+            auto positions = store.positions();
+            auto velocities = store.velocities();
+            auto radii = store.radii();
+            auto params = store.avoidanceParams();
             const bool hasSep = store.hasSeparation();
-            auto *sepsPtr = hasSep ? &const_cast<std::vector<Engine::ECS::Separation> &>(store.separations()) : nullptr;
+            const auto seps = store.separations();
             const auto &masks = store.rowMasks();
+            const bool filterRows = !store.rowTags().containsNone(excluded()); // per-row test only if excluded tags were set on rows
+            const bool mayRest = store.rowTags().has(m_atRestId);
 
             const uint32_t n = store.size();
             for (uint32_t row = 0; row < n; ++row)
             {
-                if (!masks[row].matches(required(), excluded()))
+                if (filterRows && !masks[row].matches(required(), excluded()))
                     continue;
 
-                auto &p = positions[row];
-                auto &v = velocities[row];
+                auto p = positions[row]; // row proxies (the columns may be split)
+                auto v = velocities[row];
                 const auto &r = radii[row];
                 const auto &ap = params[row];
-                const float sepSelf = sepsPtr ? (*sepsPtr)[row].value : 0.0f;
+                const float sepSelf = hasSep ? seps[row].value : 0.0f;
 
                 // Accumulate separation correction from neighbors in 3x3 cells
                 float corrX = 0.0f, corrZ = 0.0f;
+                int64_t fixedX = 0, fixedZ = 0; // deterministic mode
 
-                m_grid->forNeighbors(p.x, p.z, [&](uint32_t nStoreId, uint32_t nRow)
-                                     {
-                    // Skip self
-                    if (nStoreId == sid && nRow == row) return;
-
-                    const auto* nStore = mgr.get(nStoreId);
-                    if (!nStore) return;
-                    if (!nStore->hasPosition()) return;
-                    if (!nStore->hasRadius()) return;
-                    const bool nHasSep = nStore->hasSeparation();
-
-                    const auto& np = nStore->positions()[nRow];
-                    const auto& nr = nStore->radii()[nRow];
-                    const float sepOther = (nHasSep ? nStore->separations()[nRow].value : 0.0f);
-
+                auto accumulate = [&](float npx, float npz, float nr, float sepOther)
+                {
                     // 2D separation in gameplay ground plane (X/Z). Y is height.
-                    float dx = p.x - np.x;
-                    float dz = p.z - np.z;
+                    float dx = p.x - npx;
+                    float dz = p.z - npz;
 
-                    const float dist2 = dx*dx + dz*dz;
+                    const float dist2 = dx * dx + dz * dz;
 
                     float dist = (dist2 > 1e-12f) ? std::sqrt(dist2) : 0.0f;
 
                     const float desiredSeparation = sepSelf + sepOther;
-                    const float desiredDist = (r.r + nr.r) + desiredSeparation;
+                    const float desiredDist = (r.r + nr) + desiredSeparation;
 
                     // Overlap weight: strong when overlapping
                     float wOverlap = 0.0f;
@@ -136,58 +143,179 @@ public:
 
                     // Only react within desiredDist (no extra neighborRadius).
                     float w = wOverlap;
-                    if (w <= 0.0f) return;
+                    if (w <= 0.0f)
+                        return;
 
                     // Normalize away vector
-                    if (dist > 1e-6f) { dx /= dist; dz /= dist; } else { dx = 0.0f; dz = 0.0f; }
-
+                    if (dist > 1e-6f)
+                    {
+                        dx /= dist;
+                        dz /= dist;
+                    }
+                    else
+                    {
+                        dx = 0.0f;
+                        dz = 0.0f;
+                    }
+
+                    if (m_deterministic)
+                    {
+                        fixedX += AvoidanceKernels::toFixed(dx * w);
+                        fixedZ += AvoidanceKernels::toFixed(dz * w);
+                        return;
+                    }
                     corrX += dx * w;
-                    corrZ += dz * w; });
-
-                // Combine correction with preferred velocity (from Steering)
-                const float vPrefX = v.x;
-                const float vPrefZ = v.z;
-                const float prefSpeed = length(vPrefX, vPrefZ);
-
-                // Apply strength
-                float vRawX = vPrefX + ap.strength * corrX;
-                float vRawZ = vPrefZ + ap.strength * corrZ;
+                    corrZ += dz * w;
+                };
 
-                // Clamp speed to preferred magnitude (keeps MoveSpeed implicit)
-                const float rawSpeed = length(vRawX, vRawZ);
-                if (prefSpeed > 1e-6f && rawSpeed > prefSpeed)
+                if (m_grid->bounded())
                 {
-                    const float s = prefSpeed / rawSpeed;
-                    vRawX *= s;
-                    vRawZ *= s;
+                    // Packed snapshot: contiguous x/z/radius/separation per candidate range,
+                    // 4-8 neighbors per step. Self sits at distance 0 and contributes nothing.
+                    const AvoidanceSelf self{p.x, p.z, r.r, sepSelf};
+                    m_grid->forNeighborRanges(p.x, p.z, [&](const SpatialSnapshot &snap, uint32_t begin, uint32_t end)
+                                              { m_kernel(self, snap.x.data(), snap.z.data(), snap.radius.data(),
+                                                         snap.separation.data(), begin, end, corrX, corrZ); });
                 }
-
-                // Acceleration clamp relative to vPref
-                float dvX = vRawX - vPrefX;
-                float dvZ = vRawZ - vPrefZ;
-                const float dvMag = length(dvX, dvZ);
-                const float maxDv = ap.maxAccel * dt;
-                if (dvMag > maxDv && dvMag > 1e-6f)
+                else
                 {
-                    const float s = maxDv / dvMag;
-                    dvX *= s;
-                    dvZ *= s;
+                    m_grid->forNeighbors(p.x, p.z, [&](uint32_t nStoreId, uint32_t nRow)
+                                         {
+                        // Skip self
+                        if (nStoreId == sid && nRow == row) return;
+
+                        const auto* nStore = mgr.get(nStoreId);
+                        if (!nStore) return;
+                        if (!nStore->hasPosition()) return;
+                        if (!nStore->hasRadius()) return;
+                        const bool nHasSep = nStore->hasSeparation();
+
+                        const auto& np = nStore->positions()[nRow];
+                        const auto& nr = nStore->radii()[nRow];
+                        const float sepOther = (nHasSep ? nStore->separations()[nRow].value : 0.0f);
+                        accumulate(np.x, np.z, nr.r, sepOther); });
+                    corrX += AvoidanceKernels::fromFixed(fixedX);
+                    corrZ += AvoidanceKernels::fromFixed(fixedZ);
                 }
 
-                const float vNewX = vPrefX + dvX;
-                const float vNewZ = vPrefZ + dvZ;
+                if (mayRest && masks[row].has(m_atRestId))
+                {
+                    if (!pushed(corrX, corrZ))
+                        continue;
+                    wake(store.entities()[row]);
+                }
 
-                // Smooth the change to reduce jitter
-                const float t = clamp(ap.blend, 0.0f, 1.0f);
-                v.x = lerp(vPrefX, vNewX, t);
-                v.z = lerp(vPrefZ, vNewZ, t);
+                // Combine correction with preferred velocity (from Steering)
+                resolveVelocity(v.x, v.z, corrX, corrZ, ap, dt, v.x, v.z);
                 // Leave v.y unchanged (height axis)
             }
-
-            ++sid;
         }
     }
 
 private:
+    // Preferred velocity + separation correction -> final velocity (speed, accel and blend limits).
+    static void resolveVelocity(float vPrefX, float vPrefZ, float corrX, float corrZ,
+                                const Engine::ECS::AvoidanceParams &ap, float dt, float &outX, float &outZ)
+    {
+        auto length = [](float x, float z)
+        { return std::sqrt(x * x + z * z); };
+
+        const float prefSpeed = length(vPrefX, vPrefZ);
+
+        // Apply strength
+        float vRawX = vPrefX + ap.strength * corrX;
+        float vRawZ = vPrefZ + ap.strength * corrZ;
+
+        // Clamp speed to preferred magnitude (keeps MoveSpeed implicit)
+        const float rawSpeed = length(vRawX, vRawZ);
+        if (prefSpeed > 1e-6f && rawSpeed > prefSpeed)
+        {
+            const float s = prefSpeed / rawSpeed;
+            vRawX *= s;
+            vRawZ *= s;
+        }
+
+        // Acceleration clamp relative to vPref
+        float dvX = vRawX - vPrefX;
+        float dvZ = vRawZ - vPrefZ;
+        const float dvMag = length(dvX, dvZ);
+        const float maxDv = ap.maxAccel * dt;
+        if (dvMag > maxDv && dvMag > 1e-6f)
+        {
+            const float s = maxDv / dvMag;
+            dvX *= s;
+            dvZ *= s;
+        }
+
+        // Smooth the change to reduce jitter
+        const float t = std::max(0.0f, std::min(ap.blend, 1.0f));
+        outX = vPrefX + dvX * t;
+        outZ = vPrefZ + dvZ * t;
+    }
+
+    // Bounded grid + worker pool: every input comes from the spatial snapshot (positions and the
+    // preferred velocities captured this frame), outputs go to the stores' Velocity columns.
+    // Nothing written is read back by another unit, so the result is the same for any thread count.
+    // Work is split over contiguous runs of grid entries, i.e. ranges of spatial cells.
+    void updateParallel(Engine::ECS::ArchetypeStoreManager &mgr, float dt)
+    {
+        const auto &entries = m_grid->entries();
+        const SpatialSnapshot &snap = m_grid->snapshot();
+
+        m_storeMatches.assign(mgr.stores().size(), 0);
+        for (uint32_t sid : matchingStores(mgr))
+            m_storeMatches[sid] = 1;
+
+        workerPool()->parallelFor(static_cast<uint32_t>(entries.size()), CellChunkEntries, [&](uint32_t begin, uint32_t end)
+                                  {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                const GridEntry &e = entries[i];
+                if (e.storeId >= m_storeMatches.size() || !m_storeMatches[e.storeId])
+                    continue;
+
+                auto &store = *mgr.get(e.storeId);
+                if (!store.rowTags().containsNone(excluded()) && !store.rowMasks()[e.row].matches(required(), excluded()))
+                    continue;
+
+                // Resting units in a neighborhood where nothing moved keep their (settled) spacing.
+                const bool resting = store.rowTags().has(m_atRestId) && store.rowMasks()[e.row].has(m_atRestId);
+                if (resting && !m_grid->motionNear(snap.x[i], snap.z[i]))
+                    continue;
+
+                const auto &ap = store.avoidanceParams()[e.row];
+                const AvoidanceSelf self{snap.x[i], snap.z[i], snap.radius[i], snap.separation[i]};
+
+                float corrX = 0.0f, corrZ = 0.0f;
+                m_grid->forNeighborRanges(self.x, self.z, [&](const SpatialSnapshot &s, uint32_t nBegin, uint32_t nEnd)
+                                          { m_kernel(self, s.x.data(), s.z.data(), s.radius.data(), s.separation.data(),
+                                                     nBegin, nEnd, corrX, corrZ); });
+                if (resting)
+                {
+                    if (!pushed(corrX, corrZ))
+                        continue;
+                    wake(snap.entity[i]);
+                }
+
+                auto v = store.velocities()[e.row];
+                resolveVelocity(snap.vx[i], snap.vz[i], corrX, corrZ, ap, dt, v.x, v.z);
+            } });
+    }
+
+    // A resting unit moves again once neighbors overlap it noticeably.
+    static bool pushed(float corrX, float corrZ) { return corrX * corrX + corrZ * corrZ > 1e-4f; }
+
+    void wake(Engine::ECS::Entity e) const
+    {
+        if (commandBuffer())
+            commandBuffer()->removeTag(e, m_atRestId);
+    }
+
+    static constexpr uint32_t CellChunkEntries = 512; // grid entries per parallel task
+
     const SpatialIndexSystem *m_grid = nullptr; // not owned
+    std::vector<uint8_t> m_storeMatches;        // per store ID: matches this system's query
+    AvoidanceKernelFn m_kernel = selectAvoidanceKernel();
+    bool m_deterministic = false;
+    uint32_t m_atRestId = Engine::ECS::ComponentRegistry::InvalidID;
 };
\ No newline at end of file
@@ -5,6 +5,9 @@
   Purpose:
     - Moves entities: position += velocity * dt for any archetype store that has both Position and Velocity
       and does not contain excluded tags.
+    - With a ground heightfield set, moved entities stand on it (Position.y = ground height).
+    - When Position and Velocity use the split column layout (ComponentRegistry::setSplitLayout),
+      chunks without per-row filtering integrate the x/y/z lanes as plain float arrays.
 
   How to customize:
     - Change required/excluded component names in the constructor to reflect the game rules.
@@ -13,8 +16,9 @@
 
 #include "ECS/SystemFormat.h" // IGameplaySystem, SystemBase
 #include "ECS/Components.h"
-#include <cmath>
-#include <iostream>
+#include "Engine/Heightfield.h"
+#include <cstdint>
+
 class MovementSystem : public Engine::ECS::SystemBase
 {
 public:
@@ -26,59 +30,71 @@ public:
 
         // Optional excluded tags/components (define them in your registry if you use them).
         // Comment out if not used.
-        setExcludedNames({"Disabled", "Dead"});
+        // "AtRest" units (see SteeringSystem) have no velocity to integrate; "RegionGhost" units are
+        // read-only mirrors of another region's border (ECS/RegionPartition.h).
+        setExcludedNames({"Disabled", "Dead", "AtRest", "RegionGhost"});
+
+        // Access sets used by the system scheduler.
+        setReadNames({"Velocity"});
+        setWriteNames({"Position"});
     }
 
     const char *name() const override { return "MovementSystem"; }
 
+    // Terrain the units walk on (not owned; null keeps integrating y). Edit it only between ticks.
+    void setGround(const Engine::Heightfield *ground) { m_ground = ground; }
+
     // Called once after creation: registry will resolve names to IDs and build masks.
     // buildMasks is inherited from SystemBase; no override needed unless custom behavior is required.
 
-    // Per-frame update over all matching stores.
+    // Per-frame update over all matching stores, split into row chunks on the worker pool.
     void update(Engine::ECS::ArchetypeStoreManager &mgr, float dt) override
     {
-        for (const auto &ptr : mgr.stores())
-        {
-            if (!ptr)
-                continue;
-            const auto &store = *ptr;
-
-            // Fast store-level filter: must have required, must NOT have excluded
-            if (!store.signature().containsAll(required()))
-                continue;
-            if (!store.signature().containsNone(excluded()))
-                continue;
-
-            // Row-level filter and update
-            const uint32_t n = store.size();
-            auto &positions = const_cast<std::vector<Engine::ECS::Position> &>(store.positions());
-            auto &velocities = const_cast<std::vector<Engine::ECS::Velocity> &>(store.velocities());
-            const auto &masks = store.rowMasks();
-
-            const bool canLogTarget = store.hasMoveTarget();
-            const auto *targetsPtr = canLogTarget ? &store.moveTargets() : nullptr;
-
-            for (uint32_t i = 0; i < n; ++i)
+        const Engine::Heightfield *ground = (m_ground && !m_ground->empty()) ? m_ground : nullptr;
+        query<Engine::ECS::Position, const Engine::ECS::Velocity>(mgr).parallelForChunks(
+            workerPool(),
+            [dt, ground](const Engine::ECS::QueryChunk &chunk,
+                         Engine::ECS::Vec3ColumnView<Engine::ECS::Position> positions,
+                         Engine::ECS::Vec3ColumnView<const Engine::ECS::Velocity> velocities)
             {
-                if (!masks[i].matches(required(), excluded()))
-                    continue;
-
-                const auto before = positions[i];
-
-                positions[i].x += velocities[i].x * dt;
-                positions[i].y += velocities[i].y * dt;
-                positions[i].z += velocities[i].z * dt;
+                if (positions.split() && velocities.split() && !chunk.filterRows)
+                {
+                    integrateLane(positions.x(), velocities.x(), chunk.begin, chunk.end, dt);
+                    integrateLane(positions.y(), velocities.y(), chunk.begin, chunk.end, dt);
+                    integrateLane(positions.z(), velocities.z(), chunk.begin, chunk.end, dt);
+                    if (ground)
+                    {
+                        float *py = positions.y();
+                        const float *px = positions.x();
+                        const float *pz = positions.z();
+                        for (uint32_t i = chunk.begin; i < chunk.end; ++i)
+                            py[i] = ground->heightAt(px[i], pz[i]);
+                    }
+                    return;
+                }
 
-                const bool targetActive = (targetsPtr && (*targetsPtr)[i].active != 0);
-                const bool moving = (std::fabs(velocities[i].x) + std::fabs(velocities[i].y) + std::fabs(velocities[i].z)) > 1e-6f;
-                if (targetActive || moving)
+                for (uint32_t i = chunk.begin; i < chunk.end; ++i)
                 {
-                    const auto after = positions[i];
-                    const float dx = after.x - before.x;
-                    const float dy = after.y - before.y;
-                    const float dz = after.z - before.z;
+                    // Row-level filter (tags applied per row)
+                    if (!chunk.rowMatches(i))
+                        continue;
+
+                    positions[i].x += velocities[i].x * dt;
+                    positions[i].y += velocities[i].y * dt;
+                    positions[i].z += velocities[i].z * dt;
+                    if (ground)
+                        positions[i].y = ground->heightAt(positions[i].x, positions[i].z);
                 }
-            }
-        }
+            });
     }
+
+private:
+    // One contiguous lane: the compiler vectorizes this loop.
+    static void integrateLane(float *__restrict p, const float *__restrict v, uint32_t begin, uint32_t end, float dt)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+            p[i] += v[i] * dt;
+    }
+
+    const Engine::Heightfield *m_ground = nullptr;
 };
\ No newline at end of file
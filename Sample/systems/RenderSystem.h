@@ -1,19 +1,27 @@
 #pragma once
 
 #include "ECS/SystemFormat.h"
+#include "ECS/Interpolation.h"
 
 #include "assets/AssetManager.h"
 
 #include "Engine/Camera.h"
+#include "Engine/FrameArena.h"
+#include "Engine/Frustum.h"
+#include "Engine/GpuSceneRenderPassModule.h"
+#include "Engine/ImpostorRenderPassModule.h"
 #include "Engine/Renderer.h"
 #include "Engine/SModelRenderPassModule.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -26,6 +34,7 @@ public:
         // We need Position to build a model matrix later.
         setRequiredNames({"RenderModel", "RenderAnimation", "Position"});
         setExcludedNames({"Disabled", "Dead"});
+        setReadNames({"RenderModel", "RenderAnimation", "Position"});
     }
 
     const char *name() const override { return "RenderModelSystem"; }
@@ -34,47 +43,127 @@ public:
     void setRenderer(Engine::Renderer *renderer) { m_renderer = renderer; }
     void setCamera(Engine::Camera *camera) { m_camera = camera; }
 
+    // Blend positions between the last two fixed simulation ticks (history may be null).
+    void setInterpolation(const Engine::ECS::PositionHistory *history, float alpha)
+    {
+        m_history = history;
+        m_alpha = alpha;
+    }
+
+    // Skip pose evaluation and palette upload for instances outside the camera frustum.
+    void setFrustumCulling(bool enabled) { m_frustumCulling = enabled; }
+
+    // Also skip instances whose bounds are farther than 'maxDistance' from the camera (0 disables).
+    void setCullDistance(float maxDistance) { m_cullDistance = maxDistance; }
+
+    // Animation LOD by projected size (fraction of half the viewport height covered by the
+    // bounding-sphere radius). Below fullRateScreenSize an instance re-evaluates its pose only every
+    // reducedInterval updates; below reducedScreenSize it shares one pose per clip with the rest of its batch.
+    struct AnimationLodPolicy
+    {
+        bool enabled = true;
+        float fullRateScreenSize = 0.08f;
+        float reducedScreenSize = 0.02f;
+        uint32_t reducedInterval = 4;
+        bool sharedPose = true; // false: the smallest instances keep the reduced rate
+    };
+
+    void setAnimationLod(const AnimationLodPolicy &policy) { m_lod = policy; }
+    const AnimationLodPolicy &animationLod() const { return m_lod; }
+
+    // Draw instances whose projected size (as above) is below screenSize as baked sprites
+    // (ImpostorRenderPassModule) instead of the full model, once the model's atlas is baked. Sprites
+    // skip pose evaluation; they show the nearest baked frame of the instance's clip. Set before the
+    // first update(): the impostor module of a model is created with its batch.
+    struct ImpostorPolicy
+    {
+        bool enabled = false;
+        float screenSize = 0.01f;
+        Engine::ImpostorRenderPassModule::Settings bake;
+    };
+
+    void setImpostors(const ImpostorPolicy &policy) { m_impostors = policy; }
+    const ImpostorPolicy &impostors() const { return m_impostors; }
+
+    // Instances drawn / rejected by the last update().
+    uint32_t visibleCount() const { return m_visibleCount; }
+    uint32_t culledCount() const { return m_culledCount; }
+    // Of the visible ones, drawn as impostors.
+    uint32_t impostorCount() const { return m_impostorCount; }
+
+    // Full-rate instances whose clip time falls in the same 'seconds' bucket share one evaluated
+    // pose and palette entry (0 gives every instance its own).
+    void setPoseTimeQuantum(float seconds) { m_poseTimeQuantum = seconds; }
+
+    // Evaluate poses in a compute pre-pass from the models' baked clips: only (clip, time) is uploaded
+    // per instance and animation LOD / pose sharing are skipped. Models without baked clips, or
+    // passes without the pose shader, keep the CPU path.
+    void setGpuSkinning(bool enabled) { m_gpuSkinning = enabled; }
+
+    // Draw every unit through one GpuSceneRenderPassModule: culling, LOD, animation sampling and
+    // draw commands on the GPU, with one persistent record per entity that is only re-uploaded when
+    // it changes. The per-model passes (and impostors) are kept as the fallback until the scene
+    // module reports ready(), and for good if the device cannot run it.
+    void setGpuScene(bool enabled) { m_gpuSceneEnabled = enabled; }
+    bool gpuSceneActive() const { return m_gpuScene && m_gpuScene->ready() && m_gpuSceneEnabled; }
+
+    // evaluatePoseInto() calls / palette entries uploaded by the last update().
+    uint32_t poseEvaluations() const { return m_poseEvaluations; }
+    uint32_t paletteEntries() const { return m_paletteEntries; }
+
     void update(Engine::ECS::ArchetypeStoreManager &mgr, float dt) override
     {
         if (!m_assets || !m_renderer || !m_camera)
             return;
 
+        m_visibleCount = 0;
+        m_culledCount = 0;
+        m_impostorCount = 0;
+        // The camera's shared view: the same frustum the GPU culler and picking use.
+        const Engine::ViewData &view = m_camera->GetViewData();
+        const Engine::Frustum &frustum = view.frustum;
+        const glm::vec3 cameraPos = view.position;
+
+        // Projected radius = radius * |proj[1][1]| / distance (perspective) or radius * |proj[1][1]| (ortho),
+        // as a fraction of half the viewport height.
+        const glm::mat4 &proj = view.proj;
+        const float screenScale = std::fabs(proj[1][1]);
+        const bool orthographic = proj[3][3] == 1.0f;
+        ++m_frame;
+        m_poseEvaluations = 0;
+        m_paletteEntries = 0;
+
+        if (m_gpuSceneEnabled && !m_gpuScene)
+        {
+            // onCreate() runs at the renderer's next snapshot; batches draw until then.
+            m_gpuScene = std::make_shared<Engine::GpuSceneRenderPassModule>();
+            m_gpuScene->setAssets(m_assets);
+            m_renderer->registerPass(m_gpuScene);
+        }
+        if (m_gpuScene)
+            m_gpuScene->setEnabled(gpuSceneActive());
+        if (gpuSceneActive())
+        {
+            updateScene(mgr);
+            return;
+        }
+
         auto keyFromHandle = [](const Engine::ModelHandle &h) -> uint64_t
         {
             return (static_cast<uint64_t>(h.generation) << 32) | static_cast<uint64_t>(h.id);
         };
 
-        struct PerModelBatch
-        {
-            std::vector<glm::mat4> instanceWorlds;
-            std::vector<glm::mat4> nodePalette; // flattened: [instance][node]
-            uint32_t nodeCount = 0;
-
-            std::vector<glm::mat4> jointPalette; // flattened: [instance][joint]
-            uint32_t jointCount = 0;
-
-            // scratch (reused per instance)
-            std::vector<Engine::ModelAsset::NodeTRS> trsScratch;
-            std::vector<glm::mat4> localsScratch;
-            std::vector<glm::mat4> globalsScratch;
-            std::vector<uint8_t> visitedScratch;
+        // Shared palette slots of this update, in frame scratch: no heap traffic once the arena is warm.
+        Engine::FrameArena::Scope scratch;
+        PoseSlotMap slotByPose(64, PoseKeyHash{}, std::equal_to<PoseKey>{}, PoseSlotMap::allocator_type(scratch.arena()));
 
-            std::vector<glm::mat4> jointsScratch;
-        };
+        // Rows of a store usually share a model, so remember the last batch instead of hashing per row.
+        RenderBatch *batchPtr = nullptr;
+        uint64_t batchKey = 0;
 
-        std::unordered_map<uint64_t, PerModelBatch> batchesByModel;
-        std::unordered_map<uint64_t, Engine::ModelHandle> handleByKey;
-
-        for (const auto &ptr : mgr.stores())
+        for (uint32_t sid : matchingStores(mgr))
         {
-            if (!ptr)
-                continue;
-
-            auto &store = *ptr;
-            if (!store.signature().containsAll(required()))
-                continue;
-            if (!store.signature().containsNone(excluded()))
-                continue;
+            const auto &store = *mgr.get(sid);
             if (!store.hasRenderModel())
                 continue;
             if (!store.hasRenderAnimation())
@@ -82,143 +171,524 @@ public:
             if (!store.hasPosition())
                 continue;
 
-            auto &renderModels = store.renderModels();
-            auto &renderAnimations = store.renderAnimations();
-            auto &positions = store.positions();
+            auto renderModels = store.renderModels();
+            auto renderAnimations = store.renderAnimations();
+            auto positions = store.positions();
+            const auto &entities = store.entities();
             const auto &masks = store.rowMasks();
+            const bool filterRows = !store.rowTags().containsNone(excluded());
             const uint32_t n = store.size();
 
             for (uint32_t row = 0; row < n; ++row)
             {
-                if (!masks[row].matches(required(), excluded()))
+                if (filterRows && !masks[row].matches(required(), excluded()))
                     continue;
 
-                const Engine::ModelHandle handle = renderModels[row].handle;
+                // Still-streaming models draw as the placeholder (if one is set).
+                const Engine::ModelHandle handle = m_assets->resolveModel(renderModels[row].handle);
                 Engine::ModelAsset *asset = m_assets->getModel(handle);
                 if (!asset)
                     continue;
 
                 const uint64_t key = keyFromHandle(handle);
-                const auto &anim = renderAnimations[row];
-
-                const auto &pos = positions[row];
-
-                handleByKey[key] = handle;
-
-                auto &batch = batchesByModel[key];
-                if (batch.nodeCount == 0)
+                if (!batchPtr || key != batchKey)
                 {
-                    batch.nodeCount = static_cast<uint32_t>(asset->nodes.size());
-                    batch.nodePalette.reserve(64u * batch.nodeCount);
-
-                    batch.jointCount = asset->totalJointCount;
-                    if (batch.jointCount > 0)
-                        batch.jointPalette.reserve(64u * batch.jointCount);
+                    batchPtr = &batchFor(key, handle, *asset);
+                    batchKey = key;
                 }
+                RenderBatch &batch = *batchPtr;
+                const auto &anim = renderAnimations[row];
+
+                const Engine::ECS::Position pos = (m_history && m_history->valid())
+                                                      ? m_history->interpolate(sid, row, entities[row], positions[row], m_alpha)
+                                                      : positions[row];
 
                 if (batch.nodeCount == 0)
                     continue;
 
-                // World matrix
-                batch.instanceWorlds.emplace_back(glm::translate(glm::mat4(1.0f), glm::vec3(pos.x, pos.y, pos.z)));
+                // Instance worlds are pure translations, so the sphere only moves.
+                const glm::vec3 center = glm::vec3(pos.x, pos.y, pos.z) + glm::vec3(batch.cullSphere);
+                const float radius = batch.cullSphere.w;
+                if (radius > 0.0f)
+                {
+                    const bool outside = m_frustumCulling && !frustum.intersectsSphere(center, radius);
+                    const bool tooFar = m_cullDistance > 0.0f && glm::length(center - cameraPos) - radius > m_cullDistance;
+                    if (outside || tooFar)
+                    {
+                        ++m_culledCount;
+                        continue;
+                    }
+                }
+                ++m_visibleCount;
 
                 const uint32_t safeClip = (!asset->animClips.empty())
                                               ? std::min(anim.clipIndex, static_cast<uint32_t>(asset->animClips.size() - 1))
                                               : 0u;
                 const float timeSec = (!asset->animClips.empty() && anim.playing) ? anim.timeSec : 0.0f;
 
-                // Node palette for this instance
-                asset->evaluatePoseInto(safeClip, timeSec,
-                                        batch.trsScratch,
-                                        batch.localsScratch,
-                                        batch.globalsScratch,
-                                        batch.visitedScratch);
-                if (batch.globalsScratch.size() == batch.nodeCount)
+                if (batch.impostor && radius > 0.0f && batch.impostor->ready() && batch.impostor->baked() &&
+                    projectedSize(radius, glm::length(center - cameraPos), screenScale, orthographic) < m_impostors.screenSize)
                 {
-                    batch.nodePalette.insert(batch.nodePalette.end(), batch.globalsScratch.begin(), batch.globalsScratch.end());
+                    Engine::ImpostorRenderPassModule::Instance sprite;
+                    sprite.position = glm::vec3(pos.x, pos.y, pos.z);
+                    sprite.clip = safeClip;
+                    sprite.timeSec = timeSec;
+                    batch.impostorInstances.push_back(sprite);
+                    ++m_impostorCount;
+                    continue;
                 }
 
-                // Joint palette for this instance
-                if (batch.jointCount > 0 && batch.globalsScratch.size() == batch.nodeCount)
+                // Translation-only instance (compact 32-byte record)
+                Engine::SModelRenderPassModule::CompactInstance instance;
+                instance.position = glm::vec3(pos.x, pos.y, pos.z);
+                batch.instances.push_back(instance);
+
+                if (batch.gpuPoses)
                 {
-                    batch.jointsScratch.assign(batch.jointCount, glm::mat4(1.0f));
+                    Engine::GpuInstanceAnimation state;
+                    state.clip = safeClip;
+                    state.timeSec = timeSec;
+                    batch.instanceAnimation.push_back(state);
+                    continue;
+                }
 
-                    for (const auto &skin : asset->skins)
+                // Pick the pose source by projected size: a pose per (clip, time bucket) every frame,
+                // an own pose every N frames (staggered by entity), or one pose per clip for the batch.
+                const AnimLod lod = (radius > 0.0f) ? selectLod(radius, glm::length(center - cameraPos), screenScale, orthographic)
+                                                    : AnimLod::Full;
+                uint32_t slot = 0;
+                if (lod == AnimLod::Full && m_poseTimeQuantum > 0.0f)
+                {
+                    // Instances whose (clip, time) fall in the same bucket share one palette slot.
+                    const uint32_t bucket = static_cast<uint32_t>(std::max(timeSec, 0.0f) / m_poseTimeQuantum);
+                    const auto ins = slotByPose.try_emplace(PoseKey{&batch, (static_cast<uint64_t>(safeClip) << 32) | bucket}, 0u);
+                    if (ins.second)
                     {
-                        if (skin.jointCount == 0)
-                            continue;
-                        for (uint32_t j = 0; j < skin.jointCount; ++j)
-                        {
-                            if (j >= skin.jointNodeIndices.size() || j >= skin.inverseBind.size())
-                                continue;
-
-                            const uint32_t nodeIx = skin.jointNodeIndices[j];
-                            if (nodeIx >= batch.globalsScratch.size())
-                                continue;
-
-                            const uint32_t outIx = skin.jointBase + j;
-                            if (outIx >= batch.jointsScratch.size())
-                                continue;
-
-                            batch.jointsScratch[outIx] = batch.globalsScratch[nodeIx] * skin.inverseBind[j];
-                        }
+                        evaluatePose(*asset, safeClip, static_cast<float>(bucket) * m_poseTimeQuantum, batch, batch.scratchPose);
+                        ins.first->second = appendPalette(batch, batch.scratchPose);
                     }
-
-                    batch.jointPalette.insert(batch.jointPalette.end(), batch.jointsScratch.begin(), batch.jointsScratch.end());
+                    slot = ins.first->second;
+                }
+                else if (lod == AnimLod::Full)
+                {
+                    evaluatePose(*asset, safeClip, timeSec, batch, batch.scratchPose);
+                    slot = appendPalette(batch, batch.scratchPose);
+                }
+                else if (lod == AnimLod::Reduced)
+                {
+                    const Engine::ECS::Entity e = entities[row];
+                    CachedPose &cached = m_poseCache[e.index];
+                    const uint32_t interval = std::max(1u, m_lod.reducedInterval);
+                    const bool stale = cached.generation != e.generation || cached.modelKey != key ||
+                                       cached.pose.nodes.size() != batch.nodeCount ||
+                                       m_frame - cached.evaluatedFrame >= interval ||
+                                       ((m_frame + e.index) % interval) == 0;
+                    if (stale)
+                    {
+                        evaluatePose(*asset, safeClip, timeSec, batch, cached.pose);
+                        cached.generation = e.generation;
+                        cached.modelKey = key;
+                        cached.evaluatedFrame = m_frame;
+                    }
+                    cached.usedFrame = m_frame;
+                    slot = appendPalette(batch, cached.pose);
                 }
+                else
+                {
+                    // One slot per clip for the whole batch, posed at the first instance's time.
+                    const auto ins = slotByPose.try_emplace(PoseKey{&batch, (static_cast<uint64_t>(safeClip) << 32) | 0xFFFFFFFFull}, 0u);
+                    if (ins.second)
+                    {
+                        evaluatePose(*asset, safeClip, timeSec, batch, batch.scratchPose);
+                        ins.first->second = appendPalette(batch, batch.scratchPose);
+                    }
+                    slot = ins.first->second;
+                }
+                batch.paletteSlots.push_back(slot);
+            }
+        }
+
+        // Update passes of models with instances this frame; disable the rest.
+        for (auto &kv : m_batches)
+        {
+            RenderBatch &batch = kv.second;
+            if (batch.impostor)
+            {
+                const bool sprites = batch.frame == m_frame && !batch.impostorInstances.empty();
+                batch.impostor->setEnabled(sprites);
+                batch.impostor->setInstances(sprites ? batch.impostorInstances.data() : nullptr,
+                                             sprites ? static_cast<uint32_t>(batch.impostorInstances.size()) : 0u);
+            }
+
+            Engine::SModelRenderPassModule &pass = *batch.pass;
+            const auto &instances = batch.instances;
+            if (batch.frame != m_frame || instances.empty())
+            {
+                pass.setEnabled(false);
+                continue;
+            }
+
+            pass.setCamera(m_camera);
+            pass.setEnabled(true);
+            pass.setInstances(instances.data(), static_cast<uint32_t>(instances.size()));
+            pass.setGpuPoses(batch.gpuPoses);
+            if (batch.gpuPoses)
+            {
+                // Palettes are written on the GPU, one slot per instance.
+                pass.setInstanceAnimation(batch.instanceAnimation.data(), static_cast<uint32_t>(batch.instanceAnimation.size()));
+                pass.setPaletteSlots(nullptr, 0);
+                pass.setNodePalette(nullptr, 0, 0);
+                pass.setJointPalette(nullptr, 0, 0);
+                m_paletteEntries += static_cast<uint32_t>(instances.size());
+                continue;
+            }
 
-                (void)asset;
+            pass.setInstanceAnimation(nullptr, 0);
+            pass.setPaletteSlots(batch.paletteSlots.data(), static_cast<uint32_t>(batch.paletteSlots.size()));
+            pass.setNodePalette(batch.nodePalette.data(), batch.paletteCount, batch.nodeCount);
+            if (batch.jointCount > 0)
+            {
+                pass.setJointPalette(batch.jointPalette.data(), batch.paletteCount, batch.jointCount);
             }
+            m_paletteEntries += batch.paletteCount;
         }
 
-        // Create/update passes for models that have instances this frame.
-        for (auto &kv : batchesByModel)
+        // Drop cached poses of entities that have not been drawn at reduced rate for a while.
+        if ((m_frame & 63u) == 0)
+        {
+            for (auto it = m_poseCache.begin(); it != m_poseCache.end();)
+            {
+                if (m_frame - it->second.usedFrame > 64u)
+                    it = m_poseCache.erase(it);
+                else
+                    ++it;
+            }
+        }
+    }
+
+private:
+    // Scene record of one entity (indexed by entity index).
+    struct SceneSlot
+    {
+        uint32_t generation = 0;
+        uint32_t id = Engine::GpuSceneRenderPassModule::kInvalidId;
+        uint32_t seenFrame = 0;
+    };
+
+    void updateScene(Engine::ECS::ArchetypeStoreManager &mgr)
+    {
+        Engine::GpuSceneRenderPassModule &scene = *m_gpuScene;
+
+        // The scene draws everything; the fallback passes stay idle.
+        for (auto &kv : m_batches)
         {
-            const uint64_t key = kv.first;
-            auto &batch = kv.second;
-            auto &worlds = batch.instanceWorlds;
-            if (worlds.empty())
+            kv.second.pass->setEnabled(false);
+            if (kv.second.impostor)
+                kv.second.impostor->setEnabled(false);
+        }
+
+        uint64_t modelKey = 0;
+        uint32_t modelIndex = Engine::GpuSceneRenderPassModule::kInvalidId;
+        bool haveModel = false;
+
+        for (uint32_t sid : matchingStores(mgr))
+        {
+            const auto &store = *mgr.get(sid);
+            if (!store.hasRenderModel() || !store.hasRenderAnimation() || !store.hasPosition())
                 continue;
 
-            const Engine::ModelHandle handle = handleByKey[key];
+            auto renderModels = store.renderModels();
+            auto renderAnimations = store.renderAnimations();
+            auto positions = store.positions();
+            const auto &entities = store.entities();
+            const auto &masks = store.rowMasks();
+            const bool filterRows = !store.rowTags().containsNone(excluded());
+            const uint32_t n = store.size();
+
+            for (uint32_t row = 0; row < n; ++row)
+            {
+                if (filterRows && !masks[row].matches(required(), excluded()))
+                    continue;
+
+                const Engine::ModelHandle handle = m_assets->resolveModel(renderModels[row].handle);
+                Engine::ModelAsset *asset = m_assets->getModel(handle);
+                if (!asset)
+                    continue;
+
+                const uint64_t key = (static_cast<uint64_t>(handle.generation) << 32) | static_cast<uint64_t>(handle.id);
+                if (!haveModel || key != modelKey)
+                {
+                    modelIndex = scene.addModel(handle);
+                    modelKey = key;
+                    haveModel = true;
+                }
+                if (modelIndex == Engine::GpuSceneRenderPassModule::kInvalidId)
+                    continue;
+
+                const auto &anim = renderAnimations[row];
+                const Engine::ECS::Position pos = (m_history && m_history->valid())
+                                                      ? m_history->interpolate(sid, row, entities[row], positions[row], m_alpha)
+                                                      : positions[row];
+
+                Engine::GpuSceneRenderPassModule::Instance instance;
+                instance.position = glm::vec3(pos.x, pos.y, pos.z);
+                instance.model = modelIndex;
+                instance.clip = anim.clipIndex; // clamped on the GPU
+                instance.timeSec = (!asset->animClips.empty() && anim.playing) ? anim.timeSec : 0.0f;
+
+                const Engine::ECS::Entity e = entities[row];
+                if (e.index >= m_sceneSlots.size())
+                    m_sceneSlots.resize(static_cast<size_t>(e.index) + 1);
+                SceneSlot &slot = m_sceneSlots[e.index];
+                if (slot.id != Engine::GpuSceneRenderPassModule::kInvalidId && slot.generation != e.generation)
+                {
+                    scene.removeInstance(slot.id);
+                    slot.id = Engine::GpuSceneRenderPassModule::kInvalidId;
+                }
+                if (slot.id == Engine::GpuSceneRenderPassModule::kInvalidId)
+                    slot.id = scene.addInstance(instance);
+                else
+                    scene.updateInstance(slot.id, instance);
+                slot.generation = e.generation;
+                slot.seenFrame = m_frame;
+            }
+        }
 
-            auto it = m_passes.find(key);
-            if (it == m_passes.end())
+        // Entities that were destroyed, disabled or lost their model since the last update.
+        for (SceneSlot &slot : m_sceneSlots)
+        {
+            if (slot.id != Engine::GpuSceneRenderPassModule::kInvalidId && slot.seenFrame != m_frame)
             {
-                auto pass = std::make_shared<Engine::SModelRenderPassModule>();
-                pass->setAssets(m_assets);
-                pass->setModel(handle);
-                pass->setCamera(m_camera);
-                pass->setEnabled(true);
-                m_renderer->registerPass(pass);
-                it = m_passes.emplace(key, std::move(pass)).first;
+                scene.removeInstance(slot.id);
+                slot.id = Engine::GpuSceneRenderPassModule::kInvalidId;
             }
+        }
+
+        // Culling happens on the GPU: every submitted instance counts as visible.
+        m_visibleCount = scene.instanceCount();
+    }
+
+    enum class AnimLod
+    {
+        Full,
+        Reduced,
+        Shared
+    };
+
+    struct AnimPose
+    {
+        std::vector<glm::mat4> nodes;  // node globals
+        std::vector<glm::mat4> joints; // skin joint matrices (empty if the model has no skins)
+    };
+
+    // Per-model render state, kept across updates so the vectors and maps keep their capacity;
+    // the per-frame contents are cleared the first time a model is seen in an update.
+    struct RenderBatch
+    {
+        std::shared_ptr<Engine::SModelRenderPassModule> pass;
+        uint32_t frame = 0; // m_frame of the last update that reset this batch
+
+        std::vector<Engine::SModelRenderPassModule::CompactInstance> instances; // translation only (32 bytes each)
+
+        // Far instances drawn as sprites (null unless impostors were enabled when the batch was created)
+        std::shared_ptr<Engine::ImpostorRenderPassModule> impostor;
+        std::vector<Engine::ImpostorRenderPassModule::Instance> impostorInstances;
+        std::vector<glm::mat4> nodePalette; // flattened: [slot][node]
+        uint32_t nodeCount = 0;
+
+        std::vector<glm::mat4> jointPalette; // flattened: [slot][joint]
+        uint32_t jointCount = 0;
+
+        // Instance-space bounding sphere (w = 0: model has no bounds, never culled)
+        glm::vec4 cullSphere{0.0f};
 
-            it->second->setCamera(m_camera);
-            it->second->setEnabled(true);
-            it->second->setInstances(worlds.data(), static_cast<uint32_t>(worlds.size()));
-            it->second->setNodePalette(batch.nodePalette.data(), static_cast<uint32_t>(worlds.size()), batch.nodeCount);
+        // Palette slot per instance; palettes hold paletteCount entries.
+        std::vector<uint32_t> paletteSlots;
+        uint32_t paletteCount = 0;
 
-            if (batch.jointCount > 0 && batch.jointPalette.size() == worlds.size() * static_cast<size_t>(batch.jointCount))
+        // GPU poses: one animation record per instance instead of palettes
+        bool gpuPoses = false;
+        std::vector<Engine::GpuInstanceAnimation> instanceAnimation;
+
+        // scratch (reused per instance)
+        std::vector<Engine::ModelAsset::NodeTRS> trsScratch;
+        AnimPose scratchPose;
+    };
+
+    // (batch, clip << 32 | time bucket) -> palette slot; built per update() in FrameArena scratch.
+    struct PoseKey
+    {
+        const RenderBatch *batch;
+        uint64_t pose;
+        bool operator==(const PoseKey &o) const { return batch == o.batch && pose == o.pose; }
+    };
+    struct PoseKeyHash
+    {
+        size_t operator()(const PoseKey &k) const
+        {
+            return std::hash<const void *>{}(k.batch) ^ std::hash<uint64_t>{}(k.pose * 0x9E3779B97F4A7C15ull);
+        }
+    };
+    using PoseSlotMap = std::unordered_map<PoseKey, uint32_t, PoseKeyHash, std::equal_to<PoseKey>,
+                                           Engine::ArenaAllocator<std::pair<const PoseKey, uint32_t>>>;
+
+    struct CachedPose
+    {
+        AnimPose pose;
+        uint32_t generation = 0;
+        uint64_t modelKey = 0;
+        uint32_t evaluatedFrame = 0;
+        uint32_t usedFrame = 0;
+    };
+
+    static float projectedSize(float radius, float distance, float screenScale, bool orthographic)
+    {
+        return orthographic ? radius * screenScale : radius * screenScale / std::max(distance, 1e-3f);
+    }
+
+    AnimLod selectLod(float radius, float distance, float screenScale, bool orthographic) const
+    {
+        if (!m_lod.enabled)
+            return AnimLod::Full;
+        const float size = projectedSize(radius, distance, screenScale, orthographic);
+        if (size >= m_lod.fullRateScreenSize)
+            return AnimLod::Full;
+        if (size >= m_lod.reducedScreenSize || !m_lod.sharedPose)
+            return AnimLod::Reduced;
+        return AnimLod::Shared;
+    }
+
+    template <typename Batch>
+    void evaluatePose(const Engine::ModelAsset &asset, uint32_t clip, float timeSec, Batch &batch, AnimPose &out)
+    {
+        ++m_poseEvaluations;
+        asset.evaluatePoseInto(clip, timeSec, batch.trsScratch, out.nodes);
+
+        out.joints.clear();
+        if (batch.jointCount == 0 || out.nodes.size() != batch.nodeCount)
+            return;
+
+        out.joints.assign(batch.jointCount, glm::mat4(1.0f));
+        for (const auto &skin : asset.skins)
+        {
+            if (skin.jointCount == 0)
+                continue;
+            for (uint32_t j = 0; j < skin.jointCount; ++j)
             {
-                it->second->setJointPalette(batch.jointPalette.data(), static_cast<uint32_t>(worlds.size()), batch.jointCount);
+                if (j >= skin.jointNodeIndices.size() || j >= skin.inverseBind.size())
+                    continue;
+
+                const uint32_t nodeIx = skin.jointNodeIndices[j];
+                if (nodeIx >= out.nodes.size())
+                    continue;
+
+                const uint32_t outIx = skin.jointBase + j;
+                if (outIx >= out.joints.size())
+                    continue;
+
+                out.joints[outIx] = out.nodes[nodeIx] * skin.inverseBind[j];
             }
         }
+    }
+
+    // Append one palette entry (node globals + joints) and return its slot. Invalid poses get identities.
+    template <typename Batch>
+    static uint32_t appendPalette(Batch &batch, const AnimPose &pose)
+    {
+        const bool valid = pose.nodes.size() == batch.nodeCount;
+        if (valid)
+            batch.nodePalette.insert(batch.nodePalette.end(), pose.nodes.begin(), pose.nodes.end());
+        else
+            batch.nodePalette.insert(batch.nodePalette.end(), batch.nodeCount, glm::mat4(1.0f));
 
-        // Disable passes that have no instances this frame.
-        for (auto &kv : m_passes)
+        if (batch.jointCount > 0)
         {
-            if (batchesByModel.find(kv.first) == batchesByModel.end())
+            if (valid && pose.joints.size() == batch.jointCount)
+                batch.jointPalette.insert(batch.jointPalette.end(), pose.joints.begin(), pose.joints.end());
+            else
+                batch.jointPalette.insert(batch.jointPalette.end(), batch.jointCount, glm::mat4(1.0f));
+        }
+        return batch.paletteCount++;
+    }
+
+    RenderBatch &batchFor(uint64_t key, const Engine::ModelHandle &handle, const Engine::ModelAsset &asset)
+    {
+        auto it = m_batches.find(key);
+        if (it == m_batches.end())
+        {
+            auto pass = std::make_shared<Engine::SModelRenderPassModule>();
+            pass->setAssets(m_assets);
+            pass->setModel(handle);
+            pass->setCamera(m_camera);
+            pass->setEnabled(false);
+            pass->setGpuCulling(true);
+            pass->setInstanceFormat(Engine::SModelRenderPassModule::InstanceFormat::Compact);
+            pass->setDeviceLocalUploads(true);
+            pass->setDebugName("SModel #" + std::to_string(handle.id));
+            m_renderer->registerPass(pass);
+            it = m_batches.emplace(key, RenderBatch{}).first;
+            it->second.pass = std::move(pass);
+            it->second.frame = m_frame - 1;
+
+            if (m_impostors.enabled)
             {
-                kv.second->setEnabled(false);
+                auto impostor = std::make_shared<Engine::ImpostorRenderPassModule>();
+                impostor->setAssets(m_assets);
+                impostor->setModel(handle);
+                impostor->setCamera(m_camera);
+                impostor->setEnabled(false);
+                impostor->setSettings(m_impostors.bake);
+                impostor->setDebugName("Impostors #" + std::to_string(handle.id));
+                m_renderer->registerPass(impostor);
+                it->second.impostor = std::move(impostor);
             }
         }
+
+        RenderBatch &batch = it->second;
+        if (batch.frame != m_frame)
+        {
+            batch.frame = m_frame;
+            batch.instances.clear();
+            batch.impostorInstances.clear();
+            batch.nodePalette.clear();
+            batch.jointPalette.clear();
+            batch.paletteSlots.clear();
+            batch.paletteCount = 0;
+            batch.instanceAnimation.clear();
+
+            batch.nodeCount = static_cast<uint32_t>(asset.nodes.size());
+            batch.jointCount = asset.totalJointCount;
+            batch.cullSphere = batch.pass->instanceBoundingSphere();
+            batch.gpuPoses = m_gpuSkinning && batch.pass->gpuPosesAvailable() && Engine::GpuPoseEvaluator::supports(asset);
+        }
+        return batch;
     }
 
-private:
     Engine::AssetManager *m_assets = nullptr; // not owned
     Engine::Renderer *m_renderer = nullptr;   // not owned
     Engine::Camera *m_camera = nullptr;       // not owned
 
-    std::unordered_map<uint64_t, std::shared_ptr<Engine::SModelRenderPassModule>> m_passes;
+    const Engine::ECS::PositionHistory *m_history = nullptr; // not owned
+    float m_alpha = 1.0f;
+
+    bool m_frustumCulling = true;
+    float m_cullDistance = 0.0f;
+    bool m_gpuSkinning = false;
+    uint32_t m_visibleCount = 0;
+    uint32_t m_culledCount = 0;
+    uint32_t m_impostorCount = 0;
+
+    AnimationLodPolicy m_lod;
+    ImpostorPolicy m_impostors;
+    std::unordered_map<uint32_t, CachedPose> m_poseCache; // by entity index (reduced-rate instances)
+    uint32_t m_frame = 0;
+    uint32_t m_poseEvaluations = 0;
+    uint32_t m_paletteEntries = 0;
+    float m_poseTimeQuantum = 1.0f / 30.0f;
+
+    std::unordered_map<uint64_t, RenderBatch> m_batches; // by model handle (generation << 32 | id)
+
+    bool m_gpuSceneEnabled = false;
+    std::shared_ptr<Engine::GpuSceneRenderPassModule> m_gpuScene;
+    std::vector<SceneSlot> m_sceneSlots;
 };
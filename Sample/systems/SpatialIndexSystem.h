@@ -10,17 +10,46 @@
 
   Usage:
     - Construct the system, setCellSize(R), and call buildMasks(registry) once (requires "Position").
+    - Optionally setWorldBounds(minX, minZ, maxX, maxZ) (+ setIncremental(true)) for the flat grid.
     - Call update(stores, dt) each frame to rebuild the grid.
     - LocalAvoidanceSystem (or other systems) can call forNeighbors(x, y, fn) to visit candidate neighbors.
+    - Picking / box selection call forCellsInRect(minX, minZ, maxX, maxZ, fn) to visit only the cells
+      overlapping a ground-plane rectangle, testing each cell's bounds before its entries.
+    - Gameplay (target acquisition, auras) uses the bounded-mode queries, filtered by a Team mask:
+        forEachInRadius(x, z, 30.0f, teamBit(myTeam), fn)           // allies within 30 m, any cell span
+        nearest(x, z, 12.0f, kAllTeams & ~teamBit(myTeam), self)     // closest enemy within 12 m
+        kNearest(x, z, 8, 50.0f, kAllTeams, hits)                    // 8 closest, sorted by distance
 
   Notes:
-    - This is stateless across frames: we rebuild the grid each frame (simple and fast for RTS scales).
+    - Default (unbounded) mode rebuilds a hash grid each frame (simple, no world size needed).
+    - Bounded mode (setWorldBounds) bins into a flat cell array with a counting sort:
+      one offsets array (cells + 1) and one packed entry array, so the 3 cells of each
+      neighbor row are a single contiguous range. Positions outside the bounds clamp to edge cells.
+    - Bounded + setIncremental(true): when no entity changed cell and the store populations are
+      unchanged, the previous binning is kept and the scatter pass is skipped. With unchanged
+      populations only rows whose Position or Team was written since the last build are re-binned
+      (ArchetypeStore change versions).
     - The grid stores (storeId, row) pairs so you can access components back in ArchetypeStoreManager.
+    - Bounded mode also packs a SoA snapshot (x, z, radius, separation, vx, vz, entity) in cell
+      order; forNeighborRanges() hands out contiguous index ranges into it so neighbor loops
+      stream through memory instead of chasing (storeId, row) into every store.
+    - Bounded mode also flags cells holding a moving entity; motionNear() tests a 3x3 block of them.
+    - kNearest()/nearest() expand rings of cells around the query cell and stop once no unvisited cell
+      can hold anything closer than the current k-th hit (or maxRadius is passed).
+    - setTeamBuckets(n) additionally orders every cell's entries by team, so team-filtered queries
+      skip whole runs of non-matching entries instead of testing each one.
+    - Bounded mode with a worker pool and at least ParallelBuildMinEntities entities runs every pass
+      in parallel (cell IDs, atomic counts, blocked prefix sum, scatter, snapshot copy). Cells are
+      re-sorted by store/row order after the scatter, so the packed order matches the serial build.
 */
 
 #include "ECS/SystemFormat.h"
 #include "ECS/Components.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include <cmath>
 #include <cstdint>
@@ -60,6 +89,49 @@ struct GridCell
     std::vector<GridEntry> entries;
 };
 
+// Faction of a unit, for team-filtered spatial queries. Ids 0..31; units without one are team 0.
+struct Team
+{
+    uint8_t id = 0;
+};
+
+static constexpr uint32_t kAllTeams = 0xFFFFFFFFu; // team mask matching every team
+inline constexpr uint32_t teamBit(uint32_t id) { return 1u << (id & 31u); }
+
+// Query result: index into SpatialIndexSystem::entries() / snapshot(), squared ground distance.
+struct SpatialHit
+{
+    uint32_t index = UINT32_MAX;
+    float dist2 = 0.0f;
+
+    bool valid() const { return index != UINT32_MAX; }
+};
+
+// Per-entry copies packed in grid order (bounded mode). Index i matches SpatialIndexSystem::entries()[i].
+struct SpatialSnapshot
+{
+    std::vector<float> x;
+    std::vector<float> z;
+    std::vector<float> radius;     // negative if the entity has no Radius
+    std::vector<float> separation; // 0 if the entity has no Separation
+    std::vector<float> vx;
+    std::vector<float> vz;
+    std::vector<uint8_t> team; // Team::id, 0 if the entity has no Team
+    std::vector<Engine::ECS::Entity> entity;
+
+    void resize(size_t n)
+    {
+        x.resize(n);
+        z.resize(n);
+        radius.resize(n);
+        separation.resize(n);
+        vx.resize(n);
+        vz.resize(n);
+        team.resize(n);
+        entity.resize(n);
+    }
+};
+
 class SpatialIndexSystem : public Engine::ECS::SystemBase
 {
 public:
@@ -68,44 +140,91 @@ public:
     {
         setRequiredNames({"Position"}); // we index any entity that has Position
         // You may set excluded tags if desired: setExcludedNames({"Disabled","Dead"});
+        setReadNames({"Position", "Velocity", "Radius", "Separation", "Team"}); // snapshot copies
+        setWriteNames({"SpatialGrid"});                                   // shared resource read by neighbor queries
     }
 
     const char *name() const override { return "SpatialIndexSystem"; }
 
-    void setCellSize(float cellSize) { m_cellSize = (cellSize > 1e-6f) ? cellSize : 1e-6f; }
+    void buildMasks(Engine::ECS::ComponentRegistry &registry) override
+    {
+        SystemBase::buildMasks(registry);
+        // Columns an entity's sort key depends on (incremental re-binning).
+        m_binColumns = required();
+        m_binColumns.set(registry.ensureId("Team"));
+    }
+
+    void setCellSize(float cellSize)
+    {
+        m_cellSize = (cellSize > 1e-6f) ? cellSize : 1e-6f;
+        m_prevPopulation.clear();
+    }
     float getCellSize() const { return m_cellSize; }
 
-    // Rebuild the spatial hash grid for all entities with Position
+    // Switch to the flat bounded grid covering [minX, maxX] x [minZ, maxZ] (meters).
+    void setWorldBounds(float minX, float minZ, float maxX, float maxZ)
+    {
+        m_bounded = (maxX > minX) && (maxZ > minZ);
+        m_minX = minX;
+        m_minZ = minZ;
+        m_maxX = maxX;
+        m_maxZ = maxZ;
+        m_prevPopulation.clear(); // force a full re-bin
+    }
+
+    void clearWorldBounds()
+    {
+        m_bounded = false;
+        m_prevPopulation.clear();
+    }
+
+    bool bounded() const { return m_bounded; }
+
+    // Bounded mode: the configured world rectangle (meters).
+    void worldBounds(float &minX, float &minZ, float &maxX, float &maxZ) const
+    {
+        minX = m_minX;
+        minZ = m_minZ;
+        maxX = m_maxX;
+        maxZ = m_maxZ;
+    }
+
+    // Bounded mode only: skip re-binning on frames where no entity crossed a cell boundary.
+    void setIncremental(bool incremental)
+    {
+        m_incremental = incremental;
+        m_prevPopulation.clear();
+    }
+
+    // Bounded mode: order each cell's entries by team (ids 0..teams-2 get their own run, the rest
+    // share the last). 0 or 1 turns bucketing off; at most 32.
+    void setTeamBuckets(uint32_t teams)
+    {
+        m_teamBuckets = std::min(std::max(teams, 1u), 32u);
+        m_prevPopulation.clear();
+    }
+    uint32_t teamBuckets() const { return m_teamBuckets; }
+
+    // Rebuild the spatial grid for all entities with Position
     void update(Engine::ECS::ArchetypeStoreManager &mgr, float /*dt*/) override
     {
+        if (m_bounded)
+        {
+            buildFlat(mgr);
+            return;
+        }
+
         // Clear grid but keep capacity to minimize allocations
         for (auto &kv : m_grid)
             kv.second.entries.clear();
         // Optional: if entity count changes wildly, you can occasionally m_grid.clear()
 
         // Iterate stores with Position
-        uint32_t sid = 0;
-        for (const auto &ptr : mgr.stores())
+        for (uint32_t sid : matchingStores(mgr))
         {
-            if (!ptr)
-            {
-                ++sid;
-                continue;
-            }
-            const auto &store = *ptr;
+            const auto &store = *mgr.get(sid);
 
-            if (!store.signature().containsAll(required()))
-            {
-                ++sid;
-                continue;
-            }
-            if (!store.signature().containsNone(excluded()))
-            {
-                ++sid;
-                continue;
-            }
-
-            const auto &positions = store.positions();
+            const auto positions = store.positions();
             const uint32_t n = store.size();
 
             // Reserve a bit for typical occupancy of cells if you know it; otherwise skip.
@@ -118,8 +237,6 @@ public:
                 auto &cell = m_grid[key]; // creates if missing
                 cell.entries.push_back(GridEntry{sid, row});
             }
-
-            ++sid;
         }
     }
 
@@ -128,6 +245,25 @@ public:
     template <typename Visitor>
     void forNeighbors(float x, float z, Visitor &&visit) const
     {
+        if (m_bounded)
+        {
+            if (m_cellStart.empty())
+                return;
+            const int gx = cellX(x);
+            const int gz = cellZ(z);
+            const int x0 = std::max(gx - 1, 0);
+            const int x1 = std::min(gx + 1, m_cellsX - 1);
+            for (int cz = std::max(gz - 1, 0); cz <= std::min(gz + 1, m_cellsZ - 1); ++cz)
+            {
+                // Cells x0..x1 of one grid row are adjacent in the packed array.
+                const uint32_t begin = m_cellStart[static_cast<size_t>(cz) * m_cellsX + x0];
+                const uint32_t end = m_cellStart[static_cast<size_t>(cz) * m_cellsX + x1 + 1];
+                for (uint32_t i = begin; i < end; ++i)
+                    visit(m_entries[i].storeId, m_entries[i].row);
+            }
+            return;
+        }
+
         const int gx = static_cast<int>(std::floor(x / m_cellSize));
         const int gz = static_cast<int>(std::floor(z / m_cellSize));
         for (int dx = -1; dx <= 1; ++dx)
@@ -144,10 +280,691 @@ public:
         }
     }
 
+    // True if any entity in the 3x3 cells around (x, z) had a nonzero velocity when the grid was
+    // built (LocalAvoidanceSystem skips resting units in quiet neighborhoods). Always true unbounded.
+    bool motionNear(float x, float z) const
+    {
+        if (!m_bounded || m_cellMoving.empty())
+            return true;
+        const int gx = cellX(x);
+        const int gz = cellZ(z);
+        const int x0 = std::max(gx - 1, 0);
+        const int x1 = std::min(gx + 1, m_cellsX - 1);
+        for (int cz = std::max(gz - 1, 0); cz <= std::min(gz + 1, m_cellsZ - 1); ++cz)
+        {
+            for (int cx = x0; cx <= x1; ++cx)
+            {
+                if (m_cellMoving[static_cast<size_t>(cz) * m_cellsX + cx])
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // Bounded mode: visit(snapshot, begin, end) once per contiguous candidate range around (x,z)
+    // (up to 3 ranges). Falls back to nothing in unbounded mode; check bounded() first.
+    template <typename Visitor>
+    void forNeighborRanges(float x, float z, Visitor &&visit) const
+    {
+        if (!m_bounded || m_cellStart.empty())
+            return;
+        const int gx = cellX(x);
+        const int gz = cellZ(z);
+        const int x0 = std::max(gx - 1, 0);
+        const int x1 = std::min(gx + 1, m_cellsX - 1);
+        for (int cz = std::max(gz - 1, 0); cz <= std::min(gz + 1, m_cellsZ - 1); ++cz)
+        {
+            const uint32_t begin = m_cellStart[static_cast<size_t>(cz) * m_cellsX + x0];
+            const uint32_t end = m_cellStart[static_cast<size_t>(cz) * m_cellsX + x1 + 1];
+            if (begin < end)
+                visit(m_snapshot, begin, end);
+        }
+    }
+
+    // Bounded mode: visit(index, dist2) for every entity of a team in 'teamMask' within 'radius' of
+    // (x, z) on the ground plane, over as many cells as the radius spans. Nothing in unbounded mode.
+    template <typename Visitor>
+    void forEachInRadius(float x, float z, float radius, uint32_t teamMask, Visitor &&visit) const
+    {
+        if (!m_bounded || m_cellStart.empty() || !(radius >= 0.0f))
+            return;
+        const float r2 = radius * radius;
+        const int x0 = cellX(x - radius), x1 = cellX(x + radius);
+        for (int cz = cellZ(z - radius); cz <= cellZ(z + radius); ++cz)
+        {
+            forRowRanges(cz, x0, x1, teamMask, [&](uint32_t begin, uint32_t end)
+                         {
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    if (!(teamMask & teamBit(m_snapshot.team[i])))
+                        continue;
+                    const float dx = m_snapshot.x[i] - x;
+                    const float dz = m_snapshot.z[i] - z;
+                    const float d2 = dx * dx + dz * dz;
+                    if (d2 <= r2)
+                        visit(i, d2);
+                } });
+        }
+    }
+
+    // Bounded mode: the entity of a team in 'teamMask' closest to (x, z) within 'maxRadius', other
+    // than 'skip'. Ties go to the lower index. Invalid hit if there is none (or unbounded).
+    SpatialHit nearest(float x, float z, float maxRadius, uint32_t teamMask, Engine::ECS::Entity skip = {}) const
+    {
+        SpatialHit best;
+        ringSearch(x, z, maxRadius, teamMask, skip, [&](uint32_t i, float d2)
+                   {
+                       if (!best.valid() || d2 < best.dist2 || (d2 == best.dist2 && i < best.index))
+                           best = SpatialHit{i, d2};
+                   },
+                   [&](float bound2)
+                   { return best.valid() && best.dist2 <= bound2; });
+        return best;
+    }
+
+    // Bounded mode: up to k closest matches as nearest() does, written to 'out' nearest first.
+    // Returns out.size().
+    uint32_t kNearest(float x, float z, uint32_t k, float maxRadius, uint32_t teamMask, std::vector<SpatialHit> &out,
+                      Engine::ECS::Entity skip = {}) const
+    {
+        out.clear();
+        if (k == 0)
+            return 0;
+        // Max-heap on (dist2, index): the front is the k-th best so far.
+        auto closer = [](const SpatialHit &a, const SpatialHit &b)
+        { return a.dist2 < b.dist2 || (a.dist2 == b.dist2 && a.index < b.index); };
+        ringSearch(x, z, maxRadius, teamMask, skip, [&](uint32_t i, float d2)
+                   {
+                       const SpatialHit hit{i, d2};
+                       if (out.size() < k)
+                       {
+                           out.push_back(hit);
+                           std::push_heap(out.begin(), out.end(), closer);
+                       }
+                       else if (closer(hit, out.front()))
+                       {
+                           std::pop_heap(out.begin(), out.end(), closer);
+                           out.back() = hit;
+                           std::push_heap(out.begin(), out.end(), closer);
+                       }
+                   },
+                   [&](float bound2)
+                   { return out.size() == k && out.front().dist2 <= bound2; });
+        std::sort_heap(out.begin(), out.end(), closer);
+        return static_cast<uint32_t>(out.size());
+    }
+
+    // Visit every non-empty cell overlapping [minX, maxX] x [minZ, maxZ] (meters) as
+    // visit(cellMinX, cellMinZ, cellMaxX, cellMaxZ, const GridEntry *begin, const GridEntry *end).
+    // Bounded mode: edge cells also hold the clamped entities outside the bounds, so their rectangle
+    // is widened to cover them. Entries are from the last update(): rows can be stale if stores
+    // changed structurally since, so check row < store.size() before reading.
+    template <typename Visitor>
+    void forCellsInRect(float minX, float minZ, float maxX, float maxZ, Visitor &&visit) const
+    {
+        if (maxX < minX || maxZ < minZ)
+            return;
+
+        if (m_bounded)
+        {
+            if (m_cellStart.empty())
+                return;
+            constexpr float kUnbounded = 1e30f;
+            const int x0 = cellX(minX), x1 = cellX(maxX);
+            const int z0 = cellZ(minZ), z1 = cellZ(maxZ);
+            for (int cz = z0; cz <= z1; ++cz)
+            {
+                const float cellMinZ = cz == 0 ? -kUnbounded : m_minZ + static_cast<float>(cz) * m_cellSize;
+                const float cellMaxZ = cz == m_cellsZ - 1 ? kUnbounded : m_minZ + static_cast<float>(cz + 1) * m_cellSize;
+                for (int cx = x0; cx <= x1; ++cx)
+                {
+                    const size_t c = static_cast<size_t>(cz) * m_cellsX + cx;
+                    const uint32_t begin = m_cellStart[c];
+                    const uint32_t end = m_cellStart[c + 1];
+                    if (begin == end)
+                        continue;
+                    const float cellMinX = cx == 0 ? -kUnbounded : m_minX + static_cast<float>(cx) * m_cellSize;
+                    const float cellMaxX = cx == m_cellsX - 1 ? kUnbounded : m_minX + static_cast<float>(cx + 1) * m_cellSize;
+                    visit(cellMinX, cellMinZ, cellMaxX, cellMaxZ, m_entries.data() + begin, m_entries.data() + end);
+                }
+            }
+            return;
+        }
+
+        const int gx0 = static_cast<int>(std::floor(minX / m_cellSize));
+        const int gx1 = static_cast<int>(std::floor(maxX / m_cellSize));
+        const int gz0 = static_cast<int>(std::floor(minZ / m_cellSize));
+        const int gz1 = static_cast<int>(std::floor(maxZ / m_cellSize));
+        auto visitCell = [&](const GridKey &key, const GridCell &cell)
+        {
+            if (cell.entries.empty())
+                return;
+            const float cellMinX = static_cast<float>(key.gx) * m_cellSize;
+            const float cellMinZ = static_cast<float>(key.gz) * m_cellSize;
+            visit(cellMinX, cellMinZ, cellMinX + m_cellSize, cellMinZ + m_cellSize,
+                  cell.entries.data(), cell.entries.data() + cell.entries.size());
+        };
+
+        // Large rectangles: walking the occupied cells beats hashing every key in range.
+        const double area = (static_cast<double>(gx1) - gx0 + 1.0) * (static_cast<double>(gz1) - gz0 + 1.0);
+        if (area > static_cast<double>(m_grid.size()))
+        {
+            for (const auto &kv : m_grid)
+            {
+                if (kv.first.gx >= gx0 && kv.first.gx <= gx1 && kv.first.gz >= gz0 && kv.first.gz <= gz1)
+                    visitCell(kv.first, kv.second);
+            }
+            return;
+        }
+        for (int gz = gz0; gz <= gz1; ++gz)
+        {
+            for (int gx = gx0; gx <= gx1; ++gx)
+            {
+                const GridKey key{gx, gz};
+                auto it = m_grid.find(key);
+                if (it != m_grid.end())
+                    visitCell(key, it->second);
+            }
+        }
+    }
+
+    // Bounded mode: packed entries and their snapshot (same indexing).
+    const std::vector<GridEntry> &entries() const { return m_entries; }
+    const SpatialSnapshot &snapshot() const { return m_snapshot; }
+
     // Optional: expose direct cell access if needed
     const std::unordered_map<GridKey, GridCell, GridKeyHash> &grid() const { return m_grid; }
 
 private:
+    int cellX(float x) const
+    {
+        const int c = static_cast<int>(std::floor((x - m_minX) / m_cellSize));
+        return std::min(std::max(c, 0), m_cellsX - 1);
+    }
+
+    int cellZ(float z) const
+    {
+        const int c = static_cast<int>(std::floor((z - m_minZ) / m_cellSize));
+        return std::min(std::max(c, 0), m_cellsZ - 1);
+    }
+
+    // fn(begin, end) over the packed ranges of grid row cz, columns x0..x1. With team buckets only the
+    // runs of teams in 'teamMask' are handed out (adjacent runs merged); entries still need a team test
+    // because the last bucket holds every id past it.
+    template <typename Fn>
+    void forRowRanges(int cz, int x0, int x1, uint32_t teamMask, Fn &&fn) const
+    {
+        const size_t rowBase = static_cast<size_t>(cz) * static_cast<size_t>(m_cellsX);
+        if (m_teamBuckets <= 1 || teamMask == kAllTeams)
+        {
+            const uint32_t begin = m_cellStart[rowBase + x0];
+            const uint32_t end = m_cellStart[rowBase + x1 + 1];
+            if (begin < end)
+                fn(begin, end);
+            return;
+        }
+
+        const uint32_t teams = m_teamBuckets;
+        uint32_t runBegin = 0, runEnd = 0;
+        for (int cx = x0; cx <= x1; ++cx)
+        {
+            const size_t bucket = (rowBase + static_cast<size_t>(cx)) * teams;
+            for (uint32_t t = 0; t < teams; ++t)
+            {
+                const uint32_t bits = (t + 1 < teams) ? teamBit(t) : (~0u << t);
+                const uint32_t begin = m_bucketStart[bucket + t];
+                const uint32_t end = m_bucketStart[bucket + t + 1];
+                if (!(teamMask & bits) || begin == end)
+                    continue;
+                if (begin != runEnd)
+                {
+                    if (runBegin < runEnd)
+                        fn(runBegin, runEnd);
+                    runBegin = begin;
+                }
+                runEnd = end;
+            }
+        }
+        if (runBegin < runEnd)
+            fn(runBegin, runEnd);
+    }
+
+    // Ring expansion shared by nearest() / kNearest(): consider(index, dist2) for matches within
+    // maxRadius, ring by ring around the query cell; stops when settled(bound^2) says no unvisited
+    // cell can beat the current hits. The bound is measured from the query point clamped into the
+    // grid, against which clamped (out-of-bounds) entities are never closer than in reality.
+    template <typename Consider, typename Settled>
+    void ringSearch(float x, float z, float maxRadius, uint32_t teamMask, Engine::ECS::Entity skip,
+                    Consider &&consider, Settled &&settled) const
+    {
+        if (!m_bounded || m_cellStart.empty() || !(maxRadius >= 0.0f))
+            return;
+        const float maxR2 = maxRadius * maxRadius;
+        const int gx = cellX(x);
+        const int gz = cellZ(z);
+
+        const float cellMinX = m_minX + static_cast<float>(gx) * m_cellSize;
+        const float cellMinZ = m_minZ + static_cast<float>(gz) * m_cellSize;
+        const float px = std::min(std::max(x, cellMinX), cellMinX + m_cellSize);
+        const float pz = std::min(std::max(z, cellMinZ), cellMinZ + m_cellSize);
+        const float inner = std::min(std::min(px - cellMinX, cellMinX + m_cellSize - px),
+                                     std::min(pz - cellMinZ, cellMinZ + m_cellSize - pz));
+
+        auto scan = [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                if (!(teamMask & teamBit(m_snapshot.team[i])))
+                    continue;
+                const float dx = m_snapshot.x[i] - x;
+                const float dz = m_snapshot.z[i] - z;
+                const float d2 = dx * dx + dz * dz;
+                if (d2 > maxR2)
+                    continue;
+                const Engine::ECS::Entity e = m_snapshot.entity[i];
+                if (skip.valid() && e.index == skip.index && e.generation == skip.generation)
+                    continue;
+                consider(i, d2);
+            }
+        };
+
+        const int maxRing = std::max(std::max(gx, m_cellsX - 1 - gx), std::max(gz, m_cellsZ - 1 - gz));
+        for (int r = 0; r <= maxRing; ++r)
+        {
+            const int x0 = std::max(gx - r, 0);
+            const int x1 = std::min(gx + r, m_cellsX - 1);
+            if (gz - r >= 0)
+                forRowRanges(gz - r, x0, x1, teamMask, scan);
+            if (r > 0 && gz + r < m_cellsZ)
+                forRowRanges(gz + r, x0, x1, teamMask, scan);
+            for (int cz = std::max(gz - r + 1, 0); cz <= std::min(gz + r - 1, m_cellsZ - 1); ++cz)
+            {
+                if (gx - r >= 0)
+                    forRowRanges(cz, gx - r, gx - r, teamMask, scan);
+                if (gx + r < m_cellsX)
+                    forRowRanges(cz, gx + r, gx + r, teamMask, scan);
+            }
+
+            const float bound = static_cast<float>(r) * m_cellSize + inner;
+            if (bound > maxRadius || settled(bound * bound))
+                return;
+        }
+    }
+
+    // Counting-sort build of the flat grid: count per cell, prefix sum, stable scatter.
+    // With a worker pool and enough entities every pass runs in parallel (buildFlatParallel).
+    void buildFlat(Engine::ECS::ArchetypeStoreManager &mgr)
+    {
+        const int cellsX = std::max(1, static_cast<int>(std::ceil((m_maxX - m_minX) / m_cellSize)));
+        const int cellsZ = std::max(1, static_cast<int>(std::ceil((m_maxZ - m_minZ) / m_cellSize)));
+        const bool resized = (cellsX != m_cellsX) || (cellsZ != m_cellsZ);
+        m_cellsX = cellsX;
+        m_cellsZ = cellsZ;
+        const size_t cellCount = static_cast<size_t>(cellsX) * static_cast<size_t>(cellsZ);
+        // Sort key: the cell, or (cell, team bucket) with team buckets on.
+        const size_t bucketCount = cellCount * m_teamBuckets;
+        std::vector<uint32_t> &starts = (m_teamBuckets > 1) ? m_bucketStart : m_cellStart;
+
+        // Pass 1: sort key per entity (in store/row order) and population signature.
+        m_population.clear();
+        for (uint32_t sid : matchingStores(mgr))
+            m_population.emplace_back(sid, mgr.get(sid)->size());
+        const uint32_t total = populationBases(m_population, m_popBase);
+        const uint32_t since = m_seenVersion;
+        m_seenVersion = mgr.advanceChangeVersion();
+        m_binned.resize(total);
+        m_binCell.resize(total);
+        Engine::ECS::WorkerPool *pool = (total >= ParallelBuildMinEntities) ? workerPool() : nullptr;
+        if (m_incremental && !resized && m_population == m_prevPopulation && m_seenStores == &mgr)
+        {
+            // Same stores and sizes as the last build: start from its keys.
+            m_binCell = m_prevBinCell;
+            rebinChanged(mgr, since, pool);
+        }
+        else
+        {
+            forEntityChunks(pool, total, [&](uint32_t begin, uint32_t end)
+                            { binRange(mgr, begin, end); });
+        }
+        m_seenStores = &mgr;
+
+        if (m_incremental && !resized && m_population == m_prevPopulation && m_binCell == m_prevBinCell)
+        {
+            // Same entities in the same cells: keep the packed arrays, refresh the copies.
+            fillSnapshot(mgr);
+            return;
+        }
+
+        if (pool)
+        {
+            buildFlatParallel(*pool, starts, bucketCount);
+        }
+        else
+        {
+            // Pass 2: counts -> inclusive prefix (bucket end offsets).
+            starts.assign(bucketCount + 1, 0u);
+            for (uint32_t c : m_binCell)
+                ++starts[c];
+            uint32_t running = 0;
+            for (size_t c = 0; c < bucketCount; ++c)
+            {
+                running += starts[c];
+                starts[c] = running;
+            }
+            starts[bucketCount] = running;
+
+            // Pass 3: scatter backwards; each decrement leaves starts[c] at the bucket's first entry.
+            m_entries.resize(m_binned.size());
+            m_slot.resize(m_binned.size());
+            for (size_t i = m_binned.size(); i-- > 0;)
+            {
+                const uint32_t slot = --starts[m_binCell[i]];
+                m_entries[slot] = m_binned[i];
+                m_slot[i] = slot;
+            }
+        }
+
+        if (m_teamBuckets > 1)
+        {
+            // A cell starts at its first team bucket.
+            m_cellStart.resize(cellCount + 1);
+            for (size_t c = 0; c <= cellCount; ++c)
+                m_cellStart[c] = m_bucketStart[c * m_teamBuckets];
+        }
+
+        if (m_incremental)
+        {
+            std::swap(m_prevPopulation, m_population);
+            std::swap(m_prevBinCell, m_binCell);
+        }
+
+        fillSnapshot(mgr);
+    }
+
+    // Passes 2 and 3 on the pool, over 'cellCount' sort keys (cells or team buckets). Counts and
+    // scatter cursors are atomic; the scatter leaves each cell in arbitrary order, so every cell is
+    // then sorted by pass-1 index. The result is identical to the serial build for any worker count.
+    void buildFlatParallel(Engine::ECS::WorkerPool &pool, std::vector<uint32_t> &starts, size_t cellCount)
+    {
+        const uint32_t total = static_cast<uint32_t>(m_binCell.size());
+        const uint32_t cells = static_cast<uint32_t>(cellCount);
+        if (m_cursorCount < cellCount)
+        {
+            m_cursor.reset(new std::atomic<uint32_t>[cellCount]);
+            m_cursorCount = cellCount;
+        }
+
+        // Pass 2: per-cell counts.
+        pool.parallelFor(cells, ParallelCellGrain, [&](uint32_t begin, uint32_t end)
+                         {
+            for (uint32_t c = begin; c < end; ++c)
+                m_cursor[c].store(0, std::memory_order_relaxed); });
+        pool.parallelFor(total, ParallelEntityGrain, [&](uint32_t begin, uint32_t end)
+                         {
+            for (uint32_t i = begin; i < end; ++i)
+                m_cursor[m_binCell[i]].fetch_add(1, std::memory_order_relaxed); });
+
+        // Exclusive prefix sum in blocks: block totals, a short serial scan over them, then
+        // each block writes its cells' start offsets (and seeds the scatter cursors with them).
+        const uint32_t blocks = (cells + ParallelCellGrain - 1) / ParallelCellGrain;
+        m_blockStart.assign(blocks + 1, 0u);
+        pool.parallelFor(blocks, 1, [&](uint32_t begin, uint32_t end)
+                         {
+            for (uint32_t b = begin; b < end; ++b)
+            {
+                const uint32_t c1 = std::min(cells, (b + 1) * ParallelCellGrain);
+                uint32_t sum = 0;
+                for (uint32_t c = b * ParallelCellGrain; c < c1; ++c)
+                    sum += m_cursor[c].load(std::memory_order_relaxed);
+                m_blockStart[b + 1] = sum;
+            } });
+        for (uint32_t b = 0; b < blocks; ++b)
+            m_blockStart[b + 1] += m_blockStart[b];
+
+        starts.resize(cellCount + 1);
+        pool.parallelFor(blocks, 1, [&](uint32_t begin, uint32_t end)
+                         {
+            for (uint32_t b = begin; b < end; ++b)
+            {
+                const uint32_t c1 = std::min(cells, (b + 1) * ParallelCellGrain);
+                uint32_t running = m_blockStart[b];
+                for (uint32_t c = b * ParallelCellGrain; c < c1; ++c)
+                {
+                    const uint32_t count = m_cursor[c].load(std::memory_order_relaxed);
+                    starts[c] = running;
+                    m_cursor[c].store(running, std::memory_order_relaxed);
+                    running += count;
+                }
+            } });
+        starts[cellCount] = total;
+
+        // Pass 3: scatter pass-1 indices, then restore pass-1 order inside each cell.
+        m_order.resize(total);
+        pool.parallelFor(total, ParallelEntityGrain, [&](uint32_t begin, uint32_t end)
+                         {
+            for (uint32_t i = begin; i < end; ++i)
+                m_order[m_cursor[m_binCell[i]].fetch_add(1, std::memory_order_relaxed)] = i; });
+
+        m_entries.resize(total);
+        m_slot.resize(total);
+        pool.parallelFor(cells, ParallelCellGrain, [&](uint32_t begin, uint32_t end)
+                         {
+            for (uint32_t c = begin; c < end; ++c)
+            {
+                const uint32_t first = starts[c];
+                const uint32_t last = starts[c + 1];
+                std::sort(m_order.begin() + first, m_order.begin() + last);
+                for (uint32_t slot = first; slot < last; ++slot)
+                {
+                    const uint32_t i = m_order[slot];
+                    m_entries[slot] = m_binned[i];
+                    m_slot[i] = slot;
+                }
+            } });
+    }
+
+    // Copy per-entity data into grid order: reads each store sequentially, writes via m_slot.
+    void fillSnapshot(Engine::ECS::ArchetypeStoreManager &mgr)
+    {
+        m_snapshot.resize(m_entries.size());
+        const auto &population = m_incremental ? m_prevPopulation : m_population;
+        const uint32_t total = populationBases(population, m_popBase);
+        const uint32_t cells = static_cast<uint32_t>(m_cellStart.size() - 1);
+        m_cellMoving.resize(cells);
+
+        Engine::ECS::WorkerPool *pool = (total >= ParallelBuildMinEntities) ? workerPool() : nullptr;
+        forEntityChunks(pool, total, [&](uint32_t begin, uint32_t end)
+                        { fillRange(mgr, population, begin, end); });
+
+        // Moving flags per cell from the packed velocities (each task owns its cells).
+        auto markMoving = [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t c = begin; c < end; ++c)
+            {
+                uint8_t moving = 0;
+                for (uint32_t i = m_cellStart[c]; i < m_cellStart[c + 1] && !moving; ++i)
+                    moving = (m_snapshot.vx[i] != 0.0f || m_snapshot.vz[i] != 0.0f) ? 1 : 0;
+                m_cellMoving[c] = moving;
+            }
+        };
+        if (pool)
+            pool->parallelFor(cells, ParallelCellGrain, markMoving);
+        else
+            markMoving(0, cells);
+    }
+
+    // First pass-1 index of every store in 'population' (plus the total at the end); returns the total.
+    static uint32_t populationBases(const std::vector<std::pair<uint32_t, uint32_t>> &population,
+                                    std::vector<uint32_t> &bases)
+    {
+        bases.resize(population.size() + 1);
+        uint32_t total = 0;
+        for (size_t s = 0; s < population.size(); ++s)
+        {
+            bases[s] = total;
+            total += population[s].second;
+        }
+        bases[population.size()] = total;
+        return total;
+    }
+
+    // fn(begin, end) over pass-1 indices [0, total): split across the pool if given, else one call.
+    template <typename Fn>
+    static void forEntityChunks(Engine::ECS::WorkerPool *pool, uint32_t total, Fn &&fn)
+    {
+        if (pool)
+            pool->parallelFor(total, ParallelEntityGrain, fn);
+        else if (total > 0)
+            fn(0u, total);
+    }
+
+    // fn(store, storeId, firstRow, endRow, firstIndex) for the store rows covering pass-1 indices
+    // [begin, end) of 'population' (m_popBase must hold its bases).
+    template <typename Fn>
+    void forPopulationRange(Engine::ECS::ArchetypeStoreManager &mgr,
+                            const std::vector<std::pair<uint32_t, uint32_t>> &population,
+                            uint32_t begin, uint32_t end, Fn &&fn) const
+    {
+        size_t s = static_cast<size_t>(std::upper_bound(m_popBase.begin(), m_popBase.end() - 1, begin) - m_popBase.begin()) - 1;
+        for (uint32_t k = begin; k < end; ++s)
+        {
+            const uint32_t rowBegin = k - m_popBase[s];
+            const uint32_t rowEnd = std::min(population[s].second, rowBegin + (end - k));
+            if (rowEnd > rowBegin)
+                fn(*mgr.get(population[s].first), population[s].first, rowBegin, rowEnd, k);
+            k += rowEnd - rowBegin;
+        }
+    }
+
+    // Pass 1 over pass-1 indices [begin, end).
+    void binRange(Engine::ECS::ArchetypeStoreManager &mgr, uint32_t begin, uint32_t end)
+    {
+        const uint32_t cellsX = static_cast<uint32_t>(m_cellsX);
+        const uint32_t teams = m_teamBuckets;
+        forPopulationRange(mgr, m_population, begin, end,
+                           [&](const Engine::ECS::ArchetypeStore &store, uint32_t sid, uint32_t rowBegin, uint32_t rowEnd, uint32_t k)
+                           {
+                               const auto positions = store.positions();
+                               const float *px = positions.x();
+                               const float *pz = positions.z();
+                               const size_t stride = positions.stride();
+                               const Team *team = (teams > 1 && store.hasColumn<Team>()) ? store.column<Team>().data() : nullptr;
+                               for (uint32_t row = rowBegin; row < rowEnd; ++row, ++k)
+                               {
+                                   const uint32_t cell = static_cast<uint32_t>(cellZ(pz[row * stride])) * cellsX +
+                                                         static_cast<uint32_t>(cellX(px[row * stride]));
+                                   m_binned[k] = GridEntry{sid, row};
+                                   m_binCell[k] = cell * teams + (team ? std::min<uint32_t>(team[row].id, teams - 1) : 0u);
+                               }
+                           });
+    }
+
+    // Incremental pass 1: re-bin the rows written since 'since', and every row of a store whose rows
+    // were added, removed or swapped.
+    void rebinChanged(Engine::ECS::ArchetypeStoreManager &mgr, uint32_t since, Engine::ECS::WorkerPool *pool)
+    {
+        m_rebinRanges.clear();
+        auto addRange = [&](uint32_t begin, uint32_t end)
+        {
+            for (; begin < end; begin += ParallelEntityGrain)
+                m_rebinRanges.emplace_back(begin, std::min(end, begin + ParallelEntityGrain));
+        };
+        for (size_t s = 0; s < m_population.size(); ++s)
+        {
+            const Engine::ECS::ArchetypeStore &store = *mgr.get(m_population[s].first);
+            const uint32_t base = m_popBase[s];
+            if (store.structureVersion() > since)
+                addRange(base, base + m_population[s].second);
+            else
+                store.forEachChangedRange(m_binColumns, since, [&](uint32_t begin, uint32_t end)
+                                          { addRange(base + begin, base + end); });
+        }
+
+        auto rebin = [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+                binRange(mgr, m_rebinRanges[i].first, m_rebinRanges[i].second);
+        };
+        const uint32_t count = static_cast<uint32_t>(m_rebinRanges.size());
+        if (pool)
+            pool->parallelFor(count, 1u, rebin);
+        else
+            rebin(0u, count);
+    }
+
+    // Snapshot copies for pass-1 indices [begin, end) of 'population'.
+    void fillRange(Engine::ECS::ArchetypeStoreManager &mgr,
+                   const std::vector<std::pair<uint32_t, uint32_t>> &population, uint32_t begin, uint32_t end)
+    {
+        forPopulationRange(mgr, population, begin, end,
+                           [&](const Engine::ECS::ArchetypeStore &store, uint32_t, uint32_t rowBegin, uint32_t rowEnd, uint32_t k)
+                           {
+                               const auto positions = store.positions();
+                               const auto velocities = store.velocities();
+                               const float *px = positions.x();
+                               const float *pz = positions.z();
+                               const size_t stride = positions.stride();
+                               const auto radii = store.radii();
+                               const auto seps = store.separations();
+                               const auto &ents = store.entities();
+                               const bool hasVel = store.hasVelocity();
+                               const bool hasRadius = store.hasRadius();
+                               const bool hasSep = store.hasSeparation();
+                               const Team *team = store.hasColumn<Team>() ? store.column<Team>().data() : nullptr;
+
+                               for (uint32_t row = rowBegin; row < rowEnd; ++row, ++k)
+                               {
+                                   const uint32_t slot = m_slot[k];
+                                   m_snapshot.x[slot] = px[row * stride];
+                                   m_snapshot.z[slot] = pz[row * stride];
+                                   m_snapshot.radius[slot] = hasRadius ? radii[row].r : -1.0f;
+                                   m_snapshot.separation[slot] = hasSep ? seps[row].value : 0.0f;
+                                   m_snapshot.vx[slot] = hasVel ? velocities[row].x : 0.0f;
+                                   m_snapshot.vz[slot] = hasVel ? velocities[row].z : 0.0f;
+                                   m_snapshot.team[slot] = team ? team[row].id : 0;
+                                   m_snapshot.entity[slot] = ents[row];
+                               }
+                           });
+    }
+
+    static constexpr uint32_t ParallelBuildMinEntities = 16384; // below this the serial build wins
+    static constexpr uint32_t ParallelEntityGrain = 8192;       // entities per task
+    static constexpr uint32_t ParallelCellGrain = 4096;         // cells per task (and per prefix block)
+
     float m_cellSize; // equals neighbor radius R
     std::unordered_map<GridKey, GridCell, GridKeyHash> m_grid;
+
+    // Bounded (flat) mode
+    bool m_bounded = false;
+    bool m_incremental = false;
+    float m_minX = 0.0f, m_minZ = 0.0f, m_maxX = 0.0f, m_maxZ = 0.0f;
+    int m_cellsX = 0, m_cellsZ = 0;
+    std::vector<uint32_t> m_cellStart; // cellsX * cellsZ + 1 offsets into m_entries (row-major, z outer)
+    uint32_t m_teamBuckets = 1;          // runs per cell, ordered by team (1: no team ordering)
+    std::vector<uint32_t> m_bucketStart; // cells * m_teamBuckets + 1 offsets, when m_teamBuckets > 1
+    std::vector<GridEntry> m_entries;  // packed by cell
+    std::vector<uint32_t> m_slot;      // packed index of each entity in pass-1 (store/row) order
+    SpatialSnapshot m_snapshot;        // copies in m_entries order
+    std::vector<uint8_t> m_cellMoving; // per cell: some entity in it had a nonzero velocity
+
+    // Scratch for the counting sort, and last binning for incremental mode.
+    std::vector<GridEntry> m_binned;
+    std::vector<uint32_t> m_binCell; // sort key: cell * m_teamBuckets + team bucket
+    std::vector<std::pair<uint32_t, uint32_t>> m_population; // (storeId, rows) per matching store
+    std::vector<std::pair<uint32_t, uint32_t>> m_prevPopulation;
+    std::vector<uint32_t> m_prevBinCell;
+    std::vector<uint32_t> m_popBase; // first pass-1 index per store of the population being walked
+
+    // Incremental re-binning: change version of the last build and the columns the sort key reads.
+    Engine::ECS::ComponentMask m_binColumns;
+    uint32_t m_seenVersion = 0;
+    const Engine::ECS::ArchetypeStoreManager *m_seenStores = nullptr;
+    std::vector<std::pair<uint32_t, uint32_t>> m_rebinRanges; // pass-1 index ranges
+
+    // Parallel build scratch: per-cell counts, then scatter cursors; prefix block offsets; pass-1
+    // index per packed slot.
+    std::unique_ptr<std::atomic<uint32_t>[]> m_cursor;
+    size_t m_cursorCount = 0;
+    std::vector<uint32_t> m_blockStart;
+    std::vector<uint32_t> m_order;
 };
\ No newline at end of file
@@ -1,9 +1,14 @@
 #pragma once
 #include "ECS/SystemFormat.h"
 #include "ECS/Components.h"
+#include "ECS/CommandBuffer.h"
+#include "nav/FlowField.h"
+#include "nav/PathService.h"
+#include "systems/FormationSystem.h"
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <utility>
 
 class SteeringSystem : public Engine::ECS::SystemBase
 {
@@ -12,11 +17,28 @@ public:
     {
         // Position + Velocity + MoveTarget + MoveSpeed required
         setRequiredNames({"Position", "Velocity", "MoveTarget", "MoveSpeed"});
-        setExcludedNames({"Disabled", "Dead"});
+        // "AtRest": idle units that settled; CommandSystem / LocalAvoidanceSystem wake them.
+        setExcludedNames({"Disabled", "Dead", "AtRest", "RegionGhost"});
+        setReadNames({"Position", "MoveSpeed", "FormationMember"});
+        setWriteNames({"Velocity", "MoveTarget", "PathFollow"});
     }
 
     const char *name() const override { return "SteeringSystem"; }
 
+    void buildMasks(Engine::ECS::ComponentRegistry &registry) override
+    {
+        SystemBase::buildMasks(registry);
+        m_atRestId = registry.ensureId("AtRest");
+    }
+
+    // Optional: steer along cached flow fields toward each unit's goal region instead of a
+    // straight line (units already inside the region, or without a ready field, steer directly).
+    void setFlowFields(FlowFieldCache *flowFields) { m_flowFields = flowFields; }
+
+    // Optional: units with a PathFollow column follow its waypoints (and hold while Pending);
+    // truncated paths are requested again from 'paths' when their last waypoint is reached.
+    void setPathService(PathService *paths) { m_paths = paths; }
+
     void update(Engine::ECS::ArchetypeStoreManager &mgr, float dt) override
     {
         auto clamp = [](float v, float a, float b)
@@ -29,78 +51,174 @@ public:
         // Snappy stop: no long slowdown phase.
         // We'll keep full speed, but clamp the final step so we hit the arrival radius cleanly.
 
-        for (const auto &ptr : mgr.stores())
-        {
-            if (!ptr)
-                continue;
-            auto &store = *ptr;
-
-            if (!store.signature().containsAll(required()))
-                continue;
-            if (!store.signature().containsNone(excluded()))
-                continue;
+        FlowFieldCache *flowFields = (m_flowFields && m_flowFields->grid()) ? m_flowFields : nullptr;
 
-            // Accessors: positions, velocities, moveTargets, moveSpeeds
-            auto &positions = const_cast<std::vector<Engine::ECS::Position> &>(store.positions());
-            auto &velocities = const_cast<std::vector<Engine::ECS::Velocity> &>(store.velocities());
+        // Waypoints (cell centers beside corners) count as reached within a quarter cell, so units do
+        // not cut the corner they are rounding.
+        const float waypointRadius = (m_paths && m_paths->grid()) ? 0.25f * m_paths->grid()->cellSize() : 0.5f;
 
-            // You’ll add these to ArchetypeStore once you wire MoveTarget/MoveSpeed there:
-            auto &targets = const_cast<std::vector<Engine::ECS::MoveTarget> &>(store.moveTargets());
-            auto &speeds = const_cast<std::vector<Engine::ECS::MoveSpeed> &>(store.moveSpeeds());
-
-            const auto &masks = store.rowMasks();
-            const uint32_t n = store.size();
-
-            for (uint32_t i = 0; i < n; ++i)
+        using namespace Engine::ECS;
+        query<Position, Velocity, MoveTarget, MoveSpeed>(mgr).parallelForChunks(
+            workerPool(),
+            [&](const QueryChunk &chunk, Vec3ColumnView<Position> positions, Vec3ColumnView<Velocity> velocities, MoveTarget *targets,
+                MoveSpeed *speeds)
             {
-                if (!masks[i].matches(required(), excluded()))
-                    continue;
-
-                auto &pos = positions[i];
-                auto &vel = velocities[i];
-                auto &tgt = targets[i];
-                const auto &spd = speeds[i];
-
-                if (!tgt.active)
-                    continue;
-
-                float dx = tgt.x - pos.x;
-                float dz = tgt.z - pos.z;
-                float dist = len2(dx, dz);
-
-                if (dist <= arrivalRadius)
+                // Units in a chunk mostly share one goal: look its field up once per goal change.
+                uint32_t fieldKey = UINT32_MAX;
+                std::shared_ptr<const FlowField> field;
+                // Unmarked: only the rows whose path actually changes are reported (markPath).
+                PathFollow *paths = chunk.store->hasColumn<PathFollow>() ? chunk.store->columnUnmarked<PathFollow>().data() : nullptr;
+                uint32_t pathBegin = UINT32_MAX, pathEnd = 0;
+                auto markPath = [&](uint32_t row)
                 {
-                    vel.x = vel.y = vel.z = 0.0f;
-                    tgt.active = 0;
-                    continue;
-                }
+                    pathBegin = std::min(pathBegin, row);
+                    pathEnd = std::max(pathEnd, row + 1);
+                };
 
-                // normalize
-                if (dist > 1e-6f)
-                {
-                    dx /= dist;
-                    dz /= dist;
-                }
-                else
+                for (uint32_t i = chunk.begin; i < chunk.end; ++i)
                 {
-                    dx = dz = 0.0f;
+                    if (!chunk.rowMatches(i))
+                        continue;
+
+                    const Position pos = positions[i];
+                    auto vel = velocities[i];
+                    auto &tgt = targets[i];
+                    const auto &spd = speeds[i];
+
+                    if (!tgt.active)
+                    {
+                        // Idle: no preferred velocity. Once nothing pushed the unit during the last
+                        // tick either, it goes to rest and drops out of steering and movement.
+                        if (!formationMember(chunk, i) && vel.x * vel.x + vel.z * vel.z < kRestSpeed2)
+                            rest(chunk, i);
+                        vel.x = vel.y = vel.z = 0.0f;
+                        continue;
+                    }
+
+                    float dx = tgt.x - pos.x;
+                    float dz = tgt.z - pos.z;
+                    float dist = len2(dx, dz);
+
+                    if (dist <= arrivalRadius)
+                    {
+                        vel.x = vel.y = vel.z = 0.0f;
+                        tgt.active = 0;
+                        if (paths && paths[i].state == PathFollow::Following)
+                        {
+                            paths[i].state = PathFollow::Idle;
+                            markPath(i);
+                        }
+                        continue;
+                    }
+
+                    // normalize
+                    if (dist > 1e-6f)
+                    {
+                        dx /= dist;
+                        dz /= dist;
+                    }
+                    else
+                    {
+                        dx = dz = 0.0f;
+                    }
+
+                    PathFollow *path = paths ? &paths[i] : nullptr;
+                    if (path && path->state == PathFollow::Pending)
+                    {
+                        vel.x = vel.y = vel.z = 0.0f;
+                        continue;
+                    }
+
+                    if (path && path->state == PathFollow::Following && path->next < path->count)
+                    {
+                        auto toWaypoint = [&](float &wx, float &wz)
+                        {
+                            wx = path->x[path->next] - pos.x;
+                            wz = path->z[path->next] - pos.z;
+                            return len2(wx, wz);
+                        };
+                        float wx = 0.0f, wz = 0.0f;
+                        float wd = toWaypoint(wx, wz);
+                        while (wd <= waypointRadius && path->next + 1 < path->count)
+                        {
+                            ++path->next;
+                            markPath(i);
+                            wd = toWaypoint(wx, wz);
+                        }
+
+                        if (wd <= waypointRadius && path->partial)
+                        {
+                            markPath(i);
+                            // End of a truncated path: ask for the rest from here.
+                            if (m_paths)
+                            {
+                                path->requestId = m_paths->request(chunk.store->entities()[i], pos.x, pos.z, tgt.x, tgt.z);
+                                path->state = PathFollow::Pending;
+                                vel.x = vel.y = vel.z = 0.0f;
+                                continue;
+                            }
+                            path->state = PathFollow::Idle;
+                        }
+                        else if (wd > 1e-6f)
+                        {
+                            dx = wx / wd;
+                            dz = wz / wd;
+                        }
+                    }
+                    else if (flowFields)
+                    {
+                        const uint32_t key = flowFields->goalKey(tgt.x, tgt.z);
+                        if (key != fieldKey)
+                        {
+                            fieldKey = key;
+                            field = flowFields->acquire(tgt.x, tgt.z);
+                        }
+                        float fx = 0.0f, fz = 0.0f;
+                        if (field && field->direction(pos.x, pos.z, fx, fz))
+                        {
+                            dx = fx;
+                            dz = fz;
+                        }
+                    }
+
+                    // Snappy stop: constant speed, but avoid "creeping" by clamping so we reach the
+                    // arrival radius in this frame (then the next update will stop & clear the target).
+                    float desiredSpeed = spd.value;
+                    if (dt > 1e-6f)
+                    {
+                        const float remaining = std::max(0.0f, dist - arrivalRadius);
+                        const float maxSpeedThisFrame = remaining / dt;
+                        desiredSpeed = std::min(desiredSpeed, maxSpeedThisFrame);
+                    }
+
+                    vel.x = dx * desiredSpeed;
+                    vel.z = dz * desiredSpeed;
+                    // Height axis is y; gameplay movement stays on the ground plane for now.
+                    vel.y = 0.0f;
                 }
 
-                // Snappy stop: constant speed, but avoid "creeping" by clamping so we reach the
-                // arrival radius in this frame (then the next update will stop & clear the target).
-                float desiredSpeed = spd.value;
-                if (dt > 1e-6f)
-                {
-                    const float remaining = std::max(0.0f, dist - arrivalRadius);
-                    const float maxSpeedThisFrame = remaining / dt;
-                    desiredSpeed = std::min(desiredSpeed, maxSpeedThisFrame);
-                }
+                if (pathBegin < pathEnd)
+                    chunk.store->markChanged<PathFollow>(pathBegin, pathEnd);
+            });
+    }
 
-                vel.x = dx * desiredSpeed;
-                vel.z = dz * desiredSpeed;
-                // Height axis is y; gameplay movement stays on the ground plane for now.
-                vel.y = 0.0f;
-            }
-        }
+private:
+    static constexpr float kRestSpeed2 = 1e-4f; // (m/s)^2
+
+    // Formation members are put to rest by FormationSystem.
+    static bool formationMember(const Engine::ECS::QueryChunk &chunk, uint32_t row)
+    {
+        return chunk.store->hasColumn<FormationMember>() &&
+               std::as_const(*chunk.store).column<FormationMember>()[row].group != FormationMember::kNoGroup;
+    }
+
+    void rest(const Engine::ECS::QueryChunk &chunk, uint32_t row) const
+    {
+        if (commandBuffer() && m_atRestId != Engine::ECS::ComponentRegistry::InvalidID)
+            commandBuffer()->addTag(chunk.store->entities()[row], m_atRestId);
     }
+
+    FlowFieldCache *m_flowFields = nullptr;
+    PathService *m_paths = nullptr;
+    uint32_t m_atRestId = Engine::ECS::ComponentRegistry::InvalidID;
 };
\ No newline at end of file
@@ -1,14 +1,29 @@
 #pragma once
 
 #include "ECS/ECSContext.h"
+#include "ECS/Interpolation.h"
 
 #include "systems/CommandSystem.h"
 #include "systems/SteeringSystem.h"
+#include "systems/FormationSystem.h"
 #include "systems/SpatialIndexSystem.h"
 #include "systems/LocalAvoidanceSystem.h"
 #include "systems/MovementSystem.h"
+
+// 1 for targets without a graphics device (StratosphereBench, StratosphereServer: EngineCore only).
+// SystemRunner then has no animation or render systems and Update() is not available.
+#ifndef SAMPLE_HEADLESS
+#define SAMPLE_HEADLESS 0
+#endif
+
+#if !SAMPLE_HEADLESS
 #include "systems/CharacterAnimationSystem.h"
 #include "systems/RenderSystem.h"
+#endif
+
+#include "nav/FlowField.h"
+#include "nav/NavGrid.h"
+#include "nav/PathService.h"
 
 namespace Engine
 {
@@ -20,28 +35,81 @@ namespace Engine
 namespace Sample
 {
     // Owns and runs Sample gameplay systems in a consistent order.
+    // Simulation systems run at the fixed tick rate through Engine::ECS::SystemScheduler
+    // (independent ones in parallel); animation and rendering run once per frame.
     class SystemRunner
     {
     public:
         void Initialize(Engine::ECS::ComponentRegistry &registry);
-        void Update(Engine::ECS::ECSContext &ecs, float dtSeconds);
+
+        // One fixed simulation tick (command -> steering -> formation -> spatial -> avoidance -> movement),
+        // followed by command buffer playback.
+        void FixedUpdate(Engine::ECS::ECSContext &ecs, float dtSeconds);
+
+#if !SAMPLE_HEADLESS
+        // Per rendered frame: animation clocks and render batching. 'alpha' blends positions
+        // between the last two FixedUpdate ticks (1 = latest tick).
+        void Update(Engine::ECS::ECSContext &ecs, float dtSeconds, float alpha = 1.0f);
 
         void SetAssetManager(Engine::AssetManager *assets);
         void SetRenderer(Engine::Renderer *renderer);
         void SetCamera(Engine::Camera *camera);
+#endif
         void SetGlobalMoveTarget(float x, float y, float z);
+        // Terrain for units' Position.y (see MovementSystem::setGround); null keeps y as simulated.
+        void SetGround(const Engine::Heightfield *ground) { m_movement.setGround(ground); }
+
+        // Lockstep mode: flow fields and paths are built inside the tick that asks for them,
+        // avoidance uses its fixed-point kernel, and every tick ends with a state hash.
+        // Peers that apply the same commands at the same ticks stay bit-identical. Call before the first tick.
+        void SetDeterministic(bool enabled);
+        bool Deterministic() const { return m_deterministic; }
+        // Ticks run so far and the hash of the state after the latest one (deterministic mode only).
+        uint64_t SimulationTick() const { return m_tick; }
+        uint64_t StateHash() const { return m_stateHash; }
+
+        // After the ECS world was replaced (snapshot load): forget formation anchors and path
+        // requests that belonged to the previous world.
+        void OnWorldReplaced(Engine::ECS::ECSContext &ecs);
+
+        // Walkability grid shared by steering flow fields and HPA* paths; edit it between ticks.
+        NavGrid &Navigation() { return m_nav; }
+        FlowFieldCache &FlowFields() { return m_flowFields; }
+        PathService &Paths() { return m_paths; }
+        // Formation anchors; ScenarioSpawner seeds one per spawn group.
+        FormationGroups &Formations() { return m_formations; }
+
+        // Grid from the latest FixedUpdate (picking and box selection query it between ticks).
+        const SpatialIndexSystem &Spatial() const { return m_spatial; }
 
     private:
         bool m_initialized = false;
+        bool m_deterministic = false;
+        uint64_t m_tick = 0;
+        uint64_t m_stateHash = 0;
+        uint32_t m_selectedId = Engine::ECS::ComponentRegistry::InvalidID; // row tag mirroring ecs.selection
+
+        NavGrid m_nav;
+        FlowFieldCache m_flowFields; // after m_nav: points at it
+        PathService m_paths;         // same
+        FormationGroups m_formations;
 
         CommandSystem m_command;
         SteeringSystem m_steering;
+        FormationSystem m_formation;
         SpatialIndexSystem m_spatial{2.0f};
         LocalAvoidanceSystem m_avoidance{&m_spatial};
         MovementSystem m_movement;
 
+#if !SAMPLE_HEADLESS
         CharacterAnimationSystem m_characterAnim;
 
         RenderSystem m_renderModel;
+#endif
+
+        Engine::ECS::WorkerPool m_pool; // chunked row iteration inside systems
+        Engine::ECS::SystemScheduler m_scheduler;
+        Engine::ECS::CommandBuffer *m_commands = nullptr; // ECSContext::commands, bound on first Update
+        Engine::ECS::PositionHistory m_history;           // positions before the latest tick
     };
 }